@@ -202,6 +202,7 @@ struct _XDisplay
 	unsigned long last_request_read_upper32bit;
 	unsigned long request_upper32bit;
 #endif
+	struct _XQIndex *qindex; /* event queue lists by type and window */
 };
 
 #define XAllocIDs(dpy,ids,n) (*(dpy)->idlist_alloc)(dpy,ids,n)
@@ -323,6 +324,10 @@ typedef struct _XSQEvent
     struct _XSQEvent *next;
     XEvent event;
     unsigned long qserial_num;	/* so multi-threaded code can find new ones */
+    struct _XSQEvent *prev;	/* element before this one in the queue */
+    struct _XSQEvent *type_next, *type_prev;	/* queued events of this type */
+    struct _XSQEvent *window_next, *window_prev; /* and of nearby windows */
+    unsigned char type_list, window_list; /* lists this element is on */
 } _XQEvent;
 #endif
 
@@ -6,7 +6,7 @@
 #define _XRESPROTO_H
 
 #define XRES_MAJOR_VERSION 1
-#define XRES_MINOR_VERSION 2
+#define XRES_MINOR_VERSION 3
 
 #define XRES_NAME "X-Resource"
 
@@ -24,6 +24,9 @@
 #define X_XResQueryClientIds          4
 #define X_XResQueryResourceBytes      5
 
+/* v1.3 */
+#define X_XResQueryClientStats        6
+
 typedef struct {
    CARD32 resource_base;
    CARD32 resource_mask;
@@ -224,4 +227,45 @@ typedef struct {
 } xXResQueryResourceBytesReply;
 #define sz_xXResQueryResourceBytesReply  32
 
+/* v1.3 XResQueryClientStats */
+
+typedef struct _XResQueryClientStats {
+   CARD8   reqType;
+   CARD8   XResReqType;
+   CARD16  length;
+} xXResQueryClientStatsReq;
+#define sz_xXResQueryClientStatsReq 4
+
+/* 64-bit counters are sent as two CARD32s, most significant first */
+typedef struct _XResClientStats {
+   CARD32  resource_base;
+   CARD32  pending_output;      /* bytes not yet written to the client */
+   CARD32  requests_hi;
+   CARD32  requests_lo;
+   CARD32  dispatch_usec_hi;    /* server time spent on its requests */
+   CARD32  dispatch_usec_lo;
+   CARD32  bytes_in_hi;
+   CARD32  bytes_in_lo;
+   CARD32  bytes_out_hi;
+   CARD32  bytes_out_lo;
+   CARD32  glyph_bytes;         /* of its glyph sets */
+   CARD32  glx_bytes;           /* of its GLX drawables */
+} xXResClientStats;
+#define sz_xXResClientStats 48
+
+typedef struct {
+   CARD8   type;
+   CARD8   pad1;
+   CARD16  sequenceNumber;
+   CARD32  length;
+   CARD32  num_clients;
+   CARD32  pad2;
+   CARD32  pad3;
+   CARD32  pad4;
+   CARD32  pad5;
+   CARD32  pad6;
+   // followed by num_clients times XResClientStats
+} xXResQueryClientStatsReply;
+#define sz_xXResQueryClientStatsReply  32
+
 #endif /* _XRESPROTO_H */
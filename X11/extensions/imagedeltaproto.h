@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * IMAGE-DELTA: PutImage as a grid of tiles, each of which is either
+ * copied unchanged from a base drawable (typically a pixmap holding the
+ * previous frame), sent raw, or sent as an XOR against the base tile.
+ * Screen mirroring clients then only send what changed, and XOR tiles of
+ * small changes compress well on a compressed transport.
+ */
+
+#ifndef _IMAGEDELTAPROTO_H_
+#define _IMAGEDELTAPROTO_H_
+
+#define X_ImageDeltaQueryVersion	0
+#define X_ImageDeltaPutTiles		1
+
+#define ImageDeltaNumberEvents		0
+
+#define ImageDeltaNumberErrors		0
+
+#define ImageDeltaMajorVersion		1
+#define ImageDeltaMinorVersion		0
+
+#define ImageDeltaExtensionName		"IMAGE-DELTA"
+
+/* xImageDeltaTile.op */
+#define ImageDeltaTileCopy		0	/* base tile, no data */
+#define ImageDeltaTileRaw		1	/* data replaces the tile */
+#define ImageDeltaTileXor		2	/* base tile XOR data */
+
+typedef struct {
+    CARD8	reqType;	/* always ImageDeltaCode */
+    CARD8	deltaReqType;	/* always X_ImageDeltaQueryVersion */
+    CARD16	length;
+    CARD16	majorVersion;
+    CARD16	minorVersion;
+} xImageDeltaQueryVersionReq;
+#define sz_xImageDeltaQueryVersionReq 8
+
+typedef struct {
+    BYTE	type;			/* X_Reply */
+    CARD8	pad0;
+    CARD16	sequenceNumber;
+    CARD32	length;
+    CARD16	majorVersion;
+    CARD16	minorVersion;
+    CARD32	pad1;
+    CARD32	pad2;
+    CARD32	pad3;
+    CARD32	pad4;
+    CARD32	pad5;
+} xImageDeltaQueryVersionReply;
+#define sz_xImageDeltaQueryVersionReply 32
+
+/*
+ * Tile (col, row) covers tileWidth x tileHeight pixels at
+ * (dstX + col * tileWidth, dstY + row * tileHeight) in the drawable, and
+ * the same size area at (baseX + col * tileWidth, ...) in base, which is
+ * the drawable itself when None.  Raw and Xor tiles are followed by
+ * their ZPixmap image, scanlines padded as for PutImage; all drawing
+ * goes through gc, but no GraphicsExpose events are sent.  Tiles are
+ * drawn in list order: when base is the drawable, a tile that overlaps
+ * the base area of a later tile changes what that tile reads.
+ */
+typedef struct {
+    CARD8	reqType;	/* always ImageDeltaCode */
+    CARD8	deltaReqType;	/* always X_ImageDeltaPutTiles */
+    CARD16	length;
+    Drawable	drawable;
+    GContext	gc;
+    Drawable	base;
+    INT16	dstX;
+    INT16	dstY;
+    INT16	baseX;
+    INT16	baseY;
+    CARD16	tileWidth;
+    CARD16	tileHeight;
+    CARD8	depth;
+    CARD8	pad0;
+    CARD16	nTiles;
+} xImageDeltaPutTilesReq;
+#define sz_xImageDeltaPutTilesReq 32
+
+typedef struct {
+    CARD16	col;
+    CARD16	row;
+    CARD8	op;
+    CARD8	pad0;
+    CARD16	pad1;
+} xImageDeltaTile;
+#define sz_xImageDeltaTile 8
+
+#endif /* _IMAGEDELTAPROTO_H_ */
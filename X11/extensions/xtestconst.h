@@ -34,7 +34,7 @@ in this Software without prior written authorization from The Open Group.
 #define XTestCurrentCursor ((Cursor)1)
 
 #define XTestMajorVersion	2
-#define XTestMinorVersion	2
+#define XTestMinorVersion	3
 
 #define XTestExtensionName	"XTEST"
 
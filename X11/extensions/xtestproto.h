@@ -38,6 +38,9 @@ in this Software without prior written authorization from The Open Group.
 #define X_XTestFakeInput	2
 #define X_XTestGrabControl	3
 
+/* v2.3 */
+#define X_XTestFakeInputBatch	4
+
 typedef struct {
     CARD8	reqType;	/* always XTestReqCode */
     CARD8	xtReqType;	/* always X_XTestGetVersion */
@@ -117,6 +120,28 @@ typedef struct {
 } xXTestGrabControlReq;
 #define sz_xXTestGrabControlReq 8
 
+/* v2.3: the request is followed by any number of entries */
+typedef struct {
+    CARD8	reqType;	/* always XTestReqCode */
+    CARD8	xtReqType;	/* always X_XTestFakeInputBatch */
+    CARD16	length;
+} xXTestFakeInputBatchReq;
+#define sz_xXTestFakeInputBatchReq 4
+
+/*
+ * Each entry is followed by nEvents events, as they would be sent by
+ * FakeInput but for the time, which is ignored.  The entry is sent
+ * delay milliseconds after the one before it, or after the request for
+ * the first entry of a client with nothing left to send.
+ */
+typedef struct {
+    CARD32	delay;
+    CARD8	deviceid;
+    CARD8	nEvents;
+    CARD16	pad;
+} xXTestFakeInputBatchEntry;
+#define sz_xXTestFakeInputBatchEntry 8
+
 #undef Window
 #undef Time
 #undef Cursor
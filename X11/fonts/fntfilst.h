@@ -120,6 +120,7 @@ typedef struct _FontDirectory {
     FontTableRec    scalable;
     FontTableRec    nonScalable;
     char	    *attributes;
+    Bool	    loaded;
 } FontDirectoryRec;
 
 /* Capability bits: for definition of capabilities bitmap in the
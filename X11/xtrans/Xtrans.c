@@ -85,6 +85,8 @@ from The Open Group.
 #define TRANS_LOCAL_SCO_INDEX		13
 #define TRANS_SOCKET_INET6_INDEX	14
 #define TRANS_LOCAL_PIPE_INDEX		15
+#define TRANS_SOCKET_HVSOCK_INDEX	16
+#define TRANS_SOCKET_ZTCP_INDEX		17
 
 
 static
@@ -102,6 +104,12 @@ Xtransport_table Xtransports[] = {
 #endif /* !LOCALCONN */
     { &TRANS(SocketUNIXFuncs),	TRANS_SOCKET_UNIX_INDEX },
 #endif /* UNIXCONN */
+#if defined(HVSOCKCONN)
+    { &TRANS(SocketHVSOCKFuncs),	TRANS_SOCKET_HVSOCK_INDEX },
+#endif /* HVSOCKCONN */
+#if defined(ZTCPCONN)
+    { &TRANS(SocketZTCPFuncs),	TRANS_SOCKET_ZTCP_INDEX },
+#endif /* ZTCPCONN */
 #if defined(LOCALCONN)
     { &TRANS(LocalFuncs),	TRANS_LOCAL_LOCAL_INDEX },
 #ifndef __sun
@@ -149,6 +149,63 @@ from the copyright holders.
 #define HAVE_ABSTRACT_SOCKETS
 #endif
 
+/*
+ * Hyper-V sockets: the Windows host accepts AF_HYPERV connections from
+ * WSL2 and other guests, which connect to it with AF_VSOCK.  The X
+ * display's port number maps onto a vsock port, which Windows sees as the
+ * service GUID VSOCK_TEMPLATE with its first field replaced by the port.
+ */
+#if defined(TCPCONN) && (defined(WIN32) || defined(linux))
+#define HVSOCKCONN
+#endif
+
+#ifdef HVSOCKCONN
+#ifdef WIN32
+#ifndef AF_HYPERV
+#define AF_HYPERV 34
+#endif
+#ifndef HV_PROTOCOL_RAW
+#define HV_PROTOCOL_RAW 1
+#endif
+
+/* SOCKADDR_HV, without requiring hvsocket.h */
+struct sockaddr_hvsock {
+    ADDRESS_FAMILY	family;
+    USHORT		reserved;
+    GUID		vmid;
+    GUID		serviceid;
+};
+
+/* HV_GUID_WILDCARD is all zeros: listen for any partition */
+static const GUID hvsock_guid_parent =
+    { 0xa42e7cda, 0xd03f, 0x480c, { 0x9c, 0xc2, 0xa4, 0xde, 0x20, 0xab, 0xb8, 0x78 } };
+static const GUID hvsock_vsock_template =
+    { 0x00000000, 0xfacb, 0x11e6, { 0xbd, 0x58, 0x64, 0x00, 0x6a, 0x79, 0x86, 0xd3 } };
+
+#define HVSOCK_FAMILY	AF_HYPERV
+#define HVSOCK_PROTOCOL	HV_PROTOCOL_RAW
+#else
+#include <linux/vm_sockets.h>
+
+#define sockaddr_hvsock	sockaddr_vm
+#define HVSOCK_FAMILY	AF_VSOCK
+#define HVSOCK_PROTOCOL	0
+#endif
+#endif /* HVSOCKCONN */
+
+/*
+ * Compressed TCP: builds that link zlib define ZTCPCONN to get a
+ * "ztcp" listener on X_TCP_PORT + ZTCP_PORT_OFFSET + display, whose
+ * connections carry the X stream deflated in both directions.
+ */
+#if defined(ZTCPCONN) && !defined(TCPCONN)
+#undef ZTCPCONN
+#endif
+
+#ifdef ZTCPCONN
+#include <zlib.h>
+#endif /* ZTCPCONN */
+
 #define MIN_BACKLOG 128
 #ifdef SOMAXCONN
 #if SOMAXCONN > MIN_BACKLOG
@@ -192,6 +249,12 @@ static Sockettrans2dev Sockettrans2devtab[] = {
     {"local",AF_UNIX,SOCK_STREAM,SOCK_DGRAM,0},
 #endif /* !LOCALCONN */
 #endif /* UNIXCONN */
+#ifdef HVSOCKCONN
+    {"hvsock",HVSOCK_FAMILY,SOCK_STREAM,SOCK_DGRAM,HVSOCK_PROTOCOL},
+#endif /* HVSOCKCONN */
+#ifdef ZTCPCONN
+    {"ztcp",AF_INET,SOCK_STREAM,SOCK_DGRAM,0},
+#endif /* ZTCPCONN */
 };
 
 #define NUMSOCKETFAMILIES (sizeof(Sockettrans2devtab)/sizeof(Sockettrans2dev))
@@ -220,6 +283,40 @@ static int TRANS(SocketINETClose) (XtransConnInfo ciptr);
 #define UNIX_DIR "/tmp/.ICE-unix"
 #endif /* ICE_t */
 
+#if defined(WIN32) && defined(UNIX_DIR)
+/*
+ * There is no /tmp on Windows, so the sockets live in the user's temporary
+ * directory, for example %TEMP%\.X11-unix\X0, which WSL1 processes reach
+ * through /mnt/c.  libxcb looks for them in the same place.
+ */
+static const char *
+TRANS(WinTempName) (const char *name, char *buf, size_t size)
+{
+    if (!buf[0]) {
+	char tmp[MAX_PATH];
+	DWORD len = GetTempPathA(sizeof(tmp), tmp);
+	char *p;
+
+	if (len == 0 || len >= sizeof(tmp))
+	    strcpy(tmp, "C:\\Windows\\Temp\\");
+
+	snprintf(buf, size, "%s%s", tmp, name + strlen("/tmp/"));
+	for (p = buf; *p; p++)
+	    if (*p == '/')
+		*p = '\\';
+    }
+    return buf;
+}
+
+static char win_unix_path[108], win_unix_dir[108];
+
+static const char win_posix_unix_path[] = UNIX_PATH;
+static const char win_posix_unix_dir[] = UNIX_DIR;
+#undef UNIX_PATH
+#undef UNIX_DIR
+#define UNIX_PATH TRANS(WinTempName)(win_posix_unix_path, win_unix_path, sizeof(win_unix_path))
+#define UNIX_DIR TRANS(WinTempName)(win_posix_unix_dir, win_unix_dir, sizeof(win_unix_dir))
+#endif /* WIN32 && UNIX_DIR */
 
 #endif /* UNIXCONN */
 
@@ -2247,6 +2344,34 @@ TRANS(SocketWritev) (XtransConnInfo ciptr, struct iovec *buf, int size)
             discardFd(&ciptr->send_fds, cf, 0);
         return i;
     }
+#endif
+#ifdef WIN32
+    /* Hand all the pieces to a single WSASend() so that large reply data
+     * goes out straight from the caller's storage, together with whatever
+     * was buffered ahead of it, instead of one send() per piece. */
+    if (size > 1)
+    {
+	WSABUF	wsabuf[16];
+	DWORD	sent = 0;
+	int	i;
+
+	if (size > 16)
+	    size = 16;
+
+	for (i = 0; i < size; i++)
+	{
+	    wsabuf[i].buf = (CHAR *) buf[i].iov_base;
+	    wsabuf[i].len = (ULONG) buf[i].iov_len;
+	}
+
+	if (WSASend ((SOCKET)ciptr->fd, wsabuf, size, &sent, 0, NULL, NULL)
+	    == SOCKET_ERROR)
+	{
+	    errno = WSAGetLastError();
+	    return -1;
+	}
+	return (int) sent;
+    }
 #endif
     return WRITEV (ciptr, buf, size);
 }
@@ -2376,6 +2501,644 @@ TRANS(SocketUNIXCloseForCloning) (XtransConnInfo ciptr)
 #endif /* UNIXCONN */
 
 
+#ifdef HVSOCKCONN
+
+/*
+ * Fill in the address of port for a listener, or for a connection to host.
+ * host is a decimal vsock CID on Linux, and the parent partition if empty;
+ * Windows only connects to its parent.
+ */
+
+static int
+TRANS(SocketHVSOCKFillAddr) (struct sockaddr_hvsock *sockname,
+			     const char *host, const char *port, int listener)
+
+{
+    long	tmpport;
+
+    if (!port || !is_numeric (port))
+    {
+	prmsg (1, "SocketHVSOCKFillAddr: port %s is not a number\n",
+	    port ? port : "NULL");
+	return -1;
+    }
+
+    tmpport = strtol (port, (char**)NULL, 10);
+#ifdef X11_t
+    /* As for tcp, the port is really the display number */
+    tmpport += X_TCP_PORT;
+#endif
+
+    bzero (sockname, sizeof (*sockname));
+#ifdef WIN32
+    sockname->family = AF_HYPERV;
+    if (!listener)
+    {
+	if (host && *host)
+	{
+	    prmsg (1, "SocketHVSOCKFillAddr: can only connect to the parent partition\n");
+	    return -1;
+	}
+	sockname->vmid = hvsock_guid_parent;
+    }
+    sockname->serviceid = hvsock_vsock_template;
+    sockname->serviceid.Data1 = (unsigned long) tmpport;
+#else
+    sockname->svm_family = AF_VSOCK;
+    sockname->svm_port = (unsigned int) tmpport;
+    if (listener)
+	sockname->svm_cid = VMADDR_CID_ANY;
+    else if (host && *host)
+    {
+	if (!is_numeric (host))
+	{
+	    prmsg (1, "SocketHVSOCKFillAddr: CID %s is not a number\n", host);
+	    return -1;
+	}
+	sockname->svm_cid = (unsigned int) strtoul (host, (char**)NULL, 10);
+    }
+    else
+	sockname->svm_cid = VMADDR_CID_HOST;
+#endif
+
+    return 0;
+}
+
+
+/*
+ * Store the local, or remote, address of the socket in the XtransConnInfo
+ * structure for the connection.
+ */
+
+static int
+TRANS(SocketHVSOCKGetAddr) (XtransConnInfo ciptr, int peer)
+
+{
+    struct sockaddr_hvsock	sockname;
+    SOCKLEN_T			namelen = sizeof(sockname);
+    char			*addr;
+
+    prmsg (3,"SocketHVSOCKGetAddr(%p,%d)\n", ciptr, peer);
+
+    bzero (&sockname, sizeof (sockname));
+
+    if ((peer ? getpeername (ciptr->fd, (struct sockaddr *) &sockname,
+			     (void *)&namelen)
+	      : getsockname (ciptr->fd, (struct sockaddr *) &sockname,
+			     (void *)&namelen)) < 0)
+    {
+#ifdef WIN32
+	errno = WSAGetLastError();
+#endif
+	prmsg (1,"SocketHVSOCKGetAddr: get%sname() failed: %d\n",
+	    peer ? "peer" : "sock", EGET());
+	return -1;
+    }
+
+    if ((addr = malloc (namelen)) == NULL)
+    {
+        prmsg (1,
+	    "SocketHVSOCKGetAddr: Can't allocate space for the addr\n");
+        return -1;
+    }
+    memcpy (addr, &sockname, namelen);
+
+    if (peer)
+    {
+	ciptr->peeraddr = addr;
+	ciptr->peeraddrlen = namelen;
+    }
+    else
+    {
+	ciptr->family = ((struct sockaddr *) &sockname)->sa_family;
+	ciptr->addr = addr;
+	ciptr->addrlen = namelen;
+    }
+
+    return 0;
+}
+
+
+#ifdef TRANS_SERVER
+
+static int
+TRANS(SocketHVSOCKCreateListener) (XtransConnInfo ciptr, const char *port,
+                                   unsigned int flags)
+
+{
+    struct sockaddr_hvsock	sockname;
+    int				status;
+
+    prmsg (2, "SocketHVSOCKCreateListener(%s)\n", port);
+
+    if (TRANS(SocketHVSOCKFillAddr) (&sockname, NULL, port, 1) < 0)
+	return TRANS_CREATE_LISTENER_FAILED;
+
+    if ((status = TRANS(SocketCreateListener) (ciptr,
+	(struct sockaddr *) &sockname, sizeof(sockname), flags)) < 0)
+    {
+	prmsg (1,
+    "SocketHVSOCKCreateListener: ...SocketCreateListener() failed\n");
+	return status;
+    }
+
+    if (TRANS(SocketHVSOCKGetAddr) (ciptr, 0) < 0)
+    {
+	prmsg (1,
+       "SocketHVSOCKCreateListener: ...SocketHVSOCKGetAddr() failed\n");
+	return TRANS_CREATE_LISTENER_FAILED;
+    }
+
+    return 0;
+}
+
+
+static XtransConnInfo
+TRANS(SocketHVSOCKAccept) (XtransConnInfo ciptr, int *status)
+
+{
+    XtransConnInfo	newciptr;
+
+    prmsg (2, "SocketHVSOCKAccept(%p,%d)\n", ciptr, ciptr->fd);
+
+    if ((newciptr = calloc (1, sizeof(struct _XtransConnInfo))) == NULL)
+    {
+	prmsg (1, "SocketHVSOCKAccept: malloc failed\n");
+	*status = TRANS_ACCEPT_BAD_MALLOC;
+	return NULL;
+    }
+
+    if ((newciptr->fd = accept (ciptr->fd, NULL, NULL)) < 0)
+    {
+#ifdef WIN32
+	errno = WSAGetLastError();
+#endif
+	prmsg (1, "SocketHVSOCKAccept: accept() failed\n");
+	free (newciptr);
+	*status = TRANS_ACCEPT_FAILED;
+	return NULL;
+    }
+
+    if (TRANS(SocketHVSOCKGetAddr) (newciptr, 0) < 0 ||
+	TRANS(SocketHVSOCKGetAddr) (newciptr, 1) < 0)
+    {
+	prmsg (1,
+	    "SocketHVSOCKAccept: ...SocketHVSOCKGetAddr() failed:\n");
+	close (newciptr->fd);
+	free (newciptr->addr);
+	free (newciptr);
+	*status = TRANS_ACCEPT_MISC_ERROR;
+        return NULL;
+    }
+
+    *status = 0;
+
+    return newciptr;
+}
+
+#endif /* TRANS_SERVER */
+
+
+#ifdef TRANS_CLIENT
+
+static int
+TRANS(SocketHVSOCKConnect) (XtransConnInfo ciptr,
+			    const char *host, const char *port)
+
+{
+    struct sockaddr_hvsock	sockname;
+
+    prmsg (2,"SocketHVSOCKConnect(%d,%s,%s)\n", ciptr->fd, host, port);
+
+    if (TRANS(SocketHVSOCKFillAddr) (&sockname, host, port, 0) < 0)
+	return TRANS_CONNECT_FAILED;
+
+    if (connect (ciptr->fd, (struct sockaddr *) &sockname,
+		 sizeof (sockname)) < 0)
+    {
+#ifdef WIN32
+	int olderrno = WSAGetLastError();
+#else
+	int olderrno = errno;
+#endif
+
+	if (olderrno == EWOULDBLOCK || olderrno == EINPROGRESS)
+	    return TRANS_IN_PROGRESS;
+	else if (olderrno == EINTR)
+	    return TRANS_TRY_CONNECT_AGAIN;
+
+	prmsg (2,"SocketHVSOCKConnect: Can't connect: errno = %d\n",
+	       olderrno);
+	return TRANS_CONNECT_FAILED;
+    }
+
+    if (TRANS(SocketHVSOCKGetAddr) (ciptr, 0) < 0 ||
+	TRANS(SocketHVSOCKGetAddr) (ciptr, 1) < 0)
+    {
+	prmsg (1,
+	    "SocketHVSOCKConnect: ...SocketHVSOCKGetAddr() failed:\n");
+	return TRANS_CONNECT_FAILED;
+    }
+
+    return 0;
+}
+
+#endif /* TRANS_CLIENT */
+
+#endif /* HVSOCKCONN */
+
+
+#ifdef ZTCPCONN
+
+/*
+ * Every write ends in a sync flush, so whatever the server flushes as
+ * whole replies and events arrives as such, and the same holds for
+ * requests from the client.  The deflate window carries over from one
+ * flush to the next, so repeated glyphs and image rows shrink too.
+ */
+
+#define ZTCP_PORT_OFFSET	100
+#define ZTCP_LEVEL		1	/* fastest; the link is the bottleneck */
+#define ZTCP_BUFSIZE		16384
+
+typedef struct _ZTCPState {
+    z_stream		in;
+    z_stream		out;
+    int			in_full;	/* last inflate filled the caller's buffer */
+    int			out_dirty;	/* deflated data not yet sync flushed */
+    int			owed;		/* consumed but not yet reported written */
+    int			out_len;
+    unsigned char	in_buf[ZTCP_BUFSIZE];
+    unsigned char	out_buf[ZTCP_BUFSIZE];
+} ZTCPState;
+
+static int
+TRANS(ZTCPInit) (XtransConnInfo ciptr)
+
+{
+    ZTCPState	*z;
+
+    if ((z = calloc (1, sizeof(ZTCPState))) == NULL)
+	return -1;
+
+    if (inflateInit (&z->in) != Z_OK)
+    {
+	free (z);
+	return -1;
+    }
+    if (deflateInit (&z->out, ZTCP_LEVEL) != Z_OK)
+    {
+	inflateEnd (&z->in);
+	free (z);
+	return -1;
+    }
+
+    ciptr->priv = (char *) z;
+    return 0;
+}
+
+/*
+ * The display number names the ztcp port; the INET code adds X_TCP_PORT.
+ */
+
+static const char *
+TRANS(ZTCPPort) (const char *port, char *buf, size_t len)
+
+{
+    if (!port || !is_numeric (port))
+	return NULL;
+
+    snprintf (buf, len, "%ld",
+	strtol (port, (char**)NULL, 10) + ZTCP_PORT_OFFSET);
+    return buf;
+}
+
+/* Returns 0 once out_buf is empty, -1 with errno set otherwise. */
+
+static int
+TRANS(ZTCPSend) (XtransConnInfo ciptr, ZTCPState *z)
+
+{
+    while (z->out_len > 0)
+    {
+#ifdef WIN32
+	int n = send ((SOCKET)ciptr->fd, (char *) z->out_buf, z->out_len, 0);
+	if (n == SOCKET_ERROR) errno = WSAGetLastError();
+#else
+	int n = write (ciptr->fd, z->out_buf, z->out_len);
+#endif
+	if (n <= 0)
+	{
+	    if (n == 0)
+		errno = EWOULDBLOCK;
+	    return -1;
+	}
+	z->out_len -= n;
+	memmove (z->out_buf, z->out_buf + n, z->out_len);
+    }
+    return 0;
+}
+
+static void
+TRANS(ZTCPDeflate) (ZTCPState *z, int flush)
+
+{
+    z->out.next_out = z->out_buf + z->out_len;
+    z->out.avail_out = ZTCP_BUFSIZE - z->out_len;
+    deflate (&z->out, flush);
+    z->out_len = ZTCP_BUFSIZE - z->out.avail_out;
+}
+
+static int
+TRANS(ZTCPFlush) (XtransConnInfo ciptr, ZTCPState *z)
+
+{
+    while (z->out_dirty)
+    {
+	z->out.avail_in = 0;
+	TRANS(ZTCPDeflate) (z, Z_SYNC_FLUSH);
+	if (z->out.avail_out)
+	    z->out_dirty = 0;
+	if (TRANS(ZTCPSend) (ciptr, z) < 0)
+	    return -1;
+    }
+    return TRANS(ZTCPSend) (ciptr, z);
+}
+
+
+#ifdef TRANS_SERVER
+
+static int
+TRANS(SocketZTCPCreateListener) (XtransConnInfo ciptr, const char *port,
+                                 unsigned int flags)
+
+{
+    char	portbuf[PORTBUFSIZE];
+
+    prmsg (2, "SocketZTCPCreateListener(%s)\n", port);
+
+    if ((port = TRANS(ZTCPPort) (port, portbuf, sizeof(portbuf))) == NULL)
+    {
+	prmsg (1, "SocketZTCPCreateListener: port is not a display number\n");
+	return TRANS_CREATE_LISTENER_FAILED;
+    }
+
+    return TRANS(SocketINETCreateListener) (ciptr, port, flags);
+}
+
+
+static XtransConnInfo
+TRANS(SocketZTCPAccept) (XtransConnInfo ciptr, int *status)
+
+{
+    XtransConnInfo	newciptr;
+
+    prmsg (2, "SocketZTCPAccept(%p,%d)\n", ciptr, ciptr->fd);
+
+    if ((newciptr = TRANS(SocketINETAccept) (ciptr, status)) == NULL)
+	return NULL;
+
+    if (TRANS(ZTCPInit) (newciptr) < 0)
+    {
+	prmsg (1, "SocketZTCPAccept: ...ZTCPInit() failed\n");
+	close (newciptr->fd);
+	free (newciptr->addr);
+	free (newciptr->peeraddr);
+	free (newciptr);
+	*status = TRANS_ACCEPT_BAD_MALLOC;
+	return NULL;
+    }
+
+    return newciptr;
+}
+
+#endif /* TRANS_SERVER */
+
+
+#ifdef TRANS_CLIENT
+
+static int
+TRANS(SocketZTCPConnect) (XtransConnInfo ciptr,
+			  const char *host, const char *port)
+
+{
+    char	portbuf[PORTBUFSIZE];
+    int		ret;
+
+    prmsg (2,"SocketZTCPConnect(%d,%s,%s)\n", ciptr->fd, host, port);
+
+    if ((port = TRANS(ZTCPPort) (port, portbuf, sizeof(portbuf))) == NULL)
+    {
+	prmsg (1, "SocketZTCPConnect: port is not a display number\n");
+	return TRANS_CONNECT_FAILED;
+    }
+
+    if ((ret = TRANS(SocketINETConnect) (ciptr, host, port)) < 0)
+	return ret;
+
+    if (TRANS(ZTCPInit) (ciptr) < 0)
+    {
+	prmsg (1, "SocketZTCPConnect: ...ZTCPInit() failed\n");
+	return TRANS_CONNECT_FAILED;
+    }
+
+    return 0;
+}
+
+#endif /* TRANS_CLIENT */
+
+
+static int
+TRANS(SocketZTCPBytesReadable) (XtransConnInfo ciptr, BytesReadable_t *pend)
+
+{
+    ZTCPState	*z = (ZTCPState *) ciptr->priv;
+
+    if (TRANS(SocketBytesReadable) (ciptr, pend) < 0)
+	return -1;
+
+    /* only ever a hint: compressed bytes on the wire, or "some" */
+    if (*pend == 0 && (z->in.avail_in > 0 || z->in_full))
+	*pend = 1;
+    return 0;
+}
+
+/*
+ * Keeps inflating what is buffered before reading the socket again, and
+ * only fails with EWOULDBLOCK once all of it has been handed out: the
+ * server keeps reading a client until then, without polling.
+ */
+
+static int
+TRANS(SocketZTCPRead) (XtransConnInfo ciptr, char *buf, int size)
+
+{
+    ZTCPState	*z = (ZTCPState *) ciptr->priv;
+    int		ret, n;
+
+    prmsg (2,"SocketZTCPRead(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+    if (size <= 0)
+	return 0;
+
+    for (;;)
+    {
+	if (!z->in.avail_in && !z->in_full)
+	{
+#ifdef WIN32
+	    n = recv ((SOCKET)ciptr->fd, (char *) z->in_buf, ZTCP_BUFSIZE, 0);
+	    if (n == SOCKET_ERROR) errno = WSAGetLastError();
+#else
+	    n = read (ciptr->fd, z->in_buf, ZTCP_BUFSIZE);
+#endif
+	    if (n <= 0)
+		return n;
+	    z->in.next_in = z->in_buf;
+	    z->in.avail_in = n;
+	}
+
+	z->in.next_out = (Bytef *) buf;
+	z->in.avail_out = size;
+	ret = inflate (&z->in, Z_SYNC_FLUSH);
+	/* the peer never finishes its stream, so Z_STREAM_END is bad data */
+	if (ret != Z_OK && ret != Z_BUF_ERROR)
+	{
+	    prmsg (1, "SocketZTCPRead: inflate() failed: %d\n", ret);
+	    errno = EIO;
+	    return -1;
+	}
+
+	z->in_full = !z->in.avail_out;
+	if ((n = size - z->in.avail_out) > 0)
+	    return n;
+    }
+}
+
+static int
+TRANS(SocketZTCPReadv) (XtransConnInfo ciptr, struct iovec *buf, int size)
+
+{
+    int i;
+
+    prmsg (2,"SocketZTCPReadv(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+    /* a short read is always allowed */
+    for (i = 0; i < size; i++)
+	if (buf[i].iov_len > 0)
+	    return TRANS(SocketZTCPRead) (ciptr, buf[i].iov_base,
+					  buf[i].iov_len);
+    return 0;
+}
+
+/*
+ * Only counts a byte as written once its compressed form has been handed
+ * to the socket.  When the tail of a write is still waiting in out_buf,
+ * one byte is held back from the count, so that the caller waits for the
+ * socket to drain and offers that byte again; it is then skipped.
+ */
+
+static int
+TRANS(SocketZTCPWritev) (XtransConnInfo ciptr, struct iovec *buf, int size)
+
+{
+    ZTCPState	*z = (ZTCPState *) ciptr->priv;
+    int		i, done = 0;
+
+    prmsg (2,"SocketZTCPWritev(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+    if (TRANS(ZTCPFlush) (ciptr, z) < 0)
+	return -1;
+
+    for (i = 0; i < size; i++)
+    {
+	char	*base = buf[i].iov_base;
+	int	len = buf[i].iov_len;
+
+	if (z->owed)
+	{
+	    int skip = len < z->owed ? len : z->owed;
+
+	    base += skip;
+	    len -= skip;
+	    done += skip;
+	    z->owed -= skip;
+	}
+
+	while (len > 0)
+	{
+	    if (z->out_len == ZTCP_BUFSIZE &&
+		TRANS(ZTCPSend) (ciptr, z) < 0)
+	    {
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+		    return -1;
+		goto blocked;
+	    }
+
+	    z->out.next_in = (Bytef *) base;
+	    z->out.avail_in = len;
+	    TRANS(ZTCPDeflate) (z, Z_NO_FLUSH);
+	    base += len - z->out.avail_in;
+	    done += len - z->out.avail_in;
+	    len = z->out.avail_in;
+	    z->out_dirty = 1;
+	}
+    }
+
+    if (TRANS(ZTCPFlush) (ciptr, z) < 0)
+    {
+	if (errno != EAGAIN && errno != EWOULDBLOCK)
+	    return -1;
+	if (done > 0)
+	{
+	    z->owed = 1;
+	    done--;
+	}
+    }
+
+blocked:
+    if (done == 0 && size > 0)
+    {
+	errno = EWOULDBLOCK;
+	return -1;
+    }
+    return done;
+}
+
+static int
+TRANS(SocketZTCPWrite) (XtransConnInfo ciptr, char *buf, int size)
+
+{
+    struct iovec	iov;
+
+    prmsg (2,"SocketZTCPWrite(%d,%p,%d)\n", ciptr->fd, buf, size);
+
+    iov.iov_base = buf;
+    iov.iov_len = size;
+    return TRANS(SocketZTCPWritev) (ciptr, &iov, 1);
+}
+
+static int
+TRANS(SocketZTCPClose) (XtransConnInfo ciptr)
+
+{
+    ZTCPState	*z = (ZTCPState *) ciptr->priv;
+
+    prmsg (2,"SocketZTCPClose(%p,%d)\n", ciptr, ciptr->fd);
+
+    if (z)
+    {
+	inflateEnd (&z->in);
+	deflateEnd (&z->out);
+	free (z);
+	ciptr->priv = NULL;
+    }
+
+    return TRANS(SocketINETClose) (ciptr);
+}
+
+#endif /* ZTCPCONN */
+
+
 #ifdef TCPCONN
 # ifdef TRANS_SERVER
 static const char* tcp_nolisten[] = {
@@ -2596,3 +3359,77 @@ Xtransport	TRANS(SocketUNIXFuncs) = {
 	};
 
 #endif /* UNIXCONN */
+
+#ifdef HVSOCKCONN
+Xtransport	TRANS(SocketHVSOCKFuncs) = {
+	/* Socket Interface */
+	"hvsock",
+	TRANS_NOLISTEN,		/* only with -listen hvsock */
+#ifdef TRANS_CLIENT
+	TRANS(SocketOpenCOTSClient),
+#endif /* TRANS_CLIENT */
+#ifdef TRANS_SERVER
+	NULL,
+	TRANS(SocketOpenCOTSServer),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_REOPEN
+	TRANS(SocketReopenCOTSServer),
+#endif
+	TRANS(SocketSetOption),
+#ifdef TRANS_SERVER
+	TRANS(SocketHVSOCKCreateListener),
+	NULL,		       			/* ResetListener */
+	TRANS(SocketHVSOCKAccept),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_CLIENT
+	TRANS(SocketHVSOCKConnect),
+#endif /* TRANS_CLIENT */
+	TRANS(SocketBytesReadable),
+	TRANS(SocketRead),
+	TRANS(SocketWrite),
+	TRANS(SocketReadv),
+	TRANS(SocketWritev),
+	TRANS(SocketSendFdInvalid),
+	TRANS(SocketRecvFdInvalid),
+	TRANS(SocketDisconnect),
+	TRANS(SocketINETClose),
+	TRANS(SocketINETClose),
+	};
+#endif /* HVSOCKCONN */
+
+#ifdef ZTCPCONN
+Xtransport	TRANS(SocketZTCPFuncs) = {
+	/* Socket Interface */
+	"ztcp",
+	TRANS_NOLISTEN,		/* only with -listen ztcp */
+#ifdef TRANS_CLIENT
+	TRANS(SocketOpenCOTSClient),
+#endif /* TRANS_CLIENT */
+#ifdef TRANS_SERVER
+	NULL,
+	TRANS(SocketOpenCOTSServer),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_REOPEN
+	TRANS(SocketReopenCOTSServer),
+#endif
+	TRANS(SocketSetOption),
+#ifdef TRANS_SERVER
+	TRANS(SocketZTCPCreateListener),
+	NULL,		       			/* ResetListener */
+	TRANS(SocketZTCPAccept),
+#endif /* TRANS_SERVER */
+#ifdef TRANS_CLIENT
+	TRANS(SocketZTCPConnect),
+#endif /* TRANS_CLIENT */
+	TRANS(SocketZTCPBytesReadable),
+	TRANS(SocketZTCPRead),
+	TRANS(SocketZTCPWrite),
+	TRANS(SocketZTCPReadv),
+	TRANS(SocketZTCPWritev),
+	TRANS(SocketSendFdInvalid),
+	TRANS(SocketRecvFdInvalid),
+	TRANS(SocketDisconnect),
+	TRANS(SocketZTCPClose),
+	TRANS(SocketZTCPClose),
+	};
+#endif /* ZTCPCONN */
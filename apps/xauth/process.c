@@ -891,12 +891,24 @@ auth_finalize(void)
 			 "%s:  unable to write authority file %s\n",
 			 ProgramName, temp_name);
 	    } else {
+		/*
+		 * Replace the old file in one step where we can, so that
+		 * programs reading it, which take no lock, never find it
+		 * missing or half written.
+		 */
+#if defined(WIN32)
+		if (!MoveFileExA(temp_name, xauth_filename,
+				 MOVEFILE_REPLACE_EXISTING) &&
+		    (unlink (xauth_filename),
+		     rename(temp_name, xauth_filename) == -1))
+#elif defined(__UNIXOS2__)
 		(void) unlink (xauth_filename);
-#if defined(WIN32) || defined(__UNIXOS2__)
 		if (rename(temp_name, xauth_filename) == -1)
 #else
-		/* Attempt to rename() if link() fails, since this may be on a FS that does not support hard links */
-		if (link (temp_name, xauth_filename) == -1 && rename(temp_name, xauth_filename) == -1)
+		/* Attempt to link() if rename() fails, since this may be on a FS that cannot replace files */
+		if (rename(temp_name, xauth_filename) == -1 &&
+		    (unlink (xauth_filename),
+		     link (temp_name, xauth_filename) == -1))
 #endif
 		{
 		    fprintf (stderr,
@@ -114,6 +114,17 @@ typedef struct _String {
     int room, used;
 } String;
 
+/* macros known to the built-in preprocessor */
+#define INIT_SYMBOL_SIZE 100
+typedef struct _Symbol {
+    char *name, *value;		/* value is NULL once undefined */
+    Bool function;		/* was defined with arguments */
+} Symbol;
+typedef struct _Symbols {
+    Symbol *symbol;
+    int   room, used;
+} Symbols;
+
 static char *ProgramName;
 static Bool quiet = False;
 static char tmpname[32];
@@ -129,6 +140,7 @@ static int oper = OPLOAD;
 static char *editFile = NULL;
 static const char *cpp_program = NULL;
 static const char* const cpp_locations[] = { CPP };
+static Bool builtin_cpp = False;
 static char *backup_suffix = BACKUP_SUFFIX;
 static Bool dont_execute = False;
 static String defines;
@@ -137,6 +149,11 @@ static int defines_base;
 static char *cmd_defines[MAX_CMD_DEFINES];
 static int num_cmd_defines = 0;
 static String includes;
+#define MAX_INCLUDE_DIRS 64
+static char *include_dirs[MAX_INCLUDE_DIRS];
+static int num_include_dirs = 0;
+static Symbols symbols;
+static int symbols_base;
 static Display *dpy;
 static Buffer buffer;
 static Entries newDB;
@@ -145,6 +162,8 @@ static void fatal(char *, ...);
 static void addstring ( String *arg, const char *s );
 static void addescapedstring ( String *arg, const char *s );
 static void addtokstring ( String *arg, const char *s );
+static void escapedcopy ( char *copy, int size, const char *s );
+static void tokcopy ( char *copy, int size, const char *s );
 static void FormatEntries ( Buffer *buffer, Entries *entries );
 static void StoreProperty ( Display *dpy, Window root, Atom res_prop );
 static void Process ( int scrno, Bool doScreen, Bool execute );
@@ -201,13 +220,11 @@ InitBuffer(Buffer *b)
     b->buff = (char *)malloc(INIT_BUFFER_SIZE*sizeof(char));
 }
 
-#ifdef notyet
 static void 
 FreeBuffer(Buffer *b)
 {
     free(b->buff);
 }
-#endif
 
 static void 
 AppendToBuffer(Buffer *b, char *str, int len)
@@ -415,9 +432,78 @@ ReadFile(Buffer *buffer, FILE *input)
     AppendToBuffer(buffer, "", 1);
 }
 
+static Symbol *
+LookupSymbol(const char *name, int len)
+{
+    int n;
+
+    /* the latest definition or #undef is the one in effect */
+    for (n = symbols.used; --n >= 0; ) {
+	if (!strncmp(symbols.symbol[n].name, name, len) &&
+	    symbols.symbol[n].name[len] == '\0')
+	    return symbols.symbol[n].value ? &symbols.symbol[n] : NULL;
+    }
+    return NULL;
+}
+
+static void
+AddSymbol(const char *name, const char *value, Bool function)
+{
+    Symbol *sym;
+
+    if (symbols.used > symbols_base &&
+	!strcmp(symbols.symbol[symbols.used - 1].name, name)) {
+	/* AddDefQ() redefining what AddSimpleDef() just added */
+	sym = &symbols.symbol[symbols.used - 1];
+	free(sym->value);
+    } else {
+	if (symbols.used == symbols.room) {
+	    symbols.room = symbols.room ? 2 * symbols.room : INIT_SYMBOL_SIZE;
+	    symbols.symbol = (Symbol *)realloc(symbols.symbol,
+					       symbols.room * sizeof(Symbol));
+	    if (!symbols.symbol)
+		fatal("%s: Not enough memory\n", ProgramName);
+	}
+	sym = &symbols.symbol[symbols.used++];
+	sym->name = strdup(name);
+	if (!sym->name)
+	    fatal("%s: Not enough memory\n", ProgramName);
+    }
+    sym->value = NULL;
+    if (value && !(sym->value = strdup(value)))
+	fatal("%s: Not enough memory\n", ProgramName);
+    sym->function = function;
+}
+
+/* Forget the symbols defined since there were base of them */
+static void
+FreeSymbols(int base)
+{
+    while (symbols.used > base) {
+	symbols.used--;
+	free(symbols.symbol[symbols.used].name);
+	free(symbols.symbol[symbols.used].value);
+    }
+}
+
+/* Record a -D the way the shell and cpp would have seen it */
+static void
+AddDefSymbol(char *title, char *value)
+{
+    char name[512], val[512];
+
+    tokcopy(name, sizeof(name), title);
+    if (value && value[0] != '\0')
+	escapedcopy(val, sizeof(val), value);
+    else
+	strcpy(val, "1");
+    AddSymbol(name, val, False);
+}
+
 static void
 AddDef(String *buff, char *title, char *value)
 {
+    AddDefSymbol(title, value);
 #ifdef PATHETICCPP
     if (need_real_defines) {
 	addstring(buff, "\n#define ");
@@ -462,6 +548,7 @@ AddDefQ(String *buff, char *title, char *value)
 	addstring(buff, "=\"");
 	addescapedstring(buff, value);
 	addstring(buff, "\"");
+	AddDefSymbol(title, value);
     } else
 	AddDef(buff, title, NULL);
 }
@@ -502,6 +589,10 @@ AddDefHostname(String *buff, char *title, char *value)
 static void
 AddUndef(String *buff, char *title)
 {
+    char name[512];
+
+    tokcopy(name, sizeof(name), title);
+    AddSymbol(name, NULL, False);
 #ifdef PATHETICCPP
     if (need_real_defines) {
 	addstring(buff, "\n#undef ");
@@ -652,6 +743,688 @@ DoScreenDefines(Display *display, int scrno, String *defs)
     XFree((char *)vinfos);
 }
 
+/*
+ * The built-in preprocessor
+ *
+ * Enough of cpp for resource files, without starting a separate program
+ * for each screen: #include, #define and #undef of simple macros, and the
+ * #if family with defined() and integer expressions.  Macros are expanded
+ * in the text, outside of double quotes; macros with arguments are only
+ * known to #ifdef and defined().  Comments are stripped, and everything
+ * else, backslash-newlines included, goes through as it is, with a blank
+ * line for each line which didn't, to keep the line numbers of warnings.
+ */
+
+#define CPP_MAX_INCLUDE_DEPTH 32
+#define CPP_MAX_CONDITIONALS 64
+#define CPP_MAX_EXPANSION 32
+
+typedef struct _CppCond {
+    Bool parent;		/* the enclosing text is used */
+    Bool taking;		/* the current branch is used */
+    Bool done;			/* a branch has been used */
+    Bool seen_else;
+} CppCond;
+
+static CppCond cpp_cond[CPP_MAX_CONDITIONALS];
+static int cpp_ncond = 0;
+
+/* Macros being expanded, which aren't expanded again inside themselves */
+typedef struct _CppActive {
+    const char *name[CPP_MAX_EXPANSION];
+    int num;
+} CppActive;
+
+typedef struct _CppExpr {
+    const char *p;
+    CppActive *active;
+    Bool error;
+} CppExpr;
+
+#define CppIsIdent(c) (isascii(c) && (isalnum(c) || (c) == '_'))
+
+static Bool
+CppActiveMacro(CppActive *active, const char *name)
+{
+    int i;
+
+    for (i = 0; i < active->num; i++)
+	if (active->name[i] == name)
+	    return True;
+    return False;
+}
+
+static Bool
+CppIsActive(void)
+{
+    return cpp_ncond == 0 || cpp_cond[cpp_ncond - 1].taking;
+}
+
+static const char *
+CppSkipSpace(const char *p)
+{
+    while (*p && isascii(*p) && isspace(*p))
+	p++;
+    return p;
+}
+
+static long CppEvalCond(CppExpr *e);
+
+static long
+CppEvalMacro(CppExpr *e, Symbol *sym)
+{
+    CppExpr sub;
+    long val;
+
+    if (sym->function || e->active->num == CPP_MAX_EXPANSION ||
+	CppActiveMacro(e->active, sym->name))
+	return 0;
+    sub.p = sym->value;
+    sub.active = e->active;
+    sub.error = False;
+    e->active->name[e->active->num++] = sym->name;
+    val = CppEvalCond(&sub);
+    e->active->num--;
+    if (sub.error || *CppSkipSpace(sub.p))
+	e->error = True;
+    return val;
+}
+
+static long
+CppEvalUnary(CppExpr *e)
+{
+    const char *p = CppSkipSpace(e->p);
+    long val;
+    char *end;
+
+    e->p = p + 1;
+    switch (*p) {
+    case '(':
+	val = CppEvalCond(e);
+	e->p = CppSkipSpace(e->p);
+	if (*e->p == ')')
+	    e->p++;
+	else
+	    e->error = True;
+	return val;
+    case '!':
+	return !CppEvalUnary(e);
+    case '~':
+	return ~CppEvalUnary(e);
+    case '-':
+	return -CppEvalUnary(e);
+    case '+':
+	return CppEvalUnary(e);
+    case '\'':
+	if (*e->p == '\\') {
+	    e->p++;
+	    switch (*e->p) {
+	    case 'n': val = '\n'; break;
+	    case 't': val = '\t'; break;
+	    case '0': val = '\0'; break;
+	    default: val = (unsigned char)*e->p; break;
+	    }
+	} else
+	    val = (unsigned char)*e->p;
+	if (*e->p)
+	    e->p++;
+	if (*e->p == '\'')
+	    e->p++;
+	else
+	    e->error = True;
+	return val;
+    }
+
+    e->p = p;
+    if (isascii(*p) && isdigit(*p)) {
+	val = strtol(p, &end, 0);
+	for (p = end; *p == 'u' || *p == 'U' || *p == 'l' || *p == 'L'; p++)
+	    ;
+	e->p = p;
+	return val;
+    }
+    if (CppIsIdent(*p)) {
+	const char *name = p;
+	Symbol *sym;
+	int len;
+
+	while (CppIsIdent(*p))
+	    p++;
+	len = p - name;
+	e->p = p;
+	if (len == 7 && !strncmp(name, "defined", 7)) {
+	    Bool paren;
+
+	    p = CppSkipSpace(p);
+	    paren = (*p == '(');
+	    if (paren)
+		p = CppSkipSpace(p + 1);
+	    for (name = p; CppIsIdent(*p); p++)
+		;
+	    if (p == name)
+		e->error = True;
+	    val = LookupSymbol(name, p - name) != NULL;
+	    if (paren) {
+		p = CppSkipSpace(p);
+		if (*p == ')')
+		    p++;
+		else
+		    e->error = True;
+	    }
+	    e->p = p;
+	    return val;
+	}
+	/* names which aren't macros are 0, as in cpp */
+	sym = LookupSymbol(name, len);
+	return sym ? CppEvalMacro(e, sym) : 0;
+    }
+    e->error = True;
+    return 0;
+}
+
+static const char *const CppBinaryOps[] = {
+    /* highest precedence last, longer operators before their prefixes */
+    "||", "&&", "|", "^", "&", "== !=", "<= >= < >", "<< >>", "+ -", "* / %"
+};
+#define CPP_NUM_PRECEDENCES (sizeof(CppBinaryOps) / sizeof(CppBinaryOps[0]))
+
+/* The precedence of the binary operator at p, and its length, or 0 */
+static int
+CppBinaryOp(const char *p, int *len)
+{
+    int prec;
+
+    for (prec = CPP_NUM_PRECEDENCES; prec > 0; prec--) {
+	const char *op = CppBinaryOps[prec - 1];
+
+	while (*op) {
+	    int n = 0;
+
+	    while (op[n] && op[n] != ' ')
+		n++;
+	    /* don't take the & of && or the | of || */
+	    if (!strncmp(p, op, n) &&
+		!(n == 1 && (*p == '&' || *p == '|') && p[1] == *p) &&
+		!(n == 1 && (*p == '<' || *p == '>') &&
+		  (p[1] == *p || p[1] == '='))) {
+		*len = n;
+		return prec;
+	    }
+	    op += n;
+	    while (*op == ' ')
+		op++;
+	}
+    }
+    return 0;
+}
+
+static long
+CppEvalBinary(CppExpr *e, int min_prec)
+{
+    long lhs = CppEvalUnary(e), rhs;
+    int prec, len;
+    char op[3];
+
+    for (;;) {
+	e->p = CppSkipSpace(e->p);
+	prec = CppBinaryOp(e->p, &len);
+	if (!prec || prec < min_prec || e->error)
+	    return lhs;
+	op[0] = e->p[0];
+	op[1] = len > 1 ? e->p[1] : '\0';
+	op[2] = '\0';
+	e->p += len;
+	rhs = CppEvalBinary(e, prec + 1);
+
+	switch (op[0]) {
+	case '|': lhs = op[1] ? (lhs || rhs) : (lhs | rhs); break;
+	case '&': lhs = op[1] ? (lhs && rhs) : (lhs & rhs); break;
+	case '^': lhs ^= rhs; break;
+	case '=': lhs = lhs == rhs; break;
+	case '!': lhs = lhs != rhs; break;
+	case '<':
+	    lhs = op[1] == '<' ? lhs << rhs :
+		  op[1] == '=' ? lhs <= rhs : lhs < rhs;
+	    break;
+	case '>':
+	    lhs = op[1] == '>' ? lhs >> rhs :
+		  op[1] == '=' ? lhs >= rhs : lhs > rhs;
+	    break;
+	case '+': lhs += rhs; break;
+	case '-': lhs -= rhs; break;
+	case '*': lhs *= rhs; break;
+	case '/':
+	case '%':
+	    if (rhs == 0) {
+		e->error = True;
+		return 0;
+	    }
+	    lhs = op[0] == '/' ? lhs / rhs : lhs % rhs;
+	    break;
+	}
+    }
+}
+
+static long
+CppEvalCond(CppExpr *e)
+{
+    long cond = CppEvalBinary(e, 1), a, b;
+
+    e->p = CppSkipSpace(e->p);
+    if (*e->p != '?' || e->error)
+	return cond;
+    e->p++;
+    a = CppEvalCond(e);
+    e->p = CppSkipSpace(e->p);
+    if (*e->p != ':') {
+	e->error = True;
+	return 0;
+    }
+    e->p++;
+    b = CppEvalCond(e);
+    return cond ? a : b;
+}
+
+static Bool
+CppEvalIf(const char *expr, const char *file, int lineno)
+{
+    CppActive active;
+    CppExpr e;
+    long val;
+
+    active.num = 0;
+    e.p = expr;
+    e.active = &active;
+    e.error = False;
+    val = CppEvalCond(&e);
+    if (e.error || *CppSkipSpace(e.p)) {
+	if (!quiet)
+	    fprintf(stderr, "%s: %s:%d: bad expression in #if, taken as 0\n",
+		    ProgramName, file, lineno);
+	return False;
+    }
+    return val != 0;
+}
+
+/* Append s to the buffer with the macros in it expanded */
+static void
+CppExpand(Buffer *out, const char *s, int len, CppActive *active)
+{
+    const char *end = s + len, *start;
+
+    while (s < end) {
+	start = s;
+	if (*s == '"') {
+	    for (s++; s < end && *s != '"'; s++)
+		if (*s == '\\' && s + 1 < end)
+		    s++;
+	    if (s < end)
+		s++;
+	} else if (isascii(*s) && isdigit(*s)) {
+	    while (s < end && (CppIsIdent(*s) || *s == '.'))
+		s++;
+	} else if (CppIsIdent(*s)) {
+	    Symbol *sym;
+
+	    while (s < end && CppIsIdent(*s))
+		s++;
+	    sym = LookupSymbol(start, s - start);
+	    if (sym && !sym->function && active->num < CPP_MAX_EXPANSION &&
+		!CppActiveMacro(active, sym->name)) {
+		active->name[active->num++] = sym->name;
+		CppExpand(out, sym->value, strlen(sym->value), active);
+		active->num--;
+		continue;
+	    }
+	} else {
+	    while (s < end && *s != '"' && !CppIsIdent(*s))
+		s++;
+	}
+	AppendToBuffer(out, (char *)start, s - start);
+    }
+}
+
+/*
+ * Replace comments in the line with a space each, keeping the newlines
+ * of ones which span lines.  *in_comment carries over from line to line.
+ */
+static void
+CppStripComments(char *line, Bool *in_comment)
+{
+    char *s = line, *d = line;
+    Bool in_string = False;
+
+    while (*s) {
+	if (*in_comment) {
+	    if (s[0] == '*' && s[1] == '/') {
+		*in_comment = False;
+		*d++ = ' ';
+		s += 2;
+	    } else {
+		if (*s == '\n')
+		    *d++ = '\n';
+		s++;
+	    }
+	} else if (in_string) {
+	    if (*s == '\\' && s[1] && s[1] != '\n')
+		*d++ = *s++;
+	    else if (*s == '"' || *s == '\n')
+		in_string = False;
+	    *d++ = *s++;
+	} else if (s[0] == '/' && s[1] == '*') {
+	    *in_comment = True;
+	    s += 2;
+	} else {
+	    if (*s == '"')
+		in_string = True;
+	    *d++ = *s++;
+	}
+    }
+    *d = '\0';
+}
+
+/* Open an #include, looking beside the including file first for "name" */
+static FILE *
+CppOpenInclude(const char *name, Bool quoted, const char *from,
+	       char **path)
+{
+    const char *slash;
+    FILE *fp;
+    int i;
+
+    slash = from ? strrchr(from, '/') : NULL;
+#ifdef WIN32
+    {
+	const char *bslash = from ? strrchr(from, '\\') : NULL;
+
+	if (bslash && (!slash || bslash > slash))
+	    slash = bslash;
+    }
+#endif
+    if (name[0] == '/'
+#ifdef WIN32
+	|| name[0] == '\\' || (name[0] && name[1] == ':')
+#endif
+	) {
+	if (!(fp = fopen(name, "r")))
+	    return NULL;
+	if (!(*path = strdup(name)))
+	    fatal("%s: Out of memory\n", ProgramName);
+	return fp;
+    }
+    for (i = quoted ? -1 : 0; i < num_include_dirs; i++) {
+	if (i < 0) {
+	    if (slash) {
+		if (asprintf(path, "%.*s/%s", (int)(slash - from), from,
+			     name) == -1)
+		    fatal("%s: Out of memory\n", ProgramName);
+	    } else if (!(*path = strdup(name)))
+		fatal("%s: Out of memory\n", ProgramName);
+	} else if (asprintf(path, "%s/%s", include_dirs[i], name) == -1)
+	    fatal("%s: Out of memory\n", ProgramName);
+	if ((fp = fopen(*path, "r")))
+	    return fp;
+	free(*path);
+    }
+    *path = NULL;
+    return NULL;
+}
+
+static void CppFile(Buffer *out, FILE *input, const char *file, int depth);
+
+static void
+CppInclude(Buffer *out, char *arg, const char *file, int lineno, int depth)
+{
+    char close, *end, *path;
+    FILE *fp;
+
+    arg = (char *)CppSkipSpace(arg);
+    if (*arg == '"')
+	close = '"';
+    else if (*arg == '<')
+	close = '>';
+    else
+	close = '\0';
+    end = close ? strchr(arg + 1, close) : NULL;
+    if (!end) {
+	fprintf(stderr, "%s: %s:%d: #include expects \"file\" or <file>\n",
+		ProgramName, file, lineno);
+	return;
+    }
+    *end = '\0';
+    if (depth >= CPP_MAX_INCLUDE_DEPTH) {
+	fprintf(stderr, "%s: %s:%d: #include nested too deeply\n",
+		ProgramName, file, lineno);
+	return;
+    }
+    fp = CppOpenInclude(arg + 1, close == '"', file, &path);
+    if (!fp) {
+	fprintf(stderr, "%s: %s:%d: can't open include file '%s'\n",
+		ProgramName, file, lineno, arg + 1);
+	return;
+    }
+
+    /* line markers, which GetEntries() takes its line numbers from */
+    AppendToBuffer(out, "# 1\n", 4);
+    CppFile(out, fp, path, depth + 1);
+    fclose(fp);
+    free(path);
+    {
+	char marker[32];
+
+	/* the directive's own blank lines follow */
+	snprintf(marker, sizeof(marker), "# %d\n", lineno);
+	AppendToBuffer(out, marker, strlen(marker));
+    }
+}
+
+static void
+CppDefine(char *arg, const char *file, int lineno)
+{
+    char *name, *value, *end;
+    Bool function;
+
+    name = (char *)CppSkipSpace(arg);
+    for (end = name; CppIsIdent(*end); end++)
+	;
+    if (end == name || (isascii(*name) && isdigit(*name))) {
+	fprintf(stderr, "%s: %s:%d: #define without a name\n",
+		ProgramName, file, lineno);
+	return;
+    }
+    function = (*end == '(');
+    value = end;
+    if (function) {
+	value = strchr(end, ')');
+	value = value ? value + 1 : end + strlen(end);
+    }
+    value = (char *)CppSkipSpace(value);
+    *end = '\0';
+    end = value + strlen(value);
+    while (end > value && isascii(end[-1]) && isspace(end[-1]))
+	end--;
+    *end = '\0';
+    AddSymbol(name, value, function);
+}
+
+static void
+CppDirective(Buffer *out, char *line, const char *file, int lineno,
+	     int base, int depth)
+{
+    char *p = (char *)CppSkipSpace(line + 1), *arg, *end;
+    CppCond *cond;
+    int len;
+
+    for (arg = p; CppIsIdent(*arg); arg++)
+	;
+    len = arg - p;
+
+#define CppIs(d) (len == sizeof(d) - 1 && !strncmp(p, d, len))
+    if (CppIs("if") || CppIs("ifdef") || CppIs("ifndef")) {
+	Bool parent = CppIsActive(), val = False;
+
+	if (cpp_ncond == CPP_MAX_CONDITIONALS)
+	    fatal("%s: %s:%d: conditionals nested too deeply\n",
+		  ProgramName, file, lineno);
+	if (parent) {
+	    if (CppIs("if"))
+		val = CppEvalIf(arg, file, lineno);
+	    else {
+		arg = (char *)CppSkipSpace(arg);
+		for (end = arg; CppIsIdent(*end); end++)
+		    ;
+		val = LookupSymbol(arg, end - arg) != NULL;
+		if (CppIs("ifndef"))
+		    val = !val;
+	    }
+	}
+	cond = &cpp_cond[cpp_ncond++];
+	cond->parent = parent;
+	cond->taking = cond->done = parent && val;
+	cond->seen_else = False;
+	return;
+    }
+    if (CppIs("elif") || CppIs("else") || CppIs("endif")) {
+	if (cpp_ncond == base) {
+	    fprintf(stderr, "%s: %s:%d: #%.*s without #if\n",
+		    ProgramName, file, lineno, len, p);
+	    return;
+	}
+	cond = &cpp_cond[cpp_ncond - 1];
+	if (CppIs("endif"))
+	    cpp_ncond--;
+	else if (cond->seen_else)
+	    fprintf(stderr, "%s: %s:%d: #%.*s after #else\n",
+		    ProgramName, file, lineno, len, p);
+	else if (CppIs("else")) {
+	    cond->taking = cond->parent && !cond->done;
+	    cond->done = cond->seen_else = True;
+	} else {
+	    cond->taking = cond->parent && !cond->done &&
+		CppEvalIf(arg, file, lineno);
+	    cond->done |= cond->taking;
+	}
+	return;
+    }
+    if (!CppIsActive())
+	return;
+
+    if (CppIs("include"))
+	CppInclude(out, arg, file, lineno, depth);
+    else if (CppIs("define"))
+	CppDefine(arg, file, lineno);
+    else if (CppIs("undef")) {
+	arg = (char *)CppSkipSpace(arg);
+	for (end = arg; CppIsIdent(*end); end++)
+	    ;
+	*end = '\0';
+	if (*arg)
+	    AddSymbol(arg, NULL, False);
+    } else if (CppIs("error") || CppIs("warning")) {
+	fprintf(stderr, "%s: %s:%d: %s\n", ProgramName, file, lineno,
+		CppSkipSpace(line + 1));
+    } else if (len && !CppIs("pragma") && !CppIs("line") &&
+	       !CppIs("ident") && !quiet) {
+	fprintf(stderr, "%s: %s:%d: unknown directive #%.*s ignored\n",
+		ProgramName, file, lineno, len, p);
+    }
+#undef CppIs
+}
+
+static void
+CppFile(Buffer *out, FILE *input, const char *file, int depth)
+{
+    Buffer in;
+    CppActive active;
+    char *line, *next, *s;
+    Bool in_comment = False;
+    int lineno = 1, lines, base = cpp_ncond;
+
+    InitBuffer(&in);
+    ReadFile(&in, input);
+    active.num = 0;
+
+    for (line = in.buff; *line; line = next, lineno += lines) {
+	/* a logical line runs on past backslash-newlines */
+	for (next = line, lines = 1; (next = strchr(next, '\n')); lines++) {
+	    s = next++;
+	    if (s > line && s[-1] == '\r')
+		s--;
+	    if (s == line || s[-1] != '\\')
+		break;
+	}
+	if (!next)
+	    next = line + strlen(line);
+
+	/* work on a copy, so the comments can be taken out */
+	s = (char *)malloc(next - line + 1);
+	if (!s)
+	    fatal("%s: Not enough memory\n", ProgramName);
+	memcpy(s, line, next - line);
+	s[next - line] = '\0';
+	CppStripComments(s, &in_comment);
+
+	if (*CppSkipSpace(s) == '#') {
+	    char *d, *c;
+	    int i;
+
+	    /* directives are read as one line */
+	    for (c = d = (char *)CppSkipSpace(s); *c; c++) {
+		if (c[0] == '\\' && (c[1] == '\n' ||
+				     (c[1] == '\r' && c[2] == '\n')))
+		    c += (c[1] == '\r') ? 2 : 1;
+		else if (*c != '\n' && *c != '\r')
+		    *d++ = *c;
+	    }
+	    *d = '\0';
+	    CppDirective(out, (char *)CppSkipSpace(s), file, lineno, base,
+			 depth);
+	    for (i = 0; i < lines; i++)
+		AppendToBuffer(out, "\n", 1);
+	} else if (CppIsActive()) {
+	    int len = strlen(s);
+
+	    CppExpand(out, s, len, &active);
+	    if (!len || s[len - 1] != '\n')
+		AppendToBuffer(out, "\n", 1);
+	} else {
+	    int i;
+
+	    for (i = 0; i < lines; i++)
+		AppendToBuffer(out, "\n", 1);
+	}
+	free(s);
+    }
+
+    if (in_comment)
+	fprintf(stderr, "%s: %s: unterminated comment\n", ProgramName, file);
+    if (cpp_ncond > base) {
+	fprintf(stderr, "%s: %s: unterminated #if\n", ProgramName, file);
+	cpp_ncond = base;
+    }
+    FreeBuffer(&in);
+}
+
+/*
+ * Preprocess - Read filename, or stdin, into the buffer through the
+ * built-in preprocessor, with the symbols currently defined
+ */
+
+static void
+Preprocess(Buffer *out, const char *file)
+{
+    FILE *input = stdin;
+
+    if (file && !(input = fopen(file, "r")))
+	fatal("%s: can't open file '%s'\n", ProgramName, file);
+    out->used = 0;
+    cpp_ncond = 0;
+    CppFile(out, input, file ? file : "<stdin>", 0);
+    if (input != stdin)
+	fclose(input);
+    AppendToBuffer(out, "", 1);
+}
+
 static Entry *
 FindEntry(Entries *db, Buffer  *b)
 {
@@ -730,6 +1503,7 @@ Syntax (void)
 	     " -screens            do screen-specific resources for all screens\n"
 	     " -n                  show but don't do changes\n"
 	     " -cpp filename       preprocessor to use [%s]\n"
+	     " -builtincpp         use the built-in preprocessor\n"
 	     " -nocpp              do not use a preprocessor\n"
 	     " -query              query resources\n"
 	     " -load               load resources from file [default]\n"
@@ -744,7 +1518,8 @@ Syntax (void)
 	     " -Dname[=value], -Uname, -Idirectory    passed to preprocessor\n"
 	     "\n"
 	     "A - or no input filename represents stdin.\n",
-	     ProgramName, cpp_program ? cpp_program : "", BACKUP_SUFFIX);
+	     ProgramName, cpp_program ? cpp_program :
+	     builtin_cpp ? "built-in" : "", BACKUP_SUFFIX);
     exit (1);
 }
 
@@ -795,11 +1570,11 @@ addstring(String *arg, const char *s)
 }   
 
 static void
-addescapedstring(String *arg, const char *s)
+escapedcopy(char *copy, int size, const char *s)
 {
-    char copy[512], *c;
+    char *c;
 
-    for (c = copy; *s && c < &copy[sizeof(copy)-1]; s++) {
+    for (c = copy; *s && c < &copy[size-1]; s++) {
 	switch (*s) {
 	case '"':       case '\'':      case '`':
 	case '$':       case '\\':
@@ -810,21 +1585,37 @@ addescapedstring(String *arg, const char *s)
 	}
     }
     *c = 0;
+}
+
+static void
+addescapedstring(String *arg, const char *s)
+{
+    char copy[512];
+
+    escapedcopy(copy, sizeof(copy), s);
     addstring (arg, copy);
 }
 
 static void
-addtokstring(String *arg, const char *s)
+tokcopy(char *copy, int size, const char *s)
 {
-    char copy[512], *c;
+    char *c;
 
-    for (c = copy; *s && c < &copy[sizeof(copy)-1]; s++) {
+    for (c = copy; *s && c < &copy[size-1]; s++) {
 	if (!isalpha(*s) && !isdigit(*s) && *s != '_')
 	    *c++ = '_';
 	else
 	    *c++ = *s;
     }
     *c = 0;
+}
+
+static void
+addtokstring(String *arg, const char *s)
+{
+    char copy[512];
+
+    tokcopy(copy, sizeof(copy), s);
     addstring (arg, copy);
 }
 
@@ -869,6 +1660,9 @@ main(int argc, char *argv[])
 	    }
 	    free(dup);
 	}
+	/* rather than none at all */
+	if (cpp_program == NULL)
+	    builtin_cpp = True;
     }
 
     /* needs to be replaced with XrmParseCommand */
@@ -894,12 +1688,18 @@ main(int argc, char *argv[])
 	    } else if (isabbreviation ("-cpp", arg, 2)) {
 		if (++i >= argc) Syntax ();
 		cpp_program = argv[i];
+		builtin_cpp = False;
+		continue;
+	    } else if (isabbreviation ("-builtincpp", arg, 3)) {
+		cpp_program = NULL;
+		builtin_cpp = True;
 		continue;
 	    } else if (!strcmp ("-n", arg)) {
 		dont_execute = True;
 		continue;
 	    } else if (isabbreviation ("-nocpp", arg, 3)) {
 		cpp_program = NULL;
+		builtin_cpp = False;
 		continue;
 	    } else if (isabbreviation ("-query", arg, 2)) {
 		oper = OPQUERY;
@@ -949,6 +1749,11 @@ main(int argc, char *argv[])
 	    } else if (arg[1] == 'I') {
 		addstring(&includes, " ");
 		addescapedstring(&includes, arg);
+		if (num_include_dirs < MAX_INCLUDE_DIRS) {
+		    include_dirs[num_include_dirs++] = arg + 2;
+		} else {
+		    fatal("%s: Too many -I arguments\n", ProgramName);
+		}
 		continue;
 	    } else if (arg[1] == 'U' || arg[1] == 'D') {
 		if (num_cmd_defines < MAX_CMD_DEFINES) {
@@ -1041,6 +1846,7 @@ main(int argc, char *argv[])
 	
     DoDisplayDefines(dpy, &defines, displayname);
     defines_base = defines.used;
+    symbols_base = symbols.used;
     need_newline = (oper == OPQUERY || oper == OPSYMBOLS ||
 		    (dont_execute && oper != OPREMOVE));
     InitBuffer(&buffer);
@@ -1139,7 +1945,15 @@ StoreProperty(Display *dpy, Window root, Atom res_prop)
     int len = buffer.used;
     int mode = PropModeReplace;
     unsigned char *buf = (unsigned char *)buffer.buff;
-    int max = (XMaxRequestSize(dpy) << 2) - 28;
+    long max_request = XExtendedMaxRequestSize(dpy);
+    int max;
+
+    /* with BIG-REQUESTS the whole database goes in one request, which
+     * needs neither the server grab nor the round trips of appending */
+    if (max_request)
+	max = (int)(max_request << 2) - 32;
+    else
+	max = (XMaxRequestSize(dpy) << 2) - 28;
 
     if (len > max) {
 	XGrabServer(dpy);
@@ -1166,6 +1980,7 @@ Process(int scrno, Bool doScreen, Bool execute)
 
     defines.val[defines_base] = '\0';
     defines.used = defines_base;
+    FreeSymbols(symbols_base);
     buffer.used = 0;
     InitEntries(&newDB);
     DoScreenDefines(dpy, scrno, &defines);
@@ -1230,6 +2045,9 @@ Process(int scrno, Bool doScreen, Bool execute)
     } else {
 	if (oper == OPMERGE || oper == OPOVERRIDE)
 	    GetEntriesString(&newDB, xdefs);
+	if (builtin_cpp)
+	    Preprocess(&buffer, filename);
+	else {
 #ifdef PATHETICCPP
 	if (need_real_defines) {
 #ifdef WIN32
@@ -1310,6 +2128,7 @@ Process(int scrno, Bool doScreen, Bool execute)
 #endif
 	}
 #endif
+	}
 	GetEntries(&newDB, &buffer, 0);
 	if (execute) {
 	    FormatEntries(&buffer, &newDB);
@@ -0,0 +1,695 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * xwinbench - time the X server paths that matter for the Windows DDX
+ *
+ * Each test repeats one operation in batches, with an XSync() after every
+ * batch, until the requested time has passed, and reports operations per
+ * second.  Results are written one test per line as
+ *
+ *     name <TAB> ops per second <TAB> ops <TAB> seconds
+ *
+ * preceded by '#' comment lines describing the server.  With -compare the
+ * results are checked against such a file from an earlier run, and the
+ * exit status is 1 if any test got slower by more than -threshold percent,
+ * so runs against different engines or releases can be scripted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/Xrender.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define WIN_SIZE        512
+#define IMAGE_SIZE      500
+#define MAP_WINDOWS     50
+#define MAX_RESULTS     64
+
+typedef struct {
+    const char *name;
+    /* returns FALSE if the test can't run on this server */
+    Bool (*setup) (void);
+    /* does one batch of operations and returns how many */
+    int (*run) (void);
+    void (*cleanup) (void);
+} BenchTest;
+
+typedef struct {
+    char name[64];
+    double rate;
+} BenchResult;
+
+static Display *dpy;
+static Display *dpy2;           /* second client, for selection transfers */
+static int screen;
+static Window win;
+static GC gc;
+static XImage *image;
+static Pixmap pixmap;
+static Picture winPicture, srcPicture;
+static GlyphSet glyphset;
+static Window mapWindows[MAP_WINDOWS];
+static Window selOwner, selRequestor;
+static Atom selAtom, selProperty, selTarget;
+static char selData[4096];
+
+static double
+now(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (!frequency.QuadPart)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+static int
+error_handler(Display *d, XErrorEvent *ev)
+{
+    char text[256];
+
+    XGetErrorText(d, ev->error_code, text, sizeof(text));
+    fprintf(stderr, "xwinbench: X error: %s (request %d.%d)\n", text,
+            ev->request_code, ev->minor_code);
+    return 0;
+}
+
+/* core protocol */
+
+static Bool
+image_setup(void)
+{
+    int depth = DefaultDepth(dpy, screen);
+    int x, y;
+    char *data;
+
+    image = XCreateImage(dpy, DefaultVisual(dpy, screen), depth, ZPixmap,
+                         0, NULL, IMAGE_SIZE, IMAGE_SIZE, 32, 0);
+    if (!image)
+        return False;
+    data = malloc(image->bytes_per_line * IMAGE_SIZE);
+    if (!data) {
+        XDestroyImage(image);
+        image = NULL;
+        return False;
+    }
+    image->data = data;
+    for (y = 0; y < IMAGE_SIZE; y++)
+        for (x = 0; x < IMAGE_SIZE; x++)
+            XPutPixel(image, x, y, (x * 7) ^ (y * 13));
+    return True;
+}
+
+static void
+image_cleanup(void)
+{
+    if (image)
+        XDestroyImage(image);
+    image = NULL;
+}
+
+static int
+putimage_run(void)
+{
+    int i;
+
+    for (i = 0; i < 10; i++)
+        XPutImage(dpy, win, gc, image, 0, 0, 0, 0, IMAGE_SIZE, IMAGE_SIZE);
+    return i;
+}
+
+static Bool
+getimage_setup(void)
+{
+    XFillRectangle(dpy, win, gc, 0, 0, WIN_SIZE, WIN_SIZE);
+    return True;
+}
+
+static int
+getimage_run(void)
+{
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        XImage *got = XGetImage(dpy, win, 0, 0, IMAGE_SIZE, IMAGE_SIZE,
+                                AllPlanes, ZPixmap);
+
+        if (got)
+            XDestroyImage(got);
+    }
+    return i;
+}
+
+static int
+copyarea_run(void)
+{
+    int i;
+
+    for (i = 0; i < 100; i++)
+        XCopyArea(dpy, win, win, gc, i & 1, 0, WIN_SIZE - 2, WIN_SIZE - 2,
+                  !(i & 1), 1);
+    return i;
+}
+
+static int
+fillrect_run(void)
+{
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        XSetForeground(dpy, gc, i * 0x010203);
+        XFillRectangle(dpy, win, gc, (i * 37) % (WIN_SIZE - 100),
+                       (i * 53) % (WIN_SIZE - 100), 100, 100);
+    }
+    return i;
+}
+
+/* Core protocol arcs and wide lines, as plotting programs draw them */
+
+static Bool
+wide_setup(void)
+{
+    XSetLineAttributes(dpy, gc, 5, LineSolid, CapButt, JoinMiter);
+    return True;
+}
+
+static void
+wide_cleanup(void)
+{
+    XSetLineAttributes(dpy, gc, 0, LineSolid, CapButt, JoinMiter);
+}
+
+static int
+arc_run(int size)
+{
+    XArc arcs[100];
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        arcs[i].x = (i * 37) % (WIN_SIZE - size);
+        arcs[i].y = (i * 53) % (WIN_SIZE - size);
+        arcs[i].width = arcs[i].height = size;
+        arcs[i].angle1 = 0;
+        arcs[i].angle2 = 360 * 64;
+    }
+    XDrawArcs(dpy, win, gc, arcs, 100);
+    return i;
+}
+
+static int
+arc10_run(void)
+{
+    return arc_run(10);
+}
+
+static int
+arc100_run(void)
+{
+    return arc_run(100);
+}
+
+static int
+partarc_run(void)
+{
+    int i;
+
+    for (i = 0; i < 100; i++)
+        XDrawArc(dpy, win, gc, (i * 37) % (WIN_SIZE - 100),
+                 (i * 53) % (WIN_SIZE - 100), 100, 60,
+                 (i * 7) % 360 * 64, 135 * 64);
+    return i;
+}
+
+static int
+fillarc_run(void)
+{
+    int i;
+
+    for (i = 0; i < 100; i++)
+        XFillArc(dpy, win, gc, (i * 37) % (WIN_SIZE - 100),
+                 (i * 53) % (WIN_SIZE - 100), 100, 100,
+                 (i * 7) % 360 * 64, 270 * 64);
+    return i;
+}
+
+static int
+wideline_run(void)
+{
+    XPoint points[101];
+    int i;
+
+    for (i = 0; i <= 100; i++) {
+        points[i].x = i * (WIN_SIZE - 10) / 100 + 5;
+        points[i].y = (i * 97) % (WIN_SIZE - 10) + 5;
+    }
+    XDrawLines(dpy, win, gc, points, 101, CoordModeOrigin);
+    return 100;
+}
+
+/* Render */
+
+static Bool
+render_setup(void)
+{
+    int event_base, error_base;
+    XRenderPictFormat *format, *argb;
+    XRenderPictureAttributes pa;
+    XRenderColor color = { 0x4000, 0x8000, 0xc000, 0x8000 };
+
+    if (!XRenderQueryExtension(dpy, &event_base, &error_base))
+        return False;
+
+    format = XRenderFindVisualFormat(dpy, DefaultVisual(dpy, screen));
+    argb = XRenderFindStandardFormat(dpy, PictStandardARGB32);
+    if (!format || !argb)
+        return False;
+
+    winPicture = XRenderCreatePicture(dpy, win, format, 0, NULL);
+    pixmap = XCreatePixmap(dpy, win, 256, 256, 32);
+    pa.repeat = True;
+    srcPicture = XRenderCreatePicture(dpy, pixmap, argb, CPRepeat, &pa);
+    XRenderFillRectangle(dpy, PictOpSrc, srcPicture, &color, 0, 0, 256, 256);
+    return True;
+}
+
+static void
+render_cleanup(void)
+{
+    if (srcPicture)
+        XRenderFreePicture(dpy, srcPicture);
+    if (winPicture)
+        XRenderFreePicture(dpy, winPicture);
+    if (pixmap)
+        XFreePixmap(dpy, pixmap);
+    srcPicture = winPicture = None;
+    pixmap = None;
+}
+
+static int
+composite_run(void)
+{
+    int i;
+
+    for (i = 0; i < 100; i++)
+        XRenderComposite(dpy, PictOpOver, srcPicture, None, winPicture,
+                         0, 0, 0, 0, (i * 17) % (WIN_SIZE - 256),
+                         (i * 29) % (WIN_SIZE - 256), 256, 256);
+    return i;
+}
+
+static Bool
+glyphs_setup(void)
+{
+    XRenderPictFormat *a8;
+    XGlyphInfo info[64];
+    Glyph ids[64];
+    static char bits[64 * 16 * 12];
+    int i;
+
+    if (!render_setup())
+        return False;
+
+    a8 = XRenderFindStandardFormat(dpy, PictStandardA8);
+    if (!a8)
+        return False;
+    glyphset = XRenderCreateGlyphSet(dpy, a8);
+
+    /* 64 glyphs of 12x16, rows padded to 4 bytes */
+    for (i = 0; i < 64; i++) {
+        ids[i] = 32 + i;
+        info[i].width = 12;
+        info[i].height = 16;
+        info[i].x = 0;
+        info[i].y = 12;
+        info[i].xOff = 8;
+        info[i].yOff = 0;
+    }
+    for (i = 0; i < sizeof(bits); i++)
+        bits[i] = (i * 31) & 0xff;
+    XRenderAddGlyphs(dpy, glyphset, ids, info, 64, bits, sizeof(bits));
+    return True;
+}
+
+static void
+glyphs_cleanup(void)
+{
+    if (glyphset)
+        XRenderFreeGlyphSet(dpy, glyphset);
+    glyphset = None;
+    render_cleanup();
+}
+
+static int
+glyphs_run(void)
+{
+    static const char line[] =
+        "The quick brown fox jumps over the lazy dog 0123456789 ABCDEFGHIJKLMN";
+    int i;
+
+    for (i = 0; i < 100; i++)
+        XRenderCompositeString8(dpy, PictOpOver, srcPicture, winPicture,
+                                NULL, glyphset, 0, 0, 0,
+                                16 + (i % 30) * 16, line, sizeof(line) - 1);
+    return i;
+}
+
+/*
+ * selections, as a clipboard copy from one client to another does.  A private
+ * selection is used so the integrated clipboard doesn't take it over.
+ */
+
+static Bool
+selection_setup(void)
+{
+    dpy2 = XOpenDisplay(DisplayString(dpy));
+    if (!dpy2)
+        return False;
+
+    selAtom = XInternAtom(dpy, "_XWINBENCH_SELECTION", False);
+    selTarget = XInternAtom(dpy, "UTF8_STRING", False);
+    selProperty = XInternAtom(dpy2, "_XWINBENCH_PROPERTY", False);
+
+    selOwner = XCreateSimpleWindow(dpy, RootWindow(dpy, screen), 0, 0, 1, 1,
+                                   0, 0, 0);
+    selRequestor = XCreateSimpleWindow(dpy2, RootWindow(dpy2, screen),
+                                       0, 0, 1, 1, 0, 0, 0);
+    XSetSelectionOwner(dpy, selAtom, selOwner, CurrentTime);
+    XSync(dpy, False);
+    memset(selData, 'x', sizeof(selData));
+    return XGetSelectionOwner(dpy, selAtom) == selOwner;
+}
+
+static void
+selection_cleanup(void)
+{
+    if (dpy2) {
+        XDestroyWindow(dpy2, selRequestor);
+        XCloseDisplay(dpy2);
+    }
+    if (selOwner) {
+        XSetSelectionOwner(dpy, selAtom, None, CurrentTime);
+        XDestroyWindow(dpy, selOwner);
+    }
+    dpy2 = NULL;
+    selOwner = selRequestor = None;
+}
+
+static int
+selection_run(void)
+{
+    int i;
+
+    for (i = 0; i < 20; i++) {
+        XEvent ev;
+        XSelectionEvent notify;
+        Atom type;
+        int format;
+        unsigned long nitems, after;
+        unsigned char *data;
+
+        XConvertSelection(dpy2, selAtom, selTarget, selProperty, selRequestor,
+                          CurrentTime);
+        XFlush(dpy2);
+
+        /* answer as the owner */
+        do
+            XNextEvent(dpy, &ev);
+        while (ev.type != SelectionRequest);
+        XChangeProperty(dpy, ev.xselectionrequest.requestor,
+                        ev.xselectionrequest.property, selTarget, 8,
+                        PropModeReplace, (unsigned char *) selData,
+                        sizeof(selData));
+        notify.type = SelectionNotify;
+        notify.display = dpy;
+        notify.requestor = ev.xselectionrequest.requestor;
+        notify.selection = ev.xselectionrequest.selection;
+        notify.target = ev.xselectionrequest.target;
+        notify.property = ev.xselectionrequest.property;
+        notify.time = ev.xselectionrequest.time;
+        XSendEvent(dpy, notify.requestor, False, 0, (XEvent *) &notify);
+        XFlush(dpy);
+
+        /* and collect the data as the requestor */
+        do
+            XNextEvent(dpy2, &ev);
+        while (ev.type != SelectionNotify);
+        if (XGetWindowProperty(dpy2, selRequestor, selProperty, 0,
+                               sizeof(selData) / 4, True, AnyPropertyType,
+                               &type, &format, &nitems, &after,
+                               &data) == Success)
+            XFree(data);
+    }
+    return i;
+}
+
+/* top level windows, which in -multiwindow mode each get a Windows window */
+
+static Bool
+map_setup(void)
+{
+    int i;
+
+    for (i = 0; i < MAP_WINDOWS; i++)
+        mapWindows[i] = XCreateSimpleWindow(dpy, RootWindow(dpy, screen),
+                                            (i % 10) * 60, (i / 10) * 60,
+                                            50, 50, 0, 0,
+                                            WhitePixel(dpy, screen));
+    return True;
+}
+
+static void
+map_cleanup(void)
+{
+    int i;
+
+    for (i = 0; i < MAP_WINDOWS; i++)
+        XDestroyWindow(dpy, mapWindows[i]);
+}
+
+static int
+map_run(void)
+{
+    int i;
+
+    for (i = 0; i < MAP_WINDOWS; i++)
+        XMapWindow(dpy, mapWindows[i]);
+    XSync(dpy, False);
+    for (i = 0; i < MAP_WINDOWS; i++)
+        XUnmapWindow(dpy, mapWindows[i]);
+    return MAP_WINDOWS;
+}
+
+static const BenchTest tests[] = {
+    {"putimage-500x500", image_setup, putimage_run, image_cleanup},
+    {"getimage-500x500", getimage_setup, getimage_run, NULL},
+    {"copyarea-510x510", NULL, copyarea_run, NULL},
+    {"fillrect-100x100", NULL, fillrect_run, NULL},
+    {"circle-10-lw5", wide_setup, arc10_run, wide_cleanup},
+    {"circle-100-lw5", wide_setup, arc100_run, wide_cleanup},
+    {"arc-100x60-135deg-lw5", wide_setup, partarc_run, wide_cleanup},
+    {"fillarc-pie-100-270deg", NULL, fillarc_run, NULL},
+    {"polyline-100seg-lw5", wide_setup, wideline_run, wide_cleanup},
+    {"render-composite-over-256x256", render_setup, composite_run,
+     render_cleanup},
+    {"render-glyphs-a8-70char", glyphs_setup, glyphs_run, glyphs_cleanup},
+    {"selection-transfer-4k", selection_setup, selection_run,
+     selection_cleanup},
+    {"toplevel-map-unmap", map_setup, map_run, map_cleanup},
+};
+
+#define NUM_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+static int
+read_results(const char *filename, BenchResult * results)
+{
+    FILE *f = fopen(filename, "r");
+    char line[256];
+    int n = 0;
+
+    if (!f) {
+        fprintf(stderr, "xwinbench: can't open %s\n", filename);
+        return -1;
+    }
+    while (n < MAX_RESULTS && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%63s %lf", results[n].name, &results[n].rate) == 2)
+            n++;
+    }
+    fclose(f);
+    return n;
+}
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+            "usage: xwinbench [-display name] [-time seconds] [-label text]\n"
+            "                 [-only test] [-compare file [-threshold percent]]\n"
+            "                 [-list]\n");
+    exit(2);
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *display_name = NULL;
+    const char *label = NULL;
+    const char *only = NULL;
+    const char *compare = NULL;
+    double seconds = 2.0;
+    double threshold = 10.0;
+    BenchResult baseline[MAX_RESULTS];
+    int nbaseline = 0;
+    int regressions = 0;
+    XSetWindowAttributes attr;
+    XEvent ev;
+    unsigned int t;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-display") && i + 1 < argc)
+            display_name = argv[++i];
+        else if (!strcmp(argv[i], "-time") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-label") && i + 1 < argc)
+            label = argv[++i];
+        else if (!strcmp(argv[i], "-only") && i + 1 < argc)
+            only = argv[++i];
+        else if (!strcmp(argv[i], "-compare") && i + 1 < argc)
+            compare = argv[++i];
+        else if (!strcmp(argv[i], "-threshold") && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-list")) {
+            for (t = 0; t < NUM_TESTS; t++)
+                printf("%s\n", tests[t].name);
+            return 0;
+        }
+        else
+            usage();
+    }
+
+    if (compare && (nbaseline = read_results(compare, baseline)) < 0)
+        return 2;
+
+    dpy = XOpenDisplay(display_name);
+    if (!dpy) {
+        fprintf(stderr, "xwinbench: can't open display %s\n",
+                XDisplayName(display_name));
+        return 2;
+    }
+    XSetErrorHandler(error_handler);
+    screen = DefaultScreen(dpy);
+
+    attr.background_pixel = BlackPixel(dpy, screen);
+    attr.event_mask = ExposureMask | StructureNotifyMask;
+    win = XCreateWindow(dpy, RootWindow(dpy, screen), 0, 0, WIN_SIZE,
+                        WIN_SIZE, 0, CopyFromParent, InputOutput,
+                        CopyFromParent, CWBackPixel | CWEventMask, &attr);
+    XStoreName(dpy, win, "xwinbench");
+    XMapWindow(dpy, win);
+    do
+        XNextEvent(dpy, &ev);
+    while (ev.type != Expose);
+    gc = XCreateGC(dpy, win, 0, NULL);
+
+    printf("# server: %s %d\n", ServerVendor(dpy), VendorRelease(dpy));
+    printf("# screen: %dx%d depth %d\n", DisplayWidth(dpy, screen),
+           DisplayHeight(dpy, screen), DefaultDepth(dpy, screen));
+    if (label)
+        printf("# label: %s\n", label);
+    printf("# test\tops/s\tops\tseconds\n");
+    fflush(stdout);
+
+    for (t = 0; t < NUM_TESTS; t++) {
+        const BenchTest *test = &tests[t];
+        double start, elapsed, rate;
+        long ops = 0;
+
+        if (only && strcmp(only, test->name))
+            continue;
+
+        if (test->setup && !test->setup()) {
+            printf("# %s: not supported by this server\n", test->name);
+            if (test->cleanup)
+                test->cleanup();
+            continue;
+        }
+        XSync(dpy, False);
+
+        /* one untimed batch to warm up caches and the server */
+        test->run();
+        XSync(dpy, False);
+
+        start = now();
+        do {
+            ops += test->run();
+            XSync(dpy, False);
+            elapsed = now() - start;
+        } while (elapsed < seconds);
+        rate = ops / elapsed;
+
+        if (test->cleanup)
+            test->cleanup();
+        XSync(dpy, False);
+
+        printf("%s\t%.1f\t%ld\t%.3f\n", test->name, rate, ops, elapsed);
+        fflush(stdout);
+
+        for (i = 0; i < nbaseline; i++) {
+            if (strcmp(baseline[i].name, test->name) || baseline[i].rate <= 0)
+                continue;
+            if (rate < baseline[i].rate * (1.0 - threshold / 100.0)) {
+                fprintf(stderr, "xwinbench: %s regressed: %.1f ops/s, was %.1f "
+                        "(%.1f%%)\n", test->name, rate, baseline[i].rate,
+                        100.0 * (rate - baseline[i].rate) / baseline[i].rate);
+                regressions++;
+            }
+        }
+    }
+
+    XFreeGC(dpy, gc);
+    XDestroyWindow(dpy, win);
+    XCloseDisplay(dpy);
+
+    return regressions ? 1 : 0;
+}
@@ -251,6 +251,7 @@ bdfFreeFontBits(FontPtr pFont)
 	free (bitmapExtra);
     }
     free(pFont->info.props);
+    free(pFont->info.isStringProp);
     free(bitmapFont);
 }
 
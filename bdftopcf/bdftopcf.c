@@ -39,6 +39,8 @@ from The Open Group.
 #include "bdfint.h"
 #include "pcf.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <X11/Xos.h>
 
 #ifndef STDIN_FILENO
@@ -48,21 +50,123 @@ from The Open Group.
 #define STDOUT_FILENO 1
 #endif
 
+/*
+ * The name a BDF file given along with others is converted to: its own
+ * name ending in .pcf instead of .bdf, in dir if there is one
+ */
+static char *
+PcfFileName(const char *bdf_name, const char *dir)
+{
+    const char *base = bdf_name, *p;
+    size_t len, dirlen = 0;
+    char *name;
+
+    if (dir) {
+        for (p = bdf_name; *p; p++)
+            if (*p == '/' || *p == '\\')
+                base = p + 1;
+        dirlen = strlen(dir) + 1;
+    }
+    len = strlen(base);
+    if (len > 4 && strcmp(base + len - 4, ".bdf") == 0)
+        len -= 4;
+    name = malloc(dirlen + len + sizeof(".pcf"));
+    if (!name)
+        return NULL;
+    if (dir) {
+        strcpy(name, dir);
+        name[dirlen - 1] = '/';
+    }
+    memcpy(name + dirlen, base, len);
+    strcpy(name + dirlen + len, ".pcf");
+    return name;
+}
+
+/*
+ * Convert one font, from stdin or to stdout when a name is NULL.
+ * Returns FALSE, having said why, if it could not be done.
+ */
+static Bool
+ConvertFont(const char *program_name,
+            const char *input_name, const char *output_name,
+            int bit, int byte, int glyph, int scan)
+{
+    FontPtr font;
+
+    FontFilePtr input, output;
+
+    Bool ok;
+
+    if (input_name) {
+        input = FontFileOpen(input_name);
+        if (!input) {
+            fprintf(stderr, "%s: can't open bdf source file %s\n",
+                    program_name, input_name);
+            return FALSE;
+        }
+    }
+    else
+        input = FontFileOpenFd(STDIN_FILENO);
+    font = CreateFontRec();
+    if (!font) {
+        fprintf(stderr, "%s: out of memory\n", program_name);
+        FontFileClose(input);
+        return FALSE;
+    }
+    ok = bdfReadFont(font, input, bit, byte, glyph, scan) == Successful;
+    FontFileClose(input);
+    if (!ok) {
+        fprintf(stderr, "%s: bdf input, %s, corrupt\n",
+                program_name, input_name ? input_name : "<stdin>");
+        DestroyFontRec(font);
+        return FALSE;
+    }
+    if (output_name) {
+        output = FontFileOpenWrite(output_name);
+        if (!output) {
+            fprintf(stderr, "%s: can't open pcf sink file %s\n",
+                    program_name, output_name);
+            (*font->unload_font) (font);
+            return FALSE;
+        }
+    }
+    else
+        output = FontFileOpenWriteFd(STDOUT_FILENO);
+    if (pcfWriteFont(font, output) != Successful) {
+        fprintf(stderr, "%s: can't write pcf file %s\n",
+                program_name, output_name ? output_name : "<stdout>");
+        if (output_name)
+            remove(output_name);
+        ok = FALSE;
+    }
+    else
+        FontFileClose(output);
+    (*font->unload_font) (font);
+    return ok;
+}
+
 int
 main(int argc, char *argv[])
 {
-    FontRec font = { 0 };
+    char **input_names;
 
-    FontFilePtr input, output;
+    int num_inputs = 0;
 
-    char *input_name = NULL, *output_name = NULL;
+    char *output_name = NULL;
 
     char *program_name;
 
     int bit, byte, glyph, scan;
 
+    int i, status = 0;
+
     FontDefaultFormat(&bit, &byte, &glyph, &scan);
     program_name = argv[0];
+    input_names = malloc(argc * sizeof(char *));
+    if (!input_names) {
+        fprintf(stderr, "%s: out of memory\n", program_name);
+        exit(1);
+    }
     argc--, argv++;
     while (argc-- > 0) {
         if (argv[0][0] == '-') {
@@ -149,55 +253,44 @@ main(int argc, char *argv[])
                 goto usage;
             }
         }
-        else {
-            if (input_name) {
- usage:
-                fprintf(stderr, "%s: invalid option '%s'\n",
-                        program_name, argv[0]);
-                fprintf(stderr,
-                        "usage: %s [-p#] [-u#] [-m] [-l] [-M] [-L] [-t] [-i] [-o pcf file] [bdf file]\n"
-                        "       where # for -p is 1, 2, 4, or 8\n"
-                        "       and   # for -u is 1, 2, or 4\n",
-                        program_name);
-                exit(1);
-            }
-            input_name = argv[0];
-        }
+        else
+            input_names[num_inputs++] = argv[0];
         argv++;
     }
-    if (input_name) {
-        input = FontFileOpen(input_name);
-        if (!input) {
-            fprintf(stderr, "%s: can't open bdf source file %s\n",
-                    program_name, input_name);
+    if (num_inputs <= 1) {
+        if (!ConvertFont(program_name, num_inputs ? input_names[0] : NULL,
+                         output_name, bit, byte, glyph, scan))
             exit(1);
-        }
+        return (0);
     }
-    else
-        input = FontFileOpenFd(STDIN_FILENO);
-    if (bdfReadFont(&font, input, bit, byte, glyph, scan) != Successful) {
-        fprintf(stderr, "%s: bdf input, %s, corrupt\n",
-                program_name, input_name ? input_name : "<stdin>");
-        exit(1);
-    }
-    if (output_name) {
-        output = FontFileOpenWrite(output_name);
-        if (!output) {
-            fprintf(stderr, "%s: can't open pcf sink file %s\n",
-                    program_name, output_name);
+
+    /*
+     * Converting a whole directory of fonts in one run saves starting the
+     * program for each of them.  The -o option then names the directory
+     * to write into.
+     */
+    for (i = 0; i < num_inputs; i++) {
+        char *pcf_name = PcfFileName(input_names[i], output_name);
+
+        if (!pcf_name) {
+            fprintf(stderr, "%s: out of memory\n", program_name);
             exit(1);
         }
+        if (!ConvertFont(program_name, input_names[i], pcf_name,
+                         bit, byte, glyph, scan))
+            status = 1;
+        free(pcf_name);
     }
-    else
-        output = FontFileOpenWriteFd(STDOUT_FILENO);
-    if (pcfWriteFont(&font, output) != Successful) {
-        fprintf(stderr, "%s: can't write pcf file %s\n",
-                program_name, output_name ? output_name : "<stdout>");
-        if (output_name)
-            remove(output_name);
-        exit(1);
-    }
-    else
-        FontFileClose(output);
-    return (0);
+    free(input_names);
+    return (status);
+
+ usage:
+    fprintf(stderr, "%s: invalid option '%s'\n", program_name, argv[0]);
+    fprintf(stderr,
+            "usage: %s [-p#] [-u#] [-m] [-l] [-M] [-L] [-t] [-i] [-o pcf file] [bdf file]\n"
+            "       %s [options] [-o pcf directory] bdf file...\n"
+            "       where # for -p is 1, 2, 4, or 8\n"
+            "       and   # for -u is 1, 2, or 4\n",
+            program_name, program_name);
+    exit(1);
 }
@@ -457,20 +457,14 @@ FcDirCacheOpenFile (const FcChar8 *cache_file, struct stat *file_stat)
 {
     int	fd;
 
-#ifdef _WIN32
-    if (FcStat (cache_file, file_stat) < 0)
-        return -1;
-#endif
     fd = FcOpen((char *) cache_file, O_RDONLY | O_BINARY);
     if (fd < 0)
 	return fd;
-#ifndef _WIN32
-    if (fstat (fd, file_stat) < 0)
+    if (FcFStat (fd, file_stat) < 0)
     {
 	close (fd);
 	return -1;
     }
-#endif
     return fd;
 }
 
@@ -1493,8 +1487,10 @@ FcDirCacheWrite (FcCache *cache, FcConfig *config)
      * new cache file is not read again.  If it's large, we don't do that
      * such that we reload it, using mmap, which is shared across processes.
      */
-    if (cache->size < FC_CACHE_MIN_MMAP && FcStat (cache_hashed, &cache_stat))
+    if (cache->size < FC_CACHE_MIN_MMAP &&
+	(fd = FcDirCacheOpenFile (cache_hashed, &cache_stat)) >= 0)
     {
+	close (fd);
 	lock_cache ();
 	if ((skip = FcCacheFindByAddrUnlocked (cache)))
 	{
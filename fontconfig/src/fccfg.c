@@ -161,12 +161,17 @@ FcConfigCreate (void)
 
     config->sysRoot = NULL;
 
+    config->matchCache = NULL;
+
     config->rulesetList = FcPtrListCreate (FcDestroyAsRuleSet);
     if (!config->rulesetList)
 	goto bail9;
     config->availConfigFiles = FcStrSetCreate ();
     if (!config->availConfigFiles)
 	goto bail10;
+    config->missingConfigFiles = FcStrSetCreate ();
+    if (!config->missingConfigFiles)
+	goto bail11;
 
     config->uuid_table = FcHashTableCreate (FcHashAsStrIgnoreCase,
 					    FcCompareAsStr,
@@ -179,6 +184,8 @@ FcConfigCreate (void)
 
     return config;
 
+bail11:
+    FcStrSetDestroy (config->availConfigFiles);
 bail10:
     FcPtrListDestroy (config->rulesetList);
 bail9:
@@ -322,6 +329,7 @@ FcConfigDestroy (FcConfig *config)
 	FcPtrListDestroy (config->subst[k]);
     FcPtrListDestroy (config->rulesetList);
     FcStrSetDestroy (config->availConfigFiles);
+    FcStrSetDestroy (config->missingConfigFiles);
     for (set = FcSetSystem; set <= FcSetApplication; set++)
 	if (config->fonts[set])
 	    FcFontSetDestroy (config->fonts[set]);
@@ -338,6 +346,8 @@ FcConfigDestroy (FcConfig *config)
 
     FcHashTableDestroy (config->uuid_table);
 
+    FcMatchCacheDestroy (config);
+
     free (config);
 }
 
@@ -635,6 +645,7 @@ FcConfigSetFonts (FcConfig	*config,
     if (config->fonts[set])
 	FcFontSetDestroy (config->fonts[set]);
     config->fonts[set] = fonts;
+    FcMatchCacheFlush (config);
 }
 
 
@@ -525,11 +525,13 @@ FcCharSetMerge (FcCharSet *a, const FcCharSet *b, FcBool *changed)
 	return FcFalse;
     }
 
-    if (changed) {
-	*changed = !FcCharSetIsSubset(b, a);
-	if (!*changed)
-	    return FcTrue;
-    }
+    /*
+     * Whether anything changed is noted during the merge itself, rather
+     * than by a separate FcCharSetIsSubset walk first; merging a subset
+     * leaves a untouched either way.
+     */
+    if (changed)
+	*changed = FcFalse;
 
     while (bi < b->num)
     {
@@ -549,11 +551,25 @@ FcCharSetMerge (FcCharSet *a, const FcCharSet *b, FcBool *changed)
 	    {
 		if (!FcCharSetAddLeaf (a, bn << 8, bl))
 		    return FcFalse;
+		if (changed)
+		    *changed = FcTrue;
 	    }
 	    else
 	    {
 		FcCharLeaf *al = FcCharSetLeaf(a, ai);
-		FcCharSetUnionLeaf (al, al, bl);
+		int	   i;
+
+		for (i = 0; i < 256/32; i++)
+		{
+		    FcChar32 u = al->map[i] | bl->map[i];
+
+		    if (u != al->map[i])
+		    {
+			al->map[i] = u;
+			if (changed)
+			    *changed = FcTrue;
+		    }
+		}
 	    }
 
 	    ai++;
@@ -597,16 +613,33 @@ FcCharSetHasChar (const FcCharSet *fcs, FcChar32 ucs4)
     return (leaf->map[(ucs4 & 0xff) >> 5] & (1U << (ucs4 & 0x1f))) != 0;
 }
 
+/*
+ * Count the bits of a whole leaf.  Without a popcount builtin, the byte
+ * counts of all eight words are summed before folding them, which can't
+ * overflow a byte (8 words * 8 bits), so the fold runs once per leaf and
+ * there is no division per word.
+ */
 static FcChar32
-FcCharSetPopCount (FcChar32 c1)
+FcCharSetPopCountLeaf (const FcChar32 w[256/32])
 {
+    FcChar32	count = 0;
+    int		i;
+
 #if __GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4)
-    return __builtin_popcount (c1);
+    for (i = 0; i < 256/32; i++)
+	count += __builtin_popcount (w[i]);
+    return count;
 #else
-    /* hackmem 169 */
-    FcChar32	c2 = (c1 >> 1) & 033333333333;
-    c2 = c1 - c2 - ((c2 >> 1) & 033333333333);
-    return (((c2 + (c2 >> 3)) & 030707070707) % 077);
+    for (i = 0; i < 256/32; i++)
+    {
+	FcChar32	c = w[i];
+
+	c = c - ((c >> 1) & 0x55555555);
+	c = (c & 0x33333333) + ((c >> 2) & 0x33333333);
+	count += (c + (c >> 4)) & 0x0f0f0f0f;
+    }
+    count = (count & 0x00ff00ff) + ((count >> 8) & 0x00ff00ff);
+    return (count & 0xffff) + (count >> 16);
 #endif
 }
 
@@ -626,9 +659,12 @@ FcCharSetIntersectCount (const FcCharSet *a, const FcCharSet *b)
 	    {
 		FcChar32	*am = ai.leaf->map;
 		FcChar32	*bm = bi.leaf->map;
-		int		i = 256/32;
-		while (i--)
-		    count += FcCharSetPopCount (*am++ & *bm++);
+		FcChar32	w[256/32];
+		int		i;
+
+		for (i = 0; i < 256/32; i++)
+		    w[i] = am[i] & bm[i];
+		count += FcCharSetPopCountLeaf (w);
 		FcCharSetIterNext (a, &ai);
 	    }
 	    else if (ai.ucs4 < bi.ucs4)
@@ -655,13 +691,7 @@ FcCharSetCount (const FcCharSet *a)
     if (a)
     {
 	for (FcCharSetIterStart (a, &ai); ai.leaf; FcCharSetIterNext (a, &ai))
-	{
-	    int		    i = 256/32;
-	    FcChar32	    *am = ai.leaf->map;
-
-	    while (i--)
-		count += FcCharSetPopCount (*am++);
-	}
+	    count += FcCharSetPopCountLeaf (ai.leaf->map);
     }
     return count;
 }
@@ -681,18 +711,18 @@ FcCharSetSubtractCount (const FcCharSet *a, const FcCharSet *b)
 	    if (ai.ucs4 <= bi.ucs4)
 	    {
 		FcChar32	*am = ai.leaf->map;
-		int		i = 256/32;
 		if (ai.ucs4 == bi.ucs4)
 		{
 		    FcChar32	*bm = bi.leaf->map;
-		    while (i--)
-			count += FcCharSetPopCount (*am++ & ~*bm++);
+		    FcChar32	w[256/32];
+		    int		i;
+
+		    for (i = 0; i < 256/32; i++)
+			w[i] = am[i] & ~bm[i];
+		    count += FcCharSetPopCountLeaf (w);
 		}
 		else
-		{
-		    while (i--)
-			count += FcCharSetPopCount (*am++);
-		}
+		    count += FcCharSetPopCountLeaf (am);
 		FcCharSetIterNext (a, &ai);
 	    }
 	    else if (bi.leaf)
@@ -0,0 +1,1179 @@
+/*
+ * fontconfig/src/fcconfcache.c
+ *
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the author(s) not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The authors make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE AUTHOR(S) DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The parsed configuration cache.
+ *
+ * Parsing fonts.conf and everything it includes leaves the directories,
+ * the font selectors and the rule sets, with their tests, edits and
+ * expressions, in the FcConfig.  FcConfigSaveParsed writes all of that to
+ * one file next to the font caches, along with the modification time of
+ * every file and directory the parse read, the names it looked for and
+ * didn't find, and the environment those names were resolved in.
+ * FcConfigLoadParsed reads the file back in one go and, as long as none of
+ * that has changed, rebuilds the same configuration without parsing any
+ * XML.
+ *
+ * The file is only ever read by the architecture which wrote it, so values
+ * are stored in host byte order.
+ */
+
+#include "fcint.h"
+#include "fcarch.h"
+#include <fcntl.h>
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define FC_CONF_CACHE_MAGIC	0xfc0cf00d
+#define FC_CONF_CACHE_VERSION	1
+#define FC_CONF_CACHE_NAME	"fonts-conf-" FC_ARCHITECTURE FC_CACHE_SUFFIX
+
+/* Marks a NULL expression, string or list end */
+#define FC_CONF_CACHE_NONE	(-1)
+
+/*
+ * Writing
+ */
+
+static void
+FcConfCachePutData (FcStrBuf *buf, const void *data, int len)
+{
+    FcStrBufData (buf, (const FcChar8 *) data, len);
+}
+
+static void
+FcConfCachePutInt (FcStrBuf *buf, int i)
+{
+    FcConfCachePutData (buf, &i, sizeof (i));
+}
+
+static void
+FcConfCachePutInt64 (FcStrBuf *buf, int64_t i)
+{
+    FcConfCachePutData (buf, &i, sizeof (i));
+}
+
+static void
+FcConfCachePutDouble (FcStrBuf *buf, double d)
+{
+    FcConfCachePutData (buf, &d, sizeof (d));
+}
+
+static void
+FcConfCachePutString (FcStrBuf *buf, const FcChar8 *s)
+{
+    int len;
+
+    if (!s)
+    {
+	FcConfCachePutInt (buf, FC_CONF_CACHE_NONE);
+	return;
+    }
+    len = strlen ((const char *) s);
+    FcConfCachePutInt (buf, len);
+    FcConfCachePutData (buf, s, len + 1);
+}
+
+static void
+FcConfCachePutStrSet (FcStrBuf *buf, const FcStrSet *set)
+{
+    int i;
+
+    FcConfCachePutInt (buf, set->num);
+    for (i = 0; i < set->num; i++)
+	FcConfCachePutString (buf, set->strs[i]);
+}
+
+static void
+FcConfCachePutObject (FcStrBuf *buf, FcObject object)
+{
+    FcConfCachePutString (buf, (const FcChar8 *) FcObjectName (object));
+}
+
+static FcBool
+FcConfCachePutFontSet (FcStrBuf *buf, const FcFontSet *fs)
+{
+    int i;
+
+    FcConfCachePutInt (buf, fs->nfont);
+    for (i = 0; i < fs->nfont; i++)
+    {
+	FcChar8 *name = FcNameUnparse (fs->fonts[i]);
+
+	if (!name)
+	    return FcFalse;
+	FcConfCachePutString (buf, name);
+	FcStrFree (name);
+    }
+    return FcTrue;
+}
+
+static void
+FcConfCachePutCharSet (FcStrBuf *buf, const FcCharSet *c)
+{
+    FcChar32 map[FC_CHARSET_MAP_SIZE], next, page;
+
+    for (page = FcCharSetFirstPage (c, map, &next);
+	 page != FC_CHARSET_DONE;
+	 page = FcCharSetNextPage (c, map, &next))
+    {
+	FcConfCachePutInt (buf, (int) page);
+	FcConfCachePutData (buf, map, sizeof (map));
+    }
+    FcConfCachePutInt (buf, FC_CONF_CACHE_NONE);
+}
+
+static FcBool
+FcConfCachePutLangSet (FcStrBuf *buf, const FcLangSet *ls)
+{
+    FcStrSet *langs = FcLangSetGetLangs (ls);
+
+    if (!langs)
+	return FcFalse;
+    FcConfCachePutStrSet (buf, langs);
+    FcStrSetDestroy (langs);
+    return FcTrue;
+}
+
+static FcBool
+FcConfCachePutExpr (FcStrBuf *buf, const FcExpr *e)
+{
+    double begin, end;
+
+    if (!e)
+    {
+	FcConfCachePutInt (buf, FC_CONF_CACHE_NONE);
+	return FcTrue;
+    }
+    FcConfCachePutInt (buf, e->op);
+    switch (FC_OP_GET_OP (e->op)) {
+    case FcOpInteger:
+	FcConfCachePutInt (buf, e->u.ival);
+	break;
+    case FcOpDouble:
+	FcConfCachePutDouble (buf, e->u.dval);
+	break;
+    case FcOpString:
+	FcConfCachePutString (buf, e->u.sval);
+	break;
+    case FcOpMatrix:
+	return FcConfCachePutExpr (buf, e->u.mexpr->xx) &&
+	       FcConfCachePutExpr (buf, e->u.mexpr->xy) &&
+	       FcConfCachePutExpr (buf, e->u.mexpr->yx) &&
+	       FcConfCachePutExpr (buf, e->u.mexpr->yy);
+    case FcOpRange:
+	FcRangeGetDouble (e->u.rval, &begin, &end);
+	FcConfCachePutDouble (buf, begin);
+	FcConfCachePutDouble (buf, end);
+	break;
+    case FcOpBool:
+	FcConfCachePutInt (buf, e->u.bval);
+	break;
+    case FcOpCharSet:
+	FcConfCachePutCharSet (buf, e->u.cval);
+	break;
+    case FcOpLangSet:
+	return FcConfCachePutLangSet (buf, e->u.lval);
+    case FcOpField:
+	FcConfCachePutObject (buf, e->u.name.object);
+	FcConfCachePutInt (buf, e->u.name.kind);
+	break;
+    case FcOpConst:
+	FcConfCachePutString (buf, e->u.constant);
+	break;
+    case FcOpNil:
+    case FcOpInvalid:
+    case FcOpAssign:
+    case FcOpAssignReplace:
+    case FcOpPrepend:
+    case FcOpPrependFirst:
+    case FcOpAppend:
+    case FcOpAppendLast:
+    case FcOpDelete:
+    case FcOpDeleteAll:
+	break;
+    case FcOpNot:
+    case FcOpFloor:
+    case FcOpCeil:
+    case FcOpRound:
+    case FcOpTrunc:
+	return FcConfCachePutExpr (buf, e->u.tree.left);
+    default:
+	return FcConfCachePutExpr (buf, e->u.tree.left) &&
+	       FcConfCachePutExpr (buf, e->u.tree.right);
+    }
+    return FcTrue;
+}
+
+static FcBool
+FcConfCachePutRules (FcStrBuf *buf, const FcRule *rule)
+{
+    const FcRule *r;
+    int n = 0;
+
+    for (r = rule; r; r = r->next)
+	n++;
+    FcConfCachePutInt (buf, n);
+    for (r = rule; r; r = r->next)
+    {
+	FcConfCachePutInt (buf, r->type);
+	switch (r->type) {
+	case FcRuleTest:
+	    FcConfCachePutInt (buf, r->u.test->kind);
+	    FcConfCachePutInt (buf, r->u.test->qual);
+	    FcConfCachePutObject (buf, r->u.test->object);
+	    FcConfCachePutInt (buf, r->u.test->op);
+	    if (!FcConfCachePutExpr (buf, r->u.test->expr))
+		return FcFalse;
+	    break;
+	case FcRuleEdit:
+	    FcConfCachePutObject (buf, r->u.edit->object);
+	    FcConfCachePutInt (buf, r->u.edit->op);
+	    FcConfCachePutInt (buf, r->u.edit->binding);
+	    if (!FcConfCachePutExpr (buf, r->u.edit->expr))
+		return FcFalse;
+	    break;
+	default:
+	    break;
+	}
+    }
+    return FcTrue;
+}
+
+static FcBool
+FcConfCachePutRuleSet (FcStrBuf *buf, const FcRuleSet *rs)
+{
+    FcMatchKind k;
+
+    FcConfCachePutString (buf, rs->name);
+    FcConfCachePutString (buf, rs->description);
+    FcConfCachePutString (buf, rs->domain);
+    FcConfCachePutInt (buf, rs->enabled);
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+    {
+	FcPtrListIter iter;
+
+	FcPtrListIterInit (rs->subst[k], &iter);
+	for (; FcPtrListIterIsValid (rs->subst[k], &iter);
+	     FcPtrListIterNext (rs->subst[k], &iter))
+	{
+	    FcConfCachePutInt (buf, 1);
+	    if (!FcConfCachePutRules (buf, FcPtrListIterGetValue (rs->subst[k], &iter)))
+		return FcFalse;
+	}
+	FcConfCachePutInt (buf, FC_CONF_CACHE_NONE);
+    }
+    return FcTrue;
+}
+
+/*
+ * Rule sets are shared between config->rulesetList and config->subst[], and
+ * an <include> leaves the part of a file's rule set before it in subst[]
+ * only, so they're written once each and the lists refer to them by index.
+ */
+typedef struct _FcConfCacheRuleSets {
+    int		num;
+    int		size;
+    FcRuleSet	**rs;
+} FcConfCacheRuleSets;
+
+static int
+FcConfCacheRuleSetIndex (FcConfCacheRuleSets *sets, FcRuleSet *rs)
+{
+    int i;
+
+    for (i = 0; i < sets->num; i++)
+	if (sets->rs[i] == rs)
+	    return i;
+    if (sets->num == sets->size)
+    {
+	int size = sets->size ? sets->size * 2 : 64;
+	FcRuleSet **n = realloc (sets->rs, size * sizeof (FcRuleSet *));
+
+	if (!n)
+	    return -1;
+	sets->rs = n;
+	sets->size = size;
+    }
+    sets->rs[sets->num] = rs;
+    return sets->num++;
+}
+
+static FcBool
+FcConfCachePutRuleSetList (FcStrBuf *buf, FcConfCacheRuleSets *sets, FcPtrList *list)
+{
+    FcPtrListIter iter;
+
+    FcPtrListIterInit (list, &iter);
+    for (; FcPtrListIterIsValid (list, &iter); FcPtrListIterNext (list, &iter))
+    {
+	int i = FcConfCacheRuleSetIndex (sets, FcPtrListIterGetValue (list, &iter));
+
+	if (i < 0)
+	    return FcFalse;
+	FcConfCachePutInt (buf, i);
+    }
+    FcConfCachePutInt (buf, FC_CONF_CACHE_NONE);
+    return FcTrue;
+}
+
+/*
+ * Reading
+ */
+
+typedef struct _FcConfCacheIn {
+    const FcChar8   *p;
+    const FcChar8   *end;
+    FcBool	    failed;
+} FcConfCacheIn;
+
+static FcBool
+FcConfCacheGetData (FcConfCacheIn *in, void *data, int len)
+{
+    if (in->failed || in->end - in->p < len)
+    {
+	in->failed = FcTrue;
+	memset (data, 0, len);
+	return FcFalse;
+    }
+    memcpy (data, in->p, len);
+    in->p += len;
+    return FcTrue;
+}
+
+static int
+FcConfCacheGetInt (FcConfCacheIn *in)
+{
+    int i;
+
+    FcConfCacheGetData (in, &i, sizeof (i));
+    return i;
+}
+
+static int64_t
+FcConfCacheGetInt64 (FcConfCacheIn *in)
+{
+    int64_t i;
+
+    FcConfCacheGetData (in, &i, sizeof (i));
+    return i;
+}
+
+static double
+FcConfCacheGetDouble (FcConfCacheIn *in)
+{
+    double d;
+
+    FcConfCacheGetData (in, &d, sizeof (d));
+    return d;
+}
+
+/* The string in the cache buffer itself, or NULL */
+static const FcChar8 *
+FcConfCacheGetString (FcConfCacheIn *in)
+{
+    const FcChar8 *s;
+    int len = FcConfCacheGetInt (in);
+
+    if (in->failed || len == FC_CONF_CACHE_NONE)
+	return NULL;
+    if (len < 0 || in->end - in->p <= len || in->p[len] != 0)
+    {
+	in->failed = FcTrue;
+	return NULL;
+    }
+    s = in->p;
+    in->p += len + 1;
+    return s;
+}
+
+/* Strict about the count, as it says how much to allocate */
+static int
+FcConfCacheGetCount (FcConfCacheIn *in)
+{
+    int n = FcConfCacheGetInt (in);
+
+    if (n < 0 || n > in->end - in->p)
+    {
+	in->failed = FcTrue;
+	return 0;
+    }
+    return n;
+}
+
+static FcBool
+FcConfCacheGetStrSet (FcConfCacheIn *in, FcStrSet *set)
+{
+    int n = FcConfCacheGetCount (in);
+
+    while (n-- > 0)
+    {
+	const FcChar8 *s = FcConfCacheGetString (in);
+
+	if (!s || !FcStrSetAdd (set, s))
+	    return FcFalse;
+    }
+    return !in->failed;
+}
+
+static FcObject
+FcConfCacheGetObject (FcConfCacheIn *in)
+{
+    const FcChar8 *name = FcConfCacheGetString (in);
+
+    return name ? FcObjectFromName ((const char *) name) : FC_INVALID_OBJECT;
+}
+
+static FcBool
+FcConfCacheGetFontSet (FcConfCacheIn *in, FcFontSet *fs)
+{
+    int n = FcConfCacheGetCount (in);
+
+    while (n-- > 0)
+    {
+	const FcChar8 *s = FcConfCacheGetString (in);
+	FcPattern *p = s ? FcNameParse (s) : NULL;
+
+	if (!p)
+	    return FcFalse;
+	if (!FcFontSetAdd (fs, p))
+	{
+	    FcPatternDestroy (p);
+	    return FcFalse;
+	}
+    }
+    return !in->failed;
+}
+
+static FcCharSet *
+FcConfCacheGetCharSet (FcConfCacheIn *in)
+{
+    FcCharSet *c = FcCharSetCreate ();
+    FcChar32 map[FC_CHARSET_MAP_SIZE];
+    int page, i, j;
+
+    if (!c)
+	return NULL;
+    while ((page = FcConfCacheGetInt (in)) != FC_CONF_CACHE_NONE && !in->failed)
+    {
+	FcConfCacheGetData (in, map, sizeof (map));
+	for (i = 0; i < FC_CHARSET_MAP_SIZE; i++)
+	    for (j = 0; j < 32; j++)
+		if ((map[i] & (1U << j)) &&
+		    !FcCharSetAddChar (c, (FcChar32) page + i * 32 + j))
+		    in->failed = FcTrue;
+    }
+    if (in->failed)
+    {
+	FcCharSetDestroy (c);
+	return NULL;
+    }
+    return c;
+}
+
+static FcLangSet *
+FcConfCacheGetLangSet (FcConfCacheIn *in)
+{
+    FcLangSet *ls = FcLangSetCreate ();
+    int n = FcConfCacheGetCount (in);
+
+    if (!ls)
+	return NULL;
+    while (n-- > 0)
+    {
+	const FcChar8 *lang = FcConfCacheGetString (in);
+
+	if (!lang || !FcLangSetAdd (ls, lang))
+	{
+	    FcLangSetDestroy (ls);
+	    return NULL;
+	}
+    }
+    return ls;
+}
+
+/*
+ * Expressions come from the config's pool, like the parser's.  Each one
+ * only gets its op once what it owns has been read, so that when reading
+ * fails part way the rule holding it can still be destroyed as usual.
+ */
+static FcExpr *
+FcConfCacheGetExpr (FcConfCacheIn *in, FcConfig *config)
+{
+    int op = FcConfCacheGetInt (in);
+    const FcChar8 *s;
+    FcExpr *e;
+    double begin;
+
+    if (in->failed || op == FC_CONF_CACHE_NONE)
+	return NULL;
+    e = FcConfigAllocExpr (config);
+    if (!e)
+    {
+	in->failed = FcTrue;
+	return NULL;
+    }
+    e->op = FcOpNil;
+    switch (FC_OP_GET_OP (op)) {
+    case FcOpInteger:
+	e->u.ival = FcConfCacheGetInt (in);
+	break;
+    case FcOpDouble:
+	e->u.dval = FcConfCacheGetDouble (in);
+	break;
+    case FcOpString:
+	s = FcConfCacheGetString (in);
+	if (!s || !(e->u.sval = FcStrdup (s)))
+	    in->failed = FcTrue;
+	break;
+    case FcOpMatrix:
+	e->u.mexpr = calloc (1, sizeof (FcExprMatrix));
+	if (!e->u.mexpr)
+	{
+	    in->failed = FcTrue;
+	    break;
+	}
+	e->op = op;
+	e->u.mexpr->xx = FcConfCacheGetExpr (in, config);
+	e->u.mexpr->xy = FcConfCacheGetExpr (in, config);
+	e->u.mexpr->yx = FcConfCacheGetExpr (in, config);
+	e->u.mexpr->yy = FcConfCacheGetExpr (in, config);
+	break;
+    case FcOpRange:
+	begin = FcConfCacheGetDouble (in);
+	e->u.rval = FcRangeCreateDouble (begin, FcConfCacheGetDouble (in));
+	if (!e->u.rval)
+	    in->failed = FcTrue;
+	break;
+    case FcOpBool:
+	e->u.bval = FcConfCacheGetInt (in);
+	break;
+    case FcOpCharSet:
+	e->u.cval = FcConfCacheGetCharSet (in);
+	if (!e->u.cval)
+	    in->failed = FcTrue;
+	break;
+    case FcOpLangSet:
+	e->u.lval = FcConfCacheGetLangSet (in);
+	if (!e->u.lval)
+	    in->failed = FcTrue;
+	break;
+    case FcOpField:
+	e->u.name.object = FcConfCacheGetObject (in);
+	e->u.name.kind = FcConfCacheGetInt (in);
+	if (e->u.name.object == FC_INVALID_OBJECT)
+	    in->failed = FcTrue;
+	break;
+    case FcOpConst:
+	s = FcConfCacheGetString (in);
+	if (!s || !(e->u.constant = FcStrdup (s)))
+	    in->failed = FcTrue;
+	break;
+    case FcOpNil:
+    case FcOpInvalid:
+    case FcOpAssign:
+    case FcOpAssignReplace:
+    case FcOpPrepend:
+    case FcOpPrependFirst:
+    case FcOpAppend:
+    case FcOpAppendLast:
+    case FcOpDelete:
+    case FcOpDeleteAll:
+	break;
+    case FcOpNot:
+    case FcOpFloor:
+    case FcOpCeil:
+    case FcOpRound:
+    case FcOpTrunc:
+	e->u.tree.left = e->u.tree.right = NULL;
+	e->op = op;
+	e->u.tree.left = FcConfCacheGetExpr (in, config);
+	break;
+    default:
+	if (FC_OP_GET_OP (op) > FcOpInvalid)
+	{
+	    in->failed = FcTrue;
+	    break;
+	}
+	e->u.tree.left = e->u.tree.right = NULL;
+	e->op = op;
+	e->u.tree.left = FcConfCacheGetExpr (in, config);
+	e->u.tree.right = FcConfCacheGetExpr (in, config);
+	break;
+    }
+    if (e->op == FcOpNil && !in->failed)
+	e->op = op;
+    return e;
+}
+
+static FcRule *
+FcConfCacheGetRules (FcConfCacheIn *in, FcConfig *config)
+{
+    FcRule *rule = NULL, **prev = &rule;
+    int n = FcConfCacheGetCount (in);
+    int kind, qual, binding;
+
+    while (n-- > 0 && !in->failed)
+    {
+	FcRule *r = calloc (1, sizeof (FcRule));
+
+	if (!r)
+	{
+	    in->failed = FcTrue;
+	    break;
+	}
+	*prev = r;
+	prev = &r->next;
+	r->type = FcConfCacheGetInt (in);
+	switch (r->type) {
+	case FcRuleTest:
+	    r->u.test = malloc (sizeof (FcTest));
+	    if (!r->u.test)
+	    {
+		r->type = FcRuleUnknown;
+		in->failed = FcTrue;
+		break;
+	    }
+	    kind = FcConfCacheGetInt (in);
+	    qual = FcConfCacheGetInt (in);
+	    r->u.test->kind = kind;
+	    r->u.test->qual = qual;
+	    r->u.test->object = FcConfCacheGetObject (in);
+	    r->u.test->op = FcConfCacheGetInt (in);
+	    r->u.test->expr = FcConfCacheGetExpr (in, config);
+	    if (kind < (int) FcMatchDefault || kind >= FcMatchKindEnd ||
+		qual < FcQualAny || qual > FcQualNotFirst ||
+		r->u.test->object == FC_INVALID_OBJECT)
+		in->failed = FcTrue;
+	    break;
+	case FcRuleEdit:
+	    r->u.edit = malloc (sizeof (FcEdit));
+	    if (!r->u.edit)
+	    {
+		r->type = FcRuleUnknown;
+		in->failed = FcTrue;
+		break;
+	    }
+	    r->u.edit->object = FcConfCacheGetObject (in);
+	    r->u.edit->op = FcConfCacheGetInt (in);
+	    binding = FcConfCacheGetInt (in);
+	    r->u.edit->binding = binding;
+	    r->u.edit->expr = FcConfCacheGetExpr (in, config);
+	    if (binding < FcValueBindingWeak || binding > FcValueBindingSame ||
+		r->u.edit->object == FC_INVALID_OBJECT)
+		in->failed = FcTrue;
+	    break;
+	case FcRuleUnknown:
+	    break;
+	default:
+	    r->type = FcRuleUnknown;
+	    in->failed = FcTrue;
+	    break;
+	}
+    }
+    if (in->failed && rule)
+    {
+	FcRuleDestroy (rule);
+	rule = NULL;
+    }
+    return rule;
+}
+
+static FcRuleSet *
+FcConfCacheGetRuleSet (FcConfCacheIn *in, FcConfig *config)
+{
+    int n;
+    const FcChar8 *domain, *description;
+    FcRuleSet *rs;
+    FcMatchKind k;
+
+    rs = FcRuleSetCreate (FcConfCacheGetString (in));
+    if (!rs)
+    {
+	in->failed = FcTrue;
+	return NULL;
+    }
+    description = FcConfCacheGetString (in);
+    domain = FcConfCacheGetString (in);
+    FcRuleSetAddDescription (rs, domain, description);
+    FcRuleSetEnable (rs, FcConfCacheGetInt (in));
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd && !in->failed; k++)
+    {
+	while (FcConfCacheGetInt (in) != FC_CONF_CACHE_NONE && !in->failed)
+	{
+	    FcRule *rule = FcConfCacheGetRules (in, config);
+
+	    if (!rule)
+		continue;
+	    if ((n = FcRuleSetAdd (rs, rule, k)) < 0)
+	    {
+		FcRuleDestroy (rule);
+		in->failed = FcTrue;
+	    }
+	    else if (config->maxObjects < n)
+		config->maxObjects = n;
+	}
+    }
+    if (in->failed)
+    {
+	FcRuleSetDestroy (rs);
+	return NULL;
+    }
+    return rs;
+}
+
+static FcBool
+FcConfCacheGetRuleSetList (FcConfCacheIn *in, FcRuleSet **sets, int nsets, FcPtrList *list)
+{
+    FcPtrListIter iter;
+    int i;
+
+    while ((i = FcConfCacheGetInt (in)) != FC_CONF_CACHE_NONE && !in->failed)
+    {
+	if (i < 0 || i >= nsets)
+	    return FcFalse;
+	FcPtrListIterInitAtLast (list, &iter);
+	FcRuleSetReference (sets[i]);
+	if (!FcPtrListIterAdd (list, &iter, sets[i]))
+	{
+	    FcRuleSetDestroy (sets[i]);
+	    return FcFalse;
+	}
+    }
+    return !in->failed;
+}
+
+/*
+ * What the configuration depends on other than the files themselves
+ */
+static void
+FcConfCachePutKey (FcStrBuf *buf)
+{
+    static const char *const vars[] = {
+	"FONTCONFIG_FILE", "FONTCONFIG_PATH",
+	"XDG_CONFIG_HOME", "XDG_DATA_HOME", "XDG_CACHE_HOME",
+    };
+    FcChar8 *file = FcConfigFilename (NULL);
+    int i;
+
+    FcConfCachePutString (buf, file);
+    if (file)
+	FcStrFree (file);
+    FcConfCachePutString (buf, FcConfigHome ());
+    for (i = 0; i < (int) (sizeof (vars) / sizeof (vars[0])); i++)
+	FcConfCachePutString (buf, (const FcChar8 *) getenv (vars[i]));
+#ifdef _WIN32
+    {
+	/* <dir>CUSTOMFONTDIR</dir> and friends are relative to the module */
+	char module[MAX_PATH];
+
+	if (!GetModuleFileName (NULL, module, sizeof (module)))
+	    module[0] = 0;
+	FcConfCachePutString (buf, (const FcChar8 *) module);
+    }
+#endif
+}
+
+static FcBool
+FcConfCachePutFiles (FcStrBuf *buf, const FcStrSet *files)
+{
+    int i;
+
+    FcConfCachePutInt (buf, files->num);
+    for (i = 0; i < files->num; i++)
+    {
+	struct stat statb;
+
+	if (FcStat (files->strs[i], &statb) < 0)
+	    return FcFalse;
+	FcConfCachePutString (buf, files->strs[i]);
+	FcConfCachePutInt64 (buf, (int64_t) statb.st_mtime);
+	FcConfCachePutInt64 (buf, S_ISDIR (statb.st_mode) ? -1 : (int64_t) statb.st_size);
+    }
+    return FcTrue;
+}
+
+/* Whether every file is as it was, and every missing one still is */
+static FcBool
+FcConfCacheFilesValid (FcConfCacheIn *in, FcStrSet *files, FcStrSet *missing)
+{
+    int n = FcConfCacheGetCount (in);
+
+    while (n-- > 0)
+    {
+	const FcChar8 *file = FcConfCacheGetString (in);
+	int64_t mtime = FcConfCacheGetInt64 (in);
+	int64_t size = FcConfCacheGetInt64 (in);
+	struct stat statb;
+
+	if (!file || FcStat (file, &statb) < 0 ||
+	    (int64_t) statb.st_mtime != mtime ||
+	    (S_ISDIR (statb.st_mode) ? -1 : (int64_t) statb.st_size) != size)
+	{
+	    if (file && (FcDebug () & FC_DBG_CONFIG))
+		printf ("\tparsed config cache out of date: %s\n", file);
+	    return FcFalse;
+	}
+	if (!FcStrSetAdd (files, file))
+	    return FcFalse;
+    }
+
+    n = FcConfCacheGetCount (in);
+    while (n-- > 0)
+    {
+	const FcChar8 *name = FcConfCacheGetString (in);
+	FcChar8 *file = name ? FcConfigFilename (name) : NULL;
+
+	if (!name || file)
+	{
+	    if (file)
+	    {
+		if (FcDebug () & FC_DBG_CONFIG)
+		    printf ("\tparsed config cache out of date: %s\n", file);
+		FcStrFree (file);
+	    }
+	    return FcFalse;
+	}
+	if (!FcStrSetAdd (missing, name))
+	    return FcFalse;
+    }
+    return !in->failed;
+}
+
+static FcChar8 *
+FcConfCacheDir (void)
+{
+    FcChar8 *home = FcConfigXdgCacheHome (), *dir = NULL;
+
+    if (home)
+    {
+	dir = FcStrBuildFilename (home, (const FcChar8 *) "fontconfig", NULL);
+	FcStrFree (home);
+    }
+    return dir;
+}
+
+static void
+FcConfCacheFiles (FcChar8 *files[2])
+{
+    FcChar8 *dir = FcConfCacheDir ();
+    const char *sysdir = FC_CACHEDIR;
+
+    files[0] = files[1] = NULL;
+    if (dir)
+    {
+	files[0] = FcStrBuildFilename (dir, (const FcChar8 *) FC_CONF_CACHE_NAME, NULL);
+	FcStrFree (dir);
+    }
+    if (sysdir && *sysdir)
+	files[1] = FcStrBuildFilename ((const FcChar8 *) sysdir,
+				       (const FcChar8 *) FC_CONF_CACHE_NAME, NULL);
+}
+
+/*
+ * Whether config is as FcConfigCreate left it, so that the cache holds
+ * all there is to it
+ */
+static FcBool
+FcConfCacheUsable (FcConfig *config)
+{
+    FcPtrListIter iter;
+
+    if (FcConfigGetSysRoot (config))
+	return FcFalse;
+    if (config->configFiles->num || config->availConfigFiles->num ||
+	config->fontDirs->num || config->cacheDirs->num)
+	return FcFalse;
+    FcPtrListIterInit (config->rulesetList, &iter);
+    return !FcPtrListIterIsValid (config->rulesetList, &iter);
+}
+
+static FcChar8 *
+FcConfCacheRead (const FcChar8 *file, int *size)
+{
+    struct stat statb;
+    FcChar8 *data;
+    int fd, len = 0, n;
+
+    fd = FcOpen ((const char *) file, O_RDONLY | O_BINARY);
+    if (fd < 0)
+	return NULL;
+    if (fstat (fd, &statb) < 0 || statb.st_size <= 0 || statb.st_size > INT_MAX)
+    {
+	close (fd);
+	return NULL;
+    }
+    data = malloc (statb.st_size);
+    if (data)
+    {
+	while (len < statb.st_size &&
+	       (n = read (fd, data + len, statb.st_size - len)) > 0)
+	    len += n;
+	if (len != statb.st_size)
+	{
+	    free (data);
+	    data = NULL;
+	}
+    }
+    close (fd);
+    *size = len;
+    return data;
+}
+
+/* Fill a fresh config from the cache, or fail leaving it to be thrown away */
+static FcBool
+FcConfCacheLoad (FcConfig *config, const FcChar8 *data, int size)
+{
+    FcConfCacheIn in = { data, data + size, FcFalse };
+    FcStrBuf key;
+    FcChar8 key_static[1024];
+    FcRuleSet **sets = NULL;
+    int nsets = 0, i;
+    FcMatchKind k;
+    FcBool ret = FcFalse;
+
+    if (FcConfCacheGetInt (&in) != FC_CONF_CACHE_MAGIC ||
+	FcConfCacheGetInt (&in) != FC_CONF_CACHE_VERSION ||
+	FcConfCacheGetInt (&in) != FC_VERSION)
+	return FcFalse;
+
+    FcStrBufInit (&key, key_static, sizeof (key_static));
+    FcConfCachePutKey (&key);
+    if (key.failed || in.end - in.p < key.len ||
+	memcmp (in.p, key.buf, key.len) != 0)
+    {
+	FcStrBufDestroy (&key);
+	return FcFalse;
+    }
+    in.p += key.len;
+    FcStrBufDestroy (&key);
+
+    if (!FcConfCacheFilesValid (&in, config->availConfigFiles, config->missingConfigFiles))
+	return FcFalse;
+
+    if (!FcConfCacheGetStrSet (&in, config->configDirs) ||
+	!FcConfCacheGetStrSet (&in, config->fontDirs) ||
+	!FcConfCacheGetStrSet (&in, config->cacheDirs) ||
+	!FcConfCacheGetStrSet (&in, config->configFiles) ||
+	!FcConfCacheGetStrSet (&in, config->acceptGlobs) ||
+	!FcConfCacheGetStrSet (&in, config->rejectGlobs) ||
+	!FcConfCacheGetFontSet (&in, config->acceptPatterns) ||
+	!FcConfCacheGetFontSet (&in, config->rejectPatterns))
+	return FcFalse;
+    config->rescanInterval = FcConfCacheGetInt (&in);
+
+    nsets = FcConfCacheGetCount (&in);
+    if (in.failed)
+	return FcFalse;
+    sets = calloc (nsets ? nsets : 1, sizeof (FcRuleSet *));
+    if (!sets)
+	return FcFalse;
+    for (i = 0; i < nsets; i++)
+	if (!(sets[i] = FcConfCacheGetRuleSet (&in, config)))
+	    goto bail;
+
+    if (!FcConfCacheGetRuleSetList (&in, sets, nsets, config->rulesetList))
+	goto bail;
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+	if (!FcConfCacheGetRuleSetList (&in, sets, nsets, config->subst[k]))
+	    goto bail;
+    ret = !in.failed && in.p == in.end;
+
+bail:
+    for (i = 0; i < nsets; i++)
+	FcRuleSetDestroy (sets[i]);
+    free (sets);
+    return ret;
+}
+
+static void
+FcConfCacheSwap (FcConfig *a, FcConfig *b)
+{
+#define FC_CONF_SWAP(type, field) \
+    do { type t = a->field; a->field = b->field; b->field = t; } while (0)
+    FcMatchKind k;
+
+    FC_CONF_SWAP (FcStrSet *, configDirs);
+    FC_CONF_SWAP (FcStrSet *, fontDirs);
+    FC_CONF_SWAP (FcStrSet *, cacheDirs);
+    FC_CONF_SWAP (FcStrSet *, configFiles);
+    FC_CONF_SWAP (FcStrSet *, availConfigFiles);
+    FC_CONF_SWAP (FcStrSet *, missingConfigFiles);
+    FC_CONF_SWAP (FcStrSet *, acceptGlobs);
+    FC_CONF_SWAP (FcStrSet *, rejectGlobs);
+    FC_CONF_SWAP (FcFontSet *, acceptPatterns);
+    FC_CONF_SWAP (FcFontSet *, rejectPatterns);
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+	FC_CONF_SWAP (FcPtrList *, subst[k]);
+    FC_CONF_SWAP (FcPtrList *, rulesetList);
+    FC_CONF_SWAP (int, maxObjects);
+    FC_CONF_SWAP (int, rescanInterval);
+    FC_CONF_SWAP (FcExprPage *, expr_pool);
+#undef FC_CONF_SWAP
+}
+
+FcBool
+FcConfigLoadParsed (FcConfig *config)
+{
+    FcChar8 *files[2];
+    FcBool ret = FcFalse;
+    int i;
+
+    if (!FcConfCacheUsable (config))
+	return FcFalse;
+
+    FcConfCacheFiles (files);
+    for (i = 0; i < 2 && !ret; i++)
+    {
+	FcConfig *parsed;
+	FcChar8 *data;
+	int size;
+
+	if (!files[i] || !(data = FcConfCacheRead (files[i], &size)))
+	    continue;
+	parsed = FcConfigCreate ();
+	if (parsed)
+	{
+	    ret = FcConfCacheLoad (parsed, data, size);
+	    if (ret)
+		FcConfCacheSwap (config, parsed);
+	    FcConfigDestroy (parsed);
+	}
+	free (data);
+	if (ret && (FcDebug () & FC_DBG_CONFIG))
+	    printf ("\tLoading parsed config from %s\n", files[i]);
+    }
+    for (i = 0; i < 2; i++)
+	if (files[i])
+	    FcStrFree (files[i]);
+    return ret;
+}
+
+static FcBool
+FcConfCacheWrite (const FcChar8 *file, const FcChar8 *data, int len)
+{
+    FcChar8 *dir = FcStrDirname (file);
+    FcAtomic *atomic;
+    FcBool ret = FcFalse;
+    int fd;
+
+    if (!dir)
+	return FcFalse;
+    if (access ((char *) dir, W_OK) != 0 &&
+	(access ((char *) dir, F_OK) == 0 || !FcMakeDirectory (dir)))
+    {
+	FcStrFree (dir);
+	return FcFalse;
+    }
+    FcStrFree (dir);
+
+    atomic = FcAtomicCreate (file);
+    if (!atomic)
+	return FcFalse;
+    if (FcAtomicLock (atomic))
+    {
+	fd = FcOpen ((char *) FcAtomicNewFile (atomic), O_RDWR | O_CREAT | O_BINARY, 0666);
+	if (fd >= 0)
+	{
+	    ret = write (fd, data, len) == len;
+	    close (fd);
+	    if (ret)
+		ret = FcAtomicReplaceOrig (atomic);
+	}
+	FcAtomicUnlock (atomic);
+    }
+    FcAtomicDestroy (atomic);
+    return ret;
+}
+
+void
+FcConfigSaveParsed (FcConfig *config)
+{
+    FcConfCacheRuleSets sets = { 0, 0, NULL };
+    FcStrBuf buf;
+    FcChar8 *files[2];
+    FcMatchKind k;
+    FcBool ok;
+    int i, len;
+
+    if (FcConfigGetSysRoot (config))
+	return;
+
+    FcStrBufInit (&buf, NULL, 0);
+    FcConfCachePutInt (&buf, FC_CONF_CACHE_MAGIC);
+    FcConfCachePutInt (&buf, FC_CONF_CACHE_VERSION);
+    FcConfCachePutInt (&buf, FC_VERSION);
+    FcConfCachePutKey (&buf);
+    ok = FcConfCachePutFiles (&buf, config->availConfigFiles);
+    FcConfCachePutStrSet (&buf, config->missingConfigFiles);
+
+    FcConfCachePutStrSet (&buf, config->configDirs);
+    FcConfCachePutStrSet (&buf, config->fontDirs);
+    FcConfCachePutStrSet (&buf, config->cacheDirs);
+    FcConfCachePutStrSet (&buf, config->configFiles);
+    FcConfCachePutStrSet (&buf, config->acceptGlobs);
+    FcConfCachePutStrSet (&buf, config->rejectGlobs);
+    ok = ok && FcConfCachePutFontSet (&buf, config->acceptPatterns);
+    ok = ok && FcConfCachePutFontSet (&buf, config->rejectPatterns);
+    FcConfCachePutInt (&buf, config->rescanInterval);
+
+    /* The rule sets first, then the lists of them by index */
+    if (ok)
+    {
+	FcStrBuf lists;
+
+	FcStrBufInit (&lists, NULL, 0);
+	ok = FcConfCachePutRuleSetList (&lists, &sets, config->rulesetList);
+	for (k = FcMatchKindBegin; k < FcMatchKindEnd && ok; k++)
+	    ok = FcConfCachePutRuleSetList (&lists, &sets, config->subst[k]);
+	FcConfCachePutInt (&buf, sets.num);
+	for (i = 0; i < sets.num && ok; i++)
+	    ok = FcConfCachePutRuleSet (&buf, sets.rs[i]);
+	FcConfCachePutData (&buf, lists.buf, lists.len);
+	ok = ok && !lists.failed;
+	FcStrBufDestroy (&lists);
+    }
+    free (sets.rs);
+
+    len = buf.len;
+    if (ok && !buf.failed)
+    {
+	FcConfCacheFiles (files);
+	for (i = 0; i < 2; i++)
+	{
+	    if (files[i] && FcConfCacheWrite (files[i], buf.buf, len))
+	    {
+		if (FcDebug () & FC_DBG_CONFIG)
+		    printf ("\tSaved parsed config to %s\n", files[i]);
+		break;
+	    }
+	}
+	for (i = 0; i < 2; i++)
+	    if (files[i])
+		FcStrFree (files[i]);
+    }
+    FcStrBufDestroy (&buf);
+}
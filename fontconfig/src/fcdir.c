@@ -59,28 +59,18 @@ FcFileIsFile (const FcChar8 *file)
     return S_ISREG (statb.st_mode);
 }
 
+/*
+ * Finish the patterns scanned from one file, from old_nfont on
+ */
 static FcBool
-FcFileScanFontConfig (FcFontSet		*set,
-		      const FcChar8	*file,
-		      FcConfig		*config)
+FcFileScanFontFixup (FcFontSet		*set,
+		     int		old_nfont,
+		     FcConfig		*config)
 {
     int		i;
     FcBool	ret = FcTrue;
-    int		old_nfont = set->nfont;
     const FcChar8 *sysroot = FcConfigGetSysRoot (config);
 
-    if (FcDebug () & FC_DBG_SCAN)
-    {
-	printf ("\tScanning file %s...", file);
-	fflush (stdout);
-    }
-
-    if (!FcFreeTypeQueryAll (file, -1, NULL, NULL, set))
-	return FcFalse;
-
-    if (FcDebug () & FC_DBG_SCAN)
-	printf ("done\n");
-
     for (i = old_nfont; i < set->nfont; i++)
     {
 	FcPattern *font = set->fonts[i];
@@ -124,6 +114,52 @@ FcFileScanFontConfig (FcFontSet		*set,
     return ret;
 }
 
+static FcBool
+FcFileScanFontConfig (FcFontSet		*set,
+		      const FcChar8	*file,
+		      FcConfig		*config)
+{
+    int		old_nfont = set->nfont;
+
+    if (FcDebug () & FC_DBG_SCAN)
+    {
+	printf ("\tScanning file %s...", file);
+	fflush (stdout);
+    }
+
+    if (!FcFreeTypeQueryAll (file, -1, NULL, NULL, set))
+	return FcFalse;
+
+    if (FcDebug () & FC_DBG_SCAN)
+	printf ("done\n");
+
+    return FcFileScanFontFixup (set, old_nfont, config);
+}
+
+static FcBool
+FcFileScanAddDir (FcStrSet	*dirs,
+		  const FcChar8	*file,
+		  FcConfig	*config)
+{
+    const FcChar8 *sysroot = FcConfigGetSysRoot (config);
+    const FcChar8 *d = file;
+    size_t len;
+
+    if (sysroot)
+    {
+	    len = strlen ((const char *)sysroot);
+	    if (strncmp ((const char *)file, (const char *)sysroot, len) == 0)
+	    {
+		    if (file[len] != '/')
+			    len--;
+		    else if (file[len+1] == '/')
+			    len++;
+		    d = &file[len];
+	    }
+    }
+    return FcStrSetAdd (dirs, d);
+}
+
 FcBool
 FcFileScanConfig (FcFontSet	*set,
 		  FcStrSet	*dirs,
@@ -131,25 +167,7 @@ FcFileScanConfig (FcFontSet	*set,
 		  FcConfig	*config)
 {
     if (FcFileIsDir (file))
-    {
-	const FcChar8 *sysroot = FcConfigGetSysRoot (config);
-	const FcChar8 *d = file;
-	size_t len;
-
-	if (sysroot)
-	{
-		len = strlen ((const char *)sysroot);
-		if (strncmp ((const char *)file, (const char *)sysroot, len) == 0)
-		{
-			if (file[len] != '/')
-				len--;
-			else if (file[len+1] == '/')
-				len++;
-			d = &file[len];
-		}
-	}
-	return FcStrSetAdd (dirs, d);
-    }
+	return FcFileScanAddDir (dirs, file, config);
     else
     {
 	if (set)
@@ -179,6 +197,173 @@ cmpstringp(const void *p1, const void *p2)
     return strcmp(* (char **) p1, * (char **) p2);
 }
 
+#if !defined(FC_NO_MT) && !defined(FC_ATOMIC_INT_NIL) && \
+    (defined(_MSC_VER) || defined(__MINGW32__) || defined(HAVE_PTHREAD))
+#define FC_DIR_SCAN_THREADS 1
+#endif
+
+#ifdef FC_DIR_SCAN_THREADS
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/* Directories with fewer entries than this are scanned in the caller */
+#define FC_DIR_SCAN_MIN_FILES	8
+#define FC_DIR_SCAN_MAX_THREADS	8
+
+typedef struct _FcDirScanJob {
+    FcChar8		**files;
+    FcFontSet		**sets;	/* one per file, NULL for directories */
+    int			nfiles;
+    fc_atomic_int_t	next;	/* next file to take */
+} FcDirScanJob;
+
+/*
+ * Query files until there are none left.  Only FreeType, with a library
+ * of its own per file, and pattern construction run here; config rules
+ * are applied by the caller once all files are done.
+ */
+static void
+FcDirScanWork (FcDirScanJob *job)
+{
+    int	i;
+
+    while ((i = fc_atomic_int_add (job->next, 1)) < job->nfiles)
+    {
+	if (FcFileIsDir (job->files[i]))
+	{
+	    FcFontSetDestroy (job->sets[i]);
+	    job->sets[i] = NULL;
+	}
+	else
+	    FcFreeTypeQueryAll (job->files[i], -1, NULL, NULL, job->sets[i]);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+FcDirScanThread (LPVOID closure)
+{
+    FcDirScanWork (closure);
+    return 0;
+}
+#else
+static void *
+FcDirScanThread (void *closure)
+{
+    FcDirScanWork (closure);
+    return NULL;
+}
+#endif
+
+static int
+FcDirScanNumThreads (void)
+{
+    int	n = 1;
+#ifdef _WIN32
+    SYSTEM_INFO	si;
+
+    GetSystemInfo (&si);
+    n = (int) si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    n = (int) sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+    if (n > FC_DIR_SCAN_MAX_THREADS)
+	n = FC_DIR_SCAN_MAX_THREADS;
+    return n;
+}
+
+/*
+ * Scan the entries of a directory on several threads, then add the
+ * fonts to set in the order of files, as the serial scan does.
+ * Returns FcFalse, having done nothing, when the serial scan should be
+ * used instead.
+ */
+static FcBool
+FcDirScanFilesThreaded (FcFontSet	*set,
+			FcStrSet	*dirs,
+			FcStrSet	*files,
+			FcConfig	*config)
+{
+    FcDirScanJob	job;
+#ifdef _WIN32
+    HANDLE		threads[FC_DIR_SCAN_MAX_THREADS];
+#else
+    pthread_t		threads[FC_DIR_SCAN_MAX_THREADS];
+#endif
+    int			nthreads, started, i, j, old_nfont;
+
+    nthreads = FcDirScanNumThreads ();
+    if (nthreads < 2 || files->num < FC_DIR_SCAN_MIN_FILES)
+	return FcFalse;
+
+    job.files = files->strs;
+    job.nfiles = files->num;
+    job.next = 0;
+    job.sets = calloc (files->num, sizeof (FcFontSet *));
+    if (!job.sets)
+	return FcFalse;
+    for (i = 0; i < files->num; i++)
+    {
+	if (!(job.sets[i] = FcFontSetCreate ()))
+	{
+	    while (i-- > 0)
+		FcFontSetDestroy (job.sets[i]);
+	    free (job.sets);
+	    return FcFalse;
+	}
+    }
+
+    /* The calling thread is one of the workers */
+    for (started = 0; started < nthreads - 1; started++)
+    {
+#ifdef _WIN32
+	threads[started] = CreateThread (NULL, 0, FcDirScanThread, &job, 0, NULL);
+	if (!threads[started])
+	    break;
+#else
+	if (pthread_create (&threads[started], NULL, FcDirScanThread, &job) != 0)
+	    break;
+#endif
+    }
+    FcDirScanWork (&job);
+    for (i = 0; i < started; i++)
+    {
+#ifdef _WIN32
+	WaitForSingleObject (threads[i], INFINITE);
+	CloseHandle (threads[i]);
+#else
+	pthread_join (threads[i], NULL);
+#endif
+    }
+
+    for (i = 0; i < files->num; i++)
+    {
+	FcFontSet	*s = job.sets[i];
+
+	if (!s)
+	{
+	    FcFileScanAddDir (dirs, files->strs[i], config);
+	    continue;
+	}
+	if (FcDebug () & FC_DBG_SCAN)
+	    printf ("\tScanning file %s...done\n", files->strs[i]);
+	old_nfont = set->nfont;
+	for (j = 0; j < s->nfont; j++)
+	    if (!FcFontSetAdd (set, s->fonts[j]))
+		FcPatternDestroy (s->fonts[j]);
+	s->nfont = 0;
+	FcFontSetDestroy (s);
+	FcFileScanFontFixup (set, old_nfont, config);
+    }
+    free (job.sets);
+
+    return FcTrue;
+}
+
+#endif /* FC_DIR_SCAN_THREADS */
+
 FcBool
 FcDirScanConfig (FcFontSet	*set,
 		 FcStrSet	*dirs,
@@ -249,6 +434,9 @@ FcDirScanConfig (FcFontSet	*set,
     /*
      * Scan file files to build font patterns
      */
+#ifdef FC_DIR_SCAN_THREADS
+    if (!set || !FcDirScanFilesThreaded (set, dirs, files, config))
+#endif
     for (i = 0; i < files->num; i++)
 	FcFileScanConfig (set, dirs, files->strs[i], config);
 
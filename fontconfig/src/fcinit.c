@@ -86,16 +86,20 @@ FcInitLoadOwnConfig (FcConfig *config)
 
     FcInitDebug ();
 
-    if (!FcConfigParseAndLoad (config, 0, FcTrue))
+    if (!FcConfigLoadParsed (config))
     {
-	const FcChar8 *sysroot = FcConfigGetSysRoot (config);
-	FcConfig *fallback = FcInitFallbackConfig (sysroot);
+	if (!FcConfigParseAndLoad (config, 0, FcTrue))
+	{
+	    const FcChar8 *sysroot = FcConfigGetSysRoot (config);
+	    FcConfig *fallback = FcInitFallbackConfig (sysroot);
 
-	FcConfigDestroy (config);
+	    FcConfigDestroy (config);
 
-	return fallback;
+	    return fallback;
+	}
+	(void) FcConfigParseOnly (config, (const FcChar8 *)FC_TEMPLATEDIR, FcFalse);
+	FcConfigSaveParsed (config);
     }
-    (void) FcConfigParseOnly (config, (const FcChar8 *)FC_TEMPLATEDIR, FcFalse);
 
     if (config->cacheDirs && config->cacheDirs->num == 0)
     {
@@ -502,6 +502,8 @@ struct _FcAtomic {
     FcChar8	*tmp;		/* tmpfile name (used for locking) */
 };
 
+typedef struct _FcMatchCache FcMatchCache;
+
 struct _FcConfig {
     /*
      * File names loaded from the configuration -- saved here as the
@@ -564,8 +566,10 @@ struct _FcConfig {
 
     FcChar8     *sysRoot;	    /* override the system root directory */
     FcStrSet	*availConfigFiles;  /* config files available */
+    FcStrSet	*missingConfigFiles; /* config files looked for and not found */
     FcPtrList	*rulesetList;	    /* List of rulesets being installed */
     FcHashTable *uuid_table;	    /* UUID table for cachedirs */
+    FcMatchCache *matchCache;	    /* recent FcFontMatch/FcFontSort results */
 };
 
 typedef struct _FcFileTime {
@@ -826,6 +830,13 @@ FcReadLink (const FcChar8 *pathname,
 	    FcChar8       *buf,
 	    size_t         bufsiz);
 
+/* fcconfcache.c */
+FcPrivate FcBool
+FcConfigLoadParsed (FcConfig *config);
+
+FcPrivate void
+FcConfigSaveParsed (FcConfig *config);
+
 /* fcdbg.c */
 
 FcPrivate void
@@ -1010,6 +1021,12 @@ FcListPatternMatchAny (const FcPattern *p,
 
 /* fcmatch.c */
 
+FcPrivate void
+FcMatchCacheDestroy (FcConfig *config);
+
+FcPrivate void
+FcMatchCacheFlush (FcConfig *config);
+
 /* fcname.c */
 
 enum {
@@ -1217,6 +1234,9 @@ FcRangeSerialize (FcSerialize *serialize, const FcRange *r);
 FcPrivate int
 FcStat (const FcChar8 *file, struct stat *statb);
 
+FcPrivate int
+FcFStat (int fd, struct stat *statb);
+
 FcPrivate int
 FcStatChecksum (const FcChar8 *file, struct stat *statb);
 
@@ -865,6 +865,235 @@ FcFontSetMatch (FcConfig    *config,
 	return NULL;
 }
 
+/*
+ * Applications ask for the same match over and over, for instance once per
+ * character that needs a fallback font.  The winner only depends on the
+ * query and the config's font sets, so keep the most recent results for
+ * FcFontMatch and FcFontSort.  Entries hold references to the fonts, and
+ * are dropped whenever the font sets differ from the ones they were
+ * computed from.
+ */
+
+#define FC_MATCH_CACHE_SIZE	64
+
+#define FC_MATCH_CACHE_MATCH	0
+#define FC_MATCH_CACHE_SORT	1
+#define FC_MATCH_CACHE_TRIM	2
+#define FC_MATCH_CACHE_CHARSET	4
+
+typedef struct _FcMatchCacheEntry {
+    FcPattern	*pattern;	/* the query */
+    FcChar32	hash;
+    int		kind;
+    FcPattern	*best;		/* FcFontMatch */
+    FcFontSet	*fonts;		/* FcFontSort */
+    FcCharSet	*charset;	/* FcFontSort, when asked for */
+} FcMatchCacheEntry;
+
+struct _FcMatchCache {
+    FcMutex		lock;
+    FcFontSet		*sets[FcSetApplication + 1];
+    int			nfont[FcSetApplication + 1];
+    int			nentries;
+    FcMatchCacheEntry	entries[FC_MATCH_CACHE_SIZE]; /* most recent first */
+};
+
+static FcMatchCache *
+FcMatchCacheGet (FcConfig *config)
+{
+    FcMatchCache *cache;
+
+    if (FcDebug () & (FC_DBG_MATCH | FC_DBG_MATCHV))
+	return NULL;
+retry:
+    cache = fc_atomic_ptr_get (&config->matchCache);
+    if (!cache)
+    {
+	cache = calloc (1, sizeof (FcMatchCache));
+	if (!cache)
+	    return NULL;
+	FcMutexInit (&cache->lock);
+	if (!fc_atomic_ptr_cmpexch (&config->matchCache, NULL, cache))
+	{
+	    FcMutexFinish (&cache->lock);
+	    free (cache);
+	    goto retry;
+	}
+    }
+    return cache;
+}
+
+static void
+FcMatchCacheEntryFini (FcMatchCacheEntry *e)
+{
+    if (e->pattern)
+	FcPatternDestroy (e->pattern);
+    if (e->best)
+	FcPatternDestroy (e->best);
+    if (e->fonts)
+	FcFontSetDestroy (e->fonts);
+    if (e->charset)
+	FcCharSetDestroy (e->charset);
+}
+
+static void
+FcMatchCacheClear (FcMatchCache *cache)
+{
+    int i;
+
+    for (i = 0; i < cache->nentries; i++)
+	FcMatchCacheEntryFini (&cache->entries[i]);
+    cache->nentries = 0;
+}
+
+/* Called with the lock held; forgets everything if the fonts changed */
+static void
+FcMatchCacheValidate (FcMatchCache *cache, FcConfig *config)
+{
+    int set;
+
+    for (set = FcSetSystem; set <= FcSetApplication; set++)
+    {
+	FcFontSet *fs = config->fonts[set];
+
+	if (cache->sets[set] != fs || cache->nfont[set] != (fs ? fs->nfont : 0))
+	    break;
+    }
+    if (set > FcSetApplication)
+	return;
+
+    FcMatchCacheClear (cache);
+    for (set = FcSetSystem; set <= FcSetApplication; set++)
+    {
+	cache->sets[set] = config->fonts[set];
+	cache->nfont[set] = config->fonts[set] ? config->fonts[set]->nfont : 0;
+    }
+}
+
+/* FcPatternEqual ignores bindings, which FcCompare doesn't */
+static FcBool
+FcMatchCachePatternEqual (const FcPattern *a, const FcPattern *b)
+{
+    FcPatternElt	*ea, *eb;
+    FcValueListPtr	la, lb;
+    int			i;
+
+    if (!FcPatternEqual (a, b))
+	return FcFalse;
+    ea = FcPatternElts (a);
+    eb = FcPatternElts (b);
+    for (i = 0; i < a->num; i++)
+    {
+	for (la = FcPatternEltValues (&ea[i]), lb = FcPatternEltValues (&eb[i]);
+	     la && lb;
+	     la = FcValueListNext (la), lb = FcValueListNext (lb))
+	    if (la->binding != lb->binding)
+		return FcFalse;
+    }
+    return FcTrue;
+}
+
+/* Called with the lock held; the entry found becomes the most recent */
+static FcMatchCacheEntry *
+FcMatchCacheLookup (FcMatchCache *cache, FcConfig *config,
+		    FcPattern *p, FcChar32 hash, int kind)
+{
+    FcMatchCacheEntry	e;
+    int			i;
+
+    FcMatchCacheValidate (cache, config);
+    for (i = 0; i < cache->nentries; i++)
+    {
+	if (cache->entries[i].hash == hash &&
+	    cache->entries[i].kind == kind &&
+	    FcMatchCachePatternEqual (cache->entries[i].pattern, p))
+	{
+	    e = cache->entries[i];
+	    memmove (&cache->entries[1], &cache->entries[0], i * sizeof (e));
+	    cache->entries[0] = e;
+	    return &cache->entries[0];
+	}
+    }
+    return NULL;
+}
+
+/* Called with the lock held; takes over best, fonts and charset */
+static void
+FcMatchCacheInsert (FcMatchCache *cache, FcConfig *config,
+		    FcPattern *p, FcChar32 hash, int kind,
+		    FcPattern *best, FcFontSet *fonts, FcCharSet *charset)
+{
+    FcMatchCacheEntry e;
+
+    FcMatchCacheValidate (cache, config);
+    e.pattern = FcPatternDuplicate (p);
+    e.hash = hash;
+    e.kind = kind;
+    e.best = best;
+    e.fonts = fonts;
+    e.charset = charset;
+    if (!e.pattern)
+    {
+	FcMatchCacheEntryFini (&e);
+	return;
+    }
+    if (cache->nentries == FC_MATCH_CACHE_SIZE)
+	FcMatchCacheEntryFini (&cache->entries[--cache->nentries]);
+    memmove (&cache->entries[1], &cache->entries[0],
+	     cache->nentries * sizeof (e));
+    cache->entries[0] = e;
+    cache->nentries++;
+}
+
+void
+FcMatchCacheFlush (FcConfig *config)
+{
+    FcMatchCache *cache = fc_atomic_ptr_get (&config->matchCache);
+
+    if (cache)
+    {
+	FcMutexLock (&cache->lock);
+	FcMatchCacheClear (cache);
+	FcMutexUnlock (&cache->lock);
+    }
+}
+
+void
+FcMatchCacheDestroy (FcConfig *config)
+{
+    FcMatchCache *cache = config->matchCache;
+
+    if (cache)
+    {
+	FcMatchCacheClear (cache);
+	FcMutexFinish (&cache->lock);
+	free (cache);
+	config->matchCache = NULL;
+    }
+}
+
+/* A set holding its own references to the fonts of s */
+static FcFontSet *
+FcFontSetCopyReferences (FcFontSet *s)
+{
+    FcFontSet	*ret = FcFontSetCreate ();
+    int		i;
+
+    if (!ret)
+	return NULL;
+    for (i = 0; i < s->nfont; i++)
+    {
+	FcPatternReference (s->fonts[i]);
+	if (!FcFontSetAdd (ret, s->fonts[i]))
+	{
+	    FcPatternDestroy (s->fonts[i]);
+	    FcFontSetDestroy (ret);
+	    return NULL;
+	}
+    }
+    return ret;
+}
+
 FcPattern *
 FcFontMatch (FcConfig	*config,
 	     FcPattern	*p,
@@ -872,7 +1101,9 @@ FcFontMatch (FcConfig	*config,
 {
     FcFontSet	*sets[2];
     int		nsets;
-    FcPattern   *best;
+    FcPattern   *best, *ret;
+    FcMatchCache *cache;
+    FcChar32	hash = 0;
 
     assert (p != NULL);
     assert (result != NULL);
@@ -885,6 +1116,27 @@ FcFontMatch (FcConfig	*config,
 	if (!config)
 	    return 0;
     }
+    cache = FcMatchCacheGet (config);
+    if (cache)
+    {
+	FcMatchCacheEntry *e;
+
+	hash = FcPatternHash (p);
+	FcMutexLock (&cache->lock);
+	e = FcMatchCacheLookup (cache, config, p, hash, FC_MATCH_CACHE_MATCH);
+	if (e)
+	{
+	    best = e->best;
+	    FcPatternReference (best);
+	    FcMutexUnlock (&cache->lock);
+	    *result = FcResultMatch;
+	    ret = FcFontRenderPrepare (config, p, best);
+	    FcPatternDestroy (best);
+	    return ret;
+	}
+	FcMutexUnlock (&cache->lock);
+    }
+
     nsets = 0;
     if (config->fonts[FcSetSystem])
 	sets[nsets++] = config->fonts[FcSetSystem];
@@ -892,10 +1144,17 @@ FcFontMatch (FcConfig	*config,
 	sets[nsets++] = config->fonts[FcSetApplication];
 
     best = FcFontSetMatchInternal (sets, nsets, p, result);
-    if (best)
-	return FcFontRenderPrepare (config, p, best);
-    else
+    if (!best)
 	return NULL;
+    if (cache)
+    {
+	FcPatternReference (best);
+	FcMutexLock (&cache->lock);
+	FcMatchCacheInsert (cache, config, p, hash, FC_MATCH_CACHE_MATCH,
+			    best, NULL, NULL);
+	FcMutexUnlock (&cache->lock);
+    }
+    return FcFontRenderPrepare (config, p, best);
 }
 
 typedef struct _FcSortNode {
@@ -1184,6 +1443,10 @@ FcFontSort (FcConfig	*config,
 {
     FcFontSet	*sets[2];
     int		nsets;
+    FcFontSet	*ret;
+    FcMatchCache *cache;
+    FcChar32	hash = 0;
+    int		kind;
 
     assert (p != NULL);
     assert (result != NULL);
@@ -1196,12 +1459,67 @@ FcFontSort (FcConfig	*config,
 	if (!config)
 	    return 0;
     }
+
+    kind = FC_MATCH_CACHE_SORT;
+    if (trim)
+	kind |= FC_MATCH_CACHE_TRIM;
+    if (csp)
+	kind |= FC_MATCH_CACHE_CHARSET;
+
+    cache = FcMatchCacheGet (config);
+    if (cache)
+    {
+	FcMatchCacheEntry *e;
+
+	hash = FcPatternHash (p);
+	FcMutexLock (&cache->lock);
+	e = FcMatchCacheLookup (cache, config, p, hash, kind);
+	if (e)
+	{
+	    ret = FcFontSetCopyReferences (e->fonts);
+	    if (ret && csp)
+	    {
+		/* the caller owns and may edit its charset, so copy it */
+		*csp = FcCharSetUnion (e->charset, e->charset);
+		if (!*csp)
+		{
+		    FcFontSetDestroy (ret);
+		    ret = NULL;
+		}
+	    }
+	    FcMutexUnlock (&cache->lock);
+	    if (ret && ret->nfont > 0)
+		*result = FcResultMatch;
+	    return ret;
+	}
+	FcMutexUnlock (&cache->lock);
+    }
+
     nsets = 0;
     if (config->fonts[FcSetSystem])
 	sets[nsets++] = config->fonts[FcSetSystem];
     if (config->fonts[FcSetApplication])
 	sets[nsets++] = config->fonts[FcSetApplication];
-    return FcFontSetSort (config, sets, nsets, p, trim, csp, result);
+    ret = FcFontSetSort (config, sets, nsets, p, trim, csp, result);
+    if (ret && cache && *result == FcResultMatch)
+    {
+	FcFontSet	*fonts = FcFontSetCopyReferences (ret);
+	FcCharSet	*charset = NULL;
+
+	if (csp && fonts && !(charset = FcCharSetUnion (*csp, *csp)))
+	{
+	    FcFontSetDestroy (fonts);
+	    fonts = NULL;
+	}
+	if (fonts)
+	{
+	    FcMutexLock (&cache->lock);
+	    FcMatchCacheInsert (cache, config, p, hash, kind,
+				NULL, fonts, charset);
+	    FcMutexUnlock (&cache->lock);
+	}
+    }
+    return ret;
 }
 #define __fcmatch__
 #include "fcaliastail.h"
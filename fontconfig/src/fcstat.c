@@ -45,6 +45,7 @@
 #include <errno.h>
 
 #ifdef _WIN32
+#include <io.h>
 #ifdef __GNUC__
 typedef long long INT64;
 #define EPOCH_OFFSET 11644473600ll
@@ -72,6 +73,33 @@ typedef __int64 INT64;
  * just use the UTC timestamps from NTFS, converted to the Unix epoch.
  */
 
+static int
+FcStatFill (struct stat *statb, DWORD attributes, DWORD size_high,
+	    DWORD size_low, FILETIME *atime, FILETIME *mtime)
+{
+    statb->st_mode = _S_IREAD | _S_IWRITE;
+    statb->st_mode |= (statb->st_mode >> 3) | (statb->st_mode >> 6);
+
+    if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+	statb->st_mode |= _S_IFDIR;
+    else
+	statb->st_mode |= _S_IFREG;
+
+    statb->st_nlink = 1;
+    statb->st_uid = statb->st_gid = 0;
+    statb->st_rdev = 0;
+
+    if (size_high > 0)
+	return -1;
+    statb->st_size = size_low;
+
+    statb->st_atime = (*(INT64 *)atime)/10000000 - EPOCH_OFFSET;
+    statb->st_mtime = (*(INT64 *)mtime)/10000000 - EPOCH_OFFSET;
+    statb->st_ctime = statb->st_mtime;
+
+    return 0;
+}
+
 int
 FcStat (const FcChar8 *file, struct stat *statb)
 {
@@ -86,37 +114,39 @@ FcStat (const FcChar8 *file, struct stat *statb)
     statb->st_dev = 0;
 
     /* Calculate a pseudo inode number as a hash of the full path name.
-     * Call GetLongPathName() to get the spelling of the path name as it
-     * is on disk.
+     * Nothing compares it across spellings of a path; cache files are
+     * identified through FcFStat(), so don't pay for GetLongPathName()
+     * looking up every path component on disk.
      */
     rc = GetFullPathName ((LPCSTR) file, sizeof (full_path_name), full_path_name, &basename);
     if (rc == 0 || rc > sizeof (full_path_name))
 	return -1;
 
-    rc = GetLongPathName (full_path_name, full_path_name, sizeof (full_path_name));
     statb->st_ino = FcStringHash ((const FcChar8 *) full_path_name)&0xffff;
 
-    statb->st_mode = _S_IREAD | _S_IWRITE;
-    statb->st_mode |= (statb->st_mode >> 3) | (statb->st_mode >> 6);
-
-    if (wfad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-	statb->st_mode |= _S_IFDIR;
-    else
-	statb->st_mode |= _S_IFREG;
+    return FcStatFill (statb, wfad.dwFileAttributes, wfad.nFileSizeHigh,
+		       wfad.nFileSizeLow, &wfad.ftLastAccessTime,
+		       &wfad.ftLastWriteTime);
+}
 
-    statb->st_nlink = 1;
-    statb->st_uid = statb->st_gid = 0;
-    statb->st_rdev = 0;
+/* Same as FcStat(), for a file that is already open.  The volume serial
+ * number and file index identify the file, whatever path opened it.
+ */
+int
+FcFStat (int fd, struct stat *statb)
+{
+    BY_HANDLE_FILE_INFORMATION bhfi;
 
-    if (wfad.nFileSizeHigh > 0)
+    if (!GetFileInformationByHandle ((HANDLE) _get_osfhandle (fd), &bhfi))
 	return -1;
-    statb->st_size = wfad.nFileSizeLow;
 
-    statb->st_atime = (*(INT64 *)&wfad.ftLastAccessTime)/10000000 - EPOCH_OFFSET;
-    statb->st_mtime = (*(INT64 *)&wfad.ftLastWriteTime)/10000000 - EPOCH_OFFSET;
-    statb->st_ctime = statb->st_mtime;
+    statb->st_dev = bhfi.dwVolumeSerialNumber;
+    statb->st_ino = (bhfi.nFileIndexLow ^ (bhfi.nFileIndexLow >> 16) ^
+		     bhfi.nFileIndexHigh) & 0xffff;
 
-    return 0;
+    return FcStatFill (statb, bhfi.dwFileAttributes, bhfi.nFileSizeHigh,
+		       bhfi.nFileSizeLow, &bhfi.ftLastAccessTime,
+		       &bhfi.ftLastWriteTime);
 }
 
 #else
@@ -127,6 +157,12 @@ FcStat (const FcChar8 *file, struct stat *statb)
   return stat ((char *) file, statb);
 }
 
+int
+FcFStat (int fd, struct stat *statb)
+{
+  return fstat (fd, statb);
+}
+
 /* Adler-32 checksum implementation */
 struct Adler32 {
     int a;
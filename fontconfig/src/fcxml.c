@@ -3461,7 +3461,12 @@ _FcConfigParse (FcConfig	*config,
 
     filename = FcConfigFilename (name);
     if (!filename)
+    {
+	/* so a cache of the parsed config knows to look for it again */
+	if (name)
+	    FcStrSetAdd (config->missingConfigFiles, name);
 	goto bail0;
+    }
     realfilename = FcConfigRealFilename (config, name);
     if (!realfilename)
 	goto bail0;
@@ -505,6 +505,7 @@ typedef struct __DRIsystemTimeExtensionRec __DRIsystemTimeExtension;
 typedef struct __DRIdamageExtensionRec __DRIdamageExtension;
 typedef struct __DRIloaderExtensionRec __DRIloaderExtension;
 typedef struct __DRIswrastLoaderExtensionRec __DRIswrastLoaderExtension;
+typedef struct __DRIswrastFrontLoaderExtensionRec __DRIswrastFrontLoaderExtension;
 
 
 /**
@@ -670,6 +671,38 @@ struct __DRIswrastLoaderExtensionRec {
                          void *loaderPrivate);
 };
 
+/**
+ * SWRast front buffer loader extension.
+ *
+ * Lets the driver render straight into the memory holding the drawable's
+ * pixels, instead of reading and writing them through getImage and
+ * putImage.
+ */
+#define __DRI_SWRAST_FRONT_LOADER "DRI_SWRastFrontLoader"
+#define __DRI_SWRAST_FRONT_LOADER_VERSION 1
+struct __DRIswrastFrontLoaderExtensionRec {
+    __DRIextension base;
+
+    /**
+     * Return the top row of the drawable's pixels, or NULL if the driver
+     * must use the swrast loader instead, for example because the drawable
+     * is partly covered by another window.  Rows are \p stride bytes apart
+     * and top to bottom.  The pointer is only good until the loader next
+     * gets control back.
+     */
+    char *(*getFrontBuffer)(__DRIdrawable *drawable,
+                            int *width, int *height, int *stride, int *bpp,
+                            void *loaderPrivate);
+
+    /**
+     * Tell the loader the driver has written to a rectangle of the
+     * buffer returned by getFrontBuffer, with y counted from the top.
+     */
+    void (*damage)(__DRIdrawable *drawable,
+                   int x, int y, int width, int height,
+                   void *loaderPrivate);
+};
+
 /**
  * Invalidate loader extension.  The presence of this extension
  * indicates to the DRI driver that the loader will call invalidate in
@@ -166,6 +166,9 @@
 /* Define to 1 if you have the `arc4random_buf' function. */
 #undef HAVE_ARC4RANDOM_BUF
 
+/* Define to use the built-in SHA1 functions */
+#define HAVE_SHA1_BUILTIN
+
 /* Define to use libc SHA1 functions */
 #undef HAVE_SHA1_IN_LIBC
 
@@ -173,7 +176,7 @@
 #undef HAVE_SHA1_IN_COMMONCRYPTO
 
 /* Define to use CryptoAPI SHA1 functions */
-#define HAVE_SHA1_IN_CRYPTOAPI
+#undef HAVE_SHA1_IN_CRYPTOAPI
 
 /* Define to use libmd SHA1 functions */
 #undef HAVE_SHA1_IN_LIBMD
@@ -268,7 +271,7 @@
 #undef LOCALCONN
 
 /* Support MIT-SHM Extension */
-#undef MITSHM
+#define MITSHM 1
 
 /* Disable some debugging code */
 #define NDEBUG 1
@@ -461,6 +464,15 @@
 /* Define to 1 if the DTrace Xserver provider probes should be built in */
 /*#define XSERVER_DTRACE*/
 
+/* Define to 1 to profile the time spent in each request type */
+/*#define XSERVER_REQUEST_PROFILE*/
+
+/* Define to 1 to trace the latency of input events through the server */
+/*#define XSERVER_INPUT_LATENCY*/
+
+/* Define to 1 to trace the stages of each frame to ETW or a file */
+/*#define XSERVER_FRAME_TRACE*/
+
 /* Define to 1 if typeof works with your compiler. */
 #undef HAVE_TYPEOF
 
@@ -533,7 +545,7 @@
 #define LISTEN_TCP 1
 
 /* Listen on Unix socket */
-#undef LISTEN_UNIX
+#define LISTEN_UNIX 1
 
 /* Listen on local socket */
 #undef LISTEN_LOCAL
@@ -28,6 +28,7 @@ in this Software without prior written authorization from The Open Group.
 #include <config.h>
 #endif
 #include "Xlibint.h"
+#include "Xprivate.h"
 
 /*
  * Check existing events in queue to find if any match.  If so, return.
@@ -40,8 +41,7 @@ Bool XCheckTypedEvent (
 	int type,		/* Selected event type. */
 	register XEvent *event)	/* XEvent to be filled in. */
 {
-	register _XQEvent *prev, *qelt;
-	unsigned long qe_serial = 0;
+	register _XQEvent *qelt;
 	int n;			/* time through count */
 
         LockDisplay(dpy);
@@ -49,21 +49,19 @@ Bool XCheckTypedEvent (
 	/* Delete unclaimed cookies */
 	_XFreeEventCookies(dpy);
 
-	prev = NULL;
 	for (n = 3; --n >= 0;) {
-	    for (qelt = prev ? prev->next : dpy->head;
+	    /* Only events of this type need looking at. */
+	    for (qelt = dpy->qindex->type_head[XQ_TYPE_LIST(type)];
 		 qelt;
-		 prev = qelt, qelt = qelt->next) {
+		 qelt = qelt->type_next) {
 		if (qelt->event.type == type) {
 		    *event = qelt->event;
-		    _XDeq(dpy, prev, qelt);
+		    _XDeq(dpy, qelt->prev, qelt);
 		    _XStoreEventCookie(dpy, event);
 		    UnlockDisplay(dpy);
 		    return True;
 		}
 	    }
-	    if (prev)
-		qe_serial = prev->qserial_num;
 	    switch (n) {
 	      case 2:
 		_XEventsQueued(dpy, QueuedAfterReading);
@@ -72,9 +70,6 @@ Bool XCheckTypedEvent (
 		_XFlush(dpy);
 		break;
 	    }
-	    if (prev && prev->qserial_num != qe_serial)
-		/* another thread has snatched this event */
-		prev = NULL;
 	}
 	UnlockDisplay(dpy);
 	return False;
@@ -28,6 +28,7 @@ in this Software without prior written authorization from The Open Group.
 #include <config.h>
 #endif
 #include "Xlibint.h"
+#include "Xprivate.h"
 
 /*
  * Check existing events in queue to find if any match.  If so, return.
@@ -41,8 +42,7 @@ Bool XCheckTypedWindowEvent (
 	int type,		/* Selected event type. */
 	register XEvent *event)	/* XEvent to be filled in. */
 {
-	register _XQEvent *prev, *qelt;
-	unsigned long qe_serial = 0;
+	register _XQEvent *qelt;
 	int n;			/* time through count */
 
         LockDisplay(dpy);
@@ -50,22 +50,20 @@ Bool XCheckTypedWindowEvent (
 	/* Delete unclaimed cookies */
 	_XFreeEventCookies(dpy);
 
-	prev = NULL;
 	for (n = 3; --n >= 0;) {
-	    for (qelt = prev ? prev->next : dpy->head;
+	    /* Only events for windows that hash like this one need looking at. */
+	    for (qelt = dpy->qindex->window_head[XQ_WINDOW_LIST(w)];
 		 qelt;
-		 prev = qelt, qelt = qelt->next) {
+		 qelt = qelt->window_next) {
 		if ((qelt->event.xany.window == w) &&
 		    (qelt->event.type == type)) {
 		    *event = qelt->event;
-		    _XDeq(dpy, prev, qelt);
+		    _XDeq(dpy, qelt->prev, qelt);
 		    _XStoreEventCookie(dpy, event);
 		    UnlockDisplay(dpy);
 		    return True;
 		}
 	    }
-	    if (prev)
-		qe_serial = prev->qserial_num;
 	    switch (n) {
 	      case 2:
 		_XEventsQueued(dpy, QueuedAfterReading);
@@ -74,9 +72,6 @@ Bool XCheckTypedWindowEvent (
 		_XFlush(dpy);
 		break;
 	    }
-	    if (prev && prev->qserial_num != qe_serial)
-		/* another thread has snatched this event */
-		prev = NULL;
 	}
 	UnlockDisplay(dpy);
 	return False;
@@ -28,6 +28,7 @@ in this Software without prior written authorization from The Open Group.
 #include <config.h>
 #endif
 #include "Xlibint.h"
+#include "Xprivate.h"
 
 extern long const _Xevent_to_mask[];
 #define AllPointers (PointerMotionMask|PointerMotionHintMask|ButtonMotionMask)
@@ -46,8 +47,7 @@ Bool XCheckWindowEvent (
 	long mask,		/* Selected event mask. */
 	register XEvent *event)	/* XEvent to be filled in. */
 {
- 	register _XQEvent *prev, *qelt;
-	unsigned long qe_serial = 0;
+ 	register _XQEvent *qelt;
 	int n;			/* time through count */
 
         LockDisplay(dpy);
@@ -55,11 +55,11 @@ Bool XCheckWindowEvent (
 	/* Delete unclaimed cookies */
 	_XFreeEventCookies(dpy);
 
-	prev = NULL;
 	for (n = 3; --n >= 0;) {
-	    for (qelt = prev ? prev->next : dpy->head;
+	    /* Only events for windows that hash like this one need looking at. */
+	    for (qelt = dpy->qindex->window_head[XQ_WINDOW_LIST(w)];
 		 qelt;
-		 prev = qelt, qelt = qelt->next) {
+		 qelt = qelt->window_next) {
 		if ((qelt->event.xany.window == w) &&
 		    (qelt->event.type < GenericEvent) &&
 		    (_Xevent_to_mask[qelt->event.type] & mask) &&
@@ -67,13 +67,11 @@ Bool XCheckWindowEvent (
 		     (mask & AllPointers) ||
 		     (mask & AllButtons & qelt->event.xmotion.state))) {
 		    *event = qelt->event;
-		    _XDeq(dpy, prev, qelt);
+		    _XDeq(dpy, qelt->prev, qelt);
 		    UnlockDisplay(dpy);
 		    return True;
 		}
 	    }
-	    if (prev)
-		qe_serial = prev->qserial_num;
 	    switch (n) {
 	      case 2:
 		_XEventsQueued(dpy, QueuedAfterReading);
@@ -82,9 +80,6 @@ Bool XCheckWindowEvent (
 		_XFlush(dpy);
 		break;
 	    }
-	    if (prev && prev->qserial_num != qe_serial)
-		/* another thread has snatched this event */
-		prev = NULL;
 	}
 	UnlockDisplay(dpy);
 	return False;
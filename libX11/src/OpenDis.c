@@ -34,6 +34,7 @@ in this Software without prior written authorization from The Open Group.
 #include <stdio.h>
 #include <unistd.h>
 #include "Xintconn.h"
+#include "Xprivate.h"
 
 #ifdef XKB
 #include "XKBlib.h"
@@ -245,6 +246,10 @@ XOpenDisplay (
 	/* Set up the input event queue and input event queue parameters. */
 	dpy->head = dpy->tail = NULL;
 	dpy->qlen = 0;
+	if ((dpy->qindex = Xcalloc(1, sizeof(struct _XQIndex))) == NULL) {
+	    OutOfMemory (dpy);
+	    return(NULL);
+	}
 
 	/* Set up free-function record */
 	if ((dpy->free_funcs = Xcalloc(1, sizeof(_XFreeFuncRec))) == NULL) {
@@ -493,6 +498,11 @@ XOpenDisplay (
 	    return(NULL);
 	}
 
+/*
+ * ask about the common extensions, answered along with BIG-REQUESTS
+ */
+	_XPrefetchExtensions(dpy);
+
 /*
  * get availability of large requests
  */
@@ -691,6 +701,7 @@ void _XFreeDisplayStructure(Display *dpy)
 	}
 
 	Xfree (dpy->filedes);
+	Xfree (dpy->qindex);
 
 	_XFreeX11XCBStructure(dpy);
 
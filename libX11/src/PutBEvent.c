@@ -31,6 +31,7 @@ from The Open Group.
 #include <config.h>
 #endif
 #include "Xlibint.h"
+#include "Xprivate.h"
 
 int
 _XPutBackEvent (
@@ -64,12 +65,8 @@ _XPutBackEvent (
 	qelt = dpy->qfree;
 	dpy->qfree = qelt->next;
 	qelt->qserial_num = dpy->next_event_serial_num++;
-	qelt->next = dpy->head;
 	qelt->event = store;
-	dpy->head = qelt;
-	if (dpy->tail == NULL)
-	    dpy->tail = qelt;
-	dpy->qlen++;
+	_XQLink(dpy, qelt, True);
 	return 0;
 	}
 
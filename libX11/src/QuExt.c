@@ -28,6 +28,37 @@ in this Software without prior written authorization from The Open Group.
 #include <config.h>
 #endif
 #include "Xlibint.h"
+#include "Xxcbint.h"
+#include <xcb/xcbext.h>
+
+/*
+ * Extensions most clients, or the toolkits under them, look for right
+ * after connecting.  XOpenDisplay has xcb ask about all of them at once,
+ * so that instead of a round trip each, they are answered together with
+ * the BIG-REQUESTS query it has to wait for anyway.
+ */
+static xcb_extension_t _XPrefetchedExtensions[] = {
+    { "XKEYBOARD", 0 },
+    { "RENDER", 0 },
+    { "XInputExtension", 0 },
+    { "Generic Event Extension", 0 },
+    { "RANDR", 0 },
+    { "XFIXES", 0 },
+    { "SHAPE", 0 },
+    { "MIT-SHM", 0 }
+};
+
+void
+_XPrefetchExtensions(
+    Display *dpy)
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(_XPrefetchedExtensions) /
+		    sizeof(_XPrefetchedExtensions[0]); i++)
+	xcb_prefetch_extension_data(dpy->xcb->connection,
+				    &_XPrefetchedExtensions[i]);
+}
 
 Bool
 XQueryExtension(
@@ -39,6 +70,24 @@ XQueryExtension(
 {
     xQueryExtensionReply rep;
     register xQueryExtensionReq *req;
+    unsigned int i;
+
+    /* Not under the display lock: xcb may need to take the socket back */
+    for (i = 0; name && i < sizeof(_XPrefetchedExtensions) /
+			    sizeof(_XPrefetchedExtensions[0]); i++) {
+	if (!strcmp(name, _XPrefetchedExtensions[i].name)) {
+	    const xcb_query_extension_reply_t *ext;
+
+	    ext = xcb_get_extension_data(dpy->xcb->connection,
+					 &_XPrefetchedExtensions[i]);
+	    if (!ext)
+		break;
+	    *major_opcode = ext->major_opcode;
+	    *first_event = ext->first_event;
+	    *first_error = ext->first_error;
+	    return (ext->present);
+	}
+    }
 
     LockDisplay(dpy);
     GetReq(QueryExtension, req);
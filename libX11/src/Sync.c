@@ -28,6 +28,7 @@ in this Software without prior written authorization from The Open Group.
 #include <config.h>
 #endif
 #include "Xlibint.h"
+#include "Xprivate.h"
 
 /* Synchronize with errors and events, optionally discarding pending events */
 
@@ -53,6 +54,7 @@ XSync (
        dpy->qfree = (_XQEvent *)dpy->head;
        dpy->head = dpy->tail = NULL;
        dpy->qlen = 0;
+       _XQClear(dpy);
     }
     UnlockDisplay(dpy);
     return 1;
@@ -743,6 +743,71 @@ _XCopyEventCookie(Display *dpy, XGenericEventCookie *in, XGenericEventCookie *ou
 }
 
 
+/*
+ * _XQLink - Put an element at the back (or front) of the display's
+ * queue and of the type and window lists kept alongside it.
+ */
+void _XQLink(
+	Display *dpy,
+	_XQEvent *qelt,
+	Bool front)
+{
+	struct _XQIndex *qindex = dpy->qindex;
+	int t = XQ_TYPE_LIST(qelt->event.type);
+	int w = XQ_WINDOW_LIST(qelt->event.xany.window);
+
+	qelt->type_list = t;
+	qelt->window_list = w;
+	if (front) {
+	    qelt->prev = NULL;
+	    qelt->next = dpy->head;
+	    if (dpy->head)	dpy->head->prev = qelt;
+	    else		dpy->tail = qelt;
+	    dpy->head = qelt;
+
+	    qelt->type_prev = NULL;
+	    qelt->type_next = qindex->type_head[t];
+	    if (qelt->type_next) qelt->type_next->type_prev = qelt;
+	    else		 qindex->type_tail[t] = qelt;
+	    qindex->type_head[t] = qelt;
+
+	    qelt->window_prev = NULL;
+	    qelt->window_next = qindex->window_head[w];
+	    if (qelt->window_next) qelt->window_next->window_prev = qelt;
+	    else		   qindex->window_tail[w] = qelt;
+	    qindex->window_head[w] = qelt;
+	} else {
+	    qelt->next = NULL;
+	    qelt->prev = dpy->tail;
+	    if (dpy->tail)	dpy->tail->next = qelt;
+	    else		dpy->head = qelt;
+	    dpy->tail = qelt;
+
+	    qelt->type_next = NULL;
+	    qelt->type_prev = qindex->type_tail[t];
+	    if (qelt->type_prev) qelt->type_prev->type_next = qelt;
+	    else		 qindex->type_head[t] = qelt;
+	    qindex->type_tail[t] = qelt;
+
+	    qelt->window_next = NULL;
+	    qelt->window_prev = qindex->window_tail[w];
+	    if (qelt->window_prev) qelt->window_prev->window_next = qelt;
+	    else		   qindex->window_head[w] = qelt;
+	    qindex->window_tail[w] = qelt;
+	}
+	dpy->qlen++;
+}
+
+/*
+ * _XQClear - Forget the type and window lists once the whole queue
+ * has been thrown away.
+ */
+void _XQClear(
+	Display *dpy)
+{
+	memset(dpy->qindex, 0, sizeof(struct _XQIndex));
+}
+
 /*
  * _XEnq - Place event packets on the display's queue.
  * note that no squishing of move events in V11, since there
@@ -784,18 +849,10 @@ void _XEnq(
 	    cookie->cookie = ++dpy->next_cookie;
 
 	    qelt->qserial_num = dpy->next_event_serial_num++;
-	    if (dpy->tail)	dpy->tail->next = qelt;
-	    else		dpy->head = qelt;
-
-	    dpy->tail = qelt;
-	    dpy->qlen++;
+	    _XQLink(dpy, qelt, False);
 	} else if ((*dpy->event_vec[type])(dpy, &qelt->event, event)) {
 	    qelt->qserial_num = dpy->next_event_serial_num++;
-	    if (dpy->tail)	dpy->tail->next = qelt;
-	    else 		dpy->head = qelt;
-
-	    dpy->tail = qelt;
-	    dpy->qlen++;
+	    _XQLink(dpy, qelt, False);
 	} else {
 	    /* ignored, or stashed away for many-to-one compression */
 	    qelt->next = dpy->qfree;
@@ -811,14 +868,36 @@ void _XDeq(
     register _XQEvent *prev,	/* element before qelt */
     register _XQEvent *qelt)	/* element to be unlinked */
 {
-    if (prev) {
-	if ((prev->next = qelt->next) == NULL)
-	    dpy->tail = prev;
-    } else {
+    struct _XQIndex *qindex = dpy->qindex;
+
+    if (prev)
+	prev->next = qelt->next;
+    else
 	/* no prev, so removing first elt */
-	if ((dpy->head = qelt->next) == NULL)
-	    dpy->tail = NULL;
-    }
+	dpy->head = qelt->next;
+    if (qelt->next)
+	qelt->next->prev = prev;
+    else
+	dpy->tail = prev;
+
+    if (qelt->type_prev)
+	qelt->type_prev->type_next = qelt->type_next;
+    else
+	qindex->type_head[qelt->type_list] = qelt->type_next;
+    if (qelt->type_next)
+	qelt->type_next->type_prev = qelt->type_prev;
+    else
+	qindex->type_tail[qelt->type_list] = qelt->type_prev;
+
+    if (qelt->window_prev)
+	qelt->window_prev->window_next = qelt->window_next;
+    else
+	qindex->window_head[qelt->window_list] = qelt->window_next;
+    if (qelt->window_next)
+	qelt->window_next->window_prev = qelt->window_prev;
+    else
+	qindex->window_tail[qelt->window_list] = qelt->window_prev;
+
     qelt->qserial_num = 0;
     qelt->next = dpy->qfree;
     dpy->qfree = qelt;
@@ -15,6 +15,27 @@ extern _X_HIDDEN void _XSeqSyncFunction(Display *dpy);
 extern _X_HIDDEN void _XSetPrivSyncFunction(Display *dpy);
 extern _X_HIDDEN void _XSetSeqSyncFunction(Display *dpy);
 
+/*
+ * Every queued event is also kept on a list of the events with the same
+ * type and on one of XQ_WINDOW_LISTS lists of events for windows that hash
+ * alike, both in queue order, so XCheckTypedEvent and friends don't have
+ * to walk the whole queue looking for a match.
+ */
+#define XQ_TYPE_LISTS 128
+#define XQ_WINDOW_LISTS 64
+#define XQ_TYPE_LIST(t) ((t) & (XQ_TYPE_LISTS - 1))
+#define XQ_WINDOW_LIST(w) (((w) ^ ((w) >> 6) ^ ((w) >> 12)) & (XQ_WINDOW_LISTS - 1))
+
+struct _XQIndex {
+    struct _XSQEvent *type_head[XQ_TYPE_LISTS];
+    struct _XSQEvent *type_tail[XQ_TYPE_LISTS];
+    struct _XSQEvent *window_head[XQ_WINDOW_LISTS];
+    struct _XSQEvent *window_tail[XQ_WINDOW_LISTS];
+};
+
+extern _X_HIDDEN void _XQLink(Display *dpy, struct _XSQEvent *qelt, Bool front);
+extern _X_HIDDEN void _XQClear(Display *dpy);
+
 #ifdef XTHREADS
 #if defined(XTHREADS_WARN) || defined(XTHREADS_FILE_LINE)
 #define InternalLockDisplay(d,wskip) if ((d)->lock) \
@@ -181,10 +181,30 @@ typedef struct _LTable {
  * XrmSearchList, which is a complete crock, but we'll just leave it
  * and caste types as required.
  */
+/* A search list XrmQGetSearchList has already found for a names/classes
+ * pair.  Xt asks for the same lists over and over, once for every widget
+ * it creates along the same path and again for each subresource lookup.
+ * The quarks (names, then classes) and the list are right after the
+ * structure.  Since the list points into the database's tables, the
+ * cache is thrown away whenever the database is changed.
+ */
+typedef struct _SCache {
+    struct _SCache	*next;		/* next most recently used */
+    int			depth;		/* number of names */
+    int			length;		/* list entries, without the NULL */
+} SCacheRec, *SCache;
+
+#define SCacheQuarks(sc) ((XrmQuark *)((sc) + 1))
+#define SCacheList(sc) ((LTable *)(SCacheQuarks(sc) + ((sc)->depth << 1)))
+
+/* most search lists kept for one database */
+#define MAXSCACHE 16
+
 typedef struct _XrmHashBucketRec {
     NTable table;
     XPointer mbstate;
     XrmMethods methods;
+    SCache scache;
 #ifdef XTHREADS
     LockInfoRec linfo;
 #endif
@@ -500,6 +520,7 @@ static XrmDatabase NewDatabase(void)
 	_XCreateMutex(&db->linfo);
 	db->table = (NTable)NULL;
 	db->mbstate = (XPointer)NULL;
+	db->scache = (SCache)NULL;
 	db->methods = _XrmInitParseInfo(&db->mbstate);
 	if (!db->methods)
 	    db->methods = &mb_methods;
@@ -507,6 +528,19 @@ static XrmDatabase NewDatabase(void)
     return db;
 }
 
+/* forget every search list found in the database */
+static void FlushSearchCache(
+    XrmDatabase db)
+{
+    register SCache sc, next;
+
+    for (sc = db->scache; sc; sc = next) {
+	next = sc->next;
+	Xfree(sc);
+    }
+    db->scache = (SCache)NULL;
+}
+
 /* move all values from ftable to ttable, and free ftable's buckets.
  * ttable is guaranteed empty to start with.
  */
@@ -768,7 +802,9 @@ void XrmCombineDatabase(
     } else if (from) {
 	_XLockMutex(&from->linfo);
 	_XLockMutex(&(*into)->linfo);
+	FlushSearchCache(from);
 	if ((ftable = from->table)) {
+	    FlushSearchCache(*into);
 	    prev = &(*into)->table;
 	    ttable = *prev;
 	    if (!ftable->leaf) {
@@ -853,6 +889,7 @@ static void PutEntry(
 
     if (!db || !*quarks)
 	return;
+    FlushSearchCache(db);
     table = *(prev = &db->table);
     /* if already at leaf, bump to the leaf table */
     if (!quarks[1] && table && !table->leaf)
@@ -2252,6 +2289,85 @@ static Bool SearchNEntry(
     return False;
 }
 
+/* look for the search list of names and classes in the cache, and move
+ * it to the front.  Returns the number of entries copied into list, -1
+ * if it is not there, or -2 if it is there but list is too short.
+ */
+static int GetCachedSearchList(
+    XrmDatabase		db,
+    XrmNameList		names,
+    XrmClassList	classes,
+    LTable		*list,
+    int			listLength)
+{
+    register SCache	sc, *prev;
+    register XrmQuark	*quarks;
+    register int	i, depth;
+
+    for (depth = 0; names[depth]; depth++)
+	;
+    for (prev = &db->scache; (sc = *prev); prev = &sc->next) {
+	if (sc->depth != depth)
+	    continue;
+	quarks = SCacheQuarks(sc);
+	for (i = 0; i < depth; i++) {
+	    if (quarks[i] != names[i] || quarks[depth + i] != classes[i])
+		break;
+	}
+	if (i == depth)
+	    break;
+    }
+    if (!sc)
+	return -1;
+    if (prev != &db->scache) {
+	*prev = sc->next;
+	sc->next = db->scache;
+	db->scache = sc;
+    }
+    if (sc->length > listLength - 1)
+	return -2;
+    memcpy(list, SCacheList(sc), sc->length * sizeof(LTable));
+    return sc->length;
+}
+
+/* remember a search list just found, dropping the least recently used
+ * one if the cache is full */
+static void CacheSearchList(
+    XrmDatabase		db,
+    XrmNameList		names,
+    XrmClassList	classes,
+    LTable		*list,
+    int			length)
+{
+    register SCache	sc, *prev;
+    register XrmQuark	*quarks;
+    register int	i, depth, count;
+
+    for (depth = 0; names[depth]; depth++)
+	;
+    for (count = 1, prev = &db->scache; *prev; prev = &(*prev)->next) {
+	if (++count > MAXSCACHE) {
+	    Xfree(*prev);
+	    *prev = (SCache)NULL;
+	    break;
+	}
+    }
+    sc = Xmalloc(sizeof(SCacheRec) + ((depth << 1) * sizeof(XrmQuark)) +
+		 (length * sizeof(LTable)));
+    if (!sc)
+	return;
+    sc->depth = depth;
+    sc->length = length;
+    quarks = SCacheQuarks(sc);
+    for (i = 0; i < depth; i++) {
+	quarks[i] = names[i];
+	quarks[depth + i] = classes[i];
+    }
+    memcpy(SCacheList(sc), list, length * sizeof(LTable));
+    sc->next = db->scache;
+    db->scache = sc;
+}
+
 Bool XrmQGetSearchList(
     XrmDatabase     db,
     XrmNameList	    names,
@@ -2261,6 +2377,7 @@ Bool XrmQGetSearchList(
 {
     register NTable	table;
     SClosureRec		closure;
+    int			cached;
 
     if (listLength <= 0)
 	return False;
@@ -2269,6 +2386,17 @@ Bool XrmQGetSearchList(
     closure.limit = listLength - 2;
     if (db) {
 	_XLockMutex(&db->linfo);
+	cached = GetCachedSearchList(db, names, classes, closure.list,
+				     listLength);
+	if (cached == -2) {
+	    _XUnlockMutex(&db->linfo);
+	    return False;
+	}
+	if (cached >= 0) {
+	    _XUnlockMutex(&db->linfo);
+	    closure.list[cached] = (LTable)NULL;
+	    return True;
+	}
 	table = db->table;
 	if (*names) {
 	    if (table && !table->leaf) {
@@ -2291,6 +2419,7 @@ Bool XrmQGetSearchList(
 		return False;
 	    }
 	}
+	CacheSearchList(db, names, classes, closure.list, closure.idx + 1);
 	_XUnlockMutex(&db->linfo);
     }
     closure.list[closure.idx + 1] = (LTable)NULL;
@@ -2651,6 +2780,7 @@ void XrmDestroyDatabase(
 
     if (db) {
 	_XLockMutex(&db->linfo);
+	FlushSearchCache(db);
 	for (next = db->table; (table = next); ) {
 	    next = table->next;
 	    if (table->leaf)
@@ -49,4 +49,9 @@ void _XFreeX11XCBStructure(Display *dpy);
 _X_HIDDEN
 unsigned long _XNextRequest(Display *dpy);
 
+/* QuExt.c */
+
+_X_HIDDEN
+void _XPrefetchExtensions(Display *dpy);
+
 #endif /* XXCBINT_H */
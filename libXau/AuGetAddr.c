@@ -29,6 +29,7 @@ in this Software without prior written authorization from The Open Group.
 #endif
 #include <X11/Xauth.h>
 #include <X11/Xos.h>
+#include "Xauint.h"
 
 #define binaryEqual(a, b, len) (memcmp(a, b, len) == 0)
 
@@ -55,22 +56,21 @@ unsigned short	name_length,
 #endif
 _Xconst char*	name)
 {
-    FILE    *auth_file;
     char    *auth_name;
-    Xauth   *entry;
+    char    *buf;
+    size_t  size, offset = 0;
+    Xauth   entry;
+    Xauth   *ret = NULL;
 
     auth_name = XauFileName ();
     if (!auth_name)
 	return NULL;
     if (access (auth_name, R_OK) != 0)		/* checks REAL id */
 	return NULL;
-    auth_file = fopen (auth_name, "rb");
-    if (!auth_file)
+    buf = _XauReadAuthFile (auth_name, &size);
+    if (!buf)
 	return NULL;
-    for (;;) {
-	entry = XauReadAuth (auth_file);
-	if (!entry)
-	    break;
+    while (_XauNextAuth (buf, size, &offset, &entry)) {
 	/*
 	 * Match when:
 	 *   either family or entry->family are FamilyWild or
@@ -84,19 +84,20 @@ _Xconst char*	name)
 	 *    name and entry->name are the same
 	 */
 
-	if ((family == FamilyWild || entry->family == FamilyWild ||
-	     (entry->family == family &&
-	      address_length == entry->address_length &&
-	      binaryEqual (entry->address, address, address_length))) &&
-	    (number_length == 0 || entry->number_length == 0 ||
-	     (number_length == entry->number_length &&
-	      binaryEqual (entry->number, number, number_length))) &&
-	    (name_length == 0 || entry->name_length == 0 ||
-	     (entry->name_length == name_length &&
-	      binaryEqual (entry->name, name, name_length))))
+	if ((family == FamilyWild || entry.family == FamilyWild ||
+	     (entry.family == family &&
+	      address_length == entry.address_length &&
+	      binaryEqual (entry.address, address, address_length))) &&
+	    (number_length == 0 || entry.number_length == 0 ||
+	     (number_length == entry.number_length &&
+	      binaryEqual (entry.number, number, number_length))) &&
+	    (name_length == 0 || entry.name_length == 0 ||
+	     (entry.name_length == name_length &&
+	      binaryEqual (entry.name, name, name_length)))) {
+	    ret = _XauCopyAuth (&entry);
 	    break;
-	XauDisposeAuth (entry);
+	}
     }
-    (void) fclose (auth_file);
-    return entry;
+    _XauFreeAuthFile (buf, size);
+    return ret;
 }
@@ -37,6 +37,7 @@ in this Software without prior written authorization from The Open Group.
 #define XOS_USE_NO_LOCKING
 #include <X11/Xos_r.h>
 #endif
+#include "Xauint.h"
 
 #define binaryEqual(a, b, len) (memcmp(a, b, len) == 0)
 
@@ -60,10 +61,13 @@ XauGetBestAuthByAddr (
     char**		types,
     _Xconst int*	type_lengths)
 {
-    FILE    *auth_file;
     char    *auth_name;
-    Xauth   *entry;
-    Xauth   *best;
+    char    *buf;
+    size_t  size, offset = 0;
+    Xauth   entry;
+    Xauth   best;
+    Xauth   *ret;
+    int	    found;
     int	    best_type;
     int	    type;
 #ifdef hpux
@@ -76,8 +80,8 @@ XauGetBestAuthByAddr (
 	return NULL;
     if (access (auth_name, R_OK) != 0)		/* checks REAL id */
 	return NULL;
-    auth_file = fopen (auth_name, "rb");
-    if (!auth_file)
+    buf = _XauReadAuthFile (auth_name, &size);
+    if (!buf)
 	return NULL;
 
 #ifdef hpux
@@ -100,12 +104,9 @@ XauGetBestAuthByAddr (
     }
 #endif /* hpux */
 
-    best = NULL;
+    found = 0;
     best_type = types_length;
-    for (;;) {
-	entry = XauReadAuth (auth_file);
-	if (!entry)
-	    break;
+    while (_XauNextAuth (buf, size, &offset, &entry)) {
 	/*
 	 * Match when:
 	 *   either family or entry->family are FamilyWild or
@@ -119,45 +120,44 @@ XauGetBestAuthByAddr (
 	 *    name and entry->name are the same
 	 */
 
-	if ((family == FamilyWild || entry->family == FamilyWild ||
-	     (entry->family == family &&
-	     ((address_length == entry->address_length &&
-	      binaryEqual (entry->address, address, address_length))
+	if ((family == FamilyWild || entry.family == FamilyWild ||
+	     (entry.family == family &&
+	     ((address_length == entry.address_length &&
+	      binaryEqual (entry.address, address, address_length))
 #ifdef hpux
 	     || (family == FamilyLocal &&
-		fully_qual_address_length == entry->address_length &&
-	     	binaryEqual (entry->address, fully_qual_address,
+		fully_qual_address_length == entry.address_length &&
+	     	binaryEqual (entry.address, fully_qual_address,
 		    fully_qual_address_length))
 #endif
 	    ))) &&
-	    (number_length == 0 || entry->number_length == 0 ||
-	     (number_length == entry->number_length &&
-	      binaryEqual (entry->number, number, number_length))))
+	    (number_length == 0 || entry.number_length == 0 ||
+	     (number_length == entry.number_length &&
+	      binaryEqual (entry.number, number, number_length))))
 	{
 	    if (best_type == 0)
 	    {
 		best = entry;
+		found = 1;
 		break;
 	    }
 	    for (type = 0; type < best_type; type++)
-		if (type_lengths[type] == entry->name_length &&
-		    !(strncmp (types[type], entry->name, entry->name_length)))
+		if (type_lengths[type] == entry.name_length &&
+		    !(strncmp (types[type], entry.name, entry.name_length)))
 		{
 		    break;
 		}
 	    if (type < best_type)
 	    {
-		if (best)
-		    XauDisposeAuth (best);
 		best = entry;
+		found = 1;
 		best_type = type;
 		if (type == 0)
 		    break;
-		continue;
 	    }
 	}
-	XauDisposeAuth (entry);
     }
-    (void) fclose (auth_file);
-    return best;
+    ret = found ? _XauCopyAuth (&best) : NULL;
+    _XauFreeAuthFile (buf, size);
+    return ret;
 }
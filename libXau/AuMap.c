@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * XauGetAuthByAddr and XauGetBestAuthByAddr used to read every entry of
+ * the authority file with XauReadAuth, allocating five blocks for each
+ * just to look at it and throw it away.  Instead the file is now read in
+ * one go, the entries are matched where they are in that buffer, and
+ * only the one returned is copied out.
+ *
+ * The file is read rather than mapped: tools which rewrite it in place
+ * would otherwise make every client with a mapping of it fault when it
+ * shrinks underneath them.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <X11/Xauth.h>
+#include <X11/Xos.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include "Xauint.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * Read all of file_name, returning NULL if it can't be.  An empty file
+ * is returned as a buffer of size 0.
+ */
+char *
+_XauReadAuthFile (_Xconst char *file_name, size_t *size_return)
+{
+    struct stat statb;
+    size_t size, got;
+    char *buf;
+    int fd, n;
+
+    fd = open (file_name, O_RDONLY | O_BINARY);
+    if (fd == -1)
+	return NULL;
+    if (fstat (fd, &statb) == -1 || statb.st_size < 0 ||
+	(off_t) (size_t) statb.st_size != statb.st_size) {
+	(void) close (fd);
+	return NULL;
+    }
+    size = (size_t) statb.st_size;
+    buf = malloc (size ? size : 1);
+    if (!buf) {
+	(void) close (fd);
+	return NULL;
+    }
+    /* whatever is there when we read, if it changes size meanwhile */
+    for (got = 0; got < size; got += n) {
+	n = read (fd, buf + got, (unsigned) (size - got));
+	if (n <= 0)
+	    break;
+    }
+    (void) close (fd);
+    *size_return = got;
+    return buf;
+}
+
+void
+_XauFreeAuthFile (char *buf, size_t size)
+{
+    if (buf) {
+	(void) bzero (buf, size);
+	free (buf);
+    }
+}
+
+static int
+next_counted_string (_Xconst char *buf, size_t size, size_t *offset,
+		     unsigned short *countp, char **stringp)
+{
+    unsigned short len;
+
+    if (size - *offset < 2)
+	return 0;
+    len = (unsigned char) buf[*offset] * 256 +
+	  (unsigned char) buf[*offset + 1];
+    *offset += 2;
+    if (size - *offset < len)
+	return 0;
+    *stringp = len ? (char *) buf + *offset : NULL;
+    *countp = len;
+    *offset += len;
+    return 1;
+}
+
+/*
+ * Parse the entry at *offset in buf, the same way XauReadAuth would read
+ * it from a file, and move *offset past it.  The strings of entry point
+ * into buf.  Returns 0 at the end of the file, or if the entry there is
+ * cut short.
+ */
+int
+_XauNextAuth (_Xconst char *buf, size_t size, size_t *offset, Xauth *entry)
+{
+    size_t pos = *offset;
+
+    if (size - pos < 2)
+	return 0;
+    entry->family = (unsigned char) buf[pos] * 256 +
+		    (unsigned char) buf[pos + 1];
+    pos += 2;
+    if (!next_counted_string (buf, size, &pos,
+			      &entry->address_length, &entry->address) ||
+	!next_counted_string (buf, size, &pos,
+			      &entry->number_length, &entry->number) ||
+	!next_counted_string (buf, size, &pos,
+			      &entry->name_length, &entry->name) ||
+	!next_counted_string (buf, size, &pos,
+			      &entry->data_length, &entry->data))
+	return 0;
+    *offset = pos;
+    return 1;
+}
+
+static int
+copy_counted_string (unsigned short len, _Xconst char *from, char **stringp)
+{
+    if (len == 0) {
+	*stringp = NULL;
+	return 1;
+    }
+    *stringp = malloc ((unsigned) len);
+    if (!*stringp)
+	return 0;
+    memcpy (*stringp, from, len);
+    return 1;
+}
+
+/*
+ * Copy an entry _XauNextAuth found into storage of its own, which
+ * XauDisposeAuth frees
+ */
+Xauth *
+_XauCopyAuth (_Xconst Xauth *entry)
+{
+    Xauth *ret;
+
+    ret = (Xauth *) calloc (1, sizeof (Xauth));
+    if (!ret)
+	return NULL;
+    ret->family = entry->family;
+    ret->address_length = entry->address_length;
+    ret->number_length = entry->number_length;
+    ret->name_length = entry->name_length;
+    ret->data_length = entry->data_length;
+    if (!copy_counted_string (entry->address_length, entry->address,
+			      &ret->address) ||
+	!copy_counted_string (entry->number_length, entry->number,
+			      &ret->number) ||
+	!copy_counted_string (entry->name_length, entry->name,
+			      &ret->name) ||
+	!copy_counted_string (entry->data_length, entry->data,
+			      &ret->data)) {
+	XauDisposeAuth (ret);
+	return NULL;
+    }
+    return ret;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Reading a whole authority file at once, for the lookup functions
+ */
+
+#ifndef _XAUINT_H_
+#define _XAUINT_H_
+
+#include <X11/Xauth.h>
+#include <stddef.h>
+
+extern char *_XauReadAuthFile(_Xconst char *file_name, size_t *size_return);
+
+extern void _XauFreeAuthFile(char *buf, size_t size);
+
+extern int _XauNextAuth(_Xconst char *buf, size_t size, size_t *offset,
+			Xauth *entry);
+
+extern Xauth *_XauCopyAuth(_Xconst Xauth *entry);
+
+#endif /* _XAUINT_H_ */
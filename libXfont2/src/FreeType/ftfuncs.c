@@ -137,6 +137,11 @@ FT_Library ftypeLibrary;
 
 static FTFacePtr faceTable[NUMFACEBUCKETS];
 
+/* Instances released by their last font, most recently released first */
+static FTInstancePtr retainedInstances = NULL;
+static int numRetainedInstances = 0;
+static unsigned long retainedBytes = 0;
+
 static unsigned
 hash(char *string)
 {
@@ -407,6 +412,8 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
     }
     if(otherInstance) {
         MUMBLE("Returning cached instance\n");
+        if(otherInstance->refcount <= 0)
+            FreeTypeUnretainInstance(otherInstance);
         otherInstance->refcount++;
         *instance_return = otherInstance;
         return Successful;
@@ -435,6 +442,8 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
     instance->bmfmt = *bmfmt;
     instance->glyphs = NULL;
     instance->available = NULL;
+    instance->cachedBytes = 0;
+    instance->nextRetained = NULL;
 
     if( 0 <= tmp_ttcap->forceConstantSpacingEnd )
 	instance->nglyphs = 2 * instance->face->face->num_glyphs;
@@ -537,60 +546,116 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
 }
 
 static void
-FreeTypeFreeInstance(FTInstancePtr instance)
+FreeTypeDestroyInstance(FTInstancePtr instance)
 {
     FTInstancePtr otherInstance;
-
-    if( instance == NULL ) return;
+    int i,j;
 
     if(instance->face->active_instance == instance)
         instance->face->active_instance = NULL;
-    instance->refcount--;
-    if(instance->refcount <= 0) {
-        int i,j;
-
-        if(instance->face->instances == instance)
-            instance->face->instances = instance->next;
-        else {
-            for(otherInstance = instance->face->instances;
-                otherInstance;
-                otherInstance = otherInstance->next)
-                if(otherInstance->next == instance) {
-                    otherInstance->next = instance->next;
-                    break;
-                }
-        }
+    if(instance->face->instances == instance)
+        instance->face->instances = instance->next;
+    else {
+        for(otherInstance = instance->face->instances;
+            otherInstance;
+            otherInstance = otherInstance->next)
+            if(otherInstance->next == instance) {
+                otherInstance->next = instance->next;
+                break;
+            }
+    }
 
-        FT_Done_Size(instance->size);
-        FreeTypeFreeFace(instance->face);
+    FT_Done_Size(instance->size);
+    FreeTypeFreeFace(instance->face);
 
-        if(instance->charcellMetrics) {
-            free(instance->charcellMetrics);
-        }
-        if(instance->forceConstantMetrics) {
-            free(instance->forceConstantMetrics);
-        }
-        if(instance->glyphs) {
-            for(i = 0; i < iceil(instance->nglyphs, FONTSEGMENTSIZE); i++) {
-                if(instance->glyphs[i]) {
-                    for(j = 0; j < FONTSEGMENTSIZE; j++) {
-                        if(instance->available[i][j] ==
-                           FT_AVAILABLE_RASTERISED)
-                            free(instance->glyphs[i][j].bits);
-                    }
-                    free(instance->glyphs[i]);
+    if(instance->charcellMetrics) {
+        free(instance->charcellMetrics);
+    }
+    if(instance->forceConstantMetrics) {
+        free(instance->forceConstantMetrics);
+    }
+    if(instance->glyphs) {
+        for(i = 0; i < iceil(instance->nglyphs, FONTSEGMENTSIZE); i++) {
+            if(instance->glyphs[i]) {
+                for(j = 0; j < FONTSEGMENTSIZE; j++) {
+                    if(instance->available[i][j] ==
+                       FT_AVAILABLE_RASTERISED)
+                        free(instance->glyphs[i][j].bits);
                 }
+                free(instance->glyphs[i]);
             }
-            free(instance->glyphs);
         }
-        if(instance->available) {
-            for(i = 0; i < iceil(instance->nglyphs, FONTSEGMENTSIZE); i++) {
-                if(instance->available[i])
-                    free(instance->available[i]);
-            }
-            free(instance->available);
+        free(instance->glyphs);
+    }
+    if(instance->available) {
+        for(i = 0; i < iceil(instance->nglyphs, FONTSEGMENTSIZE); i++) {
+            if(instance->available[i])
+                free(instance->available[i]);
         }
-        free(instance);
+        free(instance->available);
+    }
+    free(instance);
+}
+
+/* Take an instance off the retained list because a font uses it again */
+static void
+FreeTypeUnretainInstance(FTInstancePtr instance)
+{
+    FTInstancePtr *prev;
+
+    for(prev = &retainedInstances; *prev; prev = &(*prev)->nextRetained) {
+        if(*prev == instance) {
+            *prev = instance->nextRetained;
+            instance->nextRetained = NULL;
+            numRetainedInstances--;
+            retainedBytes -= instance->cachedBytes;
+            break;
+        }
+    }
+}
+
+/* Destroy the least recently released instances until the retained
+   list is back within its limits */
+static void
+FreeTypeTrimRetainedInstances(void)
+{
+    FTInstancePtr *prev, instance;
+
+    while(retainedInstances &&
+          (numRetainedInstances > FT_RETAINED_INSTANCES ||
+           retainedBytes > FT_RETAINED_BYTES)) {
+        prev = &retainedInstances;
+        while((*prev)->nextRetained)
+            prev = &(*prev)->nextRetained;
+        instance = *prev;
+        *prev = NULL;
+        numRetainedInstances--;
+        retainedBytes -= instance->cachedBytes;
+        MUMBLE("Discarding retained instance\n");
+        FreeTypeDestroyInstance(instance);
+    }
+}
+
+static void
+FreeTypeFreeInstance(FTInstancePtr instance)
+{
+    if( instance == NULL ) return;
+
+    if(instance->face->active_instance == instance)
+        instance->face->active_instance = NULL;
+    instance->refcount--;
+    if(instance->refcount <= 0) {
+        /* Keep the instance and its glyphs for the next font that asks
+           for the same face, size and transformation */
+        if(instance->cachedBytes > FT_RETAINED_BYTES) {
+            FreeTypeDestroyInstance(instance);
+            return;
+        }
+        instance->nextRetained = retainedInstances;
+        retainedInstances = instance;
+        numRetainedInstances++;
+        retainedBytes += instance->cachedBytes;
+        FreeTypeTrimRetainedInstances();
     }
 }
 
@@ -639,6 +704,8 @@ FreeTypeInstanceFindGlyph(unsigned idx_in, int flags, FTInstancePtr instance,
         (*glyphs)[segment] = malloc(sizeof(CharInfoRec) * FONTSEGMENTSIZE);
         if((*glyphs)[segment] == NULL)
             return AllocError;
+        instance->cachedBytes += (sizeof(CharInfoRec) + sizeof(int)) *
+                                 FONTSEGMENTSIZE;
     }
 
     *found = 1;
@@ -1367,6 +1434,7 @@ FreeTypeRasteriseGlyph(unsigned idx, int flags, CharInfoPtr tgp,
 	return AllocError;
 
     tgp->bits = raster;
+    instance->cachedBytes += ht * bpr;
 
     /* If FT_GET_DUMMY is set, we return white space. */
     if ( is_outline == -1 ) return Successful;
@@ -27,6 +27,11 @@ THE SOFTWARE.
 /* Glyphs are held in segments of this size */
 #define FONTSEGMENTSIZE 16
 
+/* Instances no longer used by any font are kept, with their rasterised
+   glyphs, until either of these server-wide limits is exceeded */
+#define FT_RETAINED_INSTANCES 16
+#define FT_RETAINED_BYTES (2 * 1024 * 1024)
+
 /* A structure that holds bitmap order and padding info. */
 
 typedef struct {
@@ -137,7 +142,9 @@ typedef struct _FTInstance {
     int **available;
     struct TTCapInfo ttcap;
     int refcount;
+    unsigned long cachedBytes;  /* glyph segments and bitmaps held */
     struct _FTInstance *next;   /* link to next instance */
+    struct _FTInstance *nextRetained; /* link in the retained LRU list */
 } FTInstanceRec, *FTInstancePtr;
 
 /* A font is an instance with coding information; fonts are in
@@ -164,6 +171,8 @@ FreeTypeOpenInstance(FTInstancePtr *instancep, FTFacePtr face,
                      int spacing, FontBitmapFormatPtr bmfmt,
 		     struct TTCapInfo *tmp_ttcap, FT_Int32 load_flags);
 static void FreeTypeFreeInstance(FTInstancePtr instance);
+static void FreeTypeDestroyInstance(FTInstancePtr instance);
+static void FreeTypeUnretainInstance(FTInstancePtr instance);
 static int
 FreeTypeInstanceGetGlyph(unsigned idx, int flags, CharInfoPtr *g, FTInstancePtr instance);
 static int
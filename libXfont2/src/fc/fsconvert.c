@@ -195,6 +195,9 @@ _fs_convert_lfwi_reply(FSFpePtr conn, FontInfoPtr pfi,
  * predicated on the belief that using a glyph increases the chances
  * that nearby glyphs will be used: a good assumption for phonetic
  * alphabets, but a questionable one for ideographic/pictographic ones.
+ * Fonts of a single row, which is what the fonts of phonetic alphabets
+ * mostly are, come in one go: there are at most 256 glyphs, and asking
+ * for them a few at a time only costs more round trips.
  */
 /* ARGSUSED */
 int
@@ -213,6 +216,7 @@ fs_build_range(FontPtr pfont, Bool range_flag, unsigned int count,
     register unsigned long row;
     register unsigned long col;
     register unsigned long loc;
+    unsigned long span;
 
     if (!fsd->glyphs_to_get)
 	return AccessDone;
@@ -222,6 +226,9 @@ fs_build_range(FontPtr pfont, Bool range_flag, unsigned int count,
     firstcol = pfi->firstCol;
     lastcol = pfi->lastCol;
 
+    /* the columns past the start of the span a glyph is loaded with */
+    span = firstrow == lastrow ? 0xff : 0xf;
+
     /* Make sure we have default char */
     if (fsfont->pDefault && ENCODING_UNDEFINED(fsfont->pDefault))
     {
@@ -248,13 +255,14 @@ fs_build_range(FontPtr pfont, Bool range_flag, unsigned int count,
 		GLYPH_UNDEFINED(col - firstcol))
 	    {
 		int col1, col2;
-		col1 = col & 0xf0;
-		col2 = col1 + 15;
+		col1 = col & ~span;
+		col2 = col1 + span;
 		if (col1 < firstcol) col1 = firstcol;
 		if (col2 > lastcol) col2 = lastcol;
 		/* Collect a 16-glyph neighborhood containing the requested
-		   glyph... should in most cases reduce the number of round
-		   trips to the font server. */
+		   glyph, or the whole row of a single row font... should in
+		   most cases reduce the number of round trips to the font
+		   server. */
 		for (col = col1; col <= col2; col++)
 		{
 		    if (!GLYPH_UNDEFINED(col - firstcol)) continue;
@@ -321,15 +329,16 @@ fs_build_range(FontPtr pfont, Bool range_flag, unsigned int count,
 		    if (GLYPH_UNDEFINED(loc))
 		    {
 			if (row1 == row2 &&
-			    (((col1 & 0xf) && col1 > firstcol) ||
-			     (col2 & 0xf) != 0xf) && (col2 < lastcol))
+			    (((col1 & span) && col1 > firstcol) ||
+			     (col2 & span) != span) && (col2 < lastcol))
 			{
 			    /* If we're loading from a single row, expand
 			       range of glyphs loaded to a multiple of
-			       a 16-glyph range -- attempt to reduce number
+			       a 16-glyph range, or to the whole row of a
+			       single row font -- attempt to reduce number
 			       of round trips to the font server. */
-			    col1 &= 0xf0;
-			    col2 = (col2 & 0xf0) + 15;
+			    col1 &= ~span;
+			    col2 = (col2 & ~span) + span;
 			    if (col1 < firstcol) col1 = firstcol;
 			    if (col2 > lastcol) col2 = lastcol;
 			    goto expand_glyph_range;
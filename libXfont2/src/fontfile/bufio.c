@@ -173,15 +173,26 @@ BufFileOpenWrite (int fd)
 int
 BufFileRead (BufFilePtr f, char *b, int n)
 {
-    int	    c, cnt;
+    int	    c, cnt, chunk;
     cnt = n;
-    while (cnt--) {
+    while (cnt > 0) {
+	/* Copy what is buffered at once, refill through BufFileGet */
+	if (f->left > 0) {
+	    chunk = f->left < cnt ? f->left : cnt;
+	    memcpy (b, f->bufp, chunk);
+	    f->bufp += chunk;
+	    f->left -= chunk;
+	    b += chunk;
+	    cnt -= chunk;
+	    continue;
+	}
 	c = BufFileGet (f);
 	if (c == BUFFILEEOF)
 	    break;
 	*b++ = c;
+	cnt--;
     }
-    return n - cnt - 1;
+    return n - cnt;
 }
 
 int
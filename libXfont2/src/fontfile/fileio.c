@@ -34,6 +34,9 @@ in this Software without prior written authorization from The Open Group.
 #include "libxfontint.h"
 #include <X11/fonts/fntfilio.h>
 #include <X11/Xos.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <limits.h>
 #ifndef O_BINARY
 #define O_BINARY O_RDONLY
 #endif
@@ -44,23 +47,188 @@ in this Software without prior written authorization from The Open Group.
 #define O_NOFOLLOW 0
 #endif
 
+/*
+ * Compressed fonts are inflated once and the result kept in memory, so a
+ * font that is closed and opened again, or whose info is listed before it
+ * is opened, is not inflated a second time.  Entries are keyed on the
+ * file name, size and modification time.  Entries no open file refers to
+ * are dropped, least recently used first, once the cache holds more than
+ * FONT_FILE_CACHE_BYTES.
+ */
+#define FONT_FILE_CACHE_BYTES	(8 * 1024 * 1024)
+
+typedef struct _FontFileCacheEntry {
+    struct _FontFileCacheEntry	*next;
+    char			*name;
+    long			size;
+    long			mtime;
+    BufChar			*data;
+    int				length;
+    int				refcount;
+} FontFileCacheEntryRec, *FontFileCacheEntryPtr;
+
+/* Most recently used first */
+static FontFileCacheEntryPtr	fontFileCache;
+static long			fontFileCacheBytes;
+
+static void
+FontFileCacheTrim (void)
+{
+    FontFileCacheEntryPtr   *prev, *victim, entry;
+
+    while (fontFileCacheBytes > FONT_FILE_CACHE_BYTES) {
+	victim = NULL;
+	for (prev = &fontFileCache; *prev; prev = &(*prev)->next)
+	    if ((*prev)->refcount == 0)
+		victim = prev;
+	if (!victim)
+	    break;
+	entry = *victim;
+	*victim = entry->next;
+	fontFileCacheBytes -= entry->length;
+	free (entry->name);
+	free (entry->data);
+	free (entry);
+    }
+}
+
+static int
+BufFileMemoryFill (BufFilePtr f)
+{
+    f->left = 0;
+    return BUFFILEEOF;
+}
+
+static int
+BufFileMemorySkip (BufFilePtr f, int count)
+{
+    if (count > f->left) {
+	f->bufp += f->left;
+	f->left = 0;
+	return BUFFILEEOF;
+    }
+    f->bufp += count;
+    f->left -= count;
+    return count;
+}
+
+static int
+BufFileMemoryClose (BufFilePtr f, int doClose)
+{
+    FontFileCacheEntryPtr   entry = (FontFileCacheEntryPtr) f->private;
+
+    entry->refcount--;
+    FontFileCacheTrim ();
+    return 1;
+}
+
+static BufFilePtr
+BufFileOpenCacheEntry (FontFileCacheEntryPtr entry)
+{
+    BufFilePtr	f;
+
+    f = BufFileCreate ((char *) entry, BufFileMemoryFill, 0,
+		       BufFileMemorySkip, BufFileMemoryClose);
+    if (!f)
+	return 0;
+    f->bufp = entry->data;
+    f->left = entry->length;
+    entry->refcount++;
+    return f;
+}
+
+static FontFileCacheEntryPtr
+FontFileCacheLookup (const char *name, struct stat *statb)
+{
+    FontFileCacheEntryPtr   *prev, entry;
+
+    for (prev = &fontFileCache; (entry = *prev); prev = &entry->next) {
+	if (strcmp (entry->name, name) != 0)
+	    continue;
+	if (entry->size != (long) statb->st_size ||
+	    entry->mtime != (long) statb->st_mtime)
+	    return NULL;
+	*prev = entry->next;
+	entry->next = fontFileCache;
+	fontFileCache = entry;
+	return entry;
+    }
+    return NULL;
+}
+
+/* Inflate all of cooked into a new cache entry for name */
+static FontFileCacheEntryPtr
+FontFileCacheInsert (const char *name, struct stat *statb, BufFilePtr cooked)
+{
+    FontFileCacheEntryPtr   entry;
+    BufChar		    *data = NULL, *grown;
+    int			    length = 0, size = 0, n;
+
+    do {
+	if (length == size) {
+	    if (size > INT_MAX / 2)
+		goto bail;
+	    size = size ? 2 * size : 64 * 1024;
+	    grown = realloc (data, size);
+	    if (!grown)
+		goto bail;
+	    data = grown;
+	}
+	n = BufFileRead (cooked, (char *) data + length, size - length);
+	length += n;
+    } while (n > 0);
+
+    entry = malloc (sizeof *entry);
+    if (!entry)
+	goto bail;
+    entry->name = strdup (name);
+    if (!entry->name) {
+	free (entry);
+	goto bail;
+    }
+    entry->size = (long) statb->st_size;
+    entry->mtime = (long) statb->st_mtime;
+    entry->data = data;
+    entry->length = length;
+    entry->refcount = 0;
+    entry->next = fontFileCache;
+    fontFileCache = entry;
+    fontFileCacheBytes += length;
+    return entry;
+
+  bail:
+    free (data);
+    return NULL;
+}
+
 FontFilePtr
 FontFileOpen (const char *name)
 {
     int		fd;
     int		len;
-    BufFilePtr	raw, cooked;
+    BufFilePtr	raw, cooked = NULL;
+    struct stat	statb;
+    Bool	cacheable;
+    FontFileCacheEntryPtr entry = NULL;
 
     fd = open (name, O_BINARY|O_CLOEXEC|O_NOFOLLOW);
     if (fd < 0)
 	return 0;
+    len = strlen (name);
+    cacheable = fstat (fd, &statb) == 0 &&
+	((len > 2 && !strcmp (name + len - 2, ".Z")) ||
+	 (len > 3 && !strcmp (name + len - 3, ".gz")) ||
+	 (len > 4 && !strcmp (name + len - 4, ".bz2")));
+    if (cacheable && (entry = FontFileCacheLookup (name, &statb))) {
+	close (fd);
+	return (FontFilePtr) BufFileOpenCacheEntry (entry);
+    }
     raw = BufFileOpenRead (fd);
     if (!raw)
     {
 	close (fd);
 	return 0;
     }
-    len = strlen (name);
     if (len > 2 && !strcmp (name + len - 2, ".Z")) {
 	cooked = BufFilePushCompressed (raw);
 	if (!cooked) {
@@ -87,6 +255,14 @@ FontFileOpen (const char *name)
 	raw = cooked;
 #endif
     }
+    if (cacheable && raw == cooked) {
+	entry = FontFileCacheInsert (name, &statb, raw);
+	BufFileClose (raw, TRUE);
+	if (!entry)
+	    return 0;
+	raw = BufFileOpenCacheEntry (entry);
+	FontFileCacheTrim ();
+    }
     return (FontFilePtr) raw;
 }
 
@@ -147,6 +147,7 @@ FontFileMakeDir(const char *dirName, int size)
     dir->directory = (char *) (dir + 1);
     dir->dir_mtime = 0;
     dir->alias_mtime = 0;
+    dir->loaded = TRUE;
     if (attriblen)
 	dir->attributes = dir->directory + dirlen + needslash + 1;
     else
@@ -330,17 +331,27 @@ SetupWildMatch(FontTablePtr table, FontNamePtr pat,
 	    first = firstDigit - name;
 	else
 	    first = firstWild - name;
+	/*
+	 * The prefix has no digits, so the names sharing it sort together
+	 * in plain strncmp order.  Search for both ends of that run so
+	 * only the names that can match are tested.
+	 */
 	while (left < right) {
 	    center = (left + right) / 2;
-	    result = strncmp(name, table->entries[center].name.name, first);
-	    if (result == 0)
-		break;
-	    if (result < 0)
-		right = center;
-	    else
+	    if (strncmp(name, table->entries[center].name.name, first) > 0)
 		left = center + 1;
+	    else
+		right = center;
 	}
 	*leftp = left;
+	right = table->used;
+	while (left < right) {
+	    center = (left + right) / 2;
+	    if (strncmp(name, table->entries[center].name.name, first) >= 0)
+		left = center + 1;
+	    else
+		right = center;
+	}
 	*rightp = right;
 	return -1;
     } else {
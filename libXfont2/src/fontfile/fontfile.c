@@ -34,6 +34,8 @@ in this Software without prior written authorization from The Open Group.
 #include "libxfontint.h"
 #include <X11/fonts/fntfilst.h>
 #include <X11/keysym.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #ifdef WIN32
 #include <ctype.h>
 #endif
@@ -86,24 +88,69 @@ FontFileNameCheck (const char *name)
 #endif
 }
 
+/*
+ * Font directories are read when they are first searched, not when they
+ * are added to the font path.  Most opens are satisfied by the first
+ * elements of the path, so a long path of large directories does not have
+ * to be parsed at startup.  Until then the element holds an empty
+ * directory carrying only the name and attributes.
+ */
+static Bool
+FontFileDirectoryExists (FontDirectoryPtr dir)
+{
+    char	fileName[MAXFONTFILENAMELEN];
+    struct stat	statb;
+
+    if (strlen(dir->directory) + sizeof(FontAliasFile) > sizeof(fileName) ||
+	strlen(dir->directory) + sizeof(FontDirFile) > sizeof(fileName))
+	return FALSE;
+    strcpy (fileName, dir->directory);
+    strcat (fileName, FontDirFile);
+    if (stat (fileName, &statb) == 0)
+	return TRUE;
+    strcpy (fileName, dir->directory);
+    strcat (fileName, FontAliasFile);
+    return stat (fileName, &statb) == 0;
+}
+
 int
 FontFileInitFPE (FontPathElementPtr fpe)
 {
-    int			status;
     FontDirectoryPtr	dir;
 
-    status = FontFileReadDirectory (fpe->name, &dir);
-    if (status == Successful)
+    dir = FontFileMakeDir (fpe->name, 0);
+    if (!dir)
+	return AllocError;
+    if (!FontFileDirectoryExists (dir))
     {
-	if (dir->nonScalable.used > 0)
-	    if (!FontFileRegisterBitmapSource (fpe))
-	    {
-		FontFileFreeFPE (fpe);
-		return AllocError;
-	    }
-	fpe->private = (pointer) dir;
+	FontFileFreeDir (dir);
+	return BadFontPath;
     }
-    return status;
+    dir->loaded = FALSE;
+    fpe->private = (pointer) dir;
+    return Successful;
+}
+
+static FontDirectoryPtr
+FontFileLoadFPE (FontPathElementPtr fpe)
+{
+    FontDirectoryPtr	dir = (FontDirectoryPtr) fpe->private;
+    FontDirectoryPtr	loaded;
+
+    if (dir->loaded)
+	return dir;
+    /* A directory that cannot be read stays empty */
+    dir->loaded = TRUE;
+    if (FontFileReadDirectory (fpe->name, &loaded) != Successful)
+	return dir;
+    if (loaded->nonScalable.used > 0 && !FontFileRegisterBitmapSource (fpe))
+    {
+	FontFileFreeDir (loaded);
+	return dir;
+    }
+    FontFileFreeDir (dir);
+    fpe->private = (pointer) loaded;
+    return loaded;
 }
 
 /* ARGSUSED */
@@ -113,6 +160,8 @@ FontFileResetFPE (FontPathElementPtr fpe)
     FontDirectoryPtr	dir;
 
     dir = (FontDirectoryPtr) fpe->private;
+    if (!dir->loaded)
+	return Successful;
     /*
      * The reset must fail for bitmap fonts because they get cleared when
      * the path is set.
@@ -276,7 +325,7 @@ FontFileOpenFont (pointer client, FontPathElementPtr fpe, Mask flags,
 
     if (namelen >= MAXFONTNAMELEN)
 	return AllocError;
-    dir = (FontDirectoryPtr) fpe->private;
+    dir = FontFileLoadFPE (fpe);
 
     /* Match non-scalable pattern */
     CopyISOLatin1Lowered (lowerName, name, namelen);
@@ -704,7 +753,7 @@ _FontFileListFonts (pointer client, FontPathElementPtr fpe,
 
     if (len >= MAXFONTNAMELEN)
 	return AllocError;
-    dir = (FontDirectoryPtr) fpe->private;
+    dir = FontFileLoadFPE (fpe);
     CopyISOLatin1Lowered (lowerChars, pat, len);
     lowerChars[len] = '\0';
     lowerName.name = lowerChars;
@@ -865,7 +914,7 @@ FontFileListOneFontWithInfo (pointer client, FontPathElementPtr fpe,
 
     if (namelen >= MAXFONTNAMELEN)
 	return AllocError;
-    dir = (FontDirectoryPtr) fpe->private;
+    dir = FontFileLoadFPE (fpe);
 
     /* Match non-scalable pattern */
     CopyISOLatin1Lowered (lowerName, name, namelen);
@@ -34,6 +34,18 @@ in this Software without prior written authorization from The Open Group.
 #include "libxfontint.h"
 #include <X11/fonts/fontmisc.h>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define UTIL_BITMAP_SSSE3
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define UTIL_TARGET_SSSE3
+#else
+#include <cpuid.h>
+#define UTIL_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
 /* Utility functions for reformating font bitmaps */
 
 static const unsigned char _reverse_byte[0x100] = {
@@ -71,6 +83,79 @@ static const unsigned char _reverse_byte[0x100] = {
 	0x1f, 0x9f, 0x5f, 0xdf, 0x3f, 0xbf, 0x7f, 0xff
 };
 
+#ifdef UTIL_BITMAP_SSSE3
+
+/*
+ * With SSSE3, sixteen bytes at a time go through pshufb: as byte shuffles
+ * for the swaps, and as lookups of the reversed nibbles for the bit order.
+ * Whatever is left of a buffer after the last whole vector is done by the
+ * loops below, one byte or unit at a time.
+ */
+
+static int
+HaveSSSE3(void)
+{
+    static int have = -1;
+
+    if (have < 0) {
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 1);
+	have = (info[2] & (1 << 9)) != 0;
+#else
+	unsigned int a, b, c, d;
+
+	have = __get_cpuid(1, &a, &b, &c, &d) && (c & (1 << 9));
+#endif
+    }
+    return have;
+}
+
+static UTIL_TARGET_SSSE3 int
+BitOrderInvertSSSE3(unsigned char *buf, int nbytes)
+{
+    const __m128i rev_lo = _mm_setr_epi8(0x00, 0x80, 0x40, 0xc0,
+					 0x20, 0xa0, 0x60, 0xe0,
+					 0x10, 0x90, 0x50, 0xd0,
+					 0x30, 0xb0, 0x70, (char) 0xf0);
+    const __m128i rev_hi = _mm_setr_epi8(0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+					 0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    int i;
+
+    for (i = 0; i + 16 <= nbytes; i += 16) {
+	__m128i *p = (__m128i *) (buf + i);
+	__m128i v = _mm_loadu_si128(p);
+	__m128i lo = _mm_and_si128(v, nibble);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+
+	_mm_storeu_si128(p, _mm_or_si128(_mm_shuffle_epi8(rev_lo, lo),
+					 _mm_shuffle_epi8(rev_hi, hi)));
+    }
+    return i;
+}
+
+static UTIL_TARGET_SSSE3 int
+ByteSwapSSSE3(unsigned char *buf, int nbytes, int unit)
+{
+    const __m128i swap2 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+					9, 8, 11, 10, 13, 12, 15, 14);
+    const __m128i swap4 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+					11, 10, 9, 8, 15, 14, 13, 12);
+    __m128i swap = unit == 2 ? swap2 : swap4;
+    int i;
+
+    for (i = 0; i + 16 <= nbytes; i += 16) {
+	__m128i *p = (__m128i *) (buf + i);
+
+	_mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), swap));
+    }
+    return i;
+}
+
+#endif
+
 /*
  *	Invert bit order within each BYTE of an array.
  */
@@ -79,6 +164,15 @@ BitOrderInvert(unsigned char *buf, int nbytes)
 {
     const unsigned char *rev = _reverse_byte;
 
+#ifdef UTIL_BITMAP_SSSE3
+    if (nbytes >= 16 && HaveSSSE3()) {
+	int done = BitOrderInvertSSSE3(buf, nbytes);
+
+	buf += done;
+	nbytes -= done;
+    }
+#endif
+
     for (; --nbytes >= 0; buf++)
 	*buf = rev[*buf];
 }
@@ -91,6 +185,15 @@ TwoByteSwap(unsigned char *buf, int nbytes)
 {
     unsigned char c;
 
+#ifdef UTIL_BITMAP_SSSE3
+    if (nbytes >= 16 && HaveSSSE3()) {
+	int done = ByteSwapSSSE3(buf, nbytes, 2);
+
+	buf += done;
+	nbytes -= done;
+    }
+#endif
+
     for (; nbytes > 0; nbytes -= 2, buf += 2)
     {
 	c = buf[0];
@@ -107,6 +210,15 @@ FourByteSwap(unsigned char *buf, int nbytes)
 {
     unsigned char c;
 
+#ifdef UTIL_BITMAP_SSSE3
+    if (nbytes >= 16 && HaveSSSE3()) {
+	int done = ByteSwapSSSE3(buf, nbytes, 4);
+
+	buf += done;
+	nbytes -= done;
+    }
+#endif
+
     for (; nbytes > 0; nbytes -= 4, buf += 4)
     {
 	c = buf[0];
@@ -339,6 +339,92 @@ _fill_xrender_bitmap( FT_Bitmap*	target,
     }
 }
 
+/*
+ * Glyphs loaded together are sent to the server in as few AddGlyphs
+ * requests as will hold them, rather than one request per glyph.
+ */
+#define XFT_UPLOAD_MAX_BYTES	(256 * 1024)
+
+typedef struct _XftGlyphUpload {
+    Glyph	    gids[XFT_NMISSING];
+    XGlyphInfo	    info[XFT_NMISSING];
+    int		    nglyph;
+    char	    *images;
+    int		    nimage;	/* bytes of image data queued */
+    int		    size;	/* bytes allocated at images */
+    int		    max;	/* most image bytes to send in one request */
+} XftGlyphUpload;
+
+static void
+_XftGlyphUploadInit (Display *dpy, XftGlyphUpload *up)
+{
+    long    maxreq = XExtendedMaxRequestSize (dpy);
+
+    if (!maxreq)
+	maxreq = XMaxRequestSize (dpy);
+    up->nglyph = 0;
+    up->images = NULL;
+    up->nimage = 0;
+    up->size = 0;
+    /* leave room for the request header and the ids and metrics */
+    up->max = (maxreq << 2) - 12 - XFT_NMISSING * (4 + 12);
+    if (up->max > XFT_UPLOAD_MAX_BYTES)
+	up->max = XFT_UPLOAD_MAX_BYTES;
+}
+
+static void
+_XftGlyphUploadFlush (Display *dpy, XftFontInt *font, XftGlyphUpload *up)
+{
+    if (!up->nglyph)
+	return;
+    XRenderAddGlyphs (dpy, font->glyphset, up->gids, up->info, up->nglyph,
+		      up->images, up->nimage);
+    up->nglyph = 0;
+    up->nimage = 0;
+}
+
+static void
+_XftGlyphUploadAdd (Display	    *dpy,
+		    XftFontInt	    *font,
+		    XftGlyphUpload  *up,
+		    Glyph	    glyph,
+		    XGlyphInfo	    *info,
+		    unsigned char   *image,
+		    int		    size)
+{
+    if (up->nglyph == XFT_NMISSING || up->nimage + size > up->max)
+	_XftGlyphUploadFlush (dpy, font, up);
+    if (up->nimage + size > up->size && size <= up->max)
+    {
+	int	newsize = up->size ? up->size : 4096;
+	char	*images;
+
+	while (newsize < up->nimage + size)
+	    newsize *= 2;
+	if (newsize > up->max)
+	    newsize = up->max;
+	images = realloc (up->images, newsize);
+	if (images)
+	{
+	    up->images = images;
+	    up->size = newsize;
+	}
+    }
+    if (up->nimage + size > up->size)
+    {
+	/* too big to queue; send it on its own */
+	_XftGlyphUploadFlush (dpy, font, up);
+	XRenderAddGlyphs (dpy, font->glyphset, &glyph, info, 1,
+			  (char *) image, size);
+	return;
+    }
+    up->gids[up->nglyph] = glyph;
+    up->info[up->nglyph] = *info;
+    up->nglyph++;
+    memcpy (up->images + up->nimage, image, size);
+    up->nimage += size;
+}
+
 _X_EXPORT void
 XftFontLoadGlyphs (Display	    *dpy,
 		   XftFont	    *pub,
@@ -365,6 +451,7 @@ XftFontLoadGlyphs (Display	    *dpy,
     FT_Vector	    vector;
     FT_Face	    face;
     FT_Render_Mode  mode = FT_RENDER_MODE_MONO;
+    XftGlyphUpload  upload;
 
     if (!info)
 	return;
@@ -390,6 +477,8 @@ XftFontLoadGlyphs (Display	    *dpy,
 	}
     }
 
+    _XftGlyphUploadInit (dpy, &upload);
+
     while (nglyph--)
     {
 	glyphindex = *glyphs++;
@@ -691,9 +780,8 @@ XftFontLoadGlyphs (Display	    *dpy,
 		if (ImageByteOrder (dpy) != XftNativeByteOrder ())
 		    XftSwapCARD32 ((CARD32 *) bufBitmap, size >> 2);
 	    }
-	    XRenderAddGlyphs (dpy, font->glyphset, &glyph,
-			      &xftg->metrics, 1,
-			      (char *) bufBitmap, size);
+	    _XftGlyphUploadAdd (dpy, font, &upload, glyph,
+				&xftg->metrics, bufBitmap, size);
 	}
 	else
 	{
@@ -715,6 +803,8 @@ XftFontLoadGlyphs (Display	    *dpy,
 	    printf ("Caching glyph 0x%x size %ld\n", glyphindex,
 		    xftg->glyph_memory);
     }
+    _XftGlyphUploadFlush (dpy, font, &upload);
+    free (upload.images);
     if (bufBitmap != bufLocal)
 	free (bufBitmap);
     XftUnlockFace (&font->public);
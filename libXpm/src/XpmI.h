@@ -225,11 +225,16 @@ FUNC(xpmHashIntern, int, (xpmHashTable *table, char *tag, void *data));
 FUNC(xpmNextString, int, (xpmData *mdata));
 FUNC(xpmNextUI, int, (xpmData *mdata, unsigned int *ui_return));
 FUNC(xpmGetString, int, (xpmData *mdata, char **sptr, unsigned int *l));
+FUNC(xpmGetRow, char *, (xpmData *mdata, char *buf, unsigned int n));
 
 #define xpmGetC(mdata) \
 	((!mdata->type || mdata->type == XPMBUFFER) ? \
 	 (*mdata->cptr++) : (getc(mdata->stream.file)))
 
+/* a buffer xpmGetRow can read a row of width pixels into, if it needs one */
+#define xpmRowBufferSize(mdata, width, cpp) \
+	((!mdata->type || mdata->type == XPMBUFFER) ? 0 : (width) * (cpp))
+
 FUNC(xpmNextWord, unsigned int,
      (xpmData *mdata, char *buf, unsigned int buflen));
 FUNC(xpmGetCmt, int, (xpmData *mdata, char **cmt));
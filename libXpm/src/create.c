@@ -50,6 +50,9 @@
 #endif
 #include "XpmI.h"
 #include <ctype.h>
+#if !defined(FOR_MSW) && !defined(AMIGA)
+#include <X11/Xlibint.h>
+#endif
 
 LFUNC(xpmVisualType, int, (Visual *visual));
 
@@ -58,6 +61,33 @@ LFUNC(AllocColor, int, (Display *display, Colormap colormap,
 LFUNC(FreeColors, int, (Display *display, Colormap colormap,
 			Pixel *pixels, int n, void *closure));
 
+#if !defined(FOR_MSW) && !defined(AMIGA)
+typedef struct {
+    char *colorname;		/* what AllocColor is first asked for */
+    int status;			/* and what it would return */
+    Bool used;			/* handed out by BatchAllocColor */
+    XColor xcolor;
+} BatchColor;
+
+typedef struct {
+    BatchColor *colors;		/* one for each entry of the color table */
+    unsigned int color;		/* entry whose pixel is being set */
+    unsigned int *requests;	/* entry each AllocColor request is for */
+    uint64_t first_seq;		/* sequence number of the first one */
+    uint64_t last_seq;		/* and of the last one */
+} BatchState;
+
+LFUNC(BatchAllocHandler, Bool, (Display *display, xReply *rep, char *buf,
+				int len, XPointer data));
+LFUNC(BatchAllocColors, int, (Display *display, Colormap colormap,
+			      XpmColor *colors, unsigned int ncolors,
+			      unsigned int key, BatchState *state));
+LFUNC(BatchAllocColor, int, (Display *display, Colormap colormap,
+			     char *colorname, XColor *xcolor, void *closure));
+LFUNC(BatchFreeColors, void, (Display *display, Colormap colormap,
+			      unsigned int ncolors, BatchState *state));
+#endif
+
 #ifndef FOR_MSW
 LFUNC(SetCloseColor, int, (Display *display, Colormap colormap,
 			   Visual *visual, XColor *col,
@@ -249,6 +279,181 @@ AllocColor(
 }
 
 
+#if !defined(FOR_MSW) && !defined(AMIGA)
+/*
+ * Allocating the colors of the color table one XAllocColor at a time
+ * costs a round trip per color.  When the default AllocColor is used,
+ * BatchAllocColors sends the AllocColor requests for the first color
+ * name CreateColors will try for every entry all at once, and collects
+ * the replies as they come back.  CreateColors then gets them through
+ * BatchAllocColor, which only goes to the server for the names it has
+ * not already asked for.
+ *
+ * An AllocColor which fails is reported as an error.  XAllocColor keeps
+ * that quiet, but an async handler never sees errors, so this is only
+ * done for colormaps which are never full: those of the static visual
+ * classes.
+ */
+
+#define USE_BATCHALLOC(visual) \
+    ((visual)->class == TrueColor || (visual)->class == StaticColor || \
+     (visual)->class == StaticGray)
+
+static Bool
+BatchAllocHandler(
+    Display	*dpy,
+    xReply	*rep,
+    char	*buf,
+    int		 len,
+    XPointer	 data)
+{
+    BatchState *state = (BatchState *) data;
+    uint64_t seq = X_DPY_GET_LAST_REQUEST_READ(dpy);
+    xAllocColorReply replbuf;
+    xAllocColorReply *repl;
+    BatchColor *bc;
+
+    /* the last reply is read by BatchAllocColors itself */
+    if (seq < state->first_seq || seq >= state->last_seq ||
+	rep->generic.type != X_Reply)
+	return False;
+    bc = &state->colors[state->requests[seq - state->first_seq]];
+    repl = (xAllocColorReply *)
+	_XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+			(SIZEOF(xAllocColorReply) - SIZEOF(xReply)) >> 2,
+			True);
+    bc->xcolor.pixel = repl->pixel;
+    bc->xcolor.red = repl->red;
+    bc->xcolor.green = repl->green;
+    bc->xcolor.blue = repl->blue;
+    bc->status = 1;
+    return True;
+}
+
+static int
+BatchAllocColors(
+    Display		*dpy,
+    Colormap		 colormap,
+    XpmColor		*colors,
+    unsigned int	 ncolors,
+    unsigned int	 key,
+    BatchState		*state)
+{
+    unsigned int color, nrequests = 0;
+    xAllocColorReply rep;
+    xAllocColorReq *req;
+    _XAsyncHandler async;
+    BatchColor *bc;
+    char **defaults;
+    unsigned int k;
+
+    state->colors = (BatchColor *) XpmCalloc(ncolors, sizeof(BatchColor));
+    state->requests = (unsigned int *)
+	XpmMalloc(ncolors * sizeof(unsigned int));
+    if (!state->colors || !state->requests) {
+	XpmFree(state->colors);
+	XpmFree(state->requests);
+	return (XpmNoMemory);
+    }
+
+    /* the name CreateColors looks at first, parsed the way AllocColor
+     * would */
+    for (color = 0, bc = state->colors; color < ncolors; color++, bc++) {
+	defaults = (char **) &colors[color];
+	for (k = key; k > 1 && !defaults[k]; k--)
+	    ;
+	if (k < 2)
+	    for (k = key + 1; k < NKEYS + 1 && !defaults[k]; k++)
+		;
+	if (k >= NKEYS + 1 ||
+	    !xpmstrcasecmp(defaults[k], TRANSPARENT_COLOR))
+	    continue;
+	bc->colorname = defaults[k];
+	if (!XParseColor(dpy, colormap, bc->colorname, &bc->xcolor))
+	    bc->status = -1;
+	else
+	    state->requests[nrequests++] = color;
+    }
+    if (!nrequests)
+	return (XpmSuccess);
+
+    LockDisplay(dpy);
+    for (k = 0; k < nrequests; k++) {
+	bc = &state->colors[state->requests[k]];
+	GetReq(AllocColor, req);
+	req->cmap = colormap;
+	req->red = bc->xcolor.red;
+	req->green = bc->xcolor.green;
+	req->blue = bc->xcolor.blue;
+	if (k == 0)
+	    state->first_seq = X_DPY_GET_REQUEST(dpy);
+    }
+    state->last_seq = X_DPY_GET_REQUEST(dpy);
+    async.next = dpy->async_handlers;
+    async.handler = BatchAllocHandler;
+    async.data = (XPointer) state;
+    dpy->async_handlers = &async;
+    if (_XReply(dpy, (xReply *) &rep, 0, xTrue)) {
+	bc = &state->colors[state->requests[nrequests - 1]];
+	bc->xcolor.pixel = rep.pixel;
+	bc->xcolor.red = rep.red;
+	bc->xcolor.green = rep.green;
+	bc->xcolor.blue = rep.blue;
+	bc->status = 1;
+    }
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    return (XpmSuccess);
+}
+
+/* AllocColor, which already knows the answer for the first name asked for
+ * the entry of the color table being set */
+static int
+BatchAllocColor(
+    Display	*display,
+    Colormap	 colormap,
+    char	*colorname,
+    XColor	*xcolor,
+    void	*closure)
+{
+    BatchState *state = (BatchState *) closure;
+    BatchColor *bc = &state->colors[state->color];
+
+    if (colorname && colorname == bc->colorname && !bc->used) {
+	bc->used = True;
+	*xcolor = bc->xcolor;
+	return bc->status;
+    }
+    return AllocColor(display, colormap, colorname, xcolor, NULL);
+}
+
+/* free the colors allocated but never handed out, and the state */
+static void
+BatchFreeColors(
+    Display		*display,
+    Colormap		 colormap,
+    unsigned int	 ncolors,
+    BatchState		*state)
+{
+    unsigned int color, n = 0;
+    BatchColor *bc;
+    Pixel *pixels;
+
+    pixels = (Pixel *) XpmMalloc(ncolors * sizeof(Pixel));
+    for (color = 0, bc = state->colors; color < ncolors; color++, bc++) {
+	if (bc->status > 0 && !bc->used && pixels)
+	    pixels[n++] = bc->xcolor.pixel;
+    }
+    if (n)
+	XFreeColors(display, colormap, pixels, n, 0);
+    XpmFree(pixels);
+    XpmFree(state->requests);
+    XpmFree(state->colors);
+}
+#endif /* !FOR_MSW && !AMIGA */
+
+
 #ifndef FOR_MSW
 /*
  * set a close color in case the exact one can't be set
@@ -534,6 +739,10 @@ CreateColors(
 
     XColor *cols = NULL;
     unsigned int ncols = 0;
+#if !defined(FOR_MSW) && !defined(AMIGA)
+    BatchState batch;
+    Bool batched = False;
+#endif
 
     /*
      * retrieve information from the XpmAttributes
@@ -617,8 +826,22 @@ CreateColors(
 	break;
     }
 
+#if !defined(FOR_MSW) && !defined(AMIGA)
+    if (allocColor == AllocColor && !numsymbols && ncolors > 1 &&
+	USE_BATCHALLOC(visual) &&
+	BatchAllocColors(display, colormap, colors, ncolors, key,
+			 &batch) == XpmSuccess) {
+	batched = True;
+	allocColor = BatchAllocColor;
+	closure = &batch;
+    }
+#endif
+
     for (color = 0; color < ncolors; color++, colors++,
 					 image_pixels++, mask_pixels++) {
+#if !defined(FOR_MSW) && !defined(AMIGA)
+	batch.color = color;
+#endif
 	colorname = NULL;
 	pixel_defined = False;
 	defaults = (char **) colors;
@@ -708,6 +931,10 @@ CreateColors(
 	    if (!pixel_defined) {
 		if (cols)
 		    XpmFree(cols);
+#if !defined(FOR_MSW) && !defined(AMIGA)
+		if (batched)
+		    BatchFreeColors(display, colormap, ncolors, &batch);
+#endif
 		return (XpmColorFailed);
 	    }
 	} else {
@@ -726,6 +953,10 @@ CreateColors(
     }
     if (cols)
 	XpmFree(cols);
+#if !defined(FOR_MSW) && !defined(AMIGA)
+    if (batched)
+	BatchFreeColors(display, colormap, ncolors, &batch);
+#endif
     return (ErrorStatus);
 }
 
@@ -2325,6 +2556,27 @@ ParseAndPutPixels(
     Pixel		*shape_pixels)
 {
     unsigned int a, x, y;
+    unsigned int rowlen;
+    char *row, *rowbuf = NULL;
+
+    if (cpp > 0 && width >= UINT_MAX / cpp)
+	return (XpmNoMemory);
+    rowlen = width * cpp;
+    /* rows are decoded whole, straight from memory where they already are */
+    if (xpmRowBufferSize(data, width, cpp)) {
+	rowbuf = (char *) XpmMalloc(rowlen);
+	if (!rowbuf)
+	    return (XpmNoMemory);
+    }
+
+/* free the row buffer at all exits */
+#undef RETURN
+#define RETURN(status) \
+do \
+{ \
+	XpmFree(rowbuf); \
+	return (status); \
+} while(0)
 
     switch (cpp) {
 
@@ -2345,7 +2597,7 @@ ParseAndPutPixels(
 	    obm = SelectObject(*dc, image->bitmap);
 #endif
 	    if (ncolors > 256)
-		return (XpmFileInvalid);
+		RETURN(XpmFileInvalid);
 
 	    bzero((char *)colidx, 256 * sizeof(short));
 	    for (a = 0; a < ncolors; a++)
@@ -2353,10 +2605,12 @@ ParseAndPutPixels(
 
 	    for (y = 0; y < height; y++) {
 		xpmNextString(data);
+		if (!(row = xpmGetRow(data, rowbuf, rowlen)))
+		    RETURN(XpmFileInvalid);
 		for (x = 0; x < width; x++) {
-		    int c = xpmGetC(data);
+		    unsigned int c = (unsigned char) *row++;
 
-		    if (c > 0 && c < 256 && colidx[c] != 0) {
+		    if (colidx[c] != 0) {
 #ifndef FOR_MSW
 			XPutPixel(image, x, y, image_pixels[colidx[c] - 1]);
 			if (shapeimage)
@@ -2369,7 +2623,7 @@ ParseAndPutPixels(
 			}
 #endif
 		    } else
-			return (XpmFileInvalid);
+			RETURN(XpmFileInvalid);
 		}
 	    }
 #ifdef FOR_MSW
@@ -2402,7 +2656,7 @@ if (cidx[f]) XpmFree(cidx[f]);}
 			XpmCalloc(256, sizeof(unsigned short));
 		    if (cidx[char1] == NULL) { /* new block failed */
 			FREE_CIDX;
-			return (XpmNoMemory);
+			RETURN(XpmNoMemory);
 		    }
 		}
 		cidx[char1][(unsigned char)colorTable[a].string[1]] = a + 1;
@@ -2410,18 +2664,21 @@ if (cidx[f]) XpmFree(cidx[f]);}
 
 	    for (y = 0; y < height; y++) {
 		xpmNextString(data);
+		if (!(row = xpmGetRow(data, rowbuf, rowlen))) {
+		    FREE_CIDX;
+		    RETURN(XpmFileInvalid);
+		}
 		for (x = 0; x < width; x++) {
-		    int cc1 = xpmGetC(data);
-		    if (cc1 > 0 && cc1 < 256) {
-			int cc2 = xpmGetC(data);
-			if (cc2 > 0 && cc2 < 256 &&
-			    cidx[cc1] && cidx[cc1][cc2] != 0) {
+		    unsigned int cc1 = (unsigned char) *row++;
+		    unsigned int cc2 = (unsigned char) *row++;
+
+		    if (cidx[cc1] && cidx[cc1][cc2] != 0) {
 #ifndef FOR_MSW
-			    XPutPixel(image, x, y,
-				      image_pixels[cidx[cc1][cc2] - 1]);
-			    if (shapeimage)
-				XPutPixel(shapeimage, x, y,
-					  shape_pixels[cidx[cc1][cc2] - 1]);
+			XPutPixel(image, x, y,
+				  image_pixels[cidx[cc1][cc2] - 1]);
+			if (shapeimage)
+			    XPutPixel(shapeimage, x, y,
+				      shape_pixels[cidx[cc1][cc2] - 1]);
 #else
 			SelectObject(*dc, image->bitmap);
 			SetPixel(*dc, x, y, image_pixels[cidx[cc1][cc2] - 1]);
@@ -2431,13 +2688,9 @@ if (cidx[f]) XpmFree(cidx[f]);}
 				     shape_pixels[cidx[cc1][cc2] - 1]);
 			}
 #endif
-			} else {
-			    FREE_CIDX;
-			    return (XpmFileInvalid);
-			}
 		    } else {
 			FREE_CIDX;
-			return (XpmFileInvalid);
+			RETURN(XpmFileInvalid);
 		    }
 		}
 	    }
@@ -2448,11 +2701,10 @@ if (cidx[f]) XpmFree(cidx[f]);}
     default:				/* Non-optimized case of long color
 					 * names */
 	{
-	    char *s;
 	    char buf[BUFSIZ];
 
 	    if (cpp >= sizeof(buf))
-		return (XpmFileInvalid);
+		RETURN(XpmFileInvalid);
 
 	    buf[cpp] = '\0';
 	    if (USE_HASHTABLE) {
@@ -2460,12 +2712,13 @@ if (cidx[f]) XpmFree(cidx[f]);}
 
 		for (y = 0; y < height; y++) {
 		    xpmNextString(data);
-		    for (x = 0; x < width; x++) {
-			for (a = 0, s = buf; a < cpp; a++, s++)
-			    *s = xpmGetC(data);
+		    if (!(row = xpmGetRow(data, rowbuf, rowlen)))
+			RETURN(XpmFileInvalid);
+		    for (x = 0; x < width; x++, row += cpp) {
+			memcpy(buf, row, cpp);
 			slot = xpmHashSlot(hashtable, buf);
 			if (!*slot)	/* no color matches */
-			    return (XpmFileInvalid);
+			    RETURN(XpmFileInvalid);
 #ifndef FOR_MSW
 			XPutPixel(image, x, y,
 				  image_pixels[HashColorIndex(slot)]);
@@ -2487,14 +2740,15 @@ if (cidx[f]) XpmFree(cidx[f]);}
 	    } else {
 		for (y = 0; y < height; y++) {
 		    xpmNextString(data);
-		    for (x = 0; x < width; x++) {
-			for (a = 0, s = buf; a < cpp; a++, s++)
-			    *s = xpmGetC(data);
+		    if (!(row = xpmGetRow(data, rowbuf, rowlen)))
+			RETURN(XpmFileInvalid);
+		    for (x = 0; x < width; x++, row += cpp) {
+			memcpy(buf, row, cpp);
 			for (a = 0; a < ncolors; a++)
 			    if (!strcmp(colorTable[a].string, buf))
 				break;
 			if (a == ncolors)	/* no color matches */
-			    return (XpmFileInvalid);
+			    RETURN(XpmFileInvalid);
 #ifndef FOR_MSW
 			XPutPixel(image, x, y, image_pixels[a]);
 			if (shapeimage)
@@ -2513,5 +2767,5 @@ if (cidx[f]) XpmFree(cidx[f]);}
 	}
 	break;
     }
-    return (XpmSuccess);
+    RETURN(XpmSuccess);
 }
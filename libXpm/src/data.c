@@ -234,6 +234,39 @@ xpmNextString(xpmData *data)
 }
 
 
+/*
+ * return the next n characters of the current string, or NULL if it ends
+ * before them.  Data in memory is returned in place, buf (of at least n
+ * characters) is only used when reading from a file.
+ */
+char *
+xpmGetRow(
+    xpmData		*data,
+    char		*buf,
+    unsigned int	 n)
+{
+    char *s;
+
+    if (!data->type || data->type == XPMBUFFER) {
+	s = data->cptr;
+	if (memchr(s, '\0', n))
+	    return NULL;
+	data->cptr += n;
+    } else {
+	FILE *file = data->stream.file;
+	unsigned int a;
+	int c;
+
+	for (a = 0, s = buf; a < n; a++, s++) {
+	    if ((c = Getc(data, file)) == EOF)
+		return NULL;
+	    *s = c;
+	}
+	s = buf;
+    }
+    return s;
+}
+
 /*
  * skip whitespace and return the following word
  */
@@ -379,10 +379,15 @@ ParsePixels(
 {
     unsigned int *iptr, *iptr2 = NULL; /* found by Egbert Eich */
     unsigned int a, x, y;
+    unsigned int rowlen;
+    char *row, *rowbuf = NULL;
 
     if ((height > 0 && width >= UINT_MAX / height) ||
 	width * height >= UINT_MAX / sizeof(unsigned int))
 	return XpmNoMemory;
+    if (cpp > 0 && width >= UINT_MAX / cpp)
+	return XpmNoMemory;
+    rowlen = width * cpp;
 #ifndef FOR_MSW
     iptr2 = (unsigned int *) XpmMalloc(sizeof(unsigned int) * width * height);
 #else
@@ -397,6 +402,15 @@ ParsePixels(
     if (!iptr2)
 	return (XpmNoMemory);
 
+    /* rows are decoded whole, straight from memory where they already are */
+    if (xpmRowBufferSize(data, width, cpp)) {
+	rowbuf = (char *) XpmMalloc(rowlen);
+	if (!rowbuf) {
+	    XpmFree(iptr2);
+	    return (XpmNoMemory);
+	}
+    }
+
     iptr = iptr2;
 
     switch (cpp) {
@@ -408,6 +422,7 @@ ParsePixels(
 
 	    if (ncolors > 256) {
 		XpmFree(iptr2); /* found by Egbert Eich */
+		XpmFree(rowbuf);
 		return (XpmFileInvalid);
 	    }
 
@@ -417,13 +432,19 @@ ParsePixels(
 
 	    for (y = 0; y < height; y++) {
 		xpmNextString(data);
+		if (!(row = xpmGetRow(data, rowbuf, rowlen))) {
+		    XpmFree(iptr2);
+		    XpmFree(rowbuf);
+		    return (XpmFileInvalid);
+		}
 		for (x = 0; x < width; x++, iptr++) {
-		    int c = xpmGetC(data);
+		    unsigned int c = (unsigned char) *row++;
 
-		    if (c > 0 && c < 256 && colidx[c] != 0)
+		    if (colidx[c] != 0)
 			*iptr = colidx[c] - 1;
 		    else {
 			XpmFree(iptr2);
+			XpmFree(rowbuf);
 			return (XpmFileInvalid);
 		    }
 		}
@@ -456,6 +477,7 @@ do \
 		    if (cidx[char1] == NULL) { /* new block failed */
 			FREE_CIDX;
 			XpmFree(iptr2);
+			XpmFree(rowbuf);
 			return (XpmNoMemory);
 		    }
 		}
@@ -464,21 +486,22 @@ do \
 
 	    for (y = 0; y < height; y++) {
 		xpmNextString(data);
+		if (!(row = xpmGetRow(data, rowbuf, rowlen))) {
+		    FREE_CIDX;
+		    XpmFree(iptr2);
+		    XpmFree(rowbuf);
+		    return (XpmFileInvalid);
+		}
 		for (x = 0; x < width; x++, iptr++) {
-		    int cc1 = xpmGetC(data);
-		    if (cc1 > 0 && cc1 < 256) {
-			int cc2 = xpmGetC(data);
-			if (cc2 > 0 && cc2 < 256 &&
-			    cidx[cc1] && cidx[cc1][cc2] != 0)
-			    *iptr = cidx[cc1][cc2] - 1;
-			else {
-			    FREE_CIDX;
-			    XpmFree(iptr2);
-			    return (XpmFileInvalid);
-			}
-		    } else {
+		    unsigned int cc1 = (unsigned char) *row++;
+		    unsigned int cc2 = (unsigned char) *row++;
+
+		    if (cidx[cc1] && cidx[cc1][cc2] != 0)
+			*iptr = cidx[cc1][cc2] - 1;
+		    else {
 			FREE_CIDX;
 			XpmFree(iptr2);
+			XpmFree(rowbuf);
 			return (XpmFileInvalid);
 		    }
 		}
@@ -490,11 +513,11 @@ do \
     default:				/* Non-optimized case of long color
 					 * names */
 	{
-	    char *s;
 	    char buf[BUFSIZ];
 
 	    if (cpp >= sizeof(buf)) {
 		XpmFree(iptr2); /* found by Egbert Eich */
+		XpmFree(rowbuf);
 		return (XpmFileInvalid);
 	    }
 
@@ -504,12 +527,17 @@ do \
 
 		for (y = 0; y < height; y++) {
 		    xpmNextString(data);
-		    for (x = 0; x < width; x++, iptr++) {
-			for (a = 0, s = buf; a < cpp; a++, s++)
-			    *s = xpmGetC(data); /* int assigned to char, not a problem here */
+		    if (!(row = xpmGetRow(data, rowbuf, rowlen))) {
+			XpmFree(iptr2);
+			XpmFree(rowbuf);
+			return (XpmFileInvalid);
+		    }
+		    for (x = 0; x < width; x++, iptr++, row += cpp) {
+			memcpy(buf, row, cpp);
 			slot = xpmHashSlot(hashtable, buf);
 			if (!*slot) {	/* no color matches */
 			    XpmFree(iptr2);
+			    XpmFree(rowbuf);
 			    return (XpmFileInvalid);
 			}
 			*iptr = HashColorIndex(slot);
@@ -518,14 +546,19 @@ do \
 	    } else {
 		for (y = 0; y < height; y++) {
 		    xpmNextString(data);
-		    for (x = 0; x < width; x++, iptr++) {
-			for (a = 0, s = buf; a < cpp; a++, s++)
-			    *s = xpmGetC(data); /* int assigned to char, not a problem here */
+		    if (!(row = xpmGetRow(data, rowbuf, rowlen))) {
+			XpmFree(iptr2);
+			XpmFree(rowbuf);
+			return (XpmFileInvalid);
+		    }
+		    for (x = 0; x < width; x++, iptr++, row += cpp) {
+			memcpy(buf, row, cpp);
 			for (a = 0; a < ncolors; a++)
 			    if (!strcmp(colorTable[a].string, buf))
 				break;
 			if (a == ncolors) {	/* no color matches */
 			    XpmFree(iptr2);
+			    XpmFree(rowbuf);
 			    return (XpmFileInvalid);
 			}
 			*iptr = a;
@@ -535,6 +568,7 @@ do \
 	}
 	break;
     }
+    XpmFree(rowbuf);
     *pixels = iptr2;
     return (XpmSuccess);
 }
@@ -33,6 +33,8 @@ THE SOFTWARE.
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "zlib.h"
 typedef gzFile FontFilePtr;
@@ -870,36 +872,57 @@ parseFontFileName(const char *fontFileName, char *buf, char *dir)
     }
 }
 
-static FontEncPtr
-FontEncReallyReallyLoad(const char *charset,
-                        const char *dirname, const char *dir)
-{
-    FontFilePtr f;
-    FILE *file;
-    FontEncPtr encoding;
-    char file_name[MAXFONTFILENAMELEN], encoding_name[MAXFONTNAMELEN],
-        buf[MAXFONTFILENAMELEN];
-    int count, n;
-    static char format[24] = "";
+/* An encodings.dir file, read once and kept for as long as it does not
+   change, since a server or mkfontscale looks up encodings that are not
+   there (and so not yet in the list of fontenc.c) over and over. */
 
-    /* As we don't really expect to open encodings that often, we don't
-       take the trouble of caching encodings directories. */
+typedef struct _EncodingsDirEntry {
+    char *name;
+    char *file;
+} EncodingsDirEntryRec, *EncodingsDirEntryPtr;
 
-    if ((file = fopen(dirname, "r")) == NULL) {
-        return NULL;
+typedef struct _EncodingsDir {
+    char *dirname;
+    time_t mtime;
+    off_t size;
+    int count;
+    EncodingsDirEntryPtr entries;
+    struct _EncodingsDir *next;
+} EncodingsDirRec, *EncodingsDirPtr;
+
+static EncodingsDirPtr encodings_dirs = NULL;
+
+static void
+freeEncodingsDirEntries(EncodingsDirPtr d)
+{
+    int i;
+
+    for (i = 0; i < d->count; i++) {
+        free(d->entries[i].name);
+        free(d->entries[i].file);
     }
+    free(d->entries);
+    d->entries = NULL;
+    d->count = 0;
+}
+
+static int
+readEncodingsDir(EncodingsDirPtr d, FILE *file)
+{
+    char file_name[MAXFONTFILENAMELEN], encoding_name[MAXFONTNAMELEN];
+    EncodingsDirEntryPtr entries;
+    int count, n, size;
+    static char format[24] = "";
 
     count = fscanf(file, "%d\n", &n);
-    if (count == EOF || count != 1) {
-        fclose(file);
-        return NULL;
-    }
+    if (count == EOF || count != 1)
+        return 0;
 
-    encoding = NULL;
     if (!format[0]) {
         snprintf(format, sizeof(format), "%%%ds %%%d[^\n]\n",
                  (int) sizeof(encoding_name) - 1, (int) sizeof(file_name) - 1);
     }
+    size = 0;
     for (;;) {
         count = fscanf(file, format, encoding_name, file_name);
         if (count == EOF)
@@ -907,13 +930,99 @@ FontEncReallyReallyLoad(const char *charset,
         if (count != 2)
             break;
 
-        if (!strcasecmp(encoding_name, charset)) {
+        if (d->count >= size) {
+            size = size ? size * 2 : 64;
+            entries = realloc(d->entries, size * sizeof(EncodingsDirEntryRec));
+            if (!entries)
+                return 0;
+            d->entries = entries;
+        }
+        d->entries[d->count].name = strdup(encoding_name);
+        d->entries[d->count].file = strdup(file_name);
+        if (!d->entries[d->count].name || !d->entries[d->count].file) {
+            free(d->entries[d->count].name);
+            free(d->entries[d->count].file);
+            return 0;
+        }
+        d->count++;
+    }
+    return 1;
+}
+
+/* The contents of encodings.dir file dirname, read again if it changed
+   since last time */
+static EncodingsDirPtr
+findEncodingsDir(const char *dirname)
+{
+    EncodingsDirPtr d;
+    struct stat st;
+    FILE *file;
+
+    if (stat(dirname, &st) < 0)
+        return NULL;
+
+    for (d = encodings_dirs; d; d = d->next)
+        if (!strcmp(d->dirname, dirname))
+            break;
+
+    if (d) {
+        if (d->mtime == st.st_mtime && d->size == st.st_size)
+            return d;
+        freeEncodingsDirEntries(d);
+    }
+    else {
+        d = calloc(1, sizeof(EncodingsDirRec));
+        if (!d)
+            return NULL;
+        d->dirname = strdup(dirname);
+        if (!d->dirname) {
+            free(d);
+            return NULL;
+        }
+        d->next = encodings_dirs;
+        encodings_dirs = d;
+    }
+
+    /* Remember the file as it was before reading it, so that a change
+       made meanwhile is noticed next time */
+    d->mtime = st.st_mtime;
+    d->size = st.st_size;
+    if ((file = fopen(dirname, "r")) == NULL) {
+        d->mtime = 0;
+        return NULL;
+    }
+    if (!readEncodingsDir(d, file)) {
+        freeEncodingsDirEntries(d);
+        d->mtime = 0;
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    return d;
+}
+
+static FontEncPtr
+FontEncReallyReallyLoad(const char *charset,
+                        const char *dirname, const char *dir)
+{
+    FontFilePtr f;
+    FontEncPtr encoding;
+    EncodingsDirPtr d;
+    const char *file_name;
+    char buf[MAXFONTFILENAMELEN];
+    int i;
+
+    if ((d = findEncodingsDir(dirname)) == NULL)
+        return NULL;
+
+    encoding = NULL;
+    for (i = 0; i < d->count; i++) {
+        if (!strcasecmp(d->entries[i].name, charset)) {
             /* Found it */
+            file_name = d->entries[i].file;
             if (file_name[0] != '/') {
-                if (strlen(dir) + strlen(file_name) >= MAXFONTFILENAMELEN) {
-                    fclose(file);
+                if (strlen(dir) + strlen(file_name) >= MAXFONTFILENAMELEN)
                     return NULL;
-                }
                 snprintf(buf, MAXFONTFILENAMELEN, "%s%s", dir, file_name);
             }
             else {
@@ -921,18 +1030,14 @@ FontEncReallyReallyLoad(const char *charset,
             }
 
             f = FontFileOpen(buf);
-            if (f == NULL) {
-                fclose(file);
+            if (f == NULL)
                 return NULL;
-            }
             encoding = parseEncodingFile(f, 0);
             FontFileClose(f);
             break;
         }
     }
 
-    fclose(file);
-
     return encoding;
 }
 
@@ -416,6 +416,36 @@ void xcb_discard_reply(xcb_connection_t *c, unsigned int sequence);
  */
 void xcb_discard_reply64(xcb_connection_t *c, uint64_t sequence);
 
+/**
+ * @brief Wait for the reply of a given request, reading its data into caller memory.
+ * @param c The connection to the X server.
+ * @param request Sequence number of the request as returned by xcb_send_request().
+ * @param body Location to store the reply data following the 32 byte reply header.
+ * @param body_len Size of @p body in bytes.
+ * @param e Location to store errors in, or NULL. Ignored for unchecked requests.
+ *
+ * Like xcb_wait_for_reply(), but the reply data is read from the socket
+ * straight into @p body instead of a buffer allocated along with the reply.
+ * At most @p body_len bytes are stored and the rest is discarded; the length
+ * field of the reply still gives what the server sent. Only the header of
+ * the returned reply is valid. This does not work for replies carrying file
+ * descriptors.
+ */
+void *xcb_wait_for_reply_into(xcb_connection_t *c, unsigned int request, void *body, size_t body_len, xcb_generic_error_t **e);
+
+/**
+ * @brief Wait for the reply of a given request, reading its data into caller memory, with 64-bit sequence number.
+ * @param c The connection to the X server.
+ * @param request 64-bit sequence number of the request as returned by xcb_send_request64().
+ * @param body Location to store the reply data following the 32 byte reply header.
+ * @param body_len Size of @p body in bytes.
+ * @param e Location to store errors in, or NULL. Ignored for unchecked requests.
+ *
+ * Unlike its xcb_wait_for_reply_into() counterpart, the given sequence number
+ * is not automatically "widened" to 64-bit.
+ */
+void *xcb_wait_for_reply_into64(xcb_connection_t *c, uint64_t request, void *body, size_t body_len, xcb_generic_error_t **e);
+
 /* xcb_ext.c */
 
 /**
@@ -142,6 +142,9 @@ static Xauth *get_authptr(struct sockaddr *sockname, int display)
             family = XCB_FAMILY_INTERNET;
         break;
     case AF_UNIX:
+#ifdef AF_VSOCK
+    case AF_VSOCK:  /* the server treats hvsock peers as local */
+#endif
         break;
     default:
         return 0;   /* cannot authenticate this family */
@@ -219,12 +219,21 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
 {
     int n;
 
+#ifdef XCB_ZTCP
+    if(c->ztcp)
+    {
+        n = _xcb_ztcp_writev(c, *vector, *count);
+        if(n == 0)
+            return 1;
+        goto written;
+    }
+#endif
+
 #ifdef _WIN32
     int i = 0;
     int cnt=*count;
     struct iovec *vec;
     n = 0;
-    assert(!c->out.queue_len);
 
     /* Could use the WSASend win32 function for scatter/gather i/o but setting up the WSABUF struct from
        an iovec would require more work and I'm not sure of the benefit....works for now */
@@ -259,7 +268,6 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
       i++;
     }
 #else
-    assert(!c->out.queue_len);
     n = *count;
     if (n > IOV_MAX)
         n = IOV_MAX;
@@ -302,6 +310,9 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
 
 #endif /* _WIN32 */
 
+#ifdef XCB_ZTCP
+written:
+#endif
     if(n <= 0)
     {
         _xcb_conn_shutdown(c, XCB_CONN_ERROR);
@@ -350,6 +361,41 @@ int xcb_connection_has_error(xcb_connection_t *c)
 }
 
 xcb_connection_t *xcb_connect_to_fd(int fd, xcb_auth_info_t *auth_info)
+{
+    return _xcb_connect_to_fd(fd, auth_info, 0);
+}
+
+void xcb_disconnect(xcb_connection_t *c)
+{
+    if(c == NULL || is_static_error_conn(c))
+        return;
+
+    free(c->setup);
+
+    /* disallow further sends and receives */
+    shutdown(c->fd, SHUT_RDWR);
+    close(c->fd);
+
+    pthread_mutex_destroy(&c->iolock);
+    _xcb_in_destroy(&c->in);
+    _xcb_out_destroy(&c->out);
+#ifdef XCB_ZTCP
+    _xcb_ztcp_destroy(c);
+#endif
+
+    _xcb_ext_destroy(c);
+    _xcb_xid_destroy(c);
+
+    free(c);
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+/* Private interface */
+
+xcb_connection_t *_xcb_connect_to_fd(int fd, xcb_auth_info_t *auth_info, int ztcp)
 {
     xcb_connection_t* c;
 
@@ -376,6 +422,9 @@ xcb_connection_t *xcb_connect_to_fd(int fd, xcb_auth_info_t *auth_info)
         pthread_mutex_init(&c->iolock, 0) == 0 &&
         _xcb_in_init(&c->in) &&
         _xcb_out_init(&c->out) &&
+#ifdef XCB_ZTCP
+        (!ztcp || _xcb_ztcp_init(c)) &&
+#endif
         write_setup(c, auth_info) &&
         read_setup(c) &&
         _xcb_ext_init(c) &&
@@ -389,33 +438,6 @@ xcb_connection_t *xcb_connect_to_fd(int fd, xcb_auth_info_t *auth_info)
     return c;
 }
 
-void xcb_disconnect(xcb_connection_t *c)
-{
-    if(c == NULL || is_static_error_conn(c))
-        return;
-
-    free(c->setup);
-
-    /* disallow further sends and receives */
-    shutdown(c->fd, SHUT_RDWR);
-    close(c->fd);
-
-    pthread_mutex_destroy(&c->iolock);
-    _xcb_in_destroy(&c->in);
-    _xcb_out_destroy(&c->out);
-
-    _xcb_ext_destroy(c);
-    _xcb_xid_destroy(c);
-
-    free(c);
-
-#ifdef _WIN32
-    WSACleanup();
-#endif
-}
-
-/* Private interface */
-
 void _xcb_conn_shutdown(xcb_connection_t *c, int err)
 {
     c->has_error = err;
@@ -373,6 +373,31 @@ xcb_image_get (xcb_connection_t *  conn,
 }
 
 
+int
+xcb_image_get_into (xcb_connection_t *  conn,
+		    xcb_drawable_t      draw,
+		    xcb_image_t *       image,
+		    int16_t             x,
+		    int16_t             y,
+		    uint32_t            plane_mask)
+{
+  xcb_get_image_cookie_t   image_cookie;
+  xcb_get_image_reply_t *  imrep;
+  int                      ok;
+
+  image_cookie = xcb_get_image(conn, image->format, draw, x, y,
+			       image->width, image->height, plane_mask);
+  imrep = xcb_wait_for_reply_into(conn, image_cookie.sequence,
+				  image->data, image->size, 0);
+  if (!imrep)
+      return 0;
+  ok = imrep->depth == image->depth &&
+       xcb_get_image_data_length(imrep) == image->size;
+  free(imrep);
+  return ok;
+}
+
+
 xcb_image_t *
 xcb_image_native (xcb_connection_t *  c,
 		  xcb_image_t *       image,
@@ -314,6 +314,39 @@ xcb_image_get (xcb_connection_t *  conn,
 	       xcb_image_format_t  format);
 
 
+/**
+ * Read image data from the X server into an existing image.
+ * @param conn The connection to the X server.
+ * @param draw The drawable to get the image from.
+ * @param image The destination image.
+ * @param x The x coordinate in pixels, relative to the origin of the
+ * drawable and defining the upper-left corner of the rectangle.
+ * @param y The y coordinate in pixels, relative to the origin of the
+ * drawable and defining the upper-left corner of the rectangle.
+ * @param plane_mask The plane mask.  See the protocol document for details.
+ * @return 1 on success, else 0.
+ *
+ * This function reads the @p image->width by @p image->height rectangle
+ * of @p draw at @p x, @p y in @p image->format straight from the
+ * connection into @p image->data, without allocating space for it in the
+ * reply.  This suits callers that grab the same area repeatedly.
+ * The image should be in connection native format, as made by
+ * xcb_image_create_native().  For xy-pixmap images, @p plane_mask must
+ * select every plane of the image.
+ *
+ * If a problem occurs, or the data returned by the server does not
+ * have the depth and size of @p image, the function returns 0.
+ * @ingroup xcb__image_t
+ */
+int
+xcb_image_get_into (xcb_connection_t *  conn,
+		    xcb_drawable_t      draw,
+		    xcb_image_t *       image,
+		    int16_t             x,
+		    int16_t             y,
+		    uint32_t            plane_mask);
+
+
 /**
  * Put an image onto the X server.
  * @param conn The connection to the X server.
@@ -83,11 +83,18 @@ struct reply_list {
     struct reply_list *next;
 };
 
+typedef struct reply_into {
+    void *body;
+    size_t body_len;
+    int done;
+} reply_into;
+
 typedef struct pending_reply {
     uint64_t first_request;
     uint64_t last_request;
     enum workarounds workaround;
     int flags;
+    reply_into *into;
     struct pending_reply *next;
 } pending_reply;
 
@@ -176,6 +183,8 @@ static int read_packet(xcb_connection_t *c)
     uint64_t bufsize;
     void *buf;
     pending_reply *pend = 0;
+    reply_into *into = 0;
+    uint64_t bodylength = 0;
     struct event_list *event;
 
     /* Wait for there to be enough data for us to read a whole packet */
@@ -247,6 +256,17 @@ static int read_packet(xcb_connection_t *c)
          * the number of fds in the pad0 byte */
         if (pend && pend->flags & XCB_REQUEST_REPLY_FDS)
             nfd = genrep.pad0;
+
+        /* Someone is waiting in xcb_wait_for_reply_into64 with memory
+         * for the body, so only the header needs a buffer. */
+        if(pend && pend->into && !nfd && length < INT32_MAX &&
+           !(pend->flags & XCB_REQUEST_DISCARD_REPLY))
+        {
+            into = pend->into;
+            pend->into = 0;
+            bodylength = length - 32;
+            length = 32;
+        }
     }
 
     /* XGE events may have sizes > 32 */
@@ -281,6 +301,30 @@ static int read_packet(xcb_connection_t *c)
         }
     }
 
+    if (into)
+    {
+        int todo = bodylength < into->body_len ? (int) bodylength : (int) into->body_len;
+        if(todo && _xcb_in_read_block(c, into->body, todo) <= 0)
+        {
+            free(buf);
+            return 0;
+        }
+        bodylength -= todo;
+        /* Throw away whatever did not fit. */
+        while(bodylength)
+        {
+            char discard[1024];
+            todo = bodylength < sizeof(discard) ? (int) bodylength : (int) sizeof(discard);
+            if(_xcb_in_read_block(c, discard, todo) <= 0)
+            {
+                free(buf);
+                return 0;
+            }
+            bodylength -= todo;
+        }
+        into->done = 1;
+    }
+
 #if HAVE_SENDMSG
     if (nfd)
     {
@@ -365,12 +409,19 @@ static void free_reply_list(struct reply_list *head)
     }
 }
 
-static int read_block(const int fd, void *buf, const ssize_t len)
+static int read_block(xcb_connection_t *c, void *buf, const ssize_t len)
 {
+    const int fd = c->fd;
     int done = 0;
     while(done < len)
     {
-        int ret = recv(fd, ((char *) buf) + done, len - done, 0);
+        int ret;
+#ifdef XCB_ZTCP
+        if(c->ztcp)
+            ret = _xcb_ztcp_recv(c, ((char *) buf) + done, len - done);
+        else
+#endif
+        ret = recv(fd, ((char *) buf) + done, len - done, 0);
         if(ret > 0)
             done += ret;
 #ifndef _WIN32
@@ -473,11 +524,14 @@ static void insert_reader(reader_list **prev_reader, reader_list *reader, uint64
 static void remove_reader(reader_list **prev_reader, reader_list *reader)
 {
     while(*prev_reader && XCB_SEQUENCE_COMPARE((*prev_reader)->request, <=, reader->request))
+    {
         if(*prev_reader == reader)
         {
             *prev_reader = (*prev_reader)->next;
             break;
         }
+        prev_reader = &(*prev_reader)->next;
+    }
 }
 
 static void insert_special(special_list **prev_special, special_list *special, xcb_special_event_t *se)
@@ -567,25 +621,93 @@ int *xcb_get_reply_fds(xcb_connection_t *c, void *reply, size_t reply_size)
     return (int *) (&((char *) reply)[reply_size]);
 }
 
-static void insert_pending_discard(xcb_connection_t *c, pending_reply **prev_next, uint64_t seq)
+static pending_reply *insert_pending(xcb_connection_t *c, pending_reply **prev_next, uint64_t seq, int flags)
 {
     pending_reply *pend;
     pend = malloc(sizeof(*pend));
     if(!pend)
     {
         _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
-        return;
+        return 0;
     }
 
     pend->first_request = seq;
     pend->last_request = seq;
     pend->workaround = 0;
-    pend->flags = XCB_REQUEST_DISCARD_REPLY;
+    pend->flags = flags;
+    pend->into = 0;
     pend->next = *prev_next;
     *prev_next = pend;
 
     if(!pend->next)
         c->in.pending_replies_tail = &pend->next;
+    return pend;
+}
+
+static void insert_pending_discard(xcb_connection_t *c, pending_reply **prev_next, uint64_t seq)
+{
+    insert_pending(c, prev_next, seq, XCB_REQUEST_DISCARD_REPLY);
+}
+
+static void expect_reply_into(xcb_connection_t *c, uint64_t request, reply_into *into)
+{
+    pending_reply **prev_pend;
+
+    /* If we've started reading responses to this request, some of it may
+     * already be buffered; the caller copies it out instead. */
+    if(!request || XCB_SEQUENCE_COMPARE(request, <=, c->in.request_read))
+        return;
+
+    for(prev_pend = &c->in.pending_replies; *prev_pend; prev_pend = &(*prev_pend)->next)
+    {
+        if(XCB_SEQUENCE_COMPARE((*prev_pend)->first_request, >, request))
+            break;
+
+        if((*prev_pend)->first_request == request)
+        {
+            if((*prev_pend)->workaround == WORKAROUND_NONE &&
+               !((*prev_pend)->flags & (XCB_REQUEST_REPLY_FDS | XCB_REQUEST_DISCARD_REPLY)))
+                (*prev_pend)->into = into;
+            return;
+        }
+    }
+
+    /* Pending reply not found (likely due to _unchecked request). Create one: */
+    {
+        pending_reply *pend = insert_pending(c, prev_pend, request, 0);
+        if(pend)
+            pend->into = into;
+    }
+}
+
+static void forget_reply_into(xcb_connection_t *c, reply_into *into)
+{
+    pending_reply *pend;
+    for(pend = c->in.pending_replies; pend; pend = pend->next)
+        if(pend->into == into)
+            pend->into = 0;
+}
+
+static void *wait_for_reply_into(xcb_connection_t *c, uint64_t request, void *body, size_t body_len, xcb_generic_error_t **e)
+{
+    reply_into into;
+    void *ret;
+
+    into.body = body;
+    into.body_len = body_len;
+    into.done = 0;
+
+    expect_reply_into(c, request, &into);
+    ret = wait_for_reply(c, request, e);
+    forget_reply_into(c, &into);
+
+    /* The reply arrived before we could ask for it. */
+    if(ret && !into.done)
+    {
+        size_t len = (size_t) ((xcb_generic_reply_t *) ret)->length * 4;
+        memcpy(body, (char *) ret + 32, len < body_len ? len : body_len);
+    }
+    return ret;
 }
 
 static void discard_reply(xcb_connection_t *c, uint64_t request)
@@ -648,6 +770,34 @@ void xcb_discard_reply64(xcb_connection_t *c, uint64_t sequence)
     pthread_mutex_unlock(&c->iolock);
 }
 
+void *xcb_wait_for_reply_into(xcb_connection_t *c, unsigned int request, void *body, size_t body_len, xcb_generic_error_t **e)
+{
+    void *ret;
+    if(e)
+        *e = 0;
+    if(c->has_error)
+        return 0;
+
+    pthread_mutex_lock(&c->iolock);
+    ret = wait_for_reply_into(c, widen(c, request), body, body_len, e);
+    pthread_mutex_unlock(&c->iolock);
+    return ret;
+}
+
+void *xcb_wait_for_reply_into64(xcb_connection_t *c, uint64_t request, void *body, size_t body_len, xcb_generic_error_t **e)
+{
+    void *ret;
+    if(e)
+        *e = 0;
+    if(c->has_error)
+        return 0;
+
+    pthread_mutex_lock(&c->iolock);
+    ret = wait_for_reply_into(c, request, body, body_len, e);
+    pthread_mutex_unlock(&c->iolock);
+    return ret;
+}
+
 int xcb_poll_for_reply(xcb_connection_t *c, unsigned int request, void **reply, xcb_generic_error_t **error)
 {
     int ret;
@@ -944,6 +1094,7 @@ int _xcb_in_expect_reply(xcb_connection_t *c, uint64_t request, enum workarounds
     pend->first_request = pend->last_request = request;
     pend->workaround = workaround;
     pend->flags = flags;
+    pend->into = 0;
     pend->next = 0;
     *c->in.pending_replies_tail = pend;
     c->in.pending_replies_tail = &pend->next;
@@ -997,6 +1148,15 @@ int _xcb_in_read(xcb_connection_t *c)
         .msg_control = cmsgbuf.buf,
         .msg_controllen = CMSG_SPACE(sizeof(int) * (XCB_MAX_PASS_FD - c->in.in_fd.nfd)),
     };
+#ifdef XCB_ZTCP
+    if(c->ztcp)
+    {
+        /* nothing to pass fds over; the cmsg loop below must see none */
+        msg.msg_controllen = 0;
+        n = _xcb_ztcp_recv(c, iov.iov_base, iov.iov_len);
+    }
+    else
+#endif
     n = recvmsg(c->fd, &msg, 0);
 
     /* Check for truncation errors. Only MSG_CTRUNC is
@@ -1009,6 +1169,11 @@ int _xcb_in_read(xcb_connection_t *c)
         return 0;
     }
 #else
+#ifdef XCB_ZTCP
+    if(c->ztcp)
+        n = _xcb_ztcp_recv(c, c->in.queue + c->in.queue_len, sizeof(c->in.queue) - c->in.queue_len);
+    else
+#endif
     n = recv(c->fd, c->in.queue + c->in.queue_len, sizeof(c->in.queue) - c->in.queue_len, 0);
 #endif
     if(n > 0) {
@@ -1029,6 +1194,18 @@ int _xcb_in_read(xcb_connection_t *c)
     }
     while(read_packet(c))
         /* empty */;
+#ifdef XCB_ZTCP
+    /* Drain what zlib has already inflated: poll() cannot report it, and
+     * callers only come back here once the socket turns readable. */
+    while(n > 0 && c->ztcp && _xcb_ztcp_pending(c))
+    {
+        n = _xcb_ztcp_recv(c, c->in.queue + c->in.queue_len, sizeof(c->in.queue) - c->in.queue_len);
+        if(n > 0)
+            c->in.queue_len += n;
+        while(read_packet(c))
+            /* empty */;
+    }
+#endif
 #if HAVE_SENDMSG
     if (c->in.in_fd.nfd) {
         c->in.in_fd.nfd -= c->in.in_fd.ifd;
@@ -1072,7 +1249,7 @@ int _xcb_in_read_block(xcb_connection_t *c, void *buf, int len)
 
     if(len > done)
     {
-        int ret = read_block(c->fd, (char *) buf + done, len - done);
+        int ret = read_block(c, (char *) buf + done, len - done);
         if(ret <= 0)
         {
             _xcb_conn_shutdown(c, XCB_CONN_ERROR);
@@ -40,63 +40,61 @@ typedef struct node {
     void *data;
 } node;
 
+/* Keys are request sequence numbers, which are handed out consecutively,
+ * so the low bits spread them evenly over the buckets and a lookup only
+ * meets the keys that are XCB_MAP_BUCKETS requests apart. */
+#define XCB_MAP_BUCKETS 256
+
 struct _xcb_map {
-    node *head;
-    node **tail;
+    node *buckets[XCB_MAP_BUCKETS];
 };
 
 /* Private interface */
 
 _xcb_map *_xcb_map_new(void)
 {
-    _xcb_map *list;
-    list = malloc(sizeof(_xcb_map));
-    if(!list)
-        return 0;
-    list->head = 0;
-    list->tail = &list->head;
-    return list;
+    return calloc(1, sizeof(_xcb_map));
 }
 
 void _xcb_map_delete(_xcb_map *list, xcb_list_free_func_t do_free)
 {
+    int i;
     if(!list)
         return;
-    while(list->head)
-    {
-        node *cur = list->head;
-        if(do_free)
-            do_free(cur->data);
-        list->head = cur->next;
-        free(cur);
-    }
+    for(i = 0; i < XCB_MAP_BUCKETS; ++i)
+        while(list->buckets[i])
+        {
+            node *cur = list->buckets[i];
+            if(do_free)
+                do_free(cur->data);
+            list->buckets[i] = cur->next;
+            free(cur);
+        }
     free(list);
 }
 
 int _xcb_map_put(_xcb_map *list, unsigned int key, void *data)
 {
+    node **bucket = &list->buckets[key & (XCB_MAP_BUCKETS - 1)];
     node *cur = malloc(sizeof(node));
     if(!cur)
         return 0;
     cur->key = key;
     cur->data = data;
-    cur->next = 0;
-    *list->tail = cur;
-    list->tail = &cur->next;
+    cur->next = *bucket;
+    *bucket = cur;
     return 1;
 }
 
 void *_xcb_map_remove(_xcb_map *list, unsigned int key)
 {
     node **cur;
-    for(cur = &list->head; *cur; cur = &(*cur)->next)
+    for(cur = &list->buckets[key & (XCB_MAP_BUCKETS - 1)]; *cur; cur = &(*cur)->next)
         if((*cur)->key == key)
         {
             node *tmp = *cur;
             void *ret = (*cur)->data;
             *cur = (*cur)->next;
-            if(!*cur)
-                list->tail = cur;
 
             free(tmp);
             return ret;
@@ -40,6 +40,14 @@
 #include "xcbint.h"
 #include "bigreq.h"
 
+static void take_queue(xcb_connection_t *c, struct iovec *vec)
+{
+    vec->iov_base = c->out.queue;
+    vec->iov_len = c->out.queue_len;
+    c->out.queue = c->out.queue == c->out.queue_buf[0] ? c->out.queue_buf[1] : c->out.queue_buf[0];
+    c->out.queue_len = 0;
+}
+
 static __inline void send_request(xcb_connection_t *c, int isvoid, enum workarounds workaround, int flags, struct iovec *vector, int count)
 {
     if(c->has_error)
@@ -51,7 +59,7 @@ static __inline void send_request(xcb_connection_t *c, int isvoid, enum workarou
     if(workaround != WORKAROUND_NONE || flags != 0)
         _xcb_in_expect_reply(c, c->out.request, workaround, flags);
 
-    while(count && c->out.queue_len + vector[0].iov_len <= sizeof(c->out.queue))
+    while(count && c->out.queue_len + vector[0].iov_len <= XCB_QUEUE_BUFFER_SIZE)
     {
         memcpy(c->out.queue + c->out.queue_len, vector[0].iov_base, vector[0].iov_len);
         c->out.queue_len += vector[0].iov_len;
@@ -63,9 +71,7 @@ static __inline void send_request(xcb_connection_t *c, int isvoid, enum workarou
         return;
 
     --vector, ++count;
-    vector[0].iov_base = c->out.queue;
-    vector[0].iov_len = c->out.queue_len;
-    c->out.queue_len = 0;
+    take_queue(c, &vector[0]);
     _xcb_out_send(c, vector, count);
 }
 
@@ -104,17 +110,21 @@ static void get_socket_back(xcb_connection_t *c)
     _xcb_in_replies_done(c);
 }
 
-static void prepare_socket_request(xcb_connection_t *c)
+static void prepare_socket_request(xcb_connection_t *c, size_t len)
 {
-    /* We're about to append data to out.queue, so we need to
+    /* We're about to append len bytes to out.queue, so we need to
      * atomically test for an external socket owner *and* some other
      * thread currently writing.
      *
      * If we have an external socket owner, we have to get the socket back
      * before we can use it again.
      *
-     * If some other thread is writing to the socket, we assume it's
-     * writing from out.queue, and so we can't stick data there.
+     * If some other thread is writing to the socket, it may be writing
+     * from the other queue buffer, which only becomes free again once
+     * that write is done. Appending to out.queue is still fine as long
+     * as the data fits, since that will not hand the queue off to a
+     * second writer. A len that can never fit always waits for the
+     * writer to finish.
      *
      * We satisfy this condition by first calling get_socket_back
      * (which may drop the lock, but will return when XCB owns the
@@ -125,7 +135,7 @@ static void prepare_socket_request(xcb_connection_t *c)
         if(c->has_error)
             return;
         get_socket_back(c);
-        if (!c->out.writing)
+        if (!c->out.writing || len <= XCB_QUEUE_BUFFER_SIZE - c->out.queue_len)
             break;
         pthread_cond_wait(&c->out.cond, &c->iolock);
     }
@@ -194,7 +204,7 @@ static void send_fds(xcb_connection_t *c, int *fds, unsigned int num_fds)
      * prepare_socket_request() will wait for us to be done if another threads
      * tries to send fds, too). Thanks to this, we can atomically write out FDs.
      */
-    prepare_socket_request(c);
+    prepare_socket_request(c, SIZE_MAX);
 
     while (num_fds > 0) {
         while (c->out.out_fd.nfd == XCB_MAX_PASS_FD && !c->has_error) {
@@ -226,6 +236,8 @@ uint64_t xcb_send_request_with_fds64(xcb_connection_t *c, int flags, struct iove
     uint32_t prefix[2];
     int veclen = req->count;
     enum workarounds workaround = WORKAROUND_NONE;
+    size_t total = 0;
+    int v;
 
     if(c->has_error) {
         close_fds(fds, num_fds);
@@ -308,6 +320,9 @@ uint64_t xcb_send_request_with_fds64(xcb_connection_t *c, int flags, struct iove
              req->opcode == 21))
         workaround = WORKAROUND_GLX_GET_FB_CONFIGS_BUG;
 
+    for(v = 0; v < veclen; ++v)
+        total += vector[v].iov_len;
+
     /* get a sequence number and arrange for delivery. */
     pthread_mutex_lock(&c->iolock);
 
@@ -316,7 +331,7 @@ uint64_t xcb_send_request_with_fds64(xcb_connection_t *c, int flags, struct iove
      */
     send_fds(c, fds, num_fds);
 
-    prepare_socket_request(c);
+    prepare_socket_request(c, total);
 
     /* send GetInputFocus (sync_req) when 64k-2 requests have been sent without
      * a reply.
@@ -329,7 +344,7 @@ uint64_t xcb_send_request_with_fds64(xcb_connection_t *c, int flags, struct iove
            (unsigned int) (c->out.request + 1) == 0)
     {
         send_sync(c);
-        prepare_socket_request(c);
+        prepare_socket_request(c, total);
     }
 
     send_request(c, req->isvoid, workaround, flags, vector, veclen);
@@ -440,6 +455,7 @@ int _xcb_out_init(_xcb_out *out)
         return 0;
     out->writing = 0;
 
+    out->queue = out->queue_buf[0];
     out->queue_len = 0;
 
     out->request = 0;
@@ -460,10 +476,14 @@ void _xcb_out_destroy(_xcb_out *out)
 
 int _xcb_out_send(xcb_connection_t *c, struct iovec *vector, int count)
 {
+    /* Requests appended to out.queue while we drop the lock below are
+     * not part of this write. */
+    uint64_t request = c->out.request;
     int ret = 1;
     while(ret && count)
         ret = _xcb_conn_wait(c, &c->out.cond, &vector, &count);
-    c->out.request_written = c->out.request;
+    if(XCB_SEQUENCE_COMPARE(request, >, c->out.request_written))
+        c->out.request_written = request;
     pthread_cond_broadcast(&c->out.cond);
     _xcb_in_wake_up_next_reader(c);
     return ret;
@@ -471,25 +491,30 @@ int _xcb_out_send(xcb_connection_t *c, struct iovec *vector, int count)
 
 void _xcb_out_send_sync(xcb_connection_t *c)
 {
-    prepare_socket_request(c);
+    prepare_socket_request(c, sizeof(uint32_t)); /* GetInputFocus */
     send_sync(c);
 }
 
 int _xcb_out_flush_to(xcb_connection_t *c, uint64_t request)
 {
     assert(XCB_SEQUENCE_COMPARE(request, <=, c->out.request));
-    if(XCB_SEQUENCE_COMPARE(c->out.request_written, >=, request))
-        return 1;
-    if(c->out.queue_len)
+    while(XCB_SEQUENCE_COMPARE(c->out.request_written, <, request))
     {
-        struct iovec vec;
-        vec.iov_base = c->out.queue;
-        vec.iov_len = c->out.queue_len;
-        c->out.queue_len = 0;
-        return _xcb_out_send(c, &vec, 1);
+        /* The other queue buffer may still be in flight, so let the
+         * current writer finish before handing ours off. */
+        if(c->out.writing)
+        {
+            pthread_cond_wait(&c->out.cond, &c->iolock);
+            continue;
+        }
+        if(c->out.queue_len)
+        {
+            struct iovec vec;
+            take_queue(c, &vec);
+            return _xcb_out_send(c, &vec, 1);
+        }
+        assert(XCB_SEQUENCE_COMPARE(c->out.request_written, >=, request));
+        break;
     }
-    while(c->out.writing)
-        pthread_cond_wait(&c->out.cond, &c->iolock);
-    assert(XCB_SEQUENCE_COMPARE(c->out.request_written, >=, request));
     return 1;
 }
@@ -52,6 +52,10 @@
 #include <netinet/tcp.h>
 #include <fcntl.h>
 #include <netdb.h>
+#ifdef __linux__
+#include <linux/vm_sockets.h>
+#define HVSOCKCONN
+#endif
 #endif /* _WIN32 */
 
 #include "xcb.h"
@@ -232,6 +236,9 @@ static int _xcb_open_unix(char *protocol, const char *file);
 #ifdef HAVE_ABSTRACT_SOCKETS
 static int _xcb_open_abstract(char *protocol, const char *file, size_t filelen);
 #endif
+#ifdef HVSOCKCONN
+static int _xcb_open_hvsock(const char *host, const unsigned int port);
+#endif
 
 static int _xcb_open(const char *host, char *protocol, const int display)
 {
@@ -245,6 +252,28 @@ static int _xcb_open(const char *host, char *protocol, const int display)
     size_t filelen;
     char *file = NULL;
     int actual_filelen;
+#ifdef _WIN32
+    /* The server puts its sockets in %TEMP%, see Xtranssock.c */
+    char win_base[MAX_PATH + sizeof(".X11-unix\\X")];
+    DWORD win_len = GetTempPathA(MAX_PATH, win_base);
+
+    if (win_len > 0 && win_len < MAX_PATH) {
+        strcpy(win_base + win_len, ".X11-unix\\X");
+        base = win_base;
+    }
+#endif
+
+#ifdef HVSOCKCONN
+    /* display specifies a vsock to the VM host, or to the CID in host */
+    if (protocol && strcmp("hvsock",protocol) == 0)
+        return _xcb_open_hvsock(host, X_TCP_PORT + display);
+#endif
+
+#ifdef XCB_ZTCP
+    /* the compressed listener sits beside the plain TCP one */
+    if (protocol && strcmp("ztcp",protocol) == 0)
+        return _xcb_open_tcp(host, NULL, X_TCP_PORT + XCB_ZTCP_PORT_OFFSET + display);
+#endif
 
     /* If protocol or host is "unix", fall through to Unix socket code below */
     if ((!protocol || (strcmp("unix",protocol) != 0)) &&
@@ -457,6 +486,34 @@ static int _xcb_open_tcp(const char *host, char *protocol, const unsigned short
 #endif
 }
 
+#ifdef HVSOCKCONN
+static int _xcb_open_hvsock(const char *host, const unsigned int port)
+{
+    int fd;
+    struct sockaddr_vm addr;
+    char *end;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.svm_family = AF_VSOCK;
+    addr.svm_port = port;
+    addr.svm_cid = VMADDR_CID_HOST;
+    if (*host != '\0') {
+        addr.svm_cid = strtoul(host, &end, 10);
+        if (*end != '\0')
+            return -1;
+    }
+
+    fd = _xcb_socket(AF_VSOCK, SOCK_STREAM, 0);
+    if(fd == -1)
+        return -1;
+    if(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+#endif /* HVSOCKCONN */
+
 #ifdef UNIXCONN
 static int _xcb_open_unix(char *protocol, const char *file)
 {
@@ -468,6 +525,13 @@ static int _xcb_open_unix(char *protocol, const char *file)
     if (protocol && strcmp("unix",protocol))
         return -1;
 
+#ifdef _WIN32
+    if (InitWSA()<0)
+      return -1;
+#endif
+
+    if (strlen(file) >= sizeof(addr.sun_path))
+        return -1;
     strcpy(addr.sun_path, file);
     addr.sun_family = AF_UNIX;
 #ifdef HAVE_SOCKADDR_SUN_LEN
@@ -528,6 +592,7 @@ xcb_connection_t *xcb_connect_to_display_with_auth_info(const char *displayname,
     char *protocol = NULL;
     xcb_auth_info_t ourauth;
     xcb_connection_t *c;
+    int ztcp;
 
     int parsed = _xcb_parse_display(displayname, &host, &protocol, &display, screenp);
 
@@ -554,19 +619,21 @@ xcb_connection_t *xcb_connect_to_display_with_auth_info(const char *displayname,
         goto out;
     }
 
+    ztcp = protocol && strcmp("ztcp",protocol) == 0;
+
     if(auth) {
-        c = xcb_connect_to_fd(fd, auth);
+        c = _xcb_connect_to_fd(fd, auth, ztcp);
         goto out;
     }
 
     if(_xcb_get_auth_info(fd, &ourauth, display))
     {
-        c = xcb_connect_to_fd(fd, &ourauth);
+        c = _xcb_connect_to_fd(fd, &ourauth, ztcp);
         free(ourauth.name);
         free(ourauth.data);
     }
     else
-        c = xcb_connect_to_fd(fd, 0);
+        c = _xcb_connect_to_fd(fd, 0, ztcp);
 
     if(c->has_error)
         goto out;
@@ -0,0 +1,237 @@
+/* Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* The compressed "ztcp" transport: both directions of the X stream are
+ * zlib streams, sync flushed at the end of every write so that whatever
+ * was flushed as whole requests arrives as whole requests. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef XCB_ZTCP
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "xcb.h"
+#include "xcbint.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+/* fastest level: on a slow link any compression is most of the win */
+#define ZTCP_LEVEL 1
+#define ZTCP_BUFSIZE 16384
+
+struct _xcb_ztcp {
+    z_stream in;
+    z_stream out;
+    int in_full;        /* the last inflate() filled the caller's buffer */
+    int out_dirty;      /* deflate() has input not yet sync flushed */
+    int owed;           /* bytes consumed but not yet reported as written */
+    int out_len;
+    unsigned char in_buf[ZTCP_BUFSIZE];
+    unsigned char out_buf[ZTCP_BUFSIZE];
+};
+
+static int would_block(void)
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+/* Returns 1 once out_buf is empty, 0 if the socket is full, -1 on error. */
+static int send_out(xcb_connection_t *c, struct _xcb_ztcp *z)
+{
+    while(z->out_len > 0)
+    {
+        int n = send(c->fd, (char *) z->out_buf, z->out_len, 0);
+        if(n <= 0)
+            return (n < 0 && would_block()) ? 0 : -1;
+        z->out_len -= n;
+        memmove(z->out_buf, z->out_buf + n, z->out_len);
+    }
+    return 1;
+}
+
+static void deflate_into(struct _xcb_ztcp *z, int flush)
+{
+    z->out.next_out = z->out_buf + z->out_len;
+    z->out.avail_out = ZTCP_BUFSIZE - z->out_len;
+    deflate(&z->out, flush);
+    z->out_len = ZTCP_BUFSIZE - z->out.avail_out;
+}
+
+/* Finish any pending sync flush and send everything. */
+static int flush_out(xcb_connection_t *c, struct _xcb_ztcp *z)
+{
+    int ret;
+    while(z->out_dirty)
+    {
+        z->out.avail_in = 0;
+        deflate_into(z, Z_SYNC_FLUSH);
+        if(z->out.avail_out)
+            z->out_dirty = 0;
+        ret = send_out(c, z);
+        if(ret <= 0)
+            return ret;
+    }
+    return send_out(c, z);
+}
+
+int _xcb_ztcp_init(xcb_connection_t *c)
+{
+    struct _xcb_ztcp *z = calloc(1, sizeof(struct _xcb_ztcp));
+    if(!z)
+        return 0;
+    if(inflateInit(&z->in) != Z_OK)
+    {
+        free(z);
+        return 0;
+    }
+    if(deflateInit(&z->out, ZTCP_LEVEL) != Z_OK)
+    {
+        inflateEnd(&z->in);
+        free(z);
+        return 0;
+    }
+    c->ztcp = z;
+    return 1;
+}
+
+void _xcb_ztcp_destroy(xcb_connection_t *c)
+{
+    struct _xcb_ztcp *z = c->ztcp;
+    if(!z)
+        return;
+    inflateEnd(&z->in);
+    deflateEnd(&z->out);
+    free(z);
+    c->ztcp = 0;
+}
+
+int _xcb_ztcp_pending(xcb_connection_t *c)
+{
+    return c->ztcp->in.avail_in > 0 || c->ztcp->in_full;
+}
+
+int _xcb_ztcp_recv(xcb_connection_t *c, void *buf, int len)
+{
+    struct _xcb_ztcp *z = c->ztcp;
+    int ret, n;
+
+    if(len <= 0)
+        return 0;
+    while(1)
+    {
+        if(!z->in.avail_in && !z->in_full)
+        {
+            n = recv(c->fd, (char *) z->in_buf, ZTCP_BUFSIZE, 0);
+            if(n <= 0)
+                return n;
+            z->in.next_in = z->in_buf;
+            z->in.avail_in = n;
+        }
+        z->in.next_out = buf;
+        z->in.avail_out = len;
+        ret = inflate(&z->in, Z_SYNC_FLUSH);
+        /* the peer never finishes its stream, so Z_STREAM_END is bad data */
+        if(ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+#ifdef _WIN32
+            WSASetLastError(WSAECONNABORTED);
+#else
+            errno = EIO;
+#endif
+            return -1;
+        }
+        z->in_full = !z->in.avail_out;
+        n = len - z->in.avail_out;
+        if(n)
+            return n;
+    }
+}
+
+/* Every byte consumed is compressed and handed to the socket before this
+ * returns a count covering it.  When the last of it is still queued
+ * here, one byte is held back from the count: the caller then waits for
+ * the socket to drain and offers that byte again, which is skipped.
+ * Returns 0 when the socket is too full to take anything yet. */
+int _xcb_ztcp_writev(xcb_connection_t *c, struct iovec *vector, int count)
+{
+    struct _xcb_ztcp *z = c->ztcp;
+    int i, ret, done = 0;
+
+    ret = flush_out(c, z);
+    if(ret <= 0)
+        return ret;
+
+    for(i = 0; i < count; ++i)
+    {
+        char *base = vector[i].iov_base;
+        int len = vector[i].iov_len;
+
+        if(z->owed)
+        {
+            int skip = len < z->owed ? len : z->owed;
+            base += skip;
+            len -= skip;
+            done += skip;
+            z->owed -= skip;
+        }
+        while(len > 0)
+        {
+            if(z->out_len == ZTCP_BUFSIZE)
+            {
+                ret = send_out(c, z);
+                if(ret < 0)
+                    return -1;
+                if(ret == 0)
+                    return done;
+            }
+            z->out.next_in = (Bytef *) base;
+            z->out.avail_in = len;
+            deflate_into(z, Z_NO_FLUSH);
+            base += len - z->out.avail_in;
+            done += len - z->out.avail_in;
+            len = z->out.avail_in;
+            z->out_dirty = 1;
+        }
+    }
+
+    ret = flush_out(c, z);
+    if(ret < 0)
+        return -1;
+    if(ret == 0 && done > 0)
+    {
+        z->owed = 1;
+        --done;
+    }
+    return done;
+}
+
+#endif /* XCB_ZTCP */
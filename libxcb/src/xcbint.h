@@ -98,7 +98,11 @@ typedef struct _xcb_out {
     void *socket_closure;
     int socket_moving;
 
-    char queue[XCB_QUEUE_BUFFER_SIZE];
+    /* Requests are appended to queue, which points at one of queue_buf.
+     * A full queue is handed to the writer and the other buffer takes its
+     * place, so other threads keep appending while the socket write runs. */
+    char queue_buf[2][XCB_QUEUE_BUFFER_SIZE];
+    char *queue;
     int queue_len;
 
     uint64_t request;
@@ -190,6 +194,20 @@ int _xcb_ext_init(xcb_connection_t *c);
 void _xcb_ext_destroy(xcb_connection_t *c);
 
 
+/* xcb_ztcp.c */
+
+#ifdef XCB_ZTCP
+/** X_TCP_PORT + XCB_ZTCP_PORT_OFFSET + display number = server port for ztcp */
+#define XCB_ZTCP_PORT_OFFSET 100
+
+int _xcb_ztcp_init(xcb_connection_t *c);
+void _xcb_ztcp_destroy(xcb_connection_t *c);
+int _xcb_ztcp_pending(xcb_connection_t *c);
+int _xcb_ztcp_recv(xcb_connection_t *c, void *buf, int len);
+int _xcb_ztcp_writev(xcb_connection_t *c, struct iovec *vector, int count);
+#endif
+
+
 /* xcb_conn.c */
 
 struct xcb_connection_t {
@@ -199,6 +217,9 @@ struct xcb_connection_t {
     /* constant data */
     xcb_setup_t *setup;
     int fd;
+#ifdef XCB_ZTCP
+    struct _xcb_ztcp *ztcp;
+#endif
 
     /* I/O data */
     pthread_mutex_t iolock;
@@ -216,6 +237,8 @@ xcb_connection_t *_xcb_conn_ret_error(int err);
 
 int _xcb_conn_wait(xcb_connection_t *c, pthread_cond_t *cond, struct iovec **vector, int *count);
 
+xcb_connection_t *_xcb_connect_to_fd(int fd, xcb_auth_info_t *auth_info, int ztcp);
+
 
 /* xcb_auth.c */
 
@@ -592,6 +592,17 @@ generate_call(exec_list *instructions, ir_function_signature *sig,
       }
    }
 
+   /* Built-ins which just return an expression of their parameters become
+    * that expression, without a call to inline.
+    */
+   if (sig->is_builtin() && sub_var == NULL) {
+      ir_rvalue *value = sig->inline_expression(ctx, actual_parameters);
+      if (value != NULL) {
+         instructions->append_list(&post_call_conversions);
+         return value;
+      }
+   }
+
    ir_dereference_variable *deref = NULL;
    if (!sig->return_type->is_void()) {
       /* Create a new temporary to hold the return value. */
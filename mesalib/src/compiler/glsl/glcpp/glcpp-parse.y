@@ -1015,6 +1015,10 @@ _token_list_append_list(token_list_t *list, token_list_t *tail)
    list->non_space_tail = tail->non_space_tail;
 }
 
+/* Tokens are never changed once created, (expansion and pasting replace
+ * the nodes pointing at them instead), so the copy shares the tokens and
+ * only gets nodes of its own.
+ */
 static token_list_t *
 _token_list_copy(glcpp_parser_t *parser, token_list_t *other)
 {
@@ -1025,11 +1029,8 @@ _token_list_copy(glcpp_parser_t *parser, token_list_t *other)
       return NULL;
 
    copy = _token_list_create (parser);
-   for (node = other->head; node; node = node->next) {
-      token_t *new_token = linear_alloc_child(parser->linalloc, sizeof(token_t));
-      *new_token = *node->token;
-      _token_list_append (parser, copy, new_token);
-   }
+   for (node = other->head; node; node = node->next)
+      _token_list_append (parser, copy, node->token);
 
    return copy;
 }
@@ -1917,8 +1918,9 @@ _parser_active_list_push(glcpp_parser_t *parser, const char *identifier,
 {
    active_list_t *node;
 
+   /* The identifier is a token's, which lives as long as the parser. */
    node = linear_alloc_child(parser->linalloc, sizeof(active_list_t));
-   node->identifier = linear_strdup(parser->linalloc, identifier);
+   node->identifier = identifier;
    node->marker = marker;
    node->next = parser->active;
 
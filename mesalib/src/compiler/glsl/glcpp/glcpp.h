@@ -246,6 +246,14 @@ glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 		 glcpp_extension_iterator extensions, void *state,
 		 struct gl_context *g_ctx);
 
+/* Cache of preprocessed shaders, one per context */
+
+struct glcpp_cache *
+glcpp_cache_create(void);
+
+void
+glcpp_cache_destroy(struct glcpp_cache *cache);
+
 /* Functions for writing to the info log */
 
 void
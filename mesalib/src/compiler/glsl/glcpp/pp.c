@@ -22,11 +22,39 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include "glcpp.h"
+#include "c11/threads.h"
+#include "util/list.h"
+#include "util/mesa-sha1.h"
 #include "main/mtypes.h"
 
+/* Most preprocessed text a context keeps around */
+#define GLCPP_CACHE_MAX_SIZE (8 << 20)
+
+struct glcpp_cache_entry {
+	unsigned char key[20];
+	char *output;
+	char *info_log;
+	int errors;
+	size_t size;
+	struct list_head link;
+};
+
+/* A context's preprocessed shaders, most recently used first.
+ *
+ * The only thing the output depends on besides the source is the context,
+ * the extensions and limits of which decide the predefined macros, so the
+ * entries are keyed by the hash of the source.
+ */
+struct glcpp_cache {
+	mtx_t lock;
+	struct list_head entries;
+	size_t size;
+};
+
 void
 glcpp_error (YYLTYPE *locp, glcpp_parser_t *parser, const char *fmt, ...)
 {
@@ -221,14 +249,137 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	return sb->buf;
 }
 
+struct glcpp_cache *
+glcpp_cache_create(void)
+{
+	struct glcpp_cache *cache = calloc(1, sizeof(*cache));
+
+	if (cache == NULL)
+		return NULL;
+
+	mtx_init(&cache->lock, mtx_plain);
+	list_inithead(&cache->entries);
+	return cache;
+}
+
+static void
+glcpp_cache_entry_free(struct glcpp_cache_entry *entry)
+{
+	list_del(&entry->link);
+	free(entry->output);
+	free(entry->info_log);
+	free(entry);
+}
+
+void
+glcpp_cache_destroy(struct glcpp_cache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	list_for_each_entry_safe(struct glcpp_cache_entry, entry,
+				 &cache->entries, link)
+		glcpp_cache_entry_free(entry);
+	mtx_destroy(&cache->lock);
+	free(cache);
+}
+
+static void
+glcpp_cache_compute_key(const char *shader,
+			glcpp_extension_iterator extensions,
+			unsigned char key[20])
+{
+	struct mesa_sha1 ctx;
+
+	/* The standalone tools preprocess without the predefined
+	 * extension macros. */
+	_mesa_sha1_init(&ctx);
+	_mesa_sha1_update(&ctx, &extensions, sizeof(extensions));
+	_mesa_sha1_update(&ctx, shader, strlen(shader));
+	_mesa_sha1_final(&ctx, key);
+}
+
+static bool
+glcpp_cache_lookup(struct glcpp_cache *cache, const unsigned char key[20],
+		   void *ralloc_ctx, const char **shader, char **info_log,
+		   int *errors)
+{
+	bool found = false;
+
+	mtx_lock(&cache->lock);
+	list_for_each_entry(struct glcpp_cache_entry, entry,
+			    &cache->entries, link) {
+		if (memcmp(entry->key, key, sizeof(entry->key)) == 0) {
+			*shader = ralloc_strdup(ralloc_ctx, entry->output);
+			ralloc_strcat(info_log, entry->info_log);
+			*errors = entry->errors;
+			list_del(&entry->link);
+			list_add(&entry->link, &cache->entries);
+			found = true;
+			break;
+		}
+	}
+	mtx_unlock(&cache->lock);
+
+	return found;
+}
+
+static void
+glcpp_cache_insert(struct glcpp_cache *cache, const unsigned char key[20],
+		   const char *output, const char *info_log, int errors)
+{
+	struct glcpp_cache_entry *entry;
+
+	entry = malloc(sizeof(*entry));
+	if (entry == NULL)
+		return;
+
+	memcpy(entry->key, key, sizeof(entry->key));
+	entry->output = strdup(output);
+	entry->info_log = strdup(info_log);
+	entry->errors = errors;
+	entry->size = sizeof(*entry) + strlen(output) + strlen(info_log) + 2;
+	if (entry->output == NULL || entry->info_log == NULL ||
+	    entry->size > GLCPP_CACHE_MAX_SIZE / 4) {
+		free(entry->output);
+		free(entry->info_log);
+		free(entry);
+		return;
+	}
+
+	mtx_lock(&cache->lock);
+	list_add(&entry->link, &cache->entries);
+	cache->size += entry->size;
+	while (cache->size > GLCPP_CACHE_MAX_SIZE) {
+		struct glcpp_cache_entry *oldest =
+			LIST_ENTRY(struct glcpp_cache_entry,
+				   cache->entries.prev, link);
+
+		cache->size -= oldest->size;
+		glcpp_cache_entry_free(oldest);
+	}
+	mtx_unlock(&cache->lock);
+}
+
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
                  glcpp_extension_iterator extensions, void *state,
                  struct gl_context *gl_ctx)
 {
+	struct glcpp_cache *cache = gl_ctx->PreprocessorCache;
+	unsigned char key[20];
 	int errors;
-	glcpp_parser_t *parser =
-		glcpp_parser_create(&gl_ctx->Extensions, extensions, state, gl_ctx->API);
+	glcpp_parser_t *parser;
+
+	if (cache) {
+		glcpp_cache_compute_key(*shader, extensions, key);
+		if (glcpp_cache_lookup(cache, key, ralloc_ctx, shader,
+				       info_log, &errors))
+			return errors;
+	}
+
+	parser = glcpp_parser_create(&gl_ctx->Extensions, extensions, state,
+				     gl_ctx->API);
 
 	if (! gl_ctx->Const.DisableGLSLLineContinuations)
 		*shader = remove_line_continuations(parser, *shader);
@@ -251,6 +402,11 @@ glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 	*shader = parser->output->buf;
 
 	errors = parser->error;
+
+	if (cache)
+		glcpp_cache_insert(cache, key, *shader, parser->info_log->buf,
+				   errors);
+
 	glcpp_parser_destroy (parser);
 	return errors;
 }
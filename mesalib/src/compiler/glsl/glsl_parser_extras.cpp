@@ -32,8 +32,10 @@
 #include "main/shaderobj.h"
 #include "util/u_atomic.h" /* for p_atomic_cmpxchg */
 #include "util/ralloc.h"
+#include "util/debug.h"
 #include "util/disk_cache.h"
 #include "util/mesa-sha1.h"
+#include "util/os_time.h"
 #include "ast.h"
 #include "glsl_parser_extras.h"
 #include "glsl_parser.h"
@@ -2015,8 +2017,10 @@ opt_shader_and_create_symbol_table(struct gl_context *ctx,
                              ctx->Const.NativeIntegers);
    } else {
       /* Repeat it until it stops making changes. */
+      opt_pass_tracker tracker;
+
       while (do_common_optimization(shader->ir, false, false, options,
-                                    ctx->Const.NativeIntegers))
+                                    ctx->Const.NativeIntegers, &tracker))
          ;
    }
 
@@ -2187,27 +2191,132 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
  *                                    natively (as opposed to supporting
  *                                    integers in floating point registers).
  */
+/**
+ * Time spent in each pass of do_common_optimization(), printed at exit
+ * when GLSL_OPT_STATS is set.  The passes are numbered in the order they
+ * appear in the function.
+ */
+struct opt_pass_stats {
+   const char *name;
+   uint64_t nsecs;
+   unsigned runs;
+   unsigned progress;
+   unsigned skipped;
+};
+
+static struct opt_pass_stats opt_stats[64];
+static mtx_t opt_stats_lock = _MTX_INITIALIZER_NP;
+
+static void
+print_opt_stats(void)
+{
+   fprintf(stderr, "GLSL optimization passes:\n"
+           "     ms     runs progress  skipped  pass\n");
+   for (unsigned i = 0; i < ARRAY_SIZE(opt_stats); i++) {
+      const struct opt_pass_stats *stats = &opt_stats[i];
+
+      if (!stats->name)
+         continue;
+      fprintf(stderr, "%9.2f %8u %8u %8u  %s\n", stats->nsecs / 1e6,
+              stats->runs, stats->progress, stats->skipped, stats->name);
+   }
+}
+
+static bool
+opt_stats_enabled(void)
+{
+   static const bool enabled = env_var_as_boolean("GLSL_OPT_STATS", false);
+   static bool registered;
+
+   if (enabled && !registered) {
+      mtx_lock(&opt_stats_lock);
+      if (!registered)
+         atexit(print_opt_stats);
+      registered = true;
+      mtx_unlock(&opt_stats_lock);
+   }
+   return enabled;
+}
+
+static void
+record_opt_stats(unsigned pass, const char *name, int64_t nsecs,
+                 bool ran, bool progress)
+{
+   struct opt_pass_stats *stats = &opt_stats[pass];
+
+   mtx_lock(&opt_stats_lock);
+   stats->name = name;
+   if (ran) {
+      stats->nsecs += nsecs;
+      stats->runs++;
+      stats->progress += progress;
+   } else {
+      stats->skipped++;
+   }
+   mtx_unlock(&opt_stats_lock);
+}
+
+/**
+ * Run the passes common to compiling and linking once.
+ *
+ * \param tracker  passed by loops repeating this until it makes no
+ *                 progress, to skip the passes with nothing left to do
+ *
+ * \return whether any pass made progress
+ */
 bool
 do_common_optimization(exec_list *ir, bool linked,
 		       bool uniform_locations_assigned,
                        const struct gl_shader_compiler_options *options,
-                       bool native_integers)
+                       bool native_integers,
+                       opt_pass_tracker *tracker)
 {
    const bool debug = false;
+   const bool stats = opt_stats_enabled();
    GLboolean progress = GL_FALSE;
 
+   enum { opt_first_pass = __COUNTER__ + 1 };
+
+   /* Whether the pass numbered PASS found nothing to do since the IR last
+    * changed, and what to remember once it has run.
+    */
+#define OPT_CLEAN(PASS)                                                 \
+   (tracker && tracker->clean[PASS] == tracker->generation)
+#define OPT_DONE(PASS, PROGRESS) do {                                   \
+      if (tracker) {                                                    \
+         if (PROGRESS)                                                  \
+            tracker->generation++;                                      \
+         else                                                           \
+            tracker->clean[PASS] = tracker->generation;                 \
+      }                                                                 \
+   } while (false)
+
 #define OPT(PASS, ...) do {                                             \
+      const unsigned opt_pass = __COUNTER__ - opt_first_pass;           \
+      if (OPT_CLEAN(opt_pass)) {                                        \
+         if (stats)                                                     \
+            record_opt_stats(opt_pass, #PASS, 0, false, false);         \
+         break;                                                         \
+      }                                                                 \
+      const int64_t opt_start = stats ? os_time_get_nano() : 0;         \
+      bool opt_progress;                                                \
       if (debug) {                                                      \
          fprintf(stderr, "START GLSL optimization %s\n", #PASS);        \
-         const bool opt_progress = PASS(__VA_ARGS__);                   \
-         progress = opt_progress || progress;                           \
+         opt_progress = PASS(__VA_ARGS__);                              \
          if (opt_progress)                                              \
             _mesa_print_ir(stderr, ir, NULL);                           \
          fprintf(stderr, "GLSL optimization %s: %s progress\n",         \
                  #PASS, opt_progress ? "made" : "no");                  \
       } else {                                                          \
-         progress = PASS(__VA_ARGS__) || progress;                      \
+         opt_progress = PASS(__VA_ARGS__);                              \
+      }                                                                 \
+      progress = opt_progress || progress;                              \
+      if (stats) {                                                      \
+         record_opt_stats(opt_pass, #PASS,                              \
+                          os_time_get_nano() - opt_start, true,         \
+                          opt_progress);                                \
       }                                                                 \
+      OPT_DONE(opt_pass, opt_progress);                                 \
    } while (false)
 
    OPT(lower_instructions, ir, SUB_TO_ADD_NEG);
@@ -2254,10 +2363,17 @@ do_common_optimization(exec_list *ir, bool linked,
    OPT(optimize_split_arrays, ir, linked);
    OPT(optimize_redundant_jumps, ir);
 
-   if (options->MaxUnrollIterations) {
+   const unsigned unroll_pass = __COUNTER__ - opt_first_pass;
+   if (options->MaxUnrollIterations && OPT_CLEAN(unroll_pass)) {
+      if (stats)
+         record_opt_stats(unroll_pass, "unroll_loops", 0, false, false);
+   } else if (options->MaxUnrollIterations) {
+      const int64_t unroll_start = stats ? os_time_get_nano() : 0;
+      bool unroll_changed = false;
       loop_state *ls = analyze_loop_variables(ir);
       if (ls->loop_found) {
          bool loop_progress = unroll_loops(ir, ls, options);
+         unroll_changed = loop_progress;
          while (loop_progress) {
             loop_progress = false;
             loop_progress |= do_constant_propagation(ir);
@@ -2284,9 +2400,23 @@ do_common_optimization(exec_list *ir, bool linked,
          progress |= loop_progress;
       }
       delete ls;
+
+      /* The unrolling is not counted as progress, but the passes must
+       * still look at the unrolled IR.
+       */
+      if (stats) {
+         record_opt_stats(unroll_pass, "unroll_loops",
+                          os_time_get_nano() - unroll_start, true,
+                          unroll_changed);
+      }
+      OPT_DONE(unroll_pass, unroll_changed);
    }
 
+   STATIC_ASSERT(__COUNTER__ - opt_first_pass <= ARRAY_SIZE(opt_stats));
+
 #undef OPT
+#undef OPT_DONE
+#undef OPT_CLEAN
 
    return progress;
 }
@@ -982,6 +982,7 @@ extern "C" {
 #endif
 
 struct glcpp_parser;
+struct glcpp_cache;
 
 typedef void (*glcpp_extension_iterator)(
               struct _mesa_glsl_parse_state *state,
@@ -995,6 +996,9 @@ extern int glcpp_preprocess(void *ctx, const char **shader, char **info_log,
                             struct _mesa_glsl_parse_state *state,
                             struct gl_context *gl_ctx);
 
+extern struct glcpp_cache *glcpp_cache_create(void);
+extern void glcpp_cache_destroy(struct glcpp_cache *cache);
+
 extern void _mesa_destroy_shader_compiler(void);
 extern void _mesa_destroy_shader_compiler_caches(void);
 
@@ -1181,6 +1181,14 @@ public:
                                           exec_list *actual_parameters,
                                           struct hash_table *variable_context);
 
+   /**
+    * If this is a built-in whose body only returns an expression of its
+    * 'in' parameters, build that expression from the actual parameters,
+    * which are moved out of \c actual_parameters, so that the call needs no
+    * inlined copy of the body.  Returns NULL otherwise.
+    */
+   ir_rvalue *inline_expression(void *mem_ctx, exec_list *actual_parameters);
+
    /**
     * Get the name of the function for which this is a signature
     */
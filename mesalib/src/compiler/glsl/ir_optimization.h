@@ -90,10 +90,33 @@ enum lower_packing_builtins_op {
    LOWER_PACK_USE_BFE                   = 0x0800,
 };
 
+/**
+ * What do_common_optimization() remembers between the calls of a loop
+ * which repeats it on the same IR until it stops making changes.
+ *
+ * A pass which made no progress need not run again until another pass
+ * has made some, as it would find the same IR, so the passes skipped are
+ * those which found nothing to do at the current generation.  This relies
+ * on every pass reporting progress whenever it changes the IR, which the
+ * loop relies on anyway to stop.
+ */
+struct opt_pass_tracker {
+   opt_pass_tracker() : generation(1), clean()
+   {
+   }
+
+   /** Bumped every time a pass makes progress */
+   unsigned generation;
+
+   /** Generation each pass last found nothing to do at, 0 for none */
+   unsigned clean[64];
+};
+
 bool do_common_optimization(exec_list *ir, bool linked,
 			    bool uniform_locations_assigned,
                             const struct gl_shader_compiler_options *options,
-                            bool native_integers);
+                            bool native_integers,
+                            opt_pass_tracker *tracker = NULL);
 
 bool ir_constant_fold(ir_rvalue **rvalue);
 
@@ -4851,9 +4851,11 @@ linker_optimisation_loop(struct gl_context *ctx, exec_list *ir,
                                 ctx->Const.NativeIntegers);
       } else {
          /* Repeat it until it stops making changes. */
+         opt_pass_tracker tracker;
+
          while (do_common_optimization(ir, true, false,
                                        &ctx->Const.ShaderCompilerOptions[stage],
-                                       ctx->Const.NativeIntegers))
+                                       ctx->Const.NativeIntegers, &tracker))
             ;
       }
 }
@@ -29,6 +29,7 @@
 
 #include "ir.h"
 #include "ir_visitor.h"
+#include "ir_rvalue_visitor.h"
 #include "ir_function_inlining.h"
 #include "ir_expression_flattening.h"
 #include "compiler/glsl_types.h"
@@ -67,6 +68,88 @@ public:
    virtual ir_visitor_status visit_enter(ir_dereference_array *);
 };
 
+/* Most built-ins have few parameters; others are inlined as usual. */
+#define MAX_INLINE_EXPRESSION_PARAMS 8
+
+/**
+ * Counts the references to each parameter of a signature in an rvalue, and
+ * notes references to any other variable.
+ */
+class ir_parameter_refcount_visitor : public ir_hierarchical_visitor {
+public:
+   ir_parameter_refcount_visitor(exec_list *parameters)
+      : parameters(parameters), other_references(false)
+   {
+      memset(count, 0, sizeof(count));
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir)
+   {
+      unsigned i = 0;
+
+      foreach_in_list(ir_variable, param, parameters) {
+         if (param == ir->var) {
+            count[i]++;
+            return visit_continue;
+         }
+         i++;
+      }
+
+      other_references = true;
+      return visit_stop;
+   }
+
+   exec_list *parameters;
+   unsigned count[MAX_INLINE_EXPRESSION_PARAMS];
+   bool other_references;
+};
+
+/**
+ * Replaces the references to the parameters of a signature with the actual
+ * parameters.
+ */
+class ir_parameter_replacement_visitor : public ir_rvalue_visitor {
+public:
+   ir_parameter_replacement_visitor(void *mem_ctx, exec_list *parameters,
+                                    ir_rvalue **actuals)
+      : mem_ctx(mem_ctx), parameters(parameters), actuals(actuals)
+   {
+      memset(used, 0, sizeof(used));
+   }
+
+   ir_rvalue *replacement(ir_variable *var)
+   {
+      unsigned i = 0;
+
+      foreach_in_list(ir_variable, param, parameters) {
+         if (param == var) {
+            if (!used[i]) {
+               used[i] = true;
+               return actuals[i];
+            }
+            return actuals[i]->clone(mem_ctx, NULL);
+         }
+         i++;
+      }
+
+      return NULL;
+   }
+
+   virtual void handle_rvalue(ir_rvalue **rvalue)
+   {
+      ir_dereference_variable *deref =
+         *rvalue ? (*rvalue)->as_dereference_variable() : NULL;
+
+      if (deref)
+         *rvalue = replacement(deref->var);
+   }
+
+   void *mem_ctx;
+   exec_list *parameters;
+   ir_rvalue **actuals;
+   bool used[MAX_INLINE_EXPRESSION_PARAMS];
+};
+
 } /* unnamed namespace */
 
 bool
@@ -131,6 +214,74 @@ ir_save_lvalue_visitor::visit_enter(ir_dereference_array *deref)
    return visit_stop;
 }
 
+static bool
+is_cheap_to_repeat(ir_rvalue *ir)
+{
+   ir_swizzle *swiz = ir->as_swizzle();
+
+   if (swiz)
+      ir = swiz->val;
+   return ir->as_constant() || ir->as_dereference_variable();
+}
+
+ir_rvalue *
+ir_function_signature::inline_expression(void *mem_ctx,
+                                         exec_list *actual_parameters)
+{
+   ir_rvalue *actuals[MAX_INLINE_EXPRESSION_PARAMS];
+   unsigned i;
+
+   if (!is_builtin() || is_intrinsic() || body.is_empty() ||
+       body.get_head() != body.get_tail())
+      return NULL;
+
+   ir_return *ret = ((ir_instruction *) body.get_head())->as_return();
+   if (!ret || !ret->value)
+      return NULL;
+
+   if (parameters.length() > MAX_INLINE_EXPRESSION_PARAMS)
+      return NULL;
+
+   i = 0;
+   foreach_two_lists(formal_node, &parameters,
+                     actual_node, actual_parameters) {
+      ir_variable *sig_param = (ir_variable *) formal_node;
+
+      if ((sig_param->data.mode != ir_var_function_in &&
+           sig_param->data.mode != ir_var_const_in) ||
+          sig_param->type->contains_opaque())
+         return NULL;
+
+      actuals[i++] = (ir_rvalue *) actual_node;
+   }
+
+   ir_parameter_refcount_visitor refs(&parameters);
+   ret->value->accept(&refs);
+   if (refs.other_references)
+      return NULL;
+
+   /* Each actual parameter is evaluated once by the call, so only repeat
+    * the ones which cost nothing.
+    */
+   for (i = 0; i < parameters.length(); i++) {
+      if (refs.count[i] > 1 && !is_cheap_to_repeat(actuals[i]))
+         return NULL;
+   }
+
+   for (i = 0; i < parameters.length(); i++)
+      actuals[i]->remove();
+
+   ir_parameter_replacement_visitor v(mem_ctx, &parameters, actuals);
+   ir_rvalue *value = ret->value->clone(mem_ctx, NULL);
+   ir_dereference_variable *deref = value->as_dereference_variable();
+
+   if (deref)
+      return v.replacement(deref->var);
+
+   value->accept(&v);
+   return value;
+}
+
 static bool
 should_replace_variable(ir_variable *sig_param, ir_rvalue *param) {
    /* For opaque types, we want the inlined variable references
@@ -26,6 +26,7 @@
 #include "compiler/glsl/glsl_parser_extras.h"
 #include "glsl_types.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 #include "util/u_string.h"
 
 
@@ -37,6 +38,27 @@ hash_table *glsl_type::interface_types = NULL;
 hash_table *glsl_type::function_types = NULL;
 hash_table *glsl_type::subroutine_types = NULL;
 
+/**
+ * Per-thread cache of array types in front of array_types, so that most
+ * get_array_instance() calls, which come from all over the compiler and
+ * linker, neither take hash_mutex nor build a key.  Entries are only used
+ * while their generation is current: _mesa_glsl_release_types() deletes
+ * the types and starts a new generation.
+ */
+#define ARRAY_TYPE_CACHE_SIZE 64
+
+struct array_type_cache_entry {
+   const glsl_type *base;
+   unsigned array_size;
+   unsigned explicit_stride;
+   unsigned generation;
+   const glsl_type *type;
+};
+
+static thread_local array_type_cache_entry
+   array_type_cache[ARRAY_TYPE_CACHE_SIZE];
+static unsigned type_cache_generation = 1;
+
 glsl_type::glsl_type(GLenum gl_type,
                      glsl_base_type base_type, unsigned vector_elements,
                      unsigned matrix_columns, const char *name,
@@ -475,6 +497,8 @@ _mesa_glsl_release_types(void)
     * object, or if process terminates), so no mutex-locking should be
     * necessary.
     */
+   p_atomic_inc(&type_cache_generation);
+
    if (glsl_type::explicit_matrix_types != NULL) {
       _mesa_hash_table_destroy(glsl_type::explicit_matrix_types,
                                hash_free_type_function);
@@ -972,6 +996,17 @@ glsl_type::get_array_instance(const glsl_type *base,
                               unsigned array_size,
                               unsigned explicit_stride)
 {
+   const unsigned generation = p_atomic_read(&type_cache_generation);
+   array_type_cache_entry *cached =
+      &array_type_cache[((uintptr_t) base / sizeof(glsl_type) +
+                         array_size * 7 + explicit_stride) %
+                        ARRAY_TYPE_CACHE_SIZE];
+
+   if (cached->generation == generation && cached->base == base &&
+       cached->array_size == array_size &&
+       cached->explicit_stride == explicit_stride)
+      return cached->type;
+
    /* Generate a name using the base type pointer in the key.  This is
     * done because the name of the base type may not be unique across
     * shaders.  For example, two shaders may have different record types
@@ -1003,6 +1038,12 @@ glsl_type::get_array_instance(const glsl_type *base,
 
    mtx_unlock(&glsl_type::hash_mutex);
 
+   cached->base = base;
+   cached->array_size = array_size;
+   cached->explicit_stride = explicit_stride;
+   cached->generation = generation;
+   cached->type = (glsl_type *) entry->data;
+
    return (glsl_type *) entry->data;
 }
 
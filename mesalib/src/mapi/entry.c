@@ -45,13 +45,19 @@
 #define ENTRY_CURRENT_TABLE_GET U_STRINGIFY(u_current_get_table_internal)
 #endif
 
-#if defined(USE_X86_ASM) && defined(__GNUC__)
+/*
+ * The assembly dispatchers use ELF directives and TLS relocations, so
+ * Windows uses the C entries below.  VcXsrv's own build does not define
+ * GLX_USE_TLS: there the dispatch is the server's exported _glapi_Dispatch.
+ */
+#if defined(USE_X86_ASM) && defined(__GNUC__) && !defined(_WIN32)
 #   ifdef GLX_USE_TLS
 #      include "entry_x86_tls.h"
 #   else                 
 #      include "entry_x86_tsd.h"
 #   endif
-#elif defined(USE_X86_64_ASM) && defined(__GNUC__) && defined(GLX_USE_TLS)
+#elif defined(USE_X86_64_ASM) && defined(__GNUC__) && defined(GLX_USE_TLS) && \
+      !defined(_WIN32)
 #   include "entry_x86-64_tls.h"
 #elif defined(USE_PPC64LE_ASM) && defined(__GNUC__) && defined(PIPE_ARCH_LITTLE_ENDIAN)
 #   ifdef GLX_USE_TLS
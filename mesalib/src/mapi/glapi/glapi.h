@@ -96,32 +96,47 @@ typedef void (*_glapi_warning_func)(void *ctx, const char *str, ...);
 #define MAX_EXTENSION_FUNCS 300
 
 
+#ifdef INSERVER
+#define SERVEXTERN _declspec(dllimport)
+#else
+#define SERVEXTERN _declspec(dllexport)
+#endif
+
+
 /**
  ** Define the GET_CURRENT_CONTEXT() macro.
  ** \param C local variable which will hold the current context.
  **/
 #if defined (GLX_USE_TLS)
 
-_GLAPI_EXPORT extern __thread struct _glapi_table * _glapi_tls_Dispatch
-  ;
+#ifdef _MSC_VER
+/*
+ * Thread-local data can't be imported from another module, so only the
+ * module defining these (u_current.c) may touch them; everything else goes
+ * through the exported accessors.
+ */
+extern __THREAD_INITIAL_EXEC struct _glapi_table * _glapi_tls_Dispatch;
+
+extern __THREAD_INITIAL_EXEC void * _glapi_tls_Context;
+#else
+_GLAPI_EXPORT extern __THREAD_INITIAL_EXEC struct _glapi_table * _glapi_tls_Dispatch;
 
-_GLAPI_EXPORT extern __thread void * _glapi_tls_Context
-  ;
+_GLAPI_EXPORT extern __THREAD_INITIAL_EXEC void * _glapi_tls_Context;
+#endif
 
 _GLAPI_EXPORT extern const struct _glapi_table *_glapi_Dispatch;
 _GLAPI_EXPORT extern const void *_glapi_Context;
 
+#ifdef _MSC_VER
+# define GET_DISPATCH() _glapi_get_dispatch()
+# define GET_CURRENT_CONTEXT(C)  struct gl_context *C = (struct gl_context *) _glapi_get_context()
+#else
 # define GET_DISPATCH() _glapi_tls_Dispatch
 # define GET_CURRENT_CONTEXT(C)  struct gl_context *C = (struct gl_context *) _glapi_tls_Context
+#endif
 
 #else
 
-#ifdef INSERVER
-#define SERVEXTERN _declspec(dllimport)
-#else
-#define SERVEXTERN _declspec(dllexport)
-#endif
-
 SERVEXTERN struct _glapi_table *_glapi_Dispatch;
 SERVEXTERN void *_glapi_Context;
 
@@ -99,12 +99,10 @@ extern void (*__glapi_noop_table[])(void);
 /*@{*/
 #if defined(GLX_USE_TLS)
 
-__thread struct _glapi_table *u_current_table
-    __attribute__((tls_model("initial-exec")))
+__THREAD_INITIAL_EXEC struct _glapi_table *u_current_table
     = (struct _glapi_table *) table_noop_array;
 
-__thread void *u_current_context
-    __attribute__((tls_model("initial-exec")));
+__THREAD_INITIAL_EXEC void *u_current_context;
 
 #else
 
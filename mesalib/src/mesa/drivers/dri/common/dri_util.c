@@ -79,6 +79,8 @@ setupLoaderExtensions(__DRIscreen *psp,
             psp->dri2.backgroundCallable = (__DRIbackgroundCallableExtension *) extensions[i];
 	if (strcmp(extensions[i]->name, __DRI_SWRAST_LOADER) == 0)
 	    psp->swrast_loader = (__DRIswrastLoaderExtension *) extensions[i];
+	if (strcmp(extensions[i]->name, __DRI_SWRAST_FRONT_LOADER) == 0)
+	    psp->swrast_front_loader = (__DRIswrastFrontLoaderExtension *) extensions[i];
         if (strcmp(extensions[i]->name, __DRI_IMAGE_LOADER) == 0)
            psp->image.loader = (__DRIimageLoaderExtension *) extensions[i];
         if (strcmp(extensions[i]->name, __DRI_MUTABLE_RENDER_BUFFER_LOADER) == 0)
@@ -27,7 +27,10 @@
  *
  * The front-buffer is allocated by the loader. The loader provides read/write
  * callbacks for access to the front-buffer. The driver uses a scratch row for
- * front-buffer rendering to avoid repeated calls to the loader.
+ * front-buffer rendering to avoid repeated calls to the loader. If the loader
+ * also has the front buffer loader extension, the front-buffer is mapped in
+ * place whenever the loader allows it, and the loader is only told what was
+ * drawn.
  *
  * The back-buffer is allocated by the driver and is private.
  */
@@ -57,6 +60,8 @@
 #include "drivers/common/driverfuncs.h"
 #include "drivers/common/meta.h"
 #include "utils.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 
 #include "main/teximage.h"
 #include "main/texformat.h"
@@ -67,6 +72,7 @@
 #include "swrast/s_context.h"
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #ifdef HAVE_SYS_SYSCTL_H
 # include <sys/sysctl.h>
 #endif
@@ -291,6 +297,54 @@ swrastFillInModes(__DRIscreen *psp,
     return configs;
 }
 
+/**
+ * Create the on-disk shader cache.  It is keyed on the module holding the
+ * driver, so that a rebuilt driver doesn't pick up entries of the old one.
+ */
+static struct disk_cache *
+swrast_create_disk_cache(void)
+{
+#if defined(ENABLE_SHADER_CACHE) && (defined(_MSC_VER) || defined(HAVE_DLFCN_H))
+    struct mesa_sha1 sha1_ctx;
+    unsigned char sha1[20];
+    char id[41];
+
+    _mesa_sha1_init(&sha1_ctx);
+#ifdef _MSC_VER
+    {
+	HMODULE module;
+	char filename[MAX_PATH];
+	DWORD len;
+	struct stat st;
+	uint32_t timestamp;
+
+	if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+				GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+				(LPCSTR) swrast_create_disk_cache, &module))
+	    return NULL;
+
+	len = GetModuleFileNameA(module, filename, sizeof(filename));
+	if (len == 0 || len == sizeof(filename) || stat(filename, &st) != 0 ||
+	    !st.st_mtime)
+	    return NULL;
+
+	timestamp = (uint32_t) st.st_mtime;
+	_mesa_sha1_update(&sha1_ctx, &timestamp, sizeof(timestamp));
+    }
+#else
+    if (!disk_cache_get_function_identifier(swrast_create_disk_cache,
+					    &sha1_ctx))
+	return NULL;
+#endif
+    _mesa_sha1_final(&sha1_ctx, sha1);
+    disk_cache_format_hex_id(id, sha1, sizeof(sha1) * 2);
+
+    return disk_cache_create("swrast", id, 0);
+#else
+    return NULL;
+#endif
+}
+
 static const __DRIconfig **
 dri_init_screen(__DRIscreen * psp)
 {
@@ -304,6 +358,8 @@ dri_init_screen(__DRIscreen * psp)
 
     psp->extensions = dri_screen_extensions;
 
+    psp->driverPrivate = swrast_create_disk_cache();
+
     configs16 = swrastFillInModes(psp, 16, 16, 0, 1);
     configs24 = swrastFillInModes(psp, 24, 24, 8, 1);
     configs32 = swrastFillInModes(psp, 32, 24, 8, 1);
@@ -318,7 +374,7 @@ static void
 dri_destroy_screen(__DRIscreen * sPriv)
 {
     TRACE;
-    (void) sPriv;
+    disk_cache_destroy(sPriv->driverPrivate);
 }
 
 
@@ -473,6 +529,32 @@ swrast_new_renderbuffer(const struct gl_config *visual, __DRIdrawable *dPriv,
     return xrb;
 }
 
+/**
+ * Return the front buffer's pixels if the loader lets us at them, and
+ * they match the renderbuffer, or NULL.
+ */
+static GLubyte *
+get_front_buffer(struct dri_swrast_renderbuffer *xrb, int *stride)
+{
+   __DRIdrawable *dPriv = xrb->dPriv;
+   __DRIscreen *sPriv = dPriv->driScreenPriv;
+   struct gl_renderbuffer *rb = &xrb->Base.Base;
+   int w, h, bpp;
+   char *data;
+
+   if (!sPriv->swrast_front_loader)
+      return NULL;
+
+   data = sPriv->swrast_front_loader->getFrontBuffer(dPriv, &w, &h, stride,
+                                                     &bpp,
+                                                     dPriv->loaderPrivate);
+   if (!data || bpp != xrb->bpp ||
+       w < (int) rb->Width || h < (int) rb->Height)
+      return NULL;
+
+   return (GLubyte *) data;
+}
+
 static void
 swrast_map_renderbuffer(struct gl_context *ctx,
 			struct gl_renderbuffer *rb,
@@ -500,6 +582,14 @@ swrast_map_renderbuffer(struct gl_context *ctx,
       xrb->map_w = w;
       xrb->map_h = h;
 
+      map = get_front_buffer(xrb, &stride);
+      if (map) {
+         xrb->map_direct = GL_TRUE;
+         *out_map = map + (rb->Height - 1 - y) * stride + x * cpp;
+         *out_stride = -stride;
+         return;
+      }
+
       stride = w * cpp;
       xrb->Base.Buffer = malloc(h * stride);
 
@@ -536,6 +626,17 @@ swrast_unmap_renderbuffer(struct gl_context *ctx,
       __DRIdrawable *dPriv = xrb->dPriv;
       __DRIscreen *sPriv = dPriv->driScreenPriv;
 
+      if (xrb->map_direct) {
+         if (xrb->map_mode & GL_MAP_WRITE_BIT) {
+            sPriv->swrast_front_loader->damage(dPriv,
+                                               xrb->map_x, xrb->map_y,
+                                               xrb->map_w, xrb->map_h,
+                                               dPriv->loaderPrivate);
+         }
+         xrb->map_direct = GL_FALSE;
+         return;
+      }
+
       if (xrb->map_mode & GL_MAP_WRITE_BIT) {
 	 sPriv->swrast_loader->putImage(dPriv, __DRI_SWRAST_IMAGE_OP_DRAW,
 					xrb->map_x, xrb->map_y,
@@ -638,6 +739,8 @@ dri_swap_buffers(__DRIdrawable * dPriv)
     struct dri_drawable *drawable = dri_drawable(dPriv);
     struct gl_framebuffer *fb;
     struct dri_swrast_renderbuffer *frontrb, *backrb;
+    GLubyte *front;
+    int stride;
 
     TRACE;
 
@@ -658,6 +761,22 @@ dri_swap_buffers(__DRIdrawable * dPriv)
 	_mesa_notifySwapBuffers(ctx);
     }
 
+    front = get_front_buffer(frontrb, &stride);
+    if (front) {
+	const GLuint width = frontrb->Base.Base.Width;
+	const GLuint height = frontrb->Base.Base.Height;
+	const GLubyte *back = backrb->Base.Buffer;
+	GLuint i;
+
+	for (i = 0; i < height; i++) {
+	    memcpy(front + i * stride, back + i * backrb->pitch,
+		   width * (backrb->bpp / 8));
+	}
+	sPriv->swrast_front_loader->damage(dPriv, 0, 0, width, height,
+					   dPriv->loaderPrivate);
+	return;
+    }
+
     sPriv->swrast_loader->putImage(dPriv, __DRI_SWRAST_IMAGE_OP_SWAP,
 				   0, 0,
 				   frontrb->Base.Base.Width,
@@ -815,6 +934,8 @@ dri_create_context(gl_api api,
 
     driContextSetFlags(mesaCtx, ctx_config->flags);
 
+    mesaCtx->Cache = cPriv->driScreenPriv->driverPrivate;
+
     /* create module contexts */
     _swrast_CreateContext( mesaCtx );
     _vbo_CreateContext( mesaCtx );
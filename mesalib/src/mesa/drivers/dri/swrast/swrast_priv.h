@@ -108,6 +108,8 @@ struct dri_swrast_renderbuffer {
     /* GL_MAP_*_BIT, used for mapping of front buffer. */
     GLbitfield map_mode;
    int map_x, map_y, map_w, map_h;
+   /* front buffer mapped in place, see __DRI_SWRAST_FRONT_LOADER */
+   GLboolean map_direct;
 
     /* renderbuffer pitch (in bytes) */
     GLuint pitch;
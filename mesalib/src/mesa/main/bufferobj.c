@@ -95,6 +95,29 @@ buffer_usage_warning(struct gl_context *ctx, GLuint *id, const char *fmt, ...)
 static struct gl_buffer_object DummyBufferObject;
 
 
+/**
+ * Note that bytes [offset, offset + size) of the buffer are being written,
+ * so that the min/max index cache only forgets the ranges of indices they
+ * are part of.
+ */
+static void
+invalidate_minmax_cache_range(struct gl_buffer_object *bufObj,
+                              GLintptr offset, GLsizeiptr size)
+{
+   simple_mtx_lock(&bufObj->MinMaxCacheMutex);
+   if (bufObj->MinMaxCacheDirtyEnd > bufObj->MinMaxCacheDirtyStart) {
+      bufObj->MinMaxCacheDirtyStart =
+         MIN2(bufObj->MinMaxCacheDirtyStart, offset);
+      bufObj->MinMaxCacheDirtyEnd =
+         MAX2(bufObj->MinMaxCacheDirtyEnd, offset + size);
+   } else {
+      bufObj->MinMaxCacheDirtyStart = offset;
+      bufObj->MinMaxCacheDirtyEnd = offset + size;
+   }
+   simple_mtx_unlock(&bufObj->MinMaxCacheMutex);
+}
+
+
 /**
  * Return pointer to address of a buffer object target.
  * \param ctx  the GL context
@@ -2225,7 +2248,7 @@ _mesa_buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
 
    bufObj->NumSubDataCalls++;
    bufObj->Written = GL_TRUE;
-   bufObj->MinMaxCacheDirty = true;
+   invalidate_minmax_cache_range(bufObj, offset, size);
 
    assert(ctx->Driver.BufferSubData);
    ctx->Driver.BufferSubData(ctx, offset, size, data, bufObj);
@@ -2383,7 +2406,7 @@ clear_buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
    if (size == 0)
       return;
 
-   bufObj->MinMaxCacheDirty = true;
+   invalidate_minmax_cache_range(bufObj, offset, size);
 
    if (data == NULL) {
       /* clear to zeros, per the spec */
@@ -2903,7 +2926,7 @@ copy_buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *src,
       }
    }
 
-   dst->MinMaxCacheDirty = true;
+   invalidate_minmax_cache_range(dst, writeOffset, size);
 
    ctx->Driver.CopyBufferSubData(ctx, src, dst, readOffset, writeOffset, size);
 }
@@ -2921,7 +2944,7 @@ _mesa_CopyBufferSubData_no_error(GLenum readTarget, GLenum writeTarget,
    struct gl_buffer_object **dst_ptr = get_buffer_target(ctx, writeTarget);
    struct gl_buffer_object *dst = *dst_ptr;
 
-   dst->MinMaxCacheDirty = true;
+   invalidate_minmax_cache_range(dst, writeOffset, size);
    ctx->Driver.CopyBufferSubData(ctx, src, dst, readOffset, writeOffset,
                                  size);
 }
@@ -2958,7 +2981,7 @@ _mesa_CopyNamedBufferSubData_no_error(GLuint readBuffer, GLuint writeBuffer,
    struct gl_buffer_object *src = _mesa_lookup_bufferobj(ctx, readBuffer);
    struct gl_buffer_object *dst = _mesa_lookup_bufferobj(ctx, writeBuffer);
 
-   dst->MinMaxCacheDirty = true;
+   invalidate_minmax_cache_range(dst, writeOffset, size);
    ctx->Driver.CopyBufferSubData(ctx, src, dst, readOffset, writeOffset,
                                  size);
 }
@@ -3151,7 +3174,7 @@ map_buffer_range(struct gl_context *ctx, struct gl_buffer_object *bufObj,
 
    if (access & GL_MAP_WRITE_BIT) {
       bufObj->Written = GL_TRUE;
-      bufObj->MinMaxCacheDirty = true;
+      invalidate_minmax_cache_range(bufObj, offset, length);
    }
 
 #ifdef VBO_DEBUG
@@ -1287,6 +1287,9 @@ _mesa_initialize_context(struct gl_context *ctx,
       break;
    }
 
+   /* Preprocessing again is only slower, so carry on without the cache */
+   ctx->PreprocessorCache = glcpp_cache_create();
+
    ctx->FirstTimeCurrent = GL_TRUE;
 
    return GL_TRUE;
@@ -1317,6 +1320,14 @@ _mesa_free_context_data( struct gl_context *ctx )
       _mesa_make_current(ctx, NULL, NULL);
    }
 
+   /* wait for the compiles and links still on the compiler threads */
+   if (util_queue_is_initialized(&ctx->ShaderCompilerQueue)) {
+      util_queue_finish(&ctx->ShaderCompilerQueue);
+      util_queue_destroy(&ctx->ShaderCompilerQueue);
+   }
+   glcpp_cache_destroy(ctx->PreprocessorCache);
+   ctx->PreprocessorCache = NULL;
+
    /* unreference WinSysDraw/Read buffers */
    _mesa_reference_framebuffer(&ctx->WinSysDrawBuffer, NULL);
    _mesa_reference_framebuffer(&ctx->WinSysReadBuffer, NULL);
@@ -86,6 +86,8 @@ struct gl_list_instruction
    void (*Execute)( struct gl_context *ctx, void *data );
    void (*Destroy)( struct gl_context *ctx, void *data );
    void (*Print)( struct gl_context *ctx, void *data, FILE *f );
+   GLboolean (*Merge)( struct gl_context *ctx, void *data, void *next,
+                       GLbitfield attribs );
 };
 
 
@@ -1536,6 +1538,8 @@ _mesa_dlist_alloc_aligned(struct gl_context *ctx, GLuint opcode, GLuint bytes)
  * \param execute  function to execute the new display list command
  * \param destroy  function to destroy the new display list command
  * \param print  function to print the new display list command
+ * \param merge  optional function to fold the next instruction of the same
+ *               opcode into this one, see merge_instructions()
  * \return  the new opcode number or -1 if error
  */
 GLint
@@ -1543,7 +1547,9 @@ _mesa_dlist_alloc_opcode(struct gl_context *ctx,
                          GLuint size,
                          void (*execute) (struct gl_context *, void *),
                          void (*destroy) (struct gl_context *, void *),
-                         void (*print) (struct gl_context *, void *, FILE *))
+                         void (*print) (struct gl_context *, void *, FILE *),
+                         GLboolean (*merge) (struct gl_context *, void *,
+                                             void *, GLbitfield))
 {
    if (ctx->ListExt->NumOpcodes < MAX_DLIST_EXT_OPCODES) {
       const GLuint i = ctx->ListExt->NumOpcodes++;
@@ -1552,6 +1558,7 @@ _mesa_dlist_alloc_opcode(struct gl_context *ctx,
       ctx->ListExt->Opcode[i].Execute = execute;
       ctx->ListExt->Opcode[i].Destroy = destroy;
       ctx->ListExt->Opcode[i].Print = print;
+      ctx->ListExt->Opcode[i].Merge = merge;
       return i + OPCODE_EXT_0;
    }
    return -1;
@@ -1574,6 +1581,88 @@ alloc_instruction(struct gl_context *ctx, OpCode opcode, GLuint nparams)
 }
 
 
+/** Overwrite an instruction of \p size nodes with NOPs */
+static void
+erase_instruction(Node *n, GLuint size)
+{
+   GLuint i;
+   for (i = 0; i < size; i++)
+      n[i].opcode = OPCODE_NOP;
+}
+
+
+/**
+ * Called by EndList to merge extension instructions, such as the vbo
+ * module's vertex lists, which are separated only by current attribute
+ * changes, e.g. glColor between glBegin/glEnd pairs.  The extension's
+ * Merge function decides whether the second instruction sets each of
+ * those attributes itself, in which case the attribute instructions and
+ * the second instruction can be dropped, and the whole run is drawn at
+ * once.
+ */
+static void
+merge_instructions(struct gl_context *ctx)
+{
+   Node *attr_nodes[VERT_ATTRIB_MAX];
+   Node *n = ctx->ListState.CurrentList->Head;
+   Node *prev = NULL;        /* last mergeable extension instruction */
+   GLbitfield attribs = 0;   /* attributes set since prev */
+
+   for (;;) {
+      const OpCode opcode = n[0].opcode;
+      const struct gl_list_instruction *ext = NULL;
+      GLuint step;
+
+      if (opcode == OPCODE_END_OF_LIST)
+         return;
+
+      if (opcode == OPCODE_CONTINUE) {
+         n = (Node *) get_pointer(&n[1]);
+         continue;
+      }
+
+      if (is_ext_opcode(opcode)) {
+         ext = &ctx->ListExt->Opcode[opcode - OPCODE_EXT_0];
+         step = ext->Size;
+      }
+      else {
+         step = InstSize[opcode];
+      }
+
+      if (opcode == OPCODE_NOP) {
+         /* skip padding and erased instructions */
+      }
+      else if (prev && opcode >= OPCODE_ATTR_1F_NV &&
+               opcode <= OPCODE_ATTR_4F_NV && n[1].ui != VERT_ATTRIB_POS) {
+         const GLuint attr = n[1].ui;
+
+         /* an earlier value with nothing drawn since is dead */
+         if (attribs & VERT_BIT(attr))
+            erase_instruction(attr_nodes[attr],
+                              InstSize[attr_nodes[attr][0].opcode]);
+         attr_nodes[attr] = n;
+         attribs |= VERT_BIT(attr);
+      }
+      else if (prev && opcode == prev[0].opcode &&
+               ext->Merge(ctx, &prev[1], &n[1], attribs)) {
+         while (attribs) {
+            const GLuint attr = u_bit_scan(&attribs);
+            erase_instruction(attr_nodes[attr],
+                              InstSize[attr_nodes[attr][0].opcode]);
+         }
+         ext->Destroy(ctx, &n[1]);
+         erase_instruction(n, step);
+      }
+      else {
+         prev = (ext && ext->Merge) ? n : NULL;
+         attribs = 0;
+      }
+
+      n += step;
+   }
+}
+
+
 /**
  * Called by EndList to try to reduce memory used for the list.
  */
@@ -10952,6 +11041,8 @@ _mesa_EndList(void)
 
    (void) alloc_instruction(ctx, OPCODE_END_OF_LIST, 0);
 
+   merge_instructions(ctx);
+
    trim_list(ctx);
 
    /* Destroy old list, if any */
@@ -28,6 +28,12 @@
 #include "format_pack.h"
 #include "format_unpack.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2_INTRINSICS
+#include <emmintrin.h>
+#endif
+
 const mesa_array_format RGBA32_FLOAT =
    MESA_ARRAY_FORMAT(4, 1, 1, 1, 4, 0, 1, 2, 3);
 
@@ -237,6 +243,89 @@ convert_ubyte_rgba_to_bgra(size_t width, size_t height,
 }
 
 
+/**
+ * Special case conversion function from normalized GLubyte array formats to
+ * packed unorm formats.  Rows are swizzled to RGBA through a small buffer
+ * and packed from there, rather than through a copy of the whole image,
+ * giving the same results as the generic path in _mesa_format_convert.
+ *
+ * \return  true if it handled the conversion, false if the generic path
+ *          has to
+ */
+static bool
+convert_ubyte_to_packed(uint8_t *dst, mesa_format dst_format,
+                        size_t dst_stride,
+                        const uint8_t *src, int src_num_channels,
+                        size_t src_stride, uint8_t *src2rgba,
+                        uint8_t *rebase_swizzle,
+                        size_t width, size_t height)
+{
+   uint8_t rgba[64][4];
+   uint8_t rebased_src2rgba[4];
+   uint16_t to_unorm10[256], to_unorm2[256];
+   const int bits = _mesa_get_format_max_bits(dst_format);
+   size_t row, x, i;
+
+   if (bits > 8 &&
+       dst_format != MESA_FORMAT_B10G10R10A2_UNORM &&
+       dst_format != MESA_FORMAT_R10G10B10A2_UNORM)
+      return false;
+
+   /* The generic path packs formats with more than 8 bits per channel from
+    * floats, so convert through the same floats here
+    */
+   if (bits > 8) {
+      for (i = 0; i < 256; i++) {
+         to_unorm10[i] = _mesa_float_to_unorm(_mesa_unorm_to_float(i, 8), 10);
+         to_unorm2[i] = _mesa_float_to_unorm(_mesa_unorm_to_float(i, 8), 2);
+      }
+   }
+
+   compute_rebased_rgba_component_mapping(src2rgba, rebase_swizzle,
+                                          rebased_src2rgba);
+
+   for (row = 0; row < height; ++row) {
+      const uint8_t *s = src;
+      uint8_t *d = dst;
+
+      for (x = 0; x < width; x += ARRAY_SIZE(rgba)) {
+         const int n = MIN2(width - x, ARRAY_SIZE(rgba));
+
+         _mesa_swizzle_and_convert(rgba, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                                   s, MESA_ARRAY_FORMAT_TYPE_UBYTE,
+                                   src_num_channels, rebased_src2rgba,
+                                   true, n);
+
+         if (bits <= 8) {
+            _mesa_pack_ubyte_rgba_row(dst_format, n,
+                                      (const uint8_t (*)[4]) rgba, d);
+            d += n * _mesa_get_format_bytes(dst_format);
+         } else {
+            const bool bgra = dst_format == MESA_FORMAT_B10G10R10A2_UNORM;
+            uint32_t *d32 = (uint32_t *) d;
+
+            for (i = 0; i < n; i++) {
+               const uint32_t r = to_unorm10[rgba[i][0]];
+               const uint32_t b = to_unorm10[rgba[i][2]];
+
+               d32[i] = (bgra ? b : r) |
+                        (uint32_t) to_unorm10[rgba[i][1]] << 10 |
+                        (bgra ? r : b) << 20 |
+                        (uint32_t) to_unorm2[rgba[i][3]] << 30;
+            }
+            d += n * sizeof(uint32_t);
+         }
+         s += n * src_num_channels;
+      }
+
+      src += src_stride;
+      dst += dst_stride;
+   }
+
+   return true;
+}
+
+
 /**
  * This can be used to convert between most color formats.
  *
@@ -439,6 +528,17 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
       return;
    }
 
+   /* GLubyte array formats (RGBA, BGRA, ...) packed to 565, 4444, 2101010
+    * and the like, which is how most 8-bit uploads to packed formats look.
+    */
+   if (src_array_format && !dst_array_format &&
+       src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE && normalized &&
+       _mesa_get_format_datatype(dst_format) == GL_UNSIGNED_NORMALIZED &&
+       convert_ubyte_to_packed(dst, dst_format, dst_stride,
+                               src, src_num_channels, src_stride,
+                               src2rgba, rebase_swizzle, width, height))
+      return;
+
    /* At this point, we're fresh out of fast-paths and we need to convert
     * to float, uint32, or, if we're lucky, uint8.
     */
@@ -792,6 +892,97 @@ swizzle_convert_try_memcpy(void *dst,
    return true;
 }
 
+/**
+ * This function handles swizzle-and-convert operations between 4-channel
+ * GLubyte formats, such as RGBA to BGRA or BGRX to RGBA, by moving the
+ * channels around as bytes of 32-bit words, four pixels at a time where
+ * SSE2 is available.  If it can't, it returns false and we fall back to the
+ * standard version below.
+ *
+ * The arguments are exactly the same as for _mesa_swizzle_and_convert
+ *
+ * \return  true if it successfully performed the swizzle-and-convert
+ *          operation, false otherwise
+ */
+static bool
+swizzle_convert_try_ubyte4(void *dst,
+                           enum mesa_array_format_datatype dst_type,
+                           int num_dst_channels,
+                           const void *src,
+                           enum mesa_array_format_datatype src_type,
+                           int num_src_channels,
+                           const uint8_t swizzle[4], bool normalized, int count)
+{
+   const uint8_t *s = src;
+   uint8_t *d = dst;
+   const uint32_t one = normalized ? UINT8_MAX : 1;
+   uint32_t masks[4], or_mask = 0;
+   int lshift[4], rshift[4];
+   int i, c;
+
+   if (src_type != MESA_ARRAY_FORMAT_TYPE_UBYTE ||
+       dst_type != MESA_ARRAY_FORMAT_TYPE_UBYTE)
+      return false;
+   if (num_src_channels != 4 || num_dst_channels != 4)
+      return false;
+   if (!_mesa_little_endian())
+      return false;
+
+   /* Destination byte c is source byte swizzle[c] shifted into place */
+   for (c = 0; c < 4; ++c) {
+      masks[c] = 0;
+      lshift[c] = rshift[c] = 0;
+      if (swizzle[c] < 4) {
+         masks[c] = 0xffu << (8 * c);
+         if (c > swizzle[c])
+            lshift[c] = 8 * (c - swizzle[c]);
+         else
+            rshift[c] = 8 * (swizzle[c] - c);
+      } else if (swizzle[c] == MESA_FORMAT_SWIZZLE_ONE) {
+         or_mask |= one << (8 * c);
+      } else if (swizzle[c] != MESA_FORMAT_SWIZZLE_ZERO) {
+         return false;
+      }
+   }
+
+   i = 0;
+
+#ifdef HAVE_SSE2_INTRINSICS
+   {
+      __m128i vmasks[4], vlshift[4], vrshift[4];
+      const __m128i vor_mask = _mm_set1_epi32(or_mask);
+
+      for (c = 0; c < 4; ++c) {
+         vmasks[c] = _mm_set1_epi32(masks[c]);
+         vlshift[c] = _mm_cvtsi32_si128(lshift[c]);
+         vrshift[c] = _mm_cvtsi32_si128(rshift[c]);
+      }
+
+      for (; i + 4 <= count; i += 4) {
+         const __m128i p = _mm_loadu_si128((const __m128i *) (s + 4 * i));
+         __m128i r = vor_mask;
+
+         for (c = 0; c < 4; ++c) {
+            r = _mm_or_si128(r, _mm_and_si128(_mm_sll_epi32(
+                   _mm_srl_epi32(p, vrshift[c]), vlshift[c]), vmasks[c]));
+         }
+         _mm_storeu_si128((__m128i *) (d + 4 * i), r);
+      }
+   }
+#endif
+
+   for (; i < count; ++i) {
+      uint32_t p, r = or_mask;
+
+      memcpy(&p, s + 4 * i, sizeof(p));
+      for (c = 0; c < 4; ++c)
+         r |= ((p >> rshift[c]) << lshift[c]) & masks[c];
+      memcpy(d + 4 * i, &r, sizeof(r));
+   }
+
+   return true;
+}
+
 /**
  * Represents a single instance of the standard swizzle-and-convert loop
  *
@@ -1511,6 +1702,11 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                                   swizzle, normalized, count))
       return;
 
+   if (swizzle_convert_try_ubyte4(void_dst, dst_type, num_dst_channels,
+                                  void_src, src_type, num_src_channels,
+                                  swizzle, normalized, count))
+      return;
+
    switch (dst_type) {
    case MESA_ARRAY_FORMAT_TYPE_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
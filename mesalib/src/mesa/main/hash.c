@@ -3,7 +3,8 @@
  * Generic hash table. 
  *
  * Used for display lists, texture objects, vertex/fragment programs,
- * buffer objects, etc.  The hash functions are thread-safe.
+ * buffer objects, etc.  The hash functions are thread-safe, and
+ * _mesa_HashLookup() of a key below HASH_SMALL_KEYS doesn't lock at all.
  * 
  * \note key=0 is illegal.
  *
@@ -38,6 +39,7 @@
 #include "glheader.h"
 #include "hash.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 
 /**
@@ -86,12 +88,17 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   GLuint i;
+
    assert(table);
 
-   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
+   if (table->NumSmallEntries ||
+       _mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
       _mesa_problem(NULL, "In _mesa_DeleteHashTable, found non-freed data");
    }
 
+   for (i = 0; i < HASH_SMALL_PAGES; i++)
+      free(table->SmallPages[i]);
    _mesa_hash_table_destroy(table->ht, NULL);
 
    mtx_destroy(&table->Mutex);
@@ -100,6 +107,21 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
 
 
+/**
+ * Lookup a key below HASH_SMALL_KEYS, which needs no lock.
+ */
+static inline void *
+small_key_lookup(const struct _mesa_HashTable *table, GLuint key)
+{
+   void **page = p_atomic_read(&table->SmallPages[key >> HASH_SMALL_PAGE_SHIFT]);
+
+   if (!page)
+      return NULL;
+
+   return p_atomic_read(&page[key & (HASH_SMALL_PAGE_SIZE - 1)]);
+}
+
+
 /**
  * Lookup an entry in the hash table, without locking.
  * \sa _mesa_HashLookup
@@ -112,8 +134,8 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
    assert(table);
    assert(key);
 
-   if (key == DELETED_KEY_VALUE)
-      return table->deleted_key_data;
+   if (key < HASH_SMALL_KEYS)
+      return small_key_lookup(table, key);
 
    entry = _mesa_hash_table_search_pre_hashed(table->ht,
                                               uint_hash(key),
@@ -137,6 +159,13 @@ void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
    void *res;
+
+   assert(table);
+   assert(key);
+
+   if (key < HASH_SMALL_KEYS)
+      return small_key_lookup(table, key);
+
    _mesa_HashLockMutex(table);
    res = _mesa_HashLookup_unlocked(table, key);
    _mesa_HashUnlockMutex(table);
@@ -162,6 +191,40 @@ _mesa_HashLookupLocked(struct _mesa_HashTable *table, GLuint key)
 }
 
 
+/**
+ * Set the data of a key below HASH_SMALL_KEYS, with the mutex locked.
+ * Readers may be looking at the page meanwhile, so it's only ever published
+ * once it's been cleared, and slots are written with atomic stores.
+ */
+static void
+small_key_set(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   void ***pagep = &table->SmallPages[key >> HASH_SMALL_PAGE_SHIFT];
+   void **page = *pagep;
+   void **slot;
+
+   if (!page) {
+      if (!data)
+         return;
+
+      page = calloc(HASH_SMALL_PAGE_SIZE, sizeof(void *));
+      if (!page) {
+         _mesa_error_no_memory(__func__);
+         return;
+      }
+      p_atomic_set(pagep, page);
+   }
+
+   slot = &page[key & (HASH_SMALL_PAGE_SIZE - 1)];
+   if (!*slot && data)
+      table->NumSmallEntries++;
+   else if (*slot && !data)
+      table->NumSmallEntries--;
+
+   p_atomic_set(slot, data);
+}
+
+
 static inline void
 _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
 {
@@ -174,8 +237,8 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = data;
+   if (key < HASH_SMALL_KEYS) {
+      small_key_set(table, key, data);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht, hash, uint_key(key));
       if (entry) {
@@ -244,8 +307,8 @@ _mesa_HashRemove_unlocked(struct _mesa_HashTable *table, GLuint key)
     */
    assert(!table->InDeleteAll);
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = NULL;
+   if (key < HASH_SMALL_KEYS) {
+      small_key_set(table, key, NULL);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht,
                                                  uint_hash(key),
@@ -283,17 +346,23 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void (*callback)(GLuint key, void *data, void *userData),
                     void *userData)
 {
+   GLuint key;
+
    assert(callback);
    _mesa_HashLockMutex(table);
    table->InDeleteAll = GL_TRUE;
+   for (key = 1; key < HASH_SMALL_KEYS && table->NumSmallEntries; key++) {
+      void *data = small_key_lookup(table, key);
+
+      if (data) {
+         callback(key, data, userData);
+         small_key_set(table, key, NULL);
+      }
+   }
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
    }
-   if (table->deleted_key_data) {
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
-      table->deleted_key_data = NULL;
-   }
    table->InDeleteAll = GL_FALSE;
    _mesa_HashUnlockMutex(table);
 }
@@ -311,14 +380,25 @@ hash_walk_unlocked(const struct _mesa_HashTable *table,
                    void (*callback)(GLuint key, void *data, void *userData),
                    void *userData)
 {
+   GLuint key;
+
    assert(table);
    assert(callback);
 
+   for (key = 1; key < HASH_SMALL_KEYS; key++) {
+      /* skip the pages that were never allocated */
+      if (!table->SmallPages[key >> HASH_SMALL_PAGE_SHIFT]) {
+         key |= HASH_SMALL_PAGE_SIZE - 1;
+         continue;
+      }
+
+      void *data = small_key_lookup(table, key);
+      if (data)
+         callback(key, data, userData);
+   }
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
    }
-   if (table->deleted_key_data)
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
 }
 
 
@@ -357,8 +437,6 @@ debug_print_entry(GLuint key, void *data, void *userData)
 void
 _mesa_HashPrint(const struct _mesa_HashTable *table)
 {
-   if (table->deleted_key_data)
-      debug_print_entry(DELETED_KEY_VALUE, table->deleted_key_data, NULL);
    _mesa_HashWalk(table, debug_print_entry, NULL);
 }
 
@@ -415,12 +493,5 @@ _mesa_HashFindFreeKeyBlock(struct _mesa_HashTable *table, GLuint numKeys)
 GLuint
 _mesa_HashNumEntries(const struct _mesa_HashTable *table)
 {
-   GLuint count = 0;
-
-   if (table->deleted_key_data)
-      count++;
-
-   count += _mesa_hash_table_num_entries(table->ht);
-
-   return count;
+   return table->NumSmallEntries + _mesa_hash_table_num_entries(table->ht);
 }
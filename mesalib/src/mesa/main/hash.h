@@ -45,10 +45,23 @@
  * and we use a 1:1 mapping from GLuints to key pointers, so we need to be
  * able to track a GLuint that happens to match the deleted key outside of
  * struct hash_table.  We tell the hash table to use "1" as the deleted key
- * value, so that we test the deleted-key-in-the-table path as best we can.
+ * value, which is one of the small keys kept outside of the table anyway.
  */
 #define DELETED_KEY_VALUE 1
 
+/** @{
+ * Keys below HASH_SMALL_KEYS, which are most of the names glGen*() hands
+ * out, are kept in a two-level array rather than in the struct hash_table.
+ * Pages of the array are allocated as they are needed and only freed with
+ * the table, and pages and slots are written with atomic stores, so that
+ * _mesa_HashLookup() can read them without taking the mutex.
+ */
+#define HASH_SMALL_PAGE_SHIFT 10
+#define HASH_SMALL_PAGE_SIZE (1 << HASH_SMALL_PAGE_SHIFT)
+#define HASH_SMALL_PAGES 64
+#define HASH_SMALL_KEYS (HASH_SMALL_PAGES * HASH_SMALL_PAGE_SIZE)
+/** @} */
+
 /** @{
  * Mapping from our use of GLuint as both the key and the hash value to the
  * hash_table.h API
@@ -97,12 +110,12 @@ uint_key(GLuint id)
  * The hash table data structure.
  */
 struct _mesa_HashTable {
-   struct hash_table *ht;
+   struct hash_table *ht;                /**< keys >= HASH_SMALL_KEYS */
+   void **SmallPages[HASH_SMALL_PAGES];  /**< data for keys < HASH_SMALL_KEYS */
+   GLuint NumSmallEntries;               /**< non-NULL data in SmallPages */
    GLuint MaxKey;                        /**< highest key inserted so far */
    mtx_t Mutex;                          /**< mutual exclusion lock */
    GLboolean InDeleteAll;                /**< Debug check */
-   /** Value that would be in the table for DELETED_KEY_VALUE. */
-   void *deleted_key_data;
 };
 
 extern struct _mesa_HashTable *_mesa_NewHashTable(void);
@@ -49,6 +49,7 @@
 #include "compiler/glsl/list.h"
 #include "util/simple_mtx.h"
 #include "util/u_dynarray.h"
+#include "util/u_queue.h"
 
 
 #ifdef __cplusplus
@@ -1376,6 +1377,9 @@ struct gl_buffer_object
    unsigned MinMaxCacheHitIndices;
    unsigned MinMaxCacheMissIndices;
    bool MinMaxCacheDirty;
+   /** Bytes written since the cache was last looked at, if End > Start */
+   GLintptr MinMaxCacheDirtyStart;
+   GLintptr MinMaxCacheDirtyEnd;
 
    bool HandleAllocated; /**< GL_ARB_bindless_texture */
 };
@@ -2658,6 +2662,14 @@ struct gl_shader
 
    /* ARB_gl_spirv related data */
    struct gl_shader_spirv_data *spirv_data;
+
+   /**
+    * GL_ARB_parallel_shader_compile: signalled once a compile queued on
+    * gl_context::ShaderCompilerQueue is done, and the number of queued
+    * links which still read this shader.
+    */
+   struct util_queue_fence CompileFence;
+   int PendingLinks;
 };
 
 
@@ -2957,6 +2969,9 @@ struct gl_shader_program
    GLuint NumShaders;          /**< number of attached shaders */
    struct gl_shader **Shaders; /**< List of attached the shaders */
 
+   /** Signalled once a link queued on the compiler threads is done */
+   struct util_queue_fence LinkFence;
+
    /**
     * User-defined attribute bindings
     *
@@ -5131,6 +5146,15 @@ struct gl_context
 
    struct disk_cache *Cache;
 
+   /**
+    * Threads for glCompileShader and glLinkProgram, created on first use
+    * (GL_ARB_parallel_shader_compile)
+    */
+   struct util_queue ShaderCompilerQueue;
+
+   /** Preprocessed GLSL sources, for the shaders compiled more than once */
+   struct glcpp_cache *PreprocessorCache;
+
    /**
     * \name GL_ARB_bindless_texture
     */
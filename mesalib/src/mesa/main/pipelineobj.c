@@ -570,6 +570,9 @@ _mesa_DeleteProgramPipelines(GLsizei n, const GLuint *pipelines)
           * current."
           */
          if (obj == ctx->Pipeline.Current) {
+            /* compiles and links on the compiler threads read ctx->_Shader */
+            if (util_queue_is_initialized(&ctx->ShaderCompilerQueue))
+               util_queue_finish(&ctx->ShaderCompilerQueue);
             _mesa_BindProgramPipeline(0);
          }
 
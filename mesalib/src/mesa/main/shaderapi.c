@@ -41,6 +41,7 @@
 #include <c99_alloca.h>
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/debug_output.h"
 #include "main/enums.h"
 #include "main/glspirv.h"
 #include "main/hash.h"
@@ -63,6 +64,7 @@
 #include "util/hash_table.h"
 #include "util/mesa-sha1.h"
 #include "util/crc32.h"
+#include "util/u_cpu_detect.h"
 
 /**
  * Return mask of GLSL_x flags by examining the MESA_GLSL env var.
@@ -172,6 +174,104 @@ _mesa_free_shader_state(struct gl_context *ctx)
 }
 
 
+/**
+ * Return the queue of compiler threads for glCompileShader and
+ * glLinkProgram, creating it on first use, or NULL if the work should be
+ * done on the calling thread.
+ */
+static struct util_queue *
+get_shader_compiler_queue(struct gl_context *ctx)
+{
+   struct util_queue *queue = &ctx->ShaderCompilerQueue;
+
+   if (ctx->Hint.MaxShaderCompilerThreads == 0)
+      return NULL;
+
+   /* Messages from the compiler must come from the application's thread
+    * when it asked for GL_DEBUG_OUTPUT_SYNCHRONOUS.
+    */
+   if (ctx->Debug &&
+       _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT_SYNCHRONOUS))
+      return NULL;
+
+   if (!util_queue_is_initialized(queue)) {
+      unsigned num_threads;
+
+      /* leave one CPU to the application */
+      util_cpu_detect();
+      num_threads = MAX2(util_cpu_caps.nr_cpus, 2) - 1;
+
+      if (!util_queue_init(queue, "glsl", 32, num_threads,
+                           UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                           UTIL_QUEUE_INIT_SHARED_POOL))
+         return NULL;
+
+      util_queue_adjust_num_threads(queue,
+                                    ctx->Hint.MaxShaderCompilerThreads);
+   }
+
+   return queue;
+}
+
+
+/**
+ * Wait for the compiles and links queued by this context.
+ */
+static void
+finish_shader_compiler_queue(struct gl_context *ctx)
+{
+   if (util_queue_is_initialized(&ctx->ShaderCompilerQueue))
+      util_queue_finish(&ctx->ShaderCompilerQueue);
+}
+
+
+/**
+ * Wait for queued links which read the shader, before it's changed.
+ * They may have been queued by another context sharing the shader.
+ */
+static void
+wait_for_shader_links(struct gl_context *ctx, struct gl_shader *sh)
+{
+   while (p_atomic_read(&sh->PendingLinks)) {
+      finish_shader_compiler_queue(ctx);
+      if (p_atomic_read(&sh->PendingLinks))
+         thrd_yield();
+   }
+}
+
+
+/** A glCompileShader or glLinkProgram for the compiler threads */
+struct shader_compiler_job
+{
+   struct gl_context *ctx;
+   struct gl_shader *sh;
+   struct gl_shader_program *shProg;
+};
+
+
+static struct shader_compiler_job *
+new_shader_compiler_job(struct gl_context *ctx, struct gl_shader *sh,
+                        struct gl_shader_program *shProg)
+{
+   struct shader_compiler_job *job = malloc(sizeof(*job));
+
+   if (job) {
+      job->ctx = ctx;
+      job->sh = sh;
+      job->shProg = shProg;
+   }
+   return job;
+}
+
+
+static void
+free_shader_compiler_job(void *job, int thread_index)
+{
+   (void) thread_index;
+   free(job);
+}
+
+
 /**
  * Copy string from <src> to <dst>, up to maxLength characters, returning
  * length of <dst> in <length>.
@@ -657,8 +757,26 @@ static void
 get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
               GLint *params)
 {
-   struct gl_shader_program *shProg
-      = _mesa_lookup_shader_program_err(ctx, program, "glGetProgramiv(program)");
+   struct gl_shader_program *shProg;
+
+   /* Don't wait for a link on the compiler threads. */
+   if (pname == GL_COMPLETION_STATUS_ARB) {
+      shProg = _mesa_lookup_shader_program_err_no_wait(ctx, program,
+                                                       "glGetProgramiv(program)");
+      if (!shProg)
+         return;
+
+      if (!util_queue_fence_is_signalled(&shProg->LinkFence))
+         *params = GL_FALSE;
+      else if (ctx->Driver.GetShaderProgramCompletionStatus)
+         *params = ctx->Driver.GetShaderProgramCompletionStatus(ctx, shProg);
+      else
+         *params = GL_TRUE;
+      return;
+   }
+
+   shProg = _mesa_lookup_shader_program_err(ctx, program,
+                                            "glGetProgramiv(program)");
 
    /* Is transform feedback available in this context?
     */
@@ -689,12 +807,6 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
    case GL_DELETE_STATUS:
       *params = shProg->DeletePending;
       return;
-   case GL_COMPLETION_STATUS_ARB:
-      if (ctx->Driver.GetShaderProgramCompletionStatus)
-         *params = ctx->Driver.GetShaderProgramCompletionStatus(ctx, shProg);
-      else
-         *params = GL_TRUE;
-      return;
    case GL_LINK_STATUS:
       *params = shProg->data->LinkStatus ? GL_TRUE : GL_FALSE;
       return;
@@ -952,9 +1064,17 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
 static void
 get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
 {
-   struct gl_shader *shader =
-      _mesa_lookup_shader_err(ctx, name, "glGetShaderiv");
+   struct gl_shader *shader;
 
+   /* Don't wait for a compile on the compiler threads. */
+   if (pname == GL_COMPLETION_STATUS_ARB) {
+      shader = _mesa_lookup_shader_err_no_wait(ctx, name, "glGetShaderiv");
+      if (shader)
+         *params = util_queue_fence_is_signalled(&shader->CompileFence);
+      return;
+   }
+
+   shader = _mesa_lookup_shader_err(ctx, name, "glGetShaderiv");
    if (!shader) {
       return;
    }
@@ -966,10 +1086,6 @@ get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
    case GL_DELETE_STATUS:
       *params = shader->DeletePending;
       break;
-   case GL_COMPLETION_STATUS_ARB:
-      /* _mesa_glsl_compile_shader is not offloaded to other threads. */
-      *params = GL_TRUE;
-      return;
    case GL_COMPILE_STATUS:
       *params = shader->CompileStatus ? GL_TRUE : GL_FALSE;
       break;
@@ -1103,26 +1219,11 @@ set_shader_source(struct gl_shader *sh, const GLchar *source)
 
 
 /**
- * Compile a shader.
+ * Compile a shader, on this thread or one of the compiler threads.
  */
-void
-_mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+static void
+compile_shader(struct gl_context *ctx, struct gl_shader *sh)
 {
-   if (!sh)
-      return;
-
-   /* The GL_ARB_gl_spirv spec says:
-    *
-    *    "Add a new error for the CompileShader command:
-    *
-    *      An INVALID_OPERATION error is generated if the SPIR_V_BINARY_ARB
-    *      state of <shader> is TRUE."
-    */
-   if (sh->spirv_data) {
-      _mesa_error(ctx, GL_INVALID_OPERATION, "glCompileShader(SPIR-V)");
-      return;
-   }
-
    if (!sh->Source) {
       /* If the user called glCompileShader without first calling
        * glShaderSource, we should fail to compile, but not raise a GL_ERROR.
@@ -1180,63 +1281,69 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
 }
 
 
-/**
- * Link a program's shaders.
- */
-static ALWAYS_INLINE void
-link_program(struct gl_context *ctx, struct gl_shader_program *shProg,
-             bool no_error)
+static void
+compile_shader_job(void *data, int thread_index)
 {
-   if (!shProg)
-      return;
+   struct shader_compiler_job *job = data;
 
-   if (!no_error) {
-      /* From the ARB_transform_feedback2 specification:
-       * "The error INVALID_OPERATION is generated by LinkProgram if <program>
-       * is the name of a program being used by one or more transform feedback
-       * objects, even if the objects are not currently bound or are paused."
-       */
-      if (_mesa_transform_feedback_is_using_program(ctx, shProg)) {
-         _mesa_error(ctx, GL_INVALID_OPERATION,
-                     "glLinkProgram(transform feedback is using the program)");
-         return;
-      }
-   }
+   (void) thread_index;
+   compile_shader(job->ctx, job->sh);
+}
 
-   unsigned programs_in_use = 0;
-   if (ctx->_Shader)
-      for (unsigned stage = 0; stage < MESA_SHADER_STAGES; stage++) {
-         if (ctx->_Shader->CurrentProgram[stage] &&
-             ctx->_Shader->CurrentProgram[stage]->Id == shProg->Name) {
-            programs_in_use |= 1 << stage;
-         }
-   }
 
-   FLUSH_VERTICES(ctx, 0);
-   _mesa_glsl_link_shader(ctx, shProg);
+/**
+ * Compile a shader.
+ * Unless the shader has no source, the compile is handed to the compiler
+ * threads, and _mesa_lookup_shader waits for it.
+ */
+void
+_mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+{
+   struct util_queue *queue;
 
-   /* From section 7.3 (Program Objects) of the OpenGL 4.5 spec:
+   if (!sh)
+      return;
+
+   /* The GL_ARB_gl_spirv spec says:
     *
-    *    "If LinkProgram or ProgramBinary successfully re-links a program
-    *     object that is active for any shader stage, then the newly generated
-    *     executable code will be installed as part of the current rendering
-    *     state for all shader stages where the program is active.
-    *     Additionally, the newly generated executable code is made part of
-    *     the state of any program pipeline for all stages where the program
-    *     is attached."
+    *    "Add a new error for the CompileShader command:
+    *
+    *      An INVALID_OPERATION error is generated if the SPIR_V_BINARY_ARB
+    *      state of <shader> is TRUE."
     */
-   if (shProg->data->LinkStatus && programs_in_use) {
-      while (programs_in_use) {
-         const int stage = u_bit_scan(&programs_in_use);
+   if (sh->spirv_data) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glCompileShader(SPIR-V)");
+      return;
+   }
 
-         struct gl_program *prog = NULL;
-         if (shProg->_LinkedShaders[stage])
-            prog = shProg->_LinkedShaders[stage]->Program;
+   wait_for_shader_links(ctx, sh);
 
-         _mesa_use_program(ctx, stage, shProg, prog, ctx->_Shader);
+   queue = sh->Source ? get_shader_compiler_queue(ctx) : NULL;
+   if (queue) {
+      struct shader_compiler_job *job = new_shader_compiler_job(ctx, sh, NULL);
+
+      if (job) {
+         util_queue_add_job(queue, job, &sh->CompileFence,
+                            compile_shader_job, free_shader_compiler_job);
+         return;
       }
    }
 
+   compile_shader(ctx, sh);
+}
+
+
+/**
+ * Link a program's shaders, on this thread or one of the compiler threads.
+ * Installing the new executables for the current rendering state is left
+ * to the caller.
+ */
+static void
+link_shaders_and_report(struct gl_context *ctx,
+                        struct gl_shader_program *shProg)
+{
+   _mesa_glsl_link_shader(ctx, shProg);
+
    /* Capture .shader_test files. */
    const char *capture_path = _mesa_get_shader_capture_path();
    if (shProg->Name != 0 && shProg->Name != ~0 && capture_path != NULL) {
@@ -1271,8 +1378,6 @@ link_program(struct gl_context *ctx, struct gl_shader_program *shProg,
                   shProg->Name, shProg->data->InfoLog);
    }
 
-   _mesa_update_vertex_processing_mode(ctx);
-
    /* debug code */
    if (0) {
       GLuint i;
@@ -1290,24 +1395,163 @@ link_program(struct gl_context *ctx, struct gl_shader_program *shProg,
 }
 
 
+static void
+link_program_job(void *data, int thread_index)
+{
+   struct shader_compiler_job *job = data;
+   struct gl_shader_program *shProg = job->shProg;
+
+   (void) thread_index;
+
+   /* Compiles queued before this link have all been started, so this
+    * can't wait for a job stuck behind it.
+    */
+   for (unsigned i = 0; i < shProg->NumShaders; i++)
+      util_queue_fence_wait(&shProg->Shaders[i]->CompileFence);
+
+   link_shaders_and_report(job->ctx, shProg);
+
+   for (unsigned i = 0; i < shProg->NumShaders; i++)
+      p_atomic_dec(&shProg->Shaders[i]->PendingLinks);
+}
+
+
+/**
+ * Can glLinkProgram be handed to the compiler threads?  Programs which
+ * the rendering state uses without looking them up are linked right away.
+ */
+static bool
+can_link_program_async(struct gl_context *ctx,
+                       const struct gl_shader_program *shProg,
+                       unsigned programs_in_use)
+{
+   if (programs_in_use)
+      return false;
+
+   if (ctx->_Shader && ctx->_Shader->ActiveProgram == shProg)
+      return false;
+
+   for (unsigned i = 0; i < shProg->NumShaders; i++) {
+      if (shProg->Shaders[i]->spirv_data)
+         return false;
+   }
+
+   return true;
+}
+
+
+/**
+ * Link a program's shaders.
+ * With \p async, the link may be handed to the compiler threads, and
+ * _mesa_lookup_shader_program waits for it.
+ */
+static ALWAYS_INLINE void
+link_program(struct gl_context *ctx, struct gl_shader_program *shProg,
+             bool no_error, bool async)
+{
+   struct util_queue *queue = NULL;
+
+   if (!shProg)
+      return;
+
+   if (!no_error) {
+      /* From the ARB_transform_feedback2 specification:
+       * "The error INVALID_OPERATION is generated by LinkProgram if <program>
+       * is the name of a program being used by one or more transform feedback
+       * objects, even if the objects are not currently bound or are paused."
+       */
+      if (_mesa_transform_feedback_is_using_program(ctx, shProg)) {
+         _mesa_error(ctx, GL_INVALID_OPERATION,
+                     "glLinkProgram(transform feedback is using the program)");
+         return;
+      }
+   }
+
+   unsigned programs_in_use = 0;
+   if (ctx->_Shader)
+      for (unsigned stage = 0; stage < MESA_SHADER_STAGES; stage++) {
+         if (ctx->_Shader->CurrentProgram[stage] &&
+             ctx->_Shader->CurrentProgram[stage]->Id == shProg->Name) {
+            programs_in_use |= 1 << stage;
+         }
+   }
+
+   /* After a shader cache miss the link compiles the shaders again, so
+    * two links mustn't share a shader then.
+    */
+   if (ctx->Cache) {
+      for (unsigned i = 0; i < shProg->NumShaders; i++)
+         wait_for_shader_links(ctx, shProg->Shaders[i]);
+   }
+
+   FLUSH_VERTICES(ctx, 0);
+
+   if (async && can_link_program_async(ctx, shProg, programs_in_use))
+      queue = get_shader_compiler_queue(ctx);
+
+   if (queue) {
+      struct shader_compiler_job *job =
+         new_shader_compiler_job(ctx, NULL, shProg);
+
+      if (job) {
+         for (unsigned i = 0; i < shProg->NumShaders; i++)
+            p_atomic_inc(&shProg->Shaders[i]->PendingLinks);
+
+         util_queue_add_job(queue, job, &shProg->LinkFence,
+                            link_program_job, free_shader_compiler_job);
+         return;
+      }
+   }
+
+   link_shaders_and_report(ctx, shProg);
+
+   /* From section 7.3 (Program Objects) of the OpenGL 4.5 spec:
+    *
+    *    "If LinkProgram or ProgramBinary successfully re-links a program
+    *     object that is active for any shader stage, then the newly generated
+    *     executable code will be installed as part of the current rendering
+    *     state for all shader stages where the program is active.
+    *     Additionally, the newly generated executable code is made part of
+    *     the state of any program pipeline for all stages where the program
+    *     is attached."
+    */
+   if (shProg->data->LinkStatus && programs_in_use) {
+      while (programs_in_use) {
+         const int stage = u_bit_scan(&programs_in_use);
+
+         struct gl_program *prog = NULL;
+         if (shProg->_LinkedShaders[stage])
+            prog = shProg->_LinkedShaders[stage]->Program;
+
+         _mesa_use_program(ctx, stage, shProg, prog, ctx->_Shader);
+      }
+   }
+
+   _mesa_update_vertex_processing_mode(ctx);
+}
+
+
 static void
 link_program_error(struct gl_context *ctx, struct gl_shader_program *shProg)
 {
-   link_program(ctx, shProg, false);
+   link_program(ctx, shProg, false, true);
 }
 
 
 static void
 link_program_no_error(struct gl_context *ctx, struct gl_shader_program *shProg)
 {
-   link_program(ctx, shProg, true);
+   link_program(ctx, shProg, true, true);
 }
 
 
+/**
+ * Link a program for callers inside Mesa, which read the results directly.
+ */
 void
 _mesa_link_program(struct gl_context *ctx, struct gl_shader_program *shProg)
 {
-   link_program_error(ctx, shProg);
+   link_program(ctx, shProg, false, false);
 }
 
 
@@ -1993,6 +2237,7 @@ shader_source(struct gl_context *ctx, GLuint shaderObj, GLsizei count,
    }
 #endif /* ENABLE_SHADER_CACHE */
 
+   wait_for_shader_links(ctx, sh);
    set_shader_source(sh, source);
 
    free(offsets);
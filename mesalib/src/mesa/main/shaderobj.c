@@ -94,6 +94,7 @@ _mesa_init_shader(struct gl_shader *shader)
    shader->info.Geom.VerticesOut = -1;
    shader->info.Geom.InputType = GL_TRIANGLES;
    shader->info.Geom.OutputType = GL_TRIANGLE_STRIP;
+   util_queue_fence_init(&shader->CompileFence);
 }
 
 /**
@@ -126,6 +127,7 @@ _mesa_delete_shader(struct gl_context *ctx, struct gl_shader *sh)
    free((void *)sh->Source);
    free((void *)sh->FallbackSource);
    free(sh->Label);
+   util_queue_fence_destroy(&sh->CompileFence);
    ralloc_free(sh);
 }
 
@@ -145,6 +147,7 @@ _mesa_delete_linked_shader(struct gl_context *ctx,
 
 /**
  * Lookup a GLSL shader object.
+ * If the shader is being compiled on the compiler threads, wait for that.
  */
 struct gl_shader *
 _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
@@ -159,6 +162,8 @@ _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
       if (sh && sh->Type == GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (sh)
+         util_queue_fence_wait(&sh->CompileFence);
       return sh;
    }
    return NULL;
@@ -170,6 +175,21 @@ _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
  */
 struct gl_shader *
 _mesa_lookup_shader_err(struct gl_context *ctx, GLuint name, const char *caller)
+{
+   struct gl_shader *sh = _mesa_lookup_shader_err_no_wait(ctx, name, caller);
+
+   if (sh)
+      util_queue_fence_wait(&sh->CompileFence);
+   return sh;
+}
+
+
+/**
+ * As above, but don't wait for a compile on the compiler threads.
+ */
+struct gl_shader *
+_mesa_lookup_shader_err_no_wait(struct gl_context *ctx, GLuint name,
+                                const char *caller)
 {
    if (!name) {
       _mesa_error(ctx, GL_INVALID_VALUE, "%s", caller);
@@ -296,6 +316,8 @@ init_shader_program(struct gl_shader_program *prog)
    prog->TransformFeedback.BufferMode = GL_INTERLEAVED_ATTRIBS;
 
    exec_list_make_empty(&prog->EmptyUniformLocations);
+
+   util_queue_fence_init(&prog->LinkFence);
 }
 
 /**
@@ -407,12 +429,14 @@ _mesa_delete_shader_program(struct gl_context *ctx,
                             struct gl_shader_program *shProg)
 {
    _mesa_free_shader_program_data(ctx, shProg);
+   util_queue_fence_destroy(&shProg->LinkFence);
    ralloc_free(shProg);
 }
 
 
 /**
  * Lookup a GLSL program object.
+ * If the program is being linked on the compiler threads, wait for that.
  */
 struct gl_shader_program *
 _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
@@ -428,6 +452,8 @@ _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
       if (shProg && shProg->Type != GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (shProg)
+         util_queue_fence_wait(&shProg->LinkFence);
       return shProg;
    }
    return NULL;
@@ -440,6 +466,22 @@ _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
 struct gl_shader_program *
 _mesa_lookup_shader_program_err(struct gl_context *ctx, GLuint name,
                                 const char *caller)
+{
+   struct gl_shader_program *shProg =
+      _mesa_lookup_shader_program_err_no_wait(ctx, name, caller);
+
+   if (shProg)
+      util_queue_fence_wait(&shProg->LinkFence);
+   return shProg;
+}
+
+
+/**
+ * As above, but don't wait for a link on the compiler threads.
+ */
+struct gl_shader_program *
+_mesa_lookup_shader_program_err_no_wait(struct gl_context *ctx, GLuint name,
+                                        const char *caller)
 {
    if (!name) {
       _mesa_error(ctx, GL_INVALID_VALUE, "%s", caller);
@@ -465,4 +507,5 @@ void
 _mesa_init_shader_object_functions(struct dd_function_table *driver)
 {
    driver->LinkShader = _mesa_ir_link_shader;
+   driver->ShaderCacheSerializeDriverBlob = _mesa_ir_serialize_program;
 }
@@ -911,6 +911,12 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
    GLuint bytes, bw, bh;
    GLint stride;
 
+   if (_mesa_get_format_layout(format) == MESA_FORMAT_LAYOUT_S3TC) {
+      _mesa_decompress_dxt_image(format, width, height,
+                                 src, srcRowStride, dest);
+      return;
+   }
+
    bytes = _mesa_get_format_bytes(format);
    _mesa_get_format_block_size(format, &bw, &bh);
 
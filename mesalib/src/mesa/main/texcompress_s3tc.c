@@ -374,3 +374,70 @@ _mesa_get_dxt_fetch_func(mesa_format format)
       return NULL;
    }
 }
+
+
+/**
+ * Decompress a DXT image to GL_RGBA/GL_FLOAT a whole block at a time,
+ * rather than decoding each texel's block again as the fetch functions do.
+ * \param srcRowStride  stride in bytes between rows of blocks
+ */
+void
+_mesa_decompress_dxt_image(mesa_format format, GLuint width, GLuint height,
+                           const GLubyte *src, GLint srcRowStride,
+                           GLfloat *dest)
+{
+   const GLuint blockBytes = _mesa_get_format_bytes(format);
+   const GLboolean srgb = _mesa_get_format_color_encoding(format) == GL_SRGB;
+   GLuint x, y, i, j;
+
+   for (y = 0; y < height; y += 4) {
+      const GLubyte *block = src + (y / 4) * srcRowStride;
+
+      for (x = 0; x < width; x += 4, block += blockBytes) {
+         const GLuint bw = MIN2(width - x, 4);
+         const GLuint bh = MIN2(height - y, 4);
+         GLubyte rgba[16][4];
+
+         switch (format) {
+         case MESA_FORMAT_RGB_DXT1:
+         case MESA_FORMAT_SRGB_DXT1:
+            fetch_2d_block_rgb_dxt1(block, rgba);
+            break;
+         case MESA_FORMAT_RGBA_DXT1:
+         case MESA_FORMAT_SRGBA_DXT1:
+            fetch_2d_block_rgba_dxt1(block, rgba);
+            break;
+         case MESA_FORMAT_RGBA_DXT3:
+         case MESA_FORMAT_SRGBA_DXT3:
+            fetch_2d_block_rgba_dxt3(block, rgba);
+            break;
+         case MESA_FORMAT_RGBA_DXT5:
+         case MESA_FORMAT_SRGBA_DXT5:
+            fetch_2d_block_rgba_dxt5(block, rgba);
+            break;
+         default:
+            unreachable("not a DXT format");
+         }
+
+         for (j = 0; j < bh; j++) {
+            GLfloat *texel = dest + ((y + j) * width + x) * 4;
+
+            for (i = 0; i < bw; i++, texel += 4) {
+               const GLubyte *tex = rgba[j * 4 + i];
+
+               if (srgb) {
+                  texel[RCOMP] = util_format_srgb_8unorm_to_linear_float(tex[RCOMP]);
+                  texel[GCOMP] = util_format_srgb_8unorm_to_linear_float(tex[GCOMP]);
+                  texel[BCOMP] = util_format_srgb_8unorm_to_linear_float(tex[BCOMP]);
+               }
+               else {
+                  texel[RCOMP] = UBYTE_TO_FLOAT(tex[RCOMP]);
+                  texel[GCOMP] = UBYTE_TO_FLOAT(tex[GCOMP]);
+                  texel[BCOMP] = UBYTE_TO_FLOAT(tex[BCOMP]);
+               }
+               texel[ACOMP] = UBYTE_TO_FLOAT(tex[ACOMP]);
+            }
+         }
+      }
+   }
+}
@@ -47,5 +47,10 @@ _mesa_texstore_rgba_dxt5(TEXSTORE_PARAMS);
 extern compressed_fetch_func
 _mesa_get_dxt_fetch_func(mesa_format format);
 
+extern void
+_mesa_decompress_dxt_image(mesa_format format, GLuint width, GLuint height,
+                           const GLubyte *src, GLint srcRowStride,
+                           GLfloat *dest);
+
 
 #endif /* TEXCOMPRESS_S3TC_H */
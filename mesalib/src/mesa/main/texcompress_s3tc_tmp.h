@@ -177,6 +177,103 @@ static void fetch_2d_texel_rgba_dxt5(GLint srcRowStride, const GLubyte *pixdata,
 }
 
 
+/* Decode a whole DXT1/3/5 color block at once: the four colors are
+   computed once, and the sixteen 2-bit codes just pick one of them */
+
+static inline void dxt135_decode_block( const GLubyte *img_block_src,
+                         GLuint dxt_type, GLchan rgba[16][4] ) {
+   const GLushort color0 = img_block_src[0] | (img_block_src[1] << 8);
+   const GLushort color1 = img_block_src[2] | (img_block_src[3] << 8);
+   const GLuint bits = img_block_src[4] | (img_block_src[5] << 8) |
+      (img_block_src[6] << 16) | (img_block_src[7] << 24);
+   GLchan palette[4][4];
+   GLint k;
+
+   palette[0][RCOMP] = UBYTE_TO_CHAN( EXP5TO8R(color0) );
+   palette[0][GCOMP] = UBYTE_TO_CHAN( EXP6TO8G(color0) );
+   palette[0][BCOMP] = UBYTE_TO_CHAN( EXP5TO8B(color0) );
+   palette[1][RCOMP] = UBYTE_TO_CHAN( EXP5TO8R(color1) );
+   palette[1][GCOMP] = UBYTE_TO_CHAN( EXP6TO8G(color1) );
+   palette[1][BCOMP] = UBYTE_TO_CHAN( EXP5TO8B(color1) );
+   palette[0][ACOMP] = palette[1][ACOMP] = CHAN_MAX;
+   palette[2][ACOMP] = palette[3][ACOMP] = CHAN_MAX;
+   if ((dxt_type > 1) || (color0 > color1)) {
+      for (k = 0; k < 3; k++) {
+         palette[2][k] = (palette[0][k] * 2 + palette[1][k]) / 3;
+         palette[3][k] = (palette[0][k] + palette[1][k] * 2) / 3;
+      }
+   }
+   else {
+      for (k = 0; k < 3; k++) {
+         palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+         palette[3][k] = 0;
+      }
+      if (dxt_type == 1) palette[3][ACOMP] = UBYTE_TO_CHAN(0);
+   }
+
+   for (k = 0; k < 16; k++) {
+      const GLchan *color = palette[(bits >> (2 * k)) & 3];
+      rgba[k][RCOMP] = color[RCOMP];
+      rgba[k][GCOMP] = color[GCOMP];
+      rgba[k][BCOMP] = color[BCOMP];
+      rgba[k][ACOMP] = color[ACOMP];
+   }
+}
+
+/* Decode the 16 texels of a block in raster order into rgba */
+
+static inline void fetch_2d_block_rgb_dxt1(const GLubyte *blksrc, GLchan rgba[16][4])
+{
+   dxt135_decode_block(blksrc, 0, rgba);
+}
+
+static inline void fetch_2d_block_rgba_dxt1(const GLubyte *blksrc, GLchan rgba[16][4])
+{
+   dxt135_decode_block(blksrc, 1, rgba);
+}
+
+static inline void fetch_2d_block_rgba_dxt3(const GLubyte *blksrc, GLchan rgba[16][4])
+{
+   GLint k;
+
+   dxt135_decode_block(blksrc + 8, 2, rgba);
+   for (k = 0; k < 16; k++) {
+      const GLubyte anibble = (blksrc[k / 2] >> (4 * (k & 1))) & 0xf;
+      rgba[k][ACOMP] = UBYTE_TO_CHAN( (GLubyte)(EXP4TO8(anibble)) );
+   }
+}
+
+static inline void fetch_2d_block_rgba_dxt5(const GLubyte *blksrc, GLchan rgba[16][4])
+{
+   const GLubyte alpha0 = blksrc[0];
+   const GLubyte alpha1 = blksrc[1];
+   /* 3-bit codes for the first and the second 8 texels */
+   const GLuint codes[2] = {
+      blksrc[2] | (blksrc[3] << 8) | (blksrc[4] << 16),
+      blksrc[5] | (blksrc[6] << 8) | (blksrc[7] << 16)
+   };
+   GLchan apalette[8];
+   GLint k;
+
+   apalette[0] = UBYTE_TO_CHAN( alpha0 );
+   apalette[1] = UBYTE_TO_CHAN( alpha1 );
+   if (alpha0 > alpha1) {
+      for (k = 2; k < 8; k++)
+         apalette[k] = UBYTE_TO_CHAN( ((alpha0 * (8 - k) + (alpha1 * (k - 1))) / 7) );
+   }
+   else {
+      for (k = 2; k < 6; k++)
+         apalette[k] = UBYTE_TO_CHAN( ((alpha0 * (6 - k) + (alpha1 * (k - 1))) / 5) );
+      apalette[6] = 0;
+      apalette[7] = CHAN_MAX;
+   }
+
+   dxt135_decode_block(blksrc + 8, 2, rgba);
+   for (k = 0; k < 16; k++)
+      rgba[k][ACOMP] = apalette[(codes[k / 8] >> (3 * (k & 7))) & 0x7];
+}
+
+
 /* weights used for error function, basically weights (unsquared 2/4/1) according to rgb->luminance conversion
    not sure if this really reflects visual perception */
 #define REDWEIGHT 4
@@ -516,6 +613,34 @@ static void encodedxtcolorblockfaster( GLubyte *blkaddr, GLubyte srccolors[4][4]
    GLubyte i, j;
    GLuint lowcv, highcv, testcv;
    GLboolean haveAlpha = GL_FALSE;
+   GLboolean solid = GL_TRUE;
+
+   /* a block of one opaque color gets the same encoding as it would from the
+      search below, both base colors the same and all codes 0, so skip that */
+   for (j = 0; j < numypixels && solid; j++) {
+      for (i = 0; i < numxpixels; i++) {
+         if (srccolors[j][i][0] != srccolors[0][0][0] ||
+             srccolors[j][i][1] != srccolors[0][0][1] ||
+             srccolors[j][i][2] != srccolors[0][0][2] ||
+             ((type == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) && (srccolors[j][i][3] <= ALPHACUT))) {
+            solid = GL_FALSE;
+            break;
+         }
+      }
+   }
+   if (solid) {
+      const GLushort color = (srccolors[0][0][0] & 0xf8) << 8 |
+         (srccolors[0][0][1] & 0xfc) << 3 | srccolors[0][0][2] >> 3;
+      *blkaddr++ = color & 0xff;
+      *blkaddr++ = color >> 8;
+      *blkaddr++ = color & 0xff;
+      *blkaddr++ = color >> 8;
+      *blkaddr++ = 0;
+      *blkaddr++ = 0;
+      *blkaddr++ = 0;
+      *blkaddr = 0;
+      return;
+   }
 
    lowcv = highcv = srccolors[0][0][0] * srccolors[0][0][0] * REDWEIGHT +
                           srccolors[0][0][1] * srccolors[0][0][1] * GREENWEIGHT +
@@ -36,6 +36,7 @@
 #include "c99_math.h"
 #include "main/glheader.h"
 #include "main/macros.h"
+#include "util/u_cpu_detect.h"
 
 #include "m_eval.h"
 #include "m_matrix.h"
@@ -107,6 +108,9 @@ _math_init_transformation( void )
    init_copy0();
    init_dotprod();
 
+   util_cpu_detect();
+   _math_init_sse_transformation();
+
 #ifdef DEBUG_MATH
    _math_test_all_transform_functions( "default" );
    _math_test_all_normal_transform_functions( "default" );
@@ -0,0 +1,253 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * SSE intrinsics versions of the most used transform and cliptest
+ * functions, for builds without the x86 assembly.  Each vertex is one
+ * vector, and the arithmetic is done in the same order as in
+ * m_xform_tmp.h and m_clip_tmp.h, so the results are the same.
+ */
+
+
+#include "main/glheader.h"
+#include "main/macros.h"
+#include "util/u_cpu_detect.h"
+
+#include "m_matrix.h"
+#include "m_xform.h"
+
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+
+#include <xmmintrin.h>
+
+
+#define STRIDE_LOOP for ( i = 0 ; i < count ; i++, STRIDE_F(from, stride) )
+
+
+/**
+ * Sum of columns c0..c2 weighted by a 3-vector, plus c3.
+ */
+#define XFORM3(c0, c1, c2, c3, from)                                    \
+   _mm_add_ps(_mm_add_ps(_mm_add_ps(                                    \
+      _mm_mul_ps(c0, _mm_set1_ps((from)[0])),                           \
+      _mm_mul_ps(c1, _mm_set1_ps((from)[1]))),                          \
+      _mm_mul_ps(c2, _mm_set1_ps((from)[2]))), c3)
+
+/**
+ * Sum of columns c0..c3 weighted by a 4-vector.
+ */
+#define XFORM4(c0, c1, c2, c3, from)                                    \
+   _mm_add_ps(_mm_add_ps(_mm_add_ps(                                    \
+      _mm_mul_ps(c0, _mm_set1_ps((from)[0])),                           \
+      _mm_mul_ps(c1, _mm_set1_ps((from)[1]))),                          \
+      _mm_mul_ps(c2, _mm_set1_ps((from)[2]))),                          \
+      _mm_mul_ps(c3, _mm_set1_ps((from)[3])))
+
+
+/*
+ * A general 3-vector transform, which gives the 4-vector result, and a
+ * 3D one, which gives the same arithmetic for x, y and z and leaves w
+ * unused.
+ */
+#define TRANSFORM_POINTS3(name, outsize)                                \
+static void                                                             \
+name(GLvector4f *to_vec, const GLfloat m[16], const GLvector4f *from_vec) \
+{                                                                       \
+   const GLuint stride = from_vec->stride;                              \
+   const GLfloat *from = from_vec->start;                               \
+   GLfloat (*to)[4] = (GLfloat (*)[4]) to_vec->start;                   \
+   const GLuint count = from_vec->count;                                \
+   const __m128 c0 = _mm_loadu_ps(m);                                   \
+   const __m128 c1 = _mm_loadu_ps(m + 4);                               \
+   const __m128 c2 = _mm_loadu_ps(m + 8);                               \
+   const __m128 c3 = _mm_loadu_ps(m + 12);                              \
+   GLuint i;                                                            \
+   STRIDE_LOOP {                                                        \
+      _mm_storeu_ps(to[i], XFORM3(c0, c1, c2, c3, from));               \
+   }                                                                    \
+   to_vec->size = outsize;                                              \
+   to_vec->flags |= VEC_SIZE_##outsize;                                 \
+   to_vec->count = from_vec->count;                                     \
+}
+
+TRANSFORM_POINTS3(transform_points3_general_sse, 4)
+TRANSFORM_POINTS3(transform_points3_3d_sse, 3)
+
+
+static void
+transform_points4_general_sse(GLvector4f *to_vec, const GLfloat m[16],
+                              const GLvector4f *from_vec)
+{
+   const GLuint stride = from_vec->stride;
+   const GLfloat *from = from_vec->start;
+   GLfloat (*to)[4] = (GLfloat (*)[4]) to_vec->start;
+   const GLuint count = from_vec->count;
+   const __m128 c0 = _mm_loadu_ps(m);
+   const __m128 c1 = _mm_loadu_ps(m + 4);
+   const __m128 c2 = _mm_loadu_ps(m + 8);
+   const __m128 c3 = _mm_loadu_ps(m + 12);
+   GLuint i;
+   STRIDE_LOOP {
+      _mm_storeu_ps(to[i], XFORM4(c0, c1, c2, c3, from));
+   }
+   to_vec->size = 4;
+   to_vec->flags |= VEC_SIZE_4;
+   to_vec->count = from_vec->count;
+}
+
+
+/* Clip bits for the lanes of w - (x, y, z, w) < 0 and w + (x, y, z, w) < 0 */
+static const GLubyte clip_minus_bits[8] = {
+   0,
+   CLIP_RIGHT_BIT,
+   CLIP_TOP_BIT,
+   CLIP_RIGHT_BIT | CLIP_TOP_BIT,
+   CLIP_FAR_BIT,
+   CLIP_FAR_BIT | CLIP_RIGHT_BIT,
+   CLIP_FAR_BIT | CLIP_TOP_BIT,
+   CLIP_FAR_BIT | CLIP_RIGHT_BIT | CLIP_TOP_BIT
+};
+
+static const GLubyte clip_plus_bits[8] = {
+   0,
+   CLIP_LEFT_BIT,
+   CLIP_BOTTOM_BIT,
+   CLIP_LEFT_BIT | CLIP_BOTTOM_BIT,
+   CLIP_NEAR_BIT,
+   CLIP_NEAR_BIT | CLIP_LEFT_BIT,
+   CLIP_NEAR_BIT | CLIP_BOTTOM_BIT,
+   CLIP_NEAR_BIT | CLIP_LEFT_BIT | CLIP_BOTTOM_BIT
+};
+
+
+static inline GLubyte
+clip_mask_sse(__m128 v, int laneMask)
+{
+   const __m128 w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+   const __m128 zero = _mm_setzero_ps();
+   const int minus = _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(w, v), zero));
+   const int plus = _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(w, v), zero));
+
+   return clip_minus_bits[minus & laneMask] | clip_plus_bits[plus & laneMask];
+}
+
+
+static GLvector4f *
+cliptest_points4_sse(GLvector4f *clip_vec, GLvector4f *proj_vec,
+                     GLubyte clipMask[], GLubyte *orMask, GLubyte *andMask,
+                     GLboolean viewport_z_clip)
+{
+   const GLuint stride = clip_vec->stride;
+   const GLfloat *from = (GLfloat *) clip_vec->start;
+   const GLuint count = clip_vec->count;
+   const int laneMask = viewport_z_clip ? 0x7 : 0x3;
+   GLuint c = 0;
+   GLfloat (*vProj)[4] = (GLfloat (*)[4]) proj_vec->start;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   GLuint i;
+   STRIDE_LOOP {
+      const __m128 v = _mm_loadu_ps(from);
+      const GLubyte mask = clip_mask_sse(v, laneMask);
+
+      clipMask[i] = mask;
+      if (mask) {
+         c++;
+         tmpAndMask &= mask;
+         tmpOrMask |= mask;
+         _mm_storeu_ps(vProj[i], _mm_setr_ps(0.0F, 0.0F, 0.0F, 1.0F));
+      }
+      else {
+         const GLfloat oow = 1.0F / from[3];
+         _mm_storeu_ps(vProj[i], _mm_mul_ps(v, _mm_set1_ps(oow)));
+         vProj[i][3] = oow;
+      }
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = (GLubyte) (c < count ? 0 : tmpAndMask);
+
+   proj_vec->flags |= VEC_SIZE_4;
+   proj_vec->size = 4;
+   proj_vec->count = clip_vec->count;
+   return proj_vec;
+}
+
+
+static GLvector4f *
+cliptest_np_points4_sse(GLvector4f *clip_vec, GLvector4f *proj_vec,
+                        GLubyte clipMask[], GLubyte *orMask,
+                        GLubyte *andMask, GLboolean viewport_z_clip)
+{
+   const GLuint stride = clip_vec->stride;
+   const GLfloat *from = (GLfloat *) clip_vec->start;
+   const GLuint count = clip_vec->count;
+   const int laneMask = viewport_z_clip ? 0x7 : 0x3;
+   GLuint c = 0;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   GLuint i;
+   (void) proj_vec;
+   STRIDE_LOOP {
+      const GLubyte mask = clip_mask_sse(_mm_loadu_ps(from), laneMask);
+
+      clipMask[i] = mask;
+      if (mask) {
+         c++;
+         tmpAndMask &= mask;
+         tmpOrMask |= mask;
+      }
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = (GLubyte) (c < count ? 0 : tmpAndMask);
+   return clip_vec;
+}
+
+
+void
+_math_init_sse_transformation(void)
+{
+   if (!util_cpu_caps.has_sse)
+      return;
+
+   _mesa_transform_tab[3][MATRIX_GENERAL] = transform_points3_general_sse;
+   _mesa_transform_tab[3][MATRIX_3D] = transform_points3_3d_sse;
+   _mesa_transform_tab[4][MATRIX_GENERAL] = transform_points4_general_sse;
+
+   _mesa_clip_tab[4] = cliptest_points4_sse;
+   _mesa_clip_np_tab[4] = cliptest_np_points4_sse;
+}
+
+#else
+
+void
+_math_init_sse_transformation(void)
+{
+}
+
+#endif
@@ -36,6 +36,7 @@
 #include "main/shaderobj.h"
 #include "main/uniforms.h"
 #include "main/glspirv.h"
+#include "compiler/blob.h"
 #include "compiler/glsl/ast.h"
 #include "compiler/glsl/ir.h"
 #include "compiler/glsl/ir_expression_flattening.h"
@@ -53,6 +54,7 @@
 #include "program/prog_print.h"
 #include "program/program.h"
 #include "program/prog_parameter.h"
+#include "util/disk_cache.h"
 
 
 static int swizzle_for_size(int size);
@@ -149,7 +151,7 @@ namespace {
 
 class ir_to_mesa_instruction : public exec_node {
 public:
-   DECLARE_RALLOC_CXX_OPERATORS(ir_to_mesa_instruction)
+   DECLARE_LINEAR_ALLOC_CXX_OPERATORS(ir_to_mesa_instruction)
 
    enum prog_opcode op;
    dst_reg dst;
@@ -164,6 +166,8 @@ public:
 
 class variable_storage : public exec_node {
 public:
+   DECLARE_LINEAR_ALLOC_CXX_OPERATORS(variable_storage)
+
    variable_storage(ir_variable *var, gl_register_file file, int index)
       : file(file), index(index), var(var)
    {
@@ -326,6 +330,12 @@ public:
    void copy_propagate(void);
 
    void *mem_ctx;
+
+   /**
+    * Instructions and variable storage, which are only ever freed
+    * together with the visitor.
+    */
+   void *lin_ctx;
 };
 
 } /* anonymous namespace */
@@ -355,7 +365,7 @@ ir_to_mesa_visitor::emit(ir_instruction *ir, enum prog_opcode op,
 			 dst_reg dst,
 			 src_reg src0, src_reg src1, src_reg src2)
 {
-   ir_to_mesa_instruction *inst = new(mem_ctx) ir_to_mesa_instruction();
+   ir_to_mesa_instruction *inst = new(lin_ctx) ir_to_mesa_instruction();
    int num_reladdr = 0;
 
    /* If we have to do relative addressing, we want to load the ARL
@@ -639,7 +649,7 @@ ir_to_mesa_visitor::visit(ir_variable *ir)
       dst_reg dst;
       if (i == ir->get_num_state_slots()) {
 	 /* We'll set the index later. */
-	 storage = new(mem_ctx) variable_storage(ir, PROGRAM_STATE_VAR, -1);
+	 storage = new(lin_ctx) variable_storage(ir, PROGRAM_STATE_VAR, -1);
 	 this->variables.push_tail(storage);
 
 	 dst = undef_dst;
@@ -650,7 +660,7 @@ ir_to_mesa_visitor::visit(ir_variable *ir)
 	  */
 	 assert((int) ir->get_num_state_slots() == type_size(ir->type));
 
-	 storage = new(mem_ctx) variable_storage(ir, PROGRAM_TEMPORARY,
+	 storage = new(lin_ctx) variable_storage(ir, PROGRAM_TEMPORARY,
 						 this->next_temp);
 	 this->variables.push_tail(storage);
 	 this->next_temp += type_size(ir->type);
@@ -1481,7 +1491,7 @@ ir_to_mesa_visitor::visit(ir_dereference_variable *ir)
    if (!entry) {
       switch (var->data.mode) {
       case ir_var_uniform:
-	 entry = new(mem_ctx) variable_storage(var, PROGRAM_UNIFORM,
+	 entry = new(lin_ctx) variable_storage(var, PROGRAM_UNIFORM,
 					       var->data.param_index);
 	 this->variables.push_tail(entry);
 	 break;
@@ -1492,24 +1502,24 @@ ir_to_mesa_visitor::visit(ir_dereference_variable *ir)
 	  * and user-defined varyings.
 	  */
 	 assert(var->data.location != -1);
-         entry = new(mem_ctx) variable_storage(var,
+         entry = new(lin_ctx) variable_storage(var,
                                                PROGRAM_INPUT,
                                                var->data.location);
          break;
       case ir_var_shader_out:
 	 assert(var->data.location != -1);
-         entry = new(mem_ctx) variable_storage(var,
+         entry = new(lin_ctx) variable_storage(var,
                                                PROGRAM_OUTPUT,
                                                var->data.location);
 	 break;
       case ir_var_system_value:
-         entry = new(mem_ctx) variable_storage(var,
+         entry = new(lin_ctx) variable_storage(var,
                                                PROGRAM_SYSTEM_VALUE,
                                                var->data.location);
          break;
       case ir_var_auto:
       case ir_var_temporary:
-	 entry = new(mem_ctx) variable_storage(var, PROGRAM_TEMPORARY,
+	 entry = new(lin_ctx) variable_storage(var, PROGRAM_TEMPORARY,
 					       this->next_temp);
 	 this->variables.push_tail(entry);
 
@@ -1570,7 +1580,7 @@ ir_to_mesa_visitor::visit(ir_dereference_array *ir)
 	 index_reg = accum_reg;
       }
 
-      src.reladdr = ralloc(mem_ctx, src_reg);
+      src.reladdr = (src_reg *) linear_alloc_child(lin_ctx, sizeof(src_reg));
       memcpy(src.reladdr, &index_reg, sizeof(index_reg));
    }
 
@@ -2248,6 +2258,7 @@ ir_to_mesa_visitor::ir_to_mesa_visitor()
    next_signature_id = 1;
    current_function = NULL;
    mem_ctx = ralloc_context(NULL);
+   lin_ctx = linear_alloc_parent(mem_ctx, 0);
 }
 
 ir_to_mesa_visitor::~ir_to_mesa_visitor()
@@ -3024,8 +3035,191 @@ fail_exit:
    return NULL;
 }
 
+/**
+ * Restore the Mesa IR written by _mesa_ir_serialize_program() from the
+ * program's driver cache blob.
+ */
+static bool
+read_mesa_ir_from_cache(struct gl_program *prog)
+{
+   struct blob_reader blob;
+
+   if (!prog->driver_cache_blob)
+      return false;
+
+   blob_reader_init(&blob, prog->driver_cache_blob,
+                    prog->driver_cache_blob_size);
+
+   const unsigned num_instructions = blob_read_uint32(&blob);
+   prog->arb.NumTemporaries = blob_read_uint32(&blob);
+   prog->arb.NumAddressRegs = blob_read_uint32(&blob);
+   prog->arb.IndirectRegisterFiles = blob_read_uint32(&blob);
+   prog->SecondaryOutputsWritten = blob_read_uint64(&blob);
+
+   prog->arb.Instructions = rzalloc_array(prog, struct prog_instruction,
+                                          num_instructions);
+   blob_copy_bytes(&blob, prog->arb.Instructions,
+                   num_instructions * sizeof(struct prog_instruction));
+   prog->arb.NumInstructions = num_instructions;
+
+   /* We don't need the cached blob anymore so free it */
+   ralloc_free(prog->driver_cache_blob);
+   prog->driver_cache_blob = NULL;
+   prog->driver_cache_blob_size = 0;
+
+   return !blob.overrun && num_instructions > 0;
+}
+
+/**
+ * Finish linking a program whose metadata came from the shader cache, by
+ * restoring the Mesa IR of each stage instead of generating it.
+ */
+static GLboolean
+link_shader_from_cache(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+	 continue;
+
+      struct gl_program *linked_prog = prog->_LinkedShaders[i]->Program;
+
+      if (!read_mesa_ir_from_cache(linked_prog)) {
+         linker_error(prog, "invalid Mesa IR in the shader cache\n");
+         return GL_FALSE;
+      }
+
+      _mesa_associate_uniform_storage(ctx, prog, linked_prog, false);
+
+      if (!ctx->Driver.ProgramStringNotify(ctx,
+                                           _mesa_shader_stage_to_program(i),
+                                           linked_prog)) {
+         _mesa_reference_program(ctx, &prog->_LinkedShaders[i]->Program,
+                                 NULL);
+         return GL_FALSE;
+      }
+
+      if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+         fprintf(stderr, "%s Mesa IR retrieved from cache\n",
+                 _mesa_shader_stage_to_string(i));
+      }
+   }
+
+   return GL_TRUE;
+}
+
+#ifdef ENABLE_SHADER_CACHE
+/**
+ * Check that the driver cache blob of every linked stage holds Mesa IR as
+ * written by _mesa_ir_serialize_program(), without consuming it.
+ */
+static bool
+mesa_ir_cache_is_valid(struct gl_shader_program *prog)
+{
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+	 continue;
+
+      struct gl_program *linked_prog = prog->_LinkedShaders[i]->Program;
+      struct blob_reader blob;
+
+      if (!linked_prog->driver_cache_blob)
+         return false;
+
+      blob_reader_init(&blob, linked_prog->driver_cache_blob,
+                       linked_prog->driver_cache_blob_size);
+
+      const unsigned num_instructions = blob_read_uint32(&blob);
+      blob_skip_bytes(&blob, 3 * sizeof(uint32_t));
+      blob_read_uint64(&blob);
+      if (blob.overrun || num_instructions == 0 ||
+          (size_t) (blob.end - blob.current) !=
+          (size_t) num_instructions * sizeof(struct prog_instruction))
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * The program metadata came from the shader cache but its Mesa IR does
+ * not load, so treat it as a cache miss: drop the item, compile the
+ * shaders from source and link them again without the cache.  The key is
+ * kept so that the new link is written back under it.
+ */
+static void
+link_shaders_from_source(struct gl_context *ctx,
+                         struct gl_shader_program *prog)
+{
+   struct disk_cache *cache = ctx->Cache;
+   unsigned char sha1[sizeof(prog->data->sha1)];
+
+   if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+      fprintf(stderr, "invalid Mesa IR in the shader cache, "
+              "falling back to recompile\n");
+   }
+
+   memcpy(sha1, prog->data->sha1, sizeof(sha1));
+   disk_cache_remove(cache, sha1);
+
+   _mesa_clear_shader_program_data(ctx, prog);
+   prog->data = _mesa_create_shader_program_data();
+   prog->data->LinkStatus = LINKING_SUCCESS;
+
+   for (unsigned i = 0; i < prog->NumShaders; i++) {
+      _mesa_glsl_compile_shader(ctx, prog->Shaders[i], false, false, true);
+      if (!prog->Shaders[i]->CompileStatus)
+	 linker_error(prog, "linking with uncompiled/unspecialized shader");
+   }
+
+   /* Keep link_shaders() from loading the item again should the removal
+    * have failed.
+    */
+   ctx->Cache = NULL;
+   if (prog->data->LinkStatus)
+      link_shaders(ctx, prog);
+   ctx->Cache = cache;
+
+   memcpy(prog->data->sha1, sha1, sizeof(sha1));
+}
+#endif
+
 extern "C" {
 
+/**
+ * Save the Mesa IR of a linked program in its driver cache blob, which the
+ * shader cache stores along with the program metadata.
+ * Called via ctx->Driver.ShaderCacheSerializeDriverBlob()
+ */
+void
+_mesa_ir_serialize_program(struct gl_context *ctx, struct gl_program *prog)
+{
+   struct blob blob;
+   (void) ctx;
+
+   if (prog->driver_cache_blob)
+      return;
+
+   blob_init(&blob);
+   blob_write_uint32(&blob, prog->arb.NumInstructions);
+   blob_write_uint32(&blob, prog->arb.NumTemporaries);
+   blob_write_uint32(&blob, prog->arb.NumAddressRegs);
+   blob_write_uint32(&blob, prog->arb.IndirectRegisterFiles);
+   blob_write_uint64(&blob, prog->SecondaryOutputsWritten);
+   blob_write_bytes(&blob, prog->arb.Instructions,
+                    prog->arb.NumInstructions *
+                    sizeof(struct prog_instruction));
+
+   if (!blob.out_of_memory) {
+      prog->driver_cache_blob = ralloc_size(prog, blob.size);
+      if (prog->driver_cache_blob) {
+         memcpy(prog->driver_cache_blob, blob.data, blob.size);
+         prog->driver_cache_blob_size = blob.size;
+      }
+   }
+
+   blob_finish(&blob);
+}
+
 /**
  * Link a shader.
  * Called via ctx->Driver.LinkShader()
@@ -3037,6 +3231,10 @@ _mesa_ir_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
 {
    assert(prog->data->LinkStatus);
 
+   /* The shader cache restored everything but the Mesa IR. */
+   if (prog->data->LinkStatus == LINKING_SKIPPED)
+      return link_shader_from_cache(ctx, prog);
+
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
       if (prog->_LinkedShaders[i] == NULL)
 	 continue;
@@ -3158,6 +3356,12 @@ _mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
          _mesa_spirv_link_shaders(ctx, prog);
    }
 
+#ifdef ENABLE_SHADER_CACHE
+   if (prog->data->LinkStatus == LINKING_SKIPPED &&
+       !mesa_ir_cache_is_valid(prog))
+      link_shaders_from_source(ctx, prog);
+#endif
+
    /* If LinkStatus is LINKING_SUCCESS, then reset sampler validated to true.
     * Validation happens via the LinkShader call below. If LinkStatus is
     * LINKING_SKIPPED, then SamplersValidated will have been restored from the
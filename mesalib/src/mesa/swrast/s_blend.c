@@ -39,9 +39,11 @@
 #include "main/context.h"
 #include "main/colormac.h"
 #include "main/macros.h"
+#include "util/u_cpu_detect.h"
 
 #include "s_blend.h"
 #include "s_context.h"
+#include "s_simd.h"
 #include "s_span.h"
 
 
@@ -941,8 +943,16 @@ _swrast_choose_blend_func(struct gl_context *ctx, GLenum chanType)
       else
 #endif
       {
-         if (chanType == GL_UNSIGNED_BYTE)
-            swrast->BlendFunc = blend_transparency_ubyte;
+         if (chanType == GL_UNSIGNED_BYTE) {
+#if defined(SWRAST_SIMD)
+            if (util_cpu_caps.has_avx2)
+               swrast->BlendFunc = _swrast_avx2_blend_transparency_ubyte;
+            else if (util_cpu_caps.has_sse2)
+               swrast->BlendFunc = _swrast_sse2_blend_transparency_ubyte;
+            else
+#endif
+               swrast->BlendFunc = blend_transparency_ubyte;
+         }
          else if (chanType == GL_UNSIGNED_SHORT)
             swrast->BlendFunc = blend_transparency_ushort;
          else
@@ -35,6 +35,7 @@
 #include "main/teximage.h"
 #include "program/prog_parameter.h"
 #include "program/prog_statevars.h"
+#include "util/u_cpu_detect.h"
 #include "swrast.h"
 #include "s_blend.h"
 #include "s_context.h"
@@ -42,6 +43,7 @@
 #include "s_points.h"
 #include "s_span.h"
 #include "s_texfetch.h"
+#include "s_tilebin.h"
 #include "s_triangle.h"
 #include "s_texfilter.h"
 
@@ -403,7 +405,8 @@ _swrast_validate_point( struct gl_context *ctx, const SWvertex *v0 )
 
 /**
  * Called via swrast->BlendFunc.  Examine GL state to choose a blending
- * function, then call it.
+ * function, then call it.  Binned triangles may get here from several
+ * threads at once, the first of which chooses.
  */
 static void
 _swrast_validate_blend_func(struct gl_context *ctx, GLuint n, const GLubyte mask[],
@@ -412,8 +415,14 @@ _swrast_validate_blend_func(struct gl_context *ctx, GLuint n, const GLubyte mask
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
 
-   _swrast_validate_derived( ctx ); /* why is this needed? */
-   _swrast_choose_blend_func( ctx, chanType );
+   if (swrast->Bin)
+      mtx_lock(&swrast->Bin->Mutex);
+   if (swrast->BlendFunc == _swrast_validate_blend_func) {
+      _swrast_validate_derived( ctx ); /* why is this needed? */
+      _swrast_choose_blend_func( ctx, chanType );
+   }
+   if (swrast->Bin)
+      mtx_unlock(&swrast->Bin->Mutex);
 
    swrast->BlendFunc( ctx, n, mask, src, dst, chanType );
 }
@@ -610,8 +619,8 @@ _swrast_Quad( struct gl_context *ctx,
       _swrast_print_vertex( ctx, v2 );
       _swrast_print_vertex( ctx, v3 );
    }
-   SWRAST_CONTEXT(ctx)->Triangle( ctx, v0, v1, v3 );
-   SWRAST_CONTEXT(ctx)->Triangle( ctx, v1, v2, v3 );
+   _swrast_Triangle( ctx, v0, v1, v3 );
+   _swrast_Triangle( ctx, v1, v2, v3 );
 }
 
 void
@@ -624,6 +633,16 @@ _swrast_Triangle( struct gl_context *ctx, const SWvertex *v0,
       _swrast_print_vertex( ctx, v1 );
       _swrast_print_vertex( ctx, v2 );
    }
+   if (_swrast_bin_active(ctx)) {
+      SWcontext *swrast = SWRAST_CONTEXT(ctx);
+      /* the triangle function isn't known until validated */
+      if (swrast->Triangle == _swrast_validate_triangle ||
+          _swrast_triangle_binnable(ctx)) {
+         _swrast_bin_triangle( ctx, v0, v1, v2 );
+         return;
+      }
+   }
+   _swrast_flush_bins( ctx );
    SWRAST_CONTEXT(ctx)->Triangle( ctx, v0, v1, v2 );
 }
 
@@ -635,6 +654,7 @@ _swrast_Line( struct gl_context *ctx, const SWvertex *v0, const SWvertex *v1 )
       _swrast_print_vertex( ctx, v0 );
       _swrast_print_vertex( ctx, v1 );
    }
+   _swrast_flush_bins( ctx );
    SWRAST_CONTEXT(ctx)->Line( ctx, v0, v1 );
 }
 
@@ -645,6 +665,7 @@ _swrast_Point( struct gl_context *ctx, const SWvertex *v0 )
       _mesa_debug(ctx, "_swrast_Point\n");
       _swrast_print_vertex( ctx, v0 );
    }
+   _swrast_flush_bins( ctx );
    SWRAST_CONTEXT(ctx)->Point( ctx, v0 );
 }
 
@@ -654,6 +675,7 @@ _swrast_InvalidateState( struct gl_context *ctx, GLbitfield new_state )
    if (SWRAST_DEBUG) {
       _mesa_debug(ctx, "_swrast_InvalidateState\n");
    }
+   _swrast_flush_bins( ctx );
    SWRAST_CONTEXT(ctx)->InvalidateState( ctx, new_state );
 }
 
@@ -741,6 +763,9 @@ _swrast_CreateContext( struct gl_context *ctx )
    if (!swrast)
       return GL_FALSE;
 
+   /* for the thread count and the SIMD span functions */
+   util_cpu_detect();
+
    swrast->NewState = ~0;
 
    swrast->choose_point = _swrast_choose_point;
@@ -811,6 +836,8 @@ _swrast_CreateContext( struct gl_context *ctx )
       return GL_FALSE;
    }
 
+   _swrast_create_binner(ctx);
+
    return GL_TRUE;
 }
 
@@ -823,6 +850,8 @@ _swrast_DestroyContext( struct gl_context *ctx )
       _mesa_debug(ctx, "_swrast_DestroyContext\n");
    }
 
+   _swrast_destroy_binner(ctx);
+
    free( swrast->SpanArrays );
    free( swrast->ZoomedArrays );
    free( swrast->TexelBuffer );
@@ -849,6 +878,8 @@ void
 _swrast_flush( struct gl_context *ctx )
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   /* draw any binned triangles */
+   _swrast_flush_bins(ctx);
    /* flush any pending fragments from rendering points */
    if (swrast->PointSpan.end > 0) {
       _swrast_write_rgba_span(ctx, &(swrast->PointSpan));
@@ -892,6 +923,8 @@ _swrast_render_start( struct gl_context *ctx )
    if (swrast->Driver.SpanRenderStart)
       swrast->Driver.SpanRenderStart( ctx );
    swrast->PointSpan.end = 0;
+   if (swrast->Bin)
+      swrast->Bin->Rendering = GL_TRUE;
 }
  
 void
@@ -901,6 +934,8 @@ _swrast_render_finish( struct gl_context *ctx )
    struct gl_query_object *query = ctx->Query.CurrentOcclusionObject;
 
    _swrast_flush(ctx);
+   if (swrast->Bin)
+      swrast->Bin->Rendering = GL_FALSE;
 
    if (swrast->Driver.SpanRenderFinish)
       swrast->Driver.SpanRenderFinish( ctx );
@@ -51,6 +51,35 @@
 #include "s_span.h"
 
 
+struct swrast_binner;
+
+
+/** Temporary arrays for stencil operations */
+struct swrast_stencil_temp
+{
+   GLubyte *buf1, *buf2, *buf3, *buf4;
+};
+
+
+/**
+ * The scratch buffers of a thread rasterising binned triangles (see
+ * s_tilebin.c), used in place of the SWcontext ones of the same names,
+ * and the rows the thread is restricted to.
+ */
+struct swrast_thread
+{
+   struct gl_context *ctx;
+   SWspanarrays *SpanArrays;
+   GLfloat *TexelBuffer;
+   struct gl_program_machine FragProgMachine;
+   struct swrast_stencil_temp stencil_temp;
+   GLint BinYmin, BinYmax;
+};
+
+extern struct swrast_thread *
+_swrast_bin_thread(void);
+
+
 typedef void (*texture_sample_func)(struct gl_context *ctx,
                                     const struct gl_sampler_object *samp,
                                     const struct gl_texture_object *tObj,
@@ -326,9 +355,10 @@ typedef struct
    /** Temporary arrays for stencil operations.  To avoid large stack
     * allocations.
     */
-   struct {
-      GLubyte *buf1, *buf2, *buf3, *buf4;
-   } stencil_temp;
+   struct swrast_stencil_temp stencil_temp;
+
+   /** Deferred triangles and the threads rasterising them, or NULL */
+   struct swrast_binner *Bin;
 
 } SWcontext;
 
@@ -473,6 +503,39 @@ _swrast_unmap_renderbuffers(struct gl_context *ctx);
 #define ATTRIB_LOOP_END } }
 
 
+/*
+ * The per-thread scratch buffers of the thread calling, which are the
+ * SWcontext's own except while rasterising binned triangles.
+ */
+static inline SWspanarrays *
+_swrast_span_arrays(SWcontext *swrast)
+{
+   struct swrast_thread *thread = _swrast_bin_thread();
+   return thread ? thread->SpanArrays : swrast->SpanArrays;
+}
+
+static inline GLfloat **
+_swrast_texel_buffer(SWcontext *swrast)
+{
+   struct swrast_thread *thread = _swrast_bin_thread();
+   return thread ? &thread->TexelBuffer : &swrast->TexelBuffer;
+}
+
+static inline struct gl_program_machine *
+_swrast_fragprog_machine(SWcontext *swrast)
+{
+   struct swrast_thread *thread = _swrast_bin_thread();
+   return thread ? &thread->FragProgMachine : &swrast->FragProgMachine;
+}
+
+static inline struct swrast_stencil_temp *
+_swrast_stencil_temp(SWcontext *swrast)
+{
+   struct swrast_thread *thread = _swrast_bin_thread();
+   return thread ? &thread->stencil_temp : &swrast->stencil_temp;
+}
+
+
 /**
  * Return the address of a pixel value in a mapped renderbuffer.
  */
@@ -30,9 +30,11 @@
 #include "main/format_pack.h"
 #include "main/macros.h"
 #include "main/imports.h"
+#include "util/u_cpu_detect.h"
 
 #include "s_context.h"
 #include "s_depth.h"
+#include "s_simd.h"
 #include "s_span.h"
 
 
@@ -72,6 +74,13 @@ depth_test_span16( struct gl_context *ctx, GLuint n,
    const GLboolean write = ctx->Depth.Mask;
    GLuint passed = 0;
 
+#ifdef SWRAST_SIMD
+   if ((ctx->Depth.Func == GL_LESS || ctx->Depth.Func == GL_LEQUAL) &&
+       util_cpu_caps.has_sse2)
+      return _swrast_simd_depth_test_span16(n, zbuffer, zfrag, mask,
+                                            ctx->Depth.Func, write);
+#endif
+
    /* switch cases ordered from most frequent to less frequent */
    switch (ctx->Depth.Func) {
    case GL_LESS:
@@ -120,6 +129,14 @@ depth_test_span32( struct gl_context *ctx, GLuint n,
    const GLboolean write = ctx->Depth.Mask;
    GLuint passed = 0;
 
+#ifdef SWRAST_SIMD
+   if ((ctx->Depth.Func == GL_LESS || ctx->Depth.Func == GL_LEQUAL) &&
+       util_cpu_caps.has_sse2)
+      return _swrast_simd_depth_test_span32(n, zbuffer, zfrag, mask,
+                                            ctx->Depth.Func, write,
+                                            0xffffffff, 0);
+#endif
+
    /* switch cases ordered from most frequent to less frequent */
    switch (ctx->Depth.Func) {
    case GL_LESS:
@@ -300,6 +317,28 @@ _swrast_depth_test_span(struct gl_context *ctx, SWspan *span)
    else
       zStart = _swrast_pixel_address(rb, span->x, span->y);
 
+#ifdef SWRAST_SIMD
+   if ((rb->Format == MESA_FORMAT_Z24_UNORM_X8_UINT ||
+        rb->Format == MESA_FORMAT_Z24_UNORM_S8_UINT ||
+        rb->Format == MESA_FORMAT_X8_UINT_Z24_UNORM ||
+        rb->Format == MESA_FORMAT_S8_UINT_Z24_UNORM) &&
+       !(span->arrayMask & SPAN_XY) &&
+       (ctx->Depth.Func == GL_LESS || ctx->Depth.Func == GL_LEQUAL) &&
+       util_cpu_caps.has_sse2) {
+      /* test and write the 24 Z bits in place, keeping the other 8 */
+      const GLuint zshift = (rb->Format == MESA_FORMAT_X8_UINT_Z24_UNORM ||
+                             rb->Format == MESA_FORMAT_S8_UINT_Z24_UNORM) ? 8 : 0;
+      passed = _swrast_simd_depth_test_span32(count, zStart, fragZ, mask,
+                                              ctx->Depth.Func,
+                                              ctx->Depth.Mask,
+                                              0xffffff << zshift, zshift);
+      if (passed < count) {
+         span->writeAll = GL_FALSE;
+      }
+      return passed;
+   }
+#endif
+
    if (rb->Format == MESA_FORMAT_Z_UNORM16 && !(span->arrayMask & SPAN_XY)) {
       /* directly read/write row of 16-bit Z values */
       zBufferVals = zStart;
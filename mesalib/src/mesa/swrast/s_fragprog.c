@@ -205,7 +205,7 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
    const struct gl_program *program = ctx->FragmentProgram._Current;
    const GLbitfield64 outputsWritten = program->info.outputs_written;
-   struct gl_program_machine *machine = &swrast->FragProgMachine;
+   struct gl_program_machine *machine = _swrast_fragprog_machine(swrast);
    GLuint i;
 
    for (i = start; i < end; i++) {
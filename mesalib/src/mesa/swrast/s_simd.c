@@ -0,0 +1,480 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "main/glheader.h"
+#include "main/macros.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_math.h"
+
+#include "s_context.h"
+#include "s_simd.h"
+
+
+#ifdef SWRAST_SIMD
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+/* AVX2 code is only run after checking util_cpu_caps.has_avx2, so gcc
+ * may use AVX2 in those functions only.  MSVC allows it anywhere.
+ */
+#if defined(_MSC_VER)
+#define AVX2_FUNC
+#else
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+
+
+static inline GLuint
+load_u32(const void *p)
+{
+   GLuint v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline void
+store_u32(void *p, GLuint v)
+{
+   memcpy(p, &v, sizeof(v));
+}
+
+
+/**
+ * Interpolate fixed point RGBA colors into a ubyte color array, as the
+ * GL_UNSIGNED_BYTE case of interpolate_int_colors().
+ * \param start, step  the colors at the first fragment and their X
+ *                     steps, in RCOMP..ACOMP order
+ */
+void
+_swrast_sse2_interp_rgba8(GLuint n, GLubyte rgba[][4],
+                          const GLint start[4], const GLint step[4])
+{
+   const __m128i low8 = _mm_set1_epi32(0xff);
+   const __m128i d1 = _mm_loadu_si128((const __m128i *) step);
+   const __m128i d2 = _mm_add_epi32(d1, d1);
+   const __m128i d4 = _mm_add_epi32(d2, d2);
+   __m128i c = _mm_loadu_si128((const __m128i *) start);
+   GLint tail[4];
+   GLuint i;
+
+   for (i = 0; i + 4 <= n; i += 4) {
+      /* FixedToChan() of four pixels, truncated to 8 bits like the
+       * stores in the C code
+       */
+      __m128i p0 = c;
+      __m128i p1 = _mm_add_epi32(c, d1);
+      __m128i p2 = _mm_add_epi32(c, d2);
+      __m128i p3 = _mm_add_epi32(p1, d2);
+      p0 = _mm_and_si128(_mm_srai_epi32(p0, FIXED_SHIFT), low8);
+      p1 = _mm_and_si128(_mm_srai_epi32(p1, FIXED_SHIFT), low8);
+      p2 = _mm_and_si128(_mm_srai_epi32(p2, FIXED_SHIFT), low8);
+      p3 = _mm_and_si128(_mm_srai_epi32(p3, FIXED_SHIFT), low8);
+      _mm_storeu_si128((__m128i *) rgba[i],
+                       _mm_packus_epi16(_mm_packs_epi32(p0, p1),
+                                        _mm_packs_epi32(p2, p3)));
+      c = _mm_add_epi32(c, d4);
+   }
+
+   for (; i < n; i++) {
+      _mm_storeu_si128((__m128i *) tail, c);
+      rgba[i][0] = FixedToChan(tail[0]);
+      rgba[i][1] = FixedToChan(tail[1]);
+      rgba[i][2] = FixedToChan(tail[2]);
+      rgba[i][3] = FixedToChan(tail[3]);
+      c = _mm_add_epi32(c, d1);
+   }
+}
+
+
+/**
+ * Interpolate one perspective corrected float attribute, as the loop in
+ * interpolate_active_attribs().
+ */
+void
+_swrast_sse2_interp_attrib(GLuint n, GLfloat dst[][4],
+                           const GLfloat start[4], const GLfloat step[4],
+                           GLfloat w, GLfloat dwdx)
+{
+   const __m128 dv = _mm_loadu_ps(step);
+   __m128 v = _mm_loadu_ps(start);
+   GLuint k;
+
+   for (k = 0; k < n; k++) {
+      const GLfloat invW = 1.0f / w;
+      _mm_storeu_ps(dst[k], _mm_mul_ps(v, _mm_set1_ps(invW)));
+      v = _mm_add_ps(v, dv);
+      w += dwdx;
+   }
+}
+
+
+/**
+ * GL_LESS or GL_LEQUAL depth test of 16-bit Z values, eight at a time,
+ * as depth_test_span16().
+ */
+GLuint
+_swrast_simd_depth_test_span16(GLuint n, GLushort zbuffer[],
+                               const GLuint zfrag[], GLubyte mask[],
+                               GLenum func, GLboolean write)
+{
+   /* SSE2 only compares signed values, so both sides are biased */
+   const __m128i bias16 = _mm_set1_epi16((short) 0x8000);
+   const __m128i bias32 = _mm_set1_epi32(0x8000);
+   const __m128i ones = _mm_set1_epi32(-1);
+   const __m128i zero = _mm_setzero_si128();
+   GLuint passed = 0;
+   GLuint i;
+
+   assert(func == GL_LESS || func == GL_LEQUAL);
+
+   for (i = 0; i + 8 <= n; i += 8) {
+      const __m128i zf =
+         _mm_packs_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *) &zfrag[i]),
+                                       bias32),
+                         _mm_sub_epi32(_mm_loadu_si128((const __m128i *) &zfrag[i + 4]),
+                                       bias32));
+      __m128i zb = _mm_loadu_si128((const __m128i *) &zbuffer[i]);
+      const __m128i m = _mm_loadl_epi64((const __m128i *) &mask[i]);
+      const __m128i dead = _mm_cmpeq_epi16(_mm_unpacklo_epi8(m, zero), zero);
+      __m128i pass, pass8;
+
+      if (func == GL_LESS)
+         pass = _mm_cmplt_epi16(zf, _mm_xor_si128(zb, bias16));
+      else
+         pass = _mm_xor_si128(_mm_cmpgt_epi16(zf, _mm_xor_si128(zb, bias16)),
+                              ones);
+      pass = _mm_andnot_si128(dead, pass);
+
+      if (write) {
+         zb = _mm_or_si128(_mm_and_si128(pass, _mm_xor_si128(zf, bias16)),
+                           _mm_andnot_si128(pass, zb));
+         _mm_storeu_si128((__m128i *) &zbuffer[i], zb);
+      }
+
+      pass8 = _mm_packs_epi16(pass, pass);
+      _mm_storel_epi64((__m128i *) &mask[i], _mm_and_si128(m, pass8));
+      passed += util_bitcount(_mm_movemask_epi8(pass8) & 0xff);
+   }
+
+   for (; i < n; i++) {
+      if (mask[i]) {
+         if (func == GL_LESS ? zfrag[i] < zbuffer[i] : zfrag[i] <= zbuffer[i]) {
+            if (write)
+               zbuffer[i] = zfrag[i];
+            passed++;
+         }
+         else {
+            mask[i] = 0;
+         }
+      }
+   }
+
+   return passed;
+}
+
+
+static GLuint
+depth_test_span32_sse2(GLuint n, GLuint zbuffer[],
+                       const GLuint zfrag[], GLubyte mask[],
+                       GLenum func, GLboolean write,
+                       GLuint zmask, GLuint zshift)
+{
+   const __m128i bias = _mm_set1_epi32((int) 0x80000000);
+   const __m128i zm = _mm_set1_epi32((int) zmask);
+   const __m128i ones = _mm_set1_epi32(-1);
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i shift = _mm_cvtsi32_si128(zshift);
+   GLuint passed = 0;
+   GLuint i;
+
+   for (i = 0; i + 4 <= n; i += 4) {
+      const __m128i zf =
+         _mm_sll_epi32(_mm_loadu_si128((const __m128i *) &zfrag[i]), shift);
+      __m128i zb = _mm_loadu_si128((const __m128i *) &zbuffer[i]);
+      const GLuint m = load_u32(&mask[i]);
+      const __m128i dead =
+         _mm_cmpeq_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(m),
+                                                              zero),
+                                            zero),
+                         zero);
+      const __m128i a = _mm_xor_si128(zf, bias);
+      const __m128i b = _mm_xor_si128(_mm_and_si128(zb, zm), bias);
+      __m128i pass;
+
+      if (func == GL_LESS)
+         pass = _mm_cmplt_epi32(a, b);
+      else
+         pass = _mm_xor_si128(_mm_cmpgt_epi32(a, b), ones);
+      pass = _mm_andnot_si128(dead, pass);
+
+      if (write) {
+         const __m128i z = _mm_or_si128(_mm_andnot_si128(zm, zb), zf);
+         zb = _mm_or_si128(_mm_and_si128(pass, z), _mm_andnot_si128(pass, zb));
+         _mm_storeu_si128((__m128i *) &zbuffer[i], zb);
+      }
+
+      store_u32(&mask[i],
+                m & (GLuint) _mm_cvtsi128_si32(
+                       _mm_packs_epi16(_mm_packs_epi32(pass, pass), zero)));
+      passed += util_bitcount(_mm_movemask_ps(_mm_castsi128_ps(pass)));
+   }
+
+   for (; i < n; i++) {
+      if (mask[i]) {
+         const GLuint zf = zfrag[i] << zshift;
+         const GLuint zb = zbuffer[i] & zmask;
+         if (func == GL_LESS ? zf < zb : zf <= zb) {
+            if (write)
+               zbuffer[i] = (zbuffer[i] & ~zmask) | zf;
+            passed++;
+         }
+         else {
+            mask[i] = 0;
+         }
+      }
+   }
+
+   return passed;
+}
+
+
+static AVX2_FUNC GLuint
+depth_test_span32_avx2(GLuint n, GLuint zbuffer[],
+                       const GLuint zfrag[], GLubyte mask[],
+                       GLenum func, GLboolean write,
+                       GLuint zmask, GLuint zshift)
+{
+   const __m256i bias = _mm256_set1_epi32((int) 0x80000000);
+   const __m256i zm = _mm256_set1_epi32((int) zmask);
+   const __m256i zero = _mm256_setzero_si256();
+   const __m128i shift = _mm_cvtsi32_si128(zshift);
+   GLuint passed = 0;
+   GLuint i, j;
+
+   for (i = 0; i + 8 <= n; i += 8) {
+      const __m256i zf =
+         _mm256_sll_epi32(_mm256_loadu_si256((const __m256i *) &zfrag[i]), shift);
+      const __m256i zb = _mm256_loadu_si256((const __m256i *) &zbuffer[i]);
+      const __m256i dead =
+         _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) &mask[i])),
+                            zero);
+      const __m256i a = _mm256_xor_si256(zf, bias);
+      const __m256i b = _mm256_xor_si256(_mm256_and_si256(zb, zm), bias);
+      __m256i fail;
+      GLuint bits;
+
+      if (func == GL_LESS)
+         fail = _mm256_cmpeq_epi32(_mm256_cmpgt_epi32(b, a), zero);
+      else
+         fail = _mm256_cmpgt_epi32(a, b);
+      fail = _mm256_or_si256(fail, dead);
+
+      if (write) {
+         const __m256i z = _mm256_or_si256(_mm256_andnot_si256(zm, zb), zf);
+         _mm256_storeu_si256((__m256i *) &zbuffer[i],
+                             _mm256_blendv_epi8(z, zb, fail));
+      }
+
+      bits = ~_mm256_movemask_ps(_mm256_castsi256_ps(fail)) & 0xff;
+      passed += util_bitcount(bits);
+      if (bits != 0xff) {
+         for (j = 0; j < 8; j++) {
+            if (!(bits & (1 << j)))
+               mask[i + j] = 0;
+         }
+      }
+   }
+
+   return passed + depth_test_span32_sse2(n - i, zbuffer + i, zfrag + i,
+                                          mask + i, func, write,
+                                          zmask, zshift);
+}
+
+
+/**
+ * GL_LESS or GL_LEQUAL depth test of 32-bit words, as depth_test_span32().
+ * Only the bits in zmask are Z, compared against zfrag << zshift; the
+ * others (stencil, or nothing) are kept when writing.
+ */
+GLuint
+_swrast_simd_depth_test_span32(GLuint n, GLuint zbuffer[],
+                               const GLuint zfrag[], GLubyte mask[],
+                               GLenum func, GLboolean write,
+                               GLuint zmask, GLuint zshift)
+{
+   assert(func == GL_LESS || func == GL_LEQUAL);
+
+   if (util_cpu_caps.has_avx2)
+      return depth_test_span32_avx2(n, zbuffer, zfrag, mask, func, write,
+                                    zmask, zshift);
+   return depth_test_span32_sse2(n, zbuffer, zfrag, mask, func, write,
+                                 zmask, zshift);
+}
+
+
+/**
+ * glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) of two pixels held as
+ * 16-bit lanes: DIV255((s - d) * t) + d, as blend_transparency_ubyte().
+ */
+static inline __m128i
+blend_transparency_sse2(__m128i s, __m128i d)
+{
+   const __m128i round = _mm_set1_epi32(256);
+   /* each pixel's alpha in all four of its lanes */
+   const __m128i t =
+      _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(ACOMP, ACOMP, ACOMP, ACOMP)),
+                          _MM_SHUFFLE(ACOMP, ACOMP, ACOMP, ACOMP));
+   const __m128i diff = _mm_sub_epi16(s, d);
+   const __m128i lo = _mm_mullo_epi16(diff, t);
+   const __m128i hi = _mm_mulhi_epi16(diff, t);
+   __m128i x0 = _mm_unpacklo_epi16(lo, hi);
+   __m128i x1 = _mm_unpackhi_epi16(lo, hi);
+
+   /* DIV255(X) = ((X << 8) + X + 256) >> 16 */
+   x0 = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(x0, 8), x0),
+                                     round), 16);
+   x1 = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(x1, 8), x1),
+                                     round), 16);
+   return _mm_add_epi16(_mm_packs_epi32(x0, x1), d);
+}
+
+
+/* Blend four pixels, leaving those whose mask byte is zero alone */
+static inline __m128i
+blend4_transparency_sse2(__m128i s, __m128i d, GLuint m)
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i keep =
+      _mm_cmpeq_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(m),
+                                                           zero),
+                                         zero),
+                      zero);
+   const __m128i r =
+      _mm_packus_epi16(blend_transparency_sse2(_mm_unpacklo_epi8(s, zero),
+                                               _mm_unpacklo_epi8(d, zero)),
+                       blend_transparency_sse2(_mm_unpackhi_epi8(s, zero),
+                                               _mm_unpackhi_epi8(d, zero)));
+
+   return _mm_or_si128(_mm_and_si128(keep, s), _mm_andnot_si128(keep, r));
+}
+
+
+void
+_swrast_sse2_blend_transparency_ubyte(struct gl_context *ctx, GLuint n,
+                                      const GLubyte mask[], GLvoid *src,
+                                      const GLvoid *dst, GLenum chanType)
+{
+   GLubyte (*rgba)[4] = (GLubyte (*)[4]) src;
+   const GLubyte (*dest)[4] = (const GLubyte (*)[4]) dst;
+   GLuint i;
+
+   assert(chanType == GL_UNSIGNED_BYTE);
+   (void) ctx;
+   (void) chanType;
+
+   for (i = 0; i + 4 <= n; i += 4) {
+      const __m128i s = _mm_loadu_si128((const __m128i *) rgba[i]);
+      const __m128i d = _mm_loadu_si128((const __m128i *) dest[i]);
+      _mm_storeu_si128((__m128i *) rgba[i],
+                       blend4_transparency_sse2(s, d, load_u32(&mask[i])));
+   }
+
+   /* the last few pixels go through a padded copy */
+   if (i < n) {
+      GLubyte s[4][4], d[4][4], m[4];
+      const GLuint count = n - i;
+
+      memset(s, 0, sizeof(s));
+      memset(d, 0, sizeof(d));
+      memset(m, 0, sizeof(m));
+      memcpy(s, rgba[i], count * 4);
+      memcpy(d, dest[i], count * 4);
+      memcpy(m, &mask[i], count);
+      _mm_storeu_si128((__m128i *) s,
+                       blend4_transparency_sse2(_mm_loadu_si128((const __m128i *) s),
+                                                _mm_loadu_si128((const __m128i *) d),
+                                                load_u32(m)));
+      memcpy(rgba[i], s, count * 4);
+   }
+}
+
+
+/** As blend_transparency_sse2(), for two pixels in each 128-bit lane */
+static inline AVX2_FUNC __m256i
+blend_transparency_avx2(__m256i s, __m256i d)
+{
+   const __m256i round = _mm256_set1_epi32(256);
+   const __m256i t =
+      _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(ACOMP, ACOMP, ACOMP, ACOMP)),
+                             _MM_SHUFFLE(ACOMP, ACOMP, ACOMP, ACOMP));
+   const __m256i diff = _mm256_sub_epi16(s, d);
+   const __m256i lo = _mm256_mullo_epi16(diff, t);
+   const __m256i hi = _mm256_mulhi_epi16(diff, t);
+   __m256i x0 = _mm256_unpacklo_epi16(lo, hi);
+   __m256i x1 = _mm256_unpackhi_epi16(lo, hi);
+
+   x0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(x0, 8), x0),
+                                           round), 16);
+   x1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(x1, 8), x1),
+                                           round), 16);
+   return _mm256_add_epi16(_mm256_packs_epi32(x0, x1), d);
+}
+
+
+AVX2_FUNC void
+_swrast_avx2_blend_transparency_ubyte(struct gl_context *ctx, GLuint n,
+                                      const GLubyte mask[], GLvoid *src,
+                                      const GLvoid *dst, GLenum chanType)
+{
+   GLubyte (*rgba)[4] = (GLubyte (*)[4]) src;
+   const GLubyte (*dest)[4] = (const GLubyte (*)[4]) dst;
+   const __m256i zero = _mm256_setzero_si256();
+   GLuint i;
+
+   /* the unpacks and packs all work within 128-bit lanes, so each lane
+    * holds pixels 0-3 or 4-7 throughout
+    */
+   for (i = 0; i + 8 <= n; i += 8) {
+      const __m256i s = _mm256_loadu_si256((const __m256i *) rgba[i]);
+      const __m256i d = _mm256_loadu_si256((const __m256i *) dest[i]);
+      const __m256i keep =
+         _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) &mask[i])),
+                            zero);
+      __m256i r;
+
+      r = _mm256_packus_epi16(blend_transparency_avx2(_mm256_unpacklo_epi8(s, zero),
+                                                      _mm256_unpacklo_epi8(d, zero)),
+                              blend_transparency_avx2(_mm256_unpackhi_epi8(s, zero),
+                                                      _mm256_unpackhi_epi8(d, zero)));
+      _mm256_storeu_si256((__m256i *) rgba[i], _mm256_blendv_epi8(r, s, keep));
+   }
+
+   if (i < n)
+      _swrast_sse2_blend_transparency_ubyte(ctx, n - i, mask + i, rgba + i,
+                                            dest + i, chanType);
+}
+
+#endif /* SWRAST_SIMD */
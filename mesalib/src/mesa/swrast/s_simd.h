@@ -0,0 +1,86 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * SSE2 (4-wide) and AVX2 (8-wide) versions of the hottest span stages.
+ * They give the same results as the C code they replace, which picks
+ * them at runtime from util_cpu_caps.
+ */
+
+
+#ifndef S_SIMD_H
+#define S_SIMD_H
+
+
+#include "main/glheader.h"
+
+struct gl_context;
+
+
+/* SSE2 is always there on x86-64, and is assumed wherever the compiler
+ * is allowed to use it on x86.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SWRAST_SIMD 1
+#endif
+
+
+#ifdef SWRAST_SIMD
+
+extern void
+_swrast_sse2_interp_rgba8(GLuint n, GLubyte rgba[][4],
+                          const GLint start[4], const GLint step[4]);
+
+extern void
+_swrast_sse2_interp_attrib(GLuint n, GLfloat dst[][4],
+                           const GLfloat start[4], const GLfloat step[4],
+                           GLfloat w, GLfloat dwdx);
+
+extern GLuint
+_swrast_simd_depth_test_span16(GLuint n, GLushort zbuffer[],
+                               const GLuint zfrag[], GLubyte mask[],
+                               GLenum func, GLboolean write);
+
+extern GLuint
+_swrast_simd_depth_test_span32(GLuint n, GLuint zbuffer[],
+                               const GLuint zfrag[], GLubyte mask[],
+                               GLenum func, GLboolean write,
+                               GLuint zmask, GLuint zshift);
+
+extern void
+_swrast_sse2_blend_transparency_ubyte(struct gl_context *ctx, GLuint n,
+                                      const GLubyte mask[], GLvoid *src,
+                                      const GLvoid *dst, GLenum chanType);
+
+extern void
+_swrast_avx2_blend_transparency_ubyte(struct gl_context *ctx, GLuint n,
+                                      const GLubyte mask[], GLvoid *src,
+                                      const GLvoid *dst, GLenum chanType);
+
+#endif /* SWRAST_SIMD */
+
+
+#endif /* S_SIMD_H */
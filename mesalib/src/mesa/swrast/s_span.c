@@ -43,6 +43,7 @@
 #include "main/state.h"
 #include "main/stencil.h"
 #include "main/teximage.h"
+#include "util/u_cpu_detect.h"
 
 #include "s_atifragshader.h"
 #include "s_alpha.h"
@@ -53,6 +54,7 @@
 #include "s_logic.h"
 #include "s_masking.h"
 #include "s_fragprog.h"
+#include "s_simd.h"
 #include "s_span.h"
 #include "s_stencil.h"
 #include "s_texcombine.h"
@@ -196,6 +198,15 @@ interpolate_active_attribs(struct gl_context *ctx, SWspan *span,
          GLfloat v2 = span->attrStart[attr][2] + span->leftClip * dv2dx;
          GLfloat v3 = span->attrStart[attr][3] + span->leftClip * dv3dx;
          GLuint k;
+#ifdef SWRAST_SIMD
+         if (util_cpu_caps.has_sse2) {
+            const GLfloat start[4] = { v0, v1, v2, v3 };
+            const GLfloat step[4] = { dv0dx, dv1dx, dv2dx, dv3dx };
+            _swrast_sse2_interp_attrib(span->end, span->array->attribs[attr],
+                                       start, step, w, dwdx);
+         }
+         else
+#endif
          for (k = 0; k < span->end; k++) {
             const GLfloat invW = 1.0f / w;
             span->array->attribs[attr][k][0] = v0 * invW;
@@ -253,6 +264,21 @@ interpolate_int_colors(struct gl_context *ctx, SWspan *span)
             GLint dg = span->greenStep;
             GLint db = span->blueStep;
             GLint da = span->alphaStep;
+#ifdef SWRAST_SIMD
+            if (util_cpu_caps.has_sse2) {
+               GLint start[4], step[4];
+               start[RCOMP] = r;
+               start[GCOMP] = g;
+               start[BCOMP] = b;
+               start[ACOMP] = a;
+               step[RCOMP] = dr;
+               step[GCOMP] = dg;
+               step[BCOMP] = db;
+               step[ACOMP] = da;
+               _swrast_sse2_interp_rgba8(n, rgba, start, step);
+            }
+            else
+#endif
             for (i = 0; i < n; i++) {
                rgba[i][RCOMP] = FixedToChan(r);
                rgba[i][GCOMP] = FixedToChan(g);
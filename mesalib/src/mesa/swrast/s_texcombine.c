@@ -52,7 +52,7 @@ get_texel_array(SWcontext *swrast, GLuint unit)
 #ifdef _OPENMP
    return (float4_array) (swrast->TexelBuffer + unit * SWRAST_MAX_WIDTH * 4 * omp_get_num_threads() + (SWRAST_MAX_WIDTH * 4 * omp_get_thread_num()));
 #else
-   return (float4_array) (swrast->TexelBuffer + unit * SWRAST_MAX_WIDTH * 4);
+   return (float4_array) (*_swrast_texel_buffer(swrast) + unit * SWRAST_MAX_WIDTH * 4);
 #endif
 }
 
@@ -587,10 +587,11 @@ void
 _swrast_texture_span( struct gl_context *ctx, SWspan *span )
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   GLfloat **texelBuffer = _swrast_texel_buffer(swrast);
    float4_array primary_rgba;
    GLuint unit;
 
-   if (!swrast->TexelBuffer) {
+   if (!*texelBuffer) {
 #ifdef _OPENMP
       const GLint maxThreads = omp_get_max_threads();
 
@@ -600,7 +601,7 @@ _swrast_texture_span( struct gl_context *ctx, SWspan *span )
        * initialized already by another thread while this thread was waiting.
        */
       #pragma omp critical
-      if (!swrast->TexelBuffer) {
+      if (!*texelBuffer) {
 #else
       const GLint maxThreads = 1;
 #endif
@@ -609,14 +610,14 @@ _swrast_texture_span( struct gl_context *ctx, SWspan *span )
        * instances; when running with multiple threads, create one per
        * thread.
        */
-      swrast->TexelBuffer =
+      *texelBuffer =
 	 malloc(ctx->Const.Program[MESA_SHADER_FRAGMENT].MaxTextureImageUnits * maxThreads *
 			    SWRAST_MAX_WIDTH * 4 * sizeof(GLfloat));
 #ifdef _OPENMP
       } /* critical section */
 #endif
 
-      if (!swrast->TexelBuffer) {
+      if (!*texelBuffer) {
 	 _mesa_error(ctx, GL_OUT_OF_MEMORY, "texture_combine");
 	 return;
       }
@@ -714,7 +715,7 @@ _swrast_texture_span( struct gl_context *ctx, SWspan *span )
     */
    for (unit = 0; unit < ctx->Const.MaxTextureUnits; unit++) {
       if (ctx->Texture.Unit[unit]._Current)
-         texture_combine(ctx, unit, primary_rgba, swrast->TexelBuffer, span);
+         texture_combine(ctx, unit, primary_rgba, *texelBuffer, span);
    }
 
    free(primary_rgba);
@@ -23,6 +23,7 @@
  */
 
 
+#include "c11/threads.h"
 #include "c99_math.h"
 #include "main/glheader.h"
 #include "main/context.h"
@@ -137,6 +138,32 @@ lerp_rgba_3d(GLfloat result[4], GLfloat a, GLfloat b, GLfloat c,
 }
 
 
+/**
+ * Do linear interpolation of packed 8-bit texels, with t in [0, 256].
+ * Even and odd bytes are blended as separate 16-bit lanes.
+ */
+static inline GLuint
+lerp_rgba8(GLint t, GLuint a, GLuint b)
+{
+   const GLuint rb = ((a & 0x00ff00ff) * (256 - t) +
+                      (b & 0x00ff00ff) * t) >> 8;
+   const GLuint ag = ((a >> 8) & 0x00ff00ff) * (256 - t) +
+                     ((b >> 8) & 0x00ff00ff) * t;
+   return (rb & 0x00ff00ff) | (ag & 0xff00ff00);
+}
+
+
+/**
+ * Do bilinear interpolation of packed 8-bit texels.
+ */
+static inline GLuint
+lerp_rgba8_2d(GLint a, GLint b,
+              GLuint t00, GLuint t10, GLuint t01, GLuint t11)
+{
+   return lerp_rgba8(b, lerp_rgba8(a, t00, t10), lerp_rgba8(a, t01, t11));
+}
+
+
 /**
  * Used for GL_REPEAT wrap mode.  Using A % B doesn't produce the
  * right results for A<0.  Casting to A to be unsigned only works if B
@@ -1357,6 +1384,134 @@ sample_2d_linear_mipmap_linear_repeat(struct gl_context *ctx,
 }
 
 
+/*
+ * Fixed-point GL_LINEAR and GL_LINEAR_MIPMAP_LINEAR sampling of the common
+ * RGBA8 formats, see s_texfilter_tmp.h.
+ */
+#define NAME(x) x##_a8b8g8r8_repeat
+#define WRAP GL_REPEAT
+#define RSHIFT 24
+#define GSHIFT 16
+#define BSHIFT 8
+#define ASHIFT 0
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_a8b8g8r8_clamp
+#define WRAP GL_CLAMP_TO_EDGE
+#define RSHIFT 24
+#define GSHIFT 16
+#define BSHIFT 8
+#define ASHIFT 0
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_r8g8b8a8_repeat
+#define WRAP GL_REPEAT
+#define RSHIFT 0
+#define GSHIFT 8
+#define BSHIFT 16
+#define ASHIFT 24
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_r8g8b8a8_clamp
+#define WRAP GL_CLAMP_TO_EDGE
+#define RSHIFT 0
+#define GSHIFT 8
+#define BSHIFT 16
+#define ASHIFT 24
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_b8g8r8a8_repeat
+#define WRAP GL_REPEAT
+#define RSHIFT 16
+#define GSHIFT 8
+#define BSHIFT 0
+#define ASHIFT 24
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_b8g8r8a8_clamp
+#define WRAP GL_CLAMP_TO_EDGE
+#define RSHIFT 16
+#define GSHIFT 8
+#define BSHIFT 0
+#define ASHIFT 24
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_r8g8b8x8_repeat
+#define WRAP GL_REPEAT
+#define RSHIFT 0
+#define GSHIFT 8
+#define BSHIFT 16
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_r8g8b8x8_clamp
+#define WRAP GL_CLAMP_TO_EDGE
+#define RSHIFT 0
+#define GSHIFT 8
+#define BSHIFT 16
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_b8g8r8x8_repeat
+#define WRAP GL_REPEAT
+#define RSHIFT 16
+#define GSHIFT 8
+#define BSHIFT 0
+#include "s_texfilter_tmp.h"
+
+#define NAME(x) x##_b8g8r8x8_clamp
+#define WRAP GL_CLAMP_TO_EDGE
+#define RSHIFT 16
+#define GSHIFT 8
+#define BSHIFT 0
+#include "s_texfilter_tmp.h"
+
+
+#define RGBA8_CASE(FORMAT, NAME)                                        \
+   case MESA_FORMAT_##FORMAT:                                           \
+      if (repeat)                                                       \
+         return mipmap ? sample_linear_mipmap_linear_##NAME##_repeat    \
+                       : sample_linear_##NAME##_repeat;                 \
+      else                                                              \
+         return mipmap ? sample_linear_mipmap_linear_##NAME##_clamp     \
+                       : sample_linear_##NAME##_clamp;
+
+/**
+ * Return the fixed-point function for GL_LINEAR (mipmap false) or
+ * GL_LINEAR_MIPMAP_LINEAR (mipmap true) sampling of the given 2-D
+ * texture, or NULL if there is none for its format and wrap modes.
+ */
+static texture_sample_func
+choose_linear_2d_rgba8(const struct gl_sampler_object *samp,
+                       const struct gl_texture_object *tObj,
+                       GLboolean mipmap)
+{
+   const struct gl_texture_image *img = _mesa_base_tex_image(tObj);
+   const struct swrast_texture_image *swImg = swrast_texture_image_const(img);
+   GLboolean repeat;
+
+   if (img->Border != 0 || samp->WrapS != samp->WrapT)
+      return NULL;
+
+   if (samp->WrapS == GL_REPEAT && swImg->_IsPowerOfTwo)
+      repeat = GL_TRUE;
+   else if (samp->WrapS == GL_CLAMP_TO_EDGE)
+      repeat = GL_FALSE;
+   else
+      return NULL;
+
+   switch (img->TexFormat) {
+   RGBA8_CASE(A8B8G8R8_UNORM, a8b8g8r8)
+   RGBA8_CASE(R8G8B8A8_UNORM, r8g8b8a8)
+   RGBA8_CASE(B8G8R8A8_UNORM, b8g8r8a8)
+   RGBA8_CASE(R8G8B8X8_UNORM, r8g8b8x8)
+   RGBA8_CASE(B8G8R8X8_UNORM, b8g8r8x8)
+   default:
+      return NULL;
+   }
+}
+
+#undef RGBA8_CASE
+
+
 /** Sample 2D texture, nearest filtering for both min/magnification */
 static void
 sample_nearest_2d(struct gl_context *ctx,
@@ -1385,8 +1540,13 @@ sample_linear_2d(struct gl_context *ctx,
    GLuint i;
    const struct gl_texture_image *image = _mesa_base_tex_image(tObj);
    const struct swrast_texture_image *swImg = swrast_texture_image_const(image);
+   const texture_sample_func rgba8 =
+      choose_linear_2d_rgba8(samp, tObj, GL_FALSE);
    (void) lambda;
-   if (samp->WrapS == GL_REPEAT &&
+   if (rgba8) {
+      rgba8(ctx, samp, tObj, n, texcoords, NULL, rgba);
+   }
+   else if (samp->WrapS == GL_REPEAT &&
        samp->WrapT == GL_REPEAT &&
        swImg->_IsPowerOfTwo &&
        image->Border == 0) {
@@ -1504,6 +1664,7 @@ sample_lambda_2d(struct gl_context *ctx,
    const struct swrast_texture_image *swImg = swrast_texture_image_const(tImg);
    GLuint minStart, minEnd;  /* texels with minification */
    GLuint magStart, magEnd;  /* texels with magnification */
+   texture_sample_func rgba8;
 
    const GLboolean repeatNoBorderPOT = (samp->WrapS == GL_REPEAT)
       && (samp->WrapT == GL_REPEAT)
@@ -1559,7 +1720,10 @@ sample_lambda_2d(struct gl_context *ctx,
                                          lambda + minStart, rgba + minStart);
          break;
       case GL_LINEAR_MIPMAP_LINEAR:
-         if (repeatNoBorderPOT)
+         if ((rgba8 = choose_linear_2d_rgba8(samp, tObj, GL_TRUE)))
+            rgba8(ctx, samp, tObj, m, texcoords + minStart,
+                  lambda + minStart, rgba + minStart);
+         else if (repeatNoBorderPOT)
             sample_2d_linear_mipmap_linear_repeat(ctx, samp, tObj, m,
                   texcoords + minStart, lambda + minStart, rgba + minStart);
          else
@@ -1614,23 +1778,24 @@ sample_lambda_2d(struct gl_context *ctx,
 #define WEIGHT_LUT_SIZE 1024
 
 static GLfloat *weightLut = NULL;
+static once_flag weightLutOnce = ONCE_FLAG_INIT;
 
 /**
- * Creates the look-up table used to speed-up EWA sampling
+ * Creates the look-up table used to speed-up EWA sampling.
+ * Run through call_once(): the binned rasteriser samples from several
+ * threads at once.
  */
 static void
 create_filter_table(void)
 {
    GLuint i;
-   if (!weightLut) {
-      weightLut = malloc(WEIGHT_LUT_SIZE * sizeof(GLfloat));
+   weightLut = malloc(WEIGHT_LUT_SIZE * sizeof(GLfloat));
 
-      for (i = 0; i < WEIGHT_LUT_SIZE; ++i) {
-         GLfloat alpha = 2;
-         GLfloat r2 = (GLfloat) i / (GLfloat) (WEIGHT_LUT_SIZE - 1);
-         GLfloat weight = (GLfloat) exp(-alpha * r2);
-         weightLut[i] = weight;
-      }
+   for (i = 0; i < WEIGHT_LUT_SIZE; ++i) {
+      GLfloat alpha = 2;
+      GLfloat r2 = (GLfloat) i / (GLfloat) (WEIGHT_LUT_SIZE - 1);
+      GLfloat weight = (GLfloat) exp(-alpha * r2);
+      weightLut[i] = weight;
    }
 }
 
@@ -1907,9 +2072,7 @@ sample_lambda_2d_aniso(struct gl_context *ctx,
    GLuint i;
    
    /* on first access create the lookup table containing the filter weights. */
-   if (!weightLut) {
-      create_filter_table();
-   }
+   call_once(&weightLutOnce, create_filter_table);
 
    texW = swImg->WidthScale;
    texH = swImg->HeightScale;
@@ -3747,7 +3910,9 @@ _swrast_choose_texture_sample_func( struct gl_context *ctx,
             return sample_lambda_2d;
          }
          else if (sampler->MinFilter == GL_LINEAR) {
-            return sample_linear_2d;
+            texture_sample_func func =
+               choose_linear_2d_rgba8(sampler, t, GL_FALSE);
+            return func ? func : sample_linear_2d;
          }
          else {
             /* check for a few optimized cases */
@@ -0,0 +1,169 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file s_texfilter_tmp.h
+ * Fixed-point bilinear and trilinear sampling template.
+ *
+ * This template is used by s_texfilter.c to generate span sampling
+ * functions for 2-D textures of 32-bit RGBA8 formats without a border,
+ * with the same wrap mode for S and T.  Weights have 8 fractional bits,
+ * and the texels are blended as two 16-bit lanes per 32-bit word, so the
+ * channel order only matters when the result is unpacked.
+ *
+ * Expand it by defining
+ *    \p NAME(x)  to name the generated functions
+ *    \p WRAP     as GL_REPEAT (power of two sizes only) or GL_CLAMP_TO_EDGE
+ *    \p RSHIFT, \p GSHIFT, \p BSHIFT  as the bit offset of each channel
+ *    \p ASHIFT   as the bit offset of alpha, or leave it undefined if the
+ *                format has no alpha
+ */
+
+
+#if WRAP == GL_REPEAT
+#define LINEAR_LOCATIONS(s, size, i0, i1, w)                            \
+   do {                                                                 \
+      const GLfloat u = (s) * (size) - 0.5F;                            \
+      const GLint iu = IFLOOR(u);                                       \
+      i0 = iu & ((size) - 1);                                           \
+      i1 = (iu + 1) & ((size) - 1);                                     \
+      w = (GLint) ((u - (GLfloat) iu) * 256.0F);                        \
+   } while (0)
+#elif WRAP == GL_CLAMP_TO_EDGE
+#define LINEAR_LOCATIONS(s, size, i0, i1, w)                            \
+   do {                                                                 \
+      const GLfloat u = CLAMP((s), 0.0F, 1.0F) * (size) - 0.5F;         \
+      const GLint iu = IFLOOR(u);                                       \
+      i0 = MAX2(iu, 0);                                                 \
+      i1 = MIN2(iu + 1, (size) - 1);                                    \
+      w = (GLint) ((u - (GLfloat) iu) * 256.0F);                        \
+   } while (0)
+#else
+#error "bad WRAP for s_texfilter_tmp.h"
+#endif
+
+
+/**
+ * Bilinear sample of one image at (s,t), as a packed texel.
+ */
+static inline GLuint
+NAME(bilinear)(const struct swrast_texture_image *swImg,
+               GLint width, GLint height, GLfloat s, GLfloat t)
+{
+   const GLubyte *map = (const GLubyte *) swImg->ImageSlices[0];
+   const GLuint *row0, *row1;
+   GLint i0, i1, j0, j1, a, b;
+
+   LINEAR_LOCATIONS(s, width, i0, i1, a);
+   LINEAR_LOCATIONS(t, height, j0, j1, b);
+
+   row0 = (const GLuint *) (map + j0 * swImg->RowStride);
+   row1 = (const GLuint *) (map + j1 * swImg->RowStride);
+
+   return lerp_rgba8_2d(a, b, row0[i0], row0[i1], row1[i0], row1[i1]);
+}
+
+
+static inline void
+NAME(unpack)(GLuint texel, GLfloat rgba[4])
+{
+   rgba[RCOMP] = UBYTE_TO_FLOAT((texel >> RSHIFT) & 0xff);
+   rgba[GCOMP] = UBYTE_TO_FLOAT((texel >> GSHIFT) & 0xff);
+   rgba[BCOMP] = UBYTE_TO_FLOAT((texel >> BSHIFT) & 0xff);
+#ifdef ASHIFT
+   rgba[ACOMP] = UBYTE_TO_FLOAT((texel >> ASHIFT) & 0xff);
+#else
+   rgba[ACOMP] = 1.0F;
+#endif
+}
+
+
+/** Sample the base level with GL_LINEAR filtering */
+static void
+NAME(sample_linear)(struct gl_context *ctx,
+                    const struct gl_sampler_object *samp,
+                    const struct gl_texture_object *tObj,
+                    GLuint n, const GLfloat texcoords[][4],
+                    const GLfloat lambda[], GLfloat rgba[][4])
+{
+   const struct gl_texture_image *img = _mesa_base_tex_image(tObj);
+   const struct swrast_texture_image *swImg = swrast_texture_image_const(img);
+   const GLint width = img->Width2;
+   const GLint height = img->Height2;
+   GLuint i;
+   (void) ctx;
+   (void) samp;
+   (void) lambda;
+
+   for (i = 0; i < n; i++) {
+      const GLuint texel = NAME(bilinear)(swImg, width, height,
+                                          texcoords[i][0], texcoords[i][1]);
+      NAME(unpack)(texel, rgba[i]);
+   }
+}
+
+
+/** Sample with GL_LINEAR_MIPMAP_LINEAR filtering */
+static void
+NAME(sample_linear_mipmap_linear)(struct gl_context *ctx,
+                                  const struct gl_sampler_object *samp,
+                                  const struct gl_texture_object *tObj,
+                                  GLuint n, const GLfloat texcoords[][4],
+                                  const GLfloat lambda[], GLfloat rgba[][4])
+{
+   GLuint i;
+   (void) ctx;
+   (void) samp;
+   assert(lambda != NULL);
+
+   for (i = 0; i < n; i++) {
+      const GLint level = linear_mipmap_level(tObj, lambda[i]);
+      const struct gl_texture_image *img0 =
+         tObj->Image[0][MIN2(level, tObj->_MaxLevel)];
+      GLuint texel = NAME(bilinear)(swrast_texture_image_const(img0),
+                                    img0->Width2, img0->Height2,
+                                    texcoords[i][0], texcoords[i][1]);
+
+      if (level < tObj->_MaxLevel) {
+         const struct gl_texture_image *img1 = tObj->Image[0][level + 1];
+         const GLuint texel1 = NAME(bilinear)(swrast_texture_image_const(img1),
+                                              img1->Width2, img1->Height2,
+                                              texcoords[i][0],
+                                              texcoords[i][1]);
+         texel = lerp_rgba8(IROUND(FRAC(lambda[i]) * 256.0F), texel, texel1);
+      }
+
+      NAME(unpack)(texel, rgba[i]);
+   }
+}
+
+
+#undef LINEAR_LOCATIONS
+#undef NAME
+#undef WRAP
+#undef RSHIFT
+#undef GSHIFT
+#undef BSHIFT
+#undef ASHIFT
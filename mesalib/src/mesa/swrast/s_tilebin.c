@@ -0,0 +1,387 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Binned triangle rasterisation.
+ *
+ * Between _swrast_render_start() and _swrast_render_finish() triangles are
+ * copied into a batch instead of being drawn.  When the batch fills up, or
+ * anything else is about to draw or change state, the rows it covers are
+ * cut into bands, and a pool of threads takes bands in turn, each drawing
+ * every triangle of the batch that touches its band with swrast->Triangle,
+ * restricted to the band's rows (see s_tritemp.h).  Bands share no pixels,
+ * so each pixel still sees the triangles in order.  Each thread rasterises
+ * into its own copy of the SWcontext's scratch buffers, see
+ * _swrast_span_arrays() and friends.
+ *
+ * Only the triangle functions in _swrast_triangle_binnable() are known to
+ * touch nothing but their own rows, so the rest are drawn as before.  The
+ * number of threads is the number of CPUs, or the SWRAST_THREADS
+ * environment variable; with one, nothing is binned.
+ */
+
+
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "util/debug.h"
+#include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
+
+#include "s_context.h"
+#include "s_tilebin.h"
+#include "s_triangle.h"
+
+
+/** Triangles per batch */
+#define BIN_MAX_TRIANGLES 512
+
+/** Fewest rows in a band; fewer rows than two bands are not binned */
+#define BIN_MIN_ROWS 32
+
+/** Most threads, each of which gets its own SWspanarrays */
+#if defined(_WIN64) || defined(__LP64__)
+#define BIN_MAX_THREADS 32
+#else
+#define BIN_MAX_THREADS 4
+#endif
+
+
+static tss_t bin_thread_key;
+static once_flag bin_thread_once = ONCE_FLAG_INIT;
+
+static void
+create_bin_thread_key(void)
+{
+   tss_create(&bin_thread_key, NULL);
+}
+
+
+/**
+ * The thread rasterising binned triangles that is calling, or NULL when
+ * not called from a bin.
+ */
+struct swrast_thread *
+_swrast_bin_thread(void)
+{
+   return (struct swrast_thread *) tss_get(bin_thread_key);
+}
+
+
+void
+_swrast_create_binner(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_binner *bin;
+   GLuint numThreads, i;
+
+   call_once(&bin_thread_once, create_bin_thread_key);
+
+   numThreads = env_var_as_unsigned("SWRAST_THREADS",
+                                    MIN2(util_cpu_caps.nr_cpus,
+                                         BIN_MAX_THREADS));
+   numThreads = MIN2(numThreads, BIN_MAX_THREADS);
+   if (numThreads < 2)
+      return;
+
+   bin = calloc(1, sizeof(struct swrast_binner));
+   if (!bin)
+      return;
+
+   bin->Triangles = malloc(BIN_MAX_TRIANGLES *
+                           sizeof(struct swrast_bin_triangle));
+   bin->Threads = calloc(numThreads, sizeof(struct swrast_thread));
+   bin->Fences = calloc(numThreads - 1, sizeof(struct util_queue_fence));
+   if (!bin->Triangles || !bin->Threads || !bin->Fences ||
+       mtx_init(&bin->Mutex, mtx_plain) != thrd_success) {
+      free(bin->Triangles);
+      free(bin->Threads);
+      free(bin->Fences);
+      free(bin);
+      return;
+   }
+
+   bin->NumThreads = numThreads;
+   for (i = 0; i < numThreads; i++)
+      bin->Threads[i].ctx = ctx;
+
+   /* the calling thread keeps the SWcontext's buffers */
+   bin->Threads[0].SpanArrays = swrast->SpanArrays;
+   bin->Threads[0].stencil_temp = swrast->stencil_temp;
+
+   swrast->Bin = bin;
+}
+
+
+static void
+free_thread_scratch(struct swrast_thread *thread)
+{
+   free(thread->SpanArrays);
+   free(thread->stencil_temp.buf1);
+   free(thread->stencil_temp.buf2);
+   free(thread->stencil_temp.buf3);
+   free(thread->stencil_temp.buf4);
+   memset(&thread->stencil_temp, 0, sizeof(thread->stencil_temp));
+   thread->SpanArrays = NULL;
+}
+
+
+void
+_swrast_destroy_binner(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_binner *bin = swrast->Bin;
+   GLuint i;
+
+   if (!bin)
+      return;
+
+   if (util_queue_is_initialized(&bin->Queue)) {
+      util_queue_destroy(&bin->Queue);
+      for (i = 1; i < bin->NumThreads; i++)
+         util_queue_fence_destroy(&bin->Fences[i - 1]);
+   }
+
+   for (i = 0; i < bin->NumThreads; i++) {
+      if (i > 0)
+         free_thread_scratch(&bin->Threads[i]);
+      free(bin->Threads[i].TexelBuffer);
+   }
+
+   mtx_destroy(&bin->Mutex);
+   free(bin->Triangles);
+   free(bin->Threads);
+   free(bin->Fences);
+   free(bin);
+   swrast->Bin = NULL;
+}
+
+
+/**
+ * Start the other threads and give them their scratch buffers, the first
+ * time there is something for them to do.  If that fails, binning is
+ * turned off.
+ */
+static GLboolean
+init_threads(struct swrast_binner *bin)
+{
+   GLuint i;
+
+   if (util_queue_is_initialized(&bin->Queue))
+      return GL_TRUE;
+
+   for (i = 1; i < bin->NumThreads; i++) {
+      struct swrast_thread *thread = &bin->Threads[i];
+      SWspanarrays *arrays = malloc(sizeof(SWspanarrays));
+
+      thread->SpanArrays = arrays;
+      thread->stencil_temp.buf1 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+      thread->stencil_temp.buf2 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+      thread->stencil_temp.buf3 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+      thread->stencil_temp.buf4 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+      if (!arrays ||
+          !thread->stencil_temp.buf1 ||
+          !thread->stencil_temp.buf2 ||
+          !thread->stencil_temp.buf3 ||
+          !thread->stencil_temp.buf4)
+         goto fail;
+
+      arrays->ChanType = CHAN_TYPE;
+#if CHAN_TYPE == GL_UNSIGNED_BYTE
+      arrays->rgba = arrays->rgba8;
+#elif CHAN_TYPE == GL_UNSIGNED_SHORT
+      arrays->rgba = arrays->rgba16;
+#else
+      arrays->rgba = arrays->attribs[VARYING_SLOT_COL0];
+#endif
+   }
+
+   if (!util_queue_init(&bin->Queue, "swrast", bin->NumThreads - 1,
+                        bin->NumThreads - 1,
+                        UTIL_QUEUE_INIT_SHARED_POOL |
+                        UTIL_QUEUE_INIT_HIGH_PRIORITY))
+      goto fail;
+
+   for (i = 1; i < bin->NumThreads; i++)
+      util_queue_fence_init(&bin->Fences[i - 1]);
+
+   return GL_TRUE;
+
+fail:
+   for (i = 1; i < bin->NumThreads; i++)
+      free_thread_scratch(&bin->Threads[i]);
+   bin->NumThreads = 1;
+   return GL_FALSE;
+}
+
+
+/**
+ * Whether triangles drawn now may be binned.  Occlusion queries count
+ * samples into a shared result, so they are not.
+ */
+GLboolean
+_swrast_bin_active(struct gl_context *ctx)
+{
+   const struct swrast_binner *bin = SWRAST_CONTEXT(ctx)->Bin;
+
+   return bin && bin->Rendering && bin->NumThreads > 1 &&
+          !ctx->Query.CurrentOcclusionObject &&
+          ctx->DrawBuffer->Height >= 2 * BIN_MIN_ROWS;
+}
+
+
+/** The row containing window y, clamped to [0, height] */
+static inline GLint
+bin_row(GLfloat y, GLint height)
+{
+   if (!(y > 0.0F))
+      return 0;
+   if (y >= (GLfloat) height)
+      return height;
+   return (GLint) y;
+}
+
+
+/**
+ * Add a triangle to the batch, drawing the batch if it is full.
+ */
+void
+_swrast_bin_triangle(struct gl_context *ctx, const SWvertex *v0,
+                     const SWvertex *v1, const SWvertex *v2)
+{
+   struct swrast_binner *bin = SWRAST_CONTEXT(ctx)->Bin;
+   struct swrast_bin_triangle *tri = &bin->Triangles[bin->NumTriangles];
+   const GLint height = ctx->DrawBuffer->Height;
+   const GLfloat y0 = v0->attrib[VARYING_SLOT_POS][1];
+   const GLfloat y1 = v1->attrib[VARYING_SLOT_POS][1];
+   const GLfloat y2 = v2->attrib[VARYING_SLOT_POS][1];
+
+   tri->v[0] = *v0;
+   tri->v[1] = *v1;
+   tri->v[2] = *v2;
+   /* a row or so of slack either side for rounding in s_tritemp.h */
+   tri->ymin = bin_row(MIN3(y0, y1, y2) - 1.0F, height);
+   tri->ymax = bin_row(MAX3(y0, y1, y2) + 2.0F, height);
+
+   if (bin->NumTriangles == 0) {
+      bin->Ymin = tri->ymin;
+      bin->Ymax = tri->ymax;
+   }
+   else {
+      bin->Ymin = MIN2(bin->Ymin, tri->ymin);
+      bin->Ymax = MAX2(bin->Ymax, tri->ymax);
+   }
+
+   if (++bin->NumTriangles == BIN_MAX_TRIANGLES)
+      _swrast_flush_bins(ctx);
+}
+
+
+/**
+ * Draw bands of the batch until there are none left.  Run by each thread,
+ * with its swrast_thread as job.
+ */
+static void
+draw_bins(void *job, int thread_index)
+{
+   struct swrast_thread *thread = (struct swrast_thread *) job;
+   struct gl_context *ctx = thread->ctx;
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_binner *bin = swrast->Bin;
+   GLint band;
+   GLuint i;
+
+   (void) thread_index;
+
+   tss_set(bin_thread_key, thread);
+
+   while ((band = p_atomic_inc_return(&bin->NextBin) - 1) < bin->NumBins) {
+      thread->BinYmin = bin->Ymin + band * bin->BinRows;
+      thread->BinYmax = MIN2(thread->BinYmin + bin->BinRows, bin->Ymax);
+
+      /* the first triangle was drawn by _swrast_flush_bins() */
+      for (i = 1; i < bin->NumTriangles; i++) {
+         const struct swrast_bin_triangle *tri = &bin->Triangles[i];
+         if (tri->ymin < thread->BinYmax && tri->ymax > thread->BinYmin)
+            swrast->Triangle(ctx, &tri->v[0], &tri->v[1], &tri->v[2]);
+      }
+   }
+
+   tss_set(bin_thread_key, NULL);
+}
+
+
+/**
+ * Draw the triangles binned so far.
+ */
+void
+_swrast_flush_bins(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_binner *bin = swrast->Bin;
+   const struct swrast_bin_triangle *tri;
+   GLuint i;
+
+   if (!bin || !bin->NumTriangles)
+      return;
+
+   /* The first triangle is drawn alone, so that any validation
+    * swrast->Triangle and the functions it calls do first happens here.
+    */
+   tri = &bin->Triangles[0];
+   swrast->Triangle(ctx, &tri->v[0], &tri->v[1], &tri->v[2]);
+
+   if (bin->NumTriangles > 1 && _swrast_triangle_binnable(ctx) &&
+       init_threads(bin)) {
+      const GLint rows = bin->Ymax - bin->Ymin;
+      GLuint numThreads;
+
+      /* two bands per thread, to even out the work */
+      bin->BinRows = MAX2(BIN_MIN_ROWS,
+                          DIV_ROUND_UP(rows, (GLint) bin->NumThreads * 2));
+      bin->NumBins = DIV_ROUND_UP(rows, bin->BinRows);
+      bin->NextBin = 0;
+      numThreads = MIN2(bin->NumThreads, (GLuint) bin->NumBins);
+
+      for (i = 1; i < numThreads; i++)
+         util_queue_add_job(&bin->Queue, &bin->Threads[i],
+                            &bin->Fences[i - 1], draw_bins, NULL);
+      draw_bins(&bin->Threads[0], 0);
+      /* The bands are all drawn by now; jobs which the shared pool had no
+       * worker for yet would only find nothing left to do.
+       */
+      for (i = 1; i < numThreads; i++)
+         util_queue_drop_job(&bin->Queue, &bin->Fences[i - 1]);
+   }
+   else {
+      for (i = 1; i < bin->NumTriangles; i++) {
+         tri = &bin->Triangles[i];
+         swrast->Triangle(ctx, &tri->v[0], &tri->v[1], &tri->v[2]);
+      }
+   }
+
+   bin->NumTriangles = 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef S_TILEBIN_H
+#define S_TILEBIN_H
+
+#include "c11/threads.h"
+#include "util/u_queue.h"
+#include "swrast.h"
+#include "s_context.h"
+
+
+/** A deferred triangle and the rows it may touch, [ymin, ymax) */
+struct swrast_bin_triangle
+{
+   SWvertex v[3];
+   GLint ymin, ymax;
+};
+
+
+/**
+ * Triangles deferred between _swrast_render_start() and
+ * _swrast_render_finish(), and the threads that rasterise them.
+ */
+struct swrast_binner
+{
+   GLboolean Rendering;          /**< between render start and finish */
+
+   struct swrast_bin_triangle *Triangles;
+   GLuint NumTriangles;
+   GLint Ymin, Ymax;             /**< rows touched by any of the Triangles */
+
+   /** The batch is rasterised as NumBins bands of BinRows rows from Ymin,
+    * which the threads take in turn by incrementing NextBin.
+    */
+   GLint BinRows, NumBins;
+   int NextBin;
+
+   /** Threads[0] is the thread calling into swrast, the others run as
+    * jobs on Queue, each signalling its fence once out of bands.
+    */
+   GLuint NumThreads;
+   struct swrast_thread *Threads;
+   struct util_queue_fence *Fences;
+   struct util_queue Queue;
+
+   /** Held while validating functions the threads share */
+   mtx_t Mutex;
+};
+
+
+extern void
+_swrast_create_binner(struct gl_context *ctx);
+
+extern void
+_swrast_destroy_binner(struct gl_context *ctx);
+
+extern GLboolean
+_swrast_bin_active(struct gl_context *ctx);
+
+extern void
+_swrast_bin_triangle(struct gl_context *ctx, const SWvertex *v0,
+                     const SWvertex *v1, const SWvertex *v2);
+
+extern void
+_swrast_flush_bins(struct gl_context *ctx);
+
+
+#endif
@@ -144,7 +144,7 @@ _swrast_culltriangle( struct gl_context *ctx,
 
 #define RENDER_SPAN( span )						\
    GLuint i;								\
-   GLubyte (*rgba)[4] = swrast->SpanArrays->rgba8;			\
+   GLubyte (*rgba)[4] = span.array->rgba8;				\
    span.intTex[0] -= FIXED_HALF; /* off-by-one error? */		\
    span.intTex[1] -= FIXED_HALF;					\
    for (i = 0; i < span.end; i++) {					\
@@ -202,8 +202,8 @@ _swrast_culltriangle( struct gl_context *ctx,
 
 #define RENDER_SPAN( span )						\
    GLuint i;				    				\
-   GLubyte (*rgba)[4] = swrast->SpanArrays->rgba8;			\
-   GLubyte *mask = swrast->SpanArrays->mask;                            \
+   GLubyte (*rgba)[4] = span.array->rgba8;				\
+   GLubyte *mask = span.array->mask;                                    \
    span.intTex[0] -= FIXED_HALF; /* off-by-one error? */		\
    span.intTex[1] -= FIXED_HALF;					\
    for (i = 0; i < span.end; i++) {					\
@@ -970,6 +970,26 @@ _swrast_add_spec_terms_triangle(struct gl_context *ctx, const SWvertex *v0,
 
 
 
+/**
+ * Whether swrast->Triangle may be called from several threads at once for
+ * different rows, see s_tilebin.c.  These only write to the rows they are
+ * drawing and to the calling thread's scratch buffers.
+ */
+GLboolean
+_swrast_triangle_binnable(struct gl_context *ctx)
+{
+   const swrast_tri_func tri = SWRAST_CONTEXT(ctx)->Triangle;
+
+   return tri == general_triangle ||
+          tri == flat_rgba_triangle ||
+          tri == smooth_rgba_triangle ||
+          tri == simple_textured_triangle ||
+          tri == simple_z_textured_triangle ||
+          tri == nodraw_triangle;
+}
+
+
+
 #ifdef DEBUG
 
 /* record the current triangle function name */
@@ -1114,6 +1134,12 @@ _swrast_choose_triangle( struct gl_context *ctx )
                       */
                      USE(general_triangle);
                   }
+                  else if (swrast->Bin) {
+                     /* affine_textured_triangle toggles global texture
+                      * state, so it can't be binned (s_tilebin.c).
+                      */
+                     USE(general_triangle);
+                  }
                   else {
                      USE(affine_textured_triangle);
                  }
@@ -1124,7 +1150,13 @@ _swrast_choose_triangle( struct gl_context *ctx )
 #if CHAN_BITS != 8
                USE(general_triangle);
 #else
-               USE(persp_textured_triangle);
+               /* as for affine_textured_triangle above */
+               if (swrast->Bin) {
+                  USE(general_triangle);
+               }
+               else {
+                  USE(persp_textured_triangle);
+               }
 #endif
 	    }
 	 }
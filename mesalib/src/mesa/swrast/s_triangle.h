@@ -40,6 +40,9 @@ _swrast_culltriangle( struct gl_context *ctx,
 extern void
 _swrast_choose_triangle( struct gl_context *ctx );
 
+extern GLboolean
+_swrast_triangle_binnable( struct gl_context *ctx );
+
 extern void
 _swrast_add_spec_terms_triangle( struct gl_context *ctx,
 				 const SWvertex *v0,
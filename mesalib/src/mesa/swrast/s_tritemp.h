@@ -143,6 +143,11 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
    GLfloat bf = SWRAST_CONTEXT(ctx)->_BackfaceSign;
    const GLint snapMask = ~((FIXED_ONE / (1 << SUB_PIXEL_BITS)) - 1); /* for x/y coord snapping */
    GLfixed vMin_fx, vMin_fy, vMid_fx, vMid_fy, vMax_fx, vMax_fy;
+   /* rows to write: all of them, unless rasterising one bin of binned
+    * triangles (s_tilebin.c) */
+   const struct swrast_thread *binThread = _swrast_bin_thread();
+   const GLint binYmin = binThread ? binThread->BinYmin : 0;
+   const GLint binYmax = binThread ? binThread->BinYmax : INT_MAX;
 
    SWspan span;
 
@@ -808,8 +813,9 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
                /* This is where we actually generate fragments */
                /* XXX the test for span.y > 0 _shouldn't_ be needed but
                 * it fixes a problem on 64-bit Opterons (bug 4842).
+                * binYmin is never below 0.
                 */
-               if (span.end > 0 && span.y >= 0) {
+               if (span.end > 0 && span.y >= binYmin && span.y < binYmax) {
                   const GLint len = span.end - 1;
                   (void) len;
 #ifdef INTERP_RGB
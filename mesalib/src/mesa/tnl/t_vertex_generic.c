@@ -872,34 +872,59 @@ static void NAME( struct gl_context *ctx,					\
 {									\
    struct tnl_clipspace *vtx = GET_VERTEX_STATE(ctx);			\
    struct tnl_clipspace_attr *a = vtx->attr;				\
+   const GLuint stride = vtx->vertex_size;				\
+   GLubyte *in0 = NR > 0 ? a[0].inputptr : NULL;			\
+   GLubyte *in1 = NR > 1 ? a[1].inputptr : NULL;			\
+   GLubyte *in2 = NR > 2 ? a[2].inputptr : NULL;			\
+   GLubyte *in3 = NR > 3 ? a[3].inputptr : NULL;			\
+   GLubyte *in4 = NR > 4 ? a[4].inputptr : NULL;			\
+   const GLuint off0 = NR > 0 ? a[0].vertoffset : 0;			\
+   const GLuint off1 = NR > 1 ? a[1].vertoffset : 0;			\
+   const GLuint off2 = NR > 2 ? a[2].vertoffset : 0;			\
+   const GLuint off3 = NR > 3 ? a[3].vertoffset : 0;			\
+   const GLuint off4 = NR > 4 ? a[4].vertoffset : 0;			\
+   const GLuint str0 = NR > 0 ? a[0].inputstride : 0;			\
+   const GLuint str1 = NR > 1 ? a[1].inputstride : 0;			\
+   const GLuint str2 = NR > 2 ? a[2].inputstride : 0;			\
+   const GLuint str3 = NR > 3 ? a[3].inputstride : 0;			\
+   const GLuint str4 = NR > 4 ? a[4].inputstride : 0;			\
    GLuint i;								\
 									\
-   for (i = 0 ; i < count ; i++, v += vtx->vertex_size) {		\
+   /* The offsets, strides and input pointers are kept in locals, as	\
+    * the compiler can't tell that the vertex stores don't alias a[].	\
+    */									\
+   for (i = 0 ; i < count ; i++, v += stride) {				\
       if (NR > 0) {							\
-	 F0( &a[0], v + a[0].vertoffset, (GLfloat *)a[0].inputptr );	\
-	 a[0].inputptr += a[0].inputstride;				\
+	 F0( &a[0], v + off0, (GLfloat *)in0 );				\
+	 in0 += str0;							\
       }									\
       									\
       if (NR > 1) {							\
-	 F1( &a[1], v + a[1].vertoffset, (GLfloat *)a[1].inputptr );	\
-	 a[1].inputptr += a[1].inputstride;				\
+	 F1( &a[1], v + off1, (GLfloat *)in1 );				\
+	 in1 += str1;							\
       }									\
       									\
       if (NR > 2) {							\
-	 F2( &a[2], v + a[2].vertoffset, (GLfloat *)a[2].inputptr );	\
-	 a[2].inputptr += a[2].inputstride;				\
+	 F2( &a[2], v + off2, (GLfloat *)in2 );				\
+	 in2 += str2;							\
       }									\
       									\
       if (NR > 3) {							\
-	 F3( &a[3], v + a[3].vertoffset, (GLfloat *)a[3].inputptr );	\
-	 a[3].inputptr += a[3].inputstride;				\
+	 F3( &a[3], v + off3, (GLfloat *)in3 );				\
+	 in3 += str3;							\
       }									\
 									\
       if (NR > 4) {							\
-	 F4( &a[4], v + a[4].vertoffset, (GLfloat *)a[4].inputptr );	\
-	 a[4].inputptr += a[4].inputstride;				\
+	 F4( &a[4], v + off4, (GLfloat *)in4 );				\
+	 in4 += str4;							\
       }									\
    }									\
+									\
+   if (NR > 0) a[0].inputptr = in0;					\
+   if (NR > 1) a[1].inputptr = in1;					\
+   if (NR > 2) a[2].inputptr = in2;					\
+   if (NR > 3) a[3].inputptr = in3;					\
+   if (NR > 4) a[4].inputptr = in4;					\
 }
 
    
@@ -925,6 +950,70 @@ EMIT4(insert_4f_viewport_4, insert_4ub_4f_rgba_4, insert_2f_2, insert_2f_2, emit
 EMIT4(insert_4f_viewport_4, insert_4ub_4f_bgra_4, insert_2f_2, insert_2f_2,  emit_viewport4_bgra4_st2_st2)
 EMIT4(insert_4f_4, insert_4ub_4f_rgba_4, insert_2f_2, insert_2f_2, emit_xyzw4_rgba4_st2_st2)
 
+/* The SWvertex layouts built by swrast_setup: window position, integer
+ * (chan) or float color, then fog or full 4f texcoords from 2 or 4
+ * component inputs.
+ */
+EMIT2(insert_4f_viewport_4, insert_4chan_4f_rgba_4, emit_viewport4_chan4)
+EMIT2(insert_4f_viewport_4, insert_4chan_4f_rgba_3, emit_viewport4_chan3)
+EMIT2(insert_4f_viewport_4, insert_4f_4, emit_viewport4_f4)
+
+EMIT3(insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_2, emit_viewport4_chan4_tex2)
+EMIT3(insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_4, emit_viewport4_chan4_tex4)
+EMIT3(insert_4f_viewport_4, insert_4chan_4f_rgba_3, insert_4f_2, emit_viewport4_chan3_tex2)
+EMIT3(insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_1f_1, emit_viewport4_chan4_fog)
+EMIT3(insert_4f_viewport_4, insert_4f_4, insert_4f_2, emit_viewport4_f4_tex2)
+EMIT3(insert_4f_viewport_4, insert_4f_4, insert_4f_4, emit_viewport4_f4_tex4)
+
+EMIT4(insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_2, insert_4f_2, emit_viewport4_chan4_tex2_tex2)
+EMIT4(insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_4, insert_4f_4, emit_viewport4_chan4_tex4_tex4)
+
+
+/* Every hardwired fastpath and the insert functions it was built from.
+ */
+static const struct {
+   GLuint attr_count;
+   tnl_insert_func insert[4];
+   tnl_emit_func func;
+} hardwired_emit[] = {
+   { 2, { insert_3f_viewport_3, insert_4ub_4f_bgra_4 }, emit_viewport3_bgra4 },
+   { 2, { insert_3f_viewport_3, insert_4ub_4f_rgba_4 }, emit_viewport3_rgba4 },
+   { 2, { insert_3f_3, insert_4ub_4f_rgba_4 }, emit_xyz3_rgba4 },
+   { 2, { insert_4f_viewport_4, insert_4chan_4f_rgba_4 }, emit_viewport4_chan4 },
+   { 2, { insert_4f_viewport_4, insert_4chan_4f_rgba_3 }, emit_viewport4_chan3 },
+   { 2, { insert_4f_viewport_4, insert_4f_4 }, emit_viewport4_f4 },
+
+   { 3, { insert_4f_viewport_4, insert_4ub_4f_rgba_4, insert_2f_2 },
+     emit_viewport4_rgba4_st2 },
+   { 3, { insert_4f_4, insert_4ub_4f_rgba_4, insert_2f_2 },
+     emit_xyzw4_rgba4_st2 },
+   { 3, { insert_4f_viewport_4, insert_4ub_4f_bgra_4, insert_2f_2 },
+     emit_viewport4_bgra4_st2 },
+   { 3, { insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_2 },
+     emit_viewport4_chan4_tex2 },
+   { 3, { insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_4 },
+     emit_viewport4_chan4_tex4 },
+   { 3, { insert_4f_viewport_4, insert_4chan_4f_rgba_3, insert_4f_2 },
+     emit_viewport4_chan3_tex2 },
+   { 3, { insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_1f_1 },
+     emit_viewport4_chan4_fog },
+   { 3, { insert_4f_viewport_4, insert_4f_4, insert_4f_2 },
+     emit_viewport4_f4_tex2 },
+   { 3, { insert_4f_viewport_4, insert_4f_4, insert_4f_4 },
+     emit_viewport4_f4_tex4 },
+
+   { 4, { insert_4f_viewport_4, insert_4ub_4f_rgba_4, insert_2f_2,
+          insert_2f_2 }, emit_viewport4_rgba4_st2_st2 },
+   { 4, { insert_4f_4, insert_4ub_4f_rgba_4, insert_2f_2, insert_2f_2 },
+     emit_xyzw4_rgba4_st2_st2 },
+   { 4, { insert_4f_viewport_4, insert_4ub_4f_bgra_4, insert_2f_2,
+          insert_2f_2 }, emit_viewport4_bgra4_st2_st2 },
+   { 4, { insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_2,
+          insert_4f_2 }, emit_viewport4_chan4_tex2_tex2 },
+   { 4, { insert_4f_viewport_4, insert_4chan_4f_rgba_4, insert_4f_4,
+          insert_4f_4 }, emit_viewport4_chan4_tex4_tex4 },
+};
+
 
 /* Use the codegen paths to select one of a number of hardwired
  * fastpaths.
@@ -932,54 +1021,23 @@ EMIT4(insert_4f_4, insert_4ub_4f_rgba_4, insert_2f_2, insert_2f_2, emit_xyzw4_rg
 void _tnl_generate_hardwired_emit( struct gl_context *ctx )
 {
    struct tnl_clipspace *vtx = GET_VERTEX_STATE(ctx);
-   tnl_emit_func func = NULL;
+   GLuint i, j;
 
-   /* Does it fit a hardwired fastpath?  Help! this is growing out of
-    * control!
-    */
-   switch (vtx->attr_count) {
-   case 2:
-      if (vtx->attr[0].emit == insert_3f_viewport_3) {
-	 if (vtx->attr[1].emit == insert_4ub_4f_bgra_4) 
-	    func = emit_viewport3_bgra4;
-	 else if (vtx->attr[1].emit == insert_4ub_4f_rgba_4) 
-	    func = emit_viewport3_rgba4;
-      }
-      else if (vtx->attr[0].emit == insert_3f_3 &&
-	       vtx->attr[1].emit == insert_4ub_4f_rgba_4) {
- 	 func = emit_xyz3_rgba4; 
-      }
-      break;
-   case 3:
-      if (vtx->attr[2].emit == insert_2f_2) {
-	 if (vtx->attr[1].emit == insert_4ub_4f_rgba_4) {
-	    if (vtx->attr[0].emit == insert_4f_viewport_4)
-	       func = emit_viewport4_rgba4_st2;
-	    else if (vtx->attr[0].emit == insert_4f_4) 
-	       func = emit_xyzw4_rgba4_st2;
-	 }
-	 else if (vtx->attr[1].emit == insert_4ub_4f_bgra_4 &&
-		  vtx->attr[0].emit == insert_4f_viewport_4)
-	    func = emit_viewport4_bgra4_st2;
-      }
-      break;
-   case 4:
-      if (vtx->attr[2].emit == insert_2f_2 &&
-	  vtx->attr[3].emit == insert_2f_2) {
-	 if (vtx->attr[1].emit == insert_4ub_4f_rgba_4) {
-	    if (vtx->attr[0].emit == insert_4f_viewport_4)
-	       func = emit_viewport4_rgba4_st2_st2;
-	    else if (vtx->attr[0].emit == insert_4f_4) 
-	       func = emit_xyzw4_rgba4_st2_st2;
-	 }
-	 else if (vtx->attr[1].emit == insert_4ub_4f_bgra_4 &&
-		  vtx->attr[0].emit == insert_4f_viewport_4)
-	    func = emit_viewport4_bgra4_st2_st2;
+   vtx->emit = NULL;
+
+   for (i = 0; i < ARRAY_SIZE(hardwired_emit); i++) {
+      if (hardwired_emit[i].attr_count != vtx->attr_count)
+	 continue;
+
+      for (j = 0; j < vtx->attr_count; j++)
+	 if (vtx->attr[j].emit != hardwired_emit[i].insert[j])
+	    break;
+
+      if (j == vtx->attr_count) {
+	 vtx->emit = hardwired_emit[i].func;
+	 return;
       }
-      break;
    }
-
-   vtx->emit = func;
 }
 
 /***********************************************************************
@@ -32,6 +32,7 @@
 #include "main/api_arrayelt.h"
 #include "main/arrayobj.h"
 #include "main/varray.h"
+#include "util/u_cpu_detect.h"
 #include "vbo.h"
 #include "vbo_private.h"
 
@@ -168,6 +169,9 @@ _vbo_CreateContext(struct gl_context *ctx)
 
    ctx->vbo_context = vbo;
 
+   /* for the SIMD index scans of vbo_minmax_index.c */
+   util_cpu_detect();
+
    /* Initialize the arrayelt helper
     */
    if (!ctx->aelt_context &&
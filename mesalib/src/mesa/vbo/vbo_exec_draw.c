@@ -179,7 +179,10 @@ vbo_exec_bind_arrays(struct gl_context *ctx)
    GLintptr buffer_offset;
    if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
       assert(exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Pointer);
-      buffer_offset = exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
+      /* The vertices start where the last flush left off, which with a
+       * persistent mapping isn't the start of the mapping.
+       */
+      buffer_offset = exec->vtx.buffer_used;
    } else {
       /* Ptr into ordinary app memory */
       buffer_offset = (GLbyte *)exec->vtx.buffer_map - (GLbyte *)NULL;
@@ -231,6 +234,19 @@ vbo_exec_bind_arrays(struct gl_context *ctx)
 }
 
 
+/**
+ * Whether the VBO is mapped persistently, and so stays mapped while it is
+ * drawn from.  The vertices are then written straight to where they are
+ * drawn from, and a flush only moves the start of the next batch along.
+ */
+static inline bool
+vbo_exec_persistent_mapping(const struct vbo_exec_context *exec)
+{
+   return exec->ctx->Extensions.ARB_buffer_storage &&
+          _mesa_is_bufferobj(exec->vtx.bufferobj);
+}
+
+
 /**
  * Unmap the VBO.  This is called before drawing.
  */
@@ -240,7 +256,8 @@ vbo_exec_vtx_unmap(struct vbo_exec_context *exec)
    if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
       struct gl_context *ctx = exec->ctx;
 
-      if (ctx->Driver.FlushMappedBufferRange) {
+      if (ctx->Driver.FlushMappedBufferRange &&
+          !vbo_exec_persistent_mapping(exec)) {
          GLintptr offset = exec->vtx.buffer_used -
                            exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
          GLsizeiptr length = (exec->vtx.buffer_ptr - exec->vtx.buffer_map) *
@@ -273,16 +290,30 @@ void
 vbo_exec_vtx_map(struct vbo_exec_context *exec)
 {
    struct gl_context *ctx = exec->ctx;
-   const GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
-                              GL_MAP_INVALIDATE_RANGE_BIT |
-                              GL_MAP_UNSYNCHRONIZED_BIT |
-                              GL_MAP_FLUSH_EXPLICIT_BIT |
-                              MESA_MAP_NOWAIT_BIT;
+   const bool persistent = vbo_exec_persistent_mapping(exec);
+   GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
+                        GL_MAP_UNSYNCHRONIZED_BIT;
    const GLenum usage = GL_STREAM_DRAW_ARB;
 
    if (!_mesa_is_bufferobj(exec->vtx.bufferobj))
       return;
 
+   if (persistent) {
+      /* vbo_copy_vertices() reads the mapping back, and only a persistent
+       * mapping can have GL_MAP_READ_BIT along with unsynchronized writes.
+       */
+      accessRange |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT |
+                     GL_MAP_READ_BIT;
+
+      /* Still mapped from the last batch */
+      if (exec->vtx.buffer_map)
+         return;
+   } else {
+      accessRange |= GL_MAP_INVALIDATE_RANGE_BIT |
+                     GL_MAP_FLUSH_EXPLICIT_BIT |
+                     MESA_MAP_NOWAIT_BIT;
+   }
+
    assert(!exec->vtx.buffer_map);
    assert(!exec->vtx.buffer_ptr);
 
@@ -312,6 +343,10 @@ vbo_exec_vtx_map(struct vbo_exec_context *exec)
                                  VBO_VERT_BUFFER_SIZE,
                                  NULL, usage,
                                  GL_MAP_WRITE_BIT |
+                                 (persistent ?
+                                  GL_MAP_PERSISTENT_BIT |
+                                  GL_MAP_COHERENT_BIT |
+                                  GL_MAP_READ_BIT : 0) |
                                  GL_DYNAMIC_STORAGE_BIT |
                                  GL_CLIENT_STORAGE_BIT,
                                  exec->vtx.bufferobj)) {
@@ -361,6 +396,8 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
    if (0)
       vbo_exec_debug_verts(exec);
 
+   const bool persistent = vbo_exec_persistent_mapping(exec);
+
    if (exec->vtx.prim_count &&
        exec->vtx.vert_count) {
 
@@ -377,7 +414,8 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
          if (ctx->NewState)
             _mesa_update_state(ctx);
 
-         vbo_exec_vtx_unmap(exec);
+         if (!persistent)
+            vbo_exec_vtx_unmap(exec);
 
          assert(ctx->NewState == 0);
 
@@ -390,18 +428,33 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
                           NULL, 0, NULL);
 
          /* Get new storage -- unless asked not to. */
-         if (!keepUnmapped)
+         if (!persistent && !keepUnmapped)
             vbo_exec_vtx_map(exec);
       }
    }
 
+   if (persistent && exec->vtx.buffer_map) {
+      /* Start the next batch after this one, in the same mapping, and only
+       * move on to new storage once the buffer is full.  The buffer stays
+       * mapped even if asked to unmap, which a persistent mapping allows.
+       */
+      exec->vtx.buffer_used += (exec->vtx.buffer_ptr -
+                                exec->vtx.buffer_map) * sizeof(float);
+      exec->vtx.buffer_map = exec->vtx.buffer_ptr;
+
+      if (VBO_VERT_BUFFER_SIZE <= exec->vtx.buffer_used + 1024) {
+         vbo_exec_vtx_unmap(exec);
+         vbo_exec_vtx_map(exec);
+      }
+   }
+
    /* May have to unmap explicitly if we didn't draw:
     */
-   if (keepUnmapped && exec->vtx.buffer_map) {
+   if (!persistent && keepUnmapped && exec->vtx.buffer_map) {
       vbo_exec_vtx_unmap(exec);
    }
 
-   if (keepUnmapped || exec->vtx.vertex_size == 0)
+   if ((keepUnmapped && !persistent) || exec->vtx.vertex_size == 0)
       exec->vtx.max_vert = 0;
    else
       exec->vtx.max_vert = vbo_compute_max_verts(exec);
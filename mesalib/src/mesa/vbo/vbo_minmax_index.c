@@ -30,9 +30,103 @@
 #include "main/context.h"
 #include "main/varray.h"
 #include "main/macros.h"
-#include "main/sse_minmax.h"
-#include "x86/common_x86_asm.h"
 #include "util/hash_table.h"
+#include "util/u_cpu_detect.h"
+
+
+/* SSE2 is always there on x86-64, and is assumed wherever the compiler
+ * is allowed to use it on x86.  SSE4.1 and AVX2 are checked for in
+ * util_cpu_caps, which _vbo_CreateContext() fills in.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VBO_MINMAX_SIMD 1
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define SSE41_FUNC
+#define AVX2_FUNC
+#else
+#define SSE41_FUNC __attribute__((target("sse4.1")))
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+
+#define MINMAX_FUNC minmax_sse41_ubyte
+#define MINMAX_ATTR SSE41_FUNC
+#define MINMAX_TYPE GLubyte
+#define MINMAX_BITS 8
+#define MINMAX_VEC __m128i
+#define MINMAX_PREFIX _mm
+#define MINMAX_SI si128
+#include "vbo_minmax_tmp.h"
+
+#define MINMAX_FUNC minmax_sse41_ushort
+#define MINMAX_ATTR SSE41_FUNC
+#define MINMAX_TYPE GLushort
+#define MINMAX_BITS 16
+#define MINMAX_VEC __m128i
+#define MINMAX_PREFIX _mm
+#define MINMAX_SI si128
+#include "vbo_minmax_tmp.h"
+
+#define MINMAX_FUNC minmax_sse41_uint
+#define MINMAX_ATTR SSE41_FUNC
+#define MINMAX_TYPE GLuint
+#define MINMAX_BITS 32
+#define MINMAX_VEC __m128i
+#define MINMAX_PREFIX _mm
+#define MINMAX_SI si128
+#include "vbo_minmax_tmp.h"
+
+#define MINMAX_FUNC minmax_avx2_ubyte
+#define MINMAX_ATTR AVX2_FUNC
+#define MINMAX_TYPE GLubyte
+#define MINMAX_BITS 8
+#define MINMAX_VEC __m256i
+#define MINMAX_PREFIX _mm256
+#define MINMAX_SI si256
+#include "vbo_minmax_tmp.h"
+
+#define MINMAX_FUNC minmax_avx2_ushort
+#define MINMAX_ATTR AVX2_FUNC
+#define MINMAX_TYPE GLushort
+#define MINMAX_BITS 16
+#define MINMAX_VEC __m256i
+#define MINMAX_PREFIX _mm256
+#define MINMAX_SI si256
+#include "vbo_minmax_tmp.h"
+
+#define MINMAX_FUNC minmax_avx2_uint
+#define MINMAX_ATTR AVX2_FUNC
+#define MINMAX_TYPE GLuint
+#define MINMAX_BITS 32
+#define MINMAX_VEC __m256i
+#define MINMAX_PREFIX _mm256
+#define MINMAX_SI si256
+#include "vbo_minmax_tmp.h"
+
+/* Below this, the scalar loops are as quick */
+#define VBO_MINMAX_SIMD_MIN_COUNT 64
+
+enum {
+   MINMAX_SCALAR,
+   MINMAX_SSE41,
+   MINMAX_AVX2
+};
+
+static unsigned
+vbo_minmax_simd_level(GLuint count)
+{
+   if (count < VBO_MINMAX_SIMD_MIN_COUNT)
+      return MINMAX_SCALAR;
+   if (util_cpu_caps.has_avx2)
+      return MINMAX_AVX2;
+   if (util_cpu_caps.has_sse4_1)
+      return MINMAX_SSE41;
+   return MINMAX_SCALAR;
+}
+#endif
 
 
 struct minmax_cache_key {
@@ -72,6 +166,26 @@ vbo_minmax_cache_delete_entry(struct hash_entry *entry)
 }
 
 
+/**
+ * Forget the results for indices in bytes [start, end) of the buffer.
+ */
+static void
+vbo_minmax_cache_forget_range(struct hash_table *cache,
+                              GLintptr start, GLintptr end)
+{
+   hash_table_foreach(cache, entry) {
+      const struct minmax_cache_key *key = entry->key;
+      void *data = entry->data;
+
+      if (key->offset < end &&
+          key->offset + (GLintptr) key->count * key->index_size > start) {
+         _mesa_hash_table_remove(cache, entry);
+         free(data);
+      }
+   }
+}
+
+
 static GLboolean
 vbo_use_minmax_cache(struct gl_buffer_object *bufferObj)
 {
@@ -117,7 +231,8 @@ vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
 
    simple_mtx_lock(&bufferObj->MinMaxCacheMutex);
 
-   if (bufferObj->MinMaxCacheDirty) {
+   if (bufferObj->MinMaxCacheDirty ||
+       bufferObj->MinMaxCacheDirtyEnd > bufferObj->MinMaxCacheDirtyStart) {
       /* Disable the cache permanently for this BO if the number of hits
        * is asymptotically less than the number of misses. This happens when
        * applications use the BO for streaming.
@@ -133,9 +248,23 @@ vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
          goto out_disable;
       }
 
-      _mesa_hash_table_clear(bufferObj->MinMaxCache, vbo_minmax_cache_delete_entry);
-      bufferObj->MinMaxCacheDirty = false;
-      goto out_invalidate;
+      if (bufferObj->MinMaxCacheDirty) {
+         _mesa_hash_table_clear(bufferObj->MinMaxCache,
+                                vbo_minmax_cache_delete_entry);
+         bufferObj->MinMaxCacheDirty = false;
+         bufferObj->MinMaxCacheDirtyStart = 0;
+         bufferObj->MinMaxCacheDirtyEnd = 0;
+         goto out_invalidate;
+      }
+
+      /* Only glBufferSubData and the like wrote to the buffer since, so
+       * the results for the other indices still hold.
+       */
+      vbo_minmax_cache_forget_range(bufferObj->MinMaxCache,
+                                    bufferObj->MinMaxCacheDirtyStart,
+                                    bufferObj->MinMaxCacheDirtyEnd);
+      bufferObj->MinMaxCacheDirtyStart = 0;
+      bufferObj->MinMaxCacheDirtyEnd = 0;
    }
 
    key.index_size = index_size;
@@ -246,6 +375,9 @@ vbo_get_minmax_index(struct gl_context *ctx,
    const char *indices;
    GLuint i;
    GLintptr offset = 0;
+#ifdef VBO_MINMAX_SIMD
+   const unsigned simd = vbo_minmax_simd_level(count);
+#endif
 
    indices = (char *) ib->ptr + prim->start * ib->index_size;
    if (_mesa_is_bufferobj(ib->obj)) {
@@ -266,6 +398,15 @@ vbo_get_minmax_index(struct gl_context *ctx,
       const GLuint *ui_indices = (const GLuint *)indices;
       GLuint max_ui = 0;
       GLuint min_ui = ~0U;
+#ifdef VBO_MINMAX_SIMD
+      if (simd == MINMAX_AVX2)
+         minmax_avx2_uint(ui_indices, count, restart, restartIndex,
+                          &min_ui, &max_ui);
+      else if (simd == MINMAX_SSE41)
+         minmax_sse41_uint(ui_indices, count, restart, restartIndex,
+                           &min_ui, &max_ui);
+      else
+#endif
       if (restart) {
          for (i = 0; i < count; i++) {
             if (ui_indices[i] != restartIndex) {
@@ -275,16 +416,10 @@ vbo_get_minmax_index(struct gl_context *ctx,
          }
       }
       else {
-#if defined(USE_SSE41)
-         if (cpu_has_sse4_1) {
-            _mesa_uint_array_min_max(ui_indices, &min_ui, &max_ui, count);
+         for (i = 0; i < count; i++) {
+            if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
+            if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
          }
-         else
-#endif
-            for (i = 0; i < count; i++) {
-               if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-               if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
-            }
       }
       *min_index = min_ui;
       *max_index = max_ui;
@@ -294,6 +429,15 @@ vbo_get_minmax_index(struct gl_context *ctx,
       const GLushort *us_indices = (const GLushort *)indices;
       GLuint max_us = 0;
       GLuint min_us = ~0U;
+#ifdef VBO_MINMAX_SIMD
+      if (simd == MINMAX_AVX2)
+         minmax_avx2_ushort(us_indices, count, restart, restartIndex,
+                            &min_us, &max_us);
+      else if (simd == MINMAX_SSE41)
+         minmax_sse41_ushort(us_indices, count, restart, restartIndex,
+                             &min_us, &max_us);
+      else
+#endif
       if (restart) {
          for (i = 0; i < count; i++) {
             if (us_indices[i] != restartIndex) {
@@ -316,6 +460,15 @@ vbo_get_minmax_index(struct gl_context *ctx,
       const GLubyte *ub_indices = (const GLubyte *)indices;
       GLuint max_ub = 0;
       GLuint min_ub = ~0U;
+#ifdef VBO_MINMAX_SIMD
+      if (simd == MINMAX_AVX2)
+         minmax_avx2_ubyte(ub_indices, count, restart, restartIndex,
+                           &min_ub, &max_ub);
+      else if (simd == MINMAX_SSE41)
+         minmax_sse41_ubyte(ub_indices, count, restart, restartIndex,
+                            &min_ub, &max_ub);
+      else
+#endif
       if (restart) {
          for (i = 0; i < count; i++) {
             if (ub_indices[i] != restartIndex) {
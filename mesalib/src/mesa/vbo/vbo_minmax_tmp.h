@@ -0,0 +1,144 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * SIMD min/max scan of an index array, included by vbo_minmax_index.c for
+ * each index size and instruction set.  The includer defines:
+ *
+ * MINMAX_FUNC   - name of the function
+ * MINMAX_ATTR   - attributes letting the compiler use the instruction set
+ * MINMAX_TYPE   - index type
+ * MINMAX_BITS   - bits of MINMAX_TYPE: 8, 16 or 32
+ * MINMAX_VEC    - vector type, __m128i or __m256i
+ * MINMAX_PREFIX - prefix of the intrinsics, _mm or _mm256
+ * MINMAX_SI     - suffix of the whole vector intrinsics, si128 or si256
+ *
+ * The result is the same as the scalar loops': with primitive restart the
+ * restart indices are left out, and ~0 and 0 are returned when there is
+ * nothing else.
+ */
+
+#define MINMAX_CAT_(a, b, c) a##b##c
+#define MINMAX_CAT(a, b, c) MINMAX_CAT_(a, b, c)
+#define MINMAX_LANE_OP(op) MINMAX_CAT(MINMAX_PREFIX, op, MINMAX_BITS)
+#define MINMAX_VEC_OP(op) MINMAX_CAT(MINMAX_PREFIX, op, MINMAX_SI)
+
+#define MINMAX_LANES (sizeof(MINMAX_VEC) / sizeof(MINMAX_TYPE))
+
+
+static MINMAX_ATTR void
+MINMAX_FUNC(const MINMAX_TYPE *indices, GLuint count, GLboolean restart,
+            GLuint restartIndex, GLuint *min_index, GLuint *max_index)
+{
+   GLuint min_i = ~0U;
+   GLuint max_i = 0;
+   GLuint i = 0, j;
+
+   /* No index of the type can be equal to a larger restart index. */
+   if (restartIndex > (MINMAX_TYPE) ~0U)
+      restart = GL_FALSE;
+
+   if (count >= MINMAX_LANES) {
+      const MINMAX_VEC zero = MINMAX_VEC_OP(_setzero_)();
+      const MINMAX_VEC ones = MINMAX_LANE_OP(_cmpeq_epi)(zero, zero);
+      MINMAX_VEC vmin = ones;
+      MINMAX_VEC vmax = zero;
+      MINMAX_VEC vseen = ones;
+      MINMAX_TYPE lmin[MINMAX_LANES], lmax[MINMAX_LANES];
+      MINMAX_TYPE lseen[MINMAX_LANES];
+      GLboolean seen = GL_TRUE;
+
+      if (restart) {
+         const MINMAX_VEC vrestart =
+            MINMAX_LANE_OP(_set1_epi)((MINMAX_TYPE) restartIndex);
+
+         /* Restart indices count as ~0 for the minimum and as 0 for the
+          * maximum, and vseen notes whether there was anything else.
+          */
+         vseen = zero;
+         for (; i <= count - MINMAX_LANES; i += MINMAX_LANES) {
+            const MINMAX_VEC v =
+               MINMAX_VEC_OP(_loadu_)((const MINMAX_VEC *) (indices + i));
+            const MINMAX_VEC r = MINMAX_LANE_OP(_cmpeq_epi)(v, vrestart);
+
+            vmin = MINMAX_LANE_OP(_min_epu)(vmin, MINMAX_VEC_OP(_or_)(v, r));
+            vmax = MINMAX_LANE_OP(_max_epu)(vmax,
+                                            MINMAX_VEC_OP(_andnot_)(r, v));
+            vseen = MINMAX_VEC_OP(_or_)(vseen,
+                                        MINMAX_VEC_OP(_andnot_)(r, ones));
+         }
+      }
+      else {
+         for (; i <= count - MINMAX_LANES; i += MINMAX_LANES) {
+            const MINMAX_VEC v =
+               MINMAX_VEC_OP(_loadu_)((const MINMAX_VEC *) (indices + i));
+
+            vmin = MINMAX_LANE_OP(_min_epu)(vmin, v);
+            vmax = MINMAX_LANE_OP(_max_epu)(vmax, v);
+         }
+      }
+
+      MINMAX_VEC_OP(_storeu_)((MINMAX_VEC *) lmin, vmin);
+      MINMAX_VEC_OP(_storeu_)((MINMAX_VEC *) lmax, vmax);
+      MINMAX_VEC_OP(_storeu_)((MINMAX_VEC *) lseen, vseen);
+
+      if (restart) {
+         seen = GL_FALSE;
+         for (j = 0; j < MINMAX_LANES; j++)
+            seen |= lseen[j] != 0;
+      }
+      if (seen) {
+         for (j = 0; j < MINMAX_LANES; j++) {
+            if (lmin[j] < min_i) min_i = lmin[j];
+            if (lmax[j] > max_i) max_i = lmax[j];
+         }
+      }
+   }
+
+   for (; i < count; i++) {
+      if (restart && indices[i] == restartIndex)
+         continue;
+      if (indices[i] > max_i) max_i = indices[i];
+      if (indices[i] < min_i) min_i = indices[i];
+   }
+
+   *min_index = min_i;
+   *max_index = max_i;
+}
+
+
+#undef MINMAX_LANES
+#undef MINMAX_VEC_OP
+#undef MINMAX_LANE_OP
+#undef MINMAX_CAT
+#undef MINMAX_CAT_
+
+#undef MINMAX_FUNC
+#undef MINMAX_ATTR
+#undef MINMAX_TYPE
+#undef MINMAX_BITS
+#undef MINMAX_VEC
+#undef MINMAX_PREFIX
+#undef MINMAX_SI
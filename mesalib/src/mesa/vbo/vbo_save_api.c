@@ -1848,6 +1848,54 @@ vbo_destroy_vertex_list(struct gl_context *ctx, void *data)
 }
 
 
+/**
+ * Called by display list code at glEndList to append the next vertex list
+ * to this one, when only the current values of \p attribs (VERT_BIT_x)
+ * were changed in between.  That is fine if next has the same vertex
+ * layout and buffer and stores per-vertex values for all of those, since
+ * its vertices and its final current values override them.
+ */
+static GLboolean
+vbo_merge_vertex_lists(struct gl_context *ctx, void *data, void *next_data,
+                       GLbitfield attribs)
+{
+   struct vbo_save_vertex_list *node = (struct vbo_save_vertex_list *) data;
+   struct vbo_save_vertex_list *next =
+      (struct vbo_save_vertex_list *) next_data;
+   (void) ctx;
+
+   if (node->VAO[VP_MODE_FF] != next->VAO[VP_MODE_FF] ||
+       node->VAO[VP_MODE_SHADER] != next->VAO[VP_MODE_SHADER])
+      return GL_FALSE;
+
+   if ((next->VAO[VP_MODE_FF]->Enabled & attribs) != attribs ||
+       (next->VAO[VP_MODE_SHADER]->Enabled & attribs) != attribs)
+      return GL_FALSE;
+
+   if (node->prim_count == 0 || next->prim_count == 0 ||
+       next->wrap_count != 0 || !node->current_data || !next->current_data)
+      return GL_FALSE;
+
+   /* Both lists' prims must be in one store with next's after node's. */
+   if (node->prim_store != next->prim_store ||
+       next->prims < node->prims + node->prim_count)
+      return GL_FALSE;
+
+   memmove(node->prims + node->prim_count, next->prims,
+           next->prim_count * sizeof(struct _mesa_prim));
+   node->prim_count += next->prim_count;
+   merge_prims(node->prims, &node->prim_count);
+
+   node->vertex_count += next->vertex_count;
+
+   free(node->current_data);
+   node->current_data = next->current_data;
+   next->current_data = NULL;
+
+   return GL_TRUE;
+}
+
+
 static void
 vbo_print_vertex_list(struct gl_context *ctx, void *data, FILE *f)
 {
@@ -1913,7 +1961,8 @@ vbo_save_api_init(struct vbo_save_context *save)
                                sizeof(struct vbo_save_vertex_list),
                                vbo_save_playback_vertex_list,
                                vbo_destroy_vertex_list,
-                               vbo_print_vertex_list);
+                               vbo_print_vertex_list,
+                               vbo_merge_vertex_lists);
 
    vtxfmt_init(ctx);
    current_init(ctx);
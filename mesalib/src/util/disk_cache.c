@@ -24,19 +24,28 @@
 #ifdef ENABLE_SHADER_CACHE
 
 #include <ctype.h>
-#include <ftw.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <sys/file.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+#include <direct.h>
+#include <io.h>
+#include <share.h>
+#include <stdarg.h>
+#else
+#include <ftw.h>
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <unistd.h>
-#include <fcntl.h>
 #include <pwd.h>
-#include <errno.h>
 #include <dirent.h>
+#endif
 #include "zlib.h"
 
 #include "util/crc32.h"
@@ -74,6 +83,56 @@
  */
 #define CACHE_VERSION 1
 
+#ifdef _WIN32
+
+#ifndef S_ISDIR
+#define S_ISDIR(m) (((m) & S_IFMT) == S_IFDIR)
+#endif
+#ifndef S_ISREG
+#define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
+#endif
+
+#ifdef _MSC_VER
+typedef SSIZE_T ssize_t;
+#endif
+
+#define O_CLOEXEC 0
+#define CACHE_FILE_MODE (_S_IREAD | _S_IWRITE)
+
+#define ftruncate(fd, size) (_chsize_s((fd), (size)) == 0 ? 0 : -1)
+
+static int
+asprintf(char **strp, const char *fmt, ...)
+{
+   va_list args;
+   int len;
+
+   va_start(args, fmt);
+   len = _vscprintf(fmt, args);
+   va_end(args);
+   if (len < 0)
+      return -1;
+
+   *strp = malloc(len + 1);
+   if (*strp == NULL)
+      return -1;
+
+   va_start(args, fmt);
+   vsnprintf(*strp, len + 1, fmt, args);
+   va_end(args);
+
+   return len;
+}
+
+#else
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+#define CACHE_FILE_MODE 0644
+
+#endif
+
 struct disk_cache {
    /* The path to the cache directory. */
    char *path;
@@ -122,6 +181,20 @@ struct disk_cache_put_job {
    struct cache_item_metadata cache_item_metadata;
 };
 
+/* Return the disk space taken by a file, which is what the size recorded in
+ * the index counts.  Windows has no block count, so round the size up to
+ * the usual NTFS cluster size.
+ */
+static uint64_t
+file_disk_size(const struct stat *sb)
+{
+#ifdef _WIN32
+   return ((uint64_t)sb->st_size + 4095) & ~(uint64_t)4095;
+#else
+   return (uint64_t)sb->st_blocks * 512;
+#endif
+}
+
 /* Create a directory named 'path' if it does not already exist.
  *
  * Returns: 0 if path already exists as a directory or if created.
@@ -145,7 +218,11 @@ mkdir_if_needed(const char *path)
       }
    }
 
+#ifdef _WIN32
+   int ret = _mkdir(path);
+#else
    int ret = mkdir(path, 0755);
+#endif
    if (ret == 0 || (ret == -1 && errno == EEXIST))
      return 0;
 
@@ -203,9 +280,11 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    uint8_t cache_version = CACHE_VERSION;
    size_t cv_size = sizeof(cache_version);
 
+#ifndef _WIN32
    /* If running as a users other than the real user disable cache */
    if (geteuid() != getuid())
       return NULL;
+#endif
 
    /* A ralloc context for transient data during this invocation. */
    local = ralloc_context(NULL);
@@ -228,6 +307,11 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
     *   $MESA_GLSL_CACHE_DIR
     *   $XDG_CACHE_HOME/mesa_shader_cache
     *   <pwd.pw_dir>/.cache/mesa_shader_cache
+    *
+    * or on Windows:
+    *
+    *   $MESA_GLSL_CACHE_DIR
+    *   %LOCALAPPDATA%/mesa_shader_cache
     */
    path = getenv("MESA_GLSL_CACHE_DIR");
    if (path) {
@@ -239,6 +323,18 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
          goto path_fail;
    }
 
+#ifdef _WIN32
+   if (path == NULL) {
+      char *local_app_data = getenv("LOCALAPPDATA");
+
+      if (local_app_data == NULL)
+         goto path_fail;
+
+      path = concatenate_and_mkdir(local, local_app_data, CACHE_DIR_NAME);
+      if (path == NULL)
+         goto path_fail;
+   }
+#else
    if (path == NULL) {
       char *xdg_cache_home = getenv("XDG_CACHE_HOME");
 
@@ -286,6 +382,7 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
       if (path == NULL)
          goto path_fail;
    }
+#endif
 
    cache->path = ralloc_strdup(cache, path);
    if (cache->path == NULL)
@@ -295,7 +392,7 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    if (path == NULL)
       goto path_fail;
 
-   fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC | O_BINARY, CACHE_FILE_MODE);
    if (fd == -1)
       goto path_fail;
 
@@ -324,10 +421,24 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
     * guarantees of the cryptographic hash, a corrupt entry is
     * unlikely to ever match a real cache key).
     */
+#ifdef _WIN32
+   /* Views of the same file are coherent between processes, like
+    * MAP_SHARED.  The view keeps the mapping object alive.
+    */
+   HANDLE mapping = CreateFileMappingA((HANDLE) _get_osfhandle(fd), NULL,
+                                       PAGE_READWRITE, 0, 0, NULL);
+   if (mapping == NULL)
+      goto path_fail;
+   cache->index_mmap = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+   CloseHandle(mapping);
+   if (cache->index_mmap == NULL)
+      goto path_fail;
+#else
    cache->index_mmap = mmap(NULL, size, PROT_READ | PROT_WRITE,
                             MAP_SHARED, fd, 0);
    if (cache->index_mmap == MAP_FAILED)
       goto path_fail;
+#endif
    cache->index_mmap_size = size;
 
    cache->size = (uint64_t *) cache->index_mmap;
@@ -369,7 +480,9 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    cache->max_size = max_size;
 
    /* 1 thread was chosen because we don't really care about getting things
-    * to disk quickly just that it's not blocking other tasks.
+    * to disk quickly just that it's not blocking other tasks.  It is one
+    * of the shared pool, at the lowest priority, so that writes don't take
+    * a processor from the compiles.
     *
     * The queue will resize automatically when it's full, so adding new jobs
     * doesn't stall.
@@ -377,7 +490,8 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    util_queue_init(&cache->cache_queue, "disk$", 32, 1,
                    UTIL_QUEUE_INIT_RESIZE_IF_FULL |
                    UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY |
-                   UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY);
+                   UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY |
+                   UTIL_QUEUE_INIT_SHARED_POOL);
 
    cache->path_init_failed = false;
 
@@ -436,7 +550,11 @@ disk_cache_destroy(struct disk_cache *cache)
 {
    if (cache && !cache->path_init_failed) {
       util_queue_destroy(&cache->cache_queue);
+#ifdef _WIN32
+      UnmapViewOfFile(cache->index_mmap);
+#else
       munmap(cache->index_mmap, cache->index_mmap_size);
+#endif
    }
 
    ralloc_free(cache);
@@ -483,6 +601,45 @@ make_cache_file_directory(struct disk_cache *cache, const cache_key key)
    free(dir);
 }
 
+typedef bool (*lru_predicate)(const char *dir_path, const struct stat *,
+                              const char *, const size_t);
+
+/* Make the directory entry d_name the LRU candidate if it is older than
+ * the current one and the predicate returns true for it.
+ */
+static void
+update_lru_file(const char *dir_path, const struct stat *sb,
+                const char *d_name, lru_predicate predicate,
+                char **lru_name, time_t *lru_atime)
+{
+   if (!*lru_atime || (sb->st_atime < *lru_atime)) {
+      size_t len = strlen(d_name);
+
+      if (!predicate(dir_path, sb, d_name, len))
+         return;
+
+      char *tmp = realloc(*lru_name, len + 1);
+      if (tmp) {
+         *lru_name = tmp;
+         memcpy(*lru_name, d_name, len + 1);
+         *lru_atime = sb->st_atime;
+      }
+   }
+}
+
+#ifdef _WIN32
+/* Convert a FILETIME, in 100ns units since 1601, to a time_t. */
+static time_t
+filetime_to_time_t(const FILETIME *ft)
+{
+   ULARGE_INTEGER t;
+
+   t.LowPart = ft->dwLowDateTime;
+   t.HighPart = ft->dwHighDateTime;
+   return (time_t)((t.QuadPart - 116444736000000000ULL) / 10000000ULL);
+}
+#endif
+
 /* Given a directory path and predicate function, find the entry with
  * the oldest access time in that directory for which the predicate
  * returns true.
@@ -492,17 +649,46 @@ make_cache_file_directory(struct disk_cache *cache, const cache_key key)
  * finished.
  */
 static char *
-choose_lru_file_matching(const char *dir_path,
-                         bool (*predicate)(const char *dir_path,
-                                           const struct stat *,
-                                           const char *, const size_t))
+choose_lru_file_matching(const char *dir_path, lru_predicate predicate)
 {
-   DIR *dir;
-   struct dirent *entry;
    char *filename;
    char *lru_name = NULL;
    time_t lru_atime = 0;
 
+#ifdef _WIN32
+   /* The find data has everything the predicates look at, so there is no
+    * need to stat each entry.  Note that Windows may update access times
+    * lazily, or only when files are written.
+    */
+   WIN32_FIND_DATAA data;
+   HANDLE find;
+   char *pattern;
+
+   if (asprintf(&pattern, "%s/*", dir_path) == -1)
+      return NULL;
+
+   find = FindFirstFileA(pattern, &data);
+   free(pattern);
+   if (find == INVALID_HANDLE_VALUE)
+      return NULL;
+
+   do {
+      struct stat sb;
+
+      memset(&sb, 0, sizeof(sb));
+      sb.st_mode = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ?
+                   S_IFDIR : S_IFREG;
+      sb.st_atime = filetime_to_time_t(&data.ftLastAccessTime);
+
+      update_lru_file(dir_path, &sb, data.cFileName, predicate,
+                      &lru_name, &lru_atime);
+   } while (FindNextFileA(find, &data));
+
+   FindClose(find);
+#else
+   DIR *dir;
+   struct dirent *entry;
+
    dir = opendir(dir_path);
    if (dir == NULL)
       return NULL;
@@ -513,33 +699,21 @@ choose_lru_file_matching(const char *dir_path,
          break;
 
       struct stat sb;
-      if (fstatat(dirfd(dir), entry->d_name, &sb, 0) == 0) {
-         if (!lru_atime || (sb.st_atime < lru_atime)) {
-            size_t len = strlen(entry->d_name);
-
-            if (!predicate(dir_path, &sb, entry->d_name, len))
-               continue;
-
-            char *tmp = realloc(lru_name, len + 1);
-            if (tmp) {
-               lru_name = tmp;
-               memcpy(lru_name, entry->d_name, len + 1);
-               lru_atime = sb.st_atime;
-            }
-         }
-      }
+      if (fstatat(dirfd(dir), entry->d_name, &sb, 0) == 0)
+         update_lru_file(dir_path, &sb, entry->d_name, predicate,
+                         &lru_name, &lru_atime);
    }
 
-   if (lru_name == NULL) {
-      closedir(dir);
+   closedir(dir);
+#endif
+
+   if (lru_name == NULL)
       return NULL;
-   }
 
    if (asprintf(&filename, "%s/%s", dir_path, lru_name) < 0)
       filename = NULL;
 
    free(lru_name);
-   closedir(dir);
 
    return filename;
 }
@@ -579,7 +753,7 @@ unlink_lru_file_from_directory(const char *path)
    unlink(filename);
    free (filename);
 
-   return sb.st_blocks * 512;
+   return file_disk_size(&sb);
 }
 
 /* Is entry a directory with a two-character name, (and not the
@@ -599,6 +773,25 @@ is_two_character_sub_directory(const char *path, const struct stat *sb,
       return false;
 
    char *subdir;
+   unsigned subdir_entries = 0;
+#ifdef _WIN32
+   WIN32_FIND_DATAA data;
+   HANDLE find;
+
+   if (asprintf(&subdir, "%s/%s/*", path, d_name) == -1)
+      return false;
+   find = FindFirstFileA(subdir, &data);
+   free(subdir);
+
+   if (find == INVALID_HANDLE_VALUE)
+     return false;
+
+   do {
+      if(++subdir_entries > 2)
+         break;
+   } while (FindNextFileA(find, &data));
+   FindClose(find);
+#else
    if (asprintf(&subdir, "%s/%s", path, d_name) == -1)
       return false;
    DIR *dir = opendir(subdir);
@@ -607,13 +800,13 @@ is_two_character_sub_directory(const char *path, const struct stat *sb,
    if (dir == NULL)
      return false;
 
-   unsigned subdir_entries = 0;
    struct dirent *d;
    while ((d = readdir(dir)) != NULL) {
       if(++subdir_entries > 2)
          break;
    }
    closedir(dir);
+#endif
 
    /* If dir only contains '.' and '..' it must be empty */
    if (subdir_entries <= 2)
@@ -684,8 +877,8 @@ disk_cache_remove(struct disk_cache *cache, const cache_key key)
    unlink(filename);
    free(filename);
 
-   if (sb.st_blocks)
-      p_atomic_add(cache->size, - (uint64_t)sb.st_blocks * 512);
+   if (file_disk_size(&sb))
+      p_atomic_add(cache->size, - file_disk_size(&sb));
 }
 
 static ssize_t
@@ -843,6 +1036,49 @@ destroy_put_job(void *job, int thread_index)
    }
 }
 
+/* Create and open the temporary file for a cache entry, and make sure that
+ * no other process is writing it.
+ *
+ * Returns: the file descriptor, or -1 with errno set.
+ */
+static int
+open_tmp_file(const char *filename_tmp)
+{
+#ifdef _WIN32
+   /* Windows has no flock(), but the file can be opened without sharing
+    * it, which fails while another process has it open.  That also makes
+    * truncating it safe.  An open file can't be unlinked on Windows, so a
+    * temporary file that was left behind is simply written over the next
+    * time.
+    */
+   int fd;
+
+   if (_sopen_s(&fd, filename_tmp, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                _SH_DENYRW, CACHE_FILE_MODE) != 0)
+      return -1;
+
+   return fd;
+#else
+   int fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT,
+                 CACHE_FILE_MODE);
+   if (fd == -1)
+      return -1;
+
+   /* With the temporary file open, we take an exclusive flock on
+    * it. If the flock fails, then another process still has the file
+    * open with the flock held. So just let that file be responsible
+    * for writing the file.
+    */
+   if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+      close(fd);
+      errno = EWOULDBLOCK;
+      return -1;
+   }
+
+   return fd;
+#endif
+}
+
 struct cache_entry_file_data {
    uint32_t crc32;
    uint32_t uncompressed_size;
@@ -853,7 +1089,7 @@ cache_put(void *job, int thread_index)
 {
    assert(job);
 
-   int fd = -1, fd_final = -1, err, ret;
+   int fd = -1, fd_final = -1, ret;
    unsigned i = 0;
    char *filename = NULL, *filename_tmp = NULL;
    struct disk_cache_put_job *dc_job = (struct disk_cache_put_job *) job;
@@ -876,7 +1112,7 @@ cache_put(void *job, int thread_index)
    if (asprintf(&filename_tmp, "%s.tmp", filename) == -1)
       goto done;
 
-   fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT, 0644);
+   fd = open_tmp_file(filename_tmp);
 
    /* Make the two-character subdirectory within the cache as needed. */
    if (fd == -1) {
@@ -885,27 +1121,18 @@ cache_put(void *job, int thread_index)
 
       make_cache_file_directory(dc_job->cache, dc_job->key);
 
-      fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT, 0644);
+      fd = open_tmp_file(filename_tmp);
       if (fd == -1)
          goto done;
    }
 
-   /* With the temporary file open, we take an exclusive flock on
-    * it. If the flock fails, then another process still has the file
-    * open with the flock held. So just let that file be responsible
-    * for writing the file.
-    */
-   err = flock(fd, LOCK_EX | LOCK_NB);
-   if (err == -1)
-      goto done;
-
    /* Now that we have the lock on the open temporary file, we can
     * check to see if the destination file already exists. If so,
     * another process won the race between when we saw that the file
     * didn't exist and now. In this case, we don't do anything more,
     * (to ensure the size accounting of the cache doesn't get off).
     */
-   fd_final = open(filename, O_RDONLY | O_CLOEXEC);
+   fd_final = open(filename, O_RDONLY | O_CLOEXEC | O_BINARY);
    if (fd_final != -1) {
       unlink(filename_tmp);
       goto done;
@@ -979,7 +1206,17 @@ cache_put(void *job, int thread_index)
       unlink(filename_tmp);
       goto done;
    }
+#ifdef _WIN32
+   /* An open file can't be renamed on Windows.  MoveFileEx() replaces the
+    * destination atomically on the same volume, as rename() does.
+    */
+   close(fd);
+   fd = -1;
+   ret = MoveFileExA(filename_tmp, filename, MOVEFILE_REPLACE_EXISTING) ?
+         0 : -1;
+#else
    ret = rename(filename_tmp, filename);
+#endif
    if (ret == -1) {
       unlink(filename_tmp);
       goto done;
@@ -992,7 +1229,7 @@ cache_put(void *job, int thread_index)
       goto done;
    }
 
-   p_atomic_add(dc_job->cache->size, sb.st_blocks * 512);
+   p_atomic_add(dc_job->cache->size, file_disk_size(&sb));
 
  done:
    if (fd_final != -1)
@@ -1107,7 +1344,7 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
    if (filename == NULL)
       goto fail;
 
-   fd = open(filename, O_RDONLY | O_CLOEXEC);
+   fd = open(filename, O_RDONLY | O_CLOEXEC | O_BINARY);
    if (fd == -1)
       goto fail;
 
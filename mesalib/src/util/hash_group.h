@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Control bytes for the group-probed tables of hash_table.c and set.c.
+ *
+ * Every slot of a table has a control byte, which is HASH_CTRL_EMPTY,
+ * HASH_CTRL_DELETED, or for a slot in use the 7-bit tag of its key's hash.
+ * Tables are probed a group of HASH_GROUP_SIZE slots at a time, matching
+ * all of the group's control bytes against a tag at once, so keys are only
+ * compared for the slots whose tag matches.  A lookup ends at the first
+ * group with an empty slot.
+ */
+
+#ifndef _HASH_GROUP_H
+#define _HASH_GROUP_H
+
+#include <inttypes.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HASH_GROUP_SSE2
+#include <emmintrin.h>
+#endif
+
+#define HASH_GROUP_SIZE 16
+
+#define HASH_CTRL_EMPTY   0x80
+#define HASH_CTRL_DELETED 0xfe
+
+/** Spread the bits of a key's hash, which may well be a small integer */
+static inline uint32_t
+hash_group_mix(uint32_t hash)
+{
+   return hash * 0x9e3779b1u;
+}
+
+static inline uint8_t
+hash_group_tag(uint32_t mixed)
+{
+   return mixed & 0x7f;
+}
+
+static inline uint32_t
+hash_group_first(uint32_t mixed, uint32_t num_groups)
+{
+   return (mixed >> 7) & (num_groups - 1);
+}
+
+/** Bitmask of the slots of the group whose control byte is ctrl */
+static inline unsigned
+hash_group_match(const uint8_t *group, uint8_t ctrl)
+{
+#ifdef HASH_GROUP_SSE2
+   const __m128i bytes = _mm_loadu_si128((const __m128i *) group);
+
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(ctrl)));
+#else
+   unsigned mask = 0;
+   int i;
+
+   for (i = 0; i < HASH_GROUP_SIZE; i++)
+      mask |= (unsigned) (group[i] == ctrl) << i;
+   return mask;
+#endif
+}
+
+/** Bitmask of the empty and deleted slots of the group */
+static inline unsigned
+hash_group_match_available(const uint8_t *group)
+{
+#ifdef HASH_GROUP_SSE2
+   return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+#else
+   unsigned mask = 0;
+   int i;
+
+   for (i = 0; i < HASH_GROUP_SIZE; i++)
+      mask |= (unsigned) (group[i] >> 7) << i;
+   return mask;
+#endif
+}
+
+#endif /* _HASH_GROUP_H */
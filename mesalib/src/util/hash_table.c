@@ -33,7 +33,8 @@
  */
 
 /**
- * Implements an open-addressing, linear-reprobing hash table.
+ * Implements an open-addressing hash table, probed a group of slots at a
+ * time through a byte of metadata per slot, see hash_group.h.
  *
  * For more information, see:
  *
@@ -45,6 +46,8 @@
 #include <assert.h>
 
 #include "hash_table.h"
+#include "hash_group.h"
+#include "bitscan.h"
 #include "ralloc.h"
 #include "macros.h"
 #include "main/hash.h"
@@ -52,62 +55,44 @@
 static const uint32_t deleted_key_value;
 
 /**
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
+ * Tables have HASH_GROUP_SIZE << size_index slots, and are rehashed once
+ * they are 7/8 full, which group probing copes with well.
  */
-static const struct {
-   uint32_t max_entries, size, rehash;
-} hash_sizes[] = {
-   { 2,			5,		3	  },
-   { 4,			7,		5	  },
-   { 8,			13,		11	  },
-   { 16,		19,		17	  },
-   { 32,		43,		41        },
-   { 64,		73,		71        },
-   { 128,		151,		149       },
-   { 256,		283,		281       },
-   { 512,		571,		569       },
-   { 1024,		1153,		1151      },
-   { 2048,		2269,		2267      },
-   { 4096,		4519,		4517      },
-   { 8192,		9013,		9011      },
-   { 16384,		18043,		18041     },
-   { 32768,		36109,		36107     },
-   { 65536,		72091,		72089     },
-   { 131072,		144409,		144407    },
-   { 262144,		288361,		288359    },
-   { 524288,		576883,		576881    },
-   { 1048576,		1153459,	1153457   },
-   { 2097152,		2307163,	2307161   },
-   { 4194304,		4613893,	4613891   },
-   { 8388608,		9227641,	9227639   },
-   { 16777216,		18455029,	18455027  },
-   { 33554432,		36911011,	36911009  },
-   { 67108864,		73819861,	73819859  },
-   { 134217728,		147639589,	147639587 },
-   { 268435456,		295279081,	295279079 },
-   { 536870912,		590559793,	590559791 },
-   { 1073741824,	1181116273,	1181116271},
-   { 2147483648ul,	2362232233ul,	2362232231ul}
-};
+#define MAX_SIZE_INDEX 27
 
 static int
-entry_is_free(const struct hash_entry *entry)
+slot_is_present(const struct hash_table *ht, uint32_t i)
 {
-   return entry->key == NULL;
+   return ht->ctrl[i] < HASH_CTRL_EMPTY;
 }
 
-static int
-entry_is_deleted(const struct hash_table *ht, struct hash_entry *entry)
+static bool
+hash_table_alloc(struct hash_table *ht, void *mem_ctx, uint32_t size_index)
 {
-   return entry->key == ht->deleted_key;
-}
+   const uint32_t size = HASH_GROUP_SIZE << size_index;
+   struct hash_entry *table;
+   uint8_t *ctrl;
 
-static int
-entry_is_present(const struct hash_table *ht, struct hash_entry *entry)
-{
-   return entry->key != NULL && entry->key != ht->deleted_key;
+   table = rzalloc_array(mem_ctx, struct hash_entry, size);
+   if (table == NULL)
+      return false;
+
+   ctrl = ralloc_array(table, uint8_t, size);
+   if (ctrl == NULL) {
+      ralloc_free(table);
+      return false;
+   }
+   memset(ctrl, HASH_CTRL_EMPTY, size);
+
+   ht->table = table;
+   ht->ctrl = ctrl;
+   ht->size_index = size_index;
+   ht->size = size;
+   ht->max_entries = size - size / 8;
+   ht->entries = 0;
+   ht->deleted_entries = 0;
+
+   return true;
 }
 
 bool
@@ -117,18 +102,11 @@ _mesa_hash_table_init(struct hash_table *ht,
                       bool (*key_equals_function)(const void *a,
                                                   const void *b))
 {
-   ht->size_index = 0;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(mem_ctx, struct hash_entry, ht->size);
-   ht->entries = 0;
-   ht->deleted_entries = 0;
    ht->deleted_key = &deleted_key_value;
 
-   return ht->table != NULL;
+   return hash_table_alloc(ht, mem_ctx, 0);
 }
 
 struct hash_table *
@@ -171,7 +149,14 @@ _mesa_hash_table_clone(struct hash_table *src, void *dst_mem_ctx)
       return NULL;
    }
 
+   ht->ctrl = ralloc_array(ht->table, uint8_t, ht->size);
+   if (ht->ctrl == NULL) {
+      ralloc_free(ht);
+      return NULL;
+   }
+
    memcpy(ht->table, src->table, ht->size * sizeof(struct hash_entry));
+   memcpy(ht->ctrl, src->ctrl, ht->size);
 
    return ht;
 }
@@ -207,17 +192,15 @@ void
 _mesa_hash_table_clear(struct hash_table *ht,
                        void (*delete_function)(struct hash_entry *entry))
 {
-   struct hash_entry *entry;
-
-   for (entry = ht->table; entry != ht->table + ht->size; entry++) {
-      if (entry->key == NULL)
-         continue;
+   uint32_t i;
 
-      if (delete_function != NULL && entry->key != ht->deleted_key)
-         delete_function(entry);
+   for (i = 0; i < ht->size; i++) {
+      if (delete_function != NULL && slot_is_present(ht, i))
+         delete_function(ht->table + i);
 
-      entry->key = NULL;
+      ht->table[i].key = NULL;
    }
+   memset(ht->ctrl, HASH_CTRL_EMPTY, ht->size);
 
    ht->entries = 0;
    ht->deleted_entries = 0;
@@ -242,26 +225,30 @@ _mesa_hash_table_set_deleted_key(struct hash_table *ht, const void *deleted_key)
 static struct hash_entry *
 hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
 {
-   uint32_t start_hash_address = hash % ht->size;
-   uint32_t hash_address = start_hash_address;
+   const uint32_t mixed = hash_group_mix(hash);
+   const uint8_t tag = hash_group_tag(mixed);
+   const uint32_t group_mask = ht->size / HASH_GROUP_SIZE - 1;
+   uint32_t group = hash_group_first(mixed, group_mask + 1);
+   uint32_t probe;
 
-   do {
-      uint32_t double_hash;
+   /* Triangular steps visit every group of a power-of-two table */
+   for (probe = 1; probe <= group_mask + 1; probe++) {
+      const uint8_t *ctrl = ht->ctrl + group * HASH_GROUP_SIZE;
+      struct hash_entry *entries = ht->table + group * HASH_GROUP_SIZE;
+      unsigned match = hash_group_match(ctrl, tag);
 
-      struct hash_entry *entry = ht->table + hash_address;
+      while (match) {
+         struct hash_entry *entry = entries + u_bit_scan(&match);
 
-      if (entry_is_free(entry)) {
-         return NULL;
-      } else if (entry_is_present(ht, entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key))
             return entry;
-         }
       }
 
-      double_hash = 1 + hash % ht->rehash;
+      if (hash_group_match(ctrl, HASH_CTRL_EMPTY))
+         return NULL;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != start_hash_address);
+      group = (group + probe) & group_mask;
+   }
 
    return NULL;
 }
@@ -295,28 +282,23 @@ static void
 _mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
 {
    struct hash_table old_ht;
-   struct hash_entry *table;
-
-   if (new_size_index >= ARRAY_SIZE(hash_sizes))
-      return;
+   uint32_t i;
 
-   table = rzalloc_array(ralloc_parent(ht->table), struct hash_entry,
-                         hash_sizes[new_size_index].size);
-   if (table == NULL)
+   if (new_size_index > MAX_SIZE_INDEX)
       return;
 
    old_ht = *ht;
 
-   ht->table = table;
-   ht->size_index = new_size_index;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
-   ht->entries = 0;
-   ht->deleted_entries = 0;
+   if (!hash_table_alloc(ht, ralloc_parent(old_ht.table), new_size_index)) {
+      *ht = old_ht;
+      return;
+   }
 
-   hash_table_foreach(&old_ht, entry) {
-      hash_table_insert(ht, entry->hash, entry->key, entry->data);
+   for (i = 0; i < old_ht.size; i++) {
+      if (slot_is_present(&old_ht, i)) {
+         const struct hash_entry *entry = old_ht.table + i;
+         hash_table_insert(ht, entry->hash, entry->key, entry->data);
+      }
    }
 
    ralloc_free(old_ht.table);
@@ -326,8 +308,9 @@ static struct hash_entry *
 hash_table_insert(struct hash_table *ht, uint32_t hash,
                   const void *key, void *data)
 {
-   uint32_t start_hash_address, hash_address;
+   uint32_t mixed, group_mask, group, probe;
    struct hash_entry *available_entry = NULL;
+   uint8_t tag;
 
    assert(key != NULL);
 
@@ -337,19 +320,15 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
       _mesa_hash_table_rehash(ht, ht->size_index);
    }
 
-   start_hash_address = hash % ht->size;
-   hash_address = start_hash_address;
-   do {
-      struct hash_entry *entry = ht->table + hash_address;
-      uint32_t double_hash;
-
-      if (!entry_is_present(ht, entry)) {
-         /* Stash the first available entry we find */
-         if (available_entry == NULL)
-            available_entry = entry;
-         if (entry_is_free(entry))
-            break;
-      }
+   mixed = hash_group_mix(hash);
+   tag = hash_group_tag(mixed);
+   group_mask = ht->size / HASH_GROUP_SIZE - 1;
+   group = hash_group_first(mixed, group_mask + 1);
+
+   for (probe = 1; probe <= group_mask + 1; probe++) {
+      const uint8_t *ctrl = ht->ctrl + group * HASH_GROUP_SIZE;
+      struct hash_entry *entries = ht->table + group * HASH_GROUP_SIZE;
+      unsigned match = hash_group_match(ctrl, tag);
 
       /* Implement replacement when another insert happens
        * with a matching key.  This is a relatively common
@@ -362,23 +341,35 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
        * required to avoid memory leaks, perform a search
        * before inserting.
        */
-      if (!entry_is_deleted(ht, entry) &&
-          entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
-         entry->key = key;
-         entry->data = data;
-         return entry;
+      while (match) {
+         struct hash_entry *entry = entries + u_bit_scan(&match);
+
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key)) {
+            entry->key = key;
+            entry->data = data;
+            return entry;
+         }
       }
 
+      /* Stash the first available entry we find */
+      if (available_entry == NULL) {
+         unsigned available = hash_group_match_available(ctrl);
+         if (available)
+            available_entry = entries + ffs(available) - 1;
+      }
 
-      double_hash = 1 + hash % ht->rehash;
+      if (hash_group_match(ctrl, HASH_CTRL_EMPTY))
+         break;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != start_hash_address);
+      group = (group + probe) & group_mask;
+   }
 
    if (available_entry) {
-      if (entry_is_deleted(ht, available_entry))
+      const uint32_t i = available_entry - ht->table;
+
+      if (ht->ctrl[i] == HASH_CTRL_DELETED)
          ht->deleted_entries--;
+      ht->ctrl[i] = tag;
       available_entry->hash = hash;
       available_entry->key = key;
       available_entry->data = data;
@@ -423,12 +414,25 @@ void
 _mesa_hash_table_remove(struct hash_table *ht,
                         struct hash_entry *entry)
 {
+   uint32_t i;
+
    if (!entry)
       return;
 
+   /* A slot can go back to empty if its group already has an empty slot,
+    * because then no lookup has ever had to probe past this group.
+    */
+   i = entry - ht->table;
+   if (hash_group_match(ht->ctrl + (i & ~(HASH_GROUP_SIZE - 1)),
+                        HASH_CTRL_EMPTY)) {
+      ht->ctrl[i] = HASH_CTRL_EMPTY;
+   } else {
+      ht->ctrl[i] = HASH_CTRL_DELETED;
+      ht->deleted_entries++;
+   }
+
    entry->key = ht->deleted_key;
    ht->entries--;
-   ht->deleted_entries++;
 }
 
 /**
@@ -450,15 +454,11 @@ struct hash_entry *
 _mesa_hash_table_next_entry(struct hash_table *ht,
                             struct hash_entry *entry)
 {
-   if (entry == NULL)
-      entry = ht->table;
-   else
-      entry = entry + 1;
+   uint32_t i = entry == NULL ? 0 : entry - ht->table + 1;
 
-   for (; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(ht, entry)) {
-         return entry;
-      }
+   for (; i < ht->size; i++) {
+      if (slot_is_present(ht, i))
+         return ht->table + i;
    }
 
    return NULL;
@@ -476,23 +476,18 @@ struct hash_entry *
 _mesa_hash_table_random_entry(struct hash_table *ht,
                               bool (*predicate)(struct hash_entry *entry))
 {
-   struct hash_entry *entry;
-   uint32_t i = rand() % ht->size;
+   uint32_t start = rand() % ht->size;
+   uint32_t n;
 
    if (ht->entries == 0)
       return NULL;
 
-   for (entry = ht->table + i; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(ht, entry) &&
-          (!predicate || predicate(entry))) {
-         return entry;
-      }
-   }
+   for (n = 0; n < ht->size; n++) {
+      const uint32_t i = (start + n) % ht->size;
 
-   for (entry = ht->table; entry != ht->table + i; entry++) {
-      if (entry_is_present(ht, entry) &&
-          (!predicate || predicate(entry))) {
-         return entry;
+      if (slot_is_present(ht, i) &&
+          (!predicate || predicate(ht->table + i))) {
+         return ht->table + i;
       }
    }
 
@@ -250,6 +250,17 @@ do {                       \
 #define ATTRIBUTE_NOINLINE
 #endif
 
+/**
+ * Storage class for the thread-local current dispatch and context of
+ * GLX_USE_TLS builds.  MSVC's __declspec(thread) variables are always
+ * reached through the thread's TLS block like the initial-exec model.
+ */
+#if defined(_MSC_VER)
+#define __THREAD_INITIAL_EXEC __declspec(thread)
+#else
+#define __THREAD_INITIAL_EXEC __thread __attribute__((tls_model("initial-exec")))
+#endif
+
 
 /**
  * Check that STRUCT::FIELD can hold MAXVAL.  We use a lot of bitfields
@@ -37,71 +37,56 @@
 #include <string.h>
 
 #include "hash_table.h"
+#include "hash_group.h"
+#include "bitscan.h"
 #include "macros.h"
 #include "ralloc.h"
 #include "set.h"
 
 /*
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
+ * Sets are probed a group of slots at a time like hash tables, see
+ * hash_group.h.  They have HASH_GROUP_SIZE << size_index slots, and are
+ * rehashed once they are 7/8 full.
  */
 
 static const uint32_t deleted_key_value;
 static const void *deleted_key = &deleted_key_value;
 
-static const struct {
-   uint32_t max_entries, size, rehash;
-} hash_sizes[] = {
-   { 2,            5,            3            },
-   { 4,            7,            5            },
-   { 8,            13,           11           },
-   { 16,           19,           17           },
-   { 32,           43,           41           },
-   { 64,           73,           71           },
-   { 128,          151,          149          },
-   { 256,          283,          281          },
-   { 512,          571,          569          },
-   { 1024,         1153,         1151         },
-   { 2048,         2269,         2267         },
-   { 4096,         4519,         4517         },
-   { 8192,         9013,         9011         },
-   { 16384,        18043,        18041        },
-   { 32768,        36109,        36107        },
-   { 65536,        72091,        72089        },
-   { 131072,       144409,       144407       },
-   { 262144,       288361,       288359       },
-   { 524288,       576883,       576881       },
-   { 1048576,      1153459,      1153457      },
-   { 2097152,      2307163,      2307161      },
-   { 4194304,      4613893,      4613891      },
-   { 8388608,      9227641,      9227639      },
-   { 16777216,     18455029,     18455027     },
-   { 33554432,     36911011,     36911009     },
-   { 67108864,     73819861,     73819859     },
-   { 134217728,    147639589,    147639587    },
-   { 268435456,    295279081,    295279079    },
-   { 536870912,    590559793,    590559791    },
-   { 1073741824,   1181116273,   1181116271   },
-   { 2147483648ul, 2362232233ul, 2362232231ul }
-};
+#define MAX_SIZE_INDEX 27
 
 static int
-entry_is_free(struct set_entry *entry)
+slot_is_present(const struct set *ht, uint32_t i)
 {
-   return entry->key == NULL;
+   return ht->ctrl[i] < HASH_CTRL_EMPTY;
 }
 
-static int
-entry_is_deleted(struct set_entry *entry)
+static bool
+set_alloc(struct set *ht, uint32_t size_index)
 {
-   return entry->key == deleted_key;
-}
+   const uint32_t size = HASH_GROUP_SIZE << size_index;
+   struct set_entry *table;
+   uint8_t *ctrl;
 
-static int
-entry_is_present(struct set_entry *entry)
-{
-   return entry->key != NULL && entry->key != deleted_key;
+   table = rzalloc_array(ht, struct set_entry, size);
+   if (table == NULL)
+      return false;
+
+   ctrl = ralloc_array(table, uint8_t, size);
+   if (ctrl == NULL) {
+      ralloc_free(table);
+      return false;
+   }
+   memset(ctrl, HASH_CTRL_EMPTY, size);
+
+   ht->table = table;
+   ht->ctrl = ctrl;
+   ht->size_index = size_index;
+   ht->size = size;
+   ht->max_entries = size - size / 8;
+   ht->entries = 0;
+   ht->deleted_entries = 0;
+
+   return true;
 }
 
 struct set *
@@ -116,17 +101,10 @@ _mesa_set_create(void *mem_ctx,
    if (ht == NULL)
       return NULL;
 
-   ht->size_index = 0;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(ht, struct set_entry, ht->size);
-   ht->entries = 0;
-   ht->deleted_entries = 0;
 
-   if (ht->table == NULL) {
+   if (!set_alloc(ht, 0)) {
       ralloc_free(ht);
       return NULL;
    }
@@ -151,7 +129,14 @@ _mesa_set_clone(struct set *set, void *dst_mem_ctx)
       return NULL;
    }
 
+   clone->ctrl = ralloc_array(clone->table, uint8_t, clone->size);
+   if (clone->ctrl == NULL) {
+      ralloc_free(clone);
+      return NULL;
+   }
+
    memcpy(clone->table, set->table, clone->size * sizeof(struct set_entry));
+   memcpy(clone->ctrl, set->ctrl, clone->size);
 
    return clone;
 }
@@ -194,6 +179,7 @@ _mesa_set_clear(struct set *set, void (*delete_function)(struct set_entry *entry
          delete_function(entry);
       entry->key = deleted_key;
    }
+   memset(set->ctrl, HASH_CTRL_EMPTY, set->size);
 
    set->entries = set->deleted_entries = 0;
 }
@@ -206,26 +192,30 @@ _mesa_set_clear(struct set *set, void (*delete_function)(struct set_entry *entry
 static struct set_entry *
 set_search(const struct set *ht, uint32_t hash, const void *key)
 {
-   uint32_t hash_address;
-
-   hash_address = hash % ht->size;
-   do {
-      uint32_t double_hash;
-
-      struct set_entry *entry = ht->table + hash_address;
-
-      if (entry_is_free(entry)) {
-         return NULL;
-      } else if (entry_is_present(entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+   const uint32_t mixed = hash_group_mix(hash);
+   const uint8_t tag = hash_group_tag(mixed);
+   const uint32_t group_mask = ht->size / HASH_GROUP_SIZE - 1;
+   uint32_t group = hash_group_first(mixed, group_mask + 1);
+   uint32_t probe;
+
+   /* Triangular steps visit every group of a power-of-two table */
+   for (probe = 1; probe <= group_mask + 1; probe++) {
+      const uint8_t *ctrl = ht->ctrl + group * HASH_GROUP_SIZE;
+      struct set_entry *entries = ht->table + group * HASH_GROUP_SIZE;
+      unsigned match = hash_group_match(ctrl, tag);
+
+      while (match) {
+         struct set_entry *entry = entries + u_bit_scan(&match);
+
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key))
             return entry;
-         }
       }
 
-      double_hash = 1 + hash % ht->rehash;
+      if (hash_group_match(ctrl, HASH_CTRL_EMPTY))
+         return NULL;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != hash % ht->size);
+      group = (group + probe) & group_mask;
+   }
 
    return NULL;
 }
@@ -253,28 +243,21 @@ static void
 set_rehash(struct set *ht, unsigned new_size_index)
 {
    struct set old_ht;
-   struct set_entry *table;
-
-   if (new_size_index >= ARRAY_SIZE(hash_sizes))
-      return;
+   uint32_t i;
 
-   table = rzalloc_array(ht, struct set_entry,
-                         hash_sizes[new_size_index].size);
-   if (table == NULL)
+   if (new_size_index > MAX_SIZE_INDEX)
       return;
 
    old_ht = *ht;
 
-   ht->table = table;
-   ht->size_index = new_size_index;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
-   ht->entries = 0;
-   ht->deleted_entries = 0;
+   if (!set_alloc(ht, new_size_index)) {
+      *ht = old_ht;
+      return;
+   }
 
-   set_foreach(&old_ht, entry) {
-      set_add(ht, entry->hash, entry->key);
+   for (i = 0; i < old_ht.size; i++) {
+      if (slot_is_present(&old_ht, i))
+         set_add(ht, old_ht.table[i].hash, old_ht.table[i].key);
    }
 
    ralloc_free(old_ht.table);
@@ -289,8 +272,9 @@ set_rehash(struct set *ht, unsigned new_size_index)
 static struct set_entry *
 set_add(struct set *ht, uint32_t hash, const void *key)
 {
-   uint32_t hash_address;
+   uint32_t mixed, group_mask, group, probe;
    struct set_entry *available_entry = NULL;
+   uint8_t tag;
 
    if (ht->entries >= ht->max_entries) {
       set_rehash(ht, ht->size_index + 1);
@@ -298,18 +282,15 @@ set_add(struct set *ht, uint32_t hash, const void *key)
       set_rehash(ht, ht->size_index);
    }
 
-   hash_address = hash % ht->size;
-   do {
-      struct set_entry *entry = ht->table + hash_address;
-      uint32_t double_hash;
-
-      if (!entry_is_present(entry)) {
-         /* Stash the first available entry we find */
-         if (available_entry == NULL)
-            available_entry = entry;
-         if (entry_is_free(entry))
-            break;
-      }
+   mixed = hash_group_mix(hash);
+   tag = hash_group_tag(mixed);
+   group_mask = ht->size / HASH_GROUP_SIZE - 1;
+   group = hash_group_first(mixed, group_mask + 1);
+
+   for (probe = 1; probe <= group_mask + 1; probe++) {
+      const uint8_t *ctrl = ht->ctrl + group * HASH_GROUP_SIZE;
+      struct set_entry *entries = ht->table + group * HASH_GROUP_SIZE;
+      unsigned match = hash_group_match(ctrl, tag);
 
       /* Implement replacement when another insert happens
        * with a matching key.  This is a relatively common
@@ -321,21 +302,34 @@ set_add(struct set *ht, uint32_t hash, const void *key)
        * If freeing of old keys is required to avoid memory leaks,
        * perform a search before inserting.
        */
-      if (!entry_is_deleted(entry) &&
-          entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
-         entry->key = key;
-         return entry;
+      while (match) {
+         struct set_entry *entry = entries + u_bit_scan(&match);
+
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key)) {
+            entry->key = key;
+            return entry;
+         }
+      }
+
+      /* Stash the first available entry we find */
+      if (available_entry == NULL) {
+         unsigned available = hash_group_match_available(ctrl);
+         if (available)
+            available_entry = entries + ffs(available) - 1;
       }
 
-      double_hash = 1 + hash % ht->rehash;
+      if (hash_group_match(ctrl, HASH_CTRL_EMPTY))
+         break;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != hash % ht->size);
+      group = (group + probe) & group_mask;
+   }
 
    if (available_entry) {
-      if (entry_is_deleted(available_entry))
+      const uint32_t i = available_entry - ht->table;
+
+      if (ht->ctrl[i] == HASH_CTRL_DELETED)
          ht->deleted_entries--;
+      ht->ctrl[i] = tag;
       available_entry->hash = hash;
       available_entry->key = key;
       ht->entries++;
@@ -372,12 +366,25 @@ _mesa_set_add_pre_hashed(struct set *set, uint32_t hash, const void *key)
 void
 _mesa_set_remove(struct set *ht, struct set_entry *entry)
 {
+   uint32_t i;
+
    if (!entry)
       return;
 
+   /* A slot can go back to empty if its group already has an empty slot,
+    * because then no lookup has ever had to probe past this group.
+    */
+   i = entry - ht->table;
+   if (hash_group_match(ht->ctrl + (i & ~(HASH_GROUP_SIZE - 1)),
+                        HASH_CTRL_EMPTY)) {
+      ht->ctrl[i] = HASH_CTRL_EMPTY;
+   } else {
+      ht->ctrl[i] = HASH_CTRL_DELETED;
+      ht->deleted_entries++;
+   }
+
    entry->key = deleted_key;
    ht->entries--;
-   ht->deleted_entries++;
 }
 
 /**
@@ -398,15 +405,11 @@ _mesa_set_remove_key(struct set *set, const void *key)
 struct set_entry *
 _mesa_set_next_entry(const struct set *ht, struct set_entry *entry)
 {
-   if (entry == NULL)
-      entry = ht->table;
-   else
-      entry = entry + 1;
-
-   for (; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry)) {
-         return entry;
-      }
+   uint32_t i = entry == NULL ? 0 : entry - ht->table + 1;
+
+   for (; i < ht->size; i++) {
+      if (slot_is_present(ht, i))
+         return ht->table + i;
    }
 
    return NULL;
@@ -416,23 +419,18 @@ struct set_entry *
 _mesa_set_random_entry(struct set *ht,
                        int (*predicate)(struct set_entry *entry))
 {
-   struct set_entry *entry;
-   uint32_t i = rand() % ht->size;
+   uint32_t start = rand() % ht->size;
+   uint32_t n;
 
    if (ht->entries == 0)
       return NULL;
 
-   for (entry = ht->table + i; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry) &&
-          (!predicate || predicate(entry))) {
-         return entry;
-      }
-   }
+   for (n = 0; n < ht->size; n++) {
+      const uint32_t i = (start + n) % ht->size;
 
-   for (entry = ht->table; entry != ht->table + i; entry++) {
-      if (entry_is_present(entry) &&
-          (!predicate || predicate(entry))) {
-         return entry;
+      if (slot_is_present(ht, i) &&
+          (!predicate || predicate(ht->table + i))) {
+         return ht->table + i;
       }
    }
 
@@ -29,14 +29,22 @@
 #include <time.h>
 
 #include "util/os_time.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_string.h"
 #include "util/u_thread.h"
 #include "u_process.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 static void
 util_queue_kill_threads(struct util_queue *queue, unsigned keep_num_threads,
                         bool finish_locked);
 
+/* Set by the atexit handler, when the pool workers may be gone already */
+static bool exiting;
+
 /****************************************************************************
  * Wait for all queues to assert idle when exit() is called.
  *
@@ -54,6 +62,7 @@ atexit_handler(void)
    struct util_queue *iter;
 
    mtx_lock(&exit_mutex);
+   exiting = true;
    /* Wait for all queues to assert idle. */
    LIST_FOR_EACH_ENTRY(iter, &queue_list, head) {
       util_queue_kill_threads(iter, 0, false);
@@ -224,6 +233,474 @@ util_queue_fence_destroy(struct util_queue_fence *fence)
 }
 #endif
 
+/****************************************************************************
+ * Process-wide pool of workers for the queues created with
+ * UTIL_QUEUE_INIT_SHARED_POOL.
+ *
+ * Each worker has a deque of tasks for every priority.  A task is a queue
+ * with jobs waiting, and running it runs the oldest job of the queue.  A
+ * queue has at most num_threads tasks in the pool, which is what limits
+ * the number of its jobs running at the same time.  Tasks added by a
+ * worker go to the back of its own deques, and the worker takes them back
+ * from there, so that a busy queue tends to stay on the same processors;
+ * tasks added by other threads are spread over the workers.  A worker with
+ * nothing left of its own steals from the front of the deques of the
+ * others, those of its own NUMA node first, and always takes the highest
+ * priority task it can find.
+ *
+ * On Windows, the workers are spread over the NUMA nodes and processor
+ * groups, as a thread only ever runs on the processors of the group it
+ * was started in unless told otherwise.
+ */
+
+#define POOL_MAX_WORKERS 256
+#define POOL_MAX_NODES 64
+
+enum {
+   POOL_PRIORITY_LOW,
+   POOL_PRIORITY_NORMAL,
+   POOL_PRIORITY_HIGH,
+   POOL_NUM_PRIORITIES
+};
+
+struct pool_deque {
+   struct util_queue **tasks; /* NULL for tasks taken from the middle */
+   unsigned size; /* power of two */
+   unsigned head, tail;
+};
+
+struct pool_worker {
+   mtx_t lock;
+   struct pool_deque deques[POOL_NUM_PRIORITIES];
+   unsigned index;
+   unsigned node;
+   thrd_t thread;
+};
+
+#ifdef _WIN32
+/* GROUP_AFFINITY, which the Windows XP headers don't have */
+struct pool_group_affinity {
+   ULONG_PTR Mask;
+   WORD Group;
+   WORD Reserved[3];
+};
+
+typedef BOOL (WINAPI *PFNGETNUMAHIGHESTNODENUMBER)(PULONG);
+typedef BOOL (WINAPI *PFNGETNUMANODEPROCESSORMASKEX)(USHORT,
+                                                     struct pool_group_affinity *);
+typedef BOOL (WINAPI *PFNSETTHREADGROUPAFFINITY)(HANDLE,
+                                                 const struct pool_group_affinity *,
+                                                 struct pool_group_affinity *);
+#endif
+
+static struct {
+   struct pool_worker *workers;
+   unsigned num_workers;
+   unsigned next_worker; /* for tasks added by other threads */
+   int num_pending[POOL_NUM_PRIORITIES];
+   int num_sleeping;
+   mtx_t sleep_lock;
+   cnd_t wake_cond;
+#ifdef _WIN32
+   struct pool_group_affinity nodes[POOL_MAX_NODES];
+   PFNSETTHREADGROUPAFFINITY SetThreadGroupAffinity;
+#endif
+} pool;
+
+static once_flag pool_once_flag = ONCE_FLAG_INIT;
+static __THREAD_INITIAL_EXEC struct pool_worker *pool_current;
+
+static void
+pool_run_task(struct pool_worker *worker, struct util_queue *queue);
+
+static bool
+pool_deque_push(struct pool_deque *deque, struct util_queue *queue)
+{
+   if (deque->tail - deque->head == deque->size) {
+      unsigned size = MAX2(deque->size * 2, 16);
+      struct util_queue **tasks =
+         (struct util_queue **) malloc(size * sizeof(*tasks));
+
+      if (!tasks)
+         return false;
+      for (unsigned i = deque->head; i != deque->tail; i++)
+         tasks[i & (size - 1)] = deque->tasks[i & (deque->size - 1)];
+      free(deque->tasks);
+      deque->tasks = tasks;
+      deque->size = size;
+   }
+
+   deque->tasks[deque->tail++ & (deque->size - 1)] = queue;
+   return true;
+}
+
+/* Take a task of the given queue, or any task if queue is NULL, from the
+ * back or the front of a deque.
+ */
+static struct util_queue *
+pool_deque_take(struct pool_deque *deque, struct util_queue *queue,
+                bool back)
+{
+   struct util_queue *task;
+
+   if (queue) {
+      for (unsigned i = deque->head; i != deque->tail; i++) {
+         if (deque->tasks[i & (deque->size - 1)] == queue) {
+            deque->tasks[i & (deque->size - 1)] = NULL;
+            return queue;
+         }
+      }
+      return NULL;
+   }
+
+   while (deque->head != deque->tail) {
+      if (back)
+         task = deque->tasks[--deque->tail & (deque->size - 1)];
+      else
+         task = deque->tasks[deque->head++ & (deque->size - 1)];
+      if (task)
+         return task;
+   }
+   return NULL;
+}
+
+static struct util_queue *
+pool_worker_take(struct pool_worker *worker, unsigned priority,
+                 struct util_queue *queue, bool back)
+{
+   struct util_queue *task;
+
+   mtx_lock(&worker->lock);
+   task = pool_deque_take(&worker->deques[priority], queue, back);
+   mtx_unlock(&worker->lock);
+
+   if (task)
+      p_atomic_dec(&pool.num_pending[priority]);
+   return task;
+}
+
+/* Find a task of the given queue, or the highest priority task of any
+ * queue if queue is NULL, for the worker (NULL for other threads).
+ */
+static struct util_queue *
+pool_get_task(struct pool_worker *worker, struct util_queue *queue)
+{
+   struct util_queue *task;
+   unsigned start = worker ? worker->index + 1 : 0;
+
+   for (int priority = POOL_NUM_PRIORITIES - 1; priority >= 0; priority--) {
+      if (queue && queue->priority != priority)
+         continue;
+      if (!p_atomic_read(&pool.num_pending[priority]))
+         continue;
+
+      if (worker) {
+         task = pool_worker_take(worker, priority, queue, true);
+         if (task)
+            return task;
+      }
+
+      /* Steal, from the workers of the same node first. */
+      for (unsigned pass = 0; pass < (worker ? 2 : 1); pass++) {
+         for (unsigned i = 0; i < pool.num_workers; i++) {
+            struct pool_worker *victim =
+               &pool.workers[(start + i) % pool.num_workers];
+
+            if (victim == worker ||
+                (worker && (victim->node == worker->node) == pass))
+               continue;
+            task = pool_worker_take(victim, priority, queue, false);
+            if (task)
+               return task;
+         }
+      }
+   }
+   return NULL;
+}
+
+static void
+pool_add_task(struct pool_worker *worker, struct util_queue *queue)
+{
+   if (!worker) {
+      worker = &pool.workers[p_atomic_inc_return(&pool.next_worker) %
+                             pool.num_workers];
+   }
+
+   mtx_lock(&worker->lock);
+   /* Without the memory to grow the deque, run the job right away. */
+   if (!pool_deque_push(&worker->deques[queue->priority], queue)) {
+      mtx_unlock(&worker->lock);
+      pool_run_task(pool_current, queue);
+      return;
+   }
+   mtx_unlock(&worker->lock);
+   p_atomic_inc(&pool.num_pending[queue->priority]);
+
+   if (p_atomic_read(&pool.num_sleeping)) {
+      mtx_lock(&pool.sleep_lock);
+      cnd_signal(&pool.wake_cond);
+      mtx_unlock(&pool.sleep_lock);
+   }
+}
+
+static void
+pool_run_task(struct pool_worker *worker, struct util_queue *queue)
+{
+   struct util_queue_job job;
+   unsigned thread_index;
+   bool again;
+
+   mtx_lock(&queue->lock);
+   /* Drop the tasks beyond num_threads, which is 0 once the queue is
+    * being destroyed.
+    */
+   if (queue->num_queued == 0 || queue->num_tasks > queue->num_threads) {
+      queue->num_tasks--;
+      if (queue->num_waiters)
+         cnd_broadcast(&queue->idle_cond);
+      mtx_unlock(&queue->lock);
+      return;
+   }
+
+   /* There are no more running tasks than num_tasks <= max_threads. */
+   for (thread_index = 0; queue->running[thread_index] != INT64_MAX;
+        thread_index++)
+      ;
+   queue->running[thread_index] = queue->num_started++;
+
+   job = queue->jobs[queue->read_idx];
+   memset(&queue->jobs[queue->read_idx], 0, sizeof(struct util_queue_job));
+   queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
+   queue->num_queued--;
+   cnd_signal(&queue->has_space_cond);
+   mtx_unlock(&queue->lock);
+
+   if (job.job) {
+      job.execute(job.job, thread_index);
+      util_queue_fence_signal(job.fence);
+      if (job.cleanup)
+         job.cleanup(job.job, thread_index);
+   }
+
+   mtx_lock(&queue->lock);
+   queue->running[thread_index] = INT64_MAX;
+   again = queue->num_queued && queue->num_tasks <= queue->num_threads;
+   if (!again)
+      queue->num_tasks--;
+   mtx_unlock(&queue->lock);
+
+   /* Add the task back before the waiters look for it. */
+   if (again)
+      pool_add_task(worker, queue);
+
+   mtx_lock(&queue->lock);
+   if (queue->num_waiters)
+      cnd_broadcast(&queue->idle_cond);
+   mtx_unlock(&queue->lock);
+}
+
+static int
+pool_worker_func(void *input)
+{
+   struct pool_worker *worker = (struct pool_worker *) input;
+   char name[16];
+
+   pool_current = worker;
+
+#ifdef _WIN32
+   if (pool.SetThreadGroupAffinity) {
+      pool.SetThreadGroupAffinity(GetCurrentThread(),
+                                  &pool.nodes[worker->node], NULL);
+   }
+#elif defined(HAVE_PTHREAD_SETAFFINITY)
+   {
+      /* Don't inherit the thread affinity from the parent thread. */
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for (unsigned i = 0; i < CPU_SETSIZE; i++)
+         CPU_SET(i, &cpuset);
+
+      pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+   }
+#endif
+
+   util_snprintf(name, sizeof(name), "pool%u", worker->index);
+   u_thread_setname(name);
+
+   while (1) {
+      struct util_queue *task = pool_get_task(worker, NULL);
+
+      if (task) {
+         pool_run_task(worker, task);
+         continue;
+      }
+
+      mtx_lock(&pool.sleep_lock);
+      p_atomic_inc(&pool.num_sleeping);
+      if (!p_atomic_read(&pool.num_pending[POOL_PRIORITY_LOW]) &&
+          !p_atomic_read(&pool.num_pending[POOL_PRIORITY_NORMAL]) &&
+          !p_atomic_read(&pool.num_pending[POOL_PRIORITY_HIGH]))
+         cnd_wait(&pool.wake_cond, &pool.sleep_lock);
+      p_atomic_dec(&pool.num_sleeping);
+      mtx_unlock(&pool.sleep_lock);
+   }
+
+   return 0;
+}
+
+/* The number of workers for each NUMA node, one per processor */
+static unsigned
+pool_get_topology(unsigned *node_workers)
+{
+#ifdef _WIN32
+   HMODULE kernel32 = GetModuleHandleA("kernel32.dll");
+   PFNGETNUMAHIGHESTNODENUMBER GetNumaHighestNodeNumber_ =
+      (PFNGETNUMAHIGHESTNODENUMBER)
+      GetProcAddress(kernel32, "GetNumaHighestNodeNumber");
+   PFNGETNUMANODEPROCESSORMASKEX GetNumaNodeProcessorMaskEx_ =
+      (PFNGETNUMANODEPROCESSORMASKEX)
+      GetProcAddress(kernel32, "GetNumaNodeProcessorMaskEx");
+   ULONG highest;
+   unsigned num_nodes = 0;
+
+   pool.SetThreadGroupAffinity = (PFNSETTHREADGROUPAFFINITY)
+      GetProcAddress(kernel32, "SetThreadGroupAffinity");
+
+   /* Windows 7 and later, which know about processor groups */
+   if (GetNumaHighestNodeNumber_ && GetNumaNodeProcessorMaskEx_ &&
+       pool.SetThreadGroupAffinity && GetNumaHighestNodeNumber_(&highest)) {
+      for (ULONG node = 0; node <= highest && num_nodes < POOL_MAX_NODES;
+           node++) {
+         struct pool_group_affinity *affinity = &pool.nodes[num_nodes];
+         ULONG_PTR mask;
+         unsigned count = 0;
+
+         if (!GetNumaNodeProcessorMaskEx_((USHORT) node, affinity))
+            continue;
+         for (mask = affinity->Mask; mask; mask &= mask - 1)
+            count++;
+         if (count)
+            node_workers[num_nodes++] = count;
+      }
+   }
+   if (num_nodes)
+      return num_nodes;
+   pool.SetThreadGroupAffinity = NULL;
+#endif
+
+   util_cpu_detect();
+   node_workers[0] = MAX2(util_cpu_caps.nr_cpus, 1);
+   return 1;
+}
+
+static void
+pool_init(void)
+{
+   unsigned node_workers[POOL_MAX_NODES];
+   unsigned num_nodes = pool_get_topology(node_workers);
+   unsigned num_workers = 0;
+
+   for (unsigned node = 0; node < num_nodes; node++)
+      num_workers += node_workers[node];
+   num_workers = MIN2(num_workers, POOL_MAX_WORKERS);
+
+   (void) mtx_init(&pool.sleep_lock, mtx_plain);
+   cnd_init(&pool.wake_cond);
+
+   pool.workers = (struct pool_worker *)
+                  calloc(num_workers, sizeof(struct pool_worker));
+   if (!pool.workers)
+      return;
+
+   for (unsigned node = 0, i = 0; node < num_nodes; node++) {
+      for (unsigned j = 0; j < node_workers[node] && i < num_workers;
+           j++, i++) {
+         pool.workers[i].index = i;
+         pool.workers[i].node = node;
+         (void) mtx_init(&pool.workers[i].lock, mtx_plain);
+      }
+   }
+
+   /* The workers look at num_workers when they steal, so they are all set
+    * up first.  They live as long as the process.
+    */
+   pool.num_workers = num_workers;
+   for (unsigned i = 0; i < num_workers; i++) {
+      pool.workers[i].thread = u_thread_create(pool_worker_func,
+                                               &pool.workers[i]);
+      if (!pool.workers[i].thread) {
+         if (i == 0)
+            pool.num_workers = 0;
+         break;
+      }
+   }
+}
+
+/* Whether the jobs numbered below num_jobs are done */
+static bool
+pool_queue_done(struct util_queue *queue, int64_t num_jobs)
+{
+   if (queue->num_started < num_jobs)
+      return false;
+   for (unsigned i = 0; i < queue->max_threads; i++) {
+      if (queue->running[i] < num_jobs)
+         return false;
+   }
+   return true;
+}
+
+/* Wait, with the queue locked, for the jobs numbered below num_jobs, or
+ * for the tasks of the queue to be gone if num_jobs is negative.
+ *
+ * A worker waiting for a queue runs the tasks of any queue in the
+ * meantime, so that the jobs waited for are not left without workers to
+ * run them; other threads help with the jobs of the queue.
+ */
+static void
+pool_queue_wait(struct util_queue *queue, int64_t num_jobs)
+{
+   struct pool_worker *worker = pool_current;
+   int64_t deadline = exiting ? os_time_get_nano() + 1000000000ll : 0;
+
+   queue->num_waiters++;
+   while (num_jobs < 0 ? queue->num_tasks > 0 :
+          !pool_queue_done(queue, num_jobs)) {
+      struct util_queue *task;
+
+      mtx_unlock(&queue->lock);
+      task = pool_get_task(worker, worker ? NULL : queue);
+      if (task)
+         pool_run_task(worker, task);
+      mtx_lock(&queue->lock);
+      if (task)
+         continue;
+
+      if (num_jobs < 0 ? queue->num_tasks == 0 :
+          pool_queue_done(queue, num_jobs))
+         break;
+
+      if (exiting) {
+         /* The workers are killed before the atexit handlers of a DLL
+          * run, so don't wait for them forever.
+          */
+         struct timespec ts;
+
+         if (os_time_get_nano() > deadline)
+            break;
+         timespec_get(&ts, TIME_UTC);
+         ts.tv_nsec += 10000000;
+         if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+         }
+         cnd_timedwait(&queue->idle_cond, &queue->lock, &ts);
+      } else {
+         cnd_wait(&queue->idle_cond, &queue->lock);
+      }
+   }
+   queue->num_waiters--;
+}
+
 /****************************************************************************
  * util_queue implementation
  */
@@ -350,6 +827,24 @@ util_queue_adjust_num_threads(struct util_queue *queue, unsigned num_threads)
    mtx_lock(&queue->finish_lock);
    unsigned old_num_threads = queue->num_threads;
 
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED_POOL) {
+      unsigned num_tasks = 0;
+
+      /* The tasks beyond num_threads go when they are next run. */
+      mtx_lock(&queue->lock);
+      queue->num_threads = num_threads;
+      while (queue->num_tasks < MIN2(num_threads, queue->num_queued)) {
+         queue->num_tasks++;
+         num_tasks++;
+      }
+      mtx_unlock(&queue->lock);
+
+      while (num_tasks--)
+         pool_add_task(pool_current, queue);
+      mtx_unlock(&queue->finish_lock);
+      return;
+   }
+
    if (num_threads == old_num_threads) {
       mtx_unlock(&queue->finish_lock);
       return;
@@ -411,6 +906,12 @@ util_queue_init(struct util_queue *queue,
       util_snprintf(queue->name, sizeof(queue->name), "%s", name);
    }
 
+   if (flags & UTIL_QUEUE_INIT_SHARED_POOL) {
+      call_once(&pool_once_flag, pool_init);
+      if (!pool.num_workers)
+         flags &= ~UTIL_QUEUE_INIT_SHARED_POOL;
+   }
+
    queue->flags = flags;
    queue->max_threads = num_threads;
    queue->num_threads = num_threads;
@@ -427,6 +928,25 @@ util_queue_init(struct util_queue *queue,
    queue->num_queued = 0;
    cnd_init(&queue->has_queued_cond);
    cnd_init(&queue->has_space_cond);
+   cnd_init(&queue->idle_cond);
+
+   if (flags & UTIL_QUEUE_INIT_SHARED_POOL) {
+      if (flags & UTIL_QUEUE_INIT_HIGH_PRIORITY)
+         queue->priority = POOL_PRIORITY_HIGH;
+      else if (flags & UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY)
+         queue->priority = POOL_PRIORITY_LOW;
+      else
+         queue->priority = POOL_PRIORITY_NORMAL;
+
+      queue->running = (int64_t*) malloc(num_threads * sizeof(int64_t));
+      if (!queue->running)
+         goto fail;
+      for (i = 0; i < num_threads; i++)
+         queue->running[i] = INT64_MAX;
+
+      add_to_atexit_list(queue);
+      return true;
+   }
 
    queue->threads = (thrd_t*) calloc(num_threads, sizeof(thrd_t));
    if (!queue->threads)
@@ -451,8 +971,10 @@ util_queue_init(struct util_queue *queue,
 
 fail:
    free(queue->threads);
+   free(queue->running);
 
    if (queue->jobs) {
+      cnd_destroy(&queue->idle_cond);
       cnd_destroy(&queue->has_space_cond);
       cnd_destroy(&queue->has_queued_cond);
       mtx_destroy(&queue->lock);
@@ -478,6 +1000,30 @@ util_queue_kill_threads(struct util_queue *queue, unsigned keep_num_threads,
       return;
    }
 
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED_POOL) {
+      mtx_lock(&queue->lock);
+      queue->num_threads = keep_num_threads;
+      if (keep_num_threads == 0) {
+         /* The tasks left go without running more jobs. */
+         pool_queue_wait(queue, -1);
+
+         for (unsigned i = queue->read_idx; i != queue->write_idx;
+              i = (i + 1) % queue->max_jobs) {
+            if (queue->jobs[i].job) {
+               util_queue_fence_signal(queue->jobs[i].fence);
+               queue->jobs[i].job = NULL;
+            }
+         }
+         queue->read_idx = queue->write_idx;
+         queue->num_queued = 0;
+      }
+      mtx_unlock(&queue->lock);
+
+      if (!finish_locked)
+         mtx_unlock(&queue->finish_lock);
+      return;
+   }
+
    mtx_lock(&queue->lock);
    unsigned old_num_threads = queue->num_threads;
    /* Setting num_threads is what causes the threads to terminate.
@@ -500,12 +1046,14 @@ util_queue_destroy(struct util_queue *queue)
    util_queue_kill_threads(queue, 0, false);
    remove_from_atexit_list(queue);
 
+   cnd_destroy(&queue->idle_cond);
    cnd_destroy(&queue->has_space_cond);
    cnd_destroy(&queue->has_queued_cond);
    mtx_destroy(&queue->finish_lock);
    mtx_destroy(&queue->lock);
    free(queue->jobs);
    free(queue->threads);
+   free(queue->running);
 }
 
 void
@@ -516,6 +1064,7 @@ util_queue_add_job(struct util_queue *queue,
                    util_queue_execute_func cleanup)
 {
    struct util_queue_job *ptr;
+   bool add_task = false;
 
    mtx_lock(&queue->lock);
    if (queue->num_threads == 0) {
@@ -573,8 +1122,19 @@ util_queue_add_job(struct util_queue *queue,
    queue->write_idx = (queue->write_idx + 1) % queue->max_jobs;
 
    queue->num_queued++;
-   cnd_signal(&queue->has_queued_cond);
+   queue->num_added++;
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED_POOL) {
+      if (queue->num_tasks < MIN2(queue->num_threads, queue->num_queued)) {
+         queue->num_tasks++;
+         add_task = true;
+      }
+   } else {
+      cnd_signal(&queue->has_queued_cond);
+   }
    mtx_unlock(&queue->lock);
+
+   if (add_task)
+      pool_add_task(pool_current, queue);
 }
 
 /**
@@ -632,6 +1192,16 @@ util_queue_finish(struct util_queue *queue)
    util_barrier barrier;
    struct util_queue_fence *fences;
 
+   /* The jobs may not all have workers at the same time to wait at a
+    * barrier, so count them instead.
+    */
+   if (queue->flags & UTIL_QUEUE_INIT_SHARED_POOL) {
+      mtx_lock(&queue->lock);
+      pool_queue_wait(queue, queue->num_added);
+      mtx_unlock(&queue->lock);
+      return;
+   }
+
    /* If 2 threads were adding jobs for 2 different barries at the same time,
     * a deadlock would happen, because 1 barrier requires that all threads
     * wait for it exclusively.
@@ -660,7 +1230,7 @@ int64_t
 util_queue_get_thread_time_nano(struct util_queue *queue, unsigned thread_index)
 {
    /* Allow some flexibility by not raising an error. */
-   if (thread_index >= queue->num_threads)
+   if (!queue->threads || thread_index >= queue->num_threads)
       return 0;
 
    return u_thread_get_time_nano(queue->threads[thread_index]);
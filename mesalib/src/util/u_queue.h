@@ -28,6 +28,11 @@
  *
  * Jobs can be added from any thread. After that, the wait call can be used
  * to wait for completion of the job.
+ *
+ * With UTIL_QUEUE_INIT_SHARED_POOL the jobs are run by a pool of workers
+ * shared by all such queues of the process, one per processor, so that
+ * queues busy at the same time do not start more threads than there are
+ * processors between them.
  */
 
 #ifndef U_QUEUE_H
@@ -49,6 +54,8 @@ extern "C" {
 #define UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY      (1 << 0)
 #define UTIL_QUEUE_INIT_RESIZE_IF_FULL            (1 << 1)
 #define UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY  (1 << 2)
+#define UTIL_QUEUE_INIT_SHARED_POOL               (1 << 3)
+#define UTIL_QUEUE_INIT_HIGH_PRIORITY             (1 << 4)
 
 #if defined(__GNUC__) && defined(HAVE_LINUX_FUTEX_H)
 #define UTIL_QUEUE_FENCE_FUTEX
@@ -216,6 +223,18 @@ struct util_queue {
 
    /* for cleanup at exit(), protected by exit_mutex */
    struct list_head head;
+
+   /* Queues created with UTIL_QUEUE_INIT_SHARED_POOL have no threads of
+    * their own.  Their jobs are run by the process-wide pool, by at most
+    * num_threads workers at a time, each given one of num_threads thread
+    * indices.
+    */
+   unsigned priority;
+   unsigned num_tasks; /* tasks of the queue in the pool or running */
+   unsigned num_waiters; /* threads waiting for idle_cond */
+   cnd_t idle_cond;
+   int64_t num_added, num_started; /* jobs, also numbering them */
+   int64_t *running; /* job run with each thread index, or INT64_MAX */
 };
 
 bool util_queue_init(struct util_queue *queue,
@@ -250,7 +269,7 @@ int64_t util_queue_get_thread_time_nano(struct util_queue *queue,
 static inline bool
 util_queue_is_initialized(struct util_queue *queue)
 {
-   return queue->threads != NULL;
+   return queue->jobs != NULL;
 }
 
 /* Convenient structure for monitoring the queue externally and passing
@@ -57,6 +57,10 @@
 #include "data.h"
 #include "ident.h"
 
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#endif
+
 #define NPREFIX 1024
 
 #ifndef MAXFONTFILENAMELEN
@@ -108,6 +112,15 @@ static int readFontScale(HashTablePtr entries, char *dirname);
 ListPtr makeXLFD(char *filename, FT_Face face, int);
 static int readEncodings(ListPtr encodings, char *dirname);
 
+/* The encodings looked up so far, and NULL for those which do not exist */
+typedef struct _EncodingCache {
+    const char *name;
+    FontEncPtr encoding;
+    struct _EncodingCache *next;
+} EncodingCacheRec, *EncodingCachePtr;
+
+static EncodingCachePtr encodingCache;
+
 static FT_Library ft_library;
 static float bigEncodingFuzz = 0.02;
 
@@ -779,15 +792,29 @@ filePrio(char *filename)
     return 0;
 }
 
+/* Put temp in place of name in one step, so that nobody reading name
+   finds it missing or half written */
+static int
+replaceFile(const char *temp, const char *name)
+{
+#ifdef WIN32
+    if(MoveFileExA(temp, name, MOVEFILE_REPLACE_EXISTING))
+        return 0;
+    unlink(name);
+#endif
+    return rename(temp, name);
+}
+
 static int
 doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
 {
-    char *dirname, *fontscale_name, *filename, *encdir;
+    char *dirname, *fontscale_name, *fontscale_temp = NULL, *filename;
+    char *encdir, *encdir_temp;
     FILE *fontscale, *encfile;
     struct dirent** namelist;
     FT_Error ftrc;
     FT_Face face;
-    ConstListPtr encoding;
+    ConstListPtr encoding, matched = NULL;
     ListPtr xlfd, lp;
     HashTablePtr entries;
     HashBucketPtr *array;
@@ -841,11 +868,17 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
 
     if(fontscale_name == NULL)
         fontscale = stdout;
-    else
-        fontscale = fopen(fontscale_name, "wb");
+    else {
+        fontscale_temp = dsprintf("%s.tmp", fontscale_name);
+        if(fontscale_temp == NULL) {
+            perror("fontscale_name");
+            exit(1);
+        }
+        fontscale = fopen(fontscale_temp, "wb");
+    }
 
     if(fontscale == NULL) {
-        fprintf(stderr, "%s: ", fontscale_name);
+        fprintf(stderr, "%s: ", fontscale_temp);
         perror("fopen(w)");
         return 0;
     }
@@ -970,26 +1003,30 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
         if(xlfd == NULL)
             xlfd = makeXLFD(entry->d_name, face, isBitmap);
 
+        /* Which encodings the face covers does not depend on the XLFD,
+           so check them once for all of its names */
         found = 0;
 
+        for(encoding = encodings; encoding; encoding = encoding->next) {
+            if(checkEncoding(face, encoding->value)) {
+                found = 1;
+                matched = makeConstList(&encoding->value, 1, matched, 0);
+            }
+        }
+        for(encoding = extra_encodings; encoding;
+            encoding = encoding->next) {
+            if(checkExtraEncoding(face, encoding->value, found)) {
+                /* Do not set found! */
+                matched = makeConstList(&encoding->value, 1, matched, 0);
+            }
+        }
+
         for(lp = xlfd; lp; lp = lp->next) {
             char buf[MAXFONTNAMELEN];
-            for(encoding = encodings; encoding; encoding = encoding->next) {
-                if(checkEncoding(face, encoding->value)) {
-                    found = 1;
-                    snprintf(buf, MAXFONTNAMELEN, "%s-%s",
-                            lp->value, encoding->value);
-                    putHash(entries, buf, entry->d_name, PRIO(filePrio(entry->d_name)));
-                }
-            }
-            for(encoding = extra_encodings; encoding;
-                encoding = encoding->next) {
-                if(checkExtraEncoding(face, encoding->value, found)) {
-                    /* Do not set found! */
-                    snprintf(buf, MAXFONTNAMELEN, "%s-%s",
-                            lp->value, encoding->value);
-                    putHash(entries, buf, entry->d_name, PRIO(filePrio(entry->d_name)));
-                }
+            for(encoding = matched; encoding; encoding = encoding->next) {
+                snprintf(buf, MAXFONTNAMELEN, "%s-%s",
+                        lp->value, encoding->value);
+                putHash(entries, buf, entry->d_name, PRIO(filePrio(entry->d_name)));
             }
         }
     done:
@@ -997,6 +1034,8 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
             FT_Done_Face(face);
         deepDestroyList(xlfd);
         xlfd = NULL;
+        destroyConstList(matched);
+        matched = NULL;
         free(filename);
 #undef PRIO
     }
@@ -1012,7 +1051,13 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
     destroyHashArray(array);
     entries = NULL;
     if(fontscale_name) {
-        fclose(fontscale);
+        if(fclose(fontscale) != 0 ||
+           replaceFile(fontscale_temp, fontscale_name) != 0) {
+            fprintf(stderr, "%s: ", fontscale_name);
+            perror("write");
+            unlink(fontscale_temp);
+        }
+        free(fontscale_temp);
         free(fontscale_name);
     }
 
@@ -1023,10 +1068,14 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
 	perror("encodings");
 	exit(1);
     }
-    unlink(encdir);
 
     if (numEncodings) {
-	encfile = fopen(encdir, "w");
+	encdir_temp = dsprintf("%s.tmp", encdir);
+	if(encdir_temp == NULL) {
+	    perror("encodings");
+	    exit(1);
+	}
+	encfile = fopen(encdir_temp, "w");
 	if(encfile == NULL) {
 	    perror("open(encodings.dir)");
 	    exit(1);
@@ -1036,13 +1085,41 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
         for(lp = encodingsToDo; lp; lp = lp->next) {
             fprintf(encfile, "%s\n", lp->value);
         }
-	fclose (encfile);
-    }
+	if(fclose(encfile) != 0 || replaceFile(encdir_temp, encdir) != 0) {
+	    perror("write(encodings.dir)");
+	    unlink(encdir_temp);
+	    exit(1);
+	}
+	free(encdir_temp);
+    } else
+	unlink(encdir);
+    free(encdir);
 
     free(dirname);
     return 1;
 }
 
+/* FontEncFind() reads encodings.dir again each time it is asked for an
+   encoding it does not have, so remember what it said for every font */
+static FontEncPtr
+findEncoding(const char *encoding_name)
+{
+    EncodingCachePtr ec;
+
+    for(ec = encodingCache; ec; ec = ec->next)
+        if(strcmp(ec->name, encoding_name) == 0)
+            return ec->encoding;
+
+    ec = malloc(sizeof(EncodingCacheRec));
+    if(ec == NULL)
+        return FontEncFind(encoding_name, NULL);
+    ec->name = encoding_name;
+    ec->encoding = FontEncFind(encoding_name, NULL);
+    ec->next = encodingCache;
+    encodingCache = ec;
+    return ec->encoding;
+}
+
 #define CODE_IGNORED(c) ((c) < 0x20 || \
                          ((c) >= 0x7F && (c) <= 0xA0) || \
                          (c) == 0xAD || (c) == 0xF71B)
@@ -1055,7 +1132,7 @@ checkEncoding(FT_Face face, const char *encoding_name)
     int i, j, c, koi8;
     char *n;
 
-    encoding = FontEncFind(encoding_name, NULL);
+    encoding = findEncoding(encoding_name);
     if(!encoding)
         return 0;
 
@@ -0,0 +1,937 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <immintrin.h>
+#include "pixman-private.h"
+#include "pixman-combine32.h"
+#include "pixman-inlines.h"
+
+/* This tier only replaces the hottest paths; everything else falls
+ * through to the SSSE3 / SSE2 implementations below it in the chain.
+ */
+
+static force_inline __m256i
+load_256_unaligned (const void *p)
+{
+    return _mm256_loadu_si256 ((const __m256i *)p);
+}
+
+static force_inline void
+save_256_unaligned (void *p, __m256i data)
+{
+    _mm256_storeu_si256 ((__m256i *)p, data);
+}
+
+static force_inline int
+is_opaque_256 (__m256i x)
+{
+    __m256i ffs = _mm256_cmpeq_epi8 (x, x);
+
+    return (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (x, ffs)) & 0x88888888)
+	== 0x88888888;
+}
+
+static force_inline int
+is_zero_256 (__m256i x)
+{
+    return _mm256_testz_si256 (x, x);
+}
+
+/* Multiply the unpacked 16 bit channels and divide by 255 with rounding,
+ * the same way MUL_UN8 does.
+ */
+static force_inline __m256i
+pix_multiply_256 (__m256i data, __m256i alpha)
+{
+    __m256i t = _mm256_adds_epu16 (_mm256_mullo_epi16 (data, alpha),
+				   _mm256_set1_epi16 (0x0080));
+
+    return _mm256_mulhi_epu16 (t, _mm256_set1_epi16 (0x0101));
+}
+
+static force_inline __m256i
+expand_alpha_256 (__m256i data)
+{
+    data = _mm256_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3));
+    return _mm256_shufflehi_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3));
+}
+
+/* src * mask.alpha, eight pixels at a time */
+static force_inline __m256i
+in_mask_256 (__m256i src, __m256i mask)
+{
+    __m256i zero = _mm256_setzero_si256 ();
+    __m256i lo, hi;
+
+    lo = pix_multiply_256 (_mm256_unpacklo_epi8 (src, zero),
+			   expand_alpha_256 (_mm256_unpacklo_epi8 (mask, zero)));
+    hi = pix_multiply_256 (_mm256_unpackhi_epi8 (src, zero),
+			   expand_alpha_256 (_mm256_unpackhi_epi8 (mask, zero)));
+
+    return _mm256_packus_epi16 (lo, hi);
+}
+
+/* src + dst * (1 - src.alpha), eight pixels at a time */
+static force_inline __m256i
+over_256 (__m256i src, __m256i dst)
+{
+    __m256i zero = _mm256_setzero_si256 ();
+    __m256i ia = _mm256_xor_si256 (src, _mm256_cmpeq_epi8 (src, src));
+    __m256i lo, hi;
+
+    lo = pix_multiply_256 (_mm256_unpacklo_epi8 (dst, zero),
+			   expand_alpha_256 (_mm256_unpacklo_epi8 (ia, zero)));
+    hi = pix_multiply_256 (_mm256_unpackhi_epi8 (dst, zero),
+			   expand_alpha_256 (_mm256_unpackhi_epi8 (ia, zero)));
+
+    return _mm256_adds_epu8 (src, _mm256_packus_epi16 (lo, hi));
+}
+
+static force_inline uint32_t
+combine1 (const uint32_t *ps, const uint32_t *pm)
+{
+    uint32_t s = *ps;
+
+    if (pm)
+    {
+	uint32_t m = ALPHA_8 (*pm);
+
+	UN8x4_MUL_UN8 (s, m);
+    }
+
+    return s;
+}
+
+static force_inline uint32_t
+over_pixel (uint32_t s, uint32_t d)
+{
+    uint32_t ia = ALPHA_8 (~s);
+
+    UN8x4_MUL_UN8_ADD_UN8x4 (d, ia, s);
+
+    return d;
+}
+
+static void
+avx2_combine_over_u (pixman_implementation_t *imp,
+                     pixman_op_t              op,
+                     uint32_t *               pd,
+                     const uint32_t *         ps,
+                     const uint32_t *         pm,
+                     int                      w)
+{
+    while (w >= 8)
+    {
+	__m256i src = load_256_unaligned (ps);
+
+	if (pm)
+	{
+	    __m256i mask = load_256_unaligned (pm);
+
+	    if (is_zero_256 (mask))
+		goto next;
+
+	    if (!is_opaque_256 (mask))
+		src = in_mask_256 (src, mask);
+	}
+
+	if (is_opaque_256 (src))
+	    save_256_unaligned (pd, src);
+	else if (!is_zero_256 (src))
+	    save_256_unaligned (pd, over_256 (src, load_256_unaligned (pd)));
+
+    next:
+	ps += 8;
+	pd += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w--)
+    {
+	uint32_t s = combine1 (ps, pm);
+
+	if (s >= 0xff000000)
+	    *pd = s;
+	else if (s)
+	    *pd = over_pixel (s, *pd);
+
+	ps++;
+	pd++;
+	if (pm)
+	    pm++;
+    }
+}
+
+static void
+avx2_combine_add_u (pixman_implementation_t *imp,
+                    pixman_op_t              op,
+                    uint32_t *               pd,
+                    const uint32_t *         ps,
+                    const uint32_t *         pm,
+                    int                      w)
+{
+    while (w >= 8)
+    {
+	__m256i src = load_256_unaligned (ps);
+
+	if (pm)
+	    src = in_mask_256 (src, load_256_unaligned (pm));
+
+	save_256_unaligned (
+	    pd, _mm256_adds_epu8 (src, load_256_unaligned (pd)));
+
+	ps += 8;
+	pd += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w--)
+    {
+	uint32_t s = combine1 (ps, pm);
+	uint32_t d = *pd;
+
+	UN8x4_ADD_UN8x4 (d, s);
+	*pd = d;
+
+	ps++;
+	pd++;
+	if (pm)
+	    pm++;
+    }
+}
+
+static void
+avx2_composite_over_8888_8888 (pixman_implementation_t *imp,
+                               pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	avx2_combine_over_u (imp, op, dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_src_x888_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+    int32_t w;
+    int dst_stride, src_stride;
+    __m256i mask_ff000000 = _mm256_set1_epi32 (0xff000000);
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w >= 32)
+	{
+	    __m256i s0 = load_256_unaligned (src + 0);
+	    __m256i s1 = load_256_unaligned (src + 8);
+	    __m256i s2 = load_256_unaligned (src + 16);
+	    __m256i s3 = load_256_unaligned (src + 24);
+
+	    save_256_unaligned (dst + 0, _mm256_or_si256 (s0, mask_ff000000));
+	    save_256_unaligned (dst + 8, _mm256_or_si256 (s1, mask_ff000000));
+	    save_256_unaligned (dst + 16, _mm256_or_si256 (s2, mask_ff000000));
+	    save_256_unaligned (dst + 24, _mm256_or_si256 (s3, mask_ff000000));
+
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	while (w >= 8)
+	{
+	    save_256_unaligned (
+		dst, _mm256_or_si256 (load_256_unaligned (src), mask_ff000000));
+
+	    dst += 8;
+	    src += 8;
+	    w -= 8;
+	}
+
+	while (w)
+	{
+	    *dst++ = *src++ | 0xff000000;
+	    w--;
+	}
+    }
+}
+
+static void
+avx2_composite_add_8_8 (pixman_implementation_t *imp,
+			pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst_line, *dst;
+    uint8_t     *src_line, *src;
+    int dst_stride, src_stride;
+    int32_t w;
+    uint16_t t;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint8_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	src = src_line;
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+	w = width;
+
+	while (w >= 32)
+	{
+	    save_256_unaligned (
+		dst, _mm256_adds_epu8 (load_256_unaligned (src),
+				       load_256_unaligned (dst)));
+
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	while (w)
+	{
+	    t = (*dst) + (*src++);
+	    *dst++ = t | (0 - (t >> 8));
+	    w--;
+	}
+    }
+}
+
+static void
+avx2_composite_add_8888_8888 (pixman_implementation_t *imp,
+                              pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	avx2_combine_add_u (imp, op, dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+/* Bilinear cover fetcher.  This is the SSSE3 one with both passes
+ * doubled up: each 128 bit lane of the horizontal pass interpolates a
+ * pair of pixels exactly like pixman-ssse3.c does, and the vertical
+ * pass blends four intermediate pixels per lane.
+ */
+typedef struct
+{
+    int		y;
+    uint64_t *	buffer;
+} line_t;
+
+typedef struct
+{
+    line_t		lines[2];
+    pixman_fixed_t	y;
+    pixman_fixed_t	x;
+    uint64_t		data[1];
+} bilinear_info_t;
+
+static force_inline __m128i
+bilinear_horizontal_128 (__m128i vrl0, __m128i vrl1, __m128i vw)
+{
+    __m128i vr, s;
+
+    vr = _mm_unpacklo_epi16 (vrl1, vrl0);
+    /* vr: rar0, rar1, rgb0, rgb1, lar0, lar1, lgb0, lgb1 */
+
+    s = _mm_shuffle_epi32 (vr, _MM_SHUFFLE (1, 0, 3, 2));
+    /* s:  lar0, lar1, lgb0, lgb1, rar0, rar1, rgb0, rgb1 */
+
+    vr = _mm_unpackhi_epi8 (vr, s);
+
+    /* See ssse3_fetch_horizontal for why the absolute value is taken */
+    return _mm_abs_epi16 (_mm_maddubs_epi16 (vr, vw));
+}
+
+static void
+avx2_fetch_horizontal (bits_image_t *image, line_t *line,
+		       int y, pixman_fixed_t x, pixman_fixed_t ux, int n)
+{
+    uint32_t *bits = image->bits + y * image->rowstride;
+    __m256i vx = _mm256_set_epi16 (
+	- (x + 2 * ux + 1), x + 2 * ux, - (x + 2 * ux + 1), x + 2 * ux,
+	- (x + 3 * ux + 1), x + 3 * ux, - (x + 3 * ux + 1), x + 3 * ux,
+	- (x + 1), x, - (x + 1), x,
+	- (x + ux + 1), x + ux,  - (x + ux + 1), x + ux);
+    __m256i vux = _mm256_set_epi16 (
+	- 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux,
+	- 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux);
+    __m256i vaddc = _mm256_set_epi16 (
+	1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0);
+    uint64_t *b = line->buffer;
+    __m128i vw, vrl0, vrl1;
+
+    while (n >= 4)
+    {
+	__m256i vw256, vr, s, v0, v1;
+
+	v0 = _mm256_inserti128_si256 (
+	    _mm256_castsi128_si256 (_mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x)))),
+	    _mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x + 2 * ux))), 1);
+	v1 = _mm256_inserti128_si256 (
+	    _mm256_castsi128_si256 (_mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x + ux)))),
+	    _mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x + 3 * ux))), 1);
+
+	vw256 = _mm256_add_epi16 (
+	    vaddc, _mm256_srli_epi16 (vx, 16 - BILINEAR_INTERPOLATION_BITS));
+	vw256 = _mm256_packus_epi16 (vw256, vw256);
+	vx = _mm256_add_epi16 (vx, vux);
+
+	x += 4 * ux;
+
+	vr = _mm256_unpacklo_epi16 (v1, v0);
+	s = _mm256_shuffle_epi32 (vr, _MM_SHUFFLE (1, 0, 3, 2));
+	vr = _mm256_unpackhi_epi8 (vr, s);
+	vr = _mm256_abs_epi16 (_mm256_maddubs_epi16 (vr, vw256));
+
+	_mm256_store_si256 ((__m256i *)b, vr);
+	b += 4;
+	n -= 4;
+    }
+
+    /* The last one to three pixels are done two at a time in one lane,
+     * with the weights for x and x + ux in the low half of vx.
+     */
+    while (n > 0)
+    {
+	__m128i vx128 = _mm256_castsi256_si128 (vx);
+
+	vrl0 = _mm_loadl_epi64 ((__m128i *)(bits + pixman_fixed_to_int (x)));
+	if (n > 1)
+	    vrl1 = _mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x + ux)));
+	else
+	    vrl1 = _mm_setzero_si128 ();
+
+	vw = _mm_add_epi16 (
+	    _mm256_castsi256_si128 (vaddc),
+	    _mm_srli_epi16 (vx128, 16 - BILINEAR_INTERPOLATION_BITS));
+	vw = _mm_packus_epi16 (vw, vw);
+
+	/* Move the upper lane weights (x + 2ux, x + 3ux) down */
+	vx = _mm256_permute2x128_si256 (vx, vx, 0x01);
+	x += 2 * ux;
+
+	_mm_store_si128 ((__m128i *)b, bilinear_horizontal_128 (vrl0, vrl1, vw));
+	b += 2;
+	n -= 2;
+    }
+
+    line->y = y;
+}
+
+static force_inline __m256i
+bilinear_vertical_256 (__m256i top, __m256i bot, __m256i vw)
+{
+    __m256i r, tmp;
+
+    r = _mm256_mulhi_epu16 (_mm256_sub_epi16 (bot, top), vw);
+    tmp = _mm256_and_si256 (_mm256_cmpgt_epi16 (top, bot), vw);
+    r = _mm256_sub_epi16 (r, tmp);
+    r = _mm256_add_epi16 (r, top);
+    r = _mm256_srli_epi16 (r, BILINEAR_INTERPOLATION_BITS);
+
+    /* r: A1 R1 G1 B1 A0 R0 G0 B0 in each lane */
+    return _mm256_shuffle_epi32 (r, _MM_SHUFFLE (2, 0, 3, 1));
+}
+
+static uint32_t *
+avx2_fetch_bilinear_cover (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_fixed_t fx, ux;
+    bilinear_info_t *info = iter->data;
+    line_t *line0, *line1;
+    int y0, y1;
+    int32_t dist_y;
+    __m256i vw;
+    int i;
+
+    fx = info->x;
+    ux = iter->image->common.transform->matrix[0][0];
+
+    y0 = pixman_fixed_to_int (info->y);
+    y1 = y0 + 1;
+
+    line0 = &info->lines[y0 & 0x01];
+    line1 = &info->lines[y1 & 0x01];
+
+    if (line0->y != y0)
+    {
+	avx2_fetch_horizontal (
+	    &iter->image->bits, line0, y0, fx, ux, iter->width);
+    }
+
+    if (line1->y != y1)
+    {
+	avx2_fetch_horizontal (
+	    &iter->image->bits, line1, y1, fx, ux, iter->width);
+    }
+
+    dist_y = pixman_fixed_to_bilinear_weight (info->y);
+    dist_y <<= (16 - BILINEAR_INTERPOLATION_BITS);
+
+    vw = _mm256_set1_epi16 (dist_y);
+
+    for (i = 0; i + 7 < iter->width; i += 8)
+    {
+	__m256i r0 = bilinear_vertical_256 (
+	    _mm256_load_si256 ((__m256i *)(line0->buffer + i)),
+	    _mm256_load_si256 ((__m256i *)(line1->buffer + i)), vw);
+	__m256i r1 = bilinear_vertical_256 (
+	    _mm256_load_si256 ((__m256i *)(line0->buffer + i + 4)),
+	    _mm256_load_si256 ((__m256i *)(line1->buffer + i + 4)), vw);
+	__m256i p;
+
+	/* The lane-wise pack leaves the pixels as 0 1 4 5 | 2 3 6 7 */
+	p = _mm256_packus_epi16 (r0, r1);
+	p = _mm256_permute4x64_epi64 (p, _MM_SHUFFLE (3, 1, 2, 0));
+
+	save_256_unaligned (iter->buffer + i, p);
+    }
+
+    while (i < iter->width)
+    {
+	__m128i top0 = _mm_load_si128 ((__m128i *)(line0->buffer + i));
+	__m128i bot0 = _mm_load_si128 ((__m128i *)(line1->buffer + i));
+	__m128i vw128 = _mm256_castsi256_si128 (vw);
+	__m128i r0, tmp, p;
+
+	r0 = _mm_mulhi_epu16 (
+	    _mm_sub_epi16 (bot0, top0), vw128);
+	tmp = _mm_cmplt_epi16 (bot0, top0);
+	tmp = _mm_and_si128 (tmp, vw128);
+	r0 = _mm_sub_epi16 (r0, tmp);
+	r0 = _mm_add_epi16 (r0, top0);
+	r0 = _mm_srli_epi16 (r0, BILINEAR_INTERPOLATION_BITS);
+	r0 = _mm_shuffle_epi32 (r0, _MM_SHUFFLE (2, 0, 3, 1));
+
+	p = _mm_packus_epi16 (r0, r0);
+
+	if (iter->width - i == 1)
+	{
+	    *(uint32_t *)(iter->buffer + i) = _mm_cvtsi128_si32 (p);
+	    i++;
+	}
+	else
+	{
+	    _mm_storel_epi64 ((__m128i *)(iter->buffer + i), p);
+	    i += 2;
+	}
+    }
+
+    info->y += iter->image->common.transform->matrix[1][1];
+
+    return iter->buffer;
+}
+
+static void
+avx2_bilinear_cover_iter_fini (pixman_iter_t *iter)
+{
+    free (iter->data);
+}
+
+static void
+avx2_bilinear_cover_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *iter_info)
+{
+    int width = iter->width;
+    bilinear_info_t *info;
+    pixman_vector_t v;
+
+    /* Reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (iter->image->common.transform, &v))
+	goto fail;
+
+    /* Each line is rounded up to an even number of entries and both
+     * are 32 byte aligned, hence the extra slack.
+     */
+    info = malloc (sizeof (*info) + (2 * width + 1) * sizeof (uint64_t) + 64);
+    if (!info)
+	goto fail;
+
+    info->x = v.vector[0] - pixman_fixed_1 / 2;
+    info->y = v.vector[1] - pixman_fixed_1 / 2;
+
+#define ALIGN(addr)							\
+    ((void *)((((uintptr_t)(addr)) + 31) & (~31)))
+
+    /* It is safe to set the y coordinates to -1 initially
+     * because COVER_CLIP_BILINEAR ensures that we will only
+     * be asked to fetch lines in the [0, height) interval
+     */
+    info->lines[0].y = -1;
+    info->lines[0].buffer = ALIGN (&(info->data[0]));
+    info->lines[1].y = -1;
+    info->lines[1].buffer = ALIGN (info->lines[0].buffer + width + 1);
+
+    iter->get_scanline = avx2_fetch_bilinear_cover;
+    iter->fini = avx2_bilinear_cover_iter_fini;
+
+    iter->data = info;
+    return;
+
+fail:
+    /* Something went wrong, either a bad matrix or OOM; in such cases,
+     * we don't guarantee any particular rendering.
+     */
+    _pixman_log_error (
+	FUNC, "Allocation failure or bad matrix, skipping rendering\n");
+
+    iter->get_scanline = _pixman_iter_get_scanline_noop;
+    iter->fini = NULL;
+}
+
+/* Separable convolution of 8888 images.  The sums are the same integer
+ * ones the C fetchers compute, four taps at a time, so the result matches
+ * them exactly.
+ */
+
+/* (fx * fy + 0x8000) >> 16 for four taps, each spread over the four
+ * channels of its pixel
+ */
+static force_inline void
+separable_weights (const pixman_fixed_t *x_params, __m256i fy,
+		   __m256i *f01, __m256i *f23)
+{
+    __m256i fx = _mm256_cvtepi32_epi64 (_mm_loadu_si128 ((__m128i *)x_params));
+    __m256i f;
+
+    /* Only bits 16 to 47 survive, so a logical shift does as well */
+    f = _mm256_add_epi64 (_mm256_mul_epi32 (fx, fy),
+			  _mm256_set1_epi64x (0x8000));
+    f = _mm256_srli_epi64 (f, 16);
+
+    *f01 = _mm256_permutevar8x32_epi32 (
+	f, _mm256_setr_epi32 (0, 0, 0, 0, 2, 2, 2, 2));
+    *f23 = _mm256_permutevar8x32_epi32 (
+	f, _mm256_setr_epi32 (4, 4, 4, 4, 6, 6, 6, 6));
+}
+
+static force_inline __m128i
+separable_tap (uint32_t pixel, pixman_fixed_t fx, pixman_fixed_t fy)
+{
+    pixman_fixed_t f = ((pixman_fixed_32_32_t)fx * fy + 0x8000) >> 16;
+
+    return _mm_mullo_epi32 (_mm_cvtepu8_epi32 (_mm_cvtsi32_si128 (pixel)),
+			    _mm_set1_epi32 (f));
+}
+
+/* Rounds the B G R A sums and packs them back into a pixel */
+static force_inline uint32_t
+separable_reduce (__m256i sum256, __m128i sum)
+{
+    sum = _mm_add_epi32 (sum, _mm256_castsi256_si128 (sum256));
+    sum = _mm_add_epi32 (sum, _mm256_extracti128_si256 (sum256, 1));
+    sum = _mm_srai_epi32 (_mm_add_epi32 (sum, _mm_set1_epi32 (0x8000)), 16);
+    sum = _mm_packs_epi32 (sum, sum);
+
+    return _mm_cvtsi128_si32 (_mm_packus_epi16 (sum, sum));
+}
+
+/* The footprint lies within the image, so the rows are read directly */
+static force_inline uint32_t
+separable_pixel_inside (bits_image_t *bits, const pixman_fixed_t *x_params,
+			const pixman_fixed_t *y_params,
+			int x1, int y1, int cwidth, int cheight, uint32_t amask)
+{
+    __m256i sum256 = _mm256_setzero_si256 ();
+    __m128i alpha = _mm_set1_epi32 (amask);
+    __m128i sum = _mm_setzero_si128 ();
+    int i, j;
+
+    for (i = 0; i < cheight; ++i)
+    {
+	pixman_fixed_t fy = y_params[i];
+	const uint32_t *row = bits->bits + bits->rowstride * (y1 + i) + x1;
+	__m256i vfy = _mm256_set1_epi64x (fy);
+
+	if (!fy)
+	    continue;
+
+	for (j = 0; j + 3 < cwidth; j += 4)
+	{
+	    __m128i p = _mm_or_si128 (
+		_mm_loadu_si128 ((__m128i *)(row + j)), alpha);
+	    __m256i f01, f23;
+
+	    separable_weights (x_params + j, vfy, &f01, &f23);
+
+	    sum256 = _mm256_add_epi32 (sum256, _mm256_mullo_epi32 (
+		_mm256_cvtepu8_epi32 (p), f01));
+	    sum256 = _mm256_add_epi32 (sum256, _mm256_mullo_epi32 (
+		_mm256_cvtepu8_epi32 (_mm_srli_si128 (p, 8)), f23));
+	}
+
+	for (; j < cwidth; ++j)
+	    sum = _mm_add_epi32 (sum, separable_tap (row[j] | amask, x_params[j], fy));
+    }
+
+    return separable_reduce (sum256, sum);
+}
+
+/* The footprint sticks out of the image, so each tap is repeated or
+ * clipped on its own
+ */
+static uint32_t
+separable_pixel_edge (bits_image_t *bits, const pixman_fixed_t *x_params,
+		      const pixman_fixed_t *y_params,
+		      int x1, int y1, int cwidth, int cheight, uint32_t amask)
+{
+    pixman_repeat_t repeat_mode = bits->common.repeat;
+    __m128i sum = _mm_setzero_si128 ();
+    int i, j;
+
+    for (i = 0; i < cheight; ++i)
+    {
+	pixman_fixed_t fy = y_params[i];
+	int ry = y1 + i;
+	const uint32_t *row;
+
+	if (!fy)
+	    continue;
+
+	if (repeat_mode == PIXMAN_REPEAT_NONE)
+	{
+	    if (ry < 0 || ry >= bits->height)
+		continue;
+	}
+	else
+	{
+	    repeat (repeat_mode, &ry, bits->height);
+	}
+
+	row = bits->bits + bits->rowstride * ry;
+
+	for (j = 0; j < cwidth; ++j)
+	{
+	    int rx = x1 + j;
+
+	    if (repeat_mode == PIXMAN_REPEAT_NONE)
+	    {
+		if (rx < 0 || rx >= bits->width)
+		    continue;
+	    }
+	    else
+	    {
+		repeat (repeat_mode, &rx, bits->width);
+	    }
+
+	    sum = _mm_add_epi32 (sum, separable_tap (row[rx] | amask, x_params[j], fy));
+	}
+    }
+
+    return separable_reduce (_mm256_setzero_si256 (), sum);
+}
+
+static uint32_t *
+avx2_fetch_separable_convolution (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    bits_image_t *bits = &image->bits;
+    pixman_fixed_t *params = image->common.filter_params;
+    int cwidth = pixman_fixed_to_int (params[0]);
+    int cheight = pixman_fixed_to_int (params[1]);
+    int x_off = ((cwidth << 16) - pixman_fixed_1) >> 1;
+    int y_off = ((cheight << 16) - pixman_fixed_1) >> 1;
+    int x_phase_bits = pixman_fixed_to_int (params[2]);
+    int y_phase_bits = pixman_fixed_to_int (params[3]);
+    int x_phase_shift = 16 - x_phase_bits;
+    int y_phase_shift = 16 - y_phase_bits;
+    uint32_t amask = PIXMAN_FORMAT_A (bits->format) ? 0 : 0xff000000;
+    uint32_t *buffer = iter->buffer;
+    pixman_fixed_t vx, vy;
+    pixman_fixed_t ux, uy;
+    pixman_vector_t v;
+    int k;
+
+    /* Reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y++) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return buffer;
+
+    ux = image->common.transform->matrix[0][0];
+    uy = image->common.transform->matrix[1][0];
+
+    vx = v.vector[0];
+    vy = v.vector[1];
+
+    for (k = 0; k < iter->width; ++k, vx += ux, vy += uy)
+    {
+	const pixman_fixed_t *x_params, *y_params;
+	pixman_fixed_t x, y;
+	int32_t x1, y1;
+
+	if (mask && !mask[k])
+	    continue;
+
+	/* Round to the middle of the closest phase, as the C fetchers do */
+	x = ((vx >> x_phase_shift) << x_phase_shift) + ((1 << x_phase_shift) >> 1);
+	y = ((vy >> y_phase_shift) << y_phase_shift) + ((1 << y_phase_shift) >> 1);
+
+	x_params = params + 4 + ((x & 0xffff) >> x_phase_shift) * cwidth;
+	y_params = params + 4 + (1 << x_phase_bits) * cwidth +
+	    ((y & 0xffff) >> y_phase_shift) * cheight;
+
+	x1 = pixman_fixed_to_int (x - pixman_fixed_e - x_off);
+	y1 = pixman_fixed_to_int (y - pixman_fixed_e - y_off);
+
+	if (x1 >= 0 && y1 >= 0 &&
+	    x1 + cwidth <= bits->width && y1 + cheight <= bits->height)
+	{
+	    buffer[k] = separable_pixel_inside (
+		bits, x_params, y_params, x1, y1, cwidth, cheight, amask);
+	}
+	else
+	{
+	    buffer[k] = separable_pixel_edge (
+		bits, x_params, y_params, x1, y1, cwidth, cheight, amask);
+	}
+    }
+
+    return buffer;
+}
+
+#define AVX2_SEPARABLE_CONVOLUTION_FLAGS				\
+    (FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_NO_ACCESSORS		|				\
+     FAST_PATH_HAS_TRANSFORM		|				\
+     FAST_PATH_AFFINE_TRANSFORM		|				\
+     FAST_PATH_SEPARABLE_CONVOLUTION_FILTER)
+
+static const pixman_iter_info_t avx2_iters[] =
+{
+    { PIXMAN_a8r8g8b8,
+      (FAST_PATH_STANDARD_FLAGS			|
+       FAST_PATH_SCALE_TRANSFORM		|
+       FAST_PATH_BILINEAR_FILTER		|
+       FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR),
+      ITER_NARROW | ITER_SRC,
+      avx2_bilinear_cover_iter_init,
+      NULL, NULL
+    },
+
+    { PIXMAN_a8r8g8b8,
+      AVX2_SEPARABLE_CONVOLUTION_FLAGS,
+      ITER_NARROW | ITER_SRC,
+      NULL, avx2_fetch_separable_convolution, NULL
+    },
+    { PIXMAN_x8r8g8b8,
+      AVX2_SEPARABLE_CONVOLUTION_FLAGS,
+      ITER_NARROW | ITER_SRC,
+      NULL, avx2_fetch_separable_convolution, NULL
+    },
+
+    { PIXMAN_null },
+};
+
+static const pixman_fast_path_t avx2_fast_paths[] =
+{
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, avx2_composite_over_8888_8888),
+
+    PIXMAN_STD_FAST_PATH (ADD, a8, null, a8, avx2_composite_add_8_8),
+    PIXMAN_STD_FAST_PATH (ADD, a8r8g8b8, null, a8r8g8b8, avx2_composite_add_8888_8888),
+    PIXMAN_STD_FAST_PATH (ADD, a8b8g8r8, null, a8b8g8r8, avx2_composite_add_8888_8888),
+
+    PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, avx2_composite_src_x888_8888),
+    PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, avx2_composite_src_x888_8888),
+
+    { PIXMAN_OP_NONE },
+};
+
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp =
+	_pixman_implementation_create (fallback, avx2_fast_paths);
+
+    imp->combine_32[PIXMAN_OP_OVER] = avx2_combine_over_u;
+    imp->combine_32[PIXMAN_OP_ADD] = avx2_combine_add_u;
+
+    imp->iter_info = avx2_iters;
+
+    return imp;
+}
@@ -161,6 +161,8 @@ conical_get_scanline (pixman_iter_t                 *iter,
 	}
     }
 
+    _pixman_gradient_walker_flush (&walker);
+
     iter->y++;
     return iter->buffer;
 }
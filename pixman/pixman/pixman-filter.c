@@ -33,6 +33,16 @@
 #endif
 #include "pixman-private.h"
 
+#if defined(_WIN32)
+#   define _NO_W32_PSEUDO_MODIFIERS
+#   include <windows.h>
+#ifdef IN
+#undef IN
+#endif
+#elif defined(HAVE_PTHREADS)
+#   include <pthread.h>
+#endif
+
 typedef double (* kernel_func_t) (double x);
 
 typedef struct
@@ -428,6 +438,163 @@ gnuplot_filter (int width, int n_phases, const pixman_fixed_t* p)
 
 #endif
 
+/* Render clients set the same few filters over and over, often once for
+ * every scaled composite, and each time all the taps would be integrated
+ * again.  So the most recently created parameter lists are kept around,
+ * and callers get a copy since they own and free what they are given.
+ */
+#define FILTER_CACHE_SIZE		8
+/* Lists longer than this are as cheap to build as to copy */
+#define FILTER_CACHE_MAX_VALUES		(16 * 1024)
+
+typedef struct
+{
+    pixman_fixed_t	scale_x;
+    pixman_fixed_t	scale_y;
+    pixman_kernel_t	reconstruct_x;
+    pixman_kernel_t	reconstruct_y;
+    pixman_kernel_t	sample_x;
+    pixman_kernel_t	sample_y;
+    int			subsample_bits_x;
+    int			subsample_bits_y;
+} filter_key_t;
+
+typedef struct
+{
+    filter_key_t	key;
+    int			n_values;
+    pixman_fixed_t *	params;		/* NULL if the entry is unused */
+    unsigned int	last_used;
+} filter_cache_entry_t;
+
+#if defined(_WIN32)
+
+static volatile LONG filter_cache_busy;
+
+#define FILTER_CACHE
+#define filter_cache_trylock()						\
+    (InterlockedCompareExchange (&filter_cache_busy, 1, 0) == 0)
+#define filter_cache_unlock()						\
+    InterlockedExchange (&filter_cache_busy, 0)
+
+#elif defined(HAVE_PTHREADS)
+
+static pthread_mutex_t filter_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define FILTER_CACHE
+#define filter_cache_trylock()						\
+    (pthread_mutex_trylock (&filter_cache_mutex) == 0)
+#define filter_cache_unlock()						\
+    pthread_mutex_unlock (&filter_cache_mutex)
+
+#endif
+
+#ifdef FILTER_CACHE
+
+static filter_cache_entry_t filter_cache[FILTER_CACHE_SIZE];
+static unsigned int filter_cache_clock;
+
+static pixman_bool_t
+filter_key_equal (const filter_key_t *a, const filter_key_t *b)
+{
+    return a->scale_x == b->scale_x &&
+	a->scale_y == b->scale_y &&
+	a->reconstruct_x == b->reconstruct_x &&
+	a->reconstruct_y == b->reconstruct_y &&
+	a->sample_x == b->sample_x &&
+	a->sample_y == b->sample_y &&
+	a->subsample_bits_x == b->subsample_bits_x &&
+	a->subsample_bits_y == b->subsample_bits_y;
+}
+
+/* Returns a copy of the cached list for key, or NULL.  A thread which
+ * finds the cache in use by another just builds its own list.
+ */
+static pixman_fixed_t *
+filter_cache_lookup (const filter_key_t *key, int *n_values)
+{
+    pixman_fixed_t *params = NULL;
+    int i;
+
+    if (!filter_cache_trylock ())
+	return NULL;
+
+    for (i = 0; i < FILTER_CACHE_SIZE; ++i)
+    {
+	filter_cache_entry_t *entry = &filter_cache[i];
+
+	if (entry->params && filter_key_equal (&entry->key, key))
+	{
+	    params = malloc (entry->n_values * sizeof (pixman_fixed_t));
+	    if (params)
+	    {
+		memcpy (params, entry->params,
+			entry->n_values * sizeof (pixman_fixed_t));
+		*n_values = entry->n_values;
+		entry->last_used = ++filter_cache_clock;
+	    }
+	    break;
+	}
+    }
+
+    filter_cache_unlock ();
+
+    return params;
+}
+
+/* Keeps a copy of params, replacing the least recently used entry */
+static void
+filter_cache_insert (const filter_key_t *key,
+		     const pixman_fixed_t *params, int n_values)
+{
+    filter_cache_entry_t *victim;
+    pixman_fixed_t *copy;
+    int i;
+
+    if (n_values > FILTER_CACHE_MAX_VALUES)
+	return;
+
+    if (!(copy = malloc (n_values * sizeof (pixman_fixed_t))))
+	return;
+
+    memcpy (copy, params, n_values * sizeof (pixman_fixed_t));
+
+    if (!filter_cache_trylock ())
+    {
+	free (copy);
+	return;
+    }
+
+    victim = &filter_cache[0];
+    for (i = 0; i < FILTER_CACHE_SIZE; ++i)
+    {
+	filter_cache_entry_t *entry = &filter_cache[i];
+
+	if (!entry->params)
+	{
+	    victim = entry;
+	    break;
+	}
+
+	/* Compared as a difference so that the clock may wrap */
+	if (filter_cache_clock - entry->last_used >
+	    filter_cache_clock - victim->last_used)
+	{
+	    victim = entry;
+	}
+    }
+
+    free (victim->params);
+    victim->key = *key;
+    victim->n_values = n_values;
+    victim->params = copy;
+    victim->last_used = ++filter_cache_clock;
+
+    filter_cache_unlock ();
+}
+
+#endif
+
 /* Create the parameter list for a SEPARABLE_CONVOLUTION filter
  * with the given kernels and scale parameters
  */
@@ -447,6 +614,21 @@ pixman_filter_create_separable_convolution (int             *n_values,
     pixman_fixed_t *params;
     int subsample_x, subsample_y;
     int width, height;
+#ifdef FILTER_CACHE
+    filter_key_t key;
+
+    key.scale_x = scale_x;
+    key.scale_y = scale_y;
+    key.reconstruct_x = reconstruct_x;
+    key.reconstruct_y = reconstruct_y;
+    key.sample_x = sample_x;
+    key.sample_y = sample_y;
+    key.subsample_bits_x = subsample_bits_x;
+    key.subsample_bits_y = subsample_bits_y;
+
+    if ((params = filter_cache_lookup (&key, n_values)))
+	return params;
+#endif
 
     width = filter_width (reconstruct_x, sample_x, sx);
     subsample_x = (1 << subsample_bits_x);
@@ -474,5 +656,9 @@ pixman_filter_create_separable_convolution (int             *n_values,
     gnuplot_filter(width, subsample_x, params + 4);
 #endif
 
+#ifdef FILTER_CACHE
+    filter_cache_insert (&key, params, *n_values);
+#endif
+
     return params;
 }
@@ -28,6 +28,13 @@
 #endif
 #include "pixman-private.h"
 
+#if defined(USE_SSE2) && (defined(__SSE2__) || defined(_M_X64) ||	\
+			  defined(_M_AMD64) ||				\
+			  (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GRADIENT_WALKER_SSE2
+#include <emmintrin.h>
+#endif
+
 void
 _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
                               gradient_t *              gradient,
@@ -48,6 +55,7 @@ _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
     walker->repeat    = repeat;
 
     walker->need_reset = TRUE;
+    walker->n_pending  = 0;
 }
 
 static void
@@ -219,12 +227,106 @@ pixman_gradient_walker_pixel_32 (pixman_gradient_walker_t *walker,
            (((uint8_t)(f.b + .5f) >>  0) & 0x000000ff);
 }
 
+/*
+ * Four pixels that all lie between left_x and right_x, computed together.
+ * The arithmetic is the same as in pixman_gradient_walker_pixel_32(), so
+ * the results are too.
+ */
+static void
+gradient_walker_pixels_32 (pixman_gradient_walker_t    *walker,
+			   const pixman_fixed_48_16_t  *x,
+			   uint32_t * const            *buffer)
+{
+#ifdef GRADIENT_WALKER_SSE2
+    const __m128 half = _mm_set1_ps (.5f);
+    const __m128i lo8 = _mm_set1_epi32 (0xff);
+    __m128 y, a, r, g, b;
+    __m128i p;
+    uint32_t pixels[4];
+    int i;
+
+    y = _mm_setr_ps (x[0] * (1.0f / 65536.0f), x[1] * (1.0f / 65536.0f),
+		     x[2] * (1.0f / 65536.0f), x[3] * (1.0f / 65536.0f));
+
+    a = _mm_mul_ps (_mm_set1_ps (255.f),
+		    _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->a_s), y),
+				_mm_set1_ps (walker->a_b)));
+    r = _mm_mul_ps (a, _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->r_s), y),
+				   _mm_set1_ps (walker->r_b)));
+    g = _mm_mul_ps (a, _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->g_s), y),
+				   _mm_set1_ps (walker->g_b)));
+    b = _mm_mul_ps (a, _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->b_s), y),
+				   _mm_set1_ps (walker->b_b)));
+
+    /* Truncate and keep the low 8 bits, like the (uint8_t) casts */
+    p = _mm_slli_epi32 (
+	_mm_and_si128 (_mm_cvttps_epi32 (_mm_add_ps (a, half)), lo8), 24);
+    p = _mm_or_si128 (p, _mm_slli_epi32 (
+	_mm_and_si128 (_mm_cvttps_epi32 (_mm_add_ps (r, half)), lo8), 16));
+    p = _mm_or_si128 (p, _mm_slli_epi32 (
+	_mm_and_si128 (_mm_cvttps_epi32 (_mm_add_ps (g, half)), lo8), 8));
+    p = _mm_or_si128 (p,
+	_mm_and_si128 (_mm_cvttps_epi32 (_mm_add_ps (b, half)), lo8));
+
+    _mm_storeu_si128 ((__m128i *)pixels, p);
+    for (i = 0; i < 4; i++)
+	*buffer[i] = pixels[i];
+#else
+    int i;
+
+    for (i = 0; i < 4; i++)
+	*buffer[i] = pixman_gradient_walker_pixel_32 (walker, x[i]);
+#endif
+}
+
+/* Compute the narrow pixels queued by _pixman_gradient_walker_write_narrow() */
+void
+_pixman_gradient_walker_flush (pixman_gradient_walker_t *walker)
+{
+    int n = walker->n_pending;
+    int i;
+
+    walker->n_pending = 0;
+
+    if (n == 4 && !walker->need_reset)
+    {
+	for (i = 0; i < 4; i++)
+	{
+	    if (walker->pending_x[i] < walker->left_x ||
+		walker->pending_x[i] >= walker->right_x)
+		break;
+	}
+
+	if (i == 4)
+	{
+	    gradient_walker_pixels_32 (walker, walker->pending_x,
+				       walker->pending_buffer);
+	    return;
+	}
+    }
+
+    /* Some pixels are in another segment, so go one at a time */
+    for (i = 0; i < n; i++)
+    {
+	*walker->pending_buffer[i] =
+	    pixman_gradient_walker_pixel_32 (walker, walker->pending_x[i]);
+    }
+}
+
+/*
+ * Narrow pixels are queued and computed four at a time; callers must call
+ * _pixman_gradient_walker_flush() before they use the buffer.
+ */
 void
 _pixman_gradient_walker_write_narrow (pixman_gradient_walker_t *walker,
 				      pixman_fixed_48_16_t      x,
 				      uint32_t                 *buffer)
 {
-    *buffer = pixman_gradient_walker_pixel_32 (walker, x);
+    walker->pending_x[walker->n_pending] = x;
+    walker->pending_buffer[walker->n_pending] = buffer;
+
+    if (++walker->n_pending == 4)
+	_pixman_gradient_walker_flush (walker);
 }
 
 void
@@ -215,6 +215,8 @@ linear_get_scanline (pixman_iter_t                 *iter,
 	}
     }
 
+    _pixman_gradient_walker_flush (&walker);
+
     iter->y++;
 
     return iter->buffer;
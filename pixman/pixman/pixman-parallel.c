@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Tile parallel compositing.
+ *
+ * With pixman_composite_set_threads (n), composites that are large enough
+ * to be worth it have their composite region cut into horizontal bands,
+ * which the calling thread and n - 1 helper threads then run through the
+ * composite function picked for the whole operation.  Every band is
+ * computed from its own coordinates, so the result is the same as
+ * compositing the region in one go.
+ *
+ * Only one parallel composite runs at a time; a composite that finds the
+ * helpers busy, for example one from another application thread, runs on
+ * its own thread as before.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include "pixman-private.h"
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#   define _NO_W32_PSEUDO_MODIFIERS
+#   include <windows.h>
+#ifdef IN
+#undef IN
+#endif
+#   define PARALLEL_WIN32
+#elif defined(HAVE_PTHREADS)
+#   include <pthread.h>
+#   define PARALLEL_PTHREADS
+#endif
+
+/* Fewer pixels than this are not worth waking the helpers for */
+#define PARALLEL_MIN_PIXELS		(512 * 512)
+/* ... unless each pixel needs transforming, filtering or a gradient */
+#define PARALLEL_MIN_PIXELS_COSTLY	(128 * 128)
+/* Bands are at least this many rows, and there are this many per thread */
+#define PARALLEL_MIN_BAND_ROWS		8
+#define PARALLEL_BANDS_PER_THREAD	4
+#define PARALLEL_MAX_BANDS		256
+#define PARALLEL_MAX_THREADS		64
+
+typedef struct
+{
+    pixman_implementation_t *	imp;
+    pixman_composite_func_t	func;
+    pixman_composite_info_t *	bands;
+    int				n_bands;
+    volatile long		next;		/* next band to run */
+    volatile long		pending;	/* helpers still running */
+} parallel_job_t;
+
+static int n_threads_wanted;
+
+#ifdef PARALLEL_WIN32
+
+#define atomic_inc(p) InterlockedIncrement ((LONG volatile *)(p))
+#define atomic_dec(p) InterlockedDecrement ((LONG volatile *)(p))
+
+#elif defined(PARALLEL_PTHREADS)
+
+#define atomic_inc(p) __sync_add_and_fetch ((p), 1)
+#define atomic_dec(p) __sync_sub_and_fetch ((p), 1)
+
+#endif
+
+#if defined(PARALLEL_WIN32) || defined(PARALLEL_PTHREADS)
+
+static void
+run_bands (parallel_job_t *job)
+{
+    long i;
+
+    while ((i = atomic_inc (&job->next) - 1) < job->n_bands)
+	job->func (job->imp, &job->bands[i]);
+}
+
+static int n_helpers;
+static parallel_job_t *current_job;
+
+#endif
+
+#ifdef PARALLEL_WIN32
+
+static HANDLE start_semaphore;
+static HANDLE done_event;
+static volatile LONG pool_busy;
+
+#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+static DWORD WINAPI
+helper_main (LPVOID arg)
+{
+    for (;;)
+    {
+	parallel_job_t *job;
+
+	WaitForSingleObject (start_semaphore, INFINITE);
+
+	job = current_job;
+	run_bands (job);
+	if (atomic_dec (&job->pending) == 0)
+	    SetEvent (done_event);
+    }
+
+    return 0;
+}
+
+static void
+start_helpers (int n)
+{
+    if (!start_semaphore)
+    {
+	start_semaphore = CreateSemaphoreA (NULL, 0, PARALLEL_MAX_THREADS, NULL);
+	done_event = CreateEventA (NULL, FALSE, FALSE, NULL);
+	if (!start_semaphore || !done_event)
+	    return;
+    }
+
+    while (n_helpers < n)
+    {
+	HANDLE thread = CreateThread (NULL, 0, helper_main, NULL, 0, NULL);
+
+	if (!thread)
+	    break;
+	CloseHandle (thread);
+	n_helpers++;
+    }
+}
+
+static pixman_bool_t
+acquire_helpers (void)
+{
+    return InterlockedCompareExchange (&pool_busy, 1, 0) == 0;
+}
+
+static void
+run_job (parallel_job_t *job, int n)
+{
+    job->pending = n;
+    current_job = job;
+    ReleaseSemaphore (start_semaphore, n, NULL);
+
+    run_bands (job);
+
+    WaitForSingleObject (done_event, INFINITE);
+    InterlockedExchange (&pool_busy, 0);
+}
+
+#elif defined(PARALLEL_PTHREADS)
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t busy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int n_joining;		/* helpers still to join the current job */
+
+#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+static void *
+helper_main (void *arg)
+{
+    pthread_mutex_lock (&pool_mutex);
+    for (;;)
+    {
+	parallel_job_t *job;
+
+	while (n_joining == 0)
+	    pthread_cond_wait (&start_cond, &pool_mutex);
+	n_joining--;
+	job = current_job;
+	pthread_mutex_unlock (&pool_mutex);
+
+	run_bands (job);
+
+	pthread_mutex_lock (&pool_mutex);
+	if (--job->pending == 0)
+	    pthread_cond_signal (&done_cond);
+    }
+
+    return NULL;
+}
+
+static void
+start_helpers (int n)
+{
+    pthread_attr_t attr;
+
+    pthread_attr_init (&attr);
+    pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+
+    while (n_helpers < n)
+    {
+	pthread_t thread;
+
+	if (pthread_create (&thread, &attr, helper_main, NULL) != 0)
+	    break;
+	n_helpers++;
+    }
+
+    pthread_attr_destroy (&attr);
+}
+
+static pixman_bool_t
+acquire_helpers (void)
+{
+    return pthread_mutex_trylock (&busy_mutex) == 0;
+}
+
+static void
+run_job (parallel_job_t *job, int n)
+{
+    pthread_mutex_lock (&pool_mutex);
+    job->pending = n;
+    current_job = job;
+    n_joining = n;
+    pthread_cond_broadcast (&start_cond);
+    pthread_mutex_unlock (&pool_mutex);
+
+    run_bands (job);
+
+    pthread_mutex_lock (&pool_mutex);
+    while (job->pending)
+	pthread_cond_wait (&done_cond, &pool_mutex);
+    pthread_mutex_unlock (&pool_mutex);
+
+    pthread_mutex_unlock (&busy_mutex);
+}
+
+#endif
+
+/*
+ * Set the number of threads, the caller included, that large composites
+ * are spread over.  0 or 1 keeps all compositing on the calling thread.
+ * The helper threads are started on the first call that asks for them and
+ * kept from then on.  This should be called before other threads start
+ * compositing.
+ */
+PIXMAN_EXPORT void
+pixman_composite_set_threads (int n_threads)
+{
+    if (n_threads > PARALLEL_MAX_THREADS)
+	n_threads = PARALLEL_MAX_THREADS;
+
+#if defined(PARALLEL_WIN32) || defined(PARALLEL_PTHREADS)
+    if (n_threads > 1)
+	start_helpers (n_threads - 1);
+#endif
+
+    n_threads_wanted = n_threads;
+}
+
+static pixman_bool_t
+image_is_costly (pixman_image_t *image)
+{
+    if (!image)
+	return FALSE;
+
+    if (image->type != BITS)
+	return image->type != SOLID;
+
+    return !(image->common.flags & FAST_PATH_ID_TRANSFORM)	||
+	image->common.filter == PIXMAN_FILTER_BILINEAR		||
+	image->common.filter == PIXMAN_FILTER_GOOD		||
+	image->common.filter == PIXMAN_FILTER_BEST		||
+	image->common.filter == PIXMAN_FILTER_CONVOLUTION	||
+	image->common.filter == PIXMAN_FILTER_SEPARABLE_CONVOLUTION;
+}
+
+static pixman_bool_t
+image_shares_bits (pixman_image_t *image, pixman_image_t *dest)
+{
+    return image && image->type == BITS &&
+	image->bits.bits == dest->bits.bits;
+}
+
+/*
+ * Composite the boxes with func in bands spread over the helper threads.
+ * Returns FALSE, having done nothing, when the composite is better run on
+ * the calling thread.
+ */
+pixman_bool_t
+_pixman_composite_parallel (pixman_implementation_t       *imp,
+			    pixman_composite_func_t        func,
+			    const pixman_composite_info_t *info,
+			    const pixman_box32_t          *boxes,
+			    int                            n_boxes,
+			    int32_t                        src_dx,
+			    int32_t                        src_dy,
+			    int32_t                        mask_dx,
+			    int32_t                        mask_dy)
+{
+#if defined(PARALLEL_WIN32) || defined(PARALLEL_PTHREADS)
+    pixman_composite_info_t bands[PARALLEL_MAX_BANDS];
+    parallel_job_t job;
+    pixman_image_t *dest = info->dest_image;
+    int64_t pixels = 0, rows = 0;
+    int n_threads, band_rows, n_bands, i;
+
+    n_threads = MIN (n_threads_wanted, n_helpers + 1);
+    if (n_threads < 2 || n_boxes > PARALLEL_MAX_BANDS / 2)
+	return FALSE;
+
+    /* The helpers must not call back into the application, and bands
+     * must not read what other bands write.
+     */
+    if (!(info->src_image->common.flags & FAST_PATH_NO_ACCESSORS)	||
+	(info->mask_image &&
+	 !(info->mask_image->common.flags & FAST_PATH_NO_ACCESSORS))	||
+	!(dest->common.flags & FAST_PATH_NO_ACCESSORS)			||
+	image_shares_bits (info->src_image, dest)			||
+	image_shares_bits (info->mask_image, dest))
+    {
+	return FALSE;
+    }
+
+    for (i = 0; i < n_boxes; ++i)
+    {
+	pixels += (int64_t)(boxes[i].x2 - boxes[i].x1) *
+	    (boxes[i].y2 - boxes[i].y1);
+	rows += boxes[i].y2 - boxes[i].y1;
+    }
+
+    if (pixels < PARALLEL_MIN_PIXELS_COSTLY ||
+	(pixels < PARALLEL_MIN_PIXELS &&
+	 !image_is_costly (info->src_image) &&
+	 !image_is_costly (info->mask_image)))
+    {
+	return FALSE;
+    }
+
+    band_rows = (rows + n_threads * PARALLEL_BANDS_PER_THREAD - 1) /
+	(n_threads * PARALLEL_BANDS_PER_THREAD);
+    if (band_rows < PARALLEL_MIN_BAND_ROWS)
+	band_rows = PARALLEL_MIN_BAND_ROWS;
+    /* Each box adds at most one short band */
+    if (band_rows < (rows + PARALLEL_MAX_BANDS - n_boxes - 1) /
+	(PARALLEL_MAX_BANDS - n_boxes))
+    {
+	band_rows = (rows + PARALLEL_MAX_BANDS - n_boxes - 1) /
+	    (PARALLEL_MAX_BANDS - n_boxes);
+    }
+
+    n_bands = 0;
+    for (i = 0; i < n_boxes; ++i)
+    {
+	int32_t y;
+
+	for (y = boxes[i].y1; y < boxes[i].y2; y += band_rows)
+	{
+	    pixman_composite_info_t *band;
+
+	    if (n_bands == PARALLEL_MAX_BANDS)
+		return FALSE;
+
+	    band = &bands[n_bands++];
+	    *band = *info;
+	    band->src_x = boxes[i].x1 + src_dx;
+	    band->src_y = y + src_dy;
+	    band->mask_x = boxes[i].x1 + mask_dx;
+	    band->mask_y = y + mask_dy;
+	    band->dest_x = boxes[i].x1;
+	    band->dest_y = y;
+	    band->width = boxes[i].x2 - boxes[i].x1;
+	    band->height = MIN (band_rows, boxes[i].y2 - y);
+	}
+    }
+
+    if (n_bands < 2 || !acquire_helpers ())
+	return FALSE;
+
+    job.imp = imp;
+    job.func = func;
+    job.bands = bands;
+    job.n_bands = n_bands;
+    job.next = 0;
+
+    run_job (&job, MIN (n_threads - 1, n_bands - 1));
+
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
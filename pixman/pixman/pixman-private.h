@@ -352,6 +352,13 @@ typedef struct
     pixman_repeat_t	    repeat;
 
     pixman_bool_t           need_reset;
+
+    /* Narrow pixels written but not yet computed, see
+     * _pixman_gradient_walker_flush()
+     */
+    int                     n_pending;
+    pixman_fixed_48_16_t    pending_x[4];
+    uint32_t *              pending_buffer[4];
 } pixman_gradient_walker_t;
 
 void
@@ -378,6 +385,9 @@ _pixman_gradient_walker_write_wide(pixman_gradient_walker_t *walker,
 				   pixman_fixed_48_16_t      x,
 				   uint32_t                 *buffer);
 
+void
+_pixman_gradient_walker_flush (pixman_gradient_walker_t *walker);
+
 typedef void (*pixman_gradient_walker_fill_t) (
     pixman_gradient_walker_t *walker,
     pixman_fixed_48_16_t      x,
@@ -557,6 +567,17 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 					 pixman_implementation_t **out_imp,
 					 pixman_composite_func_t  *out_func);
 
+pixman_bool_t
+_pixman_composite_parallel (pixman_implementation_t       *imp,
+			    pixman_composite_func_t        func,
+			    const pixman_composite_info_t *info,
+			    const pixman_box32_t          *boxes,
+			    int                            n_boxes,
+			    int32_t                        src_dx,
+			    int32_t                        src_dy,
+			    int32_t                        mask_dx,
+			    int32_t                        mask_dy);
+
 pixman_combine_32_func_t
 _pixman_implementation_lookup_combiner (pixman_implementation_t *imp,
 					pixman_op_t		 op,
@@ -626,6 +647,11 @@ pixman_implementation_t *
 _pixman_implementation_create_ssse3 (pixman_implementation_t *fallback);
 #endif
 
+#ifdef USE_AVX2
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback);
+#endif
+
 #ifdef USE_ARM_SIMD
 pixman_implementation_t *
 _pixman_implementation_create_arm_simd (pixman_implementation_t *fallback);
@@ -431,6 +431,8 @@ radial_get_scanline (pixman_iter_t                 *iter,
 	}
     }
 
+    _pixman_gradient_walker_flush (&walker);
+
     iter->y++;
     return iter->buffer;
 }
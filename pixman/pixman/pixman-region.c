@@ -1153,6 +1153,92 @@ pixman_region_intersect_o (region_type_t *region,
     return TRUE;
 }
 
+/*-
+ *-----------------------------------------------------------------------
+ * pixman_region_clip_to_box --
+ *	Intersect a multi-rectangle region with a single box, which is
+ *	what clipping to a window or a drawable boils down to.  The
+ *	boxes are clipped in place, band by band, so no new region data
+ *	has to be built the way pixman_op does.  new_reg may be reg.
+ *
+ *-----------------------------------------------------------------------
+ */
+static pixman_bool_t
+pixman_region_clip_to_box (region_type_t *   new_reg,
+			   region_type_t *   reg,
+			   const box_type_t *clip)
+{
+    box_type_t *box, *box_end, *band_end, *out;
+    int prev_band, cur_band;
+    int numRects;
+
+    if (new_reg != reg && !PREFIX (_copy) (new_reg, reg))
+	return FALSE;
+
+    box = PIXREGION_BOXPTR (new_reg);
+    box_end = box + new_reg->data->numRects;
+    out = box;
+
+    new_reg->data->numRects = 0;
+    prev_band = 0;
+
+    for (; box != box_end; box = band_end)
+    {
+	int y1 = box->y1;
+	int y2 = box->y2;
+
+	band_end = box + 1;
+	while (band_end != box_end && band_end->y1 == y1)
+	    band_end++;
+
+	if (y2 <= clip->y1)
+	    continue;
+	if (y1 >= clip->y2)
+	    break;
+
+	y1 = MAX (y1, clip->y1);
+	y2 = MIN (y2, clip->y2);
+
+	cur_band = new_reg->data->numRects;
+
+	for (; box != band_end; box++)
+	{
+	    int x1 = MAX (box->x1, clip->x1);
+	    int x2 = MIN (box->x2, clip->x2);
+
+	    if (x1 < x2)
+		ADDRECT (out, x1, y1, x2, y2);
+	}
+
+	new_reg->data->numRects = out - PIXREGION_BOXPTR (new_reg);
+	if (new_reg->data->numRects == cur_band)
+	    continue;
+
+	COALESCE (new_reg, prev_band, cur_band);
+	out = PIXREGION_TOP (new_reg);
+    }
+
+    if (!(numRects = new_reg->data->numRects))
+    {
+	FREE_DATA (new_reg);
+	new_reg->extents.x2 = new_reg->extents.x1;
+	new_reg->extents.y2 = new_reg->extents.y1;
+	new_reg->data = pixman_region_empty_data;
+    }
+    else if (numRects == 1)
+    {
+	new_reg->extents = *PIXREGION_BOXPTR (new_reg);
+	FREE_DATA (new_reg);
+	new_reg->data = (region_data_type_t *)NULL;
+    }
+    else
+    {
+	pixman_set_extents (new_reg);
+    }
+
+    return TRUE;
+}
+
 PIXMAN_EXPORT pixman_bool_t
 PREFIX (_intersect) (region_type_t *     new_reg,
                      region_type_t *        reg1,
@@ -1204,6 +1290,15 @@ PREFIX (_intersect) (region_type_t *     new_reg,
     {
         return PREFIX (_copy) (new_reg, reg1);
     }
+    else if (!reg2->data && new_reg != reg2)
+    {
+	/* Region clipped to a rectangle */
+	return pixman_region_clip_to_box (new_reg, reg1, &reg2->extents);
+    }
+    else if (!reg1->data && new_reg != reg1)
+    {
+	return pixman_region_clip_to_box (new_reg, reg2, &reg1->extents);
+    }
     else
     {
         /* General purpose intersection */
@@ -1367,6 +1462,141 @@ PREFIX (_union_rect) (region_type_t *dest,
     return PREFIX (_union) (dest, source, &region);
 }
 
+/*-
+ *-----------------------------------------------------------------------
+ * pixman_region_append_below --
+ *	Union of two regions where every band of bottom lies below every
+ *	band of top, as when damage is accumulated down the screen.  The
+ *	boxes of bottom are appended to those of top, coalescing the two
+ *	bands where they meet.  new_reg may be top but not bottom.
+ *
+ *-----------------------------------------------------------------------
+ */
+static pixman_bool_t
+pixman_region_append_below (region_type_t *new_reg,
+			    region_type_t *top,
+			    region_type_t *bottom)
+{
+    box_type_t *r = PIXREGION_RECTS (bottom);
+    box_type_t *r_end = r + PIXREGION_NUMRECTS (bottom);
+    box_type_t *r_band_end;
+    box_type_t *last;
+    int prev_band, cur_band;
+    box_type_t extents;
+
+    extents.x1 = MIN (top->extents.x1, bottom->extents.x1);
+    extents.y1 = top->extents.y1;
+    extents.x2 = MAX (top->extents.x2, bottom->extents.x2);
+    extents.y2 = bottom->extents.y2;
+
+    if (new_reg != top && !PREFIX (_copy) (new_reg, top))
+	return FALSE;
+
+    RECTALLOC_BAIL (new_reg, r_end - r, bail);
+
+    /* Find the last band of top */
+    last = PIXREGION_END (new_reg);
+    prev_band = new_reg->data->numRects - 1;
+    while (prev_band > 0 && PIXREGION_BOX (new_reg, prev_band - 1)->y1 == last->y1)
+	prev_band--;
+
+    /* The first band of bottom may coalesce with it */
+    r_band_end = r + 1;
+    while (r_band_end != r_end && r_band_end->y1 == r->y1)
+	r_band_end++;
+
+    cur_band = new_reg->data->numRects;
+    memcpy (PIXREGION_TOP (new_reg), r, (r_band_end - r) * sizeof (box_type_t));
+    new_reg->data->numRects += r_band_end - r;
+
+    COALESCE (new_reg, prev_band, cur_band);
+
+    /* The remaining bands of bottom could not coalesce among themselves,
+     * so they cannot coalesce with the merged band either.
+     */
+    memcpy (PIXREGION_TOP (new_reg), r_band_end,
+	    (r_end - r_band_end) * sizeof (box_type_t));
+    new_reg->data->numRects += r_end - r_band_end;
+
+    new_reg->extents = extents;
+
+    if (new_reg->data->numRects == 1)
+    {
+	FREE_DATA (new_reg);
+	new_reg->data = (region_data_type_t *)NULL;
+    }
+
+    return TRUE;
+
+bail:
+    return pixman_break (new_reg);
+}
+
+/*-
+ *-----------------------------------------------------------------------
+ * pixman_region_append_right --
+ *	Union of a region and a box that spans exactly the last band of
+ *	the region and lies at or to the right of its last box, as when
+ *	damage is accumulated along a row.  The box is added to the band
+ *	in place.  new_reg may be reg.
+ *
+ *-----------------------------------------------------------------------
+ */
+static pixman_bool_t
+pixman_region_append_right (region_type_t *   new_reg,
+			    region_type_t *   reg,
+			    const box_type_t *box)
+{
+    box_type_t *last;
+    int prev_band, cur_band;
+
+    if (new_reg != reg && !PREFIX (_copy) (new_reg, reg))
+	return FALSE;
+
+    RECTALLOC_BAIL (new_reg, 1, bail);
+
+    last = PIXREGION_END (new_reg);
+    if (last->x2 == box->x1)
+    {
+	last->x2 = box->x2;
+    }
+    else
+    {
+	*PIXREGION_TOP (new_reg) = *box;
+	new_reg->data->numRects++;
+    }
+
+    if (box->x2 > new_reg->extents.x2)
+	new_reg->extents.x2 = box->x2;
+
+    /* The grown band may now match the one above it */
+    cur_band = new_reg->data->numRects - 1;
+    while (cur_band > 0 && PIXREGION_BOX (new_reg, cur_band - 1)->y1 == box->y1)
+	cur_band--;
+
+    prev_band = cur_band - 1;
+    while (prev_band > 0 &&
+	   PIXREGION_BOX (new_reg, prev_band - 1)->y1 ==
+	   PIXREGION_BOX (new_reg, cur_band - 1)->y1)
+    {
+	prev_band--;
+    }
+
+    if (prev_band >= 0)
+	COALESCE (new_reg, prev_band, cur_band);
+
+    if (new_reg->data->numRects == 1)
+    {
+	FREE_DATA (new_reg);
+	new_reg->data = (region_data_type_t *)NULL;
+    }
+
+    return TRUE;
+
+bail:
+    return pixman_break (new_reg);
+}
+
 PIXMAN_EXPORT pixman_bool_t
 PREFIX (_union) (region_type_t *new_reg,
                  region_type_t *reg1,
@@ -1437,6 +1667,26 @@ PREFIX (_union) (region_type_t *new_reg,
 	return TRUE;
     }
 
+    /*
+     * One region lies entirely below the other
+     */
+    if (reg1->extents.y2 <= reg2->extents.y1 && new_reg != reg2)
+	return pixman_region_append_below (new_reg, reg1, reg2);
+
+    if (reg2->extents.y2 <= reg1->extents.y1 && new_reg != reg1)
+	return pixman_region_append_below (new_reg, reg2, reg1);
+
+    /*
+     * A rectangle extending the last band of region 1 to the right
+     */
+    if (reg1->data && !reg2->data && new_reg != reg2 &&
+	reg2->extents.y1 == PIXREGION_END (reg1)->y1 &&
+	reg2->extents.y2 == PIXREGION_END (reg1)->y2 &&
+	reg2->extents.x1 >= PIXREGION_END (reg1)->x2)
+    {
+	return pixman_region_append_right (new_reg, reg1, &reg2->extents);
+    }
+
     if (!pixman_op (new_reg, reg1, reg2, pixman_region_union_o, TRUE, TRUE))
 	return FALSE;
 
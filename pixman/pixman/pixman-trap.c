@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "pixman-private.h"
 
 /*
@@ -387,6 +388,10 @@ pixman_rasterize_trapezoid (pixman_image_t *          image,
     }
 }
 
+/* Size of the mask bands used by pixman_composite_trapezoids() */
+#define TRAP_BAND_BYTES		(64 * 1024)
+#define TRAP_BAND_MIN_ROWS	16
+
 static const pixman_bool_t zero_src_has_no_effect[PIXMAN_N_OPERATORS] =
 {
     FALSE,	/* Clear		0			0    */
@@ -518,31 +523,91 @@ pixman_composite_trapezoids (pixman_op_t		op,
     {
 	pixman_image_t *tmp;
 	pixman_box32_t box;
-	int i;
+	int width, stride, band_h, y;
+	pixman_bool_t dirty = FALSE;
+	uint32_t *bits;
 
 	if (!get_trap_extents (op, dst, traps, n_traps, &box))
 	    return;
-	
+
+	/* Rather than rasterizing everything into one mask covering the
+	 * whole extents, walk the extents in bands of rows that stay in
+	 * cache: every trapezoid crossing the band is accumulated into
+	 * it and the band is composited straight away.  The rasterizer
+	 * clips to the band exactly the way it clips to a full mask, so
+	 * the result is the same.
+	 */
+	width = box.x2 - box.x1;
+	stride = ((width * PIXMAN_FORMAT_BPP (mask_format) + 31) / 32) * 4;
+	band_h = TRAP_BAND_BYTES / stride;
+	if (band_h < TRAP_BAND_MIN_ROWS)
+	    band_h = TRAP_BAND_MIN_ROWS;
+	if (band_h > box.y2 - box.y1)
+	    band_h = box.y2 - box.y1;
+
 	if (!(tmp = pixman_image_create_bits (
-		  mask_format, box.x2 - box.x1, box.y2 - box.y1, NULL, -1)))
+		  mask_format, width, band_h, NULL, -1)))
 	    return;
-	
-	for (i = 0; i < n_traps; ++i)
+
+	bits = pixman_image_get_data (tmp);
+	stride = pixman_image_get_stride (tmp);
+
+	for (y = box.y1; y < box.y2; y += band_h)
 	{
-	    const pixman_trapezoid_t *trap = &(traps[i]);
-	    
-	    if (!pixman_trapezoid_valid (trap))
-		continue;
-	    
-	    pixman_rasterize_trapezoid (tmp, trap, - box.x1, - box.y1);
+	    int h = box.y2 - y;
+	    pixman_fixed_t band_top = pixman_int_to_fixed (y);
+	    pixman_fixed_t band_bottom;
+	    pixman_bool_t empty = TRUE;
+
+	    if (h > band_h)
+		h = band_h;
+	    band_bottom = pixman_int_to_fixed (y + h);
+
+	    for (i = 0; i < n_traps; ++i)
+	    {
+		const pixman_trapezoid_t *trap = &(traps[i]);
+
+		if (!pixman_trapezoid_valid (trap)	||
+		    trap->bottom <= band_top		||
+		    trap->top >= band_bottom)
+		{
+		    continue;
+		}
+
+		if (dirty)
+		{
+		    memset (bits, 0, stride * band_h);
+		    dirty = FALSE;
+		}
+
+		pixman_rasterize_trapezoid (tmp, trap, - box.x1, - y);
+		empty = FALSE;
+	    }
+
+	    if (empty)
+	    {
+		/* Only operators that are not bounded by the mask need
+		 * to see the empty band.
+		 */
+		if (zero_src_has_no_effect[op])
+		    continue;
+
+		if (dirty)
+		{
+		    memset (bits, 0, stride * band_h);
+		    dirty = FALSE;
+		}
+	    }
+
+	    pixman_image_composite (op, src, tmp, dst,
+				    x_src + box.x1, y_src + y,
+				    0, 0,
+				    x_dst + box.x1, y_dst + y,
+				    width, h);
+
+	    dirty = !empty;
 	}
-	
-	pixman_image_composite (op, src, tmp, dst,
-				x_src + box.x1, y_src + box.y1,
-				0, 0,
-				x_dst + box.x1, y_dst + box.y1,
-				box.x2 - box.x1, box.y2 - box.y1);
-	
+
 	pixman_image_unref (tmp);
     }
 }
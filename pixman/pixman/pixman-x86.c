@@ -25,7 +25,8 @@
 
 #include "pixman-private.h"
 
-#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3)
+#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3) || \
+    defined (USE_AVX2)
 
 /* The CPU detection code needs to be in a file not compiled with
  * "-mmmx -msse", as gcc would generate CMOV instructions otherwise
@@ -40,7 +41,8 @@ typedef enum
     X86_SSE			= (1 << 2) | X86_MMX_EXTENSIONS,
     X86_SSE2			= (1 << 3),
     X86_CMOV			= (1 << 4),
-    X86_SSSE3			= (1 << 5)
+    X86_SSSE3			= (1 << 5),
+    X86_AVX2			= (1 << 6)
 } cpu_features_t;
 
 #ifdef HAVE_GETISAX
@@ -74,6 +76,10 @@ detect_cpu_features (void)
 
 #else
 
+#if defined (_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define _PIXMAN_X86_64							\
     (defined(__amd64__) || defined(__x86_64__) || defined(_M_AMD64))
 
@@ -119,7 +125,7 @@ pixman_cpuid (uint32_t feature,
     __asm__ volatile (
         "cpuid"				"\n\t"
 	: "=a" (*a), "=b" (*b), "=c" (*c), "=d" (*d)
-	: "a" (feature));
+	: "a" (feature), "2" (0));
 #else
     /* On x86-32 we need to be careful about the handling of %ebx
      * and %esp. We can't declare either one as clobbered
@@ -134,13 +140,13 @@ pixman_cpuid (uint32_t feature,
 	"cpuid"				"\n\t"
 	"xchg %%ebx, %1"		"\n\t"
 	: "=a" (*a), "=r" (*b), "=c" (*c), "=d" (*d)
-	: "a" (feature));
+	: "a" (feature), "2" (0));
 #endif
 
 #elif defined (_MSC_VER)
     int info[4];
 
-    __cpuid (info, feature);
+    __cpuidex (info, feature, 0);
 
     *a = info[0];
     *b = info[1];
@@ -151,15 +157,38 @@ pixman_cpuid (uint32_t feature,
 #endif
 }
 
+/* The OS must save the YMM state for AVX code to be usable */
+static pixman_bool_t
+have_ymm_state (void)
+{
+#if defined (__GNUC__)
+    uint32_t lo, hi;
+
+    __asm__ volatile (
+	".byte 0x0f, 0x01, 0xd0"	"\n\t"	/* xgetbv */
+	: "=a" (lo), "=d" (hi)
+	: "c" (0));
+
+    return (lo & 6) == 6;
+#elif defined (_MSC_VER)
+    return (_xgetbv (0) & 6) == 6;
+#else
+#error Unknown compiler
+#endif
+}
+
 static cpu_features_t
 detect_cpu_features (void)
 {
     uint32_t a, b, c, d;
+    uint32_t max_leaf;
     cpu_features_t features = 0;
 
     if (!have_cpuid())
 	return features;
 
+    pixman_cpuid (0x00, &max_leaf, &b, &c, &d);
+
     /* Get feature bits */
     pixman_cpuid (0x01, &a, &b, &c, &d);
     if (d & (1 << 15))
@@ -173,6 +202,15 @@ detect_cpu_features (void)
     if (c & (1 << 9))
 	features |= X86_SSSE3;
 
+    /* AVX2 needs OSXSAVE and AVX in leaf 1, and bit 5 of leaf 7 */
+    if (max_leaf >= 7 && (c & (1 << 27)) && (c & (1 << 28)) &&
+	have_ymm_state ())
+    {
+	pixman_cpuid (0x07, &a, &b, &c, &d);
+	if (b & (1 << 5))
+	    features |= X86_AVX2;
+    }
+
     /* Check for AMD specific features */
     if ((features & X86_MMX) && !(features & X86_SSE))
     {
@@ -228,6 +266,7 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 #define MMX_BITS  (X86_MMX | X86_MMX_EXTENSIONS)
 #define SSE2_BITS (X86_MMX | X86_MMX_EXTENSIONS | X86_SSE | X86_SSE2)
 #define SSSE3_BITS (X86_SSE | X86_SSE2 | X86_SSSE3)
+#define AVX2_BITS (X86_SSE | X86_SSE2 | X86_SSSE3 | X86_AVX2)
 
 #ifdef USE_X86_MMX
     if (!_pixman_disabled ("mmx") && have_feature (MMX_BITS))
@@ -244,5 +283,10 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 	imp = _pixman_implementation_create_ssse3 (imp);
 #endif
 
+#ifdef USE_AVX2
+    if (!_pixman_disabled ("avx2") && have_feature (AVX2_BITS))
+	imp = _pixman_implementation_create_avx2 (imp);
+#endif
+
     return imp;
 }
@@ -925,6 +925,7 @@ void          pixman_image_composite32        (pixman_op_t        op,
 					       int32_t            dest_y,
 					       int32_t            width,
 					       int32_t            height);
+void          pixman_composite_set_threads    (int                n_threads);
 
 /* Executive Summary: This function is a no-op that only exists
  * for historical reasons.
@@ -0,0 +1,136 @@
+/*
+ * Composites large enough to be split into bands for the helper threads
+ * must come out exactly as they do on the calling thread alone.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define WIDTH	640
+#define HEIGHT	512
+
+static pixman_image_t *
+make_bits (pixman_format_code_t format, int width, int height)
+{
+    int stride = width * 4;
+    uint32_t *bits = malloc (stride * height);
+
+    prng_randmemset (bits, stride * height, 0);
+
+    return pixman_image_create_bits (format, width, height, bits, stride);
+}
+
+static void
+free_bits (pixman_image_t *image)
+{
+    free (pixman_image_get_data (image));
+    pixman_image_unref (image);
+}
+
+static pixman_image_t *
+make_gradient (void)
+{
+    static const pixman_gradient_stop_t stops[] =
+    {
+	{ pixman_int_to_fixed (0), { 0xffff, 0x0000, 0x0000, 0xffff } },
+	{ pixman_double_to_fixed (0.5), { 0x0000, 0xffff, 0x8000, 0x8000 } },
+	{ pixman_int_to_fixed (1), { 0x0000, 0x0000, 0xffff, 0xffff } },
+    };
+    pixman_point_fixed_t inner = { pixman_int_to_fixed (200), pixman_int_to_fixed (150) };
+    pixman_point_fixed_t outer = { pixman_int_to_fixed (300), pixman_int_to_fixed (250) };
+
+    return pixman_image_create_radial_gradient (
+	&inner, &outer, pixman_int_to_fixed (10), pixman_int_to_fixed (400),
+	stops, 3);
+}
+
+/*
+ * Run one composite into two copies of the same destination, once with
+ * the helper threads and once without, and compare the results.
+ */
+static uint32_t
+check (const char *name, pixman_op_t op,
+       pixman_image_t *src, pixman_image_t *mask, pixman_region32_t *clip)
+{
+    pixman_image_t *dest[2];
+    uint32_t crc[2];
+    int i;
+
+    dest[0] = make_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT);
+    dest[1] = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, WIDTH, HEIGHT, malloc (WIDTH * 4 * HEIGHT), WIDTH * 4);
+    memcpy (pixman_image_get_data (dest[1]), pixman_image_get_data (dest[0]),
+	    WIDTH * 4 * HEIGHT);
+
+    for (i = 0; i < 2; i++)
+    {
+	pixman_composite_set_threads (i ? 4 : 1);
+	if (clip)
+	    pixman_image_set_clip_region32 (dest[i], clip);
+	pixman_image_composite32 (op, src, mask, dest[i],
+				  3, 5, 7, 1, 0, 0, WIDTH, HEIGHT);
+	pixman_image_set_clip_region32 (dest[i], NULL);
+	crc[i] = compute_crc32_for_image (0, dest[i]);
+	free_bits (dest[i]);
+    }
+
+    if (crc[0] != crc[1])
+    {
+	printf ("%s: threaded result %08x differs from %08x\n",
+		name, crc[1], crc[0]);
+	exit (1);
+    }
+
+    return crc[0];
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_image_t *src, *mask, *gradient, *self;
+    pixman_region32_t clip;
+    pixman_transform_t transform;
+    pixman_box32_t boxes[] =
+    {
+	{ 10, 10, 300, 200 },
+	{ 320, 10, 630, 200 },
+	{ 0, 220, 640, 500 },
+    };
+
+    prng_srand (0);
+
+    src = make_bits (PIXMAN_a8r8g8b8, WIDTH + 16, HEIGHT + 16);
+    mask = make_bits (PIXMAN_a8r8g8b8, WIDTH + 16, HEIGHT + 16);
+    gradient = make_gradient ();
+
+    check ("copy", PIXMAN_OP_SRC, src, NULL, NULL);
+    check ("over", PIXMAN_OP_OVER, src, mask, NULL);
+    check ("gradient", PIXMAN_OP_OVER, gradient, mask, NULL);
+
+    pixman_transform_init_rotate (&transform, pixman_double_to_fixed (0.8),
+				  pixman_double_to_fixed (0.6));
+    pixman_transform_scale (&transform, NULL, pixman_double_to_fixed (1.7),
+			    pixman_double_to_fixed (1.3));
+    pixman_image_set_transform (src, &transform);
+    pixman_image_set_filter (src, PIXMAN_FILTER_BILINEAR, NULL, 0);
+    pixman_image_set_repeat (src, PIXMAN_REPEAT_REFLECT);
+    check ("bilinear", PIXMAN_OP_OVER, src, NULL, NULL);
+
+    pixman_region32_init_rects (&clip, boxes, 3);
+    check ("clipped", PIXMAN_OP_ADD, src, mask, &clip);
+    pixman_region32_fini (&clip);
+
+    /* Copies within one image stay on the calling thread */
+    self = make_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT);
+    pixman_composite_set_threads (4);
+    pixman_image_composite32 (PIXMAN_OP_SRC, self, NULL, self,
+			      0, 0, 0, 0, 0, 8, WIDTH, HEIGHT - 8);
+    free_bits (self);
+
+    free_bits (src);
+    free_bits (mask);
+    pixman_image_unref (gradient);
+
+    return 0;
+}
@@ -0,0 +1,677 @@
+/*
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The copyright holders make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+ * AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING
+ * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+/*
+ * Play back a trace of the composite calls of an X server, as written by
+ * the fb -picturetrace option, and time it.
+ *
+ * Each line of the trace is a composite:
+ *
+ *   C op src mask dst src_x src_y mask_x mask_y dst_x dst_y width height
+ *
+ * or a glyph run:
+ *
+ *   G op src dst mask_format n_glyphs glyph_width glyph_height width height
+ *
+ * where a picture is "-" for none, "s", "l", "r" or "c" for a solid fill
+ * or a linear, radial or conical gradient, or
+ *
+ *   b:format:width:height:repeat:filter:component_alpha[:transform]
+ *
+ * for bits, with the X Render repeat and filter values and the transform
+ * as nine integers.  Glyph runs are replayed with made up glyphs of the
+ * average size, laid out over the extents of the run.
+ *
+ * Without -1 the trace is played once for each of pixman's implementation
+ * tiers, by running this program again with PIXMAN_DISABLE set.  The
+ * calls are timed grouped by operator and formats, and the groups taking
+ * the most time are listed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define MAX_SIZE	16384
+#define MAX_CLASSES	4096
+#define MAX_IMAGES	4096
+#define N_TOP		25
+
+typedef struct
+{
+    char		   kind;	/* C or G */
+    pixman_op_t		   op;
+    pixman_image_t	  *src;
+    pixman_image_t	  *mask;
+    pixman_image_t	  *dest;
+    int16_t		   src_x, src_y, mask_x, mask_y, dest_x, dest_y;
+    uint16_t		   width, height;
+    pixman_format_code_t   mask_format;	/* of a glyph run, 0 for none */
+    int			   n_glyphs;
+    pixman_glyph_t	  *glyphs;
+    int			   class;
+} record_t;
+
+typedef struct
+{
+    char		   name[192];
+    int			   n_calls;
+    double		   n_pixels;
+    double		   seconds;
+    int			   first;	/* record */
+} class_t;
+
+typedef struct
+{
+    char		   spec[160];
+    pixman_image_t	  *image;
+} image_entry_t;
+
+typedef struct
+{
+    pixman_format_code_t   format;
+    int			   width, height;
+    uint32_t		  *bits;
+} bits_entry_t;
+
+static record_t *records;
+static int n_records, size_records;
+static int *next_in_class;
+
+static class_t classes[MAX_CLASSES];
+static int n_classes;
+
+static image_entry_t images[MAX_IMAGES];
+static int n_images;
+
+static bits_entry_t bits_pool[MAX_IMAGES];
+static int n_bits;
+
+static pixman_glyph_cache_t *glyph_cache;
+static pixman_indexed_t palette;
+
+static uint32_t *
+get_bits (pixman_format_code_t format, int width, int height, int *stride)
+{
+    int i;
+
+    *stride = ((width * PIXMAN_FORMAT_BPP (format) + 31) / 32) * 4;
+
+    for (i = 0; i < n_bits; i++)
+    {
+	if (bits_pool[i].format == format &&
+	    bits_pool[i].width == width && bits_pool[i].height == height)
+	    return bits_pool[i].bits;
+    }
+
+    if (n_bits == MAX_IMAGES)
+	return NULL;
+
+    bits_pool[n_bits].format = format;
+    bits_pool[n_bits].width = width;
+    bits_pool[n_bits].height = height;
+    bits_pool[n_bits].bits = aligned_malloc (64, (size_t)*stride * height);
+    if (!bits_pool[n_bits].bits)
+	return NULL;
+    prng_randmemset (bits_pool[n_bits].bits, (size_t)*stride * height, 0);
+
+    return bits_pool[n_bits++].bits;
+}
+
+static pixman_image_t *
+create_gradient (char kind)
+{
+    static const pixman_gradient_stop_t stops[2] =
+    {
+	{ pixman_int_to_fixed (0), { 0xffff, 0x0000, 0x0000, 0xffff } },
+	{ pixman_int_to_fixed (1), { 0x0000, 0x0000, 0xffff, 0x8000 } },
+    };
+    pixman_point_fixed_t p1 = { 0, 0 };
+    pixman_point_fixed_t p2 = { pixman_int_to_fixed (256), 0 };
+    pixman_color_t color = { 0x8000, 0x4000, 0x2000, 0x8000 };
+
+    switch (kind)
+    {
+    case 'l':
+	return pixman_image_create_linear_gradient (&p1, &p2, stops, 2);
+    case 'r':
+	return pixman_image_create_radial_gradient (&p1, &p1, 0,
+						    pixman_int_to_fixed (256),
+						    stops, 2);
+    case 'c':
+	return pixman_image_create_conical_gradient (&p1, 0, stops, 2);
+    default:
+	return pixman_image_create_solid_fill (&color);
+    }
+}
+
+static pixman_image_t *
+create_bits (const char *spec)
+{
+    static const pixman_repeat_t repeats[] =
+    {
+	PIXMAN_REPEAT_NONE, PIXMAN_REPEAT_NORMAL,
+	PIXMAN_REPEAT_PAD, PIXMAN_REPEAT_REFLECT
+    };
+    unsigned int format;
+    int width, height, repeat, filter, ca, n;
+    pixman_transform_t transform;
+    pixman_image_t *image;
+    uint32_t *bits;
+    int stride;
+
+    if (sscanf (spec, "b:%x:%d:%d:%d:%d:%d%n",
+		&format, &width, &height, &repeat, &filter, &ca, &n) != 6)
+	return NULL;
+
+    if (width <= 0 || height <= 0 || width > MAX_SIZE || height > MAX_SIZE ||
+	!pixman_format_supported_source (format))
+	return NULL;
+
+    if (!(bits = get_bits (format, width, height, &stride)))
+	return NULL;
+
+    image = pixman_image_create_bits (format, width, height, bits, stride);
+    if (!image)
+	return NULL;
+
+    if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_COLOR ||
+	PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_GRAY)
+	pixman_image_set_indexed (image, &palette);
+
+    pixman_image_set_repeat (image, repeats[repeat & 3]);
+
+    /* As fb maps them; the convolutions are rare enough not to matter */
+    pixman_image_set_filter (image, filter == 0 || filter == 2 ?
+			     PIXMAN_FILTER_NEAREST : PIXMAN_FILTER_BILINEAR,
+			     NULL, 0);
+
+    pixman_image_set_component_alpha (image, ca);
+
+    if (spec[n] == ':')
+    {
+	int m[9];
+
+	if (sscanf (spec + n, ":%d,%d,%d,%d,%d,%d,%d,%d,%d",
+		    &m[0], &m[1], &m[2], &m[3], &m[4], &m[5],
+		    &m[6], &m[7], &m[8]) == 9)
+	{
+	    int i;
+
+	    for (i = 0; i < 9; i++)
+		transform.matrix[i / 3][i % 3] = m[i];
+	    pixman_image_set_transform (image, &transform);
+	}
+    }
+
+    return image;
+}
+
+/* Pictures with the same description share one image */
+static pixman_image_t *
+get_image (const char *spec, pixman_bool_t *failed)
+{
+    pixman_image_t *image;
+    int i;
+
+    if (strcmp (spec, "-") == 0)
+	return NULL;
+
+    for (i = 0; i < n_images; i++)
+    {
+	if (strcmp (images[i].spec, spec) == 0)
+	    return images[i].image;
+    }
+
+    if (spec[0] == 'b')
+	image = create_bits (spec);
+    else
+	image = create_gradient (spec[0]);
+
+    if (!image || n_images == MAX_IMAGES)
+    {
+	*failed = TRUE;
+	return image;
+    }
+
+    snprintf (images[n_images].spec, sizeof (images[n_images].spec),
+	      "%s", spec);
+    images[n_images++].image = image;
+
+    return image;
+}
+
+static void
+describe (char *buf, size_t size, const char *spec)
+{
+    unsigned int format = 0;
+    int repeat = 0;
+
+    switch (spec[0])
+    {
+    case '-':
+	snprintf (buf, size, "-");
+	break;
+    case 's':
+	snprintf (buf, size, "solid");
+	break;
+    case 'l':
+	snprintf (buf, size, "linear");
+	break;
+    case 'r':
+	snprintf (buf, size, "radial");
+	break;
+    case 'c':
+	snprintf (buf, size, "conical");
+	break;
+    default:
+	sscanf (spec, "b:%x:%*d:%*d:%d", &format, &repeat);
+	snprintf (buf, size, "%s%s%s", format_name (format),
+		  repeat ? "/repeat" : "",
+		  strchr (spec + 2, ',') ? "/transform" : "");
+	break;
+    }
+}
+
+static int
+get_class (const char *name)
+{
+    int i;
+
+    for (i = 0; i < n_classes; i++)
+    {
+	if (strcmp (classes[i].name, name) == 0)
+	    return i;
+    }
+
+    if (n_classes == MAX_CLASSES)
+	return MAX_CLASSES - 1;
+
+    snprintf (classes[n_classes].name, sizeof (classes[n_classes].name),
+	      "%s", name);
+    classes[n_classes].first = -1;
+
+    return n_classes++;
+}
+
+static pixman_glyph_t *
+make_glyphs (pixman_format_code_t format, int n, int gw, int gh,
+	     int width, int height)
+{
+    pixman_glyph_t *glyphs;
+    const void *glyph;
+    uintptr_t key;
+    int i, x, y;
+
+    if (gw <= 0 || gh <= 0 || gw > 256 || gh > 256)
+	return NULL;
+    if (!format || !pixman_format_supported_source (format))
+	format = PIXMAN_a8;
+
+    /* One made up glyph of each size and format */
+    key = ((uintptr_t)format << 16) | (gw << 8) | gh;
+
+    pixman_glyph_cache_freeze (glyph_cache);
+    if (!(glyph = pixman_glyph_cache_lookup (glyph_cache, NULL, (void *)key)))
+    {
+	pixman_image_t *image;
+	int stride;
+	uint32_t *bits = get_bits (format, gw, gh, &stride);
+
+	if (!bits ||
+	    !(image = pixman_image_create_bits (format, gw, gh, bits, stride)))
+	{
+	    pixman_glyph_cache_thaw (glyph_cache);
+	    return NULL;
+	}
+	glyph = pixman_glyph_cache_insert (glyph_cache, NULL, (void *)key,
+					   0, 0, image);
+	pixman_image_unref (image);
+    }
+    pixman_glyph_cache_thaw (glyph_cache);
+
+    if (!glyph || !(glyphs = malloc (n * sizeof (pixman_glyph_t))))
+	return NULL;
+
+    x = y = 0;
+    for (i = 0; i < n; i++)
+    {
+	if (x + gw > width && x > 0)
+	{
+	    x = 0;
+	    y += gh;
+	    if (y + gh > height)
+		y = 0;
+	}
+	glyphs[i].x = x;
+	glyphs[i].y = y;
+	glyphs[i].glyph = glyph;
+	x += gw;
+    }
+
+    return glyphs;
+}
+
+static pixman_bool_t
+parse_line (char *line, record_t *r)
+{
+    char src[160], mask[160], dest[160], name[192];
+    char src_name[48], mask_name[48], dest_name[48];
+    pixman_bool_t failed = FALSE;
+    int op, v[8];
+
+    memset (r, 0, sizeof (*r));
+
+    if (sscanf (line, "C %d %159s %159s %159s %d %d %d %d %d %d %d %d",
+		&op, src, mask, dest,
+		&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) == 12)
+    {
+	r->kind = 'C';
+	r->src_x = v[0];
+	r->src_y = v[1];
+	r->mask_x = v[2];
+	r->mask_y = v[3];
+	r->dest_x = v[4];
+	r->dest_y = v[5];
+	r->width = v[6];
+	r->height = v[7];
+	r->mask = get_image (mask, &failed);
+    }
+    else if (sscanf (line, "G %d %159s %159s %159s %d %d %d %d %d",
+		     &op, src, dest, mask,
+		     &v[0], &v[1], &v[2], &v[3], &v[4]) == 9)
+    {
+	unsigned int format = 0;
+
+	if (strcmp (mask, "-") != 0)
+	    sscanf (mask, "%x", &format);
+
+	r->kind = 'G';
+	r->mask_format = format;
+	r->n_glyphs = v[0];
+	r->width = v[3];
+	r->height = v[4];
+	r->glyphs = make_glyphs (r->mask_format, r->n_glyphs, v[1], v[2],
+				 v[3], v[4]);
+	if (!r->glyphs)
+	    return FALSE;
+	if (format)
+	    snprintf (mask, sizeof (mask), "b:%08x", format);
+    }
+    else
+    {
+	return FALSE;
+    }
+
+    r->op = op;
+    r->src = get_image (src, &failed);
+    r->dest = get_image (dest, &failed);
+    if (failed || !r->src || !r->dest ||
+	!pixman_format_supported_destination (
+	    pixman_image_get_format (r->dest)))
+    {
+	free (r->glyphs);
+	return FALSE;
+    }
+
+    describe (src_name, sizeof (src_name), src);
+    describe (mask_name, sizeof (mask_name), mask);
+    describe (dest_name, sizeof (dest_name), dest);
+    snprintf (name, sizeof (name), "%s %-14s %s %s %s",
+	      r->kind == 'G' ? "glyphs   " : "composite",
+	      operator_name (r->op), src_name, mask_name, dest_name);
+    r->class = get_class (name);
+
+    return TRUE;
+}
+
+static int
+load_trace (const char *filename)
+{
+    char line[1024];
+    int n_skipped = 0;
+    FILE *f;
+
+    if (!(f = fopen (filename, "r")))
+    {
+	printf ("Cannot open %s\n", filename);
+	return -1;
+    }
+
+    while (fgets (line, sizeof (line), f))
+    {
+	if (line[0] == '#' || line[0] == '\n')
+	    continue;
+
+	if (n_records == size_records)
+	{
+	    size_records = size_records ? 2 * size_records : 4096;
+	    records = realloc (records, size_records * sizeof (record_t));
+	    if (!records)
+	    {
+		printf ("Out of memory\n");
+		fclose (f);
+		return -1;
+	    }
+	}
+
+	if (parse_line (line, &records[n_records]))
+	    n_records++;
+	else
+	    n_skipped++;
+    }
+
+    fclose (f);
+    return n_skipped;
+}
+
+static void
+play (const record_t *r)
+{
+    if (r->kind == 'C')
+    {
+	pixman_image_composite (r->op, r->src, r->mask, r->dest,
+				r->src_x, r->src_y, r->mask_x, r->mask_y,
+				r->dest_x, r->dest_y, r->width, r->height);
+    }
+    else if (r->mask_format)
+    {
+	pixman_composite_glyphs (r->op, r->src, r->dest, r->mask_format,
+				 0, 0, 0, 0, 0, 0, r->width, r->height,
+				 glyph_cache, r->n_glyphs, r->glyphs);
+    }
+    else
+    {
+	pixman_composite_glyphs_no_mask (r->op, r->src, r->dest, 0, 0, 0, 0,
+					 glyph_cache, r->n_glyphs, r->glyphs);
+    }
+}
+
+static int
+compare_classes (const void *a, const void *b)
+{
+    const class_t *ca = a, *cb = b;
+
+    return ca->seconds < cb->seconds ? 1 : ca->seconds > cb->seconds ? -1 : 0;
+}
+
+static void
+bench (int n_passes)
+{
+    double t, total, pixels = 0;
+    int i, c, pass;
+
+    /* Chain the records of each class, to time the classes one by one */
+    next_in_class = malloc (n_records * sizeof (int));
+    for (i = n_records - 1; i >= 0; i--)
+    {
+	class_t *cl = &classes[records[i].class];
+
+	next_in_class[i] = cl->first;
+	cl->first = i;
+	cl->n_calls++;
+	cl->n_pixels += (double)records[i].width * records[i].height;
+	pixels += (double)records[i].width * records[i].height;
+    }
+
+    /* Warm up the caches and the glyph masks */
+    for (i = 0; i < n_records; i++)
+	play (&records[i]);
+
+    t = gettime ();
+    for (pass = 0; pass < n_passes; pass++)
+    {
+	for (i = 0; i < n_records; i++)
+	    play (&records[i]);
+    }
+    total = (gettime () - t) / n_passes;
+
+    for (c = 0; c < n_classes; c++)
+    {
+	t = gettime ();
+	for (pass = 0; pass < n_passes; pass++)
+	{
+	    for (i = classes[c].first; i >= 0; i = next_in_class[i])
+		play (&records[i]);
+	}
+	classes[c].seconds = (gettime () - t) / n_passes;
+    }
+
+    qsort (classes, n_classes, sizeof (class_t), compare_classes);
+
+    printf ("%d calls, %.1f Mpixels: %.3f ms per pass, %.1f Mpixels/s\n",
+	    n_records, pixels / 1e6, total * 1e3,
+	    total > 0 ? pixels / total / 1e6 : 0.);
+
+    for (c = 0; c < n_classes && c < N_TOP; c++)
+    {
+	printf ("  %6.2f%% %9.3f ms %8d calls %9.1f Mpix/s  %s\n",
+		total > 0 ? 100. * classes[c].seconds / total : 0.,
+		classes[c].seconds * 1e3, classes[c].n_calls,
+		classes[c].seconds > 0 ?
+		classes[c].n_pixels / classes[c].seconds / 1e6 : 0.,
+		classes[c].name);
+    }
+
+    free (next_in_class);
+}
+
+static const struct
+{
+    const char *name;
+    const char *disable;
+} tiers[] =
+{
+    { "general", "PIXMAN_DISABLE=fast mmx sse2 ssse3 avx2" },
+    { "fast",    "PIXMAN_DISABLE=mmx sse2 ssse3 avx2" },
+    { "sse2",    "PIXMAN_DISABLE=ssse3 avx2" },
+    { "ssse3",   "PIXMAN_DISABLE=avx2" },
+    { "avx2",    "PIXMAN_DISABLE=" },
+};
+
+static int
+run_tiers (const char *self, const char *filename, int n_passes)
+{
+    char cmd[4096];
+    int i;
+
+    for (i = 0; i < (int)(sizeof (tiers) / sizeof (tiers[0])); i++)
+    {
+	printf ("=== %s ===\n", tiers[i].name);
+	fflush (stdout);
+
+	putenv ((char *)tiers[i].disable);
+#ifdef _WIN32
+	/* cmd.exe drops the outer quotes */
+	snprintf (cmd, sizeof (cmd), "\"\"%s\" -1 -n %d \"%s\"\"",
+		  self, n_passes, filename);
+#else
+	snprintf (cmd, sizeof (cmd), "\"%s\" -1 -n %d \"%s\"",
+		  self, n_passes, filename);
+#endif
+	if (system (cmd) != 0)
+	    return 1;
+    }
+
+    return 0;
+}
+
+static void
+usage (const char *name)
+{
+    printf ("usage: %s [-1] [-n passes] trace\n"
+	    "  Play back a trace written by the X server -picturetrace option\n"
+	    "  -1         only with the implementations PIXMAN_DISABLE leaves\n"
+	    "             on, rather than once for each tier\n"
+	    "  -n passes  times to play the trace, default 10\n", name);
+}
+
+int
+main (int argc, char *argv[])
+{
+    const char *filename = NULL;
+    pixman_bool_t once = FALSE;
+    int n_passes = 10;
+    int i, n_skipped;
+
+    for (i = 1; i < argc; i++)
+    {
+	if (strcmp (argv[i], "-1") == 0)
+	    once = TRUE;
+	else if (strcmp (argv[i], "-n") == 0 && i + 1 < argc)
+	    n_passes = atoi (argv[++i]);
+	else if (argv[i][0] != '-' && !filename)
+	    filename = argv[i];
+	else
+	{
+	    usage (argv[0]);
+	    return 1;
+	}
+    }
+
+    if (!filename || n_passes <= 0)
+    {
+	usage (argv[0]);
+	return 1;
+    }
+
+    if (!once)
+	return run_tiers (argv[0], filename, n_passes);
+
+    prng_srand (0);
+    initialize_palette (&palette, 8, TRUE);
+    glyph_cache = pixman_glyph_cache_create ();
+
+    n_skipped = load_trace (filename);
+    if (n_skipped < 0)
+	return 1;
+    if (n_skipped)
+	printf ("Skipped %d calls which could not be played back\n", n_skipped);
+    if (!n_records)
+	return 1;
+
+    bench (n_passes);
+
+    return 0;
+}
@@ -43,7 +43,16 @@
 #include <_ptw32.h>
 
 #if !defined(_WIN32_WINNT)
-# define _WIN32_WINNT 0x0400
+# define _WIN32_WINNT 0x0601
+#endif
+
+/*
+ * From Windows 7 on, normal mutexes are slim reader/writer locks, and
+ * condition variables waited on with them the native ones.  The other
+ * mutex kinds still need the owner and count kept here.
+ */
+#if _WIN32_WINNT >= 0x0601 && !defined(WINCE)
+# define __PTW32_NATIVE_SYNC 1
 #endif
 
 #define WIN32_LEAN_AND_MEAN
@@ -274,6 +283,10 @@ struct pthread_mutex_t_
 				   threads. */
   __ptw32_robust_node_t*
                     robustNode; /* Extra state for robust mutexes  */
+#if defined(__PTW32_NATIVE_SYNC)
+  SRWLOCK srw;			/* The lock itself, for normal mutexes;
+				   lock_idx is then only 0 or 1. */
+#endif
 };
 
 enum __ptw32_robust_state_t_
@@ -398,6 +411,9 @@ struct pthread_cond_t_
   /* +-> Optional* Sync.LEVEL-2           */
   pthread_cond_t next;		/* Doubly linked list                   */
   pthread_cond_t prev;
+#if defined(__PTW32_NATIVE_SYNC)
+  CONDITION_VARIABLE native;	/* Waiters with a normal mutex          */
+#endif
 };
 
 
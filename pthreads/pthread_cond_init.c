@@ -98,6 +98,9 @@ pthread_cond_init (pthread_cond_t * cond, const pthread_condattr_t * attr)
     }
 
   cv->nWaitersBlocked = 0;
+#if defined(__PTW32_NATIVE_SYNC)
+  InitializeConditionVariable (&cv->native);
+#endif
   cv->nWaitersToUnblock = 0;
   cv->nWaitersGone = 0;
 
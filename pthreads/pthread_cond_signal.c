@@ -86,6 +86,20 @@ __ptw32_cond_unblock (pthread_cond_t * cond, int unblockAll)
       return 0;
     }
 
+#if defined(__PTW32_NATIVE_SYNC)
+  /*
+   * Wake waiters with a normal mutex; the others, if any, below.
+   */
+  if (unblockAll)
+    {
+      WakeAllConditionVariable (&cv->native);
+    }
+  else
+    {
+      WakeConditionVariable (&cv->native);
+    }
+#endif
+
   if ((result = pthread_mutex_lock (&(cv->mtxUnblockLock))) != 0)
     {
       return result;
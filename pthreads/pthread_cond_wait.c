@@ -351,6 +351,35 @@ __ptw32_cond_wait_cleanup (void *args)
     }
 }				/* __ptw32_cond_wait_cleanup */
 
+#if defined(__PTW32_NATIVE_SYNC)
+static INLINE int
+__ptw32_cond_native_timedwait (pthread_cond_t cv,
+			       pthread_mutex_t mx, const struct timespec *abstime)
+{
+  DWORD milliseconds;
+  int result = 0;
+
+  /*
+   * Still a cancellation point, though only on the way in and out.
+   */
+  pthread_testcancel ();
+
+  milliseconds = (abstime == NULL) ? INFINITE : __ptw32_relmillisecs (abstime);
+
+  if (!SleepConditionVariableSRW (&cv->native, &mx->srw, milliseconds, 0))
+    {
+      result = (GetLastError () == ERROR_TIMEOUT) ? ETIMEDOUT : EINVAL;
+    }
+
+  /* The SRW lock is held again, whoever held it meanwhile */
+  mx->lock_idx = 1;
+
+  pthread_testcancel ();
+
+  return result;
+}
+#endif
+
 static INLINE int
 __ptw32_cond_timedwait (pthread_cond_t * cond,
 		      pthread_mutex_t * mutex, const struct timespec *abstime)
@@ -382,6 +411,17 @@ __ptw32_cond_timedwait (pthread_cond_t * cond,
 
   cv = *cond;
 
+#if defined(__PTW32_NATIVE_SYNC)
+  /*
+   * The caller holds the mutex, so it has been initialised.
+   */
+  if (*mutex < PTHREAD_ERRORCHECK_MUTEX_INITIALIZER
+      && PTHREAD_MUTEX_NORMAL == (*mutex)->kind)
+    {
+      return __ptw32_cond_native_timedwait (cv, *mutex, abstime);
+    }
+#endif
+
   /* Thread can be cancelled in sem_wait() but this is OK */
   if (sem_wait (&(cv->semBlockLock)) != 0)
     {
@@ -84,7 +84,7 @@ pthread_mutex_destroy (pthread_mutex_t * mutex)
                     {
                       free(mx->robustNode);
                     }
-		  if (!CloseHandle (mx->event))
+		  if (mx->event != NULL && !CloseHandle (mx->event))
 		    {
 		      *mutex = mx;
 		      result = EINVAL;
@@ -123,14 +123,26 @@ pthread_mutex_init (pthread_mutex_t * mutex, const pthread_mutexattr_t * attr)
 	{
 	  mx->ownerThread.p = NULL;
 
-	  mx->event = CreateEvent (NULL,  __PTW32_FALSE,    /* manual reset = No */
-				    __PTW32_FALSE,           /* initial state = not signalled */
-				   NULL);                 /* event name */
+#if defined(__PTW32_NATIVE_SYNC)
+	  InitializeSRWLock (&mx->srw);
 
-	  if (0 == mx->event)
+	  /* Waiters for a normal mutex wait on the SRW lock */
+	  if (PTHREAD_MUTEX_NORMAL == mx->kind)
 	    {
-	      result = ENOSPC;
+	      mx->event = NULL;
 	    }
+	  else
+#endif
+	  {
+	    mx->event = CreateEvent (NULL,  __PTW32_FALSE,    /* manual reset = No */
+				      __PTW32_FALSE,           /* initial state = not signalled */
+				     NULL);                 /* event name */
+
+	    if (0 == mx->event)
+	      {
+	        result = ENOSPC;
+	      }
+	  }
 	}
     }
 
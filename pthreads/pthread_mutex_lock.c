@@ -74,6 +74,15 @@ pthread_mutex_lock (pthread_mutex_t * mutex)
 
   kind = mx->kind;
 
+#if defined(__PTW32_NATIVE_SYNC)
+  if (PTHREAD_MUTEX_NORMAL == kind)
+    {
+      AcquireSRWLockExclusive (&mx->srw);
+      mx->lock_idx = 1;
+      return 0;
+    }
+#endif
+
   if (kind >= 0)
     {
       /* Non-robust */
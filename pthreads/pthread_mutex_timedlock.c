@@ -139,6 +139,23 @@ pthread_mutex_timedlock (pthread_mutex_t * mutex,
 
   kind = mx->kind;
 
+#if defined(__PTW32_NATIVE_SYNC)
+  if (PTHREAD_MUTEX_NORMAL == kind)
+    {
+      /* There is no timed acquire of an SRW lock */
+      while (!TryAcquireSRWLockExclusive (&mx->srw))
+	{
+	  if (abstime != NULL && __ptw32_relmillisecs (abstime) == 0)
+	    {
+	      return ETIMEDOUT;
+	    }
+	  Sleep (1);
+	}
+      mx->lock_idx = 1;
+      return 0;
+    }
+#endif
+
   if (kind >= 0)
     {
       if (mx->kind == PTHREAD_MUTEX_NORMAL)
@@ -72,6 +72,18 @@ pthread_mutex_trylock (pthread_mutex_t * mutex)
 
   kind = mx->kind;
 
+#if defined(__PTW32_NATIVE_SYNC)
+  if (PTHREAD_MUTEX_NORMAL == kind)
+    {
+      if (!TryAcquireSRWLockExclusive (&mx->srw))
+	{
+	  return EBUSY;
+	}
+      mx->lock_idx = 1;
+      return 0;
+    }
+#endif
+
   if (kind >= 0)
     {
       /* Non-robust */
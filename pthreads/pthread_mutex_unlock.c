@@ -59,6 +59,22 @@ pthread_mutex_unlock (pthread_mutex_t * mutex)
     {
       kind = mx->kind;
 
+#if defined(__PTW32_NATIVE_SYNC)
+      if (kind == PTHREAD_MUTEX_NORMAL)
+        {
+          /*
+           * Releasing an SRW lock nobody holds raises an exception, where
+           * unlocking an unlocked normal mutex used to be harmless.
+           */
+          if (__PTW32_INTERLOCKED_EXCHANGE_LONG ((__PTW32_INTERLOCKED_LONGPTR)&mx->lock_idx,
+                                                 (__PTW32_INTERLOCKED_LONG)0) != 0)
+            {
+              ReleaseSRWLockExclusive (&mx->srw);
+            }
+          return 0;
+        }
+#endif
+
       if (kind >= 0)
         {
           if (kind == PTHREAD_MUTEX_NORMAL)
@@ -0,0 +1,184 @@
+/*
+ * benchtest6.c
+ *
+ *
+ * --------------------------------------------------------------------------
+ *
+ *      Pthreads4w - POSIX Threads for Windows
+ *      Copyright 1998 John E. Bossom
+ *      Copyright 1999-2018, Pthreads4w contributors
+ *
+ *      Homepage: https://sourceforge.net/projects/pthreads4w/
+ *
+ *      The current list of contributors is contained
+ *      in the file CONTRIBUTORS included with the source
+ *      code distribution. The list can also be seen at the
+ *      following World Wide Web location:
+ *
+ *      https://sourceforge.net/p/pthreads4w/wiki/Contributors/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * --------------------------------------------------------------------------
+ *
+ * Measure time taken to complete an elementary operation.
+ *
+ * - Mutex and condition variable
+ *   Two threads handing a token back and forth, each hand-over being
+ *   a signal and a wait on a condition variable, and two threads
+ *   contending for the same mutex.
+ */
+
+#include "test.h"
+
+#ifdef __GNUC__
+#include <stdlib.h>
+#endif
+
+#include "benchtest.h"
+
+#define ITERATIONS      100000L
+
+pthread_mutex_t mx;
+pthread_cond_t cv;
+int mxType = -1;
+long turn;
+
+__PTW32_STRUCT_TIMEB currSysTimeStart;
+__PTW32_STRUCT_TIMEB currSysTimeStop;
+long durationMilliSecs;
+
+#define GetDurationMilliSecs(_TStart, _TStop) ((long)((_TStop.time*1000+_TStop.millitm) \
+                                               - (_TStart.time*1000+_TStart.millitm)))
+
+
+void
+reportTest (char * testNameString)
+{
+  durationMilliSecs = GetDurationMilliSecs(currSysTimeStart, currSysTimeStop);
+
+  printf( "%-45s %15ld %15.3f\n",
+	    testNameString,
+          durationMilliSecs,
+          (float) durationMilliSecs * 1E3 / ITERATIONS);
+}
+
+
+/*
+ * Wait for our turn (even or odd), then hand it to the other thread.
+ */
+void *
+pingpong(void * arg)
+{
+  long parity = (long) (size_t) arg;
+  long i;
+
+  assert(pthread_mutex_lock(&mx) == 0);
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      while ((turn & 1) != parity)
+        assert(pthread_cond_wait(&cv, &mx) == 0);
+      turn++;
+      assert(pthread_cond_signal(&cv) == 0);
+    }
+  assert(pthread_mutex_unlock(&mx) == 0);
+
+  return NULL;
+}
+
+void *
+contend(void * arg)
+{
+  long i;
+
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      assert(pthread_mutex_lock(&mx) == 0);
+      turn++;
+      assert(pthread_mutex_unlock(&mx) == 0);
+    }
+
+  return NULL;
+}
+
+void
+runTwoThreads (void * (*func)(void *))
+{
+  pthread_mutexattr_t ma;
+  pthread_t t[2];
+
+  assert(pthread_mutexattr_init(&ma) == 0);
+  assert(pthread_mutexattr_settype(&ma, mxType) == 0);
+  assert(pthread_mutex_init(&mx, &ma) == 0);
+  assert(pthread_mutexattr_destroy(&ma) == 0);
+  assert(pthread_cond_init(&cv, NULL) == 0);
+  turn = 0;
+
+  __PTW32_FTIME(&currSysTimeStart);
+  assert(pthread_create(&t[0], NULL, func, (void *) 0) == 0);
+  assert(pthread_create(&t[1], NULL, func, (void *) 1) == 0);
+  assert(pthread_join(t[0], NULL) == 0);
+  assert(pthread_join(t[1], NULL) == 0);
+  __PTW32_FTIME(&currSysTimeStop);
+
+  assert(turn == 2 * ITERATIONS);
+  assert(pthread_cond_destroy(&cv) == 0);
+  assert(pthread_mutex_destroy(&mx) == 0);
+}
+
+
+void
+runTest (char * testNameString, int mType)
+{
+  char name[64];
+
+  mxType = mType;
+
+  runTwoThreads(pingpong);
+  sprintf(name, "%s hand-over", testNameString);
+  reportTest(name);
+
+  runTwoThreads(contend);
+  sprintf(name, "%s contended lock", testNameString);
+  reportTest(name);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  printf( "=============================================================================\n");
+  printf( "\nTwo threads sharing a mutex and condition variable.\n%ld iterations each\n\n",
+          ITERATIONS);
+  printf( "%-45s %15s %15s\n",
+	    "Test",
+	    "Total(msec)",
+	    "average(usec)");
+  printf( "-----------------------------------------------------------------------------\n");
+
+  /*
+   * The normal mutex is the one backed by a native lock where the
+   * library was built for it; the others show the portable path.
+   */
+  runTest("PTHREAD_MUTEX_NORMAL", PTHREAD_MUTEX_NORMAL);
+  runTest("PTHREAD_MUTEX_ERRORCHECK", PTHREAD_MUTEX_ERRORCHECK);
+  runTest("PTHREAD_MUTEX_RECURSIVE", PTHREAD_MUTEX_RECURSIVE);
+
+  printf( "=============================================================================\n");
+
+  /*
+   * End of tests.
+   */
+
+  return 0;
+}
@@ -54,7 +54,7 @@ ALL_KNOWN_TESTS = \
 TESTS = $(ALL_KNOWN_TESTS)
 
 BENCHTESTS = \
-	benchtest1 benchtest2 benchtest3 benchtest4 benchtest5
+	benchtest1 benchtest2 benchtest3 benchtest4 benchtest5 benchtest6
 
 # Output useful info if no target given. I.e. the first target that "make" sees is used in this case.
 default_target: help
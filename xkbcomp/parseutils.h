@@ -185,6 +185,11 @@ extern int XKBParseFile(FILE * /* file */ ,
                         XkbFile **      /* pRtrn */
     );
 
+extern int XKBParseString(const char * /* string */ ,
+                          size_t /* length */ ,
+                          XkbFile **    /* pRtrn */
+    );
+
 extern XkbFile *CreateXKBFile(int /* type */ ,
                               char * /* name */ ,
                               ParseCommon * /* defs */ ,
@@ -199,6 +204,7 @@ extern int yywrap(void);
 extern int yylex(void);
 extern int yyparse(void);
 extern void scan_set_file(FILE *file);
+extern void scan_set_string(const char *string, size_t length);
 
 extern int setScanState(char * /* file */ ,
                         int     /* line */
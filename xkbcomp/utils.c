@@ -149,6 +149,7 @@ static int outCount = 0;
 static char *preMsg = NULL;
 static char *postMsg = NULL;
 static char *prefix = NULL;
+static jmp_buf *fatalJump = NULL;
 
 Boolean
 uSetErrorFile(char *name)
@@ -253,6 +254,8 @@ uFatalError(const char *s, ...)
     fprintf(errorFile, "                  Exiting\n");
     fflush(errorFile);
     outCount++;
+    if (fatalJump)
+        longjmp(*fatalJump, 1);
     exit(1);
     /* NOTREACHED */
 }
@@ -298,6 +301,14 @@ uSetErrorPrefix(char *pre)
     return;
 }
 
+/* Make fatal errors return to jump instead of exiting, NULL restores exit */
+void
+uSetFatalJump(jmp_buf *jump)
+{
+    fatalJump = jump;
+    return;
+}
+
 void
 uFinishUp(void)
 {
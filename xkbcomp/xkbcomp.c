@@ -890,6 +890,102 @@ GetDisplay(char *program, char *dpyName)
 extern int yydebug;
 #endif
 
+#ifdef XKBCOMP_LIBRARY
+
+/**
+ * Library entry point used by the X server to compile a keymap without
+ * starting a process.  Compiles the length bytes of keymap source in
+ * keymap, looking up included files below root, and writes the result as
+ * an XKM file to outputFile.  Fatal errors return here instead of exiting.
+ * Returns 0 on success, like the exit status of xkbcomp.
+ */
+int
+XkbCompCompileKeymap(const char *keymap, size_t length, const char *root,
+                     int warnLevel, const char *outputPath)
+{
+    static Bool initialized = False;
+    static XkbFileInfo result;
+    jmp_buf fatal;
+    XkbFile *rtrn, *mapToUse;
+    FILE *out;
+    volatile int ok = False;
+
+    if (!initialized)
+    {
+        uSetDebugFile(NullString);
+        uSetErrorFile(NullString);
+        if (!XkbInitIncludePath())
+            return 1;
+        XkbInitAtoms(NULL);
+        initialized = True;
+    }
+    if (!rootDir || !uStringEqual(rootDir, root))
+    {
+        /* included files are cached by name, keep them for the same root */
+        XkbAddDirectoryToPath(NULL);
+        XkbAddDirectoryToPath(root);
+        uFree(rootDir);
+        rootDir = uStringDup(root);
+    }
+    warningLevel = warnLevel;
+    bzero((char *) &result, sizeof(result));
+
+    uSetFatalJump(&fatal);
+    if (setjmp(fatal) == 0)
+    {
+        setScanState("keymap", 1);
+        if (XKBParseString(keymap, length, &rtrn) && (rtrn != NULL))
+        {
+            for (mapToUse = rtrn; mapToUse;
+                 mapToUse = (XkbFile *) mapToUse->common.next)
+            {
+                if (mapToUse->flags & XkbLC_Default)
+                    break;
+            }
+            if (!mapToUse)
+                mapToUse = rtrn;
+            result.type = mapToUse->type;
+            if ((result.xkb = XkbAllocKeyboard()) == NULL)
+                WSGO("Cannot allocate keyboard description\n");
+            else if (mapToUse->type == XkmSemanticsFile ||
+                     mapToUse->type == XkmLayoutFile ||
+                     mapToUse->type == XkmKeymapFile)
+                ok = CompileKeymap(mapToUse, &result, MergeReplace);
+            else
+                WSGO1("Unknown file type %d\n", mapToUse->type);
+        }
+        if (ok)
+        {
+            result.xkb->device_spec = XkbUseCoreKbd;
+            unlink(outputPath);
+            out = fopen(outputPath, "wb");
+            if (out == NULL)
+            {
+                ERROR1("Cannot open \"%s\" to write keyboard description\n",
+                       outputPath);
+                ok = False;
+            }
+            else
+            {
+                ok = XkbWriteXKMFile(out, &result);
+                if (fclose(out))
+                    ok = False;
+                if (!ok)
+                    unlink(outputPath);
+            }
+        }
+    }
+    uSetFatalJump(NULL);
+    uFinishUp();
+
+    if (result.xkb)
+        XkbFreeKeyboard(result.xkb, XkbAllComponentsMask, True);
+    result.xkb = NULL;
+    return (ok == 0);
+}
+
+#else
+
 int
 main(int argc, char *argv[])
 {
@@ -1247,3 +1343,5 @@ main(int argc, char *argv[])
     uFinishUp();
     return (ok == 0);
 }
+
+#endif /* XKBCOMP_LIBRARY */
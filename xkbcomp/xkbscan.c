@@ -53,6 +53,8 @@ static int scanStrLine = 0;
 static char readBuf[BUFSIZE];
 static int readBufPos = 0;
 static int readBufLen = 0;
+static const char *readString = NULL;
+static size_t readStringLen = 0;
 
 #ifdef DEBUG
 extern unsigned int debugFlags;
@@ -275,13 +277,35 @@ scan_set_file(FILE *file)
 {
     readBufLen = 0;
     readBufPos = 0;
+    readString = NULL;
+    readStringLen = 0;
     yyin = file;
 }
 
+/* Scan length bytes of string instead of a file */
+void
+scan_set_string(const char *string, size_t length)
+{
+    readBufLen = 0;
+    readBufPos = 0;
+    readString = string;
+    readStringLen = length;
+    yyin = NULL;
+}
+
 static int
 scanchar(void)
 {
-    if (readBufPos >= readBufLen) {
+    if (readBufPos >= readBufLen && yyin == NULL) {
+        readBufLen = readStringLen > BUFSIZE ? BUFSIZE : readStringLen;
+        memcpy(readBuf, readString, readBufLen);
+        readString += readBufLen;
+        readStringLen -= readBufLen;
+        readBufPos = 0;
+        if (!readBufLen)
+            return EOF;
+    }
+    else if (readBufPos >= readBufLen) {
         readBufLen = fread(readBuf, 1, BUFSIZE, yyin);
         readBufPos = 0;
         if (!readBufLen)
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * IMAGE-DELTA: tiled PutImage against a base drawable, so that clients
+ * mirroring a changing image only send the tiles that changed.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <X11/X.h>
+#include <X11/Xproto.h>
+#include "misc.h"
+#include "os.h"
+#include "dixstruct.h"
+#include "scrnintstr.h"
+#include "pixmapstr.h"
+#include "gcstruct.h"
+#include "regionstr.h"
+#include "extnsionst.h"
+#include "servermd.h"
+#include "swaprep.h"
+#include <X11/extensions/imagedeltaproto.h>
+#include "extinit.h"
+
+static int
+ProcImageDeltaQueryVersion(ClientPtr client)
+{
+    xImageDeltaQueryVersionReply rep = {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = 0,
+        .majorVersion = ImageDeltaMajorVersion,
+        .minorVersion = ImageDeltaMinorVersion
+    };
+
+    REQUEST_SIZE_MATCH(xImageDeltaQueryVersionReq);
+
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swaps(&rep.majorVersion);
+        swaps(&rep.minorVersion);
+    }
+    WriteToClient(client, sizeof(xImageDeltaQueryVersionReply), &rep);
+    return Success;
+}
+
+/* The GC for Xor tiles: gc's clip and plane mask, with function GXxor. */
+static GCPtr
+ImageDeltaXorGC(DrawablePtr pDraw, GCPtr pGC)
+{
+    ChangeGCVal val = { .val = GXxor };
+    GCPtr pXorGC = GetScratchGC(pDraw->depth, pDraw->pScreen);
+
+    if (!pXorGC)
+        return NULL;
+    if (CopyGC(pGC, pXorGC, GCPlaneMask | GCSubwindowMode |
+               GCClipXOrigin | GCClipYOrigin | GCClipMask) != Success ||
+        ChangeGC(NullClient, pXorGC, GCFunction, &val) != Success) {
+        FreeScratchGC(pXorGC);
+        return NULL;
+    }
+    ValidateGC(pDraw, pXorGC);
+    return pXorGC;
+}
+
+/*
+ * Where a tile's row or column starts, if that is a valid coordinate.
+ * index and size both come from the client, so their product can take
+ * more than an int.
+ */
+static Bool
+ImageDeltaTileOrigin(int origin, int index, int size, int *pos)
+{
+    int64_t p = origin + (int64_t) index * size;
+
+    if (p < MINSHORT || p > MAXSHORT)
+        return FALSE;
+    *pos = p;
+    return TRUE;
+}
+
+static int
+ProcImageDeltaPutTiles(ClientPtr client)
+{
+    GC *pGC, *pXorGC = NULL;
+    DrawablePtr pDraw, pBase;
+    xImageDeltaTile *tile;
+    char *data, *end;
+    long length, size;
+    int i, x, y, bx, by, rc;
+
+    REQUEST(xImageDeltaPutTilesReq);
+
+    REQUEST_AT_LEAST_SIZE(xImageDeltaPutTilesReq);
+    VALIDATE_DRAWABLE_AND_GC(stuff->drawable, pDraw, DixWriteAccess);
+    if (stuff->depth != pDraw->depth)
+        return BadMatch;
+    if (stuff->base == None)
+        pBase = pDraw;
+    else {
+        rc = dixLookupDrawable(&pBase, stuff->base, client, 0,
+                               DixReadAccess);
+        if (rc != Success)
+            return rc;
+        if (pBase->pScreen != pDraw->pScreen ||
+            pBase->depth != pDraw->depth) {
+            client->errorValue = stuff->base;
+            return BadMatch;
+        }
+    }
+    if (!stuff->tileWidth || !stuff->tileHeight) {
+        client->errorValue = 0;
+        return BadValue;
+    }
+
+    length = PixmapBytePad(stuff->tileWidth, stuff->depth);
+    if (length >= INT32_MAX / stuff->tileHeight)
+        return BadLength;
+    size = length * stuff->tileHeight;
+
+    /* Check the whole list before drawing any of it. */
+    data = (char *) &stuff[1];
+    end = (char *) stuff + ((size_t) client->req_len << 2);
+    for (i = 0; i < stuff->nTiles; i++) {
+        if (end - data < sz_xImageDeltaTile)
+            return BadLength;
+        tile = (xImageDeltaTile *) data;
+        data += sz_xImageDeltaTile;
+        if (!ImageDeltaTileOrigin(stuff->dstX, tile->col, stuff->tileWidth, &x) ||
+            !ImageDeltaTileOrigin(stuff->dstY, tile->row, stuff->tileHeight, &y) ||
+            !ImageDeltaTileOrigin(stuff->baseX, tile->col, stuff->tileWidth, &bx) ||
+            !ImageDeltaTileOrigin(stuff->baseY, tile->row, stuff->tileHeight, &by)) {
+            client->errorValue = (tile->row << 16) | tile->col;
+            return BadValue;
+        }
+        switch (tile->op) {
+        case ImageDeltaTileCopy:
+            break;
+        case ImageDeltaTileRaw:
+        case ImageDeltaTileXor:
+            if (end - data < size)
+                return BadLength;
+            data += size;
+            break;
+        default:
+            client->errorValue = tile->op;
+            return BadValue;
+        }
+    }
+    if (data != end)
+        return BadLength;
+
+    /*
+     * Tiles are drawn in list order, so with the drawable as its own base
+     * a tile reads whatever the tiles before it left there.
+     */
+    data = (char *) &stuff[1];
+    for (i = 0; i < stuff->nTiles; i++) {
+        tile = (xImageDeltaTile *) data;
+        data += sz_xImageDeltaTile;
+        ImageDeltaTileOrigin(stuff->dstX, tile->col, stuff->tileWidth, &x);
+        ImageDeltaTileOrigin(stuff->dstY, tile->row, stuff->tileHeight, &y);
+        ImageDeltaTileOrigin(stuff->baseX, tile->col, stuff->tileWidth, &bx);
+        ImageDeltaTileOrigin(stuff->baseY, tile->row, stuff->tileHeight, &by);
+
+        if (tile->op != ImageDeltaTileRaw &&
+            (pBase != pDraw || bx != x || by != y)) {
+            RegionPtr pRgn = (*pGC->ops->CopyArea) (pBase, pDraw, pGC, bx, by,
+                                                    stuff->tileWidth,
+                                                    stuff->tileHeight, x, y);
+            if (pRgn)
+                RegionDestroy(pRgn);
+        }
+
+        if (tile->op == ImageDeltaTileCopy)
+            continue;
+
+        if (tile->op == ImageDeltaTileXor && !pXorGC &&
+            !(pXorGC = ImageDeltaXorGC(pDraw, pGC)))
+            return BadAlloc;
+
+        (*pGC->ops->PutImage) (pDraw,
+                               tile->op == ImageDeltaTileXor ? pXorGC : pGC,
+                               stuff->depth, x, y,
+                               stuff->tileWidth, stuff->tileHeight,
+                               0, ZPixmap, data);
+        data += size;
+    }
+
+    if (pXorGC)
+        FreeScratchGC(pXorGC);
+    return Success;
+}
+
+static int
+ProcImageDeltaDispatch(ClientPtr client)
+{
+    REQUEST(xReq);
+    switch (stuff->data) {
+    case X_ImageDeltaQueryVersion:
+        return ProcImageDeltaQueryVersion(client);
+    case X_ImageDeltaPutTiles:
+        return ProcImageDeltaPutTiles(client);
+    default:
+        return BadRequest;
+    }
+}
+
+static int _X_COLD
+SProcImageDeltaQueryVersion(ClientPtr client)
+{
+    REQUEST(xImageDeltaQueryVersionReq);
+
+    swaps(&stuff->length);
+    REQUEST_SIZE_MATCH(xImageDeltaQueryVersionReq);
+    swaps(&stuff->majorVersion);
+    swaps(&stuff->minorVersion);
+    return ProcImageDeltaQueryVersion(client);
+}
+
+static int _X_COLD
+SProcImageDeltaPutTiles(ClientPtr client)
+{
+    xImageDeltaTile *tile;
+    char *data, *end;
+    long size;
+    int i;
+
+    REQUEST(xImageDeltaPutTilesReq);
+
+    swaps(&stuff->length);
+    REQUEST_AT_LEAST_SIZE(xImageDeltaPutTilesReq);
+    swapl(&stuff->drawable);
+    swapl(&stuff->gc);
+    swapl(&stuff->base);
+    swaps(&stuff->dstX);
+    swaps(&stuff->dstY);
+    swaps(&stuff->baseX);
+    swaps(&stuff->baseY);
+    swaps(&stuff->tileWidth);
+    swaps(&stuff->tileHeight);
+    swaps(&stuff->nTiles);
+
+    /* Only the tile headers need swapping; their images follow PutImage
+     * rules.  Anything malformed is left for the request to reject. */
+    size = (long) PixmapBytePad(stuff->tileWidth, stuff->depth) *
+        stuff->tileHeight;
+    data = (char *) &stuff[1];
+    end = (char *) stuff + ((size_t) client->req_len << 2);
+    for (i = 0; i < stuff->nTiles && end - data >= sz_xImageDeltaTile; i++) {
+        tile = (xImageDeltaTile *) data;
+        data += sz_xImageDeltaTile;
+        swaps(&tile->col);
+        swaps(&tile->row);
+        if (tile->op == ImageDeltaTileRaw || tile->op == ImageDeltaTileXor) {
+            if (end - data < size)
+                break;
+            data += size;
+        }
+    }
+    return ProcImageDeltaPutTiles(client);
+}
+
+static int _X_COLD
+SProcImageDeltaDispatch(ClientPtr client)
+{
+    REQUEST(xReq);
+    switch (stuff->data) {
+    case X_ImageDeltaQueryVersion:
+        return SProcImageDeltaQueryVersion(client);
+    case X_ImageDeltaPutTiles:
+        return SProcImageDeltaPutTiles(client);
+    default:
+        return BadRequest;
+    }
+}
+
+void
+ImageDeltaExtensionInit(void)
+{
+    AddExtension(ImageDeltaExtensionName, 0, 0,
+                 ProcImageDeltaDispatch, SProcImageDeltaDispatch,
+                 NULL, StandardMinorOpcode);
+}
@@ -1363,6 +1363,28 @@ PanoramiXCopyPlane(ClientPtr client)
     return Success;
 }
 
+/*
+ * Whether nothing drawn to the drawable can show on screen j, because it
+ * is a window with no part on that screen, so that the drawing requests
+ * need not be run there.  Screen 0 is always drawn to, so that the errors
+ * of a request are still found.
+ */
+static Bool
+XineramaDrawableHidden(ClientPtr client, PanoramiXRes * draw, int j)
+{
+    WindowPtr pWin;
+
+    if (j == 0 || draw->type != XRT_WINDOW || draw->u.win.root)
+        return FALSE;
+
+    if (dixLookupWindow(&pWin, draw->info[j].id, client,
+                        DixWriteAccess) != Success)
+        return FALSE;
+
+    /* a redirected window's clip is not limited to the screen */
+    return pWin->viewable && !RegionNotEmpty(&pWin->borderClip);
+}
+
 int
 PanoramiXPolyPoint(ClientPtr client)
 {
@@ -1394,6 +1416,8 @@ PanoramiXPolyPoint(ClientPtr client)
         origPts = xallocarray(npoint, sizeof(xPoint));
         memcpy((char *) origPts, (char *) &stuff[1], npoint * sizeof(xPoint));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], origPts, npoint * sizeof(xPoint));
@@ -1459,6 +1483,8 @@ PanoramiXPolyLine(ClientPtr client)
         origPts = xallocarray(npoint, sizeof(xPoint));
         memcpy((char *) origPts, (char *) &stuff[1], npoint * sizeof(xPoint));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], origPts, npoint * sizeof(xPoint));
@@ -1528,6 +1554,8 @@ PanoramiXPolySegment(ClientPtr client)
         origSegs = xallocarray(nsegs, sizeof(xSegment));
         memcpy((char *) origSegs, (char *) &stuff[1], nsegs * sizeof(xSegment));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], origSegs, nsegs * sizeof(xSegment));
@@ -1597,6 +1625,8 @@ PanoramiXPolyRectangle(ClientPtr client)
         memcpy((char *) origRecs, (char *) &stuff[1],
                nrects * sizeof(xRectangle));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], origRecs, nrects * sizeof(xRectangle));
@@ -1663,6 +1693,8 @@ PanoramiXPolyArc(ClientPtr client)
         origArcs = xallocarray(narcs, sizeof(xArc));
         memcpy((char *) origArcs, (char *) &stuff[1], narcs * sizeof(xArc));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], origArcs, narcs * sizeof(xArc));
@@ -1726,6 +1758,8 @@ PanoramiXFillPoly(ClientPtr client)
         memcpy((char *) locPts, (char *) &stuff[1],
                count * sizeof(DDXPointRec));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], locPts, count * sizeof(DDXPointRec));
@@ -1795,6 +1829,8 @@ PanoramiXPolyFillRectangle(ClientPtr client)
         memcpy((char *) origRects, (char *) &stuff[1],
                things * sizeof(xRectangle));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], origRects, things * sizeof(xRectangle));
@@ -1861,6 +1897,8 @@ PanoramiXPolyFillArc(ClientPtr client)
         origArcs = xallocarray(narcs, sizeof(xArc));
         memcpy((char *) origArcs, (char *) &stuff[1], narcs * sizeof(xArc));
         FOR_NSCREENS_FORWARD(j) {
+            if (XineramaDrawableHidden(client, draw, j))
+                continue;
 
             if (j)
                 memcpy(&stuff[1], origArcs, narcs * sizeof(xArc));
@@ -1921,6 +1959,8 @@ PanoramiXPutImage(ClientPtr client)
     orig_x = stuff->dstX;
     orig_y = stuff->dstY;
     FOR_NSCREENS_BACKWARD(j) {
+        if (XineramaDrawableHidden(client, draw, j))
+            continue;
         if (isRoot) {
             stuff->dstX = orig_x - screenInfo.screens[j]->x;
             stuff->dstY = orig_y - screenInfo.screens[j]->y;
@@ -2120,6 +2160,8 @@ PanoramiXPolyText8(ClientPtr client)
     orig_x = stuff->x;
     orig_y = stuff->y;
     FOR_NSCREENS_BACKWARD(j) {
+        if (XineramaDrawableHidden(client, draw, j))
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
@@ -2163,6 +2205,8 @@ PanoramiXPolyText16(ClientPtr client)
     orig_x = stuff->x;
     orig_y = stuff->y;
     FOR_NSCREENS_BACKWARD(j) {
+        if (XineramaDrawableHidden(client, draw, j))
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
@@ -2206,6 +2250,8 @@ PanoramiXImageText8(ClientPtr client)
     orig_x = stuff->x;
     orig_y = stuff->y;
     FOR_NSCREENS_BACKWARD(j) {
+        if (XineramaDrawableHidden(client, draw, j))
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
@@ -2249,6 +2295,8 @@ PanoramiXImageText16(ClientPtr client)
     orig_x = stuff->x;
     orig_y = stuff->y;
     FOR_NSCREENS_BACKWARD(j) {
+        if (XineramaDrawableHidden(client, draw, j))
+            continue;
         stuff->drawable = draw->info[j].id;
         stuff->gc = gc->info[j].id;
         if (isRoot) {
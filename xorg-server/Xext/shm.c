@@ -59,12 +59,24 @@ in this Software without prior written authorization from The Open Group.
 #include "xace.h"
 #include <X11/extensions/shmproto.h>
 #include <X11/Xfuncproto.h>
+#if !defined(_MSC_VER)
 #include <sys/mman.h>
+#else
+#include <X11/Xwinsock.h>
+#include <X11/Xwindows.h>
+#include <iphlpapi.h>
+#include <aclapi.h>
+#ifndef SIO_AF_UNIX_GETPEERPID
+#define SIO_AF_UNIX_GETPEERPID _WSAIOR(IOC_VENDOR, 256)
+#endif
+#endif
 #include "protocol-versions.h"
 #include "busfault.h"
 
 /* Needed for Solaris cross-zone shared memory extension */
-#ifdef HAVE_SHMCTL64
+#if defined(_MSC_VER)
+/* segments are named file mappings, see ShmMapSegment */
+#elif defined(HAVE_SHMCTL64)
 #include <sys/ipc_impl.h>
 #define SHMSTAT(id, buf)	shmctl64(id, IPC_STAT64, buf)
 #define SHMSTAT_TYPE 		struct shmid_ds64
@@ -285,8 +297,13 @@ ProcShmQueryVersion(ClientPtr client)
         .length = 0,
         .majorVersion = SERVER_SHM_MAJOR_VERSION,
         .minorVersion = SERVER_SHM_MINOR_VERSION,
+#ifdef _MSC_VER
+        .uid = 0,
+        .gid = 0,
+#else
         .uid = geteuid(),
         .gid = getegid(),
+#endif
         .pixmapFormat = sharedPixmaps ? ZPixmap : 0
     };
 
@@ -304,6 +321,7 @@ ProcShmQueryVersion(ClientPtr client)
     return Success;
 }
 
+#ifndef _MSC_VER
 /*
  * Simulate the access() system call for a shared memory segement,
  * using the credentials from the client if available
@@ -341,9 +359,6 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
             if (uid == 0) {
                 return 0;
             }
-            #ifdef _MSC_VER
-            __asm int 3;
-            #else
             /* Check the owner */
             if (SHMPERM_UID(perm) == uid || SHMPERM_CUID(perm) == uid) {
                 mask = S_IRUSR;
@@ -352,14 +367,10 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
                 }
                 return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
             }
-            #endif
         }
 
         if (gidset) {
             /* Check the group */
-            #ifdef _MSC_VER
-            __asm int 3;
-            #else
             if (SHMPERM_GID(perm) == gid || SHMPERM_CGID(perm) == gid) {
                 mask = S_IRGRP;
                 if (!readonly) {
@@ -367,26 +378,177 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
                 }
                 return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
             }
-            #endif
         }
     }
-            #ifdef _MSC_VER
-            __asm int 3;
-            return -1;
-            #else
     /* Otherwise, check everyone else */
     mask = S_IROTH;
     if (!readonly) {
         mask |= S_IWOTH;
     }
     return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
-    #endif
 }
+#else
+/*
+ * The process at the other end of a client's connection, which must be on
+ * this machine: unix sockets say who it is, TCP connections are looked up
+ * in the TCP table by their addresses.  Returns 0 if it cannot be told.
+ */
+static DWORD
+ShmClientProcess(ClientPtr client)
+{
+    SOCKET s = (SOCKET) GetClientFd(client);
+    struct sockaddr_storage local, peer;
+    int locallen = sizeof(local), peerlen = sizeof(peer);
+    MIB_TCPTABLE_OWNER_PID *table = NULL, *grown;
+    DWORD pid = 0, size = 0, bytes, i, rc;
+
+    if (getsockname(s, (struct sockaddr *) &local, &locallen) ||
+        getpeername(s, (struct sockaddr *) &peer, &peerlen))
+        return 0;
+
+    if (local.ss_family == AF_UNIX) {
+        if (WSAIoctl(s, SIO_AF_UNIX_GETPEERPID, NULL, 0, &pid, sizeof(pid),
+                     &bytes, NULL, NULL))
+            return 0;
+        return pid;
+    }
+    if (local.ss_family != AF_INET)
+        return 0;
+
+    /* Size the table first; it can grow again before it is filled in */
+    while ((rc = GetExtendedTcpTable(table, &size, FALSE, AF_INET,
+                                     TCP_TABLE_OWNER_PID_CONNECTIONS, 0))
+           == ERROR_INSUFFICIENT_BUFFER) {
+        grown = realloc(table, size);
+        if (!grown)
+            break;
+        table = grown;
+    }
+    if (rc == NO_ERROR) {
+        struct sockaddr_in *me = (struct sockaddr_in *) &local;
+        struct sockaddr_in *them = (struct sockaddr_in *) &peer;
+
+        /* The client's row is ours with the two ends swapped */
+        for (i = 0; i < table->dwNumEntries; i++) {
+            MIB_TCPROW_OWNER_PID *row = &table->table[i];
+
+            if (row->dwLocalAddr == them->sin_addr.s_addr &&
+                (u_short) row->dwLocalPort == them->sin_port &&
+                row->dwRemoteAddr == me->sin_addr.s_addr &&
+                (u_short) row->dwRemotePort == me->sin_port) {
+                pid = row->dwOwningPid;
+                break;
+            }
+        }
+    }
+    free(table);
+    return pid;
+}
+
+/*
+ * Whether the mapping belongs to the client: its owner has to be the
+ * owner a process of the client gives the objects it makes.
+ */
+static Bool
+ShmClientOwnsMapping(ClientPtr client, HANDLE mapping)
+{
+    DWORD pid = ShmClientProcess(client);
+    HANDLE process, token;
+    TOKEN_OWNER *owner = NULL;
+    PSECURITY_DESCRIPTOR sd;
+    PSID mappingOwner;
+    DWORD size = 0;
+    Bool owns = FALSE;
+
+    if (!pid)
+        return FALSE;
+    process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process)
+        return FALSE;
+    if (OpenProcessToken(process, TOKEN_QUERY, &token)) {
+        GetTokenInformation(token, TokenOwner, NULL, 0, &size);
+        owner = size ? malloc(size) : NULL;
+        if (owner && !GetTokenInformation(token, TokenOwner, owner, size,
+                                          &size)) {
+            free(owner);
+            owner = NULL;
+        }
+        CloseHandle(token);
+    }
+    CloseHandle(process);
+    if (!owner)
+        return FALSE;
+
+    if (GetSecurityInfo(mapping, SE_KERNEL_OBJECT, OWNER_SECURITY_INFORMATION,
+                        &mappingOwner, NULL, NULL, NULL,
+                        &sd) == ERROR_SUCCESS) {
+        owns = EqualSid(mappingOwner, owner->Owner);
+        LocalFree(sd);
+    }
+    free(owner);
+    return owns;
+}
+
+/*
+ * Without SysV shared memory, a segment is a named file mapping the client
+ * created in its session, called "Local\XShm-<shmid>" with shmid in
+ * decimal.  The server opens it with its own rights, so instead of
+ * shm_access only local clients get in, and only to mappings they own.
+ * Returns NULL on failure.
+ */
+static HANDLE
+ShmOpenSegment(ClientPtr client, CARD32 shmid, DWORD access)
+{
+    char name[32];
+    HANDLE mapping;
+
+    if (!client->local)
+        return NULL;
+    snprintf(name, sizeof(name), "Local\\XShm-%u", (unsigned int) shmid);
+    mapping = OpenFileMappingA(access | READ_CONTROL, FALSE, name);
+    if (mapping && !ShmClientOwnsMapping(client, mapping)) {
+        CloseHandle(mapping);
+        return NULL;
+    }
+    return mapping;
+}
+
+/*
+ * The view keeps the mapping alive, so the handle is not kept.  Returns
+ * NULL on failure.
+ */
+static char *
+ShmMapSegment(ClientPtr client, CARD32 shmid, Bool readOnly,
+              unsigned long *size)
+{
+    DWORD access = readOnly ? FILE_MAP_READ : FILE_MAP_READ | FILE_MAP_WRITE;
+    MEMORY_BASIC_INFORMATION info;
+    HANDLE mapping;
+    char *addr;
+
+    mapping = ShmOpenSegment(client, shmid, access);
+    if (!mapping)
+        return NULL;
+    addr = MapViewOfFile(mapping, access, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!addr)
+        return NULL;
+
+    if (!VirtualQuery(addr, &info, sizeof(info)) || info.RegionSize > ULONG_MAX) {
+        UnmapViewOfFile(addr);
+        return NULL;
+    }
+    *size = (unsigned long) info.RegionSize;
+    return addr;
+}
+#endif
 
 static int
 ProcShmAttach(ClientPtr client)
 {
+#ifndef _MSC_VER
     SHMSTAT_TYPE buf;
+#endif
     ShmDescPtr shmdesc;
 
     REQUEST(xShmAttachReq);
@@ -404,6 +566,16 @@ ProcShmAttach(ClientPtr client)
     if (shmdesc) {
         if (!stuff->readOnly && !shmdesc->writable)
             return BadAccess;
+#ifdef _MSC_VER
+        {
+            /* Every client attaching has to own the segment */
+            HANDLE mapping = ShmOpenSegment(client, stuff->shmid, 0);
+
+            if (!mapping)
+                return BadAccess;
+            CloseHandle(mapping);
+        }
+#endif
         shmdesc->refcnt++;
     }
     else {
@@ -413,6 +585,14 @@ ProcShmAttach(ClientPtr client)
 #ifdef SHM_FD_PASSING
         shmdesc->is_fd = FALSE;
 #endif
+#ifdef _MSC_VER
+        shmdesc->addr = ShmMapSegment(client, stuff->shmid, stuff->readOnly,
+                                      &shmdesc->size);
+        if (!shmdesc->addr) {
+            free(shmdesc);
+            return BadAccess;
+        }
+#else
         shmdesc->addr = shmat(stuff->shmid, 0,
                               stuff->readOnly ? SHM_RDONLY : 0);
         if ((shmdesc->addr == ((char *) -1)) || SHMSTAT(stuff->shmid, &buf)) {
@@ -429,11 +609,12 @@ ProcShmAttach(ClientPtr client)
             free(shmdesc);
             return BadAccess;
         }
+        shmdesc->size = SHM_SEGSZ(buf);
+#endif
 
         shmdesc->shmid = stuff->shmid;
         shmdesc->refcnt = 1;
         shmdesc->writable = !stuff->readOnly;
-        shmdesc->size = SHM_SEGSZ(buf);
         shmdesc->next = Shmsegs;
         Shmsegs = shmdesc;
     }
@@ -451,7 +632,9 @@ ShmDetachSegment(void *value, /* must conform to DeleteType */
 
     if (--shmdesc->refcnt)
         return TRUE;
-#ifndef _MSC_VER
+#ifdef _MSC_VER
+    UnmapViewOfFile(shmdesc->addr);
+#else
 #if SHM_FD_PASSING
     if (shmdesc->is_fd) {
         if (shmdesc->busfault)
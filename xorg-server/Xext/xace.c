@@ -48,6 +48,7 @@ XaceHookDispatch(ClientPtr client, int major)
     return (erec.status == Success) ? Success : BadRequest;
 }
 
+#undef XaceHookPropertyAccess
 int
 XaceHookPropertyAccess(ClientPtr client, WindowPtr pWin,
                        PropertyPtr *ppProp, Mask access_mode)
@@ -57,6 +58,7 @@ XaceHookPropertyAccess(ClientPtr client, WindowPtr pWin,
     return rec.status;
 }
 
+#undef XaceHookSelectionAccess
 int
 XaceHookSelectionAccess(ClientPtr client, Selection ** ppSel, Mask access_mode)
 {
@@ -67,6 +69,7 @@ XaceHookSelectionAccess(ClientPtr client, Selection ** ppSel, Mask access_mode)
 
 /* Entry point for hook functions.  Called by Xserver.
  */
+#undef XaceHook
 int
 XaceHook(int hook, ...)
 {
@@ -198,6 +201,7 @@ XaceHook(int hook, ...)
  *
  * Returns non-zero if there is a callback, zero otherwise.
  */
+#undef XaceHookIsSet
 int
 XaceHookIsSet(int hook)
 {
@@ -65,6 +65,14 @@ extern _X_EXPORT int XaceHook(int /*hook */ ,
 
 /* determine whether any callbacks are present for the XACE hook */
 extern _X_EXPORT int XaceHookIsSet(int hook);
+#define XaceHookIsSet(hook) (XaceHooks[(hook)] != NULL)
+
+/* Without a security module listening, as is usual, a hook costs no more
+ * than the test of its list where it is called.  The hook arguments are
+ * not evaluated then.
+ */
+#define XaceHook(hook, ...) \
+    (XaceHookIsSet(hook) ? XaceHook((hook), __VA_ARGS__) : Success)
 
 /* Special-cased hook functions
  */
@@ -77,8 +85,17 @@ extern _X_EXPORT int XaceHookDispatch(ClientPtr ptr, int major);
 extern _X_EXPORT int XaceHookPropertyAccess(ClientPtr ptr, WindowPtr pWin,
                                             PropertyPtr *ppProp,
                                             Mask access_mode);
+#define XaceHookPropertyAccess(c, w, pp, m) \
+    (XaceHookIsSet(XACE_PROPERTY_ACCESS) ? \
+    XaceHookPropertyAccess((c), (w), (pp), (m)) : \
+    Success)
+
 extern _X_EXPORT int XaceHookSelectionAccess(ClientPtr ptr, Selection ** ppSel,
                                              Mask access_mode);
+#define XaceHookSelectionAccess(c, pp, m) \
+    (XaceHookIsSet(XACE_SELECTION_ACCESS) ? \
+    XaceHookSelectionAccess((c), (pp), (m)) : \
+    Success)
 
 /* Register a callback for a given hook.
  */
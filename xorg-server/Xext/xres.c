@@ -994,6 +994,120 @@ ProcXResQueryResourceBytes (ClientPtr client)
     return rc;
 }
 
+typedef struct {
+    SizeType sizeFunc;
+    CARD64 bytes;
+} ResTypeBytesCtx;
+
+static void
+ResAddTypeBytes(void *value, XID id, void *cdata)
+{
+    ResTypeBytesCtx *ctx = cdata;
+    ResourceSizeRec size = { 0, 0, 0 };
+
+    ctx->sizeFunc(value, id, &size);
+    ctx->bytes += size.resourceSize + size.pixmapRefSize;
+}
+
+/* Bytes of the client's resources of the type, as its size function has it */
+static CARD32
+ResClientTypeBytes(ClientPtr client, RESTYPE type)
+{
+    ResTypeBytesCtx ctx = { GetResourceTypeSizeFunc(type), 0 };
+
+    if (type == RT_NONE)
+        return 0;
+    FindClientResourcesByType(client, type, ResAddTypeBytes, &ctx);
+    return ctx.bytes > 0xffffffff ? 0xffffffff : ctx.bytes;
+}
+
+/* Extensions which aren't linked with this one are found by name */
+static RESTYPE
+ResTypeByName(const char *name)
+{
+    RESTYPE type;
+
+    for (type = 1; type <= lastResourceType; type++) {
+        if (!strcmp(LookupResourceName(type), name))
+            return type;
+    }
+    return RT_NONE;
+}
+
+/** @brief Implements the XResQueryClientStats of XResProto v1.3.
+    Sends the counters the dispatcher and the OS layer keep for every
+    client, with the memory of its glyph sets and GLX drawables. */
+static int
+ProcXResQueryClientStats(ClientPtr client)
+{
+    xXResQueryClientStatsReply rep;
+    RESTYPE glxDrawableType = ResTypeByName("GLXDrawable");
+    int i, num_clients;
+
+    REQUEST_SIZE_MATCH(xXResQueryClientStatsReq);
+
+    num_clients = 0;
+    for (i = 0; i < currentMaxClients; i++) {
+        if (clients[i])
+            num_clients++;
+    }
+
+    rep = (xXResQueryClientStatsReply) {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = bytes_to_int32(num_clients * sz_xXResClientStats),
+        .num_clients = num_clients
+    };
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swapl(&rep.num_clients);
+    }
+    WriteToClient(client, sizeof(xXResQueryClientStatsReply), &rep);
+
+    for (i = 0; i < currentMaxClients; i++) {
+        ClientPtr about = clients[i];
+        const ClientStatsRec *stats;
+        xXResClientStats scratch;
+
+        if (!about)
+            continue;
+        stats = &about->stats;
+
+        scratch = (xXResClientStats) {
+            .resource_base = about->clientAsMask,
+            .pending_output = ClientPendingOutput(about),
+            .requests_hi = stats->requests >> 32,
+            .requests_lo = stats->requests,
+            .dispatch_usec_hi = stats->dispatch_us >> 32,
+            .dispatch_usec_lo = stats->dispatch_us,
+            .bytes_in_hi = stats->bytes_in >> 32,
+            .bytes_in_lo = stats->bytes_in,
+            .bytes_out_hi = stats->bytes_out >> 32,
+            .bytes_out_lo = stats->bytes_out,
+            .glyph_bytes = ResClientTypeBytes(about, GlyphSetType),
+            .glx_bytes = ResClientTypeBytes(about, glxDrawableType)
+        };
+        if (client->swapped) {
+            swapl(&scratch.resource_base);
+            swapl(&scratch.pending_output);
+            swapl(&scratch.requests_hi);
+            swapl(&scratch.requests_lo);
+            swapl(&scratch.dispatch_usec_hi);
+            swapl(&scratch.dispatch_usec_lo);
+            swapl(&scratch.bytes_in_hi);
+            swapl(&scratch.bytes_in_lo);
+            swapl(&scratch.bytes_out_hi);
+            swapl(&scratch.bytes_out_lo);
+            swapl(&scratch.glyph_bytes);
+            swapl(&scratch.glx_bytes);
+        }
+        WriteToClient(client, sz_xXResClientStats, &scratch);
+    }
+
+    return Success;
+}
+
 static int
 ProcResDispatch(ClientPtr client)
 {
@@ -1011,6 +1125,8 @@ ProcResDispatch(ClientPtr client)
         return ProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return ProcXResQueryResourceBytes(client);
+    case X_XResQueryClientStats:
+        return ProcXResQueryClientStats(client);
     default: break;
     }
 
@@ -1093,6 +1209,8 @@ SProcResDispatch (ClientPtr client)
         return SProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return SProcXResQueryResourceBytes(client);
+    case X_XResQueryClientStats:   /* nothing to swap */
+        return ProcXResQueryClientStats(client);
     default: break;
     }
 
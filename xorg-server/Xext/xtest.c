@@ -54,6 +54,8 @@
 #include "exevents.h"
 #include "eventstr.h"
 #include "inpututils.h"
+#include "list.h"
+#include "resource.h"
 
 #include "extinit.h"
 
@@ -83,6 +85,30 @@ static int XTestSwapFakeInput(ClientPtr /* client */ ,
                               xReq *    /* req */
     );
 
+/**
+ * The entries of FakeInputBatch requests still to be sent, one queue per
+ * client.  The entries are kept as they came, and sent one after the other
+ * from a timer, so they go in between the requests of the clients like
+ * real input does.
+ */
+typedef struct _XTestQueue {
+    struct xorg_list entry;     /* in xtestQueues */
+    ClientPtr client;
+    XID id;
+    char *data;
+    size_t size;                /* of data */
+    size_t used;                /* bytes of entries in data */
+    size_t next;                /* offset of the next entry to send */
+    CARD32 last;                /* time the previous entry was due */
+} XTestQueueRec, *XTestQueuePtr;
+
+/* Entries sent in one go before the other clients get to run */
+#define XTEST_BATCH_MAX 256
+
+static struct xorg_list xtestQueues;
+static OsTimerPtr xtestBatchTimer;
+static RESTYPE RTXTestQueue;
+
 static int
 ProcXTestGetVersion(ClientPtr client)
 {
@@ -147,12 +173,22 @@ ProcXTestCompareCursor(ClientPtr client)
     return Success;
 }
 
+/* What XTestFakeInput() does once the events have been checked */
+#define XTEST_FAKE_WAIT     0   /* send them when their time has come */
+#define XTEST_FAKE_CHECK    1   /* nothing */
+#define XTEST_FAKE_SEND     2   /* send them at once */
+
+/**
+ * Check and send the events of a FakeInput request, or of an entry of a
+ * FakeInputBatch request.  Only XTEST_FAKE_WAIT looks at the time of the
+ * events, and it puts the client to sleep and resets the request if the
+ * time has yet to come.
+ */
 static int
-ProcXTestFakeInput(ClientPtr client)
+XTestFakeInput(ClientPtr client, CARD8 deviceid, xEvent *ev, int nev,
+               int mode)
 {
-    REQUEST(xXTestFakeInputReq);
-    int nev, n, type, rc;
-    xEvent *ev;
+    int n, type, rc;
     DeviceIntPtr dev = NULL;
     WindowPtr root;
     Bool extension = FALSE;
@@ -166,22 +202,16 @@ ProcXTestFakeInput(ClientPtr client)
     int flags = 0;
     int need_ptr_update = 1;
 
-    nev = (stuff->length << 2) - sizeof(xReq);
-    if ((nev % sizeof(xEvent)) || !nev)
-        return BadLength;
-    nev /= sizeof(xEvent);
-    UpdateCurrentTime();
-    ev = (xEvent *) &((xReq *) stuff)[1];
     type = ev->u.u.type & 0177;
 
     if (type >= EXTENSION_EVENT_BASE) {
         extension = TRUE;
 
         /* check device */
-        rc = dixLookupDevice(&dev, stuff->deviceid & 0177, client,
+        rc = dixLookupDevice(&dev, deviceid & 0177, client,
                              DixWriteAccess);
         if (rc != Success) {
-            client->errorValue = stuff->deviceid & 0177;
+            client->errorValue = deviceid & 0177;
             return rc;
         }
 
@@ -322,7 +352,8 @@ ProcXTestFakeInput(ClientPtr client)
 
 
     /* If the event has a time set, wait for it to pass */
-    if (ev->u.keyButtonPointer.time) {
+    if (mode == XTEST_FAKE_WAIT && ev->u.keyButtonPointer.time) {
+        xReq *req = (xReq *) client->requestBuffer;
         TimeStamp activateTime;
         CARD32 ms;
 
@@ -341,8 +372,8 @@ ProcXTestFakeInput(ClientPtr client)
         }
         /* swap the request back so we can simply re-execute it */
         if (client->swapped) {
-            (void) XTestSwapFakeInput(client, (xReq *) stuff);
-            swaps(&stuff->length);
+            (void) XTestSwapFakeInput(client, req);
+            swaps(&req->length);
         }
         ResetCurrentRequest(client);
         client->sequence--;
@@ -404,6 +435,9 @@ ProcXTestFakeInput(ClientPtr client)
         }
         break;
     }
+    if (mode == XTEST_FAKE_CHECK)
+        return Success;
+
     if (screenIsSaved == SCREEN_SAVER_ON)
         dixSaveScreens(serverClient, SCREEN_SAVER_OFF, ScreenSaverReset);
 
@@ -433,6 +467,187 @@ ProcXTestFakeInput(ClientPtr client)
     return Success;
 }
 
+static int
+ProcXTestFakeInput(ClientPtr client)
+{
+    REQUEST(xXTestFakeInputReq);
+    int nev;
+
+    nev = (stuff->length << 2) - sizeof(xReq);
+    if ((nev % sizeof(xEvent)) || !nev)
+        return BadLength;
+    nev /= sizeof(xEvent);
+    UpdateCurrentTime();
+    return XTestFakeInput(client, stuff->deviceid,
+                          (xEvent *) &((xReq *) stuff)[1], nev,
+                          XTEST_FAKE_WAIT);
+}
+
+static xXTestFakeInputBatchEntry *
+XTestNextEntry(XTestQueuePtr queue)
+{
+    if (queue->next == queue->used)
+        return NULL;
+    return (xXTestFakeInputBatchEntry *) (queue->data + queue->next);
+}
+
+/* The time the first of the queued entries is due */
+static Bool
+XTestBatchDue(CARD32 *due)
+{
+    XTestQueuePtr queue;
+    xXTestFakeInputBatchEntry *entry;
+    Bool found = FALSE;
+
+    xorg_list_for_each_entry(queue, &xtestQueues, entry) {
+        if (!(entry = XTestNextEntry(queue)))
+            continue;
+        if (!found || (int) (queue->last + entry->delay - *due) < 0)
+            *due = queue->last + entry->delay;
+        found = TRUE;
+    }
+    return found;
+}
+
+static CARD32
+XTestBatchExpire(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    XTestQueuePtr queue;
+    xXTestFakeInputBatchEntry *entry;
+    CARD32 due, wait = 0;
+    int sent;
+
+    UpdateCurrentTime();
+
+    xorg_list_for_each_entry(queue, &xtestQueues, entry) {
+        sent = 0;
+        while ((entry = XTestNextEntry(queue))) {
+            /* Go by the time the entry was due rather than the time it is
+             * sent, so a late timer does not stretch the rest */
+            due = queue->last + entry->delay;
+            if ((int) (due - now) > 0) {
+                if (!wait || due - now < wait)
+                    wait = due - now;
+                break;
+            }
+            if (sent == XTEST_BATCH_MAX) {
+                wait = 1;
+                break;
+            }
+
+            /* The batch was checked when it came in; whatever has changed
+             * since, such as a device going away, just drops the entry */
+            XTestFakeInput(queue->client, entry->deviceid,
+                           (xEvent *) &entry[1], entry->nEvents,
+                           XTEST_FAKE_SEND);
+            queue->last = due;
+            queue->next += sz_xXTestFakeInputBatchEntry +
+                entry->nEvents * sizeof(xEvent);
+            sent++;
+        }
+        if (!entry)
+            queue->next = queue->used = 0;
+    }
+
+    return wait;
+}
+
+static int
+XTestQueueDelete(void *value, XID id)
+{
+    XTestQueuePtr queue = value;
+
+    xorg_list_del(&queue->entry);
+    free(queue->data);
+    free(queue);
+    return Success;
+}
+
+static XTestQueuePtr
+XTestGetQueue(ClientPtr client)
+{
+    XTestQueuePtr queue;
+
+    xorg_list_for_each_entry(queue, &xtestQueues, entry) {
+        if (queue->client == client)
+            return queue;
+    }
+
+    queue = calloc(1, sizeof(XTestQueueRec));
+    if (!queue)
+        return NULL;
+    queue->client = client;
+    queue->id = FakeClientID(client->index);
+    xorg_list_append(&queue->entry, &xtestQueues);
+    if (!AddResource(queue->id, RTXTestQueue, queue))
+        return NULL;
+    return queue;
+}
+
+static int
+ProcXTestFakeInputBatch(ClientPtr client)
+{
+    REQUEST(xXTestFakeInputBatchReq);
+    xXTestFakeInputBatchEntry *entry;
+    XTestQueuePtr queue;
+    char *data = (char *) &stuff[1];
+    size_t len, off, size;
+    CARD32 due;
+    int rc;
+
+    REQUEST_AT_LEAST_SIZE(xXTestFakeInputBatchReq);
+    len = ((size_t) client->req_len << 2) - sz_xXTestFakeInputBatchReq;
+    if (!len)
+        return Success;
+
+    /* Check all of the batch first, so it is queued whole or not at all */
+    UpdateCurrentTime();
+    for (off = 0; off < len; off += size) {
+        if (len - off < sz_xXTestFakeInputBatchEntry)
+            return BadLength;
+        entry = (xXTestFakeInputBatchEntry *) (data + off);
+        size = sz_xXTestFakeInputBatchEntry + entry->nEvents * sizeof(xEvent);
+        if (!entry->nEvents || len - off < size)
+            return BadLength;
+        rc = XTestFakeInput(client, entry->deviceid, (xEvent *) &entry[1],
+                            entry->nEvents, XTEST_FAKE_CHECK);
+        if (rc != Success)
+            return rc;
+    }
+
+    queue = XTestGetQueue(client);
+    if (!queue)
+        return BadAlloc;
+    if (queue->next) {
+        memmove(queue->data, queue->data + queue->next,
+                queue->used - queue->next);
+        queue->used -= queue->next;
+        queue->next = 0;
+    }
+    if (queue->used + len > queue->size) {
+        size_t want = max(queue->used + len, queue->size * 2);
+        char *grown = realloc(queue->data, want);
+
+        if (!grown)
+            return BadAlloc;
+        queue->data = grown;
+        queue->size = want;
+    }
+    /* An empty queue counts the delay of the first entry from now */
+    if (!queue->used)
+        queue->last = GetTimeInMillis();
+    memcpy(queue->data + queue->used, data, len);
+    queue->used += len;
+
+    if (XTestBatchDue(&due)) {
+        xtestBatchTimer = TimerSet(xtestBatchTimer, TimerAbsolute, due,
+                                   XTestBatchExpire, NULL);
+        if (!xtestBatchTimer)
+            return BadAlloc;
+    }
+    return Success;
+}
+
 static int
 ProcXTestGrabControl(ClientPtr client)
 {
@@ -463,6 +678,8 @@ ProcXTestDispatch(ClientPtr client)
         return ProcXTestFakeInput(client);
     case X_XTestGrabControl:
         return ProcXTestGrabControl(client);
+    case X_XTestFakeInputBatch:
+        return ProcXTestFakeInputBatch(client);
     default:
         return BadRequest;
     }
@@ -528,6 +745,41 @@ SProcXTestFakeInput(ClientPtr client)
     return ProcXTestFakeInput(client);
 }
 
+static int _X_COLD
+SProcXTestFakeInputBatch(ClientPtr client)
+{
+    REQUEST(xXTestFakeInputBatchReq);
+    xXTestFakeInputBatchEntry *entry;
+    char *data = (char *) &stuff[1];
+    size_t len, off, size;
+    xEvent *ev, sev;
+    EventSwapPtr proc;
+    int n;
+
+    swaps(&stuff->length);
+    REQUEST_AT_LEAST_SIZE(xXTestFakeInputBatchReq);
+    len = ((size_t) client->req_len << 2) - sz_xXTestFakeInputBatchReq;
+    for (off = 0; off < len; off += size) {
+        if (len - off < sz_xXTestFakeInputBatchEntry)
+            return BadLength;
+        entry = (xXTestFakeInputBatchEntry *) (data + off);
+        size = sz_xXTestFakeInputBatchEntry + entry->nEvents * sizeof(xEvent);
+        if (len - off < size)
+            return BadLength;
+        swapl(&entry->delay);
+        for (ev = (xEvent *) &entry[1], n = entry->nEvents; --n >= 0; ev++) {
+            proc = EventSwapVector[ev->u.u.type & 0177];
+            if (!proc || proc == NotImplemented) {
+                client->errorValue = ev->u.u.type;
+                return BadValue;
+            }
+            (*proc) (ev, &sev);
+            *ev = sev;
+        }
+    }
+    return ProcXTestFakeInputBatch(client);
+}
+
 static int _X_COLD
 SProcXTestGrabControl(ClientPtr client)
 {
@@ -551,6 +803,8 @@ SProcXTestDispatch(ClientPtr client)
         return SProcXTestFakeInput(client);
     case X_XTestGrabControl:
         return SProcXTestGrabControl(client);
+    case X_XTestFakeInputBatch:
+        return SProcXTestFakeInputBatch(client);
     default:
         return BadRequest;
     }
@@ -681,11 +935,19 @@ XTestExtensionTearDown(ExtensionEntry * e)
 {
     FreeEventList(xtest_evlist, GetMaximumEventsNum());
     xtest_evlist = NULL;
+    /* The queues went with their clients */
+    TimerFree(xtestBatchTimer);
+    xtestBatchTimer = NULL;
 }
 
 void
 XTestExtensionInit(void)
 {
+    RTXTestQueue = CreateNewResourceType(XTestQueueDelete, "XTestQueue");
+    if (!RTXTestQueue)
+        return;
+    xorg_list_init(&xtestQueues);
+
     AddExtension(XTestExtensionName, 0, 0,
                  ProcXTestDispatch, SProcXTestDispatch,
                  XTestExtensionTearDown, StandardMinorOpcode);
@@ -45,6 +45,8 @@
 #include <dix-config.h>
 #endif
 
+#include <string.h>
+
 #include "compint.h"
 
 static Bool
@@ -193,6 +195,7 @@ compRedirectWindow(ClientPtr pClient, WindowPtr pWin, int update)
         cw->damageRegistered = FALSE;
         cw->damaged = FALSE;
         cw->pOldPixmap = NullPixmap;
+        cw->oldBitsCopied = FALSE;
         dixSetPrivate(&pWin->devPrivates, CompWindowPrivateKey, cw);
     }
     ccw->next = cw->clients;
@@ -308,7 +311,7 @@ compFreeClientWindow(WindowPtr pWin, XID id)
 
     if (pPixmap) {
         compRestoreWindow(pWin, pPixmap);
-        (*pScreen->DestroyPixmap) (pPixmap);
+        compReleasePixmap(pScreen, pPixmap);
     }
 }
 
@@ -525,15 +528,116 @@ compUnredirectOneSubwindow(WindowPtr pParent, WindowPtr pWin)
     return Success;
 }
 
+static size_t
+compPixmapBytes(PixmapPtr pPixmap)
+{
+    size_t stride = ((size_t) pPixmap->drawable.width *
+                     pPixmap->drawable.bitsPerPixel + 7) >> 3;
+
+    return stride * pPixmap->drawable.height;
+}
+
+void
+compFlushPixmapPool(ScreenPtr pScreen)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+
+    while (cs->numPoolPixmaps)
+        (*pScreen->DestroyPixmap) (cs->pixmapPool[--cs->numPoolPixmaps]);
+    cs->poolBytes = 0;
+}
+
+static CARD32
+compPixmapPoolExpire(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    compFlushPixmapPool((ScreenPtr) arg);
+    return 0;
+}
+
+/*
+ * Drop a backing pixmap the window no longer uses.  Pixmaps nobody
+ * else holds a reference to are parked in the screen pool until the
+ * pool timer expires; the oldest entries are evicted to stay within
+ * the pool limits
+ */
+void
+compReleasePixmap(ScreenPtr pScreen, PixmapPtr pPixmap)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+    size_t bytes = compPixmapBytes(pPixmap);
+
+    if (pPixmap->refcnt != 1 || bytes > COMP_PIXMAP_POOL_BYTES) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        return;
+    }
+    while (cs->numPoolPixmaps == COMP_PIXMAP_POOL_SIZE ||
+           cs->poolBytes + bytes > COMP_PIXMAP_POOL_BYTES) {
+        PixmapPtr pOldest = cs->pixmapPool[0];
+
+        cs->poolBytes -= compPixmapBytes(pOldest);
+        cs->numPoolPixmaps--;
+        memmove(&cs->pixmapPool[0], &cs->pixmapPool[1],
+                cs->numPoolPixmaps * sizeof(PixmapPtr));
+        (*pScreen->DestroyPixmap) (pOldest);
+    }
+    cs->pixmapPool[cs->numPoolPixmaps++] = pPixmap;
+    cs->poolBytes += bytes;
+
+    cs->poolTimer = TimerSet(cs->poolTimer, 0, COMP_PIXMAP_POOL_DELAY,
+                             compPixmapPoolExpire, pScreen);
+    if (!cs->poolTimer)
+        compFlushPixmapPool(pScreen);
+}
+
+/*
+ * Backing pixmaps always match the window geometry exactly, so the
+ * pool is searched for an identical size and depth, newest first
+ */
 static PixmapPtr
-compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
+compTakePoolPixmap(ScreenPtr pScreen, int w, int h, int depth)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+    int i;
+
+    for (i = cs->numPoolPixmaps - 1; i >= 0; i--) {
+        PixmapPtr pPixmap = cs->pixmapPool[i];
+
+        if (pPixmap->drawable.width == w &&
+            pPixmap->drawable.height == h &&
+            pPixmap->drawable.depth == depth) {
+            cs->poolBytes -= compPixmapBytes(pPixmap);
+            cs->numPoolPixmaps--;
+            memmove(&cs->pixmapPool[i], &cs->pixmapPool[i + 1],
+                    (cs->numPoolPixmaps - i) * sizeof(PixmapPtr));
+            return pPixmap;
+        }
+    }
+    return NullPixmap;
+}
+
+/*
+ * Create the backing pixmap for pWin at screen position x,y.  When
+ * pOld is the pixmap being replaced, the part of the new pixmap it
+ * overlaps on screen is filled from the window's own old bits and only
+ * the newly exposed remainder is copied up from the parent; *pOldCopied
+ * reports whether that happened
+ */
+static PixmapPtr
+compNewPixmap(WindowPtr pWin, int x, int y, int w, int h,
+              PixmapPtr pOld, Bool *pOldCopied)
 {
     ScreenPtr pScreen = pWin->drawable.pScreen;
     WindowPtr pParent = pWin->parent;
     PixmapPtr pPixmap;
 
-    pPixmap = (*pScreen->CreatePixmap) (pScreen, w, h, pWin->drawable.depth,
-                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    if (pOldCopied)
+        *pOldCopied = FALSE;
+
+    pPixmap = compTakePoolPixmap(pScreen, w, h, pWin->drawable.depth);
+    if (!pPixmap)
+        pPixmap = (*pScreen->CreatePixmap) (pScreen, w, h,
+                                            pWin->drawable.depth,
+                                            CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
 
     if (!pPixmap)
         return 0;
@@ -546,15 +650,60 @@ compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
 
         if (pGC) {
             ChangeGCVal val;
+            BoxRec box;
+            RegionRec exposed;
+            BoxPtr pBox;
+            int nBox;
+
+            box.x1 = 0;
+            box.y1 = 0;
+            box.x2 = w;
+            box.y2 = h;
+            RegionInit(&exposed, &box, 1);
 
             val.val = IncludeInferiors;
             ChangeGC(NullClient, pGC, GCSubwindowMode, &val);
             ValidateGC(&pPixmap->drawable, pGC);
-            (*pGC->ops->CopyArea) (&pParent->drawable,
-                                   &pPixmap->drawable,
-                                   pGC,
-                                   x - pParent->drawable.x,
-                                   y - pParent->drawable.y, w, h, 0, 0);
+
+            if (pOld && pOld->drawable.depth == pWin->drawable.depth) {
+                box.x1 = max(x, pOld->screen_x);
+                box.y1 = max(y, pOld->screen_y);
+                box.x2 = min(x + w, pOld->screen_x + pOld->drawable.width);
+                box.y2 = min(y + h, pOld->screen_y + pOld->drawable.height);
+                if (box.x1 < box.x2 && box.y1 < box.y2) {
+                    RegionRec overlap;
+
+                    (*pGC->ops->CopyArea) (&pOld->drawable,
+                                           &pPixmap->drawable,
+                                           pGC,
+                                           box.x1 - pOld->screen_x,
+                                           box.y1 - pOld->screen_y,
+                                           box.x2 - box.x1,
+                                           box.y2 - box.y1,
+                                           box.x1 - x, box.y1 - y);
+                    RegionInit(&overlap, &box, 1);
+                    RegionTranslate(&overlap, -x, -y);
+                    RegionSubtract(&exposed, &exposed, &overlap);
+                    RegionUninit(&overlap);
+                    if (pOldCopied)
+                        *pOldCopied = TRUE;
+                }
+            }
+
+            pBox = RegionRects(&exposed);
+            nBox = RegionNumRects(&exposed);
+            while (nBox--) {
+                (*pGC->ops->CopyArea) (&pParent->drawable,
+                                       &pPixmap->drawable,
+                                       pGC,
+                                       x - pParent->drawable.x + pBox->x1,
+                                       y - pParent->drawable.y + pBox->y1,
+                                       pBox->x2 - pBox->x1,
+                                       pBox->y2 - pBox->y1,
+                                       pBox->x1, pBox->y1);
+                pBox++;
+            }
+            RegionUninit(&exposed);
             FreeScratchGC(pGC);
         }
     }
@@ -601,7 +750,7 @@ compAllocPixmap(WindowPtr pWin)
     int y = pWin->drawable.y - bw;
     int w = pWin->drawable.width + (bw << 1);
     int h = pWin->drawable.height + (bw << 1);
-    PixmapPtr pPixmap = compNewPixmap(pWin, x, y, w, h);
+    PixmapPtr pPixmap = compNewPixmap(pWin, x, y, w, h, NullPixmap, NULL);
     CompWindowPtr cw = GetCompWindow(pWin);
 
     if (!pPixmap)
@@ -677,7 +826,8 @@ compReallocPixmap(WindowPtr pWin, int draw_x, int draw_y,
     pix_w = w + (bw << 1);
     pix_h = h + (bw << 1);
     if (pix_w != pOld->drawable.width || pix_h != pOld->drawable.height) {
-        pNew = compNewPixmap(pWin, pix_x, pix_y, pix_w, pix_h);
+        pNew = compNewPixmap(pWin, pix_x, pix_y, pix_w, pix_h,
+                             pOld, &cw->oldBitsCopied);
         if (!pNew)
             return FALSE;
         cw->pOldPixmap = pOld;
@@ -686,6 +836,7 @@ compReallocPixmap(WindowPtr pWin, int draw_x, int draw_y,
     else {
         pNew = pOld;
         cw->pOldPixmap = 0;
+        cw->oldBitsCopied = FALSE;
     }
     pNew->screen_x = pix_x;
     pNew->screen_y = pix_y;
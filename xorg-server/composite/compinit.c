@@ -60,6 +60,9 @@ compCloseScreen(ScreenPtr pScreen)
 
     free(cs->alternateVisuals);
 
+    compFlushPixmapPool(pScreen);
+    TimerFree(cs->poolTimer);
+
     pScreen->CloseScreen = cs->CloseScreen;
     pScreen->InstallColormap = cs->InstallColormap;
     pScreen->ChangeWindowAttributes = cs->ChangeWindowAttributes;
@@ -394,6 +397,10 @@ compScreenInit(ScreenPtr pScreen)
     cs->numImplicitRedirectExceptions = 0;
     cs->implicitRedirectExceptions = NULL;
 
+    cs->numPoolPixmaps = 0;
+    cs->poolBytes = 0;
+    cs->poolTimer = NULL;
+
     if (!compAddAlternateVisuals(pScreen, cs)) {
         free(cs);
         return FALSE;
@@ -96,11 +96,21 @@ typedef struct _CompWindow {
     int oldx;
     int oldy;
     PixmapPtr pOldPixmap;
+    Bool oldBitsCopied;         /* pOldPixmap overlap already in place */
     int borderClipX, borderClipY;
 } CompWindowRec, *CompWindowPtr;
 
 #define COMP_ORIGIN_INVALID	    0x80000000
 
+/*
+ * Backing pixmaps released by unredirect, unmap and resize are kept
+ * for a short while so that a window being dragged to a size it had a
+ * moment ago, or remapped, can pick its storage back up
+ */
+#define COMP_PIXMAP_POOL_SIZE	    8
+#define COMP_PIXMAP_POOL_BYTES	    (64 * 1024 * 1024)
+#define COMP_PIXMAP_POOL_DELAY	    1000
+
 typedef struct _CompSubwindows {
     int update;
     CompClientWindowPtr clients;
@@ -171,6 +181,11 @@ typedef struct _CompScreen {
     GetImageProcPtr GetImage;
     GetSpansProcPtr GetSpans;
     SourceValidateProcPtr SourceValidate;
+
+    PixmapPtr pixmapPool[COMP_PIXMAP_POOL_SIZE];
+    int numPoolPixmaps;
+    size_t poolBytes;
+    OsTimerPtr poolTimer;
 } CompScreenRec, *CompScreenPtr;
 
 extern DevPrivateKeyRec CompScreenPrivateKeyRec;
@@ -237,6 +252,12 @@ Bool
 compReallocPixmap(WindowPtr pWin, int x, int y,
                   unsigned int w, unsigned int h, int bw);
 
+void
+ compReleasePixmap(ScreenPtr pScreen, PixmapPtr pPixmap);
+
+void
+ compFlushPixmapPool(ScreenPtr pScreen);
+
 void compMarkAncestors(WindowPtr pWin);
 
 /*
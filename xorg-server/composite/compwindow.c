@@ -171,7 +171,7 @@ compCheckRedirect(WindowPtr pWin)
 
             compSetParentPixmap(pWin);
             compRestoreWindow(pWin, pPixmap);
-            (*pScreen->DestroyPixmap) (pPixmap);
+            compReleasePixmap(pScreen, pPixmap);
         }
     }
     else if (should) {
@@ -375,8 +375,9 @@ compFreeOldPixmap(WindowPtr pWin)
         CompWindowPtr cw = GetCompWindow(pWin);
 
         if (cw->pOldPixmap) {
-            (*pScreen->DestroyPixmap) (cw->pOldPixmap);
+            compReleasePixmap(pScreen, cw->pOldPixmap);
             cw->pOldPixmap = NullPixmap;
+            cw->oldBitsCopied = FALSE;
         }
     }
 }
@@ -501,6 +502,15 @@ compCopyWindow(WindowPtr pWin, DDXPointRec ptOldOrg, RegionPtr prgnSrc)
 
             dx = ptOldOrg.x - pWin->drawable.x;
             dy = ptOldOrg.y - pWin->drawable.y;
+
+            /*
+             * compNewPixmap already carried the overlapping old bits
+             * across in place; with the origin unchanged that is
+             * exactly the copy gravity asks for
+             */
+            if (cw->oldBitsCopied && dx == 0 && dy == 0)
+                return;
+
             RegionTranslate(prgnSrc, -dx, -dy);
 
             RegionNull(&rgnDst);
@@ -608,7 +618,7 @@ compDestroyWindow(WindowPtr pWin)
         PixmapPtr pPixmap = (*pScreen->GetWindowPixmap) (pWin);
 
         compSetParentPixmap(pWin);
-        (*pScreen->DestroyPixmap) (pPixmap);
+        compReleasePixmap(pScreen, pPixmap);
     }
     ret = (*pScreen->DestroyWindow) (pWin);
     cs->DestroyWindow = pScreen->DestroyWindow;
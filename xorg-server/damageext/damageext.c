@@ -52,6 +52,17 @@ static DevPrivateKeyRec DamageClientPrivateKeyRec;
 
 #define DamageClientPrivateKey (&DamageClientPrivateKeyRec)
 
+/*
+ * With -damagecoalesce, raw rectangle damage is gathered up and reported
+ * once every DamageCoalesceInterval milliseconds, on the multiples of it,
+ * in at most DAMAGE_COALESCE_MAX_BOXES rectangles.  Screen recorders get
+ * one batch a frame instead of an event for every box of every request.
+ */
+#define DAMAGE_COALESCE_MAX_BOXES 16
+
+static struct xorg_list DamageExtPending;
+static OsTimerPtr DamageExtPendingTimer;
+
 static void
 DamageNoteCritical(ClientPtr pClient)
 {
@@ -132,6 +143,79 @@ DamageExtNotify(DamageExtPtr pDamageExt, BoxPtr pBoxes, int nBoxes)
     DamageNoteCritical(pClient);
 }
 
+static void
+DamageExtFlushPending(DamageExtPtr pDamageExt)
+{
+    BoxPtr pBoxes = RegionRects(&pDamageExt->pending);
+    int nBoxes = RegionNumRects(&pDamageExt->pending);
+    BoxRec merged[DAMAGE_COALESCE_MAX_BOXES];
+
+    if (nBoxes > DAMAGE_COALESCE_MAX_BOXES) {
+        /* The boxes run through the bands in order, so each run of them
+         * is bounded by a strip of the damage */
+        int run = (nBoxes + DAMAGE_COALESCE_MAX_BOXES - 1) /
+            DAMAGE_COALESCE_MAX_BOXES;
+        int i, j, n = 0;
+
+        for (i = 0; i < nBoxes; i += run) {
+            merged[n] = pBoxes[i];
+            for (j = i + 1; j < i + run && j < nBoxes; j++) {
+                merged[n].x1 = min(merged[n].x1, pBoxes[j].x1);
+                merged[n].y1 = min(merged[n].y1, pBoxes[j].y1);
+                merged[n].x2 = max(merged[n].x2, pBoxes[j].x2);
+                merged[n].y2 = max(merged[n].y2, pBoxes[j].y2);
+            }
+            n++;
+        }
+        pBoxes = merged;
+        nBoxes = n;
+    }
+
+    DamageExtNotify(pDamageExt, pBoxes, nBoxes);
+
+    RegionEmpty(&pDamageExt->pending);
+    xorg_list_del(&pDamageExt->pendingEntry);
+}
+
+static CARD32
+DamageExtFlushAll(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    DamageExtPtr pDamageExt, tmp;
+
+    xorg_list_for_each_entry_safe(pDamageExt, tmp, &DamageExtPending,
+                                  pendingEntry)
+        DamageExtFlushPending(pDamageExt);
+
+    return 0;
+}
+
+static void
+DamageExtHoldRaw(DamageExtPtr pDamageExt, RegionPtr pRegion)
+{
+    CARD32 interval = DamageCoalesceInterval;
+
+    if (!RegionUnion(&pDamageExt->pending, &pDamageExt->pending, pRegion)) {
+        /* Out of memory; what there is had better go out now */
+        if (!xorg_list_is_empty(&pDamageExt->pendingEntry))
+            DamageExtFlushPending(pDamageExt);
+        DamageExtNotify(pDamageExt, RegionRects(pRegion),
+                        RegionNumRects(pRegion));
+        return;
+    }
+
+    if (!xorg_list_is_empty(&pDamageExt->pendingEntry))
+        return;
+
+    if (xorg_list_is_empty(&DamageExtPending)) {
+        CARD32 now = GetTimeInMillis();
+
+        DamageExtPendingTimer = TimerSet(DamageExtPendingTimer, TimerAbsolute,
+                                         (now / interval + 1) * interval,
+                                         DamageExtFlushAll, NULL);
+    }
+    xorg_list_append(&pDamageExt->pendingEntry, &DamageExtPending);
+}
+
 static void
 DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
 {
@@ -139,6 +223,11 @@ DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
 
     switch (pDamageExt->level) {
     case DamageReportRawRegion:
+        if (DamageCoalesceInterval > 0) {
+            DamageExtHoldRaw(pDamageExt, pRegion);
+            break;
+        }
+        /* fall through */
     case DamageReportDeltaRegion:
         DamageExtNotify(pDamageExt, RegionRects(pRegion),
                         RegionNumRects(pRegion));
@@ -236,6 +325,8 @@ DamageExtCreate(DrawablePtr pDrawable, DamageReportLevel level,
     pDamageExt->pDrawable = pDrawable;
     pDamageExt->level = level;
     pDamageExt->pClient = client;
+    RegionNull(&pDamageExt->pending);
+    xorg_list_init(&pDamageExt->pendingEntry);
     pDamageExt->pDamage = DamageCreate(DamageExtReport, DamageExtDestroy, level,
                                        FALSE, pDrawable->pScreen, pDamageExt);
     if (!pDamageExt->pDamage) {
@@ -576,6 +667,8 @@ FreeDamageExt(void *value, XID did)
     if (pDamageExt->pDamage) {
         DamageDestroy(pDamageExt->pDamage);
     }
+    xorg_list_del(&pDamageExt->pendingEntry);
+    RegionUninit(&pDamageExt->pending);
     free(pDamageExt);
     return Success;
 }
@@ -718,6 +811,14 @@ PanoramiXDamageReset(void)
 
 #endif /* PANORAMIX */
 
+static void
+DamageExtCloseDown(ExtensionEntry *extEntry)
+{
+    /* Free the timer here, as the next generation frees only those queued */
+    TimerFree(DamageExtPendingTimer);
+    DamageExtPendingTimer = NULL;
+}
+
 void
 DamageExtensionInit(void)
 {
@@ -727,6 +828,9 @@ DamageExtensionInit(void)
     for (s = 0; s < screenInfo.numScreens; s++)
         DamageSetup(screenInfo.screens[s]);
 
+    /* The pending list went with the damage of the last generation */
+    xorg_list_init(&DamageExtPending);
+
     DamageExtType = CreateNewResourceType(FreeDamageExt, "DamageExt");
     if (!DamageExtType)
         return;
@@ -738,7 +842,8 @@ DamageExtensionInit(void)
     if ((extEntry = AddExtension(DAMAGE_NAME, XDamageNumberEvents,
                                  XDamageNumberErrors,
                                  ProcDamageDispatch, SProcDamageDispatch,
-                                 NULL, StandardMinorOpcode)) != 0) {
+                                 DamageExtCloseDown,
+                                 StandardMinorOpcode)) != 0) {
         DamageReqCode = (unsigned char) extEntry->base;
         DamageEventBase = extEntry->eventBase;
         EventSwapVector[DamageEventBase + XDamageNotify] =
@@ -157,6 +157,13 @@ typedef struct _DbeWindowPrivRec {
      */
     PixmapPtr pFrontBuffer;
 
+    /* Damage to the back buffer since the last swap, and to the window by
+     * anything but a swap.  While both are tracked, the window and the back
+     * buffer agree everywhere else, so a swap only copies what they cover.
+     */
+    struct _damage *pBackDamage;
+    struct _damage *pWindowDamage;
+
     /* Device-specific private information.
      */
     PrivateRec *devPrivates;
@@ -52,10 +52,14 @@
 #include "gcstruct.h"
 #include "inputstr.h"
 #include "midbe.h"
+#include "damage.h"
 #include "xace.h"
 
 #include <stdio.h>
 
+/* Beyond this many boxes, a swap copies their extents instead */
+#define MIDBE_MAX_SWAP_BOXES 32
+
 
 /******************************************************************************
  *
@@ -235,6 +239,72 @@ miDbeAliasBuffers(DbeWindowPrivPtr pDbeWindowPriv)
 
 }                               /* miDbeAliasBuffers() */
 
+/******************************************************************************
+ *
+ * DBE MI Procedures: miDbeStartTracking, miDbeStopTracking
+ *
+ * Description:
+ *
+ *     These functions start and stop tracking what was drawn to the back
+ *     buffer and the window since a swap left them the same, so that the
+ *     next swap can copy only that.  Tracking stops whenever the buffers
+ *     are replaced or exchanged, and starts again with the next full swap.
+ *
+ *****************************************************************************/
+
+static void
+miDbeTrackingDestroy(DamagePtr pDamage, void *closure)
+{
+    DbeWindowPrivPtr pDbeWindowPriv = closure;
+
+    if (pDbeWindowPriv->pBackDamage == pDamage)
+        pDbeWindowPriv->pBackDamage = NULL;
+    if (pDbeWindowPriv->pWindowDamage == pDamage)
+        pDbeWindowPriv->pWindowDamage = NULL;
+}
+
+static void
+miDbeStopTracking(DbeWindowPrivPtr pDbeWindowPriv)
+{
+    /* miDbeTrackingDestroy() clears the pointers */
+    if (pDbeWindowPriv->pBackDamage)
+        DamageDestroy(pDbeWindowPriv->pBackDamage);
+    if (pDbeWindowPriv->pWindowDamage)
+        DamageDestroy(pDbeWindowPriv->pWindowDamage);
+}
+
+static void
+miDbeStartTracking(DbeWindowPrivPtr pDbeWindowPriv)
+{
+    WindowPtr pWin = pDbeWindowPriv->pWindow;
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+
+    if (!pDbeWindowPriv->pBackDamage) {
+        pDbeWindowPriv->pBackDamage =
+            DamageCreate(NULL, miDbeTrackingDestroy, DamageReportNone, TRUE,
+                         pScreen, pDbeWindowPriv);
+        if (pDbeWindowPriv->pBackDamage)
+            DamageRegister(&pDbeWindowPriv->pBackBuffer->drawable,
+                           pDbeWindowPriv->pBackDamage);
+    }
+
+    if (!pDbeWindowPriv->pWindowDamage) {
+        pDbeWindowPriv->pWindowDamage =
+            DamageCreate(NULL, miDbeTrackingDestroy, DamageReportNone, TRUE,
+                         pScreen, pDbeWindowPriv);
+        if (pDbeWindowPriv->pWindowDamage)
+            DamageRegister(&pWin->drawable, pDbeWindowPriv->pWindowDamage);
+    }
+
+    if (!pDbeWindowPriv->pBackDamage || !pDbeWindowPriv->pWindowDamage) {
+        miDbeStopTracking(pDbeWindowPriv);
+        return;
+    }
+
+    DamageEmpty(pDbeWindowPriv->pBackDamage);
+    DamageEmpty(pDbeWindowPriv->pWindowDamage);
+}
+
 /******************************************************************************
  *
  * DBE MI Procedure: miDbeSwapBuffers
@@ -293,9 +363,46 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
      */
 
     ValidateGC((DrawablePtr) pWin, pGC);
-    (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
-                           (DrawablePtr) pWin, pGC, 0, 0,
-                           pWin->drawable.width, pWin->drawable.height, 0, 0);
+    if (swapInfo[0].swapAction != XdbeUntouched &&
+        pDbeWindowPriv->pBackDamage && pDbeWindowPriv->pWindowDamage) {
+        RegionRec rgnStale;
+        BoxPtr pBox;
+        int nBox;
+
+        /* Window damage is in screen coordinates. */
+        RegionNull(&rgnStale);
+        RegionCopy(&rgnStale, DamageRegion(pDbeWindowPriv->pWindowDamage));
+        RegionTranslate(&rgnStale, -pWin->drawable.x, -pWin->drawable.y);
+        RegionUnion(&rgnStale, &rgnStale,
+                    DamageRegion(pDbeWindowPriv->pBackDamage));
+
+        nBox = RegionNumRects(&rgnStale);
+        pBox = RegionRects(&rgnStale);
+        if (nBox > MIDBE_MAX_SWAP_BOXES) {
+            nBox = 1;
+            pBox = RegionExtents(&rgnStale);
+        }
+        for (; nBox--; pBox++) {
+            (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
+                                   (DrawablePtr) pWin, pGC,
+                                   pBox->x1, pBox->y1,
+                                   pBox->x2 - pBox->x1, pBox->y2 - pBox->y1,
+                                   pBox->x1, pBox->y1);
+        }
+        RegionUninit(&rgnStale);
+    }
+    else {
+        (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
+                               (DrawablePtr) pWin, pGC, 0, 0,
+                               pWin->drawable.width, pWin->drawable.height,
+                               0, 0);
+    }
+
+    /* The window and back buffer now agree, unless they are exchanged. */
+    if (swapInfo[0].swapAction == XdbeUntouched)
+        miDbeStopTracking(pDbeWindowPriv);
+    else
+        miDbeStartTracking(pDbeWindowPriv);
 
     /*
      **********************************************************************
@@ -426,6 +533,8 @@ miDbeWinPrivDelete(DbeWindowPrivPtr pDbeWindowPriv, XID bufId)
      * free some stuff.
      */
 
+    miDbeStopTracking(pDbeWindowPriv);
+
     /* Destroy the front and back pixmaps. */
     if (pDbeWindowPriv->pFrontBuffer) {
         (*pDbeWindowPriv->pWindow->drawable.pScreen->
@@ -640,9 +749,10 @@ miDbePositionWindow(WindowPtr pWin, int x, int y)
         }
 
         /* Destroy the old pixmaps, and point the DBE window priv to the new
-         * pixmaps.
+         * pixmaps.  The next swap copies all of the back buffer.
          */
 
+        miDbeStopTracking(pDbeWindowPriv);
         (*pScreen->DestroyPixmap) (pDbeWindowPriv->pFrontBuffer);
         (*pScreen->DestroyPixmap) (pDbeWindowPriv->pBackBuffer);
 
@@ -672,6 +782,10 @@ miDbePositionWindow(WindowPtr pWin, int x, int y)
 Bool
 miDbeInit(ScreenPtr pScreen, DbeScreenPrivPtr pDbeScreenPriv)
 {
+    /* Swaps track what was drawn with damage. */
+    if (!DamageSetup(pScreen))
+        return FALSE;
+
     /* Wrap functions. */
     pDbeScreenPriv->PositionWindow = pScreen->PositionWindow;
     pScreen->PositionWindow = miDbePositionWindow;
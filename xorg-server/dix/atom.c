@@ -58,49 +58,85 @@ SOFTWARE.
 
 #define InitialTableSize 256
 
+/*
+ * Atoms are found by name through an open addressed hash table of atom
+ * numbers, using linear probing, kept at most half full.  Atoms are never
+ * freed individually, so it only needs to grow.  nodeTable maps atoms back
+ * to their names.
+ */
+
 typedef struct _Node {
-    struct _Node *left, *right;
     Atom a;
-    unsigned int fingerPrint;
+    unsigned int hash;
+    unsigned int len;
     const char *string;
 } NodeRec, *NodePtr;
 
 static Atom lastAtom = None;
-static NodePtr atomRoot = NULL;
 static unsigned long tableLength;
 static NodePtr *nodeTable;
+static Atom *hashTable;
+static unsigned int hashMask;
 
-Atom
-MakeAtom(const char *string, unsigned len, Bool makeit)
+static unsigned int
+HashAtomName(const char *string, unsigned len)
 {
-    NodePtr *np;
+    unsigned int hash = 2166136261u;
     unsigned i;
-    int comp;
-    unsigned int fp = 0;
 
-    np = &atomRoot;
-    for (i = 0; i < (len + 1) / 2; i++) {
-        fp = fp * 27 + string[i];
-        fp = fp * 27 + string[len - 1 - i];
+    /* FNV-1a */
+    for (i = 0; i < len; i++) {
+        hash ^= (unsigned char) string[i];
+        hash *= 16777619u;
     }
-    while (*np != NULL) {
-        if (fp < (*np)->fingerPrint)
-            np = &((*np)->left);
-        else if (fp > (*np)->fingerPrint)
-            np = &((*np)->right);
-        else {                  /* now start testing the strings */
-            comp = strncmp(string, (*np)->string, (int) len);
-            if ((comp < 0) || ((comp == 0) && (len < strlen((*np)->string))))
-                np = &((*np)->left);
-            else if (comp > 0)
-                np = &((*np)->right);
-            else
-                return (*np)->a;
-        }
+    return hash;
+}
+
+static Bool
+GrowAtomHash(void)
+{
+    unsigned int size = (hashMask + 1) * 2;
+    Atom *table;
+    Atom a;
+
+    table = calloc(size, sizeof(Atom));
+    if (!table)
+        return FALSE;
+    for (a = 1; a <= lastAtom; a++) {
+        unsigned int i = nodeTable[a]->hash & (size - 1);
+
+        while (table[i])
+            i = (i + 1) & (size - 1);
+        table[i] = a;
     }
-    if (makeit) {
-        NodePtr nd;
+    free(hashTable);
+    hashTable = table;
+    hashMask = size - 1;
+    return TRUE;
+}
 
+Atom
+MakeAtom(const char *string, unsigned len, Bool makeit)
+{
+    unsigned int hash = HashAtomName(string, len);
+    unsigned int i;
+    NodePtr nd;
+
+    if (!hashTable)
+        return makeit ? BAD_RESOURCE : None;
+    for (i = hash & hashMask; hashTable[i]; i = (i + 1) & hashMask) {
+        nd = nodeTable[hashTable[i]];
+        if (nd->hash == hash && nd->len == len &&
+            memcmp(nd->string, string, len) == 0)
+            return nd->a;
+    }
+    if (makeit) {
+        /* keep the table at most half full, and an empty slot to end probes */
+        if (lastAtom + 1 > hashMask / 2) {
+            if (!GrowAtomHash() && lastAtom + 1 >= hashMask)
+                return BAD_RESOURCE;
+            for (i = hash & hashMask; hashTable[i]; i = (i + 1) & hashMask);
+        }
         nd = malloc(sizeof(NodeRec));
         if (!nd)
             return BAD_RESOURCE;
@@ -129,11 +165,11 @@ MakeAtom(const char *string, unsigned len, Bool makeit)
             tableLength <<= 1;
             nodeTable = table;
         }
-        *np = nd;
-        nd->left = nd->right = NULL;
-        nd->fingerPrint = fp;
+        nd->hash = hash;
+        nd->len = len;
         nd->a = ++lastAtom;
         nodeTable[lastAtom] = nd;
+        hashTable[i] = nd->a;
         return nd->a;
     }
     else
@@ -164,32 +200,27 @@ AtomError(void)
     FatalError("initializing atoms");
 }
 
-static void
-FreeAtom(NodePtr patom)
-{
-    if (patom->left)
-        FreeAtom(patom->left);
-    if (patom->right)
-        FreeAtom(patom->right);
-    if (patom->a > XA_LAST_PREDEFINED) {
-        /*
-         * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's safe to
-         * cast here
-         */
-        free((char *) patom->string);
-    }
-    free(patom);
-}
-
 void
 FreeAllAtoms(void)
 {
-    if (atomRoot == NULL)
+    Atom a;
+
+    if (nodeTable == NULL)
         return;
-    FreeAtom(atomRoot);
-    atomRoot = NULL;
+    for (a = 1; a <= lastAtom; a++) {
+        if (a > XA_LAST_PREDEFINED) {
+            /*
+             * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's
+             * safe to cast here
+             */
+            free((char *) nodeTable[a]->string);
+        }
+        free(nodeTable[a]);
+    }
     free(nodeTable);
     nodeTable = NULL;
+    free(hashTable);
+    hashTable = NULL;
     lastAtom = None;
 }
 
@@ -202,6 +233,10 @@ InitAtoms(void)
     if (!nodeTable)
         AtomError();
     nodeTable[None] = NULL;
+    hashMask = 2 * InitialTableSize - 1;
+    hashTable = calloc(hashMask + 1, sizeof(Atom));
+    if (!hashTable)
+        AtomError();
     MakePredeclaredAtoms();
     if (lastAtom != XA_LAST_PREDEFINED)
         AtomError();
@@ -134,10 +134,13 @@ int ProcInitialConnection();
 #include "site.h"
 #include "client.h"
 
-#ifdef XSERVER_DTRACE
+#if defined(XSERVER_DTRACE) || defined(XSERVER_FRAME_TRACE)
 #include "registry.h"
+#endif
+#ifdef XSERVER_DTRACE
 #include "probes.h"
 #endif
+#include "frametrace.h"
 
 #define mskcnt ((MAXCLIENTS + 31) / 32)
 #define BITMASK(i) (1U << ((i) & 31))
@@ -234,9 +237,31 @@ long SmartScheduleInterval = SMART_SCHEDULE_DEFAULT_INTERVAL;
 long SmartScheduleMaxSlice = SMART_SCHEDULE_MAX_SLICE;
 long SmartScheduleTime;
 int SmartScheduleLatencyLimited = 0;
+Bool SmartScheduleStats = FALSE;
+CARD64 RequestsDispatched;
 static ClientPtr SmartLastClient;
 static int SmartLastIndex[SMART_MAX_PRIORITY - SMART_MIN_PRIORITY + 1];
 
+/*
+ * -schedstats: per client scheduling statistics, logged when the client
+ * goes away.  Times are in milliseconds; the histograms have power of two
+ * buckets, the last one collecting everything longer.  A client counts as
+ * starved when it waited at least SmartScheduleMaxSlice to be scheduled.
+ */
+#define SCHED_STATS_BUCKETS 12
+
+typedef struct _SchedStats {
+    unsigned long requests;
+    unsigned long slices;
+    unsigned long dispatch_time;
+    unsigned long wait_time;
+    unsigned long starved;
+    CARD32 ready_since;         /* when it last became ready */
+    CARD32 slice_start;
+    unsigned long dispatch_hist[SCHED_STATS_BUCKETS];
+    unsigned long wait_hist[SCHED_STATS_BUCKETS];
+} SchedStatsRec;
+
 #ifdef SMART_DEBUG
 long SmartLastPrint;
 #endif
@@ -265,8 +290,11 @@ clients_are_ready(void)
 void
 mark_client_ready(ClientPtr client)
 {
-    if (xorg_list_is_empty(&client->ready))
+    if (xorg_list_is_empty(&client->ready)) {
         xorg_list_append(&client->ready, &ready_clients);
+        if (client->sched_stats)
+            client->sched_stats->ready_since = GetTimeInMillis();
+    }
 }
 
 /*
@@ -307,7 +335,83 @@ mark_client_ungrab(void)
     xorg_list_for_each_entry_safe(client, tmp, &saved_ready_clients, ready) {
         xorg_list_del(&client->ready);
         xorg_list_append(&client->ready, &ready_clients);
+        if (client->sched_stats)
+            client->sched_stats->ready_since = GetTimeInMillis();
+    }
+}
+
+static int
+sched_stats_bucket(CARD32 ms)
+{
+    int bucket = 0;
+
+    while (ms && bucket < SCHED_STATS_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void
+sched_stats_start(ClientPtr client)
+{
+    SchedStatsRec *stats = client->sched_stats;
+    CARD32 now = GetTimeInMillis();
+    CARD32 wait = now - stats->ready_since;
+
+    stats->slice_start = now;
+    stats->wait_time += wait;
+    stats->wait_hist[sched_stats_bucket(wait)]++;
+    if (wait >= SmartScheduleMaxSlice)
+        stats->starved++;
+}
+
+static void
+sched_stats_stop(ClientPtr client)
+{
+    SchedStatsRec *stats = client->sched_stats;
+    CARD32 now = GetTimeInMillis();
+    CARD32 ran = now - stats->slice_start;
+
+    stats->slices++;
+    stats->dispatch_time += ran;
+    stats->dispatch_hist[sched_stats_bucket(ran)]++;
+    /* still ready, so from now on it is waiting for its next slice */
+    if (!xorg_list_is_empty(&client->ready))
+        stats->ready_since = now;
+}
+
+static void
+sched_stats_log_hist(const char *what, const unsigned long *hist)
+{
+    char line[256];
+    int len, bucket;
+
+    len = snprintf(line, sizeof(line), "    %s:", what);
+    for (bucket = 0; bucket < SCHED_STATS_BUCKETS && len < sizeof(line); bucket++) {
+        if (bucket == SCHED_STATS_BUCKETS - 1)
+            len += snprintf(line + len, sizeof(line) - len, " %u+ms:%lu",
+                            1U << (bucket - 1), hist[bucket]);
+        else
+            len += snprintf(line + len, sizeof(line) - len, " <%ums:%lu",
+                            1U << bucket, hist[bucket]);
     }
+    LogMessageVerb(X_NONE, 0, "%s\n", line);
+}
+
+static void
+sched_stats_log(ClientPtr client)
+{
+    SchedStatsRec *stats = client->sched_stats;
+    const char *cmdname = GetClientCmdName(client);
+
+    LogMessage(X_INFO, "client %d (%s): %lu requests in %lu slices, "
+               "%lu ms dispatching, %lu ms waiting, starved %lu times\n",
+               client->index, cmdname ? cmdname : "unknown",
+               stats->requests, stats->slices, stats->dispatch_time,
+               stats->wait_time, stats->starved);
+    sched_stats_log_hist("slice length", stats->dispatch_hist);
+    sched_stats_log_hist("queueing delay", stats->wait_hist);
 }
 
 static ClientPtr
@@ -454,12 +558,16 @@ void DispatchQueuedEvents(Bool wait)
         if (!dispatchException && clients_are_ready())
         {
             long start_tick;
+            CARD64 request_us;
             ClientPtr client;
             client = SmartScheduleClient();
+            if (client->sched_stats)
+                sched_stats_start(client);
 
             isItTimeToYield = FALSE;
 
             start_tick = SmartScheduleTime;
+            request_us = GetTimeInMicros();
             while (!isItTimeToYield)
             {
                 int result;
@@ -488,6 +596,10 @@ void DispatchQueuedEvents(Bool wait)
                 }
 
                 client->sequence++;
+                RequestsDispatched++;
+                client->stats.requests++;
+                if (client->sched_stats)
+                    client->sched_stats->requests++;
                 client->majorOp = ((xReq *) client->requestBuffer)->reqType;
                 client->minorOp = 0;
                 if (client->majorOp >= EXTENSION_BASE)
@@ -513,11 +625,41 @@ void DispatchQueuedEvents(Bool wait)
                 else
                 {
                     result = XaceHookDispatch(client, client->majorOp);
-                    if (result == Success)
+                    if (result == Success) {
+#ifdef XSERVER_REQUEST_PROFILE
+                        int major = client->majorOp, minor = client->minorOp;
+                        CARD64 profile_start;
+#endif
+#ifdef XSERVER_FRAME_TRACE
+                        const char *trace_name = NULL;
+
+                        if (FrameTraceOn) {
+                            trace_name = LookupRequestName(client->majorOp,
+                                                           client->minorOp);
+                            FrameTraceBegin(trace_name);
+                        }
+#endif
+#ifdef XSERVER_REQUEST_PROFILE
+                        profile_start = RequestProfileTicks();
+#endif
                         result = (*client->requestVector[client->majorOp]) (client);
+#ifdef XSERVER_FRAME_TRACE
+                        if (trace_name)
+                            FrameTraceEnd(trace_name);
+#endif
+#ifdef XSERVER_REQUEST_PROFILE
+                        RequestProfileRecord(major, minor, profile_start);
+#endif
+                    }
                 }
                 if (!SmartScheduleSignalEnable)
                     SmartScheduleTime = GetTimeInMillis();
+                {
+                    CARD64 now_us = GetTimeInMicros();
+
+                    client->stats.dispatch_us += now_us - request_us;
+                    request_us = now_us;
+                }
 
 #ifdef XSERVER_DTRACE
                 if (XSERVER_REQUEST_DONE_ENABLED())
@@ -556,8 +698,11 @@ void DispatchQueuedEvents(Bool wait)
                 }
             }
             FlushAllOutput();
-            if (client == SmartLastClient)
+            if (client == SmartLastClient) {
                 client->smart_stop_tick = SmartScheduleTime;
+                if (client->sched_stats)
+                    sched_stats_stop(client);
+            }
         }
         dispatchException &= ~DE_PRIORITYCHANGE;
     }
@@ -580,6 +725,15 @@ Dispatch(void)
     }
 #if defined(DDXBEFORERESET)
     ddxBeforeReset();
+#endif
+#ifdef XSERVER_REQUEST_PROFILE
+    DumpRequestProfile();
+#endif
+#ifdef XSERVER_INPUT_LATENCY
+    DumpInputLatency();
+#endif
+#ifdef XSERVER_FRAME_TRACE
+    FrameTraceFlush();
 #endif
     KillAllClients();
     dispatchException &= ~DE_RESET;
@@ -3560,6 +3714,10 @@ CloseDownClient(ClientPtr client)
             nextFreeClientID = client->index;
         clients[client->index] = NullClient;
         SmartLastClient = NullClient;
+        if (client->sched_stats) {
+            sched_stats_log(client);
+            free(client->sched_stats);
+        }
         dixFreeObjectWithPrivates(client, PRIVATE_CLIENT);
 
         while (!clients[currentMaxClients - 1])
@@ -3593,6 +3751,10 @@ InitClient(ClientPtr client, int i, void *ospriv)
     QueryMinMaxKeyCodes(&client->minKC, &client->maxKC);
     client->smart_start_tick = SmartScheduleTime;
     client->smart_stop_tick = SmartScheduleTime;
+    client->sched_stats = NULL;
+    if (i && SmartScheduleStats)
+        client->sched_stats = calloc(1, sizeof(SchedStatsRec));
+    memset(&client->stats, 0, sizeof(client->stats));
     client->clientIds = NULL;
 }
 
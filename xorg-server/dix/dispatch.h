@@ -36,6 +36,11 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #ifndef DISPATCH_H
 #define DISPATCH_H 1
 
+#ifdef XSERVER_REQUEST_PROFILE
+CARD64 RequestProfileTicks(void);
+void RequestProfileRecord(int /* major */ , int /* minor */ , CARD64 /* start */ );
+#endif
+
 int ProcAllocColor(ClientPtr /* client */ );
 int ProcAllocColorCells(ClientPtr /* client */ );
 int ProcAllocColorPlanes(ClientPtr /* client */ );
@@ -5890,6 +5890,33 @@ ProcRecolorCursor(ClientPtr client)
     return Success;
 }
 
+/*
+ * Write a core MotionNotify in wire format.  If the last thing written to
+ * the client is a MotionNotify it has not been sent yet, for the same
+ * window, child, root, state and hint detail, it is replaced instead, so a
+ * client which is behind gets the latest position rather than a backlog of
+ * them.
+ */
+static void
+WriteMotionToClient(ClientPtr pClient, xEvent *motion)
+{
+    xEvent *pending = CoalescableClientEvent(pClient);
+
+    if (pending && pending->u.u.type == MotionNotify &&
+        pending->u.u.detail == motion->u.u.detail &&
+        pending->u.keyButtonPointer.root == motion->u.keyButtonPointer.root &&
+        pending->u.keyButtonPointer.event == motion->u.keyButtonPointer.event &&
+        pending->u.keyButtonPointer.child == motion->u.keyButtonPointer.child &&
+        pending->u.keyButtonPointer.state == motion->u.keyButtonPointer.state &&
+        pending->u.keyButtonPointer.sameScreen ==
+        motion->u.keyButtonPointer.sameScreen) {
+        memcpy(pending, motion, sizeof(xEvent));
+        return;
+    }
+
+    WriteCoalescableToClient(pClient, sizeof(xEvent), motion);
+}
+
 /**
  * Write the given events to a client, swapping the byte order if necessary.
  * To swap the byte ordering, a callback is called that has to be set up for
@@ -6003,9 +6030,15 @@ WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
             (*EventSwapVector[eventFrom->u.u.type & 0177])
                 (eventFrom, eventTo);
 
-            WriteToClient(pClient, eventlength, eventTo);
+            if (count == 1 && eventFrom->u.u.type == MotionNotify)
+                WriteMotionToClient(pClient, eventTo);
+            else
+                WriteToClient(pClient, eventlength, eventTo);
         }
     }
+    else if (count == 1 && events->u.u.type == MotionNotify) {
+        WriteMotionToClient(pClient, events);
+    }
     else {
         /* only one GenericEvent, remember? that means either count is 1 and
          * eventlength is arbitrary or eventlength is 32 and count doesn't
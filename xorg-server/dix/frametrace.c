@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Frame timing trace (XSERVER_FRAME_TRACE)
+ *
+ * The markers of frametrace.h are written to whichever of these is on:
+ *
+ * - the "VcXsrv.FrameTrace" TraceLogging provider on Windows, as "Span"
+ *   start and stop events with the marker name in their Name field.  It
+ *   is registered when the server starts, and turns itself on and off as
+ *   ETW sessions enable it;
+ * - the file named by -frametrace, in the JSON array format of Chrome's
+ *   trace events, which is what Perfetto reads besides its own.  The
+ *   closing bracket is written at exit, but both readers do without it.
+ *
+ * Markers come from the server thread and the threads of the Windows
+ * DDX, so the file is written under a lock.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#ifdef XSERVER_FRAME_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <X11/X.h>
+#include "misc.h"
+#include "os.h"
+#include "frametrace.h"
+
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+#else
+#include <unistd.h>
+#endif
+
+#define FRAME_TRACE_FILE    1
+#define FRAME_TRACE_ETW     2
+
+volatile int FrameTraceOn;
+const char *FrameTracePath;
+
+static FILE *frame_trace_file;
+static Bool frame_trace_first;    /* no event written yet */
+static pthread_mutex_t frame_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long frame_trace_pid;
+
+#ifdef WIN32
+/* {1c7e9eaf-99c4-414b-9c67-8095f215778b} */
+TRACELOGGING_DEFINE_PROVIDER(frame_trace_provider, "VcXsrv.FrameTrace",
+                             (0x1c7e9eaf, 0x99c4, 0x414b, 0x9c, 0x67, 0x80,
+                              0x95, 0xf2, 0x15, 0x77, 0x8b));
+
+static void NTAPI
+frame_trace_etw_control(LPCGUID source, ULONG control, UCHAR level,
+                        ULONGLONG anyKeyword, ULONGLONG allKeyword,
+                        PEVENT_FILTER_DESCRIPTOR filter, PVOID context)
+{
+    if (control == EVENT_CONTROL_CODE_ENABLE_PROVIDER)
+        FrameTraceOn |= FRAME_TRACE_ETW;
+    else if (control == EVENT_CONTROL_CODE_DISABLE_PROVIDER)
+        FrameTraceOn &= ~FRAME_TRACE_ETW;
+}
+#endif
+
+static unsigned long
+frame_trace_thread(void)
+{
+#ifdef WIN32
+    return GetCurrentThreadId();
+#else
+    return (unsigned long) pthread_self();
+#endif
+}
+
+static void
+frame_trace_write(char phase, const char *name)
+{
+    CARD64 now = GetTimeInMicrosPrecise();
+    unsigned long tid = frame_trace_thread();
+
+    pthread_mutex_lock(&frame_trace_mutex);
+    if (frame_trace_file) {
+        fprintf(frame_trace_file,
+                "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,"
+                "\"pid\":%lu,\"tid\":%lu}",
+                frame_trace_first ? "" : ",\n",
+                name, phase, (unsigned long long) now, frame_trace_pid, tid);
+        frame_trace_first = FALSE;
+    }
+    pthread_mutex_unlock(&frame_trace_mutex);
+}
+
+static void
+frame_trace_exit(void)
+{
+    FrameTraceOn = 0;
+#ifdef WIN32
+    TraceLoggingUnregister(frame_trace_provider);
+#endif
+
+    pthread_mutex_lock(&frame_trace_mutex);
+    if (frame_trace_file) {
+        fputs("\n]\n", frame_trace_file);
+        fclose(frame_trace_file);
+        frame_trace_file = NULL;
+    }
+    pthread_mutex_unlock(&frame_trace_mutex);
+}
+
+/**
+ * Register the ETW provider and open the -frametrace file.  Called once,
+ * before the first server generation.
+ */
+void
+FrameTraceInit(void)
+{
+#ifdef WIN32
+    frame_trace_pid = GetCurrentProcessId();
+    if (TraceLoggingRegisterEx(frame_trace_provider, frame_trace_etw_control,
+                               NULL) != S_OK)
+        ErrorF("FrameTraceInit: cannot register the ETW provider\n");
+#else
+    frame_trace_pid = getpid();
+#endif
+
+    if (FrameTracePath) {
+        frame_trace_file = fopen(FrameTracePath, "w");
+        if (frame_trace_file) {
+            fputs("[\n", frame_trace_file);
+            frame_trace_first = TRUE;
+            FrameTraceOn |= FRAME_TRACE_FILE;
+        }
+        else
+            ErrorF("FrameTraceInit: cannot open %s\n", FrameTracePath);
+    }
+
+    atexit(frame_trace_exit);
+}
+
+/**
+ * Push what the trace file holds so far out to the disk.  Called at
+ * server reset.
+ */
+void
+FrameTraceFlush(void)
+{
+    pthread_mutex_lock(&frame_trace_mutex);
+    if (frame_trace_file)
+        fflush(frame_trace_file);
+    pthread_mutex_unlock(&frame_trace_mutex);
+}
+
+void
+FrameTraceBegin(const char *name)
+{
+#ifdef WIN32
+    if (FrameTraceOn & FRAME_TRACE_ETW)
+        TraceLoggingWrite(frame_trace_provider, "Span",
+                          TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                          TraceLoggingString(name, "Name"));
+#endif
+    if (FrameTraceOn & FRAME_TRACE_FILE)
+        frame_trace_write('B', name);
+}
+
+void
+FrameTraceEnd(const char *name)
+{
+#ifdef WIN32
+    if (FrameTraceOn & FRAME_TRACE_ETW)
+        TraceLoggingWrite(frame_trace_provider, "Span",
+                          TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                          TraceLoggingString(name, "Name"));
+#endif
+    if (FrameTraceOn & FRAME_TRACE_FILE)
+        frame_trace_write('E', name);
+}
+
+#endif                          /* XSERVER_FRAME_TRACE */
@@ -1405,6 +1405,14 @@ fill_pointer_events(InternalEvent *events, DeviceIntPtr pDev, int type,
         set_raw_valuators(raw, &mask, TRUE, raw->valuators.data_raw);
     }
 
+    /* Raw data from a device some other path moves the sprite for */
+    if (flags & POINTER_RAWONLY) {
+        if (!raw)
+            return 0;
+        set_raw_valuators(raw, &mask, FALSE, raw->valuators.data);
+        return 1;
+    }
+
     valuator_mask_drop_unaccelerated(&mask);
 
     /* valuators are in driver-native format (rel or abs) */
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Input latency trace (XSERVER_INPUT_LATENCY)
+ *
+ * An input event is time stamped as the DDX receives it, as mieq queues
+ * it, as ProcessInputEvents() takes it off the queue, as the first event
+ * it produces for each client is written to that client's output buffer,
+ * and as that buffer reaches the socket.  The time between stamps is kept
+ * per stage as a log2 histogram in microseconds, so lag can be put down to
+ * the DDX's own message queue, to mieq waiting for the dispatch loop, or
+ * to output waiting to be flushed.  Everything runs on the server thread.
+ * DumpInputLatency() writes the histograms to the log; the Windows tray
+ * menu offers it, and it also runs at server reset.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#ifdef XSERVER_INPUT_LATENCY
+
+#include <X11/X.h>
+#include "misc.h"
+#include "os.h"
+#include "dix.h"
+#include "dixstruct.h"
+
+enum {
+    LATENCY_DDX_QUEUE,          /* posted to the DDX until received */
+    LATENCY_DDX,                /* received until queued in mieq */
+    LATENCY_MIEQ,               /* queued until processed */
+    LATENCY_DELIVERY,           /* processed until written for a client */
+    LATENCY_OUTPUT,             /* written until flushed to the socket */
+    LATENCY_TOTAL,              /* received until flushed to the socket */
+    LATENCY_STAGES
+};
+
+static const char *latency_stage_names[LATENCY_STAGES] = {
+    "DDX message queue",
+    "DDX to mieq",
+    "mieq to processing",
+    "processing to client buffer",
+    "client buffer to socket",
+    "received to socket",
+};
+
+/* bucket 0 counts 0 and 1 us, bucket i counts [2^i, 2^(i+1)) us, and the
+   last one everything from 2^(LATENCY_BUCKETS-1) up */
+#define LATENCY_BUCKETS 32
+
+typedef struct {
+    CARD64 count;
+    CARD64 total;
+    CARD64 max;
+    CARD32 hist[LATENCY_BUCKETS];
+} InputLatencyStageRec;
+
+static InputLatencyStageRec latency_stages[LATENCY_STAGES];
+
+/* the input the DDX is handling, until mieq queues an event for it */
+static InputLatencyRec latency_received;
+
+/* the event being processed, while it is delivered */
+static InputLatencyRec latency_processing;
+
+static void
+latency_record(int stage, CARD64 us)
+{
+    InputLatencyStageRec *entry = &latency_stages[stage];
+    int bucket;
+
+    entry->count++;
+    entry->total += us;
+    if (us > entry->max)
+        entry->max = us;
+
+    for (bucket = 0; bucket < LATENCY_BUCKETS - 1 && (us >> (bucket + 1)); bucket++)
+        ;
+    entry->hist[bucket]++;
+}
+
+void
+InputLatencyReceived(CARD32 queuedMillis)
+{
+    latency_record(LATENCY_DDX_QUEUE, (CARD64) queuedMillis * 1000);
+    latency_received.received = latency_received.mark =
+        GetTimeInMicrosPrecise();
+}
+
+void
+InputLatencyEnqueued(InputLatencyRec * latency, Bool merged)
+{
+    CARD64 now = GetTimeInMicrosPrecise();
+
+    if (latency_received.mark) {
+        latency_record(LATENCY_DDX, now - latency_received.mark);
+        latency_received.mark = 0;
+    }
+    /* a motion merged into the queue's last event keeps that one's stamps,
+       which belong to the oldest input it stands for */
+    if (merged)
+        return;
+    latency->received = latency_received.received;
+    latency->mark = now;
+    latency_received.received = 0;
+}
+
+void
+InputLatencyBeginEvent(const InputLatencyRec * latency)
+{
+    CARD64 now = GetTimeInMicrosPrecise();
+
+    if (!latency->mark)
+        return;
+    latency_record(LATENCY_MIEQ, now - latency->mark);
+    latency_processing.received = latency->received;
+    latency_processing.mark = now;
+}
+
+void
+InputLatencyEndEvent(void)
+{
+    latency_processing.mark = 0;
+}
+
+void
+InputLatencyWritten(ClientPtr client)
+{
+    CARD64 now;
+
+    /* only the oldest unflushed event counts */
+    if (!latency_processing.mark || client->input_latency.mark)
+        return;
+    now = GetTimeInMicrosPrecise();
+    latency_record(LATENCY_DELIVERY, now - latency_processing.mark);
+    client->input_latency.received = latency_processing.received;
+    client->input_latency.mark = now;
+}
+
+void
+InputLatencyFlushed(ClientPtr client)
+{
+    InputLatencyRec *latency = &client->input_latency;
+    CARD64 now;
+
+    if (!latency->mark)
+        return;
+    now = GetTimeInMicrosPrecise();
+    latency_record(LATENCY_OUTPUT, now - latency->mark);
+    if (latency->received)
+        latency_record(LATENCY_TOTAL, now - latency->received);
+    latency->received = latency->mark = 0;
+}
+
+/* events traced from receipt to the socket, and their total latency */
+void
+InputLatencyTotal(CARD64 *count, CARD64 *micros)
+{
+    *count = latency_stages[LATENCY_TOTAL].count;
+    *micros = latency_stages[LATENCY_TOTAL].total;
+}
+
+/* upper bound of the bucket holding the given fraction of the events */
+static unsigned long long
+latency_percentile(const InputLatencyStageRec * entry, int percent)
+{
+    CARD64 wanted = (entry->count * percent + 99) / 100;
+    CARD64 seen = 0;
+    int bucket;
+
+    for (bucket = 0; bucket < LATENCY_BUCKETS - 1; bucket++) {
+        seen += entry->hist[bucket];
+        if (seen >= wanted)
+            break;
+    }
+    if (bucket == LATENCY_BUCKETS - 1)
+        return entry->max;
+    return 1ULL << (bucket + 1);
+}
+
+void
+DumpInputLatency(void)
+{
+    int stage;
+
+    LogMessage(X_INFO, "Input latency, in microseconds:\n");
+
+    for (stage = 0; stage < LATENCY_STAGES; stage++) {
+        const InputLatencyStageRec *entry = &latency_stages[stage];
+
+        if (!entry->count)
+            continue;
+        LogMessageVerb(X_NONE, 0, "  %-28s %10llu events, mean %llu, "
+                       "median < %llu, 99%% < %llu, max %llu\n",
+                       latency_stage_names[stage],
+                       (unsigned long long) entry->count,
+                       (unsigned long long) (entry->total / entry->count),
+                       latency_percentile(entry, 50),
+                       latency_percentile(entry, 99),
+                       (unsigned long long) entry->max);
+    }
+}
+
+#endif                          /* XSERVER_INPUT_LATENCY */
@@ -107,6 +107,7 @@ Equipment Corporation.
 #include "registry.h"
 #include "client.h"
 #include "exevents.h"
+#include "frametrace.h"
 #ifdef PANORAMIX
 #include "panoramiXsrv.h"
 #else
@@ -199,6 +200,9 @@ dix_main(int argc, char *argv[], char *envp[])
         /* Perform any operating system dependent initializations you'd like */
         OsInit();
         if (serverGeneration == 1) {
+#ifdef XSERVER_FRAME_TRACE
+            FrameTraceInit();
+#endif
             CreateWellKnownSockets();
             for (i = 1; i < LimitClients; i++)
                 clients[i] = NullClient;
@@ -135,6 +135,81 @@ static const Bool screen_specific_private[PRIVATE_LAST] = {
     /*[PRIVATE_SYNC_FENCE] =*/ FALSE
 };
 
+/*
+ * Windows, GCs and pictures come and go at a high rate, so instead of
+ * returning them to the heap they are kept for reuse on free lists by size
+ * class, in steps of POOL_QUANTUM bytes.  Each block has a header, sized to
+ * keep the malloc alignment, recording its class.
+ */
+#define POOL_QUANTUM    32
+#define POOL_CLASSES    64      /* pooled blocks hold up to 2048 bytes */
+#define POOL_MAX_FREE   256     /* free blocks kept in each class */
+
+typedef union _PoolBlock {
+    union _PoolBlock *next;     /* while on a free list */
+    unsigned sizeClass;         /* while allocated */
+    void *align[2];
+} PoolBlockRec, *PoolBlockPtr;
+
+static struct {
+    PoolBlockPtr free;
+    int numFree;
+} pools[POOL_CLASSES];
+
+static void *
+poolAlloc(unsigned size)
+{
+    unsigned sizeClass = (size + POOL_QUANTUM - 1) / POOL_QUANTUM;
+    PoolBlockPtr block;
+
+    if (sizeClass >= POOL_CLASSES) {
+        block = malloc(sizeof(PoolBlockRec) + size);
+        sizeClass = POOL_CLASSES;
+    }
+    else if ((block = pools[sizeClass].free)) {
+        pools[sizeClass].free = block->next;
+        pools[sizeClass].numFree--;
+    }
+    else
+        block = malloc(sizeof(PoolBlockRec) + sizeClass * POOL_QUANTUM);
+
+    if (!block)
+        return NULL;
+    block->sizeClass = sizeClass;
+    return block + 1;
+}
+
+static void
+poolFree(void *object)
+{
+    PoolBlockPtr block = (PoolBlockPtr) object - 1;
+    unsigned sizeClass = block->sizeClass;
+
+    if (sizeClass >= POOL_CLASSES || pools[sizeClass].numFree >= POOL_MAX_FREE) {
+        free(block);
+        return;
+    }
+    block->next = pools[sizeClass].free;
+    pools[sizeClass].free = block;
+    pools[sizeClass].numFree++;
+}
+
+static void
+poolReset(void)
+{
+    int c;
+
+    for (c = 0; c < POOL_CLASSES; c++) {
+        while (pools[c].free) {
+            PoolBlockPtr block = pools[c].free;
+
+            pools[c].free = block->next;
+            free(block);
+        }
+        pools[c].numFree = 0;
+    }
+}
+
 typedef Bool (*FixupFunc) (PrivatePtr *privates, int offset, unsigned bytes);
 
 typedef enum { FixupMove, FixupRealloc } FixupType;
@@ -554,7 +629,11 @@ _dixFreeObjectWithPrivates(void *object, PrivatePtr privates,
                            DevPrivateType type)
 {
     _dixFiniPrivates(privates, type);
-    free(object);
+    /* these come from _dixAllocateScreenObjectWithPrivates */
+    if (type == PRIVATE_WINDOW || type == PRIVATE_GC || type == PRIVATE_PICTURE)
+        poolFree(object);
+    else
+        free(object);
 }
 
 /*
@@ -718,6 +797,8 @@ _dixAllocateScreenObjectWithPrivates(ScreenPtr pScreen,
 
     assert(type > PRIVATE_SCREEN && type < PRIVATE_LAST);
     assert (screen_specific_private[type]);
+    /* pixmaps are allocated along with their bits, see AllocatePixmap */
+    assert (type != PRIVATE_PIXMAP);
 
     if (pScreen)
         privates_size = pScreen->screenSpecificPrivates[type].offset;
@@ -726,7 +807,7 @@ _dixAllocateScreenObjectWithPrivates(ScreenPtr pScreen,
     /* round up so that pointer is aligned */
     baseSize = (baseSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
     totalSize = baseSize + privates_size;
-    object = malloc(totalSize);
+    object = poolAlloc(totalSize);
     if (!object)
         return NULL;
 
@@ -799,6 +880,7 @@ dixResetPrivates(void)
         global_keys[t].created = 0;
         global_keys[t].allocated = 0;
     }
+    poolReset();
 }
 
 Bool
@@ -285,6 +285,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         pProp->format = format;
         pProp->data = data;
         pProp->size = len;
+        pProp->allocated = totalSize;
         rc = XaceHookPropertyAccess(pClient, pWin, &pProp,
                                     DixCreateAccess | DixWriteAccess);
         if (rc != Success) {
@@ -317,6 +318,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             memcpy(data, value, totalSize);
             pProp->data = data;
             pProp->size = len;
+            pProp->allocated = totalSize;
             pProp->type = type;
             pProp->format = format;
         }
@@ -324,12 +326,30 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             /* do nothing */
         }
         else if (mode == PropModeAppend) {
-            data = xallocarray(pProp->size + len, sizeInBytes);
-            if (!data)
+            size_t used = (size_t) pProp->size * sizeInBytes;
+
+            if (len > UINT32_MAX - pProp->size ||
+                pProp->size + len > SIZE_MAX / sizeInBytes)
                 return BadAlloc;
-            memcpy(data, pProp->data, pProp->size * sizeInBytes);
-            memcpy(data + pProp->size * sizeInBytes, value, totalSize);
-            pProp->data = data;
+
+            /* Grow the value geometrically, so clients appending to
+               a property a bit at a time don't copy it every time.
+               Data appended in place is only counted by the new size,
+               so a change refused below leaves the value as it was. */
+            if (used + totalSize > pProp->allocated) {
+                size_t allocated = used + totalSize;
+
+                if (pProp->allocated < SIZE_MAX / 2 &&
+                    allocated < pProp->allocated * 2)
+                    allocated = pProp->allocated * 2;
+                data = malloc(allocated);
+                if (!data)
+                    return BadAlloc;
+                memcpy(data, pProp->data, used);
+                pProp->data = data;
+                pProp->allocated = allocated;
+            }
+            memcpy((unsigned char *) pProp->data + used, value, totalSize);
             pProp->size += len;
         }
         else if (mode == PropModePrepend) {
@@ -340,6 +360,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             memcpy(data, value, totalSize);
             pProp->data = data;
             pProp->size += len;
+            pProp->allocated = (size_t) pProp->size * sizeInBytes;
         }
 
         /* Allow security modules to check the new content */
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Per request type dispatch profile (XSERVER_REQUEST_PROFILE)
+ *
+ * Dispatch() reads the CPU's time stamp counter around every request
+ * handler, and the cycles spent are filed into a histogram for the
+ * request's major and, for extension requests, minor opcode.  All of this
+ * happens on the dispatch thread, so the counters need no locking.
+ * DumpRequestProfile() writes the entries that were used to the log; the
+ * Windows tray menu offers it, and it also runs at server reset.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#ifdef XSERVER_REQUEST_PROFILE
+
+#include <X11/X.h>
+#include <X11/Xproto.h>
+#include "misc.h"
+#include "os.h"
+#include "dix.h"
+#include "registry.h"
+#include "dispatch.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define PROFILE_TSC() __rdtsc()
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define PROFILE_TSC() __rdtsc()
+#else
+#define PROFILE_TSC() GetTimeInMicros()
+#endif
+
+/* bucket 0 counts 0 and 1 cycles, bucket i counts [2^i, 2^(i+1)), and
+   the last one everything from 2^(PROFILE_BUCKETS-1) up */
+#define PROFILE_BUCKETS 36
+
+typedef struct {
+    CARD64 count;
+    CARD64 cycles;
+    CARD64 max;
+    CARD32 hist[PROFILE_BUCKETS];
+} RequestProfileRec;
+
+/* one entry per core request, one per minor opcode for extensions */
+static RequestProfileRec *request_profile[256];
+
+CARD64
+RequestProfileTicks(void)
+{
+    return PROFILE_TSC();
+}
+
+void
+RequestProfileRecord(int major, int minor, CARD64 start)
+{
+    CARD64 cycles = PROFILE_TSC() - start;
+    RequestProfileRec *entry;
+    int bucket;
+
+    if (!request_profile[major]) {
+        request_profile[major] = calloc(major < EXTENSION_BASE ? 1 : 256,
+                                        sizeof(RequestProfileRec));
+        if (!request_profile[major])
+            return;
+    }
+    entry = &request_profile[major][major < EXTENSION_BASE ? 0 : minor];
+
+    entry->count++;
+    entry->cycles += cycles;
+    if (cycles > entry->max)
+        entry->max = cycles;
+
+    for (bucket = 0; bucket < PROFILE_BUCKETS - 1 && (cycles >> (bucket + 1)); bucket++)
+        ;
+    entry->hist[bucket]++;
+}
+
+/* upper bound of the bucket holding the given fraction of the calls */
+static unsigned long long
+profile_percentile(const RequestProfileRec * entry, int percent)
+{
+    CARD64 wanted = (entry->count * percent + 99) / 100;
+    CARD64 seen = 0;
+    int bucket;
+
+    for (bucket = 0; bucket < PROFILE_BUCKETS - 1; bucket++) {
+        seen += entry->hist[bucket];
+        if (seen >= wanted)
+            break;
+    }
+    if (bucket == PROFILE_BUCKETS - 1)
+        return entry->max;
+    return 1ULL << (bucket + 1);
+}
+
+static void
+profile_log_entry(const char *name, const RequestProfileRec * entry)
+{
+    LogMessageVerb(X_NONE, 0, "  %-40s %10llu calls, mean %llu, "
+                   "median < %llu, 99%% < %llu, max %llu\n", name,
+                   (unsigned long long) entry->count,
+                   (unsigned long long) (entry->cycles / entry->count),
+                   profile_percentile(entry, 50),
+                   profile_percentile(entry, 99),
+                   (unsigned long long) entry->max);
+}
+
+void
+DumpRequestProfile(void)
+{
+    int major, minor;
+
+    LogMessage(X_INFO, "Request profile, in %s per request:\n",
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+               "TSC cycles"
+#else
+               "microseconds"
+#endif
+        );
+
+    for (major = 0; major < 256; major++) {
+        RequestProfileRec *entries = request_profile[major];
+
+        if (!entries)
+            continue;
+
+        if (major < EXTENSION_BASE) {
+            if (entries[0].count)
+                profile_log_entry(LookupMajorName(major), &entries[0]);
+            continue;
+        }
+
+        for (minor = 0; minor < 256; minor++)
+            if (entries[minor].count)
+                profile_log_entry(LookupRequestName(major, minor),
+                                  &entries[minor]);
+    }
+}
+
+#endif                          /* XSERVER_REQUEST_PROFILE */
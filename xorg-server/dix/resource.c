@@ -154,22 +154,49 @@ static void RebuildTable(int    /*client */
 
 #define SERVER_MINID 32
 
-#define INITBUCKETS 64
 #define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+#define MAXHASHSIZE 24
+
+/* resources moved from the old table for each one added while growing */
+#define MIGRATESTEP 8
+
+/*
+ * Each client's resources are kept in an open addressed table using linear
+ * probing with Robin Hood ordering: entries are sorted by their home slot,
+ * so a lookup stops as soon as it reaches an entry closer to its own home
+ * than the one looked for would be.  An ID may have several resources of
+ * different types; they share a home slot and the most recently added comes
+ * first, so they are freed in the opposite order they were added, which
+ * some ddx layers depend on.  Removal shifts the rest of the run back
+ * instead of leaving tombstones.
+ *
+ * When a table gets 3/4 full a table of twice the size is allocated, and new
+ * resources are added to it, while the old table's entries are moved across
+ * MIGRATESTEP at a time by later AddResource calls, so growing the table
+ * never stalls a client.  Lookups check both tables until the old one is
+ * empty.  An ID of 0 marks an empty slot.
+ */
 
 typedef struct _Resource {
-    struct _Resource *next;
     XID id;
     RESTYPE type;
     void *value;
 } ResourceRec, *ResourcePtr;
 
-typedef struct _ClientResource {
-    ResourcePtr *resources;
+typedef struct _ResourceTable {
+    ResourcePtr slots;
+    int hashsize;               /* log(2)(slots) */
     int elements;
-    int buckets;
-    int hashsize;               /* log(2)(buckets) */
+} ResourceTableRec, *ResourceTablePtr;
+
+typedef struct _ClientResource {
+    ResourceTableRec table;     /* where resources are added */
+    ResourceTableRec old;       /* being emptied into table after a rebuild */
+    int migrate;                /* next slot of old to move */
+    unsigned int generation;    /* changed when resources move between tables */
+    int *typeCounts;            /* resources of each type, by type & TypeMask */
+    int numTypeCounts;
+    int neverRetain;            /* resources with RC_NEVERRETAIN */
     XID fakeID;
     XID endFakeID;
 } ClientResourceRec;
@@ -637,7 +664,7 @@ ResourceClientBits(void)
 Bool
 InitClientResources(ClientPtr client)
 {
-    int i, j;
+    int i;
 
     if (client == serverClient) {
         lastResourceType = RT_LASTPREDEF;
@@ -649,13 +676,17 @@ InitClientResources(ClientPtr client)
             return FALSE;
         memcpy(resourceTypes, predefTypes, sizeof(predefTypes));
     }
-    clientTable[i = client->index].resources =
-        malloc(INITBUCKETS * sizeof(ResourcePtr));
-    if (!clientTable[i].resources)
+    clientTable[i = client->index].table.slots =
+        calloc(1 << INITHASHSIZE, sizeof(ResourceRec));
+    if (!clientTable[i].table.slots)
         return FALSE;
-    clientTable[i].buckets = INITBUCKETS;
-    clientTable[i].elements = 0;
-    clientTable[i].hashsize = INITHASHSIZE;
+    clientTable[i].table.hashsize = INITHASHSIZE;
+    clientTable[i].table.elements = 0;
+    clientTable[i].old.slots = NULL;
+    clientTable[i].old.elements = 0;
+    clientTable[i].typeCounts = NULL;
+    clientTable[i].numTypeCounts = 0;
+    clientTable[i].neverRetain = 0;
     /* Many IDs allocated from the server client are visible to clients,
      * so we don't use the SERVER_BIT for them, but we have to start
      * past the magic value constants used in the protocol.  For normal
@@ -664,9 +695,6 @@ InitClientResources(ClientPtr client)
     clientTable[i].fakeID = client->clientAsMask |
         (client->index ? SERVER_BIT : SERVER_MINID);
     clientTable[i].endFakeID = (clientTable[i].fakeID | RESOURCE_ID_MASK) + 1;
-    for (j = 0; j < INITBUCKETS; j++) {
-        clientTable[i].resources[j] = NULL;
-    }
     return TRUE;
 }
 
@@ -683,18 +711,188 @@ HashResourceID(XID id, int numBits)
     return (id ^ (id >> numBits)) & ~((~0) << numBits);
 }
 
+#define TableMask(t) ((1 << (t)->hashsize) - 1)
+
+/* How far the entry in slot pos is from its home slot */
+static _X_INLINE int
+TableDistance(ResourceTablePtr t, int pos)
+{
+    return (pos - HashResourceID(t->slots[pos].id, t->hashsize)) & TableMask(t);
+}
+
+/*
+ * Find the first resource with this id whose type is rtype, or if rtype is
+ * RT_NONE, whose type is in rclass, or any type if rclass is 0 as well.
+ */
+static _X_INLINE ResourcePtr
+TableFind(ResourceTablePtr t, XID id, RESTYPE rtype, RESTYPE rclass)
+{
+    int mask, pos, dist;
+    ResourcePtr res;
+
+    if (!t->slots)
+        return NULL;
+    mask = TableMask(t);
+    pos = HashResourceID(id, t->hashsize);
+    for (dist = 0;; dist++, pos = (pos + 1) & mask) {
+        res = &t->slots[pos];
+        if (res->id == id) {
+            if (rtype ? res->type == rtype : !rclass || (res->type & rclass))
+                return res;
+        }
+        else if (!res->id || TableDistance(t, pos) < dist)
+            return NULL;
+    }
+}
+
+/*
+ * Add a resource to a table with room for it.  It goes in front of the
+ * entries with the same home slot if newest, or after them when it is
+ * moved from an older table.
+ */
+static void
+TableInsert(ResourceTablePtr t, ResourceRec res, Bool newest)
+{
+    int mask = TableMask(t);
+    int pos = HashResourceID(res.id, t->hashsize);
+    int dist, other;
+    ResourceRec tmp;
+
+    for (dist = 0;; dist++, pos = (pos + 1) & mask) {
+        if (!t->slots[pos].id) {
+            t->slots[pos] = res;
+            t->elements++;
+            return;
+        }
+        other = TableDistance(t, pos);
+        if (other < dist || (newest && other == dist)) {
+            /* the displaced entry keeps its place ahead of its neighbours */
+            tmp = t->slots[pos];
+            t->slots[pos] = res;
+            res = tmp;
+            dist = other;
+            newest = TRUE;
+        }
+    }
+}
+
+/* Remove the entry in slot pos, moving the rest of its run back */
+static void
+TableRemove(ResourceTablePtr t, int pos)
+{
+    int mask = TableMask(t);
+    int next;
+
+    for (next = (pos + 1) & mask;
+         t->slots[next].id && TableDistance(t, next) > 0;
+         pos = next, next = (next + 1) & mask)
+        t->slots[pos] = t->slots[next];
+    t->slots[pos].id = 0;
+    t->elements--;
+}
+
+/*
+ * An empty slot to start walking the table from, so no run of entries is
+ * split by the walk and each id's resources are met newest first.
+ */
+static int
+TableWalkStart(ResourceTablePtr t)
+{
+    int pos;
+
+    for (pos = 0; t->slots[pos].id; pos++);
+    return pos;
+}
+
+static ResourcePtr
+FindResource(ClientResourceRec * rrec, XID id, RESTYPE rtype, RESTYPE rclass,
+             ResourceTablePtr *tablep)
+{
+    ResourcePtr res;
+
+    /* resources still in the old table are older than those moved out */
+    if ((res = TableFind(&rrec->table, id, rtype, rclass))) {
+        *tablep = &rrec->table;
+        return res;
+    }
+    if ((res = TableFind(&rrec->old, id, rtype, rclass))) {
+        *tablep = &rrec->old;
+        return res;
+    }
+    return NULL;
+}
+
+/*
+ * Move up to count slots' worth of resources from the old table to the
+ * current one, freeing the old table once it is empty.
+ */
+static void
+MigrateResources(ClientResourceRec * rrec, int count)
+{
+    ResourceTablePtr old = &rrec->old;
+    ResourceRec res;
+
+    if (!old->slots)
+        return;
+    while (old->elements && count-- > 0) {
+        res = old->slots[rrec->migrate];
+        if (res.id) {
+            TableRemove(old, rrec->migrate);
+            TableInsert(&rrec->table, res, FALSE);
+        }
+        else
+            rrec->migrate = (rrec->migrate + 1) & TableMask(old);
+    }
+    if (!old->elements) {
+        free(old->slots);
+        old->slots = NULL;
+    }
+    rrec->generation++;
+}
+
+/*
+ * Count the client's resources of each type, so walks for one type can skip
+ * clients without any and stop once they have seen them all.
+ */
+static Bool
+CountResource(ClientResourceRec * rrec, RESTYPE type, int delta)
+{
+    int index = type & TypeMask;
+
+    if (index >= rrec->numTypeCounts) {
+        int num = lastResourceType + 1;
+        int *counts = reallocarray(rrec->typeCounts, num, sizeof(int));
+
+        if (!counts)
+            return FALSE;
+        memset(counts + rrec->numTypeCounts, 0,
+               (num - rrec->numTypeCounts) * sizeof(int));
+        rrec->typeCounts = counts;
+        rrec->numTypeCounts = num;
+    }
+    rrec->typeCounts[index] += delta;
+    if (type & RC_NEVERRETAIN)
+        rrec->neverRetain += delta;
+    return TRUE;
+}
+
+static _X_INLINE int
+CountResourcesOfType(ClientResourceRec * rrec, RESTYPE type)
+{
+    int index = type & TypeMask;
+
+    return index < rrec->numTypeCounts ? rrec->typeCounts[index] : 0;
+}
+
 static XID
 AvailableID(int client, XID id, XID maxid, XID goodid)
 {
-    ResourcePtr res;
+    ResourceTablePtr table;
 
     if ((goodid >= id) && (goodid <= maxid))
         return goodid;
     for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
+        if (!FindResource(&clientTable[client], id, RT_NONE, 0, &table))
             return id;
     }
     return 0;
@@ -703,29 +901,29 @@ AvailableID(int client, XID id, XID maxid, XID goodid)
 void
 GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
 {
+    ClientResourceRec *rrec = &clientTable[client];
     XID id, maxid;
-    ResourcePtr *resp;
     ResourcePtr res;
     int i;
     XID goodid;
 
+    MigrateResources(rrec, INT_MAX);
+
     id = (Mask) client << CLIENTOFFSET;
     if (server)
         id |= client ? SERVER_BIT : SERVER_MINID;
     maxid = id | RESOURCE_ID_MASK;
     goodid = 0;
-    for (resp = clientTable[client].resources, i = clientTable[client].buckets;
-         --i >= 0;) {
-        for (res = *resp++; res; res = res->next) {
-            if ((res->id < id) || (res->id > maxid))
-                continue;
-            if (((res->id - id) >= (maxid - res->id)) ?
-                (goodid = AvailableID(client, id, res->id - 1, goodid)) :
-                !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
-                maxid = res->id - 1;
-            else
-                id = res->id + 1;
-        }
+    for (i = 0; i <= TableMask(&rrec->table); i++) {
+        res = &rrec->table.slots[i];
+        if (!res->id || (res->id < id) || (res->id > maxid))
+            continue;
+        if (((res->id - id) >= (maxid - res->id)) ?
+            (goodid = AvailableID(client, id, res->id - 1, goodid)) :
+            !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
+            maxid = res->id - 1;
+        else
+            id = res->id + 1;
     }
     if (id > maxid)
         id = maxid = 0;
@@ -803,77 +1001,56 @@ AddResource(XID id, RESTYPE type, void *value)
 {
     int client;
     ClientResourceRec *rrec;
-    ResourcePtr res, *head;
+    ResourceRec res;
 
 #ifdef XSERVER_DTRACE
     XSERVER_RESOURCE_ALLOC(id, type, value, TypeNameString(type));
 #endif
     client = CLIENT_ID(id);
     rrec = &clientTable[client];
-    if (!rrec->buckets) {
+    if (!rrec->table.slots) {
         ErrorF("[dix] AddResource(%lx, %x, %lx), client=%d \n",
                (unsigned long) id, type, (unsigned long)(uintptr_t) value, client);
         FatalError("client not in use\n");
     }
-    if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
+    if (rrec->table.elements >= (3 << rrec->table.hashsize) / 4)
         RebuildTable(client);
-    head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
-    res = malloc(sizeof(ResourceRec));
-    if (!res) {
+    /* keep a free slot to end probes, when the table couldn't grow */
+    if (!id || rrec->table.elements >= TableMask(&rrec->table) ||
+        !CountResource(rrec, type, 1)) {
         (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
         return FALSE;
     }
-    res->next = *head;
-    res->id = id;
-    res->type = type;
-    res->value = value;
-    *head = res;
-    rrec->elements++;
-    CallResourceStateCallback(ResourceStateAdding, res);
+    res.id = id;
+    res.type = type;
+    res.value = value;
+    TableInsert(&rrec->table, res, TRUE);
+    MigrateResources(rrec, MIGRATESTEP);
+    CallResourceStateCallback(ResourceStateAdding, &res);
     return TRUE;
 }
 
 static void
 RebuildTable(int client)
 {
-    int j;
-    ResourcePtr res, next;
-    ResourcePtr **tails, *resources;
-    ResourcePtr **tptr, *rptr;
-
-    /*
-     * For now, preserve insertion order, since some ddx layers depend
-     * on resources being free in the opposite order they are added.
-     */
+    ClientResourceRec *rrec = &clientTable[client];
+    ResourcePtr slots;
 
-    j = 2 * clientTable[client].buckets;
-    tails =  xallocarray(j, sizeof(ResourcePtr *));
-    if (!tails)
+    if (rrec->table.hashsize >= MAXHASHSIZE)
         return;
-    resources =  xallocarray(j, sizeof(ResourcePtr));
-    if (!resources) {
-        free(tails);
+
+    /* finish the previous rebuild, if resources were added that quickly */
+    MigrateResources(rrec, INT_MAX);
+
+    slots = calloc(2 << rrec->table.hashsize, sizeof(ResourceRec));
+    if (!slots)
         return;
-    }
-    for (rptr = resources, tptr = tails; --j >= 0; rptr++, tptr++) {
-        *rptr = NULL;
-        *tptr = rptr;
-    }
-    clientTable[client].hashsize++;
-    for (j = clientTable[client].buckets,
-         rptr = clientTable[client].resources; --j >= 0; rptr++) {
-        for (res = *rptr; res; res = next) {
-            next = res->next;
-            res->next = NULL;
-            tptr = &tails[HashResourceID(res->id, clientTable[client].hashsize)];
-            **tptr = res;
-            *tptr = &res->next;
-        }
-    }
-    free(tails);
-    clientTable[client].buckets *= 2;
-    free(clientTable[client].resources);
-    clientTable[client].resources = resources;
+    rrec->old = rrec->table;
+    rrec->migrate = TableWalkStart(&rrec->old);
+    rrec->table.slots = slots;
+    rrec->table.hashsize++;
+    rrec->table.elements = 0;
+    rrec->generation++;
 }
 
 static void
@@ -883,8 +1060,24 @@ doFreeResource(ResourcePtr res, Bool skip)
 
     if (!skip)
         resourceTypes[res->type & TypeMask].deleteFunc(res->value, res->id);
+}
 
-    free(res);
+/*
+ * Take a resource out of its table, then free it.  The entry is copied
+ * first, as the delete function may change the table.
+ */
+static void
+FreeResourceSlot(ClientResourceRec * rrec, ResourceTablePtr table,
+                 ResourcePtr slot, RESTYPE skipType, Bool skip)
+{
+    ResourceRec res = *slot;
+
+#ifdef XSERVER_DTRACE
+    XSERVER_RESOURCE_FREE(res.id, res.type, res.value, TypeNameString(res.type));
+#endif
+    TableRemove(table, slot - table->slots);
+    CountResource(rrec, res.type, -1);
+    doFreeResource(&res, skip || res.type == skipType);
 }
 
 void
@@ -892,34 +1085,13 @@ FreeResource(XID id, RESTYPE skipDeleteFuncType)
 {
     int cid;
     ResourcePtr res;
-    ResourcePtr *prev, *head;
-    int *eltptr;
-    int elements;
+    ResourceTablePtr table;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-        eltptr = &clientTable[cid].elements;
-
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id) {
-                RESTYPE rtype = res->type;
-
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
-#endif
-                *prev = res->next;
-                elements = --*eltptr;
-
-                doFreeResource(res, rtype == skipDeleteFuncType);
-
-                if (*eltptr != elements)
-                    prev = head;        /* prev may no longer be valid */
-            }
-            else
-                prev = &res->next;
-        }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        /* look again each time, as freeing one may have freed others */
+        while ((res = FindResource(&clientTable[cid], id, RT_NONE, 0, &table)))
+            FreeResourceSlot(&clientTable[cid], table, res,
+                             skipDeleteFuncType, FALSE);
     }
 }
 
@@ -928,28 +1100,13 @@ FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
 {
     int cid;
     ResourcePtr res;
-    ResourcePtr *prev, *head;
-
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+    ResourceTablePtr table;
 
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id && res->type == type) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
-#endif
-                *prev = res->next;
-                clientTable[cid].elements--;
-
-                doFreeResource(res, skipFree);
-
-                break;
-            }
-            else
-                prev = &res->next;
-        }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        res = FindResource(&clientTable[cid], id, type, 0, &table);
+        if (res)
+            FreeResourceSlot(&clientTable[cid], table, res, RT_NONE,
+                             skipFree);
     }
 }
 
@@ -964,19 +1121,26 @@ ChangeResourceValue(XID id, RESTYPE rtype, void *value)
 {
     int cid;
     ResourcePtr res;
+    ResourceTablePtr table;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if ((res->id == id) && (res->type == rtype)) {
-                res->value = value;
-                return TRUE;
-            }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        res = FindResource(&clientTable[cid], id, rtype, 0, &table);
+        if (res) {
+            res->value = value;
+            return TRUE;
+        }
     }
     return FALSE;
 }
 
+/*
+ * The functions below walk all of a client's resources.  They first finish
+ * moving resources out of an old table, so there is just one to walk, and
+ * start over if func adds enough resources to rebuild it.  When func frees
+ * resources the rest of the run slides back, so the current slot is looked
+ * at again.  Walks for one type stop once they have seen all of them.
+ */
+
 /* Note: if func adds or deletes resources, then func can get called
  * more than once for some resources.  If func adds new resources,
  * func might or might not get called for them.  func cannot both
@@ -987,26 +1151,39 @@ void
 FindClientResourcesByType(ClientPtr client,
                           RESTYPE type, FindResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ClientResourceRec *rrec;
+    ResourcePtr this;
+    unsigned int generation;
+    int start, i, elements, left;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                elements = *eltptr;
-                (*func) (this->value, this->id, cdata);
-                if (*eltptr != elements)
-                    next = resources[i];        /* start over */
+    rrec = &clientTable[client->index];
+    if (!rrec->table.slots || (type && !CountResourcesOfType(rrec, type)))
+        return;
+ restart:
+    MigrateResources(rrec, INT_MAX);
+    generation = rrec->generation;
+    left = type ? CountResourcesOfType(rrec, type) : -1;
+    start = TableWalkStart(&rrec->table);
+    for (i = 0; i <= TableMask(&rrec->table) && left;) {
+        this = &rrec->table.slots[(start + i) & TableMask(&rrec->table)];
+        if (this->id && (!type || this->type == type)) {
+            elements = rrec->table.elements;
+            (*func) (this->value, this->id, cdata);
+            if (rrec->generation != generation ||
+                rrec->table.elements > elements)
+                goto restart;
+            if (rrec->table.elements != elements) {
+                /* can't tell any more how many are left */
+                left = -1;
+                continue;
             }
+            if (left > 0)
+                left--;
         }
+        i++;
     }
 }
 
@@ -1022,24 +1199,33 @@ void FindSubResources(void *resource,
 void
 FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ClientResourceRec *rrec;
+    ResourcePtr this;
+    unsigned int generation;
+    int start, i, elements;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            elements = *eltptr;
+    rrec = &clientTable[client->index];
+    if (!rrec->table.slots)
+        return;
+ restart:
+    MigrateResources(rrec, INT_MAX);
+    generation = rrec->generation;
+    start = TableWalkStart(&rrec->table);
+    for (i = 0; i <= TableMask(&rrec->table);) {
+        this = &rrec->table.slots[(start + i) & TableMask(&rrec->table)];
+        if (this->id) {
+            elements = rrec->table.elements;
             (*func) (this->value, this->id, this->type, cdata);
-            if (*eltptr != elements)
-                next = resources[i];    /* start over */
+            if (rrec->generation != generation ||
+                rrec->table.elements > elements)
+                goto restart;
+            if (rrec->table.elements != elements)
+                continue;
         }
+        i++;
     }
 }
 
@@ -1048,24 +1234,28 @@ LookupClientResourceComplex(ClientPtr client,
                             RESTYPE type,
                             FindComplexResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
+    ClientResourceRec *rrec;
+    ResourcePtr this;
     void *value;
-    int i;
+    int i, left;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                /* workaround func freeing the type as DRI1 does */
-                value = this->value;
-                if ((*func) (value, this->id, cdata))
-                    return value;
-            }
+    rrec = &clientTable[client->index];
+    if (!rrec->table.slots || (type && !CountResourcesOfType(rrec, type)))
+        return NULL;
+    MigrateResources(rrec, INT_MAX);
+    left = type ? CountResourcesOfType(rrec, type) : -1;
+    for (i = 0; i <= TableMask(&rrec->table) && left; i++) {
+        this = &rrec->table.slots[i];
+        if (this->id && (!type || this->type == type)) {
+            /* workaround func freeing the type as DRI1 does */
+            value = this->value;
+            if ((*func) (value, this->id, cdata))
+                return value;
+            if (left > 0)
+                left--;
         }
     }
     return NULL;
@@ -1074,48 +1264,42 @@ LookupClientResourceComplex(ClientPtr client,
 void
 FreeClientNeverRetainResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
     ResourcePtr this;
-    ResourcePtr *prev;
-    int j, elements;
-    int *eltptr;
+    unsigned int generation;
+    int start, i, elements;
 
     if (!client)
         return;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        prev = &resources[j];
-        while ((this = *prev)) {
-            RESTYPE rtype = this->type;
-
-            if (rtype & RC_NEVERRETAIN) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(this->id, this->type,
-                                      this->value, TypeNameString(this->type));
-#endif
-                *prev = this->next;
-                clientTable[client->index].elements--;
-                elements = *eltptr;
-
-                doFreeResource(this, FALSE);
-
-                if (*eltptr != elements)
-                    prev = &resources[j];       /* prev may no longer be valid */
-            }
-            else
-                prev = &this->next;
+    rrec = &clientTable[client->index];
+    if (!rrec->table.slots || !rrec->neverRetain)
+        return;
+ restart:
+    MigrateResources(rrec, INT_MAX);
+    generation = rrec->generation;
+    start = TableWalkStart(&rrec->table);
+    for (i = 0; i <= TableMask(&rrec->table) && rrec->neverRetain;) {
+        this = &rrec->table.slots[(start + i) & TableMask(&rrec->table)];
+        if (this->id && (this->type & RC_NEVERRETAIN)) {
+            elements = rrec->table.elements - 1;
+            FreeResourceSlot(rrec, &rrec->table, this, RT_NONE, FALSE);
+            if (rrec->generation != generation ||
+                rrec->table.elements > elements)
+                goto restart;
+            continue;
         }
+        i++;
     }
 }
 
 void
 FreeClientResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
     ResourcePtr this;
-    int j;
+    unsigned int generation;
+    int start, i;
 
     /* This routine shouldn't be called with a null client, but just in
        case ... */
@@ -1125,35 +1309,35 @@ FreeClientResources(ClientPtr client)
 
     HandleSaveSet(client);
 
-    resources = clientTable[client->index].resources;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        /* It may seem silly to update the head of this resource list as
-           we delete the members, since the entire list will be deleted any way,
-           but there are some resource deletion functions "FreeClientPixels" for
-           one which do a LookupID on another resource id (a Colormap id in this
-           case), so the resource list must be kept valid up to the point that
-           it is deleted, so every time we delete a resource, we must update the
-           head, just like in FreeResource. I hope that this doesn't slow down
-           mass deletion appreciably. PRH */
-
-        ResourcePtr *head;
-
-        head = &resources[j];
-
-        for (this = *head; this; this = *head) {
-#ifdef XSERVER_DTRACE
-            XSERVER_RESOURCE_FREE(this->id, this->type,
-                                  this->value, TypeNameString(this->type));
-#endif
-            *head = this->next;
-            clientTable[client->index].elements--;
-
-            doFreeResource(this, FALSE);
+    /* It may seem silly to take each resource out of the table as we
+       delete it, since the entire table will be deleted any way, but there
+       are some resource deletion functions "FreeClientPixels" for one which
+       do a LookupID on another resource id (a Colormap id in this case), so
+       the table must be kept valid up to the point that it is deleted.
+       Deletion functions may even add resources, so go round again until
+       the table is empty. PRH */
+
+    rrec = &clientTable[client->index];
+    while (rrec->table.elements || rrec->old.elements) {
+        MigrateResources(rrec, INT_MAX);
+        generation = rrec->generation;
+        start = TableWalkStart(&rrec->table);
+        for (i = 0; i <= TableMask(&rrec->table) &&
+             rrec->generation == generation;) {
+            this = &rrec->table.slots[(start + i) & TableMask(&rrec->table)];
+            if (this->id)
+                FreeResourceSlot(rrec, &rrec->table, this, RT_NONE, FALSE);
+            else
+                i++;
         }
     }
-    free(clientTable[client->index].resources);
-    clientTable[client->index].resources = NULL;
-    clientTable[client->index].buckets = 0;
+    free(rrec->table.slots);
+    free(rrec->old.slots);
+    free(rrec->typeCounts);
+    rrec->table.slots = NULL;
+    rrec->old.slots = NULL;
+    rrec->typeCounts = NULL;
+    rrec->numTypeCounts = 0;
 }
 
 void
@@ -1162,7 +1346,7 @@ FreeAllResources(void)
     int i;
 
     for (i = currentMaxClients; --i >= 0;) {
-        if (clientTable[i].buckets)
+        if (clientTable[i].table.slots)
             FreeClientResources(clients[i]);
     }
 }
@@ -1198,18 +1382,14 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
 {
     int cid = CLIENT_ID(id);
     ResourcePtr res = NULL;
+    ResourceTablePtr table;
 
     *result = NULL;
     if ((rtype & TypeMask) > lastResourceType)
         return BadImplementation;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && res->type == rtype)
-                break;
-    }
+    if ((cid < LimitClients) && clientTable[cid].table.slots)
+        res = FindResource(&clientTable[cid], id, rtype, 0, &table);
     if (client) {
         client->errorValue = id;
     }
@@ -1235,16 +1415,12 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
 {
     int cid = CLIENT_ID(id);
     ResourcePtr res = NULL;
+    ResourceTablePtr table;
 
     *result = NULL;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && (res->type & rclass))
-                break;
-    }
+    if ((cid < LimitClients) && clientTable[cid].table.slots)
+        res = FindResource(&clientTable[cid], id, RT_NONE, rclass, &table);
     if (client) {
         client->errorValue = id;
     }
@@ -147,6 +147,10 @@ Equipment Corporation.
 
 Bool bgNoneRoot = FALSE;
 
+/* Changed whenever windows are created, destroyed, restacked or change
+   size or position, which tells caches of the window tree to start over */
+unsigned int windowTreeSerial;
+
 static unsigned char _back_lsb[4] = { 0x88, 0x22, 0x44, 0x11 };
 static unsigned char _back_msb[4] = { 0x11, 0x44, 0x22, 0x88 };
 
@@ -913,6 +917,7 @@ CreateWindow(Window wid, WindowPtr pParent, int x, int y, unsigned w,
             pParent->lastChild = pWin;
         pParent->firstChild = pWin;
     }
+    windowTreeSerial++;
 
     SetWinSize(pWin);
     SetBorderSize(pWin);
@@ -1051,6 +1056,7 @@ CrushTree(WindowPtr pWin)
                 (*UnrealizeWindow) (pChild);
             }
             FreeWindowResources(pChild);
+            windowTreeSerial++;
             dixFreeObjectWithPrivates(pChild, PRIVATE_WINDOW);
             if ((pChild = pSib))
                 break;
@@ -1089,6 +1095,7 @@ DeleteWindow(void *value, XID wid)
     }
 
     FreeWindowResources(pWin);
+    windowTreeSerial++;
     if (pParent) {
         if (pParent->firstChild == pWin)
             pParent->firstChild = pWin->nextSib;
@@ -1636,6 +1643,8 @@ MoveWindowInStack(WindowPtr pWin, WindowPtr pNextSib)
     if (pWin->nextSib != pNextSib) {
         WindowPtr pOldNextSib = pWin->nextSib;
 
+        windowTreeSerial++;
+
         if (!pNextSib) {        /* move to bottom */
             if (pParent->firstChild == pWin)
                 pParent->firstChild = pWin->nextSib;
@@ -1848,6 +1857,7 @@ ResizeChildrenWinSize(WindowPtr pWin, int dx, int dy, int dw, int dh)
     Bool resized = (dw || dh);
 
     pScreen = pWin->drawable.pScreen;
+    windowTreeSerial++;
 
     for (pSib = pWin->firstChild; pSib; pSib = pSib->nextSib) {
         if (resized && (pSib->winGravity > NorthWestGravity)) {
@@ -2389,6 +2399,7 @@ ConfigureWindow(WindowPtr pWin, Mask mask, XID *vlist, ClientPtr client)
         DeliverEvents(pWin, &event, 1, NullWindow);
     }
     if (mask & CWBorderWidth) {
+        windowTreeSerial++;
         if (action == RESTACK_WIN) {
             action = MOVE_WIN;
             pWin->borderWidth = bw;
@@ -2534,6 +2545,7 @@ ReparentWindow(WindowPtr pWin, WindowPtr pParent,
 
     /* take out of sibling chain */
 
+    windowTreeSerial++;
     pPriorParent = pPrev = pWin->parent;
     if (pPrev->firstChild == pWin)
         pPrev->firstChild = pWin->nextSib;
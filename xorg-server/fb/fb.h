@@ -421,6 +421,10 @@ typedef struct {
     FbBits bgand, bgxor;        /* for stipples */
     FbBits fg, bg, pm;          /* expanded and filled */
     unsigned int dashLength;    /* total of all dash elements */
+    /* GC values the rop values above were reduced from */
+    unsigned int validFg, validBg, validPm;
+    unsigned char validAlu, validBpp, validDepth;
+    Bool validRop;
 } FbGCPrivRec, *FbGCPrivPtr;
 
 #define fbGetGCPrivateKey(pGC)  (&fbGetScreenPrivate((pGC)->pScreen)->gcPrivateKeyRec)
@@ -461,6 +465,7 @@ typedef struct {
 	(xoff) = __fbPixOffXPix(pixmap); 					\
 	(yoff) = __fbPixOffYPix(pixmap); 					\
     } 										\
+    fbBudgetTouch(pixmap);							\
     fbPrepareAccess(pDrawable); 						\
 }
 
@@ -713,6 +718,46 @@ fbBltPlane(FbBits * src,
            FbStip fgand,
            FbStip fgxor, FbStip bgand, FbStip bgxor, Pixel planeMask);
 
+/*
+ * fbbudget.c
+ */
+
+/* Megabytes of pixmap bits kept uncompressed, < 0 when not budgeted */
+extern _X_EXPORT int fbPixmapBudget;
+
+/* Seconds a pixmap stays untouched before it may be compressed */
+extern _X_EXPORT int fbPixmapIdleTime;
+
+/* Smaller pixmaps are not worth the bookkeeping */
+#define FB_BUDGET_MIN_SIZE	65536
+
+#define fbBudgetWants(size) \
+    (fbPixmapBudget >= 0 && (size) >= FB_BUDGET_MIN_SIZE)
+
+/*
+ * Everything reaching for the bits of a pixmap which may be budgeted
+ * must touch it first, which brings back its bits if they were compressed
+ */
+#define fbBudgetTouch(pPixmap) do {					\
+    if (fbPixmapBudget >= 0)						\
+	fbBudgetAccess(pPixmap);					\
+} while (0)
+
+extern _X_EXPORT Bool
+fbBudgetScreenInit(ScreenPtr pScreen);
+
+extern _X_EXPORT void
+fbBudgetCloseScreen(ScreenPtr pScreen);
+
+extern _X_EXPORT Bool
+fbBudgetAllocBits(PixmapPtr pPixmap, size_t size);
+
+extern _X_EXPORT void
+fbBudgetFreeBits(PixmapPtr pPixmap);
+
+extern _X_EXPORT void
+fbBudgetAccess(PixmapPtr pPixmap);
+
 /*
  * fbcmap_mi.c
  */
@@ -955,6 +1000,12 @@ extern _X_EXPORT Bool
 extern _X_EXPORT void
 fbDestroyGlyphCache(void);
 
+/* File to trace the composite calls to, for pixman's trace-bench */
+extern _X_EXPORT const char *fbPictTraceFile;
+
+extern _X_EXPORT void
+fbPictTraceFlush(void);
+
 /*
  * fbpixmap.c
  */
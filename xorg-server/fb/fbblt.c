@@ -26,6 +26,7 @@
 
 #include <string.h>
 #include "fb.h"
+#include "fbrow.h"
 
 #define InitializeShifts(sx,dx,ls,rs) { \
     if (sx != dx) { \
@@ -93,6 +94,34 @@ fbBlt(FbBits * srcLine,
     }
 
     FbInitializeMergeRop(alu, pm);
+
+#if defined(FB_ROW_SIMD) && !defined(FB_ACCESS_WRAPPER)
+    /* Wide byte aligned spans go to the vector kernels whole */
+    if (!(srcX & 7) && !(dstX & 7) && !(width & 7) &&
+        (width >> 3) >= FB_ROW_MIN_BYTES)
+    {
+        CARD8           *src_byte = (CARD8 *) srcLine + (srcX >> 3);
+        CARD8           *dst_byte = (CARD8 *) dstLine + (dstX >> 3);
+        FbStride        src_byte_stride = srcStride << (FB_SHIFT - 3);
+        FbStride        dst_byte_stride = dstStride << (FB_SHIFT - 3);
+        int             width_byte = (width >> 3);
+        int i;
+
+        if (!upsidedown)
+            for (i = 0; i < height; i++)
+                (*fbBltRow) (dst_byte + i * dst_byte_stride,
+                             src_byte + i * src_byte_stride, width_byte,
+                             _ca1, _cx1, _ca2, _cx2, reverse);
+        else
+            for (i = height - 1; i >= 0; i--)
+                (*fbBltRow) (dst_byte + i * dst_byte_stride,
+                             src_byte + i * src_byte_stride, width_byte,
+                             _ca1, _cx1, _ca2, _cx2, reverse);
+
+        return;
+    }
+#endif
+
     destInvarient = FbDestInvarientMergeRop();
     if (upsidedown) {
         srcLine += (height - 1) * (srcStride);
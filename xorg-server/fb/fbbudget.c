@@ -0,0 +1,363 @@
+/*
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Pixmap memory budget
+ *
+ * When fbPixmapBudget is set, the bits of every pixmap of at least
+ * FB_BUDGET_MIN_SIZE bytes are allocated apart from the pixmap and the
+ * pixmap is kept on a list in the order it was last touched.  A timer
+ * looks at the list while more than the budget is held uncompressed and
+ * compresses the bits of the pixmaps untouched for fbPixmapIdleTime,
+ * oldest first, leaving devPrivate.ptr NULL.  fbBudgetTouch(), which
+ * fbGetDrawablePixmap() and the other ways into the bits call, brings them
+ * back before anybody looks.
+ *
+ * The bits are compressed a pixel word at a time, as runs of one value and
+ * stretches of literal words.  That is all it takes for the solid
+ * backgrounds and blank margins which make up most of the pixmaps
+ * applications leave lying around, and it is fast to undo on the server
+ * thread; bits which do not shrink to half are left alone.
+ *
+ * The RT_PIXMAP size function reports what the bits take while they are
+ * compressed, so XRes shows what each client really holds.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fb.h"
+#include "list.h"
+#include "resource.h"
+
+int fbPixmapBudget = -1;
+int fbPixmapIdleTime = 60;
+
+/* Bytes compressed in one go before the server gets to run again */
+#define FB_BUDGET_BATCH		(32 << 20)
+#define FB_BUDGET_BATCH_DELAY	100
+
+/* Shortest time between two scans */
+#define FB_BUDGET_INTERVAL	1000
+
+/* Words in a run worth a run token of its own */
+#define FB_BUDGET_MIN_RUN	3
+
+typedef struct _fbBudgetPixmap {
+    struct xorg_list entry;     /* in fbBudgetResident or fbBudgetPacked */
+    PixmapPtr pPixmap;
+    void *bits;                 /* NULL while packed */
+    CARD32 *packed;
+    size_t size;                /* 0 for pixmaps not budgeted */
+    size_t packedSize;
+    CARD32 lastUse;
+    Bool incompressible;        /* since last touched */
+} FbBudgetPixmapRec, *FbBudgetPixmapPtr;
+
+static DevPrivateKeyRec fbBudgetPixmapPrivateKeyRec;
+
+#define fbGetBudgetPixmap(pPixmap) ((FbBudgetPixmapPtr) \
+    dixLookupPrivate(&(pPixmap)->devPrivates, &fbBudgetPixmapPrivateKeyRec))
+
+/* Budgeted pixmaps with their bits, least recently touched first */
+static struct xorg_list fbBudgetResident;
+static struct xorg_list fbBudgetPacked;
+static size_t fbBudgetResidentBytes;
+
+static OsTimerPtr fbBudgetTimer;
+
+/* Time of the last scan, which is all the touches need to know */
+static CARD32 fbBudgetClock;
+
+static SizeType fbBudgetPixmapSizeWrapped;
+
+static size_t
+fbBudgetPackBits(const CARD32 *src, size_t n, CARD32 *dst, size_t room)
+{
+    size_t i = 0, lit = 0, out = 0;
+
+    while (i < n) {
+        size_t run = 1;
+
+        while (i + run < n && src[i + run] == src[i])
+            run++;
+        if (run < FB_BUDGET_MIN_RUN && i + run < n) {
+            i += run;
+            continue;
+        }
+        if (run < FB_BUDGET_MIN_RUN) {
+            i += run;
+            run = 0;
+        }
+        if (lit < i) {
+            if (out + 1 + (i - lit) > room)
+                return 0;
+            dst[out++] = (CARD32) (i - lit) << 1;
+            memcpy(dst + out, src + lit, (i - lit) * sizeof(CARD32));
+            out += i - lit;
+        }
+        if (run) {
+            if (out + 2 > room)
+                return 0;
+            dst[out++] = ((CARD32) run << 1) | 1;
+            dst[out++] = src[i];
+            i += run;
+        }
+        lit = i;
+    }
+    return out;
+}
+
+static void
+fbBudgetUnpackBits(const CARD32 *src, size_t n, CARD32 *dst)
+{
+    const CARD32 *end = src + n;
+
+    while (src < end) {
+        size_t count = *src >> 1;
+
+        if (*src++ & 1) {
+            CARD32 v = *src++;
+
+            while (count--)
+                *dst++ = v;
+        }
+        else {
+            memcpy(dst, src, count * sizeof(CARD32));
+            dst += count;
+            src += count;
+        }
+    }
+}
+
+static Bool
+fbBudgetPack(FbBudgetPixmapPtr priv)
+{
+    size_t room = priv->size / sizeof(CARD32) / 2;
+    CARD32 *packed;
+    size_t n;
+
+    packed = malloc(room * sizeof(CARD32));
+    if (!packed)
+        return FALSE;
+    n = fbBudgetPackBits(priv->bits, priv->size / sizeof(CARD32), packed,
+                         room);
+    if (!n) {
+        free(packed);
+        priv->incompressible = TRUE;
+        return FALSE;
+    }
+    priv->packed = realloc(packed, n * sizeof(CARD32));
+    if (!priv->packed)
+        priv->packed = packed;
+    priv->packedSize = n * sizeof(CARD32);
+
+    free(priv->bits);
+    priv->bits = NULL;
+    priv->pPixmap->devPrivate.ptr = NULL;
+    fbBudgetResidentBytes -= priv->size;
+    xorg_list_del(&priv->entry);
+    xorg_list_append(&priv->entry, &fbBudgetPacked);
+    return TRUE;
+}
+
+static CARD32
+fbBudgetScan(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    FbBudgetPixmapPtr priv, tmp;
+    size_t budget = (size_t) fbPixmapBudget << 20;
+    CARD32 idle = (CARD32) fbPixmapIdleTime * 1000;
+    size_t done = 0;
+
+    fbBudgetClock = now;
+
+    xorg_list_for_each_entry_safe(priv, tmp, &fbBudgetResident, entry) {
+        if (fbBudgetResidentBytes <= budget)
+            break;
+        /* The rest have been touched more recently still */
+        if (now - priv->lastUse < idle)
+            break;
+        /* Somebody has pointed the pixmap at other bits for the moment */
+        if (priv->pPixmap->devPrivate.ptr != priv->bits)
+            continue;
+        if (priv->incompressible)
+            continue;
+        if (done >= FB_BUDGET_BATCH)
+            return FB_BUDGET_BATCH_DELAY;
+        done += priv->size;
+        fbBudgetPack(priv);
+    }
+
+    return max(idle / 4, FB_BUDGET_INTERVAL);
+}
+
+static void
+fbBudgetGetPixmapBytes(void *value, XID id, ResourceSizePtr size)
+{
+    PixmapPtr pPixmap = value;
+    FbBudgetPixmapPtr priv;
+
+    fbBudgetPixmapSizeWrapped(value, id, size);
+
+    if (!pPixmap->refcnt)
+        return;
+    priv = fbGetBudgetPixmap(pPixmap);
+    if (priv->size && priv->packed && !pPixmap->devPrivate.ptr) {
+        size->resourceSize = priv->packedSize;
+        size->pixmapRefSize = size->resourceSize / pPixmap->refcnt;
+    }
+}
+
+/*
+ * fbBudgetScreenInit - Budget the pixmaps of the screen
+ *
+ * Called for every screen while its privates are set up, when
+ * fbPixmapBudget is set.
+ */
+
+Bool
+fbBudgetScreenInit(ScreenPtr pScreen)
+{
+    if (!dixRegisterPrivateKey(&fbBudgetPixmapPrivateKeyRec, PRIVATE_PIXMAP,
+                               sizeof(FbBudgetPixmapRec)))
+        return FALSE;
+
+    if (!fbBudgetTimer) {
+        xorg_list_init(&fbBudgetResident);
+        xorg_list_init(&fbBudgetPacked);
+    }
+    fbBudgetClock = GetTimeInMillis();
+    fbBudgetTimer = TimerSet(fbBudgetTimer, 0, FB_BUDGET_INTERVAL,
+                             fbBudgetScan, NULL);
+    if (!fbBudgetTimer)
+        return FALSE;
+
+    /* The resource types start afresh with each server generation */
+    if (GetResourceTypeSizeFunc(RT_PIXMAP) != fbBudgetGetPixmapBytes) {
+        fbBudgetPixmapSizeWrapped = GetResourceTypeSizeFunc(RT_PIXMAP);
+        SetResourceTypeSizeFunc(RT_PIXMAP, fbBudgetGetPixmapBytes);
+    }
+
+    return TRUE;
+}
+
+void
+fbBudgetCloseScreen(ScreenPtr pScreen)
+{
+    if (fbBudgetTimer)
+        TimerCancel(fbBudgetTimer);
+}
+
+/*
+ * fbBudgetAllocBits - Give a new pixmap bits of its own which the budget
+ * looks after
+ */
+
+Bool
+fbBudgetAllocBits(PixmapPtr pPixmap, size_t size)
+{
+    FbBudgetPixmapPtr priv = fbGetBudgetPixmap(pPixmap);
+
+    priv->bits = malloc(size);
+    if (!priv->bits)
+        return FALSE;
+    priv->pPixmap = pPixmap;
+    priv->packed = NULL;
+    priv->size = size;
+    priv->packedSize = 0;
+    priv->lastUse = fbBudgetClock;
+    priv->incompressible = FALSE;
+    xorg_list_append(&priv->entry, &fbBudgetResident);
+    fbBudgetResidentBytes += size;
+
+    pPixmap->devPrivate.ptr = priv->bits;
+    return TRUE;
+}
+
+void
+fbBudgetFreeBits(PixmapPtr pPixmap)
+{
+    FbBudgetPixmapPtr priv;
+
+    if (fbPixmapBudget < 0)
+        return;
+    priv = fbGetBudgetPixmap(pPixmap);
+    if (!priv->size)
+        return;
+
+    xorg_list_del(&priv->entry);
+    if (priv->bits)
+        fbBudgetResidentBytes -= priv->size;
+    free(priv->bits);
+    free(priv->packed);
+    priv->bits = NULL;
+    priv->packed = NULL;
+    priv->size = 0;
+}
+
+static void
+fbBudgetUnpack(FbBudgetPixmapPtr priv)
+{
+    PixmapPtr pPixmap = priv->pPixmap;
+
+    priv->bits = malloc(priv->size);
+    if (!priv->bits)
+        FatalError("fbBudgetAccess: cannot uncompress %dx%d pixmap\n",
+                   pPixmap->drawable.width, pPixmap->drawable.height);
+    fbBudgetUnpackBits(priv->packed, priv->packedSize / sizeof(CARD32),
+                       priv->bits);
+    free(priv->packed);
+    priv->packed = NULL;
+    priv->packedSize = 0;
+    fbBudgetResidentBytes += priv->size;
+    if (!pPixmap->devPrivate.ptr)
+        pPixmap->devPrivate.ptr = priv->bits;
+}
+
+/*
+ * fbBudgetAccess - Note that the bits of the pixmap are being used,
+ * uncompressing them first if needed
+ */
+
+void
+fbBudgetAccess(PixmapPtr pPixmap)
+{
+    FbBudgetPixmapPtr priv = fbGetBudgetPixmap(pPixmap);
+
+    if (!priv->size)
+        return;
+
+    if (!priv->bits)
+        fbBudgetUnpack(priv);
+    else if (priv->lastUse == fbBudgetClock)
+        return;
+
+    priv->lastUse = fbBudgetClock;
+    priv->incompressible = FALSE;
+    xorg_list_del(&priv->entry);
+    xorg_list_append(&priv->entry, &fbBudgetResident);
+}
@@ -71,6 +71,8 @@ fbCreateGC(GCPtr pGC)
     pGC->miTranslate = 1;
     pGC->fExpose = 1;
 
+    fbGetGCPrivate(pGC)->validRop = FALSE;
+
     return TRUE;
 }
 
@@ -142,9 +144,17 @@ fbValidateGC(GCPtr pGC, unsigned long changes, DrawablePtr pDrawable)
         }
     }
     /*
-     * Recompute reduced rop values
+     * Recompute reduced rop values, unless they were reduced from these
+     * very values last time, as when a client sets the same foreground
      */
-    if (changes & (GCForeground | GCBackground | GCPlaneMask | GCFunction)) {
+    if ((changes & (GCForeground | GCBackground | GCPlaneMask | GCFunction)) &&
+        !(pPriv->validRop &&
+          pPriv->validFg == pGC->fgPixel &&
+          pPriv->validBg == pGC->bgPixel &&
+          pPriv->validPm == pGC->planemask &&
+          pPriv->validAlu == pGC->alu &&
+          pPriv->validBpp == pDrawable->bitsPerPixel &&
+          pPriv->validDepth == pDrawable->depth)) {
         int s;
         FbBits depthMask;
 
@@ -170,6 +180,14 @@ fbValidateGC(GCPtr pGC, unsigned long changes, DrawablePtr pDrawable)
         pPriv->xor = fbXor(pGC->alu, pPriv->fg, pPriv->pm);
         pPriv->bgand = fbAnd(pGC->alu, pPriv->bg, pPriv->pm);
         pPriv->bgxor = fbXor(pGC->alu, pPriv->bg, pPriv->pm);
+
+        pPriv->validFg = pGC->fgPixel;
+        pPriv->validBg = pGC->bgPixel;
+        pPriv->validPm = pGC->planemask;
+        pPriv->validAlu = pGC->alu;
+        pPriv->validBpp = pDrawable->bitsPerPixel;
+        pPriv->validDepth = pDrawable->depth;
+        pPriv->validRop = TRUE;
     }
     if (changes & GCDashList) {
         unsigned short n = pGC->numInDashList;
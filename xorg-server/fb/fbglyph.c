@@ -53,6 +53,42 @@ fbGlyphIn(RegionPtr pRegion, int x, int y, int width, int height)
     return RegionContainsRect(pRegion, &box) == rgnIN;
 }
 
+/*
+ * Whether every glyph of a run lies within the clip.  Checking the run as
+ * a whole saves a region lookup per glyph for the usual unobscured line
+ * of text; when it fails, the glyphs are still checked one by one.
+ */
+static Bool
+fbGlyphRunIn(RegionPtr pRegion,
+             int x, int y, unsigned int nglyph, CharInfoPtr * ppci)
+{
+    int x1 = MAXINT, y1 = MAXINT, x2 = MININT, y2 = MININT;
+
+    while (nglyph--) {
+        CharInfoPtr pci = *ppci++;
+        int gWidth = GLYPHWIDTHPIXELS(pci);
+        int gHeight = GLYPHHEIGHTPIXELS(pci);
+
+        if (gWidth && gHeight) {
+            int gx = x + pci->metrics.leftSideBearing;
+            int gy = y - pci->metrics.ascent;
+
+            if (gx < x1)
+                x1 = gx;
+            if (gx + gWidth > x2)
+                x2 = gx + gWidth;
+            if (gy < y1)
+                y1 = gy;
+            if (gy + gHeight > y2)
+                y2 = gy + gHeight;
+        }
+        x += pci->metrics.characterWidth;
+    }
+    if (x1 >= x2)
+        return FALSE;
+    return fbGlyphIn(pRegion, x1, y1, x2 - x1, y2 - y1);
+}
+
 void
 fbPolyGlyphBlt(DrawablePtr pDrawable,
                GCPtr pGC,
@@ -71,6 +107,7 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
     FbStride dstStride = 0;
     int dstBpp = 0;
     int dstXoff = 0, dstYoff = 0;
+    Bool runIn;
 
     glyph = 0;
     if (pGC->fillStyle == FillSolid && pPriv->and == 0) {
@@ -90,6 +127,9 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
     x += pDrawable->x;
     y += pDrawable->y;
 
+    runIn = glyph && nglyph > 1 &&
+        fbGlyphRunIn(fbGetCompositeClip(pGC), x, y, nglyph, ppci);
+
     while (nglyph--) {
         pci = *ppci++;
         pglyph = FONTGLYPHBITS(pglyphBase, pci);
@@ -99,7 +139,8 @@ fbPolyGlyphBlt(DrawablePtr pDrawable,
             gx = x + pci->metrics.leftSideBearing;
             gy = y - pci->metrics.ascent;
             if (glyph && gWidth <= sizeof(FbStip) * 8 &&
-                fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight)) {
+                (runIn ||
+                 fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight))) {
                 fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff,
                               dstYoff);
                 (*glyph) (dst + (gy + dstYoff) * dstStride, dstStride, dstBpp,
@@ -139,6 +180,7 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
     FbStride dstStride = 0;
     int dstBpp = 0;
     int dstXoff = 0, dstYoff = 0;
+    Bool runIn;
 
     glyph = 0;
     if (pPriv->and == 0) {
@@ -191,6 +233,9 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
         opaque = FALSE;
     }
 
+    runIn = glyph && nglyph > 1 &&
+        fbGlyphRunIn(fbGetCompositeClip(pGC), x, y, nglyph, ppciInit);
+
     ppci = ppciInit;
     while (nglyph--) {
         pci = *ppci++;
@@ -201,7 +246,8 @@ fbImageGlyphBlt(DrawablePtr pDrawable,
             gx = x + pci->metrics.leftSideBearing;
             gy = y - pci->metrics.ascent;
             if (glyph && gWidth <= sizeof(FbStip) * 8 &&
-                fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight)) {
+                (runIn ||
+                 fbGlyphIn(fbGetCompositeClip(pGC), gx, gy, gWidth, gHeight))) {
                 fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff,
                               dstYoff);
                 (*glyph) (dst + (gy + dstYoff) * dstStride, dstStride, dstBpp,
@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include "fb.h"
+#include "fbrow.h"
 
 void
 fbPutImage(DrawablePtr pDrawable,
@@ -246,6 +247,24 @@ fbGetImage(DrawablePtr pDrawable,
     }
     else {
         dstStride = BitmapBytePad(w) / sizeof(FbStip);
+#if defined(FB_ROW_SIMD) && !defined(FB_ACCESS_WRAPPER) && \
+    BITMAP_BIT_ORDER == LSBFirst
+        /* XYPixmap asks for one plane at a time, which the vector kernels
+         * pull out of whole vectors of byte sized pixels */
+        if (srcBpp == 8 || srcBpp == 16 || srcBpp == 32) {
+            CARD8 *s = (CARD8 *) (src + (y + srcYoff) * srcStride) +
+                ((x + srcXoff) * (srcBpp >> 3));
+            FbStride sByteStride = srcStride * sizeof(FbBits);
+            int i;
+
+            for (i = 0; i < h; i++)
+                (*fbPlaneRow) ((CARD8 *) (dst + i * dstStride),
+                               s + i * sByteStride, w, srcBpp, planeMask);
+
+            fbFinishAccess(pDrawable);
+            return;
+        }
+#endif
         fbBltPlane(src + (y + srcYoff) * srcStride,
                    srcStride,
                    (x + srcXoff) * srcBpp,
@@ -27,6 +27,7 @@
 #include <dix-config.h>
 #endif
 
+#include <stdio.h>
 #include <string.h>
 
 #include "fb.h"
@@ -35,6 +36,71 @@
 #include "mipict.h"
 #include "fbpict.h"
 
+/*
+ * Composite trace
+ *
+ * With fbPictTraceFile set, every composite and glyph run is written to
+ * it as a line of text, with the operator, the formats, sizes, repeat,
+ * filter and transform of the pictures and the coordinates handed to
+ * pixman.  pixman/test/trace-bench plays such a trace back, to measure
+ * pixman against what the server really asks of it.
+ */
+
+const char *fbPictTraceFile;
+static FILE *fbPictTrace;
+
+static Bool
+fbPictTraceOpen(void)
+{
+    if (!fbPictTrace) {
+        fbPictTrace = fopen(fbPictTraceFile, "w");
+        if (!fbPictTrace) {
+            ErrorF("fbPictTraceOpen: cannot write %s\n", fbPictTraceFile);
+            fbPictTraceFile = NULL;
+            return FALSE;
+        }
+        fputs("# fbpict trace 1\n", fbPictTrace);
+    }
+    return TRUE;
+}
+
+static void
+fbPictTracePicture(PicturePtr pict, pixman_image_t *image)
+{
+    if (!pict) {
+        fputs(" -", fbPictTrace);
+        return;
+    }
+
+    if (!pict->pDrawable) {
+        static const char types[] = "slrc";
+        int type = pict->pSourcePict->type;
+
+        fprintf(fbPictTrace, " %c", type < 4 ? types[type] : 's');
+        return;
+    }
+
+    fprintf(fbPictTrace, " b:%08x:%d:%d:%d:%d:%d",
+            (unsigned int) pixman_image_get_format(image),
+            pixman_image_get_width(image), pixman_image_get_height(image),
+            pict->repeatType, pict->filter, pict->componentAlpha);
+    if (pict->transform) {
+        int i, j;
+
+        for (i = 0; i < 3; i++)
+            for (j = 0; j < 3; j++)
+                fprintf(fbPictTrace, "%c%d", i || j ? ',' : ':',
+                        (int) pict->transform->matrix[i][j]);
+    }
+}
+
+void
+fbPictTraceFlush(void)
+{
+    if (fbPictTrace)
+        fflush(fbPictTrace);
+}
+
 void
 fbComposite(CARD8 op,
             PicturePtr pSrc,
@@ -63,6 +129,17 @@ fbComposite(CARD8 op,
                                xSrc + src_xoff, ySrc + src_yoff,
                                xMask + msk_xoff, yMask + msk_yoff,
                                xDst + dst_xoff, yDst + dst_yoff, width, height);
+
+        if (fbPictTraceFile && fbPictTraceOpen()) {
+            fprintf(fbPictTrace, "C %d", op);
+            fbPictTracePicture(pSrc, src);
+            fbPictTracePicture(pMask, mask);
+            fbPictTracePicture(pDst, dest);
+            fprintf(fbPictTrace, " %d %d %d %d %d %d %d %d\n",
+                    xSrc + src_xoff, ySrc + src_yoff,
+                    xMask + msk_xoff, yMask + msk_yoff,
+                    xDst + dst_xoff, yDst + dst_yoff, width, height);
+        }
     }
 
     free_pixman_pict(pSrc, src);
@@ -72,6 +149,10 @@ fbComposite(CARD8 op,
 
 static pixman_glyph_cache_t *glyphCache;
 
+/* Glyph list for runs too long for the stack, kept between requests */
+static pixman_glyph_t *glyphList;
+static int glyphListSize;
+
 void
 fbDestroyGlyphCache(void)
 {
@@ -80,6 +161,9 @@ fbDestroyGlyphCache(void)
 	pixman_glyph_cache_destroy (glyphCache);
 	glyphCache = NULL;
     }
+    free(glyphList);
+    glyphList = NULL;
+    glyphListSize = 0;
 }
 
 static void
@@ -90,6 +174,22 @@ fbUnrealizeGlyph(ScreenPtr pScreen,
 	pixman_glyph_cache_remove (glyphCache, pGlyph, NULL);
 }
 
+static void
+fbGlyphUnionBox(pixman_box32_t *extents, GlyphPtr glyph, int x, int y)
+{
+    int x1 = x - glyph->info.x;
+    int y1 = y - glyph->info.y;
+
+    if (x1 < extents->x1)
+	extents->x1 = x1;
+    if (y1 < extents->y1)
+	extents->y1 = y1;
+    if (x1 + glyph->info.width > extents->x2)
+	extents->x2 = x1 + glyph->info.width;
+    if (y1 + glyph->info.height > extents->y2)
+	extents->y2 = y1 + glyph->info.height;
+}
+
 void
 fbGlyphs(CARD8 op,
 	 PicturePtr pSrc,
@@ -106,8 +206,11 @@ fbGlyphs(CARD8 op,
     pixman_glyph_t *pglyphs = stack_glyphs;
     pixman_image_t *srcImage, *dstImage;
     int srcXoff, srcYoff, dstXoff, dstYoff;
+    pixman_box32_t extents;
+    BoxPtr clip;
     GlyphPtr glyph;
     int n_glyphs;
+    int glyphs_w = 0, glyphs_h = 0;
     int x, y;
     int i, n;
     int xDst = list->xOff, yDst = list->yOff;
@@ -124,10 +227,21 @@ fbGlyphs(CARD8 op,
     pixman_glyph_cache_freeze (glyphCache);
 
     if (n_glyphs > N_STACK_GLYPHS) {
-	if (!(pglyphs = xallocarray(n_glyphs, sizeof(pixman_glyph_t))))
-	    goto out;
+	if (n_glyphs > glyphListSize) {
+	    pixman_glyph_t *grown = reallocarray(glyphList, n_glyphs,
+						 sizeof(pixman_glyph_t));
+
+	    if (!grown)
+		goto out;
+	    glyphList = grown;
+	    glyphListSize = n_glyphs;
+	}
+	pglyphs = glyphList;
     }
 
+    extents.x1 = extents.y1 = INT32_MAX;
+    extents.x2 = extents.y2 = INT32_MIN;
+
     i = 0;
     x = y = 0;
     while (nlist--) {
@@ -168,6 +282,9 @@ fbGlyphs(CARD8 op,
 	    pglyphs[i].y = y;
 	    pglyphs[i].glyph = g;
 	    i++;
+	    fbGlyphUnionBox(&extents, glyph, x, y);
+	    glyphs_w += glyph->info.width;
+	    glyphs_h += glyph->info.height;
 
 	next:
             x += glyph->info.xOff;
@@ -176,6 +293,22 @@ fbGlyphs(CARD8 op,
 	list++;
     }
 
+    /*
+     * Nothing outside the destination clip can show, so trim the mask to
+     * it, and skip text which is hidden altogether.
+     */
+    clip = RegionExtents(pDst->pCompositeClip);
+    if (extents.x1 < clip->x1 - pDst->pDrawable->x)
+	extents.x1 = clip->x1 - pDst->pDrawable->x;
+    if (extents.y1 < clip->y1 - pDst->pDrawable->y)
+	extents.y1 = clip->y1 - pDst->pDrawable->y;
+    if (extents.x2 > clip->x2 - pDst->pDrawable->x)
+	extents.x2 = clip->x2 - pDst->pDrawable->x;
+    if (extents.y2 > clip->y2 - pDst->pDrawable->y)
+	extents.y2 = clip->y2 - pDst->pDrawable->y;
+    if (extents.x1 >= extents.x2 || extents.y1 >= extents.y2)
+	goto out;
+
     if (!(srcImage = image_from_pict(pSrc, FALSE, &srcXoff, &srcYoff)))
 	goto out;
 
@@ -184,12 +317,9 @@ fbGlyphs(CARD8 op,
 
     if (maskFormat) {
 	pixman_format_code_t format;
-	pixman_box32_t extents;
 
 	format = maskFormat->format | (maskFormat->depth << 24);
 
-	pixman_glyph_get_extents(glyphCache, n_glyphs, pglyphs, &extents);
-
 	pixman_composite_glyphs(op, srcImage, dstImage, format,
 				xSrc + srcXoff + extents.x1 - xDst, ySrc + srcYoff + extents.y1 - yDst,
 				extents.x1, extents.y1,
@@ -205,6 +335,20 @@ fbGlyphs(CARD8 op,
 					glyphCache, n_glyphs, pglyphs);
     }
 
+    if (fbPictTraceFile && fbPictTraceOpen()) {
+	fprintf(fbPictTrace, "G %d", op);
+	fbPictTracePicture(pSrc, srcImage);
+	fbPictTracePicture(pDst, dstImage);
+	if (maskFormat)
+	    fprintf(fbPictTrace, " %08x",
+		    maskFormat->format | (maskFormat->depth << 24));
+	else
+	    fputs(" -", fbPictTrace);
+	fprintf(fbPictTrace, " %d %d %d %d %d\n", n_glyphs,
+		glyphs_w / n_glyphs, glyphs_h / n_glyphs,
+		extents.x2 - extents.x1, extents.y2 - extents.y1);
+    }
+
     free_pixman_pict(pDst, dstImage);
 
 out_free_src:
@@ -212,8 +356,6 @@ out_free_src:
 
 out:
     pixman_glyph_cache_thaw(glyphCache);
-    if (pglyphs != stack_glyphs)
-	free(pglyphs);
 }
 
 static pixman_image_t *
@@ -38,6 +38,7 @@ fbCreatePixmap(ScreenPtr pScreen, int width, int height, int depth,
     int adjust;
     int base;
     int bpp = BitsPerPixel(depth);
+    Bool budget = FALSE;
 
     paddedWidth = ((width * bpp + FB_MASK) >> FB_SHIFT) * sizeof(FbBits);
     if (paddedWidth / 4 > 32767 || height > 32767)
@@ -50,8 +51,10 @@ fbCreatePixmap(ScreenPtr pScreen, int width, int height, int depth,
     datasize += adjust;
 #ifdef FB_DEBUG
     datasize += 2 * paddedWidth;
+#else
+    budget = fbBudgetWants(datasize);
 #endif
-    pPixmap = AllocatePixmap(pScreen, datasize);
+    pPixmap = AllocatePixmap(pScreen, budget ? 0 : datasize);
     if (!pPixmap)
         return NullPixmap;
     pPixmap->drawable.type = DRAWABLE_PIXMAP;
@@ -67,7 +70,14 @@ fbCreatePixmap(ScreenPtr pScreen, int width, int height, int depth,
     pPixmap->drawable.height = height;
     pPixmap->devKind = paddedWidth;
     pPixmap->refcnt = 1;
-    pPixmap->devPrivate.ptr = (void *) ((char *) pPixmap + base + adjust);
+    if (budget) {
+        if (!fbBudgetAllocBits(pPixmap, height * paddedWidth)) {
+            FreePixmap(pPixmap);
+            return NullPixmap;
+        }
+    }
+    else
+        pPixmap->devPrivate.ptr = (void *) ((char *) pPixmap + base + adjust);
     pPixmap->master_pixmap = NULL;
 
 #ifdef FB_DEBUG
@@ -91,6 +101,7 @@ fbDestroyPixmap(PixmapPtr pPixmap)
 {
     if (--pPixmap->refcnt)
         return TRUE;
+    fbBudgetFreeBits(pPixmap);
     FreePixmap(pPixmap);
     return TRUE;
 }
@@ -149,6 +160,7 @@ fbPixmapToRegion(PixmapPtr pPix)
     FirstRect = RegionBoxptr(pReg);
     rects = FirstRect;
 
+    fbBudgetTouch(pPix);
     fbPrepareAccess(&pPix->drawable);
 
     pwLine = (FbBits *) pPix->devPrivate.ptr;
@@ -0,0 +1,527 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Runtime selected SSE2 and AVX2 row kernels for fbBlt and fbSolid,
+ * detected the same way as the shadow update row kernels.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "fb.h"
+#include "fbrow.h"
+
+#ifdef FB_ROW_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FB_TARGET_SSE2
+#define FB_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define FB_TARGET_SSE2 __attribute__((target("sse2")))
+#define FB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/*
+ * Plain C reference kernels, one byte at a time.  Byte i of the span
+ * takes its masks from byte (dst + i) & 3 of the words.
+ */
+
+#define FbRowMergeByte(i) {					\
+    int _k = (phase + (i)) & 3;					\
+    CARD8 _s = src[i];						\
+    dst[i] = (dst[i] & ((_s & a1[_k]) ^ x1[_k])) ^		\
+	((_s & a2[_k]) ^ x2[_k]);				\
+}
+
+static void
+fbBltRowGeneric(CARD8 *dst, const CARD8 *src, int n,
+                CARD32 ca1, CARD32 cx1, CARD32 ca2, CARD32 cx2, int reverse)
+{
+    int phase = (int) ((uintptr_t) dst & 3);
+    CARD8 a1[4], x1[4], a2[4], x2[4];
+    int i;
+
+    memcpy(a1, &ca1, 4);
+    memcpy(x1, &cx1, 4);
+    memcpy(a2, &ca2, 4);
+    memcpy(x2, &cx2, 4);
+    if (reverse) {
+        for (i = n - 1; i >= 0; i--)
+            FbRowMergeByte(i);
+    }
+    else {
+        for (i = 0; i < n; i++)
+            FbRowMergeByte(i);
+    }
+}
+
+static void
+fbSolidRowGeneric(CARD8 *dst, int n, CARD32 and, CARD32 xor)
+{
+    int phase = (int) ((uintptr_t) dst & 3);
+    CARD8 a[4], x[4];
+    int i;
+
+    memcpy(a, &and, 4);
+    memcpy(x, &xor, 4);
+    for (i = 0; i < n; i++) {
+        int k = (phase + i) & 3;
+
+        dst[i] = (dst[i] & a[k]) ^ x[k];
+    }
+}
+
+static void
+fbPlaneRowGeneric(CARD8 *dst, const CARD8 *src, int n, int bpp, CARD32 plane)
+{
+    int i, k;
+
+    for (i = 0; i < n; i += 8) {
+        int m = n - i < 8 ? n - i : 8;
+        CARD8 bits = 0;
+
+        for (k = 0; k < m; k++) {
+            CARD32 p;
+
+            if (bpp == 8)
+                p = src[i + k];
+            else if (bpp == 16)
+                p = ((const CARD16 *) src)[i + k];
+            else
+                p = ((const CARD32 *) src)[i + k];
+            if (p & plane)
+                bits |= 1 << k;
+        }
+        dst[i >> 3] = bits;
+    }
+}
+
+#ifdef FB_ROW_SIMD
+
+/*
+ * Turn a mask word around so that it lines up with a vector starting
+ * phase bytes past a word boundary.  The vector kernels only ever load
+ * and store at multiples of their width from dst, so one rotation holds
+ * for the whole span, and whatever is left over at the end goes to the
+ * reference kernels.
+ */
+static int
+fbRowRotate(CARD32 mask, int phase)
+{
+    CARD8 in[4], out[4];
+    CARD32 r;
+    int i;
+
+    memcpy(in, &mask, 4);
+    for (i = 0; i < 4; i++)
+        out[i] = in[(phase + i) & 3];
+    memcpy(&r, out, 4);
+    return (int) r;
+}
+
+/*
+ * A reverse span does its tail first and then the blocks from the last
+ * one down, so that an overlapping source is always read before it is
+ * overwritten.
+ */
+
+#define FbRowBltSSE2(off) {						\
+    __m128i _s = _mm_loadu_si128((const __m128i *) (src + (off)));	\
+    __m128i _d = _mm_xor_si128(_mm_and_si128(_s, a2), x2);		\
+    if (!invariant)							\
+	_d = _mm_xor_si128(_mm_and_si128(_mm_loadu_si128((const __m128i *) (dst + (off))), \
+					 _mm_xor_si128(_mm_and_si128(_s, a1), x1)), \
+			   _d);						\
+    _mm_storeu_si128((__m128i *) (dst + (off)), _d);			\
+}
+
+static void FB_TARGET_SSE2
+fbBltRowSSE2(CARD8 *dst, const CARD8 *src, int n,
+             CARD32 ca1, CARD32 cx1, CARD32 ca2, CARD32 cx2, int reverse)
+{
+    int phase = (int) ((uintptr_t) dst & 3);
+    int blocks = n >> 4, tail = n & 15;
+    int invariant = ca1 == 0 && cx1 == 0;
+    __m128i a1 = _mm_set1_epi32(fbRowRotate(ca1, phase));
+    __m128i x1 = _mm_set1_epi32(fbRowRotate(cx1, phase));
+    __m128i a2 = _mm_set1_epi32(fbRowRotate(ca2, phase));
+    __m128i x2 = _mm_set1_epi32(fbRowRotate(cx2, phase));
+    int i;
+
+    if (reverse) {
+        fbBltRowGeneric(dst + n - tail, src + n - tail, tail,
+                        ca1, cx1, ca2, cx2, reverse);
+        for (i = blocks - 1; i >= 0; i--)
+            FbRowBltSSE2(i << 4);
+    }
+    else {
+        for (i = 0; i < blocks; i++)
+            FbRowBltSSE2(i << 4);
+        fbBltRowGeneric(dst + n - tail, src + n - tail, tail,
+                        ca1, cx1, ca2, cx2, reverse);
+    }
+}
+
+static void FB_TARGET_SSE2
+fbSolidRowSSE2(CARD8 *dst, int n, CARD32 and, CARD32 xor)
+{
+    int phase = (int) ((uintptr_t) dst & 3);
+    int blocks = n >> 4, tail = n & 15;
+    __m128i a = _mm_set1_epi32(fbRowRotate(and, phase));
+    __m128i x = _mm_set1_epi32(fbRowRotate(xor, phase));
+    int i;
+
+    if (!and) {
+        for (i = 0; i < blocks; i++)
+            _mm_storeu_si128((__m128i *) (dst + (i << 4)), x);
+    }
+    else {
+        for (i = 0; i < blocks; i++) {
+            __m128i *d = (__m128i *) (dst + (i << 4));
+
+            _mm_storeu_si128(d, _mm_xor_si128(_mm_and_si128(_mm_loadu_si128(d),
+                                                            a), x));
+        }
+    }
+    fbSolidRowGeneric(dst + n - tail, tail, and, xor);
+}
+
+/*
+ * The plane kernels compare each pixel with zero after masking and pack
+ * the comparisons down to bytes, whose sign bits then come out together.
+ * The bits are those of the pixels without the plane, hence the ~.
+ */
+
+static void FB_TARGET_SSE2
+fbPlaneRowSSE2(CARD8 *dst, const CARD8 *src, int n, int bpp, CARD32 plane)
+{
+    const __m128i *s = (const __m128i *) src;
+    __m128i zero = _mm_setzero_si128();
+    int blocks = n >> 4;
+    int i;
+
+    for (i = 0; i < blocks; i++, s += bpp >> 3) {
+        __m128i c;
+        int bits;
+
+        if (bpp == 8) {
+            c = _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128(s),
+                                             _mm_set1_epi8((char) plane)),
+                               zero);
+        }
+        else if (bpp == 16) {
+            __m128i pm = _mm_set1_epi16((short) plane);
+
+            c = _mm_packs_epi16(
+                _mm_cmpeq_epi16(_mm_and_si128(_mm_loadu_si128(s), pm), zero),
+                _mm_cmpeq_epi16(_mm_and_si128(_mm_loadu_si128(s + 1), pm),
+                                zero));
+        }
+        else {
+            __m128i pm = _mm_set1_epi32((int) plane);
+
+            c = _mm_packs_epi16(
+                _mm_packs_epi32(
+                    _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(s), pm),
+                                    zero),
+                    _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(s + 1), pm),
+                                    zero)),
+                _mm_packs_epi32(
+                    _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(s + 2), pm),
+                                    zero),
+                    _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(s + 3), pm),
+                                    zero)));
+        }
+        bits = ~_mm_movemask_epi8(c);
+        dst[(i << 1)] = bits;
+        dst[(i << 1) + 1] = bits >> 8;
+    }
+    fbPlaneRowGeneric(dst + (blocks << 1), src + (blocks << 4) * (bpp >> 3),
+                      n & 15, bpp, plane);
+}
+
+#define FbRowBltAVX2(off) {						\
+    __m256i _s = _mm256_loadu_si256((const __m256i *) (src + (off)));	\
+    __m256i _d = _mm256_xor_si256(_mm256_and_si256(_s, a2), x2);	\
+    if (!invariant)							\
+	_d = _mm256_xor_si256(_mm256_and_si256(_mm256_loadu_si256((const __m256i *) (dst + (off))), \
+					       _mm256_xor_si256(_mm256_and_si256(_s, a1), x1)), \
+			      _d);					\
+    _mm256_storeu_si256((__m256i *) (dst + (off)), _d);		\
+}
+
+static void FB_TARGET_AVX2
+fbBltRowAVX2(CARD8 *dst, const CARD8 *src, int n,
+             CARD32 ca1, CARD32 cx1, CARD32 ca2, CARD32 cx2, int reverse)
+{
+    int phase = (int) ((uintptr_t) dst & 3);
+    int blocks = n >> 5, tail = n & 31;
+    int invariant = ca1 == 0 && cx1 == 0;
+    __m256i a1 = _mm256_set1_epi32(fbRowRotate(ca1, phase));
+    __m256i x1 = _mm256_set1_epi32(fbRowRotate(cx1, phase));
+    __m256i a2 = _mm256_set1_epi32(fbRowRotate(ca2, phase));
+    __m256i x2 = _mm256_set1_epi32(fbRowRotate(cx2, phase));
+    int i;
+
+    if (reverse) {
+        fbBltRowGeneric(dst + n - tail, src + n - tail, tail,
+                        ca1, cx1, ca2, cx2, reverse);
+        for (i = blocks - 1; i >= 0; i--)
+            FbRowBltAVX2(i << 5);
+    }
+    else {
+        for (i = 0; i < blocks; i++)
+            FbRowBltAVX2(i << 5);
+        fbBltRowGeneric(dst + n - tail, src + n - tail, tail,
+                        ca1, cx1, ca2, cx2, reverse);
+    }
+}
+
+static void FB_TARGET_AVX2
+fbSolidRowAVX2(CARD8 *dst, int n, CARD32 and, CARD32 xor)
+{
+    int phase = (int) ((uintptr_t) dst & 3);
+    int blocks = n >> 5, tail = n & 31;
+    __m256i a = _mm256_set1_epi32(fbRowRotate(and, phase));
+    __m256i x = _mm256_set1_epi32(fbRowRotate(xor, phase));
+    int i;
+
+    if (!and) {
+        for (i = 0; i < blocks; i++)
+            _mm256_storeu_si256((__m256i *) (dst + (i << 5)), x);
+    }
+    else {
+        for (i = 0; i < blocks; i++) {
+            __m256i *d = (__m256i *) (dst + (i << 5));
+
+            _mm256_storeu_si256(d,
+                                _mm256_xor_si256(_mm256_and_si256(_mm256_loadu_si256(d),
+                                                                  a), x));
+        }
+    }
+    fbSolidRowGeneric(dst + n - tail, tail, and, xor);
+}
+
+static void FB_TARGET_AVX2
+fbPlaneRowAVX2(CARD8 *dst, const CARD8 *src, int n, int bpp, CARD32 plane)
+{
+    const __m256i *s = (const __m256i *) src;
+    __m256i zero = _mm256_setzero_si256();
+    int blocks = n >> 5;
+    int i;
+
+    for (i = 0; i < blocks; i++, s += bpp >> 3) {
+        __m256i c;
+        CARD32 bits;
+
+        /* The packs work within each half, so the pixels are put back in
+         * order afterwards */
+        if (bpp == 8) {
+            c = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256(s),
+                                                   _mm256_set1_epi8((char) plane)),
+                                  zero);
+        }
+        else if (bpp == 16) {
+            __m256i pm = _mm256_set1_epi16((short) plane);
+
+            c = _mm256_packs_epi16(
+                _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_loadu_si256(s), pm),
+                                   zero),
+                _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_loadu_si256(s + 1),
+                                                    pm), zero));
+            c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(3, 1, 2, 0));
+        }
+        else {
+            __m256i pm = _mm256_set1_epi32((int) plane);
+
+            c = _mm256_packs_epi16(
+                _mm256_packs_epi32(
+                    _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(s),
+                                                        pm), zero),
+                    _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(s + 1),
+                                                        pm), zero)),
+                _mm256_packs_epi32(
+                    _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(s + 2),
+                                                        pm), zero),
+                    _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(s + 3),
+                                                        pm), zero)));
+            c = _mm256_permutevar8x32_epi32(c, _mm256_setr_epi32(0, 4, 1, 5,
+                                                                 2, 6, 3, 7));
+        }
+        bits = ~(CARD32) _mm256_movemask_epi8(c);
+        memcpy(dst + (i << 2), &bits, 4);
+    }
+    fbPlaneRowGeneric(dst + (blocks << 2), src + (blocks << 5) * (bpp >> 3),
+                      n & 31, bpp, plane);
+}
+
+#define FB_CPU_SSE2	(1 << 0)
+#define FB_CPU_AVX2	(1 << 1)
+
+static void
+fbCpuid(unsigned int leaf, unsigned int *regs)
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuidex(info, leaf, 0);
+    regs[0] = info[0];
+    regs[1] = info[1];
+    regs[2] = info[2];
+    regs[3] = info[3];
+#else
+    if (!__get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]))
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+static unsigned long long
+fbXgetbv(void)
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int a, d;
+
+    __asm__ __volatile__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return ((unsigned long long) d << 32) | a;
+#endif
+}
+
+static int
+fbCpuFeatures(void)
+{
+    unsigned int regs[4];
+    int features = 0;
+
+    fbCpuid(0, regs);
+    if (regs[0] < 1)
+        return 0;
+    fbCpuid(1, regs);
+
+    if (regs[3] & (1 << 26))
+        features |= FB_CPU_SSE2;
+
+    /* AVX2 needs the OS to save the YMM state as well */
+    if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28))
+        && (fbXgetbv() & 6) == 6) {
+        fbCpuid(0, regs);
+        if (regs[0] >= 7) {
+            fbCpuid(7, regs);
+            if (regs[1] & (1 << 5))
+                features |= FB_CPU_AVX2;
+        }
+    }
+
+    return features;
+}
+
+#endif /* FB_ROW_SIMD */
+
+const fbRowImplRec *
+fbRowImplementations(void)
+{
+    static fbRowImplRec impls[4];
+
+    if (impls[0].name == NULL) {
+        int n = 0;
+#ifdef FB_ROW_SIMD
+        int features = fbCpuFeatures();
+#endif
+
+        impls[n].name = "generic";
+        impls[n].blt = fbBltRowGeneric;
+        impls[n].solid = fbSolidRowGeneric;
+        impls[n].plane = fbPlaneRowGeneric;
+        n++;
+#ifdef FB_ROW_SIMD
+        if (features & FB_CPU_SSE2) {
+            impls[n].name = "sse2";
+            impls[n].blt = fbBltRowSSE2;
+            impls[n].solid = fbSolidRowSSE2;
+            impls[n].plane = fbPlaneRowSSE2;
+            n++;
+        }
+        if (features & FB_CPU_AVX2) {
+            impls[n].name = "avx2";
+            impls[n].blt = fbBltRowAVX2;
+            impls[n].solid = fbSolidRowAVX2;
+            impls[n].plane = fbPlaneRowAVX2;
+            n++;
+        }
+#endif
+    }
+
+    return impls;
+}
+
+/*
+ * The kernel pointers start out at resolvers, which replace them with
+ * the fastest implementation the first time a span is drawn.
+ */
+
+static void
+fbRowSelect(void)
+{
+    const fbRowImplRec *impl = fbRowImplementations();
+
+    while (impl[1].name != NULL)
+        impl++;
+    fbBltRow = impl->blt;
+    fbSolidRow = impl->solid;
+    fbPlaneRow = impl->plane;
+}
+
+static void
+fbBltRowResolve(CARD8 *dst, const CARD8 *src, int n,
+                CARD32 ca1, CARD32 cx1, CARD32 ca2, CARD32 cx2, int reverse)
+{
+    fbRowSelect();
+    (*fbBltRow) (dst, src, n, ca1, cx1, ca2, cx2, reverse);
+}
+
+static void
+fbSolidRowResolve(CARD8 *dst, int n, CARD32 and, CARD32 xor)
+{
+    fbRowSelect();
+    (*fbSolidRow) (dst, n, and, xor);
+}
+
+static void
+fbPlaneRowResolve(CARD8 *dst, const CARD8 *src, int n, int bpp, CARD32 plane)
+{
+    fbRowSelect();
+    (*fbPlaneRow) (dst, src, n, bpp, plane);
+}
+
+FbBltRowProc fbBltRow = fbBltRowResolve;
+FbSolidRowProc fbSolidRow = fbSolidRowResolve;
+FbPlaneRowProc fbPlaneRow = fbPlaneRowResolve;
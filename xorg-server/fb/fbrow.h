@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _FBROW_H_
+#define _FBROW_H_
+
+#include <X11/Xmd.h>
+
+/*
+ * Row kernels for byte aligned spans of fbBlt and fbSolid.
+ *
+ * fbBltRow combines n bytes of src into dst with the merge rop masks of
+ * fbrop.h, dst = (dst & ((src & ca1) ^ cx1)) ^ ((src & ca2) ^ cx2), and
+ * fbSolidRow sets n bytes of dst to (dst & and) ^ xor.  The masks are
+ * FbBits patterns laid down from the word boundary below dst, so any
+ * plane mask carries over.  A reverse fbBltRow walks from the end of the
+ * span back to its start, for copies onto an overlapping span further
+ * right.
+ *
+ * fbPlaneRow pulls one plane out of n pixels of 8, 16 or 32 bits into a
+ * bitmap, the first pixel in the low bit of the first byte, for XYPixmap
+ * GetImage.  A pixel is set when it has any of the bits of plane; the
+ * bits past n in the last byte are cleared.
+ */
+
+typedef void (*FbBltRowProc) (CARD8 *dst, const CARD8 *src, int n,
+                              CARD32 ca1, CARD32 cx1, CARD32 ca2, CARD32 cx2,
+                              int reverse);
+typedef void (*FbSolidRowProc) (CARD8 *dst, int n, CARD32 and, CARD32 xor);
+typedef void (*FbPlaneRowProc) (CARD8 *dst, const CARD8 *src, int n, int bpp,
+                                CARD32 plane);
+
+/* fbBlt, fbSolid and fbGetImage only hand spans to the kernels on x86 */
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FB_ROW_SIMD
+#endif
+
+/* Narrower spans are left to the word loops */
+#define FB_ROW_MIN_BYTES	64
+
+/* The fastest kernels the CPU supports, picked on first use */
+extern FbBltRowProc fbBltRow;
+extern FbSolidRowProc fbSolidRow;
+extern FbPlaneRowProc fbPlaneRow;
+
+typedef struct _fbRowImpl {
+    const char *name;
+    FbBltRowProc blt;
+    FbSolidRowProc solid;
+    FbPlaneRowProc plane;
+} fbRowImplRec, *fbRowImplPtr;
+
+/*
+ * All kernel sets the CPU can run, the plain C reference first and the
+ * fastest last, terminated by an entry with a NULL name.
+ */
+extern const fbRowImplRec *fbRowImplementations(void);
+
+#endif /* _FBROW_H_ */
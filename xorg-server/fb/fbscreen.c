@@ -33,6 +33,9 @@ fbCloseScreen(ScreenPtr pScreen)
     DepthPtr depths = pScreen->allowedDepths;
 
     fbDestroyGlyphCache();
+    fbPictTraceFlush();
+    if (fbPixmapBudget >= 0)
+        fbBudgetCloseScreen(pScreen);
     for (d = 0; d < pScreen->numDepths; d++)
         free(depths[d].vids);
     free(depths);
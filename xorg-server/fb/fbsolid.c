@@ -27,6 +27,7 @@
 #endif
 
 #include "fb.h"
+#include "fbrow.h"
 
 void
 fbSolid(FbBits * dst,
@@ -37,6 +38,20 @@ fbSolid(FbBits * dst,
     int n, nmiddle;
     int startbyte, endbyte;
 
+#if defined(FB_ROW_SIMD) && !defined(FB_ACCESS_WRAPPER)
+    /* Wide byte aligned spans go to the vector kernels whole */
+    if (!(dstX & 7) && !(width & 7) && (width >> 3) >= FB_ROW_MIN_BYTES) {
+        CARD8 *dst_byte = (CARD8 *) dst + (dstX >> 3);
+        FbStride dst_byte_stride = dstStride << (FB_SHIFT - 3);
+
+        while (height--) {
+            (*fbSolidRow) (dst_byte, width >> 3, and, xor);
+            dst_byte += dst_byte_stride;
+        }
+        return;
+    }
+#endif
+
     dst += dstX >> FB_SHIFT;
     dstX &= FB_MASK;
     FbMaskBitsBytes(dstX, width, and == 0, startmask, startbyte,
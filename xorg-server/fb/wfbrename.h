@@ -7,6 +7,7 @@
 #define fbBlt wfbBlt
 #define fbBltOne wfbBltOne
 #define fbBltPlane wfbBltPlane
+#define fbBltRow wfbBltRow
 #define fbBltStip wfbBltStip
 #define fbBres wfbBres
 #define fbBresDash wfbBresDash
@@ -19,6 +20,11 @@
 #define fbBresSolid16 wfbBresSolid16
 #define fbBresSolid32 wfbBresSolid32
 #define fbBresSolid8 wfbBresSolid8
+#define fbBudgetAccess wfbBudgetAccess
+#define fbBudgetAllocBits wfbBudgetAllocBits
+#define fbBudgetCloseScreen wfbBudgetCloseScreen
+#define fbBudgetFreeBits wfbBudgetFreeBits
+#define fbBudgetScreenInit wfbBudgetScreenInit
 #define fbChangeWindowAttributes wfbChangeWindowAttributes
 #define fbClearVisualTypes wfbClearVisualTypes
 #define fbCloseScreen wfbCloseScreen
@@ -77,8 +83,13 @@
 #define fbOverlayWindowExposures wfbOverlayWindowExposures
 #define fbOverlayWindowLayer wfbOverlayWindowLayer
 #define fbPadPixmap wfbPadPixmap
+#define fbPictTraceFile wfbPictTraceFile
+#define fbPictTraceFlush wfbPictTraceFlush
 #define fbPictureInit wfbPictureInit
+#define fbPixmapBudget wfbPixmapBudget
+#define fbPixmapIdleTime wfbPixmapIdleTime
 #define fbPixmapToRegion wfbPixmapToRegion
+#define fbPlaneRow wfbPlaneRow
 #define fbPolyArc wfbPolyArc
 #define fbPolyFillRect wfbPolyFillRect
 #define fbPolyGlyphBlt wfbPolyGlyphBlt
@@ -104,6 +115,7 @@
 #define fbRealizeFont wfbRealizeFont
 #define fbReplicatePixel wfbReplicatePixel
 #define fbResolveColor wfbResolveColor
+#define fbRowImplementations wfbRowImplementations
 #define fbScreenPrivateKeyRec wfbScreenPrivateKeyRec
 #define fbSegment wfbSegment
 #define fbSelectBres wfbSelectBres
@@ -114,6 +126,7 @@
 #define _fbSetWindowPixmap _wfbSetWindowPixmap
 #define fbSolid wfbSolid
 #define fbSolidBoxClipped wfbSolidBoxClipped
+#define fbSolidRow wfbSolidRow
 #define fbTrapezoids wfbTrapezoids
 #define fbTriangles wfbTriangles
 #define fbUninstallColormap wfbUninstallColormap
@@ -89,6 +89,7 @@ static const struct extension_info known_glx_extensions[] = {
     { GLX(EXT_libglvnd),                VER(0,0), N, },
     { GLX(EXT_no_config_context),       VER(0,0), N, },
     { GLX(EXT_stereo_tree),             VER(0,0), N, },
+    { GLX(EXT_swap_control_tear),       VER(0,0), N, },
     { GLX(EXT_texture_from_pixmap),     VER(0,0), N, },
     { GLX(EXT_visual_info),             VER(0,0), Y, },
     { GLX(EXT_visual_rating),           VER(0,0), Y, },
@@ -165,6 +166,12 @@ __glXEnableExtension(unsigned char *enable_bits, const char *ext)
     }
 }
 
+int
+__glXExtensionBitIsEnabled(const unsigned char *enable_bits, unsigned bit)
+{
+    return IS_SET(enable_bits, bit);
+}
+
 void
 __glXInitExtensionEnableBits(unsigned char *enable_bits)
 {
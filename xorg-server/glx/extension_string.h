@@ -51,6 +51,7 @@ enum {
     EXT_libglvnd_bit,
     EXT_no_config_context_bit,
     EXT_stereo_tree_bit,
+    EXT_swap_control_tear_bit,
     EXT_texture_from_pixmap_bit,
     EXT_visual_info_bit,
     EXT_visual_rating_bit,
@@ -77,5 +78,7 @@ extern int __glXGetExtensionString(const unsigned char *enable_bits,
                                    char *buffer);
 extern void __glXEnableExtension(unsigned char *enable_bits, const char *ext);
 extern void __glXInitExtensionEnableBits(unsigned char *enable_bits);
+extern int __glXExtensionBitIsEnabled(const unsigned char *enable_bits,
+                                      unsigned bit);
 
 #endif                          /* GLX_EXTENSION_STRING_H */
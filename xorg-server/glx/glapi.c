@@ -86,9 +86,16 @@ static void init_glapi_relocs(void);
 /*@{*/
 #if defined(GLX_USE_TLS)
 
-PUBLIC TLS struct _glapi_table *_glapi_tls_Dispatch = NULL;
+#ifdef _MSC_VER
+/* not exported, see glapi.h */
+__declspec(thread) struct _glapi_table *_glapi_tls_Dispatch = NULL;
+
+__declspec(thread) void *_glapi_tls_Context;
+#else
+PUBLIC __thread struct _glapi_table *_glapi_tls_Dispatch = NULL;
 
-PUBLIC TLS void *_glapi_tls_Context;
+PUBLIC __thread void *_glapi_tls_Context;
+#endif
 
 PUBLIC const struct _glapi_table *_glapi_Dispatch = NULL;
 PUBLIC const void *_glapi_Context = NULL;
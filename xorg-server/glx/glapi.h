@@ -102,17 +102,32 @@ typedef void (*_glapi_warning_func)(void *ctx, const char *str, ...);
  **/
 #if defined (GLX_USE_TLS)
 
+#ifdef _MSC_VER
+/*
+ * Thread-local data can't be imported from another module, so the swrast
+ * DLL reaches the server's through the exported accessors.
+ */
+extern __declspec(thread) struct _glapi_table * _glapi_tls_Dispatch;
+
+extern __declspec(thread) void * _glapi_tls_Context;
+#else
 _GLAPI_EXPORT extern __thread struct _glapi_table * _glapi_tls_Dispatch
   ;
 
 _GLAPI_EXPORT extern __thread void * _glapi_tls_Context
   ;
+#endif
 
 _GLAPI_EXPORT extern const struct _glapi_table *_glapi_Dispatch;
 _GLAPI_EXPORT extern const void *_glapi_Context;
 
+#ifdef _MSC_VER
+# define GET_DISPATCH() _glapi_get_dispatch()
+# define GET_CURRENT_CONTEXT(C)  struct gl_context *C = (struct gl_context *) _glapi_get_context()
+#else
 # define GET_DISPATCH() _glapi_tls_Dispatch
 # define GET_CURRENT_CONTEXT(C)  struct gl_context *C = (struct gl_context *) _glapi_tls_Context
+#endif
 
 #else
 
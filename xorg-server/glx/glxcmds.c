@@ -51,6 +51,7 @@
 #include "glxvndabi.h"
 
 #include "glfunctions.h"
+#include "frametrace.h"
 
 #ifdef PANORAMIX
 #include "panoramiX.h"
@@ -1687,7 +1688,10 @@ __glXDisp_SwapBuffers(__GLXclientState * cl, GLbyte * pc)
              ** Do whatever is needed to make sure that all preceding requests
              ** in both streams are completed before the swap is executed.
              */
-            glFinish();
+            if (glxc->pGlxScreen->swapNeedsOnlyFlush)
+                glFlush();
+            else
+                glFinish();
         }
         else {
             return error;
@@ -1698,9 +1702,15 @@ __glXDisp_SwapBuffers(__GLXclientState * cl, GLbyte * pc)
     if (pGlxDraw == NULL)
         return error;
 
-    if (pGlxDraw->type == DRAWABLE_WINDOW &&
-        (*pGlxDraw->swapBuffers) (cl->client, pGlxDraw) == GL_FALSE)
-        return __glXError(GLXBadDrawable);
+    if (pGlxDraw->type == DRAWABLE_WINDOW) {
+        GLboolean swapped;
+
+        FRAME_TRACE_BEGIN("GLXSwapBuffers");
+        swapped = (*pGlxDraw->swapBuffers) (cl->client, pGlxDraw);
+        FRAME_TRACE_END("GLXSwapBuffers");
+        if (swapped == GL_FALSE)
+            return __glXError(GLXBadDrawable);
+    }
 
     return Success;
 }
@@ -1892,7 +1902,10 @@ __glXDisp_CopySubBufferMESA(__GLXclientState * cl, GLbyte * pc)
              ** Do whatever is needed to make sure that all preceding requests
              ** in both streams are completed before the swap is executed.
              */
-            glFinish();
+            if (glxc->pGlxScreen->swapNeedsOnlyFlush)
+                glFlush();
+            else
+                glFinish();
         }
         else {
             return error;
@@ -2040,6 +2053,58 @@ ResetLargeCommandStatus(__GLXcontext *cx)
 /*
 ** Execute all the drawing commands in a request.
 */
+/*
+** Execute render commands which have already been checked by
+** __glXDisp_Render().  Nothing here depends on the client, so the
+** commands may be run on another thread.
+*/
+void
+__glXExecuteRender(GLbyte * pc, int length, Bool swapped)
+{
+    while (length > 0) {
+        __GLXrenderHeader *hdr = (__GLXrenderHeader *) pc;
+        __GLXrenderSizeData entry;
+        __GLXdispatchRenderProcPtr proc;
+        int cmdlen = hdr->length;
+
+        proc = (__GLXdispatchRenderProcPtr)
+            __glXGetRenderCommand(&Render_dispatch_info,
+                                  hdr->opcode, swapped, &entry);
+
+        /*
+         ** Skip over the header and execute the command.  We allow the
+         ** caller to trash the command memory.  This is useful especially
+         ** for things that require double alignment - they can just shift
+         ** the data towards lower memory (trashing the header) by 4 bytes
+         ** and achieve the required alignment.
+         */
+        (*proc) (pc + __GLX_RENDER_HDR_SIZE);
+        pc += cmdlen;
+        length -= cmdlen;
+    }
+}
+
+/*
+** Execute an assembled large render command checked by
+** __glXDisp_RenderLarge().
+*/
+void
+__glXExecuteRenderLarge(GLbyte * pc, Bool swapped)
+{
+    __GLXrenderLargeHeader *hdr = (__GLXrenderLargeHeader *) pc;
+    __GLXdispatchRenderProcPtr proc;
+
+    proc = (__GLXdispatchRenderProcPtr)
+        __glXGetProtocolDecodeFunction(&Render_dispatch_info, hdr->opcode,
+                                       swapped);
+    (*proc) (pc + __GLX_RENDER_LARGE_HDR_SIZE);
+}
+
+/*
+** Execute all the commands in a render request, or hand them to the
+** context to be executed later if it can.  Every command is checked
+** first, and the ones before a bad command are still executed.
+*/
 int
 __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
 {
@@ -2050,6 +2115,8 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
     CARD16 opcode;
     __GLXrenderHeader *hdr;
     __GLXcontext *glxc;
+    GLbyte *start;
+    int retval = Success;
 
     __GLX_DECLARE_SWAP_VARIABLES;
 
@@ -2068,15 +2135,17 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
 
     commandsDone = 0;
     pc += sz_xGLXRenderReq;
+    start = pc;
     left = (req->length << 2) - sz_xGLXRenderReq;
     while (left > 0) {
         __GLXrenderSizeData entry;
         int extra = 0;
         __GLXdispatchRenderProcPtr proc;
-        int err;
 
-        if (left < sizeof(__GLXrenderHeader))
-            return BadLength;
+        if (left < sizeof(__GLXrenderHeader)) {
+            retval = BadLength;
+            break;
+        }
 
         /*
          ** Verify that the header length and the overall length agree.
@@ -2090,24 +2159,27 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
         cmdlen = hdr->length;
         opcode = hdr->opcode;
 
-        if (left < cmdlen)
-            return BadLength;
+        if (left < cmdlen) {
+            retval = BadLength;
+            break;
+        }
 
         /*
          ** Check for core opcodes and grab entry data.
          */
-        err = __glXGetProtocolSizeData(&Render_dispatch_info, opcode, &entry);
         proc = (__GLXdispatchRenderProcPtr)
-            __glXGetProtocolDecodeFunction(&Render_dispatch_info,
-                                           opcode, client->swapped);
+            __glXGetRenderCommand(&Render_dispatch_info,
+                                  opcode, client->swapped, &entry);
 
-        if ((err < 0) || (proc == NULL)) {
+        if (proc == NULL) {
             client->errorValue = commandsDone;
-            return __glXError(GLXBadRenderRequest);
+            retval = __glXError(GLXBadRenderRequest);
+            break;
         }
 
         if (cmdlen < entry.bytes) {
-            return BadLength;
+            retval = BadLength;
+            break;
         }
 
         if (entry.varsize) {
@@ -2116,27 +2188,28 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
                                       client->swapped,
                                       left - __GLX_RENDER_HDR_SIZE);
             if (extra < 0) {
-                return BadLength;
+                retval = BadLength;
+                break;
             }
         }
 
         if (cmdlen != safe_pad(safe_add(entry.bytes, extra))) {
-            return BadLength;
+            retval = BadLength;
+            break;
         }
 
-        /*
-         ** Skip over the header and execute the command.  We allow the
-         ** caller to trash the command memory.  This is useful especially
-         ** for things that require double alignment - they can just shift
-         ** the data towards lower memory (trashing the header) by 4 bytes
-         ** and achieve the required alignment.
-         */
-        (*proc) (pc + __GLX_RENDER_HDR_SIZE);
         pc += cmdlen;
         left -= cmdlen;
         commandsDone++;
     }
-    return Success;
+
+    if (pc > start &&
+        !(glxc->queueRender &&
+          (*glxc->queueRender) (glxc, start, pc - start, FALSE,
+                                client->swapped)))
+        __glXExecuteRender(start, pc - start, client->swapped);
+
+    return retval;
 }
 
 /*
@@ -2343,7 +2416,11 @@ __glXDisp_RenderLarge(__GLXclientState * cl, GLbyte * pc)
             /*
              ** Skip over the header and execute the command.
              */
-            (*proc) (glxc->largeCmdBuf + __GLX_RENDER_LARGE_HDR_SIZE);
+            if (!(glxc->queueRender &&
+                  (*glxc->queueRender) (glxc, glxc->largeCmdBuf,
+                                        glxc->largeCmdBytesTotal, TRUE,
+                                        client->swapped)))
+                __glXExecuteRenderLarge(glxc->largeCmdBuf, client->swapped);
 
             /*
              ** Reset for the next RenderLarge series.
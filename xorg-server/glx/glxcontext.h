@@ -42,6 +42,14 @@ struct __GLXcontext {
     int (*copy) (__GLXcontext * dst, __GLXcontext * src, unsigned long mask);
     Bool (*wait) (__GLXcontext * context, __GLXclientState * cl, int *error);
 
+    /*
+     ** Optional: keep checked render commands, or one assembled large
+     ** render command, to be run later by __glXExecuteRender() or
+     ** __glXExecuteRenderLarge().  Returns FALSE if they must be run now.
+     */
+    Bool (*queueRender) (__GLXcontext * context, const GLbyte * pc,
+                         int length, Bool large, Bool swapped);
+
     /* EXT_texture_from_pixmap */
     int (*bindTexImage) (__GLXcontext * baseContext,
                          int buffer, __GLXdrawable * pixmap);
@@ -122,6 +130,13 @@ struct __GLXcontext {
     GLbyte *largeCmdBuf;
     GLint largeCmdBufSize;
 
+    /*
+     ** Pixel pack buffer for large glReadPixels replies, see singlepix.c.
+     ** hasPixelBufferObject is 0 until it has been queried, then 1 or -1.
+     */
+    GLuint readPixelsBuffer;
+    GLint hasPixelBufferObject;
+
     /*
      ** The drawable private this context is bound to
      */
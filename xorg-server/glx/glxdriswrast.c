@@ -42,7 +42,9 @@
 
 #include "scrnintstr.h"
 #include "pixmapstr.h"
+#include "windowstr.h"
 #include "gcstruct.h"
+#include "damage.h"
 #include "os.h"
 
 #include "glxserver.h"
@@ -356,6 +358,88 @@ swrastGetImage(__DRIdrawable * draw,
     }
 }
 
+/*
+ * Let the driver render straight into the pixels of a pixmap, or of a
+ * window nothing covers, which with the Windows shadow GDI server is the
+ * shadow DIB itself.  Damage then gets them to the screen.
+ */
+static char *
+swrastGetFrontBuffer(__DRIdrawable * draw, int *width, int *height,
+                     int *stride, int *bpp, void *loaderPrivate)
+{
+    __GLXDRIdrawable *drawable = loaderPrivate;
+    DrawablePtr pDraw = drawable->base.pDraw;
+    PixmapPtr pPixmap;
+    int x = 0, y = 0;
+
+#ifdef PANORAMIX
+    if (drawable->base.pAll)
+        return NULL;
+#endif
+
+    if (pDraw->type == DRAWABLE_WINDOW) {
+        WindowPtr pWin = (WindowPtr) pDraw;
+        const BoxRec *clip = RegionExtents(&pWin->clipList);
+
+        if (!pWin->viewable || RegionNumRects(&pWin->clipList) != 1 ||
+            clip->x1 != pDraw->x || clip->y1 != pDraw->y ||
+            clip->x2 != pDraw->x + pDraw->width ||
+            clip->y2 != pDraw->y + pDraw->height)
+            return NULL;
+
+        pPixmap = pDraw->pScreen->GetWindowPixmap(pWin);
+        x = pDraw->x;
+        y = pDraw->y;
+#ifdef COMPOSITE
+        x -= pPixmap->screen_x;
+        y -= pPixmap->screen_y;
+#endif
+    }
+    else
+        pPixmap = (PixmapPtr) pDraw;
+
+    if (!pPixmap->devPrivate.ptr)
+        return NULL;
+
+    *width = pDraw->width;
+    *height = pDraw->height;
+    *stride = pPixmap->devKind;
+    *bpp = pDraw->bitsPerPixel;
+    return (char *) pPixmap->devPrivate.ptr + y * pPixmap->devKind +
+        x * (pDraw->bitsPerPixel / 8);
+}
+
+static void
+swrastDamage(__DRIdrawable * draw, int x, int y, int w, int h,
+             void *loaderPrivate)
+{
+    __GLXDRIdrawable *drawable = loaderPrivate;
+    DrawablePtr pDraw = drawable->base.pDraw;
+    __GLXcontext *cx = lastGLContext;
+    BoxRec box;
+    RegionRec region;
+
+    box.x1 = pDraw->x + x;
+    box.y1 = pDraw->y + y;
+    box.x2 = box.x1 + w;
+    box.y2 = box.y1 + h;
+    RegionInit(&region, &box, 1);
+    DamageRegionAppend(pDraw, &region);
+    DamageRegionProcessPending(pDraw);
+    RegionUninit(&region);
+
+    if (cx != lastGLContext) {
+        lastGLContext = cx;
+        cx->makeCurrent(cx);
+    }
+}
+
+static const __DRIswrastFrontLoaderExtension swrastFrontLoaderExtension = {
+    {__DRI_SWRAST_FRONT_LOADER, __DRI_SWRAST_FRONT_LOADER_VERSION},
+    swrastGetFrontBuffer,
+    swrastDamage
+};
+
 static const __DRIswrastLoaderExtension swrastLoaderExtension = {
     {__DRI_SWRAST_LOADER, __DRI_SWRAST_LOADER_VERSION},
     swrastGetDrawableInfo,
@@ -365,6 +449,7 @@ static const __DRIswrastLoaderExtension swrastLoaderExtension = {
 
 static const __DRIextension *loader_extensions[] = {
     &swrastLoaderExtension.base,
+    &swrastFrontLoaderExtension.base,
     NULL
 };
 
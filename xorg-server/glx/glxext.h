@@ -63,6 +63,10 @@ extern Bool __glXAddContext(__GLXcontext * cx);
 SERVEXTERN void __glXErrorCallBack(GLenum code);
 extern void __glXClearErrorOccured(void);
 extern GLboolean __glXErrorOccured(void);
+extern void *__glXReadPixelsMapped(__GLXcontext * cx, GLint x, GLint y,
+                                   GLsizei width, GLsizei height,
+                                   GLenum format, GLenum type, GLint compsize);
+extern void __glXReadPixelsUnmap(void);
 
 extern const char GLServerVersion[];
 extern int DoGetString(__GLXclientState * cl, GLbyte * pc, GLboolean need_swap);
@@ -150,6 +150,10 @@ struct __GLXscreen {
     char *glvnd;
     unsigned char glx_enable_bits[__GLX_EXT_BYTES];
 
+    /* swapBuffers orders itself after the preceding rendering, so
+       SwapBuffers only needs to flush rather than finish */
+    Bool swapNeedsOnlyFlush;
+
     Bool (*CloseScreen) (ScreenPtr pScreen);
 };
 
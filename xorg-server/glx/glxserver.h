@@ -84,6 +84,9 @@ extern __GLXcontext *__glXForceCurrent(__GLXclientState *, GLXContextTag,
 
 int __glXError(int error);
 
+extern void __glXExecuteRender(GLbyte * pc, int length, Bool swapped);
+extern void __glXExecuteRenderLarge(GLbyte * pc, Bool swapped);
+
 /************************************************************************/
 
 enum {
@@ -260,6 +260,39 @@ get_decode_index(const struct __glXDispatchInfo *dispatch_info, unsigned opcode)
     return -1;
 }
 
+/* Flat opcode to function index map for the most recently used dispatch
+ * tree.  Each command in a Render request needs both its decode function
+ * and its size data, so this turns two walks down the tree into one load.
+ */
+#define FLAT_INDEX_BITS 13
+
+static const struct __glXDispatchInfo *flat_dispatch_info;
+static int_fast16_t flat_decode_index[1 << FLAT_INDEX_BITS];
+
+static int
+get_flat_decode_index(const struct __glXDispatchInfo *dispatch_info,
+                      unsigned opcode)
+{
+    if (dispatch_info->bits > FLAT_INDEX_BITS) {
+        return get_decode_index(dispatch_info, opcode);
+    }
+
+    if (opcode >= (1U << dispatch_info->bits)) {
+        return -1;
+    }
+
+    if (flat_dispatch_info != dispatch_info) {
+        unsigned i;
+
+        for (i = 0; i < (1U << dispatch_info->bits); i++) {
+            flat_decode_index[i] = get_decode_index(dispatch_info, i);
+        }
+        flat_dispatch_info = dispatch_info;
+    }
+
+    return flat_decode_index[opcode];
+}
+
 void *
 __glXGetProtocolDecodeFunction(const struct __glXDispatchInfo *dispatch_info,
                                int opcode, int swapped_version)
@@ -294,3 +327,34 @@ __glXGetProtocolSizeData(const struct __glXDispatchInfo *dispatch_info,
 
     return -1;
 }
+
+/**
+ * Look up both the decode function and the size data for a render command.
+ *
+ * \returns
+ * The decode function, or \c NULL if the opcode has no decode function or
+ * no size data.
+ */
+void *
+__glXGetRenderCommand(const struct __glXDispatchInfo *dispatch_info,
+                      int opcode, int swapped_version,
+                      __GLXrenderSizeData * data)
+{
+    const int func_index = get_flat_decode_index(dispatch_info, opcode);
+    int var_offset;
+
+    if ((func_index < 0) || (dispatch_info->size_table == NULL)
+        || (dispatch_info->size_table[func_index][0] == 0)) {
+        return NULL;
+    }
+
+    var_offset = dispatch_info->size_table[func_index][1];
+
+    data->bytes = dispatch_info->size_table[func_index][0];
+    data->varsize = (var_offset != ~0)
+        ? dispatch_info->size_func_table[var_offset]
+        : NULL;
+
+    return (void *) dispatch_info->
+        dispatch_functions[func_index][swapped_version];
+}
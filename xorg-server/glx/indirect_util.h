@@ -50,4 +50,9 @@ extern int __glXGetProtocolSizeData(const struct __glXDispatchInfo
                                     *dispatch_info, int opcode,
                                     __GLXrenderSizeData * data);
 
+extern void *__glXGetRenderCommand(const struct __glXDispatchInfo
+                                   *dispatch_info, int opcode,
+                                   int swapped_version,
+                                   __GLXrenderSizeData * data);
+
 #endif                          /* __GLX_INDIRECT_UTIL_H__ */
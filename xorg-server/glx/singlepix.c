@@ -31,6 +31,8 @@
 #ifdef HAVE_DIX_CONFIG_H
 #include <dix-config.h>
 #endif
+#include <stdio.h>
+#include <string.h>
 #include "glheader.h"
 
 #include "glxserver.h"
@@ -42,6 +44,81 @@
 
 #include "glfunctions.h"
 
+/*
+** Large readbacks go through a pixel pack buffer owned by the context.  The
+** driver can then DMA the pixels instead of copying them into our buffer
+** with the CPU, and the reply is written straight from the mapping.
+*/
+#define __GLX_READPIXELS_PBO_MIN_SIZE (64 * 1024)
+
+static GLboolean
+__glXHasPixelBufferObject(__GLXcontext * cx)
+{
+    if (cx->hasPixelBufferObject == 0) {
+        const char *version = (const char *) glGetString(GL_VERSION);
+        const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+        int major = 0, minor = 0;
+
+        if (version)
+            sscanf(version, "%d.%d", &major, &minor);
+
+        if (major > 2 || (major == 2 && minor >= 1) ||
+            (extensions && strstr(extensions, "GL_ARB_pixel_buffer_object")))
+            cx->hasPixelBufferObject = 1;
+        else
+            cx->hasPixelBufferObject = -1;
+    }
+
+    return cx->hasPixelBufferObject > 0;
+}
+
+/*
+** Read pixels into the context's pack buffer and map it.  Returns NULL if the
+** caller should read into client memory instead; otherwise the mapping must
+** be released with __glXReadPixelsUnmap() once the reply has been sent.
+*/
+void *
+__glXReadPixelsMapped(__GLXcontext * cx, GLint x, GLint y,
+                      GLsizei width, GLsizei height,
+                      GLenum format, GLenum type, GLint compsize)
+{
+    GLint binding = 0;
+    void *pixels;
+
+    if (compsize < __GLX_READPIXELS_PBO_MIN_SIZE ||
+        !__glXHasPixelBufferObject(cx))
+        return NULL;
+
+    /* Leave a buffer the client bound itself alone */
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &binding);
+    if (binding != 0)
+        return NULL;
+
+    if (cx->readPixelsBuffer == 0)
+        glGenBuffers(1, &cx->readPixelsBuffer);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, cx->readPixelsBuffer);
+
+    /* Orphan the previous contents, so this never waits on an old read.
+       __GLX_SEND_VOID_ARRAY() sends the padding too. */
+    glBufferData(GL_PIXEL_PACK_BUFFER, __GLX_PAD(compsize), NULL,
+                 GL_STREAM_READ);
+    glReadPixels(x, y, width, height, format, type, NULL);
+
+    pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (!pixels)
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return pixels;
+}
+
+void
+__glXReadPixelsUnmap(void)
+{
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
 int
 __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
 {
@@ -53,6 +130,7 @@ __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
     ClientPtr client = cl->client;
     int error;
     char *answer, answerBuffer[200];
+    void *mapped;
     xGLXSingleReply reply = { 0, };
 
     REQUEST_FIXED_SIZE(xGLXSingleReq, 28);
@@ -75,11 +153,18 @@ __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
 
     glPixelStorei(GL_PACK_SWAP_BYTES, swapBytes);
     glPixelStorei(GL_PACK_LSB_FIRST, lsbFirst);
-    __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
     __glXClearErrorOccured();
-    glReadPixels(*(GLint *) (pc + 0), *(GLint *) (pc + 4),
-                 *(GLsizei *) (pc + 8), *(GLsizei *) (pc + 12),
-                 *(GLenum *) (pc + 16), *(GLenum *) (pc + 20), answer);
+    mapped = __glXReadPixelsMapped(cx, *(GLint *) (pc + 0), *(GLint *) (pc + 4),
+                                   width, height, format, type, compsize);
+    if (mapped) {
+        answer = mapped;
+    }
+    else {
+        __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
+        glReadPixels(*(GLint *) (pc + 0), *(GLint *) (pc + 4),
+                     *(GLsizei *) (pc + 8), *(GLsizei *) (pc + 12),
+                     *(GLenum *) (pc + 16), *(GLenum *) (pc + 20), answer);
+    }
 
     if (__glXErrorOccured()) {
         __GLX_BEGIN_REPLY(0);
@@ -90,6 +175,8 @@ __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
         __GLX_SEND_HEADER();
         __GLX_SEND_VOID_ARRAY(compsize);
     }
+    if (mapped)
+        __glXReadPixelsUnmap();
     return Success;
 }
 
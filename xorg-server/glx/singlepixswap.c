@@ -55,6 +55,7 @@ __glXDispSwap_ReadPixels(__GLXclientState * cl, GLbyte * pc)
     ClientPtr client = cl->client;
     int error;
     char *answer, answerBuffer[200];
+    void *mapped;
     xGLXSingleReply reply = { 0, };
 
     REQUEST_FIXED_SIZE(xGLXSingleReq, 28);
@@ -85,11 +86,18 @@ __glXDispSwap_ReadPixels(__GLXclientState * cl, GLbyte * pc)
 
     glPixelStorei(GL_PACK_SWAP_BYTES, !swapBytes);
     glPixelStorei(GL_PACK_LSB_FIRST, lsbFirst);
-    __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
     __glXClearErrorOccured();
-    glReadPixels(*(GLint *) (pc + 0), *(GLint *) (pc + 4),
-                 *(GLsizei *) (pc + 8), *(GLsizei *) (pc + 12),
-                 *(GLenum *) (pc + 16), *(GLenum *) (pc + 20), answer);
+    mapped = __glXReadPixelsMapped(cx, *(GLint *) (pc + 0), *(GLint *) (pc + 4),
+                                   width, height, format, type, compsize);
+    if (mapped) {
+        answer = mapped;
+    }
+    else {
+        __GLX_GET_ANSWER_BUFFER(answer, cl, compsize, 1);
+        glReadPixels(*(GLint *) (pc + 0), *(GLint *) (pc + 4),
+                     *(GLsizei *) (pc + 8), *(GLsizei *) (pc + 12),
+                     *(GLenum *) (pc + 16), *(GLenum *) (pc + 20), answer);
+    }
 
     if (__glXErrorOccured()) {
         __GLX_BEGIN_REPLY(0);
@@ -102,6 +110,8 @@ __glXDispSwap_ReadPixels(__GLXclientState * cl, GLbyte * pc)
         __GLX_SEND_HEADER();
         __GLX_SEND_VOID_ARRAY(compsize);
     }
+    if (mapped)
+        __glXReadPixelsUnmap();
     return Success;
 }
 
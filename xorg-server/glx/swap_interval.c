@@ -72,7 +72,11 @@ DoSwapInterval(__GLXclientState * cl, GLbyte * pc, int do_swap)
         ? bswap_32(*(int *) (pc + 0))
         : *(int *) (pc + 0);
 
-    if (interval <= 0)
+    /* A negative interval is adaptive vsync: swap late frames immediately */
+    if (interval == 0 ||
+        (interval < 0 &&
+         !__glXExtensionBitIsEnabled(cx->pGlxScreen->glx_enable_bits,
+                                     EXT_swap_control_tear_bit)))
         return BadValue;
 
     (void) (*cx->pGlxScreen->swapInterval) (cx->drawPriv, interval);
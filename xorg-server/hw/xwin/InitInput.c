@@ -117,6 +117,7 @@ InitInput(int argc, char *argv[])
     }
 #endif
 
+    winStartupMark("InitInput done");
     winDebug("InitInput - returning\n");
 }
 
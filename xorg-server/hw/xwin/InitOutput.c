@@ -220,6 +220,7 @@ ddxGiveUp(enum ExitCode error)
      * we are guaranteed to not need the DirectDraw functions.
      */
     winReleaseDDProcAddresses();
+    winReleaseD3D11ProcAddresses();
 
     /* Free concatenated command line */
     free(g_pszCommandLine);
@@ -779,8 +780,14 @@ winUseMsg(void)
            "\tOverride the server's automatically selected engine type:\n"
            "\t\t1 - Shadow GDI\n"
            "\t\t4 - Shadow DirectDraw4 Non-Locking\n"
+           "\t\t8 - Shadow Direct3D 11 flip model\n"
         );
 
+    ErrorF("-framepace\n"
+           "\tCollect shadow framebuffer damage and update the display at\n"
+           "\tmost once per monitor refresh.  Damage following keyboard or\n"
+           "\tmouse button input is still shown immediately.\n");
+
     ErrorF("-fullscreen\n" "\tRun the server in fullscreen mode.\n");
 
     ErrorF("-[no]hostintitle\n"
@@ -813,6 +820,28 @@ winUseMsg(void)
            "\t\t2 - print additional runtime information [default].\n"
            "\t\t3 - print debugging and tracing information.\n");
 
+    ErrorF("-maxfps fps\n"
+           "\tLimit shadow framebuffer updates to fps per second when it is\n"
+           "\tbelow the monitor refresh rate.  Implies -framepace.\n");
+
+    ErrorF("-picturetrace filename\n"
+           "\tTrace every Render composite and glyph run to <filename>, for\n"
+           "\tpixman's trace-bench to play back.\n");
+
+    ErrorF("-pixmapbudget megabytes\n"
+           "\tCompress the pixmaps which have gone unused for a while once\n"
+           "\ttheir bits take more than megabytes.  Default is not to.\n");
+
+    ErrorF("-pixmapidle secs\n"
+           "\tHow long a pixmap must go unused before -pixmapbudget may\n"
+           "\tcompress it.  Default is 60.\n");
+
+    ErrorF("-scale percent|auto\n"
+           "\tMake each X pixel percent/100 Windows pixels wide, having the\n"
+           "\tGPU scale the screen up rather than Windows stretching all of\n"
+           "\tthe output.  auto follows the Windows display scaling.\n"
+           "\tWindowed mode with the D3D11 engine only.\n");
+
     ErrorF("-[no]multimonitors or -[no]multiplemonitors\n"
            "\tUse the entire virtual screen if multiple\n"
            "\tmonitors are present.\n");
@@ -824,6 +853,10 @@ winUseMsg(void)
 #ifdef XWIN_MULTIWINDOWEXTWM
     ErrorF("-mwextwm\n"
            "\tRun the server in multi-window external window manager mode.\n");
+
+    ErrorF("-layeredframes\n"
+           "\tIn -mwextwm mode, present each frame as a layered window\n"
+           "\tstraight from its DIB, with per-pixel alpha for ARGB visuals.\n");
 #endif
 
     ErrorF("-nodecoration\n"
@@ -846,6 +879,10 @@ winUseMsg(void)
            "\tmode gives the window scrollbars as needed, 'randr' mode uses the RANR\n"
            "\textension to resize the X screen.  'randr' is the default.\n");
 
+    ErrorF("-rawmouse\n"
+           "\tReport the mouse's own motion to XI2 RawMotion clients, from\n"
+           "\tWindows Raw Input.\n");
+
     ErrorF("-rootless\n"
            "\tUse a transparent root window with an external window\n"
            "\tmanager (such as openbox).  Not to be used with\n"
@@ -865,6 +902,10 @@ winUseMsg(void)
            "\tDisable the usage of the Windows cursor and use the X11 software\n"
            "\tcursor instead.\n");
 
+    ErrorF("-titlerate n\n"
+           "\tIn multiwindow mode, change the title of a window at most n times\n"
+           "\ta second.  0 sets every title at once.  Default is 10.\n");
+
     ErrorF("-[no]trayicon\n"
            "\tDo not create a notification area icon.  Default is to create\n"
            "\tone icon per screen.  You can globally disable notification area\n"
@@ -881,6 +922,16 @@ winUseMsg(void)
     ErrorF("-swrastwgl\n"
            "\tEnable the GLX extension to use the native Windows WGL interface based on the swrast interface for accelerated OpenGL\n");
 
+    ErrorF("-asyncswap\n"
+           "\tPerform GLX SwapBuffers on a worker thread, so a client waiting for vsync does not stall the others\n");
+
+    ErrorF("-glthread\n"
+           "\tRun the rendering commands of each native GLX context on its own thread\n");
+
+    ErrorF("-hiddenswapdelay msecs\n"
+           "\tLimit a GLX window which is obscured or minimized to one SwapBuffers every msecs\n"
+           "\tmilliseconds, and drop the swaps of minimized windows.  0 disables this.  Default is 100\n");
+
     ErrorF("-[no]winkill\n" "\tAlt+F4 exits the X Server.\n");
 
     ErrorF("-xkblayout XKBLayout\n"
@@ -895,6 +946,10 @@ winUseMsg(void)
     ErrorF("-xkboptions XKBOptions\n"
            "\tSet the options to use for XKB.  This defaults to not set.\n");
 
+    ErrorF("-xkbprecache\n"
+           "\tCompile the keymap of every known Windows keyboard layout into\n"
+           "\tthe compiled keymap cache and exit.\n");
+
     ErrorF("-xkbrules XKBRules\n"
            "\tSet the rules to use for XKB.  This defaults to xorg.\n");
 
@@ -943,6 +998,7 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
         XwinExtensionInit();
 
     winDebug("InitOutput\n");
+    winStartupMark("InitOutput");
 
     /* Validate command-line arguments */
     if (serverGeneration == 1 && !winValidateArgs()) {
@@ -950,6 +1006,11 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
                    "Exiting.\n");
     }
 
+    if (serverGeneration == 1 && g_fXkbPrecache) {
+        winPrecacheKeymaps();
+        exit(0);
+    }
+
     /* Check for duplicate invocation on same display number. */
     if (serverGeneration == 1 && !winCheckDisplayNumber()) {
         FatalError("InitOutput - Another X server is already running display-"
@@ -966,6 +1027,7 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
 
     /* Load preferences from XWinrc file */
     LoadPreferences();
+    winStartupMark("Configuration read");
 
     /* Setup global screen info parameters */
     pScreenInfo->imageByteOrder = IMAGE_BYTE_ORDER;
@@ -979,10 +1041,10 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
         pScreenInfo->formats[i] = g_PixmapFormats[i];
     }
 
-    /* Load pointers to DirectDraw functions */
-    winGetDDProcAddresses();
-
-    /* Detect supported engines */
+    /*
+     * Detect supported engines.  Direct3D 11 is probed in the background,
+     * and DirectDraw is only loaded by winSetEngine if it is wanted.
+     */
     winDetectSupportedEngines();
     /* Load libraries for taskbar grouping */
     winPropertyStoreInit();
@@ -1001,6 +1063,7 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
             FatalError("InitOutput - Couldn't add screen %d", i);
         }
     }
+    winStartupMark("Screens initialized");
 
   /*
      Unless full xinerama has been explicitly enabled, register all native screens with pseudoramiX
@@ -1080,6 +1143,7 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
           }
     }
 
+    winStartupMark("InitOutput done");
     winDebug("InitOutput - Returning.\n");
 }
 
@@ -59,7 +59,8 @@ used_wgl_ext_fns = {key: 1 for key in [
     "wglMakeContextCurrentARB",
     "wglChoosePixelFormatARB",
     "wglGetPixelFormatAttribivARB",
-    "wglGetPixelFormatAttribivARB"
+    "wglGetPixelFormatAttribivARB",
+    "wglCreateContextAttribsARB"
 ]}
 
 if __name__ == '__main__':
@@ -287,6 +288,7 @@ class MyOutputGenerator(OutputGenerator):
                  diagFile = sys.stdout):
         OutputGenerator.__init__(self, errFile, warnFile, diagFile)
         self.wrappers={}
+        self.direct={}
     def beginFile(self, genOpts):
         pass
     def endFile(self):
@@ -311,6 +313,7 @@ class MyOutputGenerator(OutputGenerator):
             return
 
         self.wrappers[name]=1
+        if self.OldVersion: self.direct[name]=1
         rettype=ParseCmdRettype(cmd)
 
         if staticwrappers: self.outFile.write("static ")
@@ -390,13 +393,27 @@ def genHeaders():
     # dispatch table entry to point to it's wrapper function
     # (assuming we were able to make one)
 
+    # the wrappers for functions exported by opengl32.dll only convert
+    # __stdcall to __cdecl, which are the same on x64, so unless we are counting
+    # or tracing calls point the dispatch table straight at the export
+
     if dispatchheader :
+        outFile.write("""
+#if defined(_WIN64) && (!defined(_DEBUG) || %d)
+#define DIRECT_ENTRY(name) name
+#else
+#define DIRECT_ENTRY(name) name##Wrapper
+#endif
+
+""" % (nodebugcallcounting))
         outFile.write( 'void glWinSetupDispatchTable(void)\n')
         outFile.write( '{\n')
         outFile.write( '  struct _glapi_table *disp = _glapi_get_dispatch();\n')
 
         for d in sorted(dispatch.keys()) :
-                if d in gen.wrappers :
+                if d in gen.direct :
+                        outFile.write('  SET_'+ d[len(prefix):] + '(disp, (void *)DIRECT_ENTRY(' + d + '));\n')
+                elif d in gen.wrappers :
                         outFile.write('  SET_'+ d[len(prefix):] + '(disp, (void *)' + d + 'Wrapper);\n')
 #enable this if you want to see this warning messages                else :
 #                        outFile.write('#pragma message("No wrapper for ' + d + ' !")\n')
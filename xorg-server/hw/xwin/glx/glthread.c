@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * GL threads for native contexts (-glthread)
+ *
+ * The commands of glXRender and glXRenderLarge requests have no reply, so
+ * once they have been checked they are copied to a queue and run by a
+ * thread owned by the context, which has the native context current while
+ * it works through them.  The server thread goes back to the other clients
+ * meanwhile.  Anything else which needs the native context, a query, a
+ * swap or making another context current, first waits for the queue to
+ * drain and takes the native context back, see glxWinContextSyncGL().
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#include <string.h>
+#include "glwindows.h"
+#include <glx/glheader.h>
+#include <glx/glxserver.h>
+#include <glx/glapi.h>
+#include <indirect.h>
+
+/* Queued bytes at which the server thread waits for the GL thread */
+#define GL_THREAD_MAX_QUEUED (8 * 1024 * 1024)
+
+typedef struct __GLXWinGLWork glxWinGLWork;
+
+struct __GLXWinGLWork {
+    glxWinGLWork *next;
+    int length;
+    Bool large;                 /* one glXRenderLarge command */
+    Bool swapped;
+    /* the commands follow */
+};
+
+struct __GLXWinGLThread {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        /* work queued, or release or quit set */
+    pthread_cond_t idle;        /* work done, or release done */
+
+    glxWinGLWork *head;
+    glxWinGLWork *tail;
+    size_t queued;              /* bytes of commands in the queue */
+
+    HDC hdc;                    /* what to make current for the next work */
+    HGLRC ctx;
+    Bool release;               /* make no context current once drained */
+    Bool quit;
+    DWORD error;                /* GetLastError() of a failed wglMakeCurrent */
+};
+
+static void *
+glxWinGLThreadMain(void *arg)
+{
+    glxWinGLThread *thread = arg;
+    Bool bound = FALSE;
+
+    /* the dispatch table may be per-thread */
+    _glapi_set_dispatch(glWinGetDispatchTable());
+
+    pthread_mutex_lock(&thread->mutex);
+    for (;;) {
+        glxWinGLWork *work;
+
+        while (!thread->head && !thread->release && !thread->quit)
+            pthread_cond_wait(&thread->cond, &thread->mutex);
+
+        work = thread->head;
+        if (!work) {
+            if (bound)
+                wglMakeCurrent(NULL, NULL);
+            bound = FALSE;
+            thread->release = FALSE;
+            pthread_cond_broadcast(&thread->idle);
+
+            if (thread->quit)
+                break;
+            continue;
+        }
+
+        thread->head = work->next;
+        if (!thread->head)
+            thread->tail = NULL;
+
+        if (!bound) {
+            HDC hdc = thread->hdc;
+            HGLRC ctx = thread->ctx;
+
+            pthread_mutex_unlock(&thread->mutex);
+            bound = wglMakeCurrent(hdc, ctx);
+            pthread_mutex_lock(&thread->mutex);
+            if (!bound)
+                thread->error = GetLastError();
+        }
+        pthread_mutex_unlock(&thread->mutex);
+
+        if (work->large)
+            __glXExecuteRenderLarge((GLbyte *) (work + 1), work->swapped);
+        else
+            __glXExecuteRender((GLbyte *) (work + 1), work->length,
+                               work->swapped);
+
+        pthread_mutex_lock(&thread->mutex);
+        thread->queued -= work->length;
+        free(work);
+        pthread_cond_broadcast(&thread->idle);
+    }
+    pthread_mutex_unlock(&thread->mutex);
+
+    return NULL;
+}
+
+glxWinGLThread *
+glxWinGLThreadCreate(void)
+{
+    glxWinGLThread *thread = calloc(1, sizeof(glxWinGLThread));
+
+    if (!thread)
+        return NULL;
+
+    pthread_mutex_init(&thread->mutex, NULL);
+    pthread_cond_init(&thread->cond, NULL);
+    pthread_cond_init(&thread->idle, NULL);
+
+    if (pthread_create(&thread->thread, NULL, glxWinGLThreadMain, thread) != 0) {
+        ErrorF("glxWinGLThreadCreate: pthread_create failed\n");
+        pthread_cond_destroy(&thread->idle);
+        pthread_cond_destroy(&thread->cond);
+        pthread_mutex_destroy(&thread->mutex);
+        free(thread);
+        return NULL;
+    }
+
+    return thread;
+}
+
+/*
+  Queue a copy of checked render commands, to be run with ctx current on hdc.
+  Returns FALSE if they couldn't be queued, and should be run here instead.
+*/
+Bool
+glxWinGLThreadQueue(glxWinGLThread * thread, HDC hdc, HGLRC ctx,
+                    const GLbyte * pc, int length, Bool large, Bool swapped)
+{
+    glxWinGLWork *work = malloc(sizeof(glxWinGLWork) + length);
+
+    if (!work)
+        return FALSE;
+
+    work->next = NULL;
+    work->length = length;
+    work->large = large;
+    work->swapped = swapped;
+    memcpy(work + 1, pc, length);
+
+    pthread_mutex_lock(&thread->mutex);
+
+    // don't let one client queue more than its driver keeps up with
+    while (thread->queued > GL_THREAD_MAX_QUEUED)
+        pthread_cond_wait(&thread->idle, &thread->mutex);
+
+    if (thread->tail)
+        thread->tail->next = work;
+    else
+        thread->head = work;
+    thread->tail = work;
+    thread->queued += length;
+    thread->hdc = hdc;
+    thread->ctx = ctx;
+    pthread_cond_signal(&thread->cond);
+    pthread_mutex_unlock(&thread->mutex);
+
+    return TRUE;
+}
+
+/*
+  Wait until everything queued has run, and the GL thread has made no
+  context current, so that the native context can be made current elsewhere
+*/
+void
+glxWinGLThreadRelease(glxWinGLThread * thread)
+{
+    DWORD error;
+
+    pthread_mutex_lock(&thread->mutex);
+    thread->release = TRUE;
+    pthread_cond_signal(&thread->cond);
+    while (thread->release)
+        pthread_cond_wait(&thread->idle, &thread->mutex);
+    error = thread->error;
+    thread->error = 0;
+    pthread_mutex_unlock(&thread->mutex);
+
+    if (error)
+        ErrorF("glxWinGLThread: wglMakeCurrent failed (%08x)\n",
+               (unsigned int) error);
+}
+
+void
+glxWinGLThreadDestroy(glxWinGLThread * thread)
+{
+    if (!thread)
+        return;
+
+    pthread_mutex_lock(&thread->mutex);
+    thread->quit = TRUE;
+    pthread_cond_signal(&thread->cond);
+    pthread_mutex_unlock(&thread->mutex);
+
+    pthread_join(thread->thread, NULL);
+    pthread_cond_destroy(&thread->idle);
+    pthread_cond_destroy(&thread->cond);
+    pthread_mutex_destroy(&thread->mutex);
+    free(thread);
+}
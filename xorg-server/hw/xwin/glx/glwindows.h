@@ -48,9 +48,15 @@ extern glxWinDebugSettingsRec glxWinDebugSettings;
 void glWinCallDelta(void);
 void glxWinPushNativeProvider(void);
 const GLubyte *glGetStringWrapperNonstatic(GLenum name);
+void glFlushWrapperNonstatic(void);
+void glWinTexImageFromPixmap(GLenum target, GLint internalFormat,
+                             GLsizei width, GLsizei height, int bitsPerPixel,
+                             int stride, const void *bits);
 void glAddSwapHintRectWINWrapperNonstatic(GLint x, GLint y, GLsizei width,
                                           GLsizei height);
+struct _glapi_table;
 void glWinSetupDispatchTable(void);
+struct _glapi_table *glWinGetDispatchTable(void);
 
 #ifdef _DEBUG
 #ifdef _MSC_VER
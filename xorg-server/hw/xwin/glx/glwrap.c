@@ -36,6 +36,7 @@
 #include <xwin-config.h>
 #endif
 
+#include <string.h>
 #include <X11/Xwindows.h>
 #define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
@@ -130,6 +131,33 @@ glWinResolveHelper(PROC * cache, const char *symbol)
 
 #include "generated_gl_wrappers.c"
 
+/*
+  The dispatch table only points at the wrappers above, which resolve their
+  entry point once for the whole process, so it is the same for every context.
+  Build it the first time a context is created and share it between them all.
+*/
+
+struct _glapi_table *
+glWinGetDispatchTable(void)
+{
+    static struct _glapi_table *dispatch = NULL;
+
+    if (!dispatch) {
+        struct _glapi_table *table =
+            calloc(sizeof(void *), (sizeof(struct _glapi_table) / sizeof(void *) + MAX_EXTENSION_FUNCS));
+
+        if (!table)
+            return NULL;
+
+        /* glWinSetupDispatchTable() fills in the current table */
+        _glapi_set_dispatch(table);
+        glWinSetupDispatchTable();
+        dispatch = table;
+    }
+
+    return dispatch;
+}
+
 /*
   Special non-static wrapper for glGetString for debug output
 */
@@ -140,6 +168,92 @@ glGetStringWrapperNonstatic(GLenum name)
     return glGetString(name);
 }
 
+/*
+  Special non-static wrapper for glFlush for loseCurrent
+*/
+
+void
+glFlushWrapperNonstatic(void)
+{
+    glFlush();
+}
+
+/*
+  Upload the bits of an X pixmap into the texture bound to target, for
+  glXBindTexImageEXT().  Rows are top-down, so the texture is y-inverted.
+
+  The client's unpack state is saved and restored around the upload.
+*/
+
+typedef void (__stdcall * PFNGLBINDBUFFERWIN) (GLenum target, GLuint buffer);
+
+void
+glWinTexImageFromPixmap(GLenum target, GLint internalFormat, GLsizei width,
+                        GLsizei height, int bitsPerPixel, int stride,
+                        const void *bits)
+{
+    static int hasPixelBufferObject = -1;
+    GLint unpackBuffer = 0;
+    GLint rowLength, skipRows, skipPixels, alignment, swapBytes, lsbFirst;
+    GLenum format, type;
+
+    if (bitsPerPixel == 32) {
+        format = GL_BGRA;
+        type = GL_UNSIGNED_BYTE;
+    }
+    else if (bitsPerPixel == 16) {
+        format = GL_RGB;
+        type = GL_UNSIGNED_SHORT_5_6_5;
+    }
+    else
+        return;
+
+    if (hasPixelBufferObject < 0) {
+        const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+
+        hasPixelBufferObject = extensions
+            && (strstr(extensions, "GL_ARB_pixel_buffer_object")
+                || strstr(extensions, "GL_EXT_pixel_buffer_object"));
+    }
+
+    if (hasPixelBufferObject)
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer);
+
+    if (unpackBuffer) {
+        RESOLVE(PFNGLBINDBUFFERWIN, "glBindBuffer");
+        proc(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH, &rowLength);
+    glGetIntegerv(GL_UNPACK_SKIP_ROWS, &skipRows);
+    glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &skipPixels);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glGetIntegerv(GL_UNPACK_SWAP_BYTES, &swapBytes);
+    glGetIntegerv(GL_UNPACK_LSB_FIRST, &lsbFirst);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / (bitsPerPixel / 8));
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_SWAP_BYTES, GL_FALSE);
+    glPixelStorei(GL_UNPACK_LSB_FIRST, GL_FALSE);
+
+    glTexImage2D(target, 0, internalFormat, width, height, 0, format, type,
+                 bits);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, skipRows);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, skipPixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    glPixelStorei(GL_UNPACK_SWAP_BYTES, swapBytes);
+    glPixelStorei(GL_UNPACK_LSB_FIRST, lsbFirst);
+
+    if (unpackBuffer) {
+        RESOLVE(PFNGLBINDBUFFERWIN, "glBindBuffer");
+        proc(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+    }
+}
+
 /*
   Special non-static wrapper for glAddSwapHintRectWIN for copySubBuffers
 */
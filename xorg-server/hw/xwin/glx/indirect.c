@@ -51,9 +51,6 @@
     before using it?
   - XGetImage() doesn't work on pixmaps; need to do more work to make the format and location
     of the native pixmap compatible
-  - implement GLX_EXT_texture_from_pixmap in terms of WGL_ARB_render_texture
-    (not quite straightforward as we will have to create a pbuffer and copy the pixmap texture
-     into it)
 */
 
 /*
@@ -105,6 +102,12 @@
 #define PFD_SUPPORT_COMPOSITION  0x00008000
 #endif
 
+/* fbConfig cache file */
+#define GLX_CACHE_MAGIC          0x43584756     /* "VGXC" */
+#define GLX_CACHE_VERSION        1
+#define GLX_CACHE_KEY_SIZE       1024
+#define GLX_CACHE_RECHECK_DELAY  10000  /* ms after startup */
+
 
 /* ---------------------------------------------------------------------- */
 /*
@@ -409,9 +412,29 @@ static void glxWinReleaseDC(HWND hwnd, HDC hdc, __GLXWinDrawable * draw);
 
 static void glxWinCreateConfigs(HDC dc, glxWinScreen * screen);
 static void glxWinCreateConfigsExt(HDC hdc, glxWinScreen * screen);
+static void glxWinEnumerateConfigs(HDC hdc, glxWinScreen * screen,
+                                   const char *wgl_extensions);
+static void glxWinConfigCacheKey(char *key, size_t size, HDC hdc,
+                                 glxWinScreen * screen,
+                                 const char *gl_extensions,
+                                 const char *wgl_extensions);
+static Bool glxWinConfigCacheLoad(const char *key, int screenNum,
+                                  glxWinScreen * screen);
+static void glxWinConfigCacheSave(const char *key, int screenNum,
+                                  glxWinScreen * screen);
+static void glxWinConfigCacheRecheck(const char *key, int screenNum,
+                                     glxWinScreen * screen,
+                                     const char *wgl_extensions);
 static int fbConfigToPixelFormat(__GLXconfig * mode,
                                  PIXELFORMATDESCRIPTOR * pfdret,
                                  int drawableTypeOverride);
+static void glxWinInitPixelFormatMap(glxWinScreen * screen);
+static void glxWinInitTextureFromPixmap(glxWinScreen * screen);
+static void glxWinUnbindDC(HDC hdc, HWND hwnd);
+static HGLRC glxWinCreateNativeContext(__GLXWinContext * gc, HDC hdc);
+static int glxWinChoosePixelFormatIndex(HDC hdc, __GLXconfig * mode,
+                                        int drawableTypeOverride,
+                                        glxWinScreen * winScreen);
 static int fbConfigToPixelFormatIndex(HDC hdc, __GLXconfig * mode,
                                       int drawableTypeOverride,
                                       glxWinScreen * winScreen);
@@ -449,10 +472,52 @@ GlxWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         return DefWindowProc(hwnd, uMsg, wParam, lParam);
 }
 
+/*
+  Make-current statistics, reported when the screen is destroyed
+*/
+static struct {
+    unsigned long makeCurrent;  /* glxWinContextMakeCurrent() calls */
+    unsigned long reused;       /* ... which found the native context already bound to the DCs */
+    unsigned long keptBound;    /* glxWinContextLoseCurrent() calls which left it bound */
+} glxWinMakeCurrentStats;
+
+/* The DC the current native context reads from, as wglGetCurrentDC() only tells the draw DC */
+static HDC glxWinCurrentReadDC;
+
+/*
+  Take the native context back from its GL thread (see glthread.c), once the
+  commands queued so far have run.  If the server still thinks the context
+  is current, make it current here again.  Returns TRUE if it was on the GL
+  thread.
+*/
+static Bool
+glxWinContextSyncGL(__GLXWinContext * gc)
+{
+    if (!gc || !gc->glThreadBound)
+        return FALSE;
+
+    glxWinGLThreadRelease(gc->glThread);
+    gc->glThreadBound = FALSE;
+
+    if (lastGLContext == &gc->base && gc->hDC) {
+        if (wglMakeCurrent(gc->hDC, gc->ctx))
+            glxWinCurrentReadDC = gc->hDC;
+        else
+            ErrorF("wglMakeCurrent error: %s\n", glxWinErrorMessage());
+    }
+
+    return TRUE;
+}
+
 static void
 glxWinScreenDestroy(__GLXscreen * screen)
 {
     GLWIN_DEBUG_MSG("glxWinScreenDestroy(%p)", screen);
+    LogMessage(X_INFO,
+               "AIGLX: %lu make-current calls, %lu reused the bound native context, "
+               "%lu lose-current calls kept it bound\n",
+               glxWinMakeCurrentStats.makeCurrent, glxWinMakeCurrentStats.reused,
+               glxWinMakeCurrentStats.keptBound);
     __glXScreenDestroy(screen);
     free(screen);
 }
@@ -514,6 +579,45 @@ glxLogExtensions(const char *prefix, const char *extensions)
     free(str);
 }
 
+/*
+ * Set a pixel format on a scratch DC, so a context can be created on it
+ * to query the renderer
+ */
+static int
+glxWinSetTestPixelFormat(HDC hdc)
+{
+    PIXELFORMATDESCRIPTOR pfd = {
+        sizeof(PIXELFORMATDESCRIPTOR),
+        1,
+        PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DEPTH_DONTCARE | PFD_DOUBLEBUFFER_DONTCARE | PFD_STEREO_DONTCARE,
+        PFD_TYPE_RGBA,
+        24,
+        0, 0, 0, 0, 0, 0,
+        0,
+        0,
+        0,
+        0, 0, 0, 0,
+        0,
+        0,
+        0,
+        PFD_MAIN_PLANE,
+        0,
+        0, 0, 0
+    };
+    int iPixelFormat = ChoosePixelFormat(hdc, &pfd);
+    if (iPixelFormat == 0) {
+        LogMessage(X_ERROR, "AIGLX: ChoosePixelFormat failed\n");
+        return 0;
+    }
+
+    if (!SetPixelFormat(hdc, iPixelFormat, NULL)) {
+        LogMessage(X_ERROR, "AIGLX: SetPixelFormat %d failed\n", iPixelFormat);
+        return 0;
+    }
+
+    return iPixelFormat;
+}
+
 /* This is called by GlxExtensionInit() asking the GLX provider if it can handle the screen... */
 static __GLXscreen *
 glxWinScreenProbe(ScreenPtr pScreen)
@@ -525,6 +629,8 @@ glxWinScreenProbe(ScreenPtr pScreen)
     HWND hwnd;
     HDC hdc;
     HGLRC hglrc;
+    char cacheKey[GLX_CACHE_KEY_SIZE];
+    Bool fCachedConfigs = FALSE;
 
     GLWIN_DEBUG_MSG("glxWinScreenProbe");
 
@@ -589,34 +695,9 @@ glxWinScreenProbe(ScreenPtr pScreen)
 
     // we must set a pixel format before we can create a context
     {
-        PIXELFORMATDESCRIPTOR pfd = {
-            sizeof(PIXELFORMATDESCRIPTOR),
-            1,
-            PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DEPTH_DONTCARE | PFD_DOUBLEBUFFER_DONTCARE | PFD_STEREO_DONTCARE,
-            PFD_TYPE_RGBA,
-            24,
-            0, 0, 0, 0, 0, 0,
-            0,
-            0,
-            0,
-            0, 0, 0, 0,
-            0,
-            0,
-            0,
-            PFD_MAIN_PLANE,
-            0,
-            0, 0, 0
-        };
-        int iPixelFormat = ChoosePixelFormat(hdc, &pfd);
-        if (iPixelFormat == 0) {
-            LogMessage(X_ERROR, "AIGLX: ChoosePixelFormat failed\n");
-            goto error;
-        }
-
-        if (!SetPixelFormat(hdc, iPixelFormat, NULL)) {
-            LogMessage(X_ERROR, "AIGLX: SetPixelFormat %d failed\n", iPixelFormat);
+        int iPixelFormat = glxWinSetTestPixelFormat(hdc);
+        if (iPixelFormat == 0)
             goto error;
-        }
         LogMessage(X_INFO, "AIGLX: Testing pixelFormatIndex %d\n", iPixelFormat);
     }
 
@@ -673,6 +754,7 @@ glxWinScreenProbe(ScreenPtr pScreen)
             { "WGL_ARB_make_current_read", "GLX_SGI_make_current_read", 1 },
             { "WGL_EXT_swap_control", "GLX_SGI_swap_control", 0 },
             { "WGL_EXT_swap_control", "GLX_MESA_swap_control", 0 },
+            { "WGL_EXT_swap_control_tear", "GLX_EXT_swap_control_tear", 0 },
             //      { "WGL_ARB_render_texture", "GLX_EXT_texture_from_pixmap", 0 },
             // Sufficiently different that it's not obvious if this can be done...
             { "WGL_ARB_pbuffer", "GLX_SGIX_pbuffer", 1 },
@@ -685,6 +767,7 @@ glxWinScreenProbe(ScreenPtr pScreen)
             { "WGL_ARB_create_context_robustness", "GLX_ARB_create_context_robustness", 0 },
             { "WGL_EXT_create_context_es2_profile", "GLX_EXT_create_context_es2_profile", 0 },
             { "WGL_ARB_framebuffer_sRGB", "GLX_ARB_framebuffer_sRGB", 0 },
+            { "WGL_ARB_create_context_no_error", "GLX_ARB_create_context_no_error", 0 },
         };
 
         //
@@ -697,6 +780,8 @@ glxWinScreenProbe(ScreenPtr pScreen)
         __glXEnableExtension(screen->base.glx_enable_bits, "GLX_EXT_import_context");
         __glXEnableExtension(screen->base.glx_enable_bits, "GLX_OML_swap_method");
         __glXEnableExtension(screen->base.glx_enable_bits, "GLX_SGIX_fbconfig");
+        __glXEnableExtension(screen->base.glx_enable_bits, "GLX_EXT_texture_from_pixmap");
+        __glXEnableExtension(screen->base.glx_enable_bits, "GLX_INTEL_swap_event");
 
         for (i = 0; i < sizeof(extensionMap)/sizeof(extensionMap[0]); i++) {
             if (strstr(wgl_extensions, extensionMap[i].wglext)) {
@@ -729,6 +814,9 @@ glxWinScreenProbe(ScreenPtr pScreen)
             screen->has_WGL_ARB_framebuffer_sRGB = TRUE;
         }
 
+        if (strstr(wgl_extensions, "WGL_ARB_create_context_no_error"))
+            screen->has_WGL_ARB_create_context_no_error = TRUE;
+
         screen->base.destroy = glxWinScreenDestroy;
         screen->base.createContext = glxWinCreateContext;
         screen->base.createDrawable = glxWinCreateDrawable;
@@ -736,22 +824,19 @@ glxWinScreenProbe(ScreenPtr pScreen)
         screen->base.pScreen = pScreen;
 
         // Creating the fbConfigs initializes screen->base.fbconfigs and screen->base.numFBConfigs
-        if (strstr(wgl_extensions, "WGL_ARB_pixel_format")) {
-            glxWinCreateConfigsExt(hdc, screen);
+        // Reuse the ones saved by an earlier start on the same adapter and driver, if any
+        glxWinConfigCacheKey(cacheKey, sizeof(cacheKey), hdc, screen,
+                             gl_extensions, wgl_extensions);
 
-            /*
-               Some graphics drivers appear to advertise WGL_ARB_pixel_format,
-               but it doesn't work usefully, so we have to be prepared for it
-               to fail and fall back to using DescribePixelFormat()
-             */
-            if (screen->base.numFBConfigs > 0) {
-                screen->has_WGL_ARB_pixel_format = TRUE;
-            }
+        fCachedConfigs = glxWinConfigCacheLoad(cacheKey, pScreen->myNum, screen);
+        if (fCachedConfigs) {
+            // Make sure the driver still agrees with the cache, without holding up startup
+            glxWinConfigCacheRecheck(cacheKey, pScreen->myNum, screen, wgl_extensions);
         }
-
-        if (screen->base.numFBConfigs <= 0) {
-            glxWinCreateConfigs(hdc, screen);
-            screen->has_WGL_ARB_pixel_format = FALSE;
+        else {
+            glxWinEnumerateConfigs(hdc, screen, wgl_extensions);
+            if (screen->base.numFBConfigs > 0)
+                glxWinConfigCacheSave(cacheKey, pScreen->myNum, screen);
         }
 
         /*
@@ -763,10 +848,16 @@ glxWinScreenProbe(ScreenPtr pScreen)
             goto error;
         }
 
+        glxWinInitPixelFormatMap(screen);
+        glxWinInitTextureFromPixmap(screen);
+
         /* These will be set by __glXScreenInit */
         screen->base.visuals = NULL;
         screen->base.numVisuals = 0;
 
+        /* The swap worker flushes before each SwapBuffers() itself */
+        screen->base.swapNeedsOnlyFlush = g_fAsyncSwap;
+
         __glXScreenInit(&screen->base, pScreen);
     }
 
@@ -924,6 +1015,12 @@ glxWinDestroyWindow(WindowPtr pWin)
 
     dixLookupResourceByType((pointer) &pGlxDraw, pWin->drawable.id, __glXDrawableRes, NullClient, DixUnknownAccess);
 
+    /* The swap worker or a GL thread may still be using the window's DC */
+    if (pGlxDraw) {
+      glxWinSwapWorkerFinish(pGlxDraw);
+      glxWinContextSyncGL(pGlxDraw->drawContext);
+    }
+
     if (pGlxDraw && pGlxDraw->drawContext)
     {
       if (pGlxDraw->drawContext->hwnd!=pWinPriv->hWnd)
@@ -934,6 +1031,8 @@ glxWinDestroyWindow(WindowPtr pWin)
     }
     if (pWinPriv->fWglUsed && pWinPriv->hWnd)
     {
+      /* A context may still be bound to its DC (see glxWinContextLoseCurrent()) */
+      glxWinUnbindDC(NULL, pWinPriv->hWnd);
       DestroyWindow(pWinPriv->hWnd);
       pWinPriv->hWnd=NULL;
       pWinPriv->fWglUsed=0;
@@ -951,6 +1050,57 @@ glxWinDestroyWindow(WindowPtr pWin)
  * Drawable functions
  */
 
+/*
+  A GL window which can't be seen still swaps at the display rate, or faster
+  without vsync, using GPU time and stalling the server in SwapBuffers().
+  While it is hidden, its owner is only allowed one swap every
+  g_iHiddenSwapDelay ms, and swaps of a minimized window are dropped.
+*/
+static CARD32
+glxWinHiddenSwapTimer(OsTimerPtr timer, CARD32 time, void *arg)
+{
+    __GLXWinDrawable *draw = arg;
+
+    if (draw->hiddenSwapClient && !draw->hiddenSwapClient->clientGone)
+        AttendClient(draw->hiddenSwapClient);
+    draw->hiddenSwapClient = NULL;
+
+    return 0;
+}
+
+/*
+  Throttle the owner of a hidden drawable.  Returns TRUE if the swap should
+  be dropped.
+*/
+static Bool
+glxWinThrottleHiddenSwap(__GLXWinDrawable * draw, ClientPtr client)
+{
+    WindowPtr pWin = (WindowPtr) draw->base.pDraw;
+    Bool minimized;
+
+    /* Only the owner can be ignored, see glxWinSwapWorkerQueue() */
+    if (g_iHiddenSwapDelay <= 0 || !client ||
+        clients[CLIENT_ID(draw->base.drawId)] != client)
+        return FALSE;
+
+    minimized = draw->drawContext->hwnd &&
+        IsIconic(GetAncestor(draw->drawContext->hwnd, GA_ROOT));
+
+    if (!minimized && pWin->viewable &&
+        pWin->visibility != VisibilityFullyObscured)
+        return FALSE;
+
+    draw->hiddenSwapTimer = TimerSet(draw->hiddenSwapTimer, 0, g_iHiddenSwapDelay,
+                                     glxWinHiddenSwapTimer, draw);
+    if (!draw->hiddenSwapTimer)
+        return FALSE;
+
+    draw->hiddenSwapClient = client;
+    IgnoreClient(client);
+
+    return minimized;
+}
+
 static GLboolean
 glxWinDrawableSwapBuffers(ClientPtr client, __GLXdrawable * base)
 {
@@ -967,6 +1117,19 @@ glxWinDrawableSwapBuffers(ClientPtr client, __GLXdrawable * base)
         ("glxWinSwapBuffers on drawable %p, last context %p (native ctx %p)",
          base, draw->drawContext, draw->drawContext->ctx);
 
+    /* The rendering queued on the context's GL thread must come first */
+    glxWinContextSyncGL(draw->drawContext);
+
+    if (base->type == GLX_DRAWABLE_WINDOW &&
+        glxWinThrottleHiddenSwap(draw, client))
+        return GL_TRUE;
+
+    g_winStats.llSwaps++;
+
+    if (g_fAsyncSwap && base->type == GLX_DRAWABLE_WINDOW &&
+        glxWinSwapWorkerQueue(draw, client, draw->drawContext->hDC))
+        return GL_TRUE;
+
     ret = SwapBuffers(draw->drawContext->hDC);
 
     if (!ret) {
@@ -974,6 +1137,9 @@ glxWinDrawableSwapBuffers(ClientPtr client, __GLXdrawable * base)
         return GL_FALSE;
     }
 
+    if (client)
+        __glXsendSwapEvent(base, GLX_BLIT_COMPLETE_INTEL, 0, 0, 0);
+
     return GL_TRUE;
 }
 
@@ -990,12 +1156,29 @@ glxWinDrawableDestroy(__GLXdrawable * base)
 {
     __GLXWinDrawable *glxPriv = (__GLXWinDrawable *) base;
 
+    glxWinSwapWorkerDestroy(glxPriv);
+    glxWinContextSyncGL(glxPriv->drawContext);
+
+    if (glxPriv->hiddenSwapTimer) {
+        TimerFree(glxPriv->hiddenSwapTimer);
+        glxWinHiddenSwapTimer(NULL, 0, glxPriv);
+    }
+
+    if (glxPriv->hPbufferDC) {
+        glxWinUnbindDC(glxPriv->hPbufferDC, NULL);
+        if (!wglReleasePbufferDCARBWrapper(glxPriv->hPbuffer, glxPriv->hPbufferDC)) {
+            ErrorF("wglReleasePbufferDCARB error: %s\n", glxWinErrorMessage());
+        }
+    }
+
     if (glxPriv->hPbuffer)
         if (!wglDestroyPbufferARBWrapper(glxPriv->hPbuffer)) {
             ErrorF("wglDestroyPbufferARB failed: %s\n", glxWinErrorMessage());
         }
 
     if (glxPriv->dibDC) {
+        glxWinUnbindDC(glxPriv->dibDC, NULL);
+
         // restore the default DIB
         SelectObject(glxPriv->dibDC, glxPriv->hOldDIB);
 
@@ -1102,8 +1285,8 @@ glxWinDeferredCreateDrawable(__GLXWinDrawable *draw, __GLXWinContext * gc)
             winScreen = (glxWinScreen *) screen;
 
             pixelFormat =
-                fbConfigToPixelFormatIndex(screenDC, config,
-                                           GLX_PBUFFER_BIT, winScreen);
+                glxWinChoosePixelFormatIndex(screenDC, config,
+                                             GLX_PBUFFER_BIT, winScreen);
             if (pixelFormat == 0) {
                 return;
             }
@@ -1193,6 +1376,7 @@ glxWinDeferredCreateDrawable(__GLXWinDrawable *draw, __GLXWinContext * gc)
             // need some jiggery pokery to point the underlying X Drawable's bitmap at the same set of bits
             // so that they can be read with XGetImage as well as glReadPixels, assuming the formats are
             // even compatible ...
+            fbBudgetTouch((PixmapPtr) draw->base.pDraw);
             draw->pOldBits = ((PixmapPtr) draw->base.pDraw)->devPrivate.ptr;
             ((PixmapPtr) draw->base.pDraw)->devPrivate.ptr = pBits;
 
@@ -1232,13 +1416,55 @@ glxWinDeferredCreateDrawable(__GLXWinDrawable *draw, __GLXWinContext * gc)
  * Texture functions
  */
 
+/*
+  X pixmaps live in system memory, where fb renders them, so binding one
+  to a texture is a single upload of its bits into whatever native context
+  is current.  The GLX pixmap never has to be made current, so it never
+  gets the DIB and the unaccelerated pixel format used to render into it.
+*/
+
 static
     int
 glxWinBindTexImage(__GLXcontext * baseContext,
                    int buffer, __GLXdrawable * pixmap)
 {
-    ErrorF("glxWinBindTexImage: not implemented\n");
-    return FALSE;
+    PixmapPtr pPixmap = (PixmapPtr) pixmap->pDraw;
+    __GLXconfig *config = pixmap->config;
+    GLint internalFormat;
+
+    if (pPixmap->drawable.type == DRAWABLE_PIXMAP)
+        fbBudgetTouch(pPixmap);
+    if (pPixmap->drawable.type != DRAWABLE_PIXMAP || pPixmap->devPrivate.ptr == NULL)
+        return __glXError(GLXBadPixmap);
+
+    if (pPixmap->drawable.bitsPerPixel != 32 && pPixmap->drawable.bitsPerPixel != 16)
+        return BadMatch;
+
+    switch (pixmap->format) {
+    case GLX_TEXTURE_FORMAT_RGB_EXT:
+        internalFormat = GL_RGB;
+        break;
+    case GLX_TEXTURE_FORMAT_RGBA_EXT:
+        internalFormat = GL_RGBA;
+        break;
+    default:
+        internalFormat = config->bindToTextureRgba ? GL_RGBA : GL_RGB;
+        break;
+    }
+
+    GLWIN_DEBUG_MSG("glxWinBindTexImage: pixmap %p %dx%d bpp %d, target %x",
+                    pPixmap, pPixmap->drawable.width, pPixmap->drawable.height,
+                    pPixmap->drawable.bitsPerPixel, pixmap->target);
+
+    // in case GL has rendered into the pixmap through its DIB
+    GdiFlush();
+
+    glWinTexImageFromPixmap(pixmap->target, internalFormat,
+                            pPixmap->drawable.width, pPixmap->drawable.height,
+                            pPixmap->drawable.bitsPerPixel, pPixmap->devKind,
+                            pPixmap->devPrivate.ptr);
+
+    return Success;
 }
 
 static
@@ -1246,8 +1472,30 @@ static
 glxWinReleaseTexImage(__GLXcontext * baseContext,
                       int buffer, __GLXdrawable * pixmap)
 {
-    ErrorF(" glxWinReleaseTexImage: not implemented\n");
-    return FALSE;
+    // the texture holds a copy, so there is nothing to release
+    return Success;
+}
+
+/*
+  Any 8 bits per channel RGB config which can be used with pixmaps can
+  have pixmaps bound as textures by glxWinBindTexImage()
+*/
+static void
+glxWinInitTextureFromPixmap(glxWinScreen * screen)
+{
+    __GLXconfig *c;
+
+    for (c = screen->base.fbconfigs; c != NULL; c = c->next) {
+        if (!(c->drawableType & GLX_PIXMAP_BIT) || !(c->renderType & GLX_RGBA_BIT)
+            || c->redBits != 8 || c->greenBits != 8 || c->blueBits != 8)
+            continue;
+
+        c->bindToTextureRgb = GL_TRUE;
+        c->bindToTextureRgba = (c->alphaBits == 8) ? GL_TRUE : GL_FALSE;
+        c->bindToMipmapTexture = GL_FALSE;
+        c->bindToTextureTargets = GLX_TEXTURE_2D_BIT_EXT | GLX_TEXTURE_RECTANGLE_BIT_EXT;
+        c->yInverted = GL_TRUE;
+    }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -1321,8 +1569,8 @@ glxWinSetPixelFormat(__GLXWinContext * gc, HDC hdc, int bppOverride,
 
     if (winScreen->has_WGL_ARB_pixel_format) {
         int pixelFormat =
-            fbConfigToPixelFormatIndex(hdc, config,
-                                       drawableTypeOverride, winScreen);
+            glxWinChoosePixelFormatIndex(hdc, config,
+                                         drawableTypeOverride, winScreen);
         if (pixelFormat != 0) {
             GLWIN_DEBUG_MSG("wglChoosePixelFormat: chose pixelFormatIndex %d",
                             pixelFormat);
@@ -1334,6 +1582,7 @@ glxWinSetPixelFormat(__GLXWinContext * gc, HDC hdc, int bppOverride,
                 ErrorF("SetPixelFormat error: %s\n", glxWinErrorMessage());
                 return FALSE;
             }
+            return TRUE;
         }
     }
 
@@ -1384,6 +1633,27 @@ glxWinSetPixelFormat(__GLXWinContext * gc, HDC hdc, int bppOverride,
     return TRUE;
 }
 
+/*
+  A no-error context skips the driver's error checking, for applications
+  known not to make errors
+*/
+static HGLRC
+glxWinCreateNativeContext(__GLXWinContext * gc, HDC hdc)
+{
+    if (gc->noError) {
+        const int attribs[] = { WGL_CONTEXT_OPENGL_NO_ERROR_ARB, TRUE, 0 };
+        HGLRC hglrc = wglCreateContextAttribsARBWrapper(hdc, NULL, attribs);
+
+        if (hglrc)
+            return hglrc;
+
+        ErrorF("wglCreateContextAttribsARB (no error) failed: %s\n",
+               glxWinErrorMessage());
+    }
+
+    return wglCreateContext(hdc);
+}
+
 static HDC
 glxWinMakeDC(__GLXWinContext *gc, __GLXWinDrawable *draw, HWND *hwnd)
 {
@@ -1424,7 +1694,7 @@ glxWinMakeDC(__GLXWinContext *gc, __GLXWinDrawable *draw, HWND *hwnd)
 
             glxWinSetPixelFormat(gc, hdc, 0, GLX_WINDOW_BIT);
             pWinPriv->OpenGlWindow=TRUE; /* Identify it as an opengl window, also used to check if the pixel format is already set */
-            gc->ctx = wglCreateContext(hdc);
+            gc->ctx = glxWinCreateNativeContext(gc, hdc);
         }
 
 #ifdef _DEBUG
@@ -1444,12 +1714,17 @@ glxWinMakeDC(__GLXWinContext *gc, __GLXWinDrawable *draw, HWND *hwnd)
 
     case GLX_DRAWABLE_PBUFFER:
     {
-        hdc = wglGetPbufferDCARBWrapper(draw->hPbuffer);
+        // like the windows' CS_OWNDC DCs, the pbuffer DC lives as long as the pbuffer
+        if (draw->hPbufferDC == NULL) {
+            draw->hPbufferDC = wglGetPbufferDCARBWrapper(draw->hPbuffer);
 
-        if (hdc == NULL)
-            ErrorF("GetDC (pbuffer) error: %s\n", glxWinErrorMessage());
+            if (draw->hPbufferDC == NULL)
+                ErrorF("GetDC (pbuffer) error: %s\n", glxWinErrorMessage());
+        }
+        hdc = draw->hPbufferDC;
 
-        gc->ctx = wglCreateContext(hdc);
+        if (!gc->ctx)
+            gc->ctx = glxWinCreateNativeContext(gc, hdc);
     }
         break;
 
@@ -1490,9 +1765,7 @@ glxWinReleaseDC(HWND hwnd, HDC hdc, __GLXWinDrawable * draw)
 
     case GLX_DRAWABLE_PBUFFER:
     {
-        if (!wglReleasePbufferDCARBWrapper(draw->hPbuffer, hdc)) {
-            ErrorF("wglReleasePbufferDCARB error: %s\n", glxWinErrorMessage());
-        }
+        // don't release DC, it is released when the pbuffer is destroyed
     }
         break;
 
@@ -1515,6 +1788,27 @@ glxWinReleaseDC(HWND hwnd, HDC hdc, __GLXWinDrawable * draw)
     }
 }
 
+/*
+  Make sure no native context is left bound to a DC (or a window's DC)
+  we are about to free
+*/
+static void
+glxWinUnbindDC(HDC hdc, HWND hwnd)
+{
+    HDC hdcCurrent;
+
+    if (!wglGetCurrentContext())
+        return;
+
+    hdcCurrent = wglGetCurrentDC();
+    if ((hdc && (hdcCurrent == hdc || glxWinCurrentReadDC == hdc))
+        || (hwnd && (WindowFromDC(hdcCurrent) == hwnd
+                     || WindowFromDC(glxWinCurrentReadDC) == hwnd))) {
+        wglMakeCurrent(NULL, NULL);
+        glxWinCurrentReadDC = NULL;
+    }
+}
+
 static void
 glxWinDeferredCreateContext(__GLXWinContext * gc, __GLXWinDrawable * draw)
 {
@@ -1557,6 +1851,21 @@ glxWinDeferredCreateContext(__GLXWinContext * gc, __GLXWinDrawable * draw)
  * Context functions
  */
 
+/*
+  Check if the native context is still bound to these DCs, as
+  glxWinContextLoseCurrent() may have left it
+*/
+static Bool
+glxWinIsBound(__GLXWinContext * gc, HDC hdc, HDC hreaddc)
+{
+    if (hdc == NULL || wglGetCurrentContext() != gc->ctx
+        || wglGetCurrentDC() != hdc || glxWinCurrentReadDC != hreaddc)
+        return FALSE;
+
+    glxWinMakeCurrentStats.reused++;
+    return TRUE;
+}
+
 /* Context manipulation routines should return TRUE on success, FALSE on failure */
 static int
 glxWinContextMakeCurrent(__GLXcontext * base)
@@ -1571,6 +1880,10 @@ glxWinContextMakeCurrent(__GLXcontext * base)
     glWinCallDelta();
 #endif
 
+    glxWinMakeCurrentStats.makeCurrent++;
+
+    glxWinContextSyncGL(gc);
+
     /* Keep a note of the last active context in the drawable */
     drawPriv = (__GLXWinDrawable *)gc->base.drawPriv;
     drawPriv->drawContext = gc;
@@ -1607,11 +1920,15 @@ glxWinContextMakeCurrent(__GLXcontext * base)
             return FALSE;
         }
 
+        if (glxWinIsBound(gc, gc->hDC, gc->hreadDC))
+            return TRUE;
+
         ret = wglMakeContextCurrentARBWrapper(gc->hDC, gc->hreadDC, gc->ctx);
         if (!ret) {
             ErrorF("wglMakeContextCurrentARBWrapper error: %s\n",
                    glxWinErrorMessage());
         }
+        glxWinCurrentReadDC = ret ? gc->hreadDC : NULL;
     }
     else {
         /* Otherwise, just use wglMakeCurrent */
@@ -1619,6 +1936,10 @@ glxWinContextMakeCurrent(__GLXcontext * base)
             /* It probably has been release by loseCurrent, so create it again */
             gc->hDC = glxWinMakeDC(gc, drawPriv, &gc->hwnd);
         }
+
+        if (glxWinIsBound(gc, gc->hDC, gc->hDC))
+            return TRUE;
+
         ret = wglMakeCurrent(gc->hDC, gc->ctx);
         if (!ret) {
             DWORD ErrorCode=GetLastError();
@@ -1628,6 +1949,7 @@ glxWinContextMakeCurrent(__GLXcontext * base)
                 ret=TRUE;
             }
         }
+        glxWinCurrentReadDC = ret ? gc->hDC : NULL;
     }
 
     // apparently make current could fail if the context is current in a different thread,
@@ -1653,12 +1975,27 @@ glxWinContextLoseCurrent(__GLXcontext * base)
      /* Clear the last active context in the drawable */
     if (drawPriv) drawPriv->drawContext = NULL;
 
+    glxWinContextSyncGL(gc);
+
     if (wglGetCurrentContext()==gc->ctx)
     {
       /* Only do this when we are sure we are currently the active, otherwise we are deactivating the wrong one (this is happening!!!) */
-      ret = wglMakeCurrent(NULL, NULL);
-      if (!ret)
-        ErrorF("glxWinContextLoseCurrent error: %s\n", glxWinErrorMessage());
+      if (drawPriv && drawPriv->base.type == GLX_DRAWABLE_WINDOW
+          && glxWinCurrentReadDC == gc->hDC)
+      {
+        /* A window's DC lives as long as the window, so leave the native context
+           bound to it in case it is made current again next; just flush what
+           has been rendered */
+        glFlushWrapperNonstatic();
+        glxWinMakeCurrentStats.keptBound++;
+      }
+      else
+      {
+        ret = wglMakeCurrent(NULL, NULL);
+        if (!ret)
+          ErrorF("glxWinContextLoseCurrent error: %s\n", glxWinErrorMessage());
+        glxWinCurrentReadDC = NULL;
+      }
     }
     else
     {
@@ -1666,7 +2003,11 @@ glxWinContextLoseCurrent(__GLXcontext * base)
     }
 
     base->currentClient=NULL;  /* It looks like glx is not doing this */
-    _glapi_set_dispatch(NULL);
+
+    /* Every context has the same dispatch table, which other contexts' GL
+       threads may be using, so leave it set with -glthread */
+    if (!g_fGLThread)
+        _glapi_set_dispatch(NULL);
 
     return ret;
 }
@@ -1700,11 +2041,15 @@ glxWinContextDestroy(__GLXcontext * base)
         GLWIN_DEBUG_MSG("GLXcontext %p destroyed (native ctx %p)", base,
                         gc->ctx);
 
+        glxWinContextSyncGL(gc);
+        glxWinGLThreadDestroy(gc->glThread);
+
         if (gc->ctx) {
             BOOL ret;
             /* It's bad style to delete the context while it's still current */
             if (wglGetCurrentContext() == gc->ctx) {
                 wglMakeCurrent(NULL, NULL);
+                glxWinCurrentReadDC = NULL;
             }
 
             ret = wglDeleteContext(gc->ctx);
@@ -1721,10 +2066,57 @@ glxWinContextDestroy(__GLXcontext * base)
         /* Clear the last active context in the drawable */
         if (drawPriv) drawPriv->drawContext = NULL;
 
-        free(gc->Dispatch);
         free(gc);
-        _glapi_set_dispatch(NULL);
+        if (!g_fGLThread)
+            _glapi_set_dispatch(NULL);
+    }
+}
+
+/*
+  With -glthread, anything but rendering needs the native context back here
+*/
+static Bool
+glxWinContextWait(__GLXcontext * base, __GLXclientState * cl, int *error)
+{
+    xGLXSingleReq *req = (xGLXSingleReq *) cl->client->requestBuffer;
+
+    if (req->glxCode != X_GLXRender && req->glxCode != X_GLXRenderLarge)
+        glxWinContextSyncGL((__GLXWinContext *) base);
+
+    return FALSE;
+}
+
+/*
+  With -glthread, hand checked render commands to the context's GL thread.
+  The native context moves there from the server thread the first time.
+*/
+static Bool
+glxWinContextQueueRender(__GLXcontext * base, const GLbyte * pc, int length,
+                         Bool large, Bool swapped)
+{
+    __GLXWinContext *gc = (__GLXWinContext *) base;
+
+    if (!gc->glThreadBound) {
+        /* It must be current here, reading from the DC it draws to */
+        if (wglGetCurrentContext() != gc->ctx || glxWinCurrentReadDC != gc->hDC)
+            return FALSE;
+
+        if (!gc->glThread)
+            gc->glThread = glxWinGLThreadCreate();
+        if (!gc->glThread)
+            return FALSE;
+
+        wglMakeCurrent(NULL, NULL);
+        glxWinCurrentReadDC = NULL;
+        gc->glThreadBound = TRUE;
     }
+
+    if (glxWinGLThreadQueue(gc->glThread, gc->hDC, gc->ctx, pc, length,
+                            large, swapped))
+        return TRUE;
+
+    glxWinContextSyncGL(gc);
+    return FALSE;
 }
 
 static __GLXcontext *
@@ -1734,18 +2126,56 @@ glxWinCreateContext(__GLXscreen * screen,
 {
     __GLXWinContext *context;
     __GLXWinContext *shareContext = (__GLXWinContext *) baseShareContext;
+    glxWinScreen *winScreen = (glxWinScreen *) screen;
+    Bool noError = FALSE;
+    uint32_t flags = 0;
+    unsigned i;
+
+    for (i = 0; i < num_attribs; i++) {
+        switch (attribs[2 * i]) {
+        case GLX_CONTEXT_OPENGL_NO_ERROR_ARB:
+            noError = attribs[2 * i + 1] ? TRUE : FALSE;
+            break;
+        case GLX_CONTEXT_FLAGS_ARB:
+            flags = attribs[2 * i + 1];
+            break;
+        }
+    }
+
+    if (noError) {
+        /* The GLX_ARB_create_context_no_error spec says BadMatch is generated
+           for a debug or robust no-error context, or if it would share with
+           a context which isn't no-error (and vice versa) */
+        if (!winScreen->has_WGL_ARB_create_context_no_error)
+            noError = FALSE;
+        else if (flags & (GLX_CONTEXT_DEBUG_BIT_ARB | GLX_CONTEXT_ROBUST_ACCESS_BIT_ARB)) {
+            *error = BadMatch;
+            return NULL;
+        }
+    }
+
+    if (shareContext && shareContext->noError != noError) {
+        *error = BadMatch;
+        return NULL;
+    }
 
     context = calloc(1, sizeof(*context));
 
     if (!context)
         return NULL;
 
+    context->noError = noError;
+
     context->base.destroy = glxWinContextDestroy;
     context->base.makeCurrent = glxWinContextMakeCurrent;
     context->base.loseCurrent = glxWinContextLoseCurrent;
     context->base.copy = glxWinContextCopy;
     context->base.bindTexImage = glxWinBindTexImage;
     context->base.releaseTexImage = glxWinReleaseTexImage;
+    if (g_fGLThread) {
+        context->base.wait = glxWinContextWait;
+        context->base.queueRender = glxWinContextQueueRender;
+    }
     context->base.config = modes;
     context->base.pGlxScreen = screen;
 
@@ -1753,11 +2183,14 @@ glxWinCreateContext(__GLXscreen * screen,
     //context->ctx = NULL; already done by calloc
     context->shareContext = shareContext;
 
-    context->Dispatch=calloc(sizeof(void*), (sizeof(struct _glapi_table) / sizeof(void *) + MAX_EXTENSION_FUNCS));
+    context->Dispatch = glWinGetDispatchTable();
+    if (!context->Dispatch) {
+        free(context);
+        *error = BadAlloc;
+        return NULL;
+    }
     _glapi_set_dispatch(context->Dispatch);
 
-    glWinSetupDispatchTable();
-
     GLWIN_DEBUG_MSG("GLXcontext %p created", context);
 
     return &(context->base);
@@ -1859,6 +2292,72 @@ fbConfigToPixelFormat(__GLXconfig * mode, PIXELFORMATDESCRIPTOR * pfdret,
     return 0;
 }
 
+static int
+glxWinDrawableTypeSlot(int drawableType)
+{
+    switch (drawableType) {
+    case GLX_WINDOW_BIT:
+        return 0;
+    case GLX_PIXMAP_BIT:
+        return 1;
+    case GLX_PBUFFER_BIT:
+        return 2;
+    }
+
+    return -1;
+}
+
+/*
+  A config's own pixel format supports every drawable type the config
+  supports, so those are known as soon as the configs are made.  Formats
+  for the other drawable types (see glxWinSetPixelFormat()) are found with
+  wglChoosePixelFormatARB() the first time they are needed, and remembered.
+*/
+static void
+glxWinInitPixelFormatMap(glxWinScreen * screen)
+{
+    __GLXconfig *c;
+    static const int drawableTypes[] =
+        { GLX_WINDOW_BIT, GLX_PIXMAP_BIT, GLX_PBUFFER_BIT };
+
+    for (c = screen->base.fbconfigs; c != NULL; c = c->next) {
+        GLXWinConfig *winConfig = (GLXWinConfig *) c;
+        int i;
+
+        for (i = 0; i < ARRAY_SIZE(drawableTypes); i++) {
+            if (c->drawableType & drawableTypes[i])
+                winConfig->drawablePixelFormat[i] = winConfig->pixelFormatIndex;
+            else
+                winConfig->drawablePixelFormat[i] = 0;
+        }
+    }
+}
+
+static int
+glxWinChoosePixelFormatIndex(HDC hdc, __GLXconfig * mode,
+                             int drawableTypeOverride, glxWinScreen * winScreen)
+{
+    GLXWinConfig *winConfig = (GLXWinConfig *) mode;
+    int slot = glxWinDrawableTypeSlot(drawableTypeOverride);
+    int pixelFormat;
+
+    if (slot < 0)
+        return fbConfigToPixelFormatIndex(hdc, mode, drawableTypeOverride,
+                                          winScreen);
+
+    pixelFormat = winConfig->drawablePixelFormat[slot];
+    if (pixelFormat > 0)
+        return pixelFormat;
+    if (pixelFormat < 0)
+        return 0;
+
+    pixelFormat = fbConfigToPixelFormatIndex(hdc, mode, drawableTypeOverride,
+                                             winScreen);
+    winConfig->drawablePixelFormat[slot] = pixelFormat ? pixelFormat : -1;
+
+    return pixelFormat;
+}
+
 #define SET_ATTR_VALUE(attr, value) { attribList[i++] = attr; attribList[i++] = value; assert(i < ARRAY_SIZE(attribList)); }
 
 static int
@@ -2624,3 +3123,460 @@ glxWinCreateConfigsExt(HDC hdc, glxWinScreen * screen)
     screen->base.numFBConfigs = n;
     screen->base.fbconfigs = first ? &(first->base) : NULL;
 }
+
+//
+// Create the GLXconfigs for the pixel formats of hdc
+//
+static void
+glxWinEnumerateConfigs(HDC hdc, glxWinScreen * screen,
+                       const char *wgl_extensions)
+{
+    if (strstr(wgl_extensions, "WGL_ARB_pixel_format")) {
+        glxWinCreateConfigsExt(hdc, screen);
+
+        /*
+           Some graphics drivers appear to advertise WGL_ARB_pixel_format,
+           but it doesn't work usefully, so we have to be prepared for it
+           to fail and fall back to using DescribePixelFormat()
+         */
+        if (screen->base.numFBConfigs > 0) {
+            screen->has_WGL_ARB_pixel_format = TRUE;
+        }
+    }
+
+    if (screen->base.numFBConfigs <= 0) {
+        glxWinCreateConfigs(hdc, screen);
+        screen->has_WGL_ARB_pixel_format = FALSE;
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/*
+ * fbConfig cache
+ *
+ * Enumerating the pixel formats can take hundreds of driver calls, so the
+ * fbConfigs made from them are saved to a file in the temporary directory,
+ * and reused at the next start which finds the same adapter, driver and
+ * WGL extensions.  When the cache is used, a background thread enumerates
+ * the pixel formats again after startup, and rewrites the file for the
+ * next start if the driver now reports something different.
+ */
+
+#define CACHE_FIELD(f) offsetof(GLXWinConfig, base.f)
+
+// The fields saved for each config, in file order (all 32 bit)
+static const size_t glxWinCacheFields[] = {
+    CACHE_FIELD(doubleBufferMode),
+    CACHE_FIELD(stereoMode),
+    CACHE_FIELD(redBits),
+    CACHE_FIELD(greenBits),
+    CACHE_FIELD(blueBits),
+    CACHE_FIELD(alphaBits),
+    CACHE_FIELD(redMask),
+    CACHE_FIELD(greenMask),
+    CACHE_FIELD(blueMask),
+    CACHE_FIELD(alphaMask),
+    CACHE_FIELD(rgbBits),
+    CACHE_FIELD(indexBits),
+    CACHE_FIELD(accumRedBits),
+    CACHE_FIELD(accumGreenBits),
+    CACHE_FIELD(accumBlueBits),
+    CACHE_FIELD(accumAlphaBits),
+    CACHE_FIELD(depthBits),
+    CACHE_FIELD(stencilBits),
+    CACHE_FIELD(numAuxBuffers),
+    CACHE_FIELD(level),
+    CACHE_FIELD(visualType),
+    CACHE_FIELD(visualRating),
+    CACHE_FIELD(transparentPixel),
+    CACHE_FIELD(transparentRed),
+    CACHE_FIELD(transparentGreen),
+    CACHE_FIELD(transparentBlue),
+    CACHE_FIELD(transparentAlpha),
+    CACHE_FIELD(transparentIndex),
+    CACHE_FIELD(sampleBuffers),
+    CACHE_FIELD(samples),
+    CACHE_FIELD(drawableType),
+    CACHE_FIELD(renderType),
+    CACHE_FIELD(maxPbufferWidth),
+    CACHE_FIELD(maxPbufferHeight),
+    CACHE_FIELD(maxPbufferPixels),
+    CACHE_FIELD(optimalPbufferWidth),
+    CACHE_FIELD(optimalPbufferHeight),
+    CACHE_FIELD(visualSelectGroup),
+    CACHE_FIELD(swapMethod),
+    CACHE_FIELD(bindToTextureRgb),
+    CACHE_FIELD(bindToTextureRgba),
+    CACHE_FIELD(bindToMipmapTexture),
+    CACHE_FIELD(bindToTextureTargets),
+    CACHE_FIELD(yInverted),
+    CACHE_FIELD(sRGBCapable),
+    offsetof(GLXWinConfig, pixelFormatIndex),
+};
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int numFields;
+    unsigned int keyLength;
+    unsigned int numConfigs;
+    unsigned int hasPixelFormat;        /* has_WGL_ARB_pixel_format */
+} glxWinCacheHeader;
+
+typedef struct {
+    char key[GLX_CACHE_KEY_SIZE];
+    int screenNum;
+    char *wgl_extensions;
+    glxWinScreen flags;         /* has_WGL_* of the probed screen */
+    unsigned int numConfigs;
+    int *records;               /* the configs as loaded from the cache */
+} glxWinCacheRecheck;
+
+static unsigned int
+glxWinCacheHash(unsigned int hash, const char *str)
+{
+    /* FNV-1a */
+    if (str) {
+        while (*str)
+            hash = (hash ^ (unsigned char) *str++) * 16777619U;
+    }
+
+    return hash;
+}
+
+/*
+ * The cache key identifies the adapter, its driver and everything which
+ * changes the configs we make from its pixel formats.  The adapter LUID is
+ * assigned afresh at each boot, so the PCI device ID is used instead.
+ */
+static void
+glxWinConfigCacheKey(char *key, size_t size, HDC hdc, glxWinScreen * screen,
+                     const char *gl_extensions, const char *wgl_extensions)
+{
+    DISPLAY_DEVICEA dd;
+    const char *deviceID = "";
+    DWORD i;
+    int numFormats;
+
+    memset(&dd, 0, sizeof(dd));
+    dd.cb = sizeof(dd);
+    for (i = 0; EnumDisplayDevicesA(NULL, i, &dd, 0); i++) {
+        if (dd.StateFlags & DISPLAY_DEVICE_PRIMARY_DEVICE) {
+            deviceID = dd.DeviceID;
+            break;
+        }
+    }
+
+    numFormats = DescribePixelFormat(hdc, 1, sizeof(PIXELFORMATDESCRIPTOR), NULL);
+
+    snprintf(key, size, "%s|%s|%s|%s|%d|%d%d%d%d|%08x",
+             deviceID,
+             (const char *) glGetStringWrapperNonstatic(GL_VENDOR),
+             (const char *) glGetStringWrapperNonstatic(GL_RENDERER),
+             (const char *) glGetStringWrapperNonstatic(GL_VERSION),
+             numFormats,
+             screen->has_WGL_ARB_multisample, screen->has_WGL_ARB_pbuffer,
+             screen->has_WGL_ARB_render_texture,
+             screen->has_WGL_ARB_framebuffer_sRGB,
+             glxWinCacheHash(glxWinCacheHash(2166136261U, gl_extensions),
+                             wgl_extensions));
+    key[size - 1] = '\0';
+
+    GLWIN_DEBUG_MSG("glxWinConfigCacheKey: %s", key);
+}
+
+static Bool
+glxWinConfigCachePath(char *path, size_t size, int screenNum)
+{
+    DWORD len = GetTempPathA(size, path);
+
+    if (len == 0 || len >= size)
+        return FALSE;
+
+    snprintf(path + len, size - len, "VcXsrv.glxconfigs.%d.cache", screenNum);
+    path[size - 1] = '\0';
+
+    return TRUE;
+}
+
+// Flatten a config list into an array of numConfigs records
+static int *
+glxWinConfigCacheRecords(__GLXconfig * configs, unsigned int numConfigs)
+{
+    const unsigned int numFields = ARRAY_SIZE(glxWinCacheFields);
+    int *records = calloc(numConfigs ? numConfigs : 1,
+                          numFields * sizeof(int));
+    __GLXconfig *c;
+    unsigned int i = 0, j;
+
+    if (!records)
+        return NULL;
+
+    for (c = configs; c && i < numConfigs; c = c->next, i++) {
+        for (j = 0; j < numFields; j++)
+            records[i * numFields + j] =
+                *(int *) ((char *) c + glxWinCacheFields[j]);
+    }
+
+    return records;
+}
+
+static void
+glxWinConfigCacheSave(const char *key, int screenNum, glxWinScreen * screen)
+{
+    const unsigned int numFields = ARRAY_SIZE(glxWinCacheFields);
+    char path[MAX_PATH];
+    char tmpPath[MAX_PATH + 16];
+    glxWinCacheHeader header;
+    int *records;
+    FILE *f;
+    Bool ok;
+
+    if (!glxWinConfigCachePath(path, sizeof(path), screenNum))
+        return;
+
+    records = glxWinConfigCacheRecords(screen->base.fbconfigs,
+                                       screen->base.numFBConfigs);
+    if (!records)
+        return;
+
+    header.magic = GLX_CACHE_MAGIC;
+    header.version = GLX_CACHE_VERSION;
+    header.numFields = numFields;
+    header.keyLength = strlen(key);
+    header.numConfigs = screen->base.numFBConfigs;
+    header.hasPixelFormat = screen->has_WGL_ARB_pixel_format;
+
+    // write a private file and rename it over the cache, so another server
+    // starting at the same time never reads half a file
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%lu", path,
+             (unsigned long) GetCurrentProcessId());
+    f = fopen(tmpPath, "wb");
+    if (!f) {
+        free(records);
+        return;
+    }
+
+    ok = (fwrite(&header, sizeof(header), 1, f) == 1)
+        && (fwrite(key, header.keyLength, 1, f) == 1)
+        && (fwrite(records, numFields * sizeof(int), header.numConfigs, f)
+            == header.numConfigs);
+    ok = (fclose(f) == 0) && ok;
+    free(records);
+
+    if (!ok || !MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileA(tmpPath);
+        LogMessage(X_WARNING, "AIGLX: Couldn't write fbConfig cache %s\n",
+                   path);
+        return;
+    }
+
+    LogMessage(X_INFO, "AIGLX: Saved %d fbConfigs to %s\n",
+               screen->base.numFBConfigs, path);
+}
+
+static Bool
+glxWinConfigCacheLoad(const char *key, int screenNum, glxWinScreen * screen)
+{
+    const unsigned int numFields = ARRAY_SIZE(glxWinCacheFields);
+    char path[MAX_PATH];
+    char fileKey[GLX_CACHE_KEY_SIZE];
+    glxWinCacheHeader header;
+    GLXWinConfig *first = NULL, *prev = NULL;
+    int *records = NULL;
+    unsigned int i, j;
+    FILE *f;
+
+    screen->base.numFBConfigs = 0;
+    screen->base.fbconfigs = NULL;
+
+    if (!glxWinConfigCachePath(path, sizeof(path), screenNum))
+        return FALSE;
+
+    f = fopen(path, "rb");
+    if (!f)
+        return FALSE;
+
+    if (fread(&header, sizeof(header), 1, f) != 1
+        || header.magic != GLX_CACHE_MAGIC
+        || header.version != GLX_CACHE_VERSION
+        || header.numFields != numFields
+        || header.keyLength != strlen(key)
+        || header.numConfigs == 0 || header.numConfigs > 65536
+        || fread(fileKey, header.keyLength, 1, f) != 1
+        || memcmp(fileKey, key, header.keyLength) != 0) {
+        fclose(f);
+        GLWIN_DEBUG_MSG("fbConfig cache %s doesn't match", path);
+        return FALSE;
+    }
+
+    records = malloc(header.numConfigs * numFields * sizeof(int));
+    if (!records
+        || fread(records, numFields * sizeof(int), header.numConfigs, f)
+        != header.numConfigs) {
+        fclose(f);
+        free(records);
+        return FALSE;
+    }
+    fclose(f);
+
+    for (i = 0; i < header.numConfigs; i++) {
+        GLXWinConfig *work = calloc(1, sizeof(GLXWinConfig));
+
+        if (NULL == work) {
+            ErrorF("Failed to allocate GLXWinConfig\n");
+            break;
+        }
+
+        for (j = 0; j < numFields; j++)
+            *(int *) ((char *) work + glxWinCacheFields[j]) =
+                records[i * numFields + j];
+
+        work->base.visualID = -1;       // will be set by __glXScreenInit()
+        work->base.fbconfigID = -1;     // will be set by __glXScreenInit()
+
+        // note the first config
+        if (!first)
+            first = work;
+
+        // update previous config to point to this config
+        if (prev)
+            prev->base.next = &(work->base);
+        prev = work;
+    }
+    free(records);
+
+    if (i != header.numConfigs) {
+        while (first) {
+            GLXWinConfig *next = (GLXWinConfig *) first->base.next;
+
+            free(first);
+            first = next;
+        }
+        return FALSE;
+    }
+
+    screen->base.numFBConfigs = header.numConfigs;
+    screen->base.fbconfigs = &(first->base);
+    screen->has_WGL_ARB_pixel_format = header.hasPixelFormat;
+
+    LogMessage(X_INFO, "AIGLX: Loaded %d fbConfigs from %s\n",
+               screen->base.numFBConfigs, path);
+
+    return TRUE;
+}
+
+static void *
+glxWinConfigCacheRecheckThread(void *arg)
+{
+    glxWinCacheRecheck *recheck = arg;
+    glxWinScreen *screen = &recheck->flags;
+    HWND hwnd;
+    HDC hdc = NULL;
+    HGLRC hglrc = NULL;
+
+    Sleep(GLX_CACHE_RECHECK_DELAY);
+
+    hwnd = CreateWindowExA(0,
+                           WIN_GL_WINDOW_CLASS,
+                           "XWin GL Renderer Capabilities Recheck Window",
+                           0, 0, 0, 0, 0, NULL, NULL, g_hInstance,
+                           NULL);
+    if (hwnd)
+        hdc = GetDC(hwnd);
+    if (hdc && glxWinSetTestPixelFormat(hdc))
+        hglrc = wglCreateContext(hdc);
+
+    if (hglrc && wglMakeCurrent(hdc, hglrc)) {
+        unsigned int numConfigs;
+        int *records;
+
+        glxWinEnumerateConfigs(hdc, screen, recheck->wgl_extensions);
+
+        numConfigs = screen->base.numFBConfigs;
+        records = glxWinConfigCacheRecords(screen->base.fbconfigs, numConfigs);
+        if (records && numConfigs > 0) {
+            if (numConfigs != recheck->numConfigs
+                || memcmp(records, recheck->records,
+                          numConfigs * ARRAY_SIZE(glxWinCacheFields) * sizeof(int))) {
+                LogMessage(X_WARNING,
+                           "AIGLX: Cached fbConfigs for screen %d are out of date, "
+                           "they will be refreshed at the next start\n",
+                           recheck->screenNum);
+                glxWinConfigCacheSave(recheck->key, recheck->screenNum, screen);
+            }
+            else
+                GLWIN_DEBUG_MSG("fbConfig cache for screen %d is up to date",
+                                recheck->screenNum);
+        }
+        free(records);
+
+        while (screen->base.fbconfigs) {
+            __GLXconfig *next = screen->base.fbconfigs->next;
+
+            free(screen->base.fbconfigs);
+            screen->base.fbconfigs = next;
+        }
+
+        wglMakeCurrent(NULL, NULL);
+    }
+
+    if (hglrc)
+        wglDeleteContext(hglrc);
+    if (hdc)
+        ReleaseDC(hwnd, hdc);
+    if (hwnd)
+        DestroyWindow(hwnd);
+
+    free(recheck->records);
+    free(recheck->wgl_extensions);
+    free(recheck);
+
+    return NULL;
+}
+
+static void
+glxWinConfigCacheRecheck(const char *key, int screenNum, glxWinScreen * screen,
+                         const char *wgl_extensions)
+{
+    glxWinCacheRecheck *recheck = calloc(1, sizeof(glxWinCacheRecheck));
+    pthread_attr_t attr;
+    pthread_t thread;
+    int ret;
+
+    if (!recheck)
+        return;
+
+    strncpy(recheck->key, key, sizeof(recheck->key) - 1);
+    recheck->screenNum = screenNum;
+    recheck->wgl_extensions = strdup(wgl_extensions);
+    recheck->flags.has_WGL_ARB_multisample = screen->has_WGL_ARB_multisample;
+    recheck->flags.has_WGL_ARB_pbuffer = screen->has_WGL_ARB_pbuffer;
+    recheck->flags.has_WGL_ARB_render_texture = screen->has_WGL_ARB_render_texture;
+    recheck->flags.has_WGL_ARB_framebuffer_sRGB = screen->has_WGL_ARB_framebuffer_sRGB;
+
+    // compare against the configs as they were loaded, before __glXScreenInit()
+    // adds its duplicates
+    recheck->numConfigs = screen->base.numFBConfigs;
+    recheck->records = glxWinConfigCacheRecords(screen->base.fbconfigs,
+                                                recheck->numConfigs);
+
+    if (!recheck->wgl_extensions || !recheck->records) {
+        free(recheck->records);
+        free(recheck->wgl_extensions);
+        free(recheck);
+        return;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    ret = pthread_create(&thread, &attr, glxWinConfigCacheRecheckThread, recheck);
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0) {
+        ErrorF("glxWinConfigCacheRecheck: pthread_create failed: %d\n", ret);
+        free(recheck->records);
+        free(recheck->wgl_extensions);
+        free(recheck);
+    }
+}
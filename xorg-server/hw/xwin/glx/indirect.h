@@ -37,6 +37,8 @@ typedef struct __GLXWinContext __GLXWinContext;
 typedef struct __GLXWinDrawable __GLXWinDrawable;
 typedef struct __GLXWinScreen glxWinScreen;
 typedef struct __GLXWinConfig GLXWinConfig;
+typedef struct __GLXWinSwapWorker glxWinSwapWorker;
+typedef struct __GLXWinGLThread glxWinGLThread;
 
 struct __GLXWinContext {
     __GLXcontext base;
@@ -48,6 +50,11 @@ struct __GLXWinContext {
     HDC hreadDC;                     /* Windows device read context */
     HWND hreadwnd;
     struct _glapi_table *Dispatch;
+    Bool noError;               /* created with GLX_CONTEXT_OPENGL_NO_ERROR_ARB */
+
+    /* If -glthread is used */
+    glxWinGLThread *glThread;
+    Bool glThreadBound;         /* ctx is current on glThread, not here */
 
 };
 
@@ -58,6 +65,7 @@ struct __GLXWinDrawable {
 
     /* If this drawable is GLX_DRAWABLE_PBUFFER */
     HPBUFFERARB hPbuffer;
+    HDC hPbufferDC;             /* lives as long as the pbuffer */
 
     /* If this drawable is GLX_DRAWABLE_PIXMAP */
     HDC dibDC;
@@ -65,6 +73,11 @@ struct __GLXWinDrawable {
     HBITMAP hDIB;
     HBITMAP hOldDIB;            /* original DIB for DC */
     void *pOldBits;             /* original pBits for this drawable's pixmap */
+
+    /* If this drawable is GLX_DRAWABLE_WINDOW and -asyncswap is used */
+    glxWinSwapWorker *swapWorker;
+    OsTimerPtr hiddenSwapTimer; /* throttles swaps while hidden */
+    ClientPtr hiddenSwapClient; /* ignored until hiddenSwapTimer fires */
 };
 
 struct __GLXWinScreen {
@@ -76,6 +89,7 @@ struct __GLXWinScreen {
     Bool has_WGL_ARB_render_texture;
     Bool has_WGL_ARB_make_current_read;
     Bool has_WGL_ARB_framebuffer_sRGB;
+    Bool has_WGL_ARB_create_context_no_error;
 
     /* wrapped screen functions */
     RealizeWindowProcPtr RealizeWindow;
@@ -88,6 +102,7 @@ struct __GLXWinScreen {
 struct __GLXWinConfig {
     __GLXconfig base;
     int pixelFormatIndex;
+    int drawablePixelFormat[3]; /* pixel format for window, pixmap and pbuffer drawables; 0 if not yet chosen, -1 if none */
 };
 
 /* ---------------------------------------------------------------------- */
@@ -98,4 +113,26 @@ struct __GLXWinConfig {
 void
 glxWinDeferredCreateDrawable(__GLXWinDrawable *draw, __GLXWinContext * gc);
 
+Bool
+glxWinSwapWorkerQueue(__GLXWinDrawable * draw, ClientPtr client, HDC hdc);
+
+void
+glxWinSwapWorkerFinish(__GLXWinDrawable * draw);
+
+void
+glxWinSwapWorkerDestroy(__GLXWinDrawable * draw);
+
+glxWinGLThread *
+glxWinGLThreadCreate(void);
+
+Bool
+glxWinGLThreadQueue(glxWinGLThread * thread, HDC hdc, HGLRC ctx,
+                    const GLbyte * pc, int length, Bool large, Bool swapped);
+
+void
+glxWinGLThreadRelease(glxWinGLThread * thread);
+
+void
+glxWinGLThreadDestroy(glxWinGLThread * thread);
+
 #endif /* indirect_h */
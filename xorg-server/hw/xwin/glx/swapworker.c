@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Asynchronous SwapBuffers for window drawables (-asyncswap)
+ *
+ * With vsync on, SwapBuffers() blocks until the driver has room for another
+ * frame, which would stall every client while one of them renders faster
+ * than the display refreshes.  Instead the swap is handed to a worker thread
+ * owned by the drawable, and the client which asked for it is ignored until
+ * it completes, so only that client waits.  Completion is noticed from the
+ * block handler, which attends to the client again and sends it the
+ * GLX_INTEL_swap_event BufferSwapComplete event if it selected for it.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#include "glwindows.h"
+#include <glx/glheader.h>
+#include <glx/glxserver.h>
+#include <GL/glxtokens.h>
+#include <winglobals.h>
+#include <indirect.h>
+
+struct __GLXWinSwapWorker {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    __GLXWinDrawable *draw;
+    HDC hdc;                    /* swap waiting for the worker, or NULL */
+    Bool busy;                  /* a swap is queued or in progress */
+    Bool done;                  /* ... and has completed */
+    Bool quit;
+    BOOL result;
+    DWORD error;                /* GetLastError() of a failed swap */
+    CARD64 ust;                 /* completion time, in microseconds */
+
+    /* only used by the server thread */
+    ClientPtr client;           /* ignored until the swap completes */
+    CARD32 sbc;
+    struct xorg_list entry;     /* in glxWinSwapsPending while busy */
+};
+
+static struct xorg_list glxWinSwapsPending;
+static Bool glxWinSwapHandlersRegistered = FALSE;
+
+static CARD64
+glxWinSwapTime(void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&now);
+    return (CARD64) (now.QuadPart / frequency.QuadPart) * 1000000
+        + (CARD64) (now.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
+
+static void *
+glxWinSwapWorkerThread(void *arg)
+{
+    glxWinSwapWorker *worker = arg;
+
+    pthread_mutex_lock(&worker->mutex);
+    for (;;) {
+        HDC hdc;
+        BOOL result;
+
+        while (!worker->hdc && !worker->quit)
+            pthread_cond_wait(&worker->cond, &worker->mutex);
+
+        if (worker->quit)
+            break;
+
+        hdc = worker->hdc;
+        pthread_mutex_unlock(&worker->mutex);
+
+        result = SwapBuffers(hdc);
+
+        pthread_mutex_lock(&worker->mutex);
+        worker->hdc = NULL;
+        worker->result = result;
+        worker->error = result ? 0 : GetLastError();
+        worker->ust = glxWinSwapTime();
+        worker->done = TRUE;
+        pthread_cond_broadcast(&worker->cond);
+
+        /* The server thread sleeps until a message or a client wakes it */
+        PostThreadMessage(g_dwCurrentThreadID, WM_NULL, 0, 0);
+    }
+    pthread_mutex_unlock(&worker->mutex);
+
+    return NULL;
+}
+
+/*
+  Report a completed swap on the server thread
+*/
+static void
+glxWinSwapComplete(glxWinSwapWorker * worker)
+{
+    xorg_list_del(&worker->entry);
+    worker->busy = FALSE;
+    worker->done = FALSE;
+
+    if (!worker->result)
+        ErrorF("SwapBuffers failed (%08x)\n", (unsigned int) worker->error);
+
+    if (worker->client && !worker->client->clientGone)
+        AttendClient(worker->client);
+    worker->client = NULL;
+
+    __glXsendSwapEvent(&worker->draw->base, GLX_BLIT_COMPLETE_INTEL,
+                       worker->ust, 0, worker->sbc);
+}
+
+static void
+glxWinSwapBlockHandler(void *blockData, void *timeout)
+{
+    glxWinSwapWorker *worker, *next;
+
+    xorg_list_for_each_entry_safe(worker, next, &glxWinSwapsPending, entry) {
+        Bool done;
+
+        pthread_mutex_lock(&worker->mutex);
+        done = worker->done;
+        pthread_mutex_unlock(&worker->mutex);
+
+        if (done)
+            glxWinSwapComplete(worker);
+    }
+}
+
+static void
+glxWinSwapWakeupHandler(void *blockData, int result)
+{
+    glxWinSwapBlockHandler(blockData, NULL);
+}
+
+static glxWinSwapWorker *
+glxWinSwapWorkerCreate(__GLXWinDrawable * draw)
+{
+    glxWinSwapWorker *worker = calloc(1, sizeof(glxWinSwapWorker));
+
+    if (!worker)
+        return NULL;
+
+    if (!glxWinSwapHandlersRegistered) {
+        xorg_list_init(&glxWinSwapsPending);
+        RegisterBlockAndWakeupHandlers(glxWinSwapBlockHandler,
+                                       glxWinSwapWakeupHandler, NULL);
+        glxWinSwapHandlersRegistered = TRUE;
+    }
+
+    worker->draw = draw;
+    xorg_list_init(&worker->entry);
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+
+    if (pthread_create(&worker->thread, NULL, glxWinSwapWorkerThread, worker) != 0) {
+        ErrorF("glxWinSwapWorkerCreate: pthread_create failed\n");
+        pthread_cond_destroy(&worker->cond);
+        pthread_mutex_destroy(&worker->mutex);
+        free(worker);
+        return NULL;
+    }
+
+    return worker;
+}
+
+/*
+  Queue a swap of the drawable's DC for the worker.  Returns FALSE if the
+  caller should swap synchronously instead.
+*/
+Bool
+glxWinSwapWorkerQueue(__GLXWinDrawable * draw, ClientPtr client, HDC hdc)
+{
+    glxWinSwapWorker *worker;
+
+    /* Only ignore the client which owns the drawable, as the drawable
+       is freed, and its swap reported, before that client is */
+    if (!client || clients[CLIENT_ID(draw->base.drawId)] != client)
+        return FALSE;
+
+    if (!draw->swapWorker)
+        draw->swapWorker = glxWinSwapWorkerCreate(draw);
+
+    worker = draw->swapWorker;
+    if (!worker)
+        return FALSE;
+
+    // the previous swap was queued by another client, so wait for it
+    glxWinSwapWorkerFinish(draw);
+
+    // submit the rendering, so the worker's SwapBuffers() comes after it
+    glFlushWrapperNonstatic();
+
+    worker->busy = TRUE;
+    worker->client = client;
+    worker->sbc++;
+    xorg_list_append(&worker->entry, &glxWinSwapsPending);
+    IgnoreClient(client);
+
+    pthread_mutex_lock(&worker->mutex);
+    worker->hdc = hdc;
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+
+    return TRUE;
+}
+
+/*
+  Wait for any swap in flight on this drawable, so its window or DC can be
+  destroyed
+*/
+void
+glxWinSwapWorkerFinish(__GLXWinDrawable * draw)
+{
+    glxWinSwapWorker *worker = draw->swapWorker;
+
+    if (!worker || !worker->busy)
+        return;
+
+    pthread_mutex_lock(&worker->mutex);
+    while (!worker->done)
+        pthread_cond_wait(&worker->cond, &worker->mutex);
+    pthread_mutex_unlock(&worker->mutex);
+
+    glxWinSwapComplete(worker);
+}
+
+void
+glxWinSwapWorkerDestroy(__GLXWinDrawable * draw)
+{
+    glxWinSwapWorker *worker = draw->swapWorker;
+
+    if (!worker)
+        return;
+
+    glxWinSwapWorkerFinish(draw);
+
+    pthread_mutex_lock(&worker->mutex);
+    worker->quit = TRUE;
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+
+    pthread_join(worker->thread, NULL);
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->mutex);
+    free(worker);
+    draw->swapWorker = NULL;
+}
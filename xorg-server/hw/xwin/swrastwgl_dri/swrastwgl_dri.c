@@ -7,6 +7,8 @@
 #include <GL/glx.h>
 #include <GL/internal/dri_interface.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <glx/glheader.h>
 #include <glx/glapi.h>
@@ -39,6 +41,7 @@ struct __DRIscreenRec
 
   const __DRIextension **extensions;
   const __DRIswrastLoaderExtension *swrast_loader;
+  const __DRIswrastFrontLoaderExtension *swrast_front_loader;
 };
 
 struct __DRIcontextRec
@@ -61,8 +64,12 @@ struct __DRIdrawableRec
   HBITMAP hBitmap;
   int winWidth;
   int winHeight;
+  int dibWidth;       /* size of hBitmap, at least winWidth x winHeight */
+  int dibHeight;
   int bitsPerPixel;
   VOID *bits;
+  char *swapBits;     /* the image handed to putImage, top row first */
+  size_t swapSize;
 
   void *driverPrivate;
   void *loaderPrivate;
@@ -325,8 +332,8 @@ void setupDIB(__DRIdrawable * pdp)
   bmHeader = &bmInfo->bmiHeader;
 
   bmHeader->biSize = sizeof(*bmHeader);
-  bmHeader->biWidth = pdp->winWidth;
-  bmHeader->biHeight = pdp->winHeight;
+  bmHeader->biWidth = pdp->dibWidth;
+  bmHeader->biHeight = pdp->dibHeight;
   bmHeader->biPlanes = 1;                     /* must be 1 */
   bmHeader->biBitCount = bitsPerPixel;
   bmHeader->biXPelsPerMeter = 0;
@@ -395,6 +402,8 @@ static void setupLoaderExtensions(__DRIscreen *psp, const __DRIextension **exten
   {
     if (strcmp(extensions[i]->name, __DRI_SWRAST_LOADER) == 0)
       psp->swrast_loader = (__DRIswrastLoaderExtension *) extensions[i];
+    if (strcmp(extensions[i]->name, __DRI_SWRAST_FRONT_LOADER) == 0)
+      psp->swrast_front_loader = (__DRIswrastFrontLoaderExtension *) extensions[i];
   }
 }
 
@@ -3173,6 +3182,26 @@ static void driDrawableCheckSize(__DRIdrawable *pdp)
     return;
   pdp->winWidth=w;
   pdp->winHeight=h;
+
+  /* GL draws into the bottom left corner of a bigger DIB just the same
+     (it is bottom up), so only make a new one when the drawable outgrows
+     it, and then by half as much again, so that dragging a window border
+     does not make one for every step */
+  if (pdp->hBitmap && w<=pdp->dibWidth && h<=pdp->dibHeight)
+    return;
+  if (pdp->hBitmap)
+  {
+    if (w>pdp->dibWidth && w<pdp->dibWidth+pdp->dibWidth/2)
+      w=pdp->dibWidth+pdp->dibWidth/2;
+    if (h>pdp->dibHeight && h<pdp->dibHeight+pdp->dibHeight/2)
+      h=pdp->dibHeight+pdp->dibHeight/2;
+    if (w<pdp->dibWidth)
+      w=pdp->dibWidth;
+    if (h<pdp->dibHeight)
+      h=pdp->dibHeight;
+  }
+  pdp->dibWidth=w;
+  pdp->dibHeight=h;
   setupDIB(pdp);
 }
 static __DRIdrawable *driCreateNewDrawable(__DRIscreen *psp, const __DRIconfig *config, void *data)
@@ -3269,6 +3298,7 @@ static void driDestroyDrawable(__DRIdrawable *pdp)
     DeleteObject(pdp->hBitmap);
     if (pdp->hPalette) DeleteObject(pdp->hPalette);
 
+    free(pdp->swapBits);
     free(pdp);
   }
 }
@@ -3332,34 +3362,66 @@ static void driDestroyScreen(__DRIscreen *psp)
 
 static void driSwapBuffers(__DRIdrawable *pdp)
 {
-//    GET_CURRENT_CONTEXT(ctx);
-  /* Revert image */
+  __DRIscreen *psp = pdp->driScreenPriv;
+  const char *pTop;
   int Row;
-  int UpRow;
-  int ColCount;
-  int HalfRowCount;
-  int *pBits;
+  int Width;
+  int Height;
+  int DibStride;
+  int RowSize;
+  int SwapStride;
+  size_t SwapSize;
 
   //GdiFlush();
 
   driDrawableCheckSize(pdp);
 
-  ColCount=pdp->winWidth;
-  HalfRowCount=pdp->winHeight/2;
-  pBits=(int*)pdp->bits;
+  Width=pdp->winWidth;
+  Height=pdp->winHeight;
+  if (Width<=0 || Height<=0)
+    return;
 
-  for (Row=0,UpRow=2*HalfRowCount-1; Row<HalfRowCount; Row++,UpRow--)
+  /* The DIB is bottom up, so the image starts at its row Height-1 and goes
+     down to row 0; copy it out rows reversed, leaving the DIB as GL drew
+     it */
+  DibStride=((pdp->dibWidth*pdp->bitsPerPixel+31)/32)*4;
+  RowSize=(Width*pdp->bitsPerPixel+7)/8;
+  pTop=(const char *)pdp->bits+(Height-1)*DibStride;
+
+  /* Straight into the X drawable's pixels if the server lets us */
+  if (psp->swrast_front_loader)
   {
-    int j;
-    for (j=0; j<ColCount; j++)
+    int FrontWidth;
+    int FrontHeight;
+    int FrontStride;
+    int FrontBpp;
+    char *pFront;
+
+    pFront=psp->swrast_front_loader->getFrontBuffer(pdp, &FrontWidth, &FrontHeight, &FrontStride, &FrontBpp, pdp->loaderPrivate);
+    if (pFront && FrontBpp==pdp->bitsPerPixel && FrontWidth>=Width && FrontHeight>=Height)
     {
-      int Temp=pBits[Row*ColCount+j];
-      pBits[Row*ColCount+j]=pBits[UpRow*ColCount+j];
-      pBits[UpRow*ColCount+j]=Temp;
+      for (Row=0; Row<Height; Row++)
+        memcpy(pFront+Row*FrontStride, pTop-Row*DibStride, RowSize);
+      psp->swrast_front_loader->damage(pdp, 0, 0, Width, Height, pdp->loaderPrivate);
+      return;
     }
   }
 
-  pdp->driScreenPriv->swrast_loader->putImage(pdp, __DRI_SWRAST_IMAGE_OP_SWAP, 0, 0, pdp->winWidth, pdp->winHeight, pdp->bits, pdp->loaderPrivate);
+  /* putImage wants the rows top down, padded to 32 bits */
+  SwapStride=((Width*pdp->bitsPerPixel+31)/32)*4;
+  SwapSize=(size_t)SwapStride*Height;
+  if (SwapSize>pdp->swapSize)
+  {
+    char *pSwap=realloc(pdp->swapBits, SwapSize);
+    if (!pSwap)
+      return;
+    pdp->swapBits=pSwap;
+    pdp->swapSize=SwapSize;
+  }
+  for (Row=0; Row<Height; Row++)
+    memcpy(pdp->swapBits+Row*SwapStride, pTop-Row*DibStride, RowSize);
+
+  psp->swrast_loader->putImage(pdp, __DRI_SWRAST_IMAGE_OP_SWAP, 0, 0, Width, Height, pdp->swapBits, pdp->loaderPrivate);
 }
 
 const __DRIcoreExtension driCoreExtension = {
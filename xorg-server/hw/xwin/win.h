@@ -47,6 +47,14 @@
 #define WM_MOUSEHWHEEL 0x020E
 #endif
 
+/* DWM asks for the iconic bitmaps of windows with these since Windows 7 */
+#ifndef WM_DWMSENDICONICTHUMBNAIL
+#define WM_DWMSENDICONICTHUMBNAIL 0x0323
+#endif
+#ifndef WM_DWMSENDICONICLIVEPREVIEWBITMAP
+#define WM_DWMSENDICONICLIVEPREVIEWBITMAP 0x0326
+#endif
+
 #define WIN_DEFAULT_BPP				0
 #define WIN_DEFAULT_WHITEPIXEL			255
 #define WIN_DEFAULT_BLACKPIXEL			0
@@ -57,6 +65,22 @@
 #define WIN_DEFAULT_WIN_KILL			TRUE
 #define WIN_DEFAULT_UNIX_KILL			FALSE
 #define WIN_DEFAULT_CLIP_UPDATES_NBOXES		0
+#define WIN_DEFAULT_SCALE			100     /* percent */
+
+/* A shadow framebuffer that has to grow is rounded up to this many pixels */
+#define WIN_FB_GROW_GRANULARITY			256
+#define winFBGrowSize(dw) \
+  (((dw) + WIN_FB_GROW_GRANULARITY - 1) & ~(WIN_FB_GROW_GRANULARITY - 1))
+
+/* Shadow framebuffer rows start on a cache line, for the fb SIMD loops */
+#define WIN_FB_PITCH_ALIGN			64
+#define WIN_SCALE_AUTO				0
+
+/* Convert between Windows client pixels and X pixels for -scale */
+#define winScaleToX(pScreenInfo, i) \
+  MulDiv((i), 100, (pScreenInfo)->dwScale)
+#define winScaleToWindows(pScreenInfo, i) \
+  MulDiv((i), (pScreenInfo)->dwScale, 100)
 #ifdef XWIN_EMULATEPSEUDO
 #define WIN_DEFAULT_EMULATE_PSEUDO		FALSE
 #endif
@@ -86,6 +110,7 @@
  */
 #define WIN_E3B_TIMER_ID		1
 #define WIN_POLLING_MOUSE_TIMER_ID	2
+#define WIN_THUMBNAIL_TIMER_ID		3
 
 #define MOUSE_POLLING_INTERVAL		50
 
@@ -97,6 +122,7 @@
 #define WIN_SERVER_NONE		0x0L    /* 0 */
 #define WIN_SERVER_SHADOW_GDI	0x1L    /* 1 */
 #define WIN_SERVER_SHADOW_DDNL	0x4L    /* 4 */
+#define WIN_SERVER_SHADOW_D3D11	0x8L    /* 8 */
 
 #define AltMapIndex		Mod1MapIndex
 #define NumLockMapIndex		Mod2MapIndex
@@ -220,6 +246,8 @@ typedef Bool (*winAllocateFBProcPtr) (ScreenPtr);
 
 typedef void (*winFreeFBProcPtr) (ScreenPtr);
 
+typedef Bool (*winResizeFBProcPtr) (ScreenPtr);
+
 typedef void (*winShadowUpdateProcPtr) (ScreenPtr, shadowBufPtr);
 
 typedef Bool (*winInitScreenProcPtr) (ScreenPtr);
@@ -340,6 +368,9 @@ typedef struct {
     DWORD dwEngine;
     DWORD dwEnginePreferred;
     DWORD dwClipUpdatesNBoxes;
+    Bool fFramePace;
+    DWORD dwMaxFPS;
+    DWORD dwScale;
 #ifdef XWIN_EMULATEPSEUDO
     Bool fEmulatePseudo;
 #endif
@@ -348,6 +379,7 @@ typedef struct {
     Bool fNoDecorationFullScreen;
 #ifdef XWIN_MULTIWINDOWEXTWM
     Bool fMWExtWM;
+    Bool fLayeredFrames;
 #endif
 #ifdef XWIN_MULTIWINDOWINTWM
   Bool			fInternalWM;
@@ -401,6 +433,8 @@ typedef struct _winPrivScreenRec {
 
     /* Palette management */
     ColormapPtr pcmapInstalled;
+    Bool fColormapDirty;        /* installed colormap changed since shown */
+    HPALETTE hpalPainted;       /* palette realized as WM_PAINT last left it */
 
     /* Pointer to the root visual so we only have to look it up once */
     VisualPtr pRootVisual;
@@ -411,6 +445,7 @@ typedef struct _winPrivScreenRec {
 
     /* Privates used by shadow fb GDI engine */
     HBITMAP hbmpShadow;
+    HANDLE hsectShadow;         /* large page bits of hbmpShadow, if any */
     HDC hdcScreen;
     HDC hdcShadow;
     HWND hwndScreen;
@@ -424,6 +459,29 @@ typedef struct _winPrivScreenRec {
     LPDIRECTDRAWCLIPPER pddcPrimary;
     BOOL fRetryCreateSurface;
 
+    /* Privates used by shadow fb Direct3D 11 engine */
+    struct ID3D11Device *pd3dDevice;
+    struct ID3D11DeviceContext *pd3dContext;
+    struct IDXGISwapChain1 *pdxgiSwapChain;
+    struct ID3D11Texture2D *pd3dtexShadow;
+    RegionRec rgnD3D11Pending;
+    RegionRec rgnD3D11Presented;
+    DWORD dwD3D11BufferWidth;
+    DWORD dwD3D11BufferHeight;
+    DWORD dwD3D11XOffset;
+    DWORD dwD3D11YOffset;
+    DWORD dwD3D11FBWidth;
+    DWORD dwD3D11FBHeight;
+
+    /* Privates used by shadow update frame pacing */
+    shadowBufPtr pFramePaceBuf;
+    RegionRec rgnFramePaced;
+    LONGLONG llFramePeriod;
+    LONGLONG llFrameNext;
+
+    /* Privates used by the Present vblank source */
+    struct _winPresentScreen *pPresent;
+
 #ifdef XWIN_MULTIWINDOWEXTWM
     /* Privates used by multi-window external window manager */
     RootlessFrameID widTop;
@@ -434,6 +492,7 @@ typedef struct _winPrivScreenRec {
     pthread_t ptWMProc;
     pthread_t ptXMsgProc;
     void *pWMInfo;
+    struct _winWindowIndexRec *pWindowIndex;
 
     /* Privates used by both multi-window and rootless */
     Bool fRootWindowShown;
@@ -445,6 +504,7 @@ typedef struct _winPrivScreenRec {
     /* Engine specific functions */
     winAllocateFBProcPtr pwinAllocateFB;
     winFreeFBProcPtr pwinFreeFB;
+    winResizeFBProcPtr pwinResizeFB;
     winShadowUpdateProcPtr pwinShadowUpdate;
     winInitScreenProcPtr pwinInitScreen;
     winCloseScreenProcPtr pwinCloseScreen;
@@ -502,6 +562,8 @@ typedef struct {
     BOOL fClose;
     BOOL fMovingOrSizing;
     BOOL fDestroyed;            //for debug
+    BOOL fLayered;
+    RECT rcDirty;
     char *pfb;
 } win32RootlessWindowRec, *win32RootlessWindowPtr;
 #endif
@@ -555,6 +617,7 @@ extern DeviceIntPtr g_pwinKeyboard;
 
 extern FARPROC g_fpDirectDrawCreate;
 extern FARPROC g_fpDirectDrawCreateClipper;
+extern FARPROC g_fpD3D11CreateDevice;
 
 /*
  * Screen privates macros
@@ -690,6 +753,9 @@ void
 Bool
  winCreateDefColormap(ScreenPtr pScreen);
 
+void
+ winColormapBlockHandler(ScreenPtr pScreen);
+
 /*
  * wincreatewnd.c
  */
@@ -732,6 +798,86 @@ Bool
 void
  winReleaseDDProcAddresses(void);
 
+Bool
+ winGetD3D11ProcAddresses(void);
+
+void
+ winReleaseD3D11ProcAddresses(void);
+
+/*
+ * winframepace.c
+ */
+
+void
+ winFramePaceInit(ScreenPtr pScreen);
+
+void
+ winFramePaceFini(ScreenPtr pScreen);
+
+void
+ winFramePaceUpdatePeriod(ScreenPtr pScreen);
+
+void
+ winShadowUpdatePaced(ScreenPtr pScreen, shadowBufPtr pBuf);
+
+void
+ winFramePaceBlockHandler(ScreenPtr pScreen, void *pTimeout);
+
+/*
+ * winstats.c
+ */
+
+typedef struct {
+    LONG64 llShadowUpdates;     /* calls of the engine's shadow update */
+    LONG64 llShadowTicks;       /* performance counter ticks spent in them */
+    LONG64 llShadowBoxes;       /* damage boxes they were handed */
+    LONG64 llSwaps;             /* GLX buffer swaps */
+    LONG64 llInputEvents;       /* keyboard and mouse messages */
+    LONG64 llInputQueuedMillis; /* time they waited in the Windows queue */
+} winStatsRec;
+
+extern winStatsRec g_winStats;
+
+void
+ winShadowUpdateCounted(ScreenPtr pScreen, shadowBufPtr pBuf);
+
+Bool
+ winStatsWindowShown(void);
+
+void
+ winToggleStatsWindow(void);
+
+/*
+ * winpresent.c
+ */
+
+Bool
+ winPresentInit(ScreenPtr pScreen);
+
+void
+ winPresentFini(ScreenPtr pScreen);
+
+void
+ winPresentUpdateMonitor(ScreenPtr pScreen);
+
+void
+ winPresentBlockHandler(ScreenPtr pScreen, void *pTimeout);
+
+/*
+ * winsync.c
+ */
+
+struct _SyncFence;
+
+Bool
+ winSyncInit(ScreenPtr pScreen);
+
+HANDLE
+ winSyncFenceEvent(struct _SyncFence *pFence);
+
+void
+ winSyncBlockHandler(ScreenPtr pScreen, void *pTimeout);
+
 /*
  * winerror.c
  */
@@ -760,6 +906,9 @@ void
 int
  winTranslateKey(WPARAM wParam, LPARAM lParam);
 
+void
+ winKeybdLayoutChanged(void);
+
 int
  winKeybdProc(DeviceIntPtr pDeviceInt, int iState);
 
@@ -803,6 +952,25 @@ CARD8
 Bool
  winUpdateFBPointer(ScreenPtr pScreen, void *pbits);
 
+void
+ winCopyFBRows(char *pDst, DWORD dwDstPitch, const char *pSrc,
+               DWORD dwSrcPitch, DWORD dwBytes, DWORD dwRows);
+
+void
+ winStartupMark(const char *pszStep);
+
+DWORD
+ winFBAlignWidth(DWORD dwWidth, DWORD dwBPP);
+
+HANDLE
+ winCreateFBSection(SIZE_T size);
+
+void *
+ winAllocFBMemory(SIZE_T size);
+
+void
+ winFreeFBMemory(void *pfb);
+
 /*
  * winmouse.c
  */
@@ -824,6 +992,18 @@ winMouseButtonsHandle(ScreenPtr pScreen,
 void
  winEnqueueMotion(int x, int y);
 
+void
+ winMouseRawInputRegister(HWND hwnd);
+
+void
+ winMouseRawInputUnregister(HWND hwnd);
+
+void
+ winMouseRawInputDrain(void);
+
+void
+ winMouseRawInput(HRAWINPUT hRawInput);
+
 /*
  * winscrinit.c
  */
@@ -841,6 +1021,13 @@ Bool
 Bool
  winSetEngineFunctionsShadowDDNL(ScreenPtr pScreen);
 
+/*
+ * winshadd3d11.c
+ */
+
+Bool
+ winSetEngineFunctionsShadowD3D11(ScreenPtr pScreen);
+
 /*
  * winshadgdi.c
  */
@@ -880,6 +1067,10 @@ Bool
 void
  winSetShapeRootless(WindowPtr pWindow, int kind);
 
+HRGN
+ winCreateRgnFromBoxes(const BoxRec * pBox, int nBox, int iOffsetX,
+                       int iOffsetY, const RECT * prcExtra);
+
 /*
  * winmultiwindowshape.c
  */
@@ -946,6 +1137,31 @@ XID
 int
  winAdjustXWindow(WindowPtr pWin, HWND hwnd);
 
+void
+ winWindowIndexDamage(ScreenPtr pScreen, RegionPtr pDamage);
+
+void
+ winWindowIndexFree(ScreenPtr pScreen);
+
+/*
+ * winthumbnail.c
+ */
+
+void
+ winThumbnailIconic(WindowPtr pWin, Bool fIconic);
+
+Bool
+ winThumbnailSend(WindowPtr pWin, int iMaxWidth, int iMaxHeight);
+
+Bool
+ winThumbnailSendLivePreview(WindowPtr pWin);
+
+void
+ winThumbnailTimer(WindowPtr pWin);
+
+void
+ winThumbnailFree(WindowPtr pWin);
+
 /*
  * winmultiwindowwndproc.c
  */
@@ -40,25 +40,10 @@ winBlockHandler(ScreenPtr pScreen, void *pTimeout)
 {
     winScreenPriv(pScreen);
 
-#ifndef HAS_DEVWINDOWS
-    struct timeval **tvp = pTimeout;
-
-    if (*tvp != NULL) {
-      if (GetQueueStatus(QS_ALLINPUT | QS_ALLPOSTMESSAGE) != 0) {
-        /* If there are still messages to process on the Windows message
-           queue, make sure select() just polls rather than blocking.
-        */
-        *(int*)pTimeout = 0;
-      }
-      else {
-        /* Otherwise, lacking /dev/windows, we must wake up again in
-           a reasonable time to check the Windows message queue. without
-           noticeable delay.
-         */
-        *(int*)pTimeout = 1;
-      }
-    }
-#endif
+    /*
+     * Lacking /dev/windows, ospoll_wait() waits for the Windows message
+     * queue as well as the sockets, so the timeout is left alone
+     */
 
     /* Signal threaded modules to begin */
     if (pScreenPriv != NULL && !pScreenPriv->fServerStarted) {
@@ -88,4 +73,20 @@ winBlockHandler(ScreenPtr pScreen, void *pTimeout)
   if (screenSaverSuspended)
     SetThreadExecutionState(ES_DISPLAY_REQUIRED);
 #endif
+
+    /* Flush frame paced damage that has become due */
+    if (pScreenPriv != NULL && pScreenPriv->pScreenInfo->fFramePace)
+        winFramePaceBlockHandler(pScreen, pTimeout);
+
+    /* Deliver Present vblank events that have become due */
+    if (pScreenPriv != NULL)
+        winPresentBlockHandler(pScreen, pTimeout);
+
+    /* Show the colors stored in the installed colormap */
+    if (pScreenPriv != NULL)
+        winColormapBlockHandler(pScreen);
+
+    /* Trigger fences whose event another thread has set */
+    if (pScreenPriv != NULL)
+        winSyncBlockHandler(pScreen, pTimeout);
 }
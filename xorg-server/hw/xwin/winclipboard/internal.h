@@ -87,11 +87,12 @@ Bool
  * winclipboardtextconv.c
  */
 
-void
- winClipboardDOStoUNIX(char *pszData, int iLength);
+HGLOBAL
+winClipboardUNIXtoDOSGlobal(const char *pszSrc, size_t iLength, Bool fUnicode);
 
-void
- winClipboardUNIXtoDOS(char **ppszData, int iLength);
+char *
+winClipboardDOStoUNIXAlloc(const void *pvSrc, size_t iLength, Bool fUnicode,
+                           size_t *piDestLength);
 
 /*
  * winclipboardthread.c
@@ -116,6 +117,11 @@ extern Bool g_fHasModernClipboardApi;
 extern ADDCLIPBOARDFORMATLISTENERPROC g_fpAddClipboardFormatListener;
 extern REMOVECLIPBOARDFORMATLISTENERPROC g_fpRemoveClipboardFormatListener;
 
+#ifndef HAS_DEVWINDOWS
+int
+winClipboardWaitForEvents(Display * pDisplay, DWORD dwTimeout, Bool fMessages);
+#endif
+
 /*
  * winclipboardwndproc.c
  */
@@ -142,6 +148,10 @@ typedef struct
   Atom *targetList;
   unsigned char *incr;
   unsigned long int incrsize;
+  unsigned long int incrallocated;
+  Atom selection;
+  Atom target;
+  unsigned int epoch;
 } ClipboardConversionData;
 
 int
@@ -152,6 +162,20 @@ winClipboardFlushXEvents(HWND hwnd,
 Atom
 winClipboardGetLastOwnedSelectionAtom(ClipboardAtoms *atoms);
 
+void
+winClipboardConvertSelection(Display *pDisplay, Window iWindow,
+                             Atom selection, Atom target,
+                             ClipboardConversionData *data,
+                             ClipboardAtoms *atoms);
+
+Bool
+winClipboardGetCachedTargets(Atom selection, ClipboardConversionData *data,
+                             ClipboardAtoms *atoms);
+
+Bool
+winClipboardRenderCachedData(Display *pDisplay, Atom selection, Atom target,
+                             Bool fUseUnicode, ClipboardAtoms *atoms);
+
 void
 winClipboardInitMonitoredSelections(void);
 
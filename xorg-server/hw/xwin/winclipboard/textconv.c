@@ -42,110 +42,293 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include "internal.h"
 
 /*
- * Convert \r\n to \n
- *
- * NOTE: This was heavily inspired by, Cygwin's
- * winsup/cygwin/fhandler.cc/fhandler_base::read ()
+ * Text is converted in pieces of this many characters, so that only a
+ * small scratch buffer is needed in addition to the source and the
+ * destination, however large the selection is.
  */
 
-void
-winClipboardDOStoUNIX(char *pszSrc, int iLength)
+#define CLIP_CONVERT_CHUNK		(64 * 1024)
+
+/*
+ * Length of the next chunk of UTF-8 text, never splitting a multibyte
+ * sequence across two chunks
+ */
+
+static size_t
+winClipboardUTF8ChunkLength(const char *pszSrc, size_t iLength)
 {
-    char *pszDest = pszSrc;
-    char *pszEnd = pszSrc + iLength;
+    size_t iChunk;
 
-    /* Loop until the last character */
-    while (pszSrc < pszEnd) {
-        /* Copy the current source character to current destination character */
-        *pszDest = *pszSrc;
+    if (iLength <= CLIP_CONVERT_CHUNK)
+        return iLength;
 
-        /* Advance to the next source character */
-        pszSrc++;
+    /* Back off while the first byte of the next chunk is a continuation */
+    iChunk = CLIP_CONVERT_CHUNK;
+    while (iChunk > CLIP_CONVERT_CHUNK - 4
+           && (((unsigned char) pszSrc[iChunk]) & 0xC0) == 0x80)
+        iChunk--;
 
-        /* Don't advance the destination character if we need to drop an \r */
-        if (*pszDest != '\r' || *pszSrc != '\n')
-            pszDest++;
-    }
+    return iChunk;
+}
 
-    /* Move the terminating null */
-    *pszDest = '\0';
+/*
+ * Length of the next chunk of UTF-16 text, never splitting a surrogate pair
+ * across two chunks
+ */
+
+static size_t
+winClipboardUTF16ChunkLength(const wchar_t *pwszSrc, size_t iLength)
+{
+    if (iLength <= CLIP_CONVERT_CHUNK)
+        return iLength;
+
+    if (pwszSrc[CLIP_CONVERT_CHUNK - 1] >= 0xD800
+        && pwszSrc[CLIP_CONVERT_CHUNK - 1] <= 0xDBFF)
+        return CLIP_CONVERT_CHUNK - 1;
+
+    return CLIP_CONVERT_CHUNK;
 }
 
 /*
- * Convert \n to \r\n
+ * Convert X selection text to Windows clipboard text
+ *
+ * Naked \n's become \r\n and embedded nulls (which separate the elements
+ * of an X text list) are dropped.  When fUnicode is set the source is UTF-8
+ * and the result is UTF-16 for CF_UNICODETEXT, otherwise the source is in
+ * the Windows multibyte code page and is copied as is for CF_TEXT.
+ *
+ * The size of the result is worked out first, so the text is converted
+ * chunk by chunk straight into the global memory handed to the clipboard,
+ * without an intermediate copy of the whole selection.
+ *
+ * Returns a moveable global memory handle, or NULL on failure.
  */
 
-void
-winClipboardUNIXtoDOS(char **ppszData, int iLength)
+HGLOBAL
+winClipboardUNIXtoDOSGlobal(const char *pszSrc, size_t iLength, Bool fUnicode)
 {
-    int iNewlineCount = 0;
-    char *pszSrc = *ppszData;
-    char *pszEnd = pszSrc + iLength;
-    char *pszDest = NULL, *pszDestBegin = NULL;
-
-    winDebug("UNIXtoDOS () - Original data:'%s'\n", *ppszData);
-
-    /* Count \n characters without leading \r */
-    while (pszSrc < pszEnd) {
-        /* Skip ahead two character if found set of \r\n */
-        if (*pszSrc == '\r' && pszSrc + 1 < pszEnd && *(pszSrc + 1) == '\n') {
-            pszSrc += 2;
-            continue;
+    HGLOBAL hGlobal;
+    size_t iDestLength = 0;
+    size_t iOffset, iChunk, i;
+    Bool fPrevCR = FALSE;
+
+    /* Count the characters of the result */
+    for (iOffset = 0; iOffset < iLength; iOffset += iChunk) {
+        if (fUnicode) {
+            iChunk = winClipboardUTF8ChunkLength(pszSrc + iOffset,
+                                                 iLength - iOffset);
+            iDestLength += MultiByteToWideChar(CP_UTF8, 0, pszSrc + iOffset,
+                                               iChunk, NULL, 0);
+        }
+        else {
+            iChunk = iLength - iOffset;
+            iDestLength += iChunk;
+        }
+
+        /*
+         * \r, \n and nulls are single bytes in both encodings, and each
+         * maps to exactly one character of the result
+         */
+        for (i = iOffset; i < iOffset + iChunk; i++) {
+            if (pszSrc[i] == '\0') {
+                iDestLength--;
+                continue;
+            }
+            if (pszSrc[i] == '\n' && !fPrevCR)
+                iDestLength++;
+            fPrevCR = (pszSrc[i] == '\r');
+        }
+    }
+
+    hGlobal = GlobalAlloc(GMEM_MOVEABLE,
+                          (iDestLength + 1) * (fUnicode ? sizeof(wchar_t) : 1));
+    if (!hGlobal)
+        return NULL;
+
+    fPrevCR = FALSE;
+
+    if (fUnicode) {
+        wchar_t *pwszDest = GlobalLock(hGlobal);
+        wchar_t *pwszEnd = pwszDest + iDestLength;
+        wchar_t *pwszScratch = malloc(CLIP_CONVERT_CHUNK * sizeof(wchar_t));
+
+        if (!pwszDest || !pwszScratch) {
+            free(pwszScratch);
+            if (pwszDest)
+                GlobalUnlock(hGlobal);
+            GlobalFree(hGlobal);
+            return NULL;
+        }
+
+        for (iOffset = 0; iOffset < iLength; iOffset += iChunk) {
+            size_t iScratch;
+
+            iChunk = winClipboardUTF8ChunkLength(pszSrc + iOffset,
+                                                 iLength - iOffset);
+            iScratch = MultiByteToWideChar(CP_UTF8, 0, pszSrc + iOffset,
+                                           iChunk, pwszScratch,
+                                           CLIP_CONVERT_CHUNK);
+
+            for (i = 0; i < iScratch && pwszDest < pwszEnd; i++) {
+                wchar_t c = pwszScratch[i];
+
+                if (c == L'\0')
+                    continue;
+                if (c == L'\n' && !fPrevCR)
+                    *pwszDest++ = L'\r';
+                if (pwszDest < pwszEnd)
+                    *pwszDest++ = c;
+                fPrevCR = (c == L'\r');
+            }
         }
+        *pwszDest = L'\0';
+
+        free(pwszScratch);
+    }
+    else {
+        char *pszDest = GlobalLock(hGlobal);
+        char *pszEnd = pszDest + iDestLength;
 
-        /* Increment the count if found naked \n */
-        if (*pszSrc == '\n') {
-            iNewlineCount++;
+        if (!pszDest) {
+            GlobalFree(hGlobal);
+            return NULL;
         }
 
-        pszSrc++;
+        for (i = 0; i < iLength && pszDest < pszEnd; i++) {
+            char c = pszSrc[i];
+
+            if (c == '\0')
+                continue;
+            if (c == '\n' && !fPrevCR)
+                *pszDest++ = '\r';
+            if (pszDest < pszEnd)
+                *pszDest++ = c;
+            fPrevCR = (c == '\r');
+        }
+        *pszDest = '\0';
     }
 
-    /* Return if no naked \n's */
-    if (iNewlineCount == 0)
-        return;
+    GlobalUnlock(hGlobal);
 
-    /* Allocate a new string */
-    pszDestBegin = pszDest = malloc(iLength + iNewlineCount + 1);
+    winDebug("winClipboardUNIXtoDOSGlobal - %lu bytes became %lu "
+             "characters\n", (unsigned long) iLength,
+             (unsigned long) iDestLength);
 
-    /* Set source pointer to beginning of data string */
-    pszSrc = *ppszData;
+    return hGlobal;
+}
+
+/*
+ * Copy one chunk of UTF-16 text to pwszDest, dropping the \r of \r\n.  The
+ * following character is looked at in the whole source, so a pair split
+ * across two chunks is still found.
+ */
 
-    /* Loop through all characters in source string */
-    while (pszSrc < pszEnd) {
-        /* Copy line endings that are already valid */
-        if (*pszSrc == '\r' && pszSrc + 1 < pszEnd && *(pszSrc + 1) == '\n') {
-            *pszDest = *pszSrc;
-            *(pszDest + 1) = *(pszSrc + 1);
-            pszDest += 2;
-            pszSrc += 2;
+static size_t
+winClipboardDOStoUNIXChunk(wchar_t *pwszDest, const wchar_t *pwszSrc,
+                           size_t iChunk, size_t iLength)
+{
+    wchar_t *pwszStart = pwszDest;
+    size_t i;
+
+    for (i = 0; i < iChunk; i++) {
+        if (pwszSrc[i] == L'\r' && i + 1 < iLength && pwszSrc[i + 1] == L'\n')
             continue;
+        *pwszDest++ = pwszSrc[i];
+    }
+
+    return pwszDest - pwszStart;
+}
+
+/*
+ * Convert Windows clipboard text to X selection text
+ *
+ * \r\n becomes \n.  When fUnicode is set the source holds iLength UTF-16
+ * characters and the result is UTF-8, otherwise the source holds iLength
+ * bytes in the Windows multibyte code page and they are copied as is.
+ * UTF-16 text is converted in chunks through a small scratch buffer, so the
+ * only full size allocation is the result itself.
+ *
+ * Returns a null terminated malloc'd string, and its length in bytes in
+ * *piDestLength, or NULL on failure.
+ *
+ * NOTE: This was heavily inspired by, Cygwin's
+ * winsup/cygwin/fhandler.cc/fhandler_base::read ()
+ */
+
+char *
+winClipboardDOStoUNIXAlloc(const void *pvSrc, size_t iLength, Bool fUnicode,
+                           size_t *piDestLength)
+{
+    char *pszDest;
+    size_t iDestLength = 0;
+
+    if (fUnicode) {
+        const wchar_t *pwszSrc = pvSrc;
+        wchar_t *pwszScratch = malloc(CLIP_CONVERT_CHUNK * sizeof(wchar_t));
+        size_t iOffset, iChunk, iScratch, iTotal;
+
+        if (!pwszScratch)
+            return NULL;
+
+        /* Count the bytes of the result */
+        for (iOffset = 0; iOffset < iLength; iOffset += iChunk) {
+            iChunk = winClipboardUTF16ChunkLength(pwszSrc + iOffset,
+                                                  iLength - iOffset);
+            iScratch = winClipboardDOStoUNIXChunk(pwszScratch,
+                                                  pwszSrc + iOffset, iChunk,
+                                                  iLength - iOffset);
+            if (iScratch)
+                iDestLength += WideCharToMultiByte(CP_UTF8, 0, pwszScratch,
+                                                   iScratch, NULL, 0,
+                                                   NULL, NULL);
         }
 
-        /* Add \r to naked \n's */
-        if (*pszSrc == '\n') {
-            *pszDest = '\r';
-            *(pszDest + 1) = *pszSrc;
-            pszDest += 2;
-            pszSrc += 1;
-            continue;
+        pszDest = malloc(iDestLength + 1);
+        if (!pszDest) {
+            free(pwszScratch);
+            return NULL;
+        }
+
+        /* Convert into the result */
+        iTotal = iDestLength;
+        iDestLength = 0;
+        for (iOffset = 0; iOffset < iLength; iOffset += iChunk) {
+            iChunk = winClipboardUTF16ChunkLength(pwszSrc + iOffset,
+                                                  iLength - iOffset);
+            iScratch = winClipboardDOStoUNIXChunk(pwszScratch,
+                                                  pwszSrc + iOffset, iChunk,
+                                                  iLength - iOffset);
+            if (iScratch && iDestLength < iTotal)
+                iDestLength += WideCharToMultiByte(CP_UTF8, 0, pwszScratch,
+                                                   iScratch,
+                                                   pszDest + iDestLength,
+                                                   iTotal - iDestLength,
+                                                   NULL, NULL);
         }
 
-        /* Copy normal characters */
-        *pszDest = *pszSrc;
-        pszSrc++;
-        pszDest++;
+        free(pwszScratch);
     }
+    else {
+        const char *pszSrc = pvSrc;
+        size_t i;
+
+        pszDest = malloc(iLength + 1);
+        if (!pszDest)
+            return NULL;
 
-    /* Put terminating null at end of new string */
-    *pszDest = '\0';
+        for (i = 0; i < iLength; i++) {
+            if (pszSrc[i] == '\r' && i + 1 < iLength && pszSrc[i + 1] == '\n')
+                continue;
+            pszDest[iDestLength++] = pszSrc[i];
+        }
+    }
 
-    /* Swap string pointers */
-    free(*ppszData);
-    *ppszData = pszDestBegin;
+    pszDest[iDestLength] = '\0';
+    *piDestLength = iDestLength;
 
-    winDebug("UNIXtoDOS () - Final string:'%s'\n", pszDestBegin);
+    return pszDest;
 }
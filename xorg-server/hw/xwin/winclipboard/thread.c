@@ -58,6 +58,7 @@
 #include <X11/Xatom.h>
 #include <X11/extensions/Xfixes.h>
 #include "winclipboard.h"
+#include "frametrace.h"
 #include "internal.h"
 
 /* Clipboard module constants */
@@ -94,6 +95,9 @@ extern Window g_iClipboardWindow;
 static jmp_buf g_jmpEntry;
 static XIOErrorHandler g_winClipboardOldIOErrorHandler;
 static pthread_t g_winClipboardProcThread;
+#ifndef HAS_DEVWINDOWS
+static WSAEVENT g_hClipboardSocketEvent = WSA_INVALID_EVENT;
+#endif
 
 int xfixes_event_base;
 int xfixes_error_base;
@@ -136,14 +140,12 @@ winClipboardProc(Bool fUseUnicode, char *szDisplay)
 
 #ifdef HAS_DEVWINDOWS
     int fdMessageQueue = 0;
-#else
-    struct timeval tvTimeout;
-#endif
     fd_set fdsRead;
     int iMaxDescriptor;
+    int iSelectError;
+#endif
     Display *pDisplay = NULL;
     Window iWindow = None;
-    int iSelectError;
     Bool fShutDown = TRUE;
     static Bool fErrorHandlerSet = FALSE;
 
@@ -223,7 +225,17 @@ winClipboardProc(Bool fUseUnicode, char *szDisplay)
     /* Find max of our file descriptors */
     iMaxDescriptor = MAX(fdMessageQueue, iConnectionNumber) + 1;
 #else
-    iMaxDescriptor = iConnectionNumber + 1;
+    /* Have the X connection set an event we can wait on with the Windows
+     * message queue */
+    if (g_hClipboardSocketEvent == WSA_INVALID_EVENT)
+        g_hClipboardSocketEvent = WSACreateEvent();
+    if (g_hClipboardSocketEvent == WSA_INVALID_EVENT ||
+        WSAEventSelect(iConnectionNumber, g_hClipboardSocketEvent,
+                       FD_READ | FD_CLOSE) == SOCKET_ERROR) {
+        ErrorF("winClipboardProc - Could not watch the X connection: %d\n",
+               WSAGetLastError());
+        goto thread_errorexit;
+    }
 #endif
 
     if (!XFixesQueryExtension(pDisplay, &xfixes_event_base, &xfixes_error_base))
@@ -305,6 +317,10 @@ winClipboardProc(Bool fUseUnicode, char *szDisplay)
     data.fUseUnicode = fUseUnicode;
     data.incr = NULL;
     data.incrsize = 0;
+    data.incrallocated = 0;
+    data.selection = None;
+    data.target = None;
+    data.epoch = 0;
     winDebug ("winClipboardProc - Started\n");
     /* Signal that the clipboard client has started */
     g_fClipboardStarted = TRUE;
@@ -312,12 +328,15 @@ winClipboardProc(Bool fUseUnicode, char *szDisplay)
     /* Loop for events */
     while (1) {
 
+        FRAME_TRACE_BEGIN("Clipboard");
+
         /* Process X events */
         winClipboardFlushXEvents(hwnd,
                                  iWindow, pDisplay, &data, &atoms);
 
         /* Process Windows messages */
         if (!winClipboardFlushWindowsMessageQueue(hwnd)) {
+          FRAME_TRACE_END("Clipboard");
           ErrorF("winClipboardProc - winClipboardFlushWindowsMessageQueue trapped "
                        "WM_QUIT message, exiting main loop.\n");
           break;
@@ -326,6 +345,16 @@ winClipboardProc(Bool fUseUnicode, char *szDisplay)
         /* We need to ensure that all pending requests are sent */
         XFlush(pDisplay);
 
+        FRAME_TRACE_END("Clipboard");
+
+#ifndef HAS_DEVWINDOWS
+        /* Wait for a Windows message or an X event, however long it takes */
+        if (winClipboardWaitForEvents(pDisplay, INFINITE, TRUE) < 0) {
+            ErrorF("winClipboardProc - Waiting for events failed: %d.  "
+                   "Bailing.\n", (int) GetLastError());
+            break;
+        }
+#else
         /* Setup the file descriptor set */
         /*
          * NOTE: You have to do this before every call to select
@@ -334,23 +363,14 @@ winClipboardProc(Bool fUseUnicode, char *szDisplay)
          */
         FD_ZERO(&fdsRead);
         FD_SET(iConnectionNumber, &fdsRead);
-#ifdef HAS_DEVWINDOWS
         FD_SET(fdMessageQueue, &fdsRead);
-#else
-        tvTimeout.tv_sec = 0;
-        tvTimeout.tv_usec = 100;
-#endif
 
         /* Wait for a Windows event or an X event */
         iReturn = select(iMaxDescriptor,        /* Highest fds number */
                          &fdsRead,      /* Read mask */
                          NULL,  /* No write mask */
                          NULL,  /* No exception mask */
-#ifdef HAS_DEVWINDOWS
                          NULL   /* No timeout */
-#else
-                         &tvTimeout     /* Set timeout */
-#endif
             );
 
 #ifndef HAS_WINSOCK
@@ -371,6 +391,7 @@ winClipboardProc(Bool fUseUnicode, char *szDisplay)
                    "Bailing.\n", iReturn);
             break;
         }
+#endif
     }
 
     /* Close our X window */
@@ -427,6 +448,12 @@ thread_errorexit:
     winDebug ("Clipboard thread died.\n");
 
 commonexit:
+#ifndef HAS_DEVWINDOWS
+    if (g_hClipboardSocketEvent != WSA_INVALID_EVENT) {
+        WSACloseEvent(g_hClipboardSocketEvent);
+        g_hClipboardSocketEvent = WSA_INVALID_EVENT;
+    }
+#endif
     g_iClipboardWindow = None;
     g_pClipboardDisplay = NULL;
     g_fClipboardLaunched = FALSE;
@@ -437,6 +464,40 @@ commonexit:
     return fShutDown;
 }
 
+#ifndef HAS_DEVWINDOWS
+/*
+ * Wait up to dwTimeout milliseconds for the X connection to have something
+ * to read, or, with fMessages, for a message on the thread's queue
+ *
+ * Returns 1 if there may be something to do, 0 on timeout, -1 on failure.
+ */
+
+int
+winClipboardWaitForEvents(Display * pDisplay, DWORD dwTimeout, Bool fMessages)
+{
+    DWORD dwResult;
+
+    if (g_hClipboardSocketEvent == WSA_INVALID_EVENT)
+        return -1;
+
+    /* Anything arriving from here on sets the event again, as reading
+     * the connection re-enables FD_READ */
+    WSAResetEvent(g_hClipboardSocketEvent);
+    if (XPending(pDisplay))
+        return 1;
+
+    dwResult = MsgWaitForMultipleObjectsEx(1, &g_hClipboardSocketEvent,
+                                           dwTimeout,
+                                           fMessages ? QS_ALLINPUT : 0,
+                                           MWMO_INPUTAVAILABLE);
+    if (dwResult == WAIT_TIMEOUT)
+        return 0;
+    if (dwResult == WAIT_FAILED)
+        return -1;
+    return 1;
+}
+#endif
+
 /*
  * Create the Windows window that we use to receive Windows messages
  */
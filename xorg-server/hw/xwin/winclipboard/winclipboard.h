@@ -33,4 +33,8 @@ void winFixClipboardChain (int Removed);
 
 extern Bool fPrimarySelection;
 
+/* Text bytes handed between the clipboards, only added to with
+   InterlockedExchangeAdd64() as the clipboard has its own thread */
+extern volatile long long g_llClipboardBytes;
+
 #endif
@@ -84,19 +84,26 @@ static int
 winProcessXEventsTimeout(HWND hwnd, Window iWindow, Display * pDisplay,
                          ClipboardConversionData *data, ClipboardAtoms *atoms, int iTimeoutSec)
 {
+#ifdef HAS_DEVWINDOWS
     int iConnNumber;
     struct timeval tv;
+#endif
+    DWORD dwStart = GetTickCount();
     int iReturn;
 
     winDebug("winProcessXEventsTimeout () - pumping X events for %d seconds\n",
              iTimeoutSec);
 
+#ifdef HAS_DEVWINDOWS
     /* Get our connection number */
     iConnNumber = ConnectionNumber(pDisplay);
+#endif
 
     /* Loop for X events */
     while (1) {
+#ifdef HAS_DEVWINDOWS
         fd_set fdsRead;
+#endif
         long remainingTime;
 
         /* Process X events */
@@ -112,14 +119,8 @@ winProcessXEventsTimeout(HWND hwnd, Window iWindow, Display * pDisplay,
         /* We need to ensure that all pending requests are sent */
         XFlush(pDisplay);
 
-        /* Setup the file descriptor set */
-        FD_ZERO(&fdsRead);
-        FD_SET(iConnNumber, &fdsRead);
-
-        /* Adjust timeout */
-        remainingTime = iTimeoutSec * 1000;
-        tv.tv_sec = remainingTime / 1000;
-        tv.tv_usec = (remainingTime % 1000) * 1000;
+        /* Adjust timeout, which counts from the start and not each wake */
+        remainingTime = iTimeoutSec * 1000 - (long) (GetTickCount() - dwStart);
         winDebug("winProcessXEventsTimeout () - %ld milliseconds left\n",
                  remainingTime);
 
@@ -127,6 +128,13 @@ winProcessXEventsTimeout(HWND hwnd, Window iWindow, Display * pDisplay,
         if (remainingTime <= 0)
             return WIN_XEVENTS_SUCCESS;
 
+#ifdef HAS_DEVWINDOWS
+        /* Setup the file descriptor set */
+        FD_ZERO(&fdsRead);
+        FD_SET(iConnNumber, &fdsRead);
+        tv.tv_sec = remainingTime / 1000;
+        tv.tv_usec = (remainingTime % 1000) * 1000;
+
         /* Wait for an X event */
         iReturn = select(iConnNumber + 1,       /* Highest fds number */
                          &fdsRead,      /* Read mask */
@@ -142,6 +150,15 @@ winProcessXEventsTimeout(HWND hwnd, Window iWindow, Display * pDisplay,
         if (!FD_ISSET(iConnNumber, &fdsRead)) {
             winDebug("winProcessXEventsTimeout - Spurious wake, select() returned %d\n", iReturn);
         }
+#else
+        /* Wait for an X event; Windows messages wait for the conversion */
+        iReturn = winClipboardWaitForEvents(pDisplay, remainingTime, FALSE);
+        if (iReturn < 0) {
+            ErrorF("winProcessXEventsTimeout - Waiting for events failed: %x.  "
+                   "Bailing.\n", (unsigned int) GetLastError());
+            break;
+        }
+#endif
     }
 
     return WIN_XEVENTS_SUCCESS;
@@ -533,32 +550,38 @@ winClipboardWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             goto fake_paste;
         }
 
-        winDebug("winClipboardWindowProc - requesting targets for selection from owner\n");
-
-        /* Request the selection's supported conversion targets */
-        XConvertSelection(pDisplay,
-                          selection,
-                          atoms->atomTargets,
-                          atoms->atomLocalProperty,
-                          iWindow, CurrentTime);
-
-        /* Process X events */
         data.fUseUnicode = fConvertToUnicode;
         data.incr = NULL;
         data.incrsize = 0;
+        data.incrallocated = 0;
+        data.targetList = NULL;
+
+        /* The owner is only asked for its targets once while it owns the selection */
+        if (!winClipboardGetCachedTargets(selection, &data, atoms)) {
+            winDebug("winClipboardWindowProc - requesting targets for selection from owner\n");
+
+            /* Request the selection's supported conversion targets */
+            winClipboardConvertSelection(pDisplay, iWindow,
+                                         selection, atoms->atomTargets,
+                                         &data, atoms);
+
+            /* Process X events */
+            iReturn = winProcessXEventsTimeout(hwnd,
+                                               iWindow,
+                                               pDisplay,
+                                               &data,
+                                               atoms,
+                                               WIN_POLL_TIMEOUT);
+
+            if (WIN_XEVENTS_NOTIFY_TARGETS != iReturn) {
+                ErrorF
+                    ("winClipboardWindowProc - timed out waiting for WIN_XEVENTS_NOTIFY_TARGETS\n");
+                goto fake_paste;
+            }
+        }
 
-        iReturn = winProcessXEventsTimeout(hwnd,
-                                           iWindow,
-                                           pDisplay,
-                                           &data,
-                                           atoms,
-                                           WIN_POLL_TIMEOUT);
-
-        if (WIN_XEVENTS_NOTIFY_TARGETS != iReturn) {
-            ErrorF
-                ("winClipboardWindowProc - timed out waiting for WIN_XEVENTS_NOTIFY_TARGETS\n");
+        if (!data.targetList)
             goto fake_paste;
-        }
 
         /* Choose the most preferred target */
         {
@@ -603,14 +626,19 @@ winClipboardWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         if (best_target == 0)
           goto fake_paste;
 
+        /* Serve the data from the cache if the owner has already converted it */
+        if (winClipboardRenderCachedData(pDisplay, selection, best_target,
+                                         fConvertToUnicode, atoms)) {
+            pasted = TRUE;
+            goto fake_paste;
+        }
+
         winDebug("winClipboardWindowProc - requesting selection from owner\n");
 
         /* Request the selection contents */
-        XConvertSelection(pDisplay,
-                          selection,
-                          best_target,
-                          atoms->atomLocalProperty,
-                          iWindow, CurrentTime);
+        winClipboardConvertSelection(pDisplay, iWindow,
+                                     selection, best_target,
+                                     &data, atoms);
 
         /* Process X events */
         iReturn = winProcessXEventsTimeout(hwnd,
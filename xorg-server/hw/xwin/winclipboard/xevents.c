@@ -65,12 +65,22 @@
 #define CLIP_OWN_PRIMARY		0
 #define CLIP_OWN_CLIPBOARD		1
 
+/* Smallest buffer allocated for receiving an INCR transfer */
+#define CLIP_INCR_MIN_ALLOC		(64 * 1024)
+
+/* Milliseconds an outgoing INCR transfer may wait for the requestor */
+#define CLIP_INCR_TIMEOUT		10000
+
+/* Largest selection data kept in the conversion cache */
+#define CLIP_CACHE_MAX_DATA		(1024 * 1024)
+
 /*
  * Global variables
  */
 
 extern int xfixes_event_base;
 Bool fPrimarySelection = TRUE;
+volatile long long g_llClipboardBytes;
 
 /*
  * Local variables
@@ -82,6 +92,69 @@ static const char *szSelectionNames[CLIP_NUM_SELECTIONS] =
 
 static unsigned int lastOwnedSelectionIndex = CLIP_OWN_NONE;
 
+/*
+ * Outgoing INCR transfers, for clipboard data too large to be sent to the
+ * requestor in a single property
+ */
+
+typedef struct _ClipboardIncrTransfer {
+    struct _ClipboardIncrTransfer *pNext;
+    Window requestor;
+    Atom property;
+    Atom target;
+    unsigned char *data;
+    unsigned long int size;
+    unsigned long int offset;
+    unsigned long int chunk;
+    Bool fXFree;
+    DWORD dwLastActivity;
+} ClipboardIncrTransfer;
+
+static ClipboardIncrTransfer *s_pIncrTransfers = NULL;
+
+/*
+ * What we have learnt from the current owner of each monitored selection:
+ * its TARGETS, and the data of the last small conversion.  The epoch
+ * changes, and the cache is emptied, whenever MonitorSelection sees the
+ * selection set, so nothing here outlives the owner it came from.
+ */
+
+typedef struct {
+    unsigned int epoch;
+    Atom *targetList;
+    Atom target;
+    Atom encoding;
+    int format;
+    unsigned char *value;
+    unsigned long int nitems;
+} ClipboardSelectionCache;
+
+static ClipboardSelectionCache s_selectionCache[CLIP_NUM_SELECTIONS];
+
+static void
+winClipboardCacheFlush(unsigned int i)
+{
+    free(s_selectionCache[i].targetList);
+    s_selectionCache[i].targetList = NULL;
+    free(s_selectionCache[i].value);
+    s_selectionCache[i].value = NULL;
+    s_selectionCache[i].nitems = 0;
+    s_selectionCache[i].target = None;
+    s_selectionCache[i].epoch++;
+}
+
+static int
+winClipboardSelectionIndex(Atom selection, ClipboardAtoms *atoms)
+{
+    if (selection == XA_PRIMARY)
+        return CLIP_OWN_PRIMARY;
+
+    if (selection == atoms->atomClipboard)
+        return CLIP_OWN_CLIPBOARD;
+
+    return CLIP_OWN_NONE;
+}
+
 static void
 MonitorSelection(XFixesSelectionNotifyEvent * e, unsigned int i)
 {
@@ -109,6 +182,9 @@ MonitorSelection(XFixesSelectionNotifyEvent * e, unsigned int i)
         lastOwnedSelectionIndex = i;
     }
 
+    /* Anything cached came from the previous owner, or its previous contents */
+    winClipboardCacheFlush(i);
+
     /* Save new selection owner or None */
     s_iOwners[i] = e->owner;
     winDebug("MonitorSelection - %s - Now owned by XID %lx\n",
@@ -136,10 +212,272 @@ winClipboardInitMonitoredSelections(void)
 {
     /* Initialize static variables */
     int i;
-    for (i = 0; i < CLIP_NUM_SELECTIONS; ++i)
+    for (i = 0; i < CLIP_NUM_SELECTIONS; ++i) {
       s_iOwners[i] = None;
+      winClipboardCacheFlush(i);
+    }
 
     lastOwnedSelectionIndex = CLIP_OWN_NONE;
+
+    /* Forget transfers left over from a previous connection */
+    while (s_pIncrTransfers) {
+        ClipboardIncrTransfer *pTransfer = s_pIncrTransfers;
+
+        s_pIncrTransfers = pTransfer->pNext;
+        if (pTransfer->fXFree)
+            XFree(pTransfer->data);
+        else
+            free(pTransfer->data);
+        free(pTransfer);
+    }
+}
+
+/*
+ * Ask the owner of selection to convert it to target, noting which
+ * ownership epoch the reply will belong to
+ */
+
+void
+winClipboardConvertSelection(Display *pDisplay, Window iWindow,
+                             Atom selection, Atom target,
+                             ClipboardConversionData *data,
+                             ClipboardAtoms *atoms)
+{
+    int i = winClipboardSelectionIndex(selection, atoms);
+
+    data->selection = selection;
+    data->target = target;
+    data->epoch = (i != CLIP_OWN_NONE) ? s_selectionCache[i].epoch : 0;
+
+    XConvertSelection(pDisplay,
+                      selection,
+                      target,
+                      atoms->atomLocalProperty,
+                      iWindow, CurrentTime);
+}
+
+/*
+ * Is the reply to the conversion in data still from the current owner?
+ */
+
+static ClipboardSelectionCache *
+winClipboardCacheForReply(ClipboardConversionData *data, ClipboardAtoms *atoms)
+{
+    int i = winClipboardSelectionIndex(data->selection, atoms);
+
+    if (i == CLIP_OWN_NONE || s_selectionCache[i].epoch != data->epoch)
+        return NULL;
+
+    return &s_selectionCache[i];
+}
+
+/*
+ * Fill in data->targetList from the cache, if the current owner of
+ * selection has already told us its TARGETS
+ */
+
+Bool
+winClipboardGetCachedTargets(Atom selection, ClipboardConversionData *data,
+                             ClipboardAtoms *atoms)
+{
+    int i = winClipboardSelectionIndex(selection, atoms);
+    Atom *targetList;
+    int n;
+
+    if (i == CLIP_OWN_NONE || !s_selectionCache[i].targetList)
+        return FALSE;
+
+    targetList = s_selectionCache[i].targetList;
+    for (n = 0; targetList[n] != 0; n++);
+
+    data->targetList = malloc((n + 1) * sizeof(Atom));
+    if (!data->targetList)
+        return FALSE;
+    memcpy(data->targetList, targetList, (n + 1) * sizeof(Atom));
+
+    winDebug("winClipboardGetCachedTargets - %d targets for %s\n", n,
+             szSelectionNames[i]);
+
+    return TRUE;
+}
+
+/*
+ * Unlink and free an outgoing INCR transfer, and stop watching the
+ * requestor once nothing more is being sent to it
+ */
+
+static void
+winClipboardIncrFree(Display *pDisplay, Window iWindow,
+                     ClipboardIncrTransfer *pTransfer)
+{
+    ClipboardIncrTransfer **ppPrev;
+    ClipboardIncrTransfer *pOther;
+
+    for (ppPrev = &s_pIncrTransfers; *ppPrev; ppPrev = &(*ppPrev)->pNext) {
+        if (*ppPrev == pTransfer) {
+            *ppPrev = pTransfer->pNext;
+            break;
+        }
+    }
+
+    for (pOther = s_pIncrTransfers; pOther; pOther = pOther->pNext) {
+        if (pOther->requestor == pTransfer->requestor)
+            break;
+    }
+    if (!pOther && pTransfer->requestor != iWindow)
+        XSelectInput(pDisplay, pTransfer->requestor, NoEventMask);
+
+    if (pTransfer->fXFree)
+        XFree(pTransfer->data);
+    else
+        free(pTransfer->data);
+    free(pTransfer);
+}
+
+/*
+ * Start an outgoing INCR transfer, taking ownership of data
+ *
+ * The requestor is told the size with an INCR property, then each time it
+ * deletes the property the next chunk is written, ending with a zero-length
+ * property (ICCCM section 2.7.2).
+ */
+
+static Bool
+winClipboardIncrStart(Display *pDisplay, Window iWindow,
+                      XSelectionRequestEvent *pRequest,
+                      unsigned char *data, unsigned long int size,
+                      Bool fXFree, unsigned long int chunk,
+                      ClipboardAtoms *atoms)
+{
+    ClipboardIncrTransfer *pTransfer;
+    ClipboardIncrTransfer *pOld;
+    long lSize = size;
+    int iReturn;
+
+    /* A new request for the same property replaces any earlier transfer */
+    for (pOld = s_pIncrTransfers; pOld; pOld = pOld->pNext) {
+        if (pOld->requestor == pRequest->requestor
+            && pOld->property == pRequest->property) {
+            winClipboardIncrFree(pDisplay, iWindow, pOld);
+            break;
+        }
+    }
+
+    pTransfer = calloc(1, sizeof(ClipboardIncrTransfer));
+    if (!pTransfer)
+        return FALSE;
+
+    /* Watch for the requestor deleting the property */
+    if (pRequest->requestor != iWindow)
+        XSelectInput(pDisplay, pRequest->requestor, PropertyChangeMask);
+
+    iReturn = XChangeProperty(pDisplay,
+                              pRequest->requestor,
+                              pRequest->property,
+                              atoms->atomIncr,
+                              32,
+                              PropModeReplace,
+                              (unsigned char *) &lSize, 1);
+    if (iReturn == BadAlloc || iReturn == BadAtom
+        || iReturn == BadMatch || iReturn == BadValue
+        || iReturn == BadWindow) {
+        ErrorF("winClipboardIncrStart - XChangeProperty failed: %d\n",
+               iReturn);
+        free(pTransfer);
+        return FALSE;
+    }
+
+    pTransfer->requestor = pRequest->requestor;
+    pTransfer->property = pRequest->property;
+    pTransfer->target = pRequest->target;
+    pTransfer->data = data;
+    pTransfer->size = size;
+    pTransfer->offset = 0;
+    pTransfer->chunk = chunk;
+    pTransfer->fXFree = fXFree;
+    pTransfer->dwLastActivity = GetTickCount();
+
+    pTransfer->pNext = s_pIncrTransfers;
+    s_pIncrTransfers = pTransfer;
+
+    winDebug("winClipboardIncrStart - %lu bytes to window 0x%lx in chunks "
+             "of %lu\n", size, pRequest->requestor, chunk);
+
+    return TRUE;
+}
+
+/*
+ * Send the next chunk of an outgoing INCR transfer when the requestor has
+ * deleted the property holding the previous one
+ *
+ * Returns TRUE if the event belonged to an INCR transfer.
+ */
+
+static Bool
+winClipboardIncrContinue(Display *pDisplay, Window iWindow,
+                         XPropertyEvent *pEvent)
+{
+    ClipboardIncrTransfer *pTransfer;
+    unsigned long int chunk;
+
+    for (pTransfer = s_pIncrTransfers; pTransfer; pTransfer = pTransfer->pNext) {
+        if (pTransfer->requestor == pEvent->window
+            && pTransfer->property == pEvent->atom)
+            break;
+    }
+    if (!pTransfer)
+        return FALSE;
+
+    /* The final zero-length chunk has been taken, so we are done */
+    if (pTransfer->offset == pTransfer->size && pTransfer->chunk == 0) {
+        winClipboardIncrFree(pDisplay, iWindow, pTransfer);
+        return TRUE;
+    }
+
+    chunk = pTransfer->size - pTransfer->offset;
+    if (chunk > pTransfer->chunk)
+        chunk = pTransfer->chunk;
+
+    XChangeProperty(pDisplay,
+                    pTransfer->requestor,
+                    pTransfer->property,
+                    pTransfer->target,
+                    8,
+                    PropModeReplace,
+                    pTransfer->data + pTransfer->offset, chunk);
+    InterlockedExchangeAdd64(&g_llClipboardBytes, chunk);
+
+    pTransfer->offset += chunk;
+    pTransfer->dwLastActivity = GetTickCount();
+
+    /* Mark that the zero-length terminator has now been written */
+    if (chunk == 0)
+        pTransfer->chunk = 0;
+
+    return TRUE;
+}
+
+/*
+ * Abandon outgoing INCR transfers whose requestor has stopped reading
+ */
+
+static void
+winClipboardIncrExpire(Display *pDisplay, Window iWindow)
+{
+    ClipboardIncrTransfer *pTransfer = s_pIncrTransfers;
+    DWORD dwNow = GetTickCount();
+
+    while (pTransfer) {
+        ClipboardIncrTransfer *pNext = pTransfer->pNext;
+
+        if (dwNow - pTransfer->dwLastActivity > CLIP_INCR_TIMEOUT) {
+            ErrorF("winClipboardIncrExpire - INCR transfer to window 0x%lx "
+                   "timed out after %lu of %lu bytes\n",
+                   pTransfer->requestor, pTransfer->offset, pTransfer->size);
+            winClipboardIncrFree(pDisplay, iWindow, pTransfer);
+        }
+        pTransfer = pNext;
+    }
 }
 
 static int
@@ -151,6 +489,8 @@ winClipboardSelectionNotifyTargets(HWND hwnd, Window iWindow, Display *pDisplay,
   unsigned long after;
   Atom *prop;
 
+  data->targetList = NULL;
+
   /* Retrieve the selection data and delete the property */
   int iReturn = XGetWindowProperty(pDisplay,
                                    iWindow,
@@ -169,7 +509,15 @@ winClipboardSelectionNotifyTargets(HWND hwnd, Window iWindow, Display *pDisplay,
            "XGetWindowProperty () failed, aborting: %d\n", iReturn);
   } else {
     int i;
+    ClipboardSelectionCache *pCache;
+
     data->targetList = malloc((nitems+1)*sizeof(Atom));
+    if (!data->targetList) {
+        ErrorF("winClipboardFlushXEvents - SelectionNotify - "
+               "malloc failed for targetList, aborting.\n");
+        XFree(prop);
+        return WIN_XEVENTS_NOTIFY_TARGETS;
+    }
 
     for (i = 0; i < nitems; i++)
     {
@@ -192,11 +540,120 @@ winClipboardSelectionNotifyTargets(HWND hwnd, Window iWindow, Display *pDisplay,
     data->targetList[i] = 0;
 
     XFree(prop);
+
+    /* Remember the targets until the selection changes hands */
+    pCache = winClipboardCacheForReply(data, atoms);
+    if (pCache && !pCache->targetList) {
+        pCache->targetList = malloc((nitems+1)*sizeof(Atom));
+        if (pCache->targetList)
+            memcpy(pCache->targetList, data->targetList, (nitems+1)*sizeof(Atom));
+    }
   }
 
   return WIN_XEVENTS_NOTIFY_TARGETS;
 }
 
+/*
+ * Convert X selection data to Windows clipboard text
+ *
+ * Returns a global memory handle for SetClipboardData (), or NULL on failure.
+ */
+
+static HGLOBAL
+winClipboardTextPropertyToGlobal(Display *pDisplay, XTextProperty *pxtpText, Bool fUseUnicode, ClipboardAtoms *atoms)
+{
+    int iReturn = XConverterNotFound;
+    char **ppszTextList = NULL;
+    int iCount;
+    char *pszReturnData = NULL;
+    size_t iReturnDataLen = 0;
+    HGLOBAL hGlobal;
+
+#ifdef X_HAVE_UTF8_STRING
+    /*
+     * UTF8_STRING is already what we need for CF_UNICODETEXT, so convert
+     * it straight into the clipboard memory
+     */
+    if (fUseUnicode && pxtpText->encoding == atoms->atomUTF8String
+        && pxtpText->format == 8)
+        return winClipboardUNIXtoDOSGlobal((char *) pxtpText->value,
+                                           pxtpText->nitems, TRUE);
+#endif
+
+    if (fUseUnicode) {
+#ifdef X_HAVE_UTF8_STRING
+        /* Convert the text property to a text list */
+        iReturn = Xutf8TextPropertyToTextList(pDisplay,
+                                              pxtpText,
+                                              &ppszTextList, &iCount);
+#endif
+    }
+    else {
+        iReturn = XmbTextPropertyToTextList(pDisplay,
+                                            pxtpText,
+                                            &ppszTextList, &iCount);
+    }
+    if (iReturn == Success || iReturn > 0) {
+        /* Conversion succeeded or some unconvertible characters */
+        if (ppszTextList != NULL) {
+            int i;
+            for (i = 0; i < iCount; i++) {
+                iReturnDataLen += strlen(ppszTextList[i]);
+            }
+            pszReturnData = malloc(iReturnDataLen + 1);
+            if (pszReturnData) {
+                iReturnDataLen = 0;
+                for (i = 0; i < iCount; i++) {
+                    size_t iLen = strlen(ppszTextList[i]);
+
+                    memcpy(pszReturnData + iReturnDataLen, ppszTextList[i], iLen);
+                    iReturnDataLen += iLen;
+                }
+            }
+        }
+        else {
+            ErrorF("winClipboardFlushXEvents - SelectionNotify - "
+                   "X*TextPropertyToTextList list_return is NULL.\n");
+            pszReturnData = malloc(1);
+        }
+    }
+    else {
+        ErrorF("winClipboardFlushXEvents - SelectionNotify - "
+               "X*TextPropertyToTextList returned: ");
+        switch (iReturn) {
+        case XNoMemory:
+            ErrorF("XNoMemory\n");
+            break;
+        case XLocaleNotSupported:
+            ErrorF("XLocaleNotSupported\n");
+            break;
+        case XConverterNotFound:
+            ErrorF("XConverterNotFound\n");
+            break;
+        default:
+            ErrorF("%d\n", iReturn);
+            break;
+        }
+        pszReturnData = malloc(1);
+    }
+
+    if (ppszTextList)
+        XFreeStringList(ppszTextList);
+
+    if (!pszReturnData) {
+        ErrorF("winClipboardFlushXEvents - SelectionNotify "
+               "malloc failed for pszReturnData, aborting.\n");
+        return NULL;
+    }
+
+    /* Convert the X clipboard string to DOS format, in clipboard memory */
+    hGlobal = winClipboardUNIXtoDOSGlobal(pszReturnData, iReturnDataLen,
+                                          fUseUnicode);
+    free(pszReturnData);
+
+    return hGlobal;
+}
+
 static int
 winClipboardSelectionNotifyData(HWND hwnd, Window iWindow, Display *pDisplay, ClipboardConversionData *data, ClipboardAtoms *atoms)
 {
@@ -208,13 +665,8 @@ winClipboardSelectionNotifyData(HWND hwnd, Window iWindow, Display *pDisplay, Cl
     XTextProperty xtpText = { 0 };
     Bool fSetClipboardData = FALSE;
     int iReturn;
-    char **ppszTextList = NULL;
-    int iCount;
-    char *pszReturnData = NULL;
-    wchar_t *pwszUnicodeStr = NULL;
     HGLOBAL hGlobal = NULL;
-    char *pszConvertData = NULL;
-    char *pszGlobalData = NULL;
+    ClipboardSelectionCache *pCache;
 
     /* Retrieve the selection data and delete the property */
     iReturn = XGetWindowProperty(pDisplay,
@@ -250,10 +702,23 @@ winClipboardSelectionNotifyData(HWND hwnd, Window iWindow, Display *pDisplay, Cl
 
     /* INCR reply indicates the start of a incremental transfer */
     if (encoding == atoms->atomIncr) {
-        winDebug("winClipboardSelectionNotifyData: starting INCR, anticipated size %d\n", *(int *)value);
+        /* The anticipated size is only a lower bound, so allow for growth */
+        long anticipated = (nitems > 0) ? *(long *)value : 0;
+
+        winDebug("winClipboardSelectionNotifyData: starting INCR, anticipated size %ld\n", anticipated);
+        XFree(value);
+        free(data->incr);
         data->incrsize = 0;
-        data->incr = malloc(*(int *)value);
-        // XXX: if malloc failed, we have an error
+        data->incrallocated = (anticipated > CLIP_INCR_MIN_ALLOC) ? anticipated : CLIP_INCR_MIN_ALLOC;
+        data->incr = malloc(data->incrallocated);
+        if (!data->incr) {
+            ErrorF("winClipboardFlushXEvents - SelectionNotify - "
+                   "malloc of %lu bytes for INCR transfer failed, aborting.\n",
+                   data->incrallocated);
+            data->incrallocated = 0;
+            value = NULL;
+            goto winClipboardFlushXEvents_SelectionNotify_Done;
+        }
         return WIN_XEVENTS_SUCCESS;
     }
     else if (data->incr) {
@@ -269,9 +734,29 @@ winClipboardSelectionNotifyData(HWND hwnd, Window iWindow, Display *pDisplay, Cl
         else {
             /* Otherwise, continue appending the INCR data */
             winDebug("winClipboardSelectionNotifyData: INCR, %ld bytes\n", nitems);
-            data->incr = realloc(data->incr, data->incrsize + nitems);
+
+            /* Grow geometrically, so a large transfer isn't copied once per chunk */
+            if (data->incrsize + nitems > data->incrallocated) {
+                unsigned long int allocated = data->incrallocated * 2;
+                unsigned char *incr;
+
+                if (allocated < data->incrsize + nitems)
+                    allocated = data->incrsize + nitems;
+
+                incr = realloc(data->incr, allocated);
+                if (!incr) {
+                    ErrorF("winClipboardFlushXEvents - SelectionNotify - "
+                           "realloc of %lu bytes for INCR transfer failed, aborting.\n",
+                           allocated);
+                    goto winClipboardFlushXEvents_SelectionNotify_Done;
+                }
+                data->incr = incr;
+                data->incrallocated = allocated;
+            }
+
             memcpy(data->incr + data->incrsize, value, nitems);
             data->incrsize = data->incrsize + nitems;
+            XFree(value);
             return WIN_XEVENTS_SUCCESS;
         }
     }
@@ -284,117 +769,24 @@ winClipboardSelectionNotifyData(HWND hwnd, Window iWindow, Display *pDisplay, Cl
         xtpText.nitems = nitems;
     }
 
-    if (data->fUseUnicode) {
-#ifdef X_HAVE_UTF8_STRING
-        /* Convert the text property to a text list */
-        iReturn = Xutf8TextPropertyToTextList(pDisplay,
-                                              &xtpText,
-                                              &ppszTextList, &iCount);
-#endif
-    }
-    else {
-        iReturn = XmbTextPropertyToTextList(pDisplay,
-                                            &xtpText,
-                                            &ppszTextList, &iCount);
-    }
-    if (iReturn == Success || iReturn > 0) {
-        /* Conversion succeeded or some unconvertible characters */
-        if (ppszTextList != NULL) {
-            int i;
-            int iReturnDataLen = 0;
-            for (i = 0; i < iCount; i++) {
-                iReturnDataLen += strlen(ppszTextList[i]);
-            }
-            pszReturnData = malloc(iReturnDataLen + 1);
-            pszReturnData[0] = '\0';
-            for (i = 0; i < iCount; i++) {
-                strcat(pszReturnData, ppszTextList[i]);
-            }
-        }
-        else {
-            ErrorF("winClipboardFlushXEvents - SelectionNotify - "
-                   "X*TextPropertyToTextList list_return is NULL.\n");
-            pszReturnData = malloc(1);
-            pszReturnData[0] = '\0';
-        }
-    }
-    else {
-        ErrorF("winClipboardFlushXEvents - SelectionNotify - "
-               "X*TextPropertyToTextList returned: ");
-        switch (iReturn) {
-        case XNoMemory:
-            ErrorF("XNoMemory\n");
-            break;
-        case XLocaleNotSupported:
-            ErrorF("XLocaleNotSupported\n");
-            break;
-        case XConverterNotFound:
-            ErrorF("XConverterNotFound\n");
-            break;
-        default:
-            ErrorF("%d\n", iReturn);
-            break;
-        }
-        pszReturnData = malloc(1);
-        pszReturnData[0] = '\0';
-    }
-
-
-    if (ppszTextList)
-        XFreeStringList(ppszTextList);
-    ppszTextList = NULL;
-
-    /* Free the data returned from XGetWindowProperty */
-    XFree(value);
-    value = NULL;
-    nitems = 0;
-
-    /* Free any INCR data */
-    if (data->incr) {
-        free(data->incr);
-        data->incr = NULL;
-        data->incrsize = 0;
-    }
-
-    /* Convert the X clipboard string to DOS format */
-    winClipboardUNIXtoDOS(&pszReturnData, strlen(pszReturnData));
-
-    if (data->fUseUnicode) {
-        /* Find out how much space needed to convert MBCS to Unicode */
-        int iUnicodeLen = MultiByteToWideChar(CP_UTF8,
-                                              0,
-                                              pszReturnData, -1, NULL, 0);
-
-        /* NOTE: iUnicodeLen includes space for null terminator */
-        pwszUnicodeStr = malloc(sizeof(wchar_t) * iUnicodeLen);
-        if (!pwszUnicodeStr) {
-            ErrorF("winClipboardFlushXEvents - SelectionNotify "
-                   "malloc failed for pwszUnicodeStr, aborting.\n");
-
-            /* Abort */
-            goto winClipboardFlushXEvents_SelectionNotify_Done;
+    /*
+     * Remember small selections, so the other clipboard format can be
+     * rendered without asking the owner again
+     */
+    pCache = winClipboardCacheForReply(data, atoms);
+    if (pCache && xtpText.format == 8 && xtpText.nitems <= CLIP_CACHE_MAX_DATA) {
+        free(pCache->value);
+        pCache->value = malloc(xtpText.nitems + 1);
+        if (pCache->value) {
+            memcpy(pCache->value, xtpText.value, xtpText.nitems);
+            pCache->target = data->target;
+            pCache->encoding = xtpText.encoding;
+            pCache->format = xtpText.format;
+            pCache->nitems = xtpText.nitems;
         }
-
-        /* Do the actual conversion */
-        MultiByteToWideChar(CP_UTF8,
-                            0,
-                            pszReturnData,
-                            -1, pwszUnicodeStr, iUnicodeLen);
-
-        /* Allocate global memory for the X clipboard data */
-        hGlobal = GlobalAlloc(GMEM_MOVEABLE,
-                              sizeof(wchar_t) * iUnicodeLen);
-    }
-    else {
-        int iConvertDataLen = 0;
-        pszConvertData = strdup(pszReturnData);
-        iConvertDataLen = strlen(pszConvertData) + 1;
-
-        /* Allocate global memory for the X clipboard data */
-        hGlobal = GlobalAlloc(GMEM_MOVEABLE, iConvertDataLen);
     }
 
-    free(pszReturnData);
+    hGlobal = winClipboardTextPropertyToGlobal(pDisplay, &xtpText, data->fUseUnicode, atoms);
 
     /* Check that global memory was allocated */
     if (!hGlobal) {
@@ -405,54 +797,35 @@ winClipboardSelectionNotifyData(HWND hwnd, Window iWindow, Display *pDisplay, Cl
         goto winClipboardFlushXEvents_SelectionNotify_Done;
     }
 
-    /* Obtain a pointer to the global memory */
-    pszGlobalData = GlobalLock(hGlobal);
-    if (pszGlobalData == NULL) {
-        ErrorF("winClipboardFlushXEvents - Could not lock global "
-               "memory for clipboard transfer\n");
-
-        /* Abort */
-        goto winClipboardFlushXEvents_SelectionNotify_Done;
-    }
-
-    /* Copy the returned string into the global memory */
-    if (data->fUseUnicode) {
-        wcscpy((wchar_t *)pszGlobalData, pwszUnicodeStr);
-        free(pwszUnicodeStr);
-        pwszUnicodeStr = NULL;
-    }
-    else {
-        strcpy(pszGlobalData, pszConvertData);
-        free(pszConvertData);
-        pszConvertData = NULL;
-    }
-
-    /* Release the pointer to the global memory */
-    GlobalUnlock(hGlobal);
-    pszGlobalData = NULL;
-
     /* Push the selection data to the Windows clipboard */
-    if (SetClipboardData(((data->fUseUnicode) ? CF_UNICODETEXT : CF_TEXT), hGlobal)) fSetClipboardData = TRUE;
+    if (SetClipboardData(((data->fUseUnicode) ? CF_UNICODETEXT : CF_TEXT), hGlobal)) {
+        fSetClipboardData = TRUE;
+        InterlockedExchangeAdd64(&g_llClipboardBytes, xtpText.nitems);
+    }
 
     /* fSetClipboardData is TRUE if SetClipboardData successful */
 
     /*
-     * NOTE: Do not try to free pszGlobalData, it is owned by
+     * NOTE: Do not try to free hGlobal, it is owned by
      * Windows after the call to SetClipboardData ().
      */
 
  winClipboardFlushXEvents_SelectionNotify_Done:
     /* Free allocated resources */
-    if (ppszTextList)
-        XFreeStringList(ppszTextList);
     if (value) {
         XFree(value);
         value = NULL;
         nitems = 0;
     }
-    free((data->fUseUnicode) ? (void *)pwszUnicodeStr : (void *)pszConvertData);
-    if (hGlobal && pszGlobalData)
-        GlobalUnlock(hGlobal);
+
+    /* Free any INCR data */
+    if (data->incr) {
+        free(data->incr);
+        data->incr = NULL;
+        data->incrsize = 0;
+        data->incrallocated = 0;
+    }
+
     if (!fSetClipboardData) {
         if (hGlobal) GlobalFree(hGlobal); /* Free the buffer if clipboard didn't take it */
         SetClipboardData(CF_UNICODETEXT, NULL);
@@ -461,6 +834,44 @@ winClipboardSelectionNotifyData(HWND hwnd, Window iWindow, Display *pDisplay, Cl
     return WIN_XEVENTS_NOTIFY_DATA;
 }
 
+/*
+ * Render the Windows clipboard from the data cached for selection, if the
+ * current owner has already converted it to target for us
+ */
+
+Bool
+winClipboardRenderCachedData(Display *pDisplay, Atom selection, Atom target,
+                             Bool fUseUnicode, ClipboardAtoms *atoms)
+{
+    int i = winClipboardSelectionIndex(selection, atoms);
+    XTextProperty xtpText = { 0 };
+    HGLOBAL hGlobal;
+
+    if (i == CLIP_OWN_NONE || !s_selectionCache[i].value
+        || s_selectionCache[i].target != target)
+        return FALSE;
+
+    xtpText.value = s_selectionCache[i].value;
+    xtpText.encoding = s_selectionCache[i].encoding;
+    xtpText.format = s_selectionCache[i].format;
+    xtpText.nitems = s_selectionCache[i].nitems;
+
+    hGlobal = winClipboardTextPropertyToGlobal(pDisplay, &xtpText, fUseUnicode, atoms);
+    if (!hGlobal)
+        return FALSE;
+
+    if (!SetClipboardData(fUseUnicode ? CF_UNICODETEXT : CF_TEXT, hGlobal)) {
+        GlobalFree(hGlobal);
+        return FALSE;
+    }
+    InterlockedExchangeAdd64(&g_llClipboardBytes, xtpText.nitems);
+
+    winDebug("winClipboardRenderCachedData - %lu bytes of %s from the cache\n",
+             xtpText.nitems, szSelectionNames[i]);
+
+    return TRUE;
+}
+
 /*
  * Process any pending X events
  */
@@ -474,6 +885,10 @@ winClipboardFlushXEvents(HWND hwnd,
     Atom atomCompoundText = atoms->atomCompoundText;
     Atom atomTargets = atoms->atomTargets;
 
+    /* Drop outgoing INCR transfers the requestor has given up on */
+    if (s_pIncrTransfers)
+        winClipboardIncrExpire(pDisplay, iWindow);
+
     /* Process all pending events */
     while (XPending(pDisplay)) {
         XTextProperty xtpText = { 0 };
@@ -484,6 +899,9 @@ winClipboardFlushXEvents(HWND hwnd,
         HGLOBAL hGlobal = NULL;
         XICCEncodingStyle xiccesStyle;
         char *pszConvertData = NULL;
+        size_t iConvertDataLen = 0;
+        unsigned char *pValue = NULL;
+        unsigned long int nValue = 0;
         char *pszTextList[2] = { NULL };
         Bool fAbort = FALSE;
         Bool fCloseClipboard = FALSE;
@@ -655,64 +1073,90 @@ winClipboardFlushXEvents(HWND hwnd,
                 goto winClipboardFlushXEvents_SelectionRequest_Done;
             }
             pszGlobalData = (char *) GlobalLock(hGlobal);
+            if (!pszGlobalData) {
+                ErrorF("winClipboardFlushXEvents - SelectionRequest - "
+                       "GlobalLock () failed: %08x\n", (unsigned int)GetLastError());
 
-            /* Convert the Unicode string to UTF8 (MBCS) */
-            if (data->fUseUnicode) {
-                int iConvertDataLen = WideCharToMultiByte(CP_UTF8,
-                                                      0,
-                                                      (LPCWSTR) pszGlobalData,
-                                                      -1, NULL, 0, NULL, NULL);
-                /* NOTE: iConvertDataLen includes space for null terminator */
-                pszConvertData = malloc(iConvertDataLen);
-                WideCharToMultiByte(CP_UTF8,
-                                    0,
-                                    (LPCWSTR) pszGlobalData,
-                                    -1,
-                                    pszConvertData,
-                                    iConvertDataLen, NULL, NULL);
-            }
-            else {
-                pszConvertData = strdup(pszGlobalData);
+                /* Abort */
+                fAbort = TRUE;
+                goto winClipboardFlushXEvents_SelectionRequest_Done;
             }
 
-            /* Convert DOS string to UNIX string */
-            winClipboardDOStoUNIX(pszConvertData, strlen(pszConvertData));
+            /* Convert the DOS string to a UNIX string, and Unicode to UTF8 (MBCS) */
+            if (data->fUseUnicode)
+                iConvertDataLen = wcsnlen((wchar_t *) pszGlobalData,
+                                          GlobalSize(hGlobal) / sizeof(wchar_t));
+            else
+                iConvertDataLen = strnlen(pszGlobalData, GlobalSize(hGlobal));
 
-            /* Setup our text list */
-            pszTextList[0] = pszConvertData;
-            pszTextList[1] = NULL;
+            pszConvertData = winClipboardDOStoUNIXAlloc(pszGlobalData,
+                                                        iConvertDataLen,
+                                                        data->fUseUnicode,
+                                                        &iConvertDataLen);
 
-            /* Initialize the text property */
-            xtpText.value = NULL;
-            xtpText.nitems = 0;
+            /* Release the clipboard data, we have our own copy now */
+            GlobalUnlock(hGlobal);
+            pszGlobalData = NULL;
+            fCloseClipboard = FALSE;
+            CloseClipboard();
 
-            /* Create the text property from the text list */
-            if (data->fUseUnicode) {
-#ifdef X_HAVE_UTF8_STRING
-                iReturn = Xutf8TextListToTextProperty(pDisplay,
-                                                      pszTextList,
-                                                      1, xiccesStyle, &xtpText);
-#endif
-            }
-            else {
-                iReturn = XmbTextListToTextProperty(pDisplay,
-                                                    pszTextList,
-                                                    1, xiccesStyle, &xtpText);
-            }
-            if (iReturn == XNoMemory || iReturn == XLocaleNotSupported) {
+            if (!pszConvertData) {
                 ErrorF("winClipboardFlushXEvents - SelectionRequest - "
-                       "X*TextListToTextProperty failed: %d\n", iReturn);
+                       "malloc failed for pszConvertData, aborting.\n");
 
                 /* Abort */
                 fAbort = TRUE;
                 goto winClipboardFlushXEvents_SelectionRequest_Done;
             }
 
-            /* Free the converted string */
-            free(pszConvertData);
-            pszConvertData = NULL;
+#ifdef X_HAVE_UTF8_STRING
+            /* UTF8_STRING needs no further conversion */
+            if (data->fUseUnicode && xiccesStyle == XUTF8StringStyle) {
+                pValue = (unsigned char *) pszConvertData;
+                nValue = iConvertDataLen;
+            }
+            else
+#endif
+            {
+                /* Setup our text list */
+                pszTextList[0] = pszConvertData;
+                pszTextList[1] = NULL;
 
-            /* data will fit into a single X request (INCR not yet supported) */
+                /* Initialize the text property */
+                xtpText.value = NULL;
+                xtpText.nitems = 0;
+
+                /* Create the text property from the text list */
+                if (data->fUseUnicode) {
+#ifdef X_HAVE_UTF8_STRING
+                    iReturn = Xutf8TextListToTextProperty(pDisplay,
+                                                          pszTextList,
+                                                          1, xiccesStyle, &xtpText);
+#endif
+                }
+                else {
+                    iReturn = XmbTextListToTextProperty(pDisplay,
+                                                        pszTextList,
+                                                        1, xiccesStyle, &xtpText);
+                }
+                if (iReturn == XNoMemory || iReturn == XLocaleNotSupported) {
+                    ErrorF("winClipboardFlushXEvents - SelectionRequest - "
+                           "X*TextListToTextProperty failed: %d\n", iReturn);
+
+                    /* Abort */
+                    fAbort = TRUE;
+                    goto winClipboardFlushXEvents_SelectionRequest_Done;
+                }
+
+                /* Free the converted string */
+                free(pszConvertData);
+                pszConvertData = NULL;
+
+                pValue = xtpText.value;
+                nValue = xtpText.nitems;
+            }
+
+            /* Hand data that won't fit into a single X request over in an INCR transfer */
             {
                 long unsigned int maxreqsize = XExtendedMaxRequestSize(pDisplay);
                 if (maxreqsize == 0)
@@ -721,44 +1165,60 @@ winClipboardFlushXEvents(HWND hwnd,
                 /* covert to bytes and allow for allow for X_ChangeProperty request */
                 maxreqsize = maxreqsize*4 - 24;
 
-                if (xtpText.nitems > maxreqsize) {
-                    ErrorF("winClipboardFlushXEvents - clipboard data size %lu greater than maximum %lu\n", xtpText.nitems, maxreqsize);
-
-                    /* Abort */
-                    fAbort = TRUE;
-                    goto winClipboardFlushXEvents_SelectionRequest_Done;
+                if (nValue > maxreqsize) {
+                    winDebug("winClipboardFlushXEvents - clipboard data size %lu greater than maximum %lu, using INCR\n", nValue, maxreqsize);
+
+                    if (!winClipboardIncrStart(pDisplay, iWindow,
+                                               &event.xselectionrequest,
+                                               pValue, nValue,
+                                               pValue == xtpText.value,
+                                               XMaxRequestSize(pDisplay)*4 - 24,
+                                               atoms)) {
+                        /* Abort */
+                        fAbort = TRUE;
+                        goto winClipboardFlushXEvents_SelectionRequest_Done;
+                    }
+
+                    /* The transfer owns the data now */
+                    if (pValue == xtpText.value)
+                        xtpText.value = NULL;
+                    else
+                        pszConvertData = NULL;
+                    pValue = NULL;
+                    nValue = 0;
                 }
             }
 
             /* Copy the clipboard text to the requesting window */
-            iReturn = XChangeProperty(pDisplay,
-                                      event.xselectionrequest.requestor,
-                                      event.xselectionrequest.property,
-                                      event.xselectionrequest.target,
-                                      8,
-                                      PropModeReplace,
-                                      xtpText.value, xtpText.nitems);
-            if (iReturn == BadAlloc || iReturn == BadAtom
-                || iReturn == BadMatch || iReturn == BadValue
-                || iReturn == BadWindow) {
-                ErrorF("winClipboardFlushXEvents - SelectionRequest - "
-                       "XChangeProperty failed: %d\n", iReturn);
+            if (pValue) {
+                iReturn = XChangeProperty(pDisplay,
+                                          event.xselectionrequest.requestor,
+                                          event.xselectionrequest.property,
+                                          event.xselectionrequest.target,
+                                          8,
+                                          PropModeReplace,
+                                          pValue, nValue);
+                if (iReturn == BadAlloc || iReturn == BadAtom
+                    || iReturn == BadMatch || iReturn == BadValue
+                    || iReturn == BadWindow) {
+                    ErrorF("winClipboardFlushXEvents - SelectionRequest - "
+                           "XChangeProperty failed: %d\n", iReturn);
 
-                /* Abort */
-                fAbort = TRUE;
-                goto winClipboardFlushXEvents_SelectionRequest_Done;
+                    /* Abort */
+                    fAbort = TRUE;
+                    goto winClipboardFlushXEvents_SelectionRequest_Done;
+                }
+                InterlockedExchangeAdd64(&g_llClipboardBytes, nValue);
             }
 
-            /* Release the clipboard data */
-            GlobalUnlock(hGlobal);
-            pszGlobalData = NULL;
-            fCloseClipboard = FALSE;
-            CloseClipboard();
-
             /* Clean up */
-            XFree(xtpText.value);
-            xtpText.value = NULL;
-            xtpText.nitems = 0;
+            if (xtpText.value) {
+                XFree(xtpText.value);
+                xtpText.value = NULL;
+                xtpText.nitems = 0;
+            }
+            free(pszConvertData);
+            pszConvertData = NULL;
 
             /* Setup selection notify event */
             eventSelection.type = SelectionNotify;
@@ -878,6 +1338,11 @@ winClipboardFlushXEvents(HWND hwnd,
             break;
 
         case PropertyNotify:
+            /* If we are sending INCR, the requestor wants the next chunk */
+            if (event.xproperty.state == PropertyDelete &&
+                winClipboardIncrContinue(pDisplay, iWindow, &event.xproperty))
+                break;
+
             /* If INCR is in progress, collect the data */
             if (data->incr &&
                 (event.xproperty.atom == atoms->atomLocalProperty) &&
@@ -72,6 +72,10 @@ winProcEstablishConnection(ClientPtr client)
     static int s_iCallCount = 0;
     static unsigned long s_ulServerGeneration = 0;
 
+    /* The first connection the server ever gets */
+    if (s_ulServerGeneration == 0 && s_iCallCount == 0)
+        winStartupMark("First client connecting");
+
   #ifdef WINDBG
     if (s_iCallCount == 0)
         winDebug("winProcEstablishConnection - Hello\n");
@@ -194,20 +194,22 @@ winStoreColors(ColormapPtr pmap, int ndef, xColorItem * pdefs)
 
     /* Save the new colors in the colormap privates */
     for (i = 0; i < ndef; ++i) {
+        Pixel pixel = pdefs[i].pixel;
+
         /* Adjust the colors from the X color spec to the Windows color spec */
         nRed = pdefs[i].red >> 8;
         nGreen = pdefs[i].green >> 8;
         nBlue = pdefs[i].blue >> 8;
 
         /* Copy the colors to a palette entry table */
-        pCmapPriv->peColors[pdefs[0].pixel + i].peRed = nRed;
-        pCmapPriv->peColors[pdefs[0].pixel + i].peGreen = nGreen;
-        pCmapPriv->peColors[pdefs[0].pixel + i].peBlue = nBlue;
+        pCmapPriv->peColors[pixel].peRed = nRed;
+        pCmapPriv->peColors[pixel].peGreen = nGreen;
+        pCmapPriv->peColors[pixel].peBlue = nBlue;
 
         /* Copy the colors to a RGBQUAD table */
-        pCmapPriv->rgbColors[pdefs[0].pixel + i].rgbRed = nRed;
-        pCmapPriv->rgbColors[pdefs[0].pixel + i].rgbGreen = nGreen;
-        pCmapPriv->rgbColors[pdefs[0].pixel + i].rgbBlue = nBlue;
+        pCmapPriv->rgbColors[pixel].rgbRed = nRed;
+        pCmapPriv->rgbColors[pixel].rgbGreen = nGreen;
+        pCmapPriv->rgbColors[pixel].rgbBlue = nBlue;
 
         winDebug("winStoreColors - nRed %d nGreen %d nBlue %d\n",
                  nRed, nGreen, nBlue);
@@ -221,6 +223,28 @@ winStoreColors(ColormapPtr pmap, int ndef, xColorItem * pdefs)
     }
 }
 
+/*
+ * winColormapBlockHandler - Show the installed colormap's changes
+ *
+ * Engines which defer showing stored colors, as an AllocColor storm would
+ * otherwise redraw the screen once per color, set fColormapDirty instead.
+ */
+
+void
+winColormapBlockHandler(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    if (!pScreenPriv->fColormapDirty)
+        return;
+    pScreenPriv->fColormapDirty = FALSE;
+
+    if (pScreenPriv->pcmapInstalled &&
+        !(*pScreenPriv->pwinInstallColormap) (pScreenPriv->pcmapInstalled))
+        ErrorF("winColormapBlockHandler - Screen specific colormap install "
+               "procedure failed\n");
+}
+
 /* See Porting Layer Definition - p. 30 */
 static void
 winResolveColor(unsigned short *pred,
@@ -501,6 +501,38 @@ winConfigKeyboard(DeviceIntPtr pDevice)
     return TRUE;
 }
 
+/* Fill the compiled keymap cache with the keymap of every known layout */
+void
+winPrecacheKeymaps(void)
+{
+    WinKBLayoutPtr pLayout;
+    XkbRMLVOSet dflts, rmlvo;
+    int nCached = 0, nFailed = 0;
+
+    XkbGetRulesDflts(&dflts);
+    rmlvo.rules = g_cmdline.xkbRules ? g_cmdline.xkbRules : dflts.rules;
+
+    for (pLayout = winKBLayouts; pLayout->winlayout != -1; pLayout++) {
+        rmlvo.model = (char *) pLayout->xkbmodel;
+        rmlvo.layout = (char *) pLayout->xkblayout;
+        rmlvo.variant = (char *) pLayout->xkbvariant;
+        rmlvo.options = (char *) pLayout->xkboptions;
+
+        if (XkbDDXPrecacheKeymap(&rmlvo))
+            nCached++;
+        else {
+            ErrorF("winPrecacheKeymaps - Could not compile keymap for "
+                   "\"%s\"\n", pLayout->layoutname);
+            nFailed++;
+        }
+    }
+
+    XkbFreeRMLVOSet(&dflts, FALSE);
+
+    ErrorF("winPrecacheKeymaps - Cached %d keymaps, %d failed\n",
+           nCached, nFailed);
+}
+
 #ifdef XWIN_XF86CONFIG
 Bool
 winConfigMouse(DeviceIntPtr pDevice)
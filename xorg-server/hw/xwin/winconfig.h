@@ -188,6 +188,7 @@ Bool winConfigFiles(void);
 Bool winConfigOptions(void);
 Bool winConfigScreens(void);
 Bool winConfigKeyboard(DeviceIntPtr pDevice);
+void winPrecacheKeymaps(void);
 Bool winConfigMouse(DeviceIntPtr pDevice);
 
 typedef struct {
@@ -44,6 +44,9 @@ static Bool
 static Bool
  winAdjustForAutoHide(RECT * prcWorkArea, winScreenInfo * pScreenInfo);
 
+static void
+ winResolveScale(winScreenInfo * pScreenInfo);
+
 /*
  * Create a full screen window
  */
@@ -151,6 +154,9 @@ winCreateBoundingWindowWindowed(ScreenPtr pScreen)
     winDebug("winCreateBoundingWindowWindowed - Current w: %d h: %d\n",
              (int) pScreenInfo->dwWidth, (int) pScreenInfo->dwHeight);
 
+    /* Settle how many Windows pixels an X pixel covers */
+    winResolveScale(pScreenInfo);
+
     /* Set the common window style flags */
     dwWindowStyle = WS_OVERLAPPED | WS_SYSMENU | WS_MINIMIZEBOX;
 
@@ -235,6 +241,10 @@ winCreateBoundingWindowWindowed(ScreenPtr pScreen)
         winDebug("winCreateBoundingWindowWindowed - User gave height "
                  "and width\n");
 
+        /* The user gave the size of the X screen */
+        iWidth = winScaleToWindows(pScreenInfo, iWidth);
+        iHeight = winScaleToWindows(pScreenInfo, iHeight);
+
         /* Adjust the window width and height for borders and title bar */
         if (pScreenInfo->fDecoration
 #ifdef XWIN_MULTIWINDOWEXTWM
@@ -368,8 +378,10 @@ winCreateBoundingWindowWindowed(ScreenPtr pScreen)
          * than the viewport size that we calculated by subtracting
          * the size of the borders and caption.
          */
-        pScreenInfo->dwWidth = rcClient.right - rcClient.left;
-        pScreenInfo->dwHeight = rcClient.bottom - rcClient.top;
+        pScreenInfo->dwWidth =
+            winScaleToX(pScreenInfo, rcClient.right - rcClient.left);
+        pScreenInfo->dwHeight =
+            winScaleToX(pScreenInfo, rcClient.bottom - rcClient.top);
     }
 
 #if 0
@@ -451,6 +463,51 @@ winCreateBoundingWindowWindowed(ScreenPtr pScreen)
     return TRUE;
 }
 
+/*
+ * Work out the -scale factor, falling back to no scaling where only
+ * Windows could do it
+ */
+
+static void
+winResolveScale(winScreenInfo * pScreenInfo)
+{
+    if (pScreenInfo->dwScale == WIN_SCALE_AUTO) {
+        HDC hdc = GetDC(NULL);
+
+        /* We are system DPI aware, so this is the Windows scaling */
+        pScreenInfo->dwScale = WIN_DEFAULT_SCALE;
+        if (hdc) {
+            pScreenInfo->dwScale =
+                max(MulDiv(GetDeviceCaps(hdc, LOGPIXELSX), 100,
+                           WIN_DEFAULT_DPI), WIN_DEFAULT_SCALE);
+            ReleaseDC(NULL, hdc);
+        }
+    }
+
+    if (pScreenInfo->dwScale == WIN_DEFAULT_SCALE)
+        return;
+
+    /*
+     * The D3D11 engine scales when it presents; the other engines blit
+     * pixel for pixel, and the rootless modes hand windows to Windows.
+     */
+    if (pScreenInfo->dwEngine != WIN_SERVER_SHADOW_D3D11
+#ifdef XWIN_MULTIWINDOWEXTWM
+        || pScreenInfo->fMWExtWM
+#endif
+        || pScreenInfo->fRootless
+        || pScreenInfo->fMultiWindow
+        || pScreenInfo->iResizeMode == resizeWithScrollbars) {
+        ErrorF("winResolveScale - -scale needs the D3D11 engine in a "
+               "windowed screen without scrollbars, not scaling\n");
+        pScreenInfo->dwScale = WIN_DEFAULT_SCALE;
+        return;
+    }
+
+    winDebug("winResolveScale - Scaling X pixels to %d%%\n",
+             (int) pScreenInfo->dwScale);
+}
+
 /*
  * Find the work area of all attached monitors
  */
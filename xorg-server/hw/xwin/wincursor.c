@@ -43,6 +43,29 @@
 
 #define BRIGHTNESS(x) (x##Red * 0.299 + x##Green * 0.587 + x##Blue * 0.114)
 
+/*
+ * Converted cursors are kept in a small cache shared by all screens, keyed
+ * by the cursor's content, so animated cursors and clients that define the
+ * same cursor over and over only build each HCURSOR once.
+ */
+#define WIN_CURSOR_CACHE_SIZE 32
+
+typedef struct {
+    HCURSOR hCursor;
+    uint32_t hash;
+    unsigned long lastUse;
+    int sm_cx, sm_cy;
+    unsigned short width, height, xhot, yhot;
+    unsigned short fore[3], back[3];
+    Bool emptyMask;
+    Bool argb;
+    unsigned char *pData;       /* copy of source, mask and argb */
+    size_t cbData;
+} winCursorCacheEntryRec;
+
+static winCursorCacheEntryRec s_cursorCache[WIN_CURSOR_CACHE_SIZE];
+static unsigned long s_ulCursorCacheTick;
+
 #ifdef _MSC_VER
 #define min(a,b) (((a) < (b)) ? (a) : (b))
 #define max(a,b) (((a) > (b)) ? (a) : (b))
@@ -107,7 +130,10 @@ winPointerWarpCursor(DeviceIntPtr pDev, ScreenPtr pScreen, int x, int y)
          * Update the Windows cursor position so that we don't
          * immediately warp back to the current position.
          */
-        SetCursorPos(rcClient.left + x, rcClient.top + y);
+        SetCursorPos(rcClient.left + winScaleToWindows(pScreenPriv->pScreenInfo,
+                                                       x),
+                     rcClient.top + winScaleToWindows(pScreenPriv->pScreenInfo,
+                                                      y));
     }
 
     /* Call the mi warp procedure to do the actual warping in X. */
@@ -125,16 +151,22 @@ winCrossScreen(ScreenPtr pScreen, Bool fEntering)
 {
 }
 
+#define R2(n) n, n + 2 * 64, n + 1 * 64, n + 3 * 64
+#define R4(n) R2(n), R2(n + 2 * 16), R2(n + 1 * 16), R2(n + 3 * 16)
+#define R6(n) R4(n), R4(n + 2 * 4), R4(n + 1 * 4), R4(n + 3 * 4)
+
+static const unsigned char s_abReverse[256] = {
+    R6(0), R6(2), R6(1), R6(3)
+};
+
+#undef R2
+#undef R4
+#undef R6
+
 static unsigned char
 reverse(unsigned char c)
 {
-    int i;
-    unsigned char ret = 0;
-
-    for (i = 0; i < 8; ++i) {
-        ret |= ((c >> i) & 1) << (7 - i);
-    }
-    return ret;
+    return s_abReverse[c];
 }
 
 /*
@@ -416,6 +448,195 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
     return hCursor;
 }
 
+static size_t
+winCursorBitmapBytes(CursorBitsPtr bits)
+{
+    return BitmapBytePad(bits->width) * bits->height;
+}
+
+static size_t
+winCursorDataBytes(CursorBitsPtr bits)
+{
+    size_t cb = 2 * winCursorBitmapBytes(bits);
+
+    if (bits->argb)
+        cb += (size_t) bits->width * bits->height * sizeof(CARD32);
+    return cb;
+}
+
+/* FNV-1a */
+static uint32_t
+winCursorHashBytes(uint32_t hash, const void *pv, size_t cb)
+{
+    const unsigned char *pb = pv;
+
+    while (cb--)
+        hash = (hash ^ *pb++) * 16777619u;
+    return hash;
+}
+
+static uint32_t
+winCursorHash(CursorPtr pCursor)
+{
+    CursorBitsPtr bits = pCursor->bits;
+    size_t cbBitmap = winCursorBitmapBytes(bits);
+    uint32_t hash = 2166136261u;
+
+    hash = winCursorHashBytes(hash, bits->source, cbBitmap);
+    hash = winCursorHashBytes(hash, bits->mask, cbBitmap);
+    if (bits->argb)
+        hash = winCursorHashBytes(hash, bits->argb,
+                                  (size_t) bits->width * bits->height *
+                                  sizeof(CARD32));
+    return hash;
+}
+
+static Bool
+winCursorCacheMatch(const winCursorCacheEntryRec * pEntry,
+                    ScreenPtr pScreen, CursorPtr pCursor, uint32_t hash)
+{
+    winScreenPriv(pScreen);
+    CursorBitsPtr bits = pCursor->bits;
+    size_t cbBitmap;
+
+    if (!pEntry->hCursor || pEntry->hash != hash
+        || pEntry->sm_cx != pScreenPriv->cursor.sm_cx
+        || pEntry->sm_cy != pScreenPriv->cursor.sm_cy
+        || pEntry->width != bits->width || pEntry->height != bits->height
+        || pEntry->xhot != bits->xhot || pEntry->yhot != bits->yhot
+        || pEntry->emptyMask != bits->emptyMask
+        || pEntry->argb != (bits->argb != NULL)
+        || pEntry->fore[0] != pCursor->foreRed
+        || pEntry->fore[1] != pCursor->foreGreen
+        || pEntry->fore[2] != pCursor->foreBlue
+        || pEntry->back[0] != pCursor->backRed
+        || pEntry->back[1] != pCursor->backGreen
+        || pEntry->back[2] != pCursor->backBlue)
+        return FALSE;
+
+    cbBitmap = winCursorBitmapBytes(bits);
+    return memcmp(pEntry->pData, bits->source, cbBitmap) == 0
+        && memcmp(pEntry->pData + cbBitmap, bits->mask, cbBitmap) == 0
+        && (!bits->argb
+            || memcmp(pEntry->pData + 2 * cbBitmap, bits->argb,
+                      pEntry->cbData - 2 * cbBitmap) == 0);
+}
+
+/* Whether some screen currently shows hCursor */
+static Bool
+winCursorInUse(HCURSOR hCursor)
+{
+    int i;
+
+    for (i = 0; i < screenInfo.numScreens; ++i) {
+        winScreenPriv(screenInfo.screens[i]);
+
+        if (pScreenPriv && pScreenPriv->cursor.handle == hCursor)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/*
+ * Get the HCURSOR for pCursor from the cache, converting it on a miss.
+ * Returns NULL if the cursor couldn't be converted.
+ */
+static HCURSOR
+winCursorCacheLoad(ScreenPtr pScreen, CursorPtr pCursor)
+{
+    winScreenPriv(pScreen);
+    CursorBitsPtr bits = pCursor->bits;
+    winCursorCacheEntryRec *pEntry = NULL;
+    uint32_t hash = winCursorHash(pCursor);
+    HCURSOR hCursor;
+    size_t cbBitmap;
+    int i;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; ++i) {
+        if (winCursorCacheMatch(&s_cursorCache[i], pScreen, pCursor, hash)) {
+            s_cursorCache[i].lastUse = ++s_ulCursorCacheTick;
+            return s_cursorCache[i].hCursor;
+        }
+    }
+
+    hCursor = winLoadCursor(pScreen, pCursor, pScreen->myNum);
+    if (!hCursor)
+        return NULL;
+
+    /* Take an empty entry, or else the least recently used idle one */
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; ++i) {
+        winCursorCacheEntryRec *pCandidate = &s_cursorCache[i];
+
+        if (!pCandidate->hCursor) {
+            pEntry = pCandidate;
+            break;
+        }
+        if (winCursorInUse(pCandidate->hCursor))
+            continue;
+        if (!pEntry || pCandidate->lastUse < pEntry->lastUse)
+            pEntry = pCandidate;
+    }
+
+    /* Every entry is on screen; the caller destroys this one when done */
+    if (!pEntry)
+        return hCursor;
+
+    if (pEntry->hCursor) {
+        DestroyCursor(pEntry->hCursor);
+        free(pEntry->pData);
+        pEntry->hCursor = NULL;
+        pEntry->pData = NULL;
+    }
+
+    pEntry->cbData = winCursorDataBytes(bits);
+    pEntry->pData = malloc(pEntry->cbData);
+    if (!pEntry->pData)
+        return hCursor;
+
+    cbBitmap = winCursorBitmapBytes(bits);
+    memcpy(pEntry->pData, bits->source, cbBitmap);
+    memcpy(pEntry->pData + cbBitmap, bits->mask, cbBitmap);
+    if (bits->argb)
+        memcpy(pEntry->pData + 2 * cbBitmap, bits->argb,
+               pEntry->cbData - 2 * cbBitmap);
+
+    pEntry->hCursor = hCursor;
+    pEntry->hash = hash;
+    pEntry->lastUse = ++s_ulCursorCacheTick;
+    pEntry->sm_cx = pScreenPriv->cursor.sm_cx;
+    pEntry->sm_cy = pScreenPriv->cursor.sm_cy;
+    pEntry->width = bits->width;
+    pEntry->height = bits->height;
+    pEntry->xhot = bits->xhot;
+    pEntry->yhot = bits->yhot;
+    pEntry->emptyMask = bits->emptyMask;
+    pEntry->argb = bits->argb != NULL;
+    pEntry->fore[0] = pCursor->foreRed;
+    pEntry->fore[1] = pCursor->foreGreen;
+    pEntry->fore[2] = pCursor->foreBlue;
+    pEntry->back[0] = pCursor->backRed;
+    pEntry->back[1] = pCursor->backGreen;
+    pEntry->back[2] = pCursor->backBlue;
+
+    return hCursor;
+}
+
+/*
+ * Let go of a cursor handle which is no longer shown.  Cached handles stay
+ * around for reuse, anything else is destroyed.
+ */
+static void
+winCursorCacheRelease(HCURSOR hCursor)
+{
+    int i;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; ++i)
+        if (s_cursorCache[i].hCursor == hCursor)
+            return;
+
+    DestroyCursor(hCursor);
+}
+
 /*
 ===========================================================================
 
@@ -434,8 +655,6 @@ winRealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
     if (pCursor == NULL || pCursor->bits == NULL)
         return FALSE;
 
-    /* FIXME: cache ARGB8888 representation? */
-
     return TRUE;
 }
 
@@ -497,19 +716,17 @@ winSetCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor, int x,
         }
     }
     else {
-        if (pScreenPriv->cursor.handle) {
-            if (!bInhibit)
-                SetCursor(NULL);
-            DestroyCursor(pScreenPriv->cursor.handle);
-            pScreenPriv->cursor.handle = NULL;
-        }
-        pScreenPriv->cursor.handle =
-            winLoadCursor(pScreen, pCursor, pScreen->myNum);
+        HCURSOR hOld = pScreenPriv->cursor.handle;
+
+        pScreenPriv->cursor.handle = winCursorCacheLoad(pScreen, pCursor);
         winDebug("winSetCursor: handle=%p\n", pScreenPriv->cursor.handle); 
 
         if (!bInhibit)
             SetCursor(pScreenPriv->cursor.handle);
 
+        if (hOld && hOld != pScreenPriv->cursor.handle)
+            winCursorCacheRelease(hOld);
+
         if (!pScreenPriv->cursor.visible) {
             if (!bInhibit && g_fSoftwareCursor)
                 ShowCursor(TRUE);
@@ -31,21 +31,194 @@
 #ifdef HAVE_XWIN_CONFIG_H
 #include <xwin-config.h>
 #endif
+#define COBJMACROS
 #include "win.h"
 #include "winmsg.h"
 
+#pragma push_macro("Status")
+#undef Status
+#define Status wStatus
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#pragma pop_macro("Status")
+
 /*
  * Global variables for function pointers into
  * dynamically loaded libraries
  */
 FARPROC g_fpDirectDrawCreate = NULL;
 FARPROC g_fpDirectDrawCreateClipper = NULL;
+FARPROC g_fpD3D11CreateDevice = NULL;
 
 /*
   module handle for dynamically loaded directdraw library
 */
 static HMODULE g_hmodDirectDraw = NULL;
 
+/*
+  module handle for dynamically loaded direct3d 11 library
+*/
+static HMODULE g_hmodD3D11 = NULL;
+
+/*
+ * Check that we can create a Direct3D 11 device whose DXGI factory
+ * knows about flip-model swap chains (DXGI 1.2, Windows 8 and later)
+ */
+
+static Bool
+winDetectD3D11FlipModel(void)
+{
+    PFN_D3D11_CREATE_DEVICE pfnCreateDevice =
+        (PFN_D3D11_CREATE_DEVICE) g_fpD3D11CreateDevice;
+    ID3D11Device *pd3dDevice = NULL;
+    IDXGIDevice *pdxgiDevice = NULL;
+    IDXGIAdapter *pdxgiAdapter = NULL;
+    IDXGIFactory2 *pdxgiFactory = NULL;
+    HRESULT hr;
+
+    hr = (*pfnCreateDevice) (NULL, D3D_DRIVER_TYPE_HARDWARE, NULL,
+                             D3D11_CREATE_DEVICE_BGRA_SUPPORT, NULL, 0,
+                             D3D11_SDK_VERSION, &pd3dDevice, NULL, NULL);
+    if (FAILED(hr)) {
+        winDebug("winDetectD3D11FlipModel - No hardware device: %08x\n",
+                 (unsigned int) hr);
+        return FALSE;
+    }
+
+    hr = ID3D11Device_QueryInterface(pd3dDevice, &IID_IDXGIDevice,
+                                     (void **) &pdxgiDevice);
+    if (SUCCEEDED(hr))
+        hr = IDXGIDevice_GetAdapter(pdxgiDevice, &pdxgiAdapter);
+    if (SUCCEEDED(hr))
+        hr = IDXGIAdapter_GetParent(pdxgiAdapter, &IID_IDXGIFactory2,
+                                    (void **) &pdxgiFactory);
+
+    /* Cleanup interfaces */
+    if (pdxgiFactory != NULL)
+        IDXGIFactory2_Release(pdxgiFactory);
+    if (pdxgiAdapter != NULL)
+        IDXGIAdapter_Release(pdxgiAdapter);
+    if (pdxgiDevice != NULL)
+        IDXGIDevice_Release(pdxgiDevice);
+    ID3D11Device_Release(pd3dDevice);
+
+    return SUCCEEDED(hr);
+}
+
+/*
+ * Probing for Direct3D 11 creates a device, which takes a while, so it is
+ * done on a thread of its own while the rest of InitOutput gets on.
+ * DirectDraw is only loaded if a screen ends up wanting it.
+ */
+
+static pthread_t s_ptD3D11Detect;
+static Bool s_fD3D11Detecting = FALSE;
+static Bool s_fD3D11FlipModel = FALSE;
+static Bool s_fDDNLDetected = FALSE;
+
+static void *
+winDetectD3D11Proc(void *arg)
+{
+    s_fD3D11FlipModel = winGetD3D11ProcAddresses()
+        && winDetectD3D11FlipModel();
+
+    return NULL;
+}
+
+/* Could any screen get the Direct3D 11 engine? */
+static Bool
+winScreensMayUseD3D11(void)
+{
+    int i;
+
+    for (i = 0; i < g_iNumScreens; ++i) {
+        winScreenInfo *pScreenInfo = &g_ScreenInfo[i];
+
+        if (FALSE
+#ifdef XWIN_MULTIWINDOWEXTWM
+            || pScreenInfo->fMWExtWM
+#endif
+            || pScreenInfo->fRootless
+            || pScreenInfo->fMultiWindow)
+            continue;
+
+        if (pScreenInfo->dwEnginePreferred == WIN_SERVER_SHADOW_D3D11
+            || (pScreenInfo->dwEnginePreferred == 0
+                && !pScreenInfo->fFullScreen))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Wait for the Direct3D 11 probe started by winDetectSupportedEngines */
+static void
+winWaitForD3D11Detection(void)
+{
+    if (!s_fD3D11Detecting)
+        return;
+
+    pthread_join(s_ptD3D11Detect, NULL);
+    s_fD3D11Detecting = FALSE;
+
+    if (s_fD3D11FlipModel) {
+        winDebug ("winWaitForD3D11Detection - Direct3D 11 flip model "
+                  "available, allowing ShadowD3D11\n");
+        g_dwEnginesSupported |= WIN_SERVER_SHADOW_D3D11;
+    }
+    winStartupMark("Direct3D 11 probed");
+}
+
+/* Load DirectDraw, the first time a screen might use it */
+static void
+winDetectDDNL(void)
+{
+    LPDIRECTDRAW lpdd = NULL;
+    LPDIRECTDRAW4 lpdd4 = NULL;
+    HRESULT ddrval;
+
+    if (s_fDDNLDetected)
+        return;
+    s_fDDNLDetected = TRUE;
+
+    /* Load pointers to DirectDraw functions */
+    winGetDDProcAddresses();
+
+    /* Was the DirectDrawCreate function found? */
+    if (g_hmodDirectDraw == NULL || g_fpDirectDrawCreate == NULL) {
+        /* No DirectDraw support */
+        return;
+    }
+
+    /* DirectDrawCreate exists, try to call it */
+    /* Create a DirectDraw object, store the address at lpdd */
+    ddrval = (*g_fpDirectDrawCreate) (NULL, (void **) &lpdd, NULL);
+    if (FAILED(ddrval)) {
+        /* No DirectDraw support */
+        winDebug ("winDetectDDNL - DirectDraw not installed\n");
+        return;
+    }
+
+    /* Try to query for DirectDraw4 interface */
+    ddrval = IDirectDraw_QueryInterface(lpdd,
+                                        &IID_IDirectDraw4,
+                                        (LPVOID *) &lpdd4);
+    if (SUCCEEDED(ddrval)) {
+        /* We have DirectDraw4 */
+        winDebug ("winDetectDDNL - DirectDraw4 installed, allowing "
+                  "ShadowDDNL\n");
+        g_dwEnginesSupported |= WIN_SERVER_SHADOW_DDNL;
+    }
+
+    /* Cleanup DirectDraw interfaces */
+    if (lpdd4 != NULL)
+        IDirectDraw_Release(lpdd4);
+    if (lpdd != NULL)
+        IDirectDraw_Release(lpdd);
+
+    winStartupMark("DirectDraw probed");
+}
+
 /*
  * Detect engines supported by current Windows version
  * DirectDraw version and hardware
@@ -54,47 +227,25 @@ static HMODULE g_hmodDirectDraw = NULL;
 void
 winDetectSupportedEngines(void)
 {
+    /* What we found stays true across server resets */
+    if (serverGeneration != 1)
+        return;
+
     /* Initialize the engine support flags */
     g_dwEnginesSupported = WIN_SERVER_SHADOW_GDI;
 
-    /* Do we have DirectDraw? */
-    if (g_hmodDirectDraw != NULL) {
-        LPDIRECTDRAW lpdd = NULL;
-        LPDIRECTDRAW4 lpdd4 = NULL;
-        HRESULT ddrval;
-
-        /* Was the DirectDrawCreate function found? */
-        if (g_fpDirectDrawCreate == NULL) {
-            /* No DirectDraw support */
-            return;
-        }
-
-        /* DirectDrawCreate exists, try to call it */
-        /* Create a DirectDraw object, store the address at lpdd */
-        ddrval = (*g_fpDirectDrawCreate) (NULL, (void **) &lpdd, NULL);
-        if (FAILED(ddrval)) {
-            /* No DirectDraw support */
-            winDebug (
-                          "winDetectSupportedEngines - DirectDraw not installed\n");
-            return;
+    /* Start probing for Direct3D 11 with flip-model presentation */
+    if (winScreensMayUseD3D11()) {
+        if (pthread_create(&s_ptD3D11Detect, NULL, winDetectD3D11Proc,
+                           NULL) == 0)
+            s_fD3D11Detecting = TRUE;
+        else {
+            ErrorF("winDetectSupportedEngines - pthread_create failed, "
+                   "probing Direct3D 11 now\n");
+            winDetectD3D11Proc(NULL);
+            if (s_fD3D11FlipModel)
+                g_dwEnginesSupported |= WIN_SERVER_SHADOW_D3D11;
         }
-
-        /* Try to query for DirectDraw4 interface */
-        ddrval = IDirectDraw_QueryInterface(lpdd,
-                                            &IID_IDirectDraw4,
-                                            (LPVOID *) &lpdd4);
-        if (SUCCEEDED(ddrval)) {
-            /* We have DirectDraw4 */
-            winDebug (
-                      "winDetectSupportedEngines - DirectDraw4 installed, allowing ShadowDDNL\n");
-            g_dwEnginesSupported |= WIN_SERVER_SHADOW_DDNL;
-        }
-
-        /* Cleanup DirectDraw interfaces */
-        if (lpdd4 != NULL)
-            IDirectDraw_Release(lpdd4);
-        if (lpdd != NULL)
-            IDirectDraw_Release(lpdd);
     }
 
     winDebug (
@@ -163,6 +314,11 @@ winSetEngine(ScreenPtr pScreen)
 
   /* If there is a user's choice, we'll use that */
   if (pScreenInfo->dwEnginePreferred) {
+        if (pScreenInfo->dwEnginePreferred == WIN_SERVER_SHADOW_D3D11)
+            winWaitForD3D11Detection();
+        else if (pScreenInfo->dwEnginePreferred == WIN_SERVER_SHADOW_DDNL)
+            winDetectDDNL();
+
         winDebug ("winSetEngine - Using user's preference: %d\n",
                       (int) pScreenInfo->dwEnginePreferred);
         pScreenInfo->dwEngine = pScreenInfo->dwEnginePreferred;
@@ -175,13 +331,33 @@ winSetEngine(ScreenPtr pScreen)
         case WIN_SERVER_SHADOW_DDNL:
             winSetEngineFunctionsShadowDDNL(pScreen);
             break;
+        case WIN_SERVER_SHADOW_D3D11:
+            winSetEngineFunctionsShadowD3D11(pScreen);
+            break;
         default:
             FatalError ("winSetEngine - Invalid engine type %d\n",pScreenInfo->dwEngine);
         }
         return TRUE;
     }
 
+    /*
+     * DirectDraw is emulated on current Windows versions, so prefer
+     * presenting through a flip-model swap chain when windowed.
+     * Fullscreen keeps using DirectDraw, which can change the video mode.
+     */
+    winWaitForD3D11Detection();
+    if ((g_dwEnginesSupported & WIN_SERVER_SHADOW_D3D11)
+        && !pScreenInfo->fFullScreen) {
+        winDebug ("winSetEngine - Using Shadow Direct3D 11\n");
+        pScreenInfo->dwEngine = WIN_SERVER_SHADOW_D3D11;
+
+        /* Set engine function pointers */
+        winSetEngineFunctionsShadowD3D11(pScreen);
+        return TRUE;
+    }
+
     /* ShadowDDNL has good performance, so why not */
+    winDetectDDNL();
     if (g_dwEnginesSupported & WIN_SERVER_SHADOW_DDNL) {
         winDebug ("winSetEngine - Using Shadow DirectDraw NonLocking\n");
         pScreenInfo->dwEngine = WIN_SERVER_SHADOW_DDNL;
@@ -264,3 +440,43 @@ winReleaseDDProcAddresses(void)
         g_fpDirectDrawCreateClipper = NULL;
     }
 }
+
+/*
+ * Get procedure address for D3D11CreateDevice
+ */
+
+Bool
+winGetD3D11ProcAddresses(void)
+{
+    /* Load the Direct3D 11 library */
+    g_hmodD3D11 = LoadLibraryEx("d3d11.dll", NULL, 0);
+    if (g_hmodD3D11 == NULL) {
+        winDebug("winGetD3D11ProcAddresses - Could not load d3d11.dll\n");
+        return FALSE;
+    }
+
+    /* Try to get the D3D11CreateDevice address */
+    g_fpD3D11CreateDevice = GetProcAddress(g_hmodD3D11, "D3D11CreateDevice");
+    if (g_fpD3D11CreateDevice == NULL) {
+        ErrorF("winGetD3D11ProcAddresses - Could not get D3D11CreateDevice "
+               "address\n");
+        FreeLibrary(g_hmodD3D11);
+        g_hmodD3D11 = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void
+winReleaseD3D11ProcAddresses(void)
+{
+    /* The probe may still be running if no screen got as far as wanting it */
+    winWaitForD3D11Detection();
+
+    if (g_hmodD3D11 != NULL) {
+        FreeLibrary(g_hmodD3D11);
+        g_hmodD3D11 = NULL;
+        g_fpD3D11CreateDevice = NULL;
+    }
+}
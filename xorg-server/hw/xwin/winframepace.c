@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Frame pacing for the shadow framebuffer update
+ *
+ * Without pacing, every block handler with pending damage blits the
+ * damage to the display, so a client repainting faster than the monitor
+ * refreshes makes us update several times per refresh.  With pacing the
+ * damage is collected, and handed to the engine's update function at
+ * most once per refresh period of the monitor, or at most -maxfps times
+ * a second.  Damage that follows keyboard or button input, or any
+ * pointer motion when the cursor is drawn in software, is flushed right
+ * away so the frame answering the input does not have to wait.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+
+/* Refresh rate assumed when the display driver reports its default */
+#define WIN_FRAMEPACE_DEFAULT_RATE	60
+
+static LARGE_INTEGER s_liFramePaceFrequency;
+
+/*
+ * Refresh rate of one monitor, in Hz
+ */
+
+static DWORD
+winFramePaceMonitorRate(HMONITOR hMonitor)
+{
+    MONITORINFOEX mi;
+    DEVMODE dm;
+
+    mi.cbSize = sizeof(mi);
+    if (!GetMonitorInfo(hMonitor, (LPMONITORINFO) &mi))
+        return WIN_FRAMEPACE_DEFAULT_RATE;
+
+    memset(&dm, 0, sizeof(dm));
+    dm.dmSize = sizeof(dm);
+    if (!EnumDisplaySettings(mi.szDevice, ENUM_CURRENT_SETTINGS, &dm))
+        return WIN_FRAMEPACE_DEFAULT_RATE;
+
+    /* 0 and 1 both mean the hardware default rate */
+    if (dm.dmDisplayFrequency <= 1)
+        return WIN_FRAMEPACE_DEFAULT_RATE;
+
+    return dm.dmDisplayFrequency;
+}
+
+static wBOOL CALLBACK
+winFramePaceMonitorProc(HMONITOR hMonitor, HDC hdc, LPRECT lprc,
+                        LPARAM lParam)
+{
+    DWORD *pdwRate = (DWORD *) lParam;
+
+    *pdwRate = max(*pdwRate, winFramePaceMonitorRate(hMonitor));
+    return TRUE;
+}
+
+/*
+ * winFramePaceUpdatePeriod - Recompute the frame period of a screen
+ *
+ * In multiwindow mode the X windows can sit on any monitor, so the
+ * fastest monitor sets the pace; otherwise the monitor holding most of
+ * the screen window does.  Called again when the display configuration
+ * changes or the screen window has been moved.
+ */
+
+void
+winFramePaceUpdatePeriod(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    DWORD dwRate = 0;
+
+    if (!pScreenInfo->fFramePace)
+        return;
+
+    if (pScreenInfo->fMultiWindow || pScreenPriv->hwndScreen == NULL)
+        EnumDisplayMonitors(NULL, NULL, winFramePaceMonitorProc,
+                            (LPARAM) &dwRate);
+    else
+        dwRate = winFramePaceMonitorRate(MonitorFromWindow
+                                         (pScreenPriv->hwndScreen,
+                                          MONITOR_DEFAULTTONEAREST));
+    if (dwRate == 0)
+        dwRate = WIN_FRAMEPACE_DEFAULT_RATE;
+
+    /* Honour a lower user-specified cap */
+    if (pScreenInfo->dwMaxFPS != 0 && pScreenInfo->dwMaxFPS < dwRate)
+        dwRate = pScreenInfo->dwMaxFPS;
+
+    pScreenPriv->llFramePeriod = s_liFramePaceFrequency.QuadPart / dwRate;
+
+    winDebug("winFramePaceUpdatePeriod - Pacing shadow updates at %u Hz\n",
+             (unsigned int) dwRate);
+}
+
+/*
+ * winFramePaceInit - Prepare frame pacing for a screen
+ */
+
+void
+winFramePaceInit(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    RegionNull(&pScreenPriv->rgnFramePaced);
+    pScreenPriv->pFramePaceBuf = NULL;
+    pScreenPriv->llFramePeriod = 0;
+    pScreenPriv->llFrameNext = 0;
+
+    if (s_liFramePaceFrequency.QuadPart == 0)
+        QueryPerformanceFrequency(&s_liFramePaceFrequency);
+
+    winFramePaceUpdatePeriod(pScreen);
+}
+
+/*
+ * winFramePaceFini - Release frame pacing resources of a screen
+ */
+
+void
+winFramePaceFini(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    RegionUninit(&pScreenPriv->rgnFramePaced);
+    pScreenPriv->pFramePaceBuf = NULL;
+}
+
+/*
+ * Hand all damage collected so far to the engine
+ */
+
+static void
+winFramePaceFlush(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    winScreenPriv(pScreen);
+    RegionPtr damage = DamageRegion(pBuf->pDamage);
+    LARGE_INTEGER liNow;
+
+    QueryPerformanceCounter(&liNow);
+
+    /*
+     * Merge the held back damage into what the engine is about to see,
+     * dropping anything a screen resize has put out of range
+     */
+    if (RegionNotEmpty(&pScreenPriv->rgnFramePaced)) {
+        BoxRec box = { 0, 0, pScreen->width, pScreen->height };
+        RegionRec rgnScreen;
+
+        RegionInit(&rgnScreen, &box, 1);
+        RegionIntersect(&pScreenPriv->rgnFramePaced,
+                        &pScreenPriv->rgnFramePaced, &rgnScreen);
+        RegionUnion(damage, damage, &pScreenPriv->rgnFramePaced);
+        RegionEmpty(&pScreenPriv->rgnFramePaced);
+        RegionUninit(&rgnScreen);
+    }
+    g_fFramePaceUrgent = FALSE;
+
+    if (RegionNotEmpty(damage))
+        winShadowUpdateCounted(pScreen, pBuf);
+
+    /*
+     * A flush forced by input does not move the regular cadence; after
+     * an idle period start a new one rather than catching up
+     */
+    if (liNow.QuadPart >= pScreenPriv->llFrameNext) {
+        pScreenPriv->llFrameNext += pScreenPriv->llFramePeriod;
+        if (pScreenPriv->llFrameNext <= liNow.QuadPart)
+            pScreenPriv->llFrameNext =
+                liNow.QuadPart + pScreenPriv->llFramePeriod;
+    }
+}
+
+/*
+ * winShadowUpdatePaced - Shadow update function used instead of the
+ * engine's one when frame pacing is enabled
+ */
+
+void
+winShadowUpdatePaced(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    winScreenPriv(pScreen);
+    LARGE_INTEGER liNow;
+
+    pScreenPriv->pFramePaceBuf = pBuf;
+
+    QueryPerformanceCounter(&liNow);
+    if (g_fFramePaceUrgent || liNow.QuadPart >= pScreenPriv->llFrameNext) {
+        winFramePaceFlush(pScreen, pBuf);
+        return;
+    }
+
+    /* Too early; keep the damage, shadow is about to empty its copy */
+    RegionUnion(&pScreenPriv->rgnFramePaced, &pScreenPriv->rgnFramePaced,
+                DamageRegion(pBuf->pDamage));
+}
+
+/*
+ * winFramePaceBlockHandler - Flush held back damage once its frame is
+ * due, and make sure we wake up in time for it
+ */
+
+void
+winFramePaceBlockHandler(ScreenPtr pScreen, void *pTimeout)
+{
+    winScreenPriv(pScreen);
+    shadowBufPtr pBuf = pScreenPriv->pFramePaceBuf;
+    int *piTimeout = pTimeout;
+    LARGE_INTEGER liNow;
+    LONGLONG llWait;
+    int iWait;
+
+    if (pBuf == NULL || !RegionNotEmpty(&pScreenPriv->rgnFramePaced))
+        return;
+
+    QueryPerformanceCounter(&liNow);
+    llWait = pScreenPriv->llFrameNext - liNow.QuadPart;
+    if (g_fFramePaceUrgent || llWait <= 0) {
+        winFramePaceFlush(pScreen, pBuf);
+        DamageEmpty(pBuf->pDamage);
+        return;
+    }
+
+    /* Round up to whole milliseconds so we never wake up early */
+    iWait = (int) ((llWait * 1000 + s_liFramePaceFrequency.QuadPart - 1)
+                   / s_liFramePaceFrequency.QuadPart);
+    if (*piTimeout < 0 || *piTimeout > iWait)
+        *piTimeout = iWait;
+}
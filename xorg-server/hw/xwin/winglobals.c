@@ -75,10 +75,17 @@ Bool g_fSilentFatalError = FALSE;
 DWORD g_dwCurrentThreadID = 0;
 Bool g_fKeyboardHookLL = FALSE;
 Bool g_fNoHelpMessageBox = FALSE;
+Bool g_fXkbPrecache = FALSE;
 Bool g_fSoftwareCursor = FALSE;
+Bool g_fRawMouse = FALSE;
+Bool g_fFramePaceUrgent = FALSE;
 Bool g_fNativeGl = TRUE;
 Bool g_fswrastwgl = FALSE;
+Bool g_fAsyncSwap = FALSE;
+Bool g_fGLThread = FALSE;
+int g_iHiddenSwapDelay = 100;
 Bool g_fHostInTitle = TRUE;
+int g_iTitleRate = 10;
 pthread_mutex_t g_pmTerminating = PTHREAD_MUTEX_INITIALIZER;
 
 /*
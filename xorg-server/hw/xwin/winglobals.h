@@ -55,15 +55,22 @@ extern Bool g_fAuthEnabled;
 extern Bool g_fXdmcpEnabled;
 
 extern Bool g_fNoHelpMessageBox;
+extern Bool g_fXkbPrecache;
 extern Bool g_fNativeGl;
 extern Bool g_fswrastwgl;
+extern Bool g_fAsyncSwap;
+extern Bool g_fGLThread;
+extern int g_iHiddenSwapDelay;
 extern Bool g_fHostInTitle;
+extern int g_iTitleRate;
 
 extern HWND g_hDlgDepthChange;
 extern HWND g_hDlgExit;
 extern HWND g_hDlgAbout;
 
 extern Bool g_fSoftwareCursor;
+extern Bool g_fRawMouse;
+extern Bool g_fFramePaceUrgent;
 extern Bool g_fCursor;
 
 /* Typedef for DIX wrapper functions */
@@ -46,6 +46,14 @@
 
 static Bool g_winKeyState[NUM_KEYCODES];
 
+/*
+ * Scan codes of the virtual keys in the current keyboard layout, plus one,
+ * or 0 if not looked up yet.  Key messages faked by other programs often
+ * have no scan code, and macro tools send thousands of them, so ask
+ * MapVirtualKeyEx () once per key and layout rather than once per message.
+ */
+static int g_aiVirtualKeyScanCode[256];
+
 /*
  * Local prototypes
  */
@@ -89,6 +97,13 @@ winTranslateKey(WPARAM wParam, LPARAM lParam)
              * keycode, otherwise if num_lock is on, we can get keypad
              * numbers instead of navigation keys. */
             iParam |= KF_EXTENDED;
+        else if (wParam < ARRAY_SIZE(g_aiVirtualKeyScanCode)) {
+            if (g_aiVirtualKeyScanCode[wParam] == 0)
+                g_aiVirtualKeyScanCode[wParam] =
+                    MapVirtualKeyEx(wParam, /*MAPVK_VK_TO_VSC */ 0,
+                                    GetKeyboardLayout(0)) + 1;
+            iParamScanCode = g_aiVirtualKeyScanCode[wParam] - 1;
+        }
         else
             iParamScanCode = MapVirtualKeyEx(wParam,
                                              /*MAPVK_VK_TO_VSC */ 0,
@@ -118,6 +133,16 @@ winTranslateKey(WPARAM wParam, LPARAM lParam)
     return iScanCode;
 }
 
+/*
+ * The input language changed, so virtual keys may have other scan codes
+ */
+
+void
+winKeybdLayoutChanged(void)
+{
+    memset(g_aiVirtualKeyScanCode, 0, sizeof(g_aiVirtualKeyScanCode));
+}
+
 /* Ring the keyboard bell (system speaker on PCs) */
 static void
 winKeybdBell(int iPercent, DeviceIntPtr pDeviceInt, void *pCtrl, int iClass)
@@ -515,6 +540,9 @@ winSendKeyEvent(DWORD dwKey, Bool fDown)
     /* Update the keyState map */
     g_winKeyState[dwKey] = fDown;
 
+    /* Show the client's response without waiting for the next frame */
+    g_fFramePaceUrgent = TRUE;
+
     QueueKeyboardEvents(g_pwinKeyboard, fDown ? KeyPress : KeyRelease,
                         dwKey + MIN_KEYCODE);
 
@@ -78,3 +78,162 @@ winUpdateFBPointer(ScreenPtr pScreen, void *pbits)
 
     return TRUE;
 }
+
+/*
+ * Copy the top left of one framebuffer into another with another pitch,
+ * when a framebuffer is replaced by a bigger one
+ */
+
+void
+winCopyFBRows(char *pDst, DWORD dwDstPitch, const char *pSrc,
+              DWORD dwSrcPitch, DWORD dwBytes, DWORD dwRows)
+{
+    while (dwRows--) {
+        memcpy(pDst, pSrc, dwBytes);
+        pDst += dwDstPitch;
+        pSrc += dwSrcPitch;
+    }
+}
+
+/*
+ * Log how long after the process was created a step of server startup
+ * was reached, with -logverbose 3 or more
+ */
+
+void
+winStartupMark(const char *pszStep)
+{
+    FILETIME ftCreation, ftExit, ftKernel, ftUser, ftNow;
+    ULARGE_INTEGER uliCreation, uliNow;
+
+    if (serverGeneration != 1)
+        return;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &ftCreation, &ftExit,
+                         &ftKernel, &ftUser))
+        return;
+    GetSystemTimeAsFileTime(&ftNow);
+
+    uliCreation.LowPart = ftCreation.dwLowDateTime;
+    uliCreation.HighPart = ftCreation.dwHighDateTime;
+    uliNow.LowPart = ftNow.dwLowDateTime;
+    uliNow.HighPart = ftNow.dwHighDateTime;
+
+    /* FILETIMEs count 100ns */
+    LogMessageVerb(X_INFO, 3, "Startup: %s at %u ms\n", pszStep,
+                   (unsigned int) ((uliNow.QuadPart - uliCreation.QuadPart)
+                                   / 10000));
+}
+
+/*
+ * Widen a shadow framebuffer so that its rows are a multiple of a cache
+ * line, when whole pixels fit that
+ */
+
+DWORD
+winFBAlignWidth(DWORD dwWidth, DWORD dwBPP)
+{
+    DWORD dwPitch = (dwWidth * dwBPP / 8 + WIN_FB_PITCH_ALIGN - 1)
+        & ~(WIN_FB_PITCH_ALIGN - 1);
+
+    if ((dwPitch * 8) % dwBPP)
+        return dwWidth;
+    return dwPitch * 8 / dwBPP;
+}
+
+/*
+ * Large pages need SeLockMemoryPrivilege, which an administrator has to
+ * grant to the user and which is off in the token until asked for
+ */
+
+static SIZE_T
+winLargePageSize(void)
+{
+    static int iState = -1;
+    static SIZE_T sizeLargePage;
+    HANDLE hToken;
+    TOKEN_PRIVILEGES tp;
+
+    if (iState >= 0)
+        return iState ? sizeLargePage : 0;
+    iState = 0;
+
+    sizeLargePage = GetLargePageMinimum();
+    if (!sizeLargePage)
+        return 0;
+
+    if (!OpenProcessToken(GetCurrentProcess(),
+                          TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hToken))
+        return 0;
+    tp.PrivilegeCount = 1;
+    tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    if (LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME,
+                             &tp.Privileges[0].Luid)
+        && AdjustTokenPrivileges(hToken, FALSE, &tp, 0, NULL, NULL)
+        && GetLastError() == ERROR_SUCCESS)
+        iState = 1;
+    CloseHandle(hToken);
+
+    winDebug("winLargePageSize - %s\n", iState ? "large pages available" :
+             "no SeLockMemoryPrivilege, using small pages");
+
+    return iState ? sizeLargePage : 0;
+}
+
+/*
+ * winCreateFBSection - A section of large pages of at least size bytes
+ * for CreateDIBSection(), or NULL to let it allocate the bits itself
+ *
+ * The caller closes the handle once the bitmap is deleted.
+ */
+
+HANDLE
+winCreateFBSection(SIZE_T size)
+{
+    SIZE_T sizeLargePage = winLargePageSize();
+    ULONGLONG ullSize;
+    HANDLE hSection;
+
+    if (!sizeLargePage)
+        return NULL;
+
+    ullSize = (size + sizeLargePage - 1) & ~(ULONGLONG) (sizeLargePage - 1);
+    hSection = CreateFileMapping(INVALID_HANDLE_VALUE, NULL,
+                                 PAGE_READWRITE | SEC_COMMIT
+                                 | SEC_LARGE_PAGES,
+                                 (DWORD) (ullSize >> 32), (DWORD) ullSize,
+                                 NULL);
+    if (!hSection)
+        winDebug("winCreateFBSection - CreateFileMapping failed: %08x\n",
+                 (unsigned int) GetLastError());
+    return hSection;
+}
+
+/*
+ * winAllocFBMemory - Zeroed memory for a shadow framebuffer, in large
+ * pages if we may, freed with winFreeFBMemory()
+ */
+
+void *
+winAllocFBMemory(SIZE_T size)
+{
+    SIZE_T sizeLargePage = winLargePageSize();
+    void *pfb = NULL;
+
+    if (sizeLargePage)
+        pfb = VirtualAlloc(NULL, (size + sizeLargePage - 1)
+                           & ~(sizeLargePage - 1),
+                           MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                           PAGE_READWRITE);
+    if (!pfb)
+        pfb = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT,
+                           PAGE_READWRITE);
+    return pfb;
+}
+
+void
+winFreeFBMemory(void *pfb)
+{
+    if (pfb)
+        VirtualFree(pfb, 0, MEM_RELEASE);
+}
@@ -77,3 +77,25 @@ QueryMonitor(int i, struct GetMonitorInfoData *data)
     /* query information */
     return !EnumDisplayMonitors(NULL, NULL, getMonitorInfo, (LPARAM) data);
 }
+
+/*
+ * winMonitorForScreen - the monitor showing an X screen
+ *
+ * In multiwindow mode the X windows can sit on any monitor, so this is
+ * the primary one; otherwise it is the monitor holding most of the
+ * screen window.
+ */
+
+HMONITOR
+winMonitorForScreen(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    POINT pt = { 0, 0 };
+
+    if (pScreenPriv->pScreenInfo->fMultiWindow ||
+        pScreenPriv->hwndScreen == NULL)
+        return MonitorFromPoint(pt, MONITOR_DEFAULTTOPRIMARY);
+
+    return MonitorFromWindow(pScreenPriv->hwndScreen,
+                             MONITOR_DEFAULTTONEAREST);
+}
@@ -41,3 +41,4 @@ struct GetMonitorInfoData {
 };
 
 Bool QueryMonitor(int i, struct GetMonitorInfoData *data);
+HMONITOR winMonitorForScreen(ScreenPtr pScreen);
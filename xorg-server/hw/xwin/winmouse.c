@@ -51,6 +51,12 @@
 /* Peek the internal button mapping */
 static CARD8 const *g_winMouseButtonMap = NULL;
 
+/* The window the mouse's Raw Input goes to, if -rawmouse registered one */
+static HWND g_hwndRawInput = NULL;
+
+/* Whether GetRawInputBuffer () gives us RAWINPUT the way we lay it out */
+static Bool g_fRawInputBuffer = TRUE;
+
 /*
  * See Porting Layer Definition - p. 18
  * This is known as a DeviceProc
@@ -226,6 +232,9 @@ winMouseButtonsSendEvent(int iEventType, int iButton)
     QueuePointerEvents(g_pwinPointer, iEventType, iButton,
                        POINTER_RELATIVE, &mask);
 
+    /* Show the client's response without waiting for the next frame */
+    g_fFramePaceUrgent = TRUE;
+
   winDebug("winMouseButtonsSendEvent: iEventType: %d, iButton: %d\n",
            iEventType, iButton);
 }
@@ -332,12 +341,180 @@ winEnqueueMotion(int x, int y)
 {
     int valuators[2];
     ValuatorMask mask;
+    ScreenPtr pScreen = miPointerGetScreen(g_pwinPointer);
+    int iSpriteX, iSpriteY;
+
+    /*
+     * Windows also sends WM_MOUSEMOVE without the mouse moving, when a
+     * window appears under the pointer or the cursor is changed.  Those
+     * are dropped, unless the pointer went elsewhere since, as after a
+     * warp: the device's last valuators are where the last queued motion
+     * put it, the sprite is where the last processed motion or warp did.
+     */
+    if (pScreen) {
+        miPointerGetPosition(g_pwinPointer, &iSpriteX, &iSpriteY);
+        if (iSpriteX == x && iSpriteY == y &&
+            g_pwinPointer->last.valuators[0] == x + pScreen->x &&
+            g_pwinPointer->last.valuators[1] == y + pScreen->y)
+            return;
+    }
 
     valuators[0] = x;
     valuators[1] = y;
 
     valuator_mask_set_range(&mask, 0, 2, valuators);
+
+    /* With Raw Input, RawMotion events carry the device's own deltas */
+    QueuePointerEvents(g_pwinPointer, MotionNotify, 0,
+                       POINTER_ABSOLUTE | POINTER_SCREEN |
+                       (g_hwndRawInput ? POINTER_NORAW : 0), &mask);
+
+    /* A software cursor is drawn into the shadow, so it must not lag */
+    if (g_fSoftwareCursor)
+        g_fFramePaceUrgent = TRUE;
+}
+
+/*
+ * winMouseRawInputRegister - Have the mouse's Raw Input sent to hwnd
+ *
+ * WM_MOUSEMOVE only says where the Windows cursor is now, after pointer
+ * ballistics, and coalesces the motion in between.  Raw Input has every
+ * report of the device, which XI2 clients get as RawMotion events.  The
+ * sprite still follows WM_MOUSEMOVE, so it stays with the Windows cursor.
+ */
+
+void
+winMouseRawInputRegister(HWND hwnd)
+{
+    RAWINPUTDEVICE rid;
+
+#ifndef _WIN64
+    BOOL fWow64;
+#endif
+
+    if (!g_fRawMouse || g_hwndRawInput)
+        return;
+
+    rid.usUsagePage = 0x01;     /* HID_USAGE_PAGE_GENERIC */
+    rid.usUsage = 0x02;         /* HID_USAGE_GENERIC_MOUSE */
+    rid.dwFlags = RIDEV_INPUTSINK;      /* rootless windows are not hwnd */
+    rid.hwndTarget = hwnd;
+
+    if (!RegisterRawInputDevices(&rid, 1, sizeof(rid))) {
+        ErrorF("winMouseRawInputRegister - RegisterRawInputDevices "
+               "failed: %08x\n", (unsigned int) GetLastError());
+        return;
+    }
+
+#ifndef _WIN64
+    /* A 32-bit process on 64-bit Windows gets the buffer in the 64-bit
+     * layout, so it reads each sample from its own WM_INPUT instead */
+    if (IsWow64Process(GetCurrentProcess(), &fWow64) && fWow64)
+        g_fRawInputBuffer = FALSE;
+#endif
+
+    g_hwndRawInput = hwnd;
+}
+
+/*
+ * winMouseRawInputUnregister - Stop sending Raw Input to hwnd, which is
+ * going away
+ */
+
+void
+winMouseRawInputUnregister(HWND hwnd)
+{
+    RAWINPUTDEVICE rid;
+
+    if (g_hwndRawInput == NULL || g_hwndRawInput != hwnd)
+        return;
+
+    rid.usUsagePage = 0x01;
+    rid.usUsage = 0x02;
+    rid.dwFlags = RIDEV_REMOVE;
+    rid.hwndTarget = NULL;
+    RegisterRawInputDevices(&rid, 1, sizeof(rid));
+
+    g_hwndRawInput = NULL;
+}
+
+/*
+ * Enqueue the motion of one Raw Input mouse report
+ */
+
+static void
+winMouseRawInputSample(const RAWMOUSE *pMouse)
+{
+    ValuatorMask mask;
+
+    /* Tablets and remote sessions report positions, as WM_MOUSEMOVE does */
+    if (pMouse->usFlags & MOUSE_MOVE_ABSOLUTE)
+        return;
+
+    if (pMouse->lLastX == 0 && pMouse->lLastY == 0)
+        return;
+
+    valuator_mask_zero(&mask);
+    valuator_mask_set(&mask, 0, pMouse->lLastX);
+    valuator_mask_set(&mask, 1, pMouse->lLastY);
     QueuePointerEvents(g_pwinPointer, MotionNotify, 0,
-                       POINTER_ABSOLUTE | POINTER_SCREEN, &mask);
+                       POINTER_RELATIVE | POINTER_RAWONLY, &mask);
+}
+
+/*
+ * winMouseRawInputDrain - Enqueue all the Raw Input mouse reports waiting
+ *
+ * Called once per trip round the dispatch loop, so a high rate mouse costs
+ * a GetRawInputBuffer () call per batch of reports rather than a message
+ * per report.
+ */
+
+void
+winMouseRawInputDrain(void)
+{
+    /* RAWINPUT blocks are aligned to pointers, so keep the buffer aligned */
+    static UINT64 s_aBuffer[2048];
+    PRAWINPUT pRawInput;
+    UINT cbSize, nCount, i;
+
+    if (g_hwndRawInput == NULL || !g_fRawInputBuffer || g_pwinPointer == NULL)
+        return;
+
+    for (;;) {
+        cbSize = sizeof(s_aBuffer);
+        nCount = GetRawInputBuffer((PRAWINPUT) s_aBuffer, &cbSize,
+                                   sizeof(RAWINPUTHEADER));
+        if (nCount == 0 || nCount == (UINT) -1)
+            break;
+
+        pRawInput = (PRAWINPUT) s_aBuffer;
+        for (i = 0; i < nCount; i++) {
+            if (pRawInput->header.dwType == RIM_TYPEMOUSE)
+                winMouseRawInputSample(&pRawInput->data.mouse);
+            pRawInput = NEXTRAWINPUTBLOCK(pRawInput);
+        }
+    }
+}
+
+/*
+ * winMouseRawInput - Handle WM_INPUT
+ */
+
+void
+winMouseRawInput(HRAWINPUT hRawInput)
+{
+    RAWINPUT rawInput;
+    UINT cbSize = sizeof(rawInput);
+
+    if (g_hwndRawInput == NULL || g_pwinPointer == NULL)
+        return;
+
+    /* The message's own report is no longer in the buffer */
+    if (GetRawInputData(hRawInput, RID_INPUT, &rawInput, &cbSize,
+                        sizeof(RAWINPUTHEADER)) != (UINT) -1 &&
+        rawInput.header.dwType == RIM_TYPEMOUSE)
+        winMouseRawInputSample(&rawInput.data.mouse);
 
+    /* Then those which came in behind it */
+    winMouseRawInputDrain();
 }
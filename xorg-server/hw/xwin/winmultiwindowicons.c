@@ -38,6 +38,13 @@
 
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN_ICON_SSE2
+#include <emmintrin.h>
+#endif
 
 #include <X11/Xwindows.h>
 #include <X11/Xlib.h>
@@ -56,6 +63,261 @@
  */
 extern HINSTANCE g_hInstance;
 
+/*
+ * _NET_WM_ICON conversion cache
+ *
+ * Converting an icon means a DIB section, a mask bitmap and possibly a
+ * rescale, so keep the results around keyed by a hash of the source pixels
+ * and the size wanted.  Windows of one application usually carry identical
+ * icons, and so share entries, as does a client rewriting an unchanged icon.
+ *
+ * An HICON handed out by the cache may be set on several windows at once,
+ * so it is only destroyed once no window refers to it and it falls out of
+ * the cache.
+ */
+
+#define WIN_ICON_CACHE_SIZE 32
+
+typedef struct {
+    uint64_t hash;
+    int iconSize;
+    Bool fAlpha;
+    HICON hIcon;
+    int refs;
+    unsigned long lastUse;
+} winIconCacheEntryRec;
+
+static winIconCacheEntryRec s_iconCache[WIN_ICON_CACHE_SIZE];
+static unsigned long s_iconCacheClock;
+static pthread_mutex_t s_pmIconCache = PTHREAD_MUTEX_INITIALIZER;
+
+/* FNV-1a over the icon's width, height and pixels */
+static uint64_t
+winIconHash(const uint32_t *icon)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i, n = 2 + (size_t) icon[0] * icon[1];
+
+    for (i = 0; i < n; i++) {
+        hash ^= icon[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static HICON
+winIconCacheLookup(uint64_t hash, int iconSize, Bool fAlpha)
+{
+    HICON hIcon = NULL;
+    int i;
+
+    pthread_mutex_lock(&s_pmIconCache);
+    for (i = 0; i < WIN_ICON_CACHE_SIZE; i++) {
+        winIconCacheEntryRec *pEntry = &s_iconCache[i];
+
+        if (pEntry->hIcon && pEntry->hash == hash &&
+            pEntry->iconSize == iconSize && pEntry->fAlpha == fAlpha) {
+            pEntry->refs++;
+            pEntry->lastUse = ++s_iconCacheClock;
+            hIcon = pEntry->hIcon;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_pmIconCache);
+
+    return hIcon;
+}
+
+static void
+winIconCacheInsert(uint64_t hash, int iconSize, Bool fAlpha, HICON hIcon)
+{
+    winIconCacheEntryRec *pVictim = NULL;
+    int i;
+
+    pthread_mutex_lock(&s_pmIconCache);
+
+    /* Reuse a free slot, else the least recently used unreferenced one */
+    for (i = 0; i < WIN_ICON_CACHE_SIZE; i++) {
+        winIconCacheEntryRec *pEntry = &s_iconCache[i];
+
+        if (!pEntry->hIcon) {
+            pVictim = pEntry;
+            break;
+        }
+        if (!pEntry->refs &&
+            (!pVictim || pEntry->lastUse < pVictim->lastUse))
+            pVictim = pEntry;
+    }
+
+    /* Every slot is in use, so this icon is just not cached */
+    if (pVictim) {
+        if (pVictim->hIcon)
+            DestroyIcon(pVictim->hIcon);
+
+        pVictim->hash = hash;
+        pVictim->iconSize = iconSize;
+        pVictim->fAlpha = fAlpha;
+        pVictim->hIcon = hIcon;
+        pVictim->refs = 1;
+        pVictim->lastUse = ++s_iconCacheClock;
+    }
+
+    pthread_mutex_unlock(&s_pmIconCache);
+}
+
+/* Drop a window's reference to a cached icon, FALSE if it isn't one */
+static Bool
+winIconCacheRelease(HICON hIcon)
+{
+    Bool fCached = FALSE;
+    int i;
+
+    pthread_mutex_lock(&s_pmIconCache);
+    for (i = 0; i < WIN_ICON_CACHE_SIZE; i++) {
+        if (s_iconCache[i].hIcon == hIcon) {
+            if (s_iconCache[i].refs > 0)
+                s_iconCache[i].refs--;
+            fCached = TRUE;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_pmIconCache);
+
+    return fCached;
+}
+
+/*
+ * Box filter one destination pixel of a _NET_WM_ICON downscale
+ *
+ * Channels are summed premultiplied by alpha, so that fully transparent
+ * pixels (whose colour is usually garbage) don't bleed into the result, and
+ * converted back to straight alpha, which is what Windows icons use.
+ */
+
+static uint32_t
+winIconBoxAverage(const uint32_t *pixels, int stride,
+                  int x0, int x1, int y0, int y1)
+{
+    uint64_t sum[4] = { 0, 0, 0, 0 };   /* b*a, g*a, r*a, a*255 */
+    uint64_t count = (uint64_t) (x1 - x0) * (y1 - y0);
+    uint32_t result;
+    int x, y, i;
+
+    for (y = y0; y < y1; y++) {
+        const uint32_t *src = pixels + (size_t) y * stride;
+        uint32_t row[4];
+
+#ifdef WIN_ICON_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const __m128i alpha255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        __m128i acc = zero;
+
+        /* Two pixels at a time, as eight 16-bit channels */
+        for (x = x0; x + 1 < x1; x += 2) {
+            __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) &src[x]),
+                                          zero);
+            __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p, 0xFF), 0xFF);
+
+            a = _mm_or_si128(_mm_andnot_si128(alphaLanes, a), alpha255);
+            p = _mm_mullo_epi16(p, a);
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(p, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(p, zero));
+        }
+        if (x < x1) {
+            __m128i p = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src[x]), zero);
+            __m128i a = _mm_shufflelo_epi16(p, 0xFF);
+
+            a = _mm_or_si128(_mm_andnot_si128(alphaLanes, a), alpha255);
+            p = _mm_mullo_epi16(p, a);
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(p, zero));
+        }
+        _mm_storeu_si128((__m128i *) row, acc);
+#else
+        row[0] = row[1] = row[2] = row[3] = 0;
+        for (x = x0; x < x1; x++) {
+            uint32_t p = src[x];
+            uint32_t a = p >> 24;
+
+            row[0] += (p & 0xFF) * a;
+            row[1] += ((p >> 8) & 0xFF) * a;
+            row[2] += ((p >> 16) & 0xFF) * a;
+            row[3] += a * 255;
+        }
+#endif
+
+        /* Rows are folded into 64 bits so large boxes can't overflow */
+        for (i = 0; i < 4; i++)
+            sum[i] += row[i];
+    }
+
+    if (!sum[3])
+        return 0;
+
+    result = (uint32_t) ((sum[3] + count * 255 / 2) / (count * 255)) << 24;
+    for (i = 0; i < 3; i++) {
+        uint64_t c = (sum[i] * 255 + sum[3] / 2) / sum[3];
+
+        result |= (uint32_t) (c > 255 ? 255 : c) << (8 * i);
+    }
+
+    return result;
+}
+
+/*
+ * Downscale a _NET_WM_ICON image to iconSize x iconSize, keeping its aspect
+ * ratio and centring it.  The result has the same width, height, pixels
+ * layout as the property, and must be freed by the caller.
+ */
+
+static uint32_t *
+winScaleNetWMIcon(const uint32_t *icon, int iconSize)
+{
+    int width = icon[0];
+    int height = icon[1];
+    const uint32_t *pixels = &icon[2];
+    int dstWidth, dstHeight, offX, offY, x, y;
+    uint32_t *scaled;
+
+    scaled = calloc(2 + iconSize * iconSize, sizeof(uint32_t));
+    if (!scaled)
+        return NULL;
+
+    scaled[0] = iconSize;
+    scaled[1] = iconSize;
+
+    if (width >= height) {
+        dstWidth = iconSize;
+        dstHeight = (int) (((int64_t) height * iconSize + width / 2) / width);
+    }
+    else {
+        dstHeight = iconSize;
+        dstWidth = (int) (((int64_t) width * iconSize + height / 2) / height);
+    }
+    if (dstWidth < 1)
+        dstWidth = 1;
+    if (dstHeight < 1)
+        dstHeight = 1;
+    offX = (iconSize - dstWidth) / 2;
+    offY = (iconSize - dstHeight) / 2;
+
+    for (y = 0; y < dstHeight; y++) {
+        int y0 = (int) ((int64_t) y * height / dstHeight);
+        int y1 = (int) ((int64_t) (y + 1) * height / dstHeight);
+        uint32_t *dst = &scaled[2 + (y + offY) * iconSize + offX];
+
+        for (x = 0; x < dstWidth; x++) {
+            int x0 = (int) ((int64_t) x * width / dstWidth);
+            int x1 = (int) ((int64_t) (x + 1) * width / dstWidth);
+
+            dst[x] = winIconBoxAverage(pixels, width, x0, x1, y0, y1);
+        }
+    }
+
+    return scaled;
+}
+
 /*
  * Scale an X icon ZPixmap into a Windoze icon bitmap
  */
@@ -336,33 +598,17 @@ NetWMToWinIconThreshold(uint32_t * icon)
 }
 
 /*
- * Attempt to create a custom icon from the WM_HINTS bitmaps
+ * Fetch the _NET_WM_ICON property of a window, NULL if it has none
  */
 
-static
-HICON
-winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize)
+static xcb_get_property_reply_t *
+winGetNetWMIcon(xcb_connection_t *conn, xcb_window_t id)
 {
-    unsigned char *mask, *image = NULL, *imageMask;
-    unsigned char *dst, *src;
-    int planes, bpp, i;
-    unsigned int biggest_size = 0;
-    HDC hDC;
-    ICONINFO ii;
-    xcb_icccm_wm_hints_t hints;
-    HICON hIcon = NULL;
-    uint32_t *biggest_icon = NULL;
     static xcb_atom_t _XA_NET_WM_ICON;
     static int generation;
-    uint32_t *icon, *icon_data = NULL;
-    unsigned long int size;
+    xcb_get_property_cookie_t cookie;
+    xcb_get_property_reply_t *reply;
 
-    hDC = GetDC(GetDesktopWindow());
-    planes = GetDeviceCaps(hDC, PLANES);
-    bpp = GetDeviceCaps(hDC, BITSPIXEL);
-    ReleaseDC(GetDesktopWindow(), hDC);
-
-    /* Always prefer _NET_WM_ICON icons */
     if (generation != serverGeneration) {
         xcb_intern_atom_reply_t *atom_reply;
         xcb_intern_atom_cookie_t atom_cookie;
@@ -380,56 +626,124 @@ winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize)
         }
     }
 
-    {
-        xcb_get_property_cookie_t cookie = xcb_get_property(conn, FALSE, id, _XA_NET_WM_ICON, XCB_ATOM_CARDINAL, 0L, INT_MAX);
-        xcb_get_property_reply_t *reply =  xcb_get_property_reply(conn, cookie, NULL);
-
-        if (reply &&
-            ((icon_data = xcb_get_property_value(reply)) != NULL)) {
-          size = xcb_get_property_value_length(reply)/sizeof(uint32_t);
-          for (icon = icon_data; icon < &icon_data[size] && *icon;
-               icon = &icon[icon[0] * icon[1] + 2]) {
-            winDebug("winXIconToHICON: %u x %u NetIcon\n", icon[0], icon[1]);
-
-            /* Icon data size will overflow an int and thus is bigger than the
-               property can possibly be */
-            if ((INT_MAX/icon[0]) < icon[1]) {
-                winDebug("winXIconToHICON: _NET_WM_ICON icon data size overflow\n");
-                break;
-            }
+    cookie = xcb_get_property(conn, FALSE, id, _XA_NET_WM_ICON, XCB_ATOM_CARDINAL, 0L, INT_MAX);
+    reply = xcb_get_property_reply(conn, cookie, NULL);
 
-            /* Icon data size is bigger than amount of data remaining */
-            if (&icon[icon[0] * icon[1] + 2] > &icon_data[size]) {
-                winDebug("winXIconToHICON: _NET_WM_ICON data is malformed\n");
-                break;
-            }
+    if (reply && !xcb_get_property_value_length(reply)) {
+        free(reply);
+        reply = NULL;
+    }
 
-            /* Found an exact match to the size we require...  */
-            if (icon[0] == iconSize && icon[1] == iconSize) {
-                winDebug("winXIconToHICON: selected %d x %d NetIcon\n",
-                         iconSize, iconSize);
-                hIcon = (bpp == 32) ? NetWMToWinIconAlpha(icon) : NetWMToWinIconThreshold(icon);
-                break;
-            }
-            /* Otherwise, find the biggest icon and let Windows scale the size */
-            else if (biggest_size < icon[0]) {
-                biggest_icon = icon;
-                biggest_size = icon[0];
-            }
+    return reply;
+}
+
+/*
+ * Create an icon from the _NET_WM_ICON image best matching iconSize
+ */
+
+static HICON
+winNetWMIconToHICON(xcb_get_property_reply_t *reply, int iconSize, int bpp)
+{
+    unsigned int biggest_size = 0;
+    uint32_t *biggest_icon = NULL;
+    uint32_t *selected = NULL;
+    uint32_t *icon, *icon_data, *scaled = NULL;
+    unsigned long int size;
+    Bool fAlpha = (bpp == 32);
+    uint64_t hash;
+    HICON hIcon;
+
+    icon_data = xcb_get_property_value(reply);
+    size = xcb_get_property_value_length(reply)/sizeof(uint32_t);
+
+    for (icon = icon_data; icon < &icon_data[size] && *icon;
+         icon = &icon[icon[0] * icon[1] + 2]) {
+        winDebug("winNetWMIconToHICON: %u x %u NetIcon\n", icon[0], icon[1]);
+
+        /* Icon data size will overflow an int and thus is bigger than the
+           property can possibly be */
+        if ((INT_MAX/icon[0]) < icon[1]) {
+            winDebug("winNetWMIconToHICON: _NET_WM_ICON icon data size overflow\n");
+            break;
         }
 
-        if (!hIcon && biggest_icon) {
-            winDebug
-                ("winXIconToHICON: selected %u x %u NetIcon for scaling to %d x %d\n",
-                 biggest_icon[0], biggest_icon[1], iconSize, iconSize);
+        /* Icon data size is bigger than amount of data remaining */
+        if (&icon[icon[0] * icon[1] + 2] > &icon_data[size]) {
+            winDebug("winNetWMIconToHICON: _NET_WM_ICON data is malformed\n");
+            break;
+        }
 
-            hIcon = (bpp == 32) ? NetWMToWinIconAlpha(biggest_icon) : NetWMToWinIconThreshold(biggest_icon);
+        /* Found an exact match to the size we require...  */
+        if (icon[0] == iconSize && icon[1] == iconSize) {
+            winDebug("winNetWMIconToHICON: selected %d x %d NetIcon\n",
+                     iconSize, iconSize);
+            selected = icon;
+            break;
+        }
+        /* Otherwise, find the biggest icon */
+        else if (biggest_size < icon[0]) {
+            biggest_icon = icon;
+            biggest_size = icon[0];
         }
+    }
 
-        free(reply);
-      }
+    if (!selected && biggest_icon) {
+        winDebug
+            ("winNetWMIconToHICON: selected %u x %u NetIcon for scaling to %d x %d\n",
+             biggest_icon[0], biggest_icon[1], iconSize, iconSize);
+        selected = biggest_icon;
     }
 
+    if (!selected)
+        return NULL;
+
+    hash = winIconHash(selected);
+    hIcon = winIconCacheLookup(hash, iconSize, fAlpha);
+    if (hIcon) {
+        winDebug("winNetWMIconToHICON: reusing cached icon %p\n", hIcon);
+        return hIcon;
+    }
+
+    /* Scale bigger icons down ourselves, let Windows scale smaller ones up */
+    if (selected[0] > iconSize || selected[1] > iconSize)
+        scaled = winScaleNetWMIcon(selected, iconSize);
+
+    hIcon = fAlpha ? NetWMToWinIconAlpha(scaled ? scaled : selected)
+                   : NetWMToWinIconThreshold(scaled ? scaled : selected);
+    free(scaled);
+
+    if (hIcon)
+        winIconCacheInsert(hash, iconSize, fAlpha, hIcon);
+
+    return hIcon;
+}
+
+/*
+ * Attempt to create a custom icon from _NET_WM_ICON or the WM_HINTS bitmaps
+ */
+
+static
+HICON
+winXIconToHICON(xcb_connection_t *conn, xcb_window_t id, int iconSize,
+                xcb_get_property_reply_t *net_wm_icon)
+{
+    unsigned char *mask, *image = NULL, *imageMask;
+    unsigned char *dst, *src;
+    int planes, bpp, i;
+    HDC hDC;
+    ICONINFO ii;
+    xcb_icccm_wm_hints_t hints;
+    HICON hIcon = NULL;
+
+    hDC = GetDC(GetDesktopWindow());
+    planes = GetDeviceCaps(hDC, PLANES);
+    bpp = GetDeviceCaps(hDC, BITSPIXEL);
+    ReleaseDC(GetDesktopWindow(), hDC);
+
+    /* Always prefer _NET_WM_ICON icons */
+    if (net_wm_icon)
+        hIcon = winNetWMIconToHICON(net_wm_icon, iconSize, bpp);
+
     if (!hIcon) {
         xcb_get_property_cookie_t wm_hints_cookie;
 
@@ -560,8 +874,13 @@ winUpdateIcon(HWND hWnd, xcb_connection_t *conn, Window id, HICON hIconNew)
         hIconSmall = hIconNew;
     } else {
         /* If we still need an icon, try and get the icon from WM_HINTS */
-        hIcon = winXIconToHICON(conn, id, GetSystemMetrics(SM_CXICON));
-        hIconSmall = winXIconToHICON(conn, id, GetSystemMetrics(SM_CXSMICON));
+        xcb_get_property_reply_t *net_wm_icon = winGetNetWMIcon(conn, id);
+
+        hIcon = winXIconToHICON(conn, id, GetSystemMetrics(SM_CXICON),
+                                net_wm_icon);
+        hIconSmall = winXIconToHICON(conn, id, GetSystemMetrics(SM_CXSMICON),
+                                     net_wm_icon);
+        free(net_wm_icon);
         /* If we got the small, but not the large one swap them */
         if (!hIcon && hIconSmall) {
             hIcon = hIconSmall;
@@ -641,6 +960,7 @@ winDestroyIcon(HICON hIcon)
     /* Delete the icon if its not one of the application defaults or an override */
     if (hIcon &&
         hIcon != g_hIconX &&
-        hIcon != g_hSmallIconX && !winIconIsOverride(hIcon))
+        hIcon != g_hSmallIconX && !winIconIsOverride(hIcon) &&
+        !winIconCacheRelease(hIcon))
         DestroyIcon(hIcon);
 }
@@ -66,6 +66,12 @@ winSetShapeMultiWindow(WindowPtr pWin, int kind)
 void
 winUpdateRgnMultiWindow(WindowPtr pWin)
 {
+    /* Windows already has this shape */
+    if (winGetWindowPriv(pWin)->fShapeUnchanged) {
+        winGetWindowPriv(pWin)->fShapeUnchanged = FALSE;
+        return;
+    }
+
     SetWindowRgn(winGetWindowPriv(pWin)->hWnd,
                  winGetWindowPriv(pWin)->hRgn, TRUE);
 
@@ -73,6 +79,42 @@ winUpdateRgnMultiWindow(WindowPtr pWin)
     winGetWindowPriv(pWin)->hRgn = NULL;
 }
 
+/* FNV-1a over the values the Windows region is made from */
+static DWORD
+winShapeChecksum(const BoxRec * pBox, int nBox, int iOffsetX, int iOffsetY,
+                 int iTitleRight)
+{
+    DWORD dwHash = 2166136261u;
+    int aiFrame[4];
+    const unsigned char *pb;
+    size_t cb;
+
+    aiFrame[0] = nBox;
+    aiFrame[1] = iOffsetX;
+    aiFrame[2] = iOffsetY;
+    aiFrame[3] = iTitleRight;
+    for (pb = (const unsigned char *) aiFrame, cb = sizeof(aiFrame); cb--;)
+        dwHash = (dwHash ^ *pb++) * 16777619u;
+    for (pb = (const unsigned char *) pBox, cb = nBox * sizeof(BoxRec); cb--;)
+        dwHash = (dwHash ^ *pb++) * 16777619u;
+
+    return dwHash;
+}
+
+/*
+ * Note that the window is about to get the shape with this checksum, and
+ * whether it has it already, in which case winUpdateRgnMultiWindow needn't
+ * touch it
+ */
+static void
+winShapeCacheUpdate(winPrivWinPtr pWinPriv, DWORD dwChecksum)
+{
+    pWinPriv->fShapeUnchanged = pWinPriv->hWndShaped == pWinPriv->hWnd
+        && pWinPriv->dwShapeChecksum == dwChecksum;
+    pWinPriv->hWndShaped = pWinPriv->hWnd;
+    pWinPriv->dwShapeChecksum = dwChecksum;
+}
+
 /*
  * winReshapeMultiWindow - Computes the composite clipping region for a window
  */
@@ -82,8 +124,8 @@ winReshapeMultiWindow(WindowPtr pWin)
 {
     int nRects;
     RegionRec rrNewShape;
-    BoxPtr pShape, pRects, pEnd;
-    HRGN hRgn, hRgnRect;
+    BoxPtr pShape;
+    HRGN hRgn;
 
     winWindowPriv(pWin);
 
@@ -106,10 +148,13 @@ winReshapeMultiWindow(WindowPtr pWin)
         DeleteObject(pWinPriv->hRgn);
         pWinPriv->hRgn = NULL;
     }
+    pWinPriv->fShapeUnchanged = FALSE;
 
     /* Bail if the window has no bounding region defined */
-    if (!wBoundingShape(pWin))
+    if (!wBoundingShape(pWin)) {
+        winShapeCacheUpdate(pWinPriv, winShapeChecksum(NULL, 0, 0, 0, 0));
         return;
+    }
 
     RegionNull(&rrNewShape);
     RegionCopy(&rrNewShape, wBoundingShape(pWin));
@@ -122,12 +167,15 @@ winReshapeMultiWindow(WindowPtr pWin)
     if (nRects > 0) {
         RECT rcClient;
         RECT rcWindow;
+        RECT rcTitle;
         int iOffsetX, iOffsetY;
 
         /* Get client rectangle */
         if (!GetClientRect(pWinPriv->hWnd, &rcClient)) {
             ErrorF("winReshape - GetClientRect failed, bailing: %d\n",
                    (int) GetLastError());
+            pWinPriv->hWndShaped = NULL;
+            RegionUninit(&rrNewShape);
             return;
         }
 
@@ -139,6 +187,8 @@ winReshapeMultiWindow(WindowPtr pWin)
         if (!GetWindowRect(pWinPriv->hWnd, &rcWindow)) {
             ErrorF("winReshape - GetWindowRect failed, bailing: %d\n",
                    (int) GetLastError());
+            pWinPriv->hWndShaped = NULL;
+            RegionUninit(&rrNewShape);
             return;
         }
 
@@ -146,48 +196,30 @@ winReshapeMultiWindow(WindowPtr pWin)
         iOffsetX = rcClient.left - rcWindow.left;
         iOffsetY = rcClient.top - rcWindow.top;
 
-        /* Create initial Windows region for title bar */
-        /* FIXME: Mean, nasty, ugly hack!!! */
-        hRgn = CreateRectRgn(0, 0, rcWindow.right, iOffsetY);
-        if (hRgn == NULL) {
-            ErrorF("winReshape - Initial CreateRectRgn (%d, %d, %d, %d) "
-                   "failed: %d\n",
-                   0, 0, (int) rcWindow.right, iOffsetY, (int) GetLastError());
+        winShapeCacheUpdate(pWinPriv,
+                            winShapeChecksum(pShape, nRects, iOffsetX,
+                                             iOffsetY, rcWindow.right));
+        if (pWinPriv->fShapeUnchanged) {
+            RegionUninit(&rrNewShape);
+            return;
         }
 
-        /* Loop through all rectangles in the X region */
-        for (pRects = pShape, pEnd = pShape + nRects; pRects < pEnd; pRects++) {
-            /* Create a Windows region for the X rectangle */
-            hRgnRect = CreateRectRgn(pRects->x1 + iOffsetX,
-                                     pRects->y1 + iOffsetY,
-                                     pRects->x2 + iOffsetX,
-                                     pRects->y2 + iOffsetY);
-            if (hRgnRect == NULL) {
-                ErrorF("winReshape - Loop CreateRectRgn (%d, %d, %d, %d) "
-                       "failed: %d\n"
-                       "\tx1: %d x2: %d xOff: %d y1: %d y2: %d yOff: %d\n",
-                       pRects->x1 + iOffsetX,
-                       pRects->y1 + iOffsetY,
-                       pRects->x2 + iOffsetX,
-                       pRects->y2 + iOffsetY,
-                       (int) GetLastError(),
-                       pRects->x1, pRects->x2, iOffsetX,
-                       pRects->y1, pRects->y2, iOffsetY);
-            }
-
-            /* Merge the Windows region with the accumulated region */
-            if (CombineRgn(hRgn, hRgn, hRgnRect, RGN_OR) == ERROR) {
-                ErrorF("winReshape - CombineRgn () failed: %d\n",
-                       (int) GetLastError());
-            }
-
-            /* Delete the temporary Windows region */
-            DeleteObject(hRgnRect);
+        /* Windows region for the title bar, and the X rectangles */
+        /* FIXME: Mean, nasty, ugly hack!!! */
+        SetRect(&rcTitle, 0, 0, rcWindow.right, iOffsetY);
+        hRgn = winCreateRgnFromBoxes(pShape, nRects, iOffsetX, iOffsetY,
+                                     &rcTitle);
+        if (hRgn == NULL) {
+            ErrorF("winReshape - winCreateRgnFromBoxes () failed: %d\n",
+                   (int) GetLastError());
+            pWinPriv->hWndShaped = NULL;
         }
 
         /* Save a handle to the composite region in the window privates */
         pWinPriv->hRgn = hRgn;
     }
+    else
+        winShapeCacheUpdate(pWinPriv, winShapeChecksum(NULL, 0, 0, 0, 0));
 
     RegionUninit(&rrNewShape);
 
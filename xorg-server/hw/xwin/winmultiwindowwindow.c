@@ -57,6 +57,58 @@ static void
 static void
  winFindWindow(void *value, XID id, void *cdata);
 
+static void
+ winWindowIndexInsert(WindowPtr pWin);
+
+static void
+ winWindowIndexRemove(WindowPtr pWin);
+
+static void
+ winDeferWindowPosition(WindowPtr pWin, const RECT * prcNew);
+
+static void
+ winCancelWindowPosition(WindowPtr pWin);
+
+/*
+ * Windows windows moved or resized by X during this dispatch cycle
+ *
+ * The moves are applied together in one DeferWindowPos transaction from
+ * a block handler, which runs before the shadow update paints the
+ * windows, so DWM recomposes once per cycle rather than once per window.
+ */
+
+static WindowPtr *s_ppWinPositionPending;
+static int s_nPositionPending;
+static int s_nPositionPendingAlloc;
+static Bool s_fPositionFlushing;
+static unsigned long s_ulPositionGeneration;
+
+/*
+ * Spatial index of the top-level windows that own a Windows window
+ *
+ * The root window is divided into a grid of square cells, and every
+ * top-level window is listed in each cell that its drawable overlaps.
+ * The shadow update looks up the cells covered by the damage, so only
+ * windows that actually overlap the damage get invalidated.  Cells on
+ * the edges of the grid extend to infinity, so windows that are partly
+ * or entirely off the root window are still found.
+ */
+
+#define WIN_WINDOW_INDEX_CELL_SHIFT	8
+
+typedef struct _winWindowIndexCell {
+    int nWindows;
+    int nAlloc;
+    WindowPtr *ppWin;
+} winWindowIndexCellRec, *winWindowIndexCellPtr;
+
+typedef struct _winWindowIndexRec {
+    int iCellsX;
+    int iCellsY;
+    DWORD dwStamp;
+    winWindowIndexCellPtr pCells;
+} winWindowIndexRec, *winWindowIndexPtr;
+
 static
     void
 winInitMultiWindowClass(void)
@@ -118,6 +170,12 @@ winCreateWindowMultiWindow(WindowPtr pWin)
     pWinPriv->hWnd = NULL;
     pWinPriv->pScreenPriv = winGetScreenPriv(pWin->drawable.pScreen);
     pWinPriv->fXKilled = FALSE;
+    pWinPriv->fIndexed = FALSE;
+    pWinPriv->dwIndexStamp = 0;
+    pWinPriv->fPositionPending = FALSE;
+    pWinPriv->hWndShaped = NULL;
+    pWinPriv->fShapeUnchanged = FALSE;
+    pWinPriv->pThumbnail = NULL;
 #ifdef XWIN_GLX_WINDOWS
     pWinPriv->fWglUsed = FALSE;
 #endif
@@ -203,6 +261,9 @@ winPositionWindowMultiWindow(WindowPtr pWin, int x, int y)
         return fResult;
     }
 
+    /* Keep the damage index in step with the new geometry */
+    winWindowIndexInsert(pWin);
+
     /* Get the Windows window style and extended style */
     dwExStyle = GetWindowLongPtr(hWnd, GWL_EXSTYLE);
     dwStyle = GetWindowLongPtr(hWnd, GWL_STYLE);
@@ -230,8 +291,12 @@ winPositionWindowMultiWindow(WindowPtr pWin, int x, int y)
      */
     AdjustWindowRectEx(&rcNew, dwStyle, FALSE, dwExStyle);
 
-    /* Get a rectangle describing the old Windows window */
-    GetWindowRect(hWnd, &rcOld);
+    /* Get a rectangle describing the old Windows window, or where it is
+       about to be moved to */
+    if (pWinPriv->fPositionPending)
+        rcOld = pWinPriv->rcPending;
+    else
+        GetWindowRect(hWnd, &rcOld);
 
 #if CYGMULTIWINDOW_DEBUG
     /* Get a rectangle describing the Windows window client area */
@@ -261,15 +326,19 @@ winPositionWindowMultiWindow(WindowPtr pWin, int x, int y)
       {
         int iWidth=rcNew.right - rcNew.left;
         int iHeight=rcNew.bottom - rcNew.top;
+        winCancelWindowPosition(pWin);
         ScreenToClient(GetParent(hWnd), (LPPOINT)&rcNew);
         MoveWindow (hWnd,
                     rcNew.left, rcNew.top,
                     iWidth, iHeight, TRUE);
       }
-      else
+      else if (s_fPositionFlushing)
+        /* Windows adjusted a window we just moved, don't wait for it */
         MoveWindow (hWnd,
                     rcNew.left, rcNew.top,
                     rcNew.right - rcNew.left, rcNew.bottom - rcNew.top, TRUE);
+      else
+        winDeferWindowPosition(pWin, &rcNew);
     }
     else {
       winDebug ("winPositionWindowMultiWindow - Not need to move\n");
@@ -582,6 +651,8 @@ winCreateWindowsWindow(WindowPtr pWin)
                (int) GetLastError());
     }
     pWinPriv->hWnd = hWnd;
+    if (hWnd != NULL)
+        winWindowIndexInsert(pWin);
 
     /* If we asked the native WM to place the window, synchronize the X window position.
        Do this before the next SetWindowPos because this one is generating a WM_STYLECHANGED
@@ -634,6 +705,11 @@ winDestroyWindowsWindow(WindowPtr pWin)
 
     winInDestroyWindowsWindow = TRUE;
 
+    /* Stop sending shadow damage to this window */
+    winWindowIndexRemove(pWin);
+    winCancelWindowPosition(pWin);
+    winThumbnailFree(pWin);
+
     /* Store the info we need to destroy after this window is gone */
     hIcon = (HICON) SendMessage(pWinPriv->hWnd, WM_GETICON, ICON_BIG, 0);
     hIconSm = (HICON) SendMessage(pWinPriv->hWnd, WM_GETICON, ICON_SMALL, 0);
@@ -644,6 +720,9 @@ winDestroyWindowsWindow(WindowPtr pWin)
     /* Null our handle to the Window so referencing it will cause an error */
     pWinPriv->hWnd = NULL;
 
+    /* A new window may get the same handle, but not the shape */
+    pWinPriv->hWndShaped = NULL;
+
     /* Destroy any icons we created for this window */
     winDestroyIcon(hIcon);
     winDestroyIcon(hIconSm);
@@ -721,6 +800,8 @@ winUpdateWindowsWindow(WindowPtr pWin)
                 winDestroyWindowsWindow (pWin);
             else {
                 winDebug ("-winUpdateWindowsWindow: %x changing parent to %x and moving to %d,%d\n",pWinPriv->hWnd,hParentWnd,pWin->drawable.x-offsetx,pWin->drawable.y-offsety);
+                winWindowIndexRemove(pWin);
+                winCancelWindowPosition(pWin);
                 SetParent(pWinPriv->hWnd,hParentWnd);
                 SetWindowPos(pWinPriv->hWnd,NULL,pWin->drawable.x-offsetx,pWin->drawable.y-offsety,0,0,SWP_NOSIZE|SWP_NOZORDER|SWP_SHOWWINDOW);
             }
@@ -831,6 +912,160 @@ winReorderWindowsMultiWindow(void)
     fRestacking = FALSE;
 }
 
+/*
+ * Whether a deferred move still has to be made, and where to
+ */
+
+static Bool
+winPendingWindowPosition(WindowPtr pWin, HWND * phWnd, RECT * prcNew)
+{
+    winWindowPriv(pWin);
+    RECT rcOld;
+
+    if (!pWinPriv->fPositionPending || !pWinPriv->hWnd)
+        return FALSE;
+
+    GetWindowRect(pWinPriv->hWnd, &rcOld);
+    if (EqualRect(&rcOld, &pWinPriv->rcPending))
+        return FALSE;
+
+    *phWnd = pWinPriv->hWnd;
+    *prcNew = pWinPriv->rcPending;
+    return TRUE;
+}
+
+/*
+ * winFlushWindowPositions - Apply the moves deferred this cycle
+ */
+
+static void
+winFlushWindowPositions(void)
+{
+    HDWP hDwp;
+    HWND hWnd;
+    RECT rcNew;
+    int i;
+
+    if (s_nPositionPending == 0)
+        return;
+
+    s_fPositionFlushing = TRUE;
+
+    hDwp = BeginDeferWindowPos(s_nPositionPending);
+    for (i = 0; hDwp && i < s_nPositionPending; ++i) {
+        if (winPendingWindowPosition(s_ppWinPositionPending[i], &hWnd, &rcNew))
+            hDwp = DeferWindowPos(hDwp, hWnd, NULL,
+                                  rcNew.left, rcNew.top,
+                                  rcNew.right - rcNew.left,
+                                  rcNew.bottom - rcNew.top,
+                                  SWP_NOZORDER | SWP_NOACTIVATE);
+    }
+
+    if (hDwp) {
+        if (!EndDeferWindowPos(hDwp))
+            ErrorF("winFlushWindowPositions - EndDeferWindowPos () failed: "
+                   "%d\n", (int) GetLastError());
+    }
+    else {
+        /* A failed DeferWindowPos drops the whole batch, move one by one */
+        ErrorF("winFlushWindowPositions - DeferWindowPos () failed: %d\n",
+               (int) GetLastError());
+        for (i = 0; i < s_nPositionPending; ++i)
+            if (winPendingWindowPosition(s_ppWinPositionPending[i], &hWnd,
+                                         &rcNew))
+                MoveWindow(hWnd, rcNew.left, rcNew.top,
+                           rcNew.right - rcNew.left, rcNew.bottom - rcNew.top,
+                           TRUE);
+    }
+
+    for (i = 0; i < s_nPositionPending; ++i) {
+        winWindowPriv(s_ppWinPositionPending[i]);
+        pWinPriv->fPositionPending = FALSE;
+    }
+    s_nPositionPending = 0;
+
+    s_fPositionFlushing = FALSE;
+}
+
+static void
+winWindowPositionBlockHandler(void *blockData, void *pTimeout)
+{
+    winFlushWindowPositions();
+}
+
+static void
+winWindowPositionWakeupHandler(void *blockData, int result)
+{
+}
+
+/*
+ * winDeferWindowPosition - Move a Windows window at the end of the
+ * dispatch cycle
+ */
+
+static void
+winDeferWindowPosition(WindowPtr pWin, const RECT * prcNew)
+{
+    winWindowPriv(pWin);
+
+    if (!pWinPriv->fPositionPending) {
+        if (s_nPositionPending == s_nPositionPendingAlloc) {
+            int nAlloc = s_nPositionPendingAlloc ?
+                s_nPositionPendingAlloc * 2 : 16;
+            WindowPtr *ppWin = reallocarray(s_ppWinPositionPending, nAlloc,
+                                            sizeof(WindowPtr));
+
+            if (ppWin == NULL) {
+                ErrorF("winDeferWindowPosition - reallocarray () failed\n");
+                MoveWindow(pWinPriv->hWnd, prcNew->left, prcNew->top,
+                           prcNew->right - prcNew->left,
+                           prcNew->bottom - prcNew->top, TRUE);
+                return;
+            }
+            s_ppWinPositionPending = ppWin;
+            s_nPositionPendingAlloc = nAlloc;
+        }
+
+        /* Handlers are dropped at server reset */
+        if (s_ulPositionGeneration != serverGeneration) {
+            RegisterBlockAndWakeupHandlers(winWindowPositionBlockHandler,
+                                           winWindowPositionWakeupHandler,
+                                           NULL);
+            s_ulPositionGeneration = serverGeneration;
+        }
+
+        s_ppWinPositionPending[s_nPositionPending++] = pWin;
+        pWinPriv->fPositionPending = TRUE;
+    }
+
+    pWinPriv->rcPending = *prcNew;
+}
+
+/*
+ * winCancelWindowPosition - Forget a deferred move, the window is going
+ * away or is about to be moved some other way
+ */
+
+static void
+winCancelWindowPosition(WindowPtr pWin)
+{
+    int i;
+
+    winWindowPriv(pWin);
+
+    if (!pWinPriv->fPositionPending)
+        return;
+    pWinPriv->fPositionPending = FALSE;
+
+    for (i = 0; i < s_nPositionPending; ++i) {
+        if (s_ppWinPositionPending[i] == pWin) {
+            s_ppWinPositionPending[i] =
+                s_ppWinPositionPending[--s_nPositionPending];
+            break;
+        }
+    }
+}
+
 /*
  * CopyWindow - See Porting Layer Definition - p. 39
  */
@@ -978,3 +1213,266 @@ winAdjustXWindow(WindowPtr pWin, HWND hwnd)
 #undef WIDTH
 #undef HEIGHT
 }
+
+/*
+ * Map a root window coordinate to the index cell containing it
+ */
+
+static int
+winWindowIndexCell(int iCoord, int nCells)
+{
+    if (iCoord < 0)
+        return 0;
+    iCoord >>= WIN_WINDOW_INDEX_CELL_SHIFT;
+    return iCoord < nCells ? iCoord : nCells - 1;
+}
+
+/*
+ * winWindowIndexInsert - (Re)insert a top-level window into the
+ * damage index of its screen, using its current drawable geometry
+ */
+
+static void
+winWindowIndexInsert(WindowPtr pWin)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+    winWindowIndexPtr pIndex;
+    BoxRec box;
+    int x, y, x1, y1, x2, y2;
+
+    winWindowPriv(pWin);
+    winScreenPriv(pScreen);
+
+    /* Only top-level windows are painted from the shadow framebuffer */
+    if (pWinPriv->hWnd == NULL || pWin->parent == NULL
+        || pWin->parent->parent != NULL) {
+        winWindowIndexRemove(pWin);
+        return;
+    }
+
+    box.x1 = pWin->drawable.x;
+    box.y1 = pWin->drawable.y;
+    box.x2 = pWin->drawable.x + pWin->drawable.width;
+    box.y2 = pWin->drawable.y + pWin->drawable.height;
+
+    /* Nothing to do if the window has not changed geometry */
+    if (pWinPriv->fIndexed
+        && pWinPriv->boxIndexed.x1 == box.x1
+        && pWinPriv->boxIndexed.y1 == box.y1
+        && pWinPriv->boxIndexed.x2 == box.x2
+        && pWinPriv->boxIndexed.y2 == box.y2)
+        return;
+
+    winWindowIndexRemove(pWin);
+
+    /* Create the grid the first time it is needed */
+    pIndex = pScreenPriv->pWindowIndex;
+    if (pIndex == NULL) {
+        pIndex = calloc(1, sizeof(winWindowIndexRec));
+        if (pIndex == NULL) {
+            ErrorF("winWindowIndexInsert - calloc () failed\n");
+            return;
+        }
+        pIndex->iCellsX = (pScreen->width >> WIN_WINDOW_INDEX_CELL_SHIFT) + 1;
+        pIndex->iCellsY = (pScreen->height >> WIN_WINDOW_INDEX_CELL_SHIFT) + 1;
+        pIndex->pCells = calloc(pIndex->iCellsX * pIndex->iCellsY,
+                                sizeof(winWindowIndexCellRec));
+        if (pIndex->pCells == NULL) {
+            ErrorF("winWindowIndexInsert - calloc () failed\n");
+            free(pIndex);
+            return;
+        }
+        pScreenPriv->pWindowIndex = pIndex;
+    }
+
+    x1 = winWindowIndexCell(box.x1, pIndex->iCellsX);
+    y1 = winWindowIndexCell(box.y1, pIndex->iCellsY);
+    x2 = winWindowIndexCell(box.x2 - 1, pIndex->iCellsX);
+    y2 = winWindowIndexCell(box.y2 - 1, pIndex->iCellsY);
+
+    for (y = y1; y <= y2; ++y) {
+        for (x = x1; x <= x2; ++x) {
+            winWindowIndexCellPtr pCell =
+                &pIndex->pCells[y * pIndex->iCellsX + x];
+
+            if (pCell->nWindows == pCell->nAlloc) {
+                int nAlloc = pCell->nAlloc ? pCell->nAlloc * 2 : 4;
+                WindowPtr *ppWin = reallocarray(pCell->ppWin, nAlloc,
+                                                sizeof(WindowPtr));
+
+                if (ppWin == NULL) {
+                    ErrorF("winWindowIndexInsert - reallocarray () failed\n");
+                    continue;
+                }
+                pCell->ppWin = ppWin;
+                pCell->nAlloc = nAlloc;
+            }
+            pCell->ppWin[pCell->nWindows++] = pWin;
+        }
+    }
+
+    pWinPriv->boxIndexed = box;
+    pWinPriv->fIndexed = TRUE;
+}
+
+/*
+ * winWindowIndexRemove - Remove a window from the damage index
+ */
+
+static void
+winWindowIndexRemove(WindowPtr pWin)
+{
+    winWindowIndexPtr pIndex;
+    int x, y, x1, y1, x2, y2, i;
+
+    winWindowPriv(pWin);
+    winScreenPriv(pWin->drawable.pScreen);
+
+    if (!pWinPriv->fIndexed)
+        return;
+    pWinPriv->fIndexed = FALSE;
+
+    pIndex = pScreenPriv->pWindowIndex;
+    if (pIndex == NULL)
+        return;
+
+    x1 = winWindowIndexCell(pWinPriv->boxIndexed.x1, pIndex->iCellsX);
+    y1 = winWindowIndexCell(pWinPriv->boxIndexed.y1, pIndex->iCellsY);
+    x2 = winWindowIndexCell(pWinPriv->boxIndexed.x2 - 1, pIndex->iCellsX);
+    y2 = winWindowIndexCell(pWinPriv->boxIndexed.y2 - 1, pIndex->iCellsY);
+
+    for (y = y1; y <= y2; ++y) {
+        for (x = x1; x <= x2; ++x) {
+            winWindowIndexCellPtr pCell =
+                &pIndex->pCells[y * pIndex->iCellsX + x];
+
+            /* Order within a cell does not matter */
+            for (i = 0; i < pCell->nWindows; ++i) {
+                if (pCell->ppWin[i] == pWin) {
+                    pCell->ppWin[i] = pCell->ppWin[--pCell->nWindows];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Invalidate the part of a Windows window covered by the damage
+ */
+
+static void
+winWindowIndexRedraw(HWND hwnd, RegionPtr pDamage, BoxPtr pBox)
+{
+    RegionRec rgnRedraw;
+    RECT rcClient, rcDamage, rcRedraw;
+    POINT ptOrigin = { 0, 0 };
+    BoxPtr pRects;
+    int nRects, i;
+    Bool fInvalidated = FALSE;
+
+    if (IsIconic(hwnd))
+        return;                 /* Don't care minimized windows */
+
+    /* Only the window's own share of the damage */
+    RegionInit(&rgnRedraw, pBox, 1);
+    RegionIntersect(&rgnRedraw, &rgnRedraw, pDamage);
+
+    /* Locate the client area in root window coordinates */
+    ClientToScreen(hwnd, &ptOrigin);
+    ptOrigin.x -= GetSystemMetrics(SM_XVIRTUALSCREEN);
+    ptOrigin.y -= GetSystemMetrics(SM_YVIRTUALSCREEN);
+    GetClientRect(hwnd, &rcClient);
+
+    nRects = RegionNumRects(&rgnRedraw);
+    pRects = RegionRects(&rgnRedraw);
+    for (i = 0; i < nRects; ++i) {
+        SetRect(&rcDamage,
+                pRects[i].x1 - ptOrigin.x, pRects[i].y1 - ptOrigin.y,
+                pRects[i].x2 - ptOrigin.x, pRects[i].y2 - ptOrigin.y);
+        if (IntersectRect(&rcRedraw, &rcClient, &rcDamage)) {
+            InvalidateRect(hwnd, &rcRedraw, FALSE);
+            fInvalidated = TRUE;
+        }
+    }
+    RegionUninit(&rgnRedraw);
+
+    if (fInvalidated)
+        UpdateWindow(hwnd);
+}
+
+/*
+ * winWindowIndexDamage - Send shadow framebuffer damage to the
+ * Windows windows it overlaps
+ */
+
+void
+winWindowIndexDamage(ScreenPtr pScreen, RegionPtr pDamage)
+{
+    winScreenPriv(pScreen);
+    winWindowIndexPtr pIndex = pScreenPriv->pWindowIndex;
+    BoxPtr pExtents;
+    DWORD dwStamp;
+    int x, y, x1, y1, x2, y2, i;
+
+    if (pIndex == NULL || RegionNil(pDamage))
+        return;
+
+    pExtents = RegionExtents(pDamage);
+
+    /* Windows spanning several cells are only visited once per update */
+    dwStamp = ++pIndex->dwStamp;
+    if (dwStamp == 0)
+        dwStamp = ++pIndex->dwStamp;
+
+    x1 = winWindowIndexCell(pExtents->x1, pIndex->iCellsX);
+    y1 = winWindowIndexCell(pExtents->y1, pIndex->iCellsY);
+    x2 = winWindowIndexCell(pExtents->x2 - 1, pIndex->iCellsX);
+    y2 = winWindowIndexCell(pExtents->y2 - 1, pIndex->iCellsY);
+
+    for (y = y1; y <= y2; ++y) {
+        for (x = x1; x <= x2; ++x) {
+            winWindowIndexCellPtr pCell =
+                &pIndex->pCells[y * pIndex->iCellsX + x];
+
+            for (i = 0; i < pCell->nWindows; ++i) {
+                winPrivWinPtr pWinPriv = winGetWindowPriv(pCell->ppWin[i]);
+                BoxRec box;
+
+                if (pWinPriv->dwIndexStamp == dwStamp)
+                    continue;
+                pWinPriv->dwIndexStamp = dwStamp;
+
+                box.x1 = max(pWinPriv->boxIndexed.x1, pExtents->x1);
+                box.y1 = max(pWinPriv->boxIndexed.y1, pExtents->y1);
+                box.x2 = min(pWinPriv->boxIndexed.x2, pExtents->x2);
+                box.y2 = min(pWinPriv->boxIndexed.y2, pExtents->y2);
+                if (box.x1 >= box.x2 || box.y1 >= box.y2)
+                    continue;
+
+                winWindowIndexRedraw(pWinPriv->hWnd, pDamage, &box);
+            }
+        }
+    }
+}
+
+/*
+ * winWindowIndexFree - Release the damage index of a screen
+ */
+
+void
+winWindowIndexFree(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winWindowIndexPtr pIndex = pScreenPriv->pWindowIndex;
+    int i;
+
+    if (pIndex == NULL)
+        return;
+
+    for (i = 0; i < pIndex->iCellsX * pIndex->iCellsY; ++i)
+        free(pIndex->pCells[i].ppWin);
+    free(pIndex->pCells);
+    free(pIndex);
+    pScreenPriv->pWindowIndex = NULL;
+}
@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 #ifdef __CYGWIN__
 #include <sys/select.h>
 #endif
@@ -67,6 +68,7 @@ typedef int pid_t;
 #include "winglobals.h"
 #include "windisplay.h"
 #include "winmultiwindowicons.h"
+#include "frametrace.h"
 
 #include <xcb/xcb.h>
 #include <xcb/xcb_icccm.h>
@@ -119,6 +121,61 @@ typedef struct _WMMsgQueueRec {
     pthread_cond_t pcNotEmpty;
 } WMMsgQueueRec, *WMMsgQueuePtr;
 
+/*
+ * Properties of a managed window which are cached by the WM thread.  A slot
+ * is fetched on first use and dropped again when PropertyNotify for its atom
+ * is forwarded by the XMsgProc thread.
+ */
+
+typedef enum {
+    WM_PROP_NET_WM_NAME,
+    WM_PROP_WM_NAME,
+    WM_PROP_WM_CLIENT_MACHINE,
+    WM_PROP_WM_CLASS,
+    WM_PROP_WM_HINTS,
+    WM_PROP_WM_NORMAL_HINTS,
+    WM_PROP_WM_PROTOCOLS,
+    WM_PROP_NET_WM_STATE,
+    WM_PROP_NET_WM_WINDOW_TYPE,
+    WM_PROP_MOTIF_WM_HINTS,
+    WM_PROP_COUNT
+} WMPropIndex;
+
+#define WM_PROP_MASK(prop)	(1U << (prop))
+#define WM_PROP_PROPERTIES	(WM_PROP_MASK(WM_PROP_COUNT) - 1)
+#define WM_PROP_HWND		(1U << 30)
+#define WM_PROP_ATTRIBUTES	(1U << 31)
+#define WM_PROP_ALL		(WM_PROP_PROPERTIES | WM_PROP_HWND | WM_PROP_ATTRIBUTES)
+#define WM_PROP_NAMES		(WM_PROP_MASK(WM_PROP_NET_WM_NAME) | \
+				 WM_PROP_MASK(WM_PROP_WM_NAME))
+#define WM_PROP_HINTS		(WM_PROP_MASK(WM_PROP_WM_HINTS) | \
+				 WM_PROP_MASK(WM_PROP_WM_NORMAL_HINTS) | \
+				 WM_PROP_MASK(WM_PROP_NET_WM_STATE) | \
+				 WM_PROP_MASK(WM_PROP_NET_WM_WINDOW_TYPE) | \
+				 WM_PROP_MASK(WM_PROP_MOTIF_WM_HINTS))
+
+#define WM_PROP_CACHE_BUCKETS	64
+#define WM_PROP_BATCH_MAX	64
+
+typedef struct _WMPropRequestRec {
+    xcb_atom_t atom;
+    xcb_atom_t type;
+    uint32_t long_length;
+} WMPropRequestRec;
+
+typedef struct _WMPropCacheRec {
+    struct _WMPropCacheRec *pNext;
+    xcb_window_t iWindow;
+    unsigned int uValid;
+    xcb_get_property_reply_t *apReply[WM_PROP_COUNT];
+    HWND hWnd;
+    Bool fOverrideRedirect;
+    Bool fPrefetched;
+    char *pszTitle;             /* title last given to hWnd */
+    DWORD dwTitleSet;           /* and the GetTickCount() then */
+    Bool fTitlePending;         /* the title changed again since */
+} WMPropCacheRec, *WMPropCachePtr;
+
 typedef struct _WMInfo {
     xcb_connection_t *conn;
     xcb_errors_context_t *err_ctx;
@@ -133,8 +190,15 @@ typedef struct _WMInfo {
     xcb_atom_t atmNumberDesktops;
     xcb_atom_t atmDesktopNames;
     xcb_atom_t atmWmState;
+    xcb_atom_t atmMotifWmHints;
     xcb_ewmh_connection_t ewmh;
     Bool fCompositeWM;
+    WMPropRequestRec aPropRequest[WM_PROP_COUNT];
+    WMPropCachePtr apPropCache[WM_PROP_CACHE_BUCKETS];
+    WMPropCacheRec propScratch;
+    Bool fTitlesPending;        /* some fTitlePending may be set */
+    wchar_t *pwszTitle;         /* conversion buffer for titles */
+    int cchTitle;
 } WMInfoRec, *WMInfoPtr;
 
 typedef struct _WMProcArgRec {
@@ -159,7 +223,8 @@ typedef struct _XMsgProcArgRec {
 static void
  PushMessage(WMMsgQueuePtr pQueue, WMMsgNodePtr pNode);
 
-static WMMsgNodePtr PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo);
+static WMMsgNodePtr PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo,
+                               int iTimeout);
 
 static Bool
  InitQueue(WMMsgQueuePtr pQueue);
@@ -171,7 +236,10 @@ static void
  SendXMessage(xcb_connection_t *conn, xcb_window_t iWin, xcb_atom_t atmType, long nData);
 
 static void
- UpdateName(WMInfoPtr pWMInfo, xcb_window_t iWindow);
+ UpdateName(WMInfoPtr pWMInfo, xcb_window_t iWindow, Bool fThrottle);
+
+static int
+ UpdatePendingNames(WMInfoPtr pWMInfo);
 
 static void *winMultiWindowWMProc(void *pArg);
 
@@ -247,6 +315,9 @@ MessageName(winWMMessagePtr msg)
     case WM_WM_HINTS_EVENT:
       return "WM_WM_HINTS_EVENT";
       break;
+    case WM_WM_PROPERTY_EVENT:
+      return "WM_WM_PROPERTY_EVENT";
+      break;
     default:
       return "Unknown Message";
       break;
@@ -287,16 +358,27 @@ PushMessage(WMMsgQueuePtr pQueue, WMMsgNodePtr pNode)
  */
 
 static WMMsgNodePtr
-PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo)
+PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo, int iTimeout)
 {
     WMMsgNodePtr pNode;
+    struct timespec tsTimeout, tsAbsolute;
+
+    if (iTimeout >= 0) {
+        tsTimeout.tv_sec = iTimeout / 1000;
+        tsTimeout.tv_nsec = (iTimeout % 1000) * 1000000L;
+        pthread_win32_getabstime_np(&tsAbsolute, &tsTimeout);
+    }
 
     /* Lock the queue mutex */
     pthread_mutex_lock(&pQueue->pmMutex);
 
-    /* Wait for --- */
+    /* Wait for a message, or until iTimeout milliseconds have passed */
     while (pQueue->pHead == NULL) {
-        pthread_cond_wait(&pQueue->pcNotEmpty, &pQueue->pmMutex);
+        if (iTimeout < 0)
+            pthread_cond_wait(&pQueue->pcNotEmpty, &pQueue->pmMutex);
+        else if (pthread_cond_timedwait(&pQueue->pcNotEmpty, &pQueue->pmMutex,
+                                        &tsAbsolute) == ETIMEDOUT)
+            break;
     }
 
     pNode = pQueue->pHead;
@@ -366,6 +448,447 @@ InitQueue(WMMsgQueuePtr pQueue)
     return TRUE;
 }
 
+/*
+ * WMPropCacheInit - Describe the property requests used to fill the cache
+ */
+
+static void
+WMPropCacheInit(WMInfoPtr pWMInfo)
+{
+    WMPropRequestRec *pReq = pWMInfo->aPropRequest;
+
+    pReq[WM_PROP_NET_WM_NAME].atom = pWMInfo->atmNetWmName;
+    pReq[WM_PROP_NET_WM_NAME].type = XCB_GET_PROPERTY_TYPE_ANY;
+    pReq[WM_PROP_NET_WM_NAME].long_length = INT_MAX;
+
+    pReq[WM_PROP_WM_NAME].atom = XCB_ATOM_WM_NAME;
+    pReq[WM_PROP_WM_NAME].type = XCB_GET_PROPERTY_TYPE_ANY;
+    pReq[WM_PROP_WM_NAME].long_length = INT_MAX;
+
+    pReq[WM_PROP_WM_CLIENT_MACHINE].atom = XCB_ATOM_WM_CLIENT_MACHINE;
+    pReq[WM_PROP_WM_CLIENT_MACHINE].type = XCB_GET_PROPERTY_TYPE_ANY;
+    pReq[WM_PROP_WM_CLIENT_MACHINE].long_length = INT_MAX;
+
+    pReq[WM_PROP_WM_CLASS].atom = XCB_ATOM_WM_CLASS;
+    pReq[WM_PROP_WM_CLASS].type = XCB_ATOM_STRING;
+    pReq[WM_PROP_WM_CLASS].long_length = 2048;
+
+    pReq[WM_PROP_WM_HINTS].atom = XCB_ATOM_WM_HINTS;
+    pReq[WM_PROP_WM_HINTS].type = XCB_ATOM_WM_HINTS;
+    pReq[WM_PROP_WM_HINTS].long_length = XCB_ICCCM_NUM_WM_HINTS_ELEMENTS;
+
+    pReq[WM_PROP_WM_NORMAL_HINTS].atom = XCB_ATOM_WM_NORMAL_HINTS;
+    pReq[WM_PROP_WM_NORMAL_HINTS].type = XCB_ATOM_WM_SIZE_HINTS;
+    pReq[WM_PROP_WM_NORMAL_HINTS].long_length = XCB_ICCCM_NUM_WM_SIZE_HINTS_ELEMENTS;
+
+    pReq[WM_PROP_WM_PROTOCOLS].atom = pWMInfo->ewmh.WM_PROTOCOLS;
+    pReq[WM_PROP_WM_PROTOCOLS].type = XCB_ATOM_ATOM;
+    pReq[WM_PROP_WM_PROTOCOLS].long_length = INT_MAX;
+
+    pReq[WM_PROP_NET_WM_STATE].atom = pWMInfo->ewmh._NET_WM_STATE;
+    pReq[WM_PROP_NET_WM_STATE].type = XCB_ATOM_ATOM;
+    pReq[WM_PROP_NET_WM_STATE].long_length = INT_MAX;
+
+    pReq[WM_PROP_NET_WM_WINDOW_TYPE].atom = pWMInfo->ewmh._NET_WM_WINDOW_TYPE;
+    pReq[WM_PROP_NET_WM_WINDOW_TYPE].type = XCB_ATOM_ATOM;
+    pReq[WM_PROP_NET_WM_WINDOW_TYPE].long_length = INT_MAX;
+
+    pReq[WM_PROP_MOTIF_WM_HINTS].atom = pWMInfo->atmMotifWmHints;
+    pReq[WM_PROP_MOTIF_WM_HINTS].type = pWMInfo->atmMotifWmHints;
+    pReq[WM_PROP_MOTIF_WM_HINTS].long_length = sizeof(MwmHints);
+}
+
+/*
+ * WMPropCacheReset - Drop everything cached for a window
+ */
+
+static void
+WMPropCacheReset(WMPropCachePtr pCache)
+{
+    int i;
+
+    for (i = 0; i < WM_PROP_COUNT; i++) {
+        free(pCache->apReply[i]);
+        pCache->apReply[i] = NULL;
+    }
+
+    pCache->uValid = 0;
+    pCache->hWnd = NULL;
+    pCache->fOverrideRedirect = FALSE;
+    pCache->fPrefetched = FALSE;
+    free(pCache->pszTitle);
+    pCache->pszTitle = NULL;
+    pCache->fTitlePending = FALSE;
+}
+
+static WMPropCachePtr
+WMPropCacheFind(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMPropCachePtr pCache;
+
+    for (pCache = pWMInfo->apPropCache[iWindow % WM_PROP_CACHE_BUCKETS];
+         pCache != NULL; pCache = pCache->pNext) {
+        if (pCache->iWindow == iWindow)
+            return pCache;
+    }
+
+    return NULL;
+}
+
+static WMPropCachePtr
+WMPropCacheAdd(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMPropCachePtr pCache = WMPropCacheFind(pWMInfo, iWindow);
+    WMPropCachePtr *ppBucket;
+
+    if (pCache)
+        return pCache;
+
+    /* A window we were already looking at outside the cache */
+    if (pWMInfo->propScratch.iWindow == iWindow) {
+        WMPropCacheReset(&pWMInfo->propScratch);
+        pWMInfo->propScratch.iWindow = XCB_NONE;
+    }
+
+    pCache = calloc(1, sizeof(WMPropCacheRec));
+    if (!pCache)
+        return NULL;
+
+    ppBucket = &pWMInfo->apPropCache[iWindow % WM_PROP_CACHE_BUCKETS];
+    pCache->iWindow = iWindow;
+    pCache->pNext = *ppBucket;
+    *ppBucket = pCache;
+
+    return pCache;
+}
+
+static void
+WMPropCacheRemove(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMPropCachePtr *ppCache;
+
+    for (ppCache = &pWMInfo->apPropCache[iWindow % WM_PROP_CACHE_BUCKETS];
+         *ppCache != NULL; ppCache = &(*ppCache)->pNext) {
+        WMPropCachePtr pCache = *ppCache;
+
+        if (pCache->iWindow == iWindow) {
+            *ppCache = pCache->pNext;
+            WMPropCacheReset(pCache);
+            free(pCache);
+            return;
+        }
+    }
+}
+
+static void
+WMPropCacheFree(WMInfoPtr pWMInfo)
+{
+    int i;
+
+    for (i = 0; i < WM_PROP_CACHE_BUCKETS; i++) {
+        while (pWMInfo->apPropCache[i])
+            WMPropCacheRemove(pWMInfo, pWMInfo->apPropCache[i]->iWindow);
+    }
+
+    WMPropCacheReset(&pWMInfo->propScratch);
+    pWMInfo->propScratch.iWindow = XCB_NONE;
+}
+
+/*
+ * WMPropCacheInvalidate - Forget the cached slots in uMask for a window
+ */
+
+static void
+WMPropCacheInvalidate(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned int uMask)
+{
+    WMPropCachePtr pCache = WMPropCacheFind(pWMInfo, iWindow);
+    int i;
+
+    if (!pCache)
+        return;
+
+    for (i = 0; i < WM_PROP_COUNT; i++) {
+        if (uMask & WM_PROP_MASK(i)) {
+            free(pCache->apReply[i]);
+            pCache->apReply[i] = NULL;
+        }
+    }
+
+    pCache->uValid &= ~uMask;
+}
+
+/*
+ * WMPropAtomMask - Map a changed property to the cache slots it affects,
+ * using uDefault when the sender didn't say which property changed
+ */
+
+static unsigned int
+WMPropAtomMask(WMInfoPtr pWMInfo, xcb_atom_t atom, unsigned int uDefault)
+{
+    int i;
+
+    if (atom == XCB_NONE)
+        return uDefault;
+
+    for (i = 0; i < WM_PROP_COUNT; i++) {
+        if (pWMInfo->aPropRequest[i].atom == atom)
+            return WM_PROP_MASK(i);
+    }
+
+    return 0;
+}
+
+/*
+ * WMPropFetch - Fill the missing slots in uWanted for a batch of windows
+ *
+ * Every request for every window is sent before the first reply is waited
+ * for, so the whole batch costs a single round-trip to the server.
+ */
+
+static void
+WMPropFetch(WMInfoPtr pWMInfo, WMPropCachePtr *ppCache, int nCache,
+            unsigned int uWanted)
+{
+    xcb_connection_t *conn = pWMInfo->conn;
+    xcb_get_property_cookie_t aCookie[WM_PROP_BATCH_MAX][WM_PROP_COUNT];
+    xcb_get_property_cookie_t aCookieHwnd[WM_PROP_BATCH_MAX];
+    xcb_get_window_attributes_cookie_t aCookieAttr[WM_PROP_BATCH_MAX];
+    unsigned int auMissing[WM_PROP_BATCH_MAX];
+    int i, j;
+
+    nCache = min(nCache, WM_PROP_BATCH_MAX);
+
+    for (i = 0; i < nCache; i++) {
+        xcb_window_t iWindow = ppCache[i]->iWindow;
+
+        auMissing[i] = uWanted & ~ppCache[i]->uValid;
+
+        for (j = 0; j < WM_PROP_COUNT; j++) {
+            const WMPropRequestRec *pReq = &pWMInfo->aPropRequest[j];
+
+            if (auMissing[i] & WM_PROP_MASK(j))
+                aCookie[i][j] = xcb_get_property(conn, FALSE, iWindow,
+                                                 pReq->atom, pReq->type,
+                                                 0, pReq->long_length);
+        }
+
+        if (auMissing[i] & WM_PROP_HWND)
+            aCookieHwnd[i] = xcb_get_property(conn, FALSE, iWindow,
+                                              pWMInfo->atmPrivMap,
+                                              XCB_ATOM_INTEGER, 0L,
+                                              sizeof(HWND)/4L);
+
+        if (auMissing[i] & WM_PROP_ATTRIBUTES)
+            aCookieAttr[i] = xcb_get_window_attributes(conn, iWindow);
+    }
+
+    for (i = 0; i < nCache; i++) {
+        WMPropCachePtr pCache = ppCache[i];
+
+        for (j = 0; j < WM_PROP_COUNT; j++) {
+            xcb_get_property_reply_t *reply;
+
+            if (!(auMissing[i] & WM_PROP_MASK(j)))
+                continue;
+
+            reply = xcb_get_property_reply(conn, aCookie[i][j], NULL);
+            if (reply && (reply->type == XCB_NONE)) {
+                free(reply);
+                reply = NULL;
+            }
+            pCache->apReply[j] = reply;
+        }
+
+        if (auMissing[i] & WM_PROP_HWND) {
+            xcb_get_property_reply_t *reply;
+
+            pCache->hWnd = NULL;
+            reply = xcb_get_property_reply(conn, aCookieHwnd[i], NULL);
+            if (reply) {
+                int length = xcb_get_property_value_length(reply);
+                HWND *value = xcb_get_property_value(reply);
+
+                if (value && (length == sizeof(HWND)))
+                    pCache->hWnd = *value;
+                free(reply);
+            }
+        }
+
+        if (auMissing[i] & WM_PROP_ATTRIBUTES) {
+            xcb_get_window_attributes_reply_t *reply;
+
+            pCache->fOverrideRedirect = FALSE;
+            reply = xcb_get_window_attributes_reply(conn, aCookieAttr[i], NULL);
+            if (reply) {
+                pCache->fOverrideRedirect = (reply->override_redirect != 0);
+                free(reply);
+            }
+            else {
+                ErrorF("WMPropFetch: Failed to get window attributes\n");
+            }
+        }
+
+        pCache->uValid |= auMissing[i];
+    }
+}
+
+/*
+ * WMPropEntry - Find the cache entry for a window
+ *
+ * Windows which aren't managed have no entry of their own, and share a
+ * scratch entry which only lives until the current message is handled.
+ */
+
+static WMPropCachePtr
+WMPropEntry(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMPropCachePtr pCache = WMPropCacheFind(pWMInfo, iWindow);
+
+    if (pCache)
+        return pCache;
+
+    pCache = &pWMInfo->propScratch;
+    if (pCache->iWindow != iWindow) {
+        WMPropCacheReset(pCache);
+        pCache->iWindow = iWindow;
+    }
+
+    return pCache;
+}
+
+/*
+ * WMPropGet - Get a cached property of a window, or NULL if it isn't set
+ *
+ * The reply belongs to the cache.  On a miss every other missing slot is
+ * fetched in the same round-trip, as callers usually want several of them.
+ */
+
+static xcb_get_property_reply_t *
+WMPropGet(WMInfoPtr pWMInfo, xcb_window_t iWindow, WMPropIndex prop)
+{
+    WMPropCachePtr pCache = WMPropEntry(pWMInfo, iWindow);
+
+    if (!(pCache->uValid & WM_PROP_MASK(prop)))
+        WMPropFetch(pWMInfo, &pCache, 1, WM_PROP_ALL);
+
+    return pCache->apReply[prop];
+}
+
+/*
+ * WMPropSetHwnd - Record the HWND we just stored on a window
+ */
+
+static void
+WMPropSetHwnd(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd)
+{
+    WMPropCachePtr pCache = WMPropEntry(pWMInfo, iWindow);
+
+    /* A new HWND has no title yet */
+    if (pCache->hWnd != hWnd) {
+        free(pCache->pszTitle);
+        pCache->pszTitle = NULL;
+    }
+    pCache->hWnd = hWnd;
+    pCache->uValid |= WM_PROP_HWND;
+}
+
+/*
+ * WMPropAtoms - Get the contents of an ATOM list property
+ */
+
+static xcb_atom_t *
+WMPropAtoms(WMInfoPtr pWMInfo, xcb_window_t iWindow, WMPropIndex prop,
+            int *pnAtoms)
+{
+    xcb_get_property_reply_t *reply = WMPropGet(pWMInfo, iWindow, prop);
+
+    *pnAtoms = 0;
+    if (!reply || (reply->type != XCB_ATOM_ATOM) || (reply->format != 32))
+        return NULL;
+
+    *pnAtoms = xcb_get_property_value_length(reply)/sizeof(xcb_atom_t);
+    return xcb_get_property_value(reply);
+}
+
+/*
+ * WMPropTextProperty - Get a text property in the form xcb_icccm returns it
+ */
+
+static Bool
+WMPropTextProperty(WMInfoPtr pWMInfo, xcb_window_t iWindow, WMPropIndex prop,
+                   xcb_icccm_get_text_property_reply_t *xtp)
+{
+    xcb_get_property_reply_t *reply = WMPropGet(pWMInfo, iWindow, prop);
+
+    if (!reply)
+        return FALSE;
+
+    xtp->_reply = NULL;
+    xtp->encoding = reply->type;
+    xtp->format = reply->format;
+    xtp->name_len = xcb_get_property_value_length(reply);
+    xtp->name = xcb_get_property_value(reply);
+
+    return TRUE;
+}
+
+/*
+ * WMPropPrefetchMapped - Fetch everything for a window being mapped
+ *
+ * Other windows whose WM_WM_MAP_MANAGED is still queued are fetched in the
+ * same pass, so a burst of maps costs one round-trip rather than a dozen
+ * per window.
+ */
+
+static void
+WMPropPrefetchMapped(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMPropCachePtr apCache[WM_PROP_BATCH_MAX];
+    WMPropCachePtr pCache;
+    WMMsgNodePtr pNode;
+    int nCache = 0;
+
+    pCache = WMPropCacheAdd(pWMInfo, iWindow);
+    if (!pCache)
+        return;
+
+    /* Already fetched along with an earlier window in the batch */
+    if (pCache->fPrefetched) {
+        pCache->fPrefetched = FALSE;
+        return;
+    }
+
+    WMPropCacheReset(pCache);
+    pCache->fPrefetched = TRUE;
+    apCache[nCache++] = pCache;
+
+    pthread_mutex_lock(&pWMInfo->wmMsgQueue.pmMutex);
+
+    for (pNode = pWMInfo->wmMsgQueue.pHead;
+         (pNode != NULL) && (nCache < WM_PROP_BATCH_MAX);
+         pNode = pNode->pNext) {
+        if (pNode->msg.msg != WM_WM_MAP_MANAGED)
+            continue;
+
+        pCache = WMPropCacheAdd(pWMInfo, pNode->msg.iWindow);
+        if (!pCache || pCache->fPrefetched)
+            continue;
+
+        WMPropCacheReset(pCache);
+        pCache->fPrefetched = TRUE;
+        apCache[nCache++] = pCache;
+    }
+
+    pthread_mutex_unlock(&pWMInfo->wmMsgQueue.pmMutex);
+
+    apCache[0]->fPrefetched = FALSE;
+
+    /* The HWND is recorded as the WM_WM_MAP_MANAGED message is handled */
+    WMPropFetch(pWMInfo, apCache, nCache, WM_PROP_ALL & ~WM_PROP_HWND);
+
+    winDebug("WMPropPrefetchMapped - fetched %d windows\n", nCache);
+}
+
 static
 char *
 Xutf8TextPropertyToString(WMInfoPtr pWMInfo, xcb_icccm_get_text_property_reply_t *xtp)
@@ -394,61 +917,49 @@ Xutf8TextPropertyToString(WMInfoPtr pWMInfo, xcb_icccm_get_text_property_reply_t
 static void
 GetWindowName(WMInfoPtr pWMInfo, xcb_window_t iWin, char **ppWindowName)
 {
-    xcb_connection_t *conn = pWMInfo->conn;
     char *pszWindowName = NULL;
 
     winDebug ("GetWindowName\n");
 
     /* Try to get window name from _NET_WM_NAME */
     {
-        xcb_get_property_cookie_t cookie;
         xcb_get_property_reply_t *reply;
 
-        cookie = xcb_get_property(pWMInfo->conn, FALSE, iWin,
-                                  pWMInfo->atmNetWmName,
-                                  XCB_GET_PROPERTY_TYPE_ANY, 0, INT_MAX);
-        reply = xcb_get_property_reply(pWMInfo->conn, cookie, NULL);
-        if (reply && (reply->type != XCB_NONE)) {
+        reply = WMPropGet(pWMInfo, iWin, WM_PROP_NET_WM_NAME);
+        if (reply) {
             pszWindowName = strndup(xcb_get_property_value(reply),
                                     xcb_get_property_value_length(reply));
-            free(reply);
         }
     }
 
     /* Otherwise, try to get window name from WM_NAME */
     if (!pszWindowName)
         {
-            xcb_get_property_cookie_t cookie;
             xcb_icccm_get_text_property_reply_t reply;
 
-            cookie = xcb_icccm_get_wm_name(conn, iWin);
-            if (!xcb_icccm_get_wm_name_reply(conn, cookie, &reply, NULL)) {
-                ErrorF("GetWindowName - xcb_icccm_get_wm_name_reply failed.  No name.\n");
+            if (!WMPropTextProperty(pWMInfo, iWin, WM_PROP_WM_NAME, &reply)) {
+                ErrorF("GetWindowName - no WM_NAME.  No name.\n");
                 *ppWindowName = NULL;
                 return;
             }
 
             pszWindowName = Xutf8TextPropertyToString(pWMInfo, &reply);
-            xcb_icccm_get_text_property_reply_wipe(&reply);
         }
 
     /* return the window name, unless... */
     *ppWindowName = pszWindowName;
 
     if (g_fHostInTitle) {
-        xcb_get_property_cookie_t cookie;
         xcb_icccm_get_text_property_reply_t reply;
 
         /* Try to get client machine name */
-        cookie = xcb_icccm_get_wm_client_machine(conn, iWin);
-        if (xcb_icccm_get_wm_client_machine_reply(conn, cookie, &reply, NULL)) {
+        if (WMPropTextProperty(pWMInfo, iWin, WM_PROP_WM_CLIENT_MACHINE, &reply)) {
             char *pszClientMachine;
             char *pszClientHostname;
             char *dot;
             char hostname[HOST_NAME_MAX + 1];
 
             pszClientMachine = Xutf8TextPropertyToString(pWMInfo, &reply);
-            xcb_icccm_get_text_property_reply_wipe(&reply);
 
             /* If client machine name looks like a FQDN, find the hostname */
             pszClientHostname = strdup(pszClientMachine);
@@ -489,20 +1000,15 @@ GetWindowName(WMInfoPtr pWMInfo, xcb_window_t iWin, char **ppWindowName)
 static Bool
 IsWmProtocolAvailable(WMInfoPtr pWMInfo, xcb_window_t iWindow, xcb_atom_t atmProtocol)
 {
-  int i, found = 0;
-  xcb_get_property_cookie_t cookie;
-  xcb_icccm_get_wm_protocols_reply_t reply;
-  xcb_connection_t *conn = pWMInfo->conn;
-
-  cookie = xcb_icccm_get_wm_protocols(conn, iWindow, pWMInfo->ewmh.WM_PROTOCOLS);
-  if (xcb_icccm_get_wm_protocols_reply(conn, cookie, &reply, NULL)) {
-    for (i = 0; i < reply.atoms_len; ++i)
-      if (reply.atoms[i] == atmProtocol) {
-              ++found;
-              break;
-      }
-    xcb_icccm_get_wm_protocols_reply_wipe(&reply);
-  }
+  int i, nAtoms, found = 0;
+  xcb_atom_t *pAtom;
+
+  pAtom = WMPropAtoms(pWMInfo, iWindow, WM_PROP_WM_PROTOCOLS, &nAtoms);
+  for (i = 0; i < nAtoms; ++i)
+    if (pAtom[i] == atmProtocol) {
+            ++found;
+            break;
+    }
 
   return found > 0;
 }
@@ -535,23 +1041,13 @@ SendXMessage(xcb_connection_t *conn, xcb_window_t iWin, xcb_atom_t atmType, long
 static HWND
 getHwnd(WMInfoPtr pWMInfo, xcb_window_t iWindow)
 {
-    HWND hWnd = NULL;
-    xcb_get_property_cookie_t cookie;
-    xcb_get_property_reply_t *reply;
-
-    cookie = xcb_get_property(pWMInfo->conn, FALSE, iWindow, pWMInfo->atmPrivMap,
-                              XCB_ATOM_INTEGER, 0L, sizeof(HWND)/4L);
-    reply = xcb_get_property_reply(pWMInfo->conn, cookie, NULL);
-
-    if (reply) {
-        int length = xcb_get_property_value_length(reply);
-        HWND *value = xcb_get_property_value(reply);
+    HWND hWnd;
+    WMPropCachePtr pCache = WMPropEntry(pWMInfo, iWindow);
 
-        if (value && (length == sizeof(HWND))) {
-            hWnd = *value;
-        }
-        free(reply);
-    }
+    /* Usually asked together with IsOverrideRedirect(), so fetch both */
+    if (!(pCache->uValid & WM_PROP_HWND))
+        WMPropFetch(pWMInfo, &pCache, 1, WM_PROP_HWND | WM_PROP_ATTRIBUTES);
+    hWnd = pCache->hWnd;
 
     /* Some sanity checks */
     if (!hWnd)
@@ -566,23 +1062,14 @@ getHwnd(WMInfoPtr pWMInfo, xcb_window_t iWindow)
  * Helper function to check for override-redirect
  */
 static Bool
-IsOverrideRedirect(xcb_connection_t *conn, xcb_window_t iWin)
+IsOverrideRedirect(WMInfoPtr pWMInfo, xcb_window_t iWin)
 {
-    Bool result = FALSE;
-    xcb_get_window_attributes_reply_t *reply;
-    xcb_get_window_attributes_cookie_t cookie;
+    WMPropCachePtr pCache = WMPropEntry(pWMInfo, iWin);
 
-    cookie = xcb_get_window_attributes(conn, iWin);
-    reply = xcb_get_window_attributes_reply(conn, cookie, NULL);
-    if (reply) {
-        result = (reply->override_redirect != 0);
-        free(reply);
-    }
-    else {
-        ErrorF("IsOverrideRedirect: Failed to get window attributes\n");
-    }
+    if (!(pCache->uValid & WM_PROP_ATTRIBUTES))
+        WMPropFetch(pWMInfo, &pCache, 1, WM_PROP_HWND | WM_PROP_ATTRIBUTES);
 
-    return result;
+    return pCache->fOverrideRedirect;
 }
 
 /*
@@ -592,27 +1079,23 @@ static void
 GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
               char **res_class, char **window_name)
 {
-    xcb_get_property_cookie_t cookie1;
     xcb_icccm_get_wm_class_reply_t reply1;
-    xcb_get_property_cookie_t cookie2;
     xcb_icccm_get_text_property_reply_t reply2;
 
-    cookie1 = xcb_icccm_get_wm_class(pWMInfo->conn, iWindow);
-    if (xcb_icccm_get_wm_class_reply(pWMInfo->conn, cookie1, &reply1,
-                                     NULL)) {
+    /* The reply stays owned by the cache, so it's not wiped here */
+    if (xcb_icccm_get_wm_class_from_reply(&reply1,
+                                          WMPropGet(pWMInfo, iWindow,
+                                                    WM_PROP_WM_CLASS))) {
         *res_name = strdup(reply1.instance_name);
         *res_class = strdup(reply1.class_name);
-        xcb_icccm_get_wm_class_reply_wipe(&reply1);
     }
     else {
         *res_name = strdup("");
         *res_class = strdup("");
     }
 
-    cookie2 = xcb_icccm_get_wm_name(pWMInfo->conn, iWindow);
-    if (xcb_icccm_get_wm_name_reply(pWMInfo->conn, cookie2, &reply2, NULL)) {
+    if (WMPropTextProperty(pWMInfo, iWindow, WM_PROP_WM_NAME, &reply2)) {
         *window_name = strndup(reply2.name, reply2.name_len);
-        xcb_icccm_get_text_property_reply_wipe(&reply2);
     }
     else {
         *window_name = strdup("");
@@ -621,40 +1104,128 @@ GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
 
 /*
  * Updates the name of a HWND according to its X WM_NAME property
+ *
+ * With fThrottle, a managed window whose title was set less than
+ * 1/g_iTitleRate seconds ago is only marked, and UpdatePendingNames() sets
+ * it once it is due, so a client retitling its window all the time costs
+ * g_iTitleRate SetWindowTextW() calls a second at most.
  */
 
 static void
-UpdateName(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+UpdateName(WMInfoPtr pWMInfo, xcb_window_t iWindow, Bool fThrottle)
 {
+    WMPropCachePtr pCache;
     HWND hWnd;
+    char *pszWindowName;
+    int iLen;
 
     hWnd = getHwnd(pWMInfo, iWindow);
     if (!hWnd)
         return;
 
     /* If window isn't override-redirect */
-    if (!IsOverrideRedirect(pWMInfo->conn, iWindow)) {
-        char *pszWindowName;
-
-        /* Get the X windows window name */
-        GetWindowName(pWMInfo, iWindow, &pszWindowName);
-
-        if (pszWindowName) {
-            /* Convert from UTF-8 to wide char */
-            int iLen =
-                MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1, NULL, 0);
-            wchar_t *pwszWideWindowName =
-                malloc(sizeof(wchar_t)*(iLen + 1));
-            MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1,
-                                pwszWideWindowName, iLen);
-
-            /* Set the Windows window name */
-            SetWindowTextW(hWnd, pwszWideWindowName);
-
-            free(pwszWideWindowName);
-            free(pszWindowName);
+    if (IsOverrideRedirect(pWMInfo, iWindow))
+        return;
+
+    /* Only managed windows remember the title they were given */
+    pCache = WMPropCacheFind(pWMInfo, iWindow);
+
+    if (pCache) {
+        if (fThrottle && g_iTitleRate > 0 && pCache->pszTitle &&
+            GetTickCount() - pCache->dwTitleSet < 1000 / g_iTitleRate) {
+            pCache->fTitlePending = TRUE;
+            pWMInfo->fTitlesPending = TRUE;
+            return;
         }
+        pCache->fTitlePending = FALSE;
     }
+
+    /* Get the X windows window name */
+    GetWindowName(pWMInfo, iWindow, &pszWindowName);
+    if (!pszWindowName)
+        return;
+
+    /* Skip titles which change back to what they were */
+    if (pCache && pCache->pszTitle &&
+        strcmp(pCache->pszTitle, pszWindowName) == 0) {
+        free(pszWindowName);
+        return;
+    }
+
+    /* Convert from UTF-8 to wide char, in a buffer kept for next time */
+    iLen = MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1, NULL, 0);
+    if (iLen > pWMInfo->cchTitle) {
+        wchar_t *pwszTitle =
+            realloc(pWMInfo->pwszTitle, sizeof(wchar_t) * iLen);
+
+        if (!pwszTitle)
+            iLen = 0;
+        else {
+            pWMInfo->pwszTitle = pwszTitle;
+            pWMInfo->cchTitle = iLen;
+        }
+    }
+    if (iLen <= 0) {
+        free(pszWindowName);
+        return;
+    }
+    MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1,
+                        pWMInfo->pwszTitle, iLen);
+
+    /* Set the Windows window name */
+    SetWindowTextW(hWnd, pWMInfo->pwszTitle);
+
+    if (pCache) {
+        free(pCache->pszTitle);
+        pCache->pszTitle = pszWindowName;
+        pCache->dwTitleSet = GetTickCount();
+    }
+    else
+        free(pszWindowName);
+}
+
+/*
+ * UpdatePendingNames - Set the titles UpdateName() held back which are due,
+ * and return the milliseconds until the next one is, or -1 if none is left
+ */
+
+static int
+UpdatePendingNames(WMInfoPtr pWMInfo)
+{
+    DWORD dwInterval, dwNow;
+    int iWait = -1;
+    int i;
+
+    if (!pWMInfo->fTitlesPending)
+        return -1;
+    pWMInfo->fTitlesPending = FALSE;
+
+    dwInterval = g_iTitleRate > 0 ? 1000 / g_iTitleRate : 0;
+    dwNow = GetTickCount();
+
+    for (i = 0; i < WM_PROP_CACHE_BUCKETS; i++) {
+        WMPropCachePtr pCache;
+
+        for (pCache = pWMInfo->apPropCache[i]; pCache != NULL;
+             pCache = pCache->pNext) {
+            DWORD dwElapsed;
+
+            if (!pCache->fTitlePending)
+                continue;
+
+            dwElapsed = dwNow - pCache->dwTitleSet;
+            if (dwElapsed >= dwInterval) {
+                UpdateName(pWMInfo, pCache->iWindow, FALSE);
+                continue;
+            }
+
+            if (iWait < 0 || iWait > (int) (dwInterval - dwElapsed))
+                iWait = dwInterval - dwElapsed;
+            pWMInfo->fTitlesPending = TRUE;
+        }
+    }
+
+    return iWait;
 }
 
 /*
@@ -672,7 +1243,7 @@ UpdateIcon(WMInfoPtr pWMInfo, xcb_window_t iWindow)
         return;
 
     /* If window isn't override-redirect */
-    if (!IsOverrideRedirect(pWMInfo->conn, iWindow)) {
+    if (!IsOverrideRedirect(pWMInfo, iWindow)) {
         char *window_name = 0;
         char *res_name = 0;
         char *res_class = 0;
@@ -700,7 +1271,7 @@ UpdateStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned long *maxmin, int
     UINT flags;
 
     /* If window isn't override-redirect */
-    if (IsOverrideRedirect(pWMInfo->conn, iWindow))
+    if (IsOverrideRedirect(pWMInfo, iWindow))
         return;
 
     hWnd = getHwnd(pWMInfo, iWindow);
@@ -821,61 +1392,57 @@ UpdateState(WMInfoPtr pWMInfo, xcb_window_t iWindow, int state)
         xcb_delete_property(pWMInfo->conn, iWindow, pWMInfo->ewmh._NET_WM_STATE);
     }
     else {
-        xcb_get_property_cookie_t cookie;
-        xcb_get_property_reply_t *reply;
-
-        cookie = xcb_get_property(pWMInfo->conn, FALSE, iWindow,
-                                  pWMInfo->ewmh._NET_WM_STATE,
-                                  XCB_ATOM_ATOM,
-                                  0, INT_MAX);
-        reply = xcb_get_property_reply(pWMInfo->conn, cookie, NULL);
-        if (reply) {
-            int nitems = xcb_get_property_value_length(reply)/sizeof(xcb_atom_t);
-            xcb_atom_t *pAtom = xcb_get_property_value(reply);
-            unsigned long i, o = 0;
-            xcb_atom_t *netwmstate=alloca((nitems + 2)*sizeof(xcb_atom_t));
-            Bool changed = FALSE;
-
-            // Make a copy with _NET_WM_HIDDEN, _NET_WM_MAXIMIZED_{VERT,HORZ}
-            // removed
-            for (i = 0; i < nitems; i++) {
-                if ((pAtom[i] != pWMInfo->ewmh._NET_WM_STATE_HIDDEN) &&
-                    (pAtom[i] != pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_VERT) &&
-                    (pAtom[i] != pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_HORZ))
-                    netwmstate[o++] = pAtom[i];
-            }
-            free(reply);
+        int nitems;
+        xcb_atom_t *pAtom;
+        unsigned long i, o = 0;
+        xcb_atom_t *netwmstate;
+        Bool changed = FALSE;
+
+        /* A window without _NET_WM_STATE yields an empty list */
+        pAtom = WMPropAtoms(pWMInfo, iWindow, WM_PROP_NET_WM_STATE, &nitems);
+        netwmstate = alloca((nitems + 2)*sizeof(xcb_atom_t));
+
+        // Make a copy with _NET_WM_HIDDEN, _NET_WM_MAXIMIZED_{VERT,HORZ}
+        // removed
+        for (i = 0; i < nitems; i++) {
+            if ((pAtom[i] != pWMInfo->ewmh._NET_WM_STATE_HIDDEN) &&
+                (pAtom[i] != pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_VERT) &&
+                (pAtom[i] != pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_HORZ))
+                netwmstate[o++] = pAtom[i];
+        }
 
-            // if iconized, add _NET_WM_HIDDEN
-            if (state == XCB_ICCCM_WM_STATE_ICONIC) {
-                netwmstate[o++] = pWMInfo->ewmh._NET_WM_STATE_HIDDEN;
-            }
+        // if iconized, add _NET_WM_HIDDEN
+        if (state == XCB_ICCCM_WM_STATE_ICONIC) {
+            netwmstate[o++] = pWMInfo->ewmh._NET_WM_STATE_HIDDEN;
+        }
 
-            // if maximized, add  _NET_WM_MAXIMIZED_{VERT,HORZ}
-            if (state == XCB_ICCCM_WM_STATE_ZOOM) {
-                netwmstate[o++] = pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_VERT;
-                netwmstate[o++] = pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_HORZ;
-            }
+        // if maximized, add  _NET_WM_MAXIMIZED_{VERT,HORZ}
+        if (state == XCB_ICCCM_WM_STATE_ZOOM) {
+            netwmstate[o++] = pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_VERT;
+            netwmstate[o++] = pWMInfo->ewmh._NET_WM_STATE_MAXIMIZED_HORZ;
+        }
 
-            // Don't change property unnecessarily
-            if (nitems != o)
-                changed = TRUE;
-            else
-                for (i = 0; i < nitems; i++)
-                    {
-                        if (pAtom[i] != netwmstate[i])
-                            {
-                                changed = TRUE;
-                                break;
-                            }
-                    }
+        // Don't change property unnecessarily
+        if (nitems != o)
+            changed = TRUE;
+        else
+            for (i = 0; i < nitems; i++)
+                {
+                    if (pAtom[i] != netwmstate[i])
+                        {
+                            changed = TRUE;
+                            break;
+                        }
+                }
 
-            if (changed)
-                xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
-                                    iWindow,
-                                    pWMInfo->ewmh._NET_WM_STATE,
-                                    XCB_ATOM_ATOM, 32,
-                                    o, (unsigned char *) &netwmstate);
+        if (changed) {
+            xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
+                                iWindow,
+                                pWMInfo->ewmh._NET_WM_STATE,
+                                XCB_ATOM_ATOM, 32,
+                                o, (unsigned char *) netwmstate);
+            WMPropCacheInvalidate(pWMInfo, iWindow,
+                                  WM_PROP_MASK(WM_PROP_NET_WM_STATE));
         }
     }
 }
@@ -941,10 +1508,18 @@ winMultiWindowWMProc(void *pArg)
     /* Loop until we explicitly break out */
     for (;;) {
         WMMsgNodePtr pNode;
+        int iTimeout;
+
+        /* Set the titles which were held back and are due now */
+        iTimeout = UpdatePendingNames(pWMInfo);
 
         /* Pop a message off of our queue */
-        pNode = PopMessage(&pWMInfo->wmMsgQueue, pWMInfo);
+        pNode = PopMessage(&pWMInfo->wmMsgQueue, pWMInfo, iTimeout);
         if (pNode == NULL) {
+            /* Woken up for the next title held back */
+            if (iTimeout >= 0)
+                continue;
+
             /* Bail if PopMessage returns without a message */
             /* NOTE: Remember that PopMessage is a blocking function. */
             ErrorF("winMultiWindowWMProc - Queue is Empty?  Exiting.\n");
@@ -954,6 +1529,8 @@ winMultiWindowWMProc(void *pArg)
         winDebug("winMultiWindowWMProc - MSG: %s (%d) ID: %d\n",
                MessageName(&(pNode->msg)), (int)pNode->msg.msg, (int)pNode->msg.dwID);
 
+        FRAME_TRACE_BEGIN("WindowManager");
+
         /* Branch on the message type */
         switch (pNode->msg.msg) {
         case WM_WM_RAISE:
@@ -981,6 +1558,7 @@ winMultiWindowWMProc(void *pArg)
                                 pNode->msg.iWindow, pWMInfo->atmPrivMap,
                                 XCB_ATOM_INTEGER, 32,
                                 sizeof(HWND)/4, &(pNode->msg.hwndWindow));
+            WMPropSetHwnd(pWMInfo, pNode->msg.iWindow, pNode->msg.hwndWindow);
 
             break;
 
@@ -988,13 +1566,17 @@ winMultiWindowWMProc(void *pArg)
           {
             unsigned long maxmin = 0;
 
+            /* Fetch the properties of this and any other windows being mapped */
+            WMPropPrefetchMapped(pWMInfo, pNode->msg.iWindow);
+
             /* Put a note as to the HWND associated with this Window */
             xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
                                 pNode->msg.iWindow, pWMInfo->atmPrivMap,
                                 XCB_ATOM_INTEGER, 32,
                                 sizeof(HWND)/4, &(pNode->msg.hwndWindow));
+            WMPropSetHwnd(pWMInfo, pNode->msg.iWindow, pNode->msg.hwndWindow);
 
-            UpdateName(pWMInfo, pNode->msg.iWindow);
+            UpdateName(pWMInfo, pNode->msg.iWindow, FALSE);
             UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 1);
 
             /* Reshape */
@@ -1056,12 +1638,12 @@ winMultiWindowWMProc(void *pArg)
             */
             {
               Bool neverFocus = FALSE;
-              xcb_get_property_cookie_t cookie;
               xcb_icccm_wm_hints_t hints;
 
-              cookie = xcb_icccm_get_wm_hints(pWMInfo->conn, pNode->msg.iWindow);
-              if (xcb_icccm_get_wm_hints_reply(pWMInfo->conn, cookie, &hints,
-                                               NULL)) {
+              if (xcb_icccm_get_wm_hints_from_reply(&hints,
+                                                    WMPropGet(pWMInfo,
+                                                              pNode->msg.iWindow,
+                                                              WM_PROP_WM_HINTS))) {
                 if (hints.flags & XCB_ICCCM_WM_HINT_INPUT)
                   neverFocus = !hints.input;
               }
@@ -1081,10 +1663,14 @@ winMultiWindowWMProc(void *pArg)
             break;
 
         case WM_WM_NAME_EVENT:
-            UpdateName(pWMInfo, pNode->msg.iWindow);
+            WMPropCacheInvalidate(pWMInfo, pNode->msg.iWindow,
+                                  WMPropAtomMask(pWMInfo, pNode->msg.dwID,
+                                                 WM_PROP_NAMES));
+            UpdateName(pWMInfo, pNode->msg.iWindow, TRUE);
             break;
 
         case WM_WM_ICON_EVENT:
+            /* WM_HINTS changes also arrive as WM_WM_HINTS_EVENT */
             UpdateIcon(pWMInfo, pNode->msg.iWindow);
             break;
 
@@ -1092,12 +1678,25 @@ winMultiWindowWMProc(void *pArg)
             {
             unsigned long maxmin = 0;
 
+            WMPropCacheInvalidate(pWMInfo, pNode->msg.iWindow,
+                                  WMPropAtomMask(pWMInfo, pNode->msg.dwID,
+                                                 WM_PROP_HINTS));
             UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 0);
             }
             break;
 
+        case WM_WM_PROPERTY_EVENT:
+            WMPropCacheInvalidate(pWMInfo, pNode->msg.iWindow,
+                                  WMPropAtomMask(pWMInfo, pNode->msg.dwID,
+                                                 WM_PROP_PROPERTIES));
+            break;
+
         case WM_WM_CHANGE_STATE:
             UpdateState(pWMInfo, pNode->msg.iWindow, pNode->msg.dwID);
+
+            /* No longer managed, so nothing will keep its cache entry fresh */
+            if (pNode->msg.dwID == XCB_ICCCM_WM_STATE_WITHDRAWN)
+                WMPropCacheRemove(pWMInfo, pNode->msg.iWindow);
             break;
 
         default:
@@ -1106,6 +1705,10 @@ winMultiWindowWMProc(void *pArg)
             break;
         }
 
+        /* Properties of unmanaged windows are only kept for one message */
+        WMPropCacheReset(&pWMInfo->propScratch);
+        pWMInfo->propScratch.iWindow = XCB_NONE;
+
         /* Flush any pending events on our display */
         xcb_flush(pWMInfo->conn);
 
@@ -1132,6 +1735,8 @@ winMultiWindowWMProc(void *pArg)
         /* Free the retrieved message */
         free(pNode);
 
+        FRAME_TRACE_END("WindowManager");
+
         /* I/O errors etc. */
         {
             int e = xcb_connection_has_error(pWMInfo->conn);
@@ -1148,6 +1753,11 @@ winMultiWindowWMProc(void *pArg)
     /* Free the mutex variable */
     pthread_mutex_destroy(&pWMInfo->wmMsgQueue.pmMutex);
 
+    WMPropCacheFree(pWMInfo);
+    free(pWMInfo->pwszTitle);
+    pWMInfo->pwszTitle = NULL;
+    pWMInfo->cchTitle = 0;
+
     xcb_disconnect(pWMInfo->conn);
     xcb_errors_context_free(pWMInfo->err_ctx);
     pWMInfo->conn=NULL;
@@ -1197,6 +1807,7 @@ winMultiWindowXMsgProc(void *pArg)
     xcb_atom_t atmWmChange;
     xcb_atom_t atmNetWmIcon;
     xcb_atom_t atmWindowState, atmMotifWmHints, atmWindowType, atmNormalHints;
+    xcb_atom_t atmWmProtocols;
     int iReturn;
     xcb_auth_info_t *auth_info;
     xcb_screen_t *root_screen;
@@ -1307,6 +1918,7 @@ winMultiWindowXMsgProc(void *pArg)
     atmMotifWmHints = intern_atom(pProcArg->conn, "_MOTIF_WM_HINTS");
     atmWindowType = intern_atom(pProcArg->conn, "_NET_WM_WINDOW_TYPE");
     atmNormalHints = intern_atom(pProcArg->conn, "WM_NORMAL_HINTS");
+    atmWmProtocols = intern_atom(pProcArg->conn, "WM_PROTOCOLS");
 
     /*
       Enable Composite extension and redirect subwindows of the root window
@@ -1388,7 +2000,7 @@ winMultiWindowXMsgProc(void *pArg)
                                           XCB_CW_EVENT_MASK, mask_value);
 
             /* If it's not override-redirect, set the border-width to 0 */
-            if (!IsOverrideRedirect(pProcArg->conn, notify->window)) {
+            if (!notify->override_redirect) {
                 const static uint32_t width_value[] = { 0 };
                 xcb_configure_window(pProcArg->conn, notify->window,
                                      XCB_CONFIG_WINDOW_BORDER_WIDTH, width_value);
@@ -1483,14 +2095,19 @@ winMultiWindowXMsgProc(void *pArg)
         else if (type ==  XCB_PROPERTY_NOTIFY) {
             xcb_property_notify_event_t *notify = (xcb_property_notify_event_t *)event;
 
-            xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(pProcArg->conn, notify->atom);
-            xcb_get_atom_name_reply_t *reply = xcb_get_atom_name_reply(pProcArg->conn, cookie, NULL);
-            if (reply) {
-                winDebug("winMultiWindowXMsgProc: PropertyNotify %.*s\n",
-                         xcb_get_atom_name_name_length(reply),
-                         xcb_get_atom_name_name(reply));
-                free(reply);
+#ifdef WINDBG
+            /* A round-trip per PropertyNotify, so only when debugging */
+            {
+                xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(pProcArg->conn, notify->atom);
+                xcb_get_atom_name_reply_t *reply = xcb_get_atom_name_reply(pProcArg->conn, cookie, NULL);
+                if (reply) {
+                    winDebug("winMultiWindowXMsgProc: PropertyNotify %.*s\n",
+                             xcb_get_atom_name_name_length(reply),
+                             xcb_get_atom_name_name(reply));
+                    free(reply);
+                }
             }
+#endif
 
             if ((notify->atom == atmWmName) ||
                 (notify->atom == atmNetWmName)) {
@@ -1498,6 +2115,7 @@ winMultiWindowXMsgProc(void *pArg)
 
                 msg.msg = WM_WM_NAME_EVENT;
                 msg.iWindow = notify->window;
+                msg.dwID = notify->atom;
 
                 /* Other fields ignored */
                 winSendMessageToWM(pProcArg->pWMInfo, &msg);
@@ -1515,6 +2133,7 @@ winMultiWindowXMsgProc(void *pArg)
                     memset(&msg, 0, sizeof(msg));
                     msg.msg = WM_WM_HINTS_EVENT;
                     msg.iWindow = notify->window;
+                    msg.dwID = notify->atom;
 
                     /* Other fields ignored */
                     winSendMessageToWM(pProcArg->pWMInfo, &msg);
@@ -1530,6 +2149,19 @@ winMultiWindowXMsgProc(void *pArg)
                     /* Other fields ignored */
                     winSendMessageToWM(pProcArg->pWMInfo, &msg);
                 }
+
+                /* Other properties the WM thread caches */
+                if ((notify->atom == XCB_ATOM_WM_CLASS) ||
+                    (notify->atom == XCB_ATOM_WM_CLIENT_MACHINE) ||
+                    (notify->atom == atmWmProtocols)) {
+                    memset(&msg, 0, sizeof(msg));
+                    msg.msg = WM_WM_PROPERTY_EVENT;
+                    msg.iWindow = notify->window;
+                    msg.dwID = notify->atom;
+
+                    /* Other fields ignored */
+                    winSendMessageToWM(pProcArg->pWMInfo, &msg);
+                }
             }
         }
         else if (type == XCB_CLIENT_MESSAGE) {
@@ -1758,6 +2390,7 @@ winInitMultiWindowWM(WMInfoPtr pWMInfo, WMProcArgPtr pProcArg)
     pWMInfo->atmNumberDesktops = intern_atom(pWMInfo->conn, "_NET_NUMBER_OF_DESKTOPS");
     pWMInfo->atmDesktopNames = intern_atom(pWMInfo->conn, "__NET_DESKTOP_NAMES");
     pWMInfo->atmWmState = intern_atom(pWMInfo->conn, "WM_STATE");
+    pWMInfo->atmMotifWmHints = intern_atom(pWMInfo->conn, "_MOTIF_WM_HINTS");
 
     /* Initialization for the xcb_ewmh and EWMH atoms */
     {
@@ -1794,6 +2427,8 @@ winInitMultiWindowWM(WMInfoPtr pWMInfo, WMProcArgPtr pProcArg)
         }
     }
 
+    WMPropCacheInit(pWMInfo);
+
     /* Get root window id */
     root_screen = xcb_aux_get_screen(pWMInfo->conn, pProcArg->dwScreen);
     root_window_id = root_screen->root;
@@ -1954,7 +2589,6 @@ static void
 winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle, unsigned long *maxmin)
 {
     xcb_connection_t *conn = pWMInfo->conn;
-    static xcb_atom_t windowState, motif_wm_hints;
     static xcb_atom_t hiddenState, fullscreenState, belowState, aboveState,
         skiptaskbarState;
     static xcb_atom_t splashType;
@@ -1975,8 +2609,6 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
 
     if (generation != serverGeneration) {
         generation = serverGeneration;
-        windowState = intern_atom(conn, "_NET_WM_STATE");
-        motif_wm_hints = intern_atom(conn, "_MOTIF_WM_HINTS");
         hiddenState = intern_atom(conn, "_NET_WM_STATE_HIDDEN");
         fullscreenState = intern_atom(conn, "_NET_WM_STATE_FULLSCREEN");
         belowState = intern_atom(conn, "_NET_WM_STATE_BELOW");
@@ -1986,12 +2618,10 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
     }
 
     {
-      xcb_get_property_cookie_t cookie_wm_state = xcb_get_property(conn, FALSE, iWindow, windowState, XCB_ATOM_ATOM, 0L, INT_MAX);
-      xcb_get_property_reply_t *reply = xcb_get_property_reply(conn, cookie_wm_state, NULL);
-      if (reply) {
+      int nitems;
+      xcb_atom_t *pAtom = WMPropAtoms(pWMInfo, iWindow, WM_PROP_NET_WM_STATE, &nitems);
+      if (pAtom) {
         int i;
-        int nitems = xcb_get_property_value_length(reply)/sizeof(xcb_atom_t);
-        xcb_atom_t *pAtom = xcb_get_property_value(reply);
         Bool verMax = FALSE;
         Bool horMax = FALSE;
 
@@ -2014,14 +2644,11 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
 
             if (verMax && horMax)
               *maxmin |= HINT_MAX;
-
-            free(reply);
       }
     }
 
     {
-      xcb_get_property_cookie_t cookie_mwm_hint = xcb_get_property(conn, FALSE, iWindow, motif_wm_hints, motif_wm_hints, 0L, sizeof(MwmHints));
-      xcb_get_property_reply_t *reply =  xcb_get_property_reply(conn, cookie_mwm_hint, NULL);
+      xcb_get_property_reply_t *reply = WMPropGet(pWMInfo, iWindow, WM_PROP_MOTIF_WM_HINTS);
       if (reply) {
         int nitems = xcb_get_property_value_length(reply)/4;
         MwmHints *mwm_hint = xcb_get_property_value(reply);
@@ -2083,37 +2710,34 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
                  */
             }
         }
-        free(reply);
       }
     }
 
     {
-      int i;
-      xcb_ewmh_get_atoms_reply_t type;
-      xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_window_type(&pWMInfo->ewmh, iWindow);
-      if (xcb_ewmh_get_wm_window_type_reply(&pWMInfo->ewmh, cookie, &type, NULL)) {
-        for (i = 0; i < type.atoms_len; i++) {
-            if (type.atoms[i] ==  pWMInfo->ewmh._NET_WM_WINDOW_TYPE_DOCK) {
-                hint &= ~(HINT_BORDER | HINT_SIZEBOX | HINT_CAPTION | HINT_NOFRAME);
-                hint |= (HINT_SKIPTASKBAR | HINT_SIZEBOX);
-                *zstyle = HWND_TOPMOST;
-            }
-            else if ((type.atoms[i] == pWMInfo->ewmh._NET_WM_WINDOW_TYPE_SPLASH)
-                     || (type.atoms[i] == splashType)) {
-                hint &= ~(HINT_BORDER | HINT_SIZEBOX | HINT_CAPTION);
-                hint |= (HINT_SKIPTASKBAR | HINT_NOSYSMENU | HINT_NOMINIMIZE | HINT_NOMAXIMIZE);
-                *zstyle = HWND_TOPMOST;
-            }
-        }
+      int i, nAtoms;
+      xcb_atom_t *pType = WMPropAtoms(pWMInfo, iWindow, WM_PROP_NET_WM_WINDOW_TYPE, &nAtoms);
+
+      for (i = 0; i < nAtoms; i++) {
+          if (pType[i] ==  pWMInfo->ewmh._NET_WM_WINDOW_TYPE_DOCK) {
+              hint &= ~(HINT_BORDER | HINT_SIZEBOX | HINT_CAPTION | HINT_NOFRAME);
+              hint |= (HINT_SKIPTASKBAR | HINT_SIZEBOX);
+              *zstyle = HWND_TOPMOST;
+          }
+          else if ((pType[i] == pWMInfo->ewmh._NET_WM_WINDOW_TYPE_SPLASH)
+                   || (pType[i] == splashType)) {
+              hint &= ~(HINT_BORDER | HINT_SIZEBOX | HINT_CAPTION);
+              hint |= (HINT_SKIPTASKBAR | HINT_NOSYSMENU | HINT_NOMINIMIZE | HINT_NOMAXIMIZE);
+              *zstyle = HWND_TOPMOST;
+          }
       }
     }
 
     {
         xcb_size_hints_t size_hints;
-        xcb_get_property_cookie_t cookie;
 
-        cookie = xcb_icccm_get_wm_normal_hints(conn, iWindow);
-        if (xcb_icccm_get_wm_normal_hints_reply(conn, cookie, &size_hints, NULL)) {
+        if (xcb_icccm_get_wm_size_hints_from_reply(&size_hints,
+                                                   WMPropGet(pWMInfo, iWindow,
+                                                             WM_PROP_WM_NORMAL_HINTS))) {
             /* Notwithstanding MwmDecorHandle, if we have a border, and
                WM_NORMAL_HINTS indicates the window should be resizeable, let
                the window have a resizing border.  This is necessary for windows
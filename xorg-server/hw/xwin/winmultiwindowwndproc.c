@@ -45,6 +45,7 @@
 #include "winprefs.h"
 #include "winmsg.h"
 #include "inputstr.h"
+#include "dixstruct.h"
 
 extern void winUpdateWindowPosition(HWND hWnd, HWND * zstyle);
 
@@ -336,6 +337,37 @@ winStartMousePolling(winPrivScreenPtr s_pScreenPriv)
 void DispatchQueuedEvents(Bool);
 #define UPDATETIMER 1234
 
+/* Longest a drag waits for the client to repaint before sizing it again */
+#define WIN_DRAG_SIZE_MAX_WAIT 100
+
+/*
+ * Resize the X window to follow a drag, unless its client is still busy
+ * with the previous size: it has neither sent requests since nor caught up
+ * with them, and has not been given long.  Each step of a drag would
+ * otherwise configure the window, and have the client repaint it, again.
+ */
+
+static void
+winDragSizeXWindow(WindowPtr pWin, HWND hwnd, Bool fForce)
+{
+    winWindowPriv(pWin);
+    ClientPtr pClient = wClient(pWin);
+
+    if (!fForce && pWinPriv->dwDragSized != 0 &&
+        GetTickCount() - pWinPriv->dwDragSized < WIN_DRAG_SIZE_MAX_WAIT &&
+        (pClient->sequence == pWinPriv->usDragSequence ||
+         client_is_ready(pClient))) {
+        pWinPriv->fDragSizePending = TRUE;
+        return;
+    }
+
+    pWinPriv->fDragSizePending = FALSE;
+    pWinPriv->fDragMovePending = FALSE;
+    winAdjustXWindow(pWin, hwnd);
+    pWinPriv->dwDragSized = GetTickCount();
+    pWinPriv->usDragSequence = pClient->sequence;
+}
+
 static
 void
 winAdjustXWindowState(winPrivScreenPtr s_pScreenPriv, winWMMessageRec *wmMsg)
@@ -764,6 +796,11 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
          */
         return 0;
 
+    case WM_INPUTLANGCHANGE:
+        /* Key messages without a scan code now map to other ones */
+        winKeybdLayoutChanged();
+        break;
+
     case WM_SYSKEYDOWN:
     case WM_KEYDOWN:
 
@@ -896,10 +933,18 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         break;
 
     case WM_MOVE:
+        /*
+         * While the user drags the window, DWM shows it moving and the X
+         * window follows once it is dropped, instead of being moved, and
+         * the windows under it exposed, at every step
+         */
+        if (pWin && GetWindowLongPtr(hwnd, WND_IDX_ENTEREDSIZEMOVE)) {
+            winGetWindowPriv(pWin)->fDragMovePending = TRUE;
+            return 0;
+        }
+
         /* Adjust the X Window to the moved Windows window */
         winAdjustXWindow(pWin, hwnd);
-        if (GetWindowLongPtr(hwnd, WND_IDX_ENTEREDSIZEMOVE))
-          DispatchQueuedEvents(0);
         return 0;
 
     case WM_SHOWWINDOW:
@@ -1028,15 +1073,30 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_ENTERSIZEMOVE:
         SetWindowLongPtr(hwnd, WND_IDX_ENTEREDSIZEMOVE, TRUE);
         SetTimer(hwnd, UPDATETIMER, 10, NULL);
+        if (pWin)
+            winGetWindowPriv(pWin)->dwDragSized = 0;
         return 0;
 
     case WM_TIMER:
+        if (wParam == WIN_THUMBNAIL_TIMER_ID) {
+            if (pWin)
+                winThumbnailTimer(pWin);
+            return 0;
+        }
+
+        /* Give the client the size it was kept waiting for, if it is ready */
+        if (pWin && winGetWindowPriv(pWin)->fDragSizePending)
+            winDragSizeXWindow(pWin, hwnd, FALSE);
         DispatchQueuedEvents(0);
         return 0;
 
     case WM_EXITSIZEMOVE:
         /* Adjust the X Window to the moved Windows window */
         SetWindowLongPtr(hwnd, WND_IDX_ENTEREDSIZEMOVE, FALSE);
+        if (pWin) {
+            winGetWindowPriv(pWin)->fDragMovePending = FALSE;
+            winGetWindowPriv(pWin)->fDragSizePending = FALSE;
+        }
         winAdjustXWindow(pWin, hwnd);
         KillTimer(hwnd, UPDATETIMER);
         if (pWin)
@@ -1066,14 +1126,21 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
                (int) LOWORD(lParam), (int) HIWORD(lParam), buf);
     }
 #endif
+        /* While dragging, at the pace the client manages to repaint */
+        if (pWin && GetWindowLongPtr(hwnd, WND_IDX_ENTEREDSIZEMOVE)) {
+            winDragSizeXWindow(pWin, hwnd, FALSE);
+            DispatchQueuedEvents(0);
+            return 0;
+        }
+
         /* Adjust the X Window to the moved Windows window */
         winAdjustXWindow (pWin, hwnd);
         if (pWin)
             winAdjustXWindowState(s_pScreenPriv, &wmMsg);
         if (wParam == SIZE_MINIMIZED)
             winReorderWindowsMultiWindow();
-        if (GetWindowLongPtr(hwnd, WND_IDX_ENTEREDSIZEMOVE))
-            DispatchQueuedEvents(0);
+        if (pWin)
+            winThumbnailIconic(pWin, wParam == SIZE_MINIMIZED);
     /* else: wait for WM_EXITSIZEMOVE */
     return 0; /* end of WM_SIZE handler */
 
@@ -1102,6 +1169,17 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         }
         break;
 
+    case WM_DWMSENDICONICTHUMBNAIL:
+        /* The maximum size is packed the other way round from WM_SIZE */
+        if (pWin && winThumbnailSend(pWin, HIWORD(lParam), LOWORD(lParam)))
+            return 0;
+        break;
+
+    case WM_DWMSENDICONICLIVEPREVIEWBITMAP:
+        if (pWin && winThumbnailSendLivePreview(pWin))
+            return 0;
+        break;
+
     case WM_SETCURSOR:
         if (LOWORD(lParam) == HTCLIENT) {
             if (!g_fSoftwareCursor)
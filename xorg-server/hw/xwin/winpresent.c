@@ -0,0 +1,605 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Vblank source for the Present extension
+ *
+ * Without a CRTC to ask, Present counts MSC against a made up 60Hz
+ * timer, which drifts away from the real refresh of the monitor.  Here
+ * a helper thread per screen blocks in D3DKMTWaitForVerticalBlankEvent
+ * for the monitor showing the screen and records the time and count of
+ * every vblank.  Present sees the screen's RandR CRTC, and vblank
+ * events it queues are delivered from the block handler once the
+ * counted MSC reaches them.  While nobody waits on a vblank for a
+ * couple of seconds the thread goes to sleep, and the count is carried
+ * forward at the nominal refresh rate when it wakes up again.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "winmonitors.h"
+
+#if defined(PRESENT) && defined(RANDR)
+
+#include "present.h"
+#include "list.h"
+
+/* Vblanks without a waiter before the thread goes to sleep */
+#define WIN_PRESENT_IDLE_FRAMES		120
+
+/* Vblanks counted from the clock before reopening a lost adapter */
+#define WIN_PRESENT_RETRY_FRAMES	60
+
+/* Refresh rate assumed when the display driver reports its default */
+#define WIN_PRESENT_DEFAULT_RATE	60
+
+/* The D3DKMT thunks, as gdi32.dll exports them */
+typedef UINT winD3DKMTHandle;
+
+typedef struct {
+    HDC hDc;
+    winD3DKMTHandle hAdapter;
+    LUID AdapterLuid;
+    UINT VidPnSourceId;
+} winD3DKMTOpenAdapterFromHdcRec;
+
+typedef struct {
+    winD3DKMTHandle hAdapter;
+    winD3DKMTHandle hDevice;
+    UINT VidPnSourceId;
+} winD3DKMTWaitForVerticalBlankEventRec;
+
+typedef struct {
+    winD3DKMTHandle hAdapter;
+} winD3DKMTCloseAdapterRec;
+
+typedef LONG (APIENTRY *winD3DKMTOpenAdapterFromHdcProc)
+    (winD3DKMTOpenAdapterFromHdcRec *);
+typedef LONG (APIENTRY *winD3DKMTWaitForVerticalBlankEventProc)
+    (const winD3DKMTWaitForVerticalBlankEventRec *);
+typedef LONG (APIENTRY *winD3DKMTCloseAdapterProc)
+    (const winD3DKMTCloseAdapterRec *);
+
+static winD3DKMTOpenAdapterFromHdcProc s_pfnOpenAdapterFromHdc;
+static winD3DKMTWaitForVerticalBlankEventProc s_pfnWaitForVerticalBlankEvent;
+static winD3DKMTCloseAdapterProc s_pfnCloseAdapter;
+
+static LARGE_INTEGER s_liPresentFrequency;
+
+typedef struct _winPresentVblank {
+    struct xorg_list list;
+    uint64_t event_id;
+    uint64_t msc;
+} winPresentVblankRec, *winPresentVblankPtr;
+
+typedef struct _winPresentScreen {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    /* Protected by mutex */
+    uint64_t ust;               /* time of the last vblank counted */
+    uint64_t msc;               /* and its count */
+    uint64_t interval;          /* nominal refresh period, us */
+    char szDevice[CCHDEVICENAME];
+    unsigned int uiGeneration;  /* bumped when szDevice changes */
+    int nWaiting;
+    Bool fIdle;
+    Bool fQuit;
+
+    /* Server thread only */
+    struct xorg_list queue;
+    uint64_t lastMsc;
+} winPresentScreenRec, *winPresentScreenPtr;
+
+/*
+ * Present UST, in microseconds of the performance counter
+ */
+
+static uint64_t
+winPresentUst(void)
+{
+    LARGE_INTEGER liNow;
+    uint64_t q, f;
+
+    QueryPerformanceCounter(&liNow);
+    q = liNow.QuadPart;
+    f = s_liPresentFrequency.QuadPart;
+
+    /* Split so the multiplication cannot overflow */
+    return (q / f) * 1000000 + (q % f) * 1000000 / f;
+}
+
+/*
+ * Nominal refresh period of a display device, in microseconds
+ */
+
+static uint64_t
+winPresentDeviceInterval(const char *pszDevice)
+{
+    DEVMODE dm;
+    DWORD dwRate = WIN_PRESENT_DEFAULT_RATE;
+
+    memset(&dm, 0, sizeof(dm));
+    dm.dmSize = sizeof(dm);
+
+    /* 0 and 1 both mean the hardware default rate */
+    if (EnumDisplaySettings(pszDevice, ENUM_CURRENT_SETTINGS, &dm) &&
+        dm.dmDisplayFrequency > 1)
+        dwRate = dm.dmDisplayFrequency;
+
+    return 1000000 / dwRate;
+}
+
+/*
+ * Count a vblank seen at 'now', along with any the thread slept through.
+ * Called with the mutex held.
+ */
+
+static void
+winPresentAdvance(winPresentScreenPtr pPresent, uint64_t now)
+{
+    uint64_t frames = 1;
+
+    if (now > pPresent->ust)
+        frames = (now - pPresent->ust + pPresent->interval / 2) /
+            pPresent->interval;
+    if (frames < 1)
+        frames = 1;
+
+    pPresent->msc += frames;
+    pPresent->ust = now;
+}
+
+static Bool
+winPresentOpenAdapter(const char *pszDevice,
+                      winD3DKMTOpenAdapterFromHdcRec *pOpen)
+{
+    HDC hdc = CreateDC(NULL, pszDevice, NULL, NULL);
+    LONG lStatus;
+
+    if (hdc == NULL)
+        return FALSE;
+
+    memset(pOpen, 0, sizeof(*pOpen));
+    pOpen->hDc = hdc;
+    lStatus = (*s_pfnOpenAdapterFromHdc) (pOpen);
+    DeleteDC(hdc);
+
+    return lStatus == 0;
+}
+
+static void
+winPresentCloseAdapter(winD3DKMTOpenAdapterFromHdcRec *pOpen)
+{
+    winD3DKMTCloseAdapterRec close;
+
+    close.hAdapter = pOpen->hAdapter;
+    (*s_pfnCloseAdapter) (&close);
+}
+
+/*
+ * winPresentVblankThread - Count the vblanks of the screen's monitor
+ *
+ * When the adapter cannot be opened or stops delivering vblanks, as it
+ * does while the monitor is off, the count goes on at the nominal rate.
+ * On shutdown the thread frees the screen record itself, so the server
+ * never has to wait for a vblank that may not come.
+ */
+
+static void *
+winPresentVblankThread(void *arg)
+{
+    winPresentScreenPtr pPresent = arg;
+    winD3DKMTOpenAdapterFromHdcRec open;
+    unsigned int uiOpened = pPresent->uiGeneration - 1;
+    Bool fOpen = FALSE;
+    int iIdleFrames = 0;
+    int iRetryFrames = 0;
+
+    pthread_mutex_lock(&pPresent->mutex);
+    while (!pPresent->fQuit) {
+        char szDevice[CCHDEVICENAME];
+        DWORD dwSleep;
+        LONG lStatus = -1;
+
+        /* Nobody has been waiting for a while, sleep until someone is */
+        if (pPresent->nWaiting == 0) {
+            if (++iIdleFrames > WIN_PRESENT_IDLE_FRAMES) {
+                pPresent->fIdle = TRUE;
+                pthread_cond_wait(&pPresent->cond, &pPresent->mutex);
+                pPresent->fIdle = FALSE;
+                iIdleFrames = 0;
+                continue;
+            }
+        }
+        else
+            iIdleFrames = 0;
+
+        /* Follow the screen to another monitor, or retry a lost one */
+        if (uiOpened != pPresent->uiGeneration ||
+            (!fOpen && ++iRetryFrames > WIN_PRESENT_RETRY_FRAMES)) {
+            uiOpened = pPresent->uiGeneration;
+            iRetryFrames = 0;
+            strcpy(szDevice, pPresent->szDevice);
+            pthread_mutex_unlock(&pPresent->mutex);
+
+            if (fOpen)
+                winPresentCloseAdapter(&open);
+            fOpen = winPresentOpenAdapter(szDevice, &open);
+
+            pthread_mutex_lock(&pPresent->mutex);
+            pPresent->interval = winPresentDeviceInterval(szDevice);
+        }
+        dwSleep = (DWORD) (pPresent->interval / 1000);
+        pthread_mutex_unlock(&pPresent->mutex);
+
+        if (fOpen) {
+            winD3DKMTWaitForVerticalBlankEventRec wait;
+
+            wait.hAdapter = open.hAdapter;
+            wait.hDevice = 0;
+            wait.VidPnSourceId = open.VidPnSourceId;
+            lStatus = (*s_pfnWaitForVerticalBlankEvent) (&wait);
+            if (lStatus != 0) {
+                winPresentCloseAdapter(&open);
+                fOpen = FALSE;
+            }
+        }
+        if (lStatus != 0)
+            Sleep(dwSleep);
+
+        pthread_mutex_lock(&pPresent->mutex);
+        winPresentAdvance(pPresent, winPresentUst());
+    }
+    pthread_mutex_unlock(&pPresent->mutex);
+
+    if (fOpen)
+        winPresentCloseAdapter(&open);
+
+    pthread_cond_destroy(&pPresent->cond);
+    pthread_mutex_destroy(&pPresent->mutex);
+    free(pPresent);
+    return NULL;
+}
+
+static winPresentScreenPtr
+winPresentScreen(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    return pScreenPriv->pPresent;
+}
+
+static RRCrtcPtr
+winPresentGetCrtc(WindowPtr pWin)
+{
+    rrScrPrivPtr pRRScrPriv = rrGetScrPriv(pWin->drawable.pScreen);
+
+    if (pRRScrPriv == NULL || pRRScrPriv->numCrtcs == 0)
+        return NULL;
+    return pRRScrPriv->crtcs[0];
+}
+
+/*
+ * Most recent vblank, extrapolated at the nominal rate past the last
+ * one the thread counted, and never going back on an MSC already handed
+ * out
+ */
+
+static int
+winPresentGetUstMsc(RRCrtcPtr crtc, uint64_t *ust, uint64_t *msc)
+{
+    winPresentScreenPtr pPresent = winPresentScreen(crtc->pScreen);
+    uint64_t now = winPresentUst();
+    uint64_t frames = 0;
+
+    pthread_mutex_lock(&pPresent->mutex);
+    if (now > pPresent->ust)
+        frames = (now - pPresent->ust) / pPresent->interval;
+    *msc = pPresent->msc + frames;
+    *ust = pPresent->ust + frames * pPresent->interval;
+    pthread_mutex_unlock(&pPresent->mutex);
+
+    if (*msc < pPresent->lastMsc)
+        *msc = pPresent->lastMsc;
+    pPresent->lastMsc = *msc;
+    return Success;
+}
+
+static int
+winPresentQueueVblank(RRCrtcPtr crtc, uint64_t event_id, uint64_t msc)
+{
+    winPresentScreenPtr pPresent = winPresentScreen(crtc->pScreen);
+    winPresentVblankPtr pVblank;
+    uint64_t ust, now_msc;
+
+    winPresentGetUstMsc(crtc, &ust, &now_msc);
+    if (msc <= now_msc) {
+        present_event_notify(event_id, ust, now_msc);
+        return Success;
+    }
+
+    pVblank = malloc(sizeof(winPresentVblankRec));
+    if (!pVblank)
+        return BadAlloc;
+
+    pVblank->event_id = event_id;
+    pVblank->msc = msc;
+    xorg_list_add(&pVblank->list, &pPresent->queue);
+
+    pthread_mutex_lock(&pPresent->mutex);
+    pPresent->nWaiting++;
+    if (pPresent->fIdle)
+        pthread_cond_signal(&pPresent->cond);
+    pthread_mutex_unlock(&pPresent->mutex);
+
+    return Success;
+}
+
+static void
+winPresentRemoveVblank(winPresentScreenPtr pPresent,
+                       winPresentVblankPtr pVblank)
+{
+    xorg_list_del(&pVblank->list);
+    free(pVblank);
+
+    pthread_mutex_lock(&pPresent->mutex);
+    pPresent->nWaiting--;
+    pthread_mutex_unlock(&pPresent->mutex);
+}
+
+static void
+winPresentAbortVblank(RRCrtcPtr crtc, uint64_t event_id, uint64_t msc)
+{
+    winPresentScreenPtr pPresent = winPresentScreen(crtc->pScreen);
+    winPresentVblankPtr pVblank;
+
+    if (pPresent == NULL)
+        return;
+
+    xorg_list_for_each_entry(pVblank, &pPresent->queue, list) {
+        if (pVblank->event_id == event_id) {
+            winPresentRemoveVblank(pPresent, pVblank);
+            break;
+        }
+    }
+}
+
+static void
+winPresentFlush(WindowPtr pWin)
+{
+    /* Rendering is done by fb on the CPU, nothing to flush */
+}
+
+static present_screen_info_rec winPresentInfo = {
+    .version = PRESENT_SCREEN_INFO_VERSION,
+    .get_crtc = winPresentGetCrtc,
+    .get_ust_msc = winPresentGetUstMsc,
+    .queue_vblank = winPresentQueueVblank,
+    .abort_vblank = winPresentAbortVblank,
+    .flush = winPresentFlush,
+    .capabilities = PresentCapabilityNone,
+};
+
+/*
+ * winPresentUpdateMonitor - Point the vblank thread at the monitor now
+ * showing the screen
+ */
+
+void
+winPresentUpdateMonitor(ScreenPtr pScreen)
+{
+    winPresentScreenPtr pPresent = winPresentScreen(pScreen);
+    MONITORINFOEX mi;
+
+    if (pPresent == NULL)
+        return;
+
+    mi.cbSize = sizeof(mi);
+    if (!GetMonitorInfo(winMonitorForScreen(pScreen), (LPMONITORINFO) &mi))
+        return;
+
+    pthread_mutex_lock(&pPresent->mutex);
+    if (strcmp(pPresent->szDevice, mi.szDevice) != 0) {
+        strcpy(pPresent->szDevice, mi.szDevice);
+        pPresent->uiGeneration++;
+        if (pPresent->fIdle)
+            pthread_cond_signal(&pPresent->cond);
+    }
+    pthread_mutex_unlock(&pPresent->mutex);
+}
+
+/*
+ * winPresentInit - Give Present a CRTC backed by real vblanks
+ *
+ * Leaves Present to its fake timers when the D3DKMT thunks are missing,
+ * as on Windows XP.
+ */
+
+Bool
+winPresentInit(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winPresentScreenPtr pPresent;
+    HMODULE hmodGdi32 = GetModuleHandle("gdi32.dll");
+    MONITORINFOEX mi;
+
+    pScreenPriv->pPresent = NULL;
+
+    if (s_pfnOpenAdapterFromHdc == NULL && hmodGdi32 != NULL) {
+        s_pfnOpenAdapterFromHdc = (winD3DKMTOpenAdapterFromHdcProc)
+            GetProcAddress(hmodGdi32, "D3DKMTOpenAdapterFromHdc");
+        s_pfnWaitForVerticalBlankEvent = (winD3DKMTWaitForVerticalBlankEventProc)
+            GetProcAddress(hmodGdi32, "D3DKMTWaitForVerticalBlankEvent");
+        s_pfnCloseAdapter = (winD3DKMTCloseAdapterProc)
+            GetProcAddress(hmodGdi32, "D3DKMTCloseAdapter");
+    }
+    if (s_pfnOpenAdapterFromHdc == NULL ||
+        s_pfnWaitForVerticalBlankEvent == NULL || s_pfnCloseAdapter == NULL) {
+        winDebug("winPresentInit - No D3DKMT vblank events, "
+                 "Present uses its timers\n");
+        return TRUE;
+    }
+
+    mi.cbSize = sizeof(mi);
+    if (!GetMonitorInfo(winMonitorForScreen(pScreen), (LPMONITORINFO) &mi))
+        return TRUE;
+
+    if (s_liPresentFrequency.QuadPart == 0)
+        QueryPerformanceFrequency(&s_liPresentFrequency);
+
+    pPresent = calloc(1, sizeof(winPresentScreenRec));
+    if (!pPresent)
+        return FALSE;
+
+    strcpy(pPresent->szDevice, mi.szDevice);
+    pPresent->interval = winPresentDeviceInterval(pPresent->szDevice);
+    pPresent->ust = winPresentUst();
+    pPresent->msc = 0;
+    xorg_list_init(&pPresent->queue);
+    pthread_mutex_init(&pPresent->mutex, NULL);
+    pthread_cond_init(&pPresent->cond, NULL);
+
+    if (pthread_create(&pPresent->thread, NULL, winPresentVblankThread,
+                       pPresent) != 0) {
+        ErrorF("winPresentInit - pthread_create () failed\n");
+        pthread_cond_destroy(&pPresent->cond);
+        pthread_mutex_destroy(&pPresent->mutex);
+        free(pPresent);
+        return TRUE;
+    }
+    pthread_detach(pPresent->thread);
+
+    pScreenPriv->pPresent = pPresent;
+    if (!present_screen_init(pScreen, &winPresentInfo)) {
+        winPresentFini(pScreen);
+        return FALSE;
+    }
+
+    winDebug("winPresentInit - Present vblanks from %s\n", mi.szDevice);
+    return TRUE;
+}
+
+/*
+ * winPresentBlockHandler - Deliver the vblank events that are due, and
+ * wake up in time for the next one
+ */
+
+void
+winPresentBlockHandler(ScreenPtr pScreen, void *pTimeout)
+{
+    winPresentScreenPtr pPresent = winPresentScreen(pScreen);
+    RRCrtcPtr crtc;
+    winPresentVblankPtr pVblank;
+    uint64_t ust, msc, next;
+    int *piTimeout = pTimeout;
+    int iWait;
+
+    if (pPresent == NULL || xorg_list_is_empty(&pPresent->queue))
+        return;
+
+    crtc = rrGetScrPriv(pScreen)->crtcs[0];
+    winPresentGetUstMsc(crtc, &ust, &msc);
+
+    /* Notifying can queue or abort other events, so start over each time */
+ restart:
+    xorg_list_for_each_entry(pVblank, &pPresent->queue, list) {
+        if (pVblank->msc <= msc) {
+            uint64_t event_id = pVblank->event_id;
+
+            winPresentRemoveVblank(pPresent, pVblank);
+            present_event_notify(event_id, ust, msc);
+            goto restart;
+        }
+    }
+
+    if (xorg_list_is_empty(&pPresent->queue))
+        return;
+
+    /* The next vblank is when the thread will have counted one more */
+    pthread_mutex_lock(&pPresent->mutex);
+    next = ust + pPresent->interval;
+    pthread_mutex_unlock(&pPresent->mutex);
+
+    /* Round up to whole milliseconds so we do not wake up early */
+    ust = winPresentUst();
+    iWait = next > ust ? (int) ((next - ust + 999) / 1000) : 0;
+    if (*piTimeout < 0 || *piTimeout > iWait)
+        *piTimeout = iWait;
+}
+
+/*
+ * winPresentFini - Detach the vblank thread from a closing screen
+ */
+
+void
+winPresentFini(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winPresentScreenPtr pPresent = pScreenPriv->pPresent;
+    winPresentVblankPtr pVblank, pTmp;
+
+    if (pPresent == NULL)
+        return;
+
+    xorg_list_for_each_entry_safe(pVblank, pTmp, &pPresent->queue, list) {
+        xorg_list_del(&pVblank->list);
+        free(pVblank);
+    }
+
+    /* The thread frees the record once it notices */
+    pthread_mutex_lock(&pPresent->mutex);
+    pPresent->fQuit = TRUE;
+    pthread_cond_signal(&pPresent->cond);
+    pthread_mutex_unlock(&pPresent->mutex);
+
+    pScreenPriv->pPresent = NULL;
+}
+
+#else
+
+Bool
+winPresentInit(ScreenPtr pScreen)
+{
+    return TRUE;
+}
+
+void
+winPresentUpdateMonitor(ScreenPtr pScreen)
+{
+}
+
+void
+winPresentBlockHandler(ScreenPtr pScreen, void *pTimeout)
+{
+}
+
+void
+winPresentFini(ScreenPtr pScreen)
+{
+}
+
+#endif
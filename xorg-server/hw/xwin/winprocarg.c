@@ -120,6 +120,9 @@ winInitializeScreenDefaults(void)
     defaultScreenInfo.fUserGavePosition = FALSE;
     defaultScreenInfo.dwBPP = WIN_DEFAULT_BPP;
     defaultScreenInfo.dwClipUpdatesNBoxes = WIN_DEFAULT_CLIP_UPDATES_NBOXES;
+    defaultScreenInfo.fFramePace = FALSE;
+    defaultScreenInfo.dwMaxFPS = 0;
+    defaultScreenInfo.dwScale = WIN_DEFAULT_SCALE;
 #ifdef XWIN_EMULATEPSEUDO
     defaultScreenInfo.fEmulatePseudo = WIN_DEFAULT_EMULATE_PSEUDO;
 #endif
@@ -130,6 +133,7 @@ winInitializeScreenDefaults(void)
     defaultScreenInfo.fNoDecorationFullScreen = FALSE;
 #ifdef XWIN_MULTIWINDOWEXTWM
     defaultScreenInfo.fMWExtWM = FALSE;
+    defaultScreenInfo.fLayeredFrames = FALSE;
 #endif
 #ifdef XWIN_MULTIWINDOWINTWM
 #endif
@@ -571,6 +575,16 @@ ddxProcessArgument(int argc, char *argv[], int i)
         /* Indicate that we have processed this argument */
         return 1;
     }
+
+    /*
+     * Look for the '-layeredframes' argument
+     */
+    if (IS_OPTION("-layeredframes")) {
+        screenInfoPtr->fLayeredFrames = TRUE;
+
+        /* Indicate that we have processed this argument */
+        return 1;
+    }
 #endif
 #ifdef XWIN_MULTIWINDOWINTWM
     /*
@@ -853,6 +867,64 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 2;
     }
 
+    /*
+     * Look for the '-framepace' argument
+     */
+    if (IS_OPTION("-framepace")) {
+        screenInfoPtr->fFramePace = TRUE;
+
+        /* Indicate that we have processed this argument */
+        return 1;
+    }
+
+    /*
+     * Look for the '-maxfps fps' argument
+     */
+    if (IS_OPTION("-maxfps")) {
+        /* Display the usage message if the argument is malformed */
+        if (++i >= argc) {
+            UseMsg();
+            return 0;
+        }
+
+        /* Grab the argument; a frame rate cap implies frame pacing */
+        screenInfoPtr->dwMaxFPS = atoi(argv[i]);
+        if (screenInfoPtr->dwMaxFPS != 0)
+            screenInfoPtr->fFramePace = TRUE;
+
+        /* Indicate that we have processed the argument */
+        return 2;
+    }
+
+    /*
+     * Look for the '-scale percent|auto' argument
+     */
+    if (IS_OPTION("-scale")) {
+        int iScale;
+
+        /* Display the usage message if the argument is malformed */
+        if (++i >= argc) {
+            UseMsg();
+            return 0;
+        }
+
+        if (strcmp(argv[i], "auto") == 0)
+            screenInfoPtr->dwScale = WIN_SCALE_AUTO;
+        else {
+            iScale = atoi(argv[i]);
+            if (iScale < 100 || iScale > 400) {
+                ErrorF("ddxProcessArgument - -scale must be auto or "
+                       "between 100 and 400\n");
+                UseMsg();
+                return 0;
+            }
+            screenInfoPtr->dwScale = iScale;
+        }
+
+        /* Indicate that we have processed the argument */
+        return 2;
+    }
+
 #ifdef XWIN_EMULATEPSEUDO
     /*
      * Look for the '-emulatepseudo' argument
@@ -1080,6 +1152,10 @@ ddxProcessArgument(int argc, char *argv[], int i)
         g_cmdline.xkbOptions = argv[++i];
         return 2;
     }
+    if (IS_OPTION("-xkbprecache")) {
+        g_fXkbPrecache = TRUE;
+        return 1;
+    }
 
     if (IS_OPTION("-keyhook")) {
         g_fKeyboardHookLL = TRUE;
@@ -1096,6 +1172,11 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 1;
     }
 
+    if (IS_OPTION("-rawmouse")) {
+        g_fRawMouse = TRUE;
+        return 1;
+    }
+
     if (IS_OPTION("-wgl")) {
         g_fNativeGl = TRUE;
         return 1;
@@ -1110,6 +1191,22 @@ ddxProcessArgument(int argc, char *argv[], int i)
         g_fswrastwgl = TRUE;
         return 1;
     }
+    else if (IS_OPTION("-asyncswap"))
+    {
+        g_fAsyncSwap = TRUE;
+        return 1;
+    }
+    else if (IS_OPTION("-glthread"))
+    {
+        g_fGLThread = TRUE;
+        return 1;
+    }
+    else if (IS_OPTION("-hiddenswapdelay"))
+    {
+        CHECK_ARGS(1);
+        g_iHiddenSwapDelay = atoi(argv[++i]);
+        return 2;
+    }
     else if (IS_OPTION("-parentprocessid"))
     {
         DWORD dwProcessId;
@@ -1133,6 +1230,34 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 1;
     }
 
+    if (IS_OPTION("-titlerate")) {
+        CHECK_ARGS(1);
+        g_iTitleRate = atoi(argv[++i]);
+        return 2;
+    }
+
+    if (IS_OPTION("-pixmapbudget")) {
+        CHECK_ARGS(1);
+        fbPixmapBudget = atoi(argv[++i]);
+        if (fbPixmapBudget < 0)
+            fbPixmapBudget = 0;
+        return 2;
+    }
+
+    if (IS_OPTION("-picturetrace")) {
+        CHECK_ARGS(1);
+        fbPictTraceFile = argv[++i];
+        return 2;
+    }
+
+    if (IS_OPTION("-pixmapidle")) {
+        CHECK_ARGS(1);
+        fbPixmapIdleTime = atoi(argv[++i]);
+        if (fbPixmapIdleTime < 0)
+            fbPixmapIdleTime = 0;
+        return 2;
+    }
+
     if (IS_OPTION("-codepage")) {
         g_iActualCodePage = TRUE;
         return 1;
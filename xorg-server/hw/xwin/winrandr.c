@@ -82,6 +82,10 @@ winRandRUpdateMode(ScreenPtr pScreen, RROutputPtr output)
         mode = RRModeGet(&modeInfo, name);
         output->crtc->mode = mode;
     }
+
+    /* Nobody asks winRandRGetInfo (), so say what changed here */
+    RROutputChanged(output, TRUE);
+    RRCrtcChanged(output->crtc, TRUE);
 }
 
 /*
@@ -109,10 +113,17 @@ winDoRandRScreenSetSize(ScreenPtr pScreen,
     pScreenInfo->dwWidth = width;
     pScreenInfo->dwHeight = height;
 
-    /* Reallocate the framebuffer used by the drawing engine */
-    (*pScreenPriv->pwinFreeFB) (pScreen);
-    if (!(*pScreenPriv->pwinAllocateFB) (pScreen)) {
-        ErrorF("winDoRandRScreenSetSize - Could not reallocate framebuffer\n");
+    /*
+     * Resize the framebuffer used by the drawing engine, in place if the
+     * engine can, else reallocate it
+     */
+    if (pScreenPriv->pwinResizeFB == NULL
+        || !(*pScreenPriv->pwinResizeFB) (pScreen)) {
+        (*pScreenPriv->pwinFreeFB) (pScreen);
+        if (!(*pScreenPriv->pwinAllocateFB) (pScreen)) {
+            ErrorF("winDoRandRScreenSetSize - Could not reallocate "
+                   "framebuffer\n");
+        }
     }
 
     pScreen->width = width;
@@ -244,6 +255,9 @@ winRandRInit(ScreenPtr pScreen)
     pRRScrPriv->rrCrtcSet = NULL;
     pRRScrPriv->rrCrtcSetGamma = NULL;
 
+    /* WM_DISPLAYCHANGE brings every change, so RandR need not poll */
+    pRRScrPriv->rrGetInfoPushed = TRUE;
+
     /* Create a CRTC and an output for the screen, and hook them together */
     {
         RRCrtcPtr crtc;
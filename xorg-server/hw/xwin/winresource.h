@@ -45,6 +45,9 @@
 #define ID_APP_ABOUT		203
 #define ID_APP_MONITOR_PRIMARY	204
 #define ID_APP_GATHER_WINDOWS	205
+#define ID_APP_DUMP_PROFILE	206
+#define ID_APP_DUMP_LATENCY	207
+#define ID_APP_STATISTICS	208
 
 #define ID_ABOUT_WEBSITE	303
 
@@ -151,7 +151,8 @@ winScreenInit(ScreenPtr pScreen, int argc, char **argv)
         && !GetSystemMetrics(SM_SAMEDISPLAYFORMAT)) {
         ErrorF("winScreenInit - Monitors do not all have same pixel format / "
                "display depth.\n");
-        if (pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI) {
+        if (pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI
+            || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_D3D11) {
             ErrorF
                 ("winScreenInit - Performance may suffer off primary display.\n");
         }
@@ -234,7 +235,9 @@ winCreateScreenResources(ScreenPtr pScreen)
     /* Now the screen bitmap has been wrapped in a pixmap,
        add that to the Shadow framebuffer */
     if (!shadowAdd(pScreen, pScreen->devPrivate,
-                   pScreenPriv->pwinShadowUpdate, NULL, 0, 0)) {
+                   pScreenPriv->pScreenInfo->fFramePace
+                   ? winShadowUpdatePaced : winShadowUpdateCounted,
+                   NULL, 0, 0)) {
         ErrorF("winCreateScreenResources - shadowAdd () failed\n");
         return FALSE;
     }
@@ -287,7 +290,8 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
     if (!fbSetupScreen(pScreen,
                        pScreenInfo->pfb,
                        pScreenInfo->dwWidth, pScreenInfo->dwHeight,
-                       monitorResolution, monitorResolution,
+                       winScaleToX(pScreenInfo, monitorResolution),
+                       winScaleToX(pScreenInfo, monitorResolution),
                        pScreenInfo->dwStride, pScreenInfo->dwBPP)) {
         ErrorF("winFinishScreenInitFB - fbSetupScreen failed\n");
         return FALSE;
@@ -317,7 +321,8 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
     if (!fbFinishScreenInit(pScreen,
                             pScreenInfo->pfb,
                             pScreenInfo->dwWidth, pScreenInfo->dwHeight,
-                            monitorResolution, monitorResolution,
+                            winScaleToX(pScreenInfo, monitorResolution),
+                            winScaleToX(pScreenInfo, monitorResolution),
                             pScreenInfo->dwStride, pScreenInfo->dwBPP)) {
         ErrorF("winFinishScreenInitFB - fbFinishScreenInit failed\n");
         return FALSE;
@@ -347,8 +352,20 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
         ErrorF("winFinishScreenInitFB - winRandRInit () failed\n");
         return FALSE;
     }
+
+    /* Drive Present from the vblanks of the screen's monitor */
+    if (!winPresentInit(pScreen)) {
+        ErrorF("winFinishScreenInitFB - winPresentInit () failed\n");
+        return FALSE;
+    }
 #endif
 
+    /* Let Sync fences be triggered through Windows event objects */
+    if (!winSyncInit(pScreen)) {
+        ErrorF("winFinishScreenInitFB - winSyncInit () failed\n");
+        return FALSE;
+    }
+
     /* Setup the cursor routines */
     winDebug("winFinishScreenInitFB - Calling miDCInitialize ()\n");
     miDCInitialize(pScreen, &g_winPointerCursorFuncs);
@@ -363,7 +380,8 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
 
     /* Initialize the shadow framebuffer layer */
     if ((pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI
-         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL)
+         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL
+         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_D3D11)
 #ifdef XWIN_MULTIWINDOWEXTWM
         && !pScreenInfo->fMWExtWM
 #endif
@@ -378,6 +396,9 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
            to the Shadow framebuffer after it's been created */
         pScreenPriv->pwinCreateScreenResources = pScreen->CreateScreenResources;
         pScreen->CreateScreenResources = winCreateScreenResources;
+
+        /* Collect damage between frames when frame pacing is on */
+        winFramePaceInit(pScreen);
     }
 
 #ifdef XWIN_MULTIWINDOWEXTWM
@@ -0,0 +1,998 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Shadow framebuffer engine presenting through a Direct3D 11 device and a
+ * DXGI flip-model swap chain.
+ *
+ * The shadow framebuffer itself lives in system memory, exactly as for
+ * ShadowDDNL, because fb needs a pointer that stays valid for the lifetime
+ * of the screen pixmap.  Damaged boxes are uploaded into a device texture
+ * that mirrors the shadow, copied into the current back buffer and
+ * presented with the damaged boxes as dirty rectangles, so DWM only has
+ * to recompose what actually changed.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#define COBJMACROS
+#include "win.h"
+#include "winprefs.h"
+
+#pragma push_macro("Status")
+#undef Status
+#define Status wStatus
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#pragma pop_macro("Status")
+
+/*
+ * Number of buffers in the flip chain.  The back buffer that we get handed
+ * after a Present holds the frame from WIN_D3D11_BUFFER_COUNT presents ago,
+ * so with two buffers it is enough to also re-copy the previous frame's
+ * damage before presenting.
+ */
+#define WIN_D3D11_BUFFER_COUNT	2
+
+/*
+ * Local prototypes
+ */
+
+static Bool
+ winAllocateFBShadowD3D11(ScreenPtr pScreen);
+
+static void
+ winFreeFBShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winResizeFBShadowD3D11(ScreenPtr pScreen);
+
+static void
+ winShadowUpdateD3D11(ScreenPtr pScreen, shadowBufPtr pBuf);
+
+static Bool
+ winCloseScreenShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winInitVisualsShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winAdjustVideoModeShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winBltExposedRegionsShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winActivateAppShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winRedrawScreenShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winRealizeInstalledPaletteShadowD3D11(ScreenPtr pScreen);
+
+static Bool
+ winInstallColormapShadowD3D11(ColormapPtr pColormap);
+
+static Bool
+ winStoreColorsShadowD3D11(ColormapPtr pmap, int ndef, xColorItem * pdefs);
+
+static Bool
+ winCreateColormapShadowD3D11(ColormapPtr pColormap);
+
+static Bool
+ winDestroyColormapShadowD3D11(ColormapPtr pColormap);
+
+/*
+ * Release the swap chain, the mirror texture and the device.
+ * The system memory shadow framebuffer is left alone.
+ */
+
+static void
+winReleaseDeviceShadowD3D11(winPrivScreenPtr pScreenPriv)
+{
+    if (pScreenPriv->pd3dtexShadow) {
+        ID3D11Texture2D_Release(pScreenPriv->pd3dtexShadow);
+        pScreenPriv->pd3dtexShadow = NULL;
+    }
+
+    if (pScreenPriv->pdxgiSwapChain) {
+        IDXGISwapChain1_Release(pScreenPriv->pdxgiSwapChain);
+        pScreenPriv->pdxgiSwapChain = NULL;
+    }
+
+    if (pScreenPriv->pd3dContext) {
+        ID3D11DeviceContext_ClearState(pScreenPriv->pd3dContext);
+        ID3D11DeviceContext_Release(pScreenPriv->pd3dContext);
+        pScreenPriv->pd3dContext = NULL;
+    }
+
+    if (pScreenPriv->pd3dDevice) {
+        ID3D11Device_Release(pScreenPriv->pd3dDevice);
+        pScreenPriv->pd3dDevice = NULL;
+    }
+
+    RegionEmpty(&pScreenPriv->rgnD3D11Pending);
+    RegionEmpty(&pScreenPriv->rgnD3D11Presented);
+}
+
+/*
+ * (Re)create the device texture mirroring the shadow framebuffer at the
+ * screen size, and upload and present the whole shadow.
+ */
+
+static Bool
+winCreateShadowTextureD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    D3D11_TEXTURE2D_DESC td;
+    BoxRec box;
+    HRESULT hr;
+
+    if (pScreenPriv->pd3dtexShadow) {
+        ID3D11Texture2D_Release(pScreenPriv->pd3dtexShadow);
+        pScreenPriv->pd3dtexShadow = NULL;
+    }
+
+    /* Describe the device copy of the shadow framebuffer */
+    ZeroMemory(&td, sizeof(td));
+    td.Width = pScreenInfo->dwWidth;
+    td.Height = pScreenInfo->dwHeight;
+    td.MipLevels = 1;
+    td.ArraySize = 1;
+    td.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_DEFAULT;
+
+    hr = ID3D11Device_CreateTexture2D(pScreenPriv->pd3dDevice, &td, NULL,
+                                      &pScreenPriv->pd3dtexShadow);
+    if (FAILED(hr)) {
+        ErrorF("winCreateShadowTextureD3D11 - CreateTexture2D failed: "
+               "%08x\n", (unsigned int) hr);
+        return FALSE;
+    }
+
+    /* Bring the device copy up to date and present all of it */
+    ID3D11DeviceContext_UpdateSubresource(pScreenPriv->pd3dContext,
+                                          (ID3D11Resource *) pScreenPriv->
+                                          pd3dtexShadow, 0, NULL,
+                                          pScreenInfo->pfb,
+                                          pScreenInfo->dwPaddedWidth, 0);
+
+    box.x1 = 0;
+    box.y1 = 0;
+    box.x2 = pScreenInfo->dwWidth;
+    box.y2 = pScreenInfo->dwHeight;
+    RegionReset(&pScreenPriv->rgnD3D11Pending, &box);
+    RegionReset(&pScreenPriv->rgnD3D11Presented, &box);
+
+    return TRUE;
+}
+
+/*
+ * Create the device, the swap chain for our display window and a device
+ * texture mirroring the shadow framebuffer, then upload the whole shadow.
+ */
+
+static Bool
+winCreateDeviceShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    static const D3D_FEATURE_LEVEL afl[] = {
+        D3D_FEATURE_LEVEL_11_0,
+        D3D_FEATURE_LEVEL_10_1,
+        D3D_FEATURE_LEVEL_10_0,
+        D3D_FEATURE_LEVEL_9_3,
+        D3D_FEATURE_LEVEL_9_1
+    };
+    PFN_D3D11_CREATE_DEVICE pfnCreateDevice =
+        (PFN_D3D11_CREATE_DEVICE) g_fpD3D11CreateDevice;
+    IDXGIDevice *pdxgiDevice = NULL;
+    IDXGIAdapter *pdxgiAdapter = NULL;
+    IDXGIFactory2 *pdxgiFactory = NULL;
+    DXGI_SWAP_CHAIN_DESC1 scd;
+    RECT rcClient;
+    HRESULT hr;
+    Bool fReturn = FALSE;
+
+    if (pfnCreateDevice == NULL)
+        return FALSE;
+
+    hr = (*pfnCreateDevice) (NULL, D3D_DRIVER_TYPE_HARDWARE, NULL,
+                             D3D11_CREATE_DEVICE_BGRA_SUPPORT
+                             | D3D11_CREATE_DEVICE_SINGLETHREADED,
+                             afl, ARRAY_SIZE(afl), D3D11_SDK_VERSION,
+                             &pScreenPriv->pd3dDevice, NULL,
+                             &pScreenPriv->pd3dContext);
+    if (FAILED(hr)) {
+        ErrorF("winCreateDeviceShadowD3D11 - D3D11CreateDevice failed: "
+               "%08x\n", (unsigned int) hr);
+        goto winCreateDeviceShadowD3D11_Exit;
+    }
+
+    /* Walk up to the factory that created our device */
+    hr = ID3D11Device_QueryInterface(pScreenPriv->pd3dDevice,
+                                     &IID_IDXGIDevice, (void **) &pdxgiDevice);
+    if (SUCCEEDED(hr))
+        hr = IDXGIDevice_GetAdapter(pdxgiDevice, &pdxgiAdapter);
+    if (SUCCEEDED(hr))
+        hr = IDXGIAdapter_GetParent(pdxgiAdapter, &IID_IDXGIFactory2,
+                                    (void **) &pdxgiFactory);
+    if (FAILED(hr)) {
+        ErrorF("winCreateDeviceShadowD3D11 - Could not get a DXGI 1.2 "
+               "factory: %08x\n", (unsigned int) hr);
+        goto winCreateDeviceShadowD3D11_Exit;
+    }
+
+    /*
+     * The swap chain covers the client area of our display window, in X
+     * pixels; with -scale the compositor stretches it up to fit.
+     */
+    GetClientRect(pScreenPriv->hwndScreen, &rcClient);
+    pScreenPriv->dwD3D11BufferWidth =
+        max(winScaleToX(pScreenInfo, rcClient.right - rcClient.left), 1);
+    pScreenPriv->dwD3D11BufferHeight =
+        max(winScaleToX(pScreenInfo, rcClient.bottom - rcClient.top), 1);
+    pScreenPriv->dwD3D11XOffset = pScreenInfo->dwXOffset;
+    pScreenPriv->dwD3D11YOffset = pScreenInfo->dwYOffset;
+
+    ZeroMemory(&scd, sizeof(scd));
+    scd.Width = pScreenPriv->dwD3D11BufferWidth;
+    scd.Height = pScreenPriv->dwD3D11BufferHeight;
+    scd.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    scd.SampleDesc.Count = 1;
+    scd.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    scd.BufferCount = WIN_D3D11_BUFFER_COUNT;
+    scd.Scaling = pScreenInfo->dwScale != WIN_DEFAULT_SCALE
+        ? DXGI_SCALING_STRETCH : DXGI_SCALING_NONE;
+    scd.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    scd.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+
+    hr = IDXGIFactory2_CreateSwapChainForHwnd(pdxgiFactory,
+                                              (IUnknown *) pScreenPriv->
+                                              pd3dDevice,
+                                              pScreenPriv->hwndScreen, &scd,
+                                              NULL, NULL,
+                                              &pScreenPriv->pdxgiSwapChain);
+    if (FAILED(hr)) {
+        ErrorF("winCreateDeviceShadowD3D11 - CreateSwapChainForHwnd "
+               "failed: %08x\n", (unsigned int) hr);
+        goto winCreateDeviceShadowD3D11_Exit;
+    }
+
+    /* We do our own fullscreen handling, keep DXGI out of it */
+    IDXGIFactory2_MakeWindowAssociation(pdxgiFactory, pScreenPriv->hwndScreen,
+                                        DXGI_MWA_NO_WINDOW_CHANGES
+                                        | DXGI_MWA_NO_ALT_ENTER);
+
+    if (!winCreateShadowTextureD3D11(pScreen))
+        goto winCreateDeviceShadowD3D11_Exit;
+
+    winDebug("winCreateDeviceShadowD3D11 - Created %dx%d swap chain\n",
+             (int) scd.Width, (int) scd.Height);
+
+    fReturn = TRUE;
+
+ winCreateDeviceShadowD3D11_Exit:
+    if (pdxgiFactory)
+        IDXGIFactory2_Release(pdxgiFactory);
+    if (pdxgiAdapter)
+        IDXGIAdapter_Release(pdxgiAdapter);
+    if (pdxgiDevice)
+        IDXGIDevice_Release(pdxgiDevice);
+
+    if (!fReturn)
+        winReleaseDeviceShadowD3D11(pScreenPriv);
+
+    return fReturn;
+}
+
+/*
+ * Copy everything that is stale in the current back buffer from the device
+ * copy of the shadow, then present the pending damage as dirty rectangles.
+ */
+
+static void
+winPresentShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    ID3D11Texture2D *pd3dtexBack = NULL;
+    DXGI_PRESENT_PARAMETERS pp;
+    RegionRec rgnCopy, rgnVisible;
+    BoxRec boxVisible;
+    RECT rcClient;
+    RECT *prcDirty = NULL;
+    BoxPtr pBox;
+    int iBox, nBox;
+    HRESULT hr;
+
+    /* Try to get our device back if it was lost */
+    if (pScreenPriv->pdxgiSwapChain == NULL
+        && !winCreateDeviceShadowD3D11(pScreen))
+        return;
+
+    /* Follow changes to the size of the client area and the scroll offsets */
+    GetClientRect(pScreenPriv->hwndScreen, &rcClient);
+    rcClient.right =
+        max(winScaleToX(pScreenInfo, rcClient.right - rcClient.left), 1);
+    rcClient.bottom =
+        max(winScaleToX(pScreenInfo, rcClient.bottom - rcClient.top), 1);
+    if ((DWORD) rcClient.right != pScreenPriv->dwD3D11BufferWidth
+        || (DWORD) rcClient.bottom != pScreenPriv->dwD3D11BufferHeight) {
+        hr = IDXGISwapChain1_ResizeBuffers(pScreenPriv->pdxgiSwapChain, 0,
+                                           rcClient.right, rcClient.bottom,
+                                           DXGI_FORMAT_UNKNOWN, 0);
+        if (FAILED(hr)) {
+            ErrorF("winPresentShadowD3D11 - ResizeBuffers failed: %08x\n",
+                   (unsigned int) hr);
+            winReleaseDeviceShadowD3D11(pScreenPriv);
+            return;
+        }
+        pScreenPriv->dwD3D11BufferWidth = rcClient.right;
+        pScreenPriv->dwD3D11BufferHeight = rcClient.bottom;
+        pScreenPriv->dwD3D11XOffset = ~0;
+    }
+
+    /* Part of the screen visible through the window, in shadow coords */
+    boxVisible.x1 = pScreenInfo->dwXOffset;
+    boxVisible.y1 = pScreenInfo->dwYOffset;
+    boxVisible.x2 = min(pScreenInfo->dwXOffset
+                        + pScreenPriv->dwD3D11BufferWidth,
+                        pScreenInfo->dwWidth);
+    boxVisible.y2 = min(pScreenInfo->dwYOffset
+                        + pScreenPriv->dwD3D11BufferHeight,
+                        pScreenInfo->dwHeight);
+
+    /* New buffers or a scrolled view leave every back buffer stale */
+    if (pScreenPriv->dwD3D11XOffset != pScreenInfo->dwXOffset
+        || pScreenPriv->dwD3D11YOffset != pScreenInfo->dwYOffset) {
+        RegionReset(&pScreenPriv->rgnD3D11Pending, &boxVisible);
+        RegionReset(&pScreenPriv->rgnD3D11Presented, &boxVisible);
+        pScreenPriv->dwD3D11XOffset = pScreenInfo->dwXOffset;
+        pScreenPriv->dwD3D11YOffset = pScreenInfo->dwYOffset;
+    }
+
+    RegionInit(&rgnVisible, &boxVisible, 1);
+    RegionIntersect(&pScreenPriv->rgnD3D11Pending,
+                    &pScreenPriv->rgnD3D11Pending, &rgnVisible);
+    if (!RegionNotEmpty(&pScreenPriv->rgnD3D11Pending)) {
+        RegionUninit(&rgnVisible);
+        return;
+    }
+
+    hr = IDXGISwapChain1_GetBuffer(pScreenPriv->pdxgiSwapChain, 0,
+                                   &IID_ID3D11Texture2D,
+                                   (void **) &pd3dtexBack);
+    if (FAILED(hr)) {
+        ErrorF("winPresentShadowD3D11 - GetBuffer failed: %08x\n",
+               (unsigned int) hr);
+        RegionUninit(&rgnVisible);
+        return;
+    }
+
+    /*
+     * The back buffer last held the frame before the previous one, so it
+     * is missing both the damage we are about to present and the damage
+     * presented last time.
+     */
+    RegionNull(&rgnCopy);
+    RegionUnion(&rgnCopy, &pScreenPriv->rgnD3D11Pending,
+                &pScreenPriv->rgnD3D11Presented);
+    RegionIntersect(&rgnCopy, &rgnCopy, &rgnVisible);
+    RegionUninit(&rgnVisible);
+
+    nBox = RegionNumRects(&rgnCopy);
+    pBox = RegionRects(&rgnCopy);
+    for (iBox = 0; iBox < nBox; ++iBox, ++pBox) {
+        D3D11_BOX boxSrc;
+
+        boxSrc.left = pBox->x1;
+        boxSrc.top = pBox->y1;
+        boxSrc.front = 0;
+        boxSrc.right = pBox->x2;
+        boxSrc.bottom = pBox->y2;
+        boxSrc.back = 1;
+
+        ID3D11DeviceContext_CopySubresourceRegion(pScreenPriv->pd3dContext,
+                                                  (ID3D11Resource *)
+                                                  pd3dtexBack, 0,
+                                                  pBox->x1 -
+                                                  pScreenInfo->dwXOffset,
+                                                  pBox->y1 -
+                                                  pScreenInfo->dwYOffset, 0,
+                                                  (ID3D11Resource *)
+                                                  pScreenPriv->pd3dtexShadow,
+                                                  0, &boxSrc);
+    }
+    RegionUninit(&rgnCopy);
+
+    ID3D11Texture2D_Release(pd3dtexBack);
+
+    /* Dirty rectangles are in back buffer coordinates */
+    nBox = RegionNumRects(&pScreenPriv->rgnD3D11Pending);
+    pBox = RegionRects(&pScreenPriv->rgnD3D11Pending);
+    prcDirty = xallocarray(nBox, sizeof(RECT));
+
+    ZeroMemory(&pp, sizeof(pp));
+    if (prcDirty != NULL) {
+        for (iBox = 0; iBox < nBox; ++iBox, ++pBox) {
+            prcDirty[iBox].left = pBox->x1 - pScreenInfo->dwXOffset;
+            prcDirty[iBox].top = pBox->y1 - pScreenInfo->dwYOffset;
+            prcDirty[iBox].right = pBox->x2 - pScreenInfo->dwXOffset;
+            prcDirty[iBox].bottom = pBox->y2 - pScreenInfo->dwYOffset;
+        }
+        pp.DirtyRectsCount = nBox;
+        pp.pDirtyRects = prcDirty;
+    }
+
+    /*
+     * Never block the server on the compositor; if the queue is full the
+     * damage stays pending and goes out with the next update.
+     */
+    hr = IDXGISwapChain1_Present1(pScreenPriv->pdxgiSwapChain, 0,
+                                  DXGI_PRESENT_DO_NOT_WAIT, &pp);
+    free(prcDirty);
+
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+        return;
+
+    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) {
+        ErrorF("winPresentShadowD3D11 - Device lost, recreating on next "
+               "update\n");
+        winReleaseDeviceShadowD3D11(pScreenPriv);
+        return;
+    }
+    else if (FAILED(hr)) {
+        ErrorF("winPresentShadowD3D11 - Present1 failed: %08x\n",
+               (unsigned int) hr);
+    }
+
+    /* What we just presented is what the next back buffer will be missing */
+    RegionCopy(&pScreenPriv->rgnD3D11Presented, &pScreenPriv->rgnD3D11Pending);
+    RegionEmpty(&pScreenPriv->rgnD3D11Pending);
+}
+
+/*
+ * Allocate the system memory shadow framebuffer and the device objects
+ * used to present it.
+ */
+
+static Bool
+winAllocateFBShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    winDebug("winAllocateFBShadowD3D11 - w %u h %u d %u\n",
+             (unsigned int)pScreenInfo->dwWidth,
+             (unsigned int)pScreenInfo->dwHeight,
+             (unsigned int)pScreenInfo->dwDepth);
+
+    /* Set the padded screen width, each row whole cache lines */
+    pScreenInfo->dwPaddedWidth =
+        PixmapBytePad(winFBAlignWidth(pScreenInfo->dwWidth,
+                                      pScreenInfo->dwBPP),
+                      pScreenInfo->dwBPP);
+    pScreenPriv->dwD3D11FBWidth = pScreenInfo->dwWidth;
+    pScreenPriv->dwD3D11FBHeight = pScreenInfo->dwHeight;
+
+    /*
+     * Allocate memory for our shadow surface, in large pages if we may,
+     * which comes zeroed so we don't get a strange display at startup
+     */
+    pScreenInfo->pfb = winAllocFBMemory(pScreenInfo->dwPaddedWidth
+                                        * pScreenInfo->dwHeight);
+    if (pScreenInfo->pfb == NULL) {
+        ErrorF("winAllocateFBShadowD3D11 - Could not allocate bits\n");
+        return FALSE;
+    }
+
+    /* Set screeninfo stride */
+    pScreenInfo->dwStride = (pScreenInfo->dwPaddedWidth * 8)
+        / pScreenInfo->dwBPP;
+
+    winDebug("winAllocateFBShadowD3D11 - Created shadow stride: %d\n",
+             (int) pScreenInfo->dwStride);
+
+    if (!winCreateDeviceShadowD3D11(pScreen)) {
+        ErrorF("winAllocateFBShadowD3D11 - winCreateDeviceShadowD3D11 "
+               "failed\n");
+        winFreeFBMemory(pScreenInfo->pfb);
+        pScreenInfo->pfb = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+winFreeFBShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    winReleaseDeviceShadowD3D11(pScreenPriv);
+
+    /* Free the shadow framebuffer and invalidate the ScreenInfo's pointer */
+    winFreeFBMemory(pScreenInfo->pfb);
+    pScreenInfo->pfb = NULL;
+}
+
+/*
+ * Resize the shadow to the screen size in pScreenInfo, from the size of
+ * pScreen.  Shadow memory that is big enough is kept with its stride,
+ * memory that is too small is replaced, rounded up so that growing a
+ * little more later doesn't replace it again.  The swap chain follows the
+ * window anyway; only the device copy of the shadow is remade.
+ */
+
+static Bool
+winResizeFBShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    if (pScreenInfo->dwWidth > pScreenPriv->dwD3D11FBWidth
+        || pScreenInfo->dwHeight > pScreenPriv->dwD3D11FBHeight) {
+        DWORD dwFBWidth = winFBGrowSize(max(pScreenInfo->dwWidth,
+                                            pScreenPriv->dwD3D11FBWidth));
+        DWORD dwFBHeight = winFBGrowSize(max(pScreenInfo->dwHeight,
+                                             pScreenPriv->dwD3D11FBHeight));
+        DWORD dwPaddedWidth = PixmapBytePad(dwFBWidth, pScreenInfo->dwBPP);
+        char *pfb = winAllocFBMemory(dwPaddedWidth * dwFBHeight);
+
+        if (pfb == NULL) {
+            ErrorF("winResizeFBShadowD3D11 - Could not allocate bits\n");
+            return FALSE;
+        }
+
+        winDebug("winResizeFBShadowD3D11 - Growing shadow to w %u h %u\n",
+                 (unsigned int) dwFBWidth, (unsigned int) dwFBHeight);
+
+        /* Keep what is still on screen */
+        winCopyFBRows(pfb, dwPaddedWidth,
+                      pScreenInfo->pfb, pScreenInfo->dwPaddedWidth,
+                      min((DWORD) pScreen->width, pScreenInfo->dwWidth)
+                      * pScreenInfo->dwBPP / 8,
+                      min((DWORD) pScreen->height, pScreenInfo->dwHeight));
+
+        winFreeFBMemory(pScreenInfo->pfb);
+        pScreenInfo->pfb = pfb;
+        pScreenInfo->dwPaddedWidth = dwPaddedWidth;
+        pScreenInfo->dwStride = (dwPaddedWidth * 8) / pScreenInfo->dwBPP;
+        pScreenPriv->dwD3D11FBWidth = dwFBWidth;
+        pScreenPriv->dwD3D11FBHeight = dwFBHeight;
+    }
+
+    /* Without a device, it is made at the new size on the next update */
+    if (pScreenPriv->pdxgiSwapChain && !winCreateShadowTextureD3D11(pScreen))
+        winReleaseDeviceShadowD3D11(pScreenPriv);
+
+    return TRUE;
+}
+
+/*
+ * Upload the damaged regions of the shadow framebuffer and present them.
+ */
+
+static void
+winShadowUpdateD3D11(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    RegionPtr damage = DamageRegion(pBuf->pDamage);
+    DWORD dwBox = RegionNumRects(damage);
+    BoxPtr pBox = RegionRects(damage);
+
+    /*
+     * Return immediately if the app is not active
+     * and we are fullscreen, or if we have a bad display depth
+     */
+    if ((!pScreenPriv->fActive && pScreenInfo->fFullScreen)
+        || pScreenPriv->fBadDepth)
+        return;
+
+    /* Recreating the device uploads the whole shadow anyway */
+    if (pScreenPriv->pdxgiSwapChain == NULL) {
+        winPresentShadowD3D11(pScreen);
+        return;
+    }
+
+    /* Loop through all boxes in the damaged region */
+    while (dwBox--) {
+        D3D11_BOX boxDst;
+
+        boxDst.left = pBox->x1;
+        boxDst.top = pBox->y1;
+        boxDst.front = 0;
+        boxDst.right = pBox->x2;
+        boxDst.bottom = pBox->y2;
+        boxDst.back = 1;
+
+        ID3D11DeviceContext_UpdateSubresource(pScreenPriv->pd3dContext,
+                                              (ID3D11Resource *)
+                                              pScreenPriv->pd3dtexShadow, 0,
+                                              &boxDst,
+                                              pScreenInfo->pfb
+                                              + pBox->y1
+                                              * pScreenInfo->dwPaddedWidth
+                                              + pBox->x1
+                                              * (pScreenInfo->dwBPP / 8),
+                                              pScreenInfo->dwPaddedWidth, 0);
+
+        /* Get a pointer to the next box */
+        ++pBox;
+    }
+
+    RegionUnion(&pScreenPriv->rgnD3D11Pending,
+                &pScreenPriv->rgnD3D11Pending, damage);
+
+    winPresentShadowD3D11(pScreen);
+}
+
+static Bool
+winInitScreenShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    /* Get a device context for the screen  */
+    pScreenPriv->hdcScreen = GetDC(pScreenPriv->hwndScreen);
+
+    /* The swap chain format fixes our masks */
+    pScreenPriv->dwBitsPerRGB = 8;
+    pScreenPriv->dwRedMask = WIN_24BPP_MASK_RED;
+    pScreenPriv->dwGreenMask = WIN_24BPP_MASK_GREEN;
+    pScreenPriv->dwBlueMask = WIN_24BPP_MASK_BLUE;
+
+    RegionNull(&pScreenPriv->rgnD3D11Pending);
+    RegionNull(&pScreenPriv->rgnD3D11Presented);
+
+    return winAllocateFBShadowD3D11(pScreen);
+}
+
+/*
+ * Call the wrapped CloseScreen function.
+ *
+ * Free our resources and private structures.
+ */
+
+static Bool
+winCloseScreenShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    Bool fReturn = TRUE;
+
+    winDebug("winCloseScreenShadowD3D11 - Freeing screen resources\n");
+
+    /* Flag that the screen is closed */
+    pScreenPriv->fClosed = TRUE;
+    pScreenPriv->fActive = FALSE;
+
+    /* Call the wrapped CloseScreen procedure */
+    WIN_UNWRAP(CloseScreen);
+    if (pScreen->CloseScreen)
+        fReturn = (*pScreen->CloseScreen) (pScreen);
+
+    winFreeFBShadowD3D11(pScreen);
+    RegionUninit(&pScreenPriv->rgnD3D11Pending);
+    RegionUninit(&pScreenPriv->rgnD3D11Presented);
+
+    /* Free the screen DC */
+    ReleaseDC(pScreenPriv->hwndScreen, pScreenPriv->hdcScreen);
+
+    /* Delete the window property */
+    RemoveProp(pScreenPriv->hwndScreen, WIN_SCR_PROP);
+
+    /* Delete tray icon, if we have one */
+    if (!pScreenInfo->fNoTrayIcon && !pref.fNoTrayIcon)
+        winDeleteNotifyIcon(pScreenPriv);
+
+    /* Free the exit confirmation dialog box, if it exists */
+    if (g_hDlgExit != NULL) {
+        DestroyWindow(g_hDlgExit);
+        g_hDlgExit = NULL;
+    }
+
+    /* Kill our window */
+    if (pScreenPriv->hwndScreen) {
+        DestroyWindow(pScreenPriv->hwndScreen);
+        pScreenPriv->hwndScreen = NULL;
+    }
+
+    /* Destroy the thread startup mutex */
+    if (pScreenPriv->pmServerStarted) pthread_mutex_destroy (&pScreenPriv->pmServerStarted);
+
+    /* Free the frame pacing damage */
+    winFramePaceFini(pScreen);
+    winPresentFini(pScreen);
+
+    /* Kill our screeninfo's pointer to the screen */
+    pScreenInfo->pScreen = NULL;
+
+    /* Free the screen privates for this screen */
+    free((void *) pScreenPriv);
+
+    return fReturn;
+}
+
+/*
+ * Tell mi what sort of visuals we need.
+ *
+ * The swap chain is always B8G8R8A8, so we only offer a depth 24
+ * TrueColor visual.
+ */
+
+static Bool
+winInitVisualsShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    winDebug("winInitVisualsShadowD3D11 - Masks %08x %08x %08x BPRGB %d d %d "
+             "bpp %d\n",
+             (unsigned int) pScreenPriv->dwRedMask,
+             (unsigned int) pScreenPriv->dwGreenMask,
+             (unsigned int) pScreenPriv->dwBlueMask,
+             (int) pScreenPriv->dwBitsPerRGB,
+             (int) pScreenInfo->dwDepth, (int) pScreenInfo->dwBPP);
+
+    if (pScreenInfo->dwDepth != 24) {
+        ErrorF("winInitVisualsShadowD3D11 - Unsupported screen depth %d\n",
+               (int) pScreenInfo->dwDepth);
+        return FALSE;
+    }
+
+    if (!miSetVisualTypesAndMasks(pScreenInfo->dwDepth,
+                                  TrueColorMask,
+                                  pScreenPriv->dwBitsPerRGB,
+                                  -1,
+                                  pScreenPriv->dwRedMask,
+                                  pScreenPriv->dwGreenMask,
+                                  pScreenPriv->dwBlueMask)) {
+        ErrorF("winInitVisualsShadowD3D11 - miSetVisualTypesAndMasks "
+               "failed for TrueColor\n");
+        return FALSE;
+    }
+
+#ifdef XWIN_EMULATEPSEUDO
+    if (pScreenInfo->fEmulatePseudo) {
+        /* Setup a pseudocolor visual */
+        if (!miSetVisualTypesAndMasks(8, PseudoColorMask, 8, -1, 0, 0, 0)) {
+            ErrorF("winInitVisualsShadowD3D11 - miSetVisualTypesAndMasks "
+                   "failed for PseudoColor\n");
+            return FALSE;
+        }
+    }
+#endif
+
+    winDebug("winInitVisualsShadowD3D11 - Returning\n");
+
+    return TRUE;
+}
+
+/*
+ * Adjust the user proposed video mode
+ */
+
+static Bool
+winAdjustVideoModeShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /*
+     * The swap chain converts to whatever the display uses, so the
+     * shadow is always 32 bpp regardless of the Windows display depth.
+     */
+    if (pScreenInfo->dwBPP != WIN_DEFAULT_BPP && pScreenInfo->dwBPP != 32)
+        winDebug("winAdjustVideoModeShadowD3D11 - Ignoring depth %d, using "
+                 "32 bpp\n", (int) pScreenInfo->dwBPP);
+
+    pScreenInfo->dwBPP = 32;
+
+    return TRUE;
+}
+
+/*
+ * Blt exposed regions to the screen
+ */
+
+static Bool
+winBltExposedRegionsShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    PAINTSTRUCT ps;
+
+    /*
+     * DWM keeps the contents of a flip-model window, so exposures only
+     * happen when the window was resized or the device went away.
+     * Validate the window and present the whole frame.
+     */
+    BeginPaint(pScreenPriv->hwndScreen, &ps);
+    EndPaint(pScreenPriv->hwndScreen, &ps);
+
+    return winRedrawScreenShadowD3D11(pScreen);
+}
+
+/*
+ * Do any engine-specific application-activation processing
+ */
+
+static Bool
+winActivateAppShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /* Same fullscreen behaviour as the other engines */
+    if (pScreenPriv->fActive && pScreenInfo->fFullScreen)
+        ShowWindow(pScreenPriv->hwndScreen, SW_RESTORE);
+    else if (!pScreenPriv->fActive && pScreenInfo->fFullScreen)
+        ShowWindow(pScreenPriv->hwndScreen, SW_MINIMIZE);
+
+    return TRUE;
+}
+
+/*
+ * Reblit the shadow framebuffer to the screen.
+ */
+
+static Bool
+winRedrawScreenShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    BoxRec box;
+
+    if (pScreenInfo->pfb == NULL)
+        return FALSE;
+
+    /* Recreating the device already queues a full frame */
+    if (pScreenPriv->pdxgiSwapChain == NULL) {
+        winPresentShadowD3D11(pScreen);
+        return pScreenPriv->pdxgiSwapChain != NULL;
+    }
+
+    ID3D11DeviceContext_UpdateSubresource(pScreenPriv->pd3dContext,
+                                          (ID3D11Resource *) pScreenPriv->
+                                          pd3dtexShadow, 0, NULL,
+                                          pScreenInfo->pfb,
+                                          pScreenInfo->dwPaddedWidth, 0);
+
+    box.x1 = 0;
+    box.y1 = 0;
+    box.x2 = pScreenInfo->dwWidth;
+    box.y2 = pScreenInfo->dwHeight;
+    RegionReset(&pScreenPriv->rgnD3D11Pending, &box);
+    RegionReset(&pScreenPriv->rgnD3D11Presented, &box);
+
+    winPresentShadowD3D11(pScreen);
+
+    return TRUE;
+}
+
+/*
+ * Realize the currently installed colormap
+ */
+
+static Bool
+winRealizeInstalledPaletteShadowD3D11(ScreenPtr pScreen)
+{
+    return TRUE;
+}
+
+/*
+ * Install the specified colormap
+ */
+
+static Bool
+winInstallColormapShadowD3D11(ColormapPtr pColormap)
+{
+    winScreenPriv(pColormap->pScreen);
+
+    /* TrueColor only, nothing to load into the swap chain */
+    pScreenPriv->pcmapInstalled = pColormap;
+
+    return TRUE;
+}
+
+/*
+ * Store the specified colors in the specified colormap
+ */
+
+static Bool
+winStoreColorsShadowD3D11(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
+{
+    return TRUE;
+}
+
+/*
+ * Colormap initialization procedure
+ */
+
+static Bool
+winCreateColormapShadowD3D11(ColormapPtr pColormap)
+{
+    return TRUE;
+}
+
+/*
+ * Colormap destruction procedure
+ */
+
+static Bool
+winDestroyColormapShadowD3D11(ColormapPtr pColormap)
+{
+    winScreenPriv(pColormap->pScreen);
+
+    if (pColormap->flags & IsDefault)
+        pScreenPriv->pcmapInstalled = NULL;
+
+    return TRUE;
+}
+
+/*
+ * Set pointers to our engine specific functions
+ */
+
+Bool
+winSetEngineFunctionsShadowD3D11(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /* Set our pointers */
+    pScreenPriv->pwinAllocateFB = winAllocateFBShadowD3D11;
+    pScreenPriv->pwinFreeFB = winFreeFBShadowD3D11;
+    pScreenPriv->pwinResizeFB = winResizeFBShadowD3D11;
+    pScreenPriv->pwinShadowUpdate = winShadowUpdateD3D11;
+    pScreenPriv->pwinInitScreen = winInitScreenShadowD3D11;
+    pScreenPriv->pwinCloseScreen = winCloseScreenShadowD3D11;
+    pScreenPriv->pwinInitVisuals = winInitVisualsShadowD3D11;
+    pScreenPriv->pwinAdjustVideoMode = winAdjustVideoModeShadowD3D11;
+    if (pScreenInfo->fFullScreen)
+        pScreenPriv->pwinCreateBoundingWindow =
+            winCreateBoundingWindowFullScreen;
+    else
+        pScreenPriv->pwinCreateBoundingWindow = winCreateBoundingWindowWindowed;
+    pScreenPriv->pwinFinishScreenInit = winFinishScreenInitFB;
+    pScreenPriv->pwinBltExposedRegions = winBltExposedRegionsShadowD3D11;
+    pScreenPriv->pwinBltExposedWindowRegion = NULL;
+    pScreenPriv->pwinActivateApp = winActivateAppShadowD3D11;
+    pScreenPriv->pwinRedrawScreen = winRedrawScreenShadowD3D11;
+    pScreenPriv->pwinRealizeInstalledPalette =
+        winRealizeInstalledPaletteShadowD3D11;
+    pScreenPriv->pwinInstallColormap = winInstallColormapShadowD3D11;
+    pScreenPriv->pwinStoreColors = winStoreColorsShadowD3D11;
+    pScreenPriv->pwinCreateColormap = winCreateColormapShadowD3D11;
+    pScreenPriv->pwinDestroyColormap = winDestroyColormapShadowD3D11;
+    pScreenPriv->pwinCreatePrimarySurface = NULL;
+    pScreenPriv->pwinReleasePrimarySurface = NULL;
+
+    return TRUE;
+}
@@ -291,9 +291,11 @@ winAllocateFBShadowDDNL(ScreenPtr pScreen)
              (unsigned int)pScreenInfo->dwHeight,
              (unsigned int)pScreenInfo->dwDepth);
 
-    /* Set the padded screen width */
-    pScreenInfo->dwPaddedWidth = PixmapBytePad(pScreenInfo->dwWidth,
-                                               pScreenInfo->dwBPP);
+    /* Set the padded screen width, each row whole cache lines */
+    pScreenInfo->dwPaddedWidth =
+        PixmapBytePad(winFBAlignWidth(pScreenInfo->dwWidth,
+                                      pScreenInfo->dwBPP),
+                      pScreenInfo->dwBPP);
 
     if ( pScreenInfo->pfb)
     {
@@ -310,18 +312,16 @@ winAllocateFBShadowDDNL(ScreenPtr pScreen)
     }
     else
     {
-        /* Allocate memory for our shadow surface */
-        lpSurface = malloc (pScreenInfo->dwPaddedWidth * pScreenInfo->dwHeight);
+        /*
+         * Allocate memory for our shadow surface, in large pages if we may,
+         * which comes zeroed so we don't get a strange display at startup
+         */
+        lpSurface = winAllocFBMemory(pScreenInfo->dwPaddedWidth
+                                     * pScreenInfo->dwHeight);
         if (lpSurface == NULL) {
             ErrorF ("winAllocateFBShadowDDNL - Could not allocate bits\n");
             return FALSE;
         }
-  
-        /*
-         * Initialize the framebuffer memory so we don't get a
-         * strange display at startup
-         */
-        ZeroMemory (lpSurface, pScreenInfo->dwPaddedWidth * pScreenInfo->dwHeight);
     }
     /* Create a clipper */
     ddrval = (*g_fpDirectDrawCreateClipper) (0,
@@ -566,7 +566,7 @@ winFreeFBShadowDDNL(ScreenPtr pScreen)
     /* Free the shadow surface, if there is one */
     if (pScreenPriv->pddsShadow4) {
         IDirectDrawSurface4_Release(pScreenPriv->pddsShadow4);
-        free(pScreenInfo->pfb);
+        winFreeFBMemory(pScreenInfo->pfb);
         pScreenInfo->pfb = NULL;
         pScreenPriv->pddsShadow4 = NULL;
     }
@@ -744,6 +744,10 @@ winCloseScreenShadowDDNL(ScreenPtr pScreen)
     /* Destroy the thread startup mutex */
     if (pScreenPriv->pmServerStarted) pthread_mutex_destroy (&pScreenPriv->pmServerStarted);
 
+    /* Free the frame pacing damage */
+    winFramePaceFini(pScreen);
+    winPresentFini(pScreen);
+
     /* Kill our screeninfo's pointer to the screen */
     pScreenInfo->pScreen = NULL;
 
@@ -1176,6 +1180,7 @@ winSetEngineFunctionsShadowDDNL(ScreenPtr pScreen)
     /* Set our pointers */
     pScreenPriv->pwinAllocateFB = winAllocateFBShadowDDNL;
     pScreenPriv->pwinFreeFB = winFreeFBShadowDDNL;
+    pScreenPriv->pwinResizeFB = NULL;
     pScreenPriv->pwinShadowUpdate = winShadowUpdateDDNL;
     pScreenPriv->pwinInitScreen = winInitScreenShadowDDNL;
     pScreenPriv->pwinCloseScreen = winCloseScreenShadowDDNL;
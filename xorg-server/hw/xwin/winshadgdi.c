@@ -40,11 +40,12 @@
 
 static wBOOL CALLBACK winRedrawAllProcShadowGDI(HWND hwnd, LPARAM lParam);
 
-static wBOOL CALLBACK winRedrawDamagedWindowShadowGDI(HWND hwnd, LPARAM lParam);
-
 static Bool
  winAllocateFBShadowGDI(ScreenPtr pScreen);
 
+static Bool
+ winResizeFBShadowGDI(ScreenPtr pScreen);
+
 static void
  winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf);
 
@@ -278,36 +279,40 @@ winRedrawAllProcShadowGDI(HWND hwnd, LPARAM lParam)
     return TRUE;
 }
 
-static wBOOL CALLBACK
-winRedrawDamagedWindowShadowGDI(HWND hwnd, LPARAM lParam)
+/*
+ * Create the shadow DIB described by pbmih, with its bits in a section of
+ * large pages when we may have them, so the hot fb loops and the update
+ * blits miss the TLB less.  The section, if one is used, is returned in
+ * phSection, to be closed once the bitmap is deleted.
+ */
+
+static HBITMAP
+winCreateShadowDIBGDI(ScreenPtr pScreen, HANDLE *phSection)
 {
-    BoxPtr pDamage = (BoxPtr) lParam;
-    RECT rcClient, rcDamage, rcRedraw;
-    POINT topLeft, bottomRight;
-
-    if (IsIconic(hwnd))
-        return TRUE;            /* Don't care minimized windows */
-
-    /* Convert the damaged area from Screen coords to Client coords */
-    topLeft.x = pDamage->x1;
-    topLeft.y = pDamage->y1;
-    bottomRight.x = pDamage->x2;
-    bottomRight.y = pDamage->y2;
-    topLeft.x += GetSystemMetrics(SM_XVIRTUALSCREEN);
-    bottomRight.x += GetSystemMetrics(SM_XVIRTUALSCREEN);
-    topLeft.y += GetSystemMetrics(SM_YVIRTUALSCREEN);
-    bottomRight.y += GetSystemMetrics(SM_YVIRTUALSCREEN);
-    ScreenToClient(hwnd, &topLeft);
-    ScreenToClient(hwnd, &bottomRight);
-    SetRect(&rcDamage, topLeft.x, topLeft.y, bottomRight.x, bottomRight.y);
-
-    GetClientRect(hwnd, &rcClient);
-
-    if (IntersectRect(&rcRedraw, &rcClient, &rcDamage)) {
-        InvalidateRect(hwnd, &rcRedraw, FALSE);
-        UpdateWindow(hwnd);
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    BITMAPINFOHEADER *pbmih = pScreenPriv->pbmih;
+    SIZE_T size = (SIZE_T) (((pbmih->biWidth * pbmih->biBitCount + 31) & ~31)
+                            / 8) * abs(pbmih->biHeight);
+    HBITMAP hbmp;
+
+    *phSection = winCreateFBSection(size);
+    if (*phSection) {
+        hbmp = CreateDIBSection(pScreenPriv->hdcScreen, (BITMAPINFO *) pbmih,
+                                DIB_RGB_COLORS, (VOID **) &pScreenInfo->pfb,
+                                *phSection, 0);
+        if (hbmp)
+            return hbmp;
+
+        winDebug("winCreateShadowDIBGDI - No DIB in large pages, "
+                 "using small ones\n");
+        CloseHandle(*phSection);
+        *phSection = NULL;
     }
-    return TRUE;
+
+    return CreateDIBSection(pScreenPriv->hdcScreen, (BITMAPINFO *) pbmih,
+                            DIB_RGB_COLORS, (VOID **) &pScreenInfo->pfb,
+                            NULL, 0);
 }
 
 /*
@@ -322,8 +327,9 @@ winAllocateFBShadowGDI(ScreenPtr pScreen)
     DIBSECTION dibsection;
     Bool fReturn = TRUE;
 
-    /* Describe shadow bitmap to be created */
-    pScreenPriv->pbmih->biWidth = pScreenInfo->dwWidth;
+    /* Describe shadow bitmap to be created, its rows whole cache lines */
+    pScreenPriv->pbmih->biWidth =
+        winFBAlignWidth(pScreenInfo->dwWidth, pScreenPriv->pbmih->biBitCount);
     pScreenPriv->pbmih->biHeight = -pScreenInfo->dwHeight;
 
     winDebug ("winAllocateFBShadowGDI - Creating DIB with width: %d height: %d "
@@ -332,11 +338,8 @@ winAllocateFBShadowGDI(ScreenPtr pScreen)
               (int) -pScreenPriv->pbmih->biHeight, pScreenPriv->pbmih->biBitCount);
 
     /* Create a DI shadow bitmap with a bit pointer */
-    pScreenPriv->hbmpShadow = CreateDIBSection(pScreenPriv->hdcScreen,
-                                               (BITMAPINFO *) pScreenPriv->
-                                               pbmih, DIB_RGB_COLORS,
-                                               (VOID **) &pScreenInfo->pfb,
-                                               NULL, 0);
+    pScreenPriv->hbmpShadow = winCreateShadowDIBGDI(pScreen,
+                                                    &pScreenPriv->hsectShadow);
     if (pScreenPriv->hbmpShadow == NULL || pScreenInfo->pfb == NULL) {
         winW32Error ("winAllocateFBShadowGDI - CreateDIBSection failed:");
         return FALSE;
@@ -403,11 +406,261 @@ winFreeFBShadowGDI(ScreenPtr pScreen)
 
     /* Free the shadow bitmap */
     DeleteObject(pScreenPriv->hbmpShadow);
+    if (pScreenPriv->hsectShadow) {
+        CloseHandle(pScreenPriv->hsectShadow);
+        pScreenPriv->hsectShadow = NULL;
+    }
 
     /* Invalidate the ScreenInfo's fb pointer */
     pScreenInfo->pfb = NULL;
 }
 
+/*
+ * Resize the shadow to the screen size in pScreenInfo, from the size of
+ * pScreen.  A shadow bitmap that is big enough is kept with its stride,
+ * one that is too small is replaced with a bigger one, rounded up so that
+ * growing a little more later doesn't replace it again.
+ */
+
+static Bool
+winResizeFBShadowGDI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    BITMAPINFOHEADER *pbmih = pScreenPriv->pbmih;
+    HBITMAP hbmpOld = pScreenPriv->hbmpShadow;
+    HANDLE hsectOld = pScreenPriv->hsectShadow;
+    char *pfbOld = pScreenInfo->pfb;
+    DWORD dwPitchOld = PixmapBytePad(pScreenInfo->dwStride,
+                                     pScreenInfo->dwBPP);
+    LONG lWidthOld = pbmih->biWidth;
+    LONG lHeightOld = -pbmih->biHeight;
+    DIBSECTION dibsection;
+
+    if ((LONG) pScreenInfo->dwWidth <= lWidthOld
+        && (LONG) pScreenInfo->dwHeight <= lHeightOld)
+        return TRUE;
+
+    pbmih->biWidth = winFBGrowSize(max((LONG) pScreenInfo->dwWidth,
+                                       lWidthOld));
+    pbmih->biHeight = -(LONG) winFBGrowSize(max((LONG) pScreenInfo->dwHeight,
+                                                lHeightOld));
+
+    winDebug("winResizeFBShadowGDI - Growing DIB to width: %d height: %d\n",
+             (int) pbmih->biWidth, (int) -pbmih->biHeight);
+
+    pScreenPriv->hbmpShadow = winCreateShadowDIBGDI(pScreen,
+                                                    &pScreenPriv->hsectShadow);
+    if (pScreenPriv->hbmpShadow == NULL || pScreenInfo->pfb == NULL) {
+        winW32Error("winResizeFBShadowGDI - CreateDIBSection failed:");
+        if (pScreenPriv->hbmpShadow)
+            DeleteObject(pScreenPriv->hbmpShadow);
+        if (pScreenPriv->hsectShadow)
+            CloseHandle(pScreenPriv->hsectShadow);
+        pScreenPriv->hbmpShadow = hbmpOld;
+        pScreenPriv->hsectShadow = hsectOld;
+        pScreenInfo->pfb = pfbOld;
+        return FALSE;
+    }
+
+    GetObject(pScreenPriv->hbmpShadow, sizeof(dibsection), &dibsection);
+    if (dibsection.dsBmih.biHeight < 0)
+        dibsection.dsBmih.biHeight = -dibsection.dsBmih.biHeight;
+    pScreenInfo->dwStride = ((dibsection.dsBmih.biSizeImage
+                              / dibsection.dsBmih.biHeight)
+                             * 8) / pScreenInfo->dwBPP;
+
+    /* Keep what is still on screen */
+    GdiFlush();
+    winCopyFBRows(pScreenInfo->pfb,
+                  PixmapBytePad(pScreenInfo->dwStride, pScreenInfo->dwBPP),
+                  pfbOld, dwPitchOld,
+                  min((DWORD) pScreen->width, pScreenInfo->dwWidth)
+                  * pScreenInfo->dwBPP / 8,
+                  min((DWORD) pScreen->height, pScreenInfo->dwHeight));
+
+    SelectObject(pScreenPriv->hdcShadow, pScreenPriv->hbmpShadow);
+    DeleteObject(hbmpOld);
+    if (hsectOld)
+        CloseHandle(hsectOld);
+
+    return TRUE;
+}
+
+/*
+ * Cost model used to pick how a shadow update is blitted, in rough
+ * nanoseconds.  A BitBlt call has a fixed overhead, each box of a clip
+ * region costs a little to build and install, and every pixel copied costs
+ * WIN_GDI_COST_PIXELS_SHIFT'th of a unit.  The measured time of each
+ * strategy is fed back into a per-strategy correction factor, so these only
+ * need to be in the right ballpark.
+ */
+#define WIN_GDI_COST_BLIT		2000
+#define WIN_GDI_COST_CLIPBOX		40
+#define WIN_GDI_COST_PIXELS_SHIFT	2
+
+/* Correction factors are fixed point with this many fractional bits */
+#define WIN_GDI_FACTOR_SHIFT		8
+#define WIN_GDI_FACTOR_ONE		(1 << WIN_GDI_FACTOR_SHIFT)
+
+/* Boxes we coalesce on the stack before falling back to malloc */
+#define WIN_GDI_COALESCE_STACK_BOXES	64
+
+enum {
+    WIN_GDI_UPDATE_BOXES,
+    WIN_GDI_UPDATE_CLIPPED,
+    WIN_GDI_UPDATE_FULL,
+    WIN_GDI_UPDATE_STRATEGIES
+};
+
+static int s_aiUpdateFactor[WIN_GDI_UPDATE_STRATEGIES] = {
+    WIN_GDI_FACTOR_ONE, WIN_GDI_FACTOR_ONE, WIN_GDI_FACTOR_ONE
+};
+
+static LONGLONG s_llPerfFrequency = 0;
+
+#define BOX_AREA(b) ((LONGLONG) ((b)->x2 - (b)->x1) * ((b)->y2 - (b)->y1))
+
+/*
+ * Merging two boxes saves one BitBlt and costs the pixels in their union
+ * that are not damaged; merge whenever that trade is a win.
+ */
+
+static Bool
+winCoalesceWorthShadowGDI(const BoxRec *pA, const BoxRec *pB, BoxPtr pUnion)
+{
+    LONGLONG llWaste;
+
+    pUnion->x1 = min(pA->x1, pB->x1);
+    pUnion->y1 = min(pA->y1, pB->y1);
+    pUnion->x2 = max(pA->x2, pB->x2);
+    pUnion->y2 = max(pA->y2, pB->y2);
+
+    /* Boxes in a region never overlap, so the waste is exact */
+    llWaste = BOX_AREA(pUnion) - BOX_AREA(pA) - BOX_AREA(pB);
+
+    return (llWaste >> WIN_GDI_COST_PIXELS_SHIFT) <= WIN_GDI_COST_BLIT;
+}
+
+/*
+ * Coalesce the y-x banded boxes of a damage region.
+ *
+ * Boxes of a band are merged left to right while that is cheaper than
+ * blitting them separately, and a box that lines up exactly with a box
+ * ending right above it is stacked onto that box.  Returns the number of
+ * boxes written to pBoxOut, which must have room for nBox boxes.
+ */
+
+#define WIN_GDI_COALESCE_LOOKBACK	32
+
+static int
+winCoalesceBoxesShadowGDI(const BoxRec *pBoxIn, int nBox, BoxPtr pBoxOut)
+{
+    int nOut = 0;
+    int iMergeFloor = 0;
+    int i, j;
+
+    for (i = 0; i < nBox; ++i) {
+        const BoxRec *pBox = &pBoxIn[i];
+        BoxRec boxUnion;
+        Bool fStacked = FALSE;
+
+        /* A new band never merges sideways with the previous one */
+        if (i == 0 || pBox->y1 != pBoxIn[i - 1].y1)
+            iMergeFloor = nOut;
+
+        /* Horizontal merge with the previous box of the same band */
+        if (nOut > iMergeFloor
+            && winCoalesceWorthShadowGDI(&pBoxOut[nOut - 1], pBox,
+                                         &boxUnion)) {
+            pBoxOut[nOut - 1] = boxUnion;
+            continue;
+        }
+
+        /* Vertical merge with a box of the same width ending right above */
+        for (j = nOut - 1; j >= 0 && j >= nOut - WIN_GDI_COALESCE_LOOKBACK;
+             --j) {
+            if (pBoxOut[j].y2 == pBox->y1
+                && pBoxOut[j].x1 == pBox->x1 && pBoxOut[j].x2 == pBox->x2) {
+                pBoxOut[j].y2 = pBox->y2;
+                fStacked = TRUE;
+                break;
+            }
+        }
+        if (fStacked) {
+            /*
+             * Later boxes of this band must not merge sideways across
+             * the stacked box, or the union would overlap it.
+             */
+            iMergeFloor = nOut;
+            continue;
+        }
+
+        pBoxOut[nOut++] = *pBox;
+    }
+
+    return nOut;
+}
+
+/*
+ * Install a GDI clip region built from every box, not just the extents,
+ * and do a single blit through it.
+ */
+
+static void
+winBltClippedShadowGDI(winPrivScreenPtr pScreenPriv, const BoxRec *pBox,
+                       int nBox, BoxPtr pBoxExtents)
+{
+    RGNDATA *prgnd;
+    RECT *prc;
+    HRGN hrgnCombined = NULL;
+    int i;
+
+    prgnd = malloc(sizeof(RGNDATAHEADER) + nBox * sizeof(RECT));
+    if (prgnd != NULL) {
+        prgnd->rdh.dwSize = sizeof(RGNDATAHEADER);
+        prgnd->rdh.iType = RDH_RECTANGLES;
+        prgnd->rdh.nCount = nBox;
+        prgnd->rdh.nRgnSize = nBox * sizeof(RECT);
+        SetRect(&prgnd->rdh.rcBound,
+                pBoxExtents->x1, pBoxExtents->y1,
+                pBoxExtents->x2, pBoxExtents->y2);
+
+        prc = (RECT *) prgnd->Buffer;
+        for (i = 0; i < nBox; ++i)
+            SetRect(&prc[i], pBox[i].x1, pBox[i].y1, pBox[i].x2, pBox[i].y2);
+
+        hrgnCombined = ExtCreateRegion(NULL,
+                                       sizeof(RGNDATAHEADER)
+                                       + nBox * sizeof(RECT), prgnd);
+        free(prgnd);
+    }
+
+    /* Fall back to the extents if we could not build the real region */
+    if (hrgnCombined == NULL)
+        hrgnCombined = CreateRectRgn(pBoxExtents->x1, pBoxExtents->y1,
+                                     pBoxExtents->x2, pBoxExtents->y2);
+
+    /* Install the GDI region as a clipping region */
+    SelectClipRgn(pScreenPriv->hdcScreen, hrgnCombined);
+    DeleteObject(hrgnCombined);
+    hrgnCombined = NULL;
+
+    /*
+     * Blit the shadow buffer to the screen,
+     * constrained to the clipping region.
+     */
+    BitBlt(pScreenPriv->hdcScreen,
+           pBoxExtents->x1, pBoxExtents->y1,
+           pBoxExtents->x2 - pBoxExtents->x1,
+           pBoxExtents->y2 - pBoxExtents->y1,
+           pScreenPriv->hdcShadow,
+           pBoxExtents->x1, pBoxExtents->y1, SRCCOPY);
+
+    /* Reset the clip region */
+    SelectClipRgn(pScreenPriv->hdcScreen, NULL);
+}
+
 /*
  * Blit the damaged regions of the shadow fb to the screen
  */
@@ -420,13 +673,21 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
     RegionPtr damage = DamageRegion(pBuf->pDamage);
     DWORD dwBox = RegionNumRects(damage);
     BoxPtr pBox = RegionRects(damage);
-    int x, y, w, h;
-    HRGN hrgnCombined = NULL;
+    BoxRec aboxStack[WIN_GDI_COALESCE_STACK_BOXES];
+    BoxPtr pBoxCoalesced = aboxStack;
+    int nCoalesced;
+    LONGLONG llDamageArea = 0, llCoalescedArea = 0, llFullArea;
+    LONGLONG allCost[WIN_GDI_UPDATE_STRATEGIES];
+    LARGE_INTEGER liStart, liEnd;
+    int iStrategy, i;
 
 #ifdef XWIN_UPDATESTATS
     static DWORD s_dwNonUnitRegions = 0;
     static DWORD s_dwTotalUpdates = 0;
     static DWORD s_dwTotalBoxes = 0;
+    static DWORD s_dwTotalCoalesced = 0;
+    static DWORD s_adwStrategy[WIN_GDI_UPDATE_STRATEGIES];
+    static LONGLONG s_llTotalWaste = 0;
 #endif
     BoxPtr pBoxExtents = RegionExtents(damage);
 
@@ -438,82 +699,153 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
         || pScreenPriv->fBadDepth)
         return;
 
-#ifdef XWIN_UPDATESTATS
-    ++s_dwTotalUpdates;
-    s_dwTotalBoxes += dwBox;
+    /* Redraw the multiwindow windows that overlap the damage */
+    if (pScreenInfo->fMultiWindow) {
+        winWindowIndexDamage(pScreen, damage);
+        return;
+    }
 
-    if (dwBox != 1) {
-        ++s_dwNonUnitRegions;
-        winDebug ("winShadowUpdatGDI - dwBox: %d\n", dwBox);
+    if (dwBox == 0)
+        return;
+
+    /* Coalesce the damage before deciding how to blit it */
+    if (dwBox > WIN_GDI_COALESCE_STACK_BOXES)
+        pBoxCoalesced = malloc(dwBox * sizeof(BoxRec));
+    if (pBoxCoalesced != NULL) {
+        nCoalesced = winCoalesceBoxesShadowGDI(pBox, dwBox, pBoxCoalesced);
+    }
+    else {
+        /* Can't coalesce, blit the boxes as they are */
+        pBoxCoalesced = pBox;
+        nCoalesced = dwBox;
     }
 
-    if ((s_dwTotalUpdates % 100) == 0)
-        winDebug ("winShadowUpdateGDI - %d%% non-unity regions, avg boxes: %d "
-                  "nu: %d tu: %d\n",
-                  (s_dwNonUnitRegions * 100) / s_dwTotalUpdates,
-                  s_dwTotalBoxes / s_dwTotalUpdates,
-                  s_dwNonUnitRegions, s_dwTotalUpdates);
-  }
-#endif                          /* XWIN_UPDATESTATS */
+    for (i = 0; i < (int) dwBox; ++i)
+        llDamageArea += BOX_AREA(&pBox[i]);
+    for (i = 0; i < nCoalesced; ++i)
+        llCoalescedArea += BOX_AREA(&pBoxCoalesced[i]);
+    llFullArea = (LONGLONG) pScreenInfo->dwWidth * pScreenInfo->dwHeight;
+
+    /* Predict what each way of getting the damage on screen would cost */
+    allCost[WIN_GDI_UPDATE_BOXES] = (LONGLONG) nCoalesced * WIN_GDI_COST_BLIT
+        + (llCoalescedArea >> WIN_GDI_COST_PIXELS_SHIFT);
+    allCost[WIN_GDI_UPDATE_CLIPPED] = WIN_GDI_COST_BLIT
+        + (LONGLONG) dwBox * WIN_GDI_COST_CLIPBOX
+        + (llDamageArea >> WIN_GDI_COST_PIXELS_SHIFT);
+    allCost[WIN_GDI_UPDATE_FULL] = WIN_GDI_COST_BLIT
+        + (llFullArea >> WIN_GDI_COST_PIXELS_SHIFT);
 
     /*
-     * Handle small regions with multiple blits,
-     * handle large regions by creating a clipping region and
-     * doing a single blit constrained to that clipping region.
+     * -clipupdates keeps its meaning as a fixed threshold between
+     * per-box blits and a clipped blit; otherwise pick the cheapest.
      */
-    if (!pScreenInfo->fMultiWindow &&
-        (pScreenInfo->dwClipUpdatesNBoxes == 0 ||
-         dwBox < pScreenInfo->dwClipUpdatesNBoxes)) {
-        /* Loop through all boxes in the damaged region */
-        while (dwBox--) {
-            /*
-             * Calculate x offset, y offset, width, and height for
-             * current damage box
-             */
-            x = pBox->x1;
-            y = pBox->y1;
-            w = pBox->x2 - pBox->x1;
-            h = pBox->y2 - pBox->y1;
+    if (pScreenInfo->dwClipUpdatesNBoxes != 0) {
+        iStrategy = (dwBox < pScreenInfo->dwClipUpdatesNBoxes)
+            ? WIN_GDI_UPDATE_BOXES : WIN_GDI_UPDATE_CLIPPED;
+    }
+    else {
+        iStrategy = WIN_GDI_UPDATE_BOXES;
+        for (i = 1; i < WIN_GDI_UPDATE_STRATEGIES; ++i) {
+            if (allCost[i] * s_aiUpdateFactor[i]
+                < allCost[iStrategy] * s_aiUpdateFactor[iStrategy])
+                iStrategy = i;
+        }
+    }
 
-            BitBlt(pScreenPriv->hdcScreen,
-                   x, y, w, h, pScreenPriv->hdcShadow, x, y, SRCCOPY);
+    if (s_llPerfFrequency == 0) {
+        LARGE_INTEGER liFrequency;
 
-            /* Get a pointer to the next box */
-            ++pBox;
-        }
+        if (QueryPerformanceFrequency(&liFrequency))
+            s_llPerfFrequency = liFrequency.QuadPart;
+        else
+            s_llPerfFrequency = -1;
     }
-    else if (!pScreenInfo->fMultiWindow) {
+    QueryPerformanceCounter(&liStart);
 
-        /* Compute a GDI region from the damaged region */
-        hrgnCombined =
-            CreateRectRgn(pBoxExtents->x1, pBoxExtents->y1, pBoxExtents->x2,
-                          pBoxExtents->y2);
+    switch (iStrategy) {
+    case WIN_GDI_UPDATE_BOXES:
+        /* Loop through all coalesced boxes */
+        for (i = 0; i < nCoalesced; ++i) {
+            BoxPtr pBoxBlt = &pBoxCoalesced[i];
 
-        /* Install the GDI region as a clipping region */
-        SelectClipRgn(pScreenPriv->hdcScreen, hrgnCombined);
-        DeleteObject(hrgnCombined);
-        hrgnCombined = NULL;
+            BitBlt(pScreenPriv->hdcScreen,
+                   pBoxBlt->x1, pBoxBlt->y1,
+                   pBoxBlt->x2 - pBoxBlt->x1, pBoxBlt->y2 - pBoxBlt->y1,
+                   pScreenPriv->hdcShadow, pBoxBlt->x1, pBoxBlt->y1, SRCCOPY);
+        }
+        break;
 
-        /*
-         * Blit the shadow buffer to the screen,
-         * constrained to the clipping region.
-         */
+    case WIN_GDI_UPDATE_CLIPPED:
+        winBltClippedShadowGDI(pScreenPriv, pBox, dwBox, pBoxExtents);
+        break;
+
+    case WIN_GDI_UPDATE_FULL:
         BitBlt(pScreenPriv->hdcScreen,
-               pBoxExtents->x1, pBoxExtents->y1,
-               pBoxExtents->x2 - pBoxExtents->x1,
-               pBoxExtents->y2 - pBoxExtents->y1,
-               pScreenPriv->hdcShadow,
-               pBoxExtents->x1, pBoxExtents->y1, SRCCOPY);
-
-        /* Reset the clip region */
-        SelectClipRgn(pScreenPriv->hdcScreen, NULL);
+               0, 0, pScreenInfo->dwWidth, pScreenInfo->dwHeight,
+               pScreenPriv->hdcShadow, 0, 0, SRCCOPY);
+        break;
     }
 
-    /* Redraw all multiwindow windows */
-    if (pScreenInfo->fMultiWindow)
-        EnumThreadWindows(g_dwCurrentThreadID,
-                          winRedrawDamagedWindowShadowGDI,
-                          (LPARAM) pBoxExtents);
+    /*
+     * Fold the ratio of measured to predicted cost into the strategy's
+     * correction factor with a 1/8 weight.  GDI batches blits, so this
+     * times only what it did before returning; flushing to time all of it
+     * would stall every update, which is only worth it for the stats.
+     */
+#ifdef XWIN_UPDATESTATS
+    GdiFlush();
+#endif
+    QueryPerformanceCounter(&liEnd);
+    if (s_llPerfFrequency > 0 && allCost[iStrategy] > 0) {
+        LONGLONG llMeasured = (liEnd.QuadPart - liStart.QuadPart)
+            * 1000000000 / s_llPerfFrequency;
+        LONGLONG llRatio = (llMeasured << WIN_GDI_FACTOR_SHIFT)
+            / allCost[iStrategy];
+
+        /* Keep the factors within sane bounds so one hiccup can't stick */
+        llRatio = max(llRatio, WIN_GDI_FACTOR_ONE / 16);
+        llRatio = min(llRatio, WIN_GDI_FACTOR_ONE * 16);
+        s_aiUpdateFactor[iStrategy] += (int) ((llRatio
+                                               - s_aiUpdateFactor[iStrategy])
+                                              / 8);
+    }
+
+#ifdef XWIN_UPDATESTATS
+    ++s_dwTotalUpdates;
+    s_dwTotalBoxes += dwBox;
+    s_dwTotalCoalesced += nCoalesced;
+    s_llTotalWaste += llCoalescedArea - llDamageArea;
+    ++s_adwStrategy[iStrategy];
+
+    if (dwBox != 1) {
+        ++s_dwNonUnitRegions;
+        winDebug ("winShadowUpdateGDI - dwBox: %d coalesced: %d\n",
+                  (int) dwBox, nCoalesced);
+    }
+
+    if ((s_dwTotalUpdates % 100) == 0) {
+        winDebug ("winShadowUpdateGDI - %d%% non-unity regions, avg boxes: %d "
+                  "nu: %d tu: %d\n",
+                  (int) ((s_dwNonUnitRegions * 100) / s_dwTotalUpdates),
+                  (int) (s_dwTotalBoxes / s_dwTotalUpdates),
+                  (int) s_dwNonUnitRegions, (int) s_dwTotalUpdates);
+        winDebug ("winShadowUpdateGDI - avg coalesced boxes: %d, avg wasted "
+                  "pixels: %d, boxes/clipped/full: %d/%d/%d, factors "
+                  "%d/%d/%d (x1/%d)\n",
+                  (int) (s_dwTotalCoalesced / s_dwTotalUpdates),
+                  (int) (s_llTotalWaste / s_dwTotalUpdates),
+                  (int) s_adwStrategy[WIN_GDI_UPDATE_BOXES],
+                  (int) s_adwStrategy[WIN_GDI_UPDATE_CLIPPED],
+                  (int) s_adwStrategy[WIN_GDI_UPDATE_FULL],
+                  s_aiUpdateFactor[WIN_GDI_UPDATE_BOXES],
+                  s_aiUpdateFactor[WIN_GDI_UPDATE_CLIPPED],
+                  s_aiUpdateFactor[WIN_GDI_UPDATE_FULL],
+                  WIN_GDI_FACTOR_ONE);
+    }
+#endif                          /* XWIN_UPDATESTATS */
+
+    if (pBoxCoalesced != aboxStack && pBoxCoalesced != pBox)
+        free(pBoxCoalesced);
 }
 
 static Bool
@@ -601,6 +933,13 @@ winCloseScreenShadowGDI(ScreenPtr pScreen)
     /* Destroy the thread startup mutex */
     if (pScreenPriv->pmServerStarted) pthread_mutex_destroy (&pScreenPriv->pmServerStarted);
 
+    /* Free the multiwindow damage index */
+    winWindowIndexFree(pScreen);
+
+    /* Free the frame pacing damage */
+    winFramePaceFini(pScreen);
+    winPresentFini(pScreen);
+
     /* Invalidate our screeninfo's pointer to the screen */
     pScreenInfo->pScreen = NULL;
 
@@ -743,12 +1082,17 @@ winBltExposedRegionsShadowGDI(ScreenPtr pScreen)
         return 0;
     }
 
-    /* Realize the palette, if we have one */
+    /* Realize the palette, if we have one.  BeginPaint hands out a fresh
+       DC, so the palette has to be selected every time, but realizing it
+       again only matters once it or the system palette has changed. */
     if (pScreenPriv->pcmapInstalled != NULL) {
         pCmapPriv = winGetCmapPriv(pScreenPriv->pcmapInstalled);
 
         SelectPalette(hdcUpdate, pCmapPriv->hPalette, FALSE);
-        RealizePalette(hdcUpdate);
+        if (pScreenPriv->hpalPainted != pCmapPriv->hPalette) {
+            RealizePalette(hdcUpdate);
+            pScreenPriv->hpalPainted = pCmapPriv->hPalette;
+        }
     }
 
     /* Our BitBlt will be clipped to the invalidated region */
@@ -830,10 +1174,21 @@ winBltExposedWindowRegionShadowGDI(ScreenPtr pScreen, WindowPtr pWin)
          */
 
         BITMAPV4HEADER bmih;
+        /* Only convert the rows being painted, not the whole pixmap */
+        int yTop = ps.rcPaint.top + pWin->borderWidth;
+        int yBottom = min(ps.rcPaint.bottom + pWin->borderWidth,
+                          pPixmap->drawable.height);
+
+        if (yTop < 0)
+            yTop = 0;
+        if (yBottom <= yTop)
+            goto paintdone;
+
+        fbBudgetTouch(pPixmap);
         memset(&bmih, 0, sizeof(bmih));
         bmih.bV4Size = sizeof(BITMAPV4HEADER);
         bmih.bV4Width = pPixmap->drawable.width;
-        bmih.bV4Height = -pPixmap->drawable.height; /* top-down bitmap */
+        bmih.bV4Height = -(yBottom - yTop); /* top-down bitmap */
         bmih.bV4Planes = 1;
         bmih.bV4BitCount = pPixmap->drawable.bitsPerPixel;
         bmih.bV4SizeImage = 0;
@@ -848,8 +1203,9 @@ winBltExposedWindowRegionShadowGDI(ScreenPtr pScreen, WindowPtr pWin)
         /* Create the window bitmap from the pixmap */
         hBitmap = CreateDIBitmap(pScreenPriv->hdcScreen,
                                  (BITMAPINFOHEADER *)&bmih, CBM_INIT,
-                                 pPixmap->devPrivate.ptr, (BITMAPINFO *)&bmih,
-                                 DIB_RGB_COLORS);
+                                 (char *) pPixmap->devPrivate.ptr +
+                                 yTop * pPixmap->devKind,
+                                 (BITMAPINFO *)&bmih, DIB_RGB_COLORS);
 
         /* Select the window bitmap into a screen-compatible DC */
         hdcPixmap = CreateCompatibleDC(pScreenPriv->hdcScreen);
@@ -862,7 +1218,7 @@ winBltExposedWindowRegionShadowGDI(ScreenPtr pScreen, WindowPtr pWin)
                     ps.rcPaint.bottom - ps.rcPaint.top,
                     hdcPixmap,
                     ps.rcPaint.left + pWin->borderWidth,
-                    ps.rcPaint.top + pWin->borderWidth,
+                    ps.rcPaint.top + pWin->borderWidth - yTop,
                     SRCCOPY))
             ErrorF("winBltExposedWindowRegionShadowGDI - BitBlt failed: %08x\n",
                    (unsigned int)GetLastError());
@@ -870,6 +1226,8 @@ winBltExposedWindowRegionShadowGDI(ScreenPtr pScreen, WindowPtr pWin)
         /* Release */
         DeleteDC(hdcPixmap);
         DeleteObject(hBitmap);
+    paintdone:
+        ;
     }
     else
 #endif
@@ -1017,6 +1375,9 @@ winRealizeInstalledPaletteShadowGDI(ScreenPtr pScreen)
 
     pCmapPriv = winGetCmapPriv(pScreenPriv->pcmapInstalled);
 
+    /* The system palette changed, so WM_PAINT must realize ours again */
+    pScreenPriv->hpalPainted = NULL;
+
     /* Realize our palette for the screen */
     if (RealizePalette(pScreenPriv->hdcScreen) == GDI_ERROR) {
         ErrorF("winRealizeInstalledPaletteShadowGDI - RealizePalette () "
@@ -1050,6 +1411,9 @@ winInstallColormapShadowGDI(ColormapPtr pColormap)
 
     winCmapPriv(pColormap);
 
+    /* WM_PAINT must realize the palette again, its colors have changed */
+    pScreenPriv->hpalPainted = NULL;
+
     /*
      * Tell Windows to install the new colormap
      */
@@ -1101,11 +1465,26 @@ winStoreColorsShadowGDI(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
     winScreenPriv(pScreen);
     winCmapPriv(pColormap);
     ColormapPtr curpmap = pScreenPriv->pcmapInstalled;
+    Pixel pixelMin, pixelMax;
+    int i;
+
+    if (ndef <= 0)
+        return TRUE;
+
+    /* The entries need not be in order, nor adjacent; the palette entry
+       table has them all, so put the span they cover in at once */
+    pixelMin = pixelMax = pdefs[0].pixel;
+    for (i = 1; i < ndef; i++) {
+        if (pdefs[i].pixel < pixelMin)
+            pixelMin = pdefs[i].pixel;
+        if (pdefs[i].pixel > pixelMax)
+            pixelMax = pdefs[i].pixel;
+    }
 
     /* Put the X colormap entries into the Windows logical palette */
     if (SetPaletteEntries(pCmapPriv->hPalette,
-                          pdefs[0].pixel,
-                          ndef, pCmapPriv->peColors + pdefs[0].pixel) == 0) {
+                          pixelMin, pixelMax - pixelMin + 1,
+                          pCmapPriv->peColors + pixelMin) == 0) {
         ErrorF("winStoreColorsShadowGDI - SetPaletteEntries () failed\n");
         return FALSE;
     }
@@ -1115,12 +1494,9 @@ winStoreColorsShadowGDI(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
         return TRUE;
     }
 
-    /* Try to install the newly modified colormap */
-    if (!winInstallColormapShadowGDI(pColormap)) {
-        ErrorF("winInstallColormapShadowGDI - winInstallColormapShadowGDI "
-               "failed\n");
-        return FALSE;
-    }
+    /* Install the modified colormap from the block handler, once for all
+       the colors stored until then */
+    pScreenPriv->fColormapDirty = TRUE;
 
 #if 0
     /* Tell Windows that the palette has changed */
@@ -1255,6 +1631,7 @@ winSetEngineFunctionsShadowGDI(ScreenPtr pScreen)
     /* Set our pointers */
     pScreenPriv->pwinAllocateFB = winAllocateFBShadowGDI;
     pScreenPriv->pwinFreeFB = winFreeFBShadowGDI;
+    pScreenPriv->pwinResizeFB = winResizeFBShadowGDI;
     pScreenPriv->pwinShadowUpdate = winShadowUpdateGDI;
     pScreenPriv->pwinInitScreen = winInitScreenShadowGDI;
     pScreenPriv->pwinCloseScreen = winCloseScreenShadowGDI;
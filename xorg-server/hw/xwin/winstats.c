@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Live statistics window
+ *
+ * A few counters are kept all the time, as they cost next to nothing:
+ * shadow updates with the time spent in them and the damage boxes they
+ * were given, requests dispatched, GLX buffer swaps, clipboard bytes
+ * converted and input messages with the time they waited in the Windows
+ * queue.  The "Show Statistics" tray menu item opens a small topmost
+ * window which samples them once a second and shows the rates, so a
+ * sluggish session can be looked at while it happens.
+ *
+ * The window belongs to the server thread, like the tray icon, so only
+ * the clipboard thread's byte count needs interlocked access.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "dixstruct.h"
+#include "winclipboard/winclipboard.h"
+#include "frametrace.h"
+
+#define WINDOW_CLASS_X_STATS "vcxsrv/x X statistics"
+
+#define WIN_STATS_TIMER_ID	1
+#define WIN_STATS_PERIOD	1000
+
+winStatsRec g_winStats;
+
+static HWND s_hwndStats;
+
+static LARGE_INTEGER s_liStatsFrequency;
+
+/* Counters as of the last sample, and the text made from them */
+static LARGE_INTEGER s_liStatsLast;
+static winStatsRec s_statsLast;
+static CARD64 s_ullRequestsLast;
+static LONG64 s_llClipboardLast;
+#ifdef XSERVER_INPUT_LATENCY
+static CARD64 s_ullLatencyCountLast, s_ullLatencyTotalLast;
+#endif
+static char s_szStats[512];
+
+/*
+ * winShadowUpdateCounted - Run the engine's shadow update, counting its
+ * time and the damage boxes it was handed
+ */
+
+void
+winShadowUpdateCounted(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    winScreenPriv(pScreen);
+    LARGE_INTEGER liStart, liEnd;
+
+    g_winStats.llShadowBoxes += RegionNumRects(DamageRegion(pBuf->pDamage));
+
+    FRAME_TRACE_BEGIN("Blit");
+    QueryPerformanceCounter(&liStart);
+    (*pScreenPriv->pwinShadowUpdate) (pScreen, pBuf);
+    QueryPerformanceCounter(&liEnd);
+    FRAME_TRACE_END("Blit");
+
+    g_winStats.llShadowUpdates++;
+    g_winStats.llShadowTicks += liEnd.QuadPart - liStart.QuadPart;
+}
+
+/* Per second rate of a counter over llTicks */
+static double
+winStatsRate(LONG64 llDelta, LONG64 llTicks)
+{
+    return (double) llDelta * s_liStatsFrequency.QuadPart / llTicks;
+}
+
+static void
+winStatsSample(void)
+{
+    LARGE_INTEGER liNow;
+    winStatsRec stats = g_winStats;
+    LONG64 llTicks, llUpdates, llInput;
+    LONG64 llClipboard;
+    CARD64 ullRequests = RequestsDispatched;
+    char *psz = s_szStats;
+    size_t left = sizeof(s_szStats);
+    int n;
+
+    QueryPerformanceCounter(&liNow);
+    llTicks = liNow.QuadPart - s_liStatsLast.QuadPart;
+    if (llTicks <= 0)
+        return;
+
+    llClipboard = InterlockedExchangeAdd64(&g_llClipboardBytes, 0);
+
+    llUpdates = stats.llShadowUpdates - s_statsLast.llShadowUpdates;
+    llInput = stats.llInputEvents - s_statsLast.llInputEvents;
+
+    n = snprintf(psz, left,
+                 "Shadow updates: %.0f/s, %.2f ms, %.1f boxes each\n",
+                 winStatsRate(llUpdates, llTicks),
+                 llUpdates ? (double) (stats.llShadowTicks -
+                                       s_statsLast.llShadowTicks) * 1000 /
+                 s_liStatsFrequency.QuadPart / llUpdates : 0.0,
+                 llUpdates ? (double) (stats.llShadowBoxes -
+                                       s_statsLast.llShadowBoxes) /
+                 llUpdates : 0.0);
+    psz += n;
+    left -= n;
+
+    n = snprintf(psz, left, "Requests: %.0f/s\nGLX swaps: %.1f/s\n",
+                 winStatsRate(ullRequests - s_ullRequestsLast, llTicks),
+                 winStatsRate(stats.llSwaps - s_statsLast.llSwaps, llTicks));
+    psz += n;
+    left -= n;
+
+    n = snprintf(psz, left, "Clipboard: %.1f KB/s\n",
+                 winStatsRate(llClipboard - s_llClipboardLast, llTicks) / 1024);
+    psz += n;
+    left -= n;
+
+    n = snprintf(psz, left, "Input: %.0f/s, %.1f ms in Windows queue\n",
+                 winStatsRate(llInput, llTicks),
+                 llInput ? (double) (stats.llInputQueuedMillis -
+                                     s_statsLast.llInputQueuedMillis) /
+                 llInput : 0.0);
+    psz += n;
+    left -= n;
+
+#ifdef XSERVER_INPUT_LATENCY
+    {
+        CARD64 ullCount, ullTotal;
+
+        InputLatencyTotal(&ullCount, &ullTotal);
+        if (ullCount > s_ullLatencyCountLast)
+            snprintf(psz, left, "Input to socket: %.2f ms\n",
+                     (double) (ullTotal - s_ullLatencyTotalLast) / 1000 /
+                     (ullCount - s_ullLatencyCountLast));
+        s_ullLatencyCountLast = ullCount;
+        s_ullLatencyTotalLast = ullTotal;
+    }
+#endif
+
+    s_liStatsLast = liNow;
+    s_statsLast = stats;
+    s_ullRequestsLast = ullRequests;
+    s_llClipboardLast = llClipboard;
+}
+
+static LRESULT CALLBACK
+winStatsWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message) {
+    case WM_TIMER:
+        winStatsSample();
+        InvalidateRect(hwnd, NULL, TRUE);
+        return 0;
+
+    case WM_PAINT:
+    {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(hwnd, &ps);
+        HGDIOBJ hOldFont = SelectObject(hdc, GetStockObject(DEFAULT_GUI_FONT));
+        RECT rc;
+
+        GetClientRect(hwnd, &rc);
+        InflateRect(&rc, -4, -4);
+        SetBkMode(hdc, TRANSPARENT);
+        DrawText(hdc, s_szStats, -1, &rc, DT_LEFT | DT_NOPREFIX);
+        SelectObject(hdc, hOldFont);
+        EndPaint(hwnd, &ps);
+        return 0;
+    }
+
+    case WM_CLOSE:
+        DestroyWindow(hwnd);
+        return 0;
+
+    case WM_DESTROY:
+        KillTimer(hwnd, WIN_STATS_TIMER_ID);
+        s_hwndStats = NULL;
+        return 0;
+    }
+
+    return DefWindowProc(hwnd, message, wParam, lParam);
+}
+
+/*
+ * winStatsWindowShown - Whether the statistics window is open
+ */
+
+Bool
+winStatsWindowShown(void)
+{
+    return s_hwndStats != NULL;
+}
+
+/*
+ * winToggleStatsWindow - Open the statistics window, or close it if it's
+ * open already
+ */
+
+void
+winToggleStatsWindow(void)
+{
+    static Bool fRegistered = FALSE;
+
+    if (s_hwndStats) {
+        DestroyWindow(s_hwndStats);
+        return;
+    }
+
+    if (!fRegistered) {
+        WNDCLASSEX wcx;
+
+        wcx.cbSize = sizeof(WNDCLASSEX);
+        wcx.style = CS_HREDRAW | CS_VREDRAW;
+        wcx.lpfnWndProc = winStatsWindowProc;
+        wcx.cbClsExtra = 0;
+        wcx.cbWndExtra = 0;
+        wcx.hInstance = g_hInstance;
+        wcx.hIcon = g_hIconX;
+        wcx.hCursor = LoadCursor(NULL, IDC_ARROW);
+        wcx.hbrBackground = (HBRUSH) (COLOR_WINDOW + 1);
+        wcx.lpszMenuName = NULL;
+        wcx.lpszClassName = WINDOW_CLASS_X_STATS;
+        wcx.hIconSm = g_hSmallIconX;
+        if (!RegisterClassEx(&wcx)) {
+            ErrorF("winToggleStatsWindow - RegisterClassEx failed\n");
+            return;
+        }
+        fRegistered = TRUE;
+    }
+
+    QueryPerformanceFrequency(&s_liStatsFrequency);
+    QueryPerformanceCounter(&s_liStatsLast);
+    s_statsLast = g_winStats;
+    s_ullRequestsLast = RequestsDispatched;
+    s_llClipboardLast = InterlockedExchangeAdd64(&g_llClipboardBytes, 0);
+#ifdef XSERVER_INPUT_LATENCY
+    InputLatencyTotal(&s_ullLatencyCountLast, &s_ullLatencyTotalLast);
+#endif
+    snprintf(s_szStats, sizeof(s_szStats), "Collecting...");
+
+    s_hwndStats = CreateWindowEx(WS_EX_TOOLWINDOW | WS_EX_TOPMOST,
+                                 WINDOW_CLASS_X_STATS,
+                                 PROJECT_NAME " Statistics",
+                                 WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU,
+                                 CW_USEDEFAULT, CW_USEDEFAULT, 320, 150,
+                                 NULL, NULL, g_hInstance, NULL);
+    if (!s_hwndStats) {
+        ErrorF("winToggleStatsWindow - CreateWindowEx failed\n");
+        return;
+    }
+
+    SetTimer(s_hwndStats, WIN_STATS_TIMER_ID, WIN_STATS_PERIOD, NULL);
+    ShowWindow(s_hwndStats, SW_SHOWNOACTIVATE);
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sync fences backed by Windows event objects
+ *
+ * Every fence of the screen has a manual-reset event, set while the fence
+ * is triggered.  Code running on another thread, or a Windows API which
+ * completes asynchronously, can be handed the event from
+ * winSyncFenceEvent() and set it, rather than having the server thread
+ * find out some other way and trigger the fence itself.  Fences somebody
+ * is waiting on are watched from the block handler, which triggers them on
+ * the server thread once their event is set, so the waiting clients are
+ * woken then.  Going the other way, a thread can wait for a fence a client
+ * triggers with WaitForSingleObject().
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "misync.h"
+#include "misyncstr.h"
+#include "list.h"
+
+static DevPrivateKeyRec winSyncFencePrivateKey;
+
+typedef struct _winSyncFencePriv {
+    SyncFence *pFence;
+    HANDLE hEvent;
+    int nTriggers;
+    struct xorg_list entry;     /* in s_fencesWatched while nTriggers > 0 */
+} winSyncFencePrivRec, *winSyncFencePrivPtr;
+
+#define WIN_SYNC_FENCE_PRIV(pFence) \
+    ((winSyncFencePrivPtr) dixLookupPrivate(&(pFence)->devPrivates, \
+                                            &winSyncFencePrivateKey))
+
+/* Fences with a trigger waiting on them, of every screen */
+static struct xorg_list s_fencesWatched;
+
+static void
+winSyncFenceSetTriggered(SyncFence * pFence)
+{
+    winSyncFencePrivPtr pPriv = WIN_SYNC_FENCE_PRIV(pFence);
+
+    if (pPriv->hEvent)
+        SetEvent(pPriv->hEvent);
+    miSyncFenceSetTriggered(pFence);
+}
+
+static void
+winSyncFenceReset(SyncFence * pFence)
+{
+    winSyncFencePrivPtr pPriv = WIN_SYNC_FENCE_PRIV(pFence);
+
+    if (pPriv->hEvent)
+        ResetEvent(pPriv->hEvent);
+    miSyncFenceReset(pFence);
+}
+
+static Bool
+winSyncFenceCheckTriggered(SyncFence * pFence)
+{
+    winSyncFencePrivPtr pPriv = WIN_SYNC_FENCE_PRIV(pFence);
+
+    /* The event may have been set behind our back */
+    if (!pFence->triggered && pPriv->hEvent &&
+        WaitForSingleObject(pPriv->hEvent, 0) == WAIT_OBJECT_0)
+        pFence->triggered = TRUE;
+
+    return miSyncFenceCheckTriggered(pFence);
+}
+
+static void
+winSyncFenceAddTrigger(SyncTrigger * pTrigger)
+{
+    SyncFence *pFence = (SyncFence *) pTrigger->pSync;
+    winSyncFencePrivPtr pPriv = WIN_SYNC_FENCE_PRIV(pFence);
+
+    if (pPriv->nTriggers++ == 0)
+        xorg_list_append(&pPriv->entry, &s_fencesWatched);
+    miSyncFenceAddTrigger(pTrigger);
+}
+
+static void
+winSyncFenceDeleteTrigger(SyncTrigger * pTrigger)
+{
+    SyncFence *pFence = (SyncFence *) pTrigger->pSync;
+    winSyncFencePrivPtr pPriv = WIN_SYNC_FENCE_PRIV(pFence);
+
+    if (pPriv->nTriggers > 0 && --pPriv->nTriggers == 0)
+        xorg_list_del(&pPriv->entry);
+    miSyncFenceDeleteTrigger(pTrigger);
+}
+
+static const SyncFenceFuncsRec winSyncFenceFuncs = {
+    &winSyncFenceSetTriggered,
+    &winSyncFenceReset,
+    &winSyncFenceCheckTriggered,
+    &winSyncFenceAddTrigger,
+    &winSyncFenceDeleteTrigger
+};
+
+static void
+winSyncScreenCreateFence(ScreenPtr pScreen, SyncFence * pFence,
+                         Bool initially_triggered)
+{
+    winSyncFencePrivPtr pPriv = WIN_SYNC_FENCE_PRIV(pFence);
+
+    /* Without an event the fence still works, only not from other threads */
+    pPriv->hEvent = CreateEvent(NULL, TRUE, initially_triggered, NULL);
+    if (pPriv->hEvent == NULL)
+        ErrorF("winSyncScreenCreateFence - CreateEvent failed: %08x\n",
+               (unsigned int) GetLastError());
+    pPriv->pFence = pFence;
+    pPriv->nTriggers = 0;
+    xorg_list_init(&pPriv->entry);
+
+    miSyncScreenCreateFence(pScreen, pFence, initially_triggered);
+    pFence->funcs = winSyncFenceFuncs;
+}
+
+static void
+winSyncScreenDestroyFence(ScreenPtr pScreen, SyncFence * pFence)
+{
+    winSyncFencePrivPtr pPriv = WIN_SYNC_FENCE_PRIV(pFence);
+
+    xorg_list_del(&pPriv->entry);
+    if (pPriv->hEvent) {
+        /* Let go of any thread still waiting for it */
+        SetEvent(pPriv->hEvent);
+        CloseHandle(pPriv->hEvent);
+        pPriv->hEvent = NULL;
+    }
+    miSyncScreenDestroyFence(pScreen, pFence);
+}
+
+/*
+ * winSyncFenceEvent - The event which triggers the fence when set, or NULL
+ *
+ * The handle belongs to the fence and is closed with it, so whoever sets
+ * it from another thread must be done with it before the fence is
+ * destroyed.
+ */
+
+HANDLE
+winSyncFenceEvent(SyncFence * pFence)
+{
+    if (pFence->funcs.SetTriggered != winSyncFenceSetTriggered)
+        return NULL;
+
+    return WIN_SYNC_FENCE_PRIV(pFence)->hEvent;
+}
+
+/*
+ * winSyncInit - Back the screen's Sync fences with event objects
+ */
+
+Bool
+winSyncInit(ScreenPtr pScreen)
+{
+    SyncScreenFuncsPtr funcs;
+
+    if (!miSyncSetup(pScreen))
+        return FALSE;
+
+    if (!dixPrivateKeyRegistered(&winSyncFencePrivateKey)) {
+        if (!dixRegisterPrivateKey(&winSyncFencePrivateKey,
+                                   PRIVATE_SYNC_FENCE,
+                                   sizeof(winSyncFencePrivRec)))
+            return FALSE;
+        xorg_list_init(&s_fencesWatched);
+    }
+
+    funcs = miSyncGetScreenFuncs(pScreen);
+    funcs->CreateFence = winSyncScreenCreateFence;
+    funcs->DestroyFence = winSyncScreenDestroyFence;
+
+    return TRUE;
+}
+
+/*
+ * winSyncBlockHandler - Trigger the watched fences of the screen whose
+ * event has been set
+ */
+
+void
+winSyncBlockHandler(ScreenPtr pScreen, void *pTimeout)
+{
+    winSyncFencePrivPtr pPriv;
+
+    if (!dixPrivateKeyRegistered(&winSyncFencePrivateKey))
+        return;
+
+    /* Nothing wakes us when another thread sets an event, so look again
+     * soon while anybody waits for a fence */
+    if (!xorg_list_is_empty(&s_fencesWatched)) {
+        int *piTimeout = pTimeout;
+
+        if (*piTimeout < 0 || *piTimeout > 1)
+            *piTimeout = 1;
+    }
+
+    /* Triggering runs the fence's triggers, which may delete themselves
+     * and take the fence off the list, so start over each time */
+ restart:
+    xorg_list_for_each_entry(pPriv, &s_fencesWatched, entry) {
+        SyncFence *pFence = pPriv->pFence;
+
+        if (pFence->pScreen == pScreen && !pFence->triggered &&
+            pPriv->hEvent &&
+            WaitForSingleObject(pPriv->hEvent, 0) == WAIT_OBJECT_0) {
+            miSyncTriggerFence(pFence);
+            goto restart;
+        }
+    }
+}
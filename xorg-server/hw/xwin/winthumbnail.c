@@ -0,0 +1,540 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Taskbar thumbnails and live previews of minimized multiwindow windows
+ *
+ * While a window is shown, DWM makes its own thumbnails from what we paint.
+ * A minimized window paints nothing, so DWM only has a blank or stale
+ * picture of it.  With -compositewm the window still has its pixmap, so
+ * while it is minimized we tell DWM we supply its bitmaps ourselves
+ * (DWMWA_FORCE_ICONIC_REPRESENTATION), and answer its
+ * WM_DWMSENDICONICTHUMBNAIL from a downscaled copy of the pixmap kept per
+ * window.  A Damage on the window records what the client draws meanwhile,
+ * so only the thumbnail pixels covering that are averaged again, and DWM is
+ * told the thumbnail changed at most every WIN_THUMBNAIL_INTERVAL ms.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN_THUMBNAIL_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "win.h"
+#include "damage.h"
+
+/* From dwmapi.h, which only has them for _WIN32_WINNT >= 0x0601 */
+#define WIN_DWMWA_FORCE_ICONIC_REPRESENTATION 7
+#define WIN_DWMWA_HAS_ICONIC_BITMAP 10
+#define WIN_DWM_SIT_DISPLAYFRAME 0x1
+
+/* Shortest time between telling DWM a thumbnail is out of date */
+#define WIN_THUMBNAIL_INTERVAL 500
+
+typedef HRESULT (WINAPI *DWMSETWINDOWATTRIBUTEPROC)(HWND, DWORD, LPCVOID,
+                                                    DWORD);
+typedef HRESULT (WINAPI *DWMSETICONICTHUMBNAILPROC)(HWND, HBITMAP, DWORD);
+typedef HRESULT (WINAPI *DWMSETICONICLIVEPREVIEWBITMAPPROC)(HWND, HBITMAP,
+                                                            POINT *, DWORD);
+typedef HRESULT (WINAPI *DWMINVALIDATEICONICBITMAPSPROC)(HWND);
+
+typedef struct _winThumbnail {
+    WindowPtr pWin;
+    HWND hWnd;
+    DamagePtr pDamage;          /* drawn since the thumbnail was made */
+    CARD32 *pBits;              /* the thumbnail, opaque a8r8g8b8 */
+    int iWidth, iHeight;
+    int iScale;                 /* window pixels per thumbnail pixel */
+    int iSrcWidth, iSrcHeight;  /* window size it was made at */
+    Bool fValid;
+    DWORD dwInvalidated;        /* GetTickCount() DWM was last told */
+    Bool fTimerSet;
+} winThumbnailRec;
+
+static HMODULE g_hmodDwmapiDll = NULL;
+static Bool g_fDwmapiLoaded = FALSE;
+static DWMSETWINDOWATTRIBUTEPROC g_pDwmSetWindowAttribute = NULL;
+static DWMSETICONICTHUMBNAILPROC g_pDwmSetIconicThumbnail = NULL;
+static DWMSETICONICLIVEPREVIEWBITMAPPROC g_pDwmSetIconicLivePreviewBitmap =
+    NULL;
+static DWMINVALIDATEICONICBITMAPSPROC g_pDwmInvalidateIconicBitmaps = NULL;
+
+/*
+ * The iconic bitmap functions are only there since Windows 7, so load them
+ * the first time a window is minimized, and do without if they're missing
+ */
+
+static Bool
+winThumbnailLoad(void)
+{
+    if (g_fDwmapiLoaded)
+        return g_pDwmInvalidateIconicBitmaps != NULL;
+    g_fDwmapiLoaded = TRUE;
+
+    g_hmodDwmapiDll = LoadLibrary("dwmapi.dll");
+    if (g_hmodDwmapiDll == NULL)
+        return FALSE;
+
+    g_pDwmSetWindowAttribute = (DWMSETWINDOWATTRIBUTEPROC)
+        GetProcAddress(g_hmodDwmapiDll, "DwmSetWindowAttribute");
+    g_pDwmSetIconicThumbnail = (DWMSETICONICTHUMBNAILPROC)
+        GetProcAddress(g_hmodDwmapiDll, "DwmSetIconicThumbnail");
+    g_pDwmSetIconicLivePreviewBitmap = (DWMSETICONICLIVEPREVIEWBITMAPPROC)
+        GetProcAddress(g_hmodDwmapiDll, "DwmSetIconicLivePreviewBitmap");
+    g_pDwmInvalidateIconicBitmaps = (DWMINVALIDATEICONICBITMAPSPROC)
+        GetProcAddress(g_hmodDwmapiDll, "DwmInvalidateIconicBitmaps");
+
+    if (!g_pDwmSetWindowAttribute || !g_pDwmSetIconicThumbnail ||
+        !g_pDwmSetIconicLivePreviewBitmap || !g_pDwmInvalidateIconicBitmaps) {
+        winDebug("winThumbnailLoad - No iconic bitmaps in dwmapi.dll\n");
+        FreeLibrary(g_hmodDwmapiDll);
+        g_hmodDwmapiDll = NULL;
+        g_pDwmInvalidateIconicBitmaps = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * The window's own pixels in its composite pixmap, if it has one in the
+ * x8r8g8b8 layout DWM can take
+ */
+
+static CARD32 *
+winThumbnailSource(WindowPtr pWin, int *piStride)
+{
+#ifdef COMPOSITE
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+    winScreenPriv(pScreen);
+    PixmapPtr pPixmap;
+
+    if (pWin->redirectDraw == RedirectDrawNone)
+        return NULL;
+
+    pPixmap = (*pScreen->GetWindowPixmap) (pWin);
+    if (pPixmap)
+        fbBudgetTouch(pPixmap);
+    if (!pPixmap || !pPixmap->devPrivate.ptr ||
+        pPixmap->drawable.bitsPerPixel != 32 ||
+        pScreenPriv->dwRedMask != 0x00ff0000 ||
+        pScreenPriv->dwGreenMask != 0x0000ff00 ||
+        pScreenPriv->dwBlueMask != 0x000000ff)
+        return NULL;
+
+    /* The pixmap covers the border too */
+    if (pPixmap->drawable.width < pWin->drawable.width + 2 * pWin->borderWidth
+        || pPixmap->drawable.height <
+        pWin->drawable.height + 2 * pWin->borderWidth)
+        return NULL;
+
+    *piStride = pPixmap->devKind / sizeof(CARD32);
+    return (CARD32 *) ((char *) pPixmap->devPrivate.ptr +
+                       pWin->borderWidth * pPixmap->devKind) +
+        pWin->borderWidth;
+#else
+    return NULL;
+#endif
+}
+
+/*
+ * Box filter one thumbnail pixel from the window pixels it covers
+ */
+
+static CARD32
+winThumbnailBoxAverage(const CARD32 *pixels, int stride,
+                       int x0, int x1, int y0, int y1)
+{
+    CARD32 sum[4] = { 0, 0, 0, 0 };     /* b, g, r, unused */
+    CARD32 count = (CARD32) (x1 - x0) * (y1 - y0);
+    CARD32 result = 0xff000000;
+    int x, y, i;
+
+    for (y = y0; y < y1; y++) {
+        const CARD32 *src = pixels + (size_t) y * stride;
+        CARD32 row[4];
+
+#ifdef WIN_THUMBNAIL_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc = zero;
+
+        /* Four pixels at a time, as two sets of eight 16-bit channels */
+        for (x = x0; x + 3 < x1; x += 4) {
+            __m128i p = _mm_loadu_si128((const __m128i *) &src[x]);
+            __m128i pair = _mm_add_epi16(_mm_unpacklo_epi8(p, zero),
+                                         _mm_unpackhi_epi8(p, zero));
+
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(pair, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(pair, zero));
+        }
+        for (; x < x1; x++) {
+            __m128i p = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src[x]), zero);
+
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(p, zero));
+        }
+        _mm_storeu_si128((__m128i *) row, acc);
+#else
+        row[0] = row[1] = row[2] = 0;
+        for (x = x0; x < x1; x++) {
+            CARD32 p = src[x];
+
+            row[0] += p & 0xFF;
+            row[1] += (p >> 8) & 0xFF;
+            row[2] += (p >> 16) & 0xFF;
+        }
+#endif
+
+        for (i = 0; i < 3; i++)
+            sum[i] += row[i];
+    }
+
+    for (i = 0; i < 3; i++)
+        result |= ((sum[i] + count / 2) / count) << (8 * i);
+
+    return result;
+}
+
+/*
+ * Average again the thumbnail pixels covering a box of the window
+ */
+
+static void
+winThumbnailScaleBox(winThumbnailPtr pThumb, const CARD32 *pixels, int stride,
+                     int x1, int y1, int x2, int y2)
+{
+    int s = pThumb->iScale;
+    int tx, ty;
+
+    x1 = max(x1, 0) / s;
+    y1 = max(y1, 0) / s;
+    x2 = min((min(x2, pThumb->iSrcWidth) + s - 1) / s, pThumb->iWidth);
+    y2 = min((min(y2, pThumb->iSrcHeight) + s - 1) / s, pThumb->iHeight);
+
+    for (ty = y1; ty < y2; ty++) {
+        int y0 = ty * s;
+        int yEnd = min(y0 + s, pThumb->iSrcHeight);
+        CARD32 *dst = pThumb->pBits + (size_t) ty * pThumb->iWidth;
+
+        for (tx = x1; tx < x2; tx++) {
+            int x0 = tx * s;
+
+            dst[tx] = winThumbnailBoxAverage(pixels, stride, x0,
+                                             min(x0 + s, pThumb->iSrcWidth),
+                                             y0, yEnd);
+        }
+    }
+}
+
+/*
+ * Bring the thumbnail up to date, for DWM asking for one of at most
+ * iMaxWidth x iMaxHeight
+ */
+
+static Bool
+winThumbnailUpdate(winThumbnailPtr pThumb, int iMaxWidth, int iMaxHeight)
+{
+    WindowPtr pWin = pThumb->pWin;
+    int iSrcWidth = pWin->drawable.width;
+    int iSrcHeight = pWin->drawable.height;
+    const CARD32 *pixels;
+    int stride, s;
+
+    if (iMaxWidth <= 0 || iMaxHeight <= 0 || iSrcWidth <= 0 || iSrcHeight <= 0)
+        return pThumb->fValid;
+
+    pixels = winThumbnailSource(pWin, &stride);
+    if (!pixels)
+        return pThumb->fValid;  /* Keep showing what we had */
+
+    /* Whole window pixels per thumbnail pixel, so a damaged box only
+     * touches the thumbnail pixels over it */
+    s = max((iSrcWidth + iMaxWidth - 1) / iMaxWidth,
+            (iSrcHeight + iMaxHeight - 1) / iMaxHeight);
+    if (s < 1)
+        s = 1;
+
+    if (!pThumb->fValid || s != pThumb->iScale ||
+        iSrcWidth != pThumb->iSrcWidth || iSrcHeight != pThumb->iSrcHeight) {
+        int iWidth = (iSrcWidth + s - 1) / s;
+        int iHeight = (iSrcHeight + s - 1) / s;
+        CARD32 *pBits = realloc(pThumb->pBits,
+                                (size_t) iWidth * iHeight * sizeof(CARD32));
+        if (!pBits)
+            return FALSE;
+
+        pThumb->pBits = pBits;
+        pThumb->iWidth = iWidth;
+        pThumb->iHeight = iHeight;
+        pThumb->iScale = s;
+        pThumb->iSrcWidth = iSrcWidth;
+        pThumb->iSrcHeight = iSrcHeight;
+        winThumbnailScaleBox(pThumb, pixels, stride,
+                             0, 0, iSrcWidth, iSrcHeight);
+        pThumb->fValid = TRUE;
+    }
+    else if (pThumb->pDamage) {
+        RegionPtr pRegion = DamageRegion(pThumb->pDamage);
+        BoxPtr pBox = RegionRects(pRegion);
+        int nBox = RegionNumRects(pRegion);
+        int dx = pWin->drawable.x, dy = pWin->drawable.y;
+
+        /* Damage of a window is in screen coordinates */
+        while (nBox--) {
+            winThumbnailScaleBox(pThumb, pixels, stride,
+                                 pBox->x1 - dx, pBox->y1 - dy,
+                                 pBox->x2 - dx, pBox->y2 - dy);
+            pBox++;
+        }
+    }
+
+    if (pThumb->pDamage)
+        DamageEmpty(pThumb->pDamage);
+
+    return TRUE;
+}
+
+/*
+ * A top-down 32bpp DIB section with a copy of some rows of pixels
+ */
+
+static HBITMAP
+winThumbnailBitmap(const CARD32 *pixels, int stride, int iWidth, int iHeight)
+{
+    BITMAPINFO bmi;
+    HBITMAP hBitmap;
+    CARD32 *pBits;
+    int x, y;
+
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = iWidth;
+    bmi.bmiHeader.biHeight = -iHeight;  /* top-down bitmap */
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    hBitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, (void **) &pBits,
+                               NULL, 0);
+    if (!hBitmap)
+        return NULL;
+
+    /* DWM takes the alpha channel, which is garbage in window pixmaps */
+    for (y = 0; y < iHeight; y++) {
+        const CARD32 *src = pixels + (size_t) y * stride;
+
+        for (x = 0; x < iWidth; x++)
+            *pBits++ = src[x] | 0xff000000;
+    }
+
+    return hBitmap;
+}
+
+static void
+winThumbnailDamageReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
+{
+    winThumbnailPtr pThumb = closure;
+    DWORD dwElapsed;
+
+    if (pThumb->fTimerSet)
+        return;
+
+    /* The thumbnail is only made again when DWM asks, which it does when
+     * it shows it and we have said it changed */
+    dwElapsed = GetTickCount() - pThumb->dwInvalidated;
+    if (dwElapsed >= WIN_THUMBNAIL_INTERVAL) {
+        pThumb->dwInvalidated = GetTickCount();
+        g_pDwmInvalidateIconicBitmaps(pThumb->hWnd);
+    }
+    else if (SetTimer(pThumb->hWnd, WIN_THUMBNAIL_TIMER_ID,
+                      WIN_THUMBNAIL_INTERVAL - dwElapsed, NULL))
+        pThumb->fTimerSet = TRUE;
+}
+
+static void
+winThumbnailDamageDestroy(DamagePtr pDamage, void *closure)
+{
+    winThumbnailPtr pThumb = closure;
+
+    pThumb->pDamage = NULL;
+}
+
+static void
+winThumbnailSetIconic(HWND hWnd, BOOL fIconic)
+{
+    g_pDwmSetWindowAttribute(hWnd, WIN_DWMWA_FORCE_ICONIC_REPRESENTATION,
+                             &fIconic, sizeof(fIconic));
+    g_pDwmSetWindowAttribute(hWnd, WIN_DWMWA_HAS_ICONIC_BITMAP,
+                             &fIconic, sizeof(fIconic));
+}
+
+/*
+ * winThumbnailIconic - Supply DWM's pictures of a window while it is
+ * minimized
+ */
+
+void
+winThumbnailIconic(WindowPtr pWin, Bool fIconic)
+{
+    winWindowPriv(pWin);
+    winThumbnailPtr pThumb = pWinPriv->pThumbnail;
+    int stride;
+
+    if (!fIconic) {
+        winThumbnailFree(pWin);
+        return;
+    }
+
+    if (pThumb || !pWinPriv->hWnd || !winThumbnailSource(pWin, &stride) ||
+        !winThumbnailLoad())
+        return;
+
+    pThumb = calloc(1, sizeof(winThumbnailRec));
+    if (!pThumb)
+        return;
+    pThumb->pWin = pWin;
+    pThumb->hWnd = pWinPriv->hWnd;
+    pThumb->dwInvalidated = GetTickCount();
+
+    pThumb->pDamage = DamageCreate(winThumbnailDamageReport,
+                                   winThumbnailDamageDestroy,
+                                   DamageReportNonEmpty, TRUE,
+                                   pWin->drawable.pScreen, pThumb);
+    if (!pThumb->pDamage) {
+        free(pThumb);
+        return;
+    }
+    DamageRegister(&pWin->drawable, pThumb->pDamage);
+
+    pWinPriv->pThumbnail = pThumb;
+    winThumbnailSetIconic(pThumb->hWnd, TRUE);
+    g_pDwmInvalidateIconicBitmaps(pThumb->hWnd);
+}
+
+/*
+ * winThumbnailSend - Answer WM_DWMSENDICONICTHUMBNAIL
+ */
+
+Bool
+winThumbnailSend(WindowPtr pWin, int iMaxWidth, int iMaxHeight)
+{
+    winThumbnailPtr pThumb = winGetWindowPriv(pWin)->pThumbnail;
+    HBITMAP hBitmap;
+
+    if (!pThumb || !winThumbnailUpdate(pThumb, iMaxWidth, iMaxHeight))
+        return FALSE;
+
+    hBitmap = winThumbnailBitmap(pThumb->pBits, pThumb->iWidth,
+                                 pThumb->iWidth, pThumb->iHeight);
+    if (!hBitmap)
+        return FALSE;
+
+    /* DWM keeps a copy */
+    g_pDwmSetIconicThumbnail(pThumb->hWnd, hBitmap, 0);
+    DeleteObject(hBitmap);
+
+    return TRUE;
+}
+
+/*
+ * winThumbnailSendLivePreview - Answer WM_DWMSENDICONICLIVEPREVIEWBITMAP
+ *
+ * The preview is full size, so it comes straight from the pixmap, which
+ * DWM only asks for while the pointer is over the thumbnail.
+ */
+
+Bool
+winThumbnailSendLivePreview(WindowPtr pWin)
+{
+    winThumbnailPtr pThumb = winGetWindowPriv(pWin)->pThumbnail;
+    const CARD32 *pixels;
+    HBITMAP hBitmap;
+    int stride;
+
+    if (!pThumb)
+        return FALSE;
+
+    pixels = winThumbnailSource(pWin, &stride);
+    if (!pixels)
+        return FALSE;
+
+    hBitmap = winThumbnailBitmap(pixels, stride, pWin->drawable.width,
+                                 pWin->drawable.height);
+    if (!hBitmap)
+        return FALSE;
+
+    g_pDwmSetIconicLivePreviewBitmap(pThumb->hWnd, hBitmap, NULL,
+                                     WIN_DWM_SIT_DISPLAYFRAME);
+    DeleteObject(hBitmap);
+
+    return TRUE;
+}
+
+/*
+ * winThumbnailTimer - Tell DWM about a change held back by the interval
+ */
+
+void
+winThumbnailTimer(WindowPtr pWin)
+{
+    winThumbnailPtr pThumb = winGetWindowPriv(pWin)->pThumbnail;
+
+    if (!pThumb)
+        return;
+
+    KillTimer(pThumb->hWnd, WIN_THUMBNAIL_TIMER_ID);
+    pThumb->fTimerSet = FALSE;
+    pThumb->dwInvalidated = GetTickCount();
+    g_pDwmInvalidateIconicBitmaps(pThumb->hWnd);
+}
+
+/*
+ * winThumbnailFree - Hand a window's pictures back to DWM
+ */
+
+void
+winThumbnailFree(WindowPtr pWin)
+{
+    winWindowPriv(pWin);
+    winThumbnailPtr pThumb = pWinPriv->pThumbnail;
+
+    if (!pThumb)
+        return;
+    pWinPriv->pThumbnail = NULL;
+
+    if (pThumb->fTimerSet)
+        KillTimer(pThumb->hWnd, WIN_THUMBNAIL_TIMER_ID);
+    if (IsWindow(pThumb->hWnd))
+        winThumbnailSetIconic(pThumb->hWnd, FALSE);
+
+    if (pThumb->pDamage) {
+        DamageUnregister(pThumb->pDamage);
+        DamageDestroy(pThumb->pDamage);
+    }
+    free(pThumb->pBits);
+    free(pThumb);
+}
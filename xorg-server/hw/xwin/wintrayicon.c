@@ -204,6 +204,23 @@ winHandleIconMessage(HWND hwnd, UINT message,
             RemoveMenu(hmenuTray, ID_APP_MONITOR_PRIMARY, MF_BYCOMMAND);
         }
 
+        if (winStatsWindowShown()) {
+            MENUITEMINFO mii = { 0 };
+            mii.cbSize = sizeof(MENUITEMINFO);
+            mii.fMask = MIIM_STATE;
+            mii.fState = MFS_CHECKED;
+            SetMenuItemInfo(hmenuTray, ID_APP_STATISTICS, FALSE, &mii);
+        }
+
+#ifdef XSERVER_REQUEST_PROFILE
+        InsertMenu(hmenuTray, ID_APP_ABOUT, MF_BYCOMMAND | MF_STRING,
+                   ID_APP_DUMP_PROFILE, "Dump Request &Profile to Log");
+#endif
+#ifdef XSERVER_INPUT_LATENCY
+        InsertMenu(hmenuTray, ID_APP_ABOUT, MF_BYCOMMAND | MF_STRING,
+                   ID_APP_DUMP_LATENCY, "Dump Input &Latency to Log");
+#endif
+
         SetupRootMenu(hmenuTray);
 
         /*
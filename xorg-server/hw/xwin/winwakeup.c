@@ -36,19 +36,52 @@
 #endif
 #include "win.h"
 
+/* Input messages to dispatch in one wakeup, besides the first message */
+#define WIN_WAKEUP_MAX_INPUT 64
+
+static void
+winDispatchMessage(MSG *msg)
+{
+    if ((msg->message >= WM_KEYFIRST && msg->message <= WM_KEYLAST) ||
+        (msg->message >= WM_MOUSEFIRST && msg->message <= WM_MOUSELAST) ||
+        msg->message == WM_INPUT) {
+        DWORD dwQueued = GetTickCount() - msg->time;
+
+        g_winStats.llInputEvents++;
+        g_winStats.llInputQueuedMillis += dwQueued;
+#ifdef XSERVER_INPUT_LATENCY
+        InputLatencyReceived(dwQueued);
+#endif
+    }
+
+    if ((g_hDlgDepthChange == 0
+         || !IsDialogMessage(g_hDlgDepthChange, msg))
+        && (g_hDlgExit == 0 || !IsDialogMessage(g_hDlgExit, msg))
+        && (g_hDlgAbout == 0 || !IsDialogMessage(g_hDlgAbout, msg))) {
+        DispatchMessage(msg);
+    }
+}
+
 /* See Porting Layer Definition - p. 7 */
 void
 winWakeupHandler(ScreenPtr pScreen, int iResult)
 {
     MSG msg;
+    int i;
+
+    /* All of the Raw Input mouse reports which came in meanwhile */
+    winMouseRawInputDrain();
 
     /* Process one message from our queue */
-    if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-        if ((g_hDlgDepthChange == 0
-             || !IsDialogMessage(g_hDlgDepthChange, &msg))
-            && (g_hDlgExit == 0 || !IsDialogMessage(g_hDlgExit, &msg))
-            && (g_hDlgAbout == 0 || !IsDialogMessage(g_hDlgAbout, &msg))) {
-            DispatchMessage(&msg);
-        }
-    }
+    if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        winDispatchMessage(&msg);
+
+    /*
+     * Then the mouse and keyboard input queued behind it, so what built up
+     * while we were busy with a client reaches mieq in one go rather than a
+     * message per trip round the dispatch loop
+     */
+    for (i = 0; i < WIN_WAKEUP_MAX_INPUT &&
+         PeekMessage(&msg, NULL, 0, 0, PM_REMOVE | PM_QS_INPUT); i++)
+        winDispatchMessage(&msg);
 }
@@ -56,6 +56,9 @@
 #ifndef ULW_OPAQUE
 #define ULW_OPAQUE	0x00000004
 #endif
+#ifndef ULW_EX_NORESIZE
+#define ULW_EX_NORESIZE	0x00000008
+#endif
 #define AC_SRC_ALPHA	0x01
 
 /*
@@ -66,6 +69,9 @@ DEFINE_ATOM_HELPER(AtmWindowsWmNativeHwnd, WINDOWSWM_NATIVE_HWND)
 static void
 winMWExtWMSetNativeProperty(RootlessWindowPtr pFrame);
 
+static void
+winMWExtWMUpdateLayered(win32RootlessWindowPtr pRLWinPriv);
+
 /*
  * Global variables
  */
@@ -133,42 +139,16 @@ winMWExtWMQueryDIBFormat(win32RootlessWindowPtr pRLWinPriv,
 static HRGN
 winMWExtWMCreateRgnFromRegion(RegionPtr pShape)
 {
-    int nRects;
-    BoxPtr pRects, pEnd;
-    HRGN hRgn, hRgnRect;
+    HRGN hRgn;
 
     if (pShape == NULL)
         return NULL;
 
-    nRects = RegionNumRects(pShape);
-    pRects = RegionRects(pShape);
-
-    hRgn = CreateRectRgn(0, 0, 0, 0);
+    hRgn = winCreateRgnFromBoxes(RegionRects(pShape), RegionNumRects(pShape),
+                                 0, 0, NULL);
     if (hRgn == NULL) {
-        ErrorF("winReshape - Initial CreateRectRgn (%d, %d, %d, %d) "
-               "failed: %d\n", 0, 0, 0, 0, (int) GetLastError());
-    }
-
-    /* Loop through all rectangles in the X region */
-    for (pEnd = pRects + nRects; pRects < pEnd; pRects++) {
-        /* Create a Windows region for the X rectangle */
-        hRgnRect = CreateRectRgn(pRects->x1,
-                                 pRects->y1, pRects->x2, pRects->y2);
-        if (hRgnRect == NULL) {
-            ErrorF("winReshape - Loop CreateRectRgn (%d, %d, %d, %d) "
-                   "failed: %d\n",
-                   pRects->x1,
-                   pRects->y1, pRects->x2, pRects->y2, (int) GetLastError());
-        }
-
-        /* Merge the Windows region with the accumulated region */
-        if (CombineRgn(hRgn, hRgn, hRgnRect, RGN_OR) == ERROR) {
-            ErrorF("winReshape - CombineRgn () failed: %d\n",
-                   (int) GetLastError());
-        }
-
-        /* Delete the temporary Windows region */
-        DeleteObject(hRgnRect);
+        ErrorF("winMWExtWMCreateRgnFromRegion - winCreateRgnFromBoxes () "
+               "failed: %d\n", (int) GetLastError());
     }
 
     return hRgn;
@@ -208,6 +188,8 @@ winMWExtWMCreateFrame(RootlessWindowPtr pFrame, ScreenPtr pScreen,
     char *res_name, *res_class, *res_role;
     static int s_iWindowID = 0;
 
+    winScreenPriv(pScreen);
+
     winDebug("winMWExtWMCreateFrame %d %d - %d %d\n",
              newX, newY, pFrame->width, pFrame->height);
 
@@ -224,6 +206,11 @@ winMWExtWMCreateFrame(RootlessWindowPtr pFrame, ScreenPtr pScreen,
     pRLWinPriv->fDestroyed = FALSE;
     pRLWinPriv->fMovingOrSizing = FALSE;
 
+    /* Layered frames need a 32 bit DIB to take the alpha channel from */
+    pRLWinPriv->fLayered = pScreenPriv->pScreenInfo->fLayeredFrames
+        && pScreenPriv->pScreenInfo->dwBPP == 32;
+    SetRectEmpty(&pRLWinPriv->rcDirty);
+
     // Store the implementation private frame ID
     pFrame->wid = (RootlessFrameID) pRLWinPriv;
 
@@ -277,7 +264,7 @@ winMWExtWMCreateFrame(RootlessWindowPtr pFrame, ScreenPtr pScreen,
 
     /* Create the window */
     g_fNoConfigureWindow = TRUE;
-    pRLWinPriv->hWnd = CreateWindowExA(WS_EX_TOOLWINDOW,        /* Extended styles */
+    pRLWinPriv->hWnd = CreateWindowExA(WS_EX_TOOLWINDOW | (pRLWinPriv->fLayered ? WS_EX_LAYERED : 0),        /* Extended styles */
                                        pszClass,        /* Class name */
                                        WINDOW_TITLE_X,  /* Window name */
                                        WS_POPUP | WS_CLIPCHILDREN, newX,        /* Horizontal position */
@@ -645,6 +632,11 @@ winMWExtWMStartDrawing(RootlessFrameID wid, char **pixelData, int *bytesPerRow)
             pRLWinPriv->hbmpShadow = hbmpNew;
 
             pRLWinPriv->fResized = FALSE;
+
+            /* The new bitmap has to be presented in full */
+            if (pRLWinPriv->fLayered)
+                SetRect(&pRLWinPriv->rcDirty, 0, 0,
+                        pRLWinPriv->pFrame->width, pRLWinPriv->pFrame->height);
             winDebug("winMWExtWMStartDrawing - 0x%08x %d\n",
                      (unsigned int) pRLWinPriv->pfb,
                      (unsigned int) dibsection.dsBm.bmWidthBytes);
@@ -661,9 +653,64 @@ winMWExtWMStartDrawing(RootlessFrameID wid, char **pixelData, int *bytesPerRow)
     *bytesPerRow = pRLWinPriv->dwWidthBytes;
 }
 
+/*
+ * winMWExtWMUpdateLayered - Hand the dirty part of a layered frame's DIB
+ * straight to the compositor, with no intermediate copy
+ */
+
+static void
+winMWExtWMUpdateLayered(win32RootlessWindowPtr pRLWinPriv)
+{
+    UPDATELAYEREDWINDOWINFO ulwi;
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    POINT ptSrc = { 0, 0 };
+    SIZE size;
+    RECT rcFrame;
+
+    if (pRLWinPriv->fDestroyed || pRLWinPriv->hbmpShadow == NULL
+        || IsRectEmpty(&pRLWinPriv->rcDirty))
+        return;
+
+    size.cx = pRLWinPriv->pFrame->width;
+    size.cy = pRLWinPriv->pFrame->height;
+    SetRect(&rcFrame, 0, 0, size.cx, size.cy);
+    if (!IntersectRect(&pRLWinPriv->rcDirty, &pRLWinPriv->rcDirty, &rcFrame))
+        return;
+
+    memset(&ulwi, 0, sizeof(ulwi));
+    ulwi.cbSize = sizeof(ulwi);
+    ulwi.psize = &size;
+    ulwi.hdcSrc = pRLWinPriv->hdcShadow;
+    ulwi.pptSrc = &ptSrc;
+    ulwi.pblend = &blend;
+    ulwi.prcDirty = &pRLWinPriv->rcDirty;
+
+    /* Only ARGB visuals have a meaningful alpha channel */
+    ulwi.dwFlags = ULW_EX_NORESIZE
+        | (pRLWinPriv->pFrame->win->drawable.depth == 32
+           ? ULW_ALPHA : ULW_OPAQUE);
+
+    if (UpdateLayeredWindowIndirect(pRLWinPriv->hWnd, &ulwi)) {
+        SetRectEmpty(&pRLWinPriv->rcDirty);
+    }
+    else {
+        /*
+         * Most likely the window has not caught up with a resize yet;
+         * present the whole frame once it has
+         */
+        winDebug("winMWExtWMUpdateLayered - UpdateLayeredWindowIndirect "
+                 "failed: %d\n", (int) GetLastError());
+        pRLWinPriv->rcDirty = rcFrame;
+    }
+}
+
 void
 winMWExtWMStopDrawing(RootlessFrameID wid, Bool fFlush)
 {
+    win32RootlessWindowPtr pRLWinPriv = (win32RootlessWindowPtr) wid;
+
+    if (fFlush && pRLWinPriv->fLayered)
+        winMWExtWMUpdateLayered(pRLWinPriv);
 }
 
 void
@@ -671,7 +718,9 @@ winMWExtWMUpdateRegion(RootlessFrameID wid, RegionPtr pDamage)
 {
     win32RootlessWindowPtr pRLWinPriv = (win32RootlessWindowPtr) wid;
 
-    if (!g_fNoConfigureWindow)
+    if (pRLWinPriv->fLayered)
+        winMWExtWMUpdateLayered(pRLWinPriv);
+    else if (!g_fNoConfigureWindow)
         UpdateWindow(pRLWinPriv->hWnd);
 }
 
@@ -693,7 +742,11 @@ winMWExtWMDamageRects(RootlessFrameID wid, int nCount, const BoxRec * pRects,
         rcDmg.right = pRects->x2 + shift_x;
         rcDmg.bottom = pRects->y2 + shift_y;
 
-        InvalidateRect(pRLWinPriv->hWnd, &rcDmg, FALSE);
+        /* Layered frames are presented from the DIB on the next flush */
+        if (pRLWinPriv->fLayered)
+            UnionRect(&pRLWinPriv->rcDirty, &pRLWinPriv->rcDirty, &rcDmg);
+        else
+            InvalidateRect(pRLWinPriv->hWnd, &rcDmg, FALSE);
     }
 }
 
@@ -708,7 +761,8 @@ winMWExtWMRootlessSwitchWindow(RootlessWindowPtr pFrame, WindowPtr oldWin)
     pRLWinPriv->fResized = TRUE;
 
     /* Set the window extended style flags */
-    SetWindowLongPtr(pRLWinPriv->hWnd, GWL_EXSTYLE, WS_EX_TOOLWINDOW);
+    SetWindowLongPtr(pRLWinPriv->hWnd, GWL_EXSTYLE, WS_EX_TOOLWINDOW
+                     | (pRLWinPriv->fLayered ? WS_EX_LAYERED : 0));
 
     /* Set the window standard style flags */
     SetWindowLongPtr(pRLWinPriv->hWnd, GWL_STYLE, WS_POPUP | WS_CLIPCHILDREN);
@@ -757,8 +811,15 @@ winMWExtWMCopyWindow(RootlessFrameID wid, int nDstRects,
         rcDmg.right = pDstRects->x2;
         rcDmg.bottom = pDstRects->y2;
 
-        InvalidateRect(pRLWinPriv->hWnd, &rcDmg, FALSE);
+        if (pRLWinPriv->fLayered)
+            UnionRect(&pRLWinPriv->rcDirty, &pRLWinPriv->rcDirty, &rcDmg);
+        else
+            InvalidateRect(pRLWinPriv->hWnd, &rcDmg, FALSE);
     }
+
+    /* Nothing else will flush a scroll of a layered frame */
+    if (pRLWinPriv->fLayered)
+        winMWExtWMUpdateLayered(pRLWinPriv);
     winDebug("winMWExtWMCopyWindow - done\n");
 }
 
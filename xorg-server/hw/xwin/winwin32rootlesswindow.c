@@ -274,6 +274,7 @@ winMWExtWMUpdateWindowDecoration(win32RootlessWindowPtr pRLWinPriv,
                          rcNew.right - rcNew.left, rcNew.bottom - rcNew.top,
                          showCmd);
 
+            memset(&wmMsg, 0, sizeof(wmMsg));
             wmMsg.hwndWindow = pRLWinPriv->hWnd;
             wmMsg.iWindow = (Window) pRLWinPriv->pFrame->win->drawable.id;
             wmMsg.msg = WM_WM_NAME_EVENT;
@@ -639,6 +639,11 @@ winMWExtWMWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
          */
         return 0;
 
+    case WM_INPUTLANGCHANGE:
+        /* Key messages without a scan code now map to other ones */
+        winKeybdLayoutChanged();
+        break;
+
     case WM_SYSKEYDOWN:
     case WM_KEYDOWN:
 #if CYGMULTIWINDOW_DEBUG
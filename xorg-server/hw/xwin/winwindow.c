@@ -299,8 +299,8 @@ winReshapeRootless(WindowPtr pWin)
 {
     int nRects;
     RegionRec rrNewShape;
-    BoxPtr pShape, pRects, pEnd;
-    HRGN hRgn, hRgnRect;
+    BoxPtr pShape;
+    HRGN hRgn;
 
     winWindowPriv(pWin);
 
@@ -332,25 +332,9 @@ winReshapeRootless(WindowPtr pWin)
     pShape = RegionRects(&rrNewShape);
 
     if (nRects > 0) {
-        /* Create initial empty Windows region */
-        hRgn = CreateRectRgn(0, 0, 0, 0);
-
-        /* Loop through all rectangles in the X region */
-        for (pRects = pShape, pEnd = pShape + nRects; pRects < pEnd; pRects++) {
-            /* Create a Windows region for the X rectangle */
-            hRgnRect = CreateRectRgn(pRects->x1, pRects->y1,
-                                     pRects->x2, pRects->y2);
-            if (hRgnRect == NULL) {
-                ErrorF("winReshapeRootless - CreateRectRgn() failed\n");
-            }
-
-            /* Merge the Windows region with the accumulated region */
-            if (CombineRgn(hRgn, hRgn, hRgnRect, RGN_OR) == ERROR) {
-                ErrorF("winReshapeRootless - CombineRgn() failed\n");
-            }
-
-            /* Delete the temporary Windows region */
-            DeleteObject(hRgnRect);
+        hRgn = winCreateRgnFromBoxes(pShape, nRects, 0, 0, NULL);
+        if (hRgn == NULL) {
+            ErrorF("winReshapeRootless - winCreateRgnFromBoxes() failed\n");
         }
 
         /* Save a handle to the composite region in the window privates */
@@ -361,3 +345,59 @@ winReshapeRootless(WindowPtr pWin)
 
     return;
 }
+
+/*
+ * winCreateRgnFromBoxes - Make a Windows region of a list of X boxes
+ * offset by iOffsetX, iOffsetY, and of prcExtra if it isn't NULL
+ *
+ * The whole list goes to GDI in one ExtCreateRegion, rather than one
+ * CreateRectRgn and CombineRgn per box.
+ */
+
+HRGN
+winCreateRgnFromBoxes(const BoxRec * pBox, int nBox, int iOffsetX,
+                      int iOffsetY, const RECT * prcExtra)
+{
+    RGNDATA *prgnd;
+    RECT *prc;
+    HRGN hRgn;
+    DWORD nCount = 0;
+    int i;
+
+    prgnd = malloc(sizeof(RGNDATAHEADER) + (nBox + 1) * sizeof(RECT));
+    if (prgnd == NULL)
+        return NULL;
+
+    prc = (RECT *) prgnd->Buffer;
+    SetRectEmpty(&prgnd->rdh.rcBound);
+
+    if (prcExtra != NULL && !IsRectEmpty(prcExtra)) {
+        prc[nCount] = *prcExtra;
+        UnionRect(&prgnd->rdh.rcBound, &prgnd->rdh.rcBound, &prc[nCount]);
+        nCount++;
+    }
+
+    for (i = 0; i < nBox; ++i) {
+        SetRect(&prc[nCount],
+                pBox[i].x1 + iOffsetX, pBox[i].y1 + iOffsetY,
+                pBox[i].x2 + iOffsetX, pBox[i].y2 + iOffsetY);
+        UnionRect(&prgnd->rdh.rcBound, &prgnd->rdh.rcBound, &prc[nCount]);
+        nCount++;
+    }
+
+    prgnd->rdh.dwSize = sizeof(RGNDATAHEADER);
+    prgnd->rdh.iType = RDH_RECTANGLES;
+    prgnd->rdh.nCount = nCount;
+    prgnd->rdh.nRgnSize = nCount * sizeof(RECT);
+
+    if (nCount > 0)
+        hRgn = ExtCreateRegion(NULL,
+                               sizeof(RGNDATAHEADER) + nCount * sizeof(RECT),
+                               prgnd);
+    else
+        hRgn = CreateRectRgn(0, 0, 0, 0);
+
+    free(prgnd);
+
+    return hRgn;
+}
@@ -77,11 +77,26 @@ typedef struct {
     winPrivScreenPtr pScreenPriv;
     Bool fXKilled;
     HDWP hDwp;
+    Bool fIndexed;
+    BoxRec boxIndexed;
+    DWORD dwIndexStamp;
+    Bool fPositionPending;
+    RECT rcPending;
+    Bool fDragMovePending;      /* moved by a drag, X is told at its end */
+    Bool fDragSizePending;      /* sized by a drag, X is told next tick */
+    DWORD dwDragSized;          /* GetTickCount() of the last of those */
+    unsigned short usDragSequence;      /* client->sequence then */
+    HWND hWndShaped;            /* hWnd that was last given a shape */
+    DWORD dwShapeChecksum;      /* and the checksum of that shape */
+    Bool fShapeUnchanged;
+    struct _winThumbnail *pThumbnail;   /* while minimized, see winthumbnail.c */
 #ifdef XWIN_GLX_WINDOWS
     Bool fWglUsed;
 #endif
 } winPrivWinRec, *winPrivWinPtr;
 
+typedef struct _winThumbnail *winThumbnailPtr;
+
 typedef struct _winWMMessageRec {
     DWORD dwID;
     DWORD msg;
@@ -108,6 +123,7 @@ typedef struct _winWMMessageRec {
 #define		WM_WM_MAP_UNMANAGED	(WM_USER + 12)
 #define		WM_WM_MAP_MANAGED	(WM_USER + 13)
 #define		WM_WM_HINTS_EVENT	(WM_USER + 14)
+#define		WM_WM_PROPERTY_EVENT	(WM_USER + 15)
 
 #define		MwmHintsDecorations	(1L << 1)
 
@@ -220,8 +220,14 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 
             winInitNotifyIcon(s_pScreenPriv,FALSE);
         }
+
+        winMouseRawInputRegister(hwnd);
         return 0;
 
+    case WM_DESTROY:
+        winMouseRawInputUnregister(hwnd);
+        break;
+
     case WM_DISPLAYCHANGE:
         /*
            WM_DISPLAYCHANGE seems to be sent when the monitor layout or
@@ -236,6 +242,10 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
                        "mode changed while we were intializing.  This is "
                        "very bad and unexpected.  Exiting.\n");
 
+        /* The refresh rate may have changed along with the mode */
+        winFramePaceUpdatePeriod(s_pScreen);
+        winPresentUpdateMonitor(s_pScreen);
+
         /*
          * We do not care about display changes with
          * fullscreen DirectDraw engines, because those engines set
@@ -510,23 +520,31 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_EXITSIZEMOVE:
         winDebug("winWindowProc - WM_EXITSIZEMOVE\n");
 
+        /* We may have been moved onto a monitor with another refresh rate */
+        winFramePaceUpdatePeriod(s_pScreen);
+        winPresentUpdateMonitor(s_pScreen);
+
         if (s_pScreenInfo->iResizeMode == resizeWithRandr) {
             /* Set screen size to match new client area, if it is different to current */
             RECT rcClient;
             DWORD dwWidth, dwHeight;
 
             GetClientRect(hwnd, &rcClient);
-            dwWidth = rcClient.right - rcClient.left;
-            dwHeight = rcClient.bottom - rcClient.top;
+            dwWidth = winScaleToX(s_pScreenInfo,
+                                  rcClient.right - rcClient.left);
+            dwHeight = winScaleToX(s_pScreenInfo,
+                                   rcClient.bottom - rcClient.top);
 
             if ((s_pScreenInfo->dwWidth != dwWidth) ||
                 (s_pScreenInfo->dwHeight != dwHeight)) {
                 /* mm = dots * (25.4 mm / inch) / (dots / inch) */
+                int iDPI = winScaleToX(s_pScreenInfo, monitorResolution);
+
                 winDoRandRScreenSetSize(s_pScreen,
                                         dwWidth,
                                         dwHeight,
-                                        (dwWidth * 25.4) / monitorResolution,
-                                        (dwHeight * 25.4) / monitorResolution);
+                                        (dwWidth * 25.4) / iDPI,
+                                        (dwHeight * 25.4) / iDPI);
             }
         }
 
@@ -784,6 +802,11 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         return 0;
     }
 
+    case WM_INPUT:
+        /* DefWindowProc() frees the input */
+        winMouseRawInput((HRAWINPUT) lParam);
+        break;
+
     case WM_MOUSEMOVE:
         if (wParam & (MK_LBUTTON|MK_RBUTTON|MK_MBUTTON))
         {
@@ -804,8 +827,12 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         /* Has the mouse pointer crossed screens? */
         if (s_pScreen != miPointerGetScreen(g_pwinPointer))
             miPointerSetScreen(g_pwinPointer, s_pScreenInfo->dwScreen,
-                               GET_X_LPARAM(lParam) - s_pScreenInfo->dwXOffset,
-                               GET_Y_LPARAM(lParam) - s_pScreenInfo->dwYOffset);
+                               winScaleToX(s_pScreenInfo,
+                                           GET_X_LPARAM(lParam))
+                               - s_pScreenInfo->dwXOffset,
+                               winScaleToX(s_pScreenInfo,
+                                           GET_Y_LPARAM(lParam))
+                               - s_pScreenInfo->dwYOffset);
 
         /* Are we tracking yet? */
         if (!s_fTracking) {
@@ -840,8 +867,10 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         }
 
         /* Deliver absolute cursor position to X Server */
-        winEnqueueMotion(GET_X_LPARAM(lParam) - s_pScreenInfo->dwXOffset,
-                         GET_Y_LPARAM(lParam) - s_pScreenInfo->dwYOffset);
+        winEnqueueMotion(winScaleToX(s_pScreenInfo, GET_X_LPARAM(lParam))
+                         - s_pScreenInfo->dwXOffset,
+                         winScaleToX(s_pScreenInfo, GET_Y_LPARAM(lParam))
+                         - s_pScreenInfo->dwYOffset);
         return 0;
 
     case WM_NCMOUSEMOVE:
@@ -1078,6 +1107,11 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         winRemoveKeyboardHookLL();
         return 0;
 
+    case WM_INPUTLANGCHANGE:
+        /* Key messages without a scan code now map to other ones */
+        winKeybdLayoutChanged();
+        break;
+
     case WM_SYSKEYDOWN:
     case WM_KEYDOWN:
         if (s_pScreenPriv == NULL || s_pScreenInfo->fIgnoreInput)
@@ -1262,6 +1296,22 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             gatherWindows();
             return 0;
 
+        case ID_APP_STATISTICS:
+            winToggleStatsWindow();
+            return 0;
+
+#ifdef XSERVER_REQUEST_PROFILE
+        case ID_APP_DUMP_PROFILE:
+            DumpRequestProfile();
+            return 0;
+#endif
+
+#ifdef XSERVER_INPUT_LATENCY
+        case ID_APP_DUMP_LATENCY:
+            DumpInputLatency();
+            return 0;
+#endif
+
         case ID_APP_ABOUT:
             /* Display the About box */
             winDisplayAboutDialog(s_pScreenPriv);
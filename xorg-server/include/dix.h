@@ -224,6 +224,28 @@ EnableLimitedSchedulingLatency(void);
 void
 DisableLimitedSchedulingLatency(void);
 
+#ifdef XSERVER_REQUEST_PROFILE
+extern _X_EXPORT void DumpRequestProfile(void);
+#endif
+
+#ifdef XSERVER_INPUT_LATENCY
+typedef struct _InputLatency {
+    CARD64 received;            /* when the DDX received the input, or 0 */
+    CARD64 mark;                /* when the last stage ended, 0 if unused */
+} InputLatencyRec;
+
+extern _X_EXPORT void InputLatencyReceived(CARD32 /* queuedMillis */ );
+extern void InputLatencyEnqueued(InputLatencyRec * /* latency */ ,
+                                 Bool /* merged */ );
+extern void InputLatencyBeginEvent(const InputLatencyRec * /* latency */ );
+extern void InputLatencyEndEvent(void);
+extern void InputLatencyWritten(ClientPtr /* client */ );
+extern void InputLatencyFlushed(ClientPtr /* client */ );
+extern _X_EXPORT void DumpInputLatency(void);
+extern _X_EXPORT void InputLatencyTotal(CARD64 * /* count */ ,
+                                        CARD64 * /* micros */ );
+#endif
+
 typedef void (*ServerBlockHandlerProcPtr) (void *blockData,
                                            void *timeout);
 
@@ -73,6 +73,14 @@ typedef struct _saveSet {
 #define SaveSetAssignToRoot(ss,tr)  ((ss).toRoot = (tr))
 #define SaveSetAssignMap(ss,m)      ((ss).map = (m))
 
+/* Always kept, for the X-Resource extension */
+typedef struct _ClientStats {
+    CARD64 requests;            /* dispatched */
+    CARD64 dispatch_us;         /* spent reading and running them */
+    CARD64 bytes_in;            /* read from the connection */
+    CARD64 bytes_out;           /* written to the connection */
+} ClientStatsRec;
+
 typedef struct _Client {
     void *requestBuffer;
     void *osPrivate;             /* for OS layer, including scheduler */
@@ -107,6 +115,11 @@ typedef struct _Client {
 
     int smart_start_tick;
     int smart_stop_tick;
+    struct _SchedStats *sched_stats;    /* only with -schedstats */
+    ClientStatsRec stats;
+#ifdef XSERVER_INPUT_LATENCY
+    InputLatencyRec input_latency;      /* oldest event not yet flushed */
+#endif
 
     DeviceIntPtr clientPtr;
     ClientIdPtr clientIds;
@@ -127,6 +140,8 @@ extern long SmartScheduleTime;
 extern long SmartScheduleInterval;
 extern long SmartScheduleSlice;
 extern long SmartScheduleMaxSlice;
+extern Bool SmartScheduleStats;
+extern CARD64 RequestsDispatched;       /* by all clients, ever */
 #ifdef HAVE_SETITIMER
 extern Bool SmartScheduleSignalEnable;
 #else
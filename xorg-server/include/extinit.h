@@ -60,6 +60,7 @@ extern void CompositeExtensionInit(void);
 
 #ifdef DAMAGE
 extern _X_EXPORT Bool noDamageExtension;
+extern _X_EXPORT int DamageCoalesceInterval;
 extern void DamageExtensionInit(void);
 #endif
 
@@ -119,6 +120,8 @@ extern void SyncExtensionInit(void);
 
 extern void XCMiscExtensionInit(void);
 
+extern void ImageDeltaExtensionInit(void);
+
 #ifdef XCSECURITY
 extern _X_EXPORT Bool noSecurityExtension;
 extern void SecurityExtensionInit(void);
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Frame timing trace (XSERVER_FRAME_TRACE)
+ *
+ * Begin and end markers around the stages a frame goes through: requests
+ * in Dispatch(), damage processing, the shadow update and the DDX blit,
+ * GLX swaps, and the work of the clipboard and window manager threads.
+ * The markers go to ETW on Windows and, with -frametrace, to a trace file
+ * which Perfetto and chrome://tracing open.  Until one of them is on, a
+ * marker only tests FrameTraceOn.
+ *
+ * The header only needs plain C, so the Xlib clients running inside the
+ * server, like the clipboard thread, can use it too.  Names must stay
+ * valid for as long as the server runs and need no quoting in JSON.
+ */
+
+#ifndef FRAMETRACE_H
+#define FRAMETRACE_H
+
+#ifdef XSERVER_FRAME_TRACE
+
+#include <X11/Xfuncproto.h>
+
+extern _X_EXPORT volatile int FrameTraceOn;
+extern _X_EXPORT const char *FrameTracePath;
+
+extern _X_EXPORT void FrameTraceInit(void);
+extern _X_EXPORT void FrameTraceFlush(void);
+extern _X_EXPORT void FrameTraceBegin(const char * /* name */ );
+extern _X_EXPORT void FrameTraceEnd(const char * /* name */ );
+
+#define FRAME_TRACE_BEGIN(name) \
+    do { if (FrameTraceOn) FrameTraceBegin(name); } while (0)
+#define FRAME_TRACE_END(name) \
+    do { if (FrameTraceOn) FrameTraceEnd(name); } while (0)
+
+#else
+
+#define FRAME_TRACE_BEGIN(name) do { } while (0)
+#define FRAME_TRACE_END(name) do { } while (0)
+
+#endif
+
+#endif /* FRAMETRACE_H */
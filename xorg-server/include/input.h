@@ -72,6 +72,7 @@ SOFTWARE.
 #define POINTER_NORAW		(1 << 5)        /* Don't generate RawEvents */
 #define POINTER_EMULATED	(1 << 6)        /* Event was emulated from another event */
 #define POINTER_DESKTOP		(1 << 7)        /* Data in desktop coordinates */
+#define POINTER_RAWONLY		(1 << 8)        /* Only generate RawEvents */
 
 /* GetTouchEvent flags */
 #define TOUCH_ACCEPT            (1 << 0)
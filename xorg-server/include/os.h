@@ -125,6 +125,14 @@ extern _X_EXPORT void SetCriticalOutputPending(void);
 extern _X_EXPORT int WriteToClient(ClientPtr /*who */ , int /*count */ ,
                                    const void * /*buf */ );
 
+extern _X_EXPORT int WriteCoalescableToClient(ClientPtr /*who */ ,
+                                              int /*count */ ,
+                                              const void * /*buf */ );
+
+extern _X_EXPORT void *CoalescableClientEvent(ClientPtr /*who */ );
+
+extern _X_EXPORT int ClientPendingOutput(ClientPtr /*who */ );
+
 extern _X_EXPORT void ResetOsBuffers(void);
 
 extern _X_EXPORT int TransIsListening(char *protocol);
@@ -186,6 +194,7 @@ extern void ForceClockId(clockid_t /* forced_clockid */);
 
 extern _X_EXPORT CARD32 GetTimeInMillis(void);
 extern _X_EXPORT CARD64 GetTimeInMicros(void);
+extern _X_EXPORT CARD64 GetTimeInMicrosPrecise(void);
 
 extern _X_EXPORT void AdjustWaitForDelay(void *waitTime, int newdelay);
 
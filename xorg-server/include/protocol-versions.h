@@ -152,7 +152,7 @@
 
 /* Resource */
 #define SERVER_XRES_MAJOR_VERSION		1
-#define SERVER_XRES_MINOR_VERSION		2
+#define SERVER_XRES_MINOR_VERSION		3
 
 /* XvMC */
 #define SERVER_XVMC_MAJOR_VERSION		1
@@ -24,7 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define X_REGISTRY_RESOURCE       1
 #endif
 
-#if defined(XSELINUX) || defined(XCSECURITY) || defined(XSERVER_DTRACE)
+#if defined(XSELINUX) || defined(XCSECURITY) || defined(XSERVER_DTRACE) || \
+    defined(XSERVER_REQUEST_PROFILE) || defined(XSERVER_FRAME_TRACE)
 #define X_REGISTRY_REQUEST        1
 #endif
 
@@ -65,6 +65,8 @@ SOFTWARE.
 #define WT_NOMATCH 3
 #define NullWindow ((WindowPtr) 0)
 
+extern _X_EXPORT unsigned int windowTreeSerial;
+
 /* Forward declaration, we can't include input.h here */
 struct _DeviceIntRec;
 struct _Cursor;
@@ -197,6 +197,8 @@ typedef struct _XkbSrvInfo {
     XkbSrvCheckRepeatPtr checkRepeat;
 
     char overlay_perkey_state[256/8]; /* bitfield */
+
+    struct _XkbReplyCache *replyCache;  /* see XkbInvalidateReplyCache */
 } XkbSrvInfoRec, *XkbSrvInfoPtr;
 
 #define	XkbSLI_IsDefault	(1L<<0)
@@ -804,6 +806,12 @@ extern _X_EXPORT void XkbFreeSrvLedInfo(XkbSrvLedInfoPtr        /* sli */
 extern _X_EXPORT void XkbFreeInfo(XkbSrvInfoPtr /* xkbi */
     );
 
+extern _X_EXPORT void XkbFreeReplyCache(XkbSrvInfoPtr /* xkbi */
+    );
+
+extern _X_EXPORT void XkbInvalidateReplyCache(DeviceIntPtr /* dev */
+    );
+
 extern _X_EXPORT Status XkbChangeTypesOfKey(XkbDescPtr /* xkb */ ,
                                             int /* key */ ,
                                             int /* nGroups */ ,
@@ -892,6 +900,9 @@ extern _X_EXPORT XkbDescPtr XkbCompileKeymap(DeviceIntPtr /* dev */ ,
                                              XkbRMLVOSet *      /* rmlvo */
     );
 
+extern _X_EXPORT Bool XkbDDXPrecacheKeymap(XkbRMLVOSet * /* rmlvo */
+    );
+
 extern _X_EXPORT XkbDescPtr XkbCompileKeymapFromString(DeviceIntPtr dev,
 						       const char *keymap,
 						       int keymap_length);
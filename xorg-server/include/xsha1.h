@@ -1,6 +1,8 @@
 #ifndef XSHA1_H
 #define XSHA1_H
 
+#include <stdint.h>
+
 /* Initialize SHA1 computation.  Returns NULL on error. */
 void *x_sha1_init(void);
 
@@ -16,4 +18,12 @@ int x_sha1_update(void *ctx, void *data, int size);
  */
 int x_sha1_final(void *ctx, unsigned char result[20]);
 
+/*
+ * Hash size bytes of data and the 128 bits of seed into result with a
+ * fast hash which is not cryptographic, for finding duplicates where
+ * nobody gains from forging a collision.
+ */
+void x_hash128(const void *data, int size, uint64_t seed_lo, uint64_t seed_hi,
+               unsigned char result[16]);
+
 #endif
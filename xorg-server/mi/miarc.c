@@ -749,16 +749,67 @@ tailX(double K,
     return xs[0];
 }
 
+/*
+ * The spans of a wide ellipse only depend on its size and the line width,
+ * and plotting programs draw the same few sizes over and over, so the ones
+ * most recently computed are kept.  Entries belong to the cache: a caller
+ * may only use the last one it was given, up to its next call, which is
+ * all the arc code needs.
+ */
+#define ARC_CACHE_SIZE		64
+#define ARC_CACHE_MAX_BYTES	(1024 * 1024)
+
+typedef struct {
+    unsigned short width, height;
+    int lw;
+    unsigned long lrustamp;
+    size_t bytes;
+    miArcSpanData *spdata;
+} miArcCacheRec;
+
+static miArcCacheRec arcCache[ARC_CACHE_SIZE];
+static unsigned long arcCacheStamp;
+static size_t arcCacheBytes;
+
+static void
+miArcCacheEvict(miArcCacheRec * ent)
+{
+    arcCacheBytes -= ent->bytes;
+    free(ent->spdata);
+    ent->spdata = NULL;
+    ent->bytes = 0;
+}
+
 static miArcSpanData *
 miComputeWideEllipse(int lw, xArc * parc)
 {
     miArcSpanData *spdata = NULL;
+    miArcCacheRec *ent, *victim;
+    size_t bytes;
     int k;
 
     if (!lw)
         lw = 1;
+
+    victim = &arcCache[0];
+    for (ent = arcCache; ent < &arcCache[ARC_CACHE_SIZE]; ent++) {
+        if (!ent->spdata) {
+            if (victim->spdata)
+                victim = ent;
+            continue;
+        }
+        if (ent->width == parc->width && ent->height == parc->height &&
+            ent->lw == lw) {
+            ent->lrustamp = ++arcCacheStamp;
+            return ent->spdata;
+        }
+        if (victim->spdata && ent->lrustamp < victim->lrustamp)
+            victim = ent;
+    }
+
     k = (parc->height >> 1) + ((lw - 1) >> 1);
-    spdata = malloc(sizeof(miArcSpanData) + sizeof(miArcSpan) * (k + 2));
+    bytes = sizeof(miArcSpanData) + sizeof(miArcSpan) * (k + 2);
+    spdata = malloc(bytes);
     if (!spdata)
         return NULL;
     spdata->spans = (miArcSpan *) (spdata + 1);
@@ -769,6 +820,30 @@ miComputeWideEllipse(int lw, xArc * parc)
         miComputeCircleSpans(lw, parc, spdata);
     else
         miComputeEllipseSpans(lw, parc, spdata);
+
+    if (victim->spdata)
+        miArcCacheEvict(victim);
+    victim->width = parc->width;
+    victim->height = parc->height;
+    victim->lw = lw;
+    victim->lrustamp = ++arcCacheStamp;
+    victim->bytes = bytes;
+    victim->spdata = spdata;
+    arcCacheBytes += bytes;
+
+    /* Keep the cache small, dropping the oldest entries but the new one */
+    while (arcCacheBytes > ARC_CACHE_MAX_BYTES) {
+        miArcCacheRec *oldest = NULL;
+
+        for (ent = arcCache; ent < &arcCache[ARC_CACHE_SIZE]; ent++)
+            if (ent->spdata && ent != victim &&
+                (!oldest || ent->lrustamp < oldest->lrustamp))
+                oldest = ent;
+        if (!oldest)
+            break;
+        miArcCacheEvict(oldest);
+    }
+
     return spdata;
 }
 
@@ -873,7 +948,6 @@ miFillWideEllipse(DrawablePtr pDraw, GCPtr pGC, xArc * parc)
             wids += 2;
         }
     }
-    free(spdata);
     (*pGC->ops->FillSpans) (pDraw, pGC, pts - points, points, widths, FALSE);
 
     free(widths);
@@ -912,9 +986,7 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
 
     if (width == 0 && pGC->lineStyle == LineSolid) {
         for (i = narcs, parc = parcs; --i >= 0; parc++) {
-            miArcSpanData *spdata;
-            spdata = miArcSegment(pDraw, pGC, *parc, NULL, NULL, NULL);
-            free(spdata);
+            miArcSegment(pDraw, pGC, *parc, NULL, NULL, NULL);
         }
         fillSpans(pDraw, pGC);
         return;
@@ -1045,10 +1117,8 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
             arcData = &polyArcs[iphase].arcs[i];
             if (spdata) {
                 if (lastArc.width != arcData->arc.width ||
-                    lastArc.height != arcData->arc.height) {
-                    free(spdata);
+                    lastArc.height != arcData->arc.height)
                     spdata = NULL;
-                }
             }
             memcpy(&lastArc, &arcData->arc, sizeof(xArc));
             spdata = miArcSegment(pDrawTo, pGCTo, arcData->arc,
@@ -1110,8 +1180,6 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
                 }
             }
         }
-        free(spdata);
-        spdata = NULL;
     }
     miFreeArcs(polyArcs, pGC);
 
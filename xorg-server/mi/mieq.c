@@ -73,6 +73,9 @@ typedef struct _Event {
     InternalEvent *events;
     ScreenPtr pScreen;
     DeviceIntPtr pDev;          /* device this event _originated_ from */
+#ifdef XSERVER_INPUT_LATENCY
+    InputLatencyRec latency;
+#endif
 } EventRec, *EventPtr;
 
 typedef struct _EventQueue {
@@ -259,6 +262,11 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
     miEventQueue.events[oldtail].pScreen = pDev ? EnqueueScreen(pDev) : NULL;
     miEventQueue.events[oldtail].pDev = pDev;
 
+#ifdef XSERVER_INPUT_LATENCY
+    InputLatencyEnqueued(&miEventQueue.events[oldtail].latency,
+                         oldtail != miEventQueue.tail);
+#endif
+
     miEventQueue.lastMotion = isMotion;
     miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
 }
@@ -505,6 +513,9 @@ mieqProcessInputEvents(void)
     ScreenPtr screen;
     InternalEvent event;
     DeviceIntPtr dev = NULL, master = NULL;
+#ifdef XSERVER_INPUT_LATENCY
+    InputLatencyRec latency;
+#endif
     static Bool inProcessInputEvents = FALSE;
 
     input_lock();
@@ -531,6 +542,9 @@ mieqProcessInputEvents(void)
         event = *e->events;
         dev = e->pDev;
         screen = e->pScreen;
+#ifdef XSERVER_INPUT_LATENCY
+        latency = e->latency;
+#endif
 
         miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
 
@@ -548,7 +562,13 @@ mieqProcessInputEvents(void)
             DPMSSet(serverClient, DPMSModeOn);
 #endif
 
+#ifdef XSERVER_INPUT_LATENCY
+        InputLatencyBeginEvent(&latency);
+#endif
         mieqProcessDeviceEvent(dev, &event, screen);
+#ifdef XSERVER_INPUT_LATENCY
+        InputLatencyEndEvent();
+#endif
 
         /* Update the sprite now. Next event may be from different device. */
         if (master &&
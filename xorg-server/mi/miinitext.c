@@ -122,6 +122,7 @@ static const ExtensionModule staticExtensions[] = {
     {SyncExtensionInit, "SYNC", NULL},
     {XkbExtensionInit, "XKEYBOARD", NULL},
     {XCMiscExtensionInit, "XC-MISC", NULL},
+    {ImageDeltaExtensionInit, "IMAGE-DELTA", NULL},
 #ifdef XCSECURITY
     {SecurityExtensionInit, "SECURITY", &noSecurityExtension},
 #endif
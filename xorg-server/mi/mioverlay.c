@@ -940,6 +940,7 @@ miOverlayMoveWindow(WindowPtr pWin,
         }
         (*pScreen->MarkOverlappedWindows) (pWin, pWin, NULL);
     }
+    windowTreeSerial++;
     pWin->origin.x = x + (int) bw;
     pWin->origin.y = y + (int) bw;
     x = pWin->drawable.x = pParent->drawable.x + x + (int) bw;
@@ -1185,6 +1186,7 @@ miOverlayResizeWindow(WindowPtr pWin,
             }
         }
     }
+    windowTreeSerial++;
     pWin->origin.x = x + bw;
     pWin->origin.y = y + bw;
     pWin->drawable.height = h;
@@ -1497,6 +1499,7 @@ miOverlayChangeBorderWidth(WindowPtr pWin, unsigned int width)
     if (WasViewable && (width < oldwidth))
         (*pScreen->MarkOverlappedWindows) (pWin, pWin, NULL);
 
+    windowTreeSerial++;
     pWin->borderWidth = width;
     SetBorderSize(pWin);
 
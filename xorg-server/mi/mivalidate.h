@@ -41,6 +41,8 @@ typedef union _Validate {
         RegionPtr borderVisible;        /* visible region of border, */
         /* non-null when size changes */
         Bool resized;           /* unclipped winSize has changed */
+        Bool unchanged;         /* only marked for overlapping a changed */
+        /* sibling; its subtree was not touched */
     } before;
     struct AfterValidate {
         RegionRec exposed;      /* exposed regions, absolute pos */
@@ -177,6 +177,82 @@ miShapedWindowIn(RegionPtr universe, RegionPtr bounding,
 				    HasBorder(w) && \
 				    (w)->backgroundState == ParentRelative)
 
+/*
+ * When enabled, the clips miComputeClips would keep are recomputed anyway,
+ * with a complaint about any that come out different
+ */
+#ifdef _DEBUG
+#define VALTREE_CHECK_ENABLE 1
+#else
+#define VALTREE_CHECK_ENABLE 0
+#endif
+
+/*
+ * A window marked only for overlapping a sibling which was configured
+ * (see miMarkOverlappedWindows) has the same clips as before if its new
+ * universe is its old borderClip, and so do its inferiors, as long as none
+ * of them was marked for any other reason.
+ */
+static Bool
+miClipsUnchanged(WindowPtr pParent, RegionPtr universe)
+{
+    WindowPtr pChild;
+
+    if (!RegionEqual(universe, &pParent->borderClip))
+        return FALSE;
+
+    pChild = pParent;
+    while (1) {
+        if (pChild->valdata && (pChild->valdata == UnmapValData ||
+                                !pChild->valdata->before.unchanged))
+            return FALSE;
+        if (pChild->viewable) {
+#ifdef COMPOSITE
+            if (pChild->redirectDraw != RedirectDrawNone)
+                return FALSE;
+#endif
+            if (pChild->firstChild) {
+                pChild = pChild->firstChild;
+                continue;
+            }
+        }
+        while (!pChild->nextSib && (pChild != pParent))
+            pChild = pChild->parent;
+        if (pChild == pParent)
+            break;
+        pChild = pChild->nextSib;
+    }
+    return TRUE;
+}
+
+/*
+ * Leave pParent and its inferiors with their clips, and nothing exposed
+ */
+static void
+miKeepClips(WindowPtr pParent)
+{
+    WindowPtr pChild;
+
+    pChild = pParent;
+    while (1) {
+        if (pChild->viewable) {
+            if (pChild->valdata) {
+                RegionNull(&pChild->valdata->after.borderExposed);
+                RegionNull(&pChild->valdata->after.exposed);
+            }
+            if (pChild->firstChild) {
+                pChild = pChild->firstChild;
+                continue;
+            }
+        }
+        while (!pChild->nextSib && (pChild != pParent))
+            pChild = pChild->parent;
+        if (pChild == pParent)
+            break;
+        pChild = pChild->nextSib;
+    }
+}
+
 /*
  *-----------------------------------------------------------------------
  * miComputeClips --
@@ -278,6 +354,37 @@ miComputeClips(WindowPtr pParent,
     if (pParent->valdata==UnmapValData)
       return; // return if no valid valdata
 
+    /*
+     * skip the subtree of a sibling the configured window did not
+     * actually reach
+     */
+    if (kind != VTBroken && pParent->valdata->before.unchanged &&
+        miClipsUnchanged(pParent, universe)) {
+#if VALTREE_CHECK_ENABLE
+        RegionRec oldBorderClip, oldClipList;
+
+        RegionNull(&oldBorderClip);
+        RegionNull(&oldClipList);
+        RegionCopy(&oldBorderClip, &pParent->borderClip);
+        RegionCopy(&oldClipList, &pParent->clipList);
+
+        pParent->valdata->before.unchanged = FALSE;
+        miComputeClips(pParent, pScreen, universe, kind, exposed);
+
+        if (!RegionEqual(&oldBorderClip, &pParent->borderClip) ||
+            !RegionEqual(&oldClipList, &pParent->clipList) ||
+            RegionNotEmpty(&pParent->valdata->after.exposed) ||
+            RegionNotEmpty(&pParent->valdata->after.borderExposed))
+            ErrorF("miComputeClips: clips of window 0x%x were kept but "
+                   "have changed\n", (unsigned int) pParent->drawable.id);
+        RegionUninit(&oldBorderClip);
+        RegionUninit(&oldClipList);
+#else
+        miKeepClips(pParent);
+#endif
+        return;
+    }
+
     dx = pParent->drawable.x - pParent->valdata->before.oldAbsCorner.x;
     dy = pParent->drawable.y - pParent->valdata->before.oldAbsCorner.y;
 
@@ -122,13 +122,18 @@ miMarkWindow(WindowPtr pWin)
 {
     ValidatePtr val;
 
-    if (pWin->valdata)
+    if (pWin->valdata) {
+        /* marked again by whatever is changing it */
+        if (pWin->valdata != UnmapValData)
+            pWin->valdata->before.unchanged = FALSE;
         return;
+    }
     val = (ValidatePtr) xnfalloc(sizeof(ValidateRec));
     val->before.oldAbsCorner.x = pWin->drawable.x;
     val->before.oldAbsCorner.y = pWin->drawable.y;
     val->before.borderVisible = NullRegion;
     val->before.resized = FALSE;
+    val->before.unchanged = FALSE;
     val->after.borderExposed.data= 0; // unitialised member--> causes crash
     pWin->valdata = val;
 }
@@ -182,7 +187,18 @@ miMarkOverlappedWindows(WindowPtr pWin, WindowPtr pFirst, WindowPtr *ppLayerWin)
                 if (RegionBroken(&pChild->borderSize))
                     SetBorderSize(pChild);
                 if (RegionContainsRect(&pChild->borderSize, box)) {
+                    /*
+                     * pChild itself is unchanged, only its clips might be;
+                     * let miComputeClips keep them if they come out the same
+                     */
+                    Bool unchanged = !pChild->valdata ||
+                        (pChild->valdata != UnmapValData &&
+                         pChild->valdata->before.unchanged);
+
                     (*MarkWindow) (pChild);
+                    if (unchanged && pChild->valdata &&
+                        pChild->valdata != UnmapValData)
+                        pChild->valdata->before.unchanged = TRUE;
                     anyMarked = TRUE;
                     if (pChild->firstChild) {
                         pChild = pChild->firstChild;
@@ -267,6 +283,7 @@ miMoveWindow(WindowPtr pWin, int x, int y, WindowPtr pNextSib, VTKind kind)
         RegionCopy(oldRegion, &pWin->borderClip);
         anyMarked = (*pScreen->MarkOverlappedWindows) (pWin, pWin, &pLayerWin);
     }
+    windowTreeSerial++;
     pWin->origin.x = x + (int) bw;
     pWin->origin.y = y + (int) bw;
     x = pWin->drawable.x = pParent->drawable.x + x + (int) bw;
@@ -429,6 +446,7 @@ miResizeWindow(WindowPtr pWin, int x, int y, unsigned int w, unsigned int h,
             }
         }
     }
+    windowTreeSerial++;
     pWin->origin.x = x + bw;
     pWin->origin.y = y + bw;
     pWin->drawable.height = h;
@@ -702,6 +720,7 @@ miChangeBorderWidth(WindowPtr pWin, unsigned int width)
     if (WasViewable && width < oldwidth)
         anyMarked = (*pScreen->MarkOverlappedWindows) (pWin, pWin, &pLayerWin);
 
+    windowTreeSerial++;
     pWin->borderWidth = width;
     SetBorderSize(pWin);
 
@@ -746,15 +765,220 @@ miMarkUnrealizedWindow(WindowPtr pChild, WindowPtr pWin, Bool fromConfigure)
     }
 }
 
-WindowPtr
-miSpriteTrace(SpritePtr pSprite, int x, int y)
+/*
+ * Finding the window under the pointer walks each level's children in
+ * stacking order.  Parents whose children take a long walk, such as the
+ * root in multiwindow mode or a Java frame with thousands of children, get
+ * a grid over their children's bounding boxes, so only the children that
+ * could contain the point are tested.  The grids are dropped whenever the
+ * window tree changes, and only built again once a few lookups have been
+ * made without it changing, so moving or resizing windows doesn't pay for
+ * rebuilding them.
+ */
+
+#define CHILD_INDEX_MIN         32      /* children walked before indexing */
+#define CHILD_INDEX_STABLE      4       /* lookups before building a grid */
+#define CHILD_INDEX_CACHE       8       /* parents with a grid */
+#define CHILD_INDEX_BIG         64      /* cells a child may cover */
+
+typedef struct _ChildIndex {
+    WindowPtr parent;
+    unsigned int serial;        /* windowTreeSerial when last checked */
+    int lookups;
+    unsigned int lastUsed;
+
+    /* the grid, if built */
+    WindowPtr *children;        /* in stacking order, top first */
+    int numChildren;
+    BoxRec bounds;              /* of all children */
+    int shift;                  /* cells are 1 << shift pixels square */
+    int cols, rows;
+    int *cellStart;             /* into cellChildren, cols * rows + 1 */
+    int *cellChildren;          /* stacking positions of children by cell */
+    int *bigChildren;           /* ... of children covering many cells */
+    int numBig;
+} ChildIndexRec, *ChildIndexPtr;
+
+static ChildIndexRec childIndexCache[CHILD_INDEX_CACHE];
+static unsigned int childIndexClock;
+
+static void
+miChildIndexFree(ChildIndexPtr index)
+{
+    free(index->children);
+    free(index->cellStart);
+    free(index->cellChildren);
+    free(index->bigChildren);
+    index->children = NULL;
+    index->cellStart = NULL;
+    index->cellChildren = NULL;
+    index->bigChildren = NULL;
+}
+
+static void
+miChildBox(WindowPtr pWin, BoxPtr box)
+{
+    int bw = wBorderWidth(pWin);
+
+    box->x1 = pWin->drawable.x - bw;
+    box->y1 = pWin->drawable.y - bw;
+    box->x2 = pWin->drawable.x + (int) pWin->drawable.width + bw;
+    box->y2 = pWin->drawable.y + (int) pWin->drawable.height + bw;
+}
+
+/* the cells covered by a box, which must be inside the bounds */
+static void
+miChildCells(ChildIndexPtr index, BoxPtr box, BoxPtr cells)
+{
+    cells->x1 = (box->x1 - index->bounds.x1) >> index->shift;
+    cells->y1 = (box->y1 - index->bounds.y1) >> index->shift;
+    cells->x2 = (box->x2 - 1 - index->bounds.x1) >> index->shift;
+    cells->y2 = (box->y2 - 1 - index->bounds.y1) >> index->shift;
+}
+
+static Bool
+miChildIndexBuild(ChildIndexPtr index)
+{
+    WindowPtr pParent = index->parent, pChild;
+    BoxRec box, cells;
+    int n, i, x, y, c, count, cover;
+    int *fill;
+
+    for (n = 0, pChild = pParent->firstChild; pChild; pChild = pChild->nextSib)
+        n++;
+    index->children = xallocarray(n, sizeof(WindowPtr));
+    if (!index->children)
+        return FALSE;
+
+    /* empty children can't be hit, so they are left out of the grid */
+    index->numChildren = n;
+    index->bounds.x1 = index->bounds.y1 = INT_MAX;
+    index->bounds.x2 = index->bounds.y2 = INT_MIN;
+    for (i = 0, pChild = pParent->firstChild; pChild;
+         i++, pChild = pChild->nextSib) {
+        index->children[i] = pChild;
+        miChildBox(pChild, &box);
+        if (box.x1 >= box.x2 || box.y1 >= box.y2)
+            continue;
+        index->bounds.x1 = min(index->bounds.x1, box.x1);
+        index->bounds.y1 = min(index->bounds.y1, box.y1);
+        index->bounds.x2 = max(index->bounds.x2, box.x2);
+        index->bounds.y2 = max(index->bounds.y2, box.y2);
+    }
+    if (index->bounds.x1 >= index->bounds.x2) {
+        index->bounds.x1 = index->bounds.x2 = 0;
+        index->bounds.y1 = index->bounds.y2 = 0;
+    }
+
+    /* about as many cells as children, none smaller than 16 pixels */
+    for (index->shift = 4;; index->shift++) {
+        index->cols = ((index->bounds.x2 - index->bounds.x1 - 1)
+                       >> index->shift) + 1;
+        index->rows = ((index->bounds.y2 - index->bounds.y1 - 1)
+                       >> index->shift) + 1;
+        if (index->cols * index->rows <= max(n, 16))
+            break;
+    }
+
+    index->cellStart = calloc(index->cols * index->rows + 1, sizeof(int));
+    index->bigChildren = xallocarray(n, sizeof(int));
+    if (!index->cellStart || !index->bigChildren)
+        return FALSE;
+
+    /* count the children in each cell, then place them in stacking order */
+    for (count = 0, i = 0; i < n; i++) {
+        miChildBox(index->children[i], &box);
+        if (box.x1 >= box.x2 || box.y1 >= box.y2)
+            continue;
+        miChildCells(index, &box, &cells);
+        cover = (cells.x2 - cells.x1 + 1) * (cells.y2 - cells.y1 + 1);
+        if (cover > CHILD_INDEX_BIG)
+            continue;
+        for (y = cells.y1; y <= cells.y2; y++)
+            for (x = cells.x1; x <= cells.x2; x++)
+                index->cellStart[y * index->cols + x + 1]++;
+        count += cover;
+    }
+    for (c = 0; c < index->cols * index->rows; c++)
+        index->cellStart[c + 1] += index->cellStart[c];
+
+    index->cellChildren = xallocarray(max(count, 1), sizeof(int));
+    fill = xallocarray(max(index->cols * index->rows, 1), sizeof(int));
+    if (!index->cellChildren || !fill) {
+        free(fill);
+        return FALSE;
+    }
+    memcpy(fill, index->cellStart, index->cols * index->rows * sizeof(int));
+    for (index->numBig = 0, i = 0; i < n; i++) {
+        miChildBox(index->children[i], &box);
+        if (box.x1 >= box.x2 || box.y1 >= box.y2)
+            continue;
+        miChildCells(index, &box, &cells);
+        cover = (cells.x2 - cells.x1 + 1) * (cells.y2 - cells.y1 + 1);
+        if (cover > CHILD_INDEX_BIG) {
+            index->bigChildren[index->numBig++] = i;
+            continue;
+        }
+        for (y = cells.y1; y <= cells.y2; y++)
+            for (x = cells.x1; x <= cells.x2; x++)
+                index->cellChildren[fill[y * index->cols + x]++] = i;
+    }
+    free(fill);
+    return TRUE;
+}
+
+/*
+ * The index for pParent if it has one, noting the lookup and building the
+ * grid if it is now due.
+ */
+static ChildIndexPtr
+miChildIndexFind(WindowPtr pParent)
+{
+    ChildIndexPtr index;
+    int i;
+
+    for (i = 0; i < CHILD_INDEX_CACHE; i++) {
+        index = &childIndexCache[i];
+        if (index->parent != pParent)
+            continue;
+        index->lastUsed = ++childIndexClock;
+        if (index->serial != windowTreeSerial) {
+            miChildIndexFree(index);
+            index->serial = windowTreeSerial;
+            index->lookups = 0;
+        }
+        if (!index->children && ++index->lookups >= CHILD_INDEX_STABLE &&
+            !miChildIndexBuild(index))
+            miChildIndexFree(index);
+        return index;
+    }
+    return NULL;
+}
+
+/* Start counting lookups for a parent with many children */
+static void
+miChildIndexAdd(WindowPtr pParent)
+{
+    ChildIndexPtr index = &childIndexCache[0];
+    int i;
+
+    for (i = 1; i < CHILD_INDEX_CACHE; i++) {
+        if (childIndexCache[i].lastUsed < index->lastUsed)
+            index = &childIndexCache[i];
+    }
+    miChildIndexFree(index);
+    index->parent = pParent;
+    index->serial = windowTreeSerial;
+    index->lookups = 1;
+    index->lastUsed = ++childIndexClock;
+}
+
+static Bool
+miPointInChild(WindowPtr pWin, int x, int y)
 {
-    WindowPtr pWin;
     BoxRec box;
 
-    pWin = DeepestSpriteWin(pSprite)->firstChild;
-    while (pWin) {
-        if ((pWin->mapped) &&
+    return ((pWin->mapped) &&
             (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
             (x < pWin->drawable.x + (int) pWin->drawable.width +
              wBorderWidth(pWin)) &&
@@ -774,18 +998,64 @@ miSpriteTrace(SpritePtr pSprite, int x, int y)
              * they're in X's stack. (E.g. if the native window system
              * implements some form of virtual desktop system).
              */
-            && !pWin->unhittable) {
-            if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
-                pSprite->spriteTraceSize += 10;
-                pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
-                                                    pSprite->spriteTraceSize,
-                                                    sizeof(WindowPtr));
-            }
-            pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
-            pWin = pWin->firstChild;
+            && !pWin->unhittable);
+}
+
+/* The topmost child of pParent containing the point, if any */
+static WindowPtr
+miChildAtPoint(WindowPtr pParent, int x, int y)
+{
+    ChildIndexPtr index = miChildIndexFind(pParent);
+    WindowPtr pWin;
+    int walked;
+
+    if (index && index->children) {
+        int cell, i, end, big, c;
+
+        if (x < index->bounds.x1 || x >= index->bounds.x2 ||
+            y < index->bounds.y1 || y >= index->bounds.y2)
+            return NullWindow;
+        cell = ((y - index->bounds.y1) >> index->shift) * index->cols +
+            ((x - index->bounds.x1) >> index->shift);
+        i = index->cellStart[cell];
+        end = index->cellStart[cell + 1];
+        big = 0;
+        /* merge the cell's children with the big ones, top first */
+        while (i < end || big < index->numBig) {
+            if (big == index->numBig ||
+                (i < end && index->cellChildren[i] < index->bigChildren[big]))
+                c = index->cellChildren[i++];
+            else
+                c = index->bigChildren[big++];
+            if (miPointInChild(index->children[c], x, y))
+                return index->children[c];
         }
-        else
-            pWin = pWin->nextSib;
+        return NullWindow;
+    }
+
+    for (walked = 0, pWin = pParent->firstChild; pWin;
+         walked++, pWin = pWin->nextSib) {
+        if (miPointInChild(pWin, x, y))
+            break;
+    }
+    if (!index && walked >= CHILD_INDEX_MIN)
+        miChildIndexAdd(pParent);
+    return pWin;
+}
+
+WindowPtr
+miSpriteTrace(SpritePtr pSprite, int x, int y)
+{
+    WindowPtr pWin;
+
+    while ((pWin = miChildAtPoint(DeepestSpriteWin(pSprite), x, y))) {
+        if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
+            pSprite->spriteTraceSize += 10;
+            pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
+                                                pSprite->spriteTraceSize,
+                                                sizeof(WindowPtr));
+        }
+        pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
     }
     return DeepestSpriteWin(pSprite);
 }
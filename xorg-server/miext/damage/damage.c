@@ -25,6 +25,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #include    <X11/X.h>
 #include    "scrnintstr.h"
@@ -40,6 +41,7 @@
 #include    "gcstruct.h"
 #include    "damage.h"
 #include    "damagestr.h"
+#include    "frametrace.h"
 
 #define wrap(priv, real, mem, func) {\
     priv->mem = real->mem; \
@@ -121,6 +123,71 @@ getDrawableDamageRef(DrawablePtr pDrawable)
     DamagePtr	*pPrev = (DamagePtr *) \
 	dixLookupPrivateAddr(&(pWindow)->devPrivates, damageWinPrivateKey)
 
+/*
+ * Damage that no one looks at until later is kept as a plain list of
+ * boxes and only unioned into pDamage->damage when the region is read,
+ * so a burst of small draws costs one batched union instead of one
+ * union per draw.  A list that would grow past DAMAGE_MAX_BOXES is
+ * folded into the region first.
+ */
+#define DAMAGE_MIN_BOXES    16
+#define DAMAGE_MAX_BOXES    256
+
+static void
+damageFlushBoxes(DamagePtr pDamage)
+{
+    RegionRec boxes;
+
+    if (!pDamage->nBoxes)
+        return;
+
+    if (RegionInitBoxes(&boxes, pDamage->pBoxes, pDamage->nBoxes))
+        RegionUnion(&pDamage->damage, &pDamage->damage, &boxes);
+    else {
+        /* Out of memory; over-reporting the bounds is safe */
+        BoxRec box = pDamage->pBoxes[0];
+        int i;
+
+        for (i = 1; i < pDamage->nBoxes; i++) {
+            box.x1 = min(box.x1, pDamage->pBoxes[i].x1);
+            box.y1 = min(box.y1, pDamage->pBoxes[i].y1);
+            box.x2 = max(box.x2, pDamage->pBoxes[i].x2);
+            box.y2 = max(box.y2, pDamage->pBoxes[i].y2);
+        }
+        RegionUninit(&boxes);
+        RegionInit(&boxes, &box, 1);
+        RegionUnion(&pDamage->damage, &pDamage->damage, &boxes);
+    }
+    RegionUninit(&boxes);
+    pDamage->nBoxes = 0;
+}
+
+static void
+damageAccumulate(DamagePtr pDamage, RegionPtr pRegion)
+{
+    int n = RegionNumRects(pRegion);
+
+    if (pDamage->nBoxes + n > pDamage->sizeBoxes) {
+        BoxPtr pBoxes = NULL;
+        int size = max(pDamage->sizeBoxes, DAMAGE_MIN_BOXES);
+
+        while (size < pDamage->nBoxes + n)
+            size *= 2;
+        if (size <= DAMAGE_MAX_BOXES)
+            pBoxes = reallocarray(pDamage->pBoxes, size, sizeof(BoxRec));
+        if (!pBoxes) {
+            damageFlushBoxes(pDamage);
+            RegionUnion(&pDamage->damage, &pDamage->damage, pRegion);
+            return;
+        }
+        pDamage->pBoxes = pBoxes;
+        pDamage->sizeBoxes = size;
+    }
+    memcpy(pDamage->pBoxes + pDamage->nBoxes, RegionRects(pRegion),
+           n * sizeof(BoxRec));
+    pDamage->nBoxes += n;
+}
+
 #if DAMAGE_DEBUG_ENABLE
 static void
 _damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
@@ -265,7 +332,7 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, pDamageRegion);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+                damageAccumulate(pDamage, pDamageRegion);
         }
 
         /*
@@ -287,20 +354,20 @@ damageRegionProcessPending(DrawablePtr pDrawable)
 {
     drawableDamage(pDrawable);
 
+    FRAME_TRACE_BEGIN("Damage");
     for (; pDamage != NULL; pDamage = pDamage->pNext) {
         if (pDamage->reportAfter) {
             /* It's possible that there is only interest in postRendering reporting. */
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, &pDamage->pendingDamage);
-            else
-                RegionUnion(&pDamage->damage, &pDamage->damage,
-                            &pDamage->pendingDamage);
+            else if (RegionNotEmpty(&pDamage->pendingDamage))
+                damageAccumulate(pDamage, &pDamage->pendingDamage);
         }
 
         if (pDamage->reportAfter)
             RegionEmpty(&pDamage->pendingDamage);
     }
-
+    FRAME_TRACE_END("Damage");
 }
 
 #if DAMAGE_DEBUG_ENABLE
@@ -1889,6 +1956,7 @@ DamageDestroy(DamagePtr pDamage)
     (*pScrPriv->funcs.Destroy) (pDamage);
     RegionUninit(&pDamage->damage);
     RegionUninit(&pDamage->pendingDamage);
+    free(pDamage->pBoxes);
     free(pDamage);
 }
 
@@ -1899,6 +1967,7 @@ DamageSubtract(DamagePtr pDamage, const RegionPtr pRegion)
     RegionRec pixmapClip;
     DrawablePtr pDrawable = pDamage->pDrawable;
 
+    damageFlushBoxes(pDamage);
     RegionSubtract(&pDamage->damage, &pDamage->damage, pRegion);
     if (pDrawable) {
         if (pDrawable->type == DRAWABLE_WINDOW)
@@ -1925,12 +1994,14 @@ DamageSubtract(DamagePtr pDamage, const RegionPtr pRegion)
 void
 DamageEmpty(DamagePtr pDamage)
 {
+    pDamage->nBoxes = 0;
     RegionEmpty(&pDamage->damage);
 }
 
 RegionPtr
 DamageRegion(DamagePtr pDamage)
 {
+    damageFlushBoxes(pDamage);
     return &pDamage->damage;
 }
 
@@ -1987,10 +2058,11 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
 
     switch (pDamage->damageLevel) {
     case DamageReportRawRegion:
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, pDamageRegion);
         (*pDamage->damageReport) (pDamage, pDamageRegion, pDamage->closure);
         break;
     case DamageReportDeltaRegion:
+        damageFlushBoxes(pDamage);
         RegionNull(&tmpRegion);
         RegionSubtract(&tmpRegion, pDamageRegion, &pDamage->damage);
         if (RegionNotEmpty(&tmpRegion)) {
@@ -2000,6 +2072,7 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
         RegionUninit(&tmpRegion);
         break;
     case DamageReportBoundingBox:
+        damageFlushBoxes(pDamage);
         tmpBox = *RegionExtents(&pDamage->damage);
         RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
         if (!BOX_SAME(&tmpBox, RegionExtents(&pDamage->damage))) {
@@ -2008,6 +2081,7 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
         }
         break;
     case DamageReportNonEmpty:
+        damageFlushBoxes(pDamage);
         was_empty = !RegionNotEmpty(&pDamage->damage);
         RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
         if (was_empty && RegionNotEmpty(&pDamage->damage)) {
@@ -2016,7 +2090,7 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
         }
         break;
     case DamageReportNone:
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, pDamageRegion);
         break;
     }
 }
@@ -49,6 +49,10 @@ typedef struct _damage {
     Bool reportAfter;
     RegionRec pendingDamage;    /* will be flushed post submission at the latest */
     ScreenPtr pScreen;
+
+    BoxPtr pBoxes;              /* damage not yet unioned into damage */
+    int nBoxes;
+    int sizeBoxes;
 } DamageRec;
 
 typedef struct _damageScrPriv {
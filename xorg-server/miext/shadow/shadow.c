@@ -35,6 +35,7 @@
 #include    "globals.h"
 #include    "gcstruct.h"
 #include    "shadow.h"
+#include    "frametrace.h"
 
 static DevPrivateKeyRec shadowScrPrivateKeyRec;
 #define shadowScrPrivateKey (&shadowScrPrivateKeyRec)
@@ -62,8 +63,10 @@ shadowRedisplay(ScreenPtr pScreen)
         return;
     pRegion = DamageRegion(pBuf->pDamage);
     if (RegionNotEmpty(pRegion)) {
+        FRAME_TRACE_BEGIN("ShadowUpdate");
         (*pBuf->update) (pScreen, pBuf);
         DamageEmpty(pBuf->pDamage);
+        FRAME_TRACE_END("ShadowUpdate");
     }
 }
 
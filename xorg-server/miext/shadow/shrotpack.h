@@ -44,6 +44,7 @@
 #include    "gcstruct.h"
 #include    "shadow.h"
 #include    "fb.h"
+#include    "shrow.h"
 
 #define DANDEBUG         0
 
@@ -176,15 +177,29 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
                     ("   |   |   |-> Writing Line - Metrics: win=%x, sha=%x\n",
                      win, sha);
 #endif
-                while (i--) {
+                if (sizeof(Data) == sizeof(CARD32)) {
+                    (*shadowRow32) ((CARD32 *) win, (const CARD32 *) sha,
+                                    i, SHASTEPX(shaStride));
+                    win += i;
+                    sha += i * SHASTEPX(shaStride);
+                }
+                else if (sizeof(Data) == sizeof(CARD16)) {
+                    (*shadowRow16) ((CARD16 *) win, (const CARD16 *) sha,
+                                    i, SHASTEPX(shaStride));
+                    win += i;
+                    sha += i * SHASTEPX(shaStride);
+                }
+                else {
+                    while (i--) {
 #if(DANDEBUG > 6)
-                    ErrorF
-                        ("   |   |   |-> Writing Pixel - Metrics: win=%x, sha=%d, remaining=%d\n",
-                         win, sha, i);
+                        ErrorF
+                            ("   |   |   |-> Writing Pixel - Metrics: win=%x, sha=%d, remaining=%d\n",
+                             win, sha, i);
 #endif
-                    *win++ = *sha;
-                    sha += SHASTEPX(shaStride);
-                }               /*  i */
+                        *win++ = *sha;
+                        sha += SHASTEPX(shaStride);
+                    }           /*  i */
+                }
             }                   /*  width */
             shaLine += SHASTEPY(shaStride);
             NEXTY(x, y, w, h);
@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Runtime selected SSE2 and AVX2 row kernels for the rotated shadow
+ * update functions, detected the same way pixman-x86.c does.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <string.h>
+
+#include "shrow.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SHADOW_ROW_X86
+#endif
+
+#ifdef SHADOW_ROW_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHADOW_TARGET_SSE2
+#define SHADOW_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SHADOW_TARGET_SSE2 __attribute__((target("sse2")))
+#define SHADOW_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/*
+ * Plain C reference kernels
+ */
+
+static void
+shadowRow16Generic(CARD16 *dst, const CARD16 *src, int n, int step)
+{
+    while (n--) {
+        *dst++ = *src;
+        src += step;
+    }
+}
+
+static void
+shadowRow32Generic(CARD32 *dst, const CARD32 *src, int n, int step)
+{
+    while (n--) {
+        *dst++ = *src;
+        src += step;
+    }
+}
+
+#ifdef SHADOW_ROW_X86
+
+/*
+ * SSE2 kernels: straight copies go to memcpy, reversed copies are done
+ * eight (16bpp) or four (32bpp) pixels at a time.  Column walks have no
+ * gather instruction to work with, so they stay in C.
+ */
+
+static void SHADOW_TARGET_SSE2
+shadowRow16SSE2(CARD16 *dst, const CARD16 *src, int n, int step)
+{
+    if (step == 1) {
+        memcpy(dst, src, n * sizeof(CARD16));
+        return;
+    }
+    if (step == -1) {
+        while (n >= 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (src - 7));
+
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+            _mm_storeu_si128((__m128i *) dst, v);
+            dst += 8;
+            src -= 8;
+            n -= 8;
+        }
+    }
+    shadowRow16Generic(dst, src, n, step);
+}
+
+static void SHADOW_TARGET_SSE2
+shadowRow32SSE2(CARD32 *dst, const CARD32 *src, int n, int step)
+{
+    if (step == 1) {
+        memcpy(dst, src, n * sizeof(CARD32));
+        return;
+    }
+    if (step == -1) {
+        while (n >= 8) {
+            __m128i v0 = _mm_loadu_si128((const __m128i *) (src - 3));
+            __m128i v1 = _mm_loadu_si128((const __m128i *) (src - 7));
+
+            v0 = _mm_shuffle_epi32(v0, _MM_SHUFFLE(0, 1, 2, 3));
+            v1 = _mm_shuffle_epi32(v1, _MM_SHUFFLE(0, 1, 2, 3));
+            _mm_storeu_si128((__m128i *) dst, v0);
+            _mm_storeu_si128((__m128i *) (dst + 4), v1);
+            dst += 8;
+            src -= 8;
+            n -= 8;
+        }
+    }
+    shadowRow32Generic(dst, src, n, step);
+}
+
+/*
+ * AVX2 kernels: 256 bit reversed copies, and gathers for the 32bpp
+ * column walks.  A 16bpp gather would have to load a 32 bit word per
+ * pixel and could read past the end of the shadow, so 16bpp column
+ * walks stay in C.
+ */
+
+static void SHADOW_TARGET_AVX2
+shadowRow16AVX2(CARD16 *dst, const CARD16 *src, int n, int step)
+{
+    if (step == 1) {
+        memcpy(dst, src, n * sizeof(CARD16));
+        return;
+    }
+    if (step == -1) {
+        const __m256i reverse = _mm256_setr_epi8(14, 15, 12, 13, 10, 11,
+                                                 8, 9, 6, 7, 4, 5, 2, 3,
+                                                 0, 1,
+                                                 14, 15, 12, 13, 10, 11,
+                                                 8, 9, 6, 7, 4, 5, 2, 3,
+                                                 0, 1);
+
+        while (n >= 16) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) (src - 15));
+
+            v = _mm256_shuffle_epi8(v, reverse);
+            v = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 3, 2));
+            _mm256_storeu_si256((__m256i *) dst, v);
+            dst += 16;
+            src -= 16;
+            n -= 16;
+        }
+    }
+    shadowRow16Generic(dst, src, n, step);
+}
+
+static void SHADOW_TARGET_AVX2
+shadowRow32AVX2(CARD32 *dst, const CARD32 *src, int n, int step)
+{
+    if (step == 1) {
+        memcpy(dst, src, n * sizeof(CARD32));
+        return;
+    }
+    if (step == -1) {
+        const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+        while (n >= 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) (src - 7));
+
+            _mm256_storeu_si256((__m256i *) dst,
+                                _mm256_permutevar8x32_epi32(v, reverse));
+            dst += 8;
+            src -= 8;
+            n -= 8;
+        }
+    }
+    else {
+        const __m256i index =
+            _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                               _mm256_set1_epi32(step));
+
+        while (n >= 8) {
+            _mm256_storeu_si256((__m256i *) dst,
+                                _mm256_i32gather_epi32((const int *) src,
+                                                       index, 4));
+            dst += 8;
+            src += 8 * step;
+            n -= 8;
+        }
+    }
+    shadowRow32Generic(dst, src, n, step);
+}
+
+#define SHADOW_CPU_SSE2	(1 << 0)
+#define SHADOW_CPU_AVX2	(1 << 1)
+
+static void
+shadowCpuid(unsigned int leaf, unsigned int *regs)
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuidex(info, leaf, 0);
+    regs[0] = info[0];
+    regs[1] = info[1];
+    regs[2] = info[2];
+    regs[3] = info[3];
+#else
+    if (!__get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]))
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+static unsigned long long
+shadowXgetbv(void)
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int a, d;
+
+    __asm__ __volatile__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return ((unsigned long long) d << 32) | a;
+#endif
+}
+
+static int
+shadowCpuFeatures(void)
+{
+    unsigned int regs[4];
+    int features = 0;
+
+    shadowCpuid(0, regs);
+    if (regs[0] < 1)
+        return 0;
+    shadowCpuid(1, regs);
+
+    if (regs[3] & (1 << 26))
+        features |= SHADOW_CPU_SSE2;
+
+    /* AVX2 needs the OS to save the YMM state as well */
+    if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28))
+        && (shadowXgetbv() & 6) == 6) {
+        shadowCpuid(0, regs);
+        if (regs[0] >= 7) {
+            shadowCpuid(7, regs);
+            if (regs[1] & (1 << 5))
+                features |= SHADOW_CPU_AVX2;
+        }
+    }
+
+    return features;
+}
+
+#endif /* SHADOW_ROW_X86 */
+
+const shadowRowImplRec *
+shadowRowImplementations(void)
+{
+    static shadowRowImplRec impls[4];
+
+    if (impls[0].name == NULL) {
+        int n = 0;
+#ifdef SHADOW_ROW_X86
+        int features = shadowCpuFeatures();
+#endif
+
+        impls[n].name = "generic";
+        impls[n].row16 = shadowRow16Generic;
+        impls[n].row32 = shadowRow32Generic;
+        n++;
+#ifdef SHADOW_ROW_X86
+        if (features & SHADOW_CPU_SSE2) {
+            impls[n].name = "sse2";
+            impls[n].row16 = shadowRow16SSE2;
+            impls[n].row32 = shadowRow32SSE2;
+            n++;
+        }
+        if (features & SHADOW_CPU_AVX2) {
+            impls[n].name = "avx2";
+            impls[n].row16 = shadowRow16AVX2;
+            impls[n].row32 = shadowRow32AVX2;
+            n++;
+        }
+#endif
+    }
+
+    return impls;
+}
+
+/*
+ * The kernel pointers start out at resolvers, which replace them with
+ * the fastest implementation the first time a rotated update runs.
+ */
+
+static void
+shadowRowSelect(void)
+{
+    const shadowRowImplRec *impl = shadowRowImplementations();
+
+    while (impl[1].name != NULL)
+        impl++;
+    shadowRow16 = impl->row16;
+    shadowRow32 = impl->row32;
+}
+
+static void
+shadowRow16Resolve(CARD16 *dst, const CARD16 *src, int n, int step)
+{
+    shadowRowSelect();
+    (*shadowRow16) (dst, src, n, step);
+}
+
+static void
+shadowRow32Resolve(CARD32 *dst, const CARD32 *src, int n, int step)
+{
+    shadowRowSelect();
+    (*shadowRow32) (dst, src, n, step);
+}
+
+ShadowRow16Proc shadowRow16 = shadowRow16Resolve;
+ShadowRow32Proc shadowRow32 = shadowRow32Resolve;
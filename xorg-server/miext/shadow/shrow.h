@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _SHROW_H_
+#define _SHROW_H_
+
+#include <X11/Xmd.h>
+
+/*
+ * Row kernels used by the rotated shadow update functions.
+ *
+ * Each one copies n pixels to the contiguous dst, reading them from src,
+ * src + step, src + 2 * step, ...  step is 1 for an unrotated copy, -1
+ * for 180 degrees and plus or minus the shadow stride for 90 and 270
+ * degrees.
+ */
+
+typedef void (*ShadowRow16Proc) (CARD16 *dst, const CARD16 *src,
+                                 int n, int step);
+typedef void (*ShadowRow32Proc) (CARD32 *dst, const CARD32 *src,
+                                 int n, int step);
+
+/* The fastest kernels the CPU supports, picked on first use */
+extern ShadowRow16Proc shadowRow16;
+extern ShadowRow32Proc shadowRow32;
+
+typedef struct _shadowRowImpl {
+    const char *name;
+    ShadowRow16Proc row16;
+    ShadowRow32Proc row32;
+} shadowRowImplRec, *shadowRowImplPtr;
+
+/*
+ * All kernel sets the CPU can run, the plain C reference first and the
+ * fastest last, terminated by an entry with a NULL name.
+ */
+extern const shadowRowImplRec *shadowRowImplementations(void);
+
+#endif /* _SHROW_H_ */
@@ -105,15 +105,176 @@ struct _OsTimerRec {
 static void DoTimer(OsTimerPtr timer, CARD32 now);
 static void DoTimers(CARD32 now);
 static void CheckAllTimers(void);
-static volatile struct xorg_list timers;
 
-static inline OsTimerPtr
+/*
+ * Pending timers live in a hierarchical timer wheel, so that setting and
+ * cancelling one doesn't depend on how many others there are.  The root
+ * level has one slot per millisecond for the next TIMER_ROOT_SIZE ms; each
+ * slot of an upper level covers a whole turn of the level below it, and is
+ * cascaded down as soon as timer_base enters the range it covers.
+ * timer_base is the next millisecond to be processed; timers already due
+ * sit in its slot.
+ * Everything here is protected by the input lock.
+ */
+#define TIMER_ROOT_BITS         8
+#define TIMER_LEVEL_BITS        6
+#define TIMER_LEVELS            4
+#define TIMER_ROOT_SIZE         (1 << TIMER_ROOT_BITS)
+#define TIMER_LEVEL_SIZE        (1 << TIMER_LEVEL_BITS)
+#define TIMER_SLOTS             (TIMER_ROOT_SIZE + TIMER_LEVELS * TIMER_LEVEL_SIZE)
+#define TIMER_SHIFT(l)          (TIMER_ROOT_BITS + (l) * TIMER_LEVEL_BITS)
+#define TIMER_ROOT_SLOT(t)      ((t) & (TIMER_ROOT_SIZE - 1))
+#define TIMER_LEVEL_INDEX(l, t) (((t) >> TIMER_SHIFT(l)) & (TIMER_LEVEL_SIZE - 1))
+#define TIMER_LEVEL_SLOT(l, t)  (TIMER_ROOT_SIZE + (l) * TIMER_LEVEL_SIZE + \
+                                 TIMER_LEVEL_INDEX(l, t))
+
+static struct xorg_list timer_wheel[TIMER_SLOTS];
+static CARD32 timer_base;
+static int timer_count;
+static OsTimerPtr timer_next;           /* earliest timer, if timer_next_valid */
+static Bool timer_next_valid;
+
+static void
+timer_enqueue(OsTimerPtr timer)
+{
+    CARD32 delta = timer->expires - timer_base;
+    int slot, l;
+
+    if ((int) delta < 0)
+        slot = TIMER_ROOT_SLOT(timer_base);
+    else if (delta < TIMER_ROOT_SIZE)
+        slot = TIMER_ROOT_SLOT(timer->expires);
+    else {
+        for (l = 0; l < TIMER_LEVELS - 1; l++)
+            if (delta < (CARD32) 1 << TIMER_SHIFT(l + 1))
+                break;
+        slot = TIMER_LEVEL_SLOT(l, timer->expires);
+    }
+    xorg_list_append(&timer->list, &timer_wheel[slot]);
+    timer_count++;
+
+    if (timer_next_valid &&
+        (!timer_next || (int) (timer->expires - timer_next->expires) < 0))
+        timer_next = timer;
+}
+
+static inline Bool timer_pending(OsTimerPtr timer) {
+    return !xorg_list_is_empty(&timer->list);
+}
+
+static void
+timer_dequeue(OsTimerPtr timer)
+{
+    if (!timer_pending(timer))
+        return;
+    xorg_list_del(&timer->list);
+    timer_count--;
+    if (timer == timer_next)
+        timer_next_valid = FALSE;
+}
+
+/* Move the timers of the slot of this level timer_base has just entered
+ * down to the levels below; returns that slot's index. */
+static int
+timer_cascade(int level)
+{
+    struct xorg_list *slot = &timer_wheel[TIMER_LEVEL_SLOT(level, timer_base)];
+    struct xorg_list moving;
+    OsTimerPtr timer;
+
+    xorg_list_init(&moving);
+    while (!xorg_list_is_empty(slot)) {
+        timer = xorg_list_first_entry(slot, struct _OsTimerRec, list);
+        timer_dequeue(timer);
+        xorg_list_append(&timer->list, &moving);
+    }
+    while (!xorg_list_is_empty(&moving)) {
+        timer = xorg_list_first_entry(&moving, struct _OsTimerRec, list);
+        xorg_list_del(&timer->list);
+        timer_enqueue(timer);
+    }
+    return TIMER_LEVEL_INDEX(level, timer_base);
+}
+
+/* Re-file every timer relative to a new base, after time has rewound */
+static void
+timer_rebase(CARD32 now)
+{
+    struct xorg_list moving;
+    OsTimerPtr timer, tmp;
+    int i;
+
+    xorg_list_init(&moving);
+    for (i = 0; i < TIMER_SLOTS; i++) {
+        xorg_list_for_each_entry_safe(timer, tmp, &timer_wheel[i], list) {
+            xorg_list_del(&timer->list);
+            xorg_list_append(&timer->list, &moving);
+        }
+    }
+    timer_base = now;
+    timer_count = 0;
+    timer_next_valid = FALSE;
+    while (!xorg_list_is_empty(&moving)) {
+        timer = xorg_list_first_entry(&moving, struct _OsTimerRec, list);
+        xorg_list_del(&timer->list);
+        timer_enqueue(timer);
+    }
+}
+
+static OsTimerPtr
+timer_earliest(OsTimerPtr best, struct xorg_list *slot)
+{
+    OsTimerPtr timer;
+
+    xorg_list_for_each_entry(timer, slot, list)
+        if (!best || (int) (timer->expires - best->expires) < 0)
+            best = timer;
+    return best;
+}
+
+/*
+ * Within each level the first non-empty slot, starting from the one
+ * timer_base will reach next, holds that level's earliest timers, so the
+ * earliest timer overall is found by looking at one slot per level.
+ */
+static OsTimerPtr
 first_timer(void)
 {
-    /* inline xorg_list_is_empty which can't handle volatile */
-    if (timers.next == &timers)
-        return NULL;
-    return xorg_list_first_entry(&timers, struct _OsTimerRec, list);
+    OsTimerPtr best = NULL;
+    int i, l;
+
+    if (timer_next_valid)
+        return timer_next;
+
+    if (timer_count) {
+        for (i = 0; i < TIMER_ROOT_SIZE; i++) {
+            struct xorg_list *slot =
+                &timer_wheel[TIMER_ROOT_SLOT(timer_base + i)];
+
+            if (!xorg_list_is_empty(slot)) {
+                best = timer_earliest(best, slot);
+                break;
+            }
+        }
+        for (l = 0; l < TIMER_LEVELS; l++) {
+            CARD32 next = TIMER_LEVEL_INDEX(l, timer_base) + 1;
+
+            for (i = 0; i < TIMER_LEVEL_SIZE; i++) {
+                struct xorg_list *slot =
+                    &timer_wheel[TIMER_ROOT_SIZE + l * TIMER_LEVEL_SIZE +
+                                 ((next + i) & (TIMER_LEVEL_SIZE - 1))];
+
+                if (!xorg_list_is_empty(slot)) {
+                    best = timer_earliest(best, slot);
+                    break;
+                }
+            }
+        }
+    }
+
+    timer_next = best;
+    timer_next_valid = TRUE;
+    return best;
 }
 
 /*
@@ -124,16 +285,24 @@ static int
 check_timers(void)
 {
     OsTimerPtr timer;
+    CARD32 expires, delta;
 
+    input_lock();
     if ((timer = first_timer()) != NULL) {
+        expires = timer->expires;
+        delta = timer->delta;
+    }
+    input_unlock();
+
+    if (timer != NULL) {
         CARD32 now = GetTimeInMillis();
-        int timeout = timer->expires - now;
+        int timeout = expires - now;
 
         if (timeout <= 0) {
             DoTimers(now);
         } else {
             /* Make sure the timeout is sane */
-            if (timeout < timer->delta + 250)
+            if (timeout < delta + 250)
                 return timeout;
 
             /* time has rewound.  reset the timers. */
@@ -202,10 +371,7 @@ WaitForSomething(Bool are_ready)
         if (dispatchException)
             i = -1;
         else
-        {
-            if (!timeout) timeout=10; /* Avoid a 100 % usage loop, timeout is in milliseconds */
             i = ospoll_wait(server_poll, timeout);
-        }
         pollerr = GetErrno();
         if (i <= 0) {           /* An error or timeout occurred */
             if (dispatchException)
@@ -327,28 +493,28 @@ AdjustWaitForDelay(void *waitTime, int newdelay)
         *timeoutp = newdelay;
 }
 
-static inline Bool timer_pending(OsTimerPtr timer) {
-    return !xorg_list_is_empty(&timer->list);
-}
-
 /* If time has rewound, re-run every affected timer.
- * Timers might drop out of the list, so we have to restart every time. */
+ * Timers might drop out of the wheel, so we have to restart every time. */
 static void
 CheckAllTimers(void)
 {
     OsTimerPtr timer;
     CARD32 now;
+    int i;
 
     input_lock();
  start:
     now = GetTimeInMillis();
 
-    xorg_list_for_each_entry(timer, &timers, list) {
-        if (timer->expires - now > timer->delta + 250) {
-            DoTimer(timer, now);
-            goto start;
+    for (i = 0; i < TIMER_SLOTS; i++) {
+        xorg_list_for_each_entry(timer, &timer_wheel[i], list) {
+            if (timer->expires - now > timer->delta + 250) {
+                DoTimer(timer, now);
+                goto start;
+            }
         }
     }
+    timer_rebase(now);
     input_unlock();
 }
 
@@ -357,7 +523,7 @@ DoTimer(OsTimerPtr timer, CARD32 now)
 {
     CARD32 newTime;
 
-    xorg_list_del(&timer->list);
+    timer_dequeue(timer);
     newTime = (*timer->callback) (timer, now, timer->arg);
     if (newTime)
         TimerSet(timer, 0, newTime, timer->callback, timer->arg);
@@ -366,13 +532,40 @@ DoTimer(OsTimerPtr timer, CARD32 now)
 static void
 DoTimers(CARD32 now)
 {
-    OsTimerPtr  timer;
+    struct xorg_list expired;
+    struct xorg_list *slot;
+    OsTimerPtr timer;
+    int l;
 
     input_lock();
-    while ((timer = first_timer())) {
-        if ((int) (timer->expires - now) > 0)
+    while ((int) (now - timer_base) >= 0) {
+        if (!timer_count) {
+            timer_base = now + 1;
             break;
-        DoTimer(timer, now);
+        }
+
+        /* callbacks may set timers which land in this slot again, a
+         * turn later, so take the due ones off it first */
+        slot = &timer_wheel[TIMER_ROOT_SLOT(timer_base)];
+        if (!xorg_list_is_empty(slot)) {
+            xorg_list_init(&expired);
+            while (!xorg_list_is_empty(slot)) {
+                timer = xorg_list_first_entry(slot, struct _OsTimerRec, list);
+                xorg_list_del(&timer->list);
+                xorg_list_append(&timer->list, &expired);
+            }
+            while (!xorg_list_is_empty(&expired)) {
+                timer = xorg_list_first_entry(&expired, struct _OsTimerRec,
+                                              list);
+                DoTimer(timer, now);
+            }
+        }
+        /* entering a new turn of the root level: bring its timers down */
+        if (!TIMER_ROOT_SLOT(++timer_base)) {
+            for (l = 0; l < TIMER_LEVELS; l++)
+                if (timer_cascade(l))
+                    break;
+        }
     }
     input_unlock();
 }
@@ -381,7 +574,6 @@ OsTimerPtr
 TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
          OsTimerCallback func, void *arg)
 {
-    OsTimerPtr existing;
     CARD32 now = GetTimeInMillis();
 
     if (!timer) {
@@ -393,7 +585,7 @@ TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
     else {
         input_lock();
         if (timer_pending(timer)) {
-            xorg_list_del(&timer->list);
+            timer_dequeue(timer);
             if (flags & TimerForceOld)
                 (void) (*timer->callback) (timer, now, timer->arg);
         }
@@ -413,12 +605,10 @@ TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
     timer->arg = arg;
     input_lock();
 
-    /* Sort into list */
-    xorg_list_for_each_entry(existing, &timers, list)
-        if ((int) (existing->expires - millis) > 0)
-            break;
-    /* This even works at the end of the list -- existing->list will be timers */
-    xorg_list_append(&timer->list, &existing->list);
+    /* an empty wheel needn't catch up with the time it spent idle */
+    if (!timer_count)
+        timer_base = now;
+    timer_enqueue(timer);
 
     /* Check to see if the timer is ready to run now */
     if ((int) (millis - now) <= 0)
@@ -447,7 +637,7 @@ TimerCancel(OsTimerPtr timer)
     if (!timer)
         return;
     input_lock();
-    xorg_list_del(&timer->list);
+    timer_dequeue(timer);
     input_unlock();
 }
 
@@ -471,16 +661,23 @@ TimerInit(void)
 {
     static Bool been_here;
     OsTimerPtr timer, tmp;
+    int i;
 
     if (!been_here) {
         been_here = TRUE;
-        xorg_list_init((struct xorg_list*) &timers);
+        for (i = 0; i < TIMER_SLOTS; i++)
+            xorg_list_init(&timer_wheel[i]);
     }
 
-    xorg_list_for_each_entry_safe(timer, tmp, &timers, list) {
-        xorg_list_del(&timer->list);
-        free(timer);
+    for (i = 0; i < TIMER_SLOTS; i++) {
+        xorg_list_for_each_entry_safe(timer, tmp, &timer_wheel[i], list) {
+            xorg_list_del(&timer->list);
+            free(timer);
+        }
     }
+    timer_base = GetTimeInMillis();
+    timer_count = 0;
+    timer_next_valid = FALSE;
 }
 
 #ifdef DPMSExtension
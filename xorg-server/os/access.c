@@ -82,6 +82,9 @@ SOFTWARE.
 
 #ifdef WIN32
 #include <X11/Xwinsock.h>
+#ifndef AF_HYPERV
+#define AF_HYPERV 34
+#endif
 #endif
 
 #include <stdio.h>
@@ -217,17 +220,36 @@ typedef struct _host {
     short len;
     unsigned char *addr;
     struct _host *next;
+    struct _host *hashNext;     /* valid hosts: in hostHash */
+    struct _host *siNext;       /* valid hosts: in siHosts */
+    struct _host *net;          /* cidr hosts: their key in hostHash */
     int requested;
 } HOST;
 
 #define MakeHost(h,l)	(h)=malloc(sizeof *(h)+(l));\
 			if (h) { \
 			   (h)->addr=(unsigned char *) ((h) + 1);\
+			   (h)->hashNext = (h)->siNext = (h)->net = NULL; \
 			   (h)->requested = FALSE; \
 			}
 #define FreeHost(h)	free(h)
 static HOST *selfhosts = NULL;
 static HOST *validhosts = NULL;
+
+/* The valid hosts are also hashed on their address, so that checking a
+   connection does not walk the whole list, and the server interpreted ones
+   are kept on a list of their own, as they have to be asked one by one.
+   A "cidr" host adds a key to the hash as well: the block's address with
+   the prefix length appended, which is looked up with the address of the
+   connection masked to each prefix length in use. */
+#define HOST_HASH_SIZE	256
+static HOST *hostHash[HOST_HASH_SIZE];
+static HOST *siHosts = NULL;
+static int cidrHosts = 0;
+static int cidrPrefixes4[33];
+#if defined(IPv6) && defined(AF_INET6)
+static int cidrPrefixes6[129];
+#endif
 static int AccessEnabled = DEFAULT_ACCESS_CONTROL;
 static int LocalHostEnabled = FALSE;
 static int LocalHostRequested = FALSE;
@@ -245,6 +267,10 @@ static Bool siAddrMatch(int family, void *addr, int len, HOST * host,
                         ClientPtr client);
 static int siCheckAddr(const char *addrString, int length);
 static void siTypesInitialize(void);
+#if defined(TCPCONN)
+static int siCidrParse(const char *addrString, int length, int *family,
+                       unsigned char *net, int *prefix);
+#endif
 
 #if NTDDI_VERSION < NTDDI_VISTA
 const char *inet_ntop(int af, const void *src, char *dst, socklen_t cnt)
@@ -1033,8 +1059,16 @@ ResetHosts(const char *display)
     LocalHostEnabled = FALSE;
     while ((host = validhosts) != 0) {
         validhosts = host->next;
+        FreeHost(host->net);
         FreeHost(host);
     }
+    memset(hostHash, 0, sizeof(hostHash));
+    siHosts = NULL;
+    cidrHosts = 0;
+    memset(cidrPrefixes4, 0, sizeof(cidrPrefixes4));
+#if defined(IPv6) && defined(AF_INET6)
+    memset(cidrPrefixes6, 0, sizeof(cidrPrefixes6));
+#endif
 
 #if defined WIN32 && defined __MINGW32__
 #define ETC_HOST_PREFIX "X"
@@ -1084,9 +1118,13 @@ ResetHosts(const char *display)
             }
 #endif
             else if (!strncmp("si:", lhostname, 3)) {
+                /* si:type:value, like xhost takes it, is stored as the
+                   type and the value separated by a NUL */
                 family = FamilyServerInterpreted;
                 hostname = ohostname + 3;
-                hostlen -= 3;
+                hostlen -= 4;
+                if ((ptr = strchr(hostname, ':')) != 0)
+                    *ptr = 0;
             }
 
             if (family == FamilyServerInterpreted) {
@@ -1435,6 +1473,170 @@ ForEachHostInFamily(int family, Bool (*func) (unsigned char *addr,
     return FALSE;
 }
 
+static unsigned
+HostHash(int family, const void *addr, int len)
+{
+    const unsigned char *p = addr;
+    unsigned hash = 2166136261u ^ family;
+
+    while (len-- > 0) {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+    return hash & (HOST_HASH_SIZE - 1);
+}
+
+static HOST *
+HostHashFind(int family, const void *addr, int len)
+{
+    HOST *host;
+
+    for (host = hostHash[HostHash(family, addr, len)]; host;
+         host = host->hashNext)
+        if (addrEqual(family, addr, len, host))
+            return host;
+    return NULL;
+}
+
+static void
+HostHashInsert(HOST *host)
+{
+    HOST **bucket = &hostHash[HostHash(host->family, host->addr, host->len)];
+
+    host->hashNext = *bucket;
+    *bucket = host;
+}
+
+static void
+HostHashRemove(HOST *host)
+{
+    HOST **prev = &hostHash[HostHash(host->family, host->addr, host->len)];
+
+    while (*prev && *prev != host)
+        prev = &(*prev)->hashNext;
+    if (*prev)
+        *prev = host->hashNext;
+}
+
+#if defined(TCPCONN)
+/* Copy an address with the bits past the prefix cleared */
+static void
+CidrMask(unsigned char *net, const unsigned char *addr, int len, int prefix)
+{
+    int i;
+
+    for (i = 0; i < len; i++, prefix -= 8) {
+        if (prefix >= 8)
+            net[i] = addr[i];
+        else if (prefix > 0)
+            net[i] = addr[i] & (0xff << (8 - prefix));
+        else
+            net[i] = 0;
+    }
+}
+
+static int *
+CidrPrefixes(int family)
+{
+    if (family == FamilyInternet)
+        return cidrPrefixes4;
+#if defined(IPv6) && defined(AF_INET6)
+    if (family == FamilyInternet6)
+        return cidrPrefixes6;
+#endif
+    return NULL;
+}
+
+/* Whether the address is in one of the cidr blocks of the valid hosts */
+static Bool
+CidrMatch(int family, const void *addr, int len)
+{
+    unsigned char key[17];
+    int *prefixes = CidrPrefixes(family);
+    int prefix;
+
+    if (!cidrHosts || !prefixes || len + 1 > sizeof(key))
+        return FALSE;
+
+    for (prefix = 0; prefix <= len * 8; prefix++) {
+        if (!prefixes[prefix])
+            continue;
+        CidrMask(key, addr, len, prefix);
+        key[len] = prefix;
+        if (HostHashFind(family, key, len + 1))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static Bool
+IsCidrHost(HOST *host)
+{
+    return host->family == FamilyServerInterpreted && host->len > 5 &&
+        !memcmp(host->addr, "cidr", 5);
+}
+#endif
+
+/* Add a valid host to the hash, and the lists it belongs on */
+static void
+HostIndexAdd(HOST *host)
+{
+    HostHashInsert(host);
+    if (host->family != FamilyServerInterpreted)
+        return;
+
+#if defined(TCPCONN)
+    if (IsCidrHost(host)) {
+        unsigned char net[16];
+        int family, prefix, len;
+        HOST *key;
+
+        len = siCidrParse((const char *) host->addr + 5, host->len - 5,
+                          &family, net, &prefix);
+        if (len > 0) {
+            MakeHost(key, len + 1)
+            if (key) {
+                key->family = family;
+                key->len = len + 1;
+                memcpy(key->addr, net, len);
+                key->addr[len] = prefix;
+                HostHashInsert(key);
+                host->net = key;
+                CidrPrefixes(family)[prefix]++;
+                cidrHosts++;
+                return;
+            }
+        }
+    }
+#endif
+
+    host->siNext = siHosts;
+    siHosts = host;
+}
+
+static void
+HostIndexRemove(HOST *host)
+{
+    HOST **prev;
+
+    HostHashRemove(host);
+    for (prev = &siHosts; *prev; prev = &(*prev)->siNext) {
+        if (*prev == host) {
+            *prev = host->siNext;
+            break;
+        }
+    }
+#if defined(TCPCONN)
+    if (host->net) {
+        HostHashRemove(host->net);
+        CidrPrefixes(host->net->family)[host->net->addr[host->net->len - 1]]--;
+        cidrHosts--;
+        FreeHost(host->net);
+        host->net = NULL;
+    }
+#endif
+}
+
 /* Add a host to the access control list. This is the internal interface
  * called when starting or resetting the server */
 static Bool
@@ -1442,10 +1644,8 @@ NewHost(int family, const void *addr, int len, int addingLocalHosts)
 {
     register HOST *host;
 
-    for (host = validhosts; host; host = host->next) {
-        if (addrEqual(family, addr, len, host))
-            return TRUE;
-    }
+    if (HostHashFind(family, addr, len))
+        return TRUE;
     if (!addingLocalHosts) {    /* Fix for XFree86 bug #156 */
         for (host = selfhosts; host; host = host->next) {
             if (addrEqual(family, addr, len, host)) {
@@ -1462,6 +1662,7 @@ NewHost(int family, const void *addr, int len, int addingLocalHosts)
     memcpy(host->addr, addr, len);
     host->next = validhosts;
     validhosts = host;
+    HostIndexAdd(host);
     return TRUE;
 }
 
@@ -1509,6 +1710,7 @@ RemoveHost(ClientPtr client, int family, unsigned length,       /* of bytes in p
          prev = &host->next);
     if (host) {
         *prev = host->next;
+        HostIndexRemove(host);
         FreeHost(host);
     }
     return Success;
@@ -1612,27 +1814,23 @@ InvalidHost(register struct sockaddr *saddr, int len, ClientPtr client)
              * implicitly enables local connections.
              */
             for (selfhost = selfhosts; selfhost; selfhost = selfhost->next) {
-                for (host = validhosts; host; host = host->next) {
-                    if (addrEqual(selfhost->family, selfhost->addr,
-                                  selfhost->len, host))
-                        return 0;
-                }
+                if (HostHashFind(selfhost->family, selfhost->addr,
+                                 selfhost->len))
+                    return 0;
             }
         }
         else
             return 0;
     }
-    for (host = validhosts; host; host = host->next) {
-        if (host->family == FamilyServerInterpreted) {
-            if (siAddrMatch(family, addr, len, host, client)) {
-                return 0;
-            }
-        }
-        else {
-            if (addr && addrEqual(family, addr, len, host))
-                return 0;
-        }
-
+    if (addr && HostHashFind(family, addr, len))
+        return 0;
+#if defined(TCPCONN)
+    if (addr && CidrMatch(family, addr, len))
+        return 0;
+#endif
+    for (host = siHosts; host; host = host->siNext) {
+        if (siAddrMatch(family, addr, len, host, client))
+            return 0;
     }
     return 1;
 }
@@ -1673,6 +1871,16 @@ ConvertAddr(register struct sockaddr *saddr, int *len, void **addr)
             return FamilyInternet6;
         }
     }
+#endif
+    /* hvsock peers are any virtual machine on this host, or the host of
+       this virtual machine, see Xtranssock.c.  They are not local and no
+       host entry can name them, so they always need authorization. */
+#ifdef WIN32
+    case AF_HYPERV:
+        return -1;
+#elif defined(AF_VSOCK)
+    case AF_VSOCK:
+        return -1;
 #endif
 #endif
     default:
@@ -1722,6 +1930,7 @@ ClientIsLocal(ClientPtr client)
  *
  * hostname	- hostname as defined in IETF RFC 2396
  * ipv6		- IPv6 literal address as defined in IETF RFC's 3513 and <TBD>
+ * cidr		- IPv4 or IPv6 address block, address/prefix-length
  *
  * See xc/doc/specs/SIAddresses for formal definitions of each type.
  */
@@ -2099,6 +2308,92 @@ siIPv6CheckAddr(const char *addrString, int length, void *typePriv)
 }
 #endif                          /* IPv6 */
 
+#if defined(TCPCONN)
+/***
+ * "cidr" server interpreted type
+ *
+ * Allows connections from any address of an IPv4 or IPv6 block, given as
+ * address/prefix-length, like 10.0.0.0/8 or fd00::/8.  The valid hosts of
+ * this type are looked up in the host hash rather than asked one by one,
+ * see CidrMatch().
+ */
+
+#define SI_CIDR_MAXLEN (INET6_ADDRSTRLEN + 4)
+
+/* Parse a block into its masked address and prefix length, returning the
+   length of the address, or -1 if it isn't one */
+static int
+siCidrParse(const char *addrString, int length, int *family,
+            unsigned char *net, int *prefix)
+{
+    char addrbuf[SI_CIDR_MAXLEN];
+    unsigned char addr[16];
+    char *slash, *end;
+    long bits;
+    int len;
+
+    if (length < 3 || length >= SI_CIDR_MAXLEN)
+        return -1;
+    memcpy(addrbuf, addrString, length);
+    addrbuf[length] = '\0';
+
+    slash = strchr(addrbuf, '/');
+    if (!slash || slash[1] == '\0')
+        return -1;
+    *slash++ = '\0';
+    errno = 0;
+    bits = strtol(slash, &end, 10);
+    if (errno || *end != '\0' || bits < 0)
+        return -1;
+
+    if (inet_pton(AF_INET, addrbuf, addr) == 1) {
+        *family = FamilyInternet;
+        len = 4;
+    }
+#if defined(IPv6) && defined(AF_INET6)
+    else if (inet_pton(AF_INET6, addrbuf, addr) == 1) {
+        *family = FamilyInternet6;
+        len = 16;
+    }
+#endif
+    else
+        return -1;
+
+    if (bits > len * 8)
+        return -1;
+    *prefix = bits;
+    CidrMask(net, addr, len, bits);
+    return len;
+}
+
+static Bool
+siCidrAddrMatch(int family, void *addr, int len,
+                const char *siAddr, int siAddrlen, ClientPtr client,
+                void *typePriv)
+{
+    unsigned char net[16], masked[16];
+    int netFamily, prefix, netLen;
+
+    netLen = siCidrParse(siAddr, siAddrlen, &netFamily, net, &prefix);
+    if (netLen < 0 || netFamily != family || netLen != len)
+        return FALSE;
+
+    CidrMask(masked, addr, len, prefix);
+    return memcmp(masked, net, len) == 0;
+}
+
+static int
+siCidrCheckAddr(const char *addrString, int length, void *typePriv)
+{
+    unsigned char net[16];
+    int family, prefix;
+
+    if (siCidrParse(addrString, length, &family, net, &prefix) < 0)
+        return -1;
+    return length;
+}
+#endif                          /* TCPCONN */
+
 #if !defined(NO_LOCAL_CLIENT_CRED)
 /***
  * "localuser" & "localgroup" server interpreted types
@@ -2236,6 +2531,9 @@ siTypesInitialize(void)
 #if defined(IPv6) && defined(AF_INET6)
     siTypeAdd("ipv6", siIPv6AddrMatch, siIPv6CheckAddr, NULL);
 #endif
+#if defined(TCPCONN)
+    siTypeAdd("cidr", siCidrAddrMatch, siCidrCheckAddr, NULL);
+#endif
 #if !defined(NO_LOCAL_CLIENT_CRED)
     siTypeAdd("localuser", siLocalCredAddrMatch, siLocalCredCheckAddr,
               &siLocalUserPriv);
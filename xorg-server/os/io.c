@@ -96,6 +96,8 @@ typedef struct _connectionOutput {
     unsigned char *buf;
     int size;
     int count;
+    int coalesce;               /* offset of an event a newer one may */
+    /* replace, see WriteCoalescableToClient, or -1 */
 } ConnectionOutput;
 
 static ConnectionInputPtr AllocateInputBuffer(void);
@@ -118,6 +120,14 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 
 #define BUFSIZE 16384
 #define BUFWATERMARK 32768
+/* writes at least this large are not copied into the output buffer, but
+   handed to FlushClient to go out along with whatever is pending */
+#define DIRECTWRITESIZE 4096
+/* clients whose requests average at least BULKREQSIZE bytes (PutImage,
+   glyph uploads) keep their input buffer and read ahead several requests
+   at a time, up to READAHEADSIZE */
+#define BULKREQSIZE (BUFSIZE / 2)
+#define READAHEADSIZE (256 * 1024)
 
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
@@ -209,6 +219,11 @@ NextAvailableInput(OsCommPtr oc)
         if (AvailableInput != oc) {
             ConnectionInputPtr aci = AvailableInput->input;
 
+            /* a client uploading bulk data keeps its large buffer */
+            if (AvailableInput->avg_req_size >= BULKREQSIZE) {
+                AvailableInput = NULL;
+                return;
+            }
             if (aci->size > BUFWATERMARK) {
                 free(aci->buffer);
                 free(aci);
@@ -334,6 +349,20 @@ ReadRequestFromClient(ClientPtr client)
                 oci->size = needed;
                 oci->buffer = ibuf;
             }
+            if (oc->avg_req_size >= BULKREQSIZE && oci->size < READAHEADSIZE) {
+                /* room for the next few requests as well, so that bulk
+                 * uploads take fewer reads; failing this is harmless */
+                unsigned int readahead = oc->avg_req_size * 4;
+                char *ibuf;
+
+                if (readahead > READAHEADSIZE)
+                    readahead = READAHEADSIZE;
+                if (readahead > oci->size &&
+                    (ibuf = (char *) realloc(oci->buffer, readahead))) {
+                    oci->size = readahead;
+                    oci->buffer = ibuf;
+                }
+            }
             oci->bufptr = oci->buffer;
             oci->bufcnt = gotnow;
         }
@@ -367,8 +396,9 @@ ReadRequestFromClient(ClientPtr client)
         }
         oci->bufcnt += result;
         gotnow += result;
+        client->stats.bytes_in += result;
         /* free up some space after huge requests */
-        if ((oci->size > BUFWATERMARK) &&
+        if ((oci->size > BUFWATERMARK) && (oc->avg_req_size < BULKREQSIZE) &&
             (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE)) {
             char *ibuf;
 
@@ -428,6 +458,9 @@ ReadRequestFromClient(ClientPtr client)
     }
 
     oci->lenLastReq = needed;
+    /* weight 1/8, so a few large requests are enough to start reading
+     * ahead and a run of small ones stops it again */
+    oc->avg_req_size += ((int) needed - (int) oc->avg_req_size) / 8;
 
     /*
      *  Check to see if client has at least one whole request in the
@@ -663,7 +696,8 @@ AbortClient(ClientPtr client)
 
 /*****************
  * WriteToClient
- *    Copies buf into ClientPtr.buf if it fits (with padding), else
+ *    Copies buf into ClientPtr.buf if it fits (with padding) and is
+ *    smaller than DIRECTWRITESIZE, else
  *    flushes ClientPtr.buf and buf to client.  As of this writing,
  *    every use of WriteToClient is cast to void, and the result
  *    is ignored.  Potentially, this could be used by requests
@@ -690,6 +724,9 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         return 0;
     oc = who->osPrivate;
     oco = oc->output;
+#ifdef XSERVER_INPUT_LATENCY
+    InputLatencyWritten(who);
+#endif
 #ifdef DEBUG_COMMUNICATION
     {
         char info[128];
@@ -742,6 +779,7 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         }
         oc->output = oco;
     }
+    oco->coalesce = -1;
 
     padBytes = padding_for_int32(count);
 
@@ -785,7 +823,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         }
     }
 #endif
-    if (oco->count == 0 || oco->count + count + padBytes > oco->size) {
+    if (oco->count == 0 || count >= DIRECTWRITESIZE ||
+        oco->count + count + padBytes > oco->size) {
         output_pending_clear(who);
         if (!any_output_pending()) {
             CriticalOutputPending = FALSE;
@@ -806,6 +845,66 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
     return count;
 }
 
+/*****************
+ * WriteCoalescableToClient
+ *    Like WriteToClient, for an event which may be overwritten through
+ *    CoalescableClientEvent by a newer one, for as long as it is the last
+ *    thing in the client's output buffer and none of it has been sent.
+ *****************/
+
+int
+WriteCoalescableToClient(ClientPtr who, int count, const void *buf)
+{
+    OsCommPtr oc;
+    ConnectionOutputPtr oco;
+    int before, result;
+
+    if (!count || !who || who == serverClient || who->clientGone)
+        return WriteToClient(who, count, buf);
+
+    oc = who->osPrivate;
+    before = oc->output ? oc->output->count : 0;
+    result = WriteToClient(who, count, buf);
+    if (result == count && !who->clientGone && (oco = oc->output) &&
+        oco->count == before + count)
+        oco->coalesce = before;
+    return result;
+}
+
+/*****************
+ * CoalescableClientEvent
+ *    Returns the unsent event written by the last WriteToClient to who,
+ *    when that was a WriteCoalescableToClient, so it can be replaced in
+ *    place.  Otherwise NULL.
+ *****************/
+
+void *
+CoalescableClientEvent(ClientPtr who)
+{
+    ConnectionOutputPtr oco;
+
+    if (!who || who == serverClient || who->clientGone)
+        return NULL;
+
+    oco = ((OsCommPtr) who->osPrivate)->output;
+    if (!oco || oco->coalesce < 0)
+        return NULL;
+    return oco->buf + oco->coalesce;
+}
+
+/* Bytes queued for the client, not written to its connection yet */
+int
+ClientPendingOutput(ClientPtr who)
+{
+    ConnectionOutputPtr oco;
+
+    if (!who || who == serverClient || who->clientGone)
+        return 0;
+
+    oco = ((OsCommPtr) who->osPrivate)->output;
+    return oco ? oco->count : 0;
+}
+
  /********************
  * FlushClient()
  *    If the client isn't keeping up with us, then we try to continue
@@ -880,6 +979,7 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
 
             errno = 0;
         if (trans_conn && (len = _XSERVTransWritev(trans_conn, iov, i)) >= 0) {
+            who->stats.bytes_out += len;
             written += len;
             notWritten -= len;
             todo = notWritten;
@@ -897,6 +997,10 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
                the rest. */
             output_pending_mark(who);
 
+            /* what is left of the buffer no longer ends in an unsent event */
+            if (written > 0)
+                oco->coalesce = -1;
+
             if (written < oco->count) {
                 if (written > 0) {
                     oco->count -= written;
@@ -920,6 +1024,7 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
                     AbortClient(who);
                     MarkClientException(who);
                     oco->count = 0;
+                    oco->coalesce = -1;
                     return -1;
                 }
                 oco->size = notWritten + BUFSIZE;
@@ -947,6 +1052,7 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
             AbortClient(who);
             MarkClientException(who);
             oco->count = 0;
+            oco->coalesce = -1;
             return -1;
         }
     }
@@ -954,6 +1060,9 @@ FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
     /* everything was flushed out */
     oco->count = 0;
     output_pending_clear(who);
+#ifdef XSERVER_INPUT_LATENCY
+    InputLatencyFlushed(who);
+#endif
 
     if (oco->size > BUFWATERMARK) {
         free(oco->buf);
@@ -1003,6 +1112,7 @@ AllocateOutputBuffer(void)
     }
     oco->size = BUFSIZE;
     oco->count = 0;
+    oco->coalesce = -1;
     return oco;
 }
 
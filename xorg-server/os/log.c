@@ -106,6 +106,16 @@ OR PERFORMANCE OF THIS SOFTWARE.
 #include "xf86bigfontsrv.h"
 #endif
 
+#if defined(WIN32) || INPUTTHREAD
+#define LOG_THREAD 1
+#include <pthread.h>
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#else
+#include <signal.h>
+#endif
+#endif
+
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wformat-nonliteral"
 #endif
@@ -126,6 +136,46 @@ static char *saveBuffer = NULL;
 static int bufferSize = 0, bufferUnused = 0, bufferPos = 0;
 static Bool needBuffer = TRUE;
 
+/* Room for "[%10.3f] " */
+#define LOG_TIME_SIZE 16
+
+#ifdef LOG_THREAD
+/*
+ * Once the log file is open, what goes to it is queued in a ring and
+ * written out by a thread of its own, so that logging verbosely costs the
+ * threads that log little more than formatting their messages.  Every
+ * message carries the time it was logged, which the writer puts in front
+ * of its line.  A message that doesn't fit, and everything logged from a
+ * signal handler or on the way out, is written right away after what is
+ * still queued.
+ */
+#define LOG_RING_SIZE   (256 * 1024)    /* a power of two */
+#define LOG_RING_MASK   (LOG_RING_SIZE - 1)
+#define LOG_RECORD_MAX  4096
+#define LOG_LINE_START  0x80000000U     /* in LogRecord.len */
+#define LOG_THREAD_DELAY 10             /* ms to let a batch gather */
+
+typedef struct _LogRecord {
+    CARD32 len;                 /* of the text following, | LOG_LINE_START */
+    CARD32 time;                /* GetTimeInMillis() when it was logged */
+} LogRecord;
+
+/*
+ * logIOLock is held while writing to the file, and always taken before
+ * logRingLock, which guards the ring.  The writer leaves the ring unlocked
+ * while it writes out what lies between logTail and logHead.
+ */
+static pthread_mutex_t logIOLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t logRingLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t logRingData = PTHREAD_COND_INITIALIZER;
+static pthread_t logThread;
+static char *logRing = NULL;
+static size_t logHead = 0, logTail = 0;   /* free running */
+static Bool logThreadRunning = FALSE;
+static Bool logThreadWaiting = FALSE;   /* for logRingData */
+static Bool logThreadAtExit = FALSE;
+#endif
+
 #ifdef __APPLE__
 #include <AvailabilityMacros.h>
 
@@ -187,6 +237,296 @@ strlen_sigsafe(const char *s)
     return len;
 }
 
+/* "[%10.3f] " of the time in seconds, without stdio for signal handlers */
+static size_t
+LogFormatTime(char *buf, CARD32 ms)
+{
+    char digits[10];
+    CARD32 secs = ms / 1000;
+    size_t len = 0;
+    int n = 0, i;
+
+    do {
+        digits[n++] = '0' + secs % 10;
+        secs /= 10;
+    } while (secs);
+
+    buf[len++] = '[';
+    for (i = n; i < 6; i++)
+        buf[len++] = ' ';
+    while (n)
+        buf[len++] = digits[--n];
+    buf[len++] = '.';
+    buf[len++] = '0' + ms % 1000 / 100;
+    buf[len++] = '0' + ms % 100 / 10;
+    buf[len++] = '0' + ms % 10;
+    buf[len++] = ']';
+    buf[len++] = ' ';
+    return len;
+}
+
+static void
+LogFileWrite(const char *buf, size_t len, Bool line_start, CARD32 time)
+{
+    if (line_start) {
+        char stamp[LOG_TIME_SIZE];
+
+        fwrite(stamp, LogFormatTime(stamp, time), 1, logFile);
+    }
+    fwrite(buf, len, 1, logFile);
+}
+
+static void
+LogFileFlush(void)
+{
+    if (logFlush) {
+        fflush(logFile);
+#ifndef WIN32
+        if (logSync)
+            fsync(fileno(logFile));
+#endif
+    }
+}
+
+#ifdef LOG_THREAD
+static void
+LogRingCopyIn(size_t pos, const void *src, size_t len)
+{
+    size_t off = pos & LOG_RING_MASK;
+    size_t n = min(len, LOG_RING_SIZE - off);
+
+    memcpy(logRing + off, src, n);
+    memcpy(logRing, (const char *) src + n, len - n);
+}
+
+static void
+LogRingCopyOut(void *dst, size_t pos, size_t len)
+{
+    size_t off = pos & LOG_RING_MASK;
+    size_t n = min(len, LOG_RING_SIZE - off);
+
+    memcpy(dst, logRing + off, n);
+    memcpy((char *) dst + n, logRing, len - n);
+}
+
+/*
+ * Write out the records between tail and head, a batch at a time, and
+ * return where the next one starts.  The caller holds logIOLock.
+ */
+static size_t
+LogRingWrite(size_t tail, size_t head)
+{
+    char out[8192];
+    size_t used = 0;
+
+    if (tail == head || !logFile)
+        return head;
+
+    while (tail != head) {
+        LogRecord rec;
+        size_t len;
+
+        LogRingCopyOut(&rec, tail, sizeof(rec));
+        len = rec.len & ~LOG_LINE_START;
+        if (used + LOG_TIME_SIZE + len > sizeof(out)) {
+            fwrite(out, used, 1, logFile);
+            used = 0;
+        }
+        if (rec.len & LOG_LINE_START)
+            used += LogFormatTime(out + used, rec.time);
+        LogRingCopyOut(out + used, tail + sizeof(rec), len);
+        used += len;
+        tail += sizeof(rec) + len;
+    }
+    fwrite(out, used, 1, logFile);
+    LogFileFlush();
+    return tail;
+}
+
+static void *
+LogWriterThread(void *arg)
+{
+    size_t tail, head;
+    Bool running;
+
+    pthread_mutex_lock(&logRingLock);
+    for (;;) {
+        while (logHead == logTail && logThreadRunning) {
+            logThreadWaiting = TRUE;
+            pthread_cond_wait(&logRingData, &logRingLock);
+        }
+        logThreadWaiting = FALSE;
+        if (logHead == logTail)
+            break;
+        running = logThreadRunning;
+        pthread_mutex_unlock(&logRingLock);
+
+        /* Rather than wake for every message, give the rest a moment to
+         * follow; a full ring gets written out by whoever fills it */
+        if (running) {
+#ifdef WIN32
+            Sleep(LOG_THREAD_DELAY);
+#else
+            struct timespec delay = { 0, LOG_THREAD_DELAY * 1000000L };
+
+            nanosleep(&delay, NULL);
+#endif
+        }
+
+        pthread_mutex_lock(&logIOLock);
+        pthread_mutex_lock(&logRingLock);
+        tail = logTail;
+        head = logHead;
+        pthread_mutex_unlock(&logRingLock);
+
+        tail = LogRingWrite(tail, head);
+
+        pthread_mutex_lock(&logRingLock);
+        logTail = tail;
+        pthread_mutex_unlock(&logIOLock);
+    }
+    pthread_mutex_unlock(&logRingLock);
+    return NULL;
+}
+
+/*
+ * Queue a message for the writer; FALSE if it has to be written now.
+ */
+static Bool
+LogQueue(const char *buf, size_t len, Bool line_start, CARD32 time)
+{
+    LogRecord rec;
+
+    if (len > LOG_RECORD_MAX)
+        return FALSE;
+
+    rec.len = len | (line_start ? LOG_LINE_START : 0);
+    rec.time = time;
+
+    pthread_mutex_lock(&logRingLock);
+    if (!logThreadRunning ||
+        logHead - logTail + sizeof(rec) + len > LOG_RING_SIZE) {
+        pthread_mutex_unlock(&logRingLock);
+        return FALSE;
+    }
+    LogRingCopyIn(logHead, &rec, sizeof(rec));
+    LogRingCopyIn(logHead + sizeof(rec), buf, len);
+    logHead += sizeof(rec) + len;
+    if (logThreadWaiting) {
+        logThreadWaiting = FALSE;
+        pthread_cond_signal(&logRingData);
+    }
+    pthread_mutex_unlock(&logRingLock);
+    return TRUE;
+}
+#endif
+
+/*
+ * Write to the file right away, after whatever is still queued.  From a
+ * signal handler, a lock somebody else holds is done without, and the
+ * message may end up ahead of some of the queue.
+ */
+static void
+LogWriteNow(const char *buf, size_t len, Bool line_start, CARD32 time,
+            Bool sigsafe)
+{
+#ifdef LOG_THREAD
+    Bool locked;
+
+    if (sigsafe)
+        locked = (pthread_mutex_trylock(&logIOLock) == 0);
+    else
+        locked = (pthread_mutex_lock(&logIOLock) == 0);
+
+    if (locked) {
+        if ((sigsafe ? pthread_mutex_trylock(&logRingLock) :
+             pthread_mutex_lock(&logRingLock)) == 0) {
+            if (logRing)
+                logTail = LogRingWrite(logTail, logHead);
+            pthread_mutex_unlock(&logRingLock);
+        }
+    }
+#endif
+
+    if (buf && logFile) {
+        LogFileWrite(buf, len, line_start, time);
+        LogFileFlush();
+    }
+
+#ifdef LOG_THREAD
+    if (locked)
+        pthread_mutex_unlock(&logIOLock);
+#endif
+}
+
+#ifdef LOG_THREAD
+static void
+LogFlushAtExit(void)
+{
+    LogWriteNow(NULL, 0, FALSE, 0, TRUE);
+}
+
+static void
+LogStartThread(void)
+{
+#ifndef WIN32
+    sigset_t set, old;
+#endif
+    int ret;
+
+    if (logThreadRunning)
+        return;
+
+    logRing = malloc(LOG_RING_SIZE);
+    if (!logRing)
+        return;
+    logHead = logTail = 0;
+    logThreadRunning = TRUE;
+
+#ifndef WIN32
+    /* Signals are for the main thread to handle */
+    sigfillset(&set);
+    pthread_sigmask(SIG_SETMASK, &set, &old);
+#endif
+    ret = pthread_create(&logThread, NULL, LogWriterThread, NULL);
+#ifndef WIN32
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+#endif
+
+    if (ret != 0) {
+        /* Carry on writing synchronously */
+        logThreadRunning = FALSE;
+        free(logRing);
+        logRing = NULL;
+        return;
+    }
+
+    if (!logThreadAtExit) {
+        atexit(LogFlushAtExit);
+        logThreadAtExit = TRUE;
+    }
+}
+
+static void
+LogStopThread(void)
+{
+    if (!logThreadRunning)
+        return;
+
+    /* The writer empties the ring before it goes */
+    pthread_mutex_lock(&logRingLock);
+    logThreadRunning = FALSE;
+    pthread_cond_signal(&logRingData);
+    pthread_mutex_unlock(&logRingLock);
+    pthread_join(logThread, NULL);
+
+    pthread_mutex_lock(&logRingLock);
+    free(logRing);
+    logRing = NULL;
+    pthread_mutex_unlock(&logRingLock);
+}
+#endif
+
 /*
  * LogFilePrep is called to setup files for logging, including getting
  * an old file out of the way, but it doesn't actually open the file,
@@ -295,6 +635,10 @@ LogInit(const char *fname, const char *backup)
             fsync(fileno(logFile));
 #endif
         }
+
+#ifdef LOG_THREAD
+        LogStartThread();
+#endif
     }
 
     /*
@@ -346,6 +690,9 @@ LogClose(enum ExitCode error)
 {
     if (logFile) {
         int msgtype = (error == EXIT_NO_ERROR) ? X_INFO : X_ERROR;
+#ifdef LOG_THREAD
+        LogStopThread();
+#endif
         LogMessageVerbSigSafe(msgtype, -1,
                 "Server terminated %s (%d). Closing log file.\n",
                 (error == EXIT_NO_ERROR) ? "successfully" : "with error",
@@ -607,9 +954,24 @@ pnprintf(char *string, int size, const char *f, ...)
     return rc;
 }
 
+static void
+LogSaveBuffer(const char *buf, size_t len)
+{
+    while (len > bufferUnused) {
+        bufferSize += 1024;
+        bufferUnused += 1024;
+        saveBuffer = realloc(saveBuffer, bufferSize);
+        if (!saveBuffer)
+            FatalError("realloc() failed while saving log messages\n");
+    }
+    bufferUnused -= len;
+    memcpy(saveBuffer + bufferPos, buf, len);
+    bufferPos += len;
+}
+
 /* This function does the actual log message writes. */
 static void
-LogSWrite(int verb, const char *buf, size_t len, Bool end_line)
+LogSWrite(int verb, const char *buf, size_t len, Bool end_line, Bool sigsafe)
 {
     static Bool newline = TRUE;
     int ret;
@@ -618,30 +980,23 @@ LogSWrite(int verb, const char *buf, size_t len, Bool end_line)
         ret = write(2, buf, len);
 
     if (verb < 0 || logFileVerbosity >= verb) {
+        CARD32 time = newline ? GetTimeInMillis() : 0;
+
         if (logFile) {
-//            if (newline)
-//                fprintf(logFile, "[%10.3f] ", GetTimeInMillis() / 1000.0);
-            newline = end_line;
-            fwrite(buf, len, 1, logFile);
-            if (logFlush) {
-                fflush(logFile);
-#ifndef WIN32
-                if (logSync)
-                    fsync(fileno(logFile));
+#ifdef LOG_THREAD
+            if (sigsafe || !LogQueue(buf, len, newline, time))
 #endif
-            }
+                LogWriteNow(buf, len, newline, time, sigsafe);
+            newline = end_line;
         }
         else if (needBuffer) {
-            if (len > bufferUnused) {
-                bufferSize += 1024;
-                bufferUnused += 1024;
-                saveBuffer = realloc(saveBuffer, bufferSize);
-                if (!saveBuffer)
-                    FatalError("realloc() failed while saving log messages\n");
+            if (newline) {
+                char stamp[LOG_TIME_SIZE];
+
+                LogSaveBuffer(stamp, LogFormatTime(stamp, time));
             }
-            bufferUnused -= len;
-            memcpy(saveBuffer + bufferPos, buf, len);
-            bufferPos += len;
+            LogSaveBuffer(buf, len);
+            newline = end_line;
         }
     }
 
@@ -733,7 +1088,7 @@ LogVMessageVerb(MessageType type, int verb, const char *format, va_list args)
         buf[len - 1] = '\n';
 
     newline = (buf[len - 1] == '\n');
-    LogSWrite(verb, buf, len, newline);
+    LogSWrite(verb, buf, len, newline, FALSE);
 }
 
 /* Log message with verbosity level specified. */
@@ -782,8 +1137,8 @@ LogVMessageVerbSigSafe(MessageType type, int verb, const char *format, va_list a
 
     /* if type_str is not "", prepend it and ' ', to message */
     if (type_str[0] != '\0') {
-        LogSWrite(verb, type_str, strlen_sigsafe(type_str), FALSE);
-        LogSWrite(verb, " ", 1, FALSE);
+        LogSWrite(verb, type_str, strlen_sigsafe(type_str), FALSE, TRUE);
+        LogSWrite(verb, " ", 1, FALSE, TRUE);
     }
 
     len = vpnprintf(buf, sizeof(buf), format, args);
@@ -793,7 +1148,7 @@ LogVMessageVerbSigSafe(MessageType type, int verb, const char *format, va_list a
         buf[len - 1] = '\n';
 
     newline = (len > 0 && buf[len - 1] == '\n');
-    LogSWrite(verb, buf, len, newline);
+    LogSWrite(verb, buf, len, newline, TRUE);
 }
 
 void
@@ -832,7 +1187,7 @@ LogVHdrMessageVerb(MessageType type, int verb, const char *msg_format,
         buf[len - 1] = '\n';
 
     newline = (buf[len - 1] == '\n');
-    LogSWrite(verb, buf, len, newline);
+    LogSWrite(verb, buf, len, newline, FALSE);
 }
 
 void
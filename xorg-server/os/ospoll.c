@@ -54,8 +54,44 @@
 #include "xserver_poll.h"
 #define POLL            1
 #define HAVE_OSPOLL     1
+#ifdef WIN32
+#define WSAPOLL         1
 #endif
+#endif
+
+#if WSAPOLL
+#include <X11/Xwinsock.h>
 
+/* WSAPoll() (Vista and later) has no FD_SETSIZE limit and doesn't need
+ * the fd_set scans of the select() emulation.  Its pollfd has a SOCKET
+ * sized fd and its own event bits, so it gets an array of its own; it is
+ * looked up at run time since the build still targets XP, falling back
+ * to xserver_poll() where it is missing.
+ */
+typedef struct {
+    SOCKET      fd;
+    SHORT       events;
+    SHORT       revents;
+} ospoll_wsapollfd;
+
+#define WSAPOLL_ERR     0x0001
+#define WSAPOLL_HUP     0x0002
+#define WSAPOLL_NVAL    0x0004
+#define WSAPOLL_WRNORM  0x0010
+#define WSAPOLL_RDNORM  0x0100
+#define WSAPOLL_RDBAND  0x0200
+
+typedef int (WSAAPI *ospoll_wsapoll_proc)(ospoll_wsapollfd *fds, ULONG nfds,
+                                          INT timeout);
+static ospoll_wsapoll_proc ospoll_wsapoll;
+
+/* The server thread also owns the windows of the DDX, so rather than
+ * sleeping in the poll and waking up every so often to look at its message
+ * queue, it sleeps in MsgWaitForMultipleObjectsEx() on an event which
+ * WSAEventSelect() sets for the sockets, and polls them once woken.
+ */
+#define OSPOLL_MSGWAIT  1
+#endif
 #if POLLSET
 
 // pollset-based implementation (as seen on AIX)
@@ -113,6 +149,12 @@ struct ospollfd {
 struct ospoll {
     struct pollfd       *fds;
     struct ospollfd     *osfds;
+#if WSAPOLL
+    ospoll_wsapollfd    *wsafds;
+#endif
+#if OSPOLL_MSGWAIT
+    WSAEVENT            wake;
+#endif
     int                 num;
     int                 size;
     Bool                changed;
@@ -234,8 +276,26 @@ ospoll_create(void)
     return ospoll;
 #endif
 #if POLL
+#if WSAPOLL
+    if (!ospoll_wsapoll) {
+        HMODULE ws2 = GetModuleHandle("ws2_32.dll");
+
+        if (ws2)
+            ospoll_wsapoll = (ospoll_wsapoll_proc) GetProcAddress(ws2, "WSAPoll");
+    }
+#endif
+#if OSPOLL_MSGWAIT
+    {
+        struct ospoll *ospoll = calloc(1, sizeof (struct ospoll));
+
+        if (ospoll)
+            ospoll->wake = WSACreateEvent();
+        return ospoll;
+    }
+#else
     return calloc(1, sizeof (struct ospoll));
 #endif
+#endif
 }
 
 void
@@ -263,6 +323,13 @@ ospoll_destroy(struct ospoll *ospoll)
         assert (ospoll->num == 0);
         free (ospoll->fds);
         free (ospoll->osfds);
+#if WSAPOLL
+        free (ospoll->wsafds);
+#endif
+#if OSPOLL_MSGWAIT
+        if (ospoll->wake != WSA_INVALID_EVENT)
+            WSACloseEvent(ospoll->wake);
+#endif
         free (ospoll);
     }
 #endif
@@ -395,11 +462,33 @@ ospoll_add(struct ospoll *ospoll, int fd,
             if (!new_osfds)
                 return FALSE;
             ospoll->osfds = new_osfds;
+#if WSAPOLL
+            {
+                ospoll_wsapollfd *new_wsafds;
+
+                new_wsafds = reallocarray(ospoll->wsafds, new_size, sizeof (ospoll->wsafds[0]));
+                if (!new_wsafds)
+                    return FALSE;
+                ospoll->wsafds = new_wsafds;
+            }
+#endif
             ospoll->size = new_size;
         }
         pos = -pos - 1;
         array_insert(ospoll->fds, ospoll->num, sizeof (ospoll->fds[0]), pos);
         array_insert(ospoll->osfds, ospoll->num, sizeof (ospoll->osfds[0]), pos);
+#if WSAPOLL
+        array_insert(ospoll->wsafds, ospoll->num, sizeof (ospoll->wsafds[0]), pos);
+        ospoll->wsafds[pos].fd = (SOCKET) fd;
+        ospoll->wsafds[pos].events = 0;
+        ospoll->wsafds[pos].revents = 0;
+#endif
+#if OSPOLL_MSGWAIT
+        /* Not every fd need be a socket, those just do not wake us */
+        if (ospoll->wake != WSA_INVALID_EVENT)
+            WSAEventSelect((SOCKET) fd, ospoll->wake,
+                           FD_READ | FD_WRITE | FD_OOB | FD_ACCEPT | FD_CLOSE);
+#endif
         ospoll->num++;
         ospoll->changed = TRUE;
 
@@ -454,8 +543,15 @@ ospoll_remove(struct ospoll *ospoll, int fd)
         xorg_list_add(&osfd->deleted, &ospoll->deleted);
 #endif
 #if POLL
+#if OSPOLL_MSGWAIT
+        if (ospoll->wake != WSA_INVALID_EVENT)
+            WSAEventSelect((SOCKET) fd, NULL, 0);
+#endif
         array_delete(ospoll->fds, ospoll->num, sizeof (ospoll->fds[0]), pos);
         array_delete(ospoll->osfds, ospoll->num, sizeof (ospoll->osfds[0]), pos);
+#if WSAPOLL
+        array_delete(ospoll->wsafds, ospoll->num, sizeof (ospoll->wsafds[0]), pos);
+#endif
         ospoll->num--;
         ospoll->changed = TRUE;
 #endif
@@ -492,6 +588,92 @@ epoll_mod(struct ospoll *ospoll, struct ospollfd *osfd)
 }
 #endif
 
+#if WSAPOLL
+static void
+wsapoll_mod(struct ospoll *ospoll, int pos)
+{
+    short events = 0;
+
+    if (ospoll->fds[pos].events & POLLIN)
+        events |= WSAPOLL_RDNORM | WSAPOLL_RDBAND;
+    if (ospoll->fds[pos].events & POLLOUT)
+        events |= WSAPOLL_WRNORM;
+    ospoll->wsafds[pos].events = events;
+}
+
+static int
+wsapoll_wait(struct ospoll *ospoll, int timeout)
+{
+    int nready = ospoll_wsapoll(ospoll->wsafds, ospoll->num, timeout);
+    int f;
+
+    if (nready <= 0)
+        return nready;
+
+    /* hand the results back in the shape the poll loop expects */
+    for (f = 0; f < ospoll->num; f++) {
+        short wsarevents = ospoll->wsafds[f].revents;
+        short revents = 0;
+
+        if (wsarevents & (WSAPOLL_RDNORM | WSAPOLL_RDBAND))
+            revents |= POLLIN;
+        if (wsarevents & WSAPOLL_WRNORM)
+            revents |= POLLOUT;
+        if (wsarevents & WSAPOLL_ERR)
+            revents |= POLLERR;
+        if (wsarevents & WSAPOLL_HUP)
+            revents |= POLLHUP;
+        if (wsarevents & WSAPOLL_NVAL)
+            revents |= POLLNVAL;
+        ospoll->fds[f].revents = revents;
+    }
+    return nready;
+}
+#endif
+
+#if POLL
+static int
+poll_wait(struct ospoll *ospoll, int timeout)
+{
+#if WSAPOLL
+    /* WSAPoll() rejects an empty array */
+    if (ospoll_wsapoll && ospoll->num)
+        return wsapoll_wait(ospoll, timeout);
+#endif
+    return xserver_poll(ospoll->fds, ospoll->num, timeout);
+}
+#endif
+
+#if OSPOLL_MSGWAIT
+static int
+msgwait_wait(struct ospoll *ospoll, int timeout)
+{
+    int nready;
+
+    /* Without the event, look at the message queue every millisecond */
+    if (ospoll->wake == WSA_INVALID_EVENT)
+        return poll_wait(ospoll, timeout < 0 || timeout > 1 ? 1 : timeout);
+
+    if (timeout == 0)
+        return poll_wait(ospoll, 0);
+
+    /* Whatever happens to the sockets after the poll sets the event */
+    WSAResetEvent(ospoll->wake);
+    nready = poll_wait(ospoll, 0);
+    if (nready != 0)
+        return nready;
+
+    /* Messages already in the queue wake us too, not only new ones */
+    if (MsgWaitForMultipleObjectsEx(1, &ospoll->wake,
+                                    timeout < 0 ? INFINITE : timeout,
+                                    QS_ALLINPUT, MWMO_INPUTAVAILABLE) ==
+        WAIT_TIMEOUT)
+        return 0;
+
+    return poll_wait(ospoll, 0);
+}
+#endif
+
 void
 ospoll_listen(struct ospoll *ospoll, int fd, int xevents)
 {
@@ -525,6 +707,9 @@ ospoll_listen(struct ospoll *ospoll, int fd, int xevents)
             ospoll->fds[pos].events |= POLLOUT;
             ospoll->osfds[pos].revents &= ~POLLOUT;
         }
+#if WSAPOLL
+        wsapoll_mod(ospoll, pos);
+#endif
 #endif
     }
 }
@@ -561,6 +746,9 @@ ospoll_mute(struct ospoll *ospoll, int fd, int xevents)
             ospoll->fds[pos].events &= ~POLLIN;
         if (xevents & X_NOTIFY_WRITE)
             ospoll->fds[pos].events &= ~POLLOUT;
+#if WSAPOLL
+        wsapoll_mod(ospoll, pos);
+#endif
 #endif
     }
 }
@@ -653,7 +841,11 @@ ospoll_wait(struct ospoll *ospoll, int timeout)
     ospoll_clean_deleted(ospoll);
 #endif
 #if POLL
-    nready = xserver_poll(ospoll->fds, ospoll->num, timeout);
+#if OSPOLL_MSGWAIT
+    nready = msgwait_wait(ospoll, timeout);
+#else
+    nready = poll_wait(ospoll, timeout);
+#endif
     ospoll->changed = FALSE;
     if (nready > 0) {
         int f;
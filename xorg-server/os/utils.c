@@ -112,6 +112,7 @@ __stdcall unsigned long GetTickCount(void);
 #include "xkbsrv.h"
 
 #include "picture.h"
+#include "frametrace.h"
 
 Bool noTestExtensions;
 
@@ -121,6 +122,7 @@ Bool noCompositeExtension = FALSE;
 
 #ifdef DAMAGE
 Bool noDamageExtension = FALSE;
+int DamageCoalesceInterval = 0;
 #endif
 #ifdef DBE
 Bool noDbeExtension = FALSE;
@@ -136,8 +138,14 @@ Bool noGlxExtension = FALSE;
 Bool noScreenSaverExtension = FALSE;
 #endif
 #ifdef MITSHM
+#ifdef WIN32
+/* segments can only be attached by native clients, as named file mappings
+   (see ShmMapSegment), so it is not offered unless +extension MIT-SHM */
+Bool noMITShmExtension = TRUE;
+#else
 Bool noMITShmExtension = FALSE;
 #endif
+#endif
 #ifdef RANDR
 Bool noRRExtension = FALSE;
 #endif
@@ -522,6 +530,28 @@ GetTimeInMicros(void)
 }
 #endif
 
+/*
+ * GetTimeInMicros() only ticks with the system timer on Windows, so time
+ * short intervals with the performance counter there.  The two clocks
+ * have different origins and must not be mixed.
+ */
+CARD64
+GetTimeInMicrosPrecise(void)
+{
+#ifdef WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (now.QuadPart / freq.QuadPart) * 1000000 +
+        (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    return GetTimeInMicros();
+#endif
+}
+
 void
 UseMsg(void)
 {
@@ -540,6 +570,9 @@ UseMsg(void)
     ErrorF("-cc int                default color visual class\n");
     ErrorF("-nocursor              disable the cursor\n");
     ErrorF("-core                  generate core dump on fatal error\n");
+#ifdef DAMAGE
+    ErrorF("-damagecoalesce ms     report raw damage rectangles once a frame\n");
+#endif
     ErrorF("-displayfd fd          file descriptor to write display number to when ready to connect\n");
 #ifdef _MSC_VER
     ErrorF("-dpi [auto|int]        screen resolution set to native or this dpi\n");
@@ -555,6 +588,10 @@ UseMsg(void)
     ErrorF("-fc string             cursor font\n");
     ErrorF("-fn string             default font name\n");
     ErrorF("-fp string             default font path\n");
+#ifdef XSERVER_FRAME_TRACE
+    ErrorF("-frametrace file       write a frame timing trace to file\n");
+#endif
+    ErrorF("-glyphhash [sha1|fast] hash render glyphs with SHA1 or a fast hash\n");
     ErrorF("-help                  prints message with these options\n");
     ErrorF("+iglx                  Allow creating indirect GLX contexts (default)\n");
     ErrorF("-iglx                  Prohibit creating indirect GLX contexts\n");
@@ -582,6 +619,7 @@ UseMsg(void)
     ErrorF("-r                     turns off auto-repeat\n");
     ErrorF("r                      turns on auto-repeat \n");
     ErrorF("-render [default|mono|gray|color] set render color alloc policy\n");
+    ErrorF("-renderthreads n       spread large render composites over n threads\n");
     ErrorF("-retro                 start with classic stipple\n");
     ErrorF("-seat string           seat to run on\n");
     ErrorF("-t #                   default pointer threshold (pixels/t)\n");
@@ -596,6 +634,7 @@ UseMsg(void)
     ErrorF
         ("-dumbSched             Disable smart scheduling and threaded input, enable old behavior\n");
     ErrorF("-schedInterval int     Set scheduler interval in msec\n");
+    ErrorF("-schedstats            Log per client scheduling statistics\n");
     ErrorF("+extension name        Enable extension\n");
     ErrorF("-extension name        Disable extension\n");
 #ifdef XDMCP
@@ -791,6 +830,17 @@ ProcessCommandLine(int argc, char *argv[])
             /* ignored for compatibility */ ;
         else if (strcmp(argv[i], "-dpms") == 0)
             DPMSDisabledSwitch = TRUE;
+#endif
+#ifdef DAMAGE
+        else if (strcmp(argv[i], "-damagecoalesce") == 0) {
+            if (++i < argc) {
+                DamageCoalesceInterval = atoi(argv[i]);
+                if (DamageCoalesceInterval < 0)
+                    DamageCoalesceInterval = 0;
+            }
+            else
+                UseMsg();
+        }
 #endif
         else if (strcmp(argv[i], "-deferglyphs") == 0) {
             if (++i >= argc || !xfont2_parse_glyph_caching_mode(argv[i]))
@@ -814,6 +864,14 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+#ifdef XSERVER_FRAME_TRACE
+        else if (strcmp(argv[i], "-frametrace") == 0) {
+            if (++i < argc)
+                FrameTracePath = argv[i];
+            else
+                UseMsg();
+        }
+#endif
         else if (strcmp(argv[i], "-fp") == 0) {
             if (++i < argc) {
                 defaultFontPath = argv[i];
@@ -1029,6 +1087,9 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-schedstats") == 0) {
+            SmartScheduleStats = TRUE;
+        }
         else if (strcmp(argv[i], "-schedMax") == 0) {
             if (++i < argc) {
                 SmartScheduleMaxSlice = atoi(argv[i]);
@@ -1048,6 +1109,27 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-glyphhash") == 0) {
+            if (++i < argc) {
+                if (strcmp(argv[i], "sha1") == 0)
+                    PictureGlyphHashFast = FALSE;
+                else if (strcmp(argv[i], "fast") == 0)
+                    PictureGlyphHashFast = TRUE;
+                else
+                    UseMsg();
+            }
+            else
+                UseMsg();
+        }
+        else if (strcmp(argv[i], "-renderthreads") == 0) {
+            if (++i < argc) {
+                PictureCompositeThreads = atoi(argv[i]);
+                if (PictureCompositeThreads < 0)
+                    UseMsg();
+            }
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "+extension") == 0) {
             if (++i < argc) {
                 if (!EnableDisableExtension(argv[i], TRUE))
@@ -30,7 +30,370 @@
 #include "os.h"
 #include "xsha1.h"
 
-#if defined(HAVE_SHA1_IN_LIBMD)  /* Use libmd for SHA1 */ \
+#if defined(HAVE_SHA1_BUILTIN)  /* Use the built-in SHA1 */
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Every glyph a client uploads is hashed, so the block function is picked
+ * once for the CPU: the SHA extensions on x86, the crypto extensions on
+ * ARMv8 builds which have them, and plain C otherwise.
+ */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SHA1_NI
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHA1_TARGET_NI
+#else
+#include <cpuid.h>
+#define SHA1_TARGET_NI __attribute__((target("sha,ssse3,sse4.1")))
+#endif
+#elif defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#define SHA1_ARMV8
+#include <arm_neon.h>
+#endif
+
+typedef void (*Sha1BlocksProc) (uint32_t state[5], const unsigned char *data,
+                                size_t blocks);
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;            /* in bytes */
+    unsigned char buffer[64];
+} Sha1BuiltinRec;
+
+static Sha1BlocksProc sha1Blocks;
+
+#define SHA1_ROL(x, n)  (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void
+sha1BlocksGeneric(uint32_t state[5], const unsigned char *data, size_t blocks)
+{
+    while (blocks--) {
+        uint32_t w[80];
+        uint32_t a = state[0], b = state[1], c = state[2];
+        uint32_t d = state[3], e = state[4];
+        int i;
+
+        for (i = 0; i < 16; i++)
+            w[i] = ((uint32_t) data[4 * i] << 24) |
+                ((uint32_t) data[4 * i + 1] << 16) |
+                ((uint32_t) data[4 * i + 2] << 8) |
+                (uint32_t) data[4 * i + 3];
+        for (; i < 80; i++)
+            w[i] = SHA1_ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        for (i = 0; i < 80; i++) {
+            uint32_t f, k, t;
+
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            }
+            else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            }
+            else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            }
+            else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+
+            t = SHA1_ROL(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = SHA1_ROL(b, 30);
+            b = a;
+            a = t;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        data += 64;
+    }
+}
+
+#ifdef SHA1_NI
+
+/* w0 becomes the message words four groups on */
+#define SHA1_NI_SCHEDULE(w0, w1, w2, w3) \
+    w0 = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w0, w1), w2), w3)
+
+/* Four rounds of function f; e is derived from abcd four rounds back */
+#define SHA1_NI_ROUNDS(w, f) {                                  \
+    e = _mm_sha1nexte_epu32(prev, w);                           \
+    prev = abcd;                                                \
+    abcd = _mm_sha1rnds4_epu32(abcd, e, f);                     \
+}
+
+static SHA1_TARGET_NI void
+sha1BlocksNI(uint32_t state[5], const unsigned char *data, size_t blocks)
+{
+    const __m128i swap = _mm_set_epi64x(0x0001020304050607ULL,
+                                        0x08090a0b0c0d0e0fULL);
+    __m128i abcd, e0, e, prev, abcd_save, e0_save;
+    __m128i m0, m1, m2, m3;
+
+    /* The instructions want a in the top lane */
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1b);
+    e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+    while (blocks--) {
+        abcd_save = abcd;
+        e0_save = e0;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), swap);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)),
+                              swap);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)),
+                              swap);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)),
+                              swap);
+
+        e = _mm_add_epi32(e0, m0);
+        prev = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+        SHA1_NI_ROUNDS(m1, 0);
+        SHA1_NI_ROUNDS(m2, 0);
+        SHA1_NI_ROUNDS(m3, 0);
+        SHA1_NI_SCHEDULE(m0, m1, m2, m3);
+        SHA1_NI_ROUNDS(m0, 0);
+
+        SHA1_NI_SCHEDULE(m1, m2, m3, m0);
+        SHA1_NI_ROUNDS(m1, 1);
+        SHA1_NI_SCHEDULE(m2, m3, m0, m1);
+        SHA1_NI_ROUNDS(m2, 1);
+        SHA1_NI_SCHEDULE(m3, m0, m1, m2);
+        SHA1_NI_ROUNDS(m3, 1);
+        SHA1_NI_SCHEDULE(m0, m1, m2, m3);
+        SHA1_NI_ROUNDS(m0, 1);
+        SHA1_NI_SCHEDULE(m1, m2, m3, m0);
+        SHA1_NI_ROUNDS(m1, 1);
+
+        SHA1_NI_SCHEDULE(m2, m3, m0, m1);
+        SHA1_NI_ROUNDS(m2, 2);
+        SHA1_NI_SCHEDULE(m3, m0, m1, m2);
+        SHA1_NI_ROUNDS(m3, 2);
+        SHA1_NI_SCHEDULE(m0, m1, m2, m3);
+        SHA1_NI_ROUNDS(m0, 2);
+        SHA1_NI_SCHEDULE(m1, m2, m3, m0);
+        SHA1_NI_ROUNDS(m1, 2);
+        SHA1_NI_SCHEDULE(m2, m3, m0, m1);
+        SHA1_NI_ROUNDS(m2, 2);
+
+        SHA1_NI_SCHEDULE(m3, m0, m1, m2);
+        SHA1_NI_ROUNDS(m3, 3);
+        SHA1_NI_SCHEDULE(m0, m1, m2, m3);
+        SHA1_NI_ROUNDS(m0, 3);
+        SHA1_NI_SCHEDULE(m1, m2, m3, m0);
+        SHA1_NI_ROUNDS(m1, 3);
+        SHA1_NI_SCHEDULE(m2, m3, m0, m1);
+        SHA1_NI_ROUNDS(m2, 3);
+        SHA1_NI_SCHEDULE(m3, m0, m1, m2);
+        SHA1_NI_ROUNDS(m3, 3);
+
+        e0 = _mm_sha1nexte_epu32(prev, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+        data += 64;
+    }
+
+    _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = _mm_extract_epi32(e0, 3);
+}
+
+static void
+sha1Cpuid(unsigned int leaf, unsigned int *regs)
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuidex(info, leaf, 0);
+    regs[0] = info[0];
+    regs[1] = info[1];
+    regs[2] = info[2];
+    regs[3] = info[3];
+#else
+    if (!__get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]))
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+static Bool
+sha1HaveNI(void)
+{
+    unsigned int regs[4];
+
+    sha1Cpuid(0, regs);
+    if (regs[0] < 7)
+        return FALSE;
+
+    /* SSSE3 and SSE4.1 */
+    sha1Cpuid(1, regs);
+    if (!(regs[2] & (1 << 9)) || !(regs[2] & (1 << 19)))
+        return FALSE;
+
+    sha1Cpuid(7, regs);
+    return (regs[1] & (1 << 29)) != 0;
+}
+
+#endif /* SHA1_NI */
+
+#ifdef SHA1_ARMV8
+
+static void
+sha1BlocksARMv8(uint32_t state[5], const unsigned char *data, size_t blocks)
+{
+    static const uint32_t k[4] = {
+        0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6
+    };
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32_t e0 = state[4];
+
+    while (blocks--) {
+        uint32x4_t abcd_save = abcd;
+        uint32_t e = e0;
+        uint32x4_t w[4];
+        int g;
+
+        for (g = 0; g < 4; g++)
+            w[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * g)));
+
+        for (g = 0; g < 20; g++) {
+            uint32x4_t wk;
+            uint32_t e_next;
+
+            if (g >= 4)
+                w[g & 3] = vsha1su1q_u32(vsha1su0q_u32(w[g & 3],
+                                                       w[(g + 1) & 3],
+                                                       w[(g + 2) & 3]),
+                                         w[(g + 3) & 3]);
+
+            wk = vaddq_u32(w[g & 3], vdupq_n_u32(k[g / 5]));
+            e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+
+            if (g < 5)
+                abcd = vsha1cq_u32(abcd, e, wk);
+            else if (g < 10 || g >= 15)
+                abcd = vsha1pq_u32(abcd, e, wk);
+            else
+                abcd = vsha1mq_u32(abcd, e, wk);
+
+            e = e_next;
+        }
+
+        abcd = vaddq_u32(abcd, abcd_save);
+        e0 += e;
+        data += 64;
+    }
+
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+#endif /* SHA1_ARMV8 */
+
+static Sha1BlocksProc
+sha1ChooseBlocks(void)
+{
+#if defined(SHA1_NI)
+    if (sha1HaveNI())
+        return sha1BlocksNI;
+#elif defined(SHA1_ARMV8)
+    return sha1BlocksARMv8;
+#endif
+    return sha1BlocksGeneric;
+}
+
+void *
+x_sha1_init(void)
+{
+    Sha1BuiltinRec *ctx = malloc(sizeof(*ctx));
+
+    if (!ctx)
+        return NULL;
+
+    if (!sha1Blocks)
+        sha1Blocks = sha1ChooseBlocks();
+
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->state[4] = 0xc3d2e1f0;
+    ctx->length = 0;
+    return ctx;
+}
+
+int
+x_sha1_update(void *ctx, void *data, int size)
+{
+    Sha1BuiltinRec *sha1_ctx = ctx;
+    const unsigned char *p = data;
+    unsigned int used = sha1_ctx->length & 63;
+
+    sha1_ctx->length += size;
+
+    if (used) {
+        unsigned int n = 64 - used;
+
+        if ((unsigned int) size < n) {
+            memcpy(sha1_ctx->buffer + used, p, size);
+            return 1;
+        }
+        memcpy(sha1_ctx->buffer + used, p, n);
+        sha1Blocks(sha1_ctx->state, sha1_ctx->buffer, 1);
+        p += n;
+        size -= n;
+    }
+
+    if (size >= 64) {
+        sha1Blocks(sha1_ctx->state, p, size / 64);
+        p += size & ~63;
+        size &= 63;
+    }
+
+    memcpy(sha1_ctx->buffer, p, size);
+    return 1;
+}
+
+int
+x_sha1_final(void *ctx, unsigned char result[20])
+{
+    Sha1BuiltinRec *sha1_ctx = ctx;
+    uint64_t bits = sha1_ctx->length * 8;
+    unsigned int used = sha1_ctx->length & 63;
+    int i;
+
+    sha1_ctx->buffer[used++] = 0x80;
+    if (used > 56) {
+        memset(sha1_ctx->buffer + used, 0, 64 - used);
+        sha1Blocks(sha1_ctx->state, sha1_ctx->buffer, 1);
+        used = 0;
+    }
+    memset(sha1_ctx->buffer + used, 0, 56 - used);
+    for (i = 0; i < 8; i++)
+        sha1_ctx->buffer[56 + i] = bits >> (56 - 8 * i);
+    sha1Blocks(sha1_ctx->state, sha1_ctx->buffer, 1);
+
+    for (i = 0; i < 20; i++)
+        result[i] = sha1_ctx->state[i / 4] >> (24 - 8 * (i & 3));
+
+    free(sha1_ctx);
+    return 1;
+}
+
+#elif defined(HAVE_SHA1_IN_LIBMD)  /* Use libmd for SHA1 */ \
 	|| defined(HAVE_SHA1_IN_LIBC)   /* Use libc for SHA1 */
 
 #include <sha1.h>
@@ -290,3 +653,112 @@ x_sha1_final(void *ctx, unsigned char result[20])
 }
 
 #endif
+
+/*
+ * A fast 128 bit hash in the style of xxh3: each 16 bytes are folded
+ * through a 64x64->128 bit multiply into two lanes, which are then mixed
+ * into each other.  Good at telling glyphs apart, useless against anybody
+ * crafting collisions.  Nothing is kept across runs, so the byte order of
+ * the host is not minded.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#define XHASH_PRIME1    0x9e3779b185ebca87ULL
+#define XHASH_PRIME2    0xc2b2ae3d27d4eb4fULL
+#define XHASH_PRIME3    0x165667b19e3779f9ULL
+#define XHASH_KEY1      0xbe4ba423396cfeb8ULL
+#define XHASH_KEY2      0x1cad21f72c81017cULL
+#define XHASH_KEY3      0xdb979083e96dd4deULL
+#define XHASH_KEY4      0x1f67b3b7a4a44072ULL
+
+static inline uint64_t
+xhashRead64(const unsigned char *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* The high and low halves of a * b, xor'ed together */
+static inline uint64_t
+xhashFold(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = (unsigned __int128) a * b;
+
+    return (uint64_t) p ^ (uint64_t) (p >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t hi, lo = _umul128(a, b, &hi);
+
+    return lo ^ hi;
+#else
+    uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi;
+    uint64_t hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (uint32_t) lh + hl;
+
+    return ((mid << 32) | (uint32_t) ll) ^ (hh + (lh >> 32) + (mid >> 32));
+#endif
+}
+
+static inline uint64_t
+xhashAvalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= XHASH_PRIME2;
+    h ^= h >> 29;
+    h *= XHASH_PRIME3;
+    return h ^ (h >> 32);
+}
+
+void
+x_hash128(const void *data, int size, uint64_t seed_lo, uint64_t seed_hi,
+          unsigned char result[16])
+{
+    const unsigned char *p = data;
+    uint64_t h1 = seed_lo ^ XHASH_PRIME1;
+    uint64_t h2 = seed_hi ^ XHASH_PRIME2;
+    uint64_t lo, hi;
+    int n = size;
+    int i;
+
+    for (;;) {
+        unsigned char tail[16];
+        uint64_t a, b;
+
+        if (n <= 0)
+            break;
+        if (n < 16) {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, n);
+            p = tail;
+            n = 16;
+        }
+
+        a = xhashRead64(p);
+        b = xhashRead64(p + 8);
+
+        /* Multiplying after each block makes the order count */
+        h1 = (h1 ^ xhashFold(a ^ XHASH_KEY1, b ^ XHASH_KEY2) ^ b) * XHASH_PRIME1;
+        h2 = (h2 ^ xhashFold(b ^ XHASH_KEY3, a ^ XHASH_KEY4) ^ a) * XHASH_PRIME2;
+
+        p += 16;
+        n -= 16;
+    }
+
+    h1 ^= (uint64_t) size * XHASH_PRIME3;
+    lo = xhashAvalanche(h1 + h2);
+    hi = xhashAvalanche(h2 ^ ((h1 << 31) | (h1 >> 33)));
+
+    for (i = 0; i < 8; i++) {
+        result[i] = lo >> (8 * i);
+        result[8 + i] = hi >> (8 * i);
+    }
+}
@@ -17,6 +17,7 @@ _X_ATTRIBUTE_PRINTF(1, 2);
 #ifndef TCPCONN
 #define TCPCONN
 #endif
+#define ZTCPCONN    /* the server links zlib anyway */
 #ifdef WIN32
 #undef SO_REUSEADDR
 #define SO_BINDRETRYCOUNT 0  // do not try to bind again when it fails, this will speed up searching for a free listening port
@@ -66,8 +66,15 @@ present_get_crtc(WindowPtr window)
     return screen_priv->get_crtc(screen_priv, window);
 }
 
+/* Update regions with more boxes than this are copied through a clip */
+#define PRESENT_COPY_MAX_BOXES  32
+
 /*
- * Copies the update region from a pixmap to the target drawable
+ * Copies the update region from a pixmap to the target drawable.
+ *
+ * A short update region is copied box by box, so damage sees only the
+ * boxes that changed rather than their bounding box.  The update region
+ * is consumed.
  */
 void
 present_copy_region(DrawablePtr drawable,
@@ -80,6 +87,30 @@ present_copy_region(DrawablePtr drawable,
     GCPtr       gc;
 
     gc = GetScratchGC(drawable->depth, screen);
+    if (update && RegionNumRects(update) <= PRESENT_COPY_MAX_BOXES) {
+        BoxPtr  box = RegionRects(update);
+        int     nbox = RegionNumRects(update);
+
+        ValidateGC(drawable, gc);
+        while (nbox--) {
+            int x1 = max(box->x1, 0);
+            int y1 = max(box->y1, 0);
+            int x2 = min(box->x2, pixmap->drawable.width);
+            int y2 = min(box->y2, pixmap->drawable.height);
+
+            if (x1 < x2 && y1 < y2)
+                (*gc->ops->CopyArea)(&pixmap->drawable,
+                                     drawable,
+                                     gc,
+                                     x1, y1,
+                                     x2 - x1, y2 - y1,
+                                     x_off + x1, y_off + y1);
+            box++;
+        }
+        RegionDestroy(update);
+        FreeScratchGC(gc);
+        return;
+    }
     if (update) {
         ChangeGCVal     changes[2];
 
@@ -86,11 +86,17 @@ present_execute_copy(present_vblank_ptr vblank, uint64_t crtc_msc)
         return;
     }
 
+    /* Pixels outside the valid region need not be copied */
+    if (vblank->valid) {
+        if (vblank->update)
+            RegionIntersect(vblank->update, vblank->update, vblank->valid);
+        else
+            vblank->update = RegionDuplicate(vblank->valid);
+    }
+
     present_copy_region(&window->drawable, vblank->pixmap, vblank->update, vblank->x_off, vblank->y_off);
 
-    /* present_copy_region sticks the region into a scratch GC,
-     * which is then freed, freeing the region
-     */
+    /* present_copy_region consumes the region */
     vblank->update = NULL;
     screen_priv->flush(window);
 
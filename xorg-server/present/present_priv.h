@@ -472,6 +472,14 @@ present_vblank_create(WindowPtr window,
                       uint64_t *target_msc,
                       uint64_t crtc_msc);
 
+Bool
+present_vblank_merge_update(present_vblank_ptr vblank,
+                            RegionPtr update,
+                            PixmapPtr pixmap,
+                            RegionPtr valid,
+                            int16_t x_off,
+                            int16_t y_off);
+
 void
 present_vblank_scrap(present_vblank_ptr vblank);
 
@@ -150,6 +150,49 @@ no_mem:
     return NULL;
 }
 
+/*
+ * Fold the update region of a pending copy that the presentation of
+ * 'pixmap' is about to overwrite in the same frame into 'update', so
+ * both go out in a single copy.  Only possible when the new pixmap
+ * holds valid contents for all of the old update region.
+ */
+Bool
+present_vblank_merge_update(present_vblank_ptr vblank,
+                            RegionPtr update,
+                            PixmapPtr pixmap,
+                            RegionPtr valid,
+                            int16_t x_off,
+                            int16_t y_off)
+{
+    RegionRec   old, outside;
+    BoxRec      box;
+    Bool        covered;
+
+    if (!vblank->update)
+        return FALSE;
+
+    /* Both update regions are relative to their own pixmap */
+    RegionNull(&old);
+    RegionCopy(&old, vblank->update);
+    RegionTranslate(&old, vblank->x_off - x_off, vblank->y_off - y_off);
+
+    box.x1 = 0;
+    box.y1 = 0;
+    box.x2 = pixmap->drawable.width;
+    box.y2 = pixmap->drawable.height;
+    RegionInit(&outside, &box, 1);
+    if (valid)
+        RegionIntersect(&outside, &outside, valid);
+    RegionSubtract(&outside, &old, &outside);
+    covered = !RegionNotEmpty(&outside);
+    RegionUninit(&outside);
+
+    if (covered)
+        RegionUnion(update, update, &old);
+    RegionUninit(&old);
+    return covered;
+}
+
 void
 present_vblank_scrap(present_vblank_ptr vblank)
 {
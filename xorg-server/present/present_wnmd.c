@@ -563,6 +563,7 @@ present_wnmd_pixmap(WindowPtr window,
     uint64_t                    crtc_msc = 0;
     int                         ret;
     present_vblank_ptr          vblank, tmp;
+    RegionPtr                   merged = NULL;
     ScreenPtr                   screen = window->drawable.pScreen;
     present_window_priv_ptr     window_priv = present_get_window_priv(window, TRUE);
     present_screen_priv_ptr     screen_priv = present_screen_priv(screen);
@@ -592,7 +593,7 @@ present_wnmd_pixmap(WindowPtr window,
      * Look for a matching presentation already on the list...
      */
 
-    if (!update && pixmap) {
+    if (pixmap) {
         xorg_list_for_each_entry_safe(vblank, tmp, &window_priv->vblank, window_list) {
 
             if (!vblank->pixmap)
@@ -604,6 +605,21 @@ present_wnmd_pixmap(WindowPtr window,
             if (vblank->target_msc != target_msc)
                 continue;
 
+            /*
+             * With an update region, the earlier one has to be carried
+             * over into this presentation's copy
+             */
+            if (update) {
+                if (!merged) {
+                    merged = RegionDuplicate(update);
+                    if (!merged)
+                        break;
+                }
+                if (!present_vblank_merge_update(vblank, merged, pixmap,
+                                                 valid, x_off, y_off))
+                    continue;
+            }
+
             present_vblank_scrap(vblank);
             if (vblank->flip_ready)
                 present_wnmd_re_execute(vblank);
@@ -614,7 +630,7 @@ present_wnmd_pixmap(WindowPtr window,
                                    pixmap,
                                    serial,
                                    valid,
-                                   update,
+                                   merged ? merged : update,
                                    x_off,
                                    y_off,
                                    target_crtc,
@@ -626,6 +642,9 @@ present_wnmd_pixmap(WindowPtr window,
                                    num_notifies,
                                    &target_msc,
                                    crtc_msc);
+    if (merged)
+        RegionDestroy(merged);
+
     if (!vblank)
         return BadAlloc;
 
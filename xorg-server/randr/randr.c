@@ -107,6 +107,7 @@ RRCloseScreen(ScreenPtr pScreen)
 
     free(pScrPriv->crtcs);
     free(pScrPriv->outputs);
+    free(pScrPriv->resourcesReply);
     free(pScrPriv);
     RRNScreens -= 1;            /* ok, one fewer screen with RandR running */
     return (*pScreen->CloseScreen) (pScreen);
@@ -577,6 +578,8 @@ RRSetChanged(ScreenPtr pScreen)
     rrScrPriv(pScreen);
     rrScrPrivPtr mastersp;
 
+    pScrPriv->resourcesReplyValid = FALSE;
+
     if (pScreen->isGPU) {
         master = pScreen->current_master;
         if (!master)
@@ -589,6 +592,7 @@ RRSetChanged(ScreenPtr pScreen)
     }
 
     mastersp->changed = TRUE;
+    mastersp->resourcesReplyValid = FALSE;
 }
 
 /*
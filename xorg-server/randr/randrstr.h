@@ -356,6 +356,12 @@ typedef struct _rrScrPriv {
     RRCreateLeaseProcPtr rrCreateLease;
     RRTerminateLeaseProcPtr rrTerminateLease;
 
+    /*
+     * Set by DDXen which report every change of their configuration as it
+     * happens, so GetScreenResources need not call rrGetInfo
+     */
+    Bool rrGetInfoPushed;
+
     /*
      * Private part of the structure; not considered part of the ABI
      */
@@ -408,6 +414,15 @@ typedef struct _rrScrPriv {
     RRMonitorPtr *monitors;
 
     struct xorg_list leases;
+
+    /* GetScreenResources reply after the header, until something changes */
+    Bool resourcesReplyValid;
+    CARD8 *resourcesReply;
+    unsigned long resourcesReplyLen;
+    CARD16 resourcesReplyModes;
+    CARD16 resourcesReplyNames;
+    TimeStamp resourcesReplySetTime;
+    TimeStamp resourcesReplyConfigTime;
 } rrScrPrivRec, *rrScrPrivPtr;
 
 extern _X_EXPORT DevPrivateKeyRec rrPrivKeyRec;
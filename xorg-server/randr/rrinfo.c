@@ -177,9 +177,10 @@ RRGetInfo(ScreenPtr pScreen, Bool force_query)
     int i;
 
     /* Return immediately if we don't need to re-query and we already have the
-     * information.
+     * information.  There is never any need with DDXen which tell us of
+     * every change themselves.
      */
-    if (!force_query) {
+    if (!force_query || pScrPriv->rrGetInfoPushed) {
         if (pScrPriv->numCrtcs != 0 || pScrPriv->numOutputs != 0)
             return TRUE;
     }
@@ -96,6 +96,10 @@ RRModeCreate(xRRModeInfo * modeInfo, const char *name, ScreenPtr userScreen)
     modes = newModes;
     modes[num_modes++] = mode;
 
+    /* The modes of a screen include the ones made for it by clients */
+    if (userScreen)
+        rrGetScrPriv(userScreen)->resourcesReplyValid = FALSE;
+
     /*
      * give the caller a reference to this mode
      */
@@ -233,6 +237,9 @@ RRModeDestroy(RRModePtr mode)
 
     if (--mode->refcnt > 0)
         return;
+    /* However the mode goes, it leaves the resources of its screen */
+    if (mode->userScreen)
+        rrGetScrPriv(mode->userScreen)->resourcesReplyValid = FALSE;
     for (m = 0; m < num_modes; m++) {
         if (modes[m] == mode) {
             memmove(modes + m, modes + m + 1,
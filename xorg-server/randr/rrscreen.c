@@ -481,6 +481,129 @@ rrGetMultiScreenResources(ClientPtr client, Bool query, ScreenPtr pScreen)
     return Success;
 }
 
+/*
+ * Serialise the crtcs, outputs and modes of the screen the way
+ * GetScreenResources replies with them, in server byte order, and keep
+ * that until anything about them changes.
+ */
+static Bool
+rrUpdateScreenResourcesReply(ScreenPtr pScreen)
+{
+    rrScrPriv(pScreen);
+    RRModePtr *modes;
+    int num_modes;
+    CARD8 *extra;
+    unsigned long extraLen;
+    int i, has_primary = 0;
+    CARD16 nbytesNames = 0;
+    RRCrtc *crtcs;
+    RROutput *outputs;
+    xRRModeInfo *modeinfos;
+    CARD8 *names;
+
+    if (pScrPriv->resourcesReplyValid &&
+        CompareTimeStamps(pScrPriv->resourcesReplySetTime,
+                          pScrPriv->lastSetTime) == SAMETIME &&
+        CompareTimeStamps(pScrPriv->resourcesReplyConfigTime,
+                          pScrPriv->lastConfigTime) == SAMETIME)
+        return TRUE;
+
+    modes = RRModesForScreen(pScreen, &num_modes);
+    if (!modes)
+        return FALSE;
+
+    for (i = 0; i < num_modes; i++)
+        nbytesNames += modes[i]->mode.nameLength;
+
+    extraLen = (pScrPriv->numCrtcs +
+                pScrPriv->numOutputs +
+                num_modes * bytes_to_int32(SIZEOF(xRRModeInfo)) +
+                bytes_to_int32(nbytesNames)) << 2;
+    if (extraLen) {
+        extra = calloc(1, extraLen);
+        if (!extra) {
+            free(modes);
+            return FALSE;
+        }
+    }
+    else
+        extra = NULL;
+
+    crtcs = (RRCrtc *) extra;
+    outputs = (RROutput *) (crtcs + pScrPriv->numCrtcs);
+    modeinfos = (xRRModeInfo *) (outputs + pScrPriv->numOutputs);
+    names = (CARD8 *) (modeinfos + num_modes);
+
+    if (pScrPriv->primaryOutput && pScrPriv->primaryOutput->crtc) {
+        has_primary = 1;
+        crtcs[0] = pScrPriv->primaryOutput->crtc->id;
+    }
+
+    for (i = 0; i < pScrPriv->numCrtcs; i++) {
+        if (has_primary &&
+            pScrPriv->primaryOutput->crtc == pScrPriv->crtcs[i]) {
+            has_primary = 0;
+            continue;
+        }
+        crtcs[i + has_primary] = pScrPriv->crtcs[i]->id;
+    }
+
+    for (i = 0; i < pScrPriv->numOutputs; i++)
+        outputs[i] = pScrPriv->outputs[i]->id;
+
+    for (i = 0; i < num_modes; i++) {
+        RRModePtr mode = modes[i];
+
+        modeinfos[i] = mode->mode;
+        memcpy(names, mode->name, mode->mode.nameLength);
+        names += mode->mode.nameLength;
+    }
+    free(modes);
+    assert(((char *) names - (char *) extra + 3) / 4 * 4 == extraLen);
+
+    free(pScrPriv->resourcesReply);
+    pScrPriv->resourcesReply = extra;
+    pScrPriv->resourcesReplyLen = extraLen;
+    pScrPriv->resourcesReplyModes = num_modes;
+    pScrPriv->resourcesReplyNames = nbytesNames;
+    pScrPriv->resourcesReplySetTime = pScrPriv->lastSetTime;
+    pScrPriv->resourcesReplyConfigTime = pScrPriv->lastConfigTime;
+    pScrPriv->resourcesReplyValid = TRUE;
+    return TRUE;
+}
+
+static void
+rrSwapScreenResourcesReply(CARD8 *extra, int nCrtcs, int nOutputs,
+                           int nModes)
+{
+    RRCrtc *crtcs = (RRCrtc *) extra;
+    RROutput *outputs = (RROutput *) (crtcs + nCrtcs);
+    xRRModeInfo *modeinfos = (xRRModeInfo *) (outputs + nOutputs);
+    int i;
+
+    for (i = 0; i < nCrtcs; i++)
+        swapl(&crtcs[i]);
+
+    for (i = 0; i < nOutputs; i++)
+        swapl(&outputs[i]);
+
+    for (i = 0; i < nModes; i++) {
+        swapl(&modeinfos[i].id);
+        swaps(&modeinfos[i].width);
+        swaps(&modeinfos[i].height);
+        swapl(&modeinfos[i].dotClock);
+        swaps(&modeinfos[i].hSyncStart);
+        swaps(&modeinfos[i].hSyncEnd);
+        swaps(&modeinfos[i].hTotal);
+        swaps(&modeinfos[i].hSkew);
+        swaps(&modeinfos[i].vSyncStart);
+        swaps(&modeinfos[i].vSyncEnd);
+        swaps(&modeinfos[i].vTotal);
+        swaps(&modeinfos[i].nameLength);
+        swapl(&modeinfos[i].modeFlags);
+    }
+}
+
 static int
 rrGetScreenResources(ClientPtr client, Bool query)
 {
@@ -491,11 +614,7 @@ rrGetScreenResources(ClientPtr client, Bool query)
     rrScrPrivPtr pScrPriv;
     CARD8 *extra;
     unsigned long extraLen;
-    int i, rc, has_primary = 0;
-    RRCrtc *crtcs;
-    RROutput *outputs;
-    xRRModeInfo *modeinfos;
-    CARD8 *names;
+    int rc;
 
     REQUEST_SIZE_MATCH(xRRGetScreenResourcesReq);
     rc = dixLookupWindow(&pWin, stuff->window, client, DixGetAttrAccess);
@@ -528,98 +647,32 @@ rrGetScreenResources(ClientPtr client, Bool query)
         extraLen = 0;
     }
     else {
-        RRModePtr *modes;
-        int num_modes;
-
-        modes = RRModesForScreen(pScreen, &num_modes);
-        if (!modes)
+        if (!rrUpdateScreenResourcesReply(pScreen))
             return BadAlloc;
 
+        extra = pScrPriv->resourcesReply;
+        extraLen = pScrPriv->resourcesReplyLen;
+
         rep = (xRRGetScreenResourcesReply) {
             .type = X_Reply,
             .sequenceNumber = client->sequence,
-            .length = 0,
+            .length = extraLen >> 2,
             .timestamp = pScrPriv->lastSetTime.milliseconds,
             .configTimestamp = pScrPriv->lastConfigTime.milliseconds,
             .nCrtcs = pScrPriv->numCrtcs,
             .nOutputs = pScrPriv->numOutputs,
-            .nModes = num_modes,
-            .nbytesNames = 0
+            .nModes = pScrPriv->resourcesReplyModes,
+            .nbytesNames = pScrPriv->resourcesReplyNames
         };
 
-
-        for (i = 0; i < num_modes; i++)
-            rep.nbytesNames += modes[i]->mode.nameLength;
-
-        rep.length = (pScrPriv->numCrtcs +
-                      pScrPriv->numOutputs +
-                      num_modes * bytes_to_int32(SIZEOF(xRRModeInfo)) +
-                      bytes_to_int32(rep.nbytesNames));
-
-        extraLen = rep.length << 2;
-        if (extraLen) {
-            extra = calloc(1, extraLen);
-            if (!extra) {
-                free(modes);
+        if (client->swapped && extraLen) {
+            extra = malloc(extraLen);
+            if (!extra)
                 return BadAlloc;
-            }
-        }
-        else
-            extra = NULL;
-
-        crtcs = (RRCrtc *) extra;
-        outputs = (RROutput *) (crtcs + pScrPriv->numCrtcs);
-        modeinfos = (xRRModeInfo *) (outputs + pScrPriv->numOutputs);
-        names = (CARD8 *) (modeinfos + num_modes);
-
-        if (pScrPriv->primaryOutput && pScrPriv->primaryOutput->crtc) {
-            has_primary = 1;
-            crtcs[0] = pScrPriv->primaryOutput->crtc->id;
-            if (client->swapped)
-                swapl(&crtcs[0]);
-        }
-
-        for (i = 0; i < pScrPriv->numCrtcs; i++) {
-            if (has_primary &&
-                pScrPriv->primaryOutput->crtc == pScrPriv->crtcs[i]) {
-                has_primary = 0;
-                continue;
-            }
-            crtcs[i + has_primary] = pScrPriv->crtcs[i]->id;
-            if (client->swapped)
-                swapl(&crtcs[i + has_primary]);
+            memcpy(extra, pScrPriv->resourcesReply, extraLen);
+            rrSwapScreenResourcesReply(extra, rep.nCrtcs, rep.nOutputs,
+                                       rep.nModes);
         }
-
-        for (i = 0; i < pScrPriv->numOutputs; i++) {
-            outputs[i] = pScrPriv->outputs[i]->id;
-            if (client->swapped)
-                swapl(&outputs[i]);
-        }
-
-        for (i = 0; i < num_modes; i++) {
-            RRModePtr mode = modes[i];
-
-            modeinfos[i] = mode->mode;
-            if (client->swapped) {
-                swapl(&modeinfos[i].id);
-                swaps(&modeinfos[i].width);
-                swaps(&modeinfos[i].height);
-                swapl(&modeinfos[i].dotClock);
-                swaps(&modeinfos[i].hSyncStart);
-                swaps(&modeinfos[i].hSyncEnd);
-                swaps(&modeinfos[i].hTotal);
-                swaps(&modeinfos[i].hSkew);
-                swaps(&modeinfos[i].vSyncStart);
-                swaps(&modeinfos[i].vSyncEnd);
-                swaps(&modeinfos[i].vTotal);
-                swaps(&modeinfos[i].nameLength);
-                swapl(&modeinfos[i].modeFlags);
-            }
-            memcpy(names, mode->name, mode->mode.nameLength);
-            names += mode->mode.nameLength;
-        }
-        free(modes);
-        assert(bytes_to_int32((char *) names - (char *) extra) == rep.length);
     }
 
     if (client->swapped) {
@@ -635,7 +688,8 @@ rrGetScreenResources(ClientPtr client, Bool query)
     WriteToClient(client, sizeof(xRRGetScreenResourcesReply), (char *) &rep);
     if (extraLen) {
         WriteToClient(client, extraLen, (char *) extra);
-        free(extra);
+        if (client->swapped)
+            free(extra);
     }
     return Success;
 }
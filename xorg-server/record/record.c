@@ -61,9 +61,16 @@ and Jim Haggerty of Metheus.
 static RESTYPE RTContext;       /* internal resource type for Record contexts */
 
 /* How many bytes of protocol data to buffer in a context. Don't set to less
- * than 32.
+ * than 32.  The buffer is flushed at the end of every dispatch cycle anyway,
+ * so a large one only saves WriteToClient calls and reply headers while a
+ * client streams many small requests.
  */
-#define REPLY_BUF_SIZE 1024
+#define REPLY_BUF_SIZE 16384
+
+/* Protocol elements at least this big are written straight to the recording
+ * client rather than copied into the buffer first.
+ */
+#define REPLY_BUF_COPY_MAX 512
 
 /* Record Context structure */
 
@@ -281,6 +288,7 @@ RecordAProtocolElement(RecordContextPtr pContext, ClientPtr pClient,
                        int category, void *data, int datalen, int padlen,
                        int futurelen)
 {
+    static char padBuffer[3];   /* as in FlushClient */
     CARD32 elemHeaderData[2];
     int numElemHeaders = 0;
     Bool recordingClientSwapped = pContext->pRecordingClient->swapped;
@@ -369,17 +377,18 @@ RecordAProtocolElement(RecordContextPtr pContext, ClientPtr pClient,
 
     numElemHeaders *= 4;
 
-    /* if space available >= space needed, buffer the data */
+    /* if space available >= space needed, buffer the data, unless there's
+     * so much that copying it twice costs more than another write
+     */
 
-    if (REPLY_BUF_SIZE - pContext->numBufBytes >= datalen + numElemHeaders) {
+    if (datalen < REPLY_BUF_COPY_MAX &&
+        REPLY_BUF_SIZE - pContext->numBufBytes >= datalen + numElemHeaders) {
         if (numElemHeaders) {
             memcpy(pContext->replyBuffer + pContext->numBufBytes,
                    elemHeaderData, numElemHeaders);
             pContext->numBufBytes += numElemHeaders;
         }
         if (datalen) {
-            static char padBuffer[3];   /* as in FlushClient */
-
             memcpy(pContext->replyBuffer + pContext->numBufBytes,
                    data, datalen - padlen);
             pContext->numBufBytes += datalen - padlen;
@@ -392,6 +401,8 @@ RecordAProtocolElement(RecordContextPtr pContext, ClientPtr pClient,
         RecordFlushReplyBuffer(pContext, (void *) elemHeaderData,
                                numElemHeaders, (void *) data,
                                datalen - padlen);
+        if (padlen)
+            RecordFlushReplyBuffer(pContext, NULL, 0, padBuffer, padlen);
     }
 }                               /* RecordAProtocolElement */
 
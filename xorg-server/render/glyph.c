@@ -165,9 +165,24 @@ int
 HashGlyph(xGlyphInfo * gi,
           CARD8 *bits, unsigned long size, unsigned char sha1[20])
 {
-    void *ctx = x_sha1_init();
+    void *ctx;
     int success;
 
+    /* The glyph info goes into the seed whole, so glyphs only collide
+     * when their bits do */
+    if (PictureGlyphHashFast) {
+        memset(sha1, 0, 20);
+        x_hash128(bits, size,
+                  (uint64_t) gi->width | (uint64_t) gi->height << 16 |
+                  (uint64_t) (CARD16) gi->x << 32 |
+                  (uint64_t) (CARD16) gi->y << 48,
+                  (uint64_t) (CARD16) gi->xOff |
+                  (uint64_t) (CARD16) gi->yOff << 16,
+                  sha1);
+        return Success;
+    }
+
+    ctx = x_sha1_init();
     if (!ctx)
         return BadAlloc;
 
@@ -494,6 +509,26 @@ FreeGlyphSet(void *value, XID gid)
     return Success;
 }
 
+/** @see GetDefaultBytes */
+void
+GetGlyphSetBytes(void *value, XID id, ResourceSizePtr size)
+{
+    GlyphSetPtr glyphSet = (GlyphSetPtr) value;
+    CARD32 i, tableSize = glyphSet->hash.hashSet->size;
+    GlyphRefPtr table = glyphSet->hash.table;
+    GlyphPtr glyph;
+
+    /* The glyphs, which other glyph sets may share */
+    size->resourceSize = 0;
+    for (i = 0; i < tableSize; i++) {
+        glyph = table[i].glyph;
+        if (glyph && glyph != DeletedGlyph)
+            size->resourceSize += glyph->size;
+    }
+    size->pixmapRefSize = 0;
+    size->refCnt = glyphSet->refcnt;
+}
+
 static void
 GlyphExtents(int nlist, GlyphListPtr list, GlyphPtr * glyphs, BoxPtr extents)
 {
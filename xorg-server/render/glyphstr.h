@@ -31,6 +31,7 @@
 #include "regionstr.h"
 #include "miscstruct.h"
 #include "privates.h"
+#include "resource.h"
 
 #define GlyphFormat1	0
 #define GlyphFormat4	1
@@ -117,6 +118,9 @@ extern GlyphSetPtr AllocateGlyphSet(int fdepth, PictFormatPtr format);
 extern int
  FreeGlyphSet(void *value, XID gid);
 
+extern void
+ GetGlyphSetBytes(void *value, XID id, ResourceSizePtr size);
+
 #define GLYPH_HAS_GLYPH_PICTURE_ACCESSOR 1 /* used for api compat */
 extern _X_EXPORT PicturePtr
  GetGlyphPicture(GlyphPtr glyph, ScreenPtr pScreen);
@@ -52,6 +52,8 @@ RESTYPE PictureType;
 RESTYPE PictFormatType;
 RESTYPE GlyphSetType;
 int PictureCmapPolicy = PictureCmapPolicyDefault;
+int PictureCompositeThreads = 0;
+Bool PictureGlyphHashFast = FALSE;
 
 PictFormatPtr
 PictureWindowFormat(WindowPtr pWindow)
@@ -97,6 +99,8 @@ PictureCloseScreen(ScreenPtr pScreen)
             (*ps->CloseIndexed) (pScreen, &ps->formats[n]);
     GlyphUninit(pScreen);
     SetPictureScreen(pScreen, 0);
+    free(ps->visualFormats);
+    free(ps->formatHash);
     free(ps->formats);
     free(ps);
     return ret;
@@ -494,16 +498,13 @@ PictureGetSubpixelOrder(ScreenPtr pScreen)
     return ps->subpixel;
 }
 
-PictFormatPtr
-PictureMatchVisual(ScreenPtr pScreen, int depth, VisualPtr pVisual)
+static PictFormatPtr
+PictureScanVisual(PictureScreenPtr ps, int depth, VisualPtr pVisual)
 {
-    PictureScreenPtr ps = GetPictureScreenIfSet(pScreen);
     PictFormatPtr format;
     int nformat;
     int type;
 
-    if (!ps)
-        return 0;
     format = ps->formats;
     nformat = ps->nformats;
     switch (pVisual->class) {
@@ -542,6 +543,85 @@ PictureMatchVisual(ScreenPtr pScreen, int depth, VisualPtr pVisual)
     return 0;
 }
 
+PictFormatPtr
+PictureMatchVisual(ScreenPtr pScreen, int depth, VisualPtr pVisual)
+{
+    PictureScreenPtr ps = GetPictureScreenIfSet(pScreen);
+    PictVisualFormatPtr vf;
+
+    if (!ps)
+        return 0;
+    if (ps->visualFormats && pVisual >= pScreen->visuals &&
+        pVisual < pScreen->visuals + ps->nVisualFormats) {
+        vf = &ps->visualFormats[pVisual - pScreen->visuals];
+        if (vf->depth == depth)
+            return vf->format;
+    }
+    return PictureScanVisual(ps, depth, pVisual);
+}
+
+#define PictureFormatKey(depth, f) (((CARD32) (depth) << 24) | ((f) & 0xffffff))
+#define PictureFormatSlot(ps, key) (((key) * 0x9e3779b1U) >> (ps)->formatHashShift)
+
+/* Tables of more slots than this are not worth it */
+#define PICTURE_FORMAT_HASH_MAX_BITS 12
+
+/*
+ * Look for a table size at which no two formats share a slot, so that
+ * PictureMatchFormat needs to look at one slot only.
+ */
+static Bool
+PictureInitFormatHash(PictureScreenPtr ps)
+{
+    int bits, n;
+
+    for (bits = 1; (1 << bits) < ps->nformats * 2; bits++)
+        ;
+    for (; bits <= PICTURE_FORMAT_HASH_MAX_BITS; bits++) {
+        ps->formatHash = calloc(1 << bits, sizeof(PictFormatPtr));
+        if (!ps->formatHash)
+            return FALSE;
+        ps->formatHashShift = 32 - bits;
+        for (n = 0; n < ps->nformats; n++) {
+            PictFormatPtr format = &ps->formats[n], other;
+            CARD32 key = PictureFormatKey(format->depth, format->format);
+            CARD32 slot = PictureFormatSlot(ps, key);
+
+            /* Of two formats that only differ in bpp, the first one wins,
+             * as it does when scanning the list */
+            other = ps->formatHash[slot];
+            if (other && PictureFormatKey(other->depth, other->format) != key)
+                break;
+            if (!other)
+                ps->formatHash[slot] = format;
+        }
+        if (n == ps->nformats)
+            return TRUE;
+        free(ps->formatHash);
+        ps->formatHash = NULL;
+    }
+    return TRUE;
+}
+
+static Bool
+PictureInitVisualFormats(ScreenPtr pScreen, PictureScreenPtr ps)
+{
+    int i;
+
+    ps->visualFormats = calloc(pScreen->numVisuals,
+                               sizeof(PictVisualFormatRec));
+    if (!ps->visualFormats)
+        return FALSE;
+    ps->nVisualFormats = pScreen->numVisuals;
+    for (i = 0; i < pScreen->numVisuals; i++) {
+        PictVisualFormatPtr vf = &ps->visualFormats[i];
+
+        vf->depth = visualDepth(pScreen, &pScreen->visuals[i]);
+        vf->format = PictureScanVisual(ps, vf->depth, &pScreen->visuals[i]);
+    }
+    return TRUE;
+}
+
 PictFormatPtr
 PictureMatchFormat(ScreenPtr pScreen, int depth, CARD32 f)
 {
@@ -551,6 +631,14 @@ PictureMatchFormat(ScreenPtr pScreen, int depth, CARD32 f)
 
     if (!ps)
         return 0;
+    if (ps->formatHash) {
+        CARD32 key = PictureFormatKey(depth, f);
+
+        format = ps->formatHash[PictureFormatSlot(ps, key)];
+        if (format && PictureFormatKey(format->depth, format->format) == key)
+            return format;
+        return 0;
+    }
     format = ps->formats;
     nformat = ps->nformats;
     while (nformat--) {
@@ -625,7 +713,9 @@ PictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
         GlyphSetType = CreateNewResourceType(FreeGlyphSet, "GLYPHSET");
         if (!GlyphSetType)
             return FALSE;
+        SetResourceTypeSizeFunc(GlyphSetType, GetGlyphSetBytes);
         PictureGeneration = serverGeneration;
+        pixman_composite_set_threads(PictureCompositeThreads);
     }
     if (!dixRegisterPrivateKey(&PictureScreenPrivateKeyRec, PRIVATE_SCREEN, 0))
         return FALSE;
@@ -683,6 +773,9 @@ PictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
     ps->formats = formats;
     ps->fallback = formats;
     ps->nformats = nformats;
+    ps->visualFormats = NULL;
+    ps->nVisualFormats = 0;
+    ps->formatHash = NULL;
 
     ps->filters = 0;
     ps->nfilters = 0;
@@ -698,9 +791,13 @@ PictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
     pScreen->CloseScreen = PictureCloseScreen;
     pScreen->StoreColors = PictureStoreColors;
 
-    if (!PictureSetDefaultFilters(pScreen)) {
+    if (!PictureSetDefaultFilters(pScreen) ||
+        !PictureInitVisualFormats(pScreen, ps) ||
+        !PictureInitFormatHash(ps)) {
         PictureResetFilters(pScreen);
         SetPictureScreen(pScreen, 0);
+        free(ps->visualFormats);
+        free(ps->formatHash);
         free(formats);
         free(ps);
         return FALSE;
@@ -870,7 +967,7 @@ CreateSolidPicture(Picture pid, xRenderColor * color, int *error)
     pPicture->pSourcePict = (SourcePictPtr) malloc(sizeof(PictSolidFill));
     if (!pPicture->pSourcePict) {
         *error = BadAlloc;
-        free(pPicture);
+        dixFreeObjectWithPrivates(pPicture, PRIVATE_PICTURE);
         return 0;
     }
     pPicture->pSourcePict->type = SourcePictTypeSolidFill;
@@ -901,7 +998,7 @@ CreateLinearGradientPicture(Picture pid, xPointFixed * p1, xPointFixed * p2,
     pPicture->pSourcePict = (SourcePictPtr) malloc(sizeof(PictLinearGradient));
     if (!pPicture->pSourcePict) {
         *error = BadAlloc;
-        free(pPicture);
+        dixFreeObjectWithPrivates(pPicture, PRIVATE_PICTURE);
         return 0;
     }
 
@@ -911,7 +1008,7 @@ CreateLinearGradientPicture(Picture pid, xPointFixed * p1, xPointFixed * p2,
 
     initGradient(pPicture->pSourcePict, nStops, stops, colors, error);
     if (*error) {
-        free(pPicture);
+        dixFreeObjectWithPrivates(pPicture, PRIVATE_PICTURE);
         return 0;
     }
     return pPicture;
@@ -941,7 +1038,7 @@ CreateRadialGradientPicture(Picture pid, xPointFixed * inner,
     pPicture->pSourcePict = (SourcePictPtr) malloc(sizeof(PictRadialGradient));
     if (!pPicture->pSourcePict) {
         *error = BadAlloc;
-        free(pPicture);
+        dixFreeObjectWithPrivates(pPicture, PRIVATE_PICTURE);
         return 0;
     }
     radial = &pPicture->pSourcePict->radial;
@@ -956,7 +1053,7 @@ CreateRadialGradientPicture(Picture pid, xPointFixed * inner,
 
     initGradient(pPicture->pSourcePict, nStops, stops, colors, error);
     if (*error) {
-        free(pPicture);
+        dixFreeObjectWithPrivates(pPicture, PRIVATE_PICTURE);
         return 0;
     }
     return pPicture;
@@ -984,7 +1081,7 @@ CreateConicalGradientPicture(Picture pid, xPointFixed * center, xFixed angle,
     pPicture->pSourcePict = (SourcePictPtr) malloc(sizeof(PictConicalGradient));
     if (!pPicture->pSourcePict) {
         *error = BadAlloc;
-        free(pPicture);
+        dixFreeObjectWithPrivates(pPicture, PRIVATE_PICTURE);
         return 0;
     }
 
@@ -994,7 +1091,7 @@ CreateConicalGradientPicture(Picture pid, xPointFixed * center, xFixed angle,
 
     initGradient(pPicture->pSourcePict, nStops, stops, colors, error);
     if (*error) {
-        free(pPicture);
+        dixFreeObjectWithPrivates(pPicture, PRIVATE_PICTURE);
         return 0;
     }
     return pPicture;
@@ -173,6 +173,20 @@ extern int PictureCmapPolicy;
 
 extern int PictureParseCmapPolicy(const char *name);
 
+/*
+ * -renderthreads: number of threads, the server's own included, that
+ * pixman spreads large composites over.  0 leaves them all on the
+ * server thread.
+ */
+extern int PictureCompositeThreads;
+
+/*
+ * -glyphhash fast: tell glyphs apart with a fast 128 bit hash rather than
+ * SHA1.  A client could then make its glyph collide with another client's,
+ * so this is only for servers whose clients trust each other.
+ */
+extern Bool PictureGlyphHashFast;
+
 extern int RenderErrBase;
 
 /* Fixed point updates from Carl Worth, USC, Information Sciences Institute */
@@ -280,6 +280,11 @@ typedef Bool (*RealizeGlyphProcPtr) (ScreenPtr pScreen, GlyphPtr glyph);
 
 typedef void (*UnrealizeGlyphProcPtr) (ScreenPtr pScreen, GlyphPtr glyph);
 
+typedef struct _PictVisualFormat {
+    int depth;
+    PictFormatPtr format;
+} PictVisualFormatRec, *PictVisualFormatPtr;
+
 typedef struct _PictureScreen {
     PictFormatPtr formats;
     PictFormatPtr fallback;
@@ -342,6 +347,12 @@ typedef struct _PictureScreen {
 #define PICTURE_SCREEN_VERSION 2
     TriStripProcPtr TriStrip;
     TriFanProcPtr TriFan;
+
+    /* Built by PictureInit for PictureMatchVisual and PictureMatchFormat */
+    PictVisualFormatPtr visualFormats;  /* by index in pScreen->visuals */
+    int nVisualFormats;                 /* visuals added later are not in it */
+    PictFormatPtr *formatHash;          /* NULL if no size was collision free */
+    int formatHashShift;
 } PictureScreenRec, *PictureScreenPtr;
 
 extern _X_EXPORT DevPrivateKeyRec PictureScreenPrivateKeyRec;
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests for the row kernels behind the byte aligned fbBlt and fbSolid
+ * spans and XYPixmap fbGetImage.  Every kernel set the CPU supports is
+ * checked against the raster ops worked out bit by bit, through all 16
+ * ops, several plane masks and alignments and overlapping copies in both
+ * directions, and against planes pulled out pixel by pixel.  Timings on
+ * wide rows are only printed with XORG_TEST_BENCHMARK set.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+
+#include "fb.h"
+#include "fbrow.h"
+#include "tests-common.h"
+
+#define FB_TEST_MAX_ROW		100
+#define FB_TEST_SIZE		(FB_TEST_MAX_ROW + 8)
+#define FB_TEST_BENCH_ROW	4096
+
+static const CARD32 planemasks[] = { 0xffffffff, 0x00ffffff, 0x12345678 };
+
+/* What alu makes of one byte, with dst left alone outside the plane mask */
+static CARD8
+fb_row_rop(int alu, CARD8 s, CARD8 d, CARD8 pm)
+{
+    CARD8 r = 0;
+    int bit;
+
+    for (bit = 0; bit < 8; bit++) {
+        int i = (((s >> bit) & 1) << 1) | ((d >> bit) & 1);
+
+        r |= ((alu >> (3 - i)) & 1) << bit;
+    }
+    return (r & pm) | (d & ~pm);
+}
+
+static void
+fb_row_masks(int alu, CARD32 pm, CARD32 *ca1, CARD32 *cx1,
+             CARD32 *ca2, CARD32 *cx2)
+{
+    FbDeclareMergeRop();
+
+    FbInitializeMergeRop(alu, pm);
+    *ca1 = _ca1;
+    *cx1 = _cx1;
+    *ca2 = _ca2;
+    *cx2 = _cx2;
+}
+
+/* Byte k of buf is under byte (buf + k) & 3 of the mask words */
+static CARD8
+fb_row_mask_byte(CARD32 mask, const CARD8 *p)
+{
+    CARD8 bytes[4];
+
+    memcpy(bytes, &mask, 4);
+    return bytes[(uintptr_t) p & 3];
+}
+
+static void
+fb_row_blt_correctness(const fbRowImplRec *impl)
+{
+    CARD32 *words = calloc(3, FB_TEST_SIZE);
+    CARD8 *src = (CARD8 *) words;
+    CARD8 *dst = src + FB_TEST_SIZE;
+    CARD8 *ref = dst + FB_TEST_SIZE;
+    int alu, p, n, so, dof, i;
+
+    assert(words);
+    for (alu = 0; alu < 16; alu++) {
+        for (p = 0; p < ARRAY_SIZE(planemasks); p++) {
+            CARD32 ca1, cx1, ca2, cx2;
+
+            fb_row_masks(alu, planemasks[p], &ca1, &cx1, &ca2, &cx2);
+            for (n = 0; n <= FB_TEST_MAX_ROW; n++) {
+                for (so = 0; so < 4; so++) {
+                    for (dof = 0; dof < 4; dof++) {
+                        for (i = 0; i < FB_TEST_SIZE; i++) {
+                            src[i] = i * 37 + 11;
+                            dst[i] = ref[i] = i * 91 + alu;
+                        }
+                        for (i = 0; i < n; i++)
+                            ref[dof + i] =
+                                fb_row_rop(alu, src[so + i], ref[dof + i],
+                                           fb_row_mask_byte(planemasks[p],
+                                                            dst + dof + i));
+                        (*impl->blt) (dst + dof, src + so, n,
+                                      ca1, cx1, ca2, cx2, n & 1);
+                        assert(memcmp(dst, ref, FB_TEST_SIZE) == 0);
+                    }
+                }
+            }
+        }
+    }
+    free(words);
+}
+
+/*
+ * Copies within one buffer, onto spans overlapping the source on either
+ * side, must behave as if the whole source had been read first.
+ */
+static void
+fb_row_blt_overlap(const fbRowImplRec *impl)
+{
+    CARD32 *words = calloc(3, 2 * FB_TEST_SIZE);
+    CARD8 *buf = (CARD8 *) words;
+    CARD8 *ref = buf + 2 * FB_TEST_SIZE;
+    CARD8 *orig = ref + 2 * FB_TEST_SIZE;
+    static const int alus[] = { GXcopy, GXxor, GXcopyInverted, GXor };
+    int a, p, n, shift, i;
+
+    assert(words);
+    for (a = 0; a < ARRAY_SIZE(alus); a++) {
+        for (p = 0; p < ARRAY_SIZE(planemasks); p++) {
+            CARD32 ca1, cx1, ca2, cx2;
+
+            fb_row_masks(alus[a], planemasks[p], &ca1, &cx1, &ca2, &cx2);
+            for (n = 0; n <= FB_TEST_MAX_ROW; n += 7) {
+                for (shift = -40; shift <= 40; shift++) {
+                    int so = FB_TEST_SIZE / 2, dof = so + shift;
+
+                    for (i = 0; i < 2 * FB_TEST_SIZE; i++)
+                        buf[i] = ref[i] = orig[i] = i * 53 + 5;
+                    for (i = 0; i < n; i++)
+                        ref[dof + i] =
+                            fb_row_rop(alus[a], orig[so + i], orig[dof + i],
+                                       fb_row_mask_byte(planemasks[p],
+                                                        buf + dof + i));
+                    (*impl->blt) (buf + dof, buf + so, n,
+                                  ca1, cx1, ca2, cx2, shift > 0);
+                    assert(memcmp(buf, ref, 2 * FB_TEST_SIZE) == 0);
+                }
+            }
+        }
+    }
+    free(words);
+}
+
+static void
+fb_row_solid_correctness(const fbRowImplRec *impl)
+{
+    static const CARD32 ands[] = { 0, 0xffffffff, 0xff00ff00, 0x0f1e2d3c };
+    static const CARD32 xors[] = { 0, 0xffffffff, 0x89abcdef };
+    CARD32 *words = calloc(2, FB_TEST_SIZE);
+    CARD8 *dst = (CARD8 *) words;
+    CARD8 *ref = dst + FB_TEST_SIZE;
+    int a, x, n, dof, i;
+
+    assert(words);
+    for (a = 0; a < ARRAY_SIZE(ands); a++) {
+        for (x = 0; x < ARRAY_SIZE(xors); x++) {
+            for (n = 0; n <= FB_TEST_MAX_ROW; n++) {
+                for (dof = 0; dof < 4; dof++) {
+                    for (i = 0; i < FB_TEST_SIZE; i++)
+                        dst[i] = ref[i] = i * 29 + 3;
+                    for (i = 0; i < n; i++)
+                        ref[dof + i] =
+                            (ref[dof + i] &
+                             fb_row_mask_byte(ands[a], dst + dof + i)) ^
+                            fb_row_mask_byte(xors[x], dst + dof + i);
+                    (*impl->solid) (dst + dof, n, ands[a], xors[x]);
+                    assert(memcmp(dst, ref, FB_TEST_SIZE) == 0);
+                }
+            }
+        }
+    }
+    free(words);
+}
+
+static void
+fb_row_plane_correctness(const fbRowImplRec *impl)
+{
+    static const int bpps[] = { 8, 16, 32 };
+    CARD32 *words = calloc(FB_TEST_SIZE, sizeof(CARD32));
+    CARD8 dst[FB_TEST_SIZE / 8 + 1], ref[FB_TEST_SIZE / 8 + 1];
+    int b, plane, n, i;
+
+    assert(words);
+    for (b = 0; b < ARRAY_SIZE(bpps); b++) {
+        int bpp = bpps[b];
+
+        for (plane = 0; plane < bpp; plane++) {
+            for (n = 0; n <= FB_TEST_MAX_ROW; n++) {
+                CARD8 *src = (CARD8 *) words;
+
+                for (i = 0; i < FB_TEST_SIZE * 4; i++)
+                    src[i] = (i * 167 + 13) ^ (i >> 3) ^ (n << plane % 8);
+                memset(ref, 0, sizeof(ref));
+                for (i = 0; i < n; i++) {
+                    CARD32 p;
+
+                    if (bpp == 8)
+                        p = src[i];
+                    else if (bpp == 16)
+                        p = ((CARD16 *) src)[i];
+                    else
+                        p = words[i];
+                    if (p & (1U << plane))
+                        ref[i >> 3] |= 1 << (i & 7);
+                }
+                memset(dst, 0xa5, sizeof(dst));
+                (*impl->plane) (dst, src, n, bpp, 1U << plane);
+                assert(memcmp(dst, ref, (n + 7) >> 3) == 0);
+                /* Nothing past the last byte is touched */
+                assert(((n + 7) >> 3) == sizeof(dst) ||
+                       dst[(n + 7) >> 3] == 0xa5);
+            }
+        }
+    }
+
+    /* More than one bit looks for any of them */
+    for (i = 0; i < 64; i++)
+        words[i] = i & 3 ? (1U << (i & 31)) : 0;
+    (*impl->plane) (dst, (CARD8 *) words, 64, 32, 0x00f00f00);
+    for (i = 0; i < 64; i++)
+        assert(((dst[i >> 3] >> (i & 7)) & 1) ==
+               ((words[i] & 0x00f00f00) != 0));
+
+    free(words);
+}
+
+static void
+fb_row_benchmark(const fbRowImplRec *impl)
+{
+    static const struct {
+        const char *name;
+        int alu;
+        CARD32 pm;
+    } ops[] = {
+        { "copy", GXcopy, 0xffffffff },
+        { "copy/pm", GXcopy, 0x00ffffff },
+        { "xor", GXxor, 0xffffffff },
+    };
+    CARD32 *src = calloc(FB_TEST_BENCH_ROW / 4, sizeof(CARD32));
+    CARD32 *dst = calloc(FB_TEST_BENCH_ROW / 4, sizeof(CARD32));
+    int o, k;
+
+    assert(src && dst);
+    for (o = 0; o < ARRAY_SIZE(ops); o++) {
+        CARD32 ca1, cx1, ca2, cx2;
+        clock_t start;
+
+        fb_row_masks(ops[o].alu, ops[o].pm, &ca1, &cx1, &ca2, &cx2);
+
+        start = clock();
+        for (k = 0; k < 10000; k++)
+            (*impl->blt) ((CARD8 *) dst, (CARD8 *) src, FB_TEST_BENCH_ROW,
+                          ca1, cx1, ca2, cx2, 0);
+        benchmark_report(start, 10000.0 * FB_TEST_BENCH_ROW,
+                         "fb row %-8s blt/%-8s per byte", impl->name,
+                         ops[o].name);
+
+        start = clock();
+        for (k = 0; k < 10000; k++)
+            (*impl->solid) ((CARD8 *) dst, FB_TEST_BENCH_ROW,
+                            ~ops[o].pm, 0x5a5a5a5a & ops[o].pm);
+        benchmark_report(start, 10000.0 * FB_TEST_BENCH_ROW,
+                         "fb row %-8s solid/%-8s per byte", impl->name,
+                         ops[o].name);
+    }
+
+    for (o = 8; o <= 32; o <<= 1) {
+        clock_t start = clock();
+
+        for (k = 0; k < 10000; k++)
+            (*impl->plane) ((CARD8 *) dst, (CARD8 *) src,
+                            FB_TEST_BENCH_ROW / (o >> 3), o, 1 << (o - 1));
+        benchmark_report(start, 10000.0 * FB_TEST_BENCH_ROW / (o >> 3),
+                         "fb row %-8s plane/%-2d per pixel", impl->name, o);
+    }
+
+    free(src);
+    free(dst);
+}
+
+static void
+fb_row_test(void)
+{
+    const fbRowImplRec *impls = fbRowImplementations();
+    const fbRowImplRec *impl;
+
+    for_each_impl(impl, impls) {
+        fb_row_blt_correctness(impl);
+        fb_row_blt_overlap(impl);
+        fb_row_solid_correctness(impl);
+        fb_row_plane_correctness(impl);
+        if (benchmark_enabled())
+            fb_row_benchmark(impl);
+    }
+}
+
+int
+fb_test(void)
+{
+    fb_row_test();
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests for the row kernels of the rotated shadow update functions.
+ * Every kernel set the CPU supports is checked against the plain C
+ * reference.  Timings on typical rows are only printed with
+ * XORG_TEST_BENCHMARK set.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+
+#include "shrow.h"
+#include "tests-common.h"
+
+#define SHADOW_TEST_STRIDE	67
+#define SHADOW_TEST_PIXELS	(SHADOW_TEST_STRIDE * 80)
+#define SHADOW_TEST_MAX_ROW	70
+
+/* Steps of a 0, 180, 90 and 270 degree update */
+static const int steps[] = { 1, -1, SHADOW_TEST_STRIDE, -SHADOW_TEST_STRIDE };
+
+static const CARD16 *
+row_start16(const CARD16 *pixels, int n, int step)
+{
+    /* Leave room so that every pixel read lies within the buffer */
+    return step > 0 ? pixels : pixels + (n ? (n - 1) * -step : 0);
+}
+
+static const CARD32 *
+row_start32(const CARD32 *pixels, int n, int step)
+{
+    return step > 0 ? pixels : pixels + (n ? (n - 1) * -step : 0);
+}
+
+static void
+shadow_row_correctness(const shadowRowImplRec *ref,
+                       const shadowRowImplRec *impl,
+                       CARD16 *src16, CARD32 *src32)
+{
+    CARD16 dst16[SHADOW_TEST_MAX_ROW + 1], ref16[SHADOW_TEST_MAX_ROW + 1];
+    CARD32 dst32[SHADOW_TEST_MAX_ROW + 1], ref32[SHADOW_TEST_MAX_ROW + 1];
+    int s, n, offset;
+
+    for (s = 0; s < ARRAY_SIZE(steps); s++) {
+        for (n = 0; n <= SHADOW_TEST_MAX_ROW; n++) {
+            /* Vary the alignment of both source and destination */
+            for (offset = 0; offset < 3; offset++) {
+                const CARD16 *sha16 =
+                    row_start16(src16 + offset, n, steps[s]);
+                const CARD32 *sha32 =
+                    row_start32(src32 + offset, n, steps[s]);
+
+                memset(dst16, 0xa5, sizeof(dst16));
+                memset(ref16, 0xa5, sizeof(ref16));
+                (*ref->row16) (ref16 + (offset & 1), sha16, n, steps[s]);
+                (*impl->row16) (dst16 + (offset & 1), sha16, n, steps[s]);
+                assert(memcmp(dst16, ref16, sizeof(dst16)) == 0);
+
+                memset(dst32, 0xa5, sizeof(dst32));
+                memset(ref32, 0xa5, sizeof(ref32));
+                (*ref->row32) (ref32 + (offset & 1), sha32, n, steps[s]);
+                (*impl->row32) (dst32 + (offset & 1), sha32, n, steps[s]);
+                assert(memcmp(dst32, ref32, sizeof(dst32)) == 0);
+            }
+        }
+    }
+}
+
+static void
+shadow_row_benchmark(const shadowRowImplRec *impl,
+                     CARD16 *src16, CARD32 *src32)
+{
+    CARD16 dst16[64];
+    CARD32 dst32[64];
+    int s, k;
+
+    for (s = 0; s < ARRAY_SIZE(steps); s++) {
+        const CARD16 *sha16 = row_start16(src16, 64, steps[s]);
+        const CARD32 *sha32 = row_start32(src32, 64, steps[s]);
+        clock_t start;
+
+        start = clock();
+        for (k = 0; k < 100000; k++)
+            (*impl->row16) (dst16, sha16, 64, steps[s]);
+        benchmark_report(start, 100000.0 * 64,
+                         "shadow row %-8s step %4d 16bpp per pixel",
+                         impl->name, steps[s]);
+
+        start = clock();
+        for (k = 0; k < 100000; k++)
+            (*impl->row32) (dst32, sha32, 64, steps[s]);
+        benchmark_report(start, 100000.0 * 64,
+                         "shadow row %-8s step %4d 32bpp per pixel",
+                         impl->name, steps[s]);
+    }
+}
+
+static void
+shadow_row_test(void)
+{
+    const shadowRowImplRec *impls = shadowRowImplementations();
+    const shadowRowImplRec *impl;
+    CARD16 *src16 = calloc(SHADOW_TEST_PIXELS, sizeof(CARD16));
+    CARD32 *src32 = calloc(SHADOW_TEST_PIXELS, sizeof(CARD32));
+    int i;
+
+    assert(src16 && src32);
+    for (i = 0; i < SHADOW_TEST_PIXELS; i++) {
+        src16[i] = i * 31 + 7;
+        src32[i] = i * 2654435761u;
+    }
+
+    for_each_impl(impl, impls) {
+        shadow_row_correctness(&impls[0], impl, src16, src32);
+        if (benchmark_enabled())
+            shadow_row_benchmark(impl, src16, src32);
+    }
+
+    free(src16);
+    free(src32);
+}
+
+int
+shadow_test(void)
+{
+    shadow_row_test();
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -31,3 +32,22 @@ child_failed:
         exit(func());
     }
 }
+
+int
+benchmark_enabled(void)
+{
+    return getenv("XORG_TEST_BENCHMARK") != NULL;
+}
+
+/* Print the time taken since start for each of units */
+void
+benchmark_report(clock_t start, double units, const char *fmt, ...)
+{
+    double ns = (clock() - start) * 1e9 / CLOCKS_PER_SEC / units;
+    va_list args;
+
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf(": %6.3f ns\n", ns);
+}
@@ -1,6 +1,11 @@
 #ifndef TESTS_COMMON_H
 #define TESTS_COMMON_H
 
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include <X11/Xfuncproto.h>
+
 #include "tests.h"
 
 #define ARRAY_SIZE(a)  (sizeof((a)) / sizeof((a)[0]))
@@ -9,4 +14,19 @@
 
 void run_test_in_child(int (*func)(void), const char *funcname);
 
+/*
+ * Walk a kernel table ended by a NULL name, whose first entry must be the
+ * plain C "generic" set the others are checked against.
+ */
+#define for_each_impl(impl, impls) \
+    for (assert((impls)[0].name != NULL && \
+                strcmp((impls)[0].name, "generic") == 0), (impl) = (impls); \
+         (impl)->name != NULL; (impl)++)
+
+/* Benchmarks only run with XORG_TEST_BENCHMARK set in the environment */
+int benchmark_enabled(void);
+
+void benchmark_report(clock_t start, double units, const char *fmt, ...)
+    _X_ATTRIBUTE_PRINTF(3, 4);
+
 #endif /* TESTS_COMMON_H */
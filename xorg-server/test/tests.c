@@ -9,9 +9,11 @@ main(int argc, char **argv)
     run_test(string_test);
 
 #ifdef XORG_TESTS
+    run_test(fb_test);
     run_test(fixes_test);
     run_test(input_test);
     run_test(misc_test);
+    run_test(shadow_test);
     run_test(signal_logging_test);
     run_test(touch_test);
     run_test(xfree86_test);
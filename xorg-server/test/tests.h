@@ -1,11 +1,13 @@
 #ifndef TESTS_H
 #define TESTS_H
 
+int fb_test(void);
 int fixes_test(void);
 int hashtabletest_test(void);
 int input_test(void);
 int list_test(void);
 int misc_test(void);
+int shadow_test(void);
 int signal_logging_test(void);
 int string_test(void);
 int touch_test(void);
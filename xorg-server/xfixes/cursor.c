@@ -192,6 +192,17 @@ CursorDisplayCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
     return ret;
 }
 
+/*
+ * The image of the last core cursor asked for.  Screen recorders fetch the
+ * cursor every frame, so it is kept rather than made from the bitmaps each
+ * time, and goes by the serial number and the colours, which
+ * RecolorCursor changes.
+ */
+static CARD32 *cursorImage;
+static int cursorImagePixels;
+static CARD32 cursorImageSerial;
+static CARD32 cursorImageFore, cursorImageBack;
+
 static Bool
 CursorCloseScreen(ScreenPtr pScreen)
 {
@@ -205,6 +216,9 @@ CursorCloseScreen(ScreenPtr pScreen)
     deleteCursorHideCountsForScreen(pScreen);
     ret = (*pScreen->CloseScreen) (pScreen);
     free(cs);
+    free(cursorImage);
+    cursorImage = NULL;
+    cursorImagePixels = 0;
     return ret;
 }
 
@@ -319,53 +333,85 @@ SXFixesCursorNotifyEvent(xXFixesCursorNotifyEvent * from,
     cpswapl(from->name, to->name);
 }
 
-static void
-CopyCursorToImage(CursorPtr pCursor, CARD32 *image)
+static const CARD32 *
+GetCursorImage(CursorPtr pCursor)
 {
     int width = pCursor->bits->width;
     int height = pCursor->bits->height;
     int npixels = width * height;
+    unsigned char *srcLine = pCursor->bits->source;
+    unsigned char *mskLine = pCursor->bits->mask;
+    int stride = BitmapBytePad(width);
+    int x, y;
+    CARD32 fg, bg, *image;
 
     if (pCursor->bits->argb)
-        memcpy(image, pCursor->bits->argb, npixels * sizeof(CARD32));
-    else
-    {
-        unsigned char *srcLine = pCursor->bits->source;
-        unsigned char *mskLine = pCursor->bits->mask;
-        int stride = BitmapBytePad(width);
-        int x, y;
-        CARD32 fg, bg;
-
-        fg = (0xff000000 |
-              ((pCursor->foreRed & 0xff00) << 8) |
-              (pCursor->foreGreen & 0xff00) | (pCursor->foreBlue >> 8));
-        bg = (0xff000000 |
-              ((pCursor->backRed & 0xff00) << 8) |
-              (pCursor->backGreen & 0xff00) | (pCursor->backBlue >> 8));
-        for (y = 0; y < height; y++) {
-            for (x = 0; x < width; x++) {
-                if (GetBit(mskLine, x)) {
-                    if (GetBit(srcLine, x))
-                        *image++ = fg;
-                    else
-                        *image++ = bg;
-                }
+        return pCursor->bits->argb;
+
+    fg = (0xff000000 |
+          ((pCursor->foreRed & 0xff00) << 8) |
+          (pCursor->foreGreen & 0xff00) | (pCursor->foreBlue >> 8));
+    bg = (0xff000000 |
+          ((pCursor->backRed & 0xff00) << 8) |
+          (pCursor->backGreen & 0xff00) | (pCursor->backBlue >> 8));
+
+    if (cursorImage && cursorImageSerial == pCursor->serialNumber &&
+        cursorImageFore == fg && cursorImageBack == bg)
+        return cursorImage;
+
+    if (npixels > cursorImagePixels) {
+        image = reallocarray(cursorImage, npixels, sizeof(CARD32));
+        if (!image)
+            return NULL;
+        cursorImage = image;
+        cursorImagePixels = npixels;
+    }
+
+    image = cursorImage;
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            if (GetBit(mskLine, x)) {
+                if (GetBit(srcLine, x))
+                    *image++ = fg;
                 else
-                    *image++ = 0;
+                    *image++ = bg;
             }
-            srcLine += stride;
-            mskLine += stride;
+            else
+                *image++ = 0;
         }
+        srcLine += stride;
+        mskLine += stride;
+    }
+
+    cursorImageSerial = pCursor->serialNumber;
+    cursorImageFore = fg;
+    cursorImageBack = bg;
+    return cursorImage;
+}
+
+/*
+ * Byte swap a copy of the image for the clients which need it
+ */
+static CARD32 *
+SwapCursorImage(const CARD32 *image, int npixels)
+{
+    CARD32 *swapped = xallocarray(npixels, sizeof(CARD32));
+
+    if (swapped) {
+        memcpy(swapped, image, npixels * sizeof(CARD32));
+        SwapLongs(swapped, npixels);
     }
+    return swapped;
 }
 
 int
 ProcXFixesGetCursorImage(ClientPtr client)
 {
 /*    REQUEST(xXFixesGetCursorImageReq); */
-    xXFixesGetCursorImageReply *rep;
+    xXFixesGetCursorImageReply rep;
     CursorPtr pCursor;
-    CARD32 *image;
+    const CARD32 *image;
+    CARD32 *swapped = NULL;
     int npixels, width, height, rc, x, y;
 
     REQUEST_SIZE_MATCH(xXFixesGetCursorImageReq);
@@ -380,39 +426,42 @@ ProcXFixesGetCursorImage(ClientPtr client)
     width = pCursor->bits->width;
     height = pCursor->bits->height;
     npixels = width * height;
-    rep = calloc(sizeof(xXFixesGetCursorImageReply) + npixels * sizeof(CARD32),
-                 1);
-    if (!rep)
+    image = GetCursorImage(pCursor);
+    if (!image)
         return BadAlloc;
+    if (client->swapped) {
+        image = swapped = SwapCursorImage(image, npixels);
+        if (!swapped)
+            return BadAlloc;
+    }
+
+    rep = (xXFixesGetCursorImageReply) {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = npixels,
+        .width = width,
+        .height = height,
+        .x = x,
+        .y = y,
+        .xhot = pCursor->bits->xhot,
+        .yhot = pCursor->bits->yhot,
+        .cursorSerial = pCursor->serialNumber,
+    };
 
-    rep->type = X_Reply;
-    rep->sequenceNumber = client->sequence;
-    rep->length = npixels;
-    rep->width = width;
-    rep->height = height;
-    rep->x = x;
-    rep->y = y;
-    rep->xhot = pCursor->bits->xhot;
-    rep->yhot = pCursor->bits->yhot;
-    rep->cursorSerial = pCursor->serialNumber;
-
-    image = (CARD32 *) (rep + 1);
-    CopyCursorToImage(pCursor, image);
     if (client->swapped) {
-        swaps(&rep->sequenceNumber);
-        swapl(&rep->length);
-        swaps(&rep->x);
-        swaps(&rep->y);
-        swaps(&rep->width);
-        swaps(&rep->height);
-        swaps(&rep->xhot);
-        swaps(&rep->yhot);
-        swapl(&rep->cursorSerial);
-        SwapLongs(image, npixels);
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swaps(&rep.x);
+        swaps(&rep.y);
+        swaps(&rep.width);
+        swaps(&rep.height);
+        swaps(&rep.xhot);
+        swaps(&rep.yhot);
+        swapl(&rep.cursorSerial);
     }
-    WriteToClient(client,
-                  sizeof(xXFixesGetCursorImageReply) + (npixels << 2), rep);
-    free(rep);
+    WriteToClient(client, sizeof(xXFixesGetCursorImageReply), &rep);
+    WriteToClient(client, npixels << 2, image);
+    free(swapped);
     return Success;
 }
 
@@ -508,9 +557,10 @@ int
 ProcXFixesGetCursorImageAndName(ClientPtr client)
 {
 /*    REQUEST(xXFixesGetCursorImageAndNameReq); */
-    xXFixesGetCursorImageAndNameReply *rep;
+    xXFixesGetCursorImageAndNameReply rep;
     CursorPtr pCursor;
-    CARD32 *image;
+    const CARD32 *image;
+    CARD32 *swapped = NULL;
     int npixels;
     const char *name;
     int nbytes, nbytesRound;
@@ -532,44 +582,47 @@ ProcXFixesGetCursorImageAndName(ClientPtr client)
     name = pCursor->name ? NameForAtom(pCursor->name) : "";
     nbytes = strlen(name);
     nbytesRound = pad_to_int32(nbytes);
-    rep = calloc(sizeof(xXFixesGetCursorImageAndNameReply) +
-                 npixels * sizeof(CARD32) + nbytesRound, 1);
-    if (!rep)
+    image = GetCursorImage(pCursor);
+    if (!image)
         return BadAlloc;
+    if (client->swapped) {
+        image = swapped = SwapCursorImage(image, npixels);
+        if (!swapped)
+            return BadAlloc;
+    }
+
+    rep = (xXFixesGetCursorImageAndNameReply) {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = npixels + bytes_to_int32(nbytesRound),
+        .width = width,
+        .height = height,
+        .x = x,
+        .y = y,
+        .xhot = pCursor->bits->xhot,
+        .yhot = pCursor->bits->yhot,
+        .cursorSerial = pCursor->serialNumber,
+        .cursorName = pCursor->name,
+        .nbytes = nbytes,
+    };
 
-    rep->type = X_Reply;
-    rep->sequenceNumber = client->sequence;
-    rep->length = npixels + bytes_to_int32(nbytesRound);
-    rep->width = width;
-    rep->height = height;
-    rep->x = x;
-    rep->y = y;
-    rep->xhot = pCursor->bits->xhot;
-    rep->yhot = pCursor->bits->yhot;
-    rep->cursorSerial = pCursor->serialNumber;
-    rep->cursorName = pCursor->name;
-    rep->nbytes = nbytes;
-
-    image = (CARD32 *) (rep + 1);
-    CopyCursorToImage(pCursor, image);
-    memcpy((image + npixels), name, nbytes);
     if (client->swapped) {
-        swaps(&rep->sequenceNumber);
-        swapl(&rep->length);
-        swaps(&rep->x);
-        swaps(&rep->y);
-        swaps(&rep->width);
-        swaps(&rep->height);
-        swaps(&rep->xhot);
-        swaps(&rep->yhot);
-        swapl(&rep->cursorSerial);
-        swapl(&rep->cursorName);
-        swaps(&rep->nbytes);
-        SwapLongs(image, npixels);
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swaps(&rep.x);
+        swaps(&rep.y);
+        swaps(&rep.width);
+        swaps(&rep.height);
+        swaps(&rep.xhot);
+        swaps(&rep.yhot);
+        swapl(&rep.cursorSerial);
+        swapl(&rep.cursorName);
+        swaps(&rep.nbytes);
     }
-    WriteToClient(client, sizeof(xXFixesGetCursorImageAndNameReply) +
-                  (npixels << 2) + nbytesRound, rep);
-    free(rep);
+    WriteToClient(client, sizeof(xXFixesGetCursorImageAndNameReply), &rep);
+    WriteToClient(client, npixels << 2, image);
+    WriteToClient(client, nbytes, name);
+    free(swapped);
     return Success;
 }
 
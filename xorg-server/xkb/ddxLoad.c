@@ -32,6 +32,7 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include <stdio.h>
 #include <ctype.h>
+#include <sys/stat.h>
 #include <X11/X.h>
 #include <X11/Xos.h>
 #include <X11/Xproto.h>
@@ -44,6 +45,7 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <xkbsrv.h>
 #include <X11/extensions/XI.h>
 #include "xkb.h"
+#include "xsha1.h"
 
 #define	PRE_ERROR_MSG "\"The XKEYBOARD keymap compiler (xkbcomp) reports:\""
 #define	ERROR_PREFIX	"\"> \""
@@ -81,6 +83,438 @@ OutputDirectory(char *outdir, size_t size)
     }
 }
 
+#if defined(WIN32)
+#define XKBCOMP_EXE "xkbcomp.exe"
+#define XKBCOMP_DLL "libxkbcomp.dll"
+#else
+#define XKBCOMP_EXE "xkbcomp"
+#endif
+
+/**
+ * Build the path of the compiled keymap mapName in directory dir the same
+ * way xkbcomp resolves it: relative directories are taken from the XKB
+ * base directory.
+ */
+static Bool
+XkmFilePath(char *buf, size_t size, const char *dir, const char *mapName)
+{
+    int len;
+
+    if ((XkbBaseDirectory != NULL) && (dir[0] != '/')
+#ifdef WIN32
+        && (!isalpha(dir[0]) || dir[1] != ':')
+#endif
+        )
+        len = snprintf(buf, size, "%s/%s%s.xkm", XkbBaseDirectory, dir,
+                       mapName);
+    else
+        len = snprintf(buf, size, "%s%s.xkm", dir, mapName);
+
+    if (len < 0 || len >= size) {
+        buf[0] = '\0';
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Compiled keymap cache.
+ *
+ * What xkbcomp produces depends only on the text we feed it, on the
+ * xkbcomp binary and on the keyboard description files it reads.  Its
+ * output is kept under a SHA1 of all three, so the next server start with
+ * the same keymap loads the .xkm directly instead of spawning xkbcomp.
+ * Cached maps are looked up in the "compiled" directory below the XKB base
+ * directory first, which an installer may populate ahead of time (see
+ * XkbDDXPrecacheKeymap), and then in the xkm output directory, where maps
+ * compiled at run time are stored.
+ */
+#define XKM_CACHE_VERSION "xkm-cache-2"
+#define XKM_CACHE_DIR "compiled" PATHSEPARATOR
+#define XKM_CACHE_MAX_FILES 256
+
+static void
+XkmCacheHashFile(void *ctx, const char *path)
+{
+    struct stat st;
+    long long id[2] = { -1, -1 };
+
+    if (stat(path, &st) == 0) {
+        id[0] = st.st_size;
+        id[1] = st.st_mtime;
+    }
+    x_sha1_update(ctx, id, sizeof(id));
+}
+
+/* The directory each section of a keymap takes its includes from */
+static const struct {
+    const char *section;
+    const char *dir;
+} XkmCacheSections[] = {
+    { "xkb_keycodes", "keycodes" },
+    { "xkb_types", "types" },
+    { "xkb_compat", "compat" },
+    { "xkb_symbols", "symbols" },
+    { "xkb_geometry", "geometry" },
+};
+
+typedef struct {
+    void *ctx;
+    char *seen[XKM_CACHE_MAX_FILES];
+    int nseen;
+    Bool overflow;
+} XkmCacheIncludesRec;
+
+/* Read all of f into a NUL terminated buffer the caller frees */
+static char *
+XkmCacheReadFile(FILE *f, size_t *length)
+{
+    char *text = NULL, *grown;
+    size_t len = 0, size = 0, n;
+
+    do {
+        if (len == size) {
+            size = size ? 2 * size : 16384;
+            grown = realloc(text, size + 1);
+            if (!grown) {
+                free(text);
+                return NULL;
+            }
+            text = grown;
+        }
+        n = fread(text + len, 1, size - len, f);
+        len += n;
+    } while (n > 0);
+    if (ferror(f)) {
+        free(text);
+        return NULL;
+    }
+    text[len] = '\0';
+    if (length)
+        *length = len;
+    return text;
+}
+
+static void XkmCacheHashIncludes(XkmCacheIncludesRec *inc, const char *text,
+                                 const char *dir);
+
+/* Hash the data file name in component directory dir and what it includes */
+static void
+XkmCacheHashInclude(XkmCacheIncludesRec *inc, const char *dir,
+                    const char *name, int len)
+{
+    char path[PATH_MAX], *text;
+    FILE *f;
+    int i;
+
+    if (snprintf(path, sizeof(path), "%s/%s/%.*s",
+                 XkbBaseDirectory ? XkbBaseDirectory : ".", dir,
+                 len, name) >= sizeof(path)) {
+        inc->overflow = TRUE;
+        return;
+    }
+    for (i = 0; i < inc->nseen; i++) {
+        if (strcmp(inc->seen[i], path) == 0)
+            return;
+    }
+    if (inc->nseen == XKM_CACHE_MAX_FILES ||
+        !(inc->seen[inc->nseen] = strdup(path))) {
+        inc->overflow = TRUE;
+        return;
+    }
+    inc->nseen++;
+
+    x_sha1_update(inc->ctx, path, strlen(path) + 1);
+    XkmCacheHashFile(inc->ctx, path);
+
+    f = fopen(path, "rb");
+    if (!f)
+        return;
+    text = XkmCacheReadFile(f, NULL);
+    fclose(f);
+    if (!text) {
+        inc->overflow = TRUE;
+        return;
+    }
+    XkmCacheHashIncludes(inc, text, dir);
+    free(text);
+}
+
+/*
+ * Hash the files named by the include, augment, override and replace
+ * statements in text, such as "pc+us(intl):2|inet(evdev)", which are taken
+ * from dir unless a section keyword says otherwise.  Comments are not
+ * skipped; a name in one costs a stat at worst.
+ */
+static void
+XkmCacheHashIncludes(XkmCacheIncludesRec *inc, const char *text,
+                     const char *dir)
+{
+    static const char *const merges[] = {
+        "include", "augment", "override", "replace"
+    };
+    const char *p = text, *word, *name, *end;
+    size_t n;
+    int i;
+
+    while (*p) {
+        if (*p == '"') {
+            /* Map names and the like */
+            if (!(p = strchr(p + 1, '"')))
+                return;
+            p++;
+            continue;
+        }
+        if (!isalpha((unsigned char) *p) && *p != '_') {
+            p++;
+            continue;
+        }
+
+        word = p;
+        while (isalnum((unsigned char) *p) || *p == '_')
+            p++;
+        n = p - word;
+        for (i = 0; i < ARRAY_SIZE(XkmCacheSections); i++) {
+            if (n >= strlen(XkmCacheSections[i].section) &&
+                strncmp(word, XkmCacheSections[i].section,
+                        strlen(XkmCacheSections[i].section)) == 0)
+                dir = XkmCacheSections[i].dir;
+        }
+        for (i = 0; i < ARRAY_SIZE(merges); i++) {
+            if (n == strlen(merges[i]) && strncmp(word, merges[i], n) == 0)
+                break;
+        }
+        if (i == ARRAY_SIZE(merges) || !dir)
+            continue;
+
+        while (isspace((unsigned char) *p))
+            p++;
+        if (*p != '"')
+            continue;
+        end = strchr(++p, '"');
+        if (!end)
+            return;
+        while (p < end) {
+            name = p;
+            while (p < end && *p != '+' && *p != '|' && *p != '(' &&
+                   *p != ':')
+                p++;
+            if (p > name)
+                XkmCacheHashInclude(inc, dir, name, p - name);
+            while (p < end && *p != '+' && *p != '|')
+                p++;
+            if (p < end)
+                p++;
+        }
+        p = end + 1;
+    }
+}
+
+/**
+ * Compute the cache name for the xkbcomp input in src.  The data files are
+ * identified by size and modification time of every file the keymap
+ * includes, directly or from other included files, so that editing any
+ * one of them leads to a new name.
+ */
+static Bool
+XkmCacheName(FILE *src, const char *xkbcomp, char *name, size_t size)
+{
+    XkmCacheIncludesRec inc = { 0 };
+    unsigned char digest[20];
+    char *text;
+    size_t n, len;
+    int i;
+    Bool ok;
+
+    if (size < strlen("xkm-") + 2 * sizeof(digest) + 1)
+        return FALSE;
+
+    inc.ctx = x_sha1_init();
+    if (!inc.ctx)
+        return FALSE;
+
+    x_sha1_update(inc.ctx, XKM_CACHE_VERSION, sizeof(XKM_CACHE_VERSION));
+    XkmCacheHashFile(inc.ctx, xkbcomp);
+
+    rewind(src);
+    text = XkmCacheReadFile(src, &len);
+    if (text) {
+        x_sha1_update(inc.ctx, text, len);
+        XkmCacheHashIncludes(&inc, text, NULL);
+        free(text);
+    }
+    ok = text && !inc.overflow;
+    for (i = 0; i < inc.nseen; i++)
+        free(inc.seen[i]);
+
+    if (!x_sha1_final(inc.ctx, digest) || !ok)
+        return FALSE;
+
+    n = sprintf(name, "xkm-");
+    for (i = 0; i < sizeof(digest); i++)
+        n += sprintf(name + n, "%02x", digest[i]);
+    return TRUE;
+}
+
+static Bool
+XkmCacheCopy(const char *from, const char *to)
+{
+    char chunk[4096];
+    FILE *in, *out;
+    size_t n;
+    Bool ok = TRUE;
+
+    in = fopen(from, "rb");
+    if (!in)
+        return FALSE;
+    out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return FALSE;
+    }
+    while (ok && (n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+        ok = fwrite(chunk, 1, n, out) == n;
+    if (ferror(in))
+        ok = FALSE;
+    fclose(in);
+    if (fclose(out) != 0)
+        ok = FALSE;
+    if (!ok)
+        unlink(to);
+    return ok;
+}
+
+/**
+ * Copy the cached map name to the file xkbcomp would have written for
+ * keymap.  Returns FALSE if there is no cached copy.
+ */
+static Bool
+XkmCacheFetch(const char *name, const char *outdir, const char *keymap)
+{
+    char cached[PATH_MAX], dest[PATH_MAX];
+
+    if (!XkmFilePath(dest, sizeof(dest), outdir, keymap))
+        return FALSE;
+
+    if ((XkmFilePath(cached, sizeof(cached), XKM_CACHE_DIR, name) &&
+         XkmCacheCopy(cached, dest)) ||
+        (XkmFilePath(cached, sizeof(cached), outdir, name) &&
+         XkmCacheCopy(cached, dest))) {
+        if (xkbDebugFlags)
+            DebugF("[xkb] using cached keymap %s\n", cached);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * Store the map xkbcomp wrote for keymap under name, in the installed
+ * cache directory if it is writable and in the output directory if not.
+ * The copy is renamed into place so a concurrent server never reads a
+ * partial file.
+ */
+static void
+XkmCacheStore(const char *name, const char *outdir, const char *keymap)
+{
+    char compiled[PATH_MAX], cached[PATH_MAX], tmp[PATH_MAX];
+    const char *dirs[] = { XKM_CACHE_DIR, outdir };
+    int i;
+
+    if (!XkmFilePath(compiled, sizeof(compiled), outdir, keymap))
+        return;
+
+    for (i = 0; i < ARRAY_SIZE(dirs); i++) {
+        if (!XkmFilePath(cached, sizeof(cached), dirs[i], name) ||
+            snprintf(tmp, sizeof(tmp), "%s.%ld", cached,
+                     (long) getpid()) >= sizeof(tmp))
+            continue;
+        if (!XkmCacheCopy(compiled, tmp))
+            continue;
+        if (rename(tmp, cached) != 0)
+            unlink(tmp);        /* somebody else stored it first */
+        return;
+    }
+}
+
+#ifdef WIN32
+
+#include <X11/Xwindows.h>
+
+typedef int (*XkbCompCompileKeymapProc) (const char *keymap, size_t length,
+                                         const char *root, int warnLevel,
+                                         const char *outputPath);
+
+/**
+ * Return the keymap compiler in libxkbcomp.dll, which is built from the
+ * same sources as xkbcomp.exe and runs in the server process, or NULL if
+ * the library is not installed next to xkbcomp.exe.
+ */
+static XkbCompCompileKeymapProc
+XkbCompLibrary(const char *xkbbindir, const char *xkbbindirsep)
+{
+    static Bool loaded = FALSE;
+    static XkbCompCompileKeymapProc compile = NULL;
+    char path[PATH_MAX];
+    HMODULE lib;
+
+    if (loaded)
+        return compile;
+    loaded = TRUE;
+
+    if (snprintf(path, sizeof(path), "%s%s" XKBCOMP_DLL, xkbbindir,
+                 xkbbindirsep) >= sizeof(path))
+        return NULL;
+    lib = LoadLibraryA(path);
+    if (lib)
+        compile = (XkbCompCompileKeymapProc)
+            GetProcAddress(lib, "XkbCompCompileKeymap");
+    if (!compile)
+        LogMessage(X_INFO, "XKB: %s not usable, running xkbcomp\n", path);
+    return compile;
+}
+
+/**
+ * Compile the keymap source in src with the in-process compiler.  Returns
+ * the exit status xkbcomp would have returned, or -1 if it could not run.
+ */
+static int
+XkbCompInProcess(XkbCompCompileKeymapProc compile, FILE *src,
+                 const char *outdir, const char *keymap)
+{
+    char path[PATH_MAX], *text = NULL, *grown;
+    size_t len = 0, size = 0, n;
+    int status = -1;
+
+    if (!XkmFilePath(path, sizeof(path), outdir, keymap))
+        return -1;
+
+    rewind(src);
+    do {
+        if (len == size) {
+            size = size ? 2 * size : 16384;
+            grown = realloc(text, size);
+            if (!grown)
+                goto out;
+            text = grown;
+        }
+        n = fread(text + len, 1, size - len, src);
+        len += n;
+    } while (n > 0);
+
+    if (!ferror(src))
+        status = (*compile) (text, len,
+                             XkbBaseDirectory ? XkbBaseDirectory : ".",
+                             ((xkbDebugFlags < 2) ? 1 :
+                              ((xkbDebugFlags > 10) ? 10 :
+                               (int) xkbDebugFlags)), path);
+
+ out:
+    free(text);
+    return status;
+}
+
+#endif
+
 /**
  * Callback invoked by XkbRunXkbComp. Write to out to talk to xkbcomp.
  */
@@ -89,24 +523,34 @@ typedef void (*xkbcomp_buffer_callback)(FILE *out, void *userdata);
 /**
  * Start xkbcomp, let the callback write into xkbcomp's stdin. When done,
  * return a strdup'd copy of the file name we've written to.
+ *
+ * The input is collected in a file first so the compiled keymap cache can
+ * be consulted; xkbcomp only runs if the cache has no copy.  On Windows
+ * the compiler in libxkbcomp.dll is called directly when it is installed,
+ * instead of starting xkbcomp.exe.
  */
 static char *
 RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 {
-    FILE *out;
-    char *buf = NULL, keymap[PATH_MAX], xkm_output_dir[PATH_MAX];
+    FILE *src;
+    char *buf = NULL, *xkbcomp = NULL;
+    char keymap[PATH_MAX], xkm_output_dir[PATH_MAX], cachename[PATH_MAX];
+    Bool cacheable, compiled;
 
     const char *emptystring = "";
     char *xkbbasedirflag = NULL;
     const char *xkbbindir = emptystring;
     const char *xkbbindirsep = emptystring;
+    const char *compiler = XKBCOMP_EXE;
 
 #ifdef WIN32
     /* WIN32 has no popen. The input must be stored in a file which is
        used as input for xkbcomp. xkbcomp does not read from stdin. */
     char tmpname[PATH_MAX];
     const char *xkmfile = tmpname;
+    XkbCompCompileKeymapProc compile;
 #else
+    FILE *out;
     const char *xkmfile = "-";
 #endif
 
@@ -149,52 +593,106 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 
     free(xkbbasedirflag);
 
-    if (!buf) {
+    /* The cache goes by whichever compiler is going to run */
+#ifdef WIN32
+    compile = XkbCompLibrary(xkbbindir, xkbbindirsep);
+    if (compile)
+        compiler = XKBCOMP_DLL;
+#endif
+
+    if (!buf ||
+        asprintf(&xkbcomp, "%s%s%s", xkbbindir, xkbbindirsep,
+                 compiler) == -1) {
         LogMessage(X_ERROR,
                    "XKB: Could not invoke xkbcomp: not enough memory\n");
+        free(buf);
         return NULL;
     }
 
 #ifndef WIN32
-    out = Popen(buf, "w");
+    src = tmpfile();
 #else
-    out = fopen(tmpname, "w");
+    /* The in-process compiler reads the input back from this process, so
+       keep it in the file cache and let it go away on close. */
+    src = fopen(tmpname, compile ? "w+TD" : "w+");
 #endif
 
-    if (out != NULL) {
-        /* Now write to xkbcomp */
-        (*callback)(out, userdata);
-
+    if (src == NULL) {
 #ifndef WIN32
-        if (Pclose(out) == 0)
+        LogMessage(X_ERROR, "XKB: Could not invoke xkbcomp\n");
 #else
-        if (fclose(out) == 0 && System(buf) >= 0)
-#endif
-        {
-            if (xkbDebugFlags)
-                DebugF("[xkb] xkb executes: %s\n", buf);
-            free(buf);
-#ifdef WIN32
-            unlink(tmpname);
+        LogMessage(X_ERROR, "Could not open file %s\n", tmpname);
 #endif
-            return xnfstrdup(keymap);
-        }
-        else {
-            LogMessage(X_ERROR, "Error compiling keymap (%s) executing '%s'\n",
-                       keymap, buf);
-        }
+        free(xkbcomp);
+        free(buf);
+        return NULL;
+    }
+
+    /* Now write the keymap for xkbcomp */
+    (*callback)(src, userdata);
+
+    cacheable = fflush(src) == 0 &&
+        XkmCacheName(src, xkbcomp, cachename, sizeof(cachename));
+    free(xkbcomp);
+
+    if (cacheable && XkmCacheFetch(cachename, xkm_output_dir, keymap)) {
+        fclose(src);
 #ifdef WIN32
-        /* remove the temporary file */
         unlink(tmpname);
 #endif
+        free(buf);
+        return xnfstrdup(keymap);
     }
-    else {
+
 #ifndef WIN32
+    out = Popen(buf, "w");
+    if (out == NULL) {
         LogMessage(X_ERROR, "XKB: Could not invoke xkbcomp\n");
+        fclose(src);
+        free(buf);
+        return NULL;
+    }
+    else {
+        char chunk[4096];
+        size_t n;
+
+        rewind(src);
+        while ((n = fread(chunk, 1, sizeof(chunk), src)) > 0)
+            fwrite(chunk, 1, n, out);
+        fclose(src);
+        compiled = (Pclose(out) == 0);
+    }
 #else
-        LogMessage(X_ERROR, "Could not open file %s\n", tmpname);
+    if (compile) {
+        int status = XkbCompInProcess(compile, src, xkm_output_dir, keymap);
+
+        compiled = (fclose(src) == 0 && status >= 0);
+        cacheable = cacheable && (status == 0);
+    }
+    else if (fclose(src) == 0) {
+        int status = System(buf);
+
+        compiled = (status >= 0);
+        /* a failing xkbcomp may still leave a partial map behind */
+        cacheable = cacheable && (status == 0);
+    }
+    else
+        compiled = FALSE;
+    /* remove the temporary file */
+    unlink(tmpname);
 #endif
+
+    if (compiled) {
+        if (xkbDebugFlags)
+            DebugF("[xkb] xkb executes: %s\n", buf);
+        if (cacheable)
+            XkmCacheStore(cachename, xkm_output_dir, keymap);
+        free(buf);
+        return xnfstrdup(keymap);
     }
+
+    LogMessage(X_ERROR, "Error compiling keymap (%s) executing '%s'\n",
+               keymap, buf);
     free(buf);
     return NULL;
 }
@@ -297,21 +795,7 @@ XkbDDXOpenConfigFile(const char *mapName, char *fileNameRtrn, int fileNameRtrnLe
     buf[0] = '\0';
     if (mapName != NULL) {
         OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
-        if ((XkbBaseDirectory != NULL) && (xkm_output_dir[0] != '/')
-#ifdef WIN32
-            && (!isalpha(xkm_output_dir[0]) || xkm_output_dir[1] != ':')
-#endif
-            ) {
-            if (snprintf(buf, PATH_MAX, "%s/%s%s.xkm", XkbBaseDirectory,
-                         xkm_output_dir, mapName) >= PATH_MAX)
-                buf[0] = '\0';
-        }
-        else {
-            if (snprintf(buf, PATH_MAX, "%s%s.xkm", xkm_output_dir, mapName)
-                >= PATH_MAX)
-                buf[0] = '\0';
-        }
-        if (buf[0] != '\0')
+        if (XkmFilePath(buf, sizeof(buf), xkm_output_dir, mapName))
             file = fopen(buf, "rb");
         else
             file = NULL;
@@ -548,3 +1032,36 @@ XkbCompileKeymapFromString(DeviceIntPtr dev,
 
     return KeymapOrDefaults(dev, xkb);
 }
+
+/**
+ * Compile the given RMLVO keymap into the compiled keymap cache without
+ * loading it, so a later server start with the same keymap finds it
+ * there.  Returns TRUE on success.
+ */
+Bool
+XkbDDXPrecacheKeymap(XkbRMLVOSet * rmlvo)
+{
+    XkbComponentNamesRec kccgst = { 0 };
+    char name[PATH_MAX], fileName[PATH_MAX];
+    unsigned int need;
+    Bool rc = FALSE;
+    FILE *file;
+
+    /* Must match XkbCompileKeymap, the request text is part of the key */
+    need = XkmSymbolsMask | XkmCompatMapMask | XkmTypesMask |
+        XkmKeyNamesMask | XkmVirtualModsMask;
+
+    if (XkbRMLVOtoKcCGST(NULL, rmlvo, &kccgst) &&
+        XkbDDXCompileKeymapByNames(NULL, &kccgst, XkmAllIndicesMask, need,
+                                   name, sizeof(name))) {
+        file = XkbDDXOpenConfigFile(name, fileName, sizeof(fileName));
+        if (file) {
+            fclose(file);
+            (void) unlink(fileName);
+            rc = TRUE;
+        }
+    }
+
+    XkbFreeComponentNames(&kccgst, FALSE);
+    return rc;
+}
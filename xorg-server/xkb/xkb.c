@@ -1371,6 +1371,130 @@ XkbWriteVirtualModMap(XkbDescPtr xkb, xkbGetMapReply * rep, char *buf,
     return (char *) wire;
 }
 
+/***====================================================================***/
+
+/*
+ * The replies to requests for a whole map, compat map or set of names only
+ * depend on the keymap, and clients ask for the same ones over and over
+ * (every client initialising Xlib's XKB support does).  The last one of
+ * each kind is kept per device, in wire form for both byte orders, and
+ * thrown away by XkbInvalidateReplyCache() whenever the keymap changes.
+ */
+
+#define XkbMapReplyCache        0
+#define XkbCompatMapReplyCache  1
+#define XkbNamesReplyCache      2
+#define XkbNumReplyCaches       3
+
+typedef union _XkbCachedReplyHdr {
+    xGenericReply generic;
+    xkbGetMapReply map;
+    xkbGetCompatMapReply compat;
+    xkbGetNamesReply names;
+} XkbCachedReplyHdr;
+
+typedef struct _XkbCachedReply {
+    CARD32 which;               /* components the request asked for */
+    struct {
+        Bool valid;
+        XkbCachedReplyHdr rep;  /* as written, sequence number aside */
+        int len;
+        char *data;
+    } order[2];                 /* server byte order, swapped */
+} XkbCachedReplyRec, *XkbCachedReplyPtr;
+
+typedef struct _XkbReplyCache {
+    XkbCachedReplyRec replies[XkbNumReplyCaches];
+} XkbReplyCacheRec;
+
+static void
+XkbClearCachedReply(XkbCachedReplyPtr cr)
+{
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        free(cr->order[i].data);
+        cr->order[i].data = NULL;
+        cr->order[i].valid = FALSE;
+    }
+}
+
+void
+XkbFreeReplyCache(XkbSrvInfoPtr xkbi)
+{
+    int i;
+
+    if (!xkbi->replyCache)
+        return;
+    for (i = 0; i < XkbNumReplyCaches; i++)
+        XkbClearCachedReply(&xkbi->replyCache->replies[i]);
+    free(xkbi->replyCache);
+    xkbi->replyCache = NULL;
+}
+
+void
+XkbInvalidateReplyCache(DeviceIntPtr dev)
+{
+    if (dev && dev->key && dev->key->xkbInfo)
+        XkbFreeReplyCache(dev->key->xkbInfo);
+}
+
+static XkbCachedReplyPtr
+XkbGetCachedReply(DeviceIntPtr dev, int kind, CARD32 which)
+{
+    XkbSrvInfoPtr xkbi = dev->key->xkbInfo;
+    XkbCachedReplyPtr cr;
+
+    if (!xkbi->replyCache) {
+        xkbi->replyCache = calloc(1, sizeof(XkbReplyCacheRec));
+        if (!xkbi->replyCache)
+            return NULL;
+    }
+    cr = &xkbi->replyCache->replies[kind];
+    if (cr->which != which) {
+        XkbClearCachedReply(cr);
+        cr->which = which;
+    }
+    return cr;
+}
+
+/*
+ * Keep a reply that is about to be written; takes over data.
+ */
+static void
+XkbStoreCachedReply(XkbCachedReplyPtr cr, ClientPtr client,
+                    const void *rep, int repSize, char *data, int len)
+{
+    int o = client->swapped ? 1 : 0;
+
+    free(cr->order[o].data);
+    memcpy(&cr->order[o].rep, rep, repSize);
+    cr->order[o].data = data;
+    cr->order[o].len = len;
+    cr->order[o].valid = TRUE;
+}
+
+static Bool
+XkbSendCachedReply(ClientPtr client, XkbCachedReplyPtr cr, int repSize)
+{
+    int o = client->swapped ? 1 : 0;
+    XkbCachedReplyHdr rep;
+
+    if (!cr || !cr->order[o].valid)
+        return FALSE;
+    memcpy(&rep, &cr->order[o].rep, repSize);
+    rep.generic.sequenceNumber = client->sequence;
+    if (client->swapped) {
+        swaps(&rep.generic.sequenceNumber);
+    }
+    WriteToClient(client, repSize, &rep);
+    if (cr->order[o].len > 0)
+        WriteToClient(client, cr->order[o].len, cr->order[o].data);
+    return TRUE;
+}
+
+/***====================================================================***/
+
 static Status
 XkbComputeGetMapReplySize(XkbDescPtr xkb, xkbGetMapReply * rep)
 {
@@ -1391,7 +1515,8 @@ XkbComputeGetMapReplySize(XkbDescPtr xkb, xkbGetMapReply * rep)
 }
 
 static int
-XkbSendMap(ClientPtr client, XkbDescPtr xkb, xkbGetMapReply * rep)
+XkbSendMap(ClientPtr client, XkbDescPtr xkb, xkbGetMapReply * rep,
+           XkbCachedReplyPtr cache)
 {
     unsigned i, len;
     char *desc, *start;
@@ -1438,7 +1563,11 @@ XkbSendMap(ClientPtr client, XkbDescPtr xkb, xkbGetMapReply * rep)
     }
     WriteToClient(client, (i = SIZEOF(xkbGetMapReply)), rep);
     WriteToClient(client, len, start);
-    free((char *) start);
+    if (cache)
+        XkbStoreCachedReply(cache, client, rep, SIZEOF(xkbGetMapReply),
+                            start, len);
+    else
+        free((char *) start);
     return Success;
 }
 
@@ -1448,6 +1577,7 @@ ProcXkbGetMap(ClientPtr client)
     DeviceIntPtr dev;
     xkbGetMapReply rep;
     XkbDescRec *xkb;
+    XkbCachedReplyPtr cache = NULL;
     int n, status;
 
     REQUEST(xkbGetMapReq);
@@ -1461,6 +1591,13 @@ ProcXkbGetMap(ClientPtr client)
     CHK_MASK_LEGAL(0x02, stuff->full, XkbAllMapComponentsMask);
     CHK_MASK_LEGAL(0x03, stuff->partial, XkbAllMapComponentsMask);
 
+    /* Only the reply to a request for whole components can be kept */
+    if (stuff->partial == 0) {
+        cache = XkbGetCachedReply(dev, XkbMapReplyCache, stuff->full);
+        if (XkbSendCachedReply(client, cache, SIZEOF(xkbGetMapReply)))
+            return Success;
+    }
+
     xkb = dev->key->xkbInfo->desc;
     memset(&rep, 0, sizeof(xkbGetMapReply));
     rep.type = X_Reply;
@@ -1573,7 +1710,7 @@ ProcXkbGetMap(ClientPtr client)
 
     if ((status = XkbComputeGetMapReplySize(xkb, &rep)) != Success)
         return status;
-    return XkbSendMap(client, xkb, &rep);
+    return XkbSendMap(client, xkb, &rep, cache);
 }
 
 /***====================================================================***/
@@ -2715,7 +2852,8 @@ XkbComputeGetCompatMapReplySize(XkbCompatMapPtr compat,
 
 static int
 XkbSendCompatMap(ClientPtr client,
-                 XkbCompatMapPtr compat, xkbGetCompatMapReply * rep)
+                 XkbCompatMapPtr compat, xkbGetCompatMapReply * rep,
+                 XkbCachedReplyPtr cache)
 {
     char *data;
     int size;
@@ -2773,10 +2911,13 @@ XkbSendCompatMap(ClientPtr client,
     }
 
     WriteToClient(client, SIZEOF(xkbGetCompatMapReply), rep);
-    if (data) {
+    if (data)
         WriteToClient(client, size, data);
+    if (cache)
+        XkbStoreCachedReply(cache, client, rep, SIZEOF(xkbGetCompatMapReply),
+                            data, data ? size : 0);
+    else
         free((char *) data);
-    }
     return Success;
 }
 
@@ -2787,6 +2928,7 @@ ProcXkbGetCompatMap(ClientPtr client)
     DeviceIntPtr dev;
     XkbDescPtr xkb;
     XkbCompatMapPtr compat;
+    XkbCachedReplyPtr cache = NULL;
 
     REQUEST(xkbGetCompatMapReq);
     REQUEST_SIZE_MATCH(xkbGetCompatMapReq);
@@ -2796,6 +2938,12 @@ ProcXkbGetCompatMap(ClientPtr client)
 
     CHK_KBD_DEVICE(dev, stuff->deviceSpec, client, DixGetAttrAccess);
 
+    if (stuff->getAllSI) {
+        cache = XkbGetCachedReply(dev, XkbCompatMapReplyCache, stuff->groups);
+        if (XkbSendCachedReply(client, cache, SIZEOF(xkbGetCompatMapReply)))
+            return Success;
+    }
+
     xkb = dev->key->xkbInfo->desc;
     compat = xkb->compat;
 
@@ -2819,7 +2967,7 @@ ProcXkbGetCompatMap(ClientPtr client)
     rep.nTotalSI = compat->num_si;
     rep.groups = stuff->groups;
     XkbComputeGetCompatMapReplySize(compat, &rep);
-    return XkbSendCompatMap(client, compat, &rep);
+    return XkbSendCompatMap(client, compat, &rep, cache);
 }
 
 /**
@@ -2951,6 +3099,7 @@ _XkbSetCompatMap(ClientPtr client, DeviceIntPtr dev,
         return BadLength;
     }
 
+    XkbInvalidateReplyCache(dev);
     if (dev->xkb_interest) {
         xkbCompatMapNotify ev;
 
@@ -3748,7 +3897,8 @@ XkbComputeGetNamesReplySize(XkbDescPtr xkb, xkbGetNamesReply * rep)
 }
 
 static int
-XkbSendNames(ClientPtr client, XkbDescPtr xkb, xkbGetNamesReply * rep)
+XkbSendNames(ClientPtr client, XkbDescPtr xkb, xkbGetNamesReply * rep,
+             XkbCachedReplyPtr cache)
 {
     register unsigned i, length, which;
     char *start;
@@ -3895,7 +4045,11 @@ XkbSendNames(ClientPtr client, XkbDescPtr xkb, xkbGetNamesReply * rep)
     }
     WriteToClient(client, SIZEOF(xkbGetNamesReply), rep);
     WriteToClient(client, length, start);
-    free((char *) start);
+    if (cache)
+        XkbStoreCachedReply(cache, client, rep, SIZEOF(xkbGetNamesReply),
+                            start, length);
+    else
+        free((char *) start);
     return Success;
 }
 
@@ -3905,6 +4059,7 @@ ProcXkbGetNames(ClientPtr client)
     DeviceIntPtr dev;
     XkbDescPtr xkb;
     xkbGetNamesReply rep;
+    XkbCachedReplyPtr cache;
 
     REQUEST(xkbGetNamesReq);
     REQUEST_SIZE_MATCH(xkbGetNamesReq);
@@ -3915,6 +4070,10 @@ ProcXkbGetNames(ClientPtr client)
     CHK_KBD_DEVICE(dev, stuff->deviceSpec, client, DixGetAttrAccess);
     CHK_MASK_LEGAL(0x01, stuff->which, XkbAllNamesMask);
 
+    cache = XkbGetCachedReply(dev, XkbNamesReplyCache, stuff->which);
+    if (XkbSendCachedReply(client, cache, SIZEOF(xkbGetNamesReply)))
+        return Success;
+
     xkb = dev->key->xkbInfo->desc;
     memset(&rep, 0, sizeof(xkbGetNamesReply));
     rep.type = X_Reply;
@@ -3929,7 +4088,7 @@ ProcXkbGetNames(ClientPtr client)
     rep.nRadioGroups = xkb->names ? xkb->names->num_rg : 0;
     
     XkbComputeGetNamesReplySize(xkb, &rep);
-    return XkbSendNames(client, xkb, &rep);
+    return XkbSendNames(client, xkb, &rep, cache);
 }
 
 /***====================================================================***/
@@ -5978,13 +6137,13 @@ ProcXkbGetKbdByName(ClientPtr client)
     }
     WriteToClient(client, SIZEOF(xkbGetKbdByNameReply), &rep);
     if (reported & (XkbGBN_SymbolsMask | XkbGBN_TypesMask))
-        XkbSendMap(client, new, &mrep);
+        XkbSendMap(client, new, &mrep, NULL);
     if (reported & XkbGBN_CompatMapMask)
-        XkbSendCompatMap(client, new->compat, &crep);
+        XkbSendCompatMap(client, new->compat, &crep, NULL);
     if (reported & XkbGBN_IndicatorMapMask)
         XkbSendIndicatorMap(client, new->indicators, &irep);
     if (reported & (XkbGBN_KeyNamesMask | XkbGBN_OtherNamesMask))
-        XkbSendNames(client, new, &nrep);
+        XkbSendNames(client, new, &nrep, NULL);
     if (reported & XkbGBN_GeometryMask)
         XkbSendGeometry(client, new->geom, &grep, FALSE);
     if (rep.loaded) {
@@ -163,6 +163,7 @@ XkbSendNewKeyboardNotify(DeviceIntPtr kbd, xkbNewKeyboardNotify * pNKN)
     Time time = GetTimeInMillis();
     CARD16 changed = pNKN->changed;
 
+    XkbInvalidateReplyCache(kbd);
     pNKN->type = XkbEventCode + XkbEventBase;
     pNKN->xkbType = XkbNewKeyboardNotify;
 
@@ -268,6 +269,7 @@ XkbSendMapNotify(DeviceIntPtr kbd, xkbMapNotify * pMN)
     CARD16 changed = pMN->changed;
     XkbSrvInfoPtr xkbi = kbd->key->xkbInfo;
 
+    XkbInvalidateReplyCache(kbd);
     pMN->minKeyCode = xkbi->desc->min_key_code;
     pMN->maxKeyCode = xkbi->desc->max_key_code;
     pMN->type = XkbEventCode + XkbEventBase;
@@ -610,6 +612,7 @@ XkbSendNamesNotify(DeviceIntPtr kbd, xkbNamesNotify * pEv)
     CARD16 changed, changedVirtualMods;
     CARD32 changedIndicators;
 
+    XkbInvalidateReplyCache(kbd);
     interest = kbd->xkb_interest;
     if (!interest)
         return;
@@ -656,6 +659,7 @@ XkbSendCompatMapNotify(DeviceIntPtr kbd, xkbCompatMapNotify * pEv)
     Time time = 0;
     CARD16 firstSI = 0, nSI = 0, nTotalSI = 0;
 
+    XkbInvalidateReplyCache(kbd);
     interest = kbd->xkb_interest;
     if (!interest)
         return;
@@ -721,6 +721,7 @@ XkbFreeInfo(XkbSrvInfoPtr xkbi)
         TimerFree(xkbi->beepTimer);
         xkbi->beepTimer = NULL;
     }
+    XkbFreeReplyCache(xkbi);
     if (xkbi->desc) {
         XkbFreeKeyboard(xkbi->desc, XkbAllComponentsMask, TRUE);
         xkbi->desc = NULL;
@@ -2022,6 +2022,8 @@ XkbDeviceApplyKeymap(DeviceIntPtr dst, XkbDescPtr desc)
     if (desc->geom)
         nkn.changed |= XkbNKN_GeometryMask;
 
+    /* Even a failed copy may have left part of the new keymap behind */
+    XkbInvalidateReplyCache(dst);
     ret = XkbCopyKeymap(dst->key->xkbInfo->desc, desc);
     if (ret)
         XkbSendNewKeyboardNotify(dst, &nkn);
@@ -6,6 +6,7 @@
 /* @(#) $Id$ */
 
 #include "zutil.h"
+#include "simd_x86.h"
 
 local uLong adler32_combine_ OF((uLong adler1, uLong adler2, z_off64_t len2));
 
@@ -68,6 +69,12 @@ uLong ZEXPORT adler32_z(adler, buf, len)
     unsigned long sum2;
     unsigned n;
 
+#ifdef Z_SIMD_X86
+    if (buf != Z_NULL && len >= ADLER32_SSSE3_MIN &&
+        (simd_x86_features() & SIMD_X86_SSSE3))
+        return adler32_ssse3(adler, buf, len);
+#endif
+
     /* split Adler-32 into component sums */
     sum2 = (adler >> 16) & 0xffff;
     adler &= 0xffff;
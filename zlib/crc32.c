@@ -31,6 +31,7 @@
 #endif /* MAKECRCH */
 
 #include "zutil.h"      /* for STDC and FAR definitions */
+#include "simd_x86.h"
 
 /* Definitions for doing the crc four data bytes at a time. */
 #if !defined(NOBYFOUR) && defined(Z_U4)
@@ -213,6 +214,18 @@ unsigned long ZEXPORT crc32_z(crc, buf, len)
         make_crc_table();
 #endif /* DYNAMIC_CRC_TABLE */
 
+#ifdef Z_SIMD_X86
+    if (len >= CRC32_PCLMUL_MIN && (simd_x86_features() & SIMD_X86_PCLMUL)) {
+        z_size_t blocks = len & ~(z_size_t)15;
+
+        crc = crc32_pclmul(crc, buf, len);
+        buf += blocks;
+        len -= blocks;
+        if (len == 0)
+            return crc;
+    }
+#endif /* Z_SIMD_X86 */
+
 #ifdef BYFOUR
     if (sizeof(void *) == sizeof(ptrdiff_t)) {
         z_crc_t endian;
@@ -8,4 +8,22 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* Little-endian 64-bit machines, with cheap unaligned loads, have inflate_fast()
+   refill its bit buffer a word at a time and copy matches eight bytes at a
+   time.  Both read and write a little further ahead than the byte at a time
+   version, so inflate_fast() wants a little more input and output. */
+#if !defined(INFLATE_FAST_NARROW) && \
+    (defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__) || \
+     defined(_M_ARM64) || (defined(__aarch64__) && !defined(__AARCH64EB__)))
+#  define INFLATE_FAST_WIDE
+#endif
+
+#ifdef INFLATE_FAST_WIDE
+#  define INFLATE_FAST_MIN_INPUT 8
+#  define INFLATE_FAST_MIN_OUTPUT 266
+#else
+#  define INFLATE_FAST_MIN_INPUT 6
+#  define INFLATE_FAST_MIN_OUTPUT 258
+#endif
+
 void ZLIB_INTERNAL inflate_fast OF((z_streamp strm, unsigned start));
@@ -0,0 +1,255 @@
+/* simd_x86.c -- x86 vector versions of crc32() and adler32()
+ * Copyright (C) 2026 VcXsrv contributors
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* @(#) $Id$ */
+
+/*
+  crc32_pclmul() folds the buffer 64 bytes at a time with carry-less
+  multiplies, then reduces to 32 bits with a Barrett reduction, as in Intel's
+  "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+  adler32_ssse3() sums 32 bytes at a time, with the weights of the second sum
+  applied by multiply-adds.  Both give the same results as the table and
+  scalar versions, and are only called once simd_x86_features() says the
+  processor has the instructions they need.
+ */
+
+#include "zutil.h"
+#include "simd_x86.h"
+
+#ifdef Z_SIMD_X86
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#  define SIMD_TARGET(x)
+#else
+#  include <cpuid.h>
+#  define SIMD_TARGET(x) __attribute__((target(x)))
+#endif
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+/* ========================================================================= */
+int ZLIB_INTERNAL simd_x86_features()
+{
+    /* racing first callers all store the same value */
+    static volatile int features = -1;
+    unsigned int ecx;
+    int found;
+
+    if (features >= 0)
+        return features;
+
+#ifdef _MSC_VER
+    {
+        int regs[4];
+
+        __cpuid(regs, 1);
+        ecx = (unsigned int)regs[2];
+    }
+#else
+    {
+        unsigned int eax, ebx, edx;
+
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            ecx = 0;
+    }
+#endif
+
+    found = 0;
+    if (ecx & (1U << 9))
+        found |= SIMD_X86_SSSE3;
+    if (ecx & (1U << 1))
+        found |= SIMD_X86_PCLMUL;
+    features = found;
+    return found;
+}
+
+/* ========================================================================= */
+/* The CRC of the first len & ~15 bytes of buf, len >= CRC32_PCLMUL_MIN */
+SIMD_TARGET("sse2,pclmul")
+unsigned long ZLIB_INTERNAL crc32_pclmul(crc, buf, len)
+    unsigned long crc;
+    const unsigned char FAR *buf;
+    z_size_t len;
+{
+    /* folding and reduction constants for the bit-reflected polynomial */
+    static const unsigned int k1k2[4] = { 0x54442bd4, 1, 0xc6e41596, 1 };
+    static const unsigned int k3k4[4] = { 0x751997d0, 1, 0xccaa009e, 0 };
+    static const unsigned int k5k0[4] = { 0x63cd6124, 1, 0, 0 };
+    static const unsigned int poly[4] = { 0xdb710641, 1, 0xf7011641, 1 };
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)(crc ^ 0xffffffffUL)));
+    x0 = _mm_loadu_si128((const __m128i *)k1k2);
+    buf += 64;
+    len -= 64;
+
+    /* fold four blocks of 16 at a time */
+    while (len >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        buf += 64;
+        len -= 64;
+    }
+
+    /* fold the four into one */
+    x0 = _mm_loadu_si128((const __m128i *)k3k4);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    /* fold in any remaining blocks of 16 */
+    while (len >= 16) {
+        x2 = _mm_loadu_si128((const __m128i *)buf);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        buf += 16;
+        len -= 16;
+    }
+
+    /* fold 128 bits to 64 */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduce to 32 bits */
+    x0 = _mm_loadu_si128((const __m128i *)poly);
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (unsigned long)
+        ~(unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+/* ========================================================================= */
+#define BASE 65521U     /* largest prime smaller than 65536 */
+#define NMAX 5552       /* see adler32.c */
+#define BLOCK 32
+
+SIMD_TARGET("ssse3")
+uLong ZLIB_INTERNAL adler32_ssse3(adler, buf, len)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+{
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    unsigned long sum1 = adler & 0xffff;
+    unsigned long sum2 = (adler >> 16) & 0xffff;
+    z_size_t blocks = len / BLOCK;
+
+    len -= blocks * BLOCK;
+
+    while (blocks) {
+        /* at most NMAX bytes before sum2 has to be reduced */
+        unsigned n = NMAX / BLOCK;
+        __m128i v_ps, v_s1, v_s2;
+
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        /* v_ps is the sum of sum1 before each block, weighted by 32 later */
+        v_ps = _mm_cvtsi32_si128((int)(sum1 * n));
+        v_s2 = _mm_cvtsi32_si128((int)sum2);
+        v_s1 = zero;
+
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                       _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                       _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+
+            buf += BLOCK;
+        } while (--n);
+
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        /* add up the lanes */
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        sum1 += (unsigned)_mm_cvtsi128_si32(v_s1);
+        sum2 = (unsigned)_mm_cvtsi128_si32(v_s2);
+
+        sum1 %= BASE;
+        sum2 %= BASE;
+    }
+
+    /* fewer than BLOCK bytes left */
+    if (len) {
+        do {
+            sum1 += *buf++;
+            sum2 += sum1;
+        } while (--len);
+        if (sum1 >= BASE)
+            sum1 -= BASE;
+        sum2 %= BASE;
+    }
+
+    return sum1 | (sum2 << 16);
+}
+
+#endif /* Z_SIMD_X86 */
@@ -0,0 +1,41 @@
+/* simd_x86.h -- header to use simd_x86.c
+ * Copyright (C) 2026 VcXsrv contributors
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the compression library and is
+   subject to change. Applications should only use zlib.h.
+ */
+
+#ifndef SIMD_X86_H
+#define SIMD_X86_H
+
+#if !defined(NO_SIMD_X86) && \
+    (defined(_M_IX86) || defined(_M_X64) || defined(_M_AMD64) || \
+     defined(__i386__) || defined(__x86_64__)) && \
+    ((defined(_MSC_VER) && _MSC_VER >= 1600) || defined(__clang__) || \
+     (defined(__GNUC__) && (__GNUC__ > 4 || \
+                            (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#  define Z_SIMD_X86
+#endif
+
+#ifdef Z_SIMD_X86
+
+/* simd_x86_features() bits */
+#define SIMD_X86_SSSE3  1
+#define SIMD_X86_PCLMUL 2
+
+/* shortest buffers the vector versions are used for */
+#define CRC32_PCLMUL_MIN    64
+#define ADLER32_SSSE3_MIN   64
+
+int ZLIB_INTERNAL simd_x86_features OF((void));
+unsigned long ZLIB_INTERNAL crc32_pclmul OF((unsigned long crc,
+                        const unsigned char FAR *buf, z_size_t len));
+uLong ZLIB_INTERNAL adler32_ssse3 OF((uLong adler, const Bytef *buf,
+                        z_size_t len));
+
+#endif /* Z_SIMD_X86 */
+
+#endif /* SIMD_X86_H */